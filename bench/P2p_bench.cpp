@@ -0,0 +1,49 @@
+/**
+ * This file benchmarks the peer-to-peer bookkeeping that runs on the notify
+ * fan-out path: assigning chunk-requests across peers and retiring them when
+ * the chunks arrive. The sends themselves require live SCTP connections and
+ * so aren't measured here.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: P2p_bench.cpp
+ * @author: Steven R. Emmerson
+ */
+
+#include "ChunkReqScheduler.h"
+#include "ProdInfo.h"
+
+#include <benchmark/benchmark.h>
+#include <vector>
+
+namespace {
+
+// Benchmarks offering a notified chunk to every peer and retiring the
+// resulting request, as happens once per chunk on the notify fan-out path
+static void BM_ChunkReqSchedulerFanOut(benchmark::State& state)
+{
+    const int                        numPeers = static_cast<int>(
+            state.range(0));
+    std::vector<hycast::InetSockAddr> peerAddrs;
+    for (int i = 0; i < numPeers; ++i)
+        peerAddrs.push_back(hycast::InetSockAddr{"192.168.1." +
+                std::to_string(i + 1), 38800});
+    hycast::ChunkReqScheduler scheduler{16, 10};
+    const hycast::ProdInfo    prodInfo{1, "product", 1000000};
+    hycast::ChunkIndex::type  chunkIndex{0};
+    for (auto _ : state) {
+        const hycast::ChunkId chunkId{prodInfo,
+                hycast::ChunkIndex{chunkIndex++ % prodInfo.getNumChunks()}};
+        for (auto& peerAddr : peerAddrs)
+            scheduler.tryAssign(chunkId, peerAddr);
+        scheduler.received(chunkId);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ChunkReqSchedulerFanOut)->RangeMultiplier(2)->Range(1, 8);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,79 @@
+/**
+ * This file benchmarks the product-store hot-paths: adding complete products,
+ * adding them from multiple threads at once, and adding them while the
+ * deletion thread concurrently evicts old ones.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: ProdStore_bench.cpp
+ * @author: Steven R. Emmerson
+ */
+
+#include "ProdStore.h"
+#include "Product.h"
+
+#include <benchmark/benchmark.h>
+#include <vector>
+
+namespace {
+
+static const size_t prodSize{100000};
+
+// Benchmarks adding complete products from a single thread
+static void BM_ProdStoreAdd(benchmark::State& state)
+{
+    std::vector<char>      data(prodSize, 0xbd);
+    hycast::ProdStore      ps{};
+    hycast::ProdIndex::type index{0};
+    for (auto _ : state) {
+        hycast::Product prod = hycast::MemoryProduct{index++, "product",
+                prodSize, data.data()};
+        ps.add(prod);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ProdStoreAdd);
+
+// Benchmarks adding complete products from multiple threads contending for
+// the store. Each thread uses a disjoint range of product indexes.
+static void BM_ProdStoreAddContended(benchmark::State& state)
+{
+    static hycast::ProdStore* ps;
+    if (state.thread_index() == 0)
+        ps = new hycast::ProdStore{};
+    std::vector<char>       data(prodSize, 0xbd);
+    hycast::ProdIndex::type index{static_cast<hycast::ProdIndex::type>(
+            state.thread_index()) << 24};
+    for (auto _ : state) {
+        hycast::Product prod = hycast::MemoryProduct{index++, "product",
+                prodSize, data.data()};
+        ps->add(prod);
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0)
+        delete ps;
+}
+BENCHMARK(BM_ProdStoreAddContended)->ThreadRange(1, 8)
+        ->UseRealTime();
+
+// Benchmarks adding complete products while the deletion thread concurrently
+// evicts products whose short residence-time has elapsed
+static void BM_ProdStoreAddWithEviction(benchmark::State& state)
+{
+    std::vector<char>      data(prodSize, 0xbd);
+    hycast::ProdStore      ps{"", 0.001};
+    hycast::ProdIndex::type index{0};
+    for (auto _ : state) {
+        hycast::Product prod = hycast::MemoryProduct{index++, "product",
+                prodSize, data.data()};
+        ps.add(prod);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ProdStoreAddWithEviction);
+
+}  // namespace
+
+BENCHMARK_MAIN();
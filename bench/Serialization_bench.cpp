@@ -0,0 +1,92 @@
+/**
+ * This file benchmarks the serialization hot-paths: codec round-trips,
+ * product-information serialization, and data-chunk reification.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: Serialization_bench.cpp
+ * @author: Steven R. Emmerson
+ */
+
+#include "Chunk.h"
+#include "Codec.h"
+#include "ProdInfo.h"
+
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+static const unsigned version{0};
+
+// Benchmarks a scalar-plus-payload codec round-trip
+static void BM_CodecRoundTrip(benchmark::State& state)
+{
+    const size_t      len = static_cast<size_t>(state.range(0));
+    std::vector<char> payload(len, 0xbd);
+    std::vector<char> buf(len + 64);
+    std::vector<char> out(len);
+    for (auto _ : state) {
+        hycast::MemEncoder encoder{buf.data(), buf.size()};
+        const auto         nbytes = encoder.encode(static_cast<uint32_t>(len))
+                + encoder.encode(payload.data(), len);
+        encoder.flush();
+        hycast::MemDecoder decoder{buf.data(), nbytes};
+        decoder.fill(sizeof(uint32_t));
+        uint32_t           len2;
+        decoder.decode(len2);
+        decoder.decode(out.data(), len2);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations())*len);
+}
+BENCHMARK(BM_CodecRoundTrip)->Range(64, hycast::ChunkSize::defaultSize);
+
+// Benchmarks product-information serialization and deserialization
+static void BM_ProdInfoRoundTrip(benchmark::State& state)
+{
+    const hycast::ProdInfo prodInfo{1, "product", 1000000};
+    std::vector<char>      buf(prodInfo.getSerialSize(version));
+    for (auto _ : state) {
+        hycast::MemEncoder encoder{buf.data(), buf.size()};
+        prodInfo.serialize(encoder, version);
+        encoder.flush();
+        hycast::MemDecoder decoder{buf.data(), buf.size()};
+        decoder.fill();
+        auto prodInfo2 = hycast::ProdInfo::deserialize(decoder, version);
+        benchmark::DoNotOptimize(prodInfo2);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ProdInfoRoundTrip);
+
+// Benchmarks data-chunk reification: serialization of an actual chunk
+// followed by deserialization and draining of the resulting latent chunk
+static void BM_ChunkReification(benchmark::State& state)
+{
+    const hycast::ChunkSize::type chunkSize = hycast::ChunkSize::defaultSize;
+    const hycast::ProdInfo        prodInfo{1, "product", chunkSize};
+    std::vector<char>             data(chunkSize, 0xbd);
+    const hycast::ActualChunk     actualChunk{prodInfo, 0, data.data()};
+    std::vector<char>             buf(actualChunk.getSerialSize(version));
+    std::vector<char>             out(chunkSize);
+    for (auto _ : state) {
+        hycast::MemEncoder encoder{buf.data(), buf.size()};
+        const auto         nbytes = actualChunk.serialize(encoder, version);
+        encoder.flush();
+        hycast::MemDecoder decoder{buf.data(), nbytes};
+        decoder.fill(hycast::LatentChunk::getMetadataSize(version));
+        auto latentChunk = hycast::LatentChunk::deserialize(decoder, version);
+        latentChunk.drainData(out.data(), out.size());
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations())*chunkSize);
+}
+BENCHMARK(BM_ChunkReification);
+
+}  // namespace
+
+BENCHMARK_MAIN();
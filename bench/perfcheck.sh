@@ -0,0 +1,186 @@
+#!/bin/sh
+# Runs the benchmark suite against a stored per-machine baseline and fails
+# when a metric regresses beyond a noise-aware threshold, so performance is
+# checked as routinely as correctness:
+#     make perfcheck
+#
+# Each Google-Benchmark program is run with repetitions and the median of
+# each benchmark's primary metric -- bytes/s or items/s where the benchmark
+# reports one, wall time otherwise -- is compared against the baseline
+# recorded for this machine. The first run on a machine records the baseline
+# and succeeds; later runs fail if any metric is worse than its baseline by
+# more than the tolerance. Re-record baselines (e.g., after an accepted
+# performance change or a hardware change) with:
+#     perfcheck.sh --rebaseline <program>...
+#
+# The end-to-end loopback harness (ShipRecv_test's Performance case), which
+# measures pipeline product-completion latency, is included when
+# HYCAST_PERFCHECK_PIPELINE is set non-empty: it needs a multicast-capable
+# loopback interface and takes considerably longer than the benchmarks. Its
+# single-run numbers are noisier than a benchmark median, so it's compared
+# at twice the tolerance.
+#
+# Environment:
+#     HYCAST_PERF_BASELINE_DIR   Baseline directory (default
+#                                "$HOME/.hycast/perf-baseline"). Baselines
+#                                are stored per-machine beneath it, keyed by
+#                                hostname: numbers from one machine never
+#                                gate another.
+#     HYCAST_PERF_TOLERANCE      Allowed fractional regression (default 0.10)
+#     HYCAST_PERF_REPETITIONS    Benchmark repetitions whose median is
+#                                compared (default 3)
+#     HYCAST_PERFCHECK_PIPELINE  Set non-empty to include the loopback
+#                                harness
+#     HYCAST_PERF_PIPELINE_PROG  Path of the loopback-harness program
+#                                (default "../test/comms/ShipRecv_test")
+
+set -e
+
+baseDir=${HYCAST_PERF_BASELINE_DIR:-$HOME/.hycast/perf-baseline}/`uname -n`
+tolerance=${HYCAST_PERF_TOLERANCE:-0.10}
+repetitions=${HYCAST_PERF_REPETITIONS:-3}
+pipelineProg=${HYCAST_PERF_PIPELINE_PROG:-../test/comms/ShipRecv_test}
+
+rebaseline=false
+if [ "$1" = --rebaseline ]; then
+    rebaseline=true
+    shift
+fi
+
+status=0
+mkdir -p "$baseDir"
+results=`mktemp`
+trap 'rm -f "$results"' EXIT
+
+# Normalizes a Google-Benchmark CSV report into "name kind value" lines,
+# keeping only the median aggregate of each benchmark. "kind" is "rate"
+# (higher is better) for benchmarks that report bytes/s or items/s and
+# "time" (lower is better) otherwise.
+normalizeCsv() {
+    awk -F, -v reps="$repetitions" '
+        NR == 1 || $1 == "" { next }
+        {
+            name = $1
+            gsub(/"/, "", name)
+            if (reps > 1) {
+                if (name !~ /_median$/)
+                    next
+                sub(/_median$/, "", name)
+            }
+            if ($6 != "")
+                print name, "rate", $6
+            else if ($7 != "")
+                print name, "rate", $7
+            else
+                print name, "time", $3
+        }'
+}
+
+# Normalizes the loopback harness's "perf:" key=value line into
+# "name kind value" lines for the gated pipeline metrics.
+normalizePerfLine() {
+    awk '
+        /^perf:/ {
+            for (i = 2; i <= NF; ++i) {
+                split($i, kv, "=")
+                if (kv[1] == "bytesPerSec")
+                    print "Pipeline/bytesPerSec", "rate", kv[2]
+                else if (kv[1] == "latP99")
+                    print "Pipeline/latP99", "time", kv[2]
+                else if (kv[1] == "cpuNsPerByte")
+                    print "Pipeline/cpuNsPerByte", "time", kv[2]
+            }
+        }'
+}
+
+# Compares "name kind value" results on standard input against a baseline
+# file. A rate metric regresses when it falls below baseline*(1-tolerance);
+# a time metric when it rises above baseline*(1+tolerance). Metrics absent
+# from the baseline are appended to it, so a new benchmark doesn't require
+# re-recording the others.
+compare() {
+    baseFile=$1
+    tol=$2
+    awk -v tol="$tol" -v baseFile="$baseFile" '
+        NR == FNR {
+            base[$1] = $3
+            next
+        }
+        {
+            if (!($1 in base)) {
+                printf "    new      %-40s %g (baseline recorded)\n", $1, $3
+                print >> baseFile
+                next
+            }
+            old = base[$1] + 0
+            new = $3 + 0
+            if (old == 0)
+                next
+            if ($2 == "rate") {
+                change = (new - old)/old
+                bad = (new < old*(1 - tol))
+            }
+            else {
+                change = (old - new)/old
+                bad = (new > old*(1 + tol))
+            }
+            if (bad) {
+                printf "    REGRESSED %-39s %g -> %g (%+.1f%%)\n",
+                        $1, old, new, change*100
+                failed = 1
+            }
+            else {
+                printf "    ok       %-40s %g -> %g (%+.1f%%)\n",
+                        $1, old, new, change*100
+            }
+        }
+        END {
+            exit failed ? 1 : 0
+        }' "$baseFile" -
+}
+
+# Records or compares one program's normalized results, which are read from
+# the results file. Not run in a pipeline so a failure can set `status`.
+check() {
+    name=$1
+    tol=$2
+    baseFile=$baseDir/$name.baseline
+    if $rebaseline || [ ! -s "$baseFile" ]; then
+        cp "$results" "$baseFile"
+        echo "    baseline recorded in $baseFile"
+    else
+        compare "$baseFile" "$tol" <"$results" || status=1
+    fi
+}
+
+for prog in "$@"; do
+    echo "perfcheck: ./$prog"
+    if [ "$repetitions" -gt 1 ]; then
+        aggFlags="--benchmark_repetitions=$repetitions \
+                --benchmark_report_aggregates_only=true"
+    else
+        aggFlags=
+    fi
+    ./"$prog" --benchmark_format=csv $aggFlags 2>/dev/null |
+            normalizeCsv >"$results"
+    check "`basename $prog`" "$tolerance"
+done
+
+if [ -n "$HYCAST_PERFCHECK_PIPELINE" ]; then
+    if [ -x "$pipelineProg" ]; then
+        echo "perfcheck: $pipelineProg (loopback pipeline)"
+        pipelineTol=`awk -v tol="$tolerance" 'BEGIN {print 2*tol}'`
+        "$pipelineProg" --gtest_filter='*Performance' |
+                normalizePerfLine >"$results"
+        check Pipeline "$pipelineTol"
+    else
+        echo "perfcheck: $pipelineProg isn't built; skipping the pipeline" \
+                "metrics (build it with \"make check\" in test/comms)"
+    fi
+fi
+
+if [ $status -ne 0 ]; then
+    echo "perfcheck: FAILED: a metric regressed beyond its tolerance." \
+            "If the change is accepted, re-record with --rebaseline."
+fi
+exit $status
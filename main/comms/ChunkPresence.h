@@ -0,0 +1,149 @@
+/**
+ * This file declares a direct-mapped, lockless bitmap summary of chunk
+ * possession.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: ChunkPresence.h
+ * @author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_COMMS_CHUNKPRESENCE_H_
+#define MAIN_COMMS_CHUNKPRESENCE_H_
+
+#include "Chunk.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+namespace hycast {
+
+/**
+ * Direct-mapped bitmap summary of chunk possession: `test()` answers "is this
+ * chunk known to be present" with one load and mask test -- no lock and no
+ * product-store bookkeeping. Each slot holds a per-product bitmap of
+ * chunk-indices, keyed by the packed chunk identifier; a product evicted by a
+ * hash collision merely makes `test()` answer `false`, so a miss is always
+ * safe and the caller falls back on its slower source of truth. A per-slot
+ * version number (odd while the slot is being re-assigned) keeps the lockless
+ * test from attributing one product's bits to another.
+ *
+ * Used both as a front-cache of locally-received chunks -- nearly every chunk
+ * arrives on both the multicast and P2P transports, so the second copy is
+ * rejected cheaply -- and as a per-peer summary of the chunks a remote peer
+ * provably has, so notices it doesn't need can be suppressed.
+ *
+ * @tparam numSlots  Number of product slots. Must be a power of two.
+ * @tparam numBits   Bitmap capacity per product. Chunk-indices at or beyond
+ *                   this fall through.
+ */
+template<size_t numSlots = 64, size_t numBits = 8192>
+class ChunkPresence final
+{
+    typedef std::mutex             Mutex;
+    typedef std::lock_guard<Mutex> LockGuard;
+
+    static const size_t numWords = numBits/64;
+
+    struct Slot
+    {
+        /// Odd while the slot is being re-assigned
+        std::atomic<uint64_t> version;
+        /// Index of the product that owns the slot
+        std::atomic<uint64_t> prodIndex;
+        /// Bitmap of present chunk-indices
+        std::atomic<uint64_t> words[numWords];
+        /// Serializes modifications
+        Mutex                 mutex;
+
+        Slot()
+            : version{0}
+            , prodIndex{0}
+            , words{}
+            , mutex{}
+        {}
+    };
+
+    Slot slots[numSlots];
+
+    inline Slot& getSlot(const uint64_t prodIndex) noexcept
+    {
+        return slots[prodIndex & (numSlots-1)];
+    }
+
+public:
+    ChunkPresence()
+        : slots{}
+    {}
+
+    /// Prevents copy and move construction and assignment
+    ChunkPresence(const ChunkPresence& that) =delete;
+    ChunkPresence(const ChunkPresence&& that) =delete;
+    ChunkPresence& operator =(const ChunkPresence& rhs) =delete;
+    ChunkPresence& operator =(const ChunkPresence&& rhs) =delete;
+
+    /**
+     * Indicates if a chunk is known to be present. Lock-free.
+     * @param[in] id     Chunk identifier
+     * @retval `true`    Chunk is present
+     * @retval `false`   Chunk might not be present: consult the slower
+     *                   source of truth
+     * @exceptionsafety  Nothrow
+     * @threadsafety     Safe
+     */
+    bool test(const ChunkId& id) noexcept
+    {
+        // One accessor call: both indices come from the packed identifier
+        const uint64_t packed = id.pack();
+        const uint64_t prodIndex = packed >> 32;
+        const uint32_t chunkIndex = static_cast<uint32_t>(packed);
+        if (chunkIndex >= numBits)
+            return false;
+        auto&      slot = getSlot(prodIndex);
+        const auto version = slot.version.load(std::memory_order_acquire);
+        if ((version & 1) ||
+                slot.prodIndex.load(std::memory_order_acquire) !=
+                        prodIndex)
+            return false;
+        const bool present = (slot.words[chunkIndex/64].load(
+                std::memory_order_acquire) >> (chunkIndex%64)) & 1;
+        // The slot might have been re-assigned between the loads
+        return present &&
+                slot.version.load(std::memory_order_acquire) == version;
+    }
+
+    /**
+     * Records that a chunk is present. Re-assigns the chunk's slot to the
+     * chunk's product if necessary.
+     * @param[in] id     Chunk identifier
+     * @exceptionsafety  Nothrow
+     * @threadsafety     Safe
+     */
+    void set(const ChunkId& id) noexcept
+    {
+        const uint64_t packed = id.pack();
+        const uint64_t prodIndex = packed >> 32;
+        const uint32_t chunkIndex = static_cast<uint32_t>(packed);
+        if (chunkIndex >= numBits)
+            return;
+        auto&     slot = getSlot(prodIndex);
+        LockGuard lock{slot.mutex};
+        if (slot.prodIndex.load(std::memory_order_relaxed) != prodIndex) {
+            slot.version.fetch_add(1, std::memory_order_acq_rel);
+            for (size_t i = 0; i < numWords; ++i)
+                slot.words[i].store(0, std::memory_order_relaxed);
+            slot.prodIndex.store(prodIndex, std::memory_order_relaxed);
+            slot.version.fetch_add(1, std::memory_order_release);
+        }
+        slot.words[chunkIndex/64].fetch_or(
+                uint64_t{1} << (chunkIndex%64),
+                std::memory_order_release);
+    }
+};
+
+} // namespace
+
+#endif /* MAIN_COMMS_CHUNKPRESENCE_H_ */
@@ -0,0 +1,384 @@
+/**
+ * This file implements a durable queue of data-products awaiting multicast
+ * transmission.
+ *
+ * The ring-file layout is
+ *
+ *     FileHdr | record | record | ... (wraps back to just after FileHdr)
+ *
+ * where every record is eight-byte aligned and comprises a fixed header, the
+ * product's name, its payload, and padding. A record whose size-field is zero
+ * is a wrap marker: the next record starts at the beginning of the ring.
+ * Records are completed -- including a CRC32C over name and payload -- before
+ * the file header's tail-offset publishes them, so a record torn by a crash
+ * is either unpublished or fails its checksum. The file is mapped shared, so
+ * the contents survive the death of the process without any synchronous I/O;
+ * `msync(MS_ASYNC)` merely hastens writeback for the case of host failure.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: DurableTxQueue.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "Crc32c.h"
+#include "DurableTxQueue.h"
+#include "error.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace hycast {
+
+class DurableTxQueue::Impl final
+{
+    typedef std::mutex             Mutex;
+    typedef std::lock_guard<Mutex> LockGuard;
+
+    /// File header. `head` is the offset of the oldest unreclaimed record;
+    /// `tail` is where the next record will be appended. `head == tail`
+    /// means the queue is empty.
+    struct FileHdr
+    {
+        uint64_t magic;    ///< Identifies a ring-file
+        uint64_t capacity; ///< Size of the file in bytes
+        uint64_t head;     ///< Offset of the oldest record
+        uint64_t tail;     ///< Offset of the next append
+        uint64_t pad[4];   ///< Reserved
+    };
+
+    /// Record header. Followed by the product's name, its payload, and
+    /// padding to an eight-byte boundary.
+    struct RecHdr
+    {
+        uint32_t size;      ///< Total record size in bytes, eight-byte
+                            ///< aligned. 0 => wrap marker.
+        uint32_t state;     ///< `PENDING` or `DONE`
+        uint64_t index;     ///< Product index
+        uint32_t prodSize;  ///< Payload size in bytes
+        uint32_t crc;       ///< CRC32C of name and payload
+        uint16_t chunkSize; ///< Canonical chunk-size
+        uint16_t nameLen;   ///< Length of the product name in bytes
+        uint32_t pad;       ///< Reserved
+    };
+
+    static const uint64_t fileMagic = UINT64_C(0x68796354785F3031); // "hycTxQ01"
+    static const uint32_t PENDING = 0;
+    static const uint32_t DONE = 1;
+    /// Offset of the first record
+    static const uint64_t dataStart = sizeof(FileHdr);
+
+    mutable Mutex mutex;
+    std::string   pathname;
+    int           fd;
+    char*         base;     ///< Mapped ring-file
+    FileHdr*      hdr;
+    size_t        numRecs;  ///< Number of unacknowledged records
+
+    inline RecHdr* recAt(const uint64_t offset) noexcept
+    {
+        return reinterpret_cast<RecHdr*>(base + offset);
+    }
+
+    /// Rounds a size up to an eight-byte boundary
+    inline static uint64_t align(const uint64_t nbytes) noexcept
+    {
+        return (nbytes + 7) & ~UINT64_C(7);
+    }
+
+    /**
+     * Advances an iteration position past the end of the ring and past any
+     * wrap marker.
+     * @param[in] pos  Iteration position
+     * @return         Position of the record at `pos`, wrapped if necessary
+     */
+    inline uint64_t wrapped(uint64_t pos) noexcept
+    {
+        if (pos == hdr->capacity || recAt(pos)->size == 0)
+            pos = dataStart;
+        return pos;
+    }
+
+    /**
+     * Hastens writeback of the mapped file. The mapping itself already
+     * survives a process crash; this narrows the window for a host failure.
+     */
+    void sync() noexcept
+    {
+        ::msync(base, hdr->capacity, MS_ASYNC);
+    }
+
+    /**
+     * Reclaims acknowledged records from the front of the queue.
+     * @pre `mutex` is locked
+     */
+    void reclaim() noexcept
+    {
+        while (hdr->head != hdr->tail) {
+            const auto pos = wrapped(hdr->head);
+            auto       rec = recAt(pos);
+            if (rec->state != DONE)
+                break;
+            hdr->head = pos + rec->size;
+        }
+        if (hdr->head == hdr->tail)
+            hdr->head = hdr->tail = dataStart; // Empty: normalize
+    }
+
+    /**
+     * Counts the unacknowledged records -- e.g., after opening an existing
+     * ring-file.
+     * @return  Number of unacknowledged records
+     */
+    size_t countRecs() noexcept
+    {
+        size_t count = 0;
+        for (auto pos = hdr->head; pos != hdr->tail; ) {
+            pos = wrapped(pos);
+            const auto rec = recAt(pos);
+            // An out-of-order acknowledgment leaves a DONE record between
+            // the head and the tail; it's not pending
+            if (rec->state != DONE)
+                ++count;
+            pos += rec->size;
+        }
+        return count;
+    }
+
+public:
+    /**
+     * Constructs.
+     * @param[in] pathname     Pathname of the ring-file
+     * @param[in] capacity     Size of the ring-file in bytes. Ignored if the
+     *                         file already exists.
+     * @throw InvalidArgument  Capacity is too small for a single product
+     * @throw RuntimeError     Existing file isn't a ring-file
+     * @throw SystemError      File couldn't be created, sized, or mapped
+     */
+    Impl(   const std::string& pathname,
+            const size_t       capacity)
+        : mutex{}
+        , pathname{pathname}
+        , fd{-1}
+        , base{nullptr}
+        , hdr{nullptr}
+        , numRecs{0}
+    {
+        if (capacity < dataStart + 4096)
+            throw INVALID_ARGUMENT("Ring-file capacity is too small: " +
+                    std::to_string(capacity));
+        fd = ::open(pathname.c_str(), O_RDWR|O_CREAT, 0666);
+        if (fd < 0)
+            throw SYSTEM_ERROR("Couldn't open ring-file \"" + pathname +
+                    "\"");
+        try {
+            struct stat stat;
+            if (::fstat(fd, &stat))
+                throw SYSTEM_ERROR("Couldn't stat ring-file \"" + pathname +
+                        "\"");
+            const bool fresh = stat.st_size == 0;
+            const auto size = fresh
+                    ? align(capacity)
+                    : static_cast<uint64_t>(stat.st_size);
+            if (fresh && ::ftruncate(fd, size))
+                throw SYSTEM_ERROR("Couldn't size ring-file \"" + pathname +
+                        "\"");
+            void* const addr = ::mmap(nullptr, size, PROT_READ|PROT_WRITE,
+                    MAP_SHARED, fd, 0);
+            if (addr == MAP_FAILED)
+                throw SYSTEM_ERROR("Couldn't map ring-file \"" + pathname +
+                        "\"");
+            base = static_cast<char*>(addr);
+            hdr = reinterpret_cast<FileHdr*>(base);
+            if (fresh) {
+                hdr->magic = fileMagic;
+                hdr->capacity = size;
+                hdr->head = hdr->tail = dataStart;
+                sync();
+            }
+            else {
+                if (hdr->magic != fileMagic || hdr->capacity != size)
+                    throw RUNTIME_ERROR("\"" + pathname + "\" isn't a "
+                            "transmit-queue ring-file");
+                numRecs = countRecs();
+            }
+        }
+        catch (...) {
+            if (base)
+                ::munmap(base, hdr->capacity);
+            ::close(fd);
+            throw;
+        }
+    }
+
+    /// Prevents copy and move construction and assignment
+    Impl(const Impl& that) =delete;
+    Impl(const Impl&& that) =delete;
+    Impl& operator =(const Impl& rhs) =delete;
+    Impl& operator =(const Impl&& rhs) =delete;
+
+    ~Impl() noexcept
+    {
+        ::munmap(base, hdr->capacity);
+        ::close(fd);
+    }
+
+    bool put(
+            Product&  prod,
+            uint64_t& id)
+    {
+        const auto     info = prod.getInfo();
+        // The view pins the product's storage while its bytes are copied
+        const auto     span = prod.getDataSpan();
+        const char*    name = info.getName().c_str();
+        const uint16_t nameLen = static_cast<uint16_t>(::strlen(name));
+        const uint64_t need = align(sizeof(RecHdr) + nameLen +
+                info.getSize());
+
+        LockGuard lock{mutex};
+        uint64_t  pos;
+        if (hdr->head <= hdr->tail) {
+            if (hdr->capacity - hdr->tail >= need) {
+                pos = hdr->tail;
+            }
+            else if (hdr->head > dataStart + need) {
+                // Wrap: mark the unused space at the end of the ring
+                if (hdr->tail < hdr->capacity)
+                    recAt(hdr->tail)->size = 0;
+                pos = dataStart;
+            }
+            else {
+                return false; // Full
+            }
+        }
+        else if (hdr->head - hdr->tail > need) {
+            pos = hdr->tail;
+        }
+        else {
+            return false; // Full
+        }
+
+        auto rec = recAt(pos);
+        rec->size = static_cast<uint32_t>(need);
+        rec->state = PENDING;
+        rec->index = static_cast<ProdIndex::type>(info.getIndex());
+        rec->prodSize = info.getSize();
+        rec->chunkSize = static_cast<ChunkSize::type>(info.getChunkSize());
+        rec->nameLen = nameLen;
+        rec->pad = 0;
+        char* body = reinterpret_cast<char*>(rec + 1);
+        ::memcpy(body, name, nameLen);
+        ::memcpy(body + nameLen, span.getData(), info.getSize());
+        rec->crc = crc32c(0, body, nameLen + info.getSize());
+        // The record is complete; publishing it is a single word-store
+        hdr->tail = pos + need;
+        ++numRecs;
+        sync();
+        id = pos;
+        return true;
+    }
+
+    void done(const uint64_t id) noexcept
+    {
+        LockGuard lock{mutex};
+        auto rec = recAt(id);
+        // `numRecs` counts PENDING records, so it's decremented on the
+        // transition only: a repeated acknowledgment is a no-op
+        if (rec->state == PENDING) {
+            rec->state = DONE;
+            --numRecs;
+        }
+        reclaim();
+        sync();
+    }
+
+    void replay(const Replayer& replayer)
+    {
+        /*
+         * Unlocked iteration: replaying re-enters `done()` via the replayer,
+         * and `put()` isn't called until the replay is over. The tail is
+         * snapshotted because acknowledgments during the replay may drain
+         * the queue and normalize the header offsets.
+         */
+        const auto tail = hdr->tail;
+        for (auto pos = hdr->head; pos != tail; ) {
+            pos = wrapped(pos);
+            auto rec = recAt(pos);
+            const char* body = reinterpret_cast<const char*>(rec + 1);
+            if (rec->size < sizeof(RecHdr) ||
+                    rec->crc != crc32c(0, body, rec->nameLen +
+                            rec->prodSize)) {
+                LOG_WARN("Transmit-queue record at offset " +
+                        std::to_string(pos) + " of \"" + pathname + "\" is "
+                        "corrupt (torn by a crash?); abandoning the replay "
+                        "of it and the records that follow it");
+                break;
+            }
+            if (rec->state == PENDING) {
+                /*
+                 * The payload is copied off the ring: the product may
+                 * outlive its record -- the product-store retains it for
+                 * peers -- while the record's space is reclaimed and
+                 * overwritten after transmission
+                 */
+                char* const copy = new char[rec->prodSize];
+                ::memcpy(copy, body + rec->nameLen, rec->prodSize);
+                Product prod = MemoryProduct{ProdIndex{rec->index},
+                        ProdName{std::string{body, rec->nameLen}.c_str()},
+                        ProdSize{rec->prodSize}, copy,
+                        [copy]{ delete[] copy; },
+                        ChunkSize{rec->chunkSize}};
+                replayer(pos, prod);
+            }
+            pos += rec->size;
+        }
+    }
+
+    size_t size() const noexcept
+    {
+        LockGuard lock{mutex};
+        return numRecs;
+    }
+};
+
+DurableTxQueue::DurableTxQueue(
+        const std::string& pathname,
+        const size_t       capacity)
+    : pImpl{new Impl(pathname, capacity)}
+{}
+
+DurableTxQueue::operator bool() const noexcept
+{
+    return static_cast<bool>(pImpl);
+}
+
+bool DurableTxQueue::put(
+        Product&  prod,
+        uint64_t& id)
+{
+    return pImpl->put(prod, id);
+}
+
+void DurableTxQueue::done(const uint64_t id) noexcept
+{
+    pImpl->done(id);
+}
+
+void DurableTxQueue::replay(const Replayer& replayer)
+{
+    pImpl->replay(replayer);
+}
+
+size_t DurableTxQueue::size() const noexcept
+{
+    return pImpl->size();
+}
+
+} // namespace
@@ -0,0 +1,122 @@
+/**
+ * This file declares a durable queue of data-products awaiting multicast
+ * transmission. The queue is a memory-mapped ring-file: a product enters
+ * when it's accepted for shipment and leaves only after it has been fully
+ * multicast, so products that the ingester has already consumed survive a
+ * crash of the sending process and are replayed at the next startup.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: DurableTxQueue.h
+ * @author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_COMMS_DURABLETXQUEUE_H_
+#define MAIN_COMMS_DURABLETXQUEUE_H_
+
+#include "Product.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace hycast {
+
+class DurableTxQueue final
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Function that re-ships a replayed product. Called with the record
+     * identifier -- to be passed to `done()` after the product has been
+     * fully multicast -- and the reconstituted product, whose data refers
+     * directly into the ring-file.
+     */
+    typedef std::function<void(uint64_t id, Product& prod)> Replayer;
+
+    /**
+     * Default constructs an empty instance that may be the target of an
+     * assignment.
+     */
+    DurableTxQueue() =default;
+
+    /**
+     * Constructs. Creates the ring-file if it doesn't exist; otherwise,
+     * opens it and leaves any unacknowledged records in place for
+     * `replay()`.
+     * @param[in] pathname     Pathname of the ring-file
+     * @param[in] capacity     Size of the ring-file in bytes. Ignored if the
+     *                         file already exists, whose capacity then
+     *                         governs.
+     * @throw InvalidArgument  Capacity is too small for a single product
+     * @throw RuntimeError     Existing file isn't a ring-file
+     * @throw SystemError      File couldn't be created, sized, or mapped
+     */
+    DurableTxQueue(
+            const std::string& pathname,
+            const size_t       capacity);
+
+    /**
+     * Indicates if this instance is valid (i.e., not default constructed).
+     * @retval `true`  Iff this instance is valid
+     */
+    operator bool() const noexcept;
+
+    /**
+     * Appends a product to the queue. The record is complete in the file
+     * before it's published, so a crash can't replay a torn product. If the
+     * ring is full -- transmission has fallen far behind ingest -- the
+     * product is *not* recorded: availability is preferred over durability
+     * for a queue whose steady state is nearly empty.
+     * @param[in]  prod  Product to record
+     * @param[out] id    Identifier of the record for `done()`
+     * @retval `true`    The product was recorded
+     * @retval `false`   The ring is full
+     * @exceptionsafety  Basic guarantee
+     * @threadsafety     Safe
+     */
+    bool put(
+            Product&  prod,
+            uint64_t& id);
+
+    /**
+     * Acknowledges the full multicast transmission of a product. Its record
+     * becomes reclaimable; the oldest records are reclaimed in order, so an
+     * out-of-order acknowledgment is deferred until its predecessors are
+     * also acknowledged.
+     * @param[in] id     Identifier from `put()` or `replay()`
+     * @exceptionsafety  Nothrow
+     * @threadsafety     Safe
+     */
+    void done(const uint64_t id) noexcept;
+
+    /**
+     * Replays every unacknowledged product in arrival order -- i.e., every
+     * product a previous process recorded but didn't fully transmit. A
+     * record with a checksum mismatch (e.g., torn by the crash) ends the
+     * replay with a warning: later records were appended after it and are
+     * suspect. Call once, before new products are `put()`.
+     * @param[in] replayer  Re-ships a product; must call `done()` with the
+     *                      given identifier after full transmission
+     * @exceptionsafety     Basic guarantee
+     * @threadsafety        Safe
+     */
+    void replay(const Replayer& replayer);
+
+    /**
+     * Returns the number of unacknowledged products.
+     * @return           Number of unacknowledged products
+     * @exceptionsafety  Nothrow
+     * @threadsafety     Safe
+     */
+    size_t size() const noexcept;
+};
+
+} // namespace
+
+#endif /* MAIN_COMMS_DURABLETXQUEUE_H_ */
@@ -0,0 +1,358 @@
+/**
+ * This file implements a write-behind file disposition for received
+ * data-products.
+ *
+ * Copyright 2018 University Corporation for Atmospheric Research.
+ * See file "COPYING" in the top-level source-directory for terms and
+ * conditions.
+ *
+ *   @file: FileWriting.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "error.h"
+#include "FileWriting.h"
+#include "Metrics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <queue>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace hycast {
+
+class FileWriting::Impl final
+{
+    typedef std::mutex              Mutex;
+    typedef std::lock_guard<Mutex>  LockGuard;
+    typedef std::unique_lock<Mutex> UniqueLock;
+
+    /// Default maximum number of queued-but-unwritten bytes (128 MB)
+    static const size_t defaultMaxBacklog = 128*1024*1024;
+    /// Alignment required of O_DIRECT transfer sizes and buffer addresses
+    static const size_t directAlign = 4096;
+    /// Size of the aligned staging-buffer for O_DIRECT writes
+    static const size_t directBufSize = 1024*1024;
+
+    typedef std::function<void(const ProdInfo&, const std::string&)> Observer;
+
+    const std::string       rootDirPathname;
+    const size_t            maxBacklog;
+    /// Whether to attempt O_DIRECT. Cleared on the first filesystem that
+    /// rejects it.
+    std::atomic<bool>       useDirect;
+    /// Guards `prods`, `backlogBytes`, `observer` and `done`
+    Mutex                   mutex;
+    /// Signaled when `prods` or `backlogBytes` changes
+    std::condition_variable cond;
+    /// Queued-but-unwritten data-products in submission order
+    std::queue<Product>     prods;
+    /// Number of queued-but-unwritten bytes
+    std::atomic<size_t>     backlogBytes;
+    Observer                observer;
+    bool                    done;
+    /// Writer threads. Declared last so that construction of the other
+    /// members precedes their use.
+    std::vector<std::thread> writers;
+
+    /**
+     * Creates the (possibly nested) parent directories of a file.
+     * @param[in] pathname  Pathname of the file
+     * @throw SystemError   `mkdir()` failure
+     */
+    void ensureParentDirs(const std::string& pathname)
+    {
+        for (auto pos = pathname.find('/', rootDirPathname.length() + 1);
+                pos != std::string::npos;
+                pos = pathname.find('/', pos + 1)) {
+            const auto dirPathname = pathname.substr(0, pos);
+            if (::mkdir(dirPathname.data(), 0777) && errno != EEXIST)
+                throw SYSTEM_ERROR(std::string{"mkdir() failure on \""} +
+                        dirPathname + "\"");
+        }
+    }
+
+    /**
+     * Writes bytes to a file, handling partial writes.
+     * @param[in] fd        File-descriptor of the file
+     * @param[in] data      Bytes to write
+     * @param[in] nbytes    Number of bytes to write
+     * @param[in] pathname  Pathname of the file (for error messages)
+     * @throw SystemError   `write()` failure
+     */
+    static void writeAll(
+            const int          fd,
+            const char*        data,
+            size_t             nbytes,
+            const std::string& pathname)
+    {
+        while (nbytes > 0) {
+            const auto nwritten = ::write(fd, data, nbytes);
+            if (nwritten == -1) {
+                if (errno == EINTR)
+                    continue;
+                throw SYSTEM_ERROR(std::string{"write() failure on \""} +
+                        pathname + "\"");
+            }
+            data += nwritten;
+            nbytes -= nwritten;
+        }
+    }
+
+    /**
+     * Writes a data-product's data to an O_DIRECT file-descriptor. The data
+     * is staged through an aligned buffer because O_DIRECT requires aligned
+     * addresses and transfer-sizes; the final, partial block is written
+     * rounded-up and the file is then truncated to the true size.
+     * @param[in] fd        File-descriptor. Opened with O_DIRECT.
+     * @param[in] data      Product data
+     * @param[in] size      Size of the data in bytes
+     * @param[in] pathname  Pathname of the file (for error messages)
+     * @throw SystemError   `posix_memalign()`, `write()` or `ftruncate()`
+     *                      failure
+     */
+    static void writeDirect(
+            const int          fd,
+            const char*        data,
+            const size_t       size,
+            const std::string& pathname)
+    {
+        void* buf;
+        if (::posix_memalign(&buf, directAlign, directBufSize))
+            throw SYSTEM_ERROR("posix_memalign() failure");
+        std::unique_ptr<void, void(*)(void*)> bufPtr{buf, &::free};
+        for (size_t offset = 0; offset < size; ) {
+            const auto nbytes = std::min(size - offset, directBufSize);
+            auto       nwrite = (nbytes + directAlign - 1) &
+                    ~(directAlign - 1);
+            ::memcpy(buf, data + offset, nbytes);
+            if (nwrite > nbytes)
+                ::memset(static_cast<char*>(buf) + nbytes, 0,
+                        nwrite - nbytes);
+            writeAll(fd, static_cast<const char*>(buf), nwrite, pathname);
+            offset += nbytes;
+        }
+        if ((size % directAlign) && ::ftruncate(fd, size))
+            throw SYSTEM_ERROR(std::string{"ftruncate() failure on \""} +
+                    pathname + "\"");
+    }
+
+    /**
+     * Writes a data-product's file. Uses O_DIRECT when enabled and supported
+     * by the filesystem -- the data bypasses the page cache entirely --
+     * otherwise writes normally, flushes, and advises the kernel to evict
+     * the pages, so write-once data doesn't displace the product-store.
+     * @param[in] prod     Data-product
+     * @param[in] pathname Pathname of the file
+     * @throw SystemError  Couldn't create or write the file
+     */
+    void writeFile(
+            Product&           prod,
+            const std::string& pathname)
+    {
+        const auto size = prod.getInfo().getSize();
+        bool       direct = useDirect;
+        int        fd = -1;
+        if (direct) {
+            fd = ::open(pathname.data(),
+                    O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC|O_DIRECT, 0666);
+            if (fd == -1) {
+                if (errno == EINVAL)
+                    // The filesystem doesn't support O_DIRECT
+                    useDirect = false;
+                direct = false;
+            }
+        }
+        if (fd == -1)
+            fd = ::open(pathname.data(), O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC,
+                    0666);
+        if (fd == -1)
+            throw SYSTEM_ERROR(std::string{"open() failure on \""} + pathname
+                    + "\"");
+        try {
+            if (direct) {
+                writeDirect(fd, prod.getData(), size, pathname);
+            }
+            else {
+                writeAll(fd, prod.getData(), size, pathname);
+                if (::fdatasync(fd) == 0)
+                    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            }
+            ::close(fd);
+        }
+        catch (...) {
+            ::close(fd);
+            throw;
+        }
+    }
+
+    /**
+     * Executes a writer thread. Drains the queue -- including after shutdown
+     * has been requested -- so every queued data-product is written. A write
+     * failure is logged, doesn't invoke the completion observer, and doesn't
+     * terminate the writer.
+     */
+    void runWriter()
+    {
+        for (;;) {
+            Product  prod{};
+            Observer completion{};
+            {
+                UniqueLock lock{mutex};
+                while (prods.empty() && !done)
+                    cond.wait(lock);
+                if (prods.empty())
+                    break; // `done` is set
+                prod = prods.front();
+                prods.pop();
+                completion = observer;
+            }
+            const auto& prodInfo = prod.getInfo();
+            const auto  pathname = rootDirPathname + "/" +
+                    prodInfo.getName().to_string();
+            try {
+                ensureParentDirs(pathname);
+                writeFile(prod, pathname);
+                static auto& fileCount = Metrics::getCounter(
+                        "hycast_disposition_files_written_total",
+                        "Data-product files completely written");
+                static auto& byteCount = Metrics::getCounter(
+                        "hycast_disposition_bytes_written_total",
+                        "Data-product bytes completely written");
+                fileCount.add(1);
+                byteCount.add(prodInfo.getSize());
+                if (completion)
+                    completion(prodInfo, pathname);
+            }
+            catch (const std::exception& ex) {
+                log_error(ex);
+            }
+            {
+                LockGuard lock{mutex};
+                backlogBytes -= prodInfo.getSize();
+                cond.notify_all();
+            }
+        }
+    }
+
+public:
+    /**
+     * Constructs. Starts the writer threads.
+     * @param[in] rootDirPathname  Pathname of the root directory
+     * @param[in] numWriters       Number of writer threads
+     * @param[in] maxBacklog       Maximum number of queued-but-unwritten
+     *                             bytes or 0 for the default
+     * @param[in] direct           Whether to attempt O_DIRECT writes
+     * @throw InvalidArgument      `numWriters == 0`
+     */
+    Impl(   const std::string& rootDirPathname,
+            const unsigned     numWriters,
+            const size_t       maxBacklog,
+            const bool         direct)
+        : rootDirPathname{rootDirPathname}
+        , maxBacklog{maxBacklog ? maxBacklog : defaultMaxBacklog}
+        , useDirect{direct}
+        , mutex{}
+        , cond{}
+        , prods{}
+        , backlogBytes{0}
+        , observer{}
+        , done{false}
+        , writers{}
+    {
+        if (numWriters == 0)
+            throw INVALID_ARGUMENT("Zero writer threads");
+        writers.reserve(numWriters);
+        for (unsigned i = 0; i < numWriters; ++i)
+            writers.emplace_back([this]{runWriter();});
+    }
+
+    Impl(const Impl& impl) =delete;
+    Impl& operator=(const Impl& rhs) =delete;
+
+    /**
+     * Destroys. The writer threads drain the queue before terminating, so
+     * every queued data-product is written.
+     */
+    ~Impl() noexcept
+    {
+        try {
+            {
+                LockGuard lock{mutex};
+                done = true;
+                cond.notify_all();
+            }
+            for (auto& writer : writers)
+                writer.join();
+        }
+        catch (const std::exception& ex) {
+            log_error(ex);
+        }
+    }
+
+    /**
+     * Queues a data-product for writing. Blocks while the dirty backlog is
+     * full.
+     * @param[in] prod   Data-product to be written
+     * @exceptionsafety  Basic guarantee
+     * @threadsafety     Safe
+     */
+    void process(Product prod)
+    {
+        const size_t size = prod.getInfo().getSize();
+        UniqueLock   lock{mutex};
+        while (backlogBytes + size > maxBacklog && backlogBytes > 0)
+            cond.wait(lock);
+        backlogBytes += size;
+        prods.push(prod);
+        cond.notify_all();
+    }
+
+    void setCompletionObserver(const Observer& observer)
+    {
+        LockGuard lock{mutex};
+        this->observer = observer;
+    }
+
+    size_t getBacklog() const noexcept
+    {
+        return backlogBytes;
+    }
+}; // FileWriting::Impl
+
+FileWriting::FileWriting(
+        const std::string& rootDirPathname,
+        const unsigned     numWriters,
+        const size_t       maxBacklog,
+        const bool         direct)
+    : pImpl{new Impl{rootDirPathname, numWriters, maxBacklog, direct}}
+{}
+
+void FileWriting::process(Product prod)
+{
+    pImpl->process(prod);
+}
+
+void FileWriting::setCompletionObserver(
+        const std::function<void(const ProdInfo&, const std::string&)>&
+                observer)
+{
+    pImpl->setCompletionObserver(observer);
+}
+
+size_t FileWriting::getBacklog() const noexcept
+{
+    return pImpl->getBacklog();
+}
+
+} // namespace
@@ -0,0 +1,100 @@
+/**
+ * This file declares a write-behind file disposition for received
+ * data-products. Completed data-products are queued -- with a bounded dirty
+ * backlog -- to a pool of writer threads, so the submitting thread never
+ * blocks on disk latency, and the files are written with O_DIRECT (or, where
+ * the filesystem doesn't support it, flushed and evicted with
+ * posix_fadvise(2)) so that write-once data doesn't displace the
+ * product-store from the page cache.
+ *
+ * Copyright 2018 University Corporation for Atmospheric Research.
+ * See file "COPYING" in the top-level source-directory for terms and
+ * conditions.
+ *
+ *   @file: FileWriting.h
+ * @author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_COMMS_FILEWRITING_H_
+#define MAIN_COMMS_FILEWRITING_H_
+
+#include "Processing.h"
+#include "Product.h"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace hycast {
+
+/**
+ * Class that disposes of data-products by writing each to the file named by
+ * its product-name under a root directory. `process()` only queues: the
+ * writing -- including directory creation and the flush -- happens on writer
+ * threads, so one slow disk doesn't stall the delivery pipeline. The backlog
+ * of queued-but-unwritten bytes is bounded: a full backlog blocks `process()`
+ * -- backpressure to the submitter -- rather than accumulating unbounded
+ * dirty state.
+ */
+class FileWriting final : public Processing
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Constructs. Starts the writer threads.
+     * @param[in] rootDirPathname  Pathname of the directory under which the
+     *                             data-products are written. Must exist.
+     * @param[in] numWriters       Number of writer threads
+     * @param[in] maxBacklog       Maximum number of queued-but-unwritten
+     *                             bytes or 0 for a reasonable default.
+     *                             `process()` blocks while the backlog is
+     *                             full.
+     * @param[in] direct           Whether to attempt O_DIRECT writes. On a
+     *                             filesystem that doesn't support O_DIRECT,
+     *                             writing falls back to a regular write
+     *                             followed by fdatasync(2) and
+     *                             posix_fadvise(POSIX_FADV_DONTNEED).
+     * @throw InvalidArgument      `numWriters == 0`
+     */
+    explicit FileWriting(
+            const std::string& rootDirPathname,
+            const unsigned     numWriters = 1,
+            const size_t       maxBacklog = 0,
+            const bool         direct = true);
+
+    /**
+     * Queues a data-product for writing. Blocks while the dirty backlog is
+     * full; otherwise, returns quickly -- never on disk latency.
+     * @param[in] prod   Data-product to be written
+     * @exceptionsafety  Basic guarantee
+     * @threadsafety     Safe
+     */
+    void process(Product prod);
+
+    /**
+     * Sets the function to call -- on a writer thread -- after a
+     * data-product's file has been completely written. E.g., so a durable
+     * receive-queue can retire the product's record only once it's on disk.
+     * A write failure is logged and doesn't invoke the observer.
+     * @param[in] observer  Function to call with the product's information
+     *                      and the pathname of the written file
+     * @exceptionsafety     Strong guarantee
+     * @threadsafety        Safe
+     */
+    void setCompletionObserver(
+            const std::function<void(const ProdInfo&, const std::string&)>&
+                    observer);
+
+    /**
+     * Returns the number of queued-but-unwritten bytes.
+     * @return Number of queued-but-unwritten bytes
+     */
+    size_t getBacklog() const noexcept;
+};
+
+} // namespace
+
+#endif /* MAIN_COMMS_FILEWRITING_H_ */
@@ -37,6 +37,25 @@ public:
      * @threadsafety              Compatible but not safe
      */
     virtual void notify(const ChunkId& chunkId) const =0;
+    /**
+     * Notifies about a contiguous range of available chunks-of-data. One
+     * coalesced notice is sent instead of a notice per chunk.
+     * @param[in] chunkRange      Relevant range of chunk identifiers
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    virtual void notify(const ChunkRange& chunkRange) const =0;
+    /**
+     * Notifies about a set of available chunks-of-data encoded as contiguous
+     * ranges. One coalesced notice is sent instead of a notice per chunk or
+     * per range.
+     * @param[in] rangeSet        Relevant set of chunk-ranges
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    virtual void notify(const ChunkRangeSet& rangeSet) const =0;
 };
 
 } // namespace
@@ -0,0 +1,231 @@
+/**
+ * This file implements a parallel stage for local processing of received
+ * data-products.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research.
+ * See file "COPYING" in the top-level source-directory for terms and
+ * conditions.
+ *
+ *   @file: ParallelProcessing.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "error.h"
+#include "ParallelProcessing.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hycast {
+
+class ParallelProcessing::Impl final
+{
+    typedef std::mutex              Mutex;
+    typedef std::unique_lock<Mutex> UniqueLock;
+
+    /// Worker thread and its bounded queue of unprocessed data-products
+    struct Worker
+    {
+        Mutex                   mutex;
+        std::condition_variable nonEmpty;
+        std::condition_variable nonFull;
+        std::deque<Product>     prods;
+        bool                    done;
+        std::thread             thread;
+
+        Worker()
+            : mutex{}
+            , nonEmpty{}
+            , nonFull{}
+            , prods{}
+            , done{false}
+            , thread{}
+        {}
+
+        Worker(const Worker& that) =delete;
+        Worker& operator=(const Worker& rhs) =delete;
+    };
+
+    Processing&                          downstream;
+    const size_t                         maxQueued;
+    const bool                           ordered;
+    /// Submitted but not yet completely processed data-products
+    std::atomic<size_t>                  outstanding;
+    /// Next worker for unordered dispatch. Monotonically increasing.
+    std::atomic<size_t>                  nextWorker;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    /**
+     * Executes a worker thread. Drains the worker's queue -- including after
+     * shutdown has been requested -- so every submitted data-product is
+     * processed. An exception thrown by the downstream processor is logged
+     * and doesn't terminate the worker.
+     * @param[in] worker  Worker whose queue should be drained
+     */
+    void runWorker(Worker& worker)
+    {
+        for (;;) {
+            Product prod{};
+            {
+                UniqueLock lock{worker.mutex};
+                while (worker.prods.empty() && !worker.done)
+                    worker.nonEmpty.wait(lock);
+                if (worker.prods.empty())
+                    break; // `worker.done` is set
+                prod = worker.prods.front();
+                worker.prods.pop_front();
+                worker.nonFull.notify_one();
+            }
+            try {
+                downstream.process(prod);
+            }
+            catch (const std::exception& ex) {
+                log_error(ex);
+            }
+            --outstanding;
+        }
+    }
+
+    /**
+     * Returns the worker that should process a data-product. When ordering is
+     * enabled, the worker is chosen by hashing the data-product's name so
+     * that same-named data-products are processed in submission order;
+     * otherwise, workers are chosen round-robin.
+     * @param[in] prod  Data-product to be processed
+     * @return          Worker that should process the data-product
+     */
+    inline Worker& getWorker(const Product& prod)
+    {
+        const size_t index = ordered
+                ? std::hash<std::string>{}(prod.getInfo().getName().to_string())
+                        % workers.size()
+                : nextWorker++ % workers.size();
+        return *workers[index];
+    }
+
+public:
+    /**
+     * Constructs. Starts the worker threads.
+     * @param[in] downstream  Processor of data-products
+     * @param[in] numWorkers  Number of worker threads or 0 to use the number
+     *                        of hardware threads
+     * @param[in] maxQueued   Maximum number of unprocessed data-products per
+     *                        worker
+     * @param[in] ordered     Whether data-products with the same name must be
+     *                        processed in submission order
+     * @throw InvalidArgument `maxQueued == 0`
+     */
+    Impl(   Processing&  downstream,
+            size_t       numWorkers,
+            const size_t maxQueued,
+            const bool   ordered)
+        : downstream(downstream)
+        , maxQueued{maxQueued}
+        , ordered{ordered}
+        , outstanding{0}
+        , nextWorker{0}
+        , workers{}
+    {
+        if (maxQueued == 0)
+            throw INVALID_ARGUMENT("Zero queue capacity");
+        if (numWorkers == 0) {
+            numWorkers = std::thread::hardware_concurrency();
+            if (numWorkers == 0)
+                numWorkers = 1;
+        }
+        workers.reserve(numWorkers);
+        for (size_t i = 0; i < numWorkers; ++i)
+            workers.emplace_back(new Worker{});
+        for (auto& worker : workers) {
+            Worker* const ptr = worker.get();
+            worker->thread = std::thread([this,ptr]{runWorker(*ptr);});
+        }
+    }
+
+    Impl(const Impl& impl) =delete;
+    Impl& operator=(const Impl& rhs) =delete;
+
+    /**
+     * Destroys. The worker threads drain their queues before terminating, so
+     * every submitted data-product is processed.
+     */
+    ~Impl() noexcept
+    {
+        try {
+            for (auto& worker : workers) {
+                UniqueLock lock{worker->mutex};
+                worker->done = true;
+                worker->nonEmpty.notify_all();
+            }
+            for (auto& worker : workers)
+                worker->thread.join();
+        }
+        catch (const std::exception& e) {
+            log_error(e);
+        }
+    }
+
+    /**
+     * Submits a data-product for processing. Blocks while the relevant
+     * worker's queue is full. The data-product is inserted after the last
+     * queued data-product of equal or greater priority class, so an urgent
+     * data-product is processed before queued bulk ones and same-priority
+     * data-products (in particular, same-named ones when ordering is
+     * enabled) stay in submission order.
+     * @param[in] prod   Data-product to be processed
+     * @exceptionsafety  Basic guarantee
+     * @threadsafety     Safe
+     */
+    void process(Product prod)
+    {
+        auto&      worker = getWorker(prod);
+        UniqueLock lock{worker.mutex};
+        while (worker.prods.size() >= maxQueued)
+            worker.nonFull.wait(lock);
+        ++outstanding;
+        const auto priority = prod.getInfo().getPriority();
+        auto       pos = worker.prods.end();
+        while (pos != worker.prods.begin() &&
+                (pos - 1)->getInfo().getPriority() < priority)
+            --pos;
+        worker.prods.insert(pos, prod);
+        worker.nonEmpty.notify_one();
+    }
+
+    /**
+     * Returns the number of submitted but not yet completely processed
+     * data-products.
+     * @return Number of outstanding data-products
+     */
+    size_t getOutstanding() const noexcept
+    {
+        return outstanding.load();
+    }
+};
+
+ParallelProcessing::ParallelProcessing(
+        Processing&  downstream,
+        const size_t numWorkers,
+        const size_t maxQueued,
+        const bool   ordered)
+    : pImpl{new Impl(downstream, numWorkers, maxQueued, ordered)}
+{}
+
+void ParallelProcessing::process(Product prod)
+{
+    pImpl->process(prod);
+}
+
+size_t ParallelProcessing::getOutstanding() const noexcept
+{
+    return pImpl->getOutstanding();
+}
+
+} // namespace
@@ -0,0 +1,81 @@
+/**
+ * This file declares a parallel stage for local processing of received
+ * data-products. A pool of worker threads drains completed data-products so
+ * that one slow disposition doesn't block delivery of everything behind it.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research.
+ * See file "COPYING" in the top-level source-directory for terms and
+ * conditions.
+ *
+ *   @file: ParallelProcessing.h
+ * @author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_COMMS_PARALLELPROCESSING_H_
+#define MAIN_COMMS_PARALLELPROCESSING_H_
+
+#include "Processing.h"
+#include "Product.h"
+
+#include <cstddef>
+#include <memory>
+
+namespace hycast {
+
+/**
+ * Class that fans local processing of data-products out to a pool of worker
+ * threads. When ordering is enabled, data-products with the same name are
+ * assigned to the same worker and, consequently, are processed in the order
+ * in which they were submitted; data-products with different names may be
+ * processed concurrently. Each worker has a bounded queue: `process()` blocks
+ * while the relevant queue is full, so a slow disposition backpressures the
+ * submitting thread (e.g., the receiving thread, which then stops requesting
+ * more chunks) rather than accumulating unbounded state.
+ */
+class ParallelProcessing final : public Processing
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Constructs.
+     * @param[in] downstream  Processor of data-products. Must exist for the
+     *                        duration of this instance. Its `process()` is
+     *                        called concurrently by the worker threads.
+     * @param[in] numWorkers  Number of worker threads or 0 to use the number
+     *                        of hardware threads
+     * @param[in] maxQueued   Maximum number of unprocessed data-products per
+     *                        worker. `process()` blocks while the relevant
+     *                        queue is full.
+     * @param[in] ordered     Whether data-products with the same name must be
+     *                        processed in the order in which they were
+     *                        submitted
+     * @throw InvalidArgument `maxQueued == 0`
+     */
+    ParallelProcessing(
+            Processing&  downstream,
+            const size_t numWorkers = 0,
+            const size_t maxQueued = 32,
+            const bool   ordered = true);
+
+    /**
+     * Submits a data-product for processing. Blocks while the relevant
+     * worker's queue is full; otherwise, returns quickly.
+     * @param[in] prod   Data-product to be processed
+     * @exceptionsafety  Basic guarantee
+     * @threadsafety     Safe
+     */
+    void process(Product prod);
+
+    /**
+     * Returns the number of submitted but not yet completely processed
+     * data-products.
+     * @return Number of outstanding data-products
+     */
+    size_t getOutstanding() const noexcept;
+};
+
+} // namespace
+
+#endif /* MAIN_COMMS_PARALLELPROCESSING_H_ */
@@ -14,11 +14,17 @@
 #include "config.h"
 
 #include "error.h"
+#include "Metrics.h"
 #include "PerfMeter.h"
 
+#include <atomic>
 #include <chrono>
+#include <cmath>
+#include <list>
 #include <mutex>
 #include <ostream>
+#include <unordered_map>
+#include <vector>
 #include <yaml-cpp/yaml.h>
 
 namespace hycast {
@@ -36,25 +42,171 @@ class PerfMeter::Impl
         STOPPED
     }             State;
 
+    /// Number of histogram sub-buckets per octave as a power of two.
+    /// 2^5 = 32 sub-buckets => about 3% relative error
+    static const unsigned      subBucketBits = 5;
+    static const unsigned long numSubBuckets = 1ul << subBucketBits;
+    /// Enough buckets for any 64-bit microsecond count
+    static const unsigned      numBuckets =
+            (64 - subBucketBits + 1)*numSubBuckets;
+
+    /**
+     * Per-thread tally of arrived chunks. The recording thread increments the
+     * counters with relaxed atomic operations -- no locks and, in the common
+     * case, no cache-line contention -- and aggregation threads read them the
+     * same way.
+     */
+    struct Tally
+    {
+        /// Number of chunks per transport
+        std::atomic<unsigned long> chunkCounts[PerfMeter::NUM_TRANSPORTS];
+        /// Number of bytes of chunk data per transport
+        std::atomic<unsigned long> byteCounts[PerfMeter::NUM_TRANSPORTS];
+        /// HDR-style histogram of product completion-latencies in
+        /// microseconds
+        std::atomic<unsigned long> latencyBuckets[numBuckets];
+        /// HDR-style histogram of one-way, origin-to-completion latencies in
+        /// microseconds
+        std::atomic<unsigned long> originBuckets[numBuckets];
+
+        Tally()
+            : chunkCounts{}
+            , byteCounts{}
+            , latencyBuckets{}
+            , originBuckets{}
+        {}
+    };
+
+    /// Source of unique instance-identifiers. An identifier -- rather than
+    /// `this` -- keys the thread-local tallies because a destroyed instance's
+    /// address can be reused
+    static std::atomic<unsigned long> nextId;
+
+    const unsigned long id;
     mutable Mutex mutex;
     State         state;
     TimePoint     start;
     unsigned long prodCount;
     unsigned long byteCount;
     Duration      duration;
+    /// Guards `tallies`
+    mutable Mutex tallyMutex;
+    /// Every thread's tally. Aggregated when queried
+    std::list<std::shared_ptr<Tally>> tallies;
+    /// Guards `firstChunkTimes`
+    mutable Mutex latencyMutex;
+    /// Time of arrival of the first chunk of each incomplete product
+    std::unordered_map<ProdIndex, TimePoint> firstChunkTimes;
+    /// Handles for the origin-latency quantile gauges on the metrics
+    /// endpoint
+    std::vector<Metrics::Gauge> originLatencyGauges;
+
+    /**
+     * Returns the calling thread's tally -- creating and registering it if
+     * necessary. After creation, recording into the tally requires no lock.
+     * @return Calling thread's tally
+     */
+    Tally& getTally()
+    {
+        static thread_local std::unordered_map<unsigned long,
+                std::shared_ptr<Tally>> threadTallies;
+        auto& tally = threadTallies[id];
+        if (!tally) {
+            tally = std::make_shared<Tally>();
+            LockGuard lock{tallyMutex};
+            tallies.push_back(tally);
+        }
+        return *tally;
+    }
+
+    /**
+     * Returns the histogram bucket for a latency.
+     * @param[in] micros  Latency in microseconds
+     * @return            Index of corresponding bucket
+     */
+    static unsigned bucketOf(const unsigned long micros) noexcept
+    {
+        if (micros < numSubBuckets)
+            return micros;
+        const unsigned exponent = 63 - __builtin_clzll(micros);
+        return (exponent - subBucketBits + 1)*numSubBuckets +
+                ((micros >> (exponent - subBucketBits)) & (numSubBuckets - 1));
+    }
+
+    /**
+     * Returns the latency that a histogram bucket represents.
+     * @param[in] bucket  Index of bucket
+     * @return            Latency in microseconds
+     */
+    static unsigned long valueOf(const unsigned bucket) noexcept
+    {
+        if (bucket < numSubBuckets)
+            return bucket;
+        const unsigned exponent = bucket/numSubBuckets + subBucketBits - 1;
+        return (numSubBuckets + bucket%numSubBuckets)
+                << (exponent - subBucketBits);
+    }
 
 public:
     Impl()
-        : mutex{}
+        : id{nextId.fetch_add(1)}
+        , mutex{}
         , state{READY}
         , start{}
         , prodCount{0}
         , byteCount{0}
         , duration{}
-    {}
+        , tallyMutex{}
+        , tallies{}
+        , latencyMutex{}
+        , firstChunkTimes{}
+        , originLatencyGauges{}
+    {
+        // The one-way, origin-to-completion latency is the end-to-end
+        // number of interest, so its quantiles are exported through the
+        // metrics endpoint. The instance-identifier labels the series
+        // because several meters may coexist.
+        for (const double quantile : {0.5, 0.9, 0.99})
+            originLatencyGauges.push_back(Metrics::registerGauge(
+                    "hycast_origin_latency_seconds{meter=\"" +
+                            std::to_string(id) + "\",quantile=\"" +
+                            std::to_string(quantile).substr(0, 4) + "\"}",
+                    "One-way, origin-to-completion product latency per "
+                    "NTP-disciplined clocks",
+                    [this,quantile]{
+                        return getOriginLatencyQuantile(quantile);
+                    }));
+    }
+
+    void chunk(
+            const ChunkId&            chunkId,
+            const size_t              nbytes,
+            const PerfMeter::Transport transport)
+    {
+        auto& tally = getTally();
+        tally.chunkCounts[transport].fetch_add(1, std::memory_order_relaxed);
+        tally.byteCounts[transport].fetch_add(nbytes,
+                std::memory_order_relaxed);
+        const auto now = Clock::now();
+        LockGuard  lock{latencyMutex};
+        firstChunkTimes.emplace(chunkId.getProdIndex(), now);
+    }
 
     void product(const ProdInfo& prodInfo)
     {
+        recordLatency(prodInfo.getIndex());
+        const auto originTime = prodInfo.getOriginTime();
+        if (originTime) {
+            // Clock skew between the two hosts can make the difference
+            // negative; such a completion lands in the zero bucket rather
+            // than in a garbage one
+            const auto now = ProdInfo::now();
+            const unsigned long micros = (now > originTime)
+                    ? now - originTime
+                    : 0;
+            getTally().originBuckets[bucketOf(micros)].fetch_add(1,
+                    std::memory_order_relaxed);
+        }
         LockGuard lock{mutex};
         if (state == READY) {
             state = STARTED;
@@ -67,6 +219,103 @@ public:
         byteCount += prodInfo.getSize();
     }
 
+    /**
+     * Records the completion-latency of a product in the calling thread's
+     * latency histogram. Does nothing if the product's first chunk wasn't
+     * recorded.
+     * @param[in] prodIndex  Index of the completed product
+     */
+    void recordLatency(const ProdIndex& prodIndex)
+    {
+        TimePoint firstChunkTime;
+        {
+            LockGuard lock{latencyMutex};
+            auto      iter = firstChunkTimes.find(prodIndex);
+            if (iter == firstChunkTimes.end())
+                return;
+            firstChunkTime = iter->second;
+            firstChunkTimes.erase(iter);
+        }
+        const auto micros = std::chrono::duration_cast<
+                std::chrono::microseconds>(Clock::now() - firstChunkTime)
+                .count();
+        getTally().latencyBuckets[bucketOf(micros)].fetch_add(1,
+                std::memory_order_relaxed);
+    }
+
+    unsigned long getChunkCount(const PerfMeter::Transport transport) const
+    {
+        unsigned long count{0};
+        LockGuard     lock{tallyMutex};
+        for (auto& tally : tallies)
+            count += tally->chunkCounts[transport].load(
+                    std::memory_order_relaxed);
+        return count;
+    }
+
+    unsigned long getByteCount(const PerfMeter::Transport transport) const
+    {
+        unsigned long count{0};
+        LockGuard     lock{tallyMutex};
+        for (auto& tally : tallies)
+            count += tally->byteCounts[transport].load(
+                    std::memory_order_relaxed);
+        return count;
+    }
+
+    /**
+     * Returns a quantile of a latency histogram.
+     * @param[in] bucketsOf  Histogram member of the per-thread tallies
+     * @param[in] quantile   Desired quantile in the interval [0, 1]
+     * @return               Latency, in seconds, at the given quantile or
+     *                       NaN if the histogram is empty
+     * @throw InvalidArgument  Quantile is outside the interval [0, 1]
+     */
+    double getQuantile(
+            std::atomic<unsigned long> (Tally::*bucketsOf)[numBuckets],
+            const double quantile) const
+    {
+        if (quantile < 0 || quantile > 1)
+            throw INVALID_ARGUMENT("Invalid quantile: " +
+                    std::to_string(quantile));
+        unsigned long buckets[numBuckets]{};
+        unsigned long total{0};
+        {
+            LockGuard lock{tallyMutex};
+            for (auto& tally : tallies) {
+                for (unsigned i = 0; i < numBuckets; ++i) {
+                    const auto count = ((*tally).*bucketsOf)[i].load(
+                            std::memory_order_relaxed);
+                    buckets[i] += count;
+                    total += count;
+                }
+            }
+        }
+        if (total == 0)
+            return std::nan("");
+        unsigned long target = static_cast<unsigned long>(
+                std::ceil(quantile*total));
+        if (target < 1)
+            target = 1;
+        unsigned long cumulative{0};
+        for (unsigned i = 0; i < numBuckets; ++i) {
+            cumulative += buckets[i];
+            if (cumulative >= target)
+                return valueOf(i)*1e-6;
+        }
+        return valueOf(numBuckets - 1)*1e-6; // Can't happen
+    }
+
+    double getLatencyQuantile(const double quantile) const
+    {
+        return getQuantile(&Tally::latencyBuckets, quantile);
+    }
+
+    double getOriginLatencyQuantile(const double quantile) const
+    {
+        return getQuantile(&Tally::originBuckets, quantile);
+    }
+
     unsigned long getProdCount() const
     {
         LockGuard lock{mutex};
@@ -122,15 +371,68 @@ public:
                     out << (std::to_string(8*byteCount/seconds) + "/s");
                 }
             out << YAML::EndMap;
+            out << YAML::Key << "Transports";
+            out << YAML::BeginMap;
+                out << YAML::Key << "mcast";
+                out << YAML::BeginMap;
+                    out << YAML::Key << "chunks";
+                    out << getChunkCount(PerfMeter::MCAST);
+                    out << YAML::Key << "bytes";
+                    out << getByteCount(PerfMeter::MCAST);
+                out << YAML::EndMap;
+                out << YAML::Key << "p2p";
+                out << YAML::BeginMap;
+                    out << YAML::Key << "chunks";
+                    out << getChunkCount(PerfMeter::P2P);
+                    out << YAML::Key << "bytes";
+                    out << getByteCount(PerfMeter::P2P);
+                out << YAML::EndMap;
+            out << YAML::EndMap;
+            const auto median = getLatencyQuantile(0.5);
+            if (!std::isnan(median)) {
+                out << YAML::Key << "Latency";
+                out << YAML::BeginMap;
+                    out << YAML::Key << "p50";
+                    out << (std::to_string(median) + " s");
+                    out << YAML::Key << "p90";
+                    out << (std::to_string(getLatencyQuantile(0.9)) + " s");
+                    out << YAML::Key << "p99";
+                    out << (std::to_string(getLatencyQuantile(0.99)) + " s");
+                out << YAML::EndMap;
+            }
+            const auto originMedian = getOriginLatencyQuantile(0.5);
+            if (!std::isnan(originMedian)) {
+                out << YAML::Key << "OriginLatency";
+                out << YAML::BeginMap;
+                    out << YAML::Key << "p50";
+                    out << (std::to_string(originMedian) + " s");
+                    out << YAML::Key << "p90";
+                    out << (std::to_string(getOriginLatencyQuantile(0.9)) +
+                            " s");
+                    out << YAML::Key << "p99";
+                    out << (std::to_string(getOriginLatencyQuantile(0.99)) +
+                            " s");
+                out << YAML::EndMap;
+            }
         out << YAML::EndMap;
         return ostream << out.c_str();
     }
 };
 
+std::atomic<unsigned long> PerfMeter::Impl::nextId{0};
+
 PerfMeter::PerfMeter()
     : pImpl{new Impl()}
 {}
 
+void PerfMeter::chunk(
+        const ChunkId&  chunkId,
+        const size_t    nbytes,
+        const Transport transport) const
+{
+    pImpl->chunk(chunkId, nbytes, transport);
+}
+
 void PerfMeter::product(const ProdInfo& prodInfo) const
 {
     pImpl->product(prodInfo);
@@ -141,6 +443,26 @@ unsigned long PerfMeter::getProdCount() const
     return pImpl->getProdCount();
 }
 
+unsigned long PerfMeter::getChunkCount(const Transport transport) const
+{
+    return pImpl->getChunkCount(transport);
+}
+
+unsigned long PerfMeter::getByteCount(const Transport transport) const
+{
+    return pImpl->getByteCount(transport);
+}
+
+double PerfMeter::getLatencyQuantile(const double quantile) const
+{
+    return pImpl->getLatencyQuantile(quantile);
+}
+
+double PerfMeter::getOriginLatencyQuantile(const double quantile) const
+{
+    return pImpl->getOriginLatencyQuantile(quantile);
+}
+
 void PerfMeter::stop() const
 {
     pImpl->stop();
@@ -14,6 +14,7 @@
 #ifndef MAIN_COMMS_PERFMETER_H_
 #define MAIN_COMMS_PERFMETER_H_
 
+#include "Chunk.h"
 #include "ProdInfo.h"
 
 #include <memory>
@@ -28,9 +29,37 @@ class PerfMeter
     std::shared_ptr<Impl> pImpl;
 
 public:
+    /// Transport over which a chunk of data arrived
+    typedef enum {
+        MCAST = 0,     /// Multicast
+        P2P,           /// Peer-to-peer
+        NUM_TRANSPORTS /// Number of transports. Must be last
+    } Transport;
+
     PerfMeter();
 
     /**
+     * Records the arrival of a chunk of data. The first chunk of a product
+     * starts that product's completion-latency clock. The per-transport
+     * counters and the latency histogram are recorded into per-thread tallies
+     * without locking and aggregated when queried, so this may be called from
+     * transport threads at line rate.
+     * @param[in] chunkId    Chunk identifier
+     * @param[in] nbytes     Number of bytes of data in the chunk
+     * @param[in] transport  Transport over which the chunk arrived
+     * @threadsafety         Safe
+     */
+    void chunk(
+            const ChunkId&  chunkId,
+            const size_t    nbytes,
+            const Transport transport) const;
+
+    /**
+     * Records a completed data-product. If the product's first chunk was
+     * recorded via `chunk()`, then the product's completion-latency (first
+     * chunk to complete) is added to the latency histogram. If the product's
+     * information carries an origin timestamp, then the one-way,
+     * origin-to-completion latency is added to the origin-latency histogram.
      * @param[in] prodInfo  Product information
      * @threadsafety        Safe
      */
@@ -41,6 +70,52 @@ public:
      */
     unsigned long getProdCount() const;
 
+    /**
+     * Returns the number of chunks of data that arrived over a given
+     * transport.
+     * @param[in] transport  Transport
+     * @return               Number of chunks
+     * @threadsafety         Safe
+     */
+    unsigned long getChunkCount(const Transport transport) const;
+
+    /**
+     * Returns the number of bytes of chunk data that arrived over a given
+     * transport.
+     * @param[in] transport  Transport
+     * @return               Number of bytes
+     * @threadsafety         Safe
+     */
+    unsigned long getByteCount(const Transport transport) const;
+
+    /**
+     * Returns a quantile of the product completion-latency distribution
+     * (e.g., 0.99 yields the 99th-percentile latency). The histogram has
+     * HDR-style logarithmic buckets, so the result has about 3% relative
+     * error.
+     * @param[in] quantile  Desired quantile in the interval [0, 1]
+     * @return              Latency, in seconds, at the given quantile or NaN
+     *                      if no completion-latency has been recorded
+     * @throw InvalidArgument  Quantile is outside the interval [0, 1]
+     * @threadsafety        Safe
+     */
+    double getLatencyQuantile(const double quantile) const;
+
+    /**
+     * Returns a quantile of the one-way, origin-to-completion latency
+     * distribution: the time from a product's first transmission -- per the
+     * origin timestamp its sender stamped into the product-information -- to
+     * its completion here. The number is only as good as the NTP discipline
+     * of the two clocks. Exported through the metrics endpoint as the
+     * `hycast_origin_latency_seconds` gauges.
+     * @param[in] quantile  Desired quantile in the interval [0, 1]
+     * @return              Latency, in seconds, at the given quantile or NaN
+     *                      if no origin-latency has been recorded
+     * @throw InvalidArgument  Quantile is outside the interval [0, 1]
+     * @threadsafety        Safe
+     */
+    double getOriginLatencyQuantile(const double quantile) const;
+
     /**
      * @threadsafety        Safe
      */
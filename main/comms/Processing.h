@@ -32,10 +32,48 @@ public:
      * Processes a data-product. Returns quickly.
      * @param[in] prod   Data-product to be processed
      * @exceptionsafety  Basic guarantee
-     * @threadsafety     Safe
      * @throws           RuntimeError
+     * @threadsafety     Safe
      */
     virtual void process(Product prod) =0;
+
+    /**
+     * Indicates whether this instance wants incremental delivery of the
+     * contiguous leading extent of each data-product as the extent grows. A
+     * streaming consumer -- e.g., a decoder that reads a large file
+     * head-first -- should override this to return `true` and override
+     * `processPrefix()`. The default is whole-product delivery only.
+     * @retval `true`   Growing extents are delivered via `processPrefix()`
+     * @retval `false`  Only complete data-products are delivered
+     */
+    virtual bool processesPrefixes() const noexcept
+    {
+        return false;
+    }
+
+    /**
+     * Processes growth of the contiguous leading extent of an incomplete
+     * data-product. Called only if `processesPrefixes()` returns `true` and
+     * only when the extent has grown. `extent` is the total number of leading
+     * bytes now present, so a consumer that tracks its own read-offset
+     * consumes bytes `[offset,extent)` and ignores a call whose extent it has
+     * already passed (concurrent receiver-threads can deliver extents out of
+     * order). The product's name will be empty if its product-information
+     * hasn't yet arrived. `data` is valid only for the duration of the call.
+     * The complete data-product is still delivered to `process()`. Returns
+     * quickly. The default implementation does nothing.
+     * @param[in] prodInfo  Information on the data-product. The name may be
+     *                      empty.
+     * @param[in] data      Product data. Bytes `[0,extent)` are valid.
+     * @param[in] extent    Size, in bytes, of the contiguous leading extent
+     * @exceptionsafety     Basic guarantee
+     * @threadsafety        Safe
+     */
+    virtual void processPrefix(
+            const ProdInfo& prodInfo,
+            const char*     data,
+            const ProdSize  extent)
+    {}
 };
 
 } // namespace
@@ -13,21 +13,31 @@
 #include "config.h"
 
 #include "Backlogger.h"
+#include "ChunkPresence.h"
 #include "error.h"
+#include "FlightRecorder.h"
 #include "McastReceiver.h"
+#include "Metrics.h"
+#include "OpAccounting.h"
 #include "P2pMgr.h"
 #include "P2pMgrServer.h"
+#include "PerfMeter.h"
+#include "probe.h"
 #include "ProdStore.h"
+#include "RetentionMsg.h"
 #include "Processing.h"
 #include "Receiving.h"
 #include "Thread.h"
 
+#include <atomic>
 #include <functional>
 #include <mutex>
 #include <pthread.h>
 #include <random>
 #include <thread>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 namespace hycast {
 
@@ -38,18 +48,37 @@ class Receiving::Impl final : public McastContentRcvr
     typedef std::lock_guard<Mutex> LockGuard;
 
     std::exception_ptr            exception;
+    const std::string             pathname;
     ProdStore                     prodStore;
     std::unordered_set<ProdIndex> requestedProdInfos;
     std::unordered_set<ChunkId>   requestedChunks;
+    /// Per-product extent already delivered to a streaming consumer
+    std::unordered_map<ProdIndex, ProdSize::type> deliveredPrefixes;
     mutable Mutex                 mutex;
     Processing*                   processing;
     P2pMgr                        p2pMgr;
     Thread                        p2pMgrThread;
-    McastReceiver                 mcastRcvr;
-    Thread                        mcastRcvrThread;
+    /// One receiver and thread per subscribed multicast group
+    std::vector<McastReceiver>    mcastRcvrs;
+    std::vector<Thread>           mcastRcvrThreads;
     bool                          controlTraffic;
     std::default_random_engine    generator;
     std::bernoulli_distribution   trafficControler;
+    /// Front-cache of received chunks for duplicate rejection
+    ChunkPresence<>               chunkPresence;
+    /// Records received chunks when metering is enabled
+    PerfMeter                     perfMeter;
+    /// Whether received chunks should be recorded in `perfMeter`
+    bool                          metering;
+    /// Shared memory-budget or a no-op default
+    MemBudget                     memBudget;
+    /// Product filter. An empty filter admits every product.
+    ProdFilter                    prodFilter;
+    /// Products the filter has excluded, so their chunks can be discarded
+    /// without consulting the filter. Guarded by `mutex`.
+    std::unordered_set<ProdIndex> excludedProds;
+    /// Maximum number of remembered excluded products
+    static const size_t           MAX_EXCLUSIONS = 512;
 
     /**
      * Throw the exception if it exists.
@@ -88,13 +117,17 @@ class Receiving::Impl final : public McastContentRcvr
     }
 
     /**
-     * Runs the multicast receiver. Intended to run on its own thread.
+     * Runs a multicast receiver. Intended to run on its own thread.
+     * @param[in] cue     Cued when the receiver is running
+     * @param[in] iMcast  Index of the multicast receiver
      */
-    void runMcastRcvr(Cue cue)
+    void runMcastRcvr(
+            Cue          cue,
+            const size_t iMcast)
     {
     	try {
     	    cue.cue();
-            mcastRcvr();
+            mcastRcvrs[iMcast]();
             throw LOGIC_ERROR("Multicast receiver stopped");
     	}
     	catch (const std::exception& e) {
@@ -102,6 +135,60 @@ class Receiving::Impl final : public McastContentRcvr
     	}
     }
 
+    /**
+     * Indicates if the product filter excludes a product given its
+     * information. An excluded product is recorded so its chunks can be
+     * discarded on arrival without consulting the filter.
+     * @param[in] prodInfo  Product information
+     * @retval `true`       Product is excluded: discard the piece
+     * @retval `false`      Otherwise
+     */
+    bool shouldDiscard(const ProdInfo& prodInfo)
+    {
+        LockGuard lock{mutex};
+        if (prodFilter.matches(prodInfo.getName()))
+            return false;
+        /*
+         * NB: the set is advisory, so it's cleared when it hits the cap.
+         * Losing an entry merely stores an unwanted chunk.
+         */
+        if (excludedProds.size() >= MAX_EXCLUSIONS)
+            excludedProds.clear();
+        excludedProds.insert(prodInfo.getIndex());
+        return true;
+    }
+
+    /**
+     * Indicates if the product filter has excluded a product.
+     * @param[in] prodIndex  Product index
+     * @retval `true`        Product is excluded
+     * @retval `false`       Otherwise
+     */
+    bool isExcluded(const ProdIndex& prodIndex)
+    {
+        LockGuard lock{mutex};
+        return excludedProds.count(prodIndex) != 0;
+    }
+
+    /**
+     * Stamps a product's trace identifier, if it has one, into this node's
+     * probe and flight recorder so offline tools can join the identifier to
+     * the product-index on every node the product crossed.
+     * @param[in] prodInfo  Information on the product
+     */
+    static void stampTraceId(const ProdInfo& prodInfo) noexcept
+    {
+        const auto traceId = prodInfo.getTraceId();
+        if (traceId == 0)
+            return;
+        HYCAST_PROBE2(trace_id,
+                static_cast<ProdIndex::type>(prodInfo.getIndex()), traceId);
+        FlightRecorder::record(FlightRecorder::Event::TRACE_ID,
+                static_cast<ProdIndex::type>(prodInfo.getIndex()),
+                static_cast<uint32_t>(traceId),
+                static_cast<uint32_t>(traceId >> 32));
+    }
+
     /**
      * Accepts information on a product. Adds the information to the
      * product-store. If the associated product is now complete, then it is
@@ -112,14 +199,35 @@ class Receiving::Impl final : public McastContentRcvr
     {
         PartialProduct prod{};
         RecvStatus     status{};
+        // The product-store is internally sharded, so it's not entered under
+        // this instance's mutex: concurrent receivers that touch different
+        // products proceed in parallel
         {
             LockGuard lock{mutex};
             throwIfException();
-            status = prodStore.add(prodInfo, prod);
+        }
+        status = prodStore.add(prodInfo, prod);
+        {
+            LockGuard lock{mutex};
             requestedProdInfos.erase(prodInfo.getIndex());
+            if (status.isComplete())
+                deliveredPrefixes.erase(prodInfo.getIndex());
         }
-        if (status.isNew() && status.isComplete())
+        if (status.isNew())
+            stampTraceId(prodInfo);
+        if (status.isNew() && status.isComplete()) {
+            HYCAST_PROBE2(product_complete,
+                    static_cast<ProdIndex::type>(prodInfo.getIndex()),
+                    static_cast<ProdSize::type>(prodInfo.getSize()));
+            FlightRecorder::record(
+                    FlightRecorder::Event::PRODUCT_COMPLETE,
+                    static_cast<ProdIndex::type>(prodInfo.getIndex()), 0,
+                    static_cast<ProdSize::type>(prodInfo.getSize()));
             processing->process(prod);
+            FlightRecorder::record(
+                    FlightRecorder::Event::PRODUCT_PROCESSED,
+                    static_cast<ProdIndex::type>(prodInfo.getIndex()));
+        }
         return status;
     }
 
@@ -130,61 +238,239 @@ class Receiving::Impl final : public McastContentRcvr
      */
     RecvStatus accept(LatentChunk& chunk)
     {
+        // Duplicate from the other transport? Reject before taking the lock.
+        if (chunkPresence.test(chunk.getId())) {
+            chunk.discard();
+            return RecvStatus{};
+        }
         PartialProduct prod{};
         RecvStatus     status{};
+        // The product-store is internally sharded, so it's not entered under
+        // this instance's mutex: concurrent receivers that touch different
+        // products proceed in parallel
         {
             LockGuard lock{mutex};
             throwIfException();
-            status = prodStore.add(chunk, prod);
-            requestedChunks.erase(chunk.getId());
         }
-        if (status.isNew() && status.isComplete())
-            processing->process(prod);
+        status = prodStore.add(chunk, prod);
+        finishChunk(chunk.getId(), status, prod);
         return status;
     }
 
+    /**
+     * Accepts a small, complete data-product that arrived as a single
+     * combined product-information and data message. The whole product goes
+     * into the product-store as one insertion -- no partial-product assembly
+     * or completeness tracking -- and is processed immediately. If an entry
+     * for the product already exists (e.g., its information arrived
+     * separately first), falls back to the decomposed path so the existing
+     * entry still completes.
+     * @param[in] smallProd  Small, complete data-product
+     */
+    RecvStatus accept(LatentSmallProd& smallProd)
+    {
+        const ProdInfo prodInfo = smallProd.getInfo();
+        const ChunkId  chunkId = ChunkInfo{prodInfo, 0}.getId();
+        // Duplicate from the other transport? Reject before draining.
+        if (chunkPresence.test(chunkId)) {
+            smallProd.discard();
+            return RecvStatus{};
+        }
+        {
+            LockGuard lock{mutex};
+            throwIfException();
+        }
+        // The product-store keeps the product handle rather than a copy of
+        // its data, so the data goes into heap storage that the product owns
+        auto data = std::make_shared<std::vector<char>>(prodInfo.getSize());
+        const auto nbytes = smallProd.drainData(data->data(), data->size());
+        if (nbytes != prodInfo.getSize()) {
+            LOG_WARN("Small product " + prodInfo.to_string() + " arrived "
+                    "with " + std::to_string(nbytes) + " bytes of data");
+            return RecvStatus{};
+        }
+        MemoryProduct prod{prodInfo, data->data(),
+                [data]() mutable { data.reset(); }};
+        if (!prodStore.add(prod)) {
+            /*
+             * The product's entry already exists -- e.g., its information
+             * arrived separately first -- so the whole-product insertion
+             * would discard the partial entry's bookkeeping. Go through the
+             * decomposed path instead so the existing entry completes.
+             */
+            auto status = accept(prodInfo);
+            if (!status.isComplete()) {
+                LatentChunk chunk{ChunkInfo{prodInfo, 0}, data->data()};
+                status = accept(chunk);
+            }
+            return status;
+        }
+        {
+            LockGuard lock{mutex};
+            requestedProdInfos.erase(prodInfo.getIndex());
+            requestedChunks.erase(chunkId);
+            deliveredPrefixes.erase(prodInfo.getIndex());
+        }
+        chunkPresence.set(chunkId);
+        stampTraceId(prodInfo);
+        HYCAST_PROBE2(product_complete,
+                static_cast<ProdIndex::type>(prodInfo.getIndex()),
+                static_cast<ProdSize::type>(prodInfo.getSize()));
+        FlightRecorder::record(
+                FlightRecorder::Event::PRODUCT_COMPLETE,
+                static_cast<ProdIndex::type>(prodInfo.getIndex()), 0,
+                static_cast<ProdSize::type>(prodInfo.getSize()));
+        processing->process(prod);
+        FlightRecorder::record(
+                FlightRecorder::Event::PRODUCT_PROCESSED,
+                static_cast<ProdIndex::type>(prodInfo.getIndex()));
+        return RecvStatus{}.setNew().setComplete();
+    }
+
+    /**
+     * Finishes the acceptance of a chunk-of-data after its addition to the
+     * product-store: updates the bookkeeping, delivers a grown contiguous
+     * prefix when streaming delivery is on, and processes the product if the
+     * addition completed it. Common to the single-chunk and batched
+     * acceptance paths.
+     * @param[in] chunkId  Identifier of the added chunk
+     * @param[in] status   Status of the addition
+     * @param[in] prod     The chunk's product
+     */
+    void finishChunk(
+            const ChunkId&   chunkId,
+            const RecvStatus status,
+            Product&         prod)
+    {
+        {
+            LockGuard lock{mutex};
+            requestedChunks.erase(chunkId);
+            if (status.isComplete())
+                deliveredPrefixes.erase(chunkId.getProdIndex());
+        }
+        chunkPresence.set(chunkId);
+        if (status.isNew()) {
+            HYCAST_PROBE2(chunk_stored,
+                    static_cast<ProdIndex::type>(chunkId.getProdIndex()),
+                    static_cast<ChunkIndex::type>(
+                            chunkId.getChunkIndex()));
+            FlightRecorder::record(FlightRecorder::Event::CHUNK_STORED,
+                    static_cast<ProdIndex::type>(chunkId.getProdIndex()),
+                    static_cast<ChunkIndex::type>(
+                            chunkId.getChunkIndex()));
+        }
+        if (status.isNew() && !status.isComplete() &&
+                processing->processesPrefixes()) {
+            /*
+             * Streaming delivery: hand the consumer the contiguous leading
+             * extent whenever it grows. The bookkeeping only remembers what's
+             * been delivered; the extent itself lives in the product.
+             */
+            const ProdSize::type extent = prod.getContiguousSize();
+            bool                 grew = false;
+            if (extent) {
+                LockGuard lock{mutex};
+                auto&     delivered =
+                        deliveredPrefixes[chunkId.getProdIndex()];
+                grew = extent > delivered;
+                if (grew)
+                    delivered = extent;
+            }
+            if (grew)
+                processing->processPrefix(prod.getInfo(), prod.getData(),
+                        extent);
+        }
+        if (status.isNew() && status.isComplete()) {
+            HYCAST_PROBE2(product_complete,
+                    static_cast<ProdIndex::type>(
+                            prod.getInfo().getIndex()),
+                    static_cast<ProdSize::type>(prod.getInfo().getSize()));
+            FlightRecorder::record(
+                    FlightRecorder::Event::PRODUCT_COMPLETE,
+                    static_cast<ProdIndex::type>(prod.getInfo().getIndex()),
+                    0,
+                    static_cast<ProdSize::type>(prod.getInfo().getSize()));
+            processing->process(prod);
+            FlightRecorder::record(
+                    FlightRecorder::Event::PRODUCT_PROCESSED,
+                    static_cast<ProdIndex::type>(prod.getInfo().getIndex()));
+        }
+    }
+
 public:
     /**
      * Constructs.
-     * @param[in] srcMcastInfo  Information on the source-specific multicast
-     * @param[in] p2pInfo       Information for the peer-to-peer component
-     * @param[in] pathname      Pathname of product-store persistence-file or
-     *                          the empty string to indicate no persistence
-     * @param[in] processing    Processes complete data-products. Must exist for
-     *                          the duration of this instance.
-     * @param[in] version       Protocol version
-     * @param[in] drop          Proportion of multicast packets to drop. From
-     *                          0 through 1, inclusive.
+     * @param[in] srcMcastInfos  Information on the source-specific multicast
+     *                           groups to subscribe to
+     * @param[in] p2pInfo        Information for the peer-to-peer component
+     * @param[in] prodStore      Store of data-products. May be shared with
+     *                           another component (e.g., a relay's shipping
+     *                           side).
+     * @param[in] pathname       Pathname of product-store persistence-file or
+     *                           the empty string to indicate no persistence
+     * @param[in] processing     Processes complete data-products. Must exist
+     *                           for the duration of this instance.
+     * @param[in] version        Protocol version
+     * @param[in] drop           Proportion of multicast packets to drop. From
+     *                           0 through 1, inclusive.
+     * @param[in] mcastWorkers   Number of message-processing worker threads
+     *                           per multicast receiver or 0 to process
+     *                           messages on the socket-reading threads
+     * @throw InvalidArgument    `srcMcastInfos` is empty
      * @see ProdStore::ProdStore()
      */
-    Impl(   const SrcMcastInfo& srcMcastInfo,
-            P2pInfo&            p2pInfo,
-            const std::string&  pathname,
-            Processing&         processing,
-            const unsigned      version,
-            const double        drop = 0)
+    Impl(   const std::vector<SrcMcastInfo>& srcMcastInfos,
+            P2pInfo&                         p2pInfo,
+            ProdStore                        prodStore,
+            const std::string&               pathname,
+            Processing&                      processing,
+            const unsigned                   version,
+            const double                     drop = 0,
+            const unsigned                   mcastWorkers = 0)
         : exception{}
-        , prodStore{pathname}
+        , pathname{pathname}
+        , prodStore{prodStore}
         , requestedProdInfos{}
         , requestedChunks{}
+        , deliveredPrefixes{}
         , mutex{}
         , processing{&processing}
         , p2pMgr{p2pInfo, *this}
         , p2pMgrThread{}
-        , mcastRcvr(srcMcastInfo, *this, version)
-        , mcastRcvrThread{}
+        , mcastRcvrs{}
+        , mcastRcvrThreads{}
         , controlTraffic{drop > 0}
         , generator{}
+        , chunkPresence{}
+        , perfMeter{}
+        , metering{false}
+        , memBudget{}
+        , prodFilter{}
+        , excludedProds{}
     {
+        if (srcMcastInfos.empty())
+            throw INVALID_ARGUMENT("Empty set of multicast groups");
+        // End-to-end integrity check. `Shipping` enables this too.
+        BaseChunk::enableChecksums(true);
+        mcastRcvrs.reserve(srcMcastInfos.size());
+        for (const auto& srcMcastInfo : srcMcastInfos)
+            mcastRcvrs.emplace_back(srcMcastInfo, *this, version, 0,
+                    mcastWorkers);
         Cue p2pMgrReady{};
-        Cue mcastRcvrReady{};
         p2pMgrThread = Thread{&Impl::runP2pMgr, this, p2pMgrReady};
-        mcastRcvrThread = Thread{&Impl::runMcastRcvr, this, mcastRcvrReady};
+        std::vector<Cue> mcastRcvrsReady{};
+        mcastRcvrThreads.reserve(mcastRcvrs.size());
+        for (size_t iMcast = 0; iMcast < mcastRcvrs.size(); ++iMcast) {
+            mcastRcvrsReady.emplace_back();
+            mcastRcvrThreads.emplace_back(Thread{&Impl::runMcastRcvr, this,
+                    mcastRcvrsReady[iMcast], iMcast});
+        }
         if (controlTraffic)
             trafficControler = std::bernoulli_distribution{
                 drop < 1 ? 1 - drop : 0};
         p2pMgrReady.wait();
-        mcastRcvrReady.wait();
+        for (auto& mcastRcvrReady : mcastRcvrsReady)
+            mcastRcvrReady.wait();
     }
 
     ~Impl()
@@ -193,14 +479,44 @@ public:
             p2pMgrThread.cancel();
             p2pMgrThread.join();
 
-            mcastRcvrThread.cancel();
-            mcastRcvrThread.join();
+            for (auto& mcastRcvrThread : mcastRcvrThreads) {
+                mcastRcvrThread.cancel();
+                mcastRcvrThread.join();
+            }
     	}
     	catch (const std::exception& e) {
             log_error(e); // Because a destructor shouldn't throw an exception
     	}
     }
 
+    /**
+     * Sets the CPU affinity of the multicast-receiving threads.
+     * @param[in] cpus         CPU indexes the threads may run on
+     * @throw InvalidArgument  `cpus` is empty
+     * @throw SystemError      Affinity couldn't be set
+     */
+    void setMcastRcvrAffinity(const std::vector<unsigned>& cpus)
+    {
+        for (auto& mcastRcvrThread : mcastRcvrThreads)
+            mcastRcvrThread.setAffinity(cpus);
+    }
+
+    /**
+     * Sets the scheduling policy and priority of the multicast-receiving
+     * threads.
+     * @param[in] policy       `SCHED_FIFO`, `SCHED_RR`, or `SCHED_OTHER`
+     * @param[in] priority     Priority within the policy's range
+     * @throw InvalidArgument  Unsupported policy or out-of-range priority
+     * @throw SystemError      Scheduling couldn't be set
+     */
+    void setMcastRcvrScheduling(
+            const int policy,
+            const int priority)
+    {
+        for (auto& mcastRcvrThread : mcastRcvrThreads)
+            mcastRcvrThread.setScheduling(policy, priority);
+    }
+
     /**
      * Returns the ID of the earliest missing chunk-of-data.
      * @return ID of earliest missing data-chunk
@@ -210,9 +526,28 @@ public:
         return prodStore.getOldestMissingChunk();
     }
 
+    /**
+     * Returns this node's retention advertisement: the oldest data-product
+     * its store still holds.
+     * @param[out] retention  Retention advertisement
+     * @retval `true`         Always: a receiving node always answers
+     */
+    bool getRetention(RetentionMsg& retention)
+    {
+        const auto oldest = prodStore.getOldestResident();
+        retention = oldest
+                ? RetentionMsg{oldest.getIndex(), oldest.getOriginTime()}
+                : RetentionMsg{};
+        return true;
+    }
+
     Backlogger getBacklogger(const ChunkId& earliest, Peer& peer)
     {
-        return Backlogger{peer, earliest, prodStore};
+        if (pathname.empty())
+            return Backlogger{peer, earliest, prodStore, memBudget};
+        // Per-peer cursor-file beside the product-store persistence-file
+        return Backlogger{peer, earliest, prodStore, pathname + ".cursor." +
+                peer.getRemoteAddr().to_string(), memBudget};
     }
 
     /**
@@ -225,11 +560,15 @@ public:
     void receive(const ProdInfo& prodInfo)
     {
     	if (!controlTraffic || trafficControler(generator)) {
+            if (shouldDiscard(prodInfo))
+                return; // Excluded before any store or processing work
             auto status = accept(prodInfo);
             LOG_DEBUG("Received product-information " + prodInfo.to_string() +
                     " from multicast");
             if (status.isNew())
-                p2pMgr.notify(prodInfo.getIndex());
+                // Identified by name so a peer's product filter, if any,
+                // can veto the product and its chunk notices
+                p2pMgr.notify(prodInfo.getIndex(), prodInfo.getName());
     	}
     }
 
@@ -242,6 +581,8 @@ public:
      */
     RecvStatus receive(const ProdInfo& prodInfo, const InetSockAddr& peerAddr)
     {
+        if (shouldDiscard(prodInfo))
+            return RecvStatus{}; // Excluded before any store work
         LOG_DEBUG("Received product-information " + prodInfo.to_string() +
                 " from peer " + peerAddr.to_string());
         return accept(prodInfo);
@@ -250,8 +591,9 @@ public:
     /**
      * Receives a chunk-of-data via multicast. Adds the chunk to the product-
      * store if appropriate. If the product is now complete, then it is
-     * processed. If the chunk is new, then all active peers are notified
-     * of its availability.
+     * processed. If the chunk is new, then any in-flight peer-to-peer request
+     * for it is cancelled and all active peers are notified of its
+     * availability.
      * @param[in] chunk  Data-chunk
      */
     void receive(LatentChunk chunk)
@@ -259,14 +601,122 @@ public:
     	if (controlTraffic && !trafficControler(generator)) {
     	    chunk.discard();
     	}
+    	else if (isExcluded(chunk.getId().getProdIndex())) {
+    	    chunk.discard(); // The filter excluded the chunk's product
+    	}
     	else {
+            OpAccounting::Scope opScope{OpAccounting::CHUNK_RECV};
             LOG_DEBUG("Received data-chunk " + chunk.getId().to_string() +
                     " from multicast");
-            if (accept(chunk).isNew())
-                p2pMgr.notify(chunk.getId());
+            if (metering)
+                perfMeter.chunk(chunk.getId(), chunk.getSize(),
+                        PerfMeter::MCAST);
+            HYCAST_PROBE3(chunk_recv_mcast,
+                    static_cast<ProdIndex::type>(chunk.getId().getProdIndex()),
+                    static_cast<ChunkIndex::type>(chunk.getId().getChunkIndex()),
+                    static_cast<ChunkSize::type>(chunk.getSize()));
+            FlightRecorder::record(
+                    FlightRecorder::Event::CHUNK_RECV_MCAST,
+                    static_cast<ProdIndex::type>(chunk.getId().getProdIndex()),
+                    static_cast<ChunkIndex::type>(
+                            chunk.getId().getChunkIndex()),
+                    static_cast<ChunkSize::type>(chunk.getSize()));
+            static auto& chunkCount = Metrics::getCounter(
+                    "hycast_chunks_received_total{transport=\"mcast\"}",
+                    "Chunks of data received, by transport");
+            static auto& byteCount = Metrics::getCounter(
+                    "hycast_bytes_received_total{transport=\"mcast\"}",
+                    "Bytes of chunk-data received, by transport");
+            chunkCount.add();
+            byteCount.add(chunk.getSize());
+            const auto chunkId = chunk.getId();
+            if (accept(chunk).isNew()) {
+                /*
+                 * The multicast datagram won the race: cancel any in-flight
+                 * peer-to-peer request for the chunk so the peer's redundant
+                 * reply isn't transmitted
+                 */
+                p2pMgr.cancel(chunkId);
+                p2pMgr.notify(chunkId);
+            }
     	}
     }
 
+    /**
+     * Receives a small, complete data-product via multicast as a single
+     * combined product-information and data message. Adds the whole product
+     * to the product-store with one insertion. If the product is new, then
+     * any in-flight peer-to-peer request for its data is cancelled, all
+     * active peers are notified of its availability, and it's processed.
+     * @param[in] smallProd  Small, complete data-product
+     */
+    void receive(LatentSmallProd smallProd)
+    {
+        if (controlTraffic && !trafficControler(generator)) {
+            smallProd.discard();
+            return;
+        }
+        const auto prodInfo = smallProd.getInfo();
+        if (shouldDiscard(prodInfo)) {
+            smallProd.discard(); // Excluded before any store work
+            return;
+        }
+        OpAccounting::Scope opScope{OpAccounting::CHUNK_RECV};
+        LOG_DEBUG("Received small product " + prodInfo.to_string() +
+                " from multicast");
+        const ChunkId chunkId = ChunkInfo{prodInfo, 0}.getId();
+        if (metering)
+            perfMeter.chunk(chunkId, prodInfo.getSize(), PerfMeter::MCAST);
+        HYCAST_PROBE3(chunk_recv_mcast,
+                static_cast<ProdIndex::type>(prodInfo.getIndex()),
+                static_cast<ChunkIndex::type>(0),
+                static_cast<ChunkSize::type>(prodInfo.getSize()));
+        FlightRecorder::record(
+                FlightRecorder::Event::CHUNK_RECV_MCAST,
+                static_cast<ProdIndex::type>(prodInfo.getIndex()), 0,
+                static_cast<ChunkSize::type>(prodInfo.getSize()));
+        static auto& chunkCount = Metrics::getCounter(
+                "hycast_chunks_received_total{transport=\"mcast\"}",
+                "Chunks of data received, by transport");
+        static auto& byteCount = Metrics::getCounter(
+                "hycast_bytes_received_total{transport=\"mcast\"}",
+                "Bytes of chunk-data received, by transport");
+        chunkCount.add();
+        byteCount.add(prodInfo.getSize());
+        if (accept(smallProd).isNew()) {
+            /*
+             * The multicast datagram won the race: cancel any in-flight
+             * peer-to-peer request for the chunk so the peer's redundant
+             * reply isn't transmitted
+             */
+            p2pMgr.cancel(chunkId);
+            // Identified by name so a peer's product filter, if any, can
+            // veto the product and its chunk notices
+            p2pMgr.notify(prodInfo.getIndex(), prodInfo.getName());
+            p2pMgr.notify(chunkId);
+        }
+    }
+
+    /**
+     * Receives a report of data-chunks that the multicast lost -- detected
+     * from a gap in the datagram sequence numbers. Immediately initiates
+     * targeted peer-to-peer repair of the chunks that are still needed, so
+     * repair begins at inter-packet-gap scale instead of waiting for the
+     * chunks' products to time out.
+     * @param[in] rangeSet  Identifiers of the missing chunks, as ranges
+     */
+    void missed(const ChunkRangeSet& rangeSet)
+    {
+        LOG_DEBUG("Multicast lost " +
+                std::to_string(rangeSet.getNumChunks()) +
+                " chunk(s): requesting peer-to-peer repair");
+        static auto& lostCount = Metrics::getCounter(
+                "hycast_mcast_lost_chunks_total",
+                "Chunks a multicast sequence-number gap showed were lost");
+        lostCount.add(rangeSet.getNumChunks());
+        p2pMgr.repair(rangeSet);
+    }
+
     /**
      * Receives a chunk-of-data from a peer. Adds the chunk to the product-
      * store if appropriate. If the product is now complete, then it's
@@ -276,14 +726,230 @@ public:
      */
     RecvStatus receive(LatentChunk& chunk, const InetSockAddr& peerAddr)
     {
+        if (isExcluded(chunk.getId().getProdIndex())) {
+            chunk.discard(); // The filter excluded the chunk's product
+            return RecvStatus{};
+        }
+        OpAccounting::Scope opScope{OpAccounting::CHUNK_RECV};
         LOG_DEBUG("Received data-chunk " + chunk.getId().to_string() +
                 " from peer " + peerAddr.to_string());
+        if (metering)
+            perfMeter.chunk(chunk.getId(), chunk.getSize(), PerfMeter::P2P);
+        HYCAST_PROBE3(chunk_recv_p2p,
+                static_cast<ProdIndex::type>(chunk.getId().getProdIndex()),
+                static_cast<ChunkIndex::type>(chunk.getId().getChunkIndex()),
+                static_cast<ChunkSize::type>(chunk.getSize()));
+        FlightRecorder::record(
+                FlightRecorder::Event::CHUNK_RECV_P2P,
+                static_cast<ProdIndex::type>(chunk.getId().getProdIndex()),
+                static_cast<ChunkIndex::type>(chunk.getId().getChunkIndex()),
+                static_cast<ChunkSize::type>(chunk.getSize()));
+        static auto& chunkCount = Metrics::getCounter(
+                "hycast_chunks_received_total{transport=\"p2p\"}",
+                "Chunks of data received, by transport");
+        static auto& byteCount = Metrics::getCounter(
+                "hycast_bytes_received_total{transport=\"p2p\"}",
+                "Bytes of chunk-data received, by transport");
+        chunkCount.add();
+        byteCount.add(chunk.getSize());
         return accept(chunk);
     }
 
+    /**
+     * Receives a small, complete data-product from a peer as a single
+     * combined product-information and data message. Adds the whole product
+     * to the product-store with one insertion. If the product is new, then
+     * it's processed.
+     * @param[in] smallProd  Small, complete data-product
+     * @param[in] peerAddr   Address of remote peer
+     */
+    RecvStatus receive(
+            LatentSmallProd&    smallProd,
+            const InetSockAddr& peerAddr)
+    {
+        const auto prodInfo = smallProd.getInfo();
+        if (shouldDiscard(prodInfo)) {
+            smallProd.discard(); // Excluded before any store work
+            return RecvStatus{};
+        }
+        OpAccounting::Scope opScope{OpAccounting::CHUNK_RECV};
+        LOG_DEBUG("Received small product " + prodInfo.to_string() +
+                " from peer " + peerAddr.to_string());
+        const ChunkId chunkId = ChunkInfo{prodInfo, 0}.getId();
+        if (metering)
+            perfMeter.chunk(chunkId, prodInfo.getSize(), PerfMeter::P2P);
+        HYCAST_PROBE3(chunk_recv_p2p,
+                static_cast<ProdIndex::type>(prodInfo.getIndex()),
+                static_cast<ChunkIndex::type>(0),
+                static_cast<ChunkSize::type>(prodInfo.getSize()));
+        FlightRecorder::record(
+                FlightRecorder::Event::CHUNK_RECV_P2P,
+                static_cast<ProdIndex::type>(prodInfo.getIndex()), 0,
+                static_cast<ChunkSize::type>(prodInfo.getSize()));
+        static auto& chunkCount = Metrics::getCounter(
+                "hycast_chunks_received_total{transport=\"p2p\"}",
+                "Chunks of data received, by transport");
+        static auto& byteCount = Metrics::getCounter(
+                "hycast_bytes_received_total{transport=\"p2p\"}",
+                "Bytes of chunk-data received, by transport");
+        chunkCount.add();
+        byteCount.add(prodInfo.getSize());
+        return accept(smallProd);
+    }
+
+    /**
+     * Receives a batch of chunks-of-data from a peer -- e.g., a chunk-run
+     * message. The chunks that survive the per-chunk screening (product
+     * filter, duplicate rejection) go to the product-store as one batch, so
+     * the store takes each shard-lock once per product-group rather than
+     * once per chunk.
+     * @param[in]  chunks     Batch of data-chunks
+     * @param[in]  numChunks  Number of chunks in the batch
+     * @param[out] statuses   Status of each reception, parallel to `chunks`
+     * @param[in]  peerAddr   Address of remote peer
+     */
+    void receive(
+            LatentChunk* const  chunks,
+            const size_t        numChunks,
+            RecvStatus* const   statuses,
+            const InetSockAddr& peerAddr)
+    {
+        {
+            LockGuard lock{mutex};
+            throwIfException();
+        }
+        static auto& chunkCount = Metrics::getCounter(
+                "hycast_chunks_received_total{transport=\"p2p\"}",
+                "Chunks of data received, by transport");
+        static auto& byteCount = Metrics::getCounter(
+                "hycast_bytes_received_total{transport=\"p2p\"}",
+                "Bytes of chunk-data received, by transport");
+        std::vector<LatentChunk> admitted{};
+        std::vector<size_t>      positions{};
+        admitted.reserve(numChunks);
+        positions.reserve(numChunks);
+        for (size_t i = 0; i < numChunks; ++i) {
+            auto& chunk = chunks[i];
+            statuses[i] = RecvStatus{};
+            if (isExcluded(chunk.getId().getProdIndex())) {
+                chunk.discard(); // The filter excluded the chunk's product
+                continue;
+            }
+            OpAccounting::Scope opScope{OpAccounting::CHUNK_RECV};
+            LOG_DEBUG("Received data-chunk " + chunk.getId().to_string() +
+                    " from peer " + peerAddr.to_string());
+            if (metering)
+                perfMeter.chunk(chunk.getId(), chunk.getSize(),
+                        PerfMeter::P2P);
+            HYCAST_PROBE3(chunk_recv_p2p,
+                    static_cast<ProdIndex::type>(
+                            chunk.getId().getProdIndex()),
+                    static_cast<ChunkIndex::type>(
+                            chunk.getId().getChunkIndex()),
+                    static_cast<ChunkSize::type>(chunk.getSize()));
+            FlightRecorder::record(
+                    FlightRecorder::Event::CHUNK_RECV_P2P,
+                    static_cast<ProdIndex::type>(
+                            chunk.getId().getProdIndex()),
+                    static_cast<ChunkIndex::type>(
+                            chunk.getId().getChunkIndex()),
+                    static_cast<ChunkSize::type>(chunk.getSize()));
+            chunkCount.add();
+            byteCount.add(chunk.getSize());
+            // Duplicate from the other transport? Reject before the store.
+            if (chunkPresence.test(chunk.getId())) {
+                chunk.discard();
+                continue;
+            }
+            admitted.push_back(chunk);
+            positions.push_back(i);
+        }
+        if (admitted.empty())
+            return;
+        std::vector<RecvStatus> batchStatuses(admitted.size());
+        std::vector<Product>    prods(admitted.size());
+        prodStore.add(admitted.data(), admitted.size(),
+                batchStatuses.data(), prods.data());
+        for (size_t k = 0; k < admitted.size(); ++k) {
+            statuses[positions[k]] = batchStatuses[k];
+            finishChunk(admitted[k].getId(), batchStatuses[k], prods[k]);
+        }
+    }
+
+    /**
+     * Sets the performance meter. Every subsequently received chunk-of-data
+     * is recorded in the meter.
+     * @param[in] perfMeter  Performance meter
+     */
+    void setPerfMeter(const PerfMeter& perfMeter)
+    {
+        this->perfMeter = perfMeter;
+        metering = true;
+    }
+
+    /**
+     * Sets the shared memory-budget. The product-store claims its products
+     * against the budget, backlog production pauses at
+     * `MemBudget::Level::PAUSE_BACKLOG`, and the scheduling of new
+     * peer-to-peer chunk-requests stops at `MemBudget::Level::BACKPRESSURE`.
+     * @param[in] memBudget  Shared memory-budget
+     * @throw LogicError     A memory-budget was already set
+     */
+    void setMemBudget(const MemBudget& memBudget)
+    {
+        prodStore.setMemBudget(memBudget);
+        this->memBudget = memBudget;
+        auto p2pMgr = this->p2pMgr; // Handle copy outlives this instance
+        memBudget.observe([p2pMgr](const MemBudget::Level level) {
+            p2pMgr.setBackpressure(level >= MemBudget::Level::BACKPRESSURE);
+        });
+    }
+
+    /**
+     * Sets the product filter. Subsequently arriving products whose names the
+     * filter excludes are discarded before any store or processing work, and
+     * the filter is sent to all remote peers so notices and backlog for
+     * excluded products are never transmitted.
+     * @param[in] filter  Product filter
+     */
+    void setProdFilter(const ProdFilter& filter)
+    {
+        {
+            LockGuard lock{mutex};
+            prodFilter = filter;
+            excludedProds.clear(); // Re-evaluate under the new filter
+        }
+        p2pMgr.setProdFilter(filter);
+    }
+
+    /**
+     * Sets the order in which remote peers will be asked to serve this
+     * node's backlog.
+     * @param[in] order  Order in which the backlog should be served
+     * @see `P2pMgr::setBacklogOrder()`
+     */
+    void setBacklogOrder(const BacklogOrder order) const noexcept
+    {
+        p2pMgr.setBacklogOrder(order);
+    }
+
+    /**
+     * Sets the bandwidth-budget for proactively pushing rare chunks --
+     * and thereby enables pushing.
+     * @param[in] rate  Push rate in bytes per second or 0 to disable
+     *                  pushing
+     * @see `P2pMgr::setPushBudget()`
+     */
+    void setPushBudget(const double rate) const
+    {
+        p2pMgr.setPushBudget(rate);
+    }
+
     bool shouldRequest(const ProdIndex& prodIndex)
     {
         checkException();
+        if (isExcluded(prodIndex))
+            return false; // The filter excluded the product
         auto prodInfo = prodStore.getProdInfo(prodIndex);
         if (prodInfo.isComplete())
             return false;
@@ -308,7 +974,9 @@ public:
     bool shouldRequest(const ChunkId& id)
     {
         checkException();
-        if (prodStore.haveChunk(id))
+        if (isExcluded(id.getProdIndex()))
+            return false; // The filter excluded the chunk's product
+        if (chunkPresence.test(id) || prodStore.haveChunk(id))
             return false;
         LockGuard lock(mutex);
         auto iter = requestedChunks.find(id);
@@ -318,6 +986,12 @@ public:
         return true;
     }
 
+    double getCompleteness(const ProdIndex& prodIndex)
+    {
+        checkException();
+        return prodStore.getCompleteness(prodIndex);
+    }
+
     bool get(const ProdIndex& prodIndex, ProdInfo& prodInfo)
     {
         checkException();
@@ -339,9 +1013,71 @@ Receiving::Receiving(
         Processing&          processing,
         const unsigned       version,
         const std::string&   pathname,
-        const double         drop)
-    : pImpl{new Impl(srcMcastInfo, p2pInfo, pathname, processing, version,
-            drop)}
+        const double         drop,
+        const unsigned       mcastWorkers)
+    : Receiving{std::vector<SrcMcastInfo>{srcMcastInfo}, p2pInfo, processing,
+            version, pathname, drop, mcastWorkers}
 {}
 
+Receiving::Receiving(
+        const std::vector<SrcMcastInfo>& srcMcastInfos,
+        P2pInfo&                         p2pInfo,
+        Processing&                      processing,
+        const unsigned                   version,
+        const std::string&               pathname,
+        const double                     drop,
+        const unsigned                   mcastWorkers)
+    : pImpl{new Impl(srcMcastInfos, p2pInfo, ProdStore{pathname}, pathname,
+            processing, version, drop, mcastWorkers)}
+{}
+
+Receiving::Receiving(
+        const std::vector<SrcMcastInfo>& srcMcastInfos,
+        P2pInfo&                         p2pInfo,
+        Processing&                      processing,
+        const unsigned                   version,
+        ProdStore&                       prodStore,
+        const double                     drop,
+        const unsigned                   mcastWorkers)
+    : pImpl{new Impl(srcMcastInfos, p2pInfo, prodStore, "", processing,
+            version, drop, mcastWorkers)}
+{}
+
+void Receiving::setMcastRcvrAffinity(const std::vector<unsigned>& cpus) const
+{
+    pImpl->setMcastRcvrAffinity(cpus);
+}
+
+void Receiving::setMcastRcvrScheduling(
+        const int policy,
+        const int priority) const
+{
+    pImpl->setMcastRcvrScheduling(policy, priority);
+}
+
+void Receiving::setPerfMeter(const PerfMeter& perfMeter) const
+{
+    pImpl->setPerfMeter(perfMeter);
+}
+
+void Receiving::setMemBudget(const MemBudget& memBudget) const
+{
+    pImpl->setMemBudget(memBudget);
+}
+
+void Receiving::setProdFilter(const ProdFilter& filter) const
+{
+    pImpl->setProdFilter(filter);
+}
+
+void Receiving::setBacklogOrder(const BacklogOrder order) const noexcept
+{
+    pImpl->setBacklogOrder(order);
+}
+
+void Receiving::setPushBudget(const double rate) const
+{
+    pImpl->setPushBudget(rate);
+}
+
 } /* namespace hycast */
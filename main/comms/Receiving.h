@@ -15,10 +15,16 @@
 #define MAIN_RECEIVING_RECEIVING_H_
 
 #include "McastReceiver.h"
+#include "MemBudget.h"
 #include "P2pContentRcvr.h"
+#include "PeerServer.h"
+#include "PerfMeter.h"
+#include "ProdFilter.h"
+#include "ProdStore.h"
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "mcast/McastContentRcvr.h"
 
@@ -26,6 +32,12 @@ namespace hycast {
 
 /**
  * Class that receives content from both the multicast and P2P networks.
+ *
+ * A process may run several independent instances -- one per feed --
+ * because all process-wide facilities are shared: the metrics registry,
+ * the codec buffer free-lists, the shared executor and chunk-buffer pools,
+ * and a common memory-budget installed via `setMemBudget()`. Per-feed
+ * state is limited to each instance's product-store and sockets.
  */
 class Receiving final
 {
@@ -43,6 +55,11 @@ public:
      *                          the empty string to indicate no persistence
      * @param[in] drop          Proportion of multicast packets to drop. From 0
      *                          through 1, inclusive.
+     * @param[in] mcastWorkers  Number of message-processing worker threads
+     *                          per multicast receiver or 0 to process
+     *                          messages on the socket-reading thread.
+     *                          Messages are partitioned among the workers by
+     *                          product-index.
      * @see ProdStore::ProdStore()
      */
     Receiving(
@@ -51,7 +68,163 @@ public:
             Processing&         processing,
             const unsigned      version,
             const std::string&  pathname = "",
-            const double        drop = 0);
+            const double        drop = 0,
+            const unsigned      mcastWorkers = 0);
+
+    /**
+     * Constructs with multiple multicast groups. The sender stripes products
+     * across its groups, so a receiver that subscribes to a subset of them
+     * ingests only the corresponding products.
+     * @param[in] srcMcastInfos  Information on the source-specific multicast
+     *                           groups to subscribe to. Must not be empty.
+     * @param[in] p2pInfo        Information for the peer-to-peer component
+     * @param[in] processing     Locally processes received data-products
+     * @param[in] version        Protocol version
+     * @param[in] pathname       Pathname of product-store persistence-file or
+     *                           the empty string to indicate no persistence
+     * @param[in] drop           Proportion of multicast packets to drop. From 0
+     *                           through 1, inclusive.
+     * @param[in] mcastWorkers   Number of message-processing worker threads
+     *                           per multicast receiver or 0 to process
+     *                           messages on the socket-reading threads.
+     *                           Messages are partitioned among the workers by
+     *                           product-index.
+     * @throw InvalidArgument    `srcMcastInfos` is empty
+     * @see ProdStore::ProdStore()
+     */
+    Receiving(
+            const std::vector<SrcMcastInfo>& srcMcastInfos,
+            P2pInfo&                         p2pInfo,
+            Processing&                      processing,
+            const unsigned                   version,
+            const std::string&               pathname = "",
+            const double                     drop = 0,
+            const unsigned                   mcastWorkers = 0);
+
+    /**
+     * Constructs with an externally-owned product-store. Received pieces land
+     * directly in the given store, so another component sharing the store --
+     * e.g., the shipping side of a relay node -- can serve them without the
+     * products being copied or bounced through the filesystem.
+     * @param[in] srcMcastInfos  Information on the source-specific multicast
+     *                           groups to subscribe to. Must not be empty.
+     * @param[in] p2pInfo        Information for the peer-to-peer component
+     * @param[in] processing     Locally processes received data-products
+     * @param[in] version        Protocol version
+     * @param[in] prodStore      Shared store of data-products
+     * @param[in] drop           Proportion of multicast packets to drop. From 0
+     *                           through 1, inclusive.
+     * @param[in] mcastWorkers   Number of message-processing worker threads
+     *                           per multicast receiver or 0 to process
+     *                           messages on the socket-reading threads.
+     * @throw InvalidArgument    `srcMcastInfos` is empty
+     */
+    Receiving(
+            const std::vector<SrcMcastInfo>& srcMcastInfos,
+            P2pInfo&                         p2pInfo,
+            Processing&                      processing,
+            const unsigned                   version,
+            ProdStore&                       prodStore,
+            const double                     drop = 0,
+            const unsigned                   mcastWorkers = 0);
+
+    /**
+     * Sets the CPU affinity of the multicast-receiving threads. On NUMA
+     * systems, pinning them to CPUs on the NIC's node keeps the receive path
+     * on one node: packet and chunk buffers are allocated by these threads,
+     * so first-touch places them node-locally. Call before traffic flows
+     * (i.e., immediately after construction) for full effect.
+     * @param[in] cpus         CPU indexes the threads may run on
+     * @throw InvalidArgument  `cpus` is empty
+     * @throw SystemError      Affinity couldn't be set
+     * @exceptionsafety        Basic guarantee
+     * @threadsafety           Safe
+     */
+    void setMcastRcvrAffinity(const std::vector<unsigned>& cpus) const;
+
+    /**
+     * Sets the scheduling policy and priority of the multicast-receiving
+     * threads. Running them `SCHED_FIFO` or `SCHED_RR` keeps housekeeping
+     * from taking their CPU under load, bounding tail receive-latency on
+     * shared hosts; backlog and maintenance threads stay `SCHED_OTHER`.
+     * Best combined with `setMcastRcvrAffinity()`.
+     * @param[in] policy       `SCHED_FIFO`, `SCHED_RR`, or `SCHED_OTHER`
+     * @param[in] priority     Priority within the policy's range
+     * @throw InvalidArgument  Unsupported policy or out-of-range priority
+     * @throw RuntimeError     `RLIMIT_RTPRIO` forbids the priority
+     * @throw SystemError      Scheduling couldn't be set
+     * @exceptionsafety        Basic guarantee
+     * @threadsafety           Safe
+     * @see Thread::setScheduling()
+     */
+    void setMcastRcvrScheduling(const int policy, const int priority) const;
+
+    /**
+     * Sets the performance meter. Every subsequently received chunk-of-data
+     * is recorded in the meter, attributed to the transport (multicast or
+     * P2P) over which it arrived. Chunks discarded by synthetic loss (cf. the
+     * `drop` construction parameter) aren't recorded. Intended for
+     * performance measurement; by default nothing is recorded.
+     * @param[in] perfMeter  Performance meter
+     * @exceptionsafety      Nothrow
+     * @threadsafety         Compatible but not safe
+     */
+    void setPerfMeter(const PerfMeter& perfMeter) const;
+
+    /**
+     * Sets the shared memory-budget. The product-store claims its products
+     * against the budget and evicts or compresses them early under pressure,
+     * backlog production pauses at `MemBudget::Level::PAUSE_BACKLOG`, and the
+     * scheduling of new peer-to-peer chunk-requests stops at
+     * `MemBudget::Level::BACKPRESSURE`. By default memory use is unbudgeted.
+     * @param[in] memBudget  Shared memory-budget
+     * @throw LogicError     A memory-budget was already set
+     * @exceptionsafety      Strong guarantee
+     * @threadsafety         Compatible but not safe
+     */
+    void setMemBudget(const MemBudget& memBudget) const;
+
+    /**
+     * Sets the product filter. Products whose names the filter excludes are
+     * discarded on arrival -- before any store or processing work -- and the
+     * filter is sent to all remote peers so notices and backlog for excluded
+     * products are never transmitted. An empty filter admits every product.
+     * A chunk that arrives before its product's information can't be
+     * evaluated and falls through to the product-store.
+     * @param[in] filter  Product filter
+     * @exceptionsafety   Basic guarantee
+     * @threadsafety      Safe
+     */
+    void setProdFilter(const ProdFilter& filter) const;
+
+    /**
+     * Sets the order in which remote peers will be asked to serve this
+     * node's backlog. Under `BacklogOrder::RECENT_FIRST` a window of the
+     * most recent products arrives first and the historical fill-in
+     * follows, so a node recovering from a long outage sees current data
+     * within seconds instead of after the whole backlog. Affects
+     * subsequently-added peers.
+     * @param[in] order   Order in which the backlog should be served
+     * @exceptionsafety   Nothrow
+     * @threadsafety      Safe
+     */
+    void setBacklogOrder(const BacklogOrder order) const noexcept;
+
+    /**
+     * Sets the bandwidth-budget for proactively pushing rare chunks --
+     * and thereby enables pushing, which is off by default. A chunk that
+     * few peers have announced -- typical after a multicast outage -- is
+     * sent, unrequested and within the budget, to peers that haven't
+     * announced it instead of being served serially as their requests
+     * trickle in.
+     * @param[in] rate         Push rate in bytes per second or 0 -- the
+     *                         default -- to disable pushing
+     * @throw InvalidArgument  The rate is negative
+     * @exceptionsafety        Strong guarantee
+     * @threadsafety           Safe
+     * @see `PeerSet::setPushBudget()`
+     */
+    void setPushBudget(const double rate) const;
 };
 
 } /* namespace hycast */
@@ -0,0 +1,141 @@
+/**
+ * This file implements a relay node: a receiving component and a shipping
+ * component coupled by a single, shared product-store.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: Relaying.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "P2pMgr.h"
+#include "Processing.h"
+#include "ProdStore.h"
+#include "Receiving.h"
+#include "Relaying.h"
+#include "Shipping.h"
+
+namespace hycast {
+
+class Relaying::Impl final : public Processing
+{
+    /// Store of data-products. Shared by the receiving and shipping sides.
+    ProdStore prodStore;
+    /// Ships received products on the local multicast group and peer-network
+    Shipping  shipping;
+    /// Receives products from the upstream multicast group and peer-network
+    Receiving receiving;
+
+public:
+    /**
+     * Constructs. Blocks until the upstream receivers are running and the
+     * local peer server is ready to accept an incoming connection.
+     * @param[in] srcMcastInfos    Information on the upstream source-specific
+     *                             multicast groups. Must not be empty.
+     * @param[in] p2pInfo          Information for the upstream peer-to-peer
+     *                             component
+     * @param[in] version          Protocol version
+     * @param[in] localMcastAddrs  Socket addresses of the local multicast
+     *                             groups. Must not be empty.
+     * @param[in] localServerAddr  Socket address of the local server for
+     *                             downstream peers
+     * @param[in] pathname         Pathname of product-store persistence-file
+     *                             or the empty string to indicate no
+     *                             persistence
+     * @param[in] maxPeers         Maximum number of downstream peers
+     * @param[in] stasisDuration   Minimum amount of time, in seconds, over
+     *                             which the set of downstream peers must be
+     *                             unchanged before the worst-performing peer
+     *                             may be replaced
+     */
+    Impl(   const std::vector<SrcMcastInfo>& srcMcastInfos,
+            P2pInfo&                         p2pInfo,
+            const unsigned                   version,
+            const std::vector<InetSockAddr>& localMcastAddrs,
+            const InetSockAddr&              localServerAddr,
+            const std::string&               pathname,
+            const unsigned                   maxPeers,
+            const unsigned                   stasisDuration)
+        : prodStore{pathname}
+        , shipping{prodStore, localMcastAddrs, version, localServerAddr,
+                maxPeers, stasisDuration}
+        , receiving{srcMcastInfos, p2pInfo, *this, version, prodStore}
+    {}
+
+    /**
+     * Relays a data-product that was completely received from upstream. The
+     * product already resides in the shared product-store -- where the
+     * downstream peers serve it from -- so relaying is only the local
+     * multicast transmission and peer notifications: the data is never
+     * copied.
+     * @param[in] prod  Complete data-product
+     */
+    void process(Product prod)
+    {
+        shipping.ship(prod);
+    }
+
+    /**
+     * Sets the performance meter.
+     * @param[in] perfMeter  Performance meter
+     * @see Receiving::setPerfMeter()
+     */
+    void setPerfMeter(const PerfMeter& perfMeter)
+    {
+        receiving.setPerfMeter(perfMeter);
+    }
+
+    /**
+     * Sets the shared memory-budget. Only the receiving side is told: it
+     * registers the shared product-store with the budget, which covers the
+     * shipping side too. (Telling both sides would register the store twice.)
+     * @param[in] memBudget  Shared memory-budget
+     * @throw LogicError     A memory-budget was already set
+     */
+    void setMemBudget(const MemBudget& memBudget)
+    {
+        receiving.setMemBudget(memBudget);
+    }
+};
+
+Relaying::Relaying(
+        const SrcMcastInfo& srcMcastInfo,
+        P2pInfo&            p2pInfo,
+        const unsigned      version,
+        const InetSockAddr& localMcastAddr,
+        const InetSockAddr& localServerAddr,
+        const std::string&  pathname,
+        const unsigned      maxPeers,
+        const unsigned      stasisDuration)
+    : pImpl{new Impl(std::vector<SrcMcastInfo>{srcMcastInfo}, p2pInfo,
+            version, std::vector<InetSockAddr>{localMcastAddr},
+            localServerAddr, pathname, maxPeers, stasisDuration)}
+{}
+
+Relaying::Relaying(
+        const std::vector<SrcMcastInfo>& srcMcastInfos,
+        P2pInfo&                         p2pInfo,
+        const unsigned                   version,
+        const std::vector<InetSockAddr>& localMcastAddrs,
+        const InetSockAddr&              localServerAddr,
+        const std::string&               pathname,
+        const unsigned                   maxPeers,
+        const unsigned                   stasisDuration)
+    : pImpl{new Impl(srcMcastInfos, p2pInfo, version, localMcastAddrs,
+            localServerAddr, pathname, maxPeers, stasisDuration)}
+{}
+
+void Relaying::setPerfMeter(const PerfMeter& perfMeter) const
+{
+    pImpl->setPerfMeter(perfMeter);
+}
+
+void Relaying::setMemBudget(const MemBudget& memBudget) const
+{
+    pImpl->setMemBudget(memBudget);
+}
+
+} // namespace
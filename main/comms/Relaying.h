@@ -0,0 +1,141 @@
+/**
+ * This file declares a relay node: a receiving component and a shipping
+ * component coupled by a single, shared product-store. The relay receives
+ * from an upstream multicast group and peer-to-peer network and re-multicasts
+ * on a local group with its own peer server, so many local consumers cost one
+ * WAN stream instead of one each.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: Relaying.h
+ * @author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_COMMS_RELAYING_H_
+#define MAIN_COMMS_RELAYING_H_
+
+#include "McastReceiver.h"
+#include "MemBudget.h"
+#include "P2pMgr.h"
+#include "PeerSet.h"
+#include "PerfMeter.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace hycast {
+
+/**
+ * Class that relays content from an upstream feed to local receiving nodes.
+ * Received pieces land in a product-store that the local shipping side serves
+ * directly, so relayed products are never copied or bounced through the
+ * filesystem on their way back out.
+ */
+class Relaying final
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Constructs. Blocks until the upstream receiver is running and the local
+     * peer server is ready to accept an incoming connection.
+     * @param[in] srcMcastInfo     Information on the upstream source-specific
+     *                             multicast
+     * @param[in] p2pInfo          Information for the upstream peer-to-peer
+     *                             component
+     * @param[in] version          Protocol version
+     * @param[in] localMcastAddr   Socket address of the local multicast group
+     *                             to re-multicast on
+     * @param[in] localServerAddr  Socket address of the local server for
+     *                             downstream peers
+     * @param[in] pathname         Pathname of product-store persistence-file
+     *                             or the empty string to indicate no
+     *                             persistence
+     * @param[in] maxPeers         Maximum number of downstream peers
+     * @param[in] stasisDuration   Minimum amount of time, in seconds, over
+     *                             which the set of downstream peers must be
+     *                             unchanged before the worst-performing peer
+     *                             may be replaced
+     * @see ProdStore::ProdStore()
+     */
+    Relaying(
+            const SrcMcastInfo& srcMcastInfo,
+            P2pInfo&            p2pInfo,
+            const unsigned      version,
+            const InetSockAddr& localMcastAddr,
+            const InetSockAddr& localServerAddr,
+            const std::string&  pathname = "",
+            const unsigned      maxPeers = PeerSet::defaultMaxPeers,
+            const unsigned      stasisDuration =
+                    PeerSet::defaultStasisDuration);
+
+    /**
+     * Constructs with multiple upstream and local multicast groups. Blocks
+     * until the upstream receivers are running and the local peer server is
+     * ready to accept an incoming connection.
+     * @param[in] srcMcastInfos    Information on the upstream source-specific
+     *                             multicast groups to subscribe to. Must not
+     *                             be empty.
+     * @param[in] p2pInfo          Information for the upstream peer-to-peer
+     *                             component
+     * @param[in] version          Protocol version
+     * @param[in] localMcastAddrs  Socket addresses of the local multicast
+     *                             groups to re-multicast on. Must not be
+     *                             empty.
+     * @param[in] localServerAddr  Socket address of the local server for
+     *                             downstream peers
+     * @param[in] pathname         Pathname of product-store persistence-file
+     *                             or the empty string to indicate no
+     *                             persistence
+     * @param[in] maxPeers         Maximum number of downstream peers
+     * @param[in] stasisDuration   Minimum amount of time, in seconds, over
+     *                             which the set of downstream peers must be
+     *                             unchanged before the worst-performing peer
+     *                             may be replaced
+     * @throw InvalidArgument      `srcMcastInfos` or `localMcastAddrs` is
+     *                             empty
+     * @see ProdStore::ProdStore()
+     */
+    Relaying(
+            const std::vector<SrcMcastInfo>& srcMcastInfos,
+            P2pInfo&                         p2pInfo,
+            const unsigned                   version,
+            const std::vector<InetSockAddr>& localMcastAddrs,
+            const InetSockAddr&              localServerAddr,
+            const std::string&               pathname = "",
+            const unsigned                   maxPeers =
+                    PeerSet::defaultMaxPeers,
+            const unsigned                   stasisDuration =
+                    PeerSet::defaultStasisDuration);
+
+    /**
+     * Sets the performance meter. Every chunk-of-data subsequently received
+     * from upstream is recorded in the meter.
+     * @param[in] perfMeter  Performance meter
+     * @exceptionsafety      Nothrow
+     * @threadsafety         Compatible but not safe
+     * @see Receiving::setPerfMeter()
+     */
+    void setPerfMeter(const PerfMeter& perfMeter) const;
+
+    /**
+     * Sets the shared memory-budget. The shared product-store claims its
+     * products against the budget, and the upstream receive path applies
+     * backpressure under pressure. Downstream peers serve from the same
+     * budgeted store.
+     * @param[in] memBudget  Shared memory-budget
+     * @throw LogicError     A memory-budget was already set
+     * @exceptionsafety      Strong guarantee
+     * @threadsafety         Compatible but not safe
+     * @see Receiving::setMemBudget()
+     */
+    void setMemBudget(const MemBudget& memBudget) const;
+};
+
+} // namespace
+
+#endif /* MAIN_COMMS_RELAYING_H_ */
@@ -30,6 +30,7 @@
  *           ChunkId        12
  *           ProdSize        4
  *           CanonChunkSize  2
+ *           Crc32c          4 (only if checksums are enabled)
  *           ChunkData
  *              ChunkSize    2 (transient; encoded in payload protocol ID)
  *              char         ?
@@ -39,16 +40,33 @@
  */
 #include "config.h"
 
+#include "Crc32c.h"
+#include "DurableTxQueue.h"
 #include "error.h"
+#include "FlightRecorder.h"
+#include "Metrics.h"
 #include "PeerSet.h"
 #include "PeerSetServer.h"
+#include "probe.h"
 #include "ProdStore.h"
+#include "RetentionMsg.h"
 #include "Shipping.h"
 #include "SctpSock.h"
+#include "Standby.h"
 #include "Thread.h"
+#include "Tunables.h"
+#include "UdpSock.h"
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <endian.h>
+#include <functional>
+#include <mutex>
 #include <pthread.h>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace hycast {
 
@@ -65,6 +83,10 @@ class Shipping::Impl final
         class PeerSetSrvr : public PeerSetServer
         {
             ProdStore         prodStore;
+            /// Shared memory-budget or a no-op default
+            MemBudget         memBudget;
+            /// Observer of receivers' chunk-losses or empty
+            std::function<void(const ChunkId&)> lossObserver;
             static RecvStatus nilRecvStatus;
 
         public:
@@ -75,8 +97,32 @@ class Shipping::Impl final
              */
             PeerSetSrvr(ProdStore& prodStore)
                 : prodStore{prodStore}
+                , memBudget{}
+                , lossObserver{}
             {}
 
+            /**
+             * Sets the shared memory-budget, which can pause backlog
+             * production.
+             * @param[in] memBudget  Shared memory-budget
+             */
+            void setMemBudget(const MemBudget& memBudget)
+            {
+                this->memBudget = memBudget;
+            }
+
+            /**
+             * Sets the observer of receivers' chunk-losses. A chunk-request
+             * from a remote peer means the requester missed the chunk on
+             * multicast, so every request is reported to the observer.
+             * @param[in] observer  Observer of receivers' chunk-losses
+             */
+            void setLossObserver(
+                    const std::function<void(const ChunkId&)>& observer)
+            {
+                lossObserver = observer;
+            }
+
             /**
              * Returns the ID of the earliest missing chunk-of-data.
              * @return ID of earliest missing data-chunk
@@ -86,11 +132,27 @@ class Shipping::Impl final
                 return ChunkId{};
             }
 
+            /**
+             * Returns this node's retention advertisement: the oldest
+             * data-product its store still holds.
+             * @param[out] retention  Retention advertisement
+             * @retval `true`         Always: the source always answers
+             */
+            bool getRetention(RetentionMsg& retention)
+            {
+                const auto oldest = prodStore.getOldestResident();
+                retention = oldest
+                        ? RetentionMsg{oldest.getIndex(),
+                                oldest.getOriginTime()}
+                        : RetentionMsg{};
+                return true;
+            }
+
             Backlogger getBacklogger(
                     const ChunkId& earliest,
                     Peer&          peer)
             {
-                return Backlogger{peer, earliest, prodStore};
+                return Backlogger{peer, earliest, prodStore, memBudget};
             }
 
             /// Do nothing because this node is the source
@@ -151,6 +213,14 @@ class Shipping::Impl final
                     const ChunkId& id,
                     ActualChunk&   chunk)
             {
+                /*
+                 * A chunk-request is a receiver's loss report. Backlog
+                 * requests arrive here too, so the reported rate is an
+                 * upper bound on multicast loss; the parity bandwidth-
+                 * budget bounds the FEC controller's response.
+                 */
+                if (lossObserver)
+                    lossObserver(id);
                 chunk = prodStore.getChunk(id);
                 return chunk.operator bool();
             }
@@ -160,6 +230,8 @@ class Shipping::Impl final
         PeerSetSrvr     peerSetSrvr; // Must initialize before `peerSet`
         PeerSet         peerSet;     // Must initialize after `peerSetSrvr`
         InetSockAddr    serverAddr;
+        /// DSCP applied to connections from remote peers. 0 => unmarked
+        std::atomic<unsigned> dscp;
         Thread          serverThread;
 
         /**
@@ -172,6 +244,9 @@ class Shipping::Impl final
         void accept(SctpSock sock)
         {
             try {
+                const unsigned dscp = this->dscp.load();
+                if (dscp)
+                    sock.setDscp(dscp);
                 // Blocks exchanging protocol version; hence, separate thread
                 auto peer = Peer(sock);
                 peerSet.tryInsert(peer);
@@ -227,6 +302,7 @@ class Shipping::Impl final
             , peerSetSrvr{prodStore}
             , peerSet{peerSetSrvr, maxPeers, stasisDuration}
             , serverAddr{serverAddr}
+            , dscp{0}
             , serverThread{[this]{runServer();}}
         {
             serverReady.wait();
@@ -249,6 +325,55 @@ class Shipping::Impl final
             }
         }
 
+        /**
+         * Sets the shared memory-budget, which can pause backlog production.
+         * @param[in] memBudget  Shared memory-budget
+         */
+        void setMemBudget(const MemBudget& memBudget)
+        {
+            peerSetSrvr.setMemBudget(memBudget);
+        }
+
+        /**
+         * Sets the observer of receivers' chunk-losses: every chunk-request
+         * from a remote peer is reported to it.
+         * @param[in] observer  Observer of receivers' chunk-losses
+         */
+        void setLossObserver(
+                const std::function<void(const ChunkId&)>& observer)
+        {
+            peerSetSrvr.setLossObserver(observer);
+        }
+
+        /**
+         * Sets the backlog bandwidth-budget of the set of active peers.
+         * @param[in] aggRate      Aggregate backlog service-rate in bytes
+         *                         per second or 0 for no limit
+         * @param[in] perPeerRate  Per-peer backlog service-rate in bytes
+         *                         per second or 0 for no limit
+         */
+        void setBacklogBudget(
+                const double aggRate,
+                const double perPeerRate)
+        {
+            peerSet.setBacklogBudget(aggRate, perPeerRate);
+        }
+
+        /**
+         * Sets the Differentiated Services code-point applied to subsequent
+         * connections from remote peers. Existing connections are unaffected.
+         * @param[in] dscp         Code-point in [0,63] (see RFC 2474). 0 is
+         *                         best-effort (the default).
+         * @throw InvalidArgument  `dscp > 63`
+         */
+        void setDscp(const unsigned dscp)
+        {
+            if (dscp > 63)
+                throw INVALID_ARGUMENT("Invalid DSCP: " +
+                        std::to_string(dscp));
+            this->dscp = dscp;
+        }
+
         /**
          * Notifies remote peers about the availability of a data-product.
          * @param[in] prod  Data-product
@@ -256,23 +381,420 @@ class Shipping::Impl final
         void notify(const Product& prod)
         {
             auto prodInfo = prod.getInfo();
-            peerSet.notify(prodInfo.getIndex());
-            ChunkIndex numChunks = prodInfo.getNumChunks();
-            for (ChunkIndex i = 0; i < numChunks; ++i)
-                peerSet.notify(ChunkId{prodInfo, i});
+            // Identified by name so a peer's product filter, if any, can
+            // veto the product and its chunk notices
+            peerSet.notify(prodInfo.getIndex(), prodInfo.getName());
+            // One coalesced notice per peer instead of one notice per chunk
+            ChunkRange chunkRange{prodInfo};
+            if (chunkRange)
+                peerSet.notify(chunkRange);
+        }
+
+        /**
+         * Notifies remote peers about the availability of information on a
+         * data-product whose chunks will follow individually.
+         * @param[in] prodInfo  Product information
+         */
+        void notify(const ProdInfo& prodInfo)
+        {
+            peerSet.notify(prodInfo.getIndex(), prodInfo.getName());
+        }
+
+        /**
+         * Notifies remote peers about the availability of a data-chunk.
+         * @param[in] chunkId  Data-chunk identifier
+         */
+        void notify(const ChunkId& chunkId)
+        {
+            peerSet.notify(chunkId);
         }
     }; // Class `PeerMgr`
 
-    ProdStore   prodStore;
-    P2pSender   p2pSender;
-    McastSender mcastSender;
+    /**
+     * Sender-side cache of the payload fingerprints of recently-shipped
+     * products. The upstream feed occasionally re-delivers an identical file
+     * under a new name; without the cache those duplicate bytes are re-shipped
+     * to the whole network. A fingerprint is the payload's size, its CRC32C,
+     * and a 64-bit FNV-1a hash: the two hash families are independent, so a
+     * coincidental match of all three is vanishingly improbable. The cache
+     * holds a bounded number of fingerprints in two generations; filling the
+     * newer generation discards the older one.
+     */
+    class DedupCache final
+    {
+        /// Fingerprint of a previously-shipped payload, keyed by FNV-1a hash
+        struct Shipped
+        {
+            uint32_t        crc;   ///< CRC32C of the payload
+            uint32_t        size;  ///< Size of the payload in bytes
+            ProdIndex::type index; ///< Index of the shipping product
+        };
+
+        typedef std::unordered_map<uint64_t, Shipped> Generation;
+
+        /// Maximum number of fingerprints per generation
+        static const size_t genCapacity = 1024;
+
+        std::mutex mutex;
+        Generation curr;
+        Generation prev;
+
+        /**
+         * Indicates if a generation contains a fingerprint.
+         * @param[in]  gen    Generation to search
+         * @param[in]  fnv    FNV-1a hash of the payload
+         * @param[in]  crc    CRC32C of the payload
+         * @param[in]  size   Size of the payload in bytes
+         * @param[out] index  Index of the matching previously-shipped product
+         * @retval `true`     The generation contains the fingerprint
+         * @retval `false`    The generation doesn't contain the fingerprint
+         */
+        static bool search(
+                const Generation& gen,
+                const uint64_t    fnv,
+                const uint32_t    crc,
+                const uint32_t    size,
+                ProdIndex::type&  index)
+        {
+            const auto iter = gen.find(fnv);
+            if (iter == gen.end() || iter->second.crc != crc ||
+                    iter->second.size != size)
+                return false;
+            index = iter->second.index;
+            return true;
+        }
+
+    public:
+        DedupCache()
+            : mutex{}
+            , curr{}
+            , prev{}
+        {
+            curr.reserve(genCapacity);
+        }
+
+        /**
+         * Indicates if a payload is a duplicate of a recently-shipped one.
+         * If it isn't, then its fingerprint is added to the cache.
+         * @param[in]  fnv        FNV-1a hash of the payload
+         * @param[in]  crc        CRC32C of the payload
+         * @param[in]  size       Size of the payload in bytes
+         * @param[in]  prodIndex  Index of the product being shipped
+         * @param[out] dupOf      Index of the previously-shipped product.
+         *                        Set iff the payload is a duplicate.
+         * @retval `true`         The payload was recently shipped
+         * @retval `false`        The payload wasn't recently shipped
+         */
+        bool checkAndAdd(
+                const uint64_t   fnv,
+                const uint32_t   crc,
+                const uint32_t   size,
+                const ProdIndex  prodIndex,
+                ProdIndex::type& dupOf)
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            if (search(curr, fnv, crc, size, dupOf) ||
+                    search(prev, fnv, crc, size, dupOf))
+                return true;
+            if (curr.size() >= genCapacity) {
+                prev = std::move(curr);
+                curr = Generation{};
+                curr.reserve(genCapacity);
+            }
+            curr[fnv] = Shipped{crc, size,
+                    static_cast<ProdIndex::type>(prodIndex)};
+            return false;
+        }
+    };
+
+    /**
+     * Aggregator of peer-to-peer repair demand. A loss event that hits many
+     * receivers identically (e.g., an upstream switch blip) makes hundreds
+     * of nodes request the same chunks peer-to-peer -- N unicast copies of
+     * identical data. This class counts the chunk-requests that reach this
+     * source-node within a sliding window; once a chunk's count crosses the
+     * threshold, the chunk is worth retransmitting once on the multicast
+     * group instead, and further retransmissions of it are suppressed for a
+     * hold-down period while the stragglers' requests drain (those are still
+     * served unicast).
+     */
+    class RepairDemand final
+    {
+        typedef std::chrono::steady_clock Clock;
+        typedef Clock::time_point         TimePoint;
+        typedef std::chrono::milliseconds Millisecs;
+
+        /// Default number of same-chunk requests within the window past
+        /// which the chunk is retransmitted on multicast
+        static const unsigned defaultThreshold = 8;
+        /// Width of the demand-counting window in milliseconds
+        static const unsigned windowMs = 1000;
+        /// Duration in milliseconds for which a retransmitted chunk won't
+        /// be retransmitted again
+        static const unsigned holdDownMs = 5000;
+        /// Number of calls between sweeps of stale entries
+        static const unsigned pruneInterval = 1024;
+
+        /// Demand for one chunk
+        struct Demand
+        {
+            unsigned  count;
+            TimePoint first;
+        };
+
+        std::mutex                             mutex;
+        /// Request-counts of the currently-demanded chunks
+        std::unordered_map<ChunkId, Demand>    demands;
+        /// Chunks recently retransmitted, by time of retransmission
+        std::unordered_map<ChunkId, TimePoint> resent;
+        /// Retransmission threshold. 0 disables multicast repair.
+        std::atomic<unsigned>                  threshold;
+        /// Calls since the last sweep of stale entries
+        unsigned                               numCalls;
+        Tunables::Handle                       thresholdTunable;
+
+        /**
+         * Discards expired demand-counts and hold-downs. The mutex must be
+         * locked.
+         * @param[in] now  The current time
+         */
+        void prune(const TimePoint now)
+        {
+            for (auto iter = demands.begin(); iter != demands.end(); )
+                iter = (now - iter->second.first > Millisecs{windowMs})
+                        ? demands.erase(iter)
+                        : ++iter;
+            for (auto iter = resent.begin(); iter != resent.end(); )
+                iter = (now - iter->second > Millisecs{holdDownMs})
+                        ? resent.erase(iter)
+                        : ++iter;
+        }
+
+    public:
+        RepairDemand()
+            : mutex{}
+            , demands{}
+            , resent{}
+            , threshold{defaultThreshold}
+            , numCalls{0}
+            , thresholdTunable{}
+        {
+            thresholdTunable = Tunables::registerTunable(
+                    "ship.repair_threshold",
+                    "Number of peer-requests for the same chunk within a "
+                    "second past which the chunk is retransmitted on the "
+                    "multicast group. 0 disables multicast repair.",
+                    [this](const std::string& value) {
+                        unsigned threshold;
+                        try {
+                            threshold = std::stoul(value);
+                        }
+                        catch (const std::exception& e) {
+                            throw INVALID_ARGUMENT("Not a number: \"" + value
+                                    + "\"");
+                        }
+                        this->threshold = threshold;
+                        return std::to_string(threshold);
+                    });
+        }
+
+        /**
+         * Registers a peer's request for a chunk and indicates whether the
+         * chunk should now be retransmitted on the multicast group.
+         * @param[in] id     Chunk identifier
+         * @retval `true`    The chunk should be retransmitted
+         * @retval `false`   The chunk should be served unicast only
+         * @exceptionsafety  Basic guarantee
+         * @threadsafety     Safe
+         */
+        bool shouldMulticast(const ChunkId& id)
+        {
+            const unsigned threshold = this->threshold;
+            if (threshold == 0)
+                return false;
+            const auto now = Clock::now();
+            std::lock_guard<std::mutex> lock{mutex};
+            if (++numCalls >= pruneInterval) {
+                prune(now);
+                numCalls = 0;
+            }
+            const auto iter = resent.find(id);
+            if (iter != resent.end()) {
+                if (now - iter->second < Millisecs{holdDownMs})
+                    return false;
+                resent.erase(iter);
+            }
+            auto& demand = demands[id];
+            if (demand.count == 0 || now - demand.first > Millisecs{windowMs}) {
+                demand.count = 1;
+                demand.first = now;
+                if (threshold > 1)
+                    return false;
+            }
+            else if (++demand.count < threshold) {
+                return false;
+            }
+            demands.erase(id);
+            resent[id] = now;
+            return true;
+        }
+    };
+
+    ProdStore                prodStore;
+    P2pSender                p2pSender;
+    /// Payload fingerprints of recently-shipped products
+    DedupCache               dedupCache;
+    /// Whether duplicate payloads are suppressed
+    bool                     dedupEnabled;
+    /// Aggregated peer-to-peer repair demand
+    RepairDemand             repairDemand;
+    /// Protocol version
+    const unsigned           version;
+    /// One sender per multicast group; products are striped across them
+    std::vector<McastSender> mcastSenders;
+    /// Sender of the low-rate essential layer or empty if layering is
+    /// disabled. The layer announces every product -- all product-
+    /// information -- but carries in full only the products the policy
+    /// below selects, so a bandwidth-constrained receiver can subscribe to
+    /// this one group alone and fetch other products selectively over the
+    /// peer-to-peer network.
+    std::shared_ptr<McastSender> essentialSender;
+    /// Largest product, in bytes, carried in full on the essential layer
+    ProdSize                 essMaxProdSize;
+    /// Priority class at or above which a product of any size is carried in
+    /// full on the essential layer
+    ProdInfo::Priority       essMinPriority;
+    /// Whether the product being streamed is also streamed on the essential
+    /// layer
+    bool                     streamEssential;
+    /// Multicast sender of the product being streamed or `nullptr` if no
+    /// streaming shipment is in progress
+    McastSender*             streamSender;
+    /// Product-store entry of the product being streamed
+    Product                  streamProd;
+    /// Durable queue of products awaiting full multicast transmission.
+    /// Invalid unless `enableDurableQueue()` was called.
+    DurableTxQueue           txQueue;
+    /// Guards `pendingAcks`
+    std::mutex               ackMutex;
+    /// Record-identifiers of fair-scheduled products awaiting the transmit
+    /// observer's acknowledgment, by product-index
+    std::unordered_map<ProdIndex::type, uint64_t> pendingAcks;
+    /// Index after that of the most-recently shipped product -- the resume
+    /// point a warm standby needs. 0 until a product is shipped.
+    std::atomic<ProdIndex::type> nextHbIndex;
+    /// Socket on which heartbeats are multicast
+    OutUdpSock               hbSock;
+    /// Thread on which heartbeats are multicast
+    Thread                   hbThread;
+    /// One in this many shipped products is flagged for full-detail
+    /// tracing. 0 flags none. Trace identifiers are minted regardless.
+    std::atomic<unsigned>    traceSampleInterval;
+    /// Number of trace identifiers minted; drives the sampling cadence
+    std::atomic<uint64_t>    numTraced;
+    Tunables::Handle         traceSampleTunable;
+
+    /**
+     * Returns the multicast sender for a product. The product's index -- not
+     * its size or name -- selects the group so every receiver of the group
+     * can predict the assignment.
+     * @param[in] prodInfo  Information on the data-product
+     * @return              Multicast sender for the product
+     */
+    inline McastSender& getMcastSender(const ProdInfo& prodInfo) noexcept
+    {
+        return mcastSenders[prodInfo.getIndex().hash() % mcastSenders.size()];
+    }
+
+    /**
+     * Returns the multicast sender for a product.
+     * @param[in] prod  Data-product
+     * @return          Multicast sender for the product
+     */
+    inline McastSender& getMcastSender(const Product& prod) noexcept
+    {
+        return getMcastSender(prod.getInfo());
+    }
+
+    /**
+     * Indicates if a product belongs on the essential layer in full: it's
+     * small enough or urgent enough under the policy set by
+     * `enableEssentialLayer()`.
+     * @param[in] prodInfo  Information on the data-product
+     * @retval `true`       The product's data belongs on the essential layer
+     * @retval `false`      Only the product's announcement does
+     */
+    inline bool isEssential(const ProdInfo& prodInfo) const noexcept
+    {
+        return prodInfo.getSize() <= essMaxProdSize ||
+                prodInfo.getPriority() >= essMinPriority;
+    }
+
+    /**
+     * Additionally transmits a product on the essential layer: its
+     * product-information always -- so an essential-layer receiver learns of
+     * every product -- and its data only if the policy selects the product.
+     * No-op unless `enableEssentialLayer()` was called.
+     * @param[in] prod  Product being shipped
+     */
+    void shipEssential(Product& prod)
+    {
+        if (!essentialSender)
+            return;
+        if (isEssential(prod.getInfo())) {
+            essentialSender->send(prod);
+        }
+        else {
+            essentialSender->send(prod.getInfo());
+        }
+    }
+
+    /**
+     * Indicates if a product's payload is identical to that of a recently-
+     * shipped product. If it isn't, then the payload's fingerprint enters the
+     * dedup cache. A suppressed duplicate is logged and counted in the
+     * `hycast_ship_duplicates_suppressed_total` metric.
+     * @param[in] prod  Product about to be shipped
+     * @retval `true`   The payload was recently shipped; don't ship it again
+     * @retval `false`  The payload wasn't recently shipped
+     */
+    bool isRecentDuplicate(Product& prod)
+    {
+        if (!dedupEnabled)
+            return false;
+        const auto      info = prod.getInfo();
+        // The view pins the product's storage while its bytes are hashed
+        const auto      span = prod.getDataSpan();
+        const char*     data = span.getData();
+        const uint32_t  size = info.getSize();
+        const uint32_t  crc = crc32c(0, data, size);
+        // Doubles as the end-to-end payload checksum carried to receivers
+        info.setPayloadCrc(crc);
+        uint64_t        fnv = UINT64_C(14695981039346656037);
+        for (uint32_t i = 0; i < size; ++i) {
+            fnv ^= static_cast<unsigned char>(data[i]);
+            fnv *= UINT64_C(1099511628211);
+        }
+        ProdIndex::type dupOf;
+        if (!dedupCache.checkAndAdd(fnv, crc, size, info.getIndex(), dupOf))
+            return false;
+        LOG_NOTE("Suppressed shipment of product " + info.to_string() +
+                ": payload is identical to that of recently-shipped product " +
+                std::to_string(dupOf));
+        static auto& dupCount = Metrics::getCounter(
+                "hycast_ship_duplicates_suppressed_total",
+                "Product shipments suppressed because an identical payload "
+                "was recently shipped");
+        dupCount.add();
+        return true;
+    }
 
 public:
     /**
      * Constructs. Blocks until ready to accept an incoming connection from a
      * remote peer.
      * @param[in] prodStore       Product store
-     * @param[in] mcastAddr       Multicast group socket address
+     * @param[in] mcastAddrs      Multicast group socket addresses
      * @param[in] version         Protocol version
      * @param[in] stasisDuration  Minimum amount of time, in seconds, over which
      *                            the set of active peers must be unchanged
@@ -280,17 +802,381 @@ public:
      *                            removed
      * @param[in] serverAddr      Socket address of local server for remote
      *                            peers
+     * @throw InvalidArgument     `mcastAddrs` is empty
      */
-    Impl(   ProdStore&              prodStore,
-            const InetSockAddr&     mcastAddr,
-            unsigned                version,
-            const InetSockAddr&     serverAddr,
-            unsigned                maxPeers,
-            const unsigned          stasisDuration)
+    Impl(   ProdStore&                       prodStore,
+            const std::vector<InetSockAddr>& mcastAddrs,
+            unsigned                         version,
+            const InetSockAddr&              serverAddr,
+            unsigned                         maxPeers,
+            const unsigned                   stasisDuration)
         : prodStore{prodStore}
         , p2pSender{prodStore, serverAddr, maxPeers, stasisDuration}
-        , mcastSender{mcastAddr, version}
-    {}
+        , dedupCache{}
+        , dedupEnabled{false}
+        , repairDemand{}
+        , version{version}
+        , mcastSenders{}
+        , essentialSender{}
+        , essMaxProdSize{0}
+        , essMinPriority{0}
+        , streamEssential{false}
+        , streamSender{nullptr}
+        , streamProd{}
+        , txQueue{}
+        , ackMutex{}
+        , pendingAcks{}
+        , nextHbIndex{0}
+        , hbSock{}
+        , hbThread{}
+        , traceSampleInterval{0}
+        , numTraced{0}
+        , traceSampleTunable{}
+    {
+        if (mcastAddrs.empty())
+            throw INVALID_ARGUMENT("Empty set of multicast groups");
+        mcastSenders.reserve(mcastAddrs.size());
+        for (const auto& mcastAddr : mcastAddrs)
+            mcastSenders.emplace_back(mcastAddr, version);
+        /*
+         * Peers' chunk-requests are the receivers' loss reports: each is
+         * routed to the multicast sender whose group carried the chunk so
+         * that sender's FEC overhead adapts to the observed loss. The
+         * captured handles share the senders' state, so the observer stays
+         * valid for as long as peers keep serving.
+         */
+        auto senders = mcastSenders;
+        p2pSender.setLossObserver([this,senders](const ChunkId& id) mutable {
+            auto& sender = senders[id.getProdIndex().hash() % senders.size()];
+            sender.reportLostChunk();
+            /*
+             * When many receivers miss the same chunk identically, their
+             * aggregated repair demand crosses the threshold and the chunk
+             * is retransmitted once on the multicast group that originally
+             * carried it -- one datagram instead of N unicast transfers.
+             * The requests already in flight are still served unicast.
+             */
+            if (repairDemand.shouldMulticast(id)) {
+                auto chunk = this->prodStore.getChunk(id);
+                if (chunk) {
+                    const auto prodInfo =
+                            this->prodStore.getProdInfo(id.getProdIndex());
+                    if (prodInfo)
+                        sender.resend(prodInfo, chunk);
+                }
+            }
+        });
+        // End-to-end integrity check. `Receiving` enables this too.
+        BaseChunk::enableChecksums(true);
+        traceSampleTunable = Tunables::registerTunable(
+                "ship.trace_sample_interval",
+                "One in this many shipped products is flagged for "
+                "full-detail tracing. 0 flags none.",
+                [this](const std::string& value) {
+                    unsigned interval;
+                    try {
+                        interval = std::stoul(value);
+                    }
+                    catch (const std::exception& e) {
+                        throw INVALID_ARGUMENT("Not a number: \"" + value
+                                + "\"");
+                    }
+                    this->traceSampleInterval = interval;
+                    return std::to_string(interval);
+                });
+    }
+
+    ~Impl() noexcept
+    {
+        try {
+            if (hbThread.joinable()) {
+                hbThread.cancel();
+                hbThread.join();
+            }
+        }
+        catch (const std::exception& ex) {
+            log_error(ex);
+        }
+    }
+
+    /**
+     * Sets the shared memory-budget. The product-store claims its products
+     * against the budget and backlog production pauses at
+     * `MemBudget::Level::PAUSE_BACKLOG`.
+     * @param[in] memBudget  Shared memory-budget
+     * @throw LogicError     A memory-budget was already set
+     */
+    void setMemBudget(const MemBudget& memBudget)
+    {
+        prodStore.setMemBudget(memBudget);
+        p2pSender.setMemBudget(memBudget);
+    }
+
+    /**
+     * Sets the backlog bandwidth-budget: caps on the aggregate and per-peer
+     * rates at which backlog data-chunks are served to remote peers, so
+     * simultaneous catch-ups can't saturate the uplink that the live
+     * multicast transmission depends on.
+     * @param[in] aggRate      Aggregate backlog service-rate in bytes per
+     *                         second or 0 for no limit
+     * @param[in] perPeerRate  Per-peer backlog service-rate in bytes per
+     *                         second or 0 for no limit
+     * @throw InvalidArgument  A rate is negative
+     */
+    void setBacklogBudget(
+            const double aggRate,
+            const double perPeerRate)
+    {
+        p2pSender.setBacklogBudget(aggRate, perPeerRate);
+    }
+
+    /**
+     * Sets the Differentiated Services code-points on the two transports:
+     * the multicast senders of the real-time product stream and the server
+     * for connections from remote peers. Existing peer-connections are
+     * unaffected.
+     * @param[in] mcastDscp    Code-point for multicast product datagrams
+     * @param[in] p2pDscp      Code-point for peer-to-peer traffic -- chunk
+     *                         repair, notices, and backlog
+     * @throw InvalidArgument  A code-point exceeds 63
+     */
+    void setDscp(
+            const unsigned mcastDscp,
+            const unsigned p2pDscp)
+    {
+        for (auto& mcastSender : mcastSenders)
+            mcastSender.setDscp(mcastDscp);
+        if (essentialSender)
+            essentialSender->setDscp(mcastDscp);
+        p2pSender.setDscp(p2pDscp);
+    }
+
+    /**
+     * Enables the layered essential feed: an additional multicast group
+     * that announces every product but carries in full only those matching
+     * a size/priority policy. One feed then serves both well-connected and
+     * bandwidth-constrained receivers: the latter subscribe to the
+     * essential group alone -- typically paced well below the full feed's
+     * rate -- receive the critical products directly, and fetch any other
+     * product selectively over the peer-to-peer network.
+     * @param[in] essAddr      Socket address of the essential-layer group.
+     *                         Must differ from the product groups.
+     * @param[in] maxProdSize  Largest product, in bytes, carried in full
+     * @param[in] minPriority  Priority class at or above which a product of
+     *                         any size is carried in full. 0 carries every
+     *                         product, so pass a class above
+     *                         `ProdInfo::defaultPriority` to make size the
+     *                         only criterion.
+     * @param[in] rate         Maximum sending rate of the essential group in
+     *                         bytes per second or 0 for no pacing
+     * @throw LogicError       The essential layer is already enabled
+     * @exceptionsafety        Strong guarantee
+     * @threadsafety           Compatible but not safe
+     */
+    void enableEssentialLayer(
+            const InetSockAddr&      essAddr,
+            const ProdSize           maxProdSize,
+            const ProdInfo::Priority minPriority,
+            const double             rate)
+    {
+        if (essentialSender)
+            throw LOGIC_ERROR("The essential layer is already enabled");
+        essMaxProdSize = maxProdSize;
+        essMinPriority = minPriority;
+        essentialSender.reset(new McastSender{essAddr, version, 0, rate});
+    }
+
+    /**
+     * Enables content-hash deduplication of shipped products.
+     */
+    void enableDedup()
+    {
+        dedupEnabled = true;
+    }
+
+    /**
+     * Enables the durable transmit-queue: a memory-mapped ring-file that a
+     * product enters before its first datagram and leaves only after its
+     * full multicast transmission. Products that a previous process recorded
+     * but didn't fully transmit are replayed -- synchronously, in arrival
+     * order -- before this function returns.
+     * @param[in] pathname     Pathname of the ring-file
+     * @param[in] capacity     Size of the ring-file in bytes. Ignored if the
+     *                         file already exists.
+     * @throw InvalidArgument  Capacity is too small for a single product
+     * @throw RuntimeError     Existing file isn't a ring-file
+     * @throw SystemError      File couldn't be created, sized, or mapped
+     */
+    void enableDurableQueue(
+            const std::string& pathname,
+            const size_t       capacity)
+    {
+        txQueue = DurableTxQueue{pathname, capacity};
+        // Fair-scheduled products are acknowledged from the senders'
+        // scheduler-threads after their final datagram is handed to the
+        // socket
+        for (auto& mcastSender : mcastSenders)
+            mcastSender.setTransmitObserver([this](const ProdInfo& prodInfo) {
+                uint64_t id;
+                {
+                    std::lock_guard<std::mutex> lock{ackMutex};
+                    auto iter = pendingAcks.find(
+                            static_cast<ProdIndex::type>(prodInfo.getIndex()));
+                    if (iter == pendingAcks.end())
+                        return;
+                    id = iter->second;
+                    pendingAcks.erase(iter);
+                }
+                txQueue.done(id);
+            });
+        const auto backlog = txQueue.size();
+        if (backlog)
+            LOG_NOTE("Replaying " + std::to_string(backlog) + " products "
+                    "that a previous process didn't fully transmit");
+        // Replayed products bypass the dedup check: they were already vetted
+        // when first shipped
+        txQueue.replay([this](const uint64_t id, Product& prod) {
+            stampPayloadCrc(prod);
+            stampTraceId(prod.getInfo());
+            prod.getInfo().setOriginTime(ProdInfo::now());
+            getMcastSender(prod).send(prod);
+            shipEssential(prod);
+            // Following order is necessary
+            prodStore.add(prod);
+            p2pSender.notify(prod);
+            txQueue.done(id);
+        });
+    }
+
+    /**
+     * Records a product in the durable transmit-queue, if enabled. A full
+     * ring -- transmission has fallen far behind ingest -- is logged and the
+     * product is shipped non-durably: availability is preferred over
+     * durability.
+     * @param[in]  prod  Product about to be shipped
+     * @param[out] id    Identifier of the product's record
+     * @retval `true`    The product was recorded; pass `id` to
+     *                   `txQueue.done()` after full transmission
+     * @retval `false`   The queue is disabled or full
+     */
+    bool record(
+            Product&  prod,
+            uint64_t& id)
+    {
+        if (!txQueue)
+            return false;
+        if (txQueue.put(prod, id))
+            return true;
+        LOG_WARN("Durable transmit-queue is full; shipping product " +
+                std::to_string(prod.getInfo().getIndex()) + " non-durably");
+        return false;
+    }
+
+    /**
+     * Mints the product's trace identifier, if it doesn't have one, and
+     * stamps the identifier into this node's probe and flight recorder so
+     * offline tools can join the identifier to the product-index. The
+     * identifier's sampling flag is set on one product in
+     * `traceSampleInterval`.
+     * @param[in] prodInfo  Information on the product
+     */
+    void stampTraceId(const ProdInfo& prodInfo) noexcept
+    {
+        if (prodInfo.getTraceId() == 0) {
+            const auto interval = traceSampleInterval.load();
+            const bool sampled = interval != 0 &&
+                    numTraced.fetch_add(1) % interval == 0;
+            prodInfo.setTraceId(ProdInfo::mintTraceId(sampled));
+        }
+        const auto traceId = prodInfo.getTraceId();
+        HYCAST_PROBE2(trace_id,
+                static_cast<ProdIndex::type>(prodInfo.getIndex()), traceId);
+        FlightRecorder::record(FlightRecorder::Event::TRACE_ID,
+                static_cast<ProdIndex::type>(prodInfo.getIndex()),
+                static_cast<uint32_t>(traceId),
+                static_cast<uint32_t>(traceId >> 32));
+    }
+
+    /**
+     * Notes the shipment of a product so heartbeats advertise the resume
+     * point: the index after that of the highest-indexed product shipped.
+     * @param[in] prodInfo  Information on the shipped product
+     */
+    void noteShipped(const ProdInfo& prodInfo) noexcept
+    {
+        const auto next = static_cast<ProdIndex::type>(prodInfo.getIndex())
+                + 1;
+        auto prev = nextHbIndex.load();
+        while (prev < next && !nextHbIndex.compare_exchange_weak(prev, next))
+            ;
+    }
+
+    /**
+     * Multicasts heartbeats. Doesn't return. Intended to run on its own
+     * thread, which can be safely canceled.
+     * @param[in] interval  Seconds between heartbeats
+     */
+    void runHeartbeat(const double interval)
+    {
+        const auto period = std::chrono::duration_cast<
+                std::chrono::nanoseconds>(
+                std::chrono::duration<double>{interval});
+        for (;;) {
+            Standby::Heartbeat hb;
+            hb.magic = htobe64(Standby::heartbeatMagic);
+            hb.nextIndex = htobe64(nextHbIndex.load());
+            try {
+                hbSock.send(&hb, sizeof(hb));
+            }
+            catch (const std::exception& ex) {
+                log_warn(ex); // A missed heartbeat isn't fatal -- yet
+            }
+            Canceler canceler{};
+            std::this_thread::sleep_for(period);
+        }
+    }
+
+    /**
+     * Starts multicasting heartbeats so a warm standby can detect the death
+     * of this process within a few intervals. Each heartbeat carries the
+     * product-index at which a standby should resume the sequence.
+     * @param[in] hbAddr    Socket address of the heartbeat multicast group.
+     *                      Must differ from the product groups.
+     * @param[in] interval  Seconds between heartbeats
+     * @throw InvalidArgument  `interval <= 0`
+     * @throw LogicError       Heartbeats were already started
+     */
+    void startHeartbeat(
+            const InetSockAddr& hbAddr,
+            const double        interval)
+    {
+        if (interval <= 0)
+            throw INVALID_ARGUMENT("Heartbeat interval isn't positive: " +
+                    std::to_string(interval));
+        if (hbThread.joinable())
+            throw LOGIC_ERROR("Heartbeats were already started");
+        hbSock = OutUdpSock{hbAddr};
+        hbThread = Thread{[this,interval]{runHeartbeat(interval);}};
+    }
+
+    /**
+     * Stamps the product's information with the CRC32C of the product's
+     * entire payload if it isn't already stamped -- the dedup check computes
+     * the same checksum and stamps it as a side effect. A receiver
+     * accumulates the checksum chunk-by-chunk as the product assembles and
+     * verifies it at completion, so end-to-end integrity costs no re-read of
+     * the data on either side.
+     * @param[in] prod  Product about to be shipped
+     */
+    void stampPayloadCrc(Product& prod)
+    {
+        const auto info = prod.getInfo();
+        if (info.getPayloadCrc() != 0)
+            return;
+        // The view pins the product's storage while its bytes are hashed
+        const auto span = prod.getDataSpan();
+        info.setPayloadCrc(crc32c(0, span.getData(), info.getSize()));
+    }
 
     /**
      * Ships a product.
@@ -298,10 +1184,138 @@ public:
      */
     void ship(Product& prod)
     {
-        mcastSender.send(prod);
+        if (isRecentDuplicate(prod))
+            return;
+        stampPayloadCrc(prod);
+        uint64_t   recId;
+        const bool recorded = record(prod, recId);
+        stampTraceId(prod.getInfo());
+        // Stamped just before first transmission so receivers can compute
+        // one-way, origin-to-completion latency
+        prod.getInfo().setOriginTime(ProdInfo::now());
+        getMcastSender(prod).send(prod);
+        shipEssential(prod);
         // Following order is necessary
         prodStore.add(prod);
         p2pSender.notify(prod);
+        if (recorded)
+            txQueue.done(recId);
+        noteShipped(prod.getInfo());
+    }
+
+    /**
+     * Ships a product via the multicast sender's fair scheduler. Returns as
+     * soon as the product is queued: its chunks are interleaved, in weighted
+     * round-robin order, with those of other queued products, so a small or
+     * urgent product achieves low latency even while a large product is in
+     * flight.
+     * @param[in] prod      Product to ship
+     * @param[in] priority  Scheduling weight: `priority+1` chunks are
+     *                      multicast per round-robin turn
+     */
+    void ship(
+            Product&       prod,
+            const unsigned priority)
+    {
+        if (isRecentDuplicate(prod))
+            return;
+        stampPayloadCrc(prod);
+        uint64_t recId;
+        if (record(prod, recId)) {
+            // Registered before the enqueue so the transmit observer can't
+            // miss the acknowledgment
+            std::lock_guard<std::mutex> lock{ackMutex};
+            pendingAcks[static_cast<ProdIndex::type>(
+                    prod.getInfo().getIndex())] = recId;
+        }
+        stampTraceId(prod.getInfo());
+        // Stamped at enqueue-time, so the latency a receiver computes
+        // includes any wait in the fair scheduler
+        prod.getInfo().setOriginTime(ProdInfo::now());
+        getMcastSender(prod).enqueue(prod, priority);
+        // Synchronous: an essential product is small and the non-essential
+        // case sends one announcement datagram
+        shipEssential(prod);
+        // Following order is necessary
+        prodStore.add(prod);
+        p2pSender.notify(prod);
+        noteShipped(prod.getInfo());
+    }
+
+    /**
+     * Begins the streaming shipment of a product whose data is still arriving
+     * -- e.g., one still landing from the ingester. The product-information
+     * is multicast and the remote peers are notified immediately, so
+     * transmission of the leading chunks overlaps the ingest of the trailing
+     * ones: the latency of a large product becomes the maximum of ingest-time
+     * and transmit-time instead of their sum.
+     * @param[in] prodInfo  Information on the data-product
+     * @throws LogicError   A streaming shipment is already in progress
+     */
+    void beginProduct(const ProdInfo& prodInfo)
+    {
+        if (streamSender)
+            throw LOGIC_ERROR("Streaming shipment of product " +
+                    std::to_string(streamProd.getInfo().getIndex()) +
+                    " is already in progress");
+        auto& sender = getMcastSender(prodInfo);
+        stampTraceId(prodInfo);
+        // Stamped just before first transmission so receivers can compute
+        // one-way, origin-to-completion latency
+        prodInfo.setOriginTime(ProdInfo::now());
+        sender.beginProduct(prodInfo);
+        if (essentialSender) {
+            if (isEssential(prodInfo)) {
+                essentialSender->beginProduct(prodInfo);
+                streamEssential = true;
+            }
+            else {
+                essentialSender->send(prodInfo); // Announcement only
+            }
+        }
+        // Following order is necessary
+        prodStore.add(prodInfo, streamProd);
+        p2pSender.notify(prodInfo);
+        streamSender = &sender;
+        noteShipped(prodInfo);
+    }
+
+    /**
+     * Ships a data-chunk of the product begun by `beginProduct()`. The chunk
+     * is multicast, added to the product-store so remote peers can request
+     * it, and the peers are notified of its availability.
+     * @param[in] chunk    Data-chunk
+     * @throws LogicError  `beginProduct()` hasn't been called
+     */
+    void ship(const ActualChunk& chunk)
+    {
+        if (streamSender == nullptr)
+            throw LOGIC_ERROR("No streaming shipment in progress");
+        streamSender->send(chunk);
+        if (streamEssential)
+            essentialSender->send(chunk);
+        // Following order is necessary
+        streamProd.add(chunk);
+        p2pSender.notify(chunk.getId());
+    }
+
+    /**
+     * Ends the current streaming shipment: multicasts the final, partial
+     * forward-error-correction block, if any, and transmits any staged
+     * datagrams.
+     * @throws LogicError  `beginProduct()` hasn't been called
+     */
+    void endProduct()
+    {
+        if (streamSender == nullptr)
+            throw LOGIC_ERROR("No streaming shipment in progress");
+        streamSender->endProduct();
+        if (streamEssential) {
+            essentialSender->endProduct();
+            streamEssential = false;
+        }
+        streamSender = nullptr;
+        streamProd = Product{};
     }
 }; // `Shipping::Impl`
 
@@ -314,13 +1328,93 @@ Shipping::Shipping(
         const InetSockAddr&     serverAddr,
         const unsigned          maxPeers,
         const unsigned          stasisDuration)
-    : pImpl{new Impl(prodStore, mcastAddr, version, serverAddr, maxPeers,
+    : Shipping{prodStore, std::vector<InetSockAddr>{mcastAddr}, version,
+            serverAddr, maxPeers, stasisDuration}
+{}
+
+Shipping::Shipping(
+        ProdStore&                       prodStore,
+        const std::vector<InetSockAddr>& mcastAddrs,
+        const unsigned                   version,
+        const InetSockAddr&              serverAddr,
+        const unsigned                   maxPeers,
+        const unsigned                   stasisDuration)
+    : pImpl{new Impl(prodStore, mcastAddrs, version, serverAddr, maxPeers,
             stasisDuration)}
 {}
 
+void Shipping::setMemBudget(const MemBudget& memBudget) const
+{
+    pImpl->setMemBudget(memBudget);
+}
+
+void Shipping::setBacklogBudget(
+        const double aggRate,
+        const double perPeerRate) const
+{
+    pImpl->setBacklogBudget(aggRate, perPeerRate);
+}
+
+void Shipping::setDscp(
+        const unsigned mcastDscp,
+        const unsigned p2pDscp) const
+{
+    pImpl->setDscp(mcastDscp, p2pDscp);
+}
+
+void Shipping::enableEssentialLayer(
+        const InetSockAddr&      essAddr,
+        const ProdSize           maxProdSize,
+        const ProdInfo::Priority minPriority,
+        const double             rate) const
+{
+    pImpl->enableEssentialLayer(essAddr, maxProdSize, minPriority, rate);
+}
+
+void Shipping::enableDedup() const
+{
+    pImpl->enableDedup();
+}
+
+void Shipping::enableDurableQueue(
+        const std::string& pathname,
+        const size_t       capacity) const
+{
+    pImpl->enableDurableQueue(pathname, capacity);
+}
+
+void Shipping::startHeartbeat(
+        const InetSockAddr& hbAddr,
+        const double        interval) const
+{
+    pImpl->startHeartbeat(hbAddr, interval);
+}
+
 void Shipping::ship(Product& prod)
 {
     pImpl->ship(prod);
 }
 
+void Shipping::ship(
+        Product&       prod,
+        const unsigned priority)
+{
+    pImpl->ship(prod, priority);
+}
+
+void Shipping::beginProduct(const ProdInfo& prodInfo)
+{
+    pImpl->beginProduct(prodInfo);
+}
+
+void Shipping::ship(const ActualChunk& chunk)
+{
+    pImpl->ship(chunk);
+}
+
+void Shipping::endProduct()
+{
+    pImpl->endProduct();
+}
+
 } // namespace
@@ -14,15 +14,28 @@
 #define MAIN_COMMS_SHIPPING_H_
 
 #include "McastSender.h"
+#include "MemBudget.h"
 #include "P2pMgr.h"
 #include "PeerSet.h"
 #include "ProdStore.h"
 #include "Product.h"
 
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace hycast {
 
+/**
+ * Class that ships data-products to receiving nodes via multicast and the
+ * P2P network.
+ *
+ * A process may run several independent instances -- one per feed --
+ * because all process-wide facilities are shared: the metrics registry,
+ * the codec buffer free-lists, the shared executor and chunk-buffer pools,
+ * and a common memory-budget installed via `setMemBudget()`. Per-feed
+ * state is limited to each instance's product-store and sockets.
+ */
 class Shipping final
 {
     class                 Impl;
@@ -37,7 +50,9 @@ public:
      * @param[in] version         Protocol version
      * @param[in] serverAddr      Socket address of local server for remote
      *                            peers
-     * @param[in] maxPeers        Maximum number of peers.
+     * @param[in] maxPeers        Initial maximum number of peers; adjustable
+     *                            at runtime via the tunable
+     *                            `peerset.<n>.max_peers`
      * @param[in] stasisDuration  Minimum amount of time, in seconds, over which
      *                            the set of active peers must be unchanged
      *                            before the worst-performing peer may be
@@ -53,11 +68,234 @@ public:
             const unsigned          stasisDuration =
                     PeerSet::defaultStasisDuration);
 
+    /**
+     * Constructs with multiple multicast groups. Blocks until ready to accept
+     * an incoming connection from a remote peer. Each product is transmitted
+     * on exactly one group -- chosen by the hash of its product-index -- so
+     * large products don't delay small ones on other groups and a receiver
+     * may subscribe to a subset of the groups.
+     * @param[in] prodStore       Product store
+     * @param[in] mcastAddrs      Multicast group socket addresses. Must not be
+     *                            empty. Must be identical, in number and
+     *                            order, at every receiver.
+     * @param[in] version         Protocol version
+     * @param[in] serverAddr      Socket address of local server for remote
+     *                            peers
+     * @param[in] maxPeers        Initial maximum number of peers; adjustable
+     *                            at runtime via the tunable
+     *                            `peerset.<n>.max_peers`
+     * @param[in] stasisDuration  Minimum amount of time, in seconds, over which
+     *                            the set of active peers must be unchanged
+     *                            before the worst-performing peer may be
+     *                            replaced
+     * @throw InvalidArgument     `mcastAddrs` is empty
+     * @see PeerSet(std::function<Peer&>, unsigned, unsigned)
+     */
+    Shipping(
+            ProdStore&                       prodStore,
+            const std::vector<InetSockAddr>& mcastAddrs,
+            const unsigned                   version,
+            const InetSockAddr&              serverAddr,
+            const unsigned                   maxPeers = PeerSet::defaultMaxPeers,
+            const unsigned                   stasisDuration =
+                    PeerSet::defaultStasisDuration);
+
+    /**
+     * Sets the shared memory-budget. The product-store claims its products
+     * against the budget and evicts or compresses them early under pressure,
+     * and backlog production pauses at `MemBudget::Level::PAUSE_BACKLOG`. By
+     * default memory use is unbudgeted.
+     * @param[in] memBudget  Shared memory-budget
+     * @throw LogicError     A memory-budget was already set
+     * @exceptionsafety      Strong guarantee
+     * @threadsafety         Compatible but not safe
+     */
+    void setMemBudget(const MemBudget& memBudget) const;
+
+    /**
+     * Sets the backlog bandwidth-budget: caps on the aggregate and per-peer
+     * rates at which backlog data-chunks are served to remote peers. The
+     * source node is the only one guaranteed to have every product, so
+     * unbudgeted backlog service can saturate its uplink and degrade live
+     * multicast transmission -- protecting the live path outranks any
+     * individual peer's catch-up speed. Requests beyond the budget aren't
+     * served; the requesters fetch history from other peers instead. By
+     * default service is unbudgeted.
+     * @param[in] aggRate      Aggregate backlog service-rate in bytes per
+     *                         second or 0 for no limit
+     * @param[in] perPeerRate  Per-peer backlog service-rate in bytes per
+     *                         second or 0 for no limit
+     * @throw InvalidArgument  A rate is negative
+     * @exceptionsafety        Strong guarantee
+     * @threadsafety           Safe
+     * @see PeerSet::setBacklogBudget()
+     */
+    void setBacklogBudget(
+            const double aggRate,
+            const double perPeerRate) const;
+
+    /**
+     * Sets the Differentiated Services code-points on the two transports so
+     * the network can class their traffic differently: the multicast senders
+     * of the real-time product stream and the server for connections from
+     * remote peers. A peer-connection carries chunk repair, notices, and
+     * backlog on one SCTP association, so those classes share the
+     * peer-to-peer code-point; connections accepted before this call are
+     * unaffected. By default all traffic is unmarked (best-effort).
+     * @param[in] mcastDscp    Code-point for multicast product datagrams, in
+     *                         [0,63] (see RFC 2474)
+     * @param[in] p2pDscp      Code-point for peer-to-peer traffic, in [0,63]
+     * @throw InvalidArgument  A code-point exceeds 63
+     * @throw SystemError      A code-point couldn't be set
+     * @exceptionsafety        Basic guarantee
+     * @threadsafety           Safe
+     */
+    void setDscp(
+            const unsigned mcastDscp,
+            const unsigned p2pDscp) const;
+
+    /**
+     * Enables the layered essential feed: an additional multicast group that
+     * announces every product -- all product-information -- but carries in
+     * full only the products matching a size/priority policy. One feed then
+     * serves both well-connected and bandwidth-constrained receivers: the
+     * latter subscribe to the essential group alone -- typically paced well
+     * below the full feed's rate -- receive the critical products directly,
+     * and fetch any other announced product selectively over the
+     * peer-to-peer network by admitting it through their product filter.
+     * @param[in] essAddr      Socket address of the essential-layer group.
+     *                         Must differ from the product groups. Must be
+     *                         the same at every essential-layer receiver.
+     * @param[in] maxProdSize  Largest product, in bytes, carried in full on
+     *                         the essential layer
+     * @param[in] minPriority  Priority class at or above which a product of
+     *                         any size is carried in full. 0 carries every
+     *                         product, so pass a class above
+     *                         `ProdInfo::defaultPriority` to make size the
+     *                         only criterion.
+     * @param[in] rate         Maximum sending rate of the essential group in
+     *                         bytes per second or 0 for no pacing
+     * @throw LogicError       The essential layer is already enabled
+     * @exceptionsafety        Strong guarantee
+     * @threadsafety           Compatible but not safe
+     * @see Receiving::setProdFilter()
+     */
+    void enableEssentialLayer(
+            const InetSockAddr&      essAddr,
+            const ProdSize           maxProdSize,
+            const ProdInfo::Priority minPriority,
+            const double             rate = 0) const;
+
+    /**
+     * Enables content-hash deduplication: a product whose payload is
+     * identical to that of a recently-shipped product is silently not
+     * shipped. Intended for feeds that occasionally re-deliver an identical
+     * file under a new name; the suppressed product never reaches the
+     * network, so only enable this if downstream nodes don't need the
+     * duplicate. Disabled by default. Doesn't apply to streaming shipments,
+     * whose payloads aren't available up front.
+     * @exceptionsafety  Nothrow
+     * @threadsafety     Compatible but not safe
+     */
+    void enableDedup() const;
+
+    /**
+     * Enables the durable transmit-queue: a memory-mapped ring-file that a
+     * product enters at `ship()` -- before its first datagram -- and leaves
+     * only after its full multicast transmission. Products that a previous
+     * process recorded but didn't fully transmit are replayed before this
+     * function returns, so products the ingester already consumed survive a
+     * crash of the sending process. If the ring fills -- transmission has
+     * fallen far behind ingest -- products are shipped non-durably with a
+     * warning. Doesn't apply to streaming shipments, whose payloads arrive
+     * incrementally.
+     * @param[in] pathname     Pathname of the ring-file
+     * @param[in] capacity     Size of the ring-file in bytes. Ignored if the
+     *                         file already exists.
+     * @throw InvalidArgument  Capacity is too small for a single product
+     * @throw RuntimeError     Existing file isn't a ring-file
+     * @throw SystemError      File couldn't be created, sized, or mapped
+     * @exceptionsafety        Basic guarantee
+     * @threadsafety           Compatible but not safe
+     */
+    void enableDurableQueue(
+            const std::string& pathname,
+            const size_t       capacity) const;
+
+    /**
+     * Starts multicasting heartbeats so a warm standby can detect the death
+     * of this process within a few intervals and take over transmission.
+     * Each heartbeat carries the product-index at which a standby should
+     * resume the sequence: the index after that of the highest-indexed
+     * product shipped so far.
+     * @param[in] hbAddr       Socket address of the heartbeat multicast
+     *                         group. Must differ from the product groups.
+     * @param[in] interval     Seconds between heartbeats
+     * @throw InvalidArgument  `interval <= 0`
+     * @throw LogicError       Heartbeats were already started
+     * @exceptionsafety        Strong guarantee
+     * @threadsafety           Compatible but not safe
+     * @see Standby
+     */
+    void startHeartbeat(
+            const InetSockAddr& hbAddr,
+            const double        interval) const;
+
     /**
      * Ships a product.
      * @param[in] prod  Product to ship
      */
     void ship(Product& prod);
+
+    /**
+     * Ships a product via the multicast sender's fair scheduler. Returns as
+     * soon as the product is queued: its chunks are interleaved, in weighted
+     * round-robin order, with those of the other queued products, so a small
+     * or urgent product achieves low latency even while a large product is
+     * in flight.
+     * @param[in] prod      Product to ship. Must remain valid until
+     *                      transmitted.
+     * @param[in] priority  Scheduling weight: `priority+1` chunks are
+     *                      multicast per round-robin turn
+     * @exceptionsafety     Basic guarantee
+     * @threadsafety        Safe
+     */
+    void ship(
+            Product&       prod,
+            const unsigned priority);
+
+    /**
+     * Begins the streaming shipment of a product whose data is still arriving
+     * -- e.g., one still landing from the ingester. The product-information
+     * is multicast and the remote peers are notified immediately, so
+     * transmission of the leading chunks overlaps the ingest of the trailing
+     * ones: the latency of a large product becomes the maximum of ingest-time
+     * and transmit-time instead of their sum.
+     * @param[in] prodInfo  Information on the data-product
+     * @throws LogicError   A streaming shipment is already in progress
+     * @exceptionsafety     Basic guarantee
+     * @threadsafety        Compatible but not safe
+     */
+    void beginProduct(const ProdInfo& prodInfo);
+
+    /**
+     * Ships a data-chunk of the product begun by `beginProduct()`. The chunk
+     * is multicast, added to the product-store so remote peers can request
+     * it, and the peers are notified of its availability.
+     * @param[in] chunk    Data-chunk
+     * @throws LogicError  `beginProduct()` hasn't been called
+     * @exceptionsafety    Basic guarantee
+     * @threadsafety       Compatible but not safe
+     */
+    void ship(const ActualChunk& chunk);
+
+    /**
+     * Ends the current streaming shipment.
+     * @throws LogicError  `beginProduct()` hasn't been called
+     * @exceptionsafety    Basic guarantee
+     * @threadsafety       Compatible but not safe
+     */
+    void endProduct();
 };
 
 } // namespace
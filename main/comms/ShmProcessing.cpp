@@ -0,0 +1,105 @@
+/**
+ * This file implements a processing stage that hands completed data-products
+ * to co-located consumer processes through a shared-memory ring.
+ *
+ * The ring is the same one `ShmIngester` reads, so the two classes form the
+ * two ends of a local, zero-copy (on the consumer's side) delivery channel:
+ * the receiver publishes each completed product once and every byte a
+ * consumer reads comes straight out of the mapped segment -- no file is
+ * written to be read once, seconds later, on the same machine.
+ *
+ * Copyright 2018 University Corporation for Atmospheric Research. All Rights
+ * reserved. See file "Copying" in the top-level source-directory for usage
+ * restrictions.
+ *
+ *        File: ShmProcessing.cpp
+ *  Created on: Aug 29, 2018
+ *      Author: Steven R. Emmerson
+ */
+
+#include "config.h"
+
+#include "error.h"
+#include "Metrics.h"
+#include "ShmIngester.h"
+#include "ShmProcessing.h"
+
+namespace hycast {
+
+class ShmProcessing::Impl final
+{
+    ShmProducer  producer;
+    const size_t maxProdSize;
+
+public:
+    /**
+     * Constructs. Creates and initializes the shared-memory ring.
+     * @param[in] name         Name of the shared-memory segment
+     * @param[in] numSlots     Number of slots in the ring
+     * @param[in] maxProdSize  Maximum size of a data-product in bytes
+     * @throw InvalidArgument  `numSlots == 0 || maxProdSize == 0`
+     * @throw SystemError      `shm_open()`, `ftruncate()` or `mmap()` failure
+     */
+    Impl(   const std::string& name,
+            const unsigned     numSlots,
+            const size_t       maxProdSize)
+        : producer{name, numSlots, maxProdSize}
+        , maxProdSize{maxProdSize}
+    {}
+
+    /**
+     * Processes a data-product: publishes its name and data into the ring.
+     * Blocks until a slot is free. A product that's too large for a slot is
+     * dropped with a warning.
+     * @param[in] prod   Complete data-product
+     * @exceptionsafety  Basic guarantee
+     * @threadsafety     Safe
+     */
+    void process(Product prod)
+    {
+        const auto&  info = prod.getInfo();
+        const size_t size = info.getSize();
+        if (size > maxProdSize) {
+            static auto& oversizeCount = Metrics::getCounter(
+                    "hycast_shm_delivery_oversize_total",
+                    "Data-products too large for a slot of the shared-memory "
+                    "delivery-ring and consequently dropped");
+            oversizeCount.add();
+            LOG_WARN("Dropping data-product " + info.to_string() +
+                    ": larger than a delivery-ring slot (" +
+                    std::to_string(maxProdSize) + " bytes)");
+            return;
+        }
+        // The view pins the product's storage while the data is forwarded
+        const auto span = prod.getDataSpan();
+        producer.send(info.getName().to_string(), span.getData(), size);
+        static auto& prodCount = Metrics::getCounter(
+                "hycast_shm_delivery_products_total",
+                "Data-products delivered to consumer processes through the "
+                "shared-memory ring");
+        prodCount.add();
+        static auto& byteCount = Metrics::getCounter(
+                "hycast_shm_delivery_bytes_total",
+                "Bytes of product-data delivered to consumer processes "
+                "through the shared-memory ring");
+        byteCount.add(size);
+    }
+};
+
+ShmProcessing::ShmProcessing()
+    : pImpl{}
+{}
+
+ShmProcessing::ShmProcessing(
+        const std::string& name,
+        const unsigned     numSlots,
+        const size_t       maxProdSize)
+    : pImpl{new Impl{name, numSlots, maxProdSize}}
+{}
+
+void ShmProcessing::process(Product prod)
+{
+    pImpl->process(prod);
+}
+
+} // namespace
@@ -0,0 +1,73 @@
+/**
+ * This file declares a processing stage that hands completed data-products to
+ * co-located consumer processes through a shared-memory ring -- no disk round
+ * trip.
+ *
+ * Copyright 2018 University Corporation for Atmospheric Research. All Rights
+ * reserved. See file "Copying" in the top-level source-directory for usage
+ * restrictions.
+ *
+ *        File: ShmProcessing.h
+ *  Created on: Aug 29, 2018
+ *      Author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_COMMS_SHMPROCESSING_H_
+#define MAIN_COMMS_SHMPROCESSING_H_
+
+#include "Processing.h"
+
+#include <memory>
+#include <string>
+
+namespace hycast {
+
+/**
+ * Delivery-side endpoint of a shared-memory ring of completed data-products.
+ * The counterpart of `ShmIngester`, which accepts products from a co-located
+ * producer: this class publishes received products to co-located consumer
+ * processes, which attach to the ring with `ShmIngester` and map each
+ * product's bytes with zero copies. A product's slot is recycled only when
+ * the last reference to the delivered product is dropped, so a consumer can
+ * hold a product as long as it likes without copying it.
+ */
+class ShmProcessing final : public Processing
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    ShmProcessing();
+
+    /**
+     * Constructs. Creates and initializes the shared-memory ring. The segment
+     * is unlinked on destruction.
+     * @param[in] name         Name of the shared-memory segment (see
+     *                         shm_open(3))
+     * @param[in] numSlots     Number of slots in the ring
+     * @param[in] maxProdSize  Maximum size of a data-product in bytes. A
+     *                         larger product is dropped with a warning.
+     * @throw InvalidArgument  `numSlots == 0 || maxProdSize == 0`
+     * @throw SystemError      `shm_open()`, `ftruncate()` or `mmap()` failure
+     * @see ShmIngester
+     */
+    ShmProcessing(
+            const std::string& name,
+            const unsigned     numSlots,
+            const size_t       maxProdSize);
+
+    /**
+     * Processes a data-product: publishes its name and data into the ring.
+     * Blocks while every slot is held, so lagging consumers backpressure the
+     * caller rather than accumulating unbounded state (compose with
+     * `ParallelProcessing` to keep the receiving thread unblocked).
+     * @param[in] prod   Complete data-product
+     * @exceptionsafety  Basic guarantee
+     * @threadsafety     Safe
+     */
+    void process(Product prod);
+};
+
+} // namespace
+
+#endif /* MAIN_COMMS_SHMPROCESSING_H_ */
@@ -0,0 +1,282 @@
+/**
+ * This file implements the warm-standby half of an active/passive source
+ * pair.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: Standby.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "error.h"
+#include "Standby.h"
+#include "Thread.h"
+#include "UdpSock.h"
+
+#include <atomic>
+#include <chrono>
+#include <endian.h>
+#include <mutex>
+#include <thread>
+
+namespace hycast {
+
+class Standby::Impl final
+{
+    typedef std::mutex             Mutex;
+    typedef std::lock_guard<Mutex> LockGuard;
+    typedef std::chrono::steady_clock Clock;
+
+    ProdStore                 prodStore;
+    std::vector<InetSockAddr> mcastAddrs;
+    const unsigned            version;
+    const InetSockAddr        serverAddr;
+    const unsigned            maxPeers;
+    const unsigned            stasisDuration;
+    const double              timeout;
+    TakeoverObserver          observer;
+    /// Pathname of the durable transmit-queue to enable at takeover.
+    /// Empty => none.
+    std::string               dtqPathname;
+    size_t                    dtqCapacity;
+    /// Socket on which the active source's heartbeats arrive
+    McastUdpSock              hbSock;
+    /// Guards `lastBeat` and the takeover transition
+    mutable Mutex             mutex;
+    /// Time of the last valid heartbeat. Initially the construction time,
+    /// so a standby started while the active is already down still takes
+    /// over after one timeout.
+    Clock::time_point         lastBeat;
+    /// Index at which to resume the product sequence: the maximum of the
+    /// last heartbeat's advertisement and one past the highest index seen
+    /// locally
+    std::atomic<ProdIndex::type> resumeIndex;
+    /// Whether this node has taken over as the active source
+    std::atomic<bool>         active;
+    /// The `Shipping` instance constructed at takeover
+    std::shared_ptr<Shipping> shipping;
+    /// Thread on which heartbeats are received
+    Thread                    rcvThread;
+    /// Thread on which the heartbeat deadline is monitored
+    Thread                    monitorThread;
+
+    /**
+     * Receives heartbeats. Doesn't return. Intended to run on its own
+     * thread, which can be safely canceled.
+     */
+    void runReceiver()
+    {
+        try {
+            for (;;) {
+                Heartbeat hb;
+                size_t    nbytes;
+                {
+                    Canceler canceler{};
+                    nbytes = hbSock.recv(&hb, sizeof(hb));
+                }
+                if (nbytes != sizeof(hb) ||
+                        be64toh(hb.magic) != heartbeatMagic)
+                    continue; // Not a heartbeat; ignore
+                const auto next = be64toh(hb.nextIndex);
+                auto       prev = resumeIndex.load();
+                while (prev < next &&
+                        !resumeIndex.compare_exchange_weak(prev, next))
+                    ;
+                LockGuard lock{mutex};
+                lastBeat = Clock::now();
+            }
+        }
+        catch (const std::exception& ex) {
+            // Because end of thread
+            log_error(ex);
+        }
+    }
+
+    /**
+     * Monitors the heartbeat deadline and triggers the takeover when it
+     * passes. Returns after the takeover. Intended to run on its own
+     * thread, which can be safely canceled.
+     */
+    void runMonitor()
+    {
+        try {
+            /*
+             * Checking at a quarter of the timeout bounds the detection
+             * latency at 1.25 timeouts while staying insensitive to
+             * scheduling jitter
+             */
+            const auto period = std::chrono::duration_cast<
+                    std::chrono::nanoseconds>(
+                    std::chrono::duration<double>{timeout/4});
+            for (;;) {
+                {
+                    Canceler canceler{};
+                    std::this_thread::sleep_for(period);
+                }
+                if (active)
+                    return;
+                Clock::time_point last;
+                {
+                    LockGuard lock{mutex};
+                    last = lastBeat;
+                }
+                const auto silence = std::chrono::duration_cast<
+                        std::chrono::duration<double>>(
+                        Clock::now() - last).count();
+                if (silence > timeout) {
+                    LOG_NOTE("No heartbeat in " + std::to_string(silence) +
+                            " seconds; taking over as the active source");
+                    takeover();
+                    return;
+                }
+            }
+        }
+        catch (const std::exception& ex) {
+            // Because end of thread
+            log_error(ex);
+        }
+    }
+
+public:
+    Impl(   ProdStore&                       prodStore,
+            const std::vector<InetSockAddr>& mcastAddrs,
+            const unsigned                   version,
+            const InetSockAddr&              serverAddr,
+            const InetSockAddr&              hbAddr,
+            const double                     timeout,
+            const TakeoverObserver&          observer,
+            const unsigned                   maxPeers,
+            const unsigned                   stasisDuration)
+        : prodStore{prodStore}
+        , mcastAddrs{mcastAddrs}
+        , version{version}
+        , serverAddr{serverAddr}
+        , maxPeers{maxPeers}
+        , stasisDuration{stasisDuration}
+        , timeout{timeout}
+        , observer{observer}
+        , dtqPathname{}
+        , dtqCapacity{0}
+        , hbSock{hbAddr, true}
+        , mutex{}
+        , lastBeat{Clock::now()}
+        , resumeIndex{0}
+        , active{false}
+        , shipping{}
+        , rcvThread{}
+        , monitorThread{}
+    {
+        if (mcastAddrs.empty())
+            throw INVALID_ARGUMENT("Empty set of multicast groups");
+        if (timeout <= 0)
+            throw INVALID_ARGUMENT("Heartbeat timeout isn't positive: " +
+                    std::to_string(timeout));
+        rcvThread = Thread{[this]{runReceiver();}};
+        monitorThread = Thread{[this]{runMonitor();}};
+    }
+
+    /// Prevents copy and move construction and assignment
+    Impl(const Impl& that) =delete;
+    Impl(const Impl&& that) =delete;
+    Impl& operator =(const Impl& rhs) =delete;
+    Impl& operator =(const Impl&& rhs) =delete;
+
+    ~Impl() noexcept
+    {
+        try {
+            if (monitorThread.joinable()) {
+                monitorThread.cancel();
+                monitorThread.join();
+            }
+            if (rcvThread.joinable()) {
+                rcvThread.cancel();
+                rcvThread.join();
+            }
+        }
+        catch (const std::exception& ex) {
+            log_error(ex);
+        }
+    }
+
+    void setDurableQueue(
+            const std::string& pathname,
+            const size_t       capacity)
+    {
+        LockGuard lock{mutex};
+        dtqPathname = pathname;
+        dtqCapacity = capacity;
+    }
+
+    void noteProduct(const ProdInfo& prodInfo) noexcept
+    {
+        const auto next = static_cast<ProdIndex::type>(prodInfo.getIndex())
+                + 1;
+        auto prev = resumeIndex.load();
+        while (prev < next && !resumeIndex.compare_exchange_weak(prev, next))
+            ;
+    }
+
+    void takeover()
+    {
+        LockGuard lock{mutex};
+        if (active)
+            return;
+        const auto resume = resumeIndex.load();
+        LOG_NOTE("Becoming the active source; resuming the product "
+                "sequence at index " + std::to_string(resume));
+        shipping = std::make_shared<Shipping>(prodStore, mcastAddrs,
+                version, serverAddr, maxPeers, stasisDuration);
+        if (!dtqPathname.empty())
+            shipping->enableDurableQueue(dtqPathname, dtqCapacity);
+        // Set before the observer runs so a query from within it agrees
+        active = true;
+        if (observer)
+            observer(*shipping, ProdIndex{resume});
+    }
+
+    bool isActive() const noexcept
+    {
+        return active;
+    }
+};
+
+Standby::Standby(
+        ProdStore&                       prodStore,
+        const std::vector<InetSockAddr>& mcastAddrs,
+        const unsigned                   version,
+        const InetSockAddr&              serverAddr,
+        const InetSockAddr&              hbAddr,
+        const double                     timeout,
+        const TakeoverObserver&          observer,
+        const unsigned                   maxPeers,
+        const unsigned                   stasisDuration)
+    : pImpl{new Impl(prodStore, mcastAddrs, version, serverAddr, hbAddr,
+            timeout, observer, maxPeers, stasisDuration)}
+{}
+
+void Standby::setDurableQueue(
+        const std::string& pathname,
+        const size_t       capacity) const
+{
+    pImpl->setDurableQueue(pathname, capacity);
+}
+
+void Standby::noteProduct(const ProdInfo& prodInfo) const noexcept
+{
+    pImpl->noteProduct(prodInfo);
+}
+
+void Standby::takeover() const
+{
+    pImpl->takeover();
+}
+
+bool Standby::isActive() const noexcept
+{
+    return pImpl->isActive();
+}
+
+} // namespace
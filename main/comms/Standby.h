@@ -0,0 +1,150 @@
+/**
+ * This file declares the warm-standby half of an active/passive source pair.
+ * The standby runs alongside an ordinary `Receiving` instance -- so its
+ * product-store mirrors the feed -- while monitoring the active source's
+ * heartbeats. When the heartbeats stop, the standby constructs a `Shipping`
+ * instance on the same multicast groups within seconds and hands it to the
+ * application together with the product-index at which to resume the
+ * sequence, so receivers see an uninterrupted feed instead of a total
+ * outage followed by a swarm-wide backlog storm.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: Standby.h
+ * @author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_COMMS_STANDBY_H_
+#define MAIN_COMMS_STANDBY_H_
+
+#include "InetSockAddr.h"
+#include "PeerSet.h"
+#include "ProdInfo.h"
+#include "ProdStore.h"
+#include "Shipping.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace hycast {
+
+class Standby final
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /// Identifies a heartbeat datagram
+    static const uint64_t heartbeatMagic = UINT64_C(0x68796348425F3031);
+
+    /// Heartbeat datagram. Both fields are big-endian on the wire.
+    struct Heartbeat
+    {
+        uint64_t magic;     ///< `heartbeatMagic`
+        uint64_t nextIndex; ///< Index after that of the highest-indexed
+                            ///< product shipped. 0 => none shipped yet.
+    };
+
+    /**
+     * Function called exactly once, when the standby becomes the active
+     * source. Called with the newly-constructed `Shipping` instance --
+     * which the application must use for all subsequent shipments -- and
+     * the product-index at which to resume the sequence.
+     */
+    typedef std::function<void(Shipping& shipping, ProdIndex resumeIndex)>
+            TakeoverObserver;
+
+    /**
+     * Constructs and starts monitoring. The given product-store should be
+     * the one the co-resident `Receiving` instance fills, so the store is
+     * warm -- remote peers can fetch recent products from it -- the moment
+     * this node takes over.
+     * @param[in] prodStore       Product store
+     * @param[in] mcastAddrs      Multicast group socket addresses on which
+     *                            the active source transmits and this node
+     *                            will transmit after takeover
+     * @param[in] version         Protocol version
+     * @param[in] serverAddr      Socket address of the local server for
+     *                            remote peers after takeover
+     * @param[in] hbAddr          Socket address of the heartbeat multicast
+     *                            group
+     * @param[in] timeout         Seconds without a heartbeat before this
+     *                            node takes over
+     * @param[in] observer        Called when this node takes over
+     * @param[in] maxPeers        Initial maximum number of peers after
+     *                            takeover
+     * @param[in] stasisDuration  Minimum amount of time, in seconds, over
+     *                            which the set of active peers must be
+     *                            unchanged before the worst-performing peer
+     *                            may be replaced
+     * @throw InvalidArgument     `mcastAddrs` is empty or `timeout <= 0`
+     * @see Shipping::startHeartbeat()
+     */
+    Standby(ProdStore&                       prodStore,
+            const std::vector<InetSockAddr>& mcastAddrs,
+            const unsigned                   version,
+            const InetSockAddr&              serverAddr,
+            const InetSockAddr&              hbAddr,
+            const double                     timeout,
+            const TakeoverObserver&          observer,
+            const unsigned                   maxPeers =
+                    PeerSet::defaultMaxPeers,
+            const unsigned                   stasisDuration =
+                    PeerSet::defaultStasisDuration);
+
+    /**
+     * Sets the pathname of the durable transmit-queue that the `Shipping`
+     * instance constructed at takeover will use. The previous active's queue
+     * can't be read across hosts, but this node's own queue survives its
+     * restarts -- and a shared pathname on replicated storage mirrors the
+     * active's. Must be called before takeover to have effect.
+     * @param[in] pathname  Pathname of the ring-file
+     * @param[in] capacity  Size of the ring-file in bytes
+     * @exceptionsafety     Strong guarantee
+     * @threadsafety        Compatible but not safe
+     * @see Shipping::enableDurableQueue()
+     */
+    void setDurableQueue(
+            const std::string& pathname,
+            const size_t       capacity) const;
+
+    /**
+     * Notes a received product so the resume-index survives the loss of the
+     * final heartbeats: the takeover resumes after the maximum of the last
+     * heartbeat's index and the highest index seen here. Intended to be
+     * called from the application's `Processing::process()`.
+     * @param[in] prodInfo  Information on a received product
+     * @exceptionsafety     Nothrow
+     * @threadsafety        Safe
+     */
+    void noteProduct(const ProdInfo& prodInfo) const noexcept;
+
+    /**
+     * Takes over as the active source immediately -- e.g., for an operator-
+     * commanded switchover. Constructs the `Shipping` instance, enables its
+     * durable transmit-queue if one was set, and calls the takeover
+     * observer. No-op if this node already took over. The previous active
+     * must not transmit again: two simultaneous sources corrupt the
+     * sequence.
+     * @exceptionsafety  Basic guarantee
+     * @threadsafety     Safe
+     */
+    void takeover() const;
+
+    /**
+     * Indicates if this node has taken over as the active source.
+     * @retval `true`    Iff this node is now the active source
+     * @exceptionsafety  Nothrow
+     * @threadsafety     Safe
+     */
+    bool isActive() const noexcept;
+};
+
+} // namespace
+
+#endif /* MAIN_COMMS_STANDBY_H_ */
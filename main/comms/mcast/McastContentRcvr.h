@@ -18,6 +18,7 @@
 #include "ProdInfo.h"
 
 #include <memory>
+#include <vector>
 
 namespace hycast {
 
@@ -34,6 +35,34 @@ public:
      * @param[in]     chunk  Chunk-of-data
      */
     virtual void receive(LatentChunk chunk) =0;
+    /**
+     * Receives a small, complete data-product as a single combined
+     * product-information and data message. The default implementation
+     * decomposes the message into a product-information reception and a
+     * data-chunk reception; a receiver backed by the product-store overrides
+     * it so the product costs a single store insertion.
+     * @param[in] smallProd  Small, complete data-product
+     */
+    virtual void receive(LatentSmallProd smallProd)
+    {
+        const ProdInfo    prodInfo = smallProd.getInfo();
+        std::vector<char> data(prodInfo.getSize());
+        smallProd.drainData(data.data(), data.size());
+        receive(prodInfo);
+        LatentChunk chunk{ChunkInfo{prodInfo, 0}, data.data()};
+        receive(chunk);
+        if (chunk.hasData())
+            chunk.discard();
+    }
+    /**
+     * Receives a report of data-chunks that a gap in the multicast datagram
+     * sequence numbers shows were lost, so repair can begin immediately
+     * instead of after a timeout. The default implementation ignores the
+     * report.
+     * @param[in] rangeSet  Identifiers of the missing chunks, as ranges
+     */
+    virtual void missed(const ChunkRangeSet& rangeSet)
+    {}
 };
 
 } // namespace
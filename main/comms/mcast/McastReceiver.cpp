@@ -15,7 +15,17 @@
 
 #include "Codec.h"
 #include "error.h"
+#include "MpmcQueue.h"
 #include "UdpSock.h"
+#include "Watchdog.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace hycast {
 
@@ -23,6 +33,13 @@ class McastReceiver::Impl final
 {
     class Dec : public Decoder
     {
+        /// Maximum number of datagrams per receive system call
+        static const unsigned recvBatchSize = 16;
+        /// Initial size, in bytes, of the adaptive receive buffer
+        static const int      initRcvBufSize = 4 << 20;
+        /// Ceiling, in bytes, on adaptive receive-buffer growth
+        static const int      maxRcvBufSize = 64 << 20;
+
         McastUdpSock  sock;
     protected:
         size_t read(
@@ -37,15 +54,38 @@ class McastReceiver::Impl final
             sock.discard();
         }
     public:
+        /*
+         * The local port is shared so that multiple receivers of the same
+         * multicast group can coexist in one host (or one process, as in the
+         * swarm-simulation benchmark): the kernel delivers a copy of each
+         * datagram to every member socket.
+         */
         explicit Dec(const InetSockAddr& mcastAddr)
             : Decoder{UdpSock::maxPayload}
-            , sock{McastUdpSock(mcastAddr)}
-        {}
+            , sock{McastUdpSock(mcastAddr, true)}
+        {
+            sock.setBatching(recvBatchSize);
+            /*
+             * Coalesces the MTU-sized trains that application-layer
+             * fragmentation generates; a no-op on kernels without UDP_GRO
+             */
+            sock.enableGro();
+            /*
+             * The receive buffer grows itself when the kernel's drop counter
+             * shows loss; also enables the telemetry that `checkDropCount()`
+             * reports
+             */
+            sock.enableAdaptiveRcvBuf(initRcvBufSize, maxRcvBufSize);
+        }
         Dec(    const InetSockAddr& mcastAddr,
                 const InetAddr&     srcAddr)
             : Decoder{UdpSock::maxPayload}
-            , sock{McastUdpSock(mcastAddr, srcAddr)}
-        {}
+            , sock{McastUdpSock(mcastAddr, srcAddr, true)}
+        {
+            sock.setBatching(recvBatchSize);
+            sock.enableGro();
+            sock.enableAdaptiveRcvBuf(initRcvBufSize, maxRcvBufSize);
+        }
         bool hasRecord()
         {
             return sock.hasRecord();
@@ -54,62 +94,901 @@ class McastReceiver::Impl final
         {
             return sock.getSize();
         }
+        /**
+         * Returns a view of the pending datagram directly from the socket's
+         * user-space batch buffer.
+         * @see InUdpSock::peek()
+         */
+        const char* peek(const size_t nbytes)
+        {
+            return static_cast<const char*>(sock.peek(nbytes));
+        }
+        /**
+         * Returns the kernel receive timestamp of the most recently received
+         * datagram.
+         * @return Kernel receive timestamp
+         */
+        struct timespec getRecvTimestamp() const noexcept
+        {
+            return sock.getRecvTimestamp();
+        }
+        /**
+         * Returns the kernel's cumulative count of datagrams dropped because
+         * the socket's receive buffer was full.
+         * @return Number of datagrams dropped by the kernel
+         */
+        unsigned long getDropCount() const noexcept
+        {
+            return sock.getDropCount();
+        }
+        /**
+         * Enables busy-polling reception on the underlying socket.
+         * @see InUdpSock::enableBusyPoll()
+         */
+        void enableBusyPoll(const unsigned spinMicros)
+        {
+            sock.enableBusyPoll(spinMicros);
+        }
+        /**
+         * Enables the experimental AF_XDP backend on the underlying socket.
+         * @see InUdpSock::enableXdp()
+         */
+        void enableXdp(
+                const std::string& ifaceName,
+                const unsigned     queueId)
+        {
+            sock.enableXdp(ifaceName, queueId);
+        }
+    };
+
+    /// The receive-state of a single forward-error-correction block
+    struct FecBlock
+    {
+        /// XOR of the data of the received chunks of the block
+        std::vector<char>                    acc;
+        /// Indexes of the received chunks of the block
+        std::unordered_set<ChunkIndex::type> rcvd;
+    };
+
+    /**
+     * The forward-error-correction receive-state of one processing thread.
+     * Only the open block -- the one whose parity message hasn't arrived
+     * yet -- is tracked: the sender adapts its block-size to reported loss,
+     * so a block's extent is known only from its parity message, which
+     * carries the block's first chunk-index and chunk-count.
+     */
+    struct FecState
+    {
+        /// Product whose FEC blocks are being tracked
+        ProdIndex        prodIndex;
+        /// Index of the first chunk of the open block
+        ChunkIndex::type firstIndex;
+        /// Receive-state of the open block
+        FecBlock         block;
+
+        FecState()
+            : prodIndex{}
+            , firstIndex{0}
+            , block{}
+        {}
+    };
+
+    /// The reassembly-state of one application-layer-fragmented data-chunk
+    struct FragChunk
+    {
+        /// Chunk data being reassembled
+        std::vector<char> data;
+        /// XOR of the received data fragments, each zero-padded to
+        /// `McastSender::fragDataSize`
+        std::vector<char> parityAcc;
+        /// Parity fragment, if received before the chunk completed
+        std::vector<char> parity;
+        /// Per-data-fragment received flags
+        std::vector<bool> rcvd;
+        /// Number of distinct data fragments received
+        unsigned          numRcvd;
+        /// Whether the parity fragment was received
+        bool              parityRcvd;
+
+        FragChunk()
+            : data{}
+            , parityAcc{}
+            , parity{}
+            , rcvd{}
+            , numRcvd{0}
+            , parityRcvd{false}
+        {}
+    };
+
+    /// The chunk-reassembly state of one processing thread
+    struct FragState
+    {
+        /// Product whose fragmented chunks are being reassembled
+        ProdIndex                                       prodIndex;
+        /// Reassembly-state of the product's chunks, by chunk-index
+        std::unordered_map<ChunkIndex::type, FragChunk> chunks;
+
+        FragState()
+            : prodIndex{}
+            , chunks{}
+        {}
+    };
+
+    /// A copy of a received datagram awaiting processing by a worker
+    typedef std::shared_ptr<std::vector<char>> Datagram;
+
+    /// Number of unprocessed datagrams a worker's queue can hold. When a
+    /// queue is full, the reading thread blocks, which applies backpressure
+    /// via the socket's receive buffer.
+    static const size_t workerQueueSize = 256;
+
+    /**
+     * A message-processing worker. In receive-side-scaling mode the thread
+     * that reads the socket only partitions messages -- by product-index --
+     * among the workers; the workers do the parsing and delivery. Because a
+     * product's messages all hash to the same worker, per-product state
+     * (such as FEC accumulation) stays thread-local and the workers touch
+     * disjoint product-store shards.
+     */
+    struct Worker
+    {
+        /// Queue of datagrams awaiting processing
+        MpmcQueue<Datagram> queue;
+        /// This worker's forward-error-correction receive-state
+        FecState            fecState;
+        /// This worker's chunk-reassembly state
+        FragState           fragState;
+        /// This worker's thread
+        std::thread         thread;
+
+        Worker()
+            : queue{workerQueueSize}
+            , fecState{}
+            , fragState{}
+            , thread{}
+        {}
     };
 
+    /// Maximum number of chunks whose repair one sequence gap may trigger.
+    /// A larger gap -- e.g., from a long receiver outage -- is left to the
+    /// usual recovery paths rather than flooding the peers with requests.
+    static const unsigned maxRepairChunks = 1024;
+
     Dec            decoder;
     McastContentRcvr*  msgRcvr;
     const unsigned version;
+    /// Number of bytes in the leading datagram sequence number. 0 =>
+    /// protocol version 0: no sequence numbers.
+    const size_t   seqNumSize;
+    /// Whether `expectedSeqNum` is valid. Set by the first datagram.
+    bool           haveSeqNum;
+    /// Sequence number expected on the next datagram
+    McastSender::SeqNumType expectedSeqNum;
+    /// Identifier of the chunk carried by the last in-sequence chunk-bearing
+    /// datagram. Invalid if sequence continuity has since been broken.
+    ChunkId        lastChunkId;
+    /// Nonzero => parity messages are processed. Block extents come from the
+    /// parity messages themselves, so this needn't match the sender's
+    /// loss-adaptive block-size.
+    const unsigned fecBlockSize;
+    /// FEC receive-state of the socket-reading thread. Used only when there
+    /// are no workers.
+    FecState       fecState;
+    /// Chunk-reassembly state of the socket-reading thread. Used only when
+    /// there are no workers.
+    FragState      fragState;
+    /// Message-processing workers or empty for processing on the reading
+    /// thread
+    std::vector<std::unique_ptr<Worker>> workers;
+    /// Serializes access to `exception`
+    std::mutex        exMutex;
+    /// Exception thrown by a worker
+    std::exception_ptr exception;
+    /// Kernel drop-count at the last check
+    unsigned long     numDropped;
+
+    /**
+     * Delivers a chunk-of-data that resides in memory to the multicast content
+     * receiver as a latent chunk.
+     * @param[in] chunkInfo  Information on the chunk
+     * @param[in] data       Chunk data
+     */
+    void deliver(
+            const ChunkInfo& chunkInfo,
+            const char*      data)
+    {
+        // A memory-backed chunk drains with a single copy directly into the
+        // product's storage -- no re-serialization through a staging buffer
+        LatentChunk chunk{chunkInfo, data};
+        msgRcvr->receive(chunk);
+        if (chunk.hasData())
+            chunk.discard();
+    }
+
+    /**
+     * Receives a data-chunk in forward-error-correction mode. The chunk's data
+     * is accumulated into its FEC block before delivery so that a single lost
+     * chunk of the block can be reconstructed from the block's parity message.
+     * @param[in] chunk     Latent data-chunk
+     * @param[in] fecState  FEC receive-state of the calling thread
+     */
+    void receiveAndAccumulate(
+            LatentChunk& chunk,
+            FecState&    fecState)
+    {
+        const size_t      chunkSize = chunk.getSize();
+        std::vector<char> data(chunkSize);
+        if (chunk.drainData(data.data(), chunkSize) != chunkSize)
+            return; // Corrupt chunk: don't poison the FEC accumulator
+        accumulate(chunk.getInfo(), data.data(), chunkSize, fecState);
+        deliver(chunk.getInfo(), data.data());
+    }
+
+    /**
+     * Accumulates the data of a received chunk into the chunk's FEC block.
+     * @param[in] chunkInfo  Information on the chunk
+     * @param[in] data       Chunk data
+     * @param[in] chunkSize  Number of bytes in `data`
+     * @param[in] fecState   FEC receive-state of the calling thread
+     */
+    void accumulate(
+            const ChunkInfo& chunkInfo,
+            const char*      data,
+            const size_t     chunkSize,
+            FecState&        fecState)
+    {
+        if (chunkInfo.getProdIndex() != fecState.prodIndex) {
+            // Sender has moved on to a new product
+            fecState.prodIndex = chunkInfo.getProdIndex();
+            fecState.firstIndex = 0;
+            fecState.block.acc.clear();
+            fecState.block.rcvd.clear();
+        }
+        const ChunkIndex::type chunkIndex = chunkInfo.getIndex();
+        if (chunkIndex < fecState.firstIndex)
+            return; // Late chunk of an already-closed block
+        auto& block = fecState.block;
+        /*
+         * A duplicated datagram (normal for UDP) must be a no-op: XORing the
+         * same chunk in twice cancels it out of the accumulator, which would
+         * make a later reconstruction silently corrupt.
+         */
+        if (!block.rcvd.insert(chunkIndex).second)
+            return;
+        if (block.acc.size() < chunkSize)
+            block.acc.resize(chunkSize, 0);
+        for (size_t i = 0; i < chunkSize; ++i)
+            block.acc[i] ^= data[i];
+    }
+
+    /**
+     * Acts upon the parity message of a forward-error-correction block,
+     * whose extent it carries. If the message closes the open block and
+     * exactly one of the block's chunks wasn't received, then the chunk is
+     * reconstructed from the parity and the received chunks and delivered to
+     * the multicast content receiver. A parity message whose block doesn't
+     * match the open one -- e.g., because an earlier parity message was lost
+     * -- only resynchronizes the state: repair of its block is left to the
+     * peer-to-peer network.
+     * @param[in] prodInfo    Information on the relevant data-product. The
+     *                        product name will be empty.
+     * @param[in] firstIndex  Index of the first chunk of the block
+     * @param[in] numChunks   Number of chunks in the block
+     * @param[in] parity      XOR of the data of the chunks of the block
+     * @param[in] fecState    FEC receive-state of the calling thread
+     */
+    void reconstruct(
+            const ProdInfo&        prodInfo,
+            const ChunkIndex::type firstIndex,
+            const unsigned         numChunks,
+            std::vector<char>&     parity,
+            FecState&              fecState)
+    {
+        if (prodInfo.getIndex() != fecState.prodIndex)
+            return; // No receive-state for this product
+        const ChunkIndex::type endIndex = firstIndex + numChunks;
+        if (endIndex <= fecState.firstIndex)
+            return; // Stale (duplicate or reordered) parity message
+        auto& block = fecState.block;
+        if (firstIndex == fecState.firstIndex) {
+            unsigned         numMissing{0};
+            ChunkIndex::type missing{0};
+            for (ChunkIndex::type index = firstIndex; index < endIndex;
+                    ++index) {
+                if (block.rcvd.count(index) == 0) {
+                    missing = index;
+                    ++numMissing;
+                }
+            }
+            /*
+             * A chunk of the *next* block that arrived before this parity
+             * message poisons the accumulator for this block, so
+             * reconstruction is skipped. The chunk's data is dropped with
+             * the accumulator below; the next block will count it missing
+             * and any duplicate reconstruction is harmless.
+             */
+            bool accClean = true;
+            for (const auto index : block.rcvd) {
+                if (index >= endIndex) {
+                    accClean = false;
+                    break;
+                }
+            }
+            if (numMissing == 1 && accClean) {
+                const auto size = std::min(parity.size(), block.acc.size());
+                for (size_t i = 0; i < size; ++i)
+                    parity[i] ^= block.acc[i];
+                ChunkInfo chunkInfo{prodInfo, ChunkIndex{missing}};
+                LOG_DEBUG("Reconstructed chunk " +
+                        chunkInfo.getId().to_string() + " from FEC parity");
+                deliver(chunkInfo, parity.data());
+            }
+        }
+        // Open the next block
+        fecState.firstIndex = endIndex;
+        block.acc.clear();
+        block.rcvd.clear();
+    }
+
+    /**
+     * Delivers a completely-reassembled data-chunk: accumulates it into its
+     * FEC block, if parity messages are enabled, hands it to the multicast
+     * content receiver, and deletes its reassembly-state.
+     * @param[in] chunkInfo  Information on the chunk
+     * @param[in] fragState  Chunk-reassembly state of the calling thread
+     * @param[in] fecState   FEC receive-state of the calling thread
+     */
+    void deliverReassembled(
+            const ChunkInfo& chunkInfo,
+            FragState&       fragState,
+            FecState&        fecState)
+    {
+        const ChunkIndex::type chunkIndex = chunkInfo.getIndex();
+        auto&                  entry = fragState.chunks[chunkIndex];
+        if (fecBlockSize)
+            accumulate(chunkInfo, entry.data.data(), entry.data.size(),
+                    fecState);
+        deliver(chunkInfo, entry.data.data());
+        fragState.chunks.erase(chunkIndex);
+    }
+
+    /**
+     * Receives one fragment of an application-layer-fragmented data-chunk.
+     * The chunk is delivered as soon as all its data fragments -- or all but
+     * one of them plus the parity fragment -- have arrived; a single lost
+     * fragment is reconstructed by XORing the parity fragment with the
+     * received data fragments. A chunk that loses two or more fragments is
+     * never delivered and is recovered by the usual repair paths.
+     * @param[in] chunkInfo  Information on the fragment's chunk
+     * @param[in] fragIndex  Origin-0 index of the fragment.
+     *                       `numFrags` denotes the parity fragment.
+     * @param[in] numFrags   Number of data fragments in the chunk
+     * @param[in] frag       Fragment data
+     * @param[in] fragLen    Number of bytes in `frag`
+     * @param[in] fragState  Chunk-reassembly state of the calling thread
+     * @param[in] fecState   FEC receive-state of the calling thread
+     */
+    void receiveFragment(
+            const ChunkInfo& chunkInfo,
+            const uint16_t   fragIndex,
+            const uint16_t   numFrags,
+            const char*      frag,
+            const size_t     fragLen,
+            FragState&       fragState,
+            FecState&        fecState)
+    {
+        if (fragIndex > numFrags || numFrags == 0)
+            return; // Corrupt fragment header
+        if (chunkInfo.getProdIndex() != fragState.prodIndex) {
+            fragState.chunks.clear(); // Sender has moved on to a new product
+            fragState.prodIndex = chunkInfo.getProdIndex();
+        }
+        const ChunkIndex::type chunkIndex = chunkInfo.getIndex();
+        auto&                  entry = fragState.chunks[chunkIndex];
+        if (entry.data.empty()) {
+            entry.data.resize(chunkInfo.getSize());
+            entry.parityAcc.assign(McastSender::fragDataSize, 0);
+            entry.rcvd.assign(numFrags, false);
+        }
+        if (fragIndex == numFrags) { // Parity fragment
+            entry.parity.assign(frag, frag + fragLen);
+            entry.parityRcvd = true;
+        }
+        else if (!entry.rcvd[fragIndex]) {
+            const size_t offset = fragIndex*McastSender::fragDataSize;
+            const size_t len = std::min(fragLen, entry.data.size() - offset);
+            std::copy(frag, frag + len, entry.data.begin() + offset);
+            for (size_t i = 0; i < len; ++i)
+                entry.parityAcc[i] ^= frag[i];
+            entry.rcvd[fragIndex] = true;
+            ++entry.numRcvd;
+        }
+        if (entry.numRcvd == numFrags) {
+            deliverReassembled(chunkInfo, fragState, fecState);
+        }
+        else if (entry.parityRcvd && entry.numRcvd + 1 == numFrags) {
+            uint16_t missing = 0;
+            while (entry.rcvd[missing])
+                ++missing;
+            const size_t offset = missing*McastSender::fragDataSize;
+            const size_t len = std::min(entry.parity.size(),
+                    entry.data.size() - offset);
+            for (size_t i = 0; i < len; ++i)
+                entry.data[offset+i] = entry.parity[i] ^ entry.parityAcc[i];
+            LOG_DEBUG("Reconstructed fragment " + std::to_string(missing) +
+                    " of chunk " + chunkInfo.getId().to_string() +
+                    " from fragment parity");
+            deliverReassembled(chunkInfo, fragState, fecState);
+        }
+    }
+
+    /**
+     * Sets the exception to be thrown by the socket-reading thread. Keeps the
+     * first exception if more than one is set.
+     * @param[in] ex  Exception thrown by a worker
+     */
+    void setException(const std::exception_ptr ex)
+    {
+        std::lock_guard<std::mutex> lock{exMutex};
+        if (!exception)
+            exception = ex;
+    }
+
+    /**
+     * Throws the exception set by a worker, if one exists.
+     */
+    void throwIfException()
+    {
+        std::lock_guard<std::mutex> lock{exMutex};
+        if (exception)
+            std::rethrow_exception(exception);
+    }
+
+    /**
+     * Returns the identifier of the data-chunk carried by the pending
+     * message or an invalid identifier if the message doesn't carry one
+     * (e.g., product-information and parity messages).
+     * Keep consistent with `dispatch()`.
+     * @param[in] decoder  Decoder positioned at the start of the message
+     *                     (after the sequence number)
+     * @return             Identifier of the message's chunk
+     */
+    ChunkId getChunkId(Decoder& decoder)
+    {
+        McastSender::MsgIdType msgId;
+        decoder.fill(sizeof(msgId));
+        decoder.decode(msgId);
+        switch (msgId) {
+            case McastSender::chunkMsgId: {
+                // The chunk's identifier leads its metadata
+                decoder.fill(LatentChunk::getMetadataSize(version));
+                return ChunkId::deserialize(decoder, version);
+            }
+            case McastSender::chunkFragMsgId: {
+                decoder.fill(McastSender::getFragMetadataSize(version));
+                auto prodIndex = ProdIndex::deserialize(decoder, version);
+                ProdSize::deserialize(decoder, version);
+                ChunkSize::deserialize(decoder, version);
+                auto chunkIndex = ChunkIndex::deserialize(decoder, version);
+                return ChunkId{prodIndex, chunkIndex};
+            }
+            case McastSender::smallProdMsgId: {
+                // The message carries the product's only chunk
+                decoder.fill(0);
+                const auto prodInfo = ProdInfo::deserialize(decoder, version);
+                return ChunkInfo{prodInfo, 0}.getId();
+            }
+            default:
+                return ChunkId{};
+        }
+    }
+
+    /**
+     * Reports the chunks that a sequence gap shows were lost so peer-to-peer
+     * repair of them begins immediately. The missing chunks are bracketed by
+     * the last in-sequence chunk and the chunk of the datagram that revealed
+     * the gap; a gap that spans a product boundary -- or whose flanking
+     * datagrams don't both carry chunks -- is left to the usual recovery
+     * paths because its extent can't be inferred.
+     * @param[in] numLost     Number of lost datagrams
+     * @param[in] curChunkId  Identifier of the chunk carried by the datagram
+     *                        that revealed the gap or an invalid identifier
+     *                        if it doesn't carry one
+     */
+    void reportMissing(
+            const uint32_t numLost,
+            const ChunkId& curChunkId)
+    {
+        LOG_INFO("Multicast sequence gap: " + std::to_string(numLost) +
+                " datagram(s) lost in the network");
+        if (!lastChunkId || !curChunkId ||
+                curChunkId.getProdIndex() != lastChunkId.getProdIndex())
+            return; // Extent of the loss can't be inferred
+        const ChunkIndex::type firstIndex =
+                static_cast<ChunkIndex::type>(lastChunkId.getChunkIndex()) + 1;
+        const ChunkIndex::type endIndex =
+                static_cast<ChunkIndex::type>(curChunkId.getChunkIndex());
+        if (endIndex <= firstIndex)
+            return; // Fragments of the same chunk were lost: parity repairs
+        if (endIndex - firstIndex > maxRepairChunks)
+            return; // Too large to pre-request
+        ChunkRangeSet rangeSet{};
+        for (ChunkIndex::type index = firstIndex; index < endIndex; ++index)
+            rangeSet.add(ChunkId{lastChunkId.getProdIndex(),
+                    ChunkIndex{index}});
+        msgRcvr->missed(rangeSet);
+    }
+
+    /**
+     * Handles the per-sender sequence number of an arriving datagram. On a
+     * gap -- the sender emitted datagrams that never arrived -- the missing
+     * chunks are immediately reported for peer-to-peer repair, so repair
+     * latency is set by the inter-packet gap instead of by a timeout. A
+     * backward jump (a reordered datagram or a restarted sender) merely
+     * resynchronizes the expected sequence.
+     * @param[in] seqNum      Sequence number of the arriving datagram
+     * @param[in] curChunkId  Identifier of the chunk the datagram carries or
+     *                        an invalid identifier if it doesn't carry one
+     */
+    void checkSeqNum(
+            const McastSender::SeqNumType seqNum,
+            const ChunkId&                curChunkId)
+    {
+        if (!haveSeqNum) {
+            haveSeqNum = true; // First datagram of the session
+        }
+        else if (seqNum != expectedSeqNum) {
+            // Modular arithmetic distinguishes a gap from a backward jump
+            const uint32_t numLost = seqNum - expectedSeqNum;
+            if (numLost < UINT32_MAX/2)
+                reportMissing(numLost, curChunkId);
+            lastChunkId = ChunkId{}; // Sequence continuity was broken
+        }
+        expectedSeqNum = seqNum + 1;
+        if (curChunkId)
+            lastChunkId = curChunkId;
+    }
+
+    /**
+     * Runs a message-processing worker. Processes datagrams from the worker's
+     * queue until an empty datagram -- the shutdown sentinel -- arrives.
+     * Intended to run on the worker's thread.
+     * @param[in] worker  Worker to run
+     */
+    void runWorker(Worker* const worker)
+    {
+        try {
+            auto heartbeat = Watchdog::registerThread("mcast-worker");
+            for (;;) {
+                heartbeat.park(); // An empty queue isn't a stall
+                auto datagram = worker->queue.pop();
+                heartbeat.beat();
+                if (!datagram)
+                    break; // Shutdown sentinel
+                MemDecoder memDecoder{datagram->data(), datagram->size()};
+                dispatch(memDecoder, worker->fecState, worker->fragState);
+            }
+        }
+        catch (const std::exception& e) {
+            setException(std::current_exception());
+        }
+    }
+
+    /**
+     * Starts the message-processing workers.
+     * @param[in] numWorkers  Number of workers to start
+     */
+    void startWorkers(const unsigned numWorkers)
+    {
+        workers.reserve(numWorkers);
+        for (unsigned i = 0; i < numWorkers; ++i) {
+            workers.emplace_back(new Worker{});
+            auto worker = workers.back().get();
+            worker->thread = std::thread{&Impl::runWorker, this, worker};
+        }
+    }
 
 public:
     Impl(   const InetSockAddr& mcastAddr,
             McastContentRcvr&       msgRcvr,
-            const unsigned      version)
+            const unsigned      version,
+            const unsigned      fecBlockSize,
+            const unsigned      numWorkers)
         : decoder(mcastAddr)
         , msgRcvr(&msgRcvr)
         , version{version}
-    {}
+        , seqNumSize{McastSender::getSeqNumSize(version)}
+        , haveSeqNum{false}
+        , expectedSeqNum{0}
+        , lastChunkId{}
+        , fecBlockSize{fecBlockSize}
+        , fecState{}
+        , fragState{}
+        , workers{}
+        , exMutex{}
+        , exception{}
+        , numDropped{0}
+    {
+        startWorkers(numWorkers);
+    }
 
     Impl(   const InetSockAddr& mcastAddr,
             const InetAddr&     srcAddr,
             McastContentRcvr&       msgRcvr,
-            const unsigned      version)
+            const unsigned      version,
+            const unsigned      fecBlockSize,
+            const unsigned      numWorkers)
         : decoder{mcastAddr, srcAddr}
         , msgRcvr{&msgRcvr}
         , version{version}
-    {}
+        , seqNumSize{McastSender::getSeqNumSize(version)}
+        , haveSeqNum{false}
+        , expectedSeqNum{0}
+        , lastChunkId{}
+        , fecBlockSize{fecBlockSize}
+        , fecState{}
+        , fragState{}
+        , workers{}
+        , exMutex{}
+        , exception{}
+        , numDropped{0}
+    {
+        startWorkers(numWorkers);
+    }
+
+    ~Impl()
+    {
+        for (auto& worker : workers)
+            worker->queue.push(Datagram{}); // Shutdown sentinel
+        for (auto& worker : workers) {
+            if (worker->thread.joinable())
+                worker->thread.join();
+        }
+    }
+
+    /**
+     * Logs any increase in the kernel's count of datagrams that were dropped
+     * because the socket's receive buffer was full. Such loss happens in this
+     * host rather than in the network, so it's reported distinctly.
+     */
+    void checkDropCount()
+    {
+        const auto dropped = decoder.getDropCount();
+        if (dropped != numDropped) {
+            LOG_WARN("Kernel dropped " + std::to_string(dropped - numDropped) +
+                    " multicast datagram(s) because the socket's receive "
+                    "buffer was full (" + std::to_string(dropped) +
+                    " since startup)");
+            numDropped = dropped;
+        }
+    }
+
+    /**
+     * Returns the product-index of the pending message, by which messages
+     * are partitioned among the workers.
+     * Keep consistent with `dispatch()`.
+     * @param[in] decoder  Decoder positioned at the start of the message
+     * @return             Product-index of the message
+     */
+    ProdIndex getPartitionIndex(Decoder& decoder)
+    {
+        McastSender::MsgIdType msgId;
+        decoder.fill(sizeof(msgId));
+        decoder.decode(msgId);
+        switch (msgId) {
+            case McastSender::prodInfoMsgId: {
+                decoder.fill(0);
+                return ProdInfo::deserialize(decoder, version).getIndex();
+            }
+            case McastSender::chunkMsgId: {
+                // The chunk's identifier leads its metadata
+                decoder.fill(LatentChunk::getMetadataSize(version));
+                return ChunkId::deserialize(decoder, version).getProdIndex();
+            }
+            case McastSender::fecMsgId: {
+                decoder.fill(McastSender::getFecMetadataSize(version));
+                return ProdIndex::deserialize(decoder, version);
+            }
+            case McastSender::chunkFragMsgId: {
+                // The product-index leads the fragment's metadata
+                decoder.fill(McastSender::getFragMetadataSize(version));
+                return ProdIndex::deserialize(decoder, version);
+            }
+            case McastSender::smallProdMsgId: {
+                // The product-information leads the data
+                decoder.fill(0);
+                return ProdInfo::deserialize(decoder, version).getIndex();
+            }
+            default:
+                throw RUNTIME_ERROR("Invalid message type: " +
+                        std::to_string(msgId));
+        }
+    }
+
+    /**
+     * Dispatches on the type of the pending message and delivers its content.
+     * The message *must* be completely consumed from the given decoder.
+     * @param[in] decoder   Decoder positioned at the start of the message
+     * @param[in] fecState  FEC receive-state of the calling thread
+     */
+    void dispatch(
+            Decoder&   decoder,
+            FecState&  fecState,
+            FragState& fragState)
+    {
+        // Keep consistent with McastSender::send(Product)
+        McastSender::MsgIdType msgId;
+        decoder.fill(sizeof(msgId));
+        decoder.decode(msgId);
+        switch (msgId) {
+            /*
+             * NB: In all the following, the input message *must* be
+             * completely consumed; otherwise, its tail might be read in the
+             * next iteration.
+             */
+            case McastSender::prodInfoMsgId: {
+                decoder.fill(0);
+                auto prodInfo = ProdInfo::deserialize(decoder, version);
+                msgRcvr->receive(prodInfo);
+                break;
+            }
+            case McastSender::chunkMsgId: {
+                decoder.fill(LatentChunk::getMetadataSize(version));
+                auto chunk = LatentChunk::deserialize(decoder, version);
+                if (fecBlockSize) {
+                    receiveAndAccumulate(chunk, fecState);
+                }
+                else {
+                    msgRcvr->receive(chunk);
+                }
+                if (chunk.hasData())
+                    throw LOGIC_ERROR("Latent chunk-of-data not drained");
+                break;
+            }
+            case McastSender::chunkFragMsgId: {
+                decoder.fill(McastSender::getFragMetadataSize(version));
+                auto     fragProdIndex = ProdIndex::deserialize(decoder,
+                        version);
+                auto     fragProdSize = ProdSize::deserialize(decoder,
+                        version);
+                auto     fragCanonSize = ChunkSize::deserialize(decoder,
+                        version);
+                auto     chunkIndex = ChunkIndex::deserialize(decoder,
+                        version);
+                uint16_t fragIndex;
+                uint16_t numFrags;
+                decoder.decode(fragIndex);
+                decoder.decode(numFrags);
+                const auto        fragLen = decoder.numRemainingBytes();
+                std::vector<char> frag(fragLen);
+                decoder.decode(frag.data(), fragLen);
+                ProdInfo  prodInfo{fragProdIndex, fragProdSize,
+                        fragCanonSize};
+                ChunkInfo chunkInfo{prodInfo, chunkIndex};
+                receiveFragment(chunkInfo, fragIndex, numFrags, frag.data(),
+                        fragLen, fragState, fecState);
+                break;
+            }
+            case McastSender::smallProdMsgId: {
+                decoder.fill(0);
+                auto smallProd = LatentSmallProd::deserialize(decoder,
+                        version);
+                msgRcvr->receive(smallProd);
+                if (smallProd.hasData())
+                    throw LOGIC_ERROR("Latent small product not drained");
+                break;
+            }
+            case McastSender::fecMsgId: {
+                decoder.fill(McastSender::getFecMetadataSize(version));
+                auto     prodIndex = ProdIndex::deserialize(decoder,
+                        version);
+                auto     prodSize = ProdSize::deserialize(decoder, version);
+                auto     canonSize = ChunkSize::deserialize(decoder,
+                        version);
+                auto     firstIndex = ChunkIndex::deserialize(decoder,
+                        version);
+                uint16_t numChunks;
+                decoder.decode(numChunks);
+                const auto        parityLen = decoder.numRemainingBytes();
+                std::vector<char> parity(parityLen);
+                decoder.decode(parity.data(), parityLen);
+                if (fecBlockSize) {
+                    ProdInfo prodInfo{prodIndex, prodSize, canonSize};
+                    reconstruct(prodInfo, firstIndex, numChunks, parity,
+                            fecState);
+                }
+                break;
+            }
+            default:
+                throw RUNTIME_ERROR("Invalid message type: " +
+                        std::to_string(msgId));
+        }
+    }
+
+    void enableBusyPoll(const unsigned spinMicros)
+    {
+        decoder.enableBusyPoll(spinMicros);
+    }
+
+    void enableXdp(
+            const std::string& ifaceName,
+            const unsigned     queueId)
+    {
+        decoder.enableXdp(ifaceName, queueId);
+    }
 
     void operator ()()
     {
+        auto heartbeat = Watchdog::registerThread("mcast-receiver");
         for (;;) {
-            // Keep consistent with McastSender::send(Product)
-            McastSender::MsgIdType msgId;
-            decoder.fill(sizeof(msgId));
-            decoder.decode(msgId);
-            switch (msgId) {
-                /*
-                 * NB: In all the following, the input message *must* be
-                 * completely consumed; otherwise, its tail might be read in the
-                 * next iteration.
-                 */
-                case McastSender::prodInfoMsgId: {
-                    decoder.fill(0);
-                    auto prodInfo = ProdInfo::deserialize(decoder, version);
-                    msgRcvr->receive(prodInfo);
-                    break;
+            if (!workers.empty())
+                throwIfException();
+            heartbeat.park(); // Waiting for a datagram isn't a stall
+            /*
+             * One-pass fast path: when the socket holds the whole datagram in
+             * a user-space batch buffer, the message type and metadata are
+             * parsed in place and the payload bytes go straight from that
+             * buffer to their final destination -- no staging through, and
+             * repeated peek-reads of, the serial buffer.
+             */
+            const char* msg = decoder.peek(seqNumSize +
+                    sizeof(McastSender::MsgIdType));
+            heartbeat.beat(); // A datagram arrived
+            if (msg) {
+                size_t size = decoder.getSize();
+                if (seqNumSize) {
+                    /*
+                     * Sequence checking happens here, on the socket-reading
+                     * thread, because datagrams must be examined in arrival
+                     * order; the workers process them concurrently. The
+                     * sequence number is then stripped so the message-parsing
+                     * paths are version-layout agnostic.
+                     */
+                    MemDecoder seqDecoder{msg, size};
+                    seqDecoder.fill(seqNumSize);
+                    McastSender::SeqNumType seqNum;
+                    seqDecoder.decode(seqNum);
+                    MemDecoder idDecoder{msg + seqNumSize, size - seqNumSize};
+                    checkSeqNum(seqNum, getChunkId(idDecoder));
+                    msg += seqNumSize;
+                    size -= seqNumSize;
                 }
-                case McastSender::chunkMsgId: {
-                    decoder.fill(LatentChunk::getMetadataSize(version));
-                    auto chunk = LatentChunk::deserialize(decoder, version);
-                    msgRcvr->receive(chunk);
-                    if (chunk.hasData())
-                        throw LOGIC_ERROR("Latent chunk-of-data not drained");
-                    break;
+                if (workers.empty()) {
+                    MemDecoder memDecoder{msg, size};
+                    dispatch(memDecoder, fecState, fragState);
                 }
-                default:
-                    throw RUNTIME_ERROR("Invalid message type: " +
-                            std::to_string(msgId));
+                else {
+                    /*
+                     * Receive-side scaling: this thread only copies the
+                     * datagram and partitions it by product-index; a worker
+                     * parses and delivers it. All of a product's messages go
+                     * to the same worker, so the workers touch disjoint
+                     * product-store shards and FEC state stays thread-local.
+                     */
+                    MemDecoder memDecoder{msg, size};
+                    const auto prodIndex = getPartitionIndex(memDecoder);
+                    auto       datagram = std::make_shared<std::vector<char>>(
+                            msg, msg + size);
+                    workers[static_cast<ProdIndex::type>(prodIndex) %
+                            workers.size()]->queue.push(datagram);
+                }
+            }
+            else {
+                if (seqNumSize) {
+                    /*
+                     * The datagram can't be peeked, so the chunks a gap
+                     * brackets can't be identified; the sequence is still
+                     * tracked so the loss is detected and logged.
+                     */
+                    decoder.fill(seqNumSize);
+                    McastSender::SeqNumType seqNum;
+                    decoder.decode(seqNum);
+                    checkSeqNum(seqNum, ChunkId{});
+                }
+                dispatch(decoder, fecState, fragState);
             }
-            decoder.clear();
+            decoder.clear(); // Consumes the message in both paths
+            checkDropCount();
         }
     }
 };
@@ -117,18 +996,35 @@ public:
 McastReceiver::McastReceiver(
         const InetSockAddr& mcastAddr,
         McastContentRcvr&       msgRcvr,
-        const unsigned      version)
-    : pImpl{new Impl(mcastAddr, msgRcvr, version)}
+        const unsigned      version,
+        const unsigned      fecBlockSize,
+        const unsigned      numWorkers)
+    : pImpl{new Impl(mcastAddr, msgRcvr, version, fecBlockSize, numWorkers)}
 {}
 
 McastReceiver::McastReceiver(
         const InetSockAddr& mcastAddr,
         const InetAddr&     srcAddr,
         McastContentRcvr&       msgRcvr,
-        const unsigned      version)
-    : pImpl{new Impl(mcastAddr, srcAddr, msgRcvr, version)}
+        const unsigned      version,
+        const unsigned      fecBlockSize,
+        const unsigned      numWorkers)
+    : pImpl{new Impl(mcastAddr, srcAddr, msgRcvr, version, fecBlockSize,
+            numWorkers)}
 {}
 
+void McastReceiver::enableBusyPoll(const unsigned spinMicros) const
+{
+    pImpl->enableBusyPoll(spinMicros);
+}
+
+void McastReceiver::enableXdp(
+        const std::string& ifaceName,
+        const unsigned     queueId) const
+{
+    pImpl->enableXdp(ifaceName, queueId);
+}
+
 void McastReceiver::operator ()()
 {
     pImpl->operator()();
@@ -28,6 +28,14 @@ struct SrcMcastInfo final
 	InetAddr     srcAddr;   /// Internet address of multicast source
 };
 
+/**
+ * Receiver of multicast datagrams. With protocol version 1 and later, every
+ * datagram carries a per-sender sequence number: a gap in the sequence is
+ * detected on the very next arrival and the chunks it brackets are
+ * immediately reported through `McastContentRcvr::missed()` for peer-to-peer
+ * repair, instead of the loss being discovered by product-completion
+ * timeouts.
+ */
 class McastReceiver
 {
     class                 Impl;
@@ -36,15 +44,27 @@ class McastReceiver
 public:
     /**
      * Constructs a source-independent multicast receiver.
-     * @param[in] mcastAddr  Multicast group socket address
-     * @param[in] msgRcvr    Receiver of multicast messages. Must exist for the
-     *                       duration of the constructed instance.
-     * @param[in] version    Protocol version
+     * @param[in] mcastAddr     Multicast group socket address
+     * @param[in] msgRcvr       Receiver of multicast messages. Must exist for
+     *                          the duration of the constructed instance.
+     * @param[in] version       Protocol version
+     * @param[in] fecBlockSize  Nonzero to process forward-error-correction
+     *                          parity messages or 0 to ignore them. A block's
+     *                          extent is carried by its parity message, so
+     *                          the sender's loss-adaptive block-size needn't
+     *                          be known.
+     * @param[in] numWorkers    Number of message-processing worker threads or
+     *                          0 to process messages on the thread that reads
+     *                          the socket. Messages are partitioned among the
+     *                          workers by product-index, so each worker
+     *                          touches disjoint product-store shards.
      */
     McastReceiver(
             const InetSockAddr& mcastAddr,
             McastContentRcvr&       msgRcvr,
-            const unsigned      version);
+            const unsigned      version,
+            const unsigned      fecBlockSize = 0,
+            const unsigned      numWorkers = 0);
 
     /**
      * Constructs an any-source multicast receiver.
@@ -54,12 +74,24 @@ public:
      * @param[in] msgRcvr    Receiver of multicast messages. Must exist for the
      *                       duration of the constructed instance.
      * @param[in] version    Protocol version
+     * @param[in] fecBlockSize  Nonzero to process forward-error-correction
+     *                          parity messages or 0 to ignore them. A block's
+     *                          extent is carried by its parity message, so
+     *                          the sender's loss-adaptive block-size needn't
+     *                          be known.
+     * @param[in] numWorkers    Number of message-processing worker threads or
+     *                          0 to process messages on the thread that reads
+     *                          the socket. Messages are partitioned among the
+     *                          workers by product-index, so each worker
+     *                          touches disjoint product-store shards.
      */
     McastReceiver(
             const InetSockAddr& mcastAddr,
             const InetAddr&     srcAddr,
             McastContentRcvr&       msgRcvr,
-            const unsigned      version);
+            const unsigned      version,
+            const unsigned      fecBlockSize = 0,
+            const unsigned      numWorkers = 0);
 
     /**
      * Constructs a source-specific multicast receiver.
@@ -67,15 +99,55 @@ public:
      * @param[in] msgRcvr       Receiver of multicast messages. Must exist for
      *                          the duration of the constructed instance.
      * @param[in] version       Protocol version
+     * @param[in] fecBlockSize  Nonzero to process forward-error-correction
+     *                          parity messages or 0 to ignore them. A block's
+     *                          extent is carried by its parity message, so
+     *                          the sender's loss-adaptive block-size needn't
+     *                          be known.
+     * @param[in] numWorkers    Number of message-processing worker threads or
+     *                          0 to process messages on the thread that reads
+     *                          the socket. Messages are partitioned among the
+     *                          workers by product-index, so each worker
+     *                          touches disjoint product-store shards.
      */
     McastReceiver(
             const SrcMcastInfo& srcMcastInfo,
             McastContentRcvr&       msgRcvr,
-            const unsigned      version)
+            const unsigned      version,
+            const unsigned      fecBlockSize = 0,
+            const unsigned      numWorkers = 0)
     	: McastReceiver(srcMcastInfo.mcastAddr, srcMcastInfo.srcAddr, msgRcvr,
-    			version)
+    			version, fecBlockSize, numWorkers)
     {}
 
+    /**
+     * Enables busy-polling reception for latency-critical deployments: before
+     * blocking for a datagram, the receiving socket spins for the given
+     * budget, so a datagram that arrives within it is received without a
+     * scheduler wakeup. Burns a core while spinning: the thread that runs
+     * `operator()()` should be pinned to a dedicated CPU via
+     * `Thread::setAffinity()`.
+     * @param[in] spinMicros  Spin budget in microseconds
+     * @throws InvalidArgument  `spinMicros == 0`
+     * @see InUdpSock::enableBusyPoll()
+     */
+    void enableBusyPoll(const unsigned spinMicros) const;
+
+    /**
+     * Enables the experimental AF_XDP receive backend for the highest-rate
+     * feeds: datagrams are delivered into user-space buffers by the kernel's
+     * XDP redirect path, bypassing the UDP stack and its per-packet cost.
+     * The NIC receive-queue should be dedicated to this feed via a
+     * flow-steering rule. Falls back to standard reception -- with a log
+     * message -- when AF_XDP isn't available.
+     * @param[in] ifaceName  Name of the network interface (e.g., "eth0")
+     * @param[in] queueId    NIC receive-queue to attach to
+     * @see InUdpSock::enableXdp()
+     */
+    void enableXdp(
+            const std::string& ifaceName,
+            const unsigned     queueId) const;
+
     /**
      * Runs the receiver. Receives multicast messages and forwards them to the
      * multicast message receiver. Doesn't return unless a zero-size datagram is
@@ -13,14 +13,48 @@
 #include "error.h"
 #include "Codec.h"
 #include "McastSender.h"
+#include "Thread.h"
+#include "Tunables.h"
 #include "UdpSock.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <list>
+#include <mutex>
+#include <utility>
+#include <vector>
+
 namespace hycast {
 
 class McastSender::Impl final
 {
+    typedef std::mutex              Mutex;
+    typedef std::lock_guard<Mutex>  LockGuard;
+    typedef std::unique_lock<Mutex> UniqueLock;
+    typedef std::condition_variable Cond;
+    typedef std::chrono::steady_clock Clock;
+
+    /// Default token-bucket capacity in maximum datagram-payloads
+    static const size_t defaultBurstSize = 8;
+    /// Seconds per loss-feedback epoch: the period at which the FEC
+    /// block-size is re-evaluated against reported receiver losses
+    static const unsigned fecEpochSecs = 10;
+    /// Ceiling on the adapted FEC block-size (i.e., floor on the
+    /// parity-to-data ratio when the network is quiet)
+    static const unsigned maxFecBlockSize = 256;
+    /// Default ceiling on the parity-to-data ratio -- the bandwidth budget
+    /// for parity messages
+    static constexpr double defaultMaxFecOverhead = 0.25;
+
     class Enc final : public Encoder
     {
+        /// Maximum number of datagrams per send system call
+        static const unsigned sendBatchSize = 8;
+
         OutUdpSock sock;
 
     protected:
@@ -35,11 +69,460 @@ class McastSender::Impl final
         Enc(const InetSockAddr& mcastAddr)
             : Encoder(UdpSock::maxPayload)
             , sock(mcastAddr)
+        {
+            sock.setBatching(sendBatchSize);
+        }
+
+        /**
+         * Transmits any datagrams staged by the socket.
+         */
+        void flushSock()
+        {
+            sock.flush();
+        }
+
+        /**
+         * Sets the Differentiated Services code-point on the socket.
+         * @param[in] dscp  Code-point in [0,63] (see RFC 2474)
+         */
+        void setDscp(const unsigned dscp)
+        {
+            sock.setDscp(dscp);
+        }
+    };
+
+    /**
+     * State of the forward-error-correction block being accumulated for one
+     * data-product. Each concurrently-transmitted product has its own
+     * instance because interleaving the chunks of different products would
+     * otherwise corrupt a shared accumulator.
+     */
+    struct FecState
+    {
+        /// XOR of the data of the chunks in the current FEC block
+        std::vector<char> buf;
+        /// Number of used bytes in `buf` (length of largest chunk in block)
+        size_t            len;
+        /// Number of chunks accumulated into the current FEC block
+        unsigned          numChunks;
+        /// Index of the first chunk in the current FEC block
+        ChunkIndex::type  firstIndex;
+
+        FecState()
+            : buf{}
+            , len{0}
+            , numChunks{0}
+            , firstIndex{0}
+        {}
+    };
+
+    /// A data-product queued for transmission by the fair scheduler
+    struct QueuedProd
+    {
+        /// Data-product being transmitted
+        Product    prod;
+        /// Index of the next chunk to be multicast
+        ChunkIndex nextIndex;
+        /// Scheduling weight. `priority+1` chunks are sent per turn.
+        unsigned   priority;
+        /// Product's FEC accumulator
+        FecState   fec;
+
+        QueuedProd()
+            : prod{}
+            , nextIndex{0}
+            , priority{0}
+            , fec{}
         {}
     };
 
-    Enc            encoder;
-    const unsigned version;
+    Enc               encoder;
+    const unsigned    version;
+    /// Sequence number of the next datagram. Unused by protocol version 0.
+    SeqNumType        seqNum;
+    /// Configured number of data-chunks per FEC block. 0 => no parity
+    /// messages.
+    const unsigned    fecBlockSize;
+    /// Current number of data-chunks per FEC block, re-derived each epoch by
+    /// the loss-feedback controller. Equals `fecBlockSize` until receiver
+    /// losses are reported. Unused if `fecBlockSize` is 0.
+    std::atomic<unsigned> curFecBlockSize;
+    /// Number of data-chunks multicast during the current feedback epoch
+    std::atomic<unsigned long> epochChunks;
+    /// Number of receiver chunk-losses reported during the current epoch
+    std::atomic<unsigned long> epochLosses;
+    /// Guards the loss-feedback epoch state
+    mutable Mutex     fecMutex;
+    /// Start of the current loss-feedback epoch
+    Clock::time_point epochStart;
+    /// Ceiling on the parity-to-data ratio -- the bandwidth budget for
+    /// parity messages
+    double            maxFecOverhead;
+    /// FEC state of the non-interleaved transmission paths
+    FecState          fec;
+    /// Guards the token-bucket state
+    mutable Mutex     mutex;
+    /// Signaled when the sending rate changes
+    Cond              cond;
+    /// Maximum sending rate in bytes per second. 0 => transmission isn't paced
+    double            rate;
+    /// Token-bucket capacity in bytes
+    const double      burst;
+    /// Number of bytes that may be sent immediately
+    double            tokens;
+    /// Time of the last token-bucket refill
+    Clock::time_point lastRefill;
+    /// Information on the product of the current streaming transmission.
+    /// Invalid if no streaming transmission is in progress.
+    ProdInfo          streamInfo;
+    /// Serializes datagram assembly, so a repair retransmission can run
+    /// concurrently with live transmission
+    mutable Mutex     txMutex;
+    /// Guards the fair-scheduler queue
+    mutable Mutex          queueMutex;
+    /// Signaled when a product is queued for the fair scheduler
+    Cond                   queueCond;
+    /// Products awaiting transmission by the fair scheduler
+    std::list<QueuedProd>  sendQueue;
+    /// Thread on which the fair scheduler runs. Started lazily.
+    Thread                 schedThread;
+    /// Exception that terminated the fair scheduler
+    std::exception_ptr     exception;
+    /// Called by the fair scheduler after a product is fully transmitted
+    std::function<void(const ProdInfo&)> txObserver;
+    /// Adjusts the sending rate at runtime. Deregistered on destruction, so
+    /// it must be declared after the state it adjusts.
+    Tunables::Handle       rateTunable;
+    /// Adjusts the parity bandwidth-budget at runtime
+    Tunables::Handle       overheadTunable;
+
+    /**
+     * Refills the token-bucket with the tokens that accrued since the last
+     * refill.
+     * @pre `mutex` is locked
+     */
+    void refill()
+    {
+        const auto now = Clock::now();
+        tokens = std::min(tokens +
+                rate*std::chrono::duration<double>(now - lastRefill).count(),
+                burst);
+        lastRefill = now;
+    }
+
+    /**
+     * Acquires permission to send a message. Blocks until the token-bucket
+     * contains as many tokens as the message has bytes. Returns immediately
+     * if transmission isn't paced. This is a cancellation point.
+     * @param[in] nbytes  Number of bytes in the message
+     */
+    void acquire(const size_t nbytes)
+    {
+        UniqueLock lock{mutex};
+        while (rate > 0) {
+            refill();
+            // A message larger than the bucket must still be sendable
+            if (tokens >= std::min(static_cast<double>(nbytes), burst)) {
+                tokens -= nbytes;
+                break;
+            }
+            const std::chrono::duration<double> shortfall{
+                    (nbytes - tokens)/rate};
+            Canceler canceler{};
+            cond.wait_for(lock, shortfall);
+        }
+    }
+
+    /**
+     * Encodes the per-sender sequence number that leads every datagram, so
+     * a receiver detects a lost datagram on the very next arrival. No-op for
+     * protocol version 0, whose datagrams don't carry one. Must be the first
+     * encode of each message.
+     */
+    void encodeSeqNum()
+    {
+        if (version > 0)
+            encoder.encode(seqNum++);
+    }
+
+    /**
+     * Multicasts the parity message of a product's current FEC block and
+     * resets the block.
+     * @param[in]     prodInfo  Information on the data-product being sent
+     * @param[in,out] fecState  Product's FEC state
+     */
+    void sendParity(
+            const ProdInfo& prodInfo,
+            FecState&       fecState)
+    {
+        acquire(getSeqNumSize(version) +
+                Codec::getSerialSize(sizeof(fecMsgId)) +
+                getFecMetadataSize(version) + fecState.len);
+        encodeSeqNum();
+        encoder.encode(fecMsgId);
+        prodInfo.getIndex().serialize(encoder, version);
+        prodInfo.getSize().serialize(encoder, version);
+        prodInfo.getChunkSize().serialize(encoder, version);
+        ChunkIndex{fecState.firstIndex}.serialize(encoder, version);
+        encoder.encode(static_cast<uint16_t>(fecState.numChunks));
+        encoder.encode(fecState.buf.data(), fecState.len);
+        encoder.flush();
+        fecState.firstIndex += fecState.numChunks;
+        fecState.numChunks = 0;
+        fecState.len = 0;
+        std::fill(fecState.buf.begin(), fecState.buf.end(), 0);
+        maybeAdjustFec();
+    }
+
+    /**
+     * Adjusts the FEC block-size if a loss-feedback epoch has elapsed.
+     * Invoked after each parity message and loss report, so the controller
+     * adds nothing to the per-chunk path. The parity-to-data ratio of a
+     * block is the reciprocal of its size, so the size is derived from the
+     * loss-rate observed during the epoch, floored by the parity
+     * bandwidth-budget, and relaxed gradually when the network is quiet.
+     */
+    void maybeAdjustFec()
+    {
+        LockGuard lock{fecMutex};
+        const auto now = Clock::now();
+        if (now - epochStart < std::chrono::seconds{fecEpochSecs})
+            return;
+        epochStart = now;
+        const auto numChunks = epochChunks.exchange(0);
+        const auto numLosses = epochLosses.exchange(0);
+        const auto curSize = curFecBlockSize.load();
+        unsigned   newSize = maxFecBlockSize;
+        if (numLosses > 0) {
+            // A block's parity repairs one loss, so blocks are sized to
+            // expect at most one loss each, with a 2x margin for clustering
+            const auto lossRate = std::min(1.0,
+                    static_cast<double>(numLosses)/
+                    std::max<unsigned long>(numChunks, 1));
+            newSize = static_cast<unsigned>(std::max(1.0, 1/(2*lossRate)));
+        }
+        // The bandwidth budget floors the block-size: parity bytes can't
+        // exceed `maxFecOverhead` times data bytes
+        newSize = std::max(newSize,
+                static_cast<unsigned>(std::ceil(1/maxFecOverhead)));
+        // Attack fast, relax slowly: protection rises at once on a loss
+        // spike but is shed by at most a factor of two per epoch
+        if (newSize > curSize)
+            newSize = std::min(newSize, 2*curSize);
+        newSize = std::min(newSize, maxFecBlockSize);
+        if (newSize != curSize) {
+            LOG_DEBUG("FEC block-size %u -> %u (%lu losses, %lu chunks)",
+                    curSize, newSize, numLosses, numChunks);
+            curFecBlockSize = newSize;
+        }
+    }
+
+    /**
+     * Accumulates a data-chunk into a product's current FEC block. Multicasts
+     * the block's parity message if the block is now complete.
+     * @param[in]     prodInfo  Information on the data-product being sent
+     * @param[in]     chunk     Data-chunk to be accumulated
+     * @param[in,out] fecState  Product's FEC state
+     */
+    void accumulate(
+            const ProdInfo&    prodInfo,
+            const ActualChunk& chunk,
+            FecState&          fecState)
+    {
+        const size_t dataLen = chunk.getSize();
+        auto         data = static_cast<const char*>(chunk.getData());
+        for (size_t i = 0; i < dataLen; ++i)
+            fecState.buf[i] ^= data[i];
+        if (dataLen > fecState.len)
+            fecState.len = dataLen;
+        if (++fecState.numChunks >= curFecBlockSize.load())
+            sendParity(prodInfo, fecState);
+    }
+
+    /**
+     * Resets a product's FEC state for a new data-product.
+     * @param[in]  prodInfo  Information on the data-product
+     * @param[out] fecState  FEC state to be reset
+     */
+    void resetFec(
+            const ProdInfo& prodInfo,
+            FecState&       fecState)
+    {
+        fecState.buf.assign(prodInfo.getChunkSize(), 0);
+        fecState.len = 0;
+        fecState.numChunks = 0;
+        fecState.firstIndex = 0;
+    }
+
+    /**
+     * Multicasts the metadata of a chunk-fragment message.
+     * @param[in] prodInfo   Information on the fragment's data-product
+     * @param[in] chunkIndex Index of the fragment's data-chunk
+     * @param[in] fragIndex  Origin-0 index of the fragment. `numFrags`
+     *                       denotes the parity fragment.
+     * @param[in] numFrags   Number of data fragments in the chunk
+     */
+    void encodeFragMetadata(
+            const ProdInfo&  prodInfo,
+            const ChunkIndex chunkIndex,
+            const uint16_t   fragIndex,
+            const uint16_t   numFrags)
+    {
+        encodeSeqNum();
+        encoder.encode(chunkFragMsgId);
+        prodInfo.getIndex().serialize(encoder, version);
+        prodInfo.getSize().serialize(encoder, version);
+        prodInfo.getChunkSize().serialize(encoder, version);
+        chunkIndex.serialize(encoder, version);
+        encoder.encode(fragIndex);
+        encoder.encode(numFrags);
+    }
+
+    /**
+     * Multicasts an oversize data-chunk as a sequence of MTU-sized fragment
+     * messages followed by one parity fragment -- the XOR of the data
+     * fragments, each zero-padded to `fragDataSize`. A receiver reassembles
+     * the chunk from the fragments and can reconstruct a single lost
+     * fragment from the parity, so the loss of one fragment no longer
+     * discards the whole chunk.
+     * @param[in] prodInfo  Information on the chunk's data-product
+     * @param[in] chunk     Data-chunk to be fragmented
+     */
+    void sendFragments(
+            const ProdInfo&    prodInfo,
+            const ActualChunk& chunk)
+    {
+        const size_t   dataLen = chunk.getSize();
+        auto           data = static_cast<const char*>(chunk.getData());
+        const uint16_t numFrags = (dataLen + fragDataSize - 1)/fragDataSize;
+        std::vector<char> parity(fragDataSize, 0);
+        for (uint16_t fragIndex = 0; fragIndex < numFrags; ++fragIndex) {
+            const size_t offset = fragIndex*fragDataSize;
+            const size_t fragLen = std::min(fragDataSize, dataLen - offset);
+            acquire(getSeqNumSize(version) +
+                    Codec::getSerialSize(sizeof(chunkFragMsgId)) +
+                    getFragMetadataSize(version) + fragLen);
+            encodeFragMetadata(prodInfo, chunk.getIndex(), fragIndex,
+                    numFrags);
+            encoder.encode(data + offset, fragLen);
+            encoder.flush();
+            for (size_t i = 0; i < fragLen; ++i)
+                parity[i] ^= data[offset+i];
+        }
+        acquire(getSeqNumSize(version) +
+                Codec::getSerialSize(sizeof(chunkFragMsgId)) +
+                getFragMetadataSize(version) + fragDataSize);
+        encodeFragMetadata(prodInfo, chunk.getIndex(), numFrags, numFrags);
+        encoder.encode(parity.data(), fragDataSize);
+        encoder.flush();
+    }
+
+    /**
+     * Multicasts a single data-chunk, accumulating it into the product's
+     * current FEC block if parity messages are enabled. A chunk whose data
+     * doesn't fit in a single MTU-sized datagram is sent as fragment
+     * messages instead of being left to IP fragmentation.
+     * @param[in]     prodInfo  Information on the chunk's data-product
+     * @param[in]     chunk     Data-chunk
+     * @param[in,out] fecState  Product's FEC state
+     */
+    void sendChunk(
+            const ProdInfo&    prodInfo,
+            const ActualChunk& chunk,
+            FecState&          fecState)
+    {
+        if (chunk.getSize() > fragDataSize) {
+            sendFragments(prodInfo, chunk);
+        }
+        else {
+            acquire(getSeqNumSize(version) +
+                    Codec::getSerialSize(sizeof(chunkMsgId)) +
+                    chunk.getSerialSize(version));
+            encodeSeqNum();
+            encoder.encode(chunkMsgId);
+            chunk.serialize(encoder, version);
+            encoder.flush();
+        }
+        if (fecBlockSize) {
+            ++epochChunks;
+            accumulate(prodInfo, chunk, fecState);
+        }
+    }
+
+    /**
+     * Transmits the chunks of the queued data-products in weighted
+     * round-robin order: each turn, a product multicasts `priority+1` chunks
+     * and then yields to the next queued product, so a small or urgent
+     * product achieves low latency regardless of how large the products
+     * ahead of it are. Chunk and parity datagrams are self-describing, so a
+     * receiver can reassemble interleaved products. Doesn't return unless an
+     * exception is thrown. Intended to run on its own thread, which can be
+     * safely canceled.
+     */
+    void runScheduler()
+    {
+        try {
+            for (;;) {
+                UniqueLock lock{queueMutex};
+                while (sendQueue.empty()) {
+                    Canceler canceler{};
+                    queueCond.wait(lock);
+                }
+                auto entry = std::move(sendQueue.front());
+                sendQueue.pop_front();
+                lock.unlock();
+
+                const auto prodInfo = entry.prod.getInfo();
+                const auto numChunks = prodInfo.getNumChunks();
+                {
+                    // Serialized with repair retransmissions
+                    LockGuard txGuard{txMutex};
+                    for (unsigned n = 0; n <= entry.priority &&
+                            entry.nextIndex < numChunks;
+                            ++n, ++entry.nextIndex) {
+                        auto chunk = entry.prod.getChunk(entry.nextIndex);
+                        if (!chunk)
+                            throw RUNTIME_ERROR("Chunk " +
+                                    std::to_string(entry.nextIndex) +
+                                    " of product " +
+                                    std::to_string(prodInfo.getIndex()) +
+                                    " doesn't exist");
+                        sendChunk(prodInfo, chunk, entry.fec);
+                    }
+                    if (entry.nextIndex >= numChunks) {
+                        if (fecBlockSize && entry.fec.numChunks)
+                            // Final, partial block
+                            sendParity(prodInfo, entry.fec);
+                        encoder.flushSock();
+                    }
+                }
+                if (entry.nextIndex < numChunks) {
+                    LockGuard guard{queueMutex};
+                    sendQueue.push_back(std::move(entry));
+                }
+                else {
+                    // Copied under the lock; called without it
+                    lock.lock();
+                    const auto observer = txObserver;
+                    lock.unlock();
+                    if (observer)
+                        observer(prodInfo);
+                }
+            }
+        }
+        catch (const std::exception& e) {
+            try {
+                std::throw_with_nested(RUNTIME_ERROR(
+                        "Multicast fair-scheduler failed"));
+            }
+            catch (const std::exception& ex) {
+                // Because end of thread
+                log_error(ex);
+                LockGuard guard{queueMutex};
+                exception = std::current_exception();
+            }
+        }
+    }
 
     /**
      * Multicasts a product-information datagram.
@@ -50,6 +533,10 @@ class McastSender::Impl final
         try {
             LOG_DEBUG("Multicasting product-info: prodIndex=%s",
                     std::to_string(prodInfo.getIndex()).c_str());
+            acquire(getSeqNumSize(version) +
+                    Codec::getSerialSize(sizeof(prodInfoMsgId)) +
+                    prodInfo.getSerialSize(version));
+            encodeSeqNum();
             encoder.encode(prodInfoMsgId);
             prodInfo.serialize(encoder, version);
             encoder.flush();
@@ -69,10 +556,182 @@ public:
      * @throws std::system_error  `socket()` failure
      */
     Impl(   const InetSockAddr& mcastAddr,
-            const unsigned      version)
+            const unsigned      version,
+            const unsigned      fecBlockSize,
+            const double        rate,
+            const size_t        burstSize)
         : encoder(mcastAddr)
         , version{version}
-    {}
+        , seqNum{0}
+        , fecBlockSize{fecBlockSize}
+        , curFecBlockSize{fecBlockSize}
+        , epochChunks{0}
+        , epochLosses{0}
+        , fecMutex{}
+        , epochStart{Clock::now()}
+        , maxFecOverhead{defaultMaxFecOverhead}
+        , fec{}
+        , mutex{}
+        , cond{}
+        , rate{rate}
+        , burst{static_cast<double>(burstSize
+                ? burstSize
+                : defaultBurstSize*UdpSock::maxPayload)}
+        , tokens{burst}
+        , lastRefill{Clock::now()}
+        , streamInfo{}
+        , txMutex{}
+        , queueMutex{}
+        , queueCond{}
+        , sendQueue{}
+        , schedThread{}
+        , exception{}
+        , txObserver{}
+        , rateTunable{}
+        , overheadTunable{}
+    {
+        if (rate < 0)
+            throw INVALID_ARGUMENT("Sending rate is negative: " +
+                    std::to_string(rate));
+        static std::atomic<unsigned> numSenders{0};
+        const auto senderNum = numSenders++;
+        rateTunable = Tunables::registerTunable(
+                "mcast." + std::to_string(senderNum) + ".rate",
+                "Maximum multicast sending rate in bytes per second. 0 "
+                "disables pacing.",
+                [this](const std::string& value) {
+                    double rate;
+                    try {
+                        rate = std::stod(value);
+                    }
+                    catch (const std::exception& e) {
+                        throw INVALID_ARGUMENT("Not a number: \"" + value +
+                                "\"");
+                    }
+                    setRate(rate);
+                    return std::to_string(rate);
+                });
+        if (fecBlockSize)
+            overheadTunable = Tunables::registerTunable(
+                    "mcast." + std::to_string(senderNum) + ".max_fec_overhead",
+                    "Ceiling on the multicast parity-to-data ratio: the "
+                    "bandwidth budget of the loss-adaptive FEC controller. "
+                    "In (0,1].",
+                    [this](const std::string& value) {
+                        double maxOverhead;
+                        try {
+                            maxOverhead = std::stod(value);
+                        }
+                        catch (const std::exception& e) {
+                            throw INVALID_ARGUMENT("Not a number: \"" + value +
+                                    "\"");
+                        }
+                        setMaxFecOverhead(maxOverhead);
+                        return std::to_string(maxOverhead);
+                    });
+    }
+
+    ~Impl() noexcept
+    {
+        try {
+            if (schedThread.joinable()) {
+                schedThread.cancel();
+                schedThread.join();
+            }
+        }
+        catch (const std::exception& ex) {
+            log_error(ex);
+        }
+    }
+
+    /**
+     * Sets the maximum sending rate.
+     * @param[in] rate  Maximum sending rate in bytes per second or 0 to
+     *                  disable pacing
+     * @throws InvalidArgument  `rate` is negative
+     */
+    void setRate(const double rate)
+    {
+        if (rate < 0)
+            throw INVALID_ARGUMENT("Sending rate is negative: " +
+                    std::to_string(rate));
+        LockGuard lock{mutex};
+        refill(); // Accrue tokens at the old rate up to now
+        this->rate = rate;
+        cond.notify_all();
+    }
+
+    /**
+     * Reports that a receiver lost a multicast data-chunk and recovered it
+     * via the peer-to-peer network. Feeds the loss-feedback controller,
+     * which adapts the parity-to-data ratio to the losses reported during
+     * each epoch. No-op if parity messages are disabled.
+     * @exceptionsafety  Basic guarantee
+     * @threadsafety     Safe
+     */
+    void reportLostChunk()
+    {
+        if (fecBlockSize == 0)
+            return;
+        ++epochLosses;
+        // Loss reports may arrive while nothing is being multicast, so the
+        // epoch is also advanced here rather than only at parity messages
+        maybeAdjustFec();
+    }
+
+    /**
+     * Sets the ceiling on the parity-to-data ratio -- the bandwidth budget
+     * for parity messages. The loss-feedback controller never shrinks the
+     * FEC block-size below the reciprocal of this ceiling, so parity
+     * traffic can't exceed the given fraction of the data traffic.
+     * @param[in] maxOverhead   Ceiling on the parity-to-data ratio. In (0,1].
+     * @throws InvalidArgument  `maxOverhead` is out of range
+     * @exceptionsafety         Strong guarantee
+     * @threadsafety            Safe
+     */
+    void setMaxFecOverhead(const double maxOverhead)
+    {
+        if (maxOverhead <= 0 || maxOverhead > 1)
+            throw INVALID_ARGUMENT("Invalid parity-overhead ceiling: " +
+                    std::to_string(maxOverhead));
+        LockGuard lock{fecMutex};
+        maxFecOverhead = maxOverhead;
+        const auto minSize = static_cast<unsigned>(std::ceil(1/maxOverhead));
+        if (curFecBlockSize.load() < minSize)
+            curFecBlockSize = minSize; // Enforce the new budget at once
+    }
+
+    /**
+     * Sets the Differentiated Services code-point on the multicast socket so
+     * the network can class the real-time product stream.
+     * @param[in] dscp  Code-point in [0,63] (see RFC 2474). 0 is best-effort
+     *                  (the default).
+     * @throws std::invalid_argument  `dscp > 63`
+     * @throws std::system_error      `setsockopt()` failure
+     * @exceptionsafety  Strong guarantee
+     * @threadsafety     Safe
+     */
+    void setDscp(const unsigned dscp)
+    {
+        encoder.setDscp(dscp);
+    }
+
+    /**
+     * Multicasts a product-information datagram by itself -- an
+     * announcement without the product's data. Intended for an essential-
+     * layer group that announces every product but carries only a subset in
+     * full, so a subscriber learns of every product and can fetch the
+     * unannounced data via the peer-to-peer network.
+     * @param[in] prodInfo  Information on the data-product
+     * @exceptionsafety     Basic guarantee
+     * @threadsafety        Safe
+     */
+    void sendProdInfo(const ProdInfo& prodInfo)
+    {
+        LockGuard txGuard{txMutex};
+        send(prodInfo);
+        encoder.flushSock();
+    }
 
     /**
      * Multicasts a data-product.
@@ -83,38 +742,311 @@ public:
     void send(Product& prod)
     {
         try {
+            LockGuard txGuard{txMutex};
             // Keep consistent with McastReceiver::operator()()
             const ProdInfo prodInfo = prod.getInfo();
+            /*
+             * A single-chunk product that fits one datagram goes as one
+             * combined information-and-data message: one datagram and one
+             * store insertion at the receiver instead of two of each. The
+             * combined message carries no parity -- parity for a lone chunk
+             * would double the product's bandwidth -- so a lost datagram is
+             * repaired peer-to-peer via the sequence-number gap.
+             */
+            const size_t smallProdSize = getSeqNumSize(version) +
+                    Codec::getSerialSize(sizeof(smallProdMsgId)) +
+                    prodInfo.getSerialSize(version) + prodInfo.getSize();
+            if (prodInfo.getNumChunks() == 1 &&
+                    smallProdSize <= UdpSock::maxPayload) {
+                auto chunk = prod.getChunk(0);
+                if (!chunk)
+                    throw RUNTIME_ERROR("Chunk 0 doesn't exist");
+                LOG_DEBUG("Multicasting small product: prodIndex=%s",
+                        std::to_string(prodInfo.getIndex()).c_str());
+                acquire(smallProdSize);
+                encodeSeqNum();
+                encoder.encode(smallProdMsgId);
+                ActualSmallProd{prodInfo, chunk}.serialize(encoder, version);
+                encoder.flush();
+                encoder.flushSock();
+                return;
+            }
             send(prodInfo);
 
             const auto prodIndex = prodInfo.getIndex();
             const auto numChunks = prodInfo.getNumChunks();
+            if (fecBlockSize)
+                resetFec(prodInfo, fec);
             for (ChunkIndex chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex) {
-                encoder.encode(chunkMsgId);
                 auto chunk = prod.getChunk(chunkIndex);
                 if (!chunk)
                     throw RUNTIME_ERROR("Chunk " + std::to_string(chunkIndex) +
                             " doesn't exist");
-                chunk.serialize(encoder, version);
-                encoder.flush();
+                sendChunk(prodInfo, chunk, fec);
             }
+            if (fecBlockSize && fec.numChunks)
+                sendParity(prodInfo, fec); // Final, partial FEC block
+            encoder.flushSock();
         }
         catch (const std::exception& ex) {
             std::throw_with_nested(RUNTIME_ERROR("Couldn't multicast product " +
                     std::to_string(prod.getInfo())));
         }
     }
+
+    /**
+     * Multicasts a data-chunk again: a repair retransmission for a chunk
+     * that many receivers missed identically, so one datagram replaces N
+     * unicast peer-to-peer transfers. Bypasses the fair scheduler and FEC
+     * accounting -- the retransmission is itself a repair. An oversize
+     * chunk is sent as fragment messages.
+     * @param[in] prodInfo  Information on the chunk's data-product
+     * @param[in] chunk     Data-chunk
+     * @exceptionsafety     Basic guarantee
+     * @threadsafety        Safe
+     */
+    void resend(
+            const ProdInfo&    prodInfo,
+            const ActualChunk& chunk)
+    {
+        try {
+            LockGuard txGuard{txMutex};
+            if (chunk.getSize() > fragDataSize) {
+                sendFragments(prodInfo, chunk);
+            }
+            else {
+                acquire(getSeqNumSize(version) +
+                        Codec::getSerialSize(sizeof(chunkMsgId)) +
+                        chunk.getSerialSize(version));
+                encodeSeqNum();
+                encoder.encode(chunkMsgId);
+                chunk.serialize(encoder, version);
+                encoder.flush();
+            }
+            encoder.flushSock();
+        }
+        catch (const std::exception& ex) {
+            std::throw_with_nested(RUNTIME_ERROR(
+                    "Couldn't multicast repair of data-chunk " +
+                    chunk.getId().to_string()));
+        }
+    }
+
+    /**
+     * Begins the streaming transmission of a data-product. Multicasts the
+     * product-information immediately -- before the product's data has
+     * completely arrived -- so transmission of the leading chunks overlaps
+     * the ingest of the trailing ones.
+     * @param[in] prodInfo  Information on the data-product
+     * @throws LogicError   A streaming transmission is already in progress
+     * @exceptionsafety     Basic guarantee
+     * @threadsafety        Compatible but not safe
+     */
+    void beginProduct(const ProdInfo& prodInfo)
+    {
+        if (streamInfo)
+            throw LOGIC_ERROR("Streaming transmission of product " +
+                    std::to_string(streamInfo.getIndex()) +
+                    " is already in progress");
+        LockGuard txGuard{txMutex};
+        send(prodInfo);
+        if (fecBlockSize)
+            resetFec(prodInfo, fec);
+        streamInfo = prodInfo;
+    }
+
+    /**
+     * Multicasts a data-chunk of the product of the current streaming
+     * transmission.
+     * @param[in] chunk    Data-chunk
+     * @throws LogicError  `beginProduct()` hasn't been called
+     * @exceptionsafety    Basic guarantee
+     * @threadsafety       Compatible but not safe
+     */
+    void send(const ActualChunk& chunk)
+    {
+        if (!streamInfo)
+            throw LOGIC_ERROR("No streaming transmission in progress");
+        try {
+            LockGuard txGuard{txMutex};
+            sendChunk(streamInfo, chunk, fec);
+        }
+        catch (const std::exception& ex) {
+            std::throw_with_nested(RUNTIME_ERROR(
+                    "Couldn't multicast data-chunk " +
+                    chunk.getId().to_string()));
+        }
+    }
+
+    /**
+     * Ends the current streaming transmission: multicasts the final, partial
+     * FEC block, if any, and transmits any staged datagrams.
+     * @throws LogicError  `beginProduct()` hasn't been called
+     * @exceptionsafety    Basic guarantee
+     * @threadsafety       Compatible but not safe
+     */
+    void endProduct()
+    {
+        if (!streamInfo)
+            throw LOGIC_ERROR("No streaming transmission in progress");
+        {
+            LockGuard txGuard{txMutex};
+            if (fecBlockSize && fec.numChunks)
+                sendParity(streamInfo, fec);
+            encoder.flushSock();
+        }
+        streamInfo = ProdInfo{};
+    }
+
+    /**
+     * Enqueues a data-product for transmission by the fair scheduler and
+     * returns immediately. The product-information is multicast at once; the
+     * data-chunks are multicast by the scheduler, which interleaves them, in
+     * weighted round-robin order, with those of the other queued products.
+     * @param[in] prod      Complete data-product
+     * @param[in] priority  Scheduling weight: `priority+1` chunks are
+     *                      multicast per round-robin turn
+     * @throws RuntimeError  The fair scheduler terminated with an exception
+     * @exceptionsafety      Basic guarantee
+     * @threadsafety         Safe
+     */
+    void enqueue(
+            Product&       prod,
+            const unsigned priority)
+    {
+        const auto prodInfo = prod.getInfo();
+        {
+            LockGuard txGuard{txMutex};
+            send(prodInfo);
+        }
+        QueuedProd entry{};
+        entry.prod = prod;
+        entry.priority = priority;
+        if (fecBlockSize)
+            resetFec(prodInfo, entry.fec);
+        LockGuard lock{queueMutex};
+        if (exception)
+            std::rethrow_exception(exception);
+        if (!schedThread.joinable())
+            schedThread = Thread{[this]{runScheduler();}};
+        sendQueue.push_back(std::move(entry));
+        queueCond.notify_one();
+    }
+
+    /**
+     * Sets the function to call after the fair scheduler fully transmits a
+     * product.
+     * @param[in] observer  Function to call with the product's information
+     */
+    void setTransmitObserver(const std::function<void(const ProdInfo&)>& observer)
+    {
+        LockGuard lock{queueMutex};
+        txObserver = observer;
+    }
 };
 
+// Definitions needed because the members are passed by reference (e.g. to
+// `std::min()`)
+const size_t McastSender::fragDataSize;
+const unsigned McastSender::Impl::maxFecBlockSize;
+
+void McastSender::send(const ProdInfo& prodInfo)
+{
+    pImpl->sendProdInfo(prodInfo);
+}
+
 void McastSender::send(Product& prod)
 {
     pImpl->send(prod);
 }
 
+void McastSender::resend(
+        const ProdInfo&    prodInfo,
+        const ActualChunk& chunk)
+{
+    pImpl->resend(prodInfo, chunk);
+}
+
+void McastSender::beginProduct(const ProdInfo& prodInfo)
+{
+    pImpl->beginProduct(prodInfo);
+}
+
+void McastSender::send(const ActualChunk& chunk)
+{
+    pImpl->send(chunk);
+}
+
+void McastSender::endProduct()
+{
+    pImpl->endProduct();
+}
+
+void McastSender::enqueue(
+        Product&       prod,
+        const unsigned priority)
+{
+    pImpl->enqueue(prod, priority);
+}
+
+void McastSender::enqueue(Product& prod)
+{
+    pImpl->enqueue(prod, prod.getInfo().getPriority());
+}
+
+void McastSender::setTransmitObserver(
+        const std::function<void(const ProdInfo&)>& observer)
+{
+    pImpl->setTransmitObserver(observer);
+}
+
+void McastSender::setRate(const double rate)
+{
+    pImpl->setRate(rate);
+}
+
+void McastSender::reportLostChunk()
+{
+    pImpl->reportLostChunk();
+}
+
+void McastSender::setDscp(const unsigned dscp)
+{
+    pImpl->setDscp(dscp);
+}
+
 McastSender::McastSender(
         const InetSockAddr& mcastAddr,
-        const unsigned      version)
-    : pImpl{new Impl(mcastAddr, version)}
+        const unsigned      version,
+        const unsigned      fecBlockSize,
+        const double        rate,
+        const size_t        burstSize)
+    : pImpl{new Impl(mcastAddr, version, fecBlockSize, rate, burstSize)}
 {}
 
+size_t McastSender::getSeqNumSize(const unsigned version) noexcept
+{
+    return version == 0
+            ? 0
+            : Codec::getSerialSize(sizeof(SeqNumType));
+}
+
+size_t McastSender::getFecMetadataSize(const unsigned version) noexcept
+{
+    return ProdIndex::getStaticSerialSize(version) +
+            ProdSize::getStaticSerialSize(version) +
+            ChunkSize::getStaticSerialSize(version) +
+            ChunkIndex::getStaticSerialSize(version) +
+            Codec::getSerialSize(sizeof(uint16_t));
+}
+
+size_t McastSender::getFragMetadataSize(const unsigned version) noexcept
+{
+    return ProdIndex::getStaticSerialSize(version) +
+            ProdSize::getStaticSerialSize(version) +
+            ChunkSize::getStaticSerialSize(version) +
+            ChunkIndex::getStaticSerialSize(version) +
+            2*Codec::getSerialSize(sizeof(uint16_t));
+}
+
 } // namespace
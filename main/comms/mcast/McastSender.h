@@ -15,6 +15,7 @@
 #include "InetSockAddr.h"
 #include "Product.h"
 
+#include <functional>
 #include <memory>
 
 namespace hycast {
@@ -26,25 +27,235 @@ class McastSender final
 
 public:
     typedef uint16_t MsgIdType;
+    /// Type of the per-sender datagram sequence number
+    typedef uint32_t SeqNumType;
 
     static const MsgIdType prodInfoMsgId = 0;
     static const MsgIdType chunkMsgId = 1;
+    static const MsgIdType fecMsgId = 2;
+    static const MsgIdType chunkFragMsgId = 3;
+    /// A small, complete product -- its information followed by its entire
+    /// data -- in a single datagram
+    static const MsgIdType smallProdMsgId = 4;
+
+    /**
+     * Number of data bytes per chunk-fragment message. Sized so a fragment
+     * message fits in a single 1500-byte Ethernet frame (minus the IP, UDP,
+     * and fragment-message headers): a chunk larger than this would otherwise
+     * be IP-fragmented, and the loss of any one IP-fragment discards the
+     * entire chunk. A chunk whose data exceeds this size is instead multicast
+     * as a sequence of application-layer fragment messages plus one parity
+     * fragment, so a receiver both loses only the fragments that are actually
+     * lost and can reconstruct a single lost fragment per chunk.
+     */
+    static const size_t fragDataSize = 1400;
 
     /**
      * Constructs.
-     * @param[in] mcastAddr  Socket address of the multicast group
-     * @param[in] version    Protocol version
+     * @param[in] mcastAddr     Socket address of the multicast group
+     * @param[in] version       Protocol version
+     * @param[in] fecBlockSize  Initial number of data-chunks per forward-
+     *                          error-correction block or 0, in which case no
+     *                          parity messages are sent. A parity message is
+     *                          the XOR of the data of the chunks in its block
+     *                          and allows a receiver to reconstruct a single
+     *                          lost chunk per block without using the
+     *                          peer-to-peer network. Reported receiver losses
+     *                          adapt the block-size at runtime.
+     *                          @see reportLostChunk()
+     * @param[in] rate          Maximum sending rate in bytes per second or 0,
+     *                          in which case transmission isn't paced.
+     *                          Transmission is smoothed by a token-bucket so
+     *                          a product's chunks aren't sent in a burst that
+     *                          overruns receiver socket-buffers.
+     * @param[in] burstSize     Token-bucket capacity in bytes or 0 for a
+     *                          reasonable default. Ignored if `rate` is 0.
      * @throws std::system_error  `socket()` failure
+     * @throws InvalidArgument    `rate` is negative
      */
     McastSender(
             const InetSockAddr& mcastAddr,
-            const unsigned      version);
+            const unsigned      version,
+            const unsigned      fecBlockSize = 0,
+            const double        rate = 0,
+            const size_t        burstSize = 0);
+
+    /**
+     * Sets the maximum sending rate. May be called at any time -- including
+     * while a product is being sent on another thread. Also adjustable at
+     * runtime via the tunable `mcast.<n>.rate`.
+     * @param[in] rate  Maximum sending rate in bytes per second or 0 to
+     *                  disable pacing
+     * @throws InvalidArgument  `rate` is negative
+     * @exceptionsafety         Strong guarantee
+     * @threadsafety            Safe
+     */
+    void setRate(const double rate);
+
+    /**
+     * Reports that a receiver lost a multicast data-chunk and recovered it
+     * via the peer-to-peer network. Chunk-requests arriving over the P2P
+     * network are the receivers' loss reports: each feeds a controller that
+     * re-derives the number of data-chunks per FEC block each epoch from the
+     * observed loss-rate. A loss spike thus raises the parity-to-data ratio
+     * within an epoch while a quiet network gradually sheds the overhead,
+     * and the ratio never exceeds the budget set by the tunable
+     * `mcast.<n>.max_fec_overhead` (default 0.25). No-op if parity messages
+     * are disabled.
+     * @exceptionsafety  Basic guarantee
+     * @threadsafety     Safe
+     */
+    void reportLostChunk();
+
+    /**
+     * Sets the Differentiated Services code-point on the multicast socket so
+     * the network can class the real-time product stream.
+     * @param[in] dscp  Code-point in [0,63] (see RFC 2474). 0 is best-effort
+     *                  (the default).
+     * @throws std::invalid_argument  `dscp > 63`
+     * @throws std::system_error      `setsockopt()` failure
+     * @exceptionsafety  Strong guarantee
+     * @threadsafety     Safe
+     */
+    void setDscp(const unsigned dscp);
+
+    /**
+     * Returns the number of bytes in the per-sender sequence number that
+     * leads every multicast datagram, or 0 for protocol version 0, whose
+     * datagrams don't carry one. The sequence number lets a receiver detect
+     * a lost datagram on the very next arrival and immediately initiate
+     * peer-to-peer repair instead of waiting for a timeout.
+     * @param[in] version  Protocol version
+     * @return             Number of bytes in the sequence number
+     */
+    static size_t getSeqNumSize(const unsigned version) noexcept;
+
+    /**
+     * Returns the number of bytes in the metadata of a serialized parity
+     * message (excluding the message identifier).
+     * @param[in] version  Protocol version
+     * @return             Number of bytes in parity-message metadata
+     */
+    static size_t getFecMetadataSize(const unsigned version) noexcept;
+
+    /**
+     * Returns the number of bytes in the metadata of a serialized chunk-
+     * fragment message (excluding the message identifier).
+     * @param[in] version  Protocol version
+     * @return             Number of bytes in fragment-message metadata
+     */
+    static size_t getFragMetadataSize(const unsigned version) noexcept;
+
+    /**
+     * Multicasts a product-information datagram by itself -- an announcement
+     * without the product's data. Intended for an essential-layer group that
+     * announces every product but carries only a subset in full, so a
+     * subscriber learns of every product and can fetch the unannounced data
+     * via the peer-to-peer network.
+     * @param[in] prodInfo  Information on the data-product
+     * @exceptionsafety     Basic guarantee
+     * @threadsafety        Safe
+     * @see Shipping::enableEssentialLayer()
+     */
+    void send(const ProdInfo& prodInfo);
 
     /**
      * Sends a data-product.
      * @param[in] prod  Data-product
      */
     void send(Product& prod);
+
+    /**
+     * Multicasts a data-chunk again: a repair retransmission for a chunk
+     * that many receivers missed identically, so one multicast datagram
+     * replaces N unicast peer-to-peer transfers. Bypasses the fair scheduler
+     * and FEC accounting -- the retransmission is itself a repair. An
+     * oversize chunk is sent as fragment messages.
+     * @param[in] prodInfo  Information on the chunk's data-product
+     * @param[in] chunk     Data-chunk
+     * @exceptionsafety     Basic guarantee
+     * @threadsafety        Safe
+     */
+    void resend(
+            const ProdInfo&    prodInfo,
+            const ActualChunk& chunk);
+
+    /**
+     * Enqueues a data-product for transmission by the fair scheduler and
+     * returns immediately. The product-information is multicast at once; the
+     * data-chunks are multicast by a scheduler-thread that interleaves them,
+     * in weighted round-robin order, with those of the other queued products
+     * -- so a small or urgent product achieves low latency even while a
+     * large product is in flight. Chunk and parity datagrams identify their
+     * product, so receivers reassemble interleaved products correctly.
+     * @param[in] prod      Complete data-product. Must remain valid until
+     *                      transmitted.
+     * @param[in] priority  Scheduling weight: `priority+1` data-chunks are
+     *                      multicast per round-robin turn
+     * @throws RuntimeError  The fair scheduler terminated with an exception
+     * @exceptionsafety      Basic guarantee
+     * @threadsafety         Safe
+     */
+    void enqueue(
+            Product&       prod,
+            const unsigned priority);
+
+    /**
+     * Enqueues a data-product for transmission by the fair scheduler using
+     * the priority class carried in the product's information.
+     * @param[in] prod  Complete data-product. Must remain valid until
+     *                  transmitted.
+     * @throws RuntimeError  The fair scheduler terminated with an exception
+     * @exceptionsafety      Basic guarantee
+     * @threadsafety         Safe
+     * @see ProdInfo::getPriority()
+     */
+    void enqueue(Product& prod);
+
+    /**
+     * Sets the function to call after the fair scheduler fully transmits an
+     * enqueued product -- e.g., so a durable transmit-queue can retire the
+     * product's record. The observer is called on the scheduler-thread after
+     * the product's final datagram is handed to the socket; it is *not*
+     * called for products transmitted synchronously via `send()`.
+     * @param[in] observer  Function to call with the product's information
+     * @exceptionsafety     Strong guarantee
+     * @threadsafety        Safe
+     */
+    void setTransmitObserver(
+            const std::function<void(const ProdInfo&)>& observer);
+
+    /**
+     * Begins the streaming transmission of a data-product whose data hasn't
+     * completely arrived yet -- e.g., one still landing from an ingester.
+     * The product-information is multicast immediately, so transmission of
+     * the leading chunks overlaps the ingest of the trailing ones.
+     * @param[in] prodInfo  Information on the data-product
+     * @throws LogicError   A streaming transmission is already in progress
+     * @exceptionsafety     Basic guarantee
+     * @threadsafety        Compatible but not safe
+     */
+    void beginProduct(const ProdInfo& prodInfo);
+
+    /**
+     * Multicasts a data-chunk of the product of the current streaming
+     * transmission.
+     * @param[in] chunk    Data-chunk
+     * @throws LogicError  `beginProduct()` hasn't been called
+     * @exceptionsafety    Basic guarantee
+     * @threadsafety       Compatible but not safe
+     */
+    void send(const ActualChunk& chunk);
+
+    /**
+     * Ends the current streaming transmission: multicasts the final, partial
+     * forward-error-correction block, if any, and transmits any staged
+     * datagrams.
+     * @throws LogicError  `beginProduct()` hasn't been called
+     * @exceptionsafety    Basic guarantee
+     * @threadsafety       Compatible but not safe
+     */
+    void endProduct();
 };
 
 } // namespace
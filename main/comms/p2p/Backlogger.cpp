@@ -20,10 +20,16 @@
 #include "config.h"
 
 #include "error.h"
+#include "logging.h"
 #include "Thread.h"
 
 #include "Backlogger.h"
 
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
 namespace hycast {
 
 class Backlogger::Impl
@@ -33,12 +39,112 @@ class Backlogger::Impl
     typedef std::unique_lock<Mutex> UniqueLock;
     typedef std::condition_variable Cond;
 
+    /// Number of unacknowledged notices after which sending pauses
+    static const unsigned defaultWindowSize = 512;
+    /// Number of chunk identifiers accumulated into one range-coded notice
+    /// message. Must be less than the window size so that unsent notices
+    /// can't stall the window.
+    static const unsigned noticesPerMessage = 64;
+    /// Number of most-recent products served first under
+    /// `BacklogOrder::RECENT_FIRST`
+    static const unsigned recentWindowProds = 256;
+
     mutable Mutex mutex;
     Cond          cond;
     Peer          peer;
-    ChunkId     startWith;
-    ChunkId     stopAt;
+    ChunkId       startWith;
+    ChunkId       stopAt;
     ProdStore     prodStore;
+    /// Maximum number of unacknowledged notices or 0 for no limit
+    const unsigned windowSize;
+    /// Number of unacknowledged notices
+    unsigned      outstanding;
+    /// Identifies the last chunk noticed to the remote peer
+    ChunkId       lastNoticed;
+    /// Identifies the last chunk whose notice the remote peer consumed.
+    /// Sending resumes from here after a reconnection
+    ChunkId       cursor;
+    /// Order in which the backlog is served -- as selected by the remote peer
+    BacklogOrder  order;
+    /// First chunk of the recent window under `BacklogOrder::RECENT_FIRST`.
+    /// Empty until -- and unless -- the recent pass begins
+    ChunkId       recentStart;
+    /// File descriptor of the cursor-file or -1 for no persistence
+    int           fd;
+    /// Shared memory-budget that can pause backlog production
+    MemBudget     memBudget;
+
+    /**
+     * Persists the cursor to the cursor-file. Does nothing if this instance
+     * has no cursor-file. A failure is logged rather than thrown because the
+     * cursor is an optimization: without it the backlog merely restarts from
+     * the beginning.
+     * @pre `mutex` is locked
+     */
+    void persistCursor() noexcept
+    {
+        if (fd < 0)
+            return;
+        char buf[64];
+        auto nbytes = ::snprintf(buf, sizeof(buf), "%lu %lu\n",
+                static_cast<unsigned long>(
+                        static_cast<ProdIndex::type>(cursor.getProdIndex())),
+                static_cast<unsigned long>(
+                        static_cast<ChunkIndex::type>(cursor.getChunkIndex())));
+        if (::pwrite(fd, buf, nbytes, 0) != nbytes)
+            LOG_WARN("Couldn't persist backlog cursor");
+    }
+
+    /**
+     * Restores the cursor from the cursor-file. Returns an empty chunk
+     * identifier if the file is empty or unparsable or the identified product
+     * is no longer in the product-store.
+     * @return Restored cursor. May be empty.
+     */
+    ChunkId restoreCursor() noexcept
+    {
+        char buf[64] = {};
+        if (fd < 0 || ::pread(fd, buf, sizeof(buf)-1, 0) <= 0)
+            return ChunkId{};
+        unsigned long prodIndex, chunkIndex;
+        if (::sscanf(buf, "%lu %lu", &prodIndex, &chunkIndex) != 2)
+            return ChunkId{};
+        try {
+            auto prodInfo = prodStore.getProdInfo(
+                    ProdIndex{static_cast<ProdIndex::type>(prodIndex)});
+            if (!prodInfo)
+                return ChunkId{}; // Product aged out of the store
+            return ChunkId{prodInfo,
+                    ChunkIndex{static_cast<ChunkIndex::type>(chunkIndex)}};
+        }
+        catch (const std::exception& ex) {
+            return ChunkId{};
+        }
+    }
+
+    /**
+     * Blocks until the window of unacknowledged notices has room. If the
+     * remote peer stops requesting backlog chunks -- perhaps because it
+     * already has them -- then the window is reopened after a grace period so
+     * the backlog continues to stream.
+     * @pre `mutex` is unlocked
+     */
+    void awaitWindow()
+    {
+        if (windowSize == 0)
+            return;
+        static const std::chrono::seconds gracePeriod{1};
+        UniqueLock lock{mutex};
+        while (outstanding >= windowSize) {
+            Canceler canceler{};
+            if (cond.wait_for(lock, gracePeriod) ==
+                    std::cv_status::timeout) {
+                outstanding = 0;
+                break;
+            }
+        }
+        ++outstanding;
+    }
 
     /**
      * Returns the identify of the chunk of data at which the sending of
@@ -56,6 +162,68 @@ class Backlogger::Impl
         return stopAt;
     }
 
+    /**
+     * Sends backlog notices for the chunks in the range `[from, upTo)`. An
+     * empty `upTo` means the bound set by `doNotNotifyOf()`, which caps
+     * every pass regardless.
+     * @pre             `getStopAt()` has returned
+     * @param[in] from  Identity of the first chunk to notice
+     * @param[in] upTo  Identity of the first chunk not to notice or empty
+     */
+    void notifyRange(
+            const ChunkId& from,
+            const ChunkId& upTo)
+    {
+        ProdIndex prevProdIndex{};
+        bool      prevProdIndexSet{false};
+        bool      prodExpired{false};
+        /*
+         * Chunk notices are accumulated into a range-coded set and sent
+         * as one message per `noticesPerMessage` chunks. A backlog is
+         * mostly contiguous, so the set usually holds a handful of
+         * ranges rather than a notice per chunk.
+         */
+        ChunkRangeSet rangeSet{};
+        for (auto iter = prodStore.getChunkInfoIterator(from);; ++iter) {
+            auto chunkInfo = *iter;
+            auto prodIndex = chunkInfo.getProdIndex();
+            if (prodIndex != prevProdIndex || !prevProdIndexSet) {
+                auto prodInfo = prodStore.getProdInfo(prodIndex);
+                // A time-to-live has elapsed: the product is worthless, so
+                // neither it nor its chunks are noticed
+                prodExpired = prodInfo && prodInfo.isExpired();
+                if (prodInfo.isComplete() && !prodExpired)
+                    // Identified by name so the peer's product filter,
+                    // if any, can veto the product and its chunk notices
+                    peer.notify(prodIndex, prodInfo.getName());
+                prevProdIndex = prodIndex;
+                prevProdIndexSet = true;
+            }
+            if (!chunkInfo.isEarlierThan(getStopAt()))
+                break;
+            if (upTo && !chunkInfo.isEarlierThan(upTo))
+                break;
+            if (prodExpired)
+                continue;
+            awaitWindow(); // Paces against the remote peer's consumption
+            // Backlog production is the most deferrable load on a node
+            memBudget.awaitBelow(MemBudget::Level::PAUSE_BACKLOG);
+            if (!rangeSet.add(chunkInfo)) {
+                peer.notify(rangeSet);
+                rangeSet.clear();
+                rangeSet.add(chunkInfo);
+            }
+            if (rangeSet.getNumChunks() >= noticesPerMessage) {
+                peer.notify(rangeSet);
+                rangeSet.clear();
+            }
+            LockGuard lock{mutex};
+            lastNoticed = chunkInfo;
+        }
+        if (rangeSet)
+            peer.notify(rangeSet); // Notices of the pass's final chunks
+    }
+
 public:
     /**
      * Default constructs.
@@ -67,6 +235,14 @@ public:
         , startWith{}
         , stopAt{}
         , prodStore{}
+        , windowSize{0}
+        , outstanding{0}
+        , lastNoticed{}
+        , cursor{}
+        , order{BacklogOrder::OLDEST_FIRST}
+        , recentStart{}
+        , fd{-1}
+        , memBudget{}
     {}
 
     /**
@@ -75,22 +251,83 @@ public:
      * @param[in] startWith    Identifies the chunk of data whose information
      *                         should be sent first
      * @param[in] prodStore    Product storage
+     * @param[in] memBudget    Shared memory-budget
      * @throw InvalidArgument  `startWith` is empty
      */
-    Impl(   Peer&          peer,
-            const ChunkId& startWith,
-            ProdStore&     prodStore)
+    Impl(   Peer&            peer,
+            const ChunkId&   startWith,
+            ProdStore&       prodStore,
+            const MemBudget& memBudget)
         : mutex{}
         , cond{}
         , peer{peer}
         , startWith{startWith}
         , stopAt{}
         , prodStore{prodStore}
+        , windowSize{defaultWindowSize}
+        , outstanding{0}
+        , lastNoticed{}
+        , cursor{}
+        , order{BacklogOrder::OLDEST_FIRST}
+        , recentStart{}
+        , fd{-1}
+        , memBudget{memBudget}
     {
         if (!startWith)
             throw INVALID_ARGUMENT("Chunk-information is empty");
     }
 
+    /**
+     * Constructs with a persistent cursor.
+     * @param[in] peer            Local peer associated with remote peer
+     * @param[in] startWith       Identifies the chunk of data whose
+     *                            information should be sent first
+     * @param[in] prodStore       Product storage
+     * @param[in] cursorPathname  Pathname of the per-peer cursor-file
+     * @param[in] memBudget       Shared memory-budget
+     * @throw InvalidArgument     `startWith` is empty
+     * @throw SystemError         Couldn't open cursor-file
+     */
+    Impl(   Peer&              peer,
+            const ChunkId&     startWith,
+            ProdStore&         prodStore,
+            const std::string& cursorPathname,
+            const MemBudget&   memBudget)
+        : mutex{}
+        , cond{}
+        , peer{peer}
+        , startWith{startWith}
+        , stopAt{}
+        , prodStore{prodStore}
+        , windowSize{defaultWindowSize}
+        , outstanding{0}
+        , lastNoticed{}
+        , cursor{}
+        , order{BacklogOrder::OLDEST_FIRST}
+        , recentStart{}
+        , fd{::open(cursorPathname.data(), O_RDWR|O_CREAT|O_CLOEXEC, 0666)}
+        , memBudget{memBudget}
+    {
+        if (fd < 0)
+            throw SYSTEM_ERROR("Couldn't open cursor-file \"" +
+                    cursorPathname + "\"");
+        try {
+            if (!startWith)
+                throw INVALID_ARGUMENT("Chunk-information is empty");
+            cursor = restoreCursor();
+        }
+        catch (const std::exception& ex) {
+            ::close(fd);
+            throw;
+        }
+    }
+
+    ~Impl() noexcept
+    {
+        if (fd >= 0)
+            ::close(fd);
+    }
+
     operator bool() const noexcept
     {
         return startWith.operator bool();
@@ -137,6 +374,82 @@ public:
         return stopAt;
     }
 
+    /**
+     * Tells this instance that the remote peer has consumed the notice of the
+     * given data-chunk (it requested the chunk). Opens the window of
+     * unacknowledged notices and advances the persistent cursor. Ignores
+     * chunks that this instance hasn't noticed.
+     * @param[in] chunkId  Consumed data-chunk
+     * @exceptionsafety    Nothrow
+     * @threadsafety       Safe
+     */
+    void ack(const ChunkId& chunkId) noexcept
+    {
+        LockGuard  lock{mutex};
+        const bool inRecentWindow = order == BacklogOrder::RECENT_FIRST &&
+                recentStart && !chunkId.isEarlierThan(recentStart);
+        if (!inRecentWindow && (!lastNoticed ||
+                (!chunkId.isEarlierThan(lastNoticed) &&
+                 !(chunkId == lastNoticed))))
+            return;
+        if (outstanding > 0) {
+            --outstanding;
+            cond.notify_one();
+        }
+        /*
+         * Under recent-first serving the cursor tracks only the historical
+         * fill-in pass: chunks in the recent window are consumed out of
+         * chronological order, and resuming from one of them after a
+         * reconnection would skip the rest of the history.
+         */
+        if (inRecentWindow)
+            return;
+        if (!cursor || cursor.isEarlierThan(chunkId)) {
+            cursor = chunkId;
+            persistCursor();
+        }
+    }
+
+    /**
+     * Returns the cursor: the last chunk whose notice the remote peer
+     * consumed. May be empty.
+     * @return Cursor. May be empty.
+     */
+    ChunkId getCursor() const noexcept
+    {
+        LockGuard lock{mutex};
+        return cursor;
+    }
+
+    /**
+     * Seeds the cursor -- e.g., from a prior association's saved session.
+     * The later of the given cursor and any existing one (e.g., restored
+     * from a cursor-file) wins. Must be called before `operator()()` runs to
+     * have an effect.
+     * @param[in] cursor  Seed cursor
+     */
+    void setCursor(const ChunkId& cursor) noexcept
+    {
+        if (!cursor)
+            return;
+        LockGuard lock{mutex};
+        if (!this->cursor || this->cursor.isEarlierThan(cursor)) {
+            this->cursor = cursor;
+            persistCursor();
+        }
+    }
+
+    /**
+     * Sets the order in which the backlog is served. Must be called before
+     * `operator()()` runs to have an effect.
+     * @param[in] order  Order in which to serve the backlog
+     */
+    void setOrder(const BacklogOrder order) noexcept
+    {
+        LockGuard lock{mutex};
+        this->order = order;
+    }
+
     /**
      * Executes this instance. Returns immediately if this instance was default
      * constructed; otherwise, doesn't start until `doNotNotifyOf()` has been
@@ -146,25 +459,37 @@ public:
      */
     void operator()()
     {
-        if (startWith) {
-            static ProdIndex prevProdIndex{};
-            static bool      prevProdIndexSet{false};
-            getStopAt(); // Don't start until `stopAt` is set
-            for (auto iter = prodStore.getChunkInfoIterator(startWith);; ++iter) {
-                auto chunkInfo = *iter;
-                auto prodIndex = chunkInfo.getProdIndex();
-                if (prodIndex != prevProdIndex || !prevProdIndexSet) {
-                    auto prodInfo = prodStore.getProdInfo(prodIndex);
-                    if (prodInfo.isComplete())
-                        peer.notify(prodIndex);
-                    prevProdIndex = prodIndex;
-                    prevProdIndexSet = true;
+        if (!startWith)
+            return;
+        auto begin = startWith;
+        {
+            // Resume from the persistent cursor after a reconnection
+            LockGuard lock{mutex};
+            if (cursor && startWith.isEarlierThan(cursor))
+                begin = cursor;
+        }
+        getStopAt(); // Don't start until `stopAt` is set
+        if (order == BacklogOrder::RECENT_FIRST) {
+            const auto windowStart =
+                    prodStore.getRecentStart(recentWindowProds);
+            if (windowStart && begin.isEarlierThan(windowStart)) {
+                {
+                    LockGuard lock{mutex};
+                    recentStart = windowStart; // `ack()` now knows the window
                 }
-                if (!chunkInfo.isEarlierThan(getStopAt()))
-                    break;
-                peer.notify(chunkInfo);
+                /*
+                 * Dual cursors: the recent window streams first so the
+                 * remote peer sees current data within seconds, then the
+                 * historical fill-in delivers the remainder. The same bytes
+                 * are transferred either way.
+                 */
+                notifyRange(windowStart, ChunkId{});
+                notifyRange(begin, windowStart);
+                return;
             }
+            // The whole backlog lies within the window: orders coincide
         }
+        notifyRange(begin, ChunkId{});
     }
 };
 
@@ -174,9 +499,19 @@ Backlogger::Backlogger()
 
 Backlogger::Backlogger(
         Peer&            peer,
-        const ChunkId& startWith,
-        ProdStore&       prodStore)
-    : pImpl{new Impl(peer, startWith, prodStore)}
+        const ChunkId&   startWith,
+        ProdStore&       prodStore,
+        const MemBudget& memBudget)
+    : pImpl{new Impl(peer, startWith, prodStore, memBudget)}
+{}
+
+Backlogger::Backlogger(
+        Peer&              peer,
+        const ChunkId&     startWith,
+        ProdStore&         prodStore,
+        const std::string& cursorPathname,
+        const MemBudget&   memBudget)
+    : pImpl{new Impl(peer, startWith, prodStore, cursorPathname, memBudget)}
 {}
 
 Backlogger::operator bool() const noexcept
@@ -194,6 +529,26 @@ void Backlogger::doNotNotifyOf(const ChunkId& chunkId) const noexcept
     pImpl->doNotNotifyOf(chunkId);
 }
 
+void Backlogger::ack(const ChunkId& chunkId) const noexcept
+{
+    pImpl->ack(chunkId);
+}
+
+ChunkId Backlogger::getCursor() const noexcept
+{
+    return pImpl->getCursor();
+}
+
+void Backlogger::setCursor(const ChunkId& cursor) const noexcept
+{
+    pImpl->setCursor(cursor);
+}
+
+void Backlogger::setOrder(const BacklogOrder order) const noexcept
+{
+    pImpl->setOrder(order);
+}
+
 const ChunkId& Backlogger::getEarliest() const noexcept
 {
     return pImpl->getEarliest();
@@ -14,10 +14,12 @@
 #ifndef MAIN_COMMS_P2P_BACKLOGGER_H_
 #define MAIN_COMMS_P2P_BACKLOGGER_H_
 
+#include "MemBudget.h"
 #include "Peer.h"
 #include "ProdStore.h"
 
 #include <memory>
+#include <string>
 
 namespace hycast {
 
@@ -38,12 +40,39 @@ public:
      * @param[in] startWith    Identifies the chunk of data whose information
      *                         should be sent first
      * @param[in] prodStore    Product storage
+     * @param[in] memBudget    Shared memory-budget. Backlog production pauses
+     *                         while the budget's pressure-level is at or above
+     *                         `MemBudget::Level::PAUSE_BACKLOG`.
      * @throw InvalidArgument  `startWith` is empty
      */
     Backlogger(
-            Peer&          peer,
-            const ChunkId& startWith,
-            ProdStore&     prodStore);
+            Peer&            peer,
+            const ChunkId&   startWith,
+            ProdStore&       prodStore,
+            const MemBudget& memBudget = MemBudget{});
+
+    /**
+     * Constructs with a persistent per-peer cursor. The cursor records the
+     * last chunk whose notice the remote peer consumed; after a reconnection
+     * the backlog resumes from the cursor rather than from the beginning.
+     * @param[in] peer            Local peer associated with remote peer
+     * @param[in] startWith       Identifies the chunk of data whose
+     *                            information should be sent first
+     * @param[in] prodStore       Product storage
+     * @param[in] cursorPathname  Pathname of the cursor-file
+     * @param[in] memBudget       Shared memory-budget. Backlog production
+     *                            pauses while the budget's pressure-level is
+     *                            at or above
+     *                            `MemBudget::Level::PAUSE_BACKLOG`.
+     * @throw InvalidArgument     `startWith` is empty
+     * @throw SystemError         Couldn't open cursor-file
+     */
+    Backlogger(
+            Peer&              peer,
+            const ChunkId&     startWith,
+            ProdStore&         prodStore,
+            const std::string& cursorPathname,
+            const MemBudget&   memBudget = MemBudget{});
 
     /**
      * Indicates if this instance is meaningful (i.e., wasn't
@@ -68,6 +97,52 @@ public:
      */
     void doNotNotifyOf(const ChunkId& doNotSend) const noexcept;
 
+    /**
+     * Tells this instance that the remote peer has consumed the notice of the
+     * given data-chunk (it requested the chunk). Opens the window of
+     * unacknowledged notices that paces the backlog and advances the
+     * persistent cursor.
+     * @param[in] chunkId  Consumed data-chunk
+     * @exceptionsafety    Nothrow
+     * @threadsafety       Safe
+     */
+    void ack(const ChunkId& chunkId) const noexcept;
+
+    /**
+     * Returns the cursor: the last chunk whose notice the remote peer
+     * consumed. Saved into the session cache when the association ends so a
+     * reconnecting peer's backlog can resume from it.
+     * @return           Cursor. May be empty.
+     * @exceptionsafety  Nothrow
+     * @threadsafety     Safe
+     * @see `ChunkId::operator bool()`
+     */
+    ChunkId getCursor() const noexcept;
+
+    /**
+     * Seeds the cursor -- e.g., from a prior association's saved session.
+     * The later of the given cursor and any existing one (e.g., restored
+     * from a cursor-file) wins; an empty cursor is ignored. Must be called
+     * before `operator()()` runs to have an effect.
+     * @param[in] cursor  Seed cursor
+     * @exceptionsafety   Nothrow
+     * @threadsafety      Safe
+     */
+    void setCursor(const ChunkId& cursor) const noexcept;
+
+    /**
+     * Sets the order in which the backlog is served -- as selected by the
+     * requesting peer. Under `BacklogOrder::RECENT_FIRST` a window of the
+     * most recent products is noticed first and the historical fill-in
+     * follows, so the remote peer sees current data within seconds instead
+     * of after the whole backlog. Must be called before `operator()()` runs
+     * to have an effect.
+     * @param[in] order   Order in which to serve the backlog
+     * @exceptionsafety   Nothrow
+     * @threadsafety      Safe
+     */
+    void setOrder(const BacklogOrder order) const noexcept;
+
     /**
      * Returns the earliest chunk-information that shouldn't be sent to the
      * remote peer.
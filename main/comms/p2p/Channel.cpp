@@ -14,20 +14,127 @@
 
 // The following are for template instantiations
 #include "Chunk.h"
+#include "CreditMsg.h"
+#include "HeartbeatMsg.h"
 #include "ProdIndex.h"
 #include "ProdInfo.h"
 #include <memory>
+#include "PeerGossip.h"
+#include "ProdFilter.h"
+#include "RetentionMsg.h"
 #include "VersionMsg.h"
 
 namespace hycast {
 
+/**
+ * Upper bound, known at compile time, on the number of serial-buffer bytes a
+ * message type needs. Enables exact-size codec buffers: a peer has eight
+ * channels, each with an encoder and a decoder, so the previous 64-KiB
+ * buffers cost about a megabyte per peer. Chunk payloads bypass the serial
+ * buffer (they're gathered and scattered directly), so a chunk channel only
+ * buffers chunk metadata.
+ */
+template<class T>
+struct SerialBufSize
+{
+    static constexpr size_t get(const unsigned version) noexcept {
+        return T::getStaticSerialSize(version);
+    }
+};
+template<>
+struct SerialBufSize<ProdInfo>
+{
+    static constexpr size_t get(const unsigned version) noexcept {
+        return ProdInfo::getMaxSerialSize(version);
+    }
+};
+template<>
+struct SerialBufSize<ChunkRangeSet>
+{
+    static constexpr size_t get(const unsigned version) noexcept {
+        return ChunkRangeSet::getMaxSerialSize(version);
+    }
+};
+template<>
+struct SerialBufSize<PeerGossip>
+{
+    static constexpr size_t get(const unsigned version) noexcept {
+        return PeerGossip::getMaxSerialSize(version);
+    }
+};
+template<>
+struct SerialBufSize<ProdFilter>
+{
+    static constexpr size_t get(const unsigned version) noexcept {
+        return ProdFilter::getMaxSerialSize(version);
+    }
+};
+template<>
+struct SerialBufSize<ActualChunk>
+{
+    static constexpr size_t get(const unsigned version) noexcept {
+        return BaseChunk::getMaxMetadataSize(version);
+    }
+};
+template<>
+struct SerialBufSize<LatentChunk>
+{
+    static constexpr size_t get(const unsigned version) noexcept {
+        return BaseChunk::getMaxMetadataSize(version);
+    }
+};
+template<>
+struct SerialBufSize<ActualChunkRun>
+{
+    static constexpr size_t get(const unsigned version) noexcept {
+        return ActualChunkRun::getMaxMetadataSize(version);
+    }
+};
+template<>
+struct SerialBufSize<LatentChunkRun>
+{
+    static constexpr size_t get(const unsigned version) noexcept {
+        return ActualChunkRun::getMaxMetadataSize(version);
+    }
+};
+template<>
+struct SerialBufSize<ActualCompressedChunk>
+{
+    static constexpr size_t get(const unsigned version) noexcept {
+        return ActualCompressedChunk::getMaxMetadataSize(version);
+    }
+};
+template<>
+struct SerialBufSize<LatentCompressedChunk>
+{
+    static constexpr size_t get(const unsigned version) noexcept {
+        return ActualCompressedChunk::getMaxMetadataSize(version);
+    }
+};
+template<>
+struct SerialBufSize<ActualSmallProd>
+{
+    static constexpr size_t get(const unsigned version) noexcept {
+        return ProdInfo::getMaxSerialSize(version);
+    }
+};
+template<>
+struct SerialBufSize<LatentSmallProd>
+{
+    static constexpr size_t get(const unsigned version) noexcept {
+        return ProdInfo::getMaxSerialSize(version);
+    }
+};
+
 class ImplBase
 {
 protected:
     class Enc : public Encoder
     {
-        SctpSock       sock;
+        MsgSock        sock;
         const unsigned streamId;
+        /// Partial-reliability lifetime in ms. 0 => fully reliable
+        const unsigned timetolive;
     protected:
         /**
          * This is a cancellation point.
@@ -38,21 +145,37 @@ protected:
                 struct iovec* iov,
                 const int     iovcnt)
         {
-            sock.sendv(streamId, iov, iovcnt);
+            sock.sendv(streamId, iov, iovcnt, timetolive);
         }
     public:
         using Encoder::write;
-        Enc(    SctpSock& sock,
-                unsigned  streamId)
-            : Encoder{UINT16_MAX}
+        /**
+         * Writes a message whose payload was serialized elsewhere, applying
+         * this channel's stream identifier and lifetime. This is a
+         * cancellation point.
+         * @param[in] iov     Gather-vector of serialized bytes
+         * @param[in] iovcnt  Size of gather-vector
+         */
+        void writeSerialized(
+                struct iovec* iov,
+                const int     iovcnt)
+        {
+            write(iov, iovcnt);
+        }
+        Enc(    MsgSock&       sock,
+                unsigned       streamId,
+                const size_t   maxSize,
+                const unsigned timetolive)
+            : Encoder{maxSize}
             , sock{sock}
             , streamId{streamId}
+            , timetolive{timetolive}
         {}
     };
 
     class Dec : public Decoder
     {
-        SctpSock sock;
+        MsgSock sock;
     protected:
         size_t read(
                 const struct iovec* iov,
@@ -62,8 +185,9 @@ protected:
             return sock.recvv(iov, iovcnt, peek ? MSG_PEEK : 0);
         }
     public:
-        Dec(SctpSock& sock)
-            : Decoder{UINT16_MAX}
+        Dec(    MsgSock&     sock,
+                const size_t maxSize)
+            : Decoder{maxSize}
             , sock{sock}
         {}
         size_t fill(size_t nbytes = 0)
@@ -89,8 +213,7 @@ protected:
                     (serialBuf == that.serialBuf) &&
                     (nextSerial == that.nextSerial) &&
                     (serialBufBytes == that.serialBufBytes) &&
-                    (dma.iov_base == that.dma.iov_base) &&
-                    (dma.iov_len == that.dma.iov_len) &&
+                    (numDma == that.numDma) &&
                     (sock == that.sock)
             );
         }
@@ -101,25 +224,28 @@ protected:
         }
     }; // `Dec`
 
-    SctpSock       sock;
+    MsgSock        sock;
     const unsigned streamId;
     const unsigned version;
     Enc            encoder;
     Dec            decoder;
 
     ImplBase(
-            SctpSock&      sock,
+            MsgSock&       sock,
             const unsigned streamId,
-            const unsigned version)
+            const unsigned version,
+            const size_t   encBufSize,
+            const size_t   decBufSize,
+            const unsigned timetolive)
         : sock{sock}
         , streamId{streamId}
         , version{version}
-        , encoder{sock, streamId}
-        , decoder{sock}
+        , encoder{sock, streamId, encBufSize, timetolive}
+        , decoder{sock, decBufSize}
     {}
 
 public:
-    SctpSock& getSocket()
+    MsgSock& getSocket()
     {
         return sock;
     }
@@ -158,10 +284,12 @@ template<class S, class R>
 class Channel<S,R>::Impl final : public ImplBase
 {
 public:
-    Impl(   SctpSock&      sock,
+    Impl(   MsgSock&       sock,
             const unsigned streamId,
-            const unsigned version)
-        : ImplBase{sock, streamId, version}
+            const unsigned version,
+            const unsigned timetolive)
+        : ImplBase{sock, streamId, version, SerialBufSize<S>::get(version),
+                SerialBufSize<R>::get(version), timetolive}
     {}
 
     /**
@@ -176,7 +304,30 @@ public:
         }
         catch (const std::exception& ex) {
             std::throw_with_nested(RUNTIME_ERROR("Couldn't send object over "
-                    "SCTP socket " + std::to_string(sock)));
+                    "socket " + std::to_string(sock)));
+        }
+    }
+
+    /**
+     * This is a cancellation point.
+     * @param[in] bytes   Serialized object
+     * @param[in] nbytes  Size of the serialized object in bytes
+     */
+    void sendSerialized(
+            const void*  bytes,
+            const size_t nbytes)
+    {
+        try {
+            // Bypasses the serial buffer: the channel's stream identifier
+            // and lifetime are applied by the encoder's gather-write
+            struct iovec iov;
+            iov.iov_base = const_cast<void*>(bytes);
+            iov.iov_len = nbytes;
+            encoder.writeSerialized(&iov, 1);
+        }
+        catch (const std::exception& ex) {
+            std::throw_with_nested(RUNTIME_ERROR("Couldn't send serialized "
+                    "object over socket " + std::to_string(sock)));
         }
     }
 
@@ -199,16 +350,39 @@ LatentChunk Channel<ActualChunk,LatentChunk>::Impl::recv()
     return LatentChunk::deserialize(decoder, version);
 }
 
+template<>
+LatentChunkRun Channel<ActualChunkRun,LatentChunkRun>::Impl::recv()
+{
+    ImplBase::fill(ActualChunkRun::getMaxMetadataSize(version));
+    return LatentChunkRun::deserialize(decoder, version);
+}
+
+template<>
+LatentCompressedChunk
+Channel<ActualCompressedChunk,LatentCompressedChunk>::Impl::recv()
+{
+    ImplBase::fill(ActualCompressedChunk::getMaxMetadataSize(version));
+    return LatentCompressedChunk::deserialize(decoder, version);
+}
+
+template<>
+LatentSmallProd Channel<ActualSmallProd,LatentSmallProd>::Impl::recv()
+{
+    ImplBase::fill(ProdInfo::getMaxSerialSize(version));
+    return LatentSmallProd::deserialize(decoder, version);
+}
+
 template<class S, class R>
 Channel<S,R>::Channel(
-        SctpSock&      sock,
+        MsgSock&       sock,
         const unsigned streamId,
-        const unsigned version)
-    : pImpl{new Impl(sock, streamId, version)}
+        const unsigned version,
+        const unsigned timetolive)
+    : pImpl{new Impl(sock, streamId, version, timetolive)}
 {}
 
 template<class S, class R>
-SctpSock& Channel<S,R>::getSocket() const
+MsgSock& Channel<S,R>::getSocket() const
 {
     return pImpl->getSocket();
 }
@@ -225,6 +399,14 @@ void Channel<S,R>::send(const S& obj) const
     pImpl->send(obj);
 }
 
+template<class S, class R>
+void Channel<S,R>::sendSerialized(
+        const void*  bytes,
+        const size_t nbytes) const
+{
+    pImpl->sendSerialized(bytes, nbytes);
+}
+
 template<class S, class R>
 R Channel<S,R>::recv() const
 {
@@ -232,9 +414,19 @@ R Channel<S,R>::recv() const
 }
 
 template class Channel<VersionMsg>;
+template class Channel<CreditMsg>;
+template class Channel<RetentionMsg>;
+template class Channel<HeartbeatMsg>;
 template class Channel<ProdIndex>;
 template class Channel<ProdInfo>;
 template class Channel<ChunkId>;
+template class Channel<ChunkRange>;
+template class Channel<ChunkRangeSet>;
+template class Channel<PeerGossip>;
+template class Channel<ProdFilter>;
 template class Channel<ActualChunk, LatentChunk>;
+template class Channel<ActualChunkRun, LatentChunkRun>;
+template class Channel<ActualCompressedChunk, LatentCompressedChunk>;
+template class Channel<ActualSmallProd, LatentSmallProd>;
 
 } // namespace
@@ -12,7 +12,7 @@
 #ifndef CHANNEL_H_
 #define CHANNEL_H_
 
-#include "SctpSock.h"
+#include "MsgSock.h"
 
 #include <cstddef>
 #include <memory>
@@ -37,19 +37,29 @@ public:
 
     /**
      * Constructs.
-     * @param[in] sock      SCTP socket
-     * @param[in] streamId  SCTP stream identifier
-     * @param[in] version   Protocol version
+     * @param[in] sock        Message-oriented socket
+     * @param[in] streamId    Logical stream identifier
+     * @param[in] version     Protocol version
+     * @param[in] timetolive  Partial-reliability lifetime, in milliseconds,
+     *                        of this channel's messages (see RFC 3758):
+     *                        under congestion, an SCTP transport abandons an
+     *                        unsent or unacknowledged message this old
+     *                        instead of retransmitting it. 0 (the default)
+     *                        means fully-reliable delivery. Intended for
+     *                        time-sensitive messages (e.g., notices) whose
+     *                        value expires before a congested retransmission
+     *                        would arrive.
      */
-    Channel(SctpSock&      sock,
+    Channel(MsgSock&       sock,
             const unsigned streamId,
-            const unsigned version);
+            const unsigned version,
+            const unsigned timetolive = 0);
 
     /**
-     * Returns the associated SCTP socket.
-     * @returns the associated SCTP socket
+     * Returns the associated message-oriented socket.
+     * @returns the associated message-oriented socket
      */
-    SctpSock& getSocket() const;
+    MsgSock& getSocket() const;
 
     /**
      * Returns the size of the current message in bytes.
@@ -84,6 +94,23 @@ public:
      */
     void send(const S& obj) const;
 
+    /**
+     * Sends an object that was already serialized -- e.g., once for a set of
+     * peers by a `NoticeCache`. The bytes must be the serial representation,
+     * under this channel's protocol version, of an object of the sent type:
+     * this channel's stream identifier and partial-reliability lifetime are
+     * applied to the message, but the payload goes out as given. This is a
+     * cancellation point.
+     * @param[in] bytes   Serialized object
+     * @param[in] nbytes  Size of the serialized object in bytes
+     * @throws std::system_error if an I/O error occurred
+     * @execptionsafety Basic
+     * @threadsafety    Compatible but not safe
+     */
+    void sendSerialized(
+            const void*  bytes,
+            const size_t nbytes) const;
+
     /**
      * Returns the value in the current message. Waits for a value if necessary.
      * @return Value in the current message
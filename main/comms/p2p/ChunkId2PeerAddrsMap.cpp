@@ -13,6 +13,8 @@
 
 #include "ChunkId2PeerAddrsMap.h"
 
+#include <chrono>
+#include <cstdint>
 #include <mutex>
 #include <unordered_map>
 
@@ -20,48 +22,294 @@ namespace hycast {
 
 class ChunkId2PeerAddrsMap::Impl final
 {
-    typedef std::mutex                               Mutex;
-    typedef std::lock_guard<Mutex>                   LockGuard;
-    typedef std::unordered_map<ChunkId, PeerAddrSet> Map;
+    typedef std::mutex                 Mutex;
+    typedef std::lock_guard<Mutex>     LockGuard;
+    typedef std::chrono::steady_clock  Clock;
+    typedef Clock::time_point          TimePoint;
 
-    mutable Mutex mutex;
-    Map           peerAddrs;
+    /// Peer-addresses and when they were last updated
+    struct Entry
+    {
+        PeerAddrSet peerAddrs;
+        TimePoint   whenUpdated;
+
+        Entry()
+            : peerAddrs{}
+            , whenUpdated{}
+        {}
+    };
+
+    /**
+     * The entries are keyed on `ChunkId::pack()`: the packed word compares in
+     * one operation and `std::hash` of an integer is identity-like, which
+     * suffices here because the chunk-index occupies the fast-varying low
+     * bits.
+     */
+    typedef std::unordered_map<uint64_t, Entry> Map;
+
+    /**
+     * Number of shards. Keeps threads that concurrently record notices from
+     * serializing on a single lock.
+     */
+    static const size_t numShards = 16;
+
+    /**
+     * Number of retired entries migrated into the current table per
+     * operation. One per insert suffices to drain the retired table before
+     * the doubled current table can fill; a few more drains it sooner.
+     */
+    static const size_t migrationStep = 4;
+
+    struct Shard
+    {
+        mutable Mutex mutex;
+        /// Current table. Insertions go here; lookups check here first.
+        Map           entries;
+        /// Table retired by the last growth, drained incrementally into
+        /// `entries` a few entries per operation, so no single insert ever
+        /// pays a full rehash.
+        Map           retired;
+        TimePoint     whenPurged;
+
+        Shard()
+            : mutex{}
+            , entries{}
+            , retired{}
+            , whenPurged{Clock::now()}
+        {}
+    };
+
+    mutable Shard         shards[numShards];
+    /// Age at which an entry is considered stale
+    const Clock::duration maxAge;
+
+    /**
+     * Returns the shard that contains a packed data-chunk identifier.
+     * @param[in] key  Packed data-chunk identifier
+     * @return         Shard that contains the identifier
+     */
+    inline Shard& getShard(const uint64_t key) const noexcept
+    {
+        return shards[key % numShards];
+    }
+
+    /**
+     * Removes a shard's stale entries if the shard hasn't been purged
+     * recently. Bounds the size of the map when notices arrive but the
+     * associated chunks are never requested (e.g., during an outage). The
+     * shard must be locked.
+     * @param[in] shard  Shard to be purged
+     * @param[in] now    Current time
+     */
+    void purgeIfNeeded(
+            Shard&           shard,
+            const TimePoint& now) const
+    {
+        if (now - shard.whenPurged < maxAge)
+            return;
+        for (Map* map : {&shard.entries, &shard.retired}) {
+            for (auto iter = map->begin(); iter != map->end(); ) {
+                if (now - iter->second.whenUpdated >= maxAge) {
+                    iter = map->erase(iter);
+                }
+                else {
+                    ++iter;
+                }
+            }
+        }
+        shard.whenPurged = now;
+    }
+
+    /**
+     * Moves up to `migrationStep` entries from a shard's retired table into
+     * its current one. The current table was reserved for twice the retired
+     * population when the tables were swapped, so the moves never rehash.
+     * The shard must be locked.
+     * @param[in] shard  Shard to be migrated
+     */
+    void migrateSome(Shard& shard) const
+    {
+        for (size_t n = migrationStep; n-- && !shard.retired.empty(); ) {
+            auto iter = shard.retired.begin();
+            shard.entries.emplace(iter->first, std::move(iter->second));
+            shard.retired.erase(iter);
+        }
+    }
+
+    /**
+     * Retires a shard's current table and replaces it with one of twice the
+     * capacity when one more insertion would rehash. The retired table is
+     * drained by `migrateSome()`; growth is deferred while a previous
+     * migration is still draining.
+     * @param[in] shard  Shard to be grown
+     */
+    void growIfNeeded(Shard& shard) const
+    {
+        auto& map = shard.entries;
+        if (!shard.retired.empty())
+            return; // The previous migration is still draining
+        const size_t limit = map.bucket_count() * map.max_load_factor();
+        if (map.bucket_count() != 0 && map.size() + 1 < limit)
+            return;
+        shard.retired.swap(map);
+        map.reserve(2*shard.retired.size() + 16);
+    }
+
+    /**
+     * Returns a pointer to the entry with a packed chunk-identifier or the
+     * null pointer. Checks the current table and then the retired one,
+     * promoting a retired hit into the current table. The shard must be
+     * locked.
+     * @param[in] shard      Shard to be searched
+     * @param[in] key        Packed data-chunk identifier
+     * @retval    `nullptr`  No such entry
+     * @return               The entry. Valid until the shard is next modified.
+     */
+    Entry* find(
+            Shard&         shard,
+            const uint64_t key) const
+    {
+        auto iter = shard.entries.find(key);
+        if (iter != shard.entries.end())
+            return &iter->second;
+        iter = shard.retired.find(key);
+        if (iter == shard.retired.end())
+            return nullptr;
+        auto& entry = shard.entries[key];
+        entry = std::move(iter->second);
+        shard.retired.erase(iter);
+        return &entry;
+    }
 
 public:
-    Impl()
-        : mutex{}
-        , peerAddrs{}
-    {}
+    /**
+     * Constructs.
+     * @param[in] maxAge    Age, in seconds, at which an entry is considered
+     *                      stale
+     * @param[in] sizeHint  Expected number of entries or 0. The tables are
+     *                      pre-sized for the hint so the expected population
+     *                      never triggers growth at all.
+     */
+    Impl(   const double maxAge,
+            const size_t sizeHint)
+        : shards{}
+        , maxAge{std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>{maxAge})}
+    {
+        if (sizeHint) {
+            const size_t perShard = (sizeHint + numShards - 1) / numShards;
+            for (size_t i = 0; i < numShards; ++i)
+                shards[i].entries.reserve(perShard);
+        }
+    }
 
     size_t size() const
     {
-        LockGuard lock{mutex};
-        return peerAddrs.size();
+        size_t size = 0;
+        for (size_t i = 0; i < numShards; ++i) {
+            LockGuard lock{shards[i].mutex};
+            size += shards[i].entries.size() + shards[i].retired.size();
+        }
+        return size;
     }
 
     void add(
             const ChunkId& chunkId,
             const InetSockAddr& peerAddr)
     {
-        LockGuard lock{mutex};
-        peerAddrs[chunkId].add(peerAddr);
+        const auto key = chunkId.pack();
+        auto&      shard = getShard(key);
+        const auto now = Clock::now();
+        LockGuard  lock{shard.mutex};
+        purgeIfNeeded(shard, now);
+        migrateSome(shard);
+        Entry* entry = find(shard, key);
+        if (entry == nullptr) {
+            growIfNeeded(shard);
+            entry = &shard.entries[key];
+        }
+        entry->peerAddrs.add(peerAddr);
+        entry->whenUpdated = now;
+    }
+
+    void add(
+            const ChunkId&      chunkId,
+            const InetSockAddr& peerAddr,
+            const double        weight)
+    {
+        const auto key = chunkId.pack();
+        auto&      shard = getShard(key);
+        const auto now = Clock::now();
+        LockGuard  lock{shard.mutex};
+        purgeIfNeeded(shard, now);
+        migrateSome(shard);
+        Entry* entry = find(shard, key);
+        if (entry == nullptr) {
+            growIfNeeded(shard);
+            entry = &shard.entries[key];
+        }
+        entry->peerAddrs.add(peerAddr, weight);
+        entry->whenUpdated = now;
     }
 
     void remove(
             const ChunkId&      chunkId,
             const InetSockAddr& peerAddr)
     {
-        LockGuard lock{mutex};
-        auto iter = peerAddrs.find(chunkId);
-        if (iter == peerAddrs.end())
+        const auto key = chunkId.pack();
+        auto&      shard = getShard(key);
+        LockGuard  lock{shard.mutex};
+        migrateSome(shard);
+        Entry* entry = find(shard, key);
+        if (entry == nullptr)
             return;
-        iter->second.remove(peerAddr);
+        entry->peerAddrs.remove(peerAddr);
     }
 
     void remove(const ChunkId& chunkId)
     {
-        LockGuard lock{mutex};
-        peerAddrs.erase(chunkId);
+        const auto key = chunkId.pack();
+        auto&      shard = getShard(key);
+        LockGuard  lock{shard.mutex};
+        migrateSome(shard);
+        shard.entries.erase(key);
+        shard.retired.erase(key);
+    }
+
+    size_t count(const ChunkId& chunkId) const
+    {
+        const auto key = chunkId.pack();
+        auto&      shard = getShard(key);
+        const auto now = Clock::now();
+        LockGuard  lock{shard.mutex};
+        migrateSome(shard);
+        Entry* entry = find(shard, key);
+        if (entry == nullptr)
+            return 0;
+        if (now - entry->whenUpdated >= maxAge) {
+            shard.entries.erase(key); // `find()` promoted any retired entry
+            return 0;
+        }
+        return entry->peerAddrs.size();
+    }
+
+    bool contains(
+            const ChunkId&      chunkId,
+            const InetSockAddr& peerAddr) const
+    {
+        const auto key = chunkId.pack();
+        auto&      shard = getShard(key);
+        const auto now = Clock::now();
+        LockGuard  lock{shard.mutex};
+        migrateSome(shard);
+        Entry* entry = find(shard, key);
+        if (entry == nullptr)
+            return false;
+        if (now - entry->whenUpdated >= maxAge) {
+            shard.entries.erase(key); // `find()` promoted any retired entry
+            return false;
+        }
+        return entry->peerAddrs.contains(peerAddr);
     }
 
     bool getRandom(
@@ -69,16 +317,26 @@ public:
             InetSockAddr&               peerAddr,
             std::default_random_engine& generator) const
     {
-        LockGuard lock{mutex};
-        auto iter = peerAddrs.find(chunkId);
-        if (iter == peerAddrs.end())
+        const auto key = chunkId.pack();
+        auto&      shard = getShard(key);
+        const auto now = Clock::now();
+        LockGuard  lock{shard.mutex};
+        migrateSome(shard);
+        Entry* entry = find(shard, key);
+        if (entry == nullptr)
             return false;
-        return iter->second.getRandom(peerAddr, generator);
+        if (now - entry->whenUpdated >= maxAge) {
+            shard.entries.erase(key); // `find()` promoted any retired entry
+            return false;
+        }
+        return entry->peerAddrs.getRandom(peerAddr, generator);
     }
 };
 
-ChunkId2PeerAddrsMap::ChunkId2PeerAddrsMap()
-    : pImpl{new Impl()}
+ChunkId2PeerAddrsMap::ChunkId2PeerAddrsMap(
+        const double maxAge,
+        const size_t sizeHint)
+    : pImpl{new Impl(maxAge, sizeHint)}
 {}
 
 size_t ChunkId2PeerAddrsMap::size() const
@@ -93,6 +351,14 @@ void ChunkId2PeerAddrsMap::add(
     pImpl->add(chunkId, peerAddr);
 }
 
+void ChunkId2PeerAddrsMap::add(
+        const ChunkId&      chunkId,
+        const InetSockAddr& peerAddr,
+        const double        weight)
+{
+    pImpl->add(chunkId, peerAddr, weight);
+}
+
 void ChunkId2PeerAddrsMap::remove(
         const ChunkId&      chunkId,
         const InetSockAddr& peerAddr)
@@ -105,6 +371,18 @@ void ChunkId2PeerAddrsMap::remove(const ChunkId& chunkId)
     pImpl->remove(chunkId);
 }
 
+size_t ChunkId2PeerAddrsMap::count(const ChunkId& chunkId) const
+{
+    return pImpl->count(chunkId);
+}
+
+bool ChunkId2PeerAddrsMap::contains(
+        const ChunkId&      chunkId,
+        const InetSockAddr& peerAddr) const
+{
+    return pImpl->contains(chunkId, peerAddr);
+}
+
 bool ChunkId2PeerAddrsMap::getRandom(
         const ChunkId&              chunkId,
         InetSockAddr&               peerAddr,
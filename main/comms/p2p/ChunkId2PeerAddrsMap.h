@@ -19,6 +19,9 @@
 
 #include <memory>
 
+/// Default age, in seconds, at which an entry is considered stale
+#define DEFAULT_MAX_NOTICE_AGE 60.0
+
 namespace hycast {
 
 class ChunkId2PeerAddrsMap final
@@ -28,13 +31,25 @@ class ChunkId2PeerAddrsMap final
 
 public:
     /**
-     * Constructs.
+     * Constructs. Entries older than the maximum age are removed as a
+     * side-effect of other operations, so the map stays bounded even when
+     * entries aren't explicitly removed. The hash tables are pre-sized for
+     * the size hint and thereafter grow by two-table migration amortized
+     * over operations, so no single insertion on the notice-ingest path
+     * ever pays a full rehash.
+     * @param[in] maxAge    Age, in seconds, at which an entry is considered
+     *                      stale
+     * @param[in] sizeHint  Expected number of entries -- e.g., the notice
+     *                      rate times the maximum age -- or 0 for no hint
      */
-    ChunkId2PeerAddrsMap();
+    explicit ChunkId2PeerAddrsMap(
+            const double maxAge = DEFAULT_MAX_NOTICE_AGE,
+            const size_t sizeHint = 0);
 
     /**
-     * Returns the number of entries.
-     * @return           Number of peer-addresses
+     * Returns the number of entries, including any stale ones that haven't
+     * yet been removed.
+     * @return           Number of entries
      * @exceptionsafety  Strong guarantee
      * @threadsafety     Safe
      */
@@ -52,6 +67,21 @@ public:
             const ChunkId&      chunkId,
             const InetSockAddr& peerAddr);
 
+    /**
+     * Adds a peer-address together with a quality-weight (e.g., the peer's
+     * score from the gossip quality database). The weight biases selection
+     * by `getRandom()` toward better-performing peers.
+     * @param[in] chunkId   Data-chunk identifier
+     * @param[in] peerAddr  Peer-address to be added
+     * @param[in] weight    Quality-weight of the peer. Higher is better.
+     * @exceptionsafety     Strong guarantee
+     * @threadsafety        Safe
+     */
+    void add(
+            const ChunkId&      chunkId,
+            const InetSockAddr& peerAddr,
+            double              weight);
+
     /**
      * Removes a peer-address. Decreases the size of the map by one if the
      * address is the only one associated with the chunk identifier.
@@ -74,6 +104,33 @@ public:
      */
     void remove(const ChunkId& chunkId);
 
+    /**
+     * Returns the number of peer-addresses associated with a data-chunk
+     * identifier -- i.e., the number of peers known to have the chunk. A
+     * stale entry counts as absent.
+     * @param[in] chunkId  Data-chunk identifier
+     * @return             Number of associated peer-addresses
+     * @exceptionsafety    Strong guarantee
+     * @threadsafety       Safe
+     */
+    size_t count(const ChunkId& chunkId) const;
+
+    /**
+     * Indicates if a peer-address is associated with a data-chunk identifier
+     * -- i.e., if the peer is known to have the chunk. A stale entry counts
+     * as absent.
+     * @param[in] chunkId   Data-chunk identifier
+     * @param[in] peerAddr  Peer-address in question
+     * @retval `true`       The peer-address is associated with the identifier
+     * @retval `false`      The peer-address is not associated with the
+     *                      identifier
+     * @exceptionsafety     Strong guarantee
+     * @threadsafety        Safe
+     */
+    bool contains(
+            const ChunkId&      chunkId,
+            const InetSockAddr& peerAddr) const;
+
     /**
      * Pseudo-randomly chooses a peer-address that's associated with a
      * data-chunk identifier and returns it.
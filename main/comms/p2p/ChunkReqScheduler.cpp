@@ -0,0 +1,582 @@
+/**
+ * This file implements a thread-safe scheduler of chunk-requests that stripes
+ * outstanding requests across the remote peers that have announced each chunk.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All Rights
+ * reserved. See file "Copying" in the top-level source-directory for usage
+ * restrictions.
+ *
+ *        File: ChunkReqScheduler.cpp
+ *  Created on: Dec 14, 2017
+ *      Author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "ChunkReqScheduler.h"
+#include "error.h"
+#include "Metrics.h"
+#include "Thread.h"
+#include "Tunables.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <condition_variable>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace hycast {
+
+class ChunkReqScheduler::Impl final
+{
+    typedef std::mutex                     Mutex;
+    typedef std::lock_guard<Mutex>         LockGuard;
+    typedef std::unique_lock<Mutex>        UniqueLock;
+    typedef std::condition_variable        Cond;
+    typedef std::chrono::steady_clock      Clock;
+    typedef std::chrono::time_point<Clock> TimePoint;
+
+    /// The request-state of a single chunk
+    struct Entry
+    {
+        /// The chunk's identifier. The map is keyed on the packed form, so
+        /// the identifier proper is kept here for returning to callers.
+        ChunkId                          chunkId;
+        /// Remote peers that have announced the chunk
+        std::unordered_set<InetSockAddr> candidates;
+        /// Peer to which the request is assigned. Invalid if unassigned.
+        InetSockAddr                     assignee;
+        /// When the request was assigned. Meaningless if unassigned.
+        TimePoint                        whenAssigned;
+        /// When the chunk was first tracked. Anchors the hold-down window.
+        TimePoint                        whenTracked;
+        /// Priority class of the chunk's product
+        ProdInfo::Priority               priority;
+
+        Entry()
+            : chunkId{}
+            , candidates{}
+            , assignee{}
+            , whenAssigned{}
+            , whenTracked{}
+            , priority{ProdInfo::defaultPriority}
+        {}
+    };
+
+    /// Default ceiling, in seconds, on the adaptive repair hold-down
+    static constexpr double defaultMaxHoldDown = 0.5;
+    /// Floor, in seconds, below which the estimate rounds to no hold-down:
+    /// scheduling jitter exceeds a sub-millisecond window, and dispatching
+    /// immediately costs nothing when multicast wins that quickly
+    static constexpr double minHoldDown = 0.001;
+
+    mutable Mutex                            mutex;
+    mutable Cond                             cond;
+    /// Request-state of tracked chunks, keyed on `ChunkId::pack()`: one-word
+    /// compares and identity-like hashing instead of per-field work
+    std::unordered_map<uint64_t, Entry>      entries;
+    /// Number of outstanding chunk-requests per remote peer
+    std::unordered_map<InetSockAddr, size_t> numOutstanding;
+    /// Per-peer request-window sizes. A peer without an entry gets the
+    /// default, `maxOutstanding`.
+    std::unordered_map<InetSockAddr, size_t> windowSizes;
+    const size_t                             maxOutstanding;
+    const Clock::duration                    deadline;
+    /// Whether new chunk-requests are withheld due to memory pressure
+    bool                                     backpressure;
+    /// Returns the fraction of a product's chunks that have been received.
+    /// Empty <=> deferred requests are ordered by priority class alone.
+    CompletenessFn                           completenessFn;
+    /*
+     * Hold-down of repair requests: a multicast datagram that's merely
+     * reordered or a few milliseconds late would otherwise trigger a P2P
+     * request that the multicast delivery then races -- peer bandwidth paid
+     * for nothing. Every chunk that's cancelled because it arrived via
+     * another transport yields a sample of how long multicast took to beat
+     * the repair; the samples feed an RFC 6298-style smoothed estimate
+     * whose mean-plus-four-deviations approximates a high percentile of the
+     * reorder/latency window. New requests are withheld for that long --
+     * bounded by a tunable ceiling -- unless the chunk's product has
+     * elevated priority. One scheduler serves one feed, so the estimate is
+     * effectively per-sender.
+     */
+    double                                   holdDownMean; /// Seconds
+    double                                   holdDownDev;  /// Seconds
+    bool                                     haveHoldDown; /// Whether any
+                                                           /// sample arrived
+    double                                   maxHoldDown;  /// Ceiling in
+                                                           /// seconds. 0
+                                                           /// disables.
+    /// Exports the number of tracked chunk-requests. Deregistered on
+    /// destruction, so it must be declared after the state it samples.
+    Metrics::Gauge                           depthGauge;
+    /// Adjusts the hold-down ceiling at runtime. Deregistered on
+    /// destruction, so it must be declared after the state it adjusts.
+    Tunables::Handle                         holdDownTunable;
+
+    /**
+     * Indicates if a remote peer's request-window has room.
+     * @pre                 `mutex` is locked
+     * @param[in] peerAddr  Address of remote peer
+     * @retval `true`       Iff another request may be assigned to the peer
+     */
+    inline bool hasRoom(const InetSockAddr& peerAddr) const
+    {
+        const auto   witer = windowSizes.find(peerAddr);
+        const size_t window = (witer == windowSizes.end())
+                ? maxOutstanding
+                : witer->second;
+        auto iter = numOutstanding.find(peerAddr);
+        return iter == numOutstanding.end() || iter->second < window;
+    }
+
+    /**
+     * Assigns a chunk-request to a remote peer.
+     * @pre                 `mutex` is locked
+     * @param[in] entry     Request-state of the chunk
+     * @param[in] peerAddr  Address of remote peer
+     */
+    void assign(
+            Entry&              entry,
+            const InetSockAddr& peerAddr)
+    {
+        entry.assignee = peerAddr;
+        entry.whenAssigned = Clock::now();
+        ++numOutstanding[peerAddr];
+    }
+
+    /**
+     * Removes a chunk-request assignment.
+     * @pre             `mutex` is locked
+     * @param[in] entry  Request-state of the chunk
+     */
+    void unassign(Entry& entry)
+    {
+        auto iter = numOutstanding.find(entry.assignee);
+        if (iter != numOutstanding.end() && --iter->second == 0)
+            numOutstanding.erase(iter);
+        entry.assignee = InetSockAddr{};
+    }
+
+    /**
+     * Returns the current hold-down: the estimated multicast reorder/latency
+     * window, clamped to the ceiling.
+     * @pre  `mutex` is locked
+     * @return  Hold-down duration
+     */
+    Clock::duration holdDown() const
+    {
+        double secs = holdDownMean + 4*holdDownDev;
+        if (secs < minHoldDown)
+            secs = 0;
+        else if (secs > maxHoldDown)
+            secs = maxHoldDown;
+        return std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>{secs});
+    }
+
+    /**
+     * Indicates if a chunk-request is being held down: the multicast
+     * delivery it would race gets the estimated reorder window to arrive
+     * first. Chunks of elevated-priority products are never held down.
+     * @pre              `mutex` is locked
+     * @param[in] entry  Request-state of the chunk
+     * @param[in] now    The current time
+     * @retval `true`    Iff the request shouldn't be dispatched yet
+     */
+    inline bool inHoldDown(
+            const Entry&     entry,
+            const TimePoint& now) const
+    {
+        return haveHoldDown && maxHoldDown > 0 &&
+                entry.priority <= ProdInfo::defaultPriority &&
+                now < entry.whenTracked + holdDown();
+    }
+
+    /**
+     * Returns the completeness fraction of a chunk's product: the fraction
+     * of the product's chunks that have been received. The callback is
+     * queried at most once per product per scan via the supplied cache --
+     * several tracked chunks usually belong to the same product.
+     * @pre             `mutex` is locked
+     * @param[in] entry  Request-state of the chunk
+     * @param[in] cache  Per-scan cache of completeness fractions, keyed on
+     *                   product-index
+     * @return           Completeness fraction in `[0,1]`. 0 if no callback
+     *                   is set.
+     */
+    double completenessOf(
+            const Entry&                                 entry,
+            std::unordered_map<ProdIndex::type, double>& cache) const
+    {
+        if (!completenessFn)
+            return 0;
+        const auto prodIndex = entry.chunkId.getProdIndex();
+        const auto key = static_cast<ProdIndex::type>(prodIndex);
+        auto       iter = cache.find(key);
+        if (iter != cache.end())
+            return iter->second;
+        const auto frac = completenessFn(prodIndex);
+        cache.emplace(key, frac);
+        return frac;
+    }
+
+    /**
+     * Accepts a sample of the multicast reorder/latency window: the time a
+     * chunk spent tracked before it arrived via another transport.
+     * @pre                    `mutex` is locked
+     * @param[in] whenTracked  When the chunk was first tracked
+     */
+    void sampleMcastLatency(const TimePoint& whenTracked)
+    {
+        const double sample = std::chrono::duration<double>{
+                Clock::now() - whenTracked}.count();
+        if (!haveHoldDown) {
+            holdDownMean = sample;
+            holdDownDev = sample/2;
+            haveHoldDown = true;
+        }
+        else {
+            const double err = sample - holdDownMean;
+            holdDownMean += err/8;
+            holdDownDev += (std::fabs(err) - holdDownDev)/4;
+        }
+    }
+
+public:
+    /**
+     * Constructs.
+     * @param[in] maxOutstanding  Maximum number of outstanding chunk-requests
+     *                            per remote peer
+     * @param[in] deadline        Number of seconds after which an outstanding
+     *                            chunk-request is re-issued
+     * @throws InvalidArgument    `maxOutstanding == 0 || deadline == 0`
+     */
+    Impl(   const unsigned maxOutstanding,
+            const unsigned deadline)
+        : mutex{}
+        , cond{}
+        , entries{}
+        , numOutstanding{}
+        , windowSizes{}
+        , maxOutstanding{maxOutstanding}
+        , deadline{std::chrono::seconds{deadline}}
+        , backpressure{false}
+        , completenessFn{}
+        , holdDownMean{0}
+        , holdDownDev{0}
+        , haveHoldDown{false}
+        , maxHoldDown{defaultMaxHoldDown}
+        , depthGauge{}
+        , holdDownTunable{}
+    {
+        static std::atomic<unsigned> numSchedulers{0};
+        const auto                   schedNum = numSchedulers++;
+        depthGauge = Metrics::registerGauge(
+                "hycast_chunk_requests{scheduler=\"" +
+                        std::to_string(schedNum) + "\"}",
+                "Number of outstanding or pending chunk-requests",
+                [this]{
+                    LockGuard lock{mutex};
+                    return static_cast<double>(entries.size());
+                });
+        holdDownTunable = Tunables::registerTunable(
+                "reqsched." + std::to_string(schedNum) + ".max_holddown_ms",
+                "Ceiling, in milliseconds, on the adaptive hold-down of "
+                "chunk-requests that gives a merely-late multicast delivery "
+                "time to arrive before a P2P repair is dispatched. 0 "
+                "disables hold-down.",
+                [this](const std::string& value) {
+                    double ms;
+                    try {
+                        ms = std::stod(value);
+                    }
+                    catch (const std::exception& e) {
+                        throw INVALID_ARGUMENT("Not a number: \"" + value +
+                                "\"");
+                    }
+                    if (ms < 0)
+                        throw INVALID_ARGUMENT("Negative hold-down ceiling");
+                    {
+                        LockGuard lock{mutex};
+                        maxHoldDown = ms/1000;
+                    }
+                    cond.notify_all(); // Held chunks might now be dispatchable
+                    return std::to_string(ms);
+                });
+        if (maxOutstanding == 0)
+            throw INVALID_ARGUMENT("Request-window size can't be zero");
+        if (deadline == 0)
+            throw INVALID_ARGUMENT("Request deadline can't be zero");
+    }
+
+    /// Prevents copy and move construction and assignment
+    Impl(const Impl& that) =delete;
+    Impl(const Impl&& that) =delete;
+    Impl& operator =(const Impl& rhs) =delete;
+    Impl& operator =(const Impl&& rhs) =delete;
+
+    bool tryAssign(
+            const ChunkId&           chunkId,
+            const InetSockAddr&      peerAddr,
+            const ProdInfo::Priority priority)
+    {
+        LockGuard lock{mutex};
+        auto&     entry = entries[chunkId.pack()];
+        if (!entry.chunkId) {
+            entry.chunkId = chunkId;
+            entry.whenTracked = Clock::now();
+        }
+        entry.candidates.insert(peerAddr);
+        if (priority > entry.priority)
+            entry.priority = priority;
+        if (backpressure || entry.assignee || !hasRoom(peerAddr))
+            return false;
+        if (inHoldDown(entry, Clock::now())) {
+            // `getAssignment()` dispatches the chunk at its release time
+            cond.notify_all();
+            return false;
+        }
+        assign(entry, peerAddr);
+        cond.notify_all(); // Earliest deadline might have changed
+        return true;
+    }
+
+    void received(const ChunkId& chunkId)
+    {
+        LockGuard lock{mutex};
+        auto      iter = entries.find(chunkId.pack());
+        if (iter == entries.end())
+            return;
+        if (iter->second.assignee)
+            unassign(iter->second);
+        entries.erase(iter);
+        cond.notify_all(); // A request-window slot was freed
+    }
+
+    InetSockAddr cancelled(const ChunkId& chunkId)
+    {
+        LockGuard    lock{mutex};
+        InetSockAddr assignee{};
+        auto         iter = entries.find(chunkId.pack());
+        if (iter != entries.end()) {
+            /*
+             * The chunk arrived via another transport -- multicast beat the
+             * repair -- so the time it spent tracked samples the multicast
+             * reorder/latency window
+             */
+            sampleMcastLatency(iter->second.whenTracked);
+            if (iter->second.assignee) {
+                assignee = iter->second.assignee;
+                unassign(iter->second);
+            }
+            entries.erase(iter);
+            cond.notify_all(); // A request-window slot was freed
+        }
+        return assignee;
+    }
+
+    void setWindow(
+            const InetSockAddr& peerAddr,
+            const size_t        window)
+    {
+        LockGuard  lock{mutex};
+        const auto clamped = (window < 1)
+                ? 1
+                : (window > maxOutstanding) ? maxOutstanding : window;
+        windowSizes[peerAddr] = clamped;
+        cond.notify_all(); // The window might have grown
+    }
+
+    void peerStopped(const InetSockAddr& peerAddr)
+    {
+        LockGuard lock{mutex};
+        numOutstanding.erase(peerAddr);
+        windowSizes.erase(peerAddr);
+        for (auto& elt : entries) {
+            auto& entry = elt.second;
+            entry.candidates.erase(peerAddr);
+            if (entry.assignee == peerAddr)
+                entry.assignee = InetSockAddr{};
+        }
+        cond.notify_all(); // Unassigned chunks might now be assignable
+    }
+
+    void getAssignment(
+            ChunkId&      chunkId,
+            InetSockAddr& peerAddr)
+    {
+        UniqueLock lock{mutex};
+        for (;;) {
+            auto         now = Clock::now();
+            TimePoint    nextDeadline{};
+            bool         haveDeadline{false};
+            Entry*       bestEntry{nullptr};
+            InetSockAddr bestCandidate{};
+            double       bestFrac{0};
+            std::unordered_map<ProdIndex::type, double> fracCache{};
+            for (auto& elt : entries) {
+                auto& entry = elt.second;
+                if (!entry.assignee) {
+                    if (backpressure)
+                        continue; // New requests are withheld; chunk remains
+                                  // tracked for dispatch when pressure abates
+                    if (inHoldDown(entry, now)) {
+                        // Held down: wake at the release time to dispatch it
+                        const auto release = entry.whenTracked + holdDown();
+                        if (!haveDeadline || release < nextDeadline) {
+                            nextDeadline = release;
+                            haveDeadline = true;
+                        }
+                        continue;
+                    }
+                    /*
+                     * Deferred request: a candidate for the highest-priority
+                     * dispatchable chunk so lower-priority bulk can't starve
+                     * an urgent product. Within a priority class, the chunk
+                     * of the most nearly-complete product goes first:
+                     * finishing a 99%-complete product delivers a usable
+                     * product now, while spreading requests evenly across
+                     * products delivers nothing until much later.
+                     */
+                    if (bestEntry && entry.priority < bestEntry->priority)
+                        continue;
+                    const auto frac = completenessOf(entry, fracCache);
+                    if (bestEntry && entry.priority == bestEntry->priority &&
+                            frac <= bestFrac)
+                        continue;
+                    for (auto& candidate : entry.candidates) {
+                        if (hasRoom(candidate)) {
+                            bestEntry = &entry;
+                            bestCandidate = candidate;
+                            bestFrac = frac;
+                            break;
+                        }
+                    }
+                }
+                else {
+                    auto expires = entry.whenAssigned + deadline;
+                    if (expires <= now) {
+                        // Overdue request: re-issue to an alternative peer
+                        for (auto& candidate : entry.candidates) {
+                            if (!(candidate == entry.assignee) &&
+                                    hasRoom(candidate)) {
+                                unassign(entry);
+                                assign(entry, candidate);
+                                chunkId = entry.chunkId;
+                                peerAddr = candidate;
+                                return;
+                            }
+                        }
+                        // No alternative: re-issue to the same peer
+                        entry.whenAssigned = now;
+                        chunkId = entry.chunkId;
+                        peerAddr = entry.assignee;
+                        return;
+                    }
+                    if (!haveDeadline || expires < nextDeadline) {
+                        nextDeadline = expires;
+                        haveDeadline = true;
+                    }
+                }
+            }
+            if (bestEntry) {
+                assign(*bestEntry, bestCandidate);
+                chunkId = bestEntry->chunkId;
+                peerAddr = bestCandidate;
+                return;
+            }
+            Canceler canceler{};
+            if (haveDeadline) {
+                cond.wait_until(lock, nextDeadline);
+            }
+            else {
+                cond.wait(lock);
+            }
+        }
+    }
+
+    void setCompletenessFn(const CompletenessFn& fn)
+    {
+        LockGuard lock{mutex};
+        completenessFn = fn;
+    }
+
+    void setBackpressure(const bool enable)
+    {
+        LockGuard lock{mutex};
+        if (backpressure == enable)
+            return;
+        backpressure = enable;
+        if (!enable)
+            cond.notify_all(); // Withheld chunks might now be assignable
+    }
+
+    size_t size() const
+    {
+        LockGuard lock{mutex};
+        return entries.size();
+    }
+};
+
+ChunkReqScheduler::ChunkReqScheduler(
+        const unsigned maxOutstanding,
+        const unsigned deadline)
+    : pImpl{new Impl(maxOutstanding, deadline)}
+{}
+
+bool ChunkReqScheduler::tryAssign(
+        const ChunkId&           chunkId,
+        const InetSockAddr&      peerAddr,
+        const ProdInfo::Priority priority)
+{
+    return pImpl->tryAssign(chunkId, peerAddr, priority);
+}
+
+void ChunkReqScheduler::received(const ChunkId& chunkId)
+{
+    pImpl->received(chunkId);
+}
+
+InetSockAddr ChunkReqScheduler::cancelled(const ChunkId& chunkId)
+{
+    return pImpl->cancelled(chunkId);
+}
+
+void ChunkReqScheduler::setWindow(
+        const InetSockAddr& peerAddr,
+        const size_t        window)
+{
+    pImpl->setWindow(peerAddr, window);
+}
+
+void ChunkReqScheduler::peerStopped(const InetSockAddr& peerAddr)
+{
+    pImpl->peerStopped(peerAddr);
+}
+
+void ChunkReqScheduler::getAssignment(
+        ChunkId&      chunkId,
+        InetSockAddr& peerAddr)
+{
+    pImpl->getAssignment(chunkId, peerAddr);
+}
+
+void ChunkReqScheduler::setCompletenessFn(const CompletenessFn& completenessFn)
+{
+    pImpl->setCompletenessFn(completenessFn);
+}
+
+void ChunkReqScheduler::setBackpressure(const bool enable)
+{
+    pImpl->setBackpressure(enable);
+}
+
+size_t ChunkReqScheduler::size() const
+{
+    return pImpl->size();
+}
+
+} // namespace
@@ -0,0 +1,188 @@
+/**
+ * This file declares a thread-safe scheduler of chunk-requests that stripes
+ * outstanding requests across the remote peers that have announced each chunk.
+ * Each peer is given a bounded window of in-flight requests and a request
+ * that isn't satisfied by a deadline is re-issued to an alternative peer.
+ * New requests are held down for an adaptive estimate of the multicast
+ * reorder/latency window, so a datagram that's merely late isn't repaired
+ * over P2P at the cost of peer bandwidth; chunks of elevated-priority
+ * products bypass the hold-down.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All Rights
+ * reserved. See file "Copying" in the top-level source-directory for usage
+ * restrictions.
+ *
+ *        File: ChunkReqScheduler.h
+ *  Created on: Dec 14, 2017
+ *      Author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_COMMS_P2P_CHUNKREQSCHEDULER_H_
+#define MAIN_COMMS_P2P_CHUNKREQSCHEDULER_H_
+
+#include "Chunk.h"
+#include "InetSockAddr.h"
+#include "ProdInfo.h"
+
+#include <functional>
+#include <memory>
+
+namespace hycast {
+
+class ChunkReqScheduler final
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Type of the callback that returns the fraction of a product's
+     * data-chunks that have been received -- e.g., from the product-store.
+     * @see `setCompletenessFn()`
+     */
+    typedef std::function<double(const ProdIndex&)> CompletenessFn;
+
+    /**
+     * Constructs.
+     * @param[in] maxOutstanding   Maximum number of outstanding chunk-requests
+     *                             per remote peer
+     * @param[in] deadline         Number of seconds after which an outstanding
+     *                             chunk-request is re-issued
+     * @throws InvalidArgument     `maxOutstanding == 0 || deadline == 0`
+     */
+    ChunkReqScheduler(
+            const unsigned maxOutstanding,
+            const unsigned deadline);
+
+    /**
+     * Tries to assign a chunk-request to a remote peer that has announced the
+     * chunk. The assignment succeeds if the chunk isn't already assigned to
+     * another peer, the peer's request-window isn't full, and the chunk isn't
+     * being held down for a possibly-late multicast delivery; otherwise, the
+     * peer is recorded as a candidate for a deferred or re-issued request.
+     * The hold-down -- an adaptive estimate of the multicast
+     * reorder/latency window, fed by `cancelled()` and capped by the tunable
+     * `reqsched.<n>.max_holddown_ms` -- doesn't apply to chunks of
+     * elevated-priority products.
+     * @param[in] chunkId   Data-chunk identifier
+     * @param[in] peerAddr  Address of remote peer that has the chunk
+     * @param[in] priority  Priority class of the chunk's product. Deferred
+     *                      requests for higher-priority chunks are dispatched
+     *                      first by `getAssignment()`.
+     * @retval `true`       Peer should request the chunk
+     * @retval `false`      Peer shouldn't request the chunk (yet)
+     * @exceptionsafety     Strong guarantee
+     * @threadsafety        Safe
+     */
+    bool tryAssign(
+            const ChunkId&           chunkId,
+            const InetSockAddr&      peerAddr,
+            const ProdInfo::Priority priority = ProdInfo::defaultPriority);
+
+    /**
+     * Accepts the arrival of a chunk. The chunk's entry is deleted and a slot
+     * in the request-window of the peer to which the chunk was assigned is
+     * freed.
+     * @param[in] chunkId  Identifier of arrived data-chunk
+     * @exceptionsafety    Strong guarantee
+     * @threadsafety       Safe
+     */
+    void received(const ChunkId& chunkId);
+
+    /**
+     * Accepts the cancellation of interest in a chunk -- e.g., because the
+     * chunk arrived via another transport. The chunk's entry is deleted and
+     * a slot in the request-window of the peer to which the chunk was
+     * assigned, if any, is freed. The time the chunk spent tracked feeds the
+     * hold-down estimate of the multicast reorder/latency window.
+     * @param[in] chunkId  Identifier of unwanted data-chunk
+     * @return             Address of the remote peer to which the chunk was
+     *                     assigned. Invalid if the chunk wasn't assigned.
+     * @exceptionsafety    Strong guarantee
+     * @threadsafety       Safe
+     */
+    InetSockAddr cancelled(const ChunkId& chunkId);
+
+    /**
+     * Sets the request-window size for a remote peer -- e.g., from the
+     * kernel's congestion window for the peer's association, so requests are
+     * rerouted as soon as the transport reports congestion rather than after
+     * the deadline expires. The size is clamped to `[1, maxOutstanding]`.
+     * @param[in] peerAddr  Address of remote peer
+     * @param[in] window    Maximum number of outstanding chunk-requests for
+     *                      the peer
+     * @exceptionsafety     Strong guarantee
+     * @threadsafety        Safe
+     */
+    void setWindow(
+            const InetSockAddr& peerAddr,
+            const size_t        window);
+
+    /**
+     * Accepts the termination of a remote peer. Chunk-requests that were
+     * assigned to the peer become eligible for assignment to the remaining
+     * candidate peers.
+     * @param[in] peerAddr  Address of stopped remote peer
+     * @exceptionsafety     Strong guarantee
+     * @threadsafety        Safe
+     */
+    void peerStopped(const InetSockAddr& peerAddr);
+
+    /**
+     * Sets the callback that returns the fraction of a product's data-chunks
+     * that have been received. When set, deferred requests of equal priority
+     * are dispatched most-nearly-complete product first: finishing a
+     * 99%-complete product delivers a usable product now, while spreading
+     * requests evenly across products delivers nothing until much later.
+     * @param[in] completenessFn  Completeness callback. Called with this
+     *                            instance's lock held, so it must not call
+     *                            back into this instance.
+     * @exceptionsafety           Strong guarantee
+     * @threadsafety              Safe
+     */
+    void setCompletenessFn(const CompletenessFn& completenessFn);
+
+    /**
+     * Returns the next chunk-request to be issued. Blocks until an unassigned
+     * chunk can be assigned to a candidate peer whose request-window has room
+     * or an outstanding request passes its deadline, in which case the request
+     * is re-issued -- to an alternative candidate peer if one has room;
+     * otherwise, to the same peer. Deferred requests are dispatched by
+     * priority class and then -- if a completeness callback is set -- by the
+     * completeness of the chunk's product. This is a cancellation point.
+     * @param[out] chunkId   Data-chunk identifier
+     * @param[out] peerAddr  Address of remote peer that should request the
+     *                       chunk
+     * @exceptionsafety      Basic guarantee
+     * @threadsafety         Safe
+     * @see `setCompletenessFn()`
+     */
+    void getAssignment(
+            ChunkId&      chunkId,
+            InetSockAddr& peerAddr);
+
+    /**
+     * Enables or disables backpressure -- e.g., because a shared
+     * memory-budget reached its ceiling. While enabled, no new chunk-request
+     * is assigned or dispatched: `tryAssign()` only records the peer as a
+     * candidate and `getAssignment()` withholds unassigned chunks. Overdue
+     * requests are still re-issued so in-flight chunks complete. Withheld
+     * chunks are dispatched when backpressure is disabled.
+     * @param[in] enable  Whether to withhold new chunk-requests
+     * @exceptionsafety   Strong guarantee
+     * @threadsafety      Safe
+     */
+    void setBackpressure(const bool enable);
+
+    /**
+     * Returns the number of chunks being tracked.
+     * @return           Number of tracked chunks
+     * @exceptionsafety  Strong guarantee
+     * @threadsafety     Safe
+     */
+    size_t size() const;
+};
+
+} // namespace
+
+#endif /* MAIN_COMMS_P2P_CHUNKREQSCHEDULER_H_ */
@@ -0,0 +1,38 @@
+/**
+ * This file implements a receive-window credit message exchanged between
+ * peers.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: CreditMsg.cpp
+ * @author: Steven R. Emmerson
+ */
+
+#include "CreditMsg.h"
+
+namespace hycast {
+
+size_t CreditMsg::getSerialSize(unsigned version) const noexcept
+{
+    return getStaticSerialSize(version);
+}
+
+size_t CreditMsg::serialize(
+        Encoder&       encoder,
+        const unsigned version) const
+{
+    return encoder.encode(credit);
+}
+
+CreditMsg CreditMsg::deserialize(
+        Decoder&        decoder,
+        const unsigned  version)
+{
+    uint32_t credit;
+    decoder.decode(credit);
+    return CreditMsg(credit);
+}
+
+} // namespace
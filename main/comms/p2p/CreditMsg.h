@@ -0,0 +1,91 @@
+/**
+ * This file declares a receive-window credit message exchanged between peers.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: CreditMsg.h
+ * @author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_COMMS_P2P_CREDITMSG_H_
+#define MAIN_COMMS_P2P_CREDITMSG_H_
+
+#include "Codec.h"
+#include "Serializable.h"
+
+namespace hycast {
+
+/**
+ * Receive-window credit advertised by a peer: the number of further
+ * chunk-of-data messages the sending peer is prepared to absorb. The credit
+ * is absolute -- each advertisement replaces the previous one -- so the two
+ * sides can't drift apart. Exchanged only when both peers advertise
+ * `VersionMsg::FLOW_CONTROL`.
+ */
+class CreditMsg final : public Serializable<CreditMsg>
+{
+    uint32_t credit;
+
+public:
+    /**
+     * Constructs.
+     * @param[in] credit  Number of further chunk messages the sending peer
+     *                    is prepared to absorb
+     */
+    explicit CreditMsg(const uint32_t credit = 0)
+        : credit{credit}
+    {}
+
+    /**
+     * Returns the advertised credit.
+     * @return Number of further chunk messages the sending peer is prepared
+     *         to absorb
+     */
+    uint32_t getCredit() const noexcept
+    {
+        return credit;
+    }
+
+    /**
+     * Serializes this instance to an encoder.
+     * @param[in] encoder  Encoder
+     * @param[in] version  Protocol version
+     * @return Number of bytes written
+     * @exceptionsafety Basic guarantee
+     * @threadsafety    Safe
+     */
+    size_t serialize(
+            Encoder&       encoder,
+            const unsigned version) const;
+
+    size_t getSerialSize(unsigned version) const noexcept;
+
+    /**
+     * Returns the number of bytes in the serial representation of any
+     * instance.
+     * @param[in] version  Protocol version
+     * @return the number of bytes in the serial representation
+     */
+    static constexpr size_t getStaticSerialSize(const unsigned version)
+            noexcept {
+        return Codec::getSerialSize(sizeof(uint32_t));
+    }
+
+    /**
+     * Returns an instance corresponding to the serialized representation in a
+     * decoder.
+     * @param[in] decoder  Decoder
+     * @param[in] version  Protocol version
+     * @exceptionsafety Basic
+     * @threadsafety    Compatible but not thread-safe
+     */
+    static CreditMsg deserialize(
+            Decoder&        decoder,
+            const unsigned  version);
+};
+
+} // namespace
+
+#endif /* MAIN_COMMS_P2P_CREDITMSG_H_ */
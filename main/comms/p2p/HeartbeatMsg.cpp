@@ -0,0 +1,37 @@
+/**
+ * This file implements a liveness heartbeat message exchanged between peers.
+ *
+ * Copyright 2018 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: HeartbeatMsg.cpp
+ * @author: Steven R. Emmerson
+ */
+
+#include "HeartbeatMsg.h"
+
+namespace hycast {
+
+size_t HeartbeatMsg::getSerialSize(unsigned version) const noexcept
+{
+    return getStaticSerialSize(version);
+}
+
+size_t HeartbeatMsg::serialize(
+        Encoder&       encoder,
+        const unsigned version) const
+{
+    return encoder.encode(sequence);
+}
+
+HeartbeatMsg HeartbeatMsg::deserialize(
+        Decoder&        decoder,
+        const unsigned  version)
+{
+    uint32_t sequence;
+    decoder.decode(sequence);
+    return HeartbeatMsg(sequence);
+}
+
+} // namespace
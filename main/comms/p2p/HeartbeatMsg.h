@@ -0,0 +1,94 @@
+/**
+ * This file declares a liveness heartbeat message exchanged between peers.
+ *
+ * Copyright 2018 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: HeartbeatMsg.h
+ * @author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_COMMS_P2P_HEARTBEATMSG_H_
+#define MAIN_COMMS_P2P_HEARTBEATMSG_H_
+
+#include "Codec.h"
+#include "Serializable.h"
+
+namespace hycast {
+
+/**
+ * Liveness heartbeat sent by a peer whose association has been idle: its
+ * arrival -- not its content -- proves the sending process is alive, so a
+ * silently-dead remote peer (e.g., a NIC failure that produces no RST) is
+ * detected within a few heartbeat intervals instead of waiting out the
+ * worst-peer replacement cycle. Any other message proves liveness equally
+ * well, so heartbeats are sent only when no other traffic is flowing.
+ * Exchanged only when both peers advertise `VersionMsg::HEARTBEATS`.
+ */
+class HeartbeatMsg final : public Serializable<HeartbeatMsg>
+{
+    uint32_t sequence;
+
+public:
+    /**
+     * Constructs.
+     * @param[in] sequence  Number of heartbeats sent on the association,
+     *                      including this one. Aids debugging of liveness
+     *                      problems; the receiver otherwise ignores it.
+     */
+    explicit HeartbeatMsg(const uint32_t sequence = 0)
+        : sequence{sequence}
+    {}
+
+    /**
+     * Returns the heartbeat sequence number.
+     * @return Number of heartbeats sent on the association, including this
+     *         one
+     */
+    uint32_t getSequence() const noexcept
+    {
+        return sequence;
+    }
+
+    /**
+     * Serializes this instance to an encoder.
+     * @param[in] encoder  Encoder
+     * @param[in] version  Protocol version
+     * @return Number of bytes written
+     * @exceptionsafety Basic guarantee
+     * @threadsafety    Safe
+     */
+    size_t serialize(
+            Encoder&       encoder,
+            const unsigned version) const;
+
+    size_t getSerialSize(unsigned version) const noexcept;
+
+    /**
+     * Returns the number of bytes in the serial representation of any
+     * instance.
+     * @param[in] version  Protocol version
+     * @return the number of bytes in the serial representation
+     */
+    static constexpr size_t getStaticSerialSize(const unsigned version)
+            noexcept {
+        return Codec::getSerialSize(sizeof(uint32_t));
+    }
+
+    /**
+     * Returns an instance corresponding to the serialized representation in a
+     * decoder.
+     * @param[in] decoder  Decoder
+     * @param[in] version  Protocol version
+     * @exceptionsafety Basic
+     * @threadsafety    Compatible but not thread-safe
+     */
+    static HeartbeatMsg deserialize(
+            Decoder&        decoder,
+            const unsigned  version);
+};
+
+} // namespace
+
+#endif /* MAIN_COMMS_P2P_HEARTBEATMSG_H_ */
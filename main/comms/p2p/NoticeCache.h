@@ -0,0 +1,102 @@
+/**
+ * This file declares a cache of the serialized form of a notice that is
+ * fanned out to many peers. Notifying N peers of the same chunk or product
+ * used to serialize the identical message N times through N encoders; the
+ * cache serializes it once per wire-encoding and every peer's send path
+ * writes the shared bytes directly, the per-association differences (stream
+ * identifier, partial-reliability lifetime) being applied outside the
+ * payload by the channel. Notice fan-out is the highest-frequency send
+ * operation, so this divides its codec cost by the number of peers.
+ *
+ * Copyright 2018 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: NoticeCache.h
+ * @author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_COMMS_P2P_NOTICECACHE_H_
+#define MAIN_COMMS_P2P_NOTICECACHE_H_
+
+#include "Codec.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace hycast {
+
+/**
+ * Lazily-built cache of a notice's serialized form, one entry per
+ * wire-encoding in use (the fixed-width encoding and the compact one), so a
+ * mixed set of peers still serializes each variant only once. An instance
+ * belongs to a single send-action, which is shared -- reference-counted --
+ * by every peer's send-queue.
+ */
+class NoticeCache final
+{
+public:
+    /// A reference-counted, immutable serial buffer
+    typedef std::shared_ptr<const std::vector<char>> Buffer;
+
+    /// Number of wire-encodings the cache covers. An encoding version
+    /// beyond this isn't cached; the caller serializes as usual.
+    static const unsigned NUM_VERSIONS = 2;
+
+private:
+    /// Guards `buffers`. Contended only when peers' sender threads race to
+    /// build the same entry, in which case the loser's work is discarded.
+    mutable std::mutex mutex;
+    mutable Buffer     buffers[NUM_VERSIONS];
+
+public:
+    NoticeCache()
+        : mutex{}
+        , buffers{}
+    {}
+
+    /// An instance belongs to one send-action; prevent copy and assignment
+    NoticeCache(const NoticeCache& that) =delete;
+    NoticeCache& operator=(const NoticeCache& rhs) =delete;
+
+    /**
+     * Returns the serialized form of an object under a given wire-encoding,
+     * building and caching it on first use. All callers must pass the same
+     * object: the cache doesn't compare it against the cached bytes.
+     * @param[in] obj      Object to be serialized
+     * @param[in] version  Wire-encoding (protocol) version
+     * @return             Shared serial buffer or an empty pointer if the
+     *                     version isn't cacheable, in which case the caller
+     *                     should serialize as usual
+     * @exceptionsafety    Strong guarantee
+     * @threadsafety       Safe
+     */
+    template<class T>
+    Buffer get(
+            const T&       obj,
+            const unsigned version) const
+    {
+        if (version >= NUM_VERSIONS)
+            return Buffer{};
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            if (buffers[version])
+                return buffers[version];
+        }
+        // Serialized outside the lock so racing builders don't convoy
+        auto buf = std::make_shared<std::vector<char>>(
+                obj.getSerialSize(version));
+        MemEncoder encoder{buf->data(), buf->size()};
+        obj.serialize(encoder, version);
+        encoder.flush();
+        std::lock_guard<std::mutex> lock{mutex};
+        if (!buffers[version])
+            buffers[version] = buf;
+        return buffers[version];
+    }
+};
+
+} // namespace
+
+#endif /* MAIN_COMMS_P2P_NOTICECACHE_H_ */
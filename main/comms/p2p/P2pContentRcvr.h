@@ -17,6 +17,8 @@
 #include "Chunk.h"
 #include "ProdInfo.h"
 
+#include <vector>
+
 namespace hycast {
 
 class P2pContentRcvr
@@ -41,6 +43,51 @@ public:
     virtual RecvStatus receive(
             LatentChunk&        chunk,
             const InetSockAddr& peerAddr) =0;
+
+    /**
+     * Receives a small, complete data-product as a single combined
+     * product-information and data message. The default implementation
+     * decomposes the message into a product-information reception and a
+     * data-chunk reception; a receiver backed by the product-store overrides
+     * it so the product costs a single store insertion.
+     * @param[in] smallProd  Small, complete data-product
+     * @param[in] peerAddr   Address of remote peer
+     */
+    virtual RecvStatus receive(
+            LatentSmallProd&    smallProd,
+            const InetSockAddr& peerAddr)
+    {
+        const ProdInfo    prodInfo = smallProd.getInfo();
+        std::vector<char> data(prodInfo.getSize());
+        smallProd.drainData(data.data(), data.size());
+        receive(prodInfo, peerAddr);
+        LatentChunk chunk{ChunkInfo{prodInfo, 0}, data.data()};
+        auto        status = receive(chunk, peerAddr);
+        if (chunk.hasData())
+            chunk.discard();
+        return status;
+    }
+
+    /**
+     * Receives a batch of chunks-of-data that arrived together (e.g., in a
+     * chunk-run message). The default implementation receives the chunks one
+     * at a time; a receiver backed by the product-store overrides it so the
+     * store can group the batch by shard and product and take each lock
+     * once.
+     * @param[in]  chunks     Batch of data-chunks
+     * @param[in]  numChunks  Number of chunks in the batch
+     * @param[out] statuses   Status of each reception, parallel to `chunks`
+     * @param[in]  peerAddr   Address of remote peer
+     */
+    virtual void receive(
+            LatentChunk* const  chunks,
+            const size_t        numChunks,
+            RecvStatus* const   statuses,
+            const InetSockAddr& peerAddr)
+    {
+        for (size_t i = 0; i < numChunks; ++i)
+            statuses[i] = receive(chunks[i], peerAddr);
+    }
 };
 
 } // namespace
@@ -14,18 +14,27 @@
 
 #include "Completer.h"
 #include "error.h"
+#include "Metrics.h"
+#include "PeerGossip.h"
 #include "PeerSetServer.h"
 #include "P2pMgr.h"
 #include "P2pMgrServer.h"
+#include "PeerProber.h"
 #include "PeerSet.h"
 #include "PeerSource.h"
 #include "Thread.h"
+#include "Tunables.h"
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <list>
+#include <map>
 #include <mutex>
 #include <set>
+#include <thread>
+#include <vector>
 
 namespace hycast {
 
@@ -72,6 +81,79 @@ class P2pMgr::Impl final : public Notifier, public PeerSetServer
     Mutex                     peerSetMutex;
     Cond                      peerSetCond;
 
+    /// Maximum number of concurrent connection attempts to peer candidates
+    static const unsigned     maxConcurrentConnects = 4;
+
+    /// Deadline, in seconds, on a single connection attempt. An unresponsive
+    /// candidate is abandoned -- and requeued for a later try -- at its
+    /// deadline so that it can't stall the walk of the candidate list.
+    static const unsigned     connectDeadlineSecs = 10;
+
+    /// Head start, in milliseconds, given to the preferred address family's
+    /// connection attempt before the fallback family's attempt is started
+    /// (RFC 8305's connection-attempt delay)
+    static const unsigned     familyStaggerMs = 250;
+
+    /// Maximum number of consecutive candidates that may be deferred because
+    /// their subnet is already represented. Bounds the preference for path
+    /// diversity so a single-subnet candidate list can't stall the adder.
+    static const unsigned     maxDiversityDeferrals = 8;
+
+    /// Delay, in seconds, before a deferred same-subnet candidate becomes
+    /// available again
+    static const unsigned     diversityDeferralSecs = 2;
+
+    /// Default rate, in connections per second, at which the peer-server
+    /// admits accepted connections. Adjustable at runtime via the tunable
+    /// `p2p.<n>.accept_rate`.
+    static constexpr double   defaultAcceptRate = 20;
+
+    /// Number of admissions that may proceed unpaced after a quiet period,
+    /// so pacing doesn't delay the occasional single reconnection
+    static const unsigned     acceptBurst = 8;
+
+    /// Fraction of an admission charge refunded for a connection that
+    /// resumes a prior association: its server-side session state already
+    /// exists, so admitting it is cheaper, and established members regain
+    /// the swarm ahead of strangers
+    static constexpr double   resumeRefund = 0.5;
+
+    /// An outstanding attempt to connect to a peer candidate
+    struct ConnectAttempt
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        /// Socket address of the peer candidate
+        InetSockAddr      peerAddr;
+        /// Thread making the attempt
+        Thread            thread;
+        /// When the attempt should be abandoned
+        Clock::time_point deadline;
+        /// Whether the attempt has finished
+        bool              done;
+
+        explicit ConnectAttempt(const InetSockAddr& peerAddr)
+            : peerAddr{peerAddr}
+            , thread{}
+            , deadline{Clock::now() +
+                    std::chrono::seconds{connectDeadlineSecs}}
+            , done{false}
+        {}
+    };
+
+    /// Concurrent access variables for connection attempts:
+    Mutex                     connectMutex;
+    Cond                      connectCond;
+
+    /// Outstanding connection attempts
+    std::list<ConnectAttempt> connectAttempts;
+
+    /// Maximum number of standby candidates that may be probed concurrently
+    static const unsigned     maxStandbyProbes = 2;
+
+    /// Number of candidates currently being probed. Guarded by `connectMutex`.
+    unsigned                  numProbing;
+
     /// Maximum number of peers:
     unsigned                  maxPeers;
 
@@ -81,12 +163,60 @@ class P2pMgr::Impl final : public Notifier, public PeerSetServer
     /// Remote socket address of initiated peers
     std::set<InetSockAddr>    initiatedPeers;
 
+    /// Concurrent access variables for the local node's product filter:
+    mutable Mutex             filterMutex;
+
+    /// Product filter of the local node, sent to every new peer. Guarded by
+    /// `filterMutex`.
+    ProdFilter                prodFilter;
+
+    /// Interfaces across which initiated peer-connections are striped. May be
+    /// empty, in which case the routing table picks the source interface.
+    InterfaceSet              interfaces;
+
+    /// DSCP, in [0,63], applied to peer-connections. 0 => unmarked
+    const unsigned            dscp;
+
+    /// Concurrent access variable for the admission state:
+    mutable Mutex             admitMutex;
+
+    /// Rate, in connections per second, at which the peer-server admits
+    /// accepted connections, or 0 for unpaced admission. When a regional
+    /// outage ends, hundreds of downstream peers reconnect to the same few
+    /// servers within seconds -- exactly when backlog service begins -- so
+    /// admission is paced and the excess waits in the kernel's listen
+    /// backlog. Guarded by `admitMutex`.
+    double                    acceptRate;
+
+    /// Admission tokens currently accrued, in connections. Guarded by
+    /// `admitMutex`.
+    double                    admitTokens;
+
+    /// When admission tokens were last accrued. Guarded by `admitMutex`.
+    std::chrono::steady_clock::time_point admitTime;
+
+    /// Handle of the accept-rate tunable
+    Tunables::Handle          acceptRateTunable;
+
+    /// Source address of each striped peer-connection. Guarded by
+    /// `peerSetMutex`.
+    std::map<InetSockAddr, InetAddr> peerSrcAddrs;
+
+    /// Session token issued by each remote peer-server, presented on the
+    /// next connection to it so the server resumes the prior association's
+    /// session state. Guarded by `peerSetMutex`.
+    std::map<InetSockAddr, uint64_t> resumeTokens;
+
     /// Exception that caused failure:
     std::exception_ptr        exception;
 
     /// Thread on which local peers are initiated:
     Thread                    peerAddrThread;
 
+    /// Thread that joins completed connection attempts and abandons overdue
+    /// ones:
+    Thread                    connectReaperThread;
+
     /// Thread on which remote peers are accepted:
     Thread                    serverThread;
 
@@ -107,12 +237,73 @@ class P2pMgr::Impl final : public Notifier, public PeerSetServer
             std::rethrow_exception(exception);
     }
 
+    /**
+     * Admits an accepted connection: delays until an admission token has
+     * accrued and consumes it. Called before each `accept()`, so deferred
+     * connections are held by the kernel's listen backlog -- which it keeps
+     * cheaply -- instead of each becoming a peer the moment it lands. This
+     * is a cancellation point.
+     * @exceptionsafety  Basic guarantee
+     * @threadsafety     Safe
+     */
+    void admit()
+    {
+        typedef std::chrono::steady_clock     Clock;
+        typedef std::chrono::duration<double> Seconds;
+        for (;;) {
+            Seconds wait{0};
+            {
+                LockGuard  lock{admitMutex};
+                const auto now = Clock::now();
+                if (acceptRate <= 0) {
+                    admitTime = now;
+                    return; // Admission isn't paced
+                }
+                admitTokens += Seconds{now - admitTime}.count() * acceptRate;
+                if (admitTokens > acceptBurst)
+                    admitTokens = acceptBurst;
+                admitTime = now;
+                if (admitTokens >= 1) {
+                    admitTokens -= 1;
+                    return;
+                }
+                wait = Seconds{(1 - admitTokens) / acceptRate};
+            }
+            static auto& deferrals = Metrics::getCounter(
+                    "hycast_p2p_admissions_deferred_total",
+                    "Number of times admission of an incoming peer-connection "
+                    "was deferred by accept-pacing");
+            deferrals.add();
+            Canceler canceler{};
+            std::this_thread::sleep_for(wait);
+        }
+    }
+
+    /**
+     * Refunds part of an admission charge: called for a connection that
+     * resumed a prior association, so resuming sessions are admitted ahead
+     * of new ones during a reconnection storm.
+     * @exceptionsafety  Nothrow
+     * @threadsafety     Safe
+     */
+    void refundResumedAdmission() noexcept
+    {
+        LockGuard lock{admitMutex};
+        admitTokens += resumeRefund;
+        if (admitTokens > acceptBurst)
+            admitTokens = acceptBurst;
+    }
+
     /**
      * Runs the server for connections from remote peers. Creates a
      * corresponding local peer and attempts to add it to the set of active
-     * peers if and only if at least one initiated peer exists. Doesn't return
-     * unless an exception is thrown. Intended to run on its own thread, which
-     * can be safely canceled.
+     * peers if and only if at least one initiated peer exists. Admission is
+     * paced: an accepted connection consumes an admission token, a
+     * connection that resumes a prior association is refunded part of the
+     * charge, and when no token is available the excess reconnections wait
+     * in the kernel's listen backlog. Doesn't return unless an exception is
+     * thrown. Intended to run on its own thread, which can be safely
+     * canceled.
      * @exceptionsafety Basic guarantee
      * @threadsafety    Compatible but not safe
      */
@@ -123,13 +314,21 @@ class P2pMgr::Impl final : public Notifier, public PeerSetServer
                 SrvrSctpSock serverSock{serverSockAddr, Peer::getNumStreams()};
                 serverSock.listen();
                 for (;;) {
+                    admit(); // Might block
                     auto sock = serverSock.accept(); // Blocks
                     LockGuard lock(peerSetMutex);
                     try {
+                        if (dscp)
+                            sock.setDscp(dscp);
                         Peer peer{sock};
-                        if (peerSet.tryInsert(peer)) // Might block
+                        if (peer.getResumeToken())
+                            refundResumedAdmission();
+                        if (peerSet.tryInsert(peer)) { // Might block
                             LOG_NOTE("Accepted connection from remote peer " +
                                     peer.getRemoteAddr().to_string());
+                            sendGossip(peer);
+                            sendFilter(peer);
+                        }
                     }
                     catch (const std::exception& e) {
                         log_warn(e); // Possibly incompatible protocol versions
@@ -146,13 +345,284 @@ class P2pMgr::Impl final : public Notifier, public PeerSetServer
         }
     }
 
+    /**
+     * Sends what the source of potential peers knows about the
+     * best-performing peers to a newly-connected remote peer. Does nothing if
+     * the source doesn't track performance. Failure is logged but not thrown
+     * because gossip is advisory.
+     * @param[in] peer  Newly-connected remote peer
+     */
+    void sendGossip(Peer& peer)
+    {
+        try {
+            PeerGossip gossip{};
+            for (const auto& elt : peerSource.getBest(PeerGossip::maxEntries))
+                gossip.add(elt.first, elt.second);
+            if (gossip.size() > 0)
+                peer.gossip(gossip);
+        }
+        catch (const std::exception& e) {
+            log_warn(e);
+        }
+    }
+
+    /**
+     * Sends the local node's product filter to a newly-connected remote
+     * peer. Does nothing if no filter has been set. Failure is logged but
+     * not thrown because a missed filter only costs unwanted notices.
+     * @param[in] peer  Newly-connected remote peer
+     */
+    void sendFilter(Peer& peer)
+    {
+        try {
+            ProdFilter filter{};
+            {
+                LockGuard lock{filterMutex};
+                filter = prodFilter;
+            }
+            if (filter)
+                peer.setFilter(filter);
+        }
+        catch (const std::exception& e) {
+            log_warn(e);
+        }
+    }
+
+    /**
+     * Vets a connected peer candidate against the worst-performing active
+     * peer. Does nothing if the set of active peers isn't full or if
+     * `maxStandbyProbes` candidates are already being probed. Otherwise, the
+     * candidate is held as a standby connection and probed -- its notice
+     * latency and notice rate measured without requesting any data -- and is
+     * cleared for promotion only if its estimated score beats the incumbent's,
+     * so replacement is a measured upgrade instead of a gamble. A losing
+     * candidate is requeued with its measured score.
+     * @param[in] peerAddr  Socket address of remote peer candidate
+     * @param[in] peer      Connected peer candidate
+     * @retval `true`       Candidate may be inserted into the set of active
+     *                      peers
+     * @retval `false`      Candidate lost to the incumbent and was requeued
+     */
+    bool vetCandidate(
+            const InetSockAddr& peerAddr,
+            Peer&               peer)
+    {
+        if (!peerSet.isFull())
+            return true; // There's room: nothing would be replaced
+        {
+            LockGuard lock{connectMutex};
+            if (numProbing >= maxStandbyProbes)
+                return true; // No probe slot: fall back to unprobed insertion
+            ++numProbing;
+            // Probing extends the attempt past the connect deadline
+            for (auto& attempt : connectAttempts)
+                if (attempt.peerAddr == peerAddr && !attempt.done)
+                    attempt.deadline += std::chrono::seconds{
+                            PeerProber::defaultProbeDuration};
+        }
+        double candidateScore;
+        try {
+            // Cancelable so an overdue probe can be abandoned by the reaper
+            Canceler canceler{};
+            candidateScore = PeerProber{}.probe(peer);
+        }
+        catch (...) {
+            LockGuard lock{connectMutex};
+            --numProbing;
+            throw;
+        }
+        {
+            LockGuard lock{connectMutex};
+            --numProbing;
+        }
+        const auto worstScore = peerSet.getWorstScore();
+        if (candidateScore > worstScore)
+            return true;
+        LOG_NOTE("Probed peer candidate " + peerAddr.to_string() +
+                " scored " + std::to_string(candidateScore) +
+                " versus incumbent's " + std::to_string(worstScore) +
+                ": deferring replacement");
+        peerSource.learn(peerAddr, candidateScore, stasisDuration);
+        return false;
+    }
+
+    /**
+     * Creates a client-side SCTP socket in the given address family,
+     * configured for an initiated connection, and connects it. Blocks until
+     * connected.
+     * @param[in] family    Address family of the remote endpoint
+     * @param[in] sockAddr  Socket address of the remote endpoint
+     * @return              Connected socket
+     * @throw SystemError   Connection failure
+     */
+    SctpSock connectSock(
+            const int           family,
+            const InetSockAddr& sockAddr)
+    {
+        SctpSock sock{family, Peer::getNumStreams()};
+        if (dscp)
+            sock.setDscp(dscp);
+        sock.connect(sockAddr);
+        return sock;
+    }
+
+    /**
+     * Connects to a peer candidate. A candidate with addresses in both
+     * families is raced in the happy-eyeballs manner (RFC 8305): the IPv6
+     * attempt starts first, the IPv4 attempt starts `familyStaggerMs` later,
+     * and the first association established wins -- so a candidate whose
+     * preferred family's path is broken costs the stagger instead of a full
+     * connection timeout. The losing attempt is canceled and its association,
+     * if any, is closed. Blocks until connected or until every family's
+     * attempt has failed.
+     * @param[in] peerAddr  Socket address of the remote peer candidate
+     * @return              Connected socket
+     * @throw RuntimeError  Every family's attempt failed
+     */
+    SctpSock raceConnect(const InetSockAddr& peerAddr)
+    {
+        // Concrete socket address of each family, preferred family first
+        std::vector<std::pair<int, InetSockAddr>> famAddrs;
+        const auto inetAddr = peerAddr.getInetAddr();
+        InetAddr   famAddr;
+        if (inetAddr.getInetAddr(AF_INET6, famAddr))
+            famAddrs.emplace_back(AF_INET6,
+                    InetSockAddr{famAddr, peerAddr.getPort()});
+        if (inetAddr.getInetAddr(AF_INET, famAddr))
+            famAddrs.emplace_back(AF_INET,
+                    InetSockAddr{famAddr, peerAddr.getPort()});
+        if (famAddrs.empty())
+            throw RUNTIME_ERROR("No usable address for peer candidate " +
+                    peerAddr.to_string());
+        if (famAddrs.size() == 1)
+            return connectSock(famAddrs[0].first, famAddrs[0].second);
+        struct Race {
+            Mutex    mutex;
+            Cond     cond;
+            SctpSock winner;
+            bool     haveWinner;
+            unsigned numFailed;
+            Race()
+                : mutex{}
+                , cond{}
+                , winner{}
+                , haveWinner{false}
+                , numFailed{0}
+            {}
+        } race;
+        /*
+         * The attempt threads are destroyed -- canceled and joined -- before
+         * `race`, so they can't dangle if this function unwinds (e.g., when
+         * the whole attempt is abandoned at its deadline).
+         */
+        std::list<Thread> attempts;
+        UniqueLock        lock{race.mutex};
+        unsigned          numStarted = 0;
+        for (size_t i = 0; i < famAddrs.size(); ++i) {
+            const int          family = famAddrs[i].first;
+            const InetSockAddr sockAddr = famAddrs[i].second;
+            attempts.push_back(Thread{[this, &race, family, sockAddr] {
+                try {
+                    auto sock = connectSock(family, sockAddr);
+                    LockGuard lock{race.mutex};
+                    if (!race.haveWinner) {
+                        race.winner = sock;
+                        race.haveWinner = true;
+                    } // Else the losing association closes with `sock`
+                }
+                catch (const std::exception& e) {
+                    log_warn(e);
+                    LockGuard lock{race.mutex};
+                    ++race.numFailed;
+                }
+                race.cond.notify_one();
+            }});
+            ++numStarted;
+            if (i + 1 == famAddrs.size())
+                break;
+            // The preferred family gets a head start
+            const auto fallbackTime = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds{familyStaggerMs};
+            while (!race.haveWinner && race.numFailed < numStarted) {
+                Canceler canceler{};
+                if (race.cond.wait_until(lock, fallbackTime) ==
+                        std::cv_status::timeout)
+                    break;
+            }
+            if (race.haveWinner)
+                break;
+        }
+        while (!race.haveWinner && race.numFailed < numStarted) {
+            Canceler canceler{};
+            race.cond.wait(lock);
+        }
+        if (!race.haveWinner)
+            throw RUNTIME_ERROR("Couldn't connect to peer candidate " +
+                    peerAddr.to_string() + " in any address family");
+        return race.winner;
+    }
+
+    /**
+     * Creates an initiated peer. If this instance has a set of interfaces,
+     * then a source interface is picked by policy and the connection is bound
+     * to it so initiated peers stripe across the interfaces; otherwise, the
+     * candidate's address families are raced and the first established
+     * association wins. A configured DSCP is applied before connecting.
+     * Blocks until connected and versions exchanged.
+     * @param[in] peerAddr  Socket address of remote peer
+     * @return              Corresponding local peer
+     * @throw RuntimeError  Couldn't create peer
+     * @throw SystemError   Connection failure
+     */
+    /**
+     * Returns the session token to present to a remote peer-server: the
+     * token it issued on the previous association or 0 if this is the first
+     * connection to it.
+     * @param[in] peerAddr  Socket address of remote peer-server
+     * @return              Session token to present or 0 for none
+     */
+    uint64_t getResumeToken(const InetSockAddr& peerAddr)
+    {
+        LockGuard lock(peerSetMutex);
+        auto      iter = resumeTokens.find(peerAddr);
+        return (iter == resumeTokens.end()) ? 0 : iter->second;
+    }
+
+    Peer makePeer(const InetSockAddr& peerAddr)
+    {
+        const auto resumeToken = getResumeToken(peerAddr);
+        if (!interfaces) {
+            auto sock = raceConnect(peerAddr);
+            return Peer{sock, resumeToken};
+        }
+        auto srcAddr = interfaces.acquire(AF_INET);
+        try {
+            SctpSock sock{Peer::getNumStreams()};
+            sock.setSrcAddr(srcAddr);
+            if (dscp)
+                sock.setDscp(dscp);
+            sock.connect(peerAddr);
+            Peer peer{sock, resumeToken};
+            LockGuard lock(peerSetMutex);
+            peerSrcAddrs[peerAddr] = srcAddr;
+            return peer;
+        }
+        catch (const std::exception& e) {
+            interfaces.release(srcAddr);
+            throw;
+        }
+    }
+
     /**
      * Tries to insert a remote peer given its Internet socket address. The peer
      * will be an *initiated* peer (i.e., one whose connection was initiated by
-     * this instance).
+     * this instance). If the set of active peers is full, then the candidate
+     * is first probed and is inserted only if its estimated performance score
+     * beats that of the worst active peer.
      * @param[in]     peerAddr   Socket address of remote peer candidate
      * @return `true`            Peer was added
      * @return `false`           Peer wasn't added because it's already a member
+     *                           or because it lost to the worst active peer
      * @throw RuntimeError       Couldn't add peer
      * @exceptionsafety          Strong guarantee
      * @threadsafety             Safe
@@ -161,9 +631,28 @@ class P2pMgr::Impl final : public Notifier, public PeerSetServer
     {
         bool success;
     	try {
-            // Blocks until connected and versions exchanged
-            Peer peer{peerAddr};
+            Peer peer{};
+            {
+                /*
+                 * Blocks until connected and versions exchanged. The attempt
+                 * thread is cancelable only here so that an unresponsive
+                 * candidate can be abandoned at its deadline without
+                 * corrupting the set of active peers.
+                 */
+                Canceler canceler{};
+                peer = makePeer(peerAddr);
+            }
+            if (!vetCandidate(peerAddr, peer))
+                return false; // Connection closes when `peer` is destroyed
             success = peerSet.tryInsert(peer); // Might block
+            if (success) {
+                sendGossip(peer);
+                sendFilter(peer);
+                // Present the remote's token on the next reconnection so the
+                // prior association's backlog cursor is resumed
+                LockGuard lock(peerSetMutex);
+                resumeTokens[peerAddr] = peer.getRemoteSessionToken();
+            }
         }
         catch (const std::exception& e) {
             std::throw_with_nested(RuntimeError{__FILE__, __LINE__,
@@ -174,28 +663,105 @@ class P2pMgr::Impl final : public Notifier, public PeerSetServer
     }
 
     /**
-     * Attempts to add peers to the set of active peers. Doesn't return unless
-     * an exception is thrown. Intended to run on its own thread, which can be
-     * safely canceled.
+     * Attempts to connect to a single peer candidate and to add the resulting
+     * peer to the set of active peers. Failure is logged and the candidate is
+     * requeued for a later attempt. Intended to run on its own thread, which
+     * can be safely canceled while connecting.
+     * @param[in] peerAddr  Socket address of peer candidate
+     */
+    void connectToPeer(const InetSockAddr peerAddr)
+    {
+        try {
+            try {
+                if (tryInsert(peerAddr)) { // Blocks
+                    LOG_NOTE("Initiated connection to remote peer " +
+                            peerAddr.to_string());
+                    // Peer wasn't a member of active set
+                    LockGuard lock(peerSetMutex);
+                    initiatedPeers.insert(peerAddr);
+                }
+            }
+            catch (const std::exception& e) {
+                log_warn(e);
+                // Try again later
+                peerSource.push(peerAddr, stasisDuration);
+            }
+            LockGuard lock{connectMutex};
+            for (auto& attempt : connectAttempts) {
+                if (attempt.peerAddr == peerAddr && !attempt.done) {
+                    attempt.done = true;
+                    break;
+                }
+            }
+            connectCond.notify_all();
+        }
+        catch (const std::exception& e) {
+            setException();
+        }
+    }
+
+    /**
+     * Indicates if a peer candidate's subnet is already represented among the
+     * initiated peers or the in-flight connection attempts. Such a candidate
+     * likely shares a network path with an existing peer, so connecting to it
+     * adds little repair capacity during regional congestion.
+     * @param[in] peerAddr  Socket address of peer candidate
+     * @retval `true`       A peer in the candidate's subnet exists
+     * @retval `false`      No peer in the candidate's subnet exists
+     */
+    bool subnetRepresented(const InetSockAddr& peerAddr)
+    {
+        const auto subnet = peerAddr.getInetAddr().getSubnetId();
+        {
+            LockGuard lock(peerSetMutex);
+            for (const auto& addr : initiatedPeers)
+                if (addr.getInetAddr().getSubnetId() == subnet)
+                    return true;
+        }
+        LockGuard lock{connectMutex};
+        for (const auto& attempt : connectAttempts)
+            if (!attempt.done &&
+                    attempt.peerAddr.getInetAddr().getSubnetId() == subnet)
+                return true;
+        return false;
+    }
+
+    /**
+     * Attempts to add peers to the set of active peers. Candidates are
+     * connected-to concurrently -- up to `maxConcurrentConnects` at a time --
+     * so that the many round-trips of one handshake overlap those of the
+     * others and a single unresponsive candidate can't stall the walk of the
+     * candidate list. Doesn't return unless an exception is thrown. Intended
+     * to run on its own thread, which can be safely canceled.
      */
     void runPeerAdder()
     {
         try {
+            unsigned numDeferrals = 0;
             for (;;) {
                 auto peerAddr = peerSource.pop(); // Blocks. Cancellation point
-                try {
-                    if (tryInsert(peerAddr)) { // Blocks
-                        LOG_NOTE("Initiated connection to remote peer " +
-                                peerAddr.to_string());
-                        // Peer wasn't a member of active set
-                        initiatedPeers.insert(peerAddr);
-                    }
+                /*
+                 * Prefer path diversity: a candidate whose subnet is already
+                 * represented is deferred -- boundedly -- so candidates on
+                 * other network paths get the next attempt slots and the set
+                 * of active peers doesn't converge on one congested path.
+                 */
+                if (numDeferrals < maxDiversityDeferrals &&
+                        !peerSource.empty() && subnetRepresented(peerAddr)) {
+                    ++numDeferrals;
+                    peerSource.push(peerAddr, diversityDeferralSecs);
+                    continue;
                 }
-                catch (const std::exception& e) {
-                    log_warn(e);
-                    // Try again later
-                    peerSource.push(peerAddr, stasisDuration);
+                numDeferrals = 0;
+                UniqueLock lock{connectMutex};
+                // Wait for one of the concurrent attempt slots
+                while (connectAttempts.size() >= maxConcurrentConnects) {
+                    Canceler canceler{};
+                    connectCond.wait(lock);
                 }
+                connectAttempts.emplace_back(peerAddr);
+                connectAttempts.back().thread =
+                        Thread{[this,peerAddr]{connectToPeer(peerAddr);}};
             }
         }
         catch (std::exception& e) {
@@ -210,19 +776,87 @@ class P2pMgr::Impl final : public Notifier, public PeerSetServer
         }
     }
 
+    /**
+     * Joins completed connection attempts and abandons attempts that pass
+     * their deadline, requeueing the abandoned candidates for a later try.
+     * Doesn't return unless an exception is thrown. Intended to run on its
+     * own thread, which can be safely canceled.
+     */
+    void runConnectReaper()
+    {
+        try {
+            UniqueLock lock{connectMutex};
+            for (;;) {
+                bool reaped = true;
+                while (reaped) {
+                    reaped = false;
+                    const auto now = ConnectAttempt::Clock::now();
+                    for (auto iter = connectAttempts.begin();
+                            iter != connectAttempts.end(); ++iter) {
+                        const bool overdue = !iter->done &&
+                                iter->deadline <= now;
+                        if (!iter->done && !overdue)
+                            continue;
+                        Thread     thread{std::move(iter->thread)};
+                        const auto peerAddr = iter->peerAddr;
+                        connectAttempts.erase(iter);
+                        lock.unlock();
+                        if (overdue) {
+                            LOG_NOTE("Abandoning connection attempt to "
+                                    "unresponsive peer candidate " +
+                                    peerAddr.to_string());
+                            thread.cancel();
+                        }
+                        thread.join();
+                        if (overdue)
+                            peerSource.push(peerAddr, stasisDuration);
+                        lock.lock();
+                        connectCond.notify_all(); // An attempt slot is free
+                        reaped = true;
+                        break; // The list might have changed while unlocked
+                    }
+                }
+                Canceler canceler{};
+                if (connectAttempts.empty()) {
+                    connectCond.wait(lock);
+                }
+                else {
+                    auto deadline = connectAttempts.front().deadline;
+                    for (const auto& attempt : connectAttempts)
+                        deadline = std::min(deadline, attempt.deadline);
+                    connectCond.wait_until(lock, deadline);
+                }
+            }
+        }
+        catch (const std::exception& e) {
+            setException();
+        }
+    }
+
     /***
      * Handles a stopped peer. Called by the active peer-set. Removes the peer
-     * from the set of initiated peers, if applicable, adds the peer address to
-     * the delay queue, and signals the adder of locally-initiated peers.
+     * from the set of initiated peers, if applicable, tells the source of
+     * potential peers about the peer's final performance score, adds the peer
+     * address to the delay queue, and signals the adder of locally-initiated
+     * peers.
      * @param[in] peerAddr  Address of remote peer
+     * @param[in] score     Composite performance score of the peer at the time
+     *                      it stopped. Higher is better.
      */
-    void handleStoppedPeer(const InetSockAddr& peerAddr)
+    void handleStoppedPeer(
+            const InetSockAddr& peerAddr,
+            const double        score)
     {
         LOG_NOTE("Connection with remote peer terminated: peer=%s",
                 peerAddr.to_string().c_str());
         LockGuard lock(peerSetMutex);
         initiatedPeers.erase(peerAddr);
-        peerSource.push(peerAddr, stasisDuration);
+        auto iter = peerSrcAddrs.find(peerAddr);
+        if (iter != peerSrcAddrs.end()) {
+            interfaces.release(iter->second);
+            peerSrcAddrs.erase(iter);
+        }
+        peerSource.learn(peerAddr, score, stasisDuration);
         peerSetCond.notify_one();
     }
 
@@ -238,6 +872,23 @@ class P2pMgr::Impl final : public Notifier, public PeerSetServer
 
         pImpl->peerAddrThread.cancel();
         pImpl->peerAddrThread.join();
+
+        pImpl->connectReaperThread.cancel();
+        pImpl->connectReaperThread.join();
+
+        // Abandon any outstanding connection attempts
+        for (;;) {
+            Thread thread{};
+            {
+                LockGuard lock{pImpl->connectMutex};
+                if (pImpl->connectAttempts.empty())
+                    break;
+                thread = std::move(pImpl->connectAttempts.front().thread);
+                pImpl->connectAttempts.pop_front();
+            }
+            thread.cancel();
+            thread.join();
+        }
     }
 
 public:
@@ -253,13 +904,19 @@ public:
      *                                performing peer may be replaced
      * @param[in,out] peerSetServer   Higher-level component for the set of
      *                                active peers
+     * @param[in]     dscp            Differentiated Services code-point, in
+     *                                [0,63], applied to peer-connections.
+     *                                0 => unmarked.
+     * @throw InvalidArgument         `dscp > 63`
      * @see `run()`
      */
     Impl(   const InetSockAddr&       serverSockAddr,
             const unsigned            maxPeers,
             PeerSource&               peerSource,
             const unsigned            stasisDuration,
-            P2pMgrServer&             p2pMgrServer)
+            P2pMgrServer&             p2pMgrServer,
+            const InterfaceSet&       interfaces,
+            const unsigned            dscp)
         : peerSource(peerSource)
         , serverSockAddr{serverSockAddr}
         , p2pMgrServer(p2pMgrServer)
@@ -269,13 +926,52 @@ public:
         , exceptCond{}
         , peerSetMutex{}
         , peerSetCond{}
+        , connectMutex{}
+        , connectCond{}
+        , connectAttempts{}
+        , numProbing{0}
         , maxPeers{maxPeers}
         , stasisDuration{stasisDuration}
+        , interfaces{interfaces}
+        , dscp{dscp}
+        , admitMutex{}
+        , acceptRate{defaultAcceptRate}
+        , admitTokens{acceptBurst}
+        , admitTime{std::chrono::steady_clock::now()}
+        , acceptRateTunable{}
+        , peerSrcAddrs{}
         , exception{}
         , peerAddrThread{}
+        , connectReaperThread{}
         , serverThread{}
         , serverSock{serverSockAddr, Peer::getNumStreams()}
-    {}
+    {
+        if (dscp > 63)
+            throw INVALID_ARGUMENT("Invalid DSCP: " + std::to_string(dscp));
+        static std::atomic<unsigned> numP2pMgrs{0};
+        const auto mgrNum = numP2pMgrs++;
+        acceptRateTunable = Tunables::registerTunable(
+                "p2p." + std::to_string(mgrNum) + ".accept_rate",
+                "Rate, in connections per second, at which the peer-server "
+                "admits accepted connections. Excess reconnections wait in "
+                "the kernel's listen backlog. 0 disables pacing.",
+                [this](const std::string& value) {
+                    double rate;
+                    try {
+                        rate = std::stod(value);
+                    }
+                    catch (const std::exception& e) {
+                        throw INVALID_ARGUMENT("Not a number: \"" + value +
+                                "\"");
+                    }
+                    if (rate < 0)
+                        throw INVALID_ARGUMENT("Negative accept-rate: " +
+                                std::to_string(rate));
+                    LockGuard lock{admitMutex};
+                    acceptRate = rate;
+                    return std::to_string(rate);
+                });
+    }
 
     ~Impl() noexcept
     {
@@ -299,8 +995,10 @@ public:
     {
         UniqueLock lock(exceptMutex);
         THREAD_CLEANUP_PUSH(stopThreads, this);
-        if (!peerSource.empty())
+        if (!peerSource.empty()) {
             peerAddrThread = Thread{[this]{runPeerAdder();}};
+            connectReaperThread = Thread{[this]{runConnectReaper();}};
+        }
         serverThread = Thread{[this]{runServer();}};
         while (!exception) {
             Canceler canceler{};
@@ -323,6 +1021,25 @@ public:
         peerSet.notify(prodIndex);
     }
 
+    /**
+     * Notifies all active peers about available information on a product,
+     * identifying the product by name so a peer whose remote side advertised
+     * a product filter excluding the name can suppress the notice.
+     * @param[in] prodIndex       Product index
+     * @param[in] prodName        Name of the product or the empty string if
+     *                            unknown
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void notify(
+            const ProdIndex&   prodIndex,
+            const std::string& prodName) const
+    {
+        checkException();
+        peerSet.notify(prodIndex, prodName);
+    }
+
     /**
      * Notifies all active peers about an available chunk-of-data.
      * @param[in] chunkId         Chunk identifier
@@ -336,12 +1053,120 @@ public:
         peerSet.notify(chunkId);
     }
 
+    /**
+     * Notifies all active peers about a contiguous range of available
+     * chunks-of-data.
+     * @param[in] chunkRange      Range of chunk identifiers
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void notify(const ChunkRange& chunkRange) const
+    {
+        checkException();
+        peerSet.notify(chunkRange);
+    }
+
+    /**
+     * Notifies all active peers about a set of available chunks-of-data
+     * encoded as contiguous ranges.
+     * @param[in] rangeSet        Set of chunk-ranges
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void notify(const ChunkRangeSet& rangeSet) const
+    {
+        checkException();
+        peerSet.notify(rangeSet);
+    }
+
+    /**
+     * Cancels any outstanding peer-to-peer request for a chunk -- e.g.,
+     * because the chunk arrived via multicast, so the peer's reply would be a
+     * redundant transmission of the same data.
+     * @param[in] chunkId         Identifier of the unwanted data-chunk
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Safe
+     */
+    void cancel(const ChunkId& chunkId) const
+    {
+        checkException();
+        peerSet.cancel(chunkId);
+    }
+
+    /**
+     * Requests the peer-to-peer repair of chunks-of-data that another
+     * transport lost -- e.g., chunks that a gap in the multicast datagram
+     * sequence numbers shows will never arrive.
+     * @param[in] rangeSet  Identifiers of the missing chunks, as ranges
+     * @see `PeerSet::repair()`
+     */
+    void repair(const ChunkRangeSet& rangeSet) const
+    {
+        checkException();
+        peerSet.repair(rangeSet);
+    }
+
+    /**
+     * Enables or disables backpressure on the scheduling of chunk-requests --
+     * e.g., because a shared memory-budget reached its ceiling.
+     * @param[in] enable  Whether to withhold new chunk-requests
+     * @see `PeerSet::setBackpressure()`
+     */
+    void setBackpressure(const bool enable) const
+    {
+        peerSet.setBackpressure(enable);
+    }
+
+    /**
+     * Sets the product filter of the local node. The filter is sent to every
+     * active peer and remembered for each subsequently-connected peer.
+     * @param[in] filter  Product filter
+     */
+    void setProdFilter(const ProdFilter& filter)
+    {
+        {
+            LockGuard lock{filterMutex};
+            prodFilter = filter;
+        }
+        peerSet.sendFilter(filter); // Existing peers
+    }
+
+    /**
+     * Sets the order in which remote peers will be asked to serve this
+     * node's backlog.
+     * @param[in] order  Order in which the backlog should be served
+     * @see `PeerSet::setBacklogOrder()`
+     */
+    void setBacklogOrder(const BacklogOrder order) const noexcept
+    {
+        peerSet.setBacklogOrder(order);
+    }
+
+    /**
+     * Sets the bandwidth-budget for proactively pushing rare chunks --
+     * and thereby enables pushing.
+     * @param[in] rate  Push rate in bytes per second or 0 to disable
+     *                  pushing
+     * @see `PeerSet::setPushBudget()`
+     */
+    void setPushBudget(const double rate) const
+    {
+        peerSet.setPushBudget(rate);
+    }
+
     // Begin implementation of `PeerSetServer`
 
     ChunkId getEarliestMissingChunkId() {
         return p2pMgrServer.getEarliestMissingChunkId();
     }
 
+    bool getRetention(RetentionMsg& retention) {
+        return p2pMgrServer.getRetention(retention);
+    }
+
     Backlogger getBacklogger(
             const ChunkId& earliest,
             Peer&          peer)
@@ -350,7 +1175,13 @@ public:
     }
     void peerStopped(const InetSockAddr& peerAddr)
     {
-        handleStoppedPeer(peerAddr);
+        handleStoppedPeer(peerAddr, 0);
+    }
+    void peerStopped(
+            const InetSockAddr& peerAddr,
+            const double        score)
+    {
+        handleStoppedPeer(peerAddr, score);
     }
     bool shouldRequest(const ProdIndex& index)
     {
@@ -360,6 +1191,10 @@ public:
     {
         return p2pMgrServer.shouldRequest(chunkId);
     }
+    double getCompleteness(const ProdIndex& index)
+    {
+        return p2pMgrServer.getCompleteness(index);
+    }
     bool get(const ProdIndex& index, ProdInfo& info)
     {
         return p2pMgrServer.get(index, info);
@@ -380,6 +1215,39 @@ public:
     {
         return p2pMgrServer.receive(chunk, peerAddr);
     }
+    RecvStatus receive(
+            LatentSmallProd&    smallProd,
+            const InetSockAddr& peerAddr)
+    {
+        return p2pMgrServer.receive(smallProd, peerAddr);
+    }
+    void receive(
+            LatentChunk* const  chunks,
+            const size_t        numChunks,
+            RecvStatus* const   statuses,
+            const InetSockAddr& peerAddr)
+    {
+        p2pMgrServer.receive(chunks, numChunks, statuses, peerAddr);
+    }
+    void receive(
+            const PeerGossip&   gossip,
+            const InetSockAddr& peerAddr)
+    {
+        const auto numPeers = gossip.size();
+        for (size_t i = 0; i < numPeers; ++i) {
+            try {
+                const auto gossipedAddr = gossip.getPeerAddr(i);
+                if (gossipedAddr == serverSockAddr)
+                    continue; // This instance's own peer-server
+                if (peerSet.contains(gossipedAddr))
+                    continue; // Already an active peer
+                peerSource.learn(gossipedAddr, gossip.getScore(i));
+            }
+            catch (const std::exception& e) {
+                log_warn(e); // Gossip is advisory
+            }
+        }
+    }
 };
 
 P2pMgr::P2pMgr(
@@ -387,9 +1255,11 @@ P2pMgr::P2pMgr(
         P2pMgrServer&            p2pMgrServer,
         PeerSource&              peerSource,
         const unsigned           maxPeers,
-        const unsigned           stasisDuration)
+        const unsigned           stasisDuration,
+        const InterfaceSet&      interfaces,
+        const unsigned           dscp)
     : pImpl{new Impl(serverSockAddr, maxPeers, peerSource, stasisDuration,
-            p2pMgrServer)}
+            p2pMgrServer, interfaces, dscp)}
 {}
 
 void P2pMgr::run()
@@ -402,9 +1272,56 @@ void P2pMgr::notify(const ProdIndex& prodIndex) const
     pImpl->notify(prodIndex);
 }
 
+void P2pMgr::notify(
+        const ProdIndex&   prodIndex,
+        const std::string& prodName) const
+{
+    pImpl->notify(prodIndex, prodName);
+}
+
 void P2pMgr::notify(const ChunkId& chunkId) const
 {
     pImpl->notify(chunkId);
 }
 
+void P2pMgr::notify(const ChunkRange& chunkRange) const
+{
+    pImpl->notify(chunkRange);
+}
+
+void P2pMgr::notify(const ChunkRangeSet& rangeSet) const
+{
+    pImpl->notify(rangeSet);
+}
+
+void P2pMgr::setBackpressure(const bool enable) const
+{
+    pImpl->setBackpressure(enable);
+}
+
+void P2pMgr::cancel(const ChunkId& chunkId) const
+{
+    pImpl->cancel(chunkId);
+}
+
+void P2pMgr::repair(const ChunkRangeSet& rangeSet) const
+{
+    pImpl->repair(rangeSet);
+}
+
+void P2pMgr::setProdFilter(const ProdFilter& filter) const
+{
+    pImpl->setProdFilter(filter);
+}
+
+void P2pMgr::setBacklogOrder(const BacklogOrder order) const noexcept
+{
+    pImpl->setBacklogOrder(order);
+}
+
+void P2pMgr::setPushBudget(const double rate) const
+{
+    pImpl->setPushBudget(rate);
+}
+
 } // namespace
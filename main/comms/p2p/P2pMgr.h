@@ -15,6 +15,7 @@
 #ifndef MAIN_P2P_P2PMGR_H_
 #define MAIN_P2P_P2PMGR_H_
 
+#include "Interface.h"
 #include "Notifier.h"
 #include "P2pMgrServer.h"
 #include "PeerSet.h"
@@ -41,14 +42,31 @@ struct P2pInfo final
      */
     unsigned          stasisDuration;
 
+    /**
+     * Interfaces across which initiated peer-connections are striped. May be
+     * empty, in which case the routing table picks the source interface.
+     */
+    InterfaceSet      interfaces;
+
+    /**
+     * Differentiated Services code-point, in [0,63], applied to
+     * peer-connections so the network can class peer-to-peer traffic (see
+     * RFC 2474). 0 => unmarked (best-effort).
+     */
+    unsigned          dscp;
+
     P2pInfo(const InetSockAddr&      serverSockAddr,
             const unsigned           maxPeers,
             PeerSource&              peerSource,
-            const unsigned           stasisDuration)
+            const unsigned           stasisDuration,
+            const InterfaceSet&      interfaces = InterfaceSet{},
+            const unsigned           dscp = 0)
     : serverSockAddr{serverSockAddr}
     , peerCount{maxPeers}
     , peerSource(peerSource)
     , stasisDuration{stasisDuration}
+    , interfaces{interfaces}
+    , dscp{dscp}
     {}
 };
 
@@ -73,13 +91,22 @@ public:
      *                            of active peers must be unchanged before the
      *                            worst performing peer may be replaced. Default
      *                            is 60 seconds.
+     * @param[in] interfaces      Interfaces across which initiated
+     *                            peer-connections are striped. Default is
+     *                            empty: the routing table picks the source
+     *                            interface.
+     * @param[in] dscp            Differentiated Services code-point, in
+     *                            [0,63], applied to peer-connections (see
+     *                            RFC 2474). Default is 0: unmarked.
      * @see `run()`
      */
     P2pMgr( const InetSockAddr& serverSockAddr,
             P2pMgrServer&       p2pMgrServer,
             PeerSource&         peerSource,
             const unsigned      maxPeers = PeerSet::defaultMaxPeers,
-            const unsigned      stasisDuration = PeerSet::defaultStasisDuration);
+            const unsigned      stasisDuration = PeerSet::defaultStasisDuration,
+            const InterfaceSet& interfaces = InterfaceSet{},
+            const unsigned      dscp = 0);
 
     /**
      * Constructs.
@@ -90,7 +117,8 @@ public:
     P2pMgr( P2pInfo&      p2pInfo,
             P2pMgrServer& p2pMgrServer)
     	: P2pMgr(p2pInfo.serverSockAddr, p2pMgrServer, p2pInfo.peerSource,
-                p2pInfo.peerCount, p2pInfo.stasisDuration)
+                p2pInfo.peerCount, p2pInfo.stasisDuration, p2pInfo.interfaces,
+                p2pInfo.dscp)
     {}
 
     /**
@@ -112,6 +140,22 @@ public:
      */
     void notify(const ProdIndex& prodIndex) const;
 
+    /**
+     * Notifies all active peers about available information on a product,
+     * identifying the product by name. A peer whose remote side advertised a
+     * product filter that excludes the name suppresses the notice and the
+     * product's subsequent chunk notices.
+     * @param[in] prodIndex       Product index
+     * @param[in] prodName        Name of the product or the empty string if
+     *                            unknown, in which case every peer is notified
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void notify(
+            const ProdIndex&   prodIndex,
+            const std::string& prodName) const;
+
     /**
      * Notifies all active peers about an available chunk-of-data.
      * @param[in] chunkId         Chunk identifier
@@ -120,6 +164,99 @@ public:
      * @threadsafety              Compatible but not safe
      */
     void notify(const ChunkId& chunkId) const;
+
+    /**
+     * Notifies all active peers about a contiguous range of available
+     * chunks-of-data.
+     * @param[in] chunkRange      Range of chunk identifiers
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void notify(const ChunkRange& chunkRange) const;
+
+    /**
+     * Notifies all active peers about a set of available chunks-of-data
+     * encoded as contiguous ranges.
+     * @param[in] rangeSet        Set of chunk-ranges
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void notify(const ChunkRangeSet& rangeSet) const;
+
+    /**
+     * Cancels any outstanding peer-to-peer request for a chunk -- e.g.,
+     * because the chunk arrived via multicast, so the peer's reply would be a
+     * redundant transmission of the same data. Best-effort: the reply is
+     * dropped only if it hasn't been transmitted.
+     * @param[in] chunkId         Identifier of the unwanted data-chunk
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Safe
+     */
+    void cancel(const ChunkId& chunkId) const;
+
+    /**
+     * Requests the peer-to-peer repair of chunks-of-data that another
+     * transport lost -- e.g., chunks that a gap in the multicast datagram
+     * sequence numbers shows will never arrive. Each chunk that's still
+     * needed is immediately assigned to an active peer without waiting for
+     * the chunk to be announced; a peer that doesn't have the chunk simply
+     * doesn't reply and the request is re-issued to an alternative peer at
+     * the deadline.
+     * @param[in] rangeSet        Identifiers of the missing chunks, as ranges
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Safe
+     */
+    void repair(const ChunkRangeSet& rangeSet) const;
+
+    /**
+     * Enables or disables backpressure on the scheduling of peer-to-peer
+     * chunk-requests -- e.g., because a shared memory-budget reached its
+     * ceiling. While enabled, no new chunk-request is assigned to a remote
+     * peer; overdue requests are still re-issued so in-flight chunks
+     * complete.
+     * @param[in] enable  Whether to withhold new chunk-requests
+     * @exceptionsafety   Strong guarantee
+     * @threadsafety      Safe
+     */
+    void setBackpressure(const bool enable) const;
+
+    /**
+     * Sets the product filter of the local node. The filter is sent to every
+     * active peer and to each subsequently-connected peer, so remote peers
+     * stop sending notices -- including backlog notices -- for products whose
+     * names the filter excludes. An empty filter re-enables all notices.
+     * @param[in] filter  Product filter
+     * @exceptionsafety   Basic guarantee
+     * @threadsafety      Safe
+     */
+    void setProdFilter(const ProdFilter& filter) const;
+
+    /**
+     * Sets the order in which remote peers will be asked to serve this
+     * node's backlog. Affects subsequently-added peers.
+     * @param[in] order   Order in which the backlog should be served
+     * @exceptionsafety   Nothrow
+     * @threadsafety      Safe
+     * @see `PeerSet::setBacklogOrder()`
+     */
+    void setBacklogOrder(const BacklogOrder order) const noexcept;
+
+    /**
+     * Sets the bandwidth-budget for proactively pushing rare chunks to
+     * remote peers that haven't announced them -- and thereby enables
+     * pushing, which is off by default.
+     * @param[in] rate         Push rate in bytes per second or 0 -- the
+     *                         default -- to disable pushing
+     * @throw InvalidArgument  The rate is negative
+     * @exceptionsafety        Strong guarantee
+     * @threadsafety           Safe
+     * @see `PeerSet::setPushBudget()`
+     */
+    void setPushBudget(const double rate) const;
 };
 
 } // namespace
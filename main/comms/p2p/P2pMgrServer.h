@@ -16,6 +16,7 @@
 #include "P2pServer.h"
 #include "BackloggerFactory.h"
 #include "P2pContentRcvr.h"
+#include "RetentionMsg.h"
 
 namespace hycast {
 
@@ -30,6 +31,18 @@ public:
      * @return ID of earliest missing data-chunk
      */
     virtual ChunkId getEarliestMissingChunkId() =0;
+
+    /**
+     * Returns this node's retention advertisement: the oldest data-product
+     * its store still holds. The default implementation doesn't answer, so
+     * nothing is advertised to remote peers.
+     * @param[out] retention  Retention advertisement
+     * @retval `true`         Iff `retention` is set
+     */
+    virtual bool getRetention(RetentionMsg& retention)
+    {
+        return false;
+    }
 };
 
 } // namespace
@@ -36,6 +36,18 @@ public:
      * @param[in]     chunkId  Identifier of relevant data-chunk
      */
     virtual bool shouldRequest(const ChunkId& chunkId) =0;
+    /**
+     * Returns the fraction of a product's data-chunks that have been
+     * received -- e.g., from the product-store -- so the chunk-request
+     * scheduler can prefer chunks that finish nearly-complete products. The
+     * default implementation doesn't know and returns 0.
+     * @param[in] prodIndex  Index of relevant product
+     * @return               Completeness fraction in `[0,1]`
+     */
+    virtual double getCompleteness(const ProdIndex& prodIndex)
+    {
+        return 0;
+    }
     /**
      * Returns information about a product.
      * @param[in]  index     Index of relevant product
@@ -9,25 +9,45 @@
  * @author: Steven R. Emmerson
  */
 
+#include "config.h"
+
 #include "Channel.h"
 #include "Chunk.h"
+#include "CreditMsg.h"
 #include "error.h"
+#include "FlightRecorder.h"
+#include "HeartbeatMsg.h"
+#include "Metrics.h"
+#include "MsgSock.h"
+#include "NoticeCache.h"
+#include "OpAccounting.h"
 #include "Peer.h"
+#include "PeerGossip.h"
 #include "PeerServer.h"
+#include "probe.h"
+#include "ProdFilter.h"
 #include "ProdIndex.h"
 #include "ProdInfo.h"
+#include "RetentionMsg.h"
 #include "SctpSock.h"
+#include "TcpSock.h"
 #include "Thread.h"
 #include "VersionMsg.h"
+#include "Watchdog.h"
 
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstddef>
 #include <functional>
 #include <iostream>
 #include <mutex>
+#include <poll.h>
+#include <random>
 #include <thread>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 namespace hycast {
 
@@ -43,12 +63,46 @@ private:
         PROD_NOTICE_STREAM_ID,
         PROD_INFO_STREAM_ID,
         CHUNK_NOTICE_STREAM_ID,
+        CHUNK_RANGE_NOTICE_STREAM_ID,
+        CHUNK_RANGE_SET_NOTICE_STREAM_ID,
         PROD_REQ_STREAM_ID,
         CHUNK_REQ_STREAM_ID,
+        CHUNK_RANGE_SET_REQ_STREAM_ID,
+        CHUNK_CANCEL_STREAM_ID,
         CHUNK_STREAM_ID,
+        GOSSIP_STREAM_ID,
+        CHUNK_RUN_STREAM_ID,
+        CHUNK_LZ4_STREAM_ID,
+        FILTER_STREAM_ID,
+        BACKLOG_RECENT_STREAM_ID,
+        CREDIT_STREAM_ID,
+        SMALL_PROD_STREAM_ID,
+        HEARTBEAT_STREAM_ID,
+        RETENTION_STREAM_ID,
         NUM_STREAM_IDS
     } SctpStreamId;
 
+    /*
+     * Partial-reliability lifetimes, in milliseconds, of the time-sensitive
+     * message classes (see RFC 3758): under congestion, the kernel abandons
+     * an unsent or unacknowledged message older than its class's lifetime
+     * instead of retransmitting it ahead of useful data. A notice only
+     * advertises availability -- a remote peer that misses one learns of the
+     * chunk from a later notice or another peer -- and a cancellation is
+     * purely advisory, so delivering either seconds late is worthless.
+     * Requests, chunks, backlog, and gossip stay fully reliable.
+     */
+    static const unsigned NOTICE_TTL_MS = 5000;
+    static const unsigned CANCEL_TTL_MS = 2000;
+    /// A late heartbeat is worthless -- any newer message proves liveness
+    /// just as well -- and retransmitting one ahead of useful data would be
+    /// perverse, so heartbeats get the shortest lifetime of all.
+    static const unsigned HEARTBEAT_TTL_MS = 1000;
+
+    /// Ceiling, in bytes, on the adaptive growth of the connection's send
+    /// buffer
+    static const int      MAX_SNDBUF_SIZE = 8 << 20;
+
     class SafeChunkIdSet final
     {
         typedef std::mutex                  Mutex;
@@ -67,6 +121,11 @@ private:
             LockGuard lock{mutex};
             chunkIds.erase(chunkId);
         }
+        void clear()
+        {
+            LockGuard lock{mutex};
+            chunkIds.clear(); // The buckets stay allocated
+        }
         Peer::ChunkIdSet getChunkIds() const
         {
             LockGuard lock{mutex};
@@ -75,16 +134,121 @@ private:
     };
 
     unsigned                          version;
+    /**
+     * Serialization version of the compact encoding: varint integers and
+     * delta-coded indices. Used on an association only if both peers
+     * advertise `VersionMsg::COMPACT_ENCODING`; the encoding is fixed for
+     * the whole association by the version exchange, so no message carries
+     * version information.
+     */
+    static const unsigned             COMPACT_VERSION = 1;
     Channel<VersionMsg>               versionChan;
     Channel<ChunkId>                  backlogChan;
     Channel<ProdIndex>                prodNoticeChan;
     Channel<ProdInfo>                 prodInfoChan;
     Channel<ChunkId>                  chunkNoticeChan;
+    Channel<ChunkRange>               chunkRangeNoticeChan;
+    Channel<ChunkRangeSet>            chunkRangeSetNoticeChan;
     Channel<ProdIndex>                prodReqChan;
     Channel<ChunkId>                  chunkReqChan;
+    Channel<ChunkRangeSet>            chunkRangeSetReqChan;
+    Channel<ChunkId>                  chunkCancelChan;
     Channel<ActualChunk,LatentChunk>  chunkChan;
-    SctpSock                          sock;
+    Channel<ActualChunkRun,LatentChunkRun> chunkRunChan;
+    Channel<ActualCompressedChunk,LatentCompressedChunk> chunkLz4Chan;
+    Channel<PeerGossip>               gossipChan;
+    Channel<ProdFilter>               filterChan;
+    Channel<ChunkId>                  backlogRecentChan;
+    Channel<CreditMsg>                creditChan;
+    Channel<ActualSmallProd,LatentSmallProd> smallProdChan;
+    Channel<HeartbeatMsg>             heartbeatChan;
+    Channel<RetentionMsg>             retentionChan;
+    MsgSock                           sock;
     SafeChunkIdSet                    requestedChunks;
+    /// Capabilities advertised by both peers: the association's negotiated
+    /// feature set, fixed by the version exchange in the constructor
+    unsigned                          negotiated;
+
+    /*
+     * Application-level flow control (`VersionMsg::FLOW_CONTROL`). The kernel
+     * already bounds bytes in flight, but a slow consumer lets the connection
+     * fill the whole send buffer -- up to `MAX_SNDBUF_SIZE` -- with chunks it
+     * won't drain for seconds. Each side instead advertises an absolute
+     * chunk-credit window; the initial window is implicit in the negotiation
+     * and a fresh window is advertised after every `CREDIT_WINDOW/2`
+     * deliveries consumed. A sender that exhausts the remote window drops
+     * further chunks rather than blocking (credit arrives on the very thread
+     * a blocked send would stall); the requester's scheduler times the
+     * unserved chunks out and re-requests them.
+     */
+    /// Chunk-credit window a peer grants: the number of further chunk
+    /// deliveries it's prepared to absorb
+    static const uint32_t             CREDIT_WINDOW = 1024;
+    /// Chunk-send credit granted by the remote peer. Negative => flow
+    /// control wasn't negotiated, so sends are unlimited.
+    mutable std::atomic<long>         sendCredit;
+    /// Chunk deliveries consumed since credit was last advertised
+    std::atomic<uint32_t>             consumedChunks;
+
+    /*
+     * Session-resumption tokens. Each peer issues a token for the
+     * association; the remote peer presents it on a reconnection so
+     * server-side session state -- e.g., the backlog cursor -- survives the
+     * flap. All three are fixed by the version exchange in the constructor.
+     */
+    /// Token this peer issued for this association
+    uint64_t                          sessionToken;
+    /// Token the remote peer issued for this association
+    uint64_t                          remoteSessionToken;
+    /// Token the remote peer presented for resumption or 0 for none
+    uint64_t                          remoteResumeToken;
+
+    /// Maximum number of remembered excluded products
+    static const size_t               MAX_EXCLUSIONS = 512;
+
+    /*
+     * The remote peer's product filter and the products it has excluded.
+     * Written by the receiving thread; read by the notifying threads.
+     */
+    mutable std::mutex                filterMutex;
+    ProdFilter                        remoteFilter;
+    std::unordered_set<ProdIndex>     excludedProds;
+
+    /// When the version exchange completed: start of the recovery-critical
+    /// interval to the first data-chunk served on the association
+    std::chrono::steady_clock::time_point setupTime;
+    /// Whether a data-chunk has been served on this association
+    mutable std::atomic<bool>         servedChunk;
+
+    /*
+     * Liveness heartbeats (`VersionMsg::HEARTBEATS`). Any received message
+     * proves the remote process is alive, so the tick of the most recent one
+     * is recorded; the peer-set's monitor evicts a peer whose silence exceeds
+     * a few heartbeat intervals and sends a heartbeat on an association whose
+     * outgoing side has gone idle.
+     */
+    /// Tick (`steady_clock` time-since-epoch count) of the most recent
+    /// message received from the remote peer
+    mutable std::atomic<std::chrono::steady_clock::duration::rep> lastRecvTick;
+    /// Number of heartbeats sent on this association
+    std::atomic<uint32_t>             heartbeatSeq;
+
+    /*
+     * The remote peer's retention range (`VersionMsg::RETENTION`): the
+     * oldest product its store still holds, learned from its retention
+     * advertisements. Written by the receiving thread; read by the threads
+     * that assign chunk-requests. The three cells are read independently --
+     * a momentarily-torn view merely mis-targets one advisory request -- so
+     * no lock is taken on the request path.
+     */
+    /// Whether a retention advertisement has been received on this
+    /// association. Until one arrives the remote peer is assumed to hold
+    /// everything, which is the pre-retention behavior.
+    mutable std::atomic<bool>         remoteRetentionKnown;
+    /// Whether the remote peer's store holds anything at all
+    mutable std::atomic<bool>         remoteHoldsData;
+    /// Index of the oldest product the remote peer's store still holds
+    mutable std::atomic<ProdIndex::type> remoteOldestProd;
 
     /**
      * Every peer implementation is unique.
@@ -95,25 +259,439 @@ private:
     Impl& operator=(const Impl&& impl) =delete;
 
     /**
-     * Returns the protocol version of the remote peer.
+     * Returns the capabilities this peer advertises to the remote peer.
+     * A capability is used on the association only if both peers advertise
+     * it, so a build without a capability simply never negotiates it.
+     * @return Locally-supported capabilities
+     */
+    static unsigned getCapabilities() noexcept
+    {
+        unsigned capabilities = VersionMsg::COMPACT_ENCODING |
+                VersionMsg::CHUNK_RUNS | VersionMsg::FLOW_CONTROL |
+                VersionMsg::SMALL_PRODUCTS | VersionMsg::HEARTBEATS |
+                VersionMsg::RETENTION;
+#ifdef USE_LZ4
+        capabilities |= VersionMsg::LZ4_CHUNKS;
+#endif
+        return capabilities;
+    }
+
+    /**
+     * Indicates if an optional capability may be used on this association:
+     * i.e., both peers advertised it in the version exchange.
+     * @param[in] cap  Capability in question
+     * @retval `true`  Iff the capability was negotiated
+     */
+    inline bool canUse(const VersionMsg::Capability cap) const noexcept
+    {
+        return (negotiated & cap) != 0;
+    }
+
+    /**
+     * Returns the wire-encoding version of this association's notice
+     * channels: the compact encoding if it was negotiated; the protocol
+     * version otherwise. Keys the per-version entries of a `NoticeCache`.
+     * @return Wire-encoding version of the notice channels
+     */
+    inline unsigned noticeVersion() const noexcept
+    {
+        return canUse(VersionMsg::COMPACT_ENCODING)
+                ? COMPACT_VERSION
+                : version;
+    }
+
+    /**
+     * Returns the version message of the remote peer.
      * @pre                `sock.getStreamId() == VERSION_STREAM_ID`
-     * @return             Protocol version of the remote peer
+     * @return             Version message of the remote peer
      * @throws LogicError  `sock.getStreamId() != VERSION_STREAM_ID`
      * @threadsafety       Safe
      */
-    unsigned getVersion()
+    VersionMsg getVersionMsg()
     {
         if (sock.getStreamId() != VERSION_STREAM_ID)
             throw LOGIC_ERROR("Current message isn't a version message");
-        return versionChan.recv().getVersion();
+        return versionChan.recv();
     }
 
-    void sendVersion()
+    void sendVersion(const uint64_t resumeToken)
     {
-        VersionMsg msg(version);
+        VersionMsg msg(version, getCapabilities(), sessionToken,
+                resumeToken);
         versionChan.send(msg);
     }
 
+    /**
+     * Re-binds the index-bearing channels to the compact encoding. Called
+     * once -- after the version exchange and before any other traffic --
+     * when both peers advertise `VersionMsg::COMPACT_ENCODING`. The
+     * data-chunk channels are untouched: their payload dwarfs the metadata,
+     * so compacting them isn't worth a second metadata layout.
+     */
+    void useCompactEncoding()
+    {
+        backlogChan = Channel<ChunkId>{sock, BACKLOG_STREAM_ID,
+                COMPACT_VERSION};
+        prodNoticeChan = Channel<ProdIndex>{sock, PROD_NOTICE_STREAM_ID,
+                COMPACT_VERSION, NOTICE_TTL_MS};
+        chunkNoticeChan = Channel<ChunkId>{sock, CHUNK_NOTICE_STREAM_ID,
+                COMPACT_VERSION, NOTICE_TTL_MS};
+        chunkRangeNoticeChan = Channel<ChunkRange>{sock,
+                CHUNK_RANGE_NOTICE_STREAM_ID, COMPACT_VERSION, NOTICE_TTL_MS};
+        chunkRangeSetNoticeChan = Channel<ChunkRangeSet>{sock,
+                CHUNK_RANGE_SET_NOTICE_STREAM_ID, COMPACT_VERSION,
+                NOTICE_TTL_MS};
+        prodReqChan = Channel<ProdIndex>{sock, PROD_REQ_STREAM_ID,
+                COMPACT_VERSION};
+        chunkReqChan = Channel<ChunkId>{sock, CHUNK_REQ_STREAM_ID,
+                COMPACT_VERSION};
+        chunkRangeSetReqChan = Channel<ChunkRangeSet>{sock,
+                CHUNK_RANGE_SET_REQ_STREAM_ID, COMPACT_VERSION};
+        chunkCancelChan = Channel<ChunkId>{sock, CHUNK_CANCEL_STREAM_ID,
+                COMPACT_VERSION, CANCEL_TTL_MS};
+        backlogRecentChan = Channel<ChunkId>{sock, BACKLOG_RECENT_STREAM_ID,
+                COMPACT_VERSION};
+    }
+
+    /**
+     * Performs the version exchange with the remote peer: enables the
+     * socket's send-side optimizations, sends this peer's version message,
+     * and fixes the association's negotiated feature set, credit window,
+     * and session tokens from the remote peer's reply. Called by the socket
+     * constructor and by `rebind()`. Blocks until the remote peer's version
+     * message arrives. This is a cancellation point.
+     * @param[in] resumeToken  Session token issued by the remote peer on a
+     *                         prior association to present for resumption or
+     *                         0 for none
+     * @throw LogicError       Unknown protocol version from remote peer
+     */
+    void negotiate(const uint64_t resumeToken)
+    {
+        // Large chunk sends (e.g., backlog) then avoid the kernel copy.
+        // Chunk data resides in the product-store, so it persists until
+        // the kernel signals completion.
+        sock.enableZeroCopy();
+        /*
+         * A send that stalls on a full send buffer blocks every stream
+         * of the connection, so the buffer grows itself when that's
+         * observed
+         */
+        sock.enableAdaptiveSndBuf(MAX_SNDBUF_SIZE);
+        sendVersion(resumeToken);
+        const auto remote = getVersionMsg();
+        if (remote.getVersion() != version)
+            throw LOGIC_ERROR(
+                    "Remote peer uses unsupported protocol version: " +
+                    std::to_string(remote.getVersion()));
+        /*
+         * The negotiated feature set is the intersection of the two
+         * advertisements. Bits this build doesn't recognize are masked
+         * off here, so a newer remote's features are simply never used.
+         */
+        negotiated = getCapabilities() & remote.getCapabilities();
+        if (canUse(VersionMsg::COMPACT_ENCODING))
+            useCompactEncoding();
+        /*
+         * The initial chunk-credit window is implicit in the
+         * negotiation: each side may send a full window before its
+         * first credit message arrives, so neither side waits on the
+         * other at startup.
+         */
+        if (canUse(VersionMsg::FLOW_CONTROL))
+            sendCredit = static_cast<long>(CREDIT_WINDOW);
+        LOG_DEBUG("Negotiated capabilities " +
+                std::to_string(negotiated) + " with remote peer " +
+                getRemoteAddr().to_string());
+        remoteSessionToken = remote.getSessionToken();
+        remoteResumeToken = remote.getResumeToken();
+        setupTime = std::chrono::steady_clock::now();
+        // The version exchange counts as received traffic
+        noteMsgReceived();
+    }
+
+    /**
+     * Resets the per-association state so this instance can carry a new
+     * association. The containers are cleared rather than replaced: their
+     * buckets stay allocated, which is the warm-pool's payoff on reuse.
+     */
+    void resetSession()
+    {
+        requestedChunks.clear();
+        negotiated = 0;
+        sendCredit = -1;
+        consumedChunks = 0;
+        heartbeatSeq = 0;
+        sessionToken = 0;
+        remoteSessionToken = 0;
+        remoteResumeToken = 0;
+        servedChunk = false;
+        remoteRetentionKnown = false;
+        remoteHoldsData = false;
+        remoteOldestProd = 0;
+        std::lock_guard<std::mutex> lock{filterMutex};
+        remoteFilter = ProdFilter{};
+        excludedProds.clear();
+    }
+
+    /**
+     * Records the service of the association's first data-chunk. The time
+     * from the version exchange to the first served chunk is the
+     * recovery-critical accept-to-service latency, so the most recent
+     * observation is exported as a gauge.
+     */
+    void recordServedChunk() const
+    {
+        if (servedChunk.exchange(true))
+            return;
+        static std::atomic<uint64_t> latestMicros{0};
+        static auto                  gauge = Metrics::registerGauge(
+                "hycast_peer_first_chunk_seconds",
+                "Most recent time from a peer's version exchange to the "
+                "first data-chunk it served",
+                []{ return latestMicros.load()/1e6; });
+        latestMicros = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - setupTime)
+                        .count());
+    }
+
+    /**
+     * Returns a new, non-zero session-resumption token. The token only
+     * guards an optimization -- a guessed token merely resumes a backlog
+     * cursor -- so a pseudo-random value seeded from the system's entropy
+     * source suffices.
+     * @return New session token
+     */
+    static uint64_t makeSessionToken()
+    {
+        static std::random_device entropy;
+        const uint64_t token = (static_cast<uint64_t>(entropy()) << 32) |
+                entropy();
+        return token ? token : 1;
+    }
+
+    /**
+     * Adds an approved chunk identifier to a batched request. If the batch is
+     * full, then it's sent, cleared, and the identifier is added to the now
+     * empty batch. The caller must send any non-empty batch when it's done
+     * adding.
+     * @param[in,out] rangeSet  Batched request under construction
+     * @param[in]     chunkId   Chunk identifier to add
+     */
+    void batchRequest(
+            ChunkRangeSet& rangeSet,
+            const ChunkId& chunkId)
+    {
+        if (!rangeSet.add(chunkId)) {
+            request(rangeSet);
+            rangeSet.clear();
+            rangeSet.add(chunkId);
+        }
+    }
+
+    /**
+     * Indicates if a data-chunk extends a run of contiguous chunks.
+     * @param[in] run    Non-empty run of contiguous chunks
+     * @param[in] chunk  Data-chunk
+     * @retval `true`    The chunk immediately follows the run's last chunk
+     * @retval `false`   The chunk doesn't extend the run
+     */
+    static bool extendsRun(
+            const std::vector<ActualChunk>& run,
+            const ActualChunk&              chunk)
+    {
+        const auto& last = run.back();
+        return chunk.getProdIndex() == last.getProdIndex() &&
+                static_cast<ChunkIndex::type>(chunk.getIndex()) ==
+                static_cast<ChunkIndex::type>(last.getIndex()) + 1;
+    }
+
+    /**
+     * Sends a run of contiguous data-chunks being accumulated while serving a
+     * chunk-range request and clears it. A run of one chunk -- or any run
+     * when the remote peer didn't advertise `VersionMsg::CHUNK_RUNS` -- is
+     * sent as ordinary chunk messages; otherwise the run is sent as a single
+     * chunk-run message, which amortizes the per-chunk message overhead that
+     * bounds backlog throughput. Does nothing if the run is empty.
+     * @param[in,out] run  Run of contiguous chunks. Cleared on return.
+     */
+    void sendRun(std::vector<ActualChunk>& run)
+    {
+        if (run.empty())
+            return;
+        if (run.size() == 1 || !canUse(VersionMsg::CHUNK_RUNS)) {
+            // No batching: each chunk goes as an ordinary chunk message
+            for (const auto& chunk : run)
+                send(chunk);
+        }
+        else {
+            try {
+                /*
+                 * The whole run's credit is consumed at once, saturating at
+                 * zero: the serving loop's per-chunk credit check bounds
+                 * any overshoot to a single run.
+                 */
+                consumeSendCredits(static_cast<long>(run.size()));
+                ActualChunkRun chunkRun{run};
+                chunkRunChan.send(chunkRun);
+                recordServedChunk();
+            }
+            catch (const std::exception& ex) {
+                std::throw_with_nested(RUNTIME_ERROR("Couldn't send run of " +
+                        std::to_string(run.size()) +
+                        " data-chunks starting at chunk " +
+                        run.front().getId().to_string() + " to remote peer " +
+                        getRemoteAddr().to_string()));
+            }
+        }
+        run.clear();
+    }
+
+    /**
+     * Indicates if the remote peer's product filter has excluded a product,
+     * in which case notices about the product's chunks are suppressed.
+     * @param[in] prodIndex  Product index
+     * @retval `true`        Product is excluded
+     * @retval `false`       Otherwise
+     */
+    bool excludes(const ProdIndex& prodIndex) const
+    {
+        std::lock_guard<std::mutex> lock{filterMutex};
+        return excludedProds.count(prodIndex) != 0;
+    }
+
+    /**
+     * Indicates if the remote peer's product filter excludes a product's
+     * name, recording an excluded product so its chunk notices are
+     * suppressed as well.
+     * @param[in] prodIndex  Product index
+     * @param[in] prodName   Name of the product or the empty string if
+     *                       unknown, which is never excluded
+     * @retval `true`        Product is excluded
+     * @retval `false`       Otherwise
+     */
+    bool filterExcludes(
+            const ProdIndex&   prodIndex,
+            const std::string& prodName)
+    {
+        if (prodName.empty())
+            return false;
+        std::lock_guard<std::mutex> lock{filterMutex};
+        if (remoteFilter.matches(prodName))
+            return false;
+        /*
+         * NB: the set is advisory -- like the cancellation-set in
+         * `PeerSet` -- so it's cleared when it hits the cap. Losing
+         * an entry merely sends an unwanted notice, which the remote
+         * peer declines to request.
+         */
+        if (excludedProds.size() >= MAX_EXCLUSIONS)
+            excludedProds.clear();
+        excludedProds.insert(prodIndex);
+        return true;
+    }
+
+    /**
+     * Tries to consume one unit of the chunk-send credit granted by the
+     * remote peer. Never blocks.
+     * @retval `true`   A credit was consumed or flow control wasn't
+     *                  negotiated
+     * @retval `false`  The remote peer's window is exhausted
+     */
+    bool consumeSendCredit() const noexcept
+    {
+        auto credit = sendCredit.load();
+        for (;;) {
+            if (credit < 0)
+                return true; // Flow control wasn't negotiated
+            if (credit == 0)
+                return false;
+            if (sendCredit.compare_exchange_weak(credit, credit - 1))
+                return true;
+        }
+    }
+
+    /**
+     * Consumes up to a given number of units of the chunk-send credit
+     * granted by the remote peer, saturating at zero. Used for chunk-run
+     * messages, whose chunks are sent whole once the run is assembled.
+     * @param[in] want  Number of credits to consume
+     */
+    void consumeSendCredits(const long want) const noexcept
+    {
+        auto credit = sendCredit.load();
+        for (;;) {
+            if (credit < 0)
+                return; // Flow control wasn't negotiated
+            long next;
+            if (credit > want) {
+                next = credit - want;
+            }
+            else {
+                next = 0;
+            }
+            if (sendCredit.compare_exchange_weak(credit, next))
+                return;
+        }
+    }
+
+    /**
+     * Indicates if the remote peer's chunk-credit window has room for at
+     * least one more chunk. A non-consuming peek used to stop serving a
+     * chunk-range request early.
+     * @retval `true`  Iff at least one more chunk may be sent
+     */
+    inline bool hasSendCredit() const noexcept
+    {
+        return sendCredit.load() != 0;
+    }
+
+    /**
+     * Counts a chunk delivery dropped because the remote peer's
+     * chunk-credit window was exhausted. The requester's scheduler times
+     * the chunk out and re-requests it -- possibly from a peer with a
+     * faster consumer.
+     * @param[in] chunkId  Identifier of the dropped chunk
+     */
+    static void creditExhausted(const ChunkId& chunkId)
+    {
+        static auto& dropped = Metrics::getCounter(
+                "hycast_chunks_credit_dropped_total",
+                "Chunk deliveries dropped because the remote peer's "
+                "receive-window credit was exhausted");
+        dropped.add();
+        LOG_DEBUG("Not sending chunk " + chunkId.to_string() +
+                ": remote peer's receive-window credit is exhausted");
+    }
+
+    /**
+     * Counts a consumed chunk delivery and advertises a fresh chunk-credit
+     * window to the remote peer when half the window has been consumed.
+     * Called on the receiving thread, which is this peer's only sender of
+     * credit messages. Does nothing if flow control wasn't negotiated.
+     */
+    void chunkConsumed()
+    {
+        if (!canUse(VersionMsg::FLOW_CONTROL))
+            return;
+        if (consumedChunks.fetch_add(1) + 1 >= CREDIT_WINDOW/2) {
+            consumedChunks = 0;
+            creditChan.send(CreditMsg{CREDIT_WINDOW});
+        }
+    }
+
+    /**
+     * Records the arrival of a message -- any message -- from the remote
+     * peer: proof that the remote process is alive. Called on the receiving
+     * thread; read by the peer-set's heartbeat monitor via
+     * `getRecvSilence()`.
+     */
+    inline void noteMsgReceived() const noexcept
+    {
+        lastRecvTick.store(std::chrono::steady_clock::now()
+                .time_since_epoch().count(), std::memory_order_relaxed);
+    }
+
 public:
     /**
      * Default constructs. Any attempt to use use the resulting instance will
@@ -125,41 +703,98 @@ public:
         , backlogChan{}
         , prodNoticeChan{}
         , chunkNoticeChan{}
+        , chunkRangeNoticeChan{}
+        , chunkRangeSetNoticeChan{}
         , prodReqChan{}
         , chunkReqChan{}
+        , chunkRangeSetReqChan{}
+        , chunkCancelChan{}
         , chunkChan{}
+        , chunkRunChan{}
+        , chunkLz4Chan{}
+        , gossipChan{}
+        , filterChan{}
+        , smallProdChan{}
+        , heartbeatChan{}
+        , retentionChan{}
         , sock{}
         , requestedChunks{}
+        , negotiated{0}
+        , sendCredit{-1}
+        , consumedChunks{0}
+        , sessionToken{0}
+        , remoteSessionToken{0}
+        , remoteResumeToken{0}
+        , filterMutex{}
+        , remoteFilter{}
+        , excludedProds{}
+        , setupTime{}
+        , servedChunk{false}
+        , lastRecvTick{0}
+        , heartbeatSeq{0}
+        , remoteRetentionKnown{false}
+        , remoteHoldsData{false}
+        , remoteOldestProd{0}
     {}
 
     /**
      * Constructs. Blocks connecting to remote server and exchanging protocol
      * version with remote peer. This is a cancellation point.
-     * @param[in] sock          Socket
+     * @param[in] sock          Message-oriented socket
+     * @param[in] resumeToken   Session token issued by the remote peer on a
+     *                          prior association to present for resumption
+     *                          or 0 for none
      * @throw     LogicError    Unknown protocol version from remote peer
      * @throw     RuntimeError  Couldn't construct peer
      */
-    Impl(   SctpSock&    sock)
+    Impl(   MsgSock        sock,
+            const uint64_t resumeToken = 0)
         : version(0)
         , versionChan(sock, VERSION_STREAM_ID, version)
         , backlogChan(sock, BACKLOG_STREAM_ID, version)
-        , prodNoticeChan(sock, PROD_NOTICE_STREAM_ID, version)
+        , prodNoticeChan(sock, PROD_NOTICE_STREAM_ID, version, NOTICE_TTL_MS)
         , prodInfoChan(sock, PROD_INFO_STREAM_ID, version)
-        , chunkNoticeChan(sock, CHUNK_NOTICE_STREAM_ID, version)
+        , chunkNoticeChan(sock, CHUNK_NOTICE_STREAM_ID, version, NOTICE_TTL_MS)
+        , chunkRangeNoticeChan(sock, CHUNK_RANGE_NOTICE_STREAM_ID, version,
+                NOTICE_TTL_MS)
+        , chunkRangeSetNoticeChan(sock, CHUNK_RANGE_SET_NOTICE_STREAM_ID,
+                version, NOTICE_TTL_MS)
         , prodReqChan(sock, PROD_REQ_STREAM_ID, version)
         , chunkReqChan(sock, CHUNK_REQ_STREAM_ID, version)
+        , chunkRangeSetReqChan(sock, CHUNK_RANGE_SET_REQ_STREAM_ID, version)
+        , chunkCancelChan(sock, CHUNK_CANCEL_STREAM_ID, version,
+                CANCEL_TTL_MS)
         , chunkChan(sock, CHUNK_STREAM_ID, version)
+        , chunkRunChan(sock, CHUNK_RUN_STREAM_ID, version)
+        , chunkLz4Chan(sock, CHUNK_LZ4_STREAM_ID, version)
+        , gossipChan(sock, GOSSIP_STREAM_ID, version)
+        , filterChan(sock, FILTER_STREAM_ID, version)
+        , backlogRecentChan(sock, BACKLOG_RECENT_STREAM_ID, version)
+        , creditChan(sock, CREDIT_STREAM_ID, version)
+        , smallProdChan(sock, SMALL_PROD_STREAM_ID, version)
+        , heartbeatChan(sock, HEARTBEAT_STREAM_ID, version, HEARTBEAT_TTL_MS)
+        , retentionChan(sock, RETENTION_STREAM_ID, version)
         , sock(sock)
         , requestedChunks{}
+        , negotiated{0}
+        , sendCredit{-1}
+        , consumedChunks{0}
+        , sessionToken{makeSessionToken()}
+        , remoteSessionToken{0}
+        , remoteResumeToken{0}
+        , filterMutex{}
+        , remoteFilter{}
+        , excludedProds{}
+        , setupTime{}
+        , servedChunk{false}
+        , lastRecvTick{0}
+        , heartbeatSeq{0}
+        , remoteRetentionKnown{false}
+        , remoteHoldsData{false}
+        , remoteOldestProd{0}
     {
         try {
-            VersionMsg msg(version);
-            versionChan.send(msg);
-            const unsigned vers = getVersion();
-            if (vers != version)
-                throw LOGIC_ERROR(
-                        "Remote peer uses unsupported protocol version: " +
-                        std::to_string(vers));
+            negotiate(resumeToken);
         }
         catch (const std::exception& ex) {
             std::throw_with_nested(RUNTIME_ERROR("Couldn't construct peer"));
@@ -170,14 +805,120 @@ public:
      * Constructs. Blocks connecting to remote server and exchanging protocol
      * version with remote peer.
      * @param[in] peerAddr      Socket address of remote peer
+     * @param[in] resumeToken   Session token issued by the remote peer on a
+     *                          prior association to present for resumption
+     *                          or 0 for none
      * @throw     LogicError    Unknown protocol version from remote peer
      * @throw     RuntimeError  Couldn't construct peer
      * @throw     SystemError   Connection failure
      */
-    Impl(   const InetSockAddr& peerAddr)
-        : Impl{SctpSock{getNumStreams()}.connect(peerAddr)}
+    Impl(   const InetSockAddr&   peerAddr,
+            const Peer::Transport transport,
+            const uint64_t        resumeToken = 0)
+        : Impl{(transport == Peer::Transport::TCP)
+                ? MsgSock{TcpSock{getNumStreams()}.connect(peerAddr)}
+                : MsgSock{SctpSock{getNumStreams()}.connect(peerAddr)},
+                resumeToken}
     {}
 
+    /**
+     * Binds this retired instance to a new association. Assigns the socket,
+     * rebuilds the channels over it, resets the per-association state, and
+     * performs the version exchange exactly as the socket constructor does.
+     * Blocks exchanging protocol version with the remote peer. This is a
+     * cancellation point.
+     * @pre                     `retire()` was called
+     * @param[in] sock          Message-oriented socket
+     * @param[in] resumeToken   Session token issued by the remote peer on a
+     *                          prior association to present for resumption
+     *                          or 0 for none
+     * @throw     LogicError    Unknown protocol version from remote peer
+     * @throw     RuntimeError  Couldn't construct peer
+     */
+    void rebind(
+            MsgSock        sock,
+            const uint64_t resumeToken)
+    {
+        this->sock = sock;
+        versionChan = Channel<VersionMsg>{sock, VERSION_STREAM_ID, version};
+        backlogChan = Channel<ChunkId>{sock, BACKLOG_STREAM_ID, version};
+        prodNoticeChan = Channel<ProdIndex>{sock, PROD_NOTICE_STREAM_ID,
+                version, NOTICE_TTL_MS};
+        prodInfoChan = Channel<ProdInfo>{sock, PROD_INFO_STREAM_ID, version};
+        chunkNoticeChan = Channel<ChunkId>{sock, CHUNK_NOTICE_STREAM_ID,
+                version, NOTICE_TTL_MS};
+        chunkRangeNoticeChan = Channel<ChunkRange>{sock,
+                CHUNK_RANGE_NOTICE_STREAM_ID, version, NOTICE_TTL_MS};
+        chunkRangeSetNoticeChan = Channel<ChunkRangeSet>{sock,
+                CHUNK_RANGE_SET_NOTICE_STREAM_ID, version, NOTICE_TTL_MS};
+        prodReqChan = Channel<ProdIndex>{sock, PROD_REQ_STREAM_ID, version};
+        chunkReqChan = Channel<ChunkId>{sock, CHUNK_REQ_STREAM_ID, version};
+        chunkRangeSetReqChan = Channel<ChunkRangeSet>{sock,
+                CHUNK_RANGE_SET_REQ_STREAM_ID, version};
+        chunkCancelChan = Channel<ChunkId>{sock, CHUNK_CANCEL_STREAM_ID,
+                version, CANCEL_TTL_MS};
+        chunkChan = Channel<ActualChunk,LatentChunk>{sock, CHUNK_STREAM_ID,
+                version};
+        chunkRunChan = Channel<ActualChunkRun,LatentChunkRun>{sock,
+                CHUNK_RUN_STREAM_ID, version};
+        chunkLz4Chan = Channel<ActualCompressedChunk,LatentCompressedChunk>{
+                sock, CHUNK_LZ4_STREAM_ID, version};
+        gossipChan = Channel<PeerGossip>{sock, GOSSIP_STREAM_ID, version};
+        filterChan = Channel<ProdFilter>{sock, FILTER_STREAM_ID, version};
+        backlogRecentChan = Channel<ChunkId>{sock, BACKLOG_RECENT_STREAM_ID,
+                version};
+        creditChan = Channel<CreditMsg>{sock, CREDIT_STREAM_ID, version};
+        smallProdChan = Channel<ActualSmallProd,LatentSmallProd>{sock,
+                SMALL_PROD_STREAM_ID, version};
+        heartbeatChan = Channel<HeartbeatMsg>{sock, HEARTBEAT_STREAM_ID,
+                version, HEARTBEAT_TTL_MS};
+        retentionChan = Channel<RetentionMsg>{sock, RETENTION_STREAM_ID,
+                version};
+        resetSession();
+        sessionToken = makeSessionToken();
+        try {
+            negotiate(resumeToken);
+        }
+        catch (const std::exception& ex) {
+            std::throw_with_nested(RUNTIME_ERROR("Couldn't construct peer"));
+        }
+    }
+
+    /**
+     * Disconnects this instance so it can wait, warm, in the pool of
+     * torn-down peer implementations. Dropping the channels and the socket
+     * closes the association and returns the codecs' serial buffers to their
+     * thread-local free-list; the per-association containers keep their
+     * allocations for the next association.
+     * @pre  No other thread is using this instance
+     */
+    void retire()
+    {
+        versionChan = Channel<VersionMsg>{};
+        backlogChan = Channel<ChunkId>{};
+        prodNoticeChan = Channel<ProdIndex>{};
+        prodInfoChan = Channel<ProdInfo>{};
+        chunkNoticeChan = Channel<ChunkId>{};
+        chunkRangeNoticeChan = Channel<ChunkRange>{};
+        chunkRangeSetNoticeChan = Channel<ChunkRangeSet>{};
+        prodReqChan = Channel<ProdIndex>{};
+        chunkReqChan = Channel<ChunkId>{};
+        chunkRangeSetReqChan = Channel<ChunkRangeSet>{};
+        chunkCancelChan = Channel<ChunkId>{};
+        chunkChan = Channel<ActualChunk,LatentChunk>{};
+        chunkRunChan = Channel<ActualChunkRun,LatentChunkRun>{};
+        chunkLz4Chan = Channel<ActualCompressedChunk,LatentCompressedChunk>{};
+        gossipChan = Channel<PeerGossip>{};
+        filterChan = Channel<ProdFilter>{};
+        backlogRecentChan = Channel<ChunkId>{};
+        creditChan = Channel<CreditMsg>{};
+        smallProdChan = Channel<ActualSmallProd,LatentSmallProd>{};
+        heartbeatChan = Channel<HeartbeatMsg>{};
+        retentionChan = Channel<RetentionMsg>{};
+        sock = MsgSock{};
+        resetSession();
+    }
+
     /**
      * Returns the number of streams.
      */
@@ -195,70 +936,360 @@ public:
         return sock.getRemoteAddr();
     }
 
-    void runReceiver(PeerServer& peerServer)
+    /**
+     * Returns the socket descriptor of the connection. Intended for use by an
+     * event loop that waits for input from many peers at once.
+     * @return Socket descriptor of the connection
+     */
+    inline int getSock() const noexcept
+    {
+        return sock.getSock();
+    }
+
+    /**
+     * Returns a snapshot of the kernel's transport metrics for the
+     * association with the remote peer.
+     * @return             Transport metrics of the association
+     * @throw SystemError  Metrics couldn't be obtained
+     */
+    inline SctpSock::Status getTransportStatus() const
+    {
+        return sock.getStatus();
+    }
+
+    /**
+     * Receives a single message from the remote peer and processes it by
+     * calling a higher-level component. Blocks until a message arrives unless
+     * input is already available (e.g., the socket was reported ready by an
+     * event loop).
+     * @param[in] peerServer  Higher-level component
+     * @param[in] heartbeat   Stall-watchdog heartbeat of the calling thread
+     *                        or `nullptr`
+     * @retval `true`         A message was processed
+     * @retval `false`        The connection was closed by the remote peer
+     */
+    bool receive(
+            PeerServer&                peerServer,
+            Watchdog::Heartbeat* const heartbeat = nullptr)
     {
         try {
-            while (sock.getSize()) { // Blocks waiting for input
-                switch (sock.getStreamId()) {
-                    case BACKLOG_STREAM_ID: {
-                        auto chunkId = backlogChan.recv();
-                        peerServer.startBacklog(chunkId);
-                        break;
-                    }
-                    case PROD_NOTICE_STREAM_ID: {
-                        auto prodIndex = prodNoticeChan.recv();
-                        if (peerServer.shouldRequest(prodIndex))
-                            request(prodIndex);
-                        break;
-                    }
-                    case CHUNK_NOTICE_STREAM_ID: {
-                        auto chunkId = chunkNoticeChan.recv();
-                        LOG_DEBUG("Received notice of chunk " +
-                                chunkId.to_string());
+            if (heartbeat)
+                heartbeat->park(); // Waiting for peer input isn't a stall
+            if (sock.getSize() == 0) // Blocks waiting for input
+                return false;
+            if (heartbeat)
+                heartbeat->beat(); // A message arrived
+            noteMsgReceived(); // Any message proves the remote peer is alive
+            switch (sock.getStreamId()) {
+                case BACKLOG_STREAM_ID: {
+                    auto chunkId = backlogChan.recv();
+                    peerServer.startBacklog(chunkId,
+                            BacklogOrder::OLDEST_FIRST);
+                    break;
+                }
+                case BACKLOG_RECENT_STREAM_ID: {
+                    auto chunkId = backlogRecentChan.recv();
+                    peerServer.startBacklog(chunkId,
+                            BacklogOrder::RECENT_FIRST);
+                    break;
+                }
+                case PROD_NOTICE_STREAM_ID: {
+                    auto prodIndex = prodNoticeChan.recv();
+                    if (peerServer.shouldRequest(prodIndex))
+                        request(prodIndex);
+                    break;
+                }
+                case CHUNK_NOTICE_STREAM_ID: {
+                    auto chunkId = chunkNoticeChan.recv();
+                    LOG_DEBUG("Received notice of chunk " +
+                            chunkId.to_string());
+                    if (peerServer.shouldRequest(chunkId))
+                        request(chunkId);
+                    break;
+                }
+                case CHUNK_RANGE_NOTICE_STREAM_ID: {
+                    auto chunkRange = chunkRangeNoticeChan.recv();
+                    LOG_DEBUG("Received notice of chunk-range " +
+                            chunkRange.to_string());
+                    ChunkRangeSet          reqSet{};
+                    const ChunkIndex::type numChunks =
+                            chunkRange.getNumChunks();
+                    for (ChunkIndex::type i = 0; i < numChunks; ++i) {
+                        auto chunkId = chunkRange.getChunkId(i);
                         if (peerServer.shouldRequest(chunkId))
-                            request(chunkId);
-                        break;
+                            batchRequest(reqSet, chunkId);
+                    }
+                    if (reqSet)
+                        request(reqSet);
+                    break;
+                }
+                case CHUNK_RANGE_SET_NOTICE_STREAM_ID: {
+                    auto rangeSet = chunkRangeSetNoticeChan.recv();
+                    LOG_DEBUG("Received notice of chunk-range set " +
+                            rangeSet.to_string());
+                    ChunkRangeSet reqSet{};
+                    for (const auto& chunkRange : rangeSet) {
+                        const ChunkIndex::type numChunks =
+                                chunkRange.getNumChunks();
+                        for (ChunkIndex::type i = 0; i < numChunks; ++i) {
+                            auto chunkId = chunkRange.getChunkId(i);
+                            if (peerServer.shouldRequest(chunkId))
+                                batchRequest(reqSet, chunkId);
+                        }
                     }
-                    case PROD_REQ_STREAM_ID: {
-                        ProdInfo prodInfo{};
-                        if (peerServer.get(prodReqChan.recv(), prodInfo))
+                    if (reqSet)
+                        request(reqSet);
+                    break;
+                }
+                case PROD_REQ_STREAM_ID: {
+                    ProdInfo prodInfo{};
+                    if (peerServer.get(prodReqChan.recv(), prodInfo)) {
+                        /*
+                         * A single-chunk product whose data is on hand is
+                         * served as one combined information-and-data
+                         * message, saving the remote peer the chunk
+                         * request/reply exchange and a second store
+                         * insertion.
+                         */
+                        ActualChunk chunk{};
+                        if (canUse(VersionMsg::SMALL_PRODUCTS) &&
+                                prodInfo.getNumChunks() == 1 &&
+                                peerServer.get(
+                                        ChunkInfo{prodInfo, 0}.getId(),
+                                        chunk)) {
+                            smallProdChan.send(
+                                    ActualSmallProd{prodInfo, chunk});
+                            recordServedChunk();
+                        }
+                        else {
                             send(prodInfo);
-                        break;
+                        }
                     }
-                    case CHUNK_REQ_STREAM_ID: {
-                        ActualChunk chunk;
-                        if (peerServer.get(chunkReqChan.recv(), chunk))
-                            send(chunk);
-                        break;
+                    break;
+                }
+                case CHUNK_REQ_STREAM_ID: {
+                    ActualChunk chunk;
+                    if (peerServer.get(chunkReqChan.recv(), chunk))
+                        send(chunk);
+                    break;
+                }
+                case CHUNK_RANGE_SET_REQ_STREAM_ID: {
+                    auto rangeSet = chunkRangeSetReqChan.recv();
+                    LOG_DEBUG("Received request for chunk-range set " +
+                            rangeSet.to_string());
+                    // Contiguous gettable chunks are coalesced into runs
+                    std::vector<ActualChunk> run{};
+                    bool outOfCredit = false;
+                    for (const auto& chunkRange : rangeSet) {
+                        const ChunkIndex::type numChunks =
+                                chunkRange.getNumChunks();
+                        for (ChunkIndex::type i = 0; i < numChunks; ++i) {
+                            /*
+                             * Credit messages arrive on this very thread, so
+                             * waiting for credit here would deadlock. The
+                             * unserved remainder is dropped instead; the
+                             * remote peer re-requests it.
+                             */
+                            if (!hasSendCredit()) {
+                                creditExhausted(chunkRange.getChunkId(i));
+                                outOfCredit = true;
+                                break;
+                            }
+                            ActualChunk chunk;
+                            if (peerServer.get(chunkRange.getChunkId(i),
+                                    chunk)) {
+                                if (!run.empty() && !extendsRun(run, chunk))
+                                    sendRun(run);
+                                run.push_back(chunk);
+                                if (run.size() >= ActualChunkRun::maxChunks)
+                                    sendRun(run);
+                            }
+                            else {
+                                sendRun(run); // Gap in the run
+                            }
+                        }
+                        if (outOfCredit)
+                            break;
                     }
-                    case PROD_INFO_STREAM_ID: {
-                        auto prodInfo = prodInfoChan.recv();
-                        peerServer.receive(prodInfo);
-                        break;
+                    sendRun(run);
+                    break;
+                }
+                case CHUNK_CANCEL_STREAM_ID: {
+                    auto chunkId = chunkCancelChan.recv();
+                    peerServer.cancel(chunkId);
+                    break;
+                }
+                case PROD_INFO_STREAM_ID: {
+                    auto prodInfo = prodInfoChan.recv();
+                    peerServer.receive(prodInfo);
+                    break;
+                }
+                case CHUNK_STREAM_ID: {
+                    auto chunk = chunkChan.recv();
+                    peerServer.receive(chunk);
+                    requestedChunks.erase(chunk.getId());
+                    chunkConsumed();
+                    break;
+                }
+                case CHUNK_RUN_STREAM_ID: {
+                    auto run = chunkRunChan.recv();
+                    const auto totalSize = run.getTotalSize();
+                    std::vector<char> buf(totalSize);
+                    // A corrupt run is dropped whole; its chunks will be
+                    // re-requested individually
+                    if (run.drainData(buf.data(), totalSize) == totalSize) {
+                        const auto numChunks = run.getNumChunks();
+                        /*
+                         * The whole run goes up as one batch, so the
+                         * product-store can take its shard-lock once for
+                         * the run instead of once per chunk.
+                         */
+                        std::vector<LatentChunk> batch{};
+                        std::vector<RecvStatus>  statuses(numChunks);
+                        batch.reserve(numChunks);
+                        size_t offset = 0;
+                        for (unsigned i = 0; i < numChunks; ++i) {
+                            const auto chunkInfo = run.getChunkInfo(i);
+                            batch.push_back(
+                                    LatentChunk{chunkInfo,
+                                            buf.data() + offset});
+                            offset += chunkInfo.getSize();
+                        }
+                        peerServer.receive(batch.data(), batch.size(),
+                                statuses.data());
+                        for (auto& chunk : batch) {
+                            if (chunk.hasData())
+                                chunk.discard();
+                            requestedChunks.erase(chunk.getId());
+                            chunkConsumed();
+                        }
                     }
-                    case CHUNK_STREAM_ID: {
-                        auto chunk = chunkChan.recv();
+                    break;
+                }
+                case CHUNK_LZ4_STREAM_ID: {
+                    auto compressed = chunkLz4Chan.recv();
+                    const auto chunkInfo = compressed.getInfo();
+                    std::vector<char> buf(chunkInfo.getSize());
+                    // A corrupt chunk is dropped; it will be re-requested
+                    if (compressed.drainData(buf.data(), buf.size()) ==
+                            chunkInfo.getSize()) {
+                        LatentChunk chunk{chunkInfo, buf.data()};
                         peerServer.receive(chunk);
-                        requestedChunks.erase(chunk.getId());
-                        break;
+                        if (chunk.hasData())
+                            chunk.discard();
+                        requestedChunks.erase(chunkInfo.getId());
+                        chunkConsumed();
                     }
-                    default:
-                        LOG_WARN("Discarding unknown message type " +
-                                std::to_string(sock.getStreamId()) +
-                                " from remote peer " + to_string());
-                        sock.discard();
-                } // Channel/Stream-ID switch
-            } // Input loop
+                    break;
+                }
+                case GOSSIP_STREAM_ID: {
+                    auto gossip = gossipChan.recv();
+                    peerServer.receive(gossip);
+                    break;
+                }
+                case SMALL_PROD_STREAM_ID: {
+                    auto smallProd = smallProdChan.recv();
+                    peerServer.receive(smallProd);
+                    if (smallProd.hasData())
+                        smallProd.discard();
+                    requestedChunks.erase(
+                            ChunkInfo{smallProd.getInfo(), 0}.getId());
+                    break;
+                }
+                case CREDIT_STREAM_ID: {
+                    const auto credit = creditChan.recv().getCredit();
+                    // Absolute: each advertisement replaces the last, so the
+                    // two sides can't drift apart
+                    if (canUse(VersionMsg::FLOW_CONTROL))
+                        sendCredit = static_cast<long>(credit);
+                    break;
+                }
+                case HEARTBEAT_STREAM_ID: {
+                    // The arrival itself is the payload: it was recorded by
+                    // `noteMsgReceived()` above
+                    heartbeatChan.recv();
+                    break;
+                }
+                case RETENTION_STREAM_ID: {
+                    const auto retention = retentionChan.recv();
+                    // Absolute: each advertisement replaces the last, so the
+                    // two sides can't drift apart
+                    if (canUse(VersionMsg::RETENTION)) {
+                        remoteOldestProd = static_cast<ProdIndex::type>(
+                                retention.getOldestProd());
+                        remoteHoldsData = retention.holdsAnything();
+                        remoteRetentionKnown = true;
+                    }
+                    break;
+                }
+                case FILTER_STREAM_ID: {
+                    auto filter = filterChan.recv();
+                    std::lock_guard<std::mutex> lock{filterMutex};
+                    remoteFilter = filter;
+                    // The new filter might admit previously-excluded products
+                    excludedProds.clear();
+                    break;
+                }
+                default:
+                    LOG_WARN("Discarding unknown message type " +
+                            std::to_string(sock.getStreamId()) +
+                            " from remote peer " + to_string());
+                    sock.discard();
+            } // Channel/Stream-ID switch
         }
         catch (const std::exception& ex) {
             std::throw_with_nested(RUNTIME_ERROR("Failure of peer " +
                     to_string()));
         }
+        return true;
+    }
+
+    /**
+     * Indicates if the connection has input that can be received without
+     * waiting for network activity: a message already peeked from the socket
+     * or unread bytes in the kernel's receive buffer. NB: unread bytes may
+     * comprise only part of a message, in which case receiving still waits
+     * for the remainder -- the same wait any message that arrives in pieces
+     * incurs.
+     * @retval `true`    Input is available
+     * @retval `false`   No input is available
+     * @exceptionsafety  Nothrow
+     * @threadsafety     Safe
+     */
+    bool hasInput() const noexcept
+    {
+        if (sock.hasMessage())
+            return true;
+        struct pollfd pfd;
+        pfd.fd = sock.getSock();
+        pfd.events = POLLIN;
+        return ::poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLIN) != 0;
     }
 
-    void requestBacklog(const ChunkId& chunkId)
+    void runReceiver(PeerServer& peerServer)
+    {
+        auto heartbeat = Watchdog::registerThread(
+                "peer " + getRemoteAddr().to_string());
+        while (receive(peerServer, &heartbeat))
+            ; // Input loop
+    }
+
+    void requestBacklog(
+            const ChunkId&     chunkId,
+            const BacklogOrder order)
     {
-        backlogChan.send(chunkId);
+        /*
+         * The order rides in the choice of stream. A remote peer that
+         * predates `BACKLOG_RECENT_STREAM_ID` discards the message
+         * unprocessed, so a recent-first request degrades to no backlog
+         * rather than to a misordered one.
+         */
+        if (order == BacklogOrder::RECENT_FIRST) {
+            backlogRecentChan.send(chunkId);
+        }
+        else {
+            backlogChan.send(chunkId);
+        }
     }
 
     /**
@@ -280,6 +1311,82 @@ public:
         }
     }
 
+    /**
+     * Notifies the remote peer about available information on a product
+     * using a fan-out cache of the notice's serialized form, so a notice
+     * fanned out to many peers is serialized once per wire-encoding instead
+     * of once per peer.
+     * @param[in] prodIndex       Index of the relevant product
+     * @param[in] cache           Cache of the notice's serialized form,
+     *                            shared by the fan-out
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void notify(
+            const ProdIndex&   prodIndex,
+            const NoticeCache& cache) const
+    {
+        const auto buffer = cache.get(prodIndex, noticeVersion());
+        if (!buffer)
+            return notify(prodIndex); // Uncacheable encoding
+        try {
+            prodNoticeChan.sendSerialized(buffer->data(), buffer->size());
+        }
+        catch (const std::exception& ex) {
+            std::throw_with_nested(RUNTIME_ERROR("Couldn't notify remote peer "
+                    + getRemoteAddr().to_string() +
+                    " about information on product " + prodIndex.to_string()));
+        }
+    }
+
+    /**
+     * Notifies the remote peer about available product information,
+     * identifying the product by name. If the remote peer's product filter
+     * excludes the name, then no notice is sent and the product is recorded
+     * so its chunk notices are suppressed as well.
+     * @param[in] prodIndex       Index of the relevant product
+     * @param[in] prodName        Name of the product or the empty string if
+     *                            unknown, in which case the notice is always
+     *                            sent
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void notify(
+            const ProdIndex&   prodIndex,
+            const std::string& prodName)
+    {
+        if (filterExcludes(prodIndex, prodName))
+            return; // The remote peer doesn't want the product
+        notify(prodIndex);
+    }
+
+    /**
+     * Notifies the remote peer about available product information,
+     * identifying the product by name, using a fan-out cache of the notice's
+     * serialized form. The remote peer's product filter is applied as usual:
+     * only the serialization is shared.
+     * @param[in] prodIndex       Index of the relevant product
+     * @param[in] prodName        Name of the product or the empty string if
+     *                            unknown, in which case the notice is always
+     *                            sent
+     * @param[in] cache           Cache of the notice's serialized form,
+     *                            shared by the fan-out
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void notify(
+            const ProdIndex&   prodIndex,
+            const std::string& prodName,
+            const NoticeCache& cache)
+    {
+        if (filterExcludes(prodIndex, prodName))
+            return; // The remote peer doesn't want the product
+        notify(prodIndex, cache);
+    }
+
     /**
      * Notifies the remote peer about an available chunk of data.
      * @param[in] chunkId         Relevant data-chunk identifier
@@ -289,8 +1396,14 @@ public:
      */
     void notify(const ChunkId& chunkId) const
     {
+        if (excludes(chunkId.getProdIndex()))
+            return; // The remote peer's filter excluded the product
+        OpAccounting::Scope opScope{OpAccounting::NOTIFY};
         try {
             chunkNoticeChan.send(chunkId);
+            HYCAST_PROBE2(notice_sent,
+                    static_cast<ProdIndex::type>(chunkId.getProdIndex()),
+                    static_cast<ChunkIndex::type>(chunkId.getChunkIndex()));
         }
         catch (const std::exception& ex) {
             std::throw_with_nested(RUNTIME_ERROR("Couldn't notify remote peer "
@@ -300,88 +1413,497 @@ public:
     }
 
     /**
-     * Requests information on a product from the remote peer.
-     * @param[in] prodIndex       Index of relevant product
+     * Notifies the remote peer about an available chunk of data using a
+     * fan-out cache of the notice's serialized form.
+     * @param[in] chunkId         Relevant data-chunk identifier
+     * @param[in] cache           Cache of the notice's serialized form,
+     *                            shared by the fan-out
      * @throws std::system_error  I/O error occurred
      * @exceptionsafety           Basic
      * @threadsafety              Compatible but not safe
      */
-    void request(const ProdIndex& prodIndex) const
+    void notify(
+            const ChunkId&     chunkId,
+            const NoticeCache& cache) const
     {
+        if (excludes(chunkId.getProdIndex()))
+            return; // The remote peer's filter excluded the product
+        const auto buffer = cache.get(chunkId, noticeVersion());
+        if (!buffer)
+            return notify(chunkId); // Uncacheable encoding
+        OpAccounting::Scope opScope{OpAccounting::NOTIFY};
         try {
-            prodReqChan.send(prodIndex);
+            chunkNoticeChan.sendSerialized(buffer->data(), buffer->size());
+            HYCAST_PROBE2(notice_sent,
+                    static_cast<ProdIndex::type>(chunkId.getProdIndex()),
+                    static_cast<ChunkIndex::type>(chunkId.getChunkIndex()));
         }
         catch (const std::exception& ex) {
-            std::throw_with_nested(RUNTIME_ERROR(
-                    "Couldn't request information on product "
-                    + prodIndex.to_string() + " from remote peer " +
-                    getRemoteAddr().to_string()));
+            std::throw_with_nested(RUNTIME_ERROR("Couldn't notify remote peer "
+                    + getRemoteAddr().to_string() +
+                    " about data-chunk " + chunkId.to_string()));
         }
     }
 
     /**
-     * Requests a chunk-of-data from the remote peer.
-     * @param[in] chunkId         Data-chunk identifier
+     * Notifies the remote peer about a contiguous range of available chunks
+     * of data.
+     * @param[in] chunkRange      Relevant range of chunk identifiers
      * @throws std::system_error  I/O error occurred
      * @exceptionsafety           Basic
      * @threadsafety              Compatible but not safe
      */
-    void request(const ChunkId& chunkId)
+    void notify(const ChunkRange& chunkRange) const
     {
+        if (excludes(chunkRange.getFirst().getProdIndex()))
+            return; // The remote peer's filter excluded the product
         try {
-            // NB: Higher-level peer-replacement prevents unlimited growth
-            requestedChunks.insert(chunkId);
-            chunkReqChan.send(chunkId);
+            chunkRangeNoticeChan.send(chunkRange);
         }
         catch (const std::exception& ex) {
-            std::throw_with_nested(RUNTIME_ERROR("Couldn't request data-chunk "
-                    + chunkId.to_string() + " from remote peer " +
-                    getRemoteAddr().to_string()));
+            std::throw_with_nested(RUNTIME_ERROR("Couldn't notify remote peer "
+                    + getRemoteAddr().to_string() +
+                    " about chunk-range " + chunkRange.to_string()));
         }
     }
 
     /**
-     * Sends information on a product to the remote peer.
-     * @param[in] prodInfo        Product information
+     * Notifies the remote peer about a contiguous range of available chunks
+     * of data using a fan-out cache of the notice's serialized form.
+     * @param[in] chunkRange      Relevant range of chunk identifiers
+     * @param[in] cache           Cache of the notice's serialized form,
+     *                            shared by the fan-out
      * @throws std::system_error  I/O error occurred
      * @exceptionsafety           Basic
      * @threadsafety              Compatible but not safe
      */
-    void send(const ProdInfo& prodInfo) const
+    void notify(
+            const ChunkRange&  chunkRange,
+            const NoticeCache& cache) const
     {
+        if (excludes(chunkRange.getFirst().getProdIndex()))
+            return; // The remote peer's filter excluded the product
+        const auto buffer = cache.get(chunkRange, noticeVersion());
+        if (!buffer)
+            return notify(chunkRange); // Uncacheable encoding
         try {
-            prodInfoChan.send(prodInfo);
+            chunkRangeNoticeChan.sendSerialized(buffer->data(),
+                    buffer->size());
         }
         catch (const std::exception& ex) {
-            std::throw_with_nested(RUNTIME_ERROR(
-                    "Couldn't send information on product " +
-                    prodInfo.to_string() + " to remote peer " +
-                    getRemoteAddr().to_string()));
+            std::throw_with_nested(RUNTIME_ERROR("Couldn't notify remote peer "
+                    + getRemoteAddr().to_string() +
+                    " about chunk-range " + chunkRange.to_string()));
         }
     }
 
     /**
-     * Sends a chunk of data to the remote peer.
-     * @param[in] chunk           Chunk of data
+     * Notifies the remote peer about a set of available chunks of data
+     * encoded as contiguous ranges.
+     * @param[in] rangeSet        Relevant set of chunk-ranges
      * @throws std::system_error  I/O error occurred
      * @exceptionsafety           Basic
      * @threadsafety              Compatible but not safe
      */
-    void send(const ActualChunk& chunk) const
+    void notify(const ChunkRangeSet& rangeSet) const
     {
+        // Ranges of products the remote peer's filter excluded are dropped.
+        // A range never spans products, so exclusion is per-range.
+        ChunkRangeSet filtered{};
+        bool          dropped = false;
+        {
+            std::lock_guard<std::mutex> lock{filterMutex};
+            if (!excludedProds.empty()) {
+                for (const auto& chunkRange : rangeSet) {
+                    if (excludedProds.count(
+                            chunkRange.getFirst().getProdIndex())) {
+                        dropped = true;
+                    }
+                    else {
+                        filtered.add(chunkRange);
+                    }
+                }
+            }
+        }
+        if (dropped && !filtered)
+            return; // Every range was excluded
+        const auto& toSend = dropped ? filtered : rangeSet;
         try {
-            chunkChan.send(chunk);
+            chunkRangeSetNoticeChan.send(toSend);
         }
         catch (const std::exception& ex) {
-            std::throw_with_nested(RUNTIME_ERROR("Couldn't send data-chunk " +
-                    chunk.getId().to_string() + " to remote peer " +
-                    getRemoteAddr().to_string()));
+            std::throw_with_nested(RUNTIME_ERROR("Couldn't notify remote peer "
+                    + getRemoteAddr().to_string() +
+                    " about chunk-range set " + toSend.to_string()));
         }
     }
 
     /**
-     * Indicates if this instance equals another.
-     * @param[in] that  Other instance
+     * Notifies the remote peer about a set of available chunks of data
+     * encoded as contiguous ranges, using a fan-out cache of the notice's
+     * serialized form. If the remote peer's filter excludes any of the set's
+     * products, its notice differs from the shared one and is serialized
+     * individually.
+     * @param[in] rangeSet        Relevant set of chunk-ranges
+     * @param[in] cache           Cache of the notice's serialized form,
+     *                            shared by the fan-out
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void notify(
+            const ChunkRangeSet& rangeSet,
+            const NoticeCache&   cache) const
+    {
+        bool subset = false;
+        {
+            std::lock_guard<std::mutex> lock{filterMutex};
+            if (!excludedProds.empty()) {
+                for (const auto& chunkRange : rangeSet) {
+                    if (excludedProds.count(
+                            chunkRange.getFirst().getProdIndex())) {
+                        subset = true;
+                        break;
+                    }
+                }
+            }
+        }
+        if (subset)
+            return notify(rangeSet); // This peer gets a per-peer subset
+        const auto buffer = cache.get(rangeSet, noticeVersion());
+        if (!buffer)
+            return notify(rangeSet); // Uncacheable encoding
+        try {
+            chunkRangeSetNoticeChan.sendSerialized(buffer->data(),
+                    buffer->size());
+        }
+        catch (const std::exception& ex) {
+            std::throw_with_nested(RUNTIME_ERROR("Couldn't notify remote peer "
+                    + getRemoteAddr().to_string() +
+                    " about chunk-range set " + rangeSet.to_string()));
+        }
+    }
+
+    /**
+     * Requests information on a product from the remote peer.
+     * @param[in] prodIndex       Index of relevant product
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void request(const ProdIndex& prodIndex) const
+    {
+        try {
+            prodReqChan.send(prodIndex);
+        }
+        catch (const std::exception& ex) {
+            std::throw_with_nested(RUNTIME_ERROR(
+                    "Couldn't request information on product "
+                    + prodIndex.to_string() + " from remote peer " +
+                    getRemoteAddr().to_string()));
+        }
+    }
+
+    /**
+     * Requests a chunk-of-data from the remote peer.
+     * @param[in] chunkId         Data-chunk identifier
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void request(const ChunkId& chunkId)
+    {
+        try {
+            // NB: Higher-level peer-replacement prevents unlimited growth
+            requestedChunks.insert(chunkId);
+            chunkReqChan.send(chunkId);
+            HYCAST_PROBE2(request_sent,
+                    static_cast<ProdIndex::type>(chunkId.getProdIndex()),
+                    static_cast<ChunkIndex::type>(chunkId.getChunkIndex()));
+            FlightRecorder::record(FlightRecorder::Event::REQUEST_SENT,
+                    static_cast<ProdIndex::type>(chunkId.getProdIndex()),
+                    static_cast<ChunkIndex::type>(chunkId.getChunkIndex()));
+        }
+        catch (const std::exception& ex) {
+            std::throw_with_nested(RUNTIME_ERROR("Couldn't request data-chunk "
+                    + chunkId.to_string() + " from remote peer " +
+                    getRemoteAddr().to_string()));
+        }
+    }
+
+    /**
+     * Requests a set of chunks-of-data, encoded as contiguous ranges, from
+     * the remote peer. One vectored request message is sent instead of a
+     * request per chunk, so asking for a deep backlog costs a few serialized
+     * ranges rather than hundreds of small records.
+     * @param[in] rangeSet        Set of chunk-ranges to request
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void request(const ChunkRangeSet& rangeSet)
+    {
+        try {
+            for (const auto& chunkRange : rangeSet) {
+                const ChunkIndex::type numChunks = chunkRange.getNumChunks();
+                // NB: Higher-level peer-replacement prevents unlimited growth
+                for (ChunkIndex::type i = 0; i < numChunks; ++i)
+                    requestedChunks.insert(chunkRange.getChunkId(i));
+            }
+            chunkRangeSetReqChan.send(rangeSet);
+        }
+        catch (const std::exception& ex) {
+            std::throw_with_nested(RUNTIME_ERROR(
+                    "Couldn't request chunk-range set " + rangeSet.to_string()
+                    + " from remote peer " + getRemoteAddr().to_string()));
+        }
+    }
+
+    /**
+     * Cancels a previous request for a chunk-of-data -- e.g., because the
+     * chunk arrived via multicast. Best-effort: SCTP streams are ordered
+     * independently, so the cancellation can overtake the request it cancels,
+     * and the remote peer ignores a cancellation for an unknown chunk.
+     * @param[in] chunkId         Data-chunk identifier
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void cancel(const ChunkId& chunkId)
+    {
+        try {
+            requestedChunks.erase(chunkId);
+            chunkCancelChan.send(chunkId);
+        }
+        catch (const std::exception& ex) {
+            std::throw_with_nested(RUNTIME_ERROR(
+                    "Couldn't cancel request for data-chunk "
+                    + chunkId.to_string() + " to remote peer " +
+                    getRemoteAddr().to_string()));
+        }
+    }
+
+    /**
+     * Sends information on a product to the remote peer.
+     * @param[in] prodInfo        Product information
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void send(const ProdInfo& prodInfo) const
+    {
+        try {
+            prodInfoChan.send(prodInfo);
+        }
+        catch (const std::exception& ex) {
+            std::throw_with_nested(RUNTIME_ERROR(
+                    "Couldn't send information on product " +
+                    prodInfo.to_string() + " to remote peer " +
+                    getRemoteAddr().to_string()));
+        }
+    }
+
+    /**
+     * Sends a chunk of data to the remote peer.
+     * @param[in] chunk           Chunk of data
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void send(const ActualChunk& chunk) const
+    {
+        try {
+            // Dropped, not blocked, when the remote peer's receive-window
+            // credit is exhausted; the remote peer re-requests the chunk
+            if (!consumeSendCredit()) {
+                creditExhausted(chunk.getId());
+                return;
+            }
+            /*
+             * Chunk payloads are compressed when both peers advertised the
+             * capability and the chunk is big enough to pay for it.
+             * Incompressible data (detected cheaply by LZ4 itself) falls
+             * through to the uncompressed path.
+             */
+            if (canUse(VersionMsg::LZ4_CHUNKS) &&
+                    chunk.getSize() >= ActualCompressedChunk::minSize) {
+                ActualCompressedChunk compressed{chunk};
+                if (compressed) {
+                    chunkLz4Chan.send(compressed);
+                    HYCAST_PROBE3(request_served,
+                            static_cast<ProdIndex::type>(
+                                    chunk.getId().getProdIndex()),
+                            static_cast<ChunkIndex::type>(
+                                    chunk.getId().getChunkIndex()),
+                            static_cast<ChunkSize::type>(chunk.getSize()));
+                    FlightRecorder::record(
+                            FlightRecorder::Event::REQUEST_SERVED,
+                            static_cast<ProdIndex::type>(
+                                    chunk.getId().getProdIndex()),
+                            static_cast<ChunkIndex::type>(
+                                    chunk.getId().getChunkIndex()),
+                            static_cast<ChunkSize::type>(chunk.getSize()));
+                    recordServedChunk();
+                    return;
+                }
+            }
+            chunkChan.send(chunk);
+            HYCAST_PROBE3(request_served,
+                    static_cast<ProdIndex::type>(chunk.getId().getProdIndex()),
+                    static_cast<ChunkIndex::type>(
+                            chunk.getId().getChunkIndex()),
+                    static_cast<ChunkSize::type>(chunk.getSize()));
+            FlightRecorder::record(FlightRecorder::Event::REQUEST_SERVED,
+                    static_cast<ProdIndex::type>(chunk.getId().getProdIndex()),
+                    static_cast<ChunkIndex::type>(
+                            chunk.getId().getChunkIndex()),
+                    static_cast<ChunkSize::type>(chunk.getSize()));
+            recordServedChunk();
+        }
+        catch (const std::exception& ex) {
+            std::throw_with_nested(RUNTIME_ERROR("Couldn't send data-chunk " +
+                    chunk.getId().to_string() + " to remote peer " +
+                    getRemoteAddr().to_string()));
+        }
+    }
+
+    /**
+     * Sends a gossip message to the remote peer.
+     * @param[in] gossip          Gossip message
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void gossip(const PeerGossip& gossip) const
+    {
+        try {
+            gossipChan.send(gossip);
+        }
+        catch (const std::exception& ex) {
+            std::throw_with_nested(RUNTIME_ERROR(
+                    "Couldn't send gossip message to remote peer " +
+                    getRemoteAddr().to_string()));
+        }
+    }
+
+    /**
+     * Sends this instance's product filter to the remote peer, which then
+     * stops sending notices for products whose names the filter excludes.
+     * @param[in] filter          Product filter
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void setFilter(const ProdFilter& filter) const
+    {
+        try {
+            filterChan.send(filter);
+        }
+        catch (const std::exception& ex) {
+            std::throw_with_nested(RUNTIME_ERROR(
+                    "Couldn't send product filter to remote peer " +
+                    getRemoteAddr().to_string()));
+        }
+    }
+
+    /**
+     * Sends a liveness heartbeat to the remote peer. Does nothing if
+     * heartbeats weren't negotiated.
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void sendHeartbeat()
+    {
+        if (!canUse(VersionMsg::HEARTBEATS))
+            return;
+        try {
+            heartbeatChan.send(HeartbeatMsg{heartbeatSeq.fetch_add(1) + 1});
+        }
+        catch (const std::exception& ex) {
+            std::throw_with_nested(RUNTIME_ERROR(
+                    "Couldn't send heartbeat to remote peer " +
+                    getRemoteAddr().to_string()));
+        }
+    }
+
+    /**
+     * Advertises this peer's retention range to the remote peer, which then
+     * stops assigning this peer chunk-requests for products older than the
+     * advertised oldest resident product. Does nothing if retention
+     * advertisements weren't negotiated.
+     * @param[in] retention       Retention advertisement
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void advertiseRetention(const RetentionMsg& retention)
+    {
+        if (!canUse(VersionMsg::RETENTION))
+            return;
+        try {
+            retentionChan.send(retention);
+        }
+        catch (const std::exception& ex) {
+            std::throw_with_nested(RUNTIME_ERROR(
+                    "Couldn't send retention advertisement to remote peer " +
+                    getRemoteAddr().to_string()));
+        }
+    }
+
+    /**
+     * Indicates if the remote peer's store might still hold a given product,
+     * according to its most recent retention advertisement. A peer that
+     * hasn't advertised is assumed to hold everything, so a request to it
+     * behaves exactly as before retention advertisements existed.
+     * @param[in] prodIndex  Index of the product in question
+     * @retval `true`        The remote peer might hold the product
+     * @retval `false`       The remote peer evicted the product
+     * @exceptionsafety      Nothrow
+     * @threadsafety         Safe
+     */
+    bool mayHave(const ProdIndex& prodIndex) const noexcept
+    {
+        if (!remoteRetentionKnown.load(std::memory_order_relaxed))
+            return true;
+        if (!remoteHoldsData.load(std::memory_order_relaxed))
+            return false;
+        const ProdIndex oldest{
+                remoteOldestProd.load(std::memory_order_relaxed)};
+        return !prodIndex.isEarlierThan(oldest);
+    }
+
+    /**
+     * Indicates if liveness heartbeats were negotiated on this association,
+     * in which case the remote peer sends them when idle and this peer may
+     * be evicted for prolonged silence.
+     * @retval `true`    Iff heartbeats were negotiated
+     * @exceptionsafety  Nothrow
+     * @threadsafety     Safe
+     */
+    bool heartbeatsNegotiated() const noexcept
+    {
+        return canUse(VersionMsg::HEARTBEATS);
+    }
+
+    /**
+     * Returns the time since a message -- any message -- was last received
+     * from the remote peer.
+     * @return           Duration of the current receive-side silence
+     * @exceptionsafety  Nothrow
+     * @threadsafety     Safe
+     */
+    std::chrono::milliseconds getRecvSilence() const noexcept
+    {
+        const std::chrono::steady_clock::duration elapsed{
+                std::chrono::steady_clock::now().time_since_epoch().count() -
+                lastRecvTick.load(std::memory_order_relaxed)};
+        return std::chrono::duration_cast<std::chrono::milliseconds>(elapsed);
+    }
+
+    /**
+     * Indicates if this instance equals another.
+     * @param[in] that  Other instance
      * @return `true` iff this instance equals the other
      * @execptionsafety Nothrow
      * @threadsafety    Thread-safe
@@ -446,28 +1968,191 @@ public:
     {
         return requestedChunks.getChunkIds();
     }
+
+    /**
+     * Returns the session token this peer issued for the association.
+     * @return Issued session token
+     */
+    inline uint64_t getSessionToken() const noexcept
+    {
+        return sessionToken;
+    }
+
+    /**
+     * Returns the session token the remote peer issued for the association.
+     * @return Remotely-issued session token
+     */
+    inline uint64_t getRemoteSessionToken() const noexcept
+    {
+        return remoteSessionToken;
+    }
+
+    /**
+     * Returns the session token the remote peer presented for resumption.
+     * @return Presented resumption token or 0 for none
+     */
+    inline uint64_t getResumeToken() const noexcept
+    {
+        return remoteResumeToken;
+    }
 };
 
+/**
+ * Pool of warm, retired peer implementations. A reconnect storm after a
+ * network blip makes the peer-server construct peers back-to-back, so a
+ * torn-down implementation -- whose containers keep their allocations and
+ * whose channels draw their codec buffers from the thread-local free-list --
+ * is reused instead of constructed from scratch. The pool is bounded so an
+ * idle process doesn't hoard peer objects.
+ */
+class Peer::ImplPool final
+{
+    typedef std::mutex             Mutex;
+    typedef std::lock_guard<Mutex> LockGuard;
+
+    /// Bound on the number of pooled implementations. A storm deeper than
+    /// this merely falls back to ordinary construction.
+    static const size_t                       MAX_IMPLS = 8;
+    static Mutex                              mutex;
+    static std::vector<std::shared_ptr<Impl>> impls;
+
+public:
+    /**
+     * Returns a warm, retired peer implementation or an empty pointer if the
+     * pool is empty.
+     * @return        Retired implementation to rebind or an empty pointer
+     * @threadsafety  Safe
+     */
+    static std::shared_ptr<Impl> get()
+    {
+        static auto& reuses = Metrics::getCounter(
+                "hycast_peer_pool_reuses_total",
+                "Connections served by a warm, pooled peer implementation");
+        static auto& misses = Metrics::getCounter(
+                "hycast_peer_pool_misses_total",
+                "Connections whose peer implementation was constructed from "
+                "scratch because the pool was empty");
+        LockGuard lock{mutex};
+        if (impls.empty()) {
+            misses.add();
+            return std::shared_ptr<Impl>{};
+        }
+        auto impl = impls.back();
+        impls.pop_back();
+        reuses.add();
+        return impl;
+    }
+
+    /**
+     * Offers a retired peer implementation to the pool. The implementation
+     * is discarded if the pool is full.
+     * @pre           `impl->retire()` was called
+     * @param[in] impl  Retired implementation
+     * @threadsafety    Safe
+     */
+    static void put(const std::shared_ptr<Impl>& impl)
+    {
+        LockGuard lock{mutex};
+        if (impls.size() < MAX_IMPLS)
+            impls.push_back(impl);
+    }
+};
+
+std::mutex                                    Peer::ImplPool::mutex;
+std::vector<std::shared_ptr<Peer::Impl>>      Peer::ImplPool::impls;
+
 Peer::Peer()
     : pImpl(new Impl())
 {}
 
-Peer::Peer(SctpSock& sock)
-    : pImpl{new Impl(sock)}
-{}
+Peer::Peer(
+        SctpSock&      sock,
+        const uint64_t resumeToken)
+    : pImpl{ImplPool::get()}
+{
+    if (pImpl) {
+        pImpl->rebind(MsgSock{sock}, resumeToken);
+    }
+    else {
+        pImpl.reset(new Impl(MsgSock{sock}, resumeToken));
+    }
+}
+
+Peer::Peer(
+        TcpSock&       sock,
+        const uint64_t resumeToken)
+    : pImpl{ImplPool::get()}
+{
+    if (pImpl) {
+        pImpl->rebind(MsgSock{sock}, resumeToken);
+    }
+    else {
+        pImpl.reset(new Impl(MsgSock{sock}, resumeToken));
+    }
+}
 
-Peer::Peer(const InetSockAddr& peerAddr)
-    : pImpl{new Impl(peerAddr)}
+Peer::Peer(
+        const InetSockAddr& peerAddr,
+        const uint64_t      resumeToken)
+    : Peer{peerAddr, Transport::SCTP, resumeToken}
 {}
 
+Peer::Peer(
+        const InetSockAddr& peerAddr,
+        const Transport     transport,
+        const uint64_t      resumeToken)
+    : pImpl{ImplPool::get()}
+{
+    if (pImpl) {
+        pImpl->rebind((transport == Transport::TCP)
+                ? MsgSock{TcpSock{Impl::getNumStreams()}.connect(peerAddr)}
+                : MsgSock{SctpSock{Impl::getNumStreams()}.connect(peerAddr)},
+                resumeToken);
+    }
+    else {
+        pImpl.reset(new Impl(peerAddr, transport, resumeToken));
+    }
+}
+
+void Peer::recycle()
+{
+    if (pImpl.use_count() > 1)
+        return; // Another copy still references the implementation
+    pImpl->retire();
+    ImplPool::put(pImpl);
+    pImpl.reset(new Impl());
+}
+
+int Peer::getSock() const noexcept
+{
+    return pImpl->getSock();
+}
+
+SctpSock::Status Peer::getTransportStatus() const
+{
+    return pImpl->getTransportStatus();
+}
+
+bool Peer::receive(PeerServer& peerServer) const
+{
+    return pImpl->receive(peerServer);
+}
+
+bool Peer::hasInput() const noexcept
+{
+    return pImpl->hasInput();
+}
+
 void Peer::runReceiver(PeerServer& peerServer) const
 {
     pImpl->runReceiver(peerServer);
 }
 
-void Peer::requestBacklog(const ChunkId& chunkId) const
+void Peer::requestBacklog(
+        const ChunkId&     chunkId,
+        const BacklogOrder order) const
 {
-    pImpl->requestBacklog(chunkId);
+    pImpl->requestBacklog(chunkId, order);
 }
 
 void Peer::notify(const ProdIndex& prodIndex) const
@@ -475,11 +2160,119 @@ void Peer::notify(const ProdIndex& prodIndex) const
     pImpl->notify(prodIndex);
 }
 
+void Peer::notify(
+        const ProdIndex&   prodIndex,
+        const NoticeCache& cache) const
+{
+    pImpl->notify(prodIndex, cache);
+}
+
+void Peer::notify(
+        const ProdIndex&   prodIndex,
+        const std::string& prodName) const
+{
+    pImpl->notify(prodIndex, prodName);
+}
+
+void Peer::notify(
+        const ProdIndex&   prodIndex,
+        const std::string& prodName,
+        const NoticeCache& cache) const
+{
+    pImpl->notify(prodIndex, prodName, cache);
+}
+
 void Peer::notify(const ChunkId& chunkId) const
 {
     pImpl->notify(chunkId);
 }
 
+void Peer::notify(
+        const ChunkId&     chunkId,
+        const NoticeCache& cache) const
+{
+    pImpl->notify(chunkId, cache);
+}
+
+void Peer::notify(const ChunkRange& chunkRange) const
+{
+    pImpl->notify(chunkRange);
+}
+
+void Peer::notify(
+        const ChunkRange&  chunkRange,
+        const NoticeCache& cache) const
+{
+    pImpl->notify(chunkRange, cache);
+}
+
+void Peer::notify(const ChunkRangeSet& rangeSet) const
+{
+    pImpl->notify(rangeSet);
+}
+
+void Peer::notify(
+        const ChunkRangeSet& rangeSet,
+        const NoticeCache&   cache) const
+{
+    pImpl->notify(rangeSet, cache);
+}
+
+void Peer::request(const ChunkId& chunkId) const
+{
+    pImpl->request(chunkId);
+}
+
+void Peer::request(const ChunkRangeSet& rangeSet) const
+{
+    pImpl->request(rangeSet);
+}
+
+void Peer::cancel(const ChunkId& chunkId) const
+{
+    pImpl->cancel(chunkId);
+}
+
+void Peer::send(const ActualChunk& chunk) const
+{
+    pImpl->send(chunk);
+}
+
+void Peer::gossip(const PeerGossip& gossip) const
+{
+    pImpl->gossip(gossip);
+}
+
+void Peer::setFilter(const ProdFilter& filter) const
+{
+    pImpl->setFilter(filter);
+}
+
+void Peer::sendHeartbeat() const
+{
+    pImpl->sendHeartbeat();
+}
+
+void Peer::advertiseRetention(const RetentionMsg& retention) const
+{
+    pImpl->advertiseRetention(retention);
+}
+
+bool Peer::mayHave(const ProdIndex& prodIndex) const noexcept
+{
+    return pImpl->mayHave(prodIndex);
+}
+
+bool Peer::heartbeatsNegotiated() const noexcept
+{
+    return pImpl->heartbeatsNegotiated();
+}
+
+std::chrono::milliseconds Peer::getRecvSilence() const noexcept
+{
+    return pImpl->getRecvSilence();
+}
+
 bool Peer::operator ==(const Peer& that) const noexcept
 {
     return *pImpl.get() == *that.pImpl.get();
@@ -520,4 +2313,19 @@ Peer::ChunkIdSet Peer::getOutstandingChunks() const
     return pImpl->getOutstandingChunks();
 }
 
+uint64_t Peer::getSessionToken() const noexcept
+{
+    return pImpl->getSessionToken();
+}
+
+uint64_t Peer::getRemoteSessionToken() const noexcept
+{
+    return pImpl->getRemoteSessionToken();
+}
+
+uint64_t Peer::getResumeToken() const noexcept
+{
+    return pImpl->getResumeToken();
+}
+
 } // namespace
@@ -13,12 +13,18 @@
 #define PEER_H_
 
 #include "Chunk.h"
+#include "NoticeCache.h"
 #include "Notifier.h"
 #include "PeerServer.h"
+#include "ProdFilter.h"
 #include "ProdInfo.h"
+#include "RetentionMsg.h"
 #include "SctpSock.h"
+#include "TcpSock.h"
 
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <set>
 
@@ -26,13 +32,25 @@ namespace hycast {
 
 class Peer final : public Notifier
 {
-    class                 Impl;  // Forward declaration
-    std::shared_ptr<Impl> pImpl; // `pImpl` idiom
+    class                 Impl;     // Forward declaration
+    class                 ImplPool; // Pool of warm, disconnected `Impl`-s
+    std::shared_ptr<Impl> pImpl;    // `pImpl` idiom
 
 public:
     /// Type of container returned by `getOutstandingChunks()`
     typedef std::set<ChunkId> ChunkIdSet;
 
+    /**
+     * Transport over which the connection with the remote peer is made.
+     * SCTP delivers the logical streams independently; TCP shares one
+     * ordered byte-stream among them but rides the NIC's segmentation-
+     * offload paths and traverses middleboxes that block SCTP.
+     */
+    enum class Transport {
+        SCTP,
+        TCP
+    };
+
     /**
      * Constructs from nothing. Any attempt to use the resulting instance will
      * throw an exception.
@@ -43,21 +61,59 @@ public:
      * Constructs a server-side instance. Blocks until connected and versions
      * exchanged. This is a cancellation point.
      * @param[in] sock          Socket (as from `accept()`)
+     * @param[in] resumeToken   Session token issued by the remote peer on a
+     *                          prior association to present for resumption
+     *                          or 0 for none
+     * @throw     LogicError    Unknown protocol version from remote peer
+     * @throw     RuntimeError  Couldn't construct peer
+     * @throw     SystemError   Connection failure
+     */
+    Peer(   SctpSock&      sock,
+            const uint64_t resumeToken = 0);
+
+    /**
+     * Constructs a server-side instance from a framed TCP connection. Blocks
+     * until connected and versions exchanged. This is a cancellation point.
+     * @param[in] sock          Socket (as from `SrvrTcpSock::accept()`)
+     * @param[in] resumeToken   Session token issued by the remote peer on a
+     *                          prior association to present for resumption
+     *                          or 0 for none
      * @throw     LogicError    Unknown protocol version from remote peer
      * @throw     RuntimeError  Couldn't construct peer
      * @throw     SystemError   Connection failure
      */
-    Peer(SctpSock&  sock);
+    Peer(   TcpSock&       sock,
+            const uint64_t resumeToken = 0);
 
     /**
-     * Constructs a client-side instance. Blocks until connected and versions
-     * exchanged.
+     * Constructs a client-side instance over SCTP. Blocks until connected and
+     * versions exchanged.
      * @param[in] peerAddr      Socket address of remote peer-server
+     * @param[in] resumeToken   Session token issued by the remote peer on a
+     *                          prior association to present for resumption
+     *                          or 0 for none
      * @throw     LogicError    Unknown protocol version from remote peer
      * @throw     RuntimeError  Couldn't construct peer
      * @throw     SystemError   Connection failure
      */
-    Peer(const InetSockAddr& peerAddr);
+    Peer(   const InetSockAddr& peerAddr,
+            const uint64_t      resumeToken = 0);
+
+    /**
+     * Constructs a client-side instance over the given transport. Blocks
+     * until connected and versions exchanged.
+     * @param[in] peerAddr      Socket address of remote peer-server
+     * @param[in] transport     Transport over which to connect
+     * @param[in] resumeToken   Session token issued by the remote peer on a
+     *                          prior association to present for resumption
+     *                          or 0 for none
+     * @throw     LogicError    Unknown protocol version from remote peer
+     * @throw     RuntimeError  Couldn't construct peer
+     * @throw     SystemError   Connection failure
+     */
+    Peer(   const InetSockAddr& peerAddr,
+            const Transport     transport,
+            const uint64_t      resumeToken = 0);
 
     /**
      * Returns the Internet socket address of the remote peer.
@@ -96,6 +152,47 @@ public:
      */
     bool operator!=(const Peer& that) const noexcept;
 
+    /**
+     * Returns the socket descriptor of the connection. Intended for use by an
+     * event loop that waits for input from many peers at once.
+     * @return Socket descriptor of the connection
+     */
+    int getSock() const noexcept;
+
+    /**
+     * Returns a snapshot of the kernel's transport metrics for the
+     * association with the remote peer (e.g., smoothed round-trip time and
+     * congestion window), so peer scoring and request scheduling can react
+     * to transport congestion ahead of application-level symptoms.
+     * @return             Transport metrics of the association
+     * @throw SystemError  Metrics couldn't be obtained
+     */
+    SctpSock::Status getTransportStatus() const;
+
+    /**
+     * Receives a single message from the remote peer and processes it by
+     * calling a higher-level component. Blocks until a message arrives unless
+     * input is already available (e.g., the socket was reported ready by an
+     * event loop).
+     * @param[in] peerServer  Higher-level component
+     * @retval `true`         A message was processed
+     * @retval `false`        The connection was closed by the remote peer
+     */
+    bool receive(PeerServer& peerServer) const;
+
+    /**
+     * Indicates if the connection has input that can be received without
+     * waiting for network activity: a message already peeked from the socket
+     * or unread bytes in the kernel's receive buffer. Intended for an
+     * event-loop handler that drains buffered messages before returning to
+     * the multiplexer.
+     * @retval `true`    Input is available
+     * @retval `false`   No input is available
+     * @exceptionsafety  Nothrow
+     * @threadsafety     Safe
+     */
+    bool hasInput() const noexcept;
+
     /**
      * Receives messages from the socket and calls a higher-level component.
      * Doesn't return until the connection is closed. Intended to run on its own
@@ -107,8 +204,13 @@ public:
     /**
      * Requests the backlog of data-chunks from the remote peer.
      * @param[in] chunkId  Identifier of earliest data-chunk in backlog
+     * @param[in] order    Order in which the backlog should be served. The
+     *                     default preserves the historical oldest-first
+     *                     behavior.
      */
-    void requestBacklog(const ChunkId& chunkId) const;
+    void requestBacklog(
+            const ChunkId&     chunkId,
+            const BacklogOrder order = BacklogOrder::OLDEST_FIRST) const;
 
     /**
      * Notifies the remote peer about available product information.
@@ -119,6 +221,59 @@ public:
      */
     void notify(const ProdIndex& prodIndex) const;
 
+    /**
+     * Notifies the remote peer about available product information using a
+     * fan-out cache of the notice's serialized form: a notice fanned out to
+     * many peers is serialized once per wire-encoding instead of once per
+     * peer, and each peer's channel writes the shared bytes directly.
+     * @param[in] prodIndex       Product index
+     * @param[in] cache           Cache of the notice's serialized form,
+     *                            shared by the fan-out
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void notify(
+            const ProdIndex&   prodIndex,
+            const NoticeCache& cache) const;
+
+    /**
+     * Notifies the remote peer about available product information,
+     * identifying the product by name. If the remote peer advertised a
+     * product filter that excludes the name, then no notice is sent and
+     * subsequent chunk notices for the product are suppressed as well.
+     * @param[in] prodIndex       Product index
+     * @param[in] prodName        Name of the product or the empty string if
+     *                            unknown, in which case the notice is always
+     *                            sent
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void notify(
+            const ProdIndex&   prodIndex,
+            const std::string& prodName) const;
+
+    /**
+     * Notifies the remote peer about available product information,
+     * identifying the product by name, using a fan-out cache of the notice's
+     * serialized form. The remote peer's product filter is applied as usual:
+     * only the serialization is shared.
+     * @param[in] prodIndex       Product index
+     * @param[in] prodName        Name of the product or the empty string if
+     *                            unknown, in which case the notice is always
+     *                            sent
+     * @param[in] cache           Cache of the notice's serialized form,
+     *                            shared by the fan-out
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void notify(
+            const ProdIndex&   prodIndex,
+            const std::string& prodName,
+            const NoticeCache& cache) const;
+
     /**
      * Notifies the remote peer about an available chunk-of-data.
      * @param[in] chunkId         Relevant chunk index
@@ -128,6 +283,188 @@ public:
      */
     void notify(const ChunkId& chunkId) const;
 
+    /**
+     * Notifies the remote peer about an available chunk-of-data using a
+     * fan-out cache of the notice's serialized form.
+     * @param[in] chunkId         Relevant chunk index
+     * @param[in] cache           Cache of the notice's serialized form,
+     *                            shared by the fan-out
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void notify(
+            const ChunkId&     chunkId,
+            const NoticeCache& cache) const;
+
+    /**
+     * Notifies the remote peer about a contiguous range of available
+     * chunks-of-data. One coalesced notice is sent instead of a notice per
+     * chunk.
+     * @param[in] chunkRange      Relevant range of chunk identifiers
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void notify(const ChunkRange& chunkRange) const;
+
+    /**
+     * Notifies the remote peer about a contiguous range of available
+     * chunks-of-data using a fan-out cache of the notice's serialized form.
+     * @param[in] chunkRange      Relevant range of chunk identifiers
+     * @param[in] cache           Cache of the notice's serialized form,
+     *                            shared by the fan-out
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void notify(
+            const ChunkRange&  chunkRange,
+            const NoticeCache& cache) const;
+
+    /**
+     * Notifies the remote peer about a set of available chunks-of-data
+     * encoded as contiguous ranges. One coalesced notice is sent instead of a
+     * notice per chunk or per range.
+     * @param[in] rangeSet        Relevant set of chunk-ranges
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void notify(const ChunkRangeSet& rangeSet) const;
+
+    /**
+     * Notifies the remote peer about a set of available chunks-of-data
+     * encoded as contiguous ranges, using a fan-out cache of the notice's
+     * serialized form. If the remote peer's product filter excludes some of
+     * the set's products, its notice differs from the shared one and is
+     * serialized individually.
+     * @param[in] rangeSet        Relevant set of chunk-ranges
+     * @param[in] cache           Cache of the notice's serialized form,
+     *                            shared by the fan-out
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void notify(
+            const ChunkRangeSet& rangeSet,
+            const NoticeCache&   cache) const;
+
+    /**
+     * Requests a chunk-of-data from the remote peer.
+     * @param[in] chunkId         Data-chunk identifier
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void request(const ChunkId& chunkId) const;
+
+    /**
+     * Requests a set of chunks-of-data, encoded as contiguous ranges, from
+     * the remote peer. One vectored request message is sent instead of a
+     * request per chunk.
+     * @param[in] rangeSet        Set of chunk-ranges to request
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void request(const ChunkRangeSet& rangeSet) const;
+
+    /**
+     * Cancels a previous request for a chunk-of-data -- e.g., because the
+     * chunk arrived via multicast. Best-effort: the cancellation can overtake
+     * the request it cancels because SCTP streams are ordered independently,
+     * and the remote peer ignores a cancellation for an unknown chunk.
+     * @param[in] chunkId         Data-chunk identifier
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void cancel(const ChunkId& chunkId) const;
+
+    /**
+     * Sends a chunk of data to the remote peer.
+     * @param[in] chunk           Chunk of data
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void send(const ActualChunk& chunk) const;
+
+    /**
+     * Sends a gossip message to the remote peer.
+     * @param[in] gossip          Gossip message
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void gossip(const PeerGossip& gossip) const;
+
+    /**
+     * Sends this instance's product filter to the remote peer, which then
+     * stops sending notices -- including backlog notices -- for products
+     * whose names the filter excludes. An empty filter re-enables all
+     * notices.
+     * @param[in] filter          Product filter
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void setFilter(const ProdFilter& filter) const;
+
+    /**
+     * Sends a liveness heartbeat to the remote peer: proof, on an otherwise
+     * idle association, that this process is still alive. Does nothing if
+     * both peers didn't advertise heartbeats in the version exchange.
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void sendHeartbeat() const;
+
+    /**
+     * Advertises this peer's retention range to the remote peer, which then
+     * stops assigning this peer chunk-requests for products older than the
+     * advertised oldest resident product. Does nothing if both peers didn't
+     * advertise retention advertisements in the version exchange.
+     * @param[in] retention       Retention advertisement
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void advertiseRetention(const RetentionMsg& retention) const;
+
+    /**
+     * Indicates if the remote peer's store might still hold a given product,
+     * according to its most recent retention advertisement. A peer that
+     * hasn't advertised is assumed to hold everything.
+     * @param[in] prodIndex  Index of the product in question
+     * @retval `true`        The remote peer might hold the product
+     * @retval `false`       The remote peer evicted the product
+     * @exceptionsafety      Nothrow
+     * @threadsafety         Safe
+     */
+    bool mayHave(const ProdIndex& prodIndex) const noexcept;
+
+    /**
+     * Indicates if liveness heartbeats were negotiated on this association,
+     * in which case the remote peer sends them when idle and prolonged
+     * silence from it implies its death.
+     * @retval `true`    Iff heartbeats were negotiated
+     * @exceptionsafety  Nothrow
+     * @threadsafety     Safe
+     */
+    bool heartbeatsNegotiated() const noexcept;
+
+    /**
+     * Returns the time since a message -- any message, heartbeats included --
+     * was last received from the remote peer.
+     * @return           Duration of the current receive-side silence
+     * @exceptionsafety  Nothrow
+     * @threadsafety     Safe
+     */
+    std::chrono::milliseconds getRecvSilence() const noexcept;
+
     /**
      * Returns the number of streams.
      */
@@ -147,6 +484,49 @@ public:
      * @return Copy of set of outstanding data-chunks
      */
     ChunkIdSet getOutstandingChunks() const;
+
+    /**
+     * Offers this peer's implementation to the pool of warm, disconnected
+     * implementations from which the constructors draw, provided no other
+     * copy of this peer references it. The connection is closed and this
+     * instance is left in the default-constructed state. A reconnect storm
+     * then reuses the torn-down implementations -- their containers keep
+     * their allocations -- instead of constructing each peer from scratch.
+     * @pre              The peer's receiving and sending threads have
+     *                   completed
+     * @exceptionsafety  Basic guarantee
+     * @threadsafety     Compatible but not safe
+     */
+    void recycle();
+
+    /**
+     * Returns the session token this peer issued for the association. The
+     * remote peer presents the token on a reconnection, so it keys the
+     * session state saved when this association ends.
+     * @return Issued session token
+     * @exceptionsafety Nothrow
+     * @threadsafety    Safe
+     */
+    uint64_t getSessionToken() const noexcept;
+
+    /**
+     * Returns the session token the remote peer issued for the association.
+     * Presenting it on the next connection to the same remote peer resumes
+     * this association's session state there.
+     * @return Remotely-issued session token
+     * @exceptionsafety Nothrow
+     * @threadsafety    Safe
+     */
+    uint64_t getRemoteSessionToken() const noexcept;
+
+    /**
+     * Returns the session token the remote peer presented for resumption of
+     * a prior association's session state.
+     * @return Presented resumption token or 0 for none
+     * @exceptionsafety Nothrow
+     * @threadsafety    Safe
+     */
+    uint64_t getResumeToken() const noexcept;
 };
 
 } // namespace
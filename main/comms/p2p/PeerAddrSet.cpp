@@ -14,13 +14,17 @@
 #include "PeerAddrSet.h"
 
 #include <chrono>
-#include <set>
+#include <map>
 
 namespace hycast {
 
 class PeerAddrSet::Impl final
 {
-    std::set<InetSockAddr> peerAddrs;
+    /// Smallest usable quality-weight. Keeps a zero-scored peer selectable.
+    static constexpr double minWeight = 1e-3;
+
+    /// Peer-addresses and their quality-weights
+    std::map<InetSockAddr, double> peerAddrs;
 
 public:
     Impl()
@@ -33,31 +37,77 @@ public:
     }
 
     void add(const InetSockAddr& peerAddr) {
-        peerAddrs.insert(peerAddr);
+        // Doesn't overwrite a previously-learned weight
+        peerAddrs.emplace(peerAddr, 1.0);
+    }
+
+    void add(
+            const InetSockAddr& peerAddr,
+            const double        weight) {
+        peerAddrs[peerAddr] = (weight < minWeight) ? minWeight : weight;
     }
 
     void remove(const InetSockAddr& peerAddr) {
         peerAddrs.erase(peerAddr);
     }
 
+    bool contains(const InetSockAddr& peerAddr) const {
+        return peerAddrs.find(peerAddr) != peerAddrs.end();
+    }
+
     bool getRandom(
             InetSockAddr&               peerAddr,
             std::default_random_engine& generator) const
     {
-        auto distrib = std::uniform_int_distribution<int>{0,
-                static_cast<int>(peerAddrs.size())-1};
-        auto targetIndex = distrib(generator);
-        auto index = 0;
-        for (const InetSockAddr& addr : peerAddrs) {
-            if (index++ == targetIndex) {
-                peerAddr = addr;
-                return true;
+        if (peerAddrs.empty())
+            return false;
+        /*
+         * Two-stage, subnet-diverse draw. A subnet is selected with
+         * probability proportional to its best member's weight -- so many
+         * peers behind one congested path count for no more than one -- and
+         * then a member of that subnet is selected with probability
+         * proportional to its own weight.
+         */
+        std::map<size_t, double> subnetWeights;
+        for (const auto& elt : peerAddrs) {
+            const auto subnet = elt.first.getInetAddr().getSubnetId();
+            auto       pair = subnetWeights.emplace(subnet, elt.second);
+            if (!pair.second && elt.second > pair.first->second)
+                pair.first->second = elt.second;
+        }
+        double total = 0;
+        for (const auto& elt : subnetWeights)
+            total += elt.second;
+        auto   distrib = std::uniform_real_distribution<double>{0, total};
+        double target = distrib(generator);
+        size_t subnet = subnetWeights.rbegin()->first;
+        for (const auto& elt : subnetWeights) {
+            target -= elt.second;
+            if (target <= 0) {
+                subnet = elt.first;
+                break;
             }
         }
-        return false;
+        total = 0;
+        for (const auto& elt : peerAddrs)
+            if (elt.first.getInetAddr().getSubnetId() == subnet)
+                total += elt.second;
+        distrib = std::uniform_real_distribution<double>{0, total};
+        target = distrib(generator);
+        for (const auto& elt : peerAddrs) {
+            if (elt.first.getInetAddr().getSubnetId() != subnet)
+                continue;
+            peerAddr = elt.first;
+            target -= elt.second;
+            if (target <= 0)
+                break;
+        }
+        return true;
     }
 };
 
+constexpr double PeerAddrSet::Impl::minWeight;
+
 PeerAddrSet::PeerAddrSet()
     : pImpl{new Impl()}
 {}
@@ -72,11 +122,23 @@ void PeerAddrSet::add(const InetSockAddr& peerAddr)
     pImpl->add(peerAddr);
 }
 
+void PeerAddrSet::add(
+        const InetSockAddr& peerAddr,
+        const double        weight)
+{
+    pImpl->add(peerAddr, weight);
+}
+
 void PeerAddrSet::remove(const InetSockAddr& peerAddr)
 {
     pImpl->remove(peerAddr);
 }
 
+bool PeerAddrSet::contains(const InetSockAddr& peerAddr) const
+{
+    return pImpl->contains(peerAddr);
+}
+
 bool PeerAddrSet::getRandom(
         InetSockAddr&               peerAddr,
         std::default_random_engine& generator) const
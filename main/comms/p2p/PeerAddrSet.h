@@ -48,6 +48,20 @@ public:
      */
     void add(const InetSockAddr& peerAddr);
 
+    /**
+     * Adds a peer-address together with a quality-weight (e.g., the peer's
+     * score from the gossip quality database). A higher weight makes the
+     * peer more likely to be selected. Overwrites any previous weight.
+     * @param[in] peerAddr  Peer-address to be added
+     * @param[in] weight    Quality-weight of the peer. Higher is better.
+     *                      Clamped below at a small positive value.
+     * @exceptionsafety     Strong guarantee
+     * @threadsafety        Compatible but not safe
+     */
+    void add(
+            const InetSockAddr& peerAddr,
+            double              weight);
+
     /**
      * Removes a peer-address.
      * @param[in] peerAddr  Peer-address to be removed
@@ -57,7 +71,22 @@ public:
     void remove(const InetSockAddr& peerAddr);
 
     /**
-     * Returns a peer-address chosen at random.
+     * Indicates if a peer-address is a member.
+     * @param[in] peerAddr  Peer-address in question
+     * @retval `true`       The peer-address is a member
+     * @retval `false`      The peer-address is not a member
+     * @exceptionsafety     Strong guarantee
+     * @threadsafety        Compatible but not safe
+     */
+    bool contains(const InetSockAddr& peerAddr) const;
+
+    /**
+     * Returns a peer-address chosen at random with a subnet-diverse,
+     * quality-weighted draw: a subnet is selected with probability
+     * proportional to its best member's weight -- so several peers behind
+     * the same network path count for no more than one -- and then a member
+     * of that subnet is selected with probability proportional to its own
+     * weight.
      * @param[out] peerAddr  Pseudo-randomly-chosen peer-address. Set if the set
      *                       isn't empty.
      * @generator            Pseudo-random number generator
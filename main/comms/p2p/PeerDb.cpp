@@ -0,0 +1,271 @@
+/**
+ * This file implements a persistent database of remote peers ranked by their
+ * historical performance, together with a source of potential peers that's
+ * backed by such a database.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: PeerDb.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "error.h"
+#include "PeerDb.h"
+#include "PortNumber.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <unistd.h>
+
+namespace hycast {
+
+class PeerDb::Impl final
+{
+    typedef std::mutex             Mutex;
+    typedef std::lock_guard<Mutex> LockGuard;
+
+    /// What's known about a peer
+    struct Entry
+    {
+        double score;    ///< Exponentially-weighted moving average of scores
+        time_t lastSeen; ///< When the peer was last observed, in epoch seconds
+    };
+
+    /// Weight of a new observation in the moving average
+    static constexpr double alpha = 0.25;
+    /// Maximum number of peers retained in the database
+    static const size_t     maxSize = 1000;
+
+    mutable Mutex                     mutex;
+    const std::string                 pathname;
+    std::map<std::string, Entry>      entries; ///< Keyed by `to_string()`
+
+    /**
+     * Removes the oldest-seen peer if the database is over-full.
+     * @pre `mutex` is locked
+     */
+    void pruneIfNeeded()
+    {
+        if (entries.size() <= maxSize)
+            return;
+        auto oldest = entries.begin();
+        for (auto iter = entries.begin(); iter != entries.end(); ++iter)
+            if (iter->second.lastSeen < oldest->second.lastSeen)
+                oldest = iter;
+        entries.erase(oldest);
+    }
+
+    /**
+     * Loads the database from its file. Does nothing if the file doesn't
+     * exist.
+     * @throw RuntimeError  The file is corrupt
+     */
+    void load()
+    {
+        std::ifstream input{pathname};
+        if (!input)
+            return; // No database file yet
+        std::string line;
+        unsigned    lineNo = 0;
+        while (std::getline(input, line)) {
+            ++lineNo;
+            if (line.empty())
+                continue;
+            std::istringstream parser{line};
+            std::string        addrSpec;
+            Entry              entry;
+            if (!(parser >> addrSpec >> entry.score >> entry.lastSeen))
+                throw RUNTIME_ERROR("Corrupt line " + std::to_string(lineNo) +
+                        " in peer database \"" + pathname + "\"");
+            entries[addrSpec] = entry;
+        }
+    }
+
+    /**
+     * Parses the key of an entry into an Internet socket address.
+     * Keep consistent with `InetSockAddr::to_string()` (e.g.,
+     * "192.168.0.1:38800" or "[::1]:38800").
+     * @param[in] key  Key of the entry
+     * @return         Corresponding Internet socket address
+     */
+    static InetSockAddr getSockAddr(const std::string& key)
+    {
+        const auto colon = key.rfind(':');
+        if (colon == std::string::npos)
+            throw RUNTIME_ERROR("Invalid peer-database key \"" + key + "\"");
+        const auto port = std::stoul(key.substr(colon+1));
+        auto       addrSpec = key.substr(0, colon);
+        if (addrSpec.size() >= 2 && addrSpec.front() == '[' &&
+                addrSpec.back() == ']')
+            addrSpec = addrSpec.substr(1, addrSpec.size()-2);
+        return InetSockAddr{addrSpec,
+                PortNumber{static_cast<in_port_t>(port)}};
+    }
+
+public:
+    explicit Impl(const std::string& pathname)
+        : mutex{}
+        , pathname{pathname}
+        , entries{}
+    {
+        load();
+    }
+
+    ~Impl()
+    {
+        try {
+            save();
+        }
+        catch (const std::exception& e) {
+            log_error(e); // Because a destructor shouldn't throw an exception
+        }
+    }
+
+    void observe(
+            const InetSockAddr& peerAddr,
+            const double        score)
+    {
+        LockGuard  lock{mutex};
+        const auto key = peerAddr.to_string();
+        auto       iter = entries.find(key);
+        if (iter == entries.end()) {
+            Entry entry;
+            entry.score = score;
+            entry.lastSeen = ::time(nullptr);
+            entries[key] = entry;
+            pruneIfNeeded();
+        }
+        else {
+            auto& entry = iter->second;
+            entry.score += alpha*(score - entry.score);
+            entry.lastSeen = ::time(nullptr);
+        }
+    }
+
+    std::vector<std::pair<InetSockAddr, double>> getRanked(
+            const size_t n) const
+    {
+        std::vector<std::pair<std::string, double>> scored;
+        {
+            LockGuard lock{mutex};
+            scored.reserve(entries.size());
+            for (const auto& elt : entries)
+                scored.push_back({elt.first, elt.second.score});
+        }
+        std::sort(scored.begin(), scored.end(),
+                [](const std::pair<std::string, double>& entry1,
+                   const std::pair<std::string, double>& entry2) {
+                    return entry1.second > entry2.second;
+                });
+        if (scored.size() > n)
+            scored.resize(n);
+        std::vector<std::pair<InetSockAddr, double>> best;
+        best.reserve(scored.size());
+        for (const auto& elt : scored) {
+            try {
+                best.push_back({getSockAddr(elt.first), elt.second});
+            }
+            catch (const std::exception& e) {
+                log_warn(e); // E.g., hostname no longer resolves
+            }
+        }
+        return best;
+    }
+
+    size_t size() const noexcept
+    {
+        LockGuard lock{mutex};
+        return entries.size();
+    }
+
+    void save() const
+    {
+        LockGuard  lock{mutex};
+        // Written to a temporary file then renamed so a crash can't leave a
+        // partially-written database
+        const auto tmpPathname = pathname + ".tmp";
+        {
+            std::ofstream output{tmpPathname, std::ofstream::trunc};
+            if (!output)
+                throw SYSTEM_ERROR("Couldn't open temporary peer database \"" +
+                        tmpPathname + "\"");
+            for (const auto& elt : entries)
+                output << elt.first << ' ' << elt.second.score << ' ' <<
+                        elt.second.lastSeen << '\n';
+            if (!output.flush())
+                throw SYSTEM_ERROR("Couldn't write temporary peer database \"" +
+                        tmpPathname + "\"");
+        }
+        if (::rename(tmpPathname.c_str(), pathname.c_str())) {
+            ::unlink(tmpPathname.c_str());
+            throw SYSTEM_ERROR("Couldn't rename temporary peer database \"" +
+                    tmpPathname + "\" to \"" + pathname + "\"");
+        }
+    }
+};
+
+PeerDb::PeerDb(const std::string& pathname)
+    : pImpl{new Impl(pathname)}
+{}
+
+void PeerDb::observe(
+        const InetSockAddr& peerAddr,
+        const double        score)
+{
+    pImpl->observe(peerAddr, score);
+}
+
+std::vector<std::pair<InetSockAddr, double>> PeerDb::getRanked(
+        const size_t n) const
+{
+    return pImpl->getRanked(n);
+}
+
+size_t PeerDb::size() const noexcept
+{
+    return pImpl->size();
+}
+
+void PeerDb::save() const
+{
+    pImpl->save();
+}
+
+PeerDbSource::PeerDbSource(const std::string& pathname)
+    : PeerSource{}
+    , peerDb{pathname}
+{
+    for (const auto& elt : peerDb.getRanked(SIZE_MAX))
+        push(elt.first);
+}
+
+void PeerDbSource::learn(
+        const InetSockAddr& peerAddr,
+        const double        score,
+        const unsigned      delay)
+{
+    peerDb.observe(peerAddr, score);
+    push(peerAddr, delay);
+}
+
+std::vector<std::pair<InetSockAddr, double>> PeerDbSource::getBest(
+        const size_t n) const
+{
+    return peerDb.getRanked(n);
+}
+
+PeerDb PeerDbSource::getPeerDb() const
+{
+    return peerDb;
+}
+
+} // namespace
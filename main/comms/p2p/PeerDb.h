@@ -0,0 +1,134 @@
+/**
+ * This file declares a persistent database of remote peers ranked by their
+ * historical performance, together with a source of potential peers that's
+ * backed by such a database.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: PeerDb.h
+ * @author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_COMMS_P2P_PEERDB_H_
+#define MAIN_COMMS_P2P_PEERDB_H_
+
+#include "InetSockAddr.h"
+#include "PeerSource.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace hycast {
+
+class PeerDb final
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Constructs. Loads the database from its file if the file exists;
+     * otherwise, starts with an empty database.
+     * @param[in] pathname      Pathname of the database file
+     * @throw     SystemError   The file exists but couldn't be read
+     * @throw     RuntimeError  The file is corrupt
+     */
+    explicit PeerDb(const std::string& pathname);
+
+    /**
+     * Accepts an observation of a peer's performance. The peer's score becomes
+     * an exponentially-weighted moving average of the observations, so recent
+     * behavior dominates old behavior.
+     * @param[in] peerAddr  Internet socket address of the peer's server
+     * @param[in] score     Observed performance score. Higher is better.
+     * @exceptionsafety     Strong guarantee
+     * @threadsafety        Safe
+     */
+    void observe(
+            const InetSockAddr& peerAddr,
+            const double        score);
+
+    /**
+     * Returns the highest-scored peers.
+     * @param[in] n      Maximum number of peers to return
+     * @return           Peer addresses and their scores, best first
+     * @exceptionsafety  Strong guarantee
+     * @threadsafety     Safe
+     */
+    std::vector<std::pair<InetSockAddr, double>> getRanked(
+            const size_t n) const;
+
+    /**
+     * Returns the number of peers in the database.
+     * @return Number of peers
+     */
+    size_t size() const noexcept;
+
+    /**
+     * Writes the database to its file. Also called by the destructor, so an
+     * explicit call is only necessary to bound the loss from a crash.
+     * @throw SystemError  The file couldn't be written
+     * @exceptionsafety    Basic guarantee
+     * @threadsafety       Safe
+     */
+    void save() const;
+};
+
+/**
+ * A source of potential peers that's backed by a persistent peer database.
+ * Popping yields the historically best-performing peers first; observations
+ * from gossip messages and stopped peers update the database and make the
+ * relevant peers available for (re)connection.
+ */
+class PeerDbSource final : public PeerSource
+{
+    PeerDb peerDb;
+
+public:
+    /**
+     * Constructs. The peers in the database are made available best-first.
+     * @param[in] pathname      Pathname of the database file
+     * @throw     SystemError   The file exists but couldn't be read
+     * @throw     RuntimeError  The file is corrupt
+     */
+    explicit PeerDbSource(const std::string& pathname);
+
+    /**
+     * Accepts an observation of a potential peer's performance. Updates the
+     * database and adds the peer to the set of potential peers.
+     * @param[in] peerAddr  Internet socket address of the peer's server
+     * @param[in] score     Observed performance score. Higher is better.
+     * @param[in] delay     The delay, in seconds, for the potential peer before
+     *                      it becomes available
+     * @exceptionsafety     Strong guarantee
+     * @threadsafety        Safe
+     */
+    void learn(
+            const InetSockAddr& peerAddr,
+            const double        score,
+            const unsigned      delay = 0) override;
+
+    /**
+     * Returns the highest-scored known peers.
+     * @param[in] n      Maximum number of peers to return
+     * @return           Peer addresses and their scores, best first
+     * @exceptionsafety  Strong guarantee
+     * @threadsafety     Safe
+     */
+    std::vector<std::pair<InetSockAddr, double>> getBest(
+            const size_t n) const override;
+
+    /**
+     * Returns the associated database.
+     * @return The associated database
+     */
+    PeerDb getPeerDb() const;
+};
+
+} // namespace
+
+#endif /* MAIN_COMMS_P2P_PEERDB_H_ */
@@ -0,0 +1,118 @@
+/**
+ * This file implements a gossip message exchanged between peers: a small set
+ * of known peer-server addresses together with the sender's observed
+ * performance of each.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: PeerGossip.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "error.h"
+#include "PeerGossip.h"
+#include "PortNumber.h"
+
+namespace hycast {
+
+const size_t PeerGossip::maxEntries;
+const size_t PeerGossip::maxAddrSpecLen;
+
+PeerGossip::PeerGossip()
+    : entries{}
+{}
+
+void PeerGossip::add(
+        const InetSockAddr& peerAddr,
+        const double        score)
+{
+    if (entries.size() >= maxEntries)
+        return;
+    Entry entry;
+    entry.addrSpec = peerAddr.getInetAddr().to_string();
+    if (entry.addrSpec.size() > maxAddrSpecLen)
+        throw INVALID_ARGUMENT("Address specification \"" + entry.addrSpec +
+                "\" is longer than " + std::to_string(maxAddrSpecLen) +
+                " bytes");
+    entry.port = peerAddr.getPort().get_host();
+    entry.milliScore = (score <= 0)
+            ? 0
+            : static_cast<uint32_t>(score*1000);
+    entries.push_back(entry);
+}
+
+size_t PeerGossip::size() const noexcept
+{
+    return entries.size();
+}
+
+InetSockAddr PeerGossip::getPeerAddr(const size_t index) const
+{
+    if (index >= entries.size())
+        throw INVALID_ARGUMENT("Index " + std::to_string(index) +
+                " isn't less than " + std::to_string(entries.size()));
+    const Entry& entry = entries[index];
+    return InetSockAddr{entry.addrSpec, PortNumber{entry.port}};
+}
+
+double PeerGossip::getScore(const size_t index) const
+{
+    if (index >= entries.size())
+        throw INVALID_ARGUMENT("Index " + std::to_string(index) +
+                " isn't less than " + std::to_string(entries.size()));
+    return entries[index].milliScore/1000.0;
+}
+
+size_t PeerGossip::serialize(
+        Encoder&       encoder,
+        const unsigned version) const
+{
+    size_t nbytes = encoder.encode(static_cast<uint16_t>(entries.size()));
+    for (const Entry& entry : entries) {
+        nbytes += encoder.encode(entry.addrSpec);
+        nbytes += encoder.encode(static_cast<uint16_t>(entry.port));
+        nbytes += encoder.encode(entry.milliScore);
+    }
+    return nbytes;
+}
+
+size_t PeerGossip::getSerialSize(unsigned version) const noexcept
+{
+    size_t nbytes = Codec::getSerialSize(sizeof(uint16_t));
+    for (const Entry& entry : entries)
+        nbytes += Codec::getSerialSize(entry.addrSpec) +
+                Codec::getSerialSize(sizeof(uint16_t)) +
+                Codec::getSerialSize(sizeof(uint32_t));
+    return nbytes;
+}
+
+PeerGossip PeerGossip::deserialize(
+        Decoder&        decoder,
+        const unsigned  version)
+{
+    PeerGossip gossip{};
+    uint16_t   numEntries;
+    decoder.decode(numEntries);
+    if (numEntries > maxEntries)
+        throw RUNTIME_ERROR("Gossip message has " +
+                std::to_string(numEntries) + " entries; maximum is " +
+                std::to_string(maxEntries));
+    for (uint16_t i = 0; i < numEntries; ++i) {
+        Entry entry;
+        decoder.decode(entry.addrSpec);
+        if (entry.addrSpec.size() > maxAddrSpecLen)
+            throw RUNTIME_ERROR("Address specification is longer than " +
+                    std::to_string(maxAddrSpecLen) + " bytes");
+        uint16_t port;
+        decoder.decode(port);
+        entry.port = port;
+        decoder.decode(entry.milliScore);
+        gossip.entries.push_back(entry);
+    }
+    return gossip;
+}
+
+} // namespace
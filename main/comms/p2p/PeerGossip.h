@@ -0,0 +1,137 @@
+/**
+ * This file declares a gossip message exchanged between peers: a small set of
+ * known peer-server addresses together with the sender's observed performance
+ * of each. Gossiping lets nodes discover better peers than a static
+ * configuration provides.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: PeerGossip.h
+ * @author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_COMMS_P2P_PEERGOSSIP_H_
+#define MAIN_COMMS_P2P_PEERGOSSIP_H_
+
+#include "InetSockAddr.h"
+#include "Serializable.h"
+
+#include <netinet/in.h>
+#include <string>
+#include <vector>
+
+namespace hycast {
+
+class PeerGossip final : public Serializable<PeerGossip>
+{
+    /// A gossiped peer
+    struct Entry
+    {
+        std::string addrSpec;   ///< Internet address specification
+        in_port_t   port;       ///< Port number in host byte-order
+        uint32_t    milliScore; ///< Observed performance score times 1000
+    };
+
+    std::vector<Entry> entries;
+
+public:
+    /// Maximum number of peers in a message
+    static const size_t maxEntries = 8;
+    /// Maximum length of an Internet address specification in bytes
+    static const size_t maxAddrSpecLen = 64;
+
+    /**
+     * Constructs an empty message.
+     */
+    PeerGossip();
+
+    /**
+     * Adds a peer. Does nothing if the message is full.
+     * @param[in] peerAddr         Internet socket address of the peer-server
+     * @param[in] score            Observed performance score. Negative values
+     *                             are clamped to 0.
+     * @throw     InvalidArgument  Address specification is too long
+     * @exceptionsafety            Strong guarantee
+     * @threadsafety               Compatible but not safe
+     */
+    void add(
+            const InetSockAddr& peerAddr,
+            const double        score);
+
+    /**
+     * Returns the number of peers in this message.
+     * @return Number of peers
+     */
+    size_t size() const noexcept;
+
+    /**
+     * Returns the Internet socket address of a peer.
+     * @param[in] index        Index of the peer
+     * @return                 Internet socket address of the peer
+     * @throw InvalidArgument  `index >= size()`
+     */
+    InetSockAddr getPeerAddr(const size_t index) const;
+
+    /**
+     * Returns the sender's observed performance score of a peer.
+     * @param[in] index        Index of the peer
+     * @return                 Observed performance score
+     * @throw InvalidArgument  `index >= size()`
+     */
+    double getScore(const size_t index) const;
+
+    /**
+     * Serializes this instance to an encoder.
+     * @param[in] encoder  Encoder
+     * @param[in] version  Protocol version
+     * @return Number of bytes written
+     * @exceptionsafety Basic guarantee
+     * @threadsafety    Safe
+     */
+    size_t serialize(
+            Encoder&       encoder,
+            const unsigned version) const;
+
+    /**
+     * Returns the number of bytes in the serial representation of this
+     * instance.
+     * @param[in] version  Protocol version
+     * @return the number of bytes in the serial representation
+     */
+    size_t getSerialSize(unsigned version) const noexcept;
+
+    /**
+     * Returns an upper bound, known at compile time, on the number of bytes
+     * in the serial representation of any instance.
+     * Keep consistent with `getSerialSize()`.
+     * @param[in] version  Protocol version
+     * @return the maximum number of bytes in a serial representation
+     */
+    static constexpr size_t getMaxSerialSize(const unsigned version)
+            noexcept {
+        return Codec::getSerialSize(sizeof(uint16_t)) + // Number of entries
+                maxEntries*(
+                    Codec::getSerialSize(sizeof(uint16_t)) + // Address length
+                    maxAddrSpecLen +                         // Address
+                    Codec::getSerialSize(sizeof(uint16_t)) + // Port number
+                    Codec::getSerialSize(sizeof(uint32_t))); // Score
+    }
+
+    /**
+     * Returns an instance corresponding to the serialized representation in a
+     * decoder.
+     * @param[in] decoder  Decoder
+     * @param[in] version  Protocol version
+     * @exceptionsafety Basic
+     * @threadsafety    Compatible but not thread-safe
+     */
+    static PeerGossip deserialize(
+            Decoder&        decoder,
+            const unsigned  version);
+};
+
+} // namespace
+
+#endif /* MAIN_COMMS_P2P_PEERGOSSIP_H_ */
@@ -0,0 +1,246 @@
+/**
+ * This file implements an epoll(7)-based multiplexer of peer input. A small,
+ * fixed set of event threads waits for input on the sockets of all registered
+ * peers, so a large set of peers doesn't need a receiving thread per peer.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: PeerMux.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "error.h"
+#include "PeerMux.h"
+#include "Thread.h"
+
+#include <condition_variable>
+#include <errno.h>
+#include <mutex>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace hycast {
+
+class PeerMux::Impl final
+{
+    typedef std::mutex              Mutex;
+    typedef std::lock_guard<Mutex>  LockGuard;
+    typedef std::unique_lock<Mutex> UniqueLock;
+
+    /// State of a registered socket
+    struct Entry
+    {
+        Handler handler;
+        /// Whether an event thread is currently executing the handler
+        bool    busy;
+
+        explicit Entry(Handler handler)
+            : handler{handler}
+            , busy{false}
+        {}
+    };
+
+    typedef std::shared_ptr<Entry> EntryPtr;
+
+    mutable Mutex                      mutex;
+    mutable std::condition_variable    cond;
+    std::unordered_map<int, EntryPtr>  entries;
+    int                                epollFd;
+    std::vector<Thread>                eventThreads;
+
+    /**
+     * Re-enables input notification for a socket. The socket is registered
+     * with `EPOLLONESHOT`, so it's disabled after every notification and
+     * its handler is consequently executed by one event thread at a time.
+     * @param[in] sock  Socket descriptor
+     */
+    void rearm(const int sock) noexcept
+    {
+        struct epoll_event event = {};
+        event.events = EPOLLIN | EPOLLONESHOT;
+        event.data.fd = sock;
+        // Failure means the socket was concurrently deregistered
+        ::epoll_ctl(epollFd, EPOLL_CTL_MOD, sock, &event);
+    }
+
+    /**
+     * Waits for input on the registered sockets and executes the relevant
+     * handlers. Doesn't return unless an exception is thrown. Intended to run
+     * on an event thread.
+     */
+    void runEventLoop()
+    {
+        try {
+            for (;;) {
+                struct epoll_event event;
+                int                status;
+                {
+                    Canceler canceler{};
+                    status = ::epoll_wait(epollFd, &event, 1, -1);
+                }
+                if (status < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    throw SYSTEM_ERROR("epoll_wait() failure");
+                }
+                if (status == 0)
+                    continue;
+                const int sock = event.data.fd;
+                EntryPtr  entry{};
+                {
+                    LockGuard lock{mutex};
+                    auto      iter = entries.find(sock);
+                    if (iter == entries.end())
+                        continue; // Concurrently deregistered
+                    entry = iter->second;
+                    entry->busy = true;
+                }
+                const bool keep = entry->handler(); // Mustn't throw
+                {
+                    LockGuard lock{mutex};
+                    entry->busy = false;
+                    if (keep) {
+                        rearm(sock);
+                    }
+                    else {
+                        deregister(sock);
+                    }
+                }
+                cond.notify_all();
+            }
+        }
+        catch (const std::exception& e) {
+            log_error(e); // Because end of thread
+        }
+    }
+
+    /**
+     * Deregisters a socket.
+     * @pre             `mutex` is locked
+     * @param[in] sock  Socket descriptor
+     */
+    void deregister(const int sock) noexcept
+    {
+        // Failure means the socket was already deregistered
+        ::epoll_ctl(epollFd, EPOLL_CTL_DEL, sock, nullptr);
+        entries.erase(sock);
+    }
+
+public:
+    /**
+     * Constructs. Creates the event threads.
+     * @param[in] numThreads    Number of event threads
+     * @throw InvalidArgument   `numThreads == 0`
+     * @throw SystemError       Couldn't create epoll(7) instance
+     */
+    explicit Impl(const unsigned numThreads)
+        : mutex{}
+        , cond{}
+        , entries{}
+        , epollFd{-1}
+        , eventThreads{}
+    {
+        if (numThreads == 0)
+            throw INVALID_ARGUMENT("Number of event threads can't be zero");
+        epollFd = ::epoll_create1(0);
+        if (epollFd < 0)
+            throw SYSTEM_ERROR("Couldn't create epoll(7) instance");
+        try {
+            eventThreads.reserve(numThreads);
+            for (unsigned i = 0; i < numThreads; ++i)
+                eventThreads.emplace_back(Thread{&Impl::runEventLoop, this});
+        }
+        catch (const std::exception& e) {
+            ::close(epollFd);
+            throw;
+        }
+    }
+
+    /**
+     * Destroys. Cancels the event threads and joins them.
+     */
+    ~Impl()
+    {
+        try {
+            for (auto& eventThread : eventThreads) {
+                eventThread.cancel();
+                eventThread.join();
+            }
+        }
+        catch (const std::exception& e) {
+            log_error(e); // Because a destructor shouldn't throw an exception
+        }
+        ::close(epollFd);
+    }
+
+    /// Prevents copy and move construction and assignment
+    Impl(const Impl& that) =delete;
+    Impl(const Impl&& that) =delete;
+    Impl& operator=(const Impl& rhs) =delete;
+    Impl& operator=(const Impl&& rhs) =delete;
+
+    void add(
+            const int sock,
+            Handler   handler)
+    {
+        LockGuard lock{mutex};
+        auto      pair = entries.emplace(sock, EntryPtr{new Entry{handler}});
+        struct epoll_event event = {};
+        event.events = EPOLLIN | EPOLLONESHOT;
+        event.data.fd = sock;
+        if (::epoll_ctl(epollFd, EPOLL_CTL_ADD, sock, &event)) {
+            if (pair.second)
+                entries.erase(sock);
+            throw SYSTEM_ERROR("Couldn't register socket " +
+                    std::to_string(sock) + " with epoll(7) instance");
+        }
+    }
+
+    void remove(const int sock) noexcept
+    {
+        UniqueLock lock{mutex};
+        auto       iter = entries.find(sock);
+        if (iter == entries.end())
+            return;
+        auto entry = iter->second;
+        deregister(sock);
+        // An event thread might still be executing the handler
+        while (entry->busy)
+            cond.wait(lock);
+    }
+};
+
+PeerMux::PeerMux()
+    : pImpl{}
+{}
+
+PeerMux::PeerMux(const unsigned numThreads)
+    : pImpl{new Impl(numThreads)}
+{}
+
+PeerMux::operator bool() const noexcept
+{
+    return pImpl.operator bool();
+}
+
+void PeerMux::add(
+        const int sock,
+        Handler   handler)
+{
+    if (!pImpl)
+        throw LOGIC_ERROR("Multiplexer was default constructed");
+    pImpl->add(sock, handler);
+}
+
+void PeerMux::remove(const int sock) noexcept
+{
+    if (pImpl)
+        pImpl->remove(sock);
+}
+
+} // namespace
@@ -0,0 +1,86 @@
+/**
+ * This file declares an epoll(7)-based multiplexer of peer input. A small,
+ * fixed set of event threads waits for input on the sockets of all registered
+ * peers, so a large set of peers doesn't need a receiving thread per peer.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: PeerMux.h
+ * @author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_COMMS_P2P_PEERMUX_H_
+#define MAIN_COMMS_P2P_PEERMUX_H_
+
+#include <functional>
+#include <memory>
+
+namespace hycast {
+
+class PeerMux final
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Handles available input on a registered socket. Returns `true` if the
+     * socket should remain registered and `false` if it should be removed
+     * (e.g., because the connection was closed). Must not throw: any
+     * exception must be captured and conveyed by other means.
+     */
+    typedef std::function<bool()> Handler;
+
+    /**
+     * Default constructs an inactive instance. Any attempt to register a
+     * socket will throw an exception.
+     */
+    PeerMux();
+
+    /**
+     * Constructs. Creates the event threads.
+     * @param[in] numThreads    Number of event threads. Must be positive.
+     * @throw InvalidArgument   `numThreads == 0`
+     * @throw SystemError       Couldn't create epoll(7) instance
+     */
+    explicit PeerMux(const unsigned numThreads);
+
+    /**
+     * Indicates if this instance is active (i.e., wasn't default
+     * constructed).
+     * @retval `true`   Instance is active
+     * @retval `false`  Instance is not active
+     */
+    operator bool() const noexcept;
+
+    /**
+     * Registers a socket. An event thread will call the handler whenever
+     * input is available. The handler is called by one thread at a time.
+     * @param[in] sock        Socket descriptor
+     * @param[in] handler     Handler of available input
+     * @throw LogicError      Instance was default constructed
+     * @throw SystemError     Couldn't register socket
+     * @exceptionsafety       Strong guarantee
+     * @threadsafety          Safe
+     */
+    void add(
+            const int sock,
+            Handler   handler);
+
+    /**
+     * Deregisters a socket. Blocks until any executing handler for the socket
+     * has returned, so the resources the handler references may be destroyed
+     * upon return. A socket whose handler returned `false` is deregistered
+     * automatically; deregistering it again is harmless.
+     * @param[in] sock   Socket descriptor
+     * @exceptionsafety  Nothrow
+     * @threadsafety     Safe
+     */
+    void remove(const int sock) noexcept;
+};
+
+} // namespace
+
+#endif /* MAIN_COMMS_P2P_PEERMUX_H_ */
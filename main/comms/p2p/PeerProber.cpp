@@ -0,0 +1,146 @@
+/**
+ * This file implements a prober of standby peers.
+ *
+ * Copyright 2018 University Corporation for Atmospheric Research. All Rights
+ * reserved. See file "Copying" in the top-level source-directory for usage
+ * restrictions.
+ *
+ *        File: PeerProber.cpp
+ *  Created on: Feb 2, 2018
+ *      Author: Steven R. Emmerson
+ */
+
+#include "config.h"
+
+#include "error.h"
+#include "PeerProber.h"
+#include "PeerScore.h"
+#include "PeerServer.h"
+
+#include <cerrno>
+#include <chrono>
+#include <limits>
+#include <poll.h>
+
+namespace hycast {
+
+class PeerProber::Impl final : public PeerServer
+{
+    typedef std::chrono::steady_clock     Clock;
+    typedef std::chrono::duration<double> Seconds;
+
+    Clock::time_point startTime;          ///< When the probe started
+    double            firstNoticeLatency; ///< Seconds from start of probe to
+                                          ///< first notice. Negative means no
+                                          ///< notice has arrived.
+    unsigned long     numNotices;         ///< Number of notices received
+
+    /**
+     * Records the arrival of a notice from the remote peer.
+     */
+    void recordNotice()
+    {
+        if (firstNoticeLatency < 0)
+            firstNoticeLatency = Seconds{Clock::now() - startTime}.count();
+        ++numNotices;
+    }
+
+public:
+    Impl()
+        : startTime{}
+        , firstNoticeLatency{-1}
+        , numNotices{0}
+    {}
+
+    /*
+     * Begin implementation of `PeerServer`. A probe only observes: notices
+     * are counted but nothing is requested and nothing is served.
+     */
+
+    void startBacklog(
+            const ChunkId&     earliest,
+            const BacklogOrder order)
+    {}
+
+    bool shouldRequest(const ProdIndex& prodIndex)
+    {
+        recordNotice();
+        return false;
+    }
+
+    bool shouldRequest(const ChunkId& chunkId)
+    {
+        recordNotice();
+        return false;
+    }
+
+    bool get(const ProdIndex& prodIndex, ProdInfo& prodInfo)
+    {
+        return false;
+    }
+
+    bool get(const ChunkId& chunkId, ActualChunk& chunk)
+    {
+        return false;
+    }
+
+    RecvStatus receive(const ProdInfo& info)
+    {
+        return RecvStatus{}; // Unsolicited. Ignored.
+    }
+
+    RecvStatus receive(LatentChunk& chunk)
+    {
+        chunk.discard(); // Unsolicited. Ignored.
+        return RecvStatus{};
+    }
+
+    // End implementation of `PeerServer`
+
+    double probe(
+            Peer&          peer,
+            const unsigned duration)
+    {
+        startTime = Clock::now();
+        const auto    deadline = startTime + std::chrono::seconds{duration};
+        struct pollfd pfd;
+        pfd.fd = peer.getSock();
+        pfd.events = POLLIN;
+        for (;;) {
+            const auto remaining = std::chrono::duration_cast<
+                    std::chrono::milliseconds>(deadline - Clock::now());
+            if (remaining.count() <= 0)
+                break;
+            // poll() is a cancellation point
+            const int status = ::poll(&pfd, 1,
+                    static_cast<int>(remaining.count()));
+            if (status < 0) {
+                if (errno == EINTR)
+                    continue;
+                throw SYSTEM_ERROR("Couldn't poll socket of probed peer " +
+                        peer.getRemoteAddr().to_string());
+            }
+            if (status == 0)
+                break; // Probe window expired
+            if (!peer.receive(*this))
+                // Remote peer closed the connection: the worst possible peer
+                return -std::numeric_limits<double>::infinity();
+        }
+        const double elapsed = Seconds{Clock::now() - startTime}.count();
+        const double noticeRate = (elapsed > 0) ? numNotices/elapsed : 0;
+        return PeerScore::probeScore(noticeRate, firstNoticeLatency);
+    }
+};
+
+PeerProber::PeerProber()
+    : pImpl{new Impl()}
+{}
+
+double PeerProber::probe(
+        Peer&          peer,
+        const unsigned duration) const
+{
+    return pImpl->probe(peer, duration);
+}
+
+} // namespace
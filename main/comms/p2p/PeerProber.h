@@ -0,0 +1,60 @@
+/**
+ * This file declares a prober of standby peers. A prober holds a connected
+ * peer candidate for a short interval and measures its notice latency and
+ * notice rate -- without requesting any data -- so peer replacement can be a
+ * measured upgrade instead of a gamble on an unvetted candidate.
+ *
+ * Copyright 2018 University Corporation for Atmospheric Research. All Rights
+ * reserved. See file "Copying" in the top-level source-directory for usage
+ * restrictions.
+ *
+ *        File: PeerProber.h
+ *  Created on: Feb 2, 2018
+ *      Author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_COMMS_P2P_PEERPROBER_H_
+#define MAIN_COMMS_P2P_PEERPROBER_H_
+
+#include "Peer.h"
+
+#include <memory>
+
+namespace hycast {
+
+class PeerProber final
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /// Default duration of a probe in seconds
+    static const unsigned defaultProbeDuration = 5;
+
+    /**
+     * Default constructs.
+     */
+    PeerProber();
+
+    /**
+     * Probes a connected peer. Receives messages from the remote peer for, at
+     * most, the given duration, counting notices but requesting and serving
+     * nothing. Blocks for up to the given duration. This is a cancellation
+     * point.
+     * @param[in] peer      Connected peer to probe
+     * @param[in] duration  Duration of the probe in seconds
+     * @return              Estimated composite performance score of the peer.
+     *                      Comparable with `PeerScore::getScore()`. Negative
+     *                      infinity if the remote peer closed the connection.
+     * @throw SystemError   Couldn't poll the peer's socket
+     * @exceptionsafety     Basic guarantee
+     * @threadsafety        Compatible but not safe
+     */
+    double probe(
+            Peer&          peer,
+            const unsigned duration = defaultProbeDuration) const;
+};
+
+} // namespace
+
+#endif /* MAIN_COMMS_P2P_PEERPROBER_H_ */
@@ -0,0 +1,255 @@
+/**
+ * This file implements the performance score of a remote peer.
+ *
+ * The throughput and conversion metrics are leaky integrators: every event
+ * adds its contribution divided by the time-constant and the accumulated
+ * value decays exponentially, so a steady input of X bytes per second
+ * converges on a rate of X and the rate of a stalled peer sinks towards
+ * zero. Round-trip latency is smoothed TCP-style (7/8 old + 1/8 sample).
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All Rights
+ * reserved. See file "Copying" in the top-level source-directory for usage
+ * restrictions.
+ *
+ *        File: PeerScore.cpp
+ *  Created on: Jan 12, 2018
+ *      Author: Steven R. Emmerson
+ */
+
+#include "config.h"
+
+#include "PeerScore.h"
+
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+
+namespace hycast {
+
+class PeerScore::Impl final
+{
+    typedef std::mutex                     Mutex;
+    typedef std::lock_guard<Mutex>         LockGuard;
+    typedef std::chrono::steady_clock      Clock;
+    typedef std::chrono::time_point<Clock> TimePoint;
+    typedef std::chrono::duration<double>  Seconds;
+
+    /// Time-constant of the exponentially-weighted rates in seconds
+    static const double timeConstant;
+    /// Round-trip latency that costs about one unit of score in seconds
+    static const double latencyScale;
+    /// Outstanding requests older than this are forgotten in seconds
+    static const double requestLifetime;
+
+    mutable Mutex mutex;
+    TimePoint     lastDecay;    ///< When the rates were last decayed
+    double        byteRate;     ///< Delivered bytes per second
+    double        noticeRate;   ///< Received notices per second
+    double        deliveryRate; ///< Delivered chunks per second
+    double        smoothedRtt;  ///< Smoothed round-trip latency in seconds.
+                                ///< Negative means no sample yet.
+    double        kernelSrtt;   ///< Kernel's smoothed round-trip time in
+                                ///< seconds. Negative means no sample yet.
+    double        kernelCwnd;   ///< Kernel's congestion window in bytes.
+                                ///< Non-positive means no sample yet.
+    /// When each outstanding chunk-request was sent
+    std::unordered_map<ChunkId, TimePoint> requestTimes;
+
+    /**
+     * Decays the rates to the given time.
+     * @pre            `mutex` is locked
+     * @param[in] now  Time to decay to
+     */
+    void decay(const TimePoint& now) noexcept
+    {
+        const double dt = Seconds{now - lastDecay}.count();
+        if (dt > 0) {
+            const double weight = std::exp(-dt/timeConstant);
+            byteRate *= weight;
+            noticeRate *= weight;
+            deliveryRate *= weight;
+            lastDecay = now;
+        }
+    }
+
+    /**
+     * Forgets outstanding requests that are too old to yield a meaningful
+     * latency sample (e.g., the chunk arrived via multicast instead).
+     * @pre            `mutex` is locked
+     * @param[in] now  Current time
+     */
+    void purgeRequests(const TimePoint& now)
+    {
+        for (auto iter = requestTimes.begin(); iter != requestTimes.end(); ) {
+            (Seconds{now - iter->second}.count() > requestLifetime)
+                ? (iter = requestTimes.erase(iter))
+                : ++iter;
+        }
+    }
+
+public:
+    Impl()
+        : mutex{}
+        , lastDecay{Clock::now()}
+        , byteRate{0}
+        , noticeRate{0}
+        , deliveryRate{0}
+        , smoothedRtt{-1}
+        , kernelSrtt{-1}
+        , kernelCwnd{0}
+        , requestTimes{}
+    {}
+
+    void noticeReceived() noexcept
+    {
+        LockGuard lock{mutex};
+        decay(Clock::now());
+        noticeRate += 1/timeConstant;
+    }
+
+    void requestSent(const ChunkId& chunkId)
+    {
+        LockGuard  lock{mutex};
+        const auto now = Clock::now();
+        purgeRequests(now);
+        requestTimes[chunkId] = now;
+    }
+
+    void chunkReceived(
+            const ChunkId& chunkId,
+            const size_t   nbytes)
+    {
+        LockGuard  lock{mutex};
+        const auto now = Clock::now();
+        decay(now);
+        byteRate += nbytes/timeConstant;
+        deliveryRate += 1/timeConstant;
+        const auto iter = requestTimes.find(chunkId);
+        if (iter != requestTimes.end()) {
+            const double sample = Seconds{now - iter->second}.count();
+            smoothedRtt = (smoothedRtt < 0)
+                    ? sample
+                    : 0.875*smoothedRtt + 0.125*sample;
+            requestTimes.erase(iter);
+        }
+    }
+
+    void transportSampled(
+            const double srtt,
+            const double cwndBytes) noexcept
+    {
+        LockGuard lock{mutex};
+        kernelSrtt = srtt;
+        kernelCwnd = cwndBytes;
+    }
+
+    /**
+     * Returns the composite score:
+     *   - The logarithm of the byte throughput, so doubling an already-fast
+     *     peer matters less than reviving a slow one;
+     *   - Plus the notice-to-delivery conversion in [0,1], weighted so an
+     *     all-talk peer can't outrank a delivering one;
+     *   - Minus a penalty that grows with the smoothed round-trip latency --
+     *     the kernel's estimate when available because it's fresher; and
+     *   - Minus a penalty for a congestion window that has collapsed below
+     *     the canonical chunk-size, which signals congestion seconds before
+     *     the throughput metric decays.
+     */
+    double getScore() const noexcept
+    {
+        LockGuard    lock{mutex};
+        const double dt = Seconds{Clock::now() - lastDecay}.count();
+        const double weight = (dt > 0) ? std::exp(-dt/timeConstant) : 1;
+        double       score = std::log1p(byteRate*weight);
+        if (noticeRate > 0) {
+            double conversion = deliveryRate/noticeRate;
+            if (conversion > 1)
+                conversion = 1;
+            score += 4*conversion;
+        }
+        const double rtt = (kernelSrtt >= 0) ? kernelSrtt : smoothedRtt;
+        if (rtt >= 0)
+            score -= std::log1p(rtt/latencyScale);
+        if (kernelCwnd > 0)
+            score -= std::log1p(ChunkSize::defaultSize/kernelCwnd);
+        return score;
+    }
+
+    void reset() noexcept
+    {
+        LockGuard lock{mutex};
+        lastDecay = Clock::now();
+        byteRate = 0;
+        noticeRate = 0;
+        deliveryRate = 0;
+        smoothedRtt = -1;
+        kernelSrtt = -1;
+        kernelCwnd = 0;
+        requestTimes.clear();
+    }
+};
+
+const double PeerScore::Impl::timeConstant = 30;
+const double PeerScore::Impl::latencyScale = 0.05;
+const double PeerScore::Impl::requestLifetime = 60;
+
+PeerScore::PeerScore()
+    : pImpl{new Impl()}
+{}
+
+void PeerScore::noticeReceived() const noexcept
+{
+    pImpl->noticeReceived();
+}
+
+void PeerScore::requestSent(const ChunkId& chunkId) const
+{
+    pImpl->requestSent(chunkId);
+}
+
+void PeerScore::chunkReceived(
+        const ChunkId& chunkId,
+        const size_t   nbytes) const
+{
+    pImpl->chunkReceived(chunkId, nbytes);
+}
+
+void PeerScore::transportSampled(
+        const double srtt,
+        const double cwndBytes) const noexcept
+{
+    pImpl->transportSampled(srtt, cwndBytes);
+}
+
+double PeerScore::getScore() const noexcept
+{
+    return pImpl->getScore();
+}
+
+double PeerScore::probeScore(
+        const double noticeRate,
+        const double firstNoticeLatency) noexcept
+{
+    if (firstNoticeLatency < 0)
+        return -std::numeric_limits<double>::infinity(); // Mute peer
+    /*
+     * Estimate of `getScore()` for a peer whose deliveries haven't been
+     * sampled: the throughput term assumes every noticed chunk could have
+     * been delivered at the canonical chunk-size, the conversion term takes
+     * the neutral midpoint of its 4-unit weight, and the latency penalty
+     * uses the first-notice latency -- a coarser signal than the smoothed
+     * round-trip latency, so it's scaled in whole seconds rather than by
+     * `latencyScale`.
+     */
+    return std::log1p(noticeRate*ChunkSize::defaultSize) + 2 -
+            std::log1p(firstNoticeLatency);
+}
+
+void PeerScore::reset() const noexcept
+{
+    pImpl->reset();
+}
+
+} // namespace
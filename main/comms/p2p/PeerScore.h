@@ -0,0 +1,122 @@
+/**
+ * This file declares the performance score of a remote peer. The score
+ * combines exponentially-weighted byte throughput, smoothed request/delivery
+ * round-trip latency, and the fraction of notices that become deliveries, so
+ * peer replacement can keep the peers that contribute the most goodput.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All Rights
+ * reserved. See file "Copying" in the top-level source-directory for usage
+ * restrictions.
+ *
+ *        File: PeerScore.h
+ *  Created on: Jan 12, 2018
+ *      Author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_COMMS_P2P_PEERSCORE_H_
+#define MAIN_COMMS_P2P_PEERSCORE_H_
+
+#include "Chunk.h"
+
+#include <cstddef>
+#include <memory>
+
+namespace hycast {
+
+class PeerScore final
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Default constructs. The resulting instance is functional and has a
+     * neutral score.
+     */
+    PeerScore();
+
+    /**
+     * Tells this instance that the remote peer sent a notice of an available
+     * chunk-of-data.
+     * @exceptionsafety  Nothrow
+     * @threadsafety     Safe
+     */
+    void noticeReceived() const noexcept;
+
+    /**
+     * Tells this instance that a chunk-of-data was requested from the remote
+     * peer. Starts the round-trip-latency clock for the chunk.
+     * @param[in] chunkId  Identifier of requested data-chunk
+     * @exceptionsafety    Strong guarantee
+     * @threadsafety       Safe
+     */
+    void requestSent(const ChunkId& chunkId) const;
+
+    /**
+     * Tells this instance that the remote peer delivered a chunk-of-data.
+     * Updates the throughput, latency, and conversion metrics.
+     * @param[in] chunkId  Identifier of delivered data-chunk
+     * @param[in] nbytes   Size of the data-chunk in bytes
+     * @exceptionsafety    Strong guarantee
+     * @threadsafety       Safe
+     */
+    void chunkReceived(
+            const ChunkId& chunkId,
+            const size_t   nbytes) const;
+
+    /**
+     * Tells this instance about a kernel transport sample for the remote
+     * peer's association. The kernel's smoothed round-trip time supersedes
+     * the application-level estimate in the composite score because it's
+     * fresher, and a collapsed congestion window lowers the score ahead of
+     * any decay of the throughput metric.
+     * @param[in] srtt       Kernel's smoothed round-trip time in seconds
+     * @param[in] cwndBytes  Congestion window of the primary path in bytes
+     * @exceptionsafety      Nothrow
+     * @threadsafety         Safe
+     */
+    void transportSampled(
+            const double srtt,
+            const double cwndBytes) const noexcept;
+
+    /**
+     * Returns the composite performance score. Higher is better. The score of
+     * a peer that stops delivering decays towards the minimum, so a stalled
+     * peer becomes the replacement candidate without waiting for explicit
+     * demerits.
+     * @return           Composite performance score
+     * @exceptionsafety  Nothrow
+     * @threadsafety     Safe
+     */
+    double getScore() const noexcept;
+
+    /**
+     * Resets this instance to a neutral score.
+     * @exceptionsafety  Nothrow
+     * @threadsafety     Safe
+     */
+    void reset() const noexcept;
+
+    /**
+     * Returns the estimated composite performance score of a peer that has
+     * only been probed -- i.e., whose notices have been observed but from
+     * which nothing has been requested. The estimate is on the same scale as
+     * `getScore()` so it can be compared against the scores of active peers.
+     * @param[in] noticeRate          Observed notices per second
+     * @param[in] firstNoticeLatency  Seconds from the start of observation to
+     *                                the first notice or negative, in which
+     *                                case no notice arrived and the score is
+     *                                negative infinity
+     * @return                        Estimated composite performance score.
+     *                                Higher is better.
+     * @exceptionsafety               Nothrow
+     * @threadsafety                  Safe
+     */
+    static double probeScore(
+            const double noticeRate,
+            const double firstNoticeLatency) noexcept;
+};
+
+} // namespace
+
+#endif /* MAIN_COMMS_P2P_PEERSCORE_H_ */
@@ -14,11 +14,28 @@
 #define PEERSERVER_H_
 
 #include "P2pServer.h"
+#include "PeerGossip.h"
 
 #include <memory>
+#include <vector>
 
 namespace hycast {
 
+/**
+ * Order in which the backlog of data-chunks is served. Chosen by the
+ * requesting peer: a receiver recovering from a long outage wants the
+ * products that are arriving now long before it wants hours-old data.
+ */
+enum class BacklogOrder {
+    /// From the earliest missing data-chunk forward. The historical default.
+    OLDEST_FIRST,
+    /// A window of the most recent products first, then the historical
+    /// fill-in from the earliest missing data-chunk forward. The same bytes
+    /// are transferred, but the time until current data flows drops from the
+    /// duration of the backlog to the duration of the recent window.
+    RECENT_FIRST
+};
+
 class PeerServer : public P2pServer
 {
 public:
@@ -27,8 +44,11 @@ public:
     /**
      * Starts sending the backlog of data-chunks. Doesn't block.
      * @param[in] earliest  Identifier of earliest data-chunk in backlog
+     * @param[in] order     Order in which the backlog should be served
      */
-    virtual void startBacklog(const ChunkId& earliest) =0;
+    virtual void startBacklog(
+            const ChunkId&     earliest,
+            const BacklogOrder order) =0;
 
     /**
      * Accepts information about a product.
@@ -42,6 +62,64 @@ public:
      * @param[in] peerAddr  Address of remote peer
      */
     virtual RecvStatus receive(LatentChunk& chunk) =0;
+
+    /**
+     * Accepts a small, complete data-product as a single combined
+     * product-information and data message. The default implementation
+     * decomposes the message into a product-information reception and a
+     * data-chunk reception; an implementation backed by the product-store
+     * forwards the whole message so the product costs a single store
+     * insertion.
+     * @param[in] smallProd  Small, complete data-product
+     */
+    virtual RecvStatus receive(LatentSmallProd& smallProd)
+    {
+        const ProdInfo    prodInfo = smallProd.getInfo();
+        std::vector<char> data(prodInfo.getSize());
+        smallProd.drainData(data.data(), data.size());
+        receive(prodInfo);
+        LatentChunk chunk{ChunkInfo{prodInfo, 0}, data.data()};
+        auto        status = receive(chunk);
+        if (chunk.hasData())
+            chunk.discard();
+        return status;
+    }
+
+    /**
+     * Accepts a batch of chunks-of-data that arrived together (e.g., in a
+     * chunk-run message). The default implementation accepts the chunks one
+     * at a time; an implementation backed by the product-store forwards the
+     * whole batch so the store can group it by shard and product and take
+     * each lock once.
+     * @param[in]  chunks     Batch of data-chunks
+     * @param[in]  numChunks  Number of chunks in the batch
+     * @param[out] statuses   Status of each reception, parallel to `chunks`
+     */
+    virtual void receive(
+            LatentChunk* const chunks,
+            const size_t       numChunks,
+            RecvStatus* const  statuses)
+    {
+        for (size_t i = 0; i < numChunks; ++i)
+            statuses[i] = receive(chunks[i]);
+    }
+
+    /**
+     * Accepts a gossip message. The default implementation ignores it.
+     * @param[in] gossip  Gossip message
+     */
+    virtual void receive(const PeerGossip& gossip)
+    {}
+
+    /**
+     * Accepts the cancellation of a previously-requested chunk-of-data: the
+     * remote peer no longer needs it (e.g., the chunk arrived via multicast),
+     * so a queued send of the chunk should be dropped if it hasn't been
+     * transmitted. The default implementation ignores it.
+     * @param[in] chunkId  Identifier of the unwanted data-chunk
+     */
+    virtual void cancel(const ChunkId& chunkId)
+    {}
 };
 
 } // namespace
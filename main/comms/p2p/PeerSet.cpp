@@ -9,11 +9,22 @@
  * @author: Steven R. Emmerson
  */
 
+#include "ChunkId2PeerAddrsMap.h"
+#include "ChunkPresence.h"
+#include "ChunkReqScheduler.h"
 #include "Completer.h"
 #include "error.h"
 #include "logging.h"
+#include "Metrics.h"
+#include "NoticeCache.h"
+#include "PeerScore.h"
+#include "PeerMux.h"
 #include "PeerSet.h"
+#include "probe.h"
+#include "RetentionMsg.h"
+#include "SimClock.h"
 #include "Thread.h"
+#include "Tunables.h"
 
 #include <assert.h>
 #include <atomic>
@@ -22,13 +33,18 @@
 #include <cstdint>
 #include <functional>
 #include <future>
+#include <limits>
 #include <list>
 #include <map>
 #include <mutex>
+#include <deque>
 #include <queue>
 #include <set>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 
 namespace hycast {
 
@@ -56,6 +72,138 @@ class PeerEntryServer : public P2pServer
 {
 public:
     virtual ~PeerEntryServer() =default;
+
+    using P2pServer::shouldRequest;
+    using P2pContentRcvr::receive;
+
+    /**
+     * Indicates if a chunk-of-data should be requested from a particular
+     * remote peer.
+     * @param[in] chunkId   Data-chunk identifier
+     * @param[in] peerAddr  Address of remote peer that has the chunk
+     * @retval `true`       Iff the chunk should be requested from the peer
+     */
+    virtual bool shouldRequest(
+            const ChunkId&      chunkId,
+            const InetSockAddr& peerAddr) =0;
+
+    /**
+     * Accepts a gossip message from a particular remote peer.
+     * @param[in] gossip    Gossip message
+     * @param[in] peerAddr  Address of remote peer that sent the message
+     */
+    virtual void receive(
+            const PeerGossip&   gossip,
+            const InetSockAddr& peerAddr) =0;
+
+    /**
+     * Saves the session state of an ended association under its session
+     * token so a reconnecting peer that presents the token can resume it.
+     * @param[in] token          Session token issued for the association
+     * @param[in] backlogCursor  Backlog cursor of the association. May be
+     *                           empty, in which case nothing is saved.
+     */
+    virtual void saveSession(
+            const uint64_t token,
+            const ChunkId& backlogCursor) =0;
+
+    /**
+     * Restores -- and consumes -- the session state saved under a session
+     * token.
+     * @param[in] token  Token presented by the reconnecting remote peer
+     * @return           Saved backlog cursor or an empty chunk identifier if
+     *                   no session is saved under the token
+     */
+    virtual ChunkId restoreSession(const uint64_t token) =0;
+
+    /**
+     * Returns the order in which this node asks remote peers to serve its
+     * backlog.
+     * @return Order in which the backlog should be served
+     */
+    virtual BacklogOrder getBacklogOrder() const noexcept =0;
+
+    /**
+     * Returns this node's retention advertisement: the oldest data-product
+     * its store still holds.
+     * @param[out] retention  Retention advertisement
+     * @retval `true`         Iff `retention` is set
+     */
+    virtual bool getRetention(RetentionMsg& retention) =0;
+
+    /**
+     * Returns the per-peer backlog service-rate.
+     * @return Per-peer backlog service-rate in bytes per second or 0 for
+     *         no limit
+     */
+    virtual double getPeerBacklogRate() const noexcept =0;
+
+    /**
+     * Tries to claim part of the aggregate backlog bandwidth-budget.
+     * @param[in] nbytes  Number of backlog bytes about to be sent
+     * @retval `true`     The bytes fit within the budget
+     * @retval `false`    The budget is exhausted
+     */
+    virtual bool acquireBacklogBandwidth(const size_t nbytes) =0;
+};
+
+/******************************************************************************/
+
+/**
+ * Non-blocking token-bucket budget for an optional peer-to-peer service --
+ * serving backlog data-chunks or pushing rare ones. Such services must yield
+ * to the live transmission path, so bytes beyond the budget simply aren't
+ * sent: a backlog request that isn't served times out at the requester,
+ * whose scheduler retries another peer, and an unpushed chunk remains
+ * obtainable by the ordinary notice-and-request exchange.
+ */
+class BandwidthBudget final
+{
+    typedef std::chrono::steady_clock Clock;
+
+    std::mutex        mutex;
+    /// Number of bytes that may be sent immediately
+    double            tokens;
+    /// Time of the last token refill
+    Clock::time_point lastRefill;
+
+public:
+    BandwidthBudget()
+        : mutex{}
+        , tokens{0}
+        , lastRefill{Clock::now()}
+    {}
+
+    /**
+     * Tries to claim bytes from the budget. The bucket holds at most one
+     * second's worth of the rate, so an idle budget can't accumulate into a
+     * burst that defeats its purpose. The rate is a parameter rather than
+     * state so a runtime adjustment takes effect on the very next claim.
+     * @param[in] rate    Service rate in bytes per second or 0 for no limit
+     * @param[in] nbytes  Number of bytes to claim
+     * @retval `true`     The bytes fit within the budget
+     * @retval `false`    The budget is exhausted
+     * @exceptionsafety   Strong guarantee
+     * @threadsafety      Safe
+     */
+    bool tryAcquire(
+            const double rate,
+            const size_t nbytes)
+    {
+        if (rate <= 0)
+            return true;
+        std::lock_guard<std::mutex> lock{mutex};
+        const auto now = Clock::now();
+        tokens = std::min(tokens +
+                rate*std::chrono::duration<double>(now - lastRefill).count(),
+                rate);
+        lastRefill = now;
+        // A chunk larger than the bucket must still be sendable
+        if (tokens < std::min(static_cast<double>(nbytes), rate))
+            return false;
+        tokens -= nbytes;
+        return true;
+    }
 };
 
 /******************************************************************************/
@@ -72,6 +220,26 @@ class PeerSet::Impl final : public PeerEntryServer
 
     static const PeerValue VALUE_MAX{INT32_MAX};
     static const PeerValue VALUE_MIN{INT32_MIN};
+    /// Maximum number of outstanding chunk-requests per remote peer
+    static const unsigned  MAX_OUTSTANDING_REQS{16};
+    /// Seconds after which an outstanding chunk-request is re-issued
+    static const unsigned  REQUEST_DEADLINE{10};
+    /// Maximum number of remembered chunk-send cancellations per remote peer
+    static const unsigned  MAX_CANCELLATIONS{512};
+    /// Maximum number of messages drained per readiness callback in
+    /// event-loop mode. Bounds how long one busy peer can occupy an event
+    /// thread that other peers share.
+    static const unsigned  MAX_MSGS_PER_EVENT{16};
+    /// Milliseconds between liveness heartbeats on an idle association.
+    /// Flowing traffic proves liveness by itself, so a heartbeat is sent
+    /// only when nothing else has been sent for an interval.
+    static const unsigned  HEARTBEAT_INTERVAL_MS{250};
+    /// Number of missed heartbeat intervals -- nothing at all received --
+    /// after which a remote peer is presumed dead and evicted. A
+    /// silently-dead peer (e.g., NIC failure, no RST) is thus detected in
+    /// under a second instead of waiting out the worst-peer replacement
+    /// cycle while its share of chunk-requests times out.
+    static const unsigned  MAX_MISSED_HEARTBEATS{4};
 
     /**
      * Interface for performing sending actions.
@@ -79,8 +247,25 @@ class PeerSet::Impl final : public PeerEntryServer
     class Sender
     {
     public:
-        virtual void notify(const ProdIndex& prodIndex) =0;
-        virtual void notify(const ChunkId& id) =0;
+        virtual void notify(
+                const ProdIndex&   prodIndex,
+                const std::string& prodName,
+                const NoticeCache& cache) =0;
+        virtual void notify(
+                const ChunkId&     id,
+                const NoticeCache& cache) =0;
+        virtual void notify(
+                const ChunkRange&  chunkRange,
+                const NoticeCache& cache) =0;
+        virtual void notify(
+                const ChunkRangeSet& rangeSet,
+                const NoticeCache&   cache) =0;
+        virtual void request(const ChunkId& id) =0;
+        virtual void cancelRequest(const ChunkId& id) =0;
+        virtual void send(const ActualChunk& chunk) =0;
+        virtual void sendFilter(const ProdFilter& filter) =0;
+        virtual void sendHeartbeat() =0;
+        virtual void advertiseRetention(const RetentionMsg& retention) =0;
     };
 
     /// Abstract base class for send-actions.
@@ -97,6 +282,26 @@ class PeerSet::Impl final : public PeerEntryServer
         {
             return whenCreated;
         }
+        /**
+         * Indicates if this action sends bulk data. Bulk actions are sent
+         * only when no control action (notice, request) is queued.
+         * @retval `true`   Action sends bulk data
+         * @retval `false`  Action sends a control message
+         */
+        virtual bool isBulk() const noexcept
+        {
+            return false;
+        }
+        /**
+         * Returns the priority class of this action. Only meaningful for
+         * bulk actions: higher-priority chunks are sent before
+         * lower-priority ones.
+         * @return Priority class of this action
+         */
+        virtual ProdInfo::Priority getPriority() const noexcept
+        {
+            return ProdInfo::defaultPriority;
+        }
         /**
          * Acts upon a `Sender` (i.e., a `PeerEntry`).
          * @param[in,out] sender  Peer entry implementation to be acted upon
@@ -111,10 +316,20 @@ class PeerSet::Impl final : public PeerEntryServer
     /// Send-action notice of a new product.
     class SendProdNotice final : public SendAction
     {
-        ProdIndex prodIndex;
+        ProdIndex         prodIndex;
+        /// Product name for filter-aware peers or the empty string if unknown
+        const std::string prodName;
+        /// Shared serialized form of the notice. The action is shared by
+        /// every peer's send-queue, so the notice is serialized once per
+        /// wire-encoding instead of once per peer.
+        NoticeCache       cache;
     public:
-        SendProdNotice(const ProdIndex& prodIndex)
+        SendProdNotice(
+                const ProdIndex&   prodIndex,
+                const std::string& prodName)
             : prodIndex{prodIndex}
+            , prodName{prodName}
+            , cache{}
         {}
         /**
          * Sends a notice of a data-product to a remote peer.
@@ -124,17 +339,20 @@ class PeerSet::Impl final : public PeerEntryServer
          */
         void actUpon(Sender& sender)
         {
-            sender.notify(prodIndex);
+            sender.notify(prodIndex, prodName, cache);
         }
     };
 
     /// Send-action notice of a new chunk-of-data.
     class SendChunkNotice final : public SendAction
     {
-        ChunkId id;
+        ChunkId     id;
+        /// Shared serialized form of the notice; see `SendProdNotice`
+        NoticeCache cache;
     public:
         SendChunkNotice(const ChunkId& id)
             : id{id}
+            , cache{}
         {}
         /**
          * Sends a notice of the availability of a chunk-of-data to a remote
@@ -145,7 +363,182 @@ class PeerSet::Impl final : public PeerEntryServer
          */
         void actUpon(Sender& sender)
         {
-            sender.notify(id);
+            sender.notify(id, cache);
+        }
+    };
+
+    /// Send-action notice of a contiguous range of new chunks-of-data.
+    class SendChunkRangeNotice final : public SendAction
+    {
+        ChunkRange  chunkRange;
+        /// Shared serialized form of the notice; see `SendProdNotice`
+        NoticeCache cache;
+    public:
+        SendChunkRangeNotice(const ChunkRange& chunkRange)
+            : chunkRange{chunkRange}
+            , cache{}
+        {}
+        /**
+         * Sends one coalesced notice of the availability of a contiguous
+         * range of chunks-of-data to a remote peer.
+         * @param[in] sender    Peer-entry implementation
+         * @exceptionsafety     Basic guarantee
+         * @threadsafety        Compatible but not safe
+         */
+        void actUpon(Sender& sender)
+        {
+            sender.notify(chunkRange, cache);
+        }
+    };
+
+    /// Send-action notice of a range-encoded set of new chunks-of-data.
+    class SendChunkRangeSetNotice final : public SendAction
+    {
+        ChunkRangeSet rangeSet;
+        /// Shared serialized form of the notice; see `SendProdNotice`
+        NoticeCache   cache;
+    public:
+        SendChunkRangeSetNotice(const ChunkRangeSet& rangeSet)
+            : rangeSet{rangeSet}
+            , cache{}
+        {}
+        /**
+         * Sends one coalesced notice of the availability of a range-encoded
+         * set of chunks-of-data to a remote peer.
+         * @param[in] sender    Peer-entry implementation
+         * @exceptionsafety     Basic guarantee
+         * @threadsafety        Compatible but not safe
+         */
+        void actUpon(Sender& sender)
+        {
+            sender.notify(rangeSet, cache);
+        }
+    };
+
+    /// Send-action transmission of a product filter.
+    class SendFilter final : public SendAction
+    {
+        ProdFilter filter;
+    public:
+        SendFilter(const ProdFilter& filter)
+            : filter{filter}
+        {}
+        /**
+         * Sends a product filter to a remote peer.
+         * @param[in] sender    Peer-entry implementation
+         * @exceptionsafety     Basic guarantee
+         * @threadsafety        Compatible but not safe
+         */
+        void actUpon(Sender& sender)
+        {
+            sender.sendFilter(filter);
+        }
+    };
+
+    /// Send-action transmission of a retention-range advertisement.
+    class SendRetention final : public SendAction
+    {
+        RetentionMsg retention;
+    public:
+        SendRetention(const RetentionMsg& retention)
+            : retention{retention}
+        {}
+        /**
+         * Sends a retention-range advertisement to a remote peer.
+         * @param[in] sender    Peer-entry implementation
+         * @exceptionsafety     Basic guarantee
+         * @threadsafety        Compatible but not safe
+         */
+        void actUpon(Sender& sender)
+        {
+            sender.advertiseRetention(retention);
+        }
+    };
+
+    /// Send-action transmission of a liveness heartbeat.
+    class SendHeartbeat final : public SendAction
+    {
+    public:
+        SendHeartbeat()
+        {}
+        /**
+         * Sends a liveness heartbeat to a remote peer.
+         * @param[in] sender    Peer-entry implementation
+         * @exceptionsafety     Basic guarantee
+         * @threadsafety        Compatible but not safe
+         */
+        void actUpon(Sender& sender)
+        {
+            sender.sendHeartbeat();
+        }
+    };
+
+    /// Send-action request for a chunk-of-data.
+    class SendChunkRequest final : public SendAction
+    {
+        ChunkId id;
+    public:
+        SendChunkRequest(const ChunkId& id)
+            : id{id}
+        {}
+        /**
+         * Sends a request for a chunk-of-data to a remote peer.
+         * @param[in] sender    Peer-entry implementation
+         * @exceptionsafety     Basic guarantee
+         * @threadsafety        Compatible but not safe
+         */
+        void actUpon(Sender& sender)
+        {
+            sender.request(id);
+        }
+    };
+
+    /// Send-action cancellation of a previous request for a chunk-of-data.
+    class SendChunkCancel final : public SendAction
+    {
+        ChunkId id;
+    public:
+        SendChunkCancel(const ChunkId& id)
+            : id{id}
+        {}
+        /**
+         * Sends a cancellation of a previous request for a chunk-of-data to a
+         * remote peer.
+         * @param[in] sender    Peer-entry implementation
+         * @exceptionsafety     Basic guarantee
+         * @threadsafety        Compatible but not safe
+         */
+        void actUpon(Sender& sender)
+        {
+            sender.cancelRequest(id);
+        }
+    };
+
+    /// Send-action transmission of a chunk-of-data (bulk data).
+    class SendChunk final : public SendAction
+    {
+        ActualChunk chunk;
+    public:
+        SendChunk(const ActualChunk& chunk)
+            : chunk{chunk}
+        {}
+        bool isBulk() const noexcept
+        {
+            return true;
+        }
+        ProdInfo::Priority getPriority() const noexcept
+        {
+            return chunk.getInfo().getProdInfo().getPriority();
+        }
+        /**
+         * Sends a chunk-of-data to a remote peer.
+         * @param[in] sender    Peer-entry implementation
+         * @exceptionsafety     Basic guarantee
+         * @threadsafety        Compatible but not safe
+         */
+        void actUpon(Sender& sender)
+        {
+            sender.send(chunk);
         }
     };
 
@@ -165,13 +558,38 @@ class PeerSet::Impl final : public PeerEntryServer
             {
                 typedef std::shared_ptr<SendAction> Pimpl;
 
-                std::queue<Pimpl>        queue;
+                /// Queue of control actions (notices, requests)
+                std::deque<Pimpl>        ctrlQueue;
+                /// Queue of bulk actions (chunks-of-data), ordered by
+                /// decreasing priority class. FIFO within a class.
+                std::deque<Pimpl>        bulkQueue;
                 std::mutex               mutex;
                 std::condition_variable  cond;
                 const TimeUnit           maxResideTime;
+
+                /**
+                 * Deletes the entries of a queue that are older than the
+                 * maximum residence time. The whole queue is scanned because
+                 * the bulk queue is ordered by priority class, so entry ages
+                 * aren't monotonic.
+                 * @param[in,out] queue  Queue to be pruned
+                 */
+                void prune(std::deque<Pimpl>& queue)
+                {
+                    const auto now = Clock::now();
+                    for (auto iter = queue.begin(); iter != queue.end(); ) {
+                        if (now - (*iter)->getCreateTime() > maxResideTime) {
+                            iter = queue.erase(iter);
+                        }
+                        else {
+                            ++iter;
+                        }
+                    }
+                }
             public:
                 SendQ(const TimeUnit& maxResideTime = TimeUnit{0})
-                    : queue{}
+                    : ctrlQueue{}
+                    , bulkQueue{}
                     , mutex{}
                     , cond{}
                     , maxResideTime{maxResideTime}
@@ -185,32 +603,52 @@ class PeerSet::Impl final : public PeerEntryServer
 
                 /**
                  * Adds an action to the queue. Entries older than the maximum
-                 * residence time will be deleted.
+                 * residence time will be deleted. A bulk action is inserted
+                 * after the last queued action of equal or greater priority
+                 * class, so higher-priority chunks are sent first and
+                 * equal-priority chunks stay in FIFO order.
+                 * The action is borrowed by reference: a notice fanned out
+                 * to many peers then costs one owning copy per queue instead
+                 * of atomic reference-count traffic at every call-boundary,
+                 * which profiles as cross-core cache-line bouncing.
                  * @param[in] action         Action to be added
                  */
-                void push(std::shared_ptr<SendAction> action)
+                void push(const std::shared_ptr<SendAction>& action)
                 {
                     LockGuard lock{mutex};
-                    while (!queue.empty() && (Clock::now() -
-                            queue.front()->getCreateTime() > maxResideTime))
-                        queue.pop();
-                    queue.push(action);
+                    if (action->isBulk()) {
+                        prune(bulkQueue);
+                        const auto priority = action->getPriority();
+                        auto       pos = bulkQueue.end();
+                        while (pos != bulkQueue.begin() &&
+                                (*(pos - 1))->getPriority() < priority)
+                            --pos;
+                        bulkQueue.insert(pos, action);
+                    }
+                    else {
+                        prune(ctrlQueue);
+                        ctrlQueue.push_back(action);
+                    }
                     cond.notify_one();
                 }
 
                 /**
-                 * Removes the entry at the front of the queue and returns it.
-                 * @return Entry at front of queue
+                 * Removes the highest-priority entry and returns it. Control
+                 * actions always precede bulk actions, so a large backlog of
+                 * queued chunks can't delay notices and requests.
+                 * @return Highest-priority entry
                  */
                 Pimpl pop()
                 {
                     UniqueLock lock{mutex};
-                    while (queue.empty()) {
+                    while (ctrlQueue.empty() && bulkQueue.empty()) {
                         Canceler canceler{};
                         cond.wait(lock);
                     }
-                    auto action = queue.front();
-                    queue.pop();
+                    auto& queue = ctrlQueue.empty() ? bulkQueue : ctrlQueue;
+                    // Moved, not copied: ownership leaves the queue anyway
+                    auto  action = std::move(queue.front());
+                    queue.pop_front();
                     return action;
                 }
             };
@@ -221,14 +659,36 @@ class PeerSet::Impl final : public PeerEntryServer
             Peer                   peer;
             /// Value of this entry
             std::atomic<PeerValue> value;
+            /// Performance score of the remote peer
+            PeerScore              score;
             /// Completion service for executing the sending and receiving tasks
             Completer<void>        completer;
             /// Higher-level component used by this instance
             PeerEntryServer*       peerEntryServer;
             /// Sender of backlog data-chunks to the remote peer
             Backlogger             backlogger;
+            /// This peer's share of the backlog bandwidth-budget
+            BandwidthBudget        peerBudget;
             /// Thread on which the sender of the backlog executes
             Thread                 backlogThread;
+            /// Event-loop multiplexer or `nullptr` for a receiving thread
+            PeerMux*               peerMux;
+            /// Guards `cancelledChunks`
+            std::mutex             cancelMutex;
+            /// Chunks whose queued sends the remote peer has cancelled
+            std::unordered_set<ChunkId> cancelledChunks;
+            /// Chunks the remote peer provably has -- it announced them,
+            /// delivered them to us, or we sent them to it. On a healthy
+            /// feed most notices would announce chunks the receiver already
+            /// holds, so such notices are suppressed. A miss is safe: it
+            /// merely sends a notice the remote peer ignores.
+            ChunkPresence<16>      remotePossession;
+            /// Tick (`Clock` time-since-epoch count) of the most recent
+            /// send-action performed for the remote peer. Written by the
+            /// sender thread; read by the heartbeat monitor, which sends a
+            /// heartbeat only when the send side has gone idle -- flowing
+            /// traffic piggybacks the liveness signal.
+            std::atomic<Clock::duration::rep> lastSendTick;
 
             /**
              * Processes send-actions queued-up for a peer. Doesn't return
@@ -240,6 +700,8 @@ class PeerSet::Impl final : public PeerEntryServer
                     for (;;) {
                         auto action = sendQ.pop();
                         action->actUpon(*this); // E.g., `sendNotice()`
+                        lastSendTick.store(Clock::now().time_since_epoch()
+                                .count(), std::memory_order_relaxed);
                     }
                 }
                 catch (const std::exception& e) {
@@ -253,6 +715,7 @@ class PeerSet::Impl final : public PeerEntryServer
                 : sendQ{}
                 , peer{}
                 , value{0}
+                , score{}
                 , completer{}
                 /*
                  * g++(1) 4.8.5 doesn't support "{}"-based initialization of
@@ -260,7 +723,13 @@ class PeerSet::Impl final : public PeerEntryServer
                  */
                 , peerEntryServer(nullptr)
                 , backlogger{}
+                , peerBudget{}
                 , backlogThread{}
+                , peerMux{nullptr}
+                , cancelMutex{}
+                , cancelledChunks{}
+                , remotePossession{}
+                , lastSendTick{0}
             {}
             /**
              * Constructs. Acts upon input from the remote peer by calling the
@@ -271,16 +740,25 @@ class PeerSet::Impl final : public PeerEntryServer
              *                             instance.
              * @param[in] maxResideTime    Maximum residence time for
              *                             send-actions
+             * @param[in] peerMux          Event-loop multiplexer that receives
+             *                             input from the remote peer or
+             *                             `nullptr`, in which case a dedicated
+             *                             receiving thread is used. If not
+             *                             `nullptr`, then it *must* exist for
+             *                             the duration of the constructed
+             *                             instance.
              * @throw LogicError           First message from remote peer isn't
              *                             chunk-request
              * @throw RuntimeError         Instance couldn't be constructed
              */
             Impl(   Peer&            peer,
                     PeerEntryServer& peerEntryServer,
-                    const TimeUnit&  maxResideTime)
+                    const TimeUnit&  maxResideTime,
+                    PeerMux*         peerMux)
                 : sendQ{maxResideTime}
                 , peer{peer}
                 , value{0}
+                , score{}
                 , completer{}
                 /*
                  * g++(1) 4.8.5 doesn't support "{}"-based initialization of
@@ -288,7 +766,13 @@ class PeerSet::Impl final : public PeerEntryServer
                  */
                 , peerEntryServer(&peerEntryServer)
                 , backlogger{}
+                , peerBudget{}
                 , backlogThread{}
+                , peerMux{peerMux}
+                , cancelMutex{}
+                , cancelledChunks{}
+                , remotePossession{}
+                , lastSendTick{Clock::now().time_since_epoch().count()}
             {}
 
             /// Prevents copy and move construction and assignment.
@@ -314,27 +798,144 @@ class PeerSet::Impl final : public PeerEntryServer
              */
             void operator()(const ChunkId& earliest)
             {
+                /*
+                 * The retention range is advertised before anything else so
+                 * the remote peer never assigns this node a chunk-request
+                 * that's doomed by eviction.
+                 */
+                RetentionMsg retention{};
+                if (peerEntryServer->getRetention(retention))
+                    peer.advertiseRetention(retention);
                 if (earliest) {
-                    peer.requestBacklog(earliest);
+                    peer.requestBacklog(earliest,
+                            peerEntryServer->getBacklogOrder());
                 }
                 else {
                     LOG_INFO("Backlog won't be requested because "
                             "there's no oldest missing data-chunk");
                 }
-                completer.submit([this]{peer.runReceiver(*this);});
-                completer.submit([this]{runSender();});
-                completer.take().getResult(); // Will rethrow any task exception
+                if (peerMux) {
+                    completer.submit([this]{runSender();});
+                    // Event threads receive for this peer from now on
+                    peerMux->add(peer.getSock(), [this]{return receiveOne();});
+                    try {
+                        // Will rethrow any task exception
+                        completer.take().getResult();
+                    }
+                    catch (const std::exception& e) {
+                        peerMux->remove(peer.getSock());
+                        throw;
+                    }
+                    peerMux->remove(peer.getSock());
+                }
+                else {
+                    completer.submit([this]{peer.runReceiver(*this);});
+                    completer.submit([this]{runSender();});
+                    // Will rethrow any task exception
+                    completer.take().getResult();
+                }
+            }
+
+            /**
+             * Receives and processes a single message from the remote peer.
+             * Called by an event thread when input is available. Doesn't
+             * throw: a failure -- or the remote peer closing the connection --
+             * is conveyed to `operator()` via the completion service.
+             * @retval `true`   Input should continue to be awaited
+             * @retval `false`  This peer is done: deregister its socket
+             */
+            bool receiveOne() noexcept
+            {
+                try {
+                    /*
+                     * Messages already buffered on the connection are
+                     * drained before returning to the multiplexer, so the
+                     * epoll_wait(2) round-trip amortizes over a batch
+                     * instead of costing one wakeup per message.
+                     */
+                    for (unsigned numMsgs = 0;;) {
+                        if (!peer.receive(*this)) {
+                            receiverStopped(std::exception_ptr{});
+                            return false;
+                        }
+                        if (++numMsgs >= MAX_MSGS_PER_EVENT ||
+                                !peer.hasInput())
+                            return true; // Remaining input re-arms epoll
+                    }
+                }
+                catch (const std::exception& e) {
+                    receiverStopped(std::current_exception());
+                }
+                return false;
+            }
+
+            /**
+             * Conveys the termination of the receive path to `operator()`,
+             * which is blocked on the completion service: a task is submitted
+             * that rethrows the given exception or -- if the connection was
+             * simply closed -- returns immediately.
+             * @param[in] ex  Exception that terminated the receive path or
+             *                `nullptr` if the connection was closed
+             */
+            void receiverStopped(std::exception_ptr ex)
+            {
+                completer.submit([ex]{
+                    if (ex)
+                        std::rethrow_exception(ex);
+                });
             }
 
-            void startBacklog(const ChunkId& earliest)
+            void startBacklog(
+                    const ChunkId&     earliest,
+                    const BacklogOrder order)
             {
+                backlogger = peerEntryServer->getBacklogger(earliest, peer);
+                backlogger.setOrder(order); // As the remote peer requested
+                /*
+                 * If the remote peer presented a resumption token, then its
+                 * prior association's backlog cursor seeds the new
+                 * backlogger: sending resumes where the remote peer left
+                 * off instead of re-announcing the whole backlog.
+                 */
+                const auto token = peer.getResumeToken();
+                if (token)
+                    backlogger.setCursor(
+                            peerEntryServer->restoreSession(token));
                 /*
                  * NB: The following is safe even if `backlogThread` was
                  * default-constructed or is associated with an active thread
                  * because assignment cancels the target thread.
                  */
-                backlogThread = Thread{
-                        peerEntryServer->getBacklogger(earliest, peer)};
+                backlogThread = Thread{backlogger};
+            }
+
+            /**
+             * Saves the session state of this entry's association under the
+             * locally-issued session token so the remote peer can resume it
+             * by presenting the token on a reconnection. Called when the
+             * peer is stopped or removed.
+             */
+            void saveSession()
+            {
+                if (backlogger)
+                    peerEntryServer->saveSession(peer.getSessionToken(),
+                            backlogger.getCursor());
+            }
+
+            /**
+             * Offers the peer's torn-down implementation to the warm-peer
+             * pool from which new peers are constructed during a reconnect
+             * storm. The sending and receiving tasks use the peer and the
+             * backlog sender holds a copy of it, so they're torn down first.
+             * Called when the peer is stopped, after its session state has
+             * been saved.
+             */
+            void recyclePeer()
+            {
+                completer = Completer<void>{};
+                backlogThread = Thread{};
+                backlogger = Backlogger{};
+                peer.recycle();
             }
 
             bool shouldRequest(const ProdIndex& prodIndex)
@@ -344,7 +945,14 @@ class PeerSet::Impl final : public PeerEntryServer
 
             bool shouldRequest(const ChunkId& chunkId)
             {
-                return peerEntryServer->shouldRequest(chunkId);
+                // The notice proves the remote peer has the chunk
+                remotePossession.set(chunkId);
+                score.noticeReceived();
+                const bool should = peerEntryServer->shouldRequest(chunkId,
+                        peer.getRemoteAddr());
+                if (should)
+                    score.requestSent(chunkId);
+                return should;
             }
 
             bool get(const ProdIndex& prodIndex, ProdInfo& prodInfo)
@@ -352,9 +960,64 @@ class PeerSet::Impl final : public PeerEntryServer
                 return peerEntryServer->get(prodIndex, prodInfo);
             }
 
+            /**
+             * Handles a request for a chunk-of-data from the remote peer. If
+             * the chunk exists, then it's queued as a bulk send-action for
+             * the sender thread rather than sent by the caller, so control
+             * messages can preempt it and the receiver thread isn't blocked
+             * by a bulk transmission.
+             * @param[in]  chunkId  Data-chunk identifier
+             * @param[out] chunk    Unused
+             * @retval `false`      Always. The caller needn't send the chunk.
+             */
             bool get(const ChunkId& chunkId, ActualChunk& chunk)
             {
-                return peerEntryServer->get(chunkId, chunk);
+                ActualChunk actualChunk{};
+                if (peerEntryServer->get(chunkId, actualChunk)) {
+                    // The request acknowledges consumption of the notice
+                    if (backlogger) {
+                        backlogger.ack(chunkId);
+                        /*
+                         * A historical chunk is served only within the
+                         * backlog bandwidth-budget: the uplink must carry
+                         * the live stream first. The requester's scheduler
+                         * times an unserved request out and retries another
+                         * peer.
+                         */
+                        const auto& earliest = backlogger.getEarliest();
+                        if (earliest && chunkId.isEarlierThan(earliest) &&
+                                !acquireBacklogBandwidth(
+                                        actualChunk.getSize())) {
+                            static auto& deferCount = Metrics::getCounter(
+                                    "hycast_backlog_chunks_deferred_total",
+                                    "Backlog chunk-requests not served "
+                                    "because the backlog bandwidth-budget "
+                                    "was exhausted");
+                            deferCount.add();
+                            LOG_DEBUG("Deferred backlog chunk " +
+                                    chunkId.to_string() +
+                                    ": bandwidth-budget exhausted");
+                            return false;
+                        }
+                    }
+                    push(std::shared_ptr<SendAction>{
+                            new SendChunk(actualChunk)});
+                }
+                return false;
+            }
+
+            /**
+             * Tries to claim backlog bandwidth for this peer: first from
+             * the per-peer budget, then from the set-wide aggregate budget.
+             * @param[in] nbytes  Number of backlog bytes about to be sent
+             * @retval `true`     The bytes fit within both budgets
+             * @retval `false`    A budget is exhausted
+             */
+            bool acquireBacklogBandwidth(const size_t nbytes)
+            {
+                return peerBudget.tryAcquire(
+                        peerEntryServer->getPeerBacklogRate(), nbytes) &&
+                        peerEntryServer->acquireBacklogBandwidth(nbytes);
             }
 
             RecvStatus receive(const ProdInfo& info)
@@ -364,26 +1027,267 @@ class PeerSet::Impl final : public PeerEntryServer
 
             RecvStatus receive(LatentChunk& chunk)
             {
+                // The delivery proves the remote peer has the chunk
+                remotePossession.set(chunk.getId());
+                score.chunkReceived(chunk.getId(),
+                        static_cast<size_t>(chunk.getSize()));
                 return peerEntryServer->receive(chunk, peer.getRemoteAddr());
             }
 
-            void notify(const ProdIndex& prodIndex)
+            RecvStatus receive(LatentSmallProd& smallProd)
+            {
+                // The delivery proves the remote peer has the chunk
+                const auto prodInfo = smallProd.getInfo();
+                const auto chunkId = ChunkInfo{prodInfo, 0}.getId();
+                remotePossession.set(chunkId);
+                score.chunkReceived(chunkId,
+                        static_cast<size_t>(prodInfo.getSize()));
+                return peerEntryServer->receive(smallProd,
+                        peer.getRemoteAddr());
+            }
+
+            void receive(
+                    LatentChunk* const chunks,
+                    const size_t       numChunks,
+                    RecvStatus* const  statuses)
             {
-                peer.notify(prodIndex);
+                for (size_t i = 0; i < numChunks; ++i) {
+                    // The deliveries prove the remote peer has the chunks
+                    remotePossession.set(chunks[i].getId());
+                    score.chunkReceived(chunks[i].getId(),
+                            static_cast<size_t>(chunks[i].getSize()));
+                }
+                peerEntryServer->receive(chunks, numChunks, statuses,
+                        peer.getRemoteAddr());
+            }
+
+            void receive(const PeerGossip& gossip)
+            {
+                peerEntryServer->receive(gossip, peer.getRemoteAddr());
+            }
+
+            /**
+             * Accepts the cancellation of a previously-requested chunk-of-data
+             * by the remote peer: if the corresponding send-action is still
+             * queued, then it's dropped when the sender thread reaches it.
+             * @param[in] chunkId  Identifier of the unwanted data-chunk
+             */
+            void cancel(const ChunkId& chunkId)
+            {
+                LockGuard lock{cancelMutex};
+                /*
+                 * NB: `send()` consumes matching entries, but a cancellation
+                 * that arrives after its chunk was sent would linger, so the
+                 * set is cleared when it hits the cap. Cancellations are
+                 * advisory; losing one merely sends an unwanted chunk.
+                 */
+                if (cancelledChunks.size() >= MAX_CANCELLATIONS)
+                    cancelledChunks.clear();
+                cancelledChunks.insert(chunkId);
             }
 
-            void notify(const ChunkId& chunkId)
+            void notify(
+                    const ProdIndex&   prodIndex,
+                    const std::string& prodName,
+                    const NoticeCache& cache)
+            {
+                peer.notify(prodIndex, prodName, cache);
+            }
+
+            /**
+             * Indicates if the remote peer provably has every chunk of a
+             * range, in which case a notice of the range is useless to it.
+             * @param[in] chunkRange  Range of chunk identifiers
+             * @retval `true`         The remote peer has every chunk
+             * @retval `false`       The remote peer might need a chunk
+             */
+            bool hasAllOf(const ChunkRange& chunkRange)
+            {
+                const ChunkIndex::type numChunks = chunkRange.getNumChunks();
+                for (ChunkIndex::type i = 0; i < numChunks; ++i)
+                    if (!remotePossession.test(chunkRange.getChunkId(i)))
+                        return false;
+                return true;
+            }
+
+            /**
+             * Counts a suppressed chunk-notice.
+             */
+            static void noticeSuppressed()
+            {
+                static auto& suppressedCount = Metrics::getCounter(
+                        "hycast_chunk_notices_suppressed_total",
+                        "Chunk-notices not sent because the remote peer "
+                        "provably has the chunks");
+                suppressedCount.add();
+            }
+
+            void notify(
+                    const ChunkId&     chunkId,
+                    const NoticeCache& cache)
             {
                 // No need to include this chunk in the backlog
                 backlogger.doNotNotifyOf(chunkId);
-                peer.notify(chunkId);
+                // A notice of a chunk the remote peer provably has is noise
+                if (remotePossession.test(chunkId)) {
+                    noticeSuppressed();
+                    return;
+                }
+                peer.notify(chunkId, cache);
+            }
+
+            void notify(
+                    const ChunkRange&  chunkRange,
+                    const NoticeCache& cache)
+            {
+                // No need to include these chunks in the backlog
+                const ChunkIndex::type numChunks = chunkRange.getNumChunks();
+                for (ChunkIndex::type i = 0; i < numChunks; ++i)
+                    backlogger.doNotNotifyOf(chunkRange.getChunkId(i));
+                if (hasAllOf(chunkRange)) {
+                    noticeSuppressed();
+                    return;
+                }
+                peer.notify(chunkRange, cache);
+            }
+
+            void notify(
+                    const ChunkRangeSet& rangeSet,
+                    const NoticeCache&   cache)
+            {
+                // No need to include these chunks in the backlog
+                for (const auto& chunkRange : rangeSet) {
+                    const ChunkIndex::type numChunks =
+                            chunkRange.getNumChunks();
+                    for (ChunkIndex::type i = 0; i < numChunks; ++i)
+                        backlogger.doNotNotifyOf(chunkRange.getChunkId(i));
+                }
+                /*
+                 * Ranges whose every chunk the remote peer provably has are
+                 * dropped. The common case -- the remote peer announced or
+                 * delivered the whole set -- sends nothing at all.
+                 */
+                ChunkRangeSet needed{};
+                for (const auto& chunkRange : rangeSet) {
+                    if (hasAllOf(chunkRange)) {
+                        noticeSuppressed();
+                    }
+                    else {
+                        needed.add(chunkRange);
+                    }
+                }
+                if (needed.size() == rangeSet.size()) {
+                    peer.notify(rangeSet, cache); // Nothing was dropped
+                }
+                else if (needed) {
+                    // This peer's subset differs from the shared notice, so
+                    // it's serialized individually
+                    peer.notify(needed);
+                }
+            }
+
+            void request(const ChunkId& chunkId)
+            {
+                peer.request(chunkId);
+            }
+
+            void cancelRequest(const ChunkId& chunkId)
+            {
+                peer.cancel(chunkId);
+            }
+
+            void send(const ActualChunk& chunk)
+            {
+                {
+                    LockGuard lock{cancelMutex};
+                    if (cancelledChunks.erase(chunk.getId())) {
+                        LOG_DEBUG("Dropping cancelled send of data-chunk " +
+                                chunk.getId().to_string() + " to remote peer "
+                                + getRemoteAddr().to_string());
+                        return;
+                    }
+                }
+                peer.send(chunk);
+                // The remote peer now has the chunk
+                remotePossession.set(chunk.getId());
+            }
+
+            void sendFilter(const ProdFilter& filter)
+            {
+                peer.setFilter(filter);
+            }
+
+            void sendHeartbeat()
+            {
+                peer.sendHeartbeat();
+            }
+
+            void advertiseRetention(const RetentionMsg& retention)
+            {
+                peer.advertiseRetention(retention);
+            }
+
+            /**
+             * Indicates if the remote peer's store might still hold a given
+             * product, according to its most recent retention advertisement.
+             * @param[in] prodIndex  Index of the product in question
+             * @retval `true`        The remote peer might hold the product
+             * @retval `false`       The remote peer evicted the product
+             * @exceptionsafety      Nothrow
+             * @threadsafety         Safe
+             */
+            bool mayHave(const ProdIndex& prodIndex) const noexcept
+            {
+                return peer.mayHave(prodIndex);
+            }
+
+            /**
+             * Indicates if liveness heartbeats were negotiated with the
+             * remote peer, in which case silence implies death.
+             * @retval `true`    Iff heartbeats were negotiated
+             * @exceptionsafety  Nothrow
+             * @threadsafety     Safe
+             */
+            bool heartbeatsNegotiated() const noexcept
+            {
+                return peer.heartbeatsNegotiated();
+            }
+
+            /**
+             * Returns the time since a message was last received from the
+             * remote peer.
+             * @return           Duration of the receive-side silence
+             * @exceptionsafety  Nothrow
+             * @threadsafety     Safe
+             */
+            std::chrono::milliseconds getRecvSilence() const noexcept
+            {
+                return peer.getRecvSilence();
             }
 
             /**
-             * Adds a send-action to the send-action queue.
+             * Indicates if the send side of the association has been idle
+             * for at least the given duration, in which case a heartbeat is
+             * the only way the remote peer learns this process is alive.
+             * @param[in] duration  Idleness threshold
+             * @retval `true`       Nothing was sent in the last `duration`
+             * @exceptionsafety     Nothrow
+             * @threadsafety        Safe
+             */
+            bool sendIdleFor(const Clock::duration& duration) const noexcept
+            {
+                const Clock::duration idle{
+                        Clock::now().time_since_epoch().count() -
+                        lastSendTick.load(std::memory_order_relaxed)};
+                return idle >= duration;
+            }
+
+            /**
+             * Adds a send-action to the send-action queue. The action is
+             * borrowed by reference; the queue makes the owning copy.
              * @param[in] action         Send-action to be added
              */
-            void push(std::shared_ptr<SendAction> action)
+            void push(const std::shared_ptr<SendAction>& action)
             {
                 sendQ.push(action);
             }
@@ -428,6 +1332,32 @@ class PeerSet::Impl final : public PeerEntryServer
                 return value;
             }
 
+            /**
+             * Returns the composite performance score of the peer: the
+             * performance metrics plus a small weight for each manual
+             * increment or decrement of the peer's value.
+             * @return           Composite performance score. Higher is better.
+             * @exceptionsafety  Nothrow
+             * @threadsafety     Safe
+             */
+            double getScore() const noexcept
+            {
+                return score.getScore() + 0.25*static_cast<double>(value);
+            }
+
+            /**
+             * Tells the peer's performance score about a kernel transport
+             * sample for the peer's association.
+             * @param[in] status  Transport metrics of the association
+             * @exceptionsafety   Nothrow
+             * @threadsafety      Safe
+             */
+            void transportSampled(const SctpSock::Status& status) noexcept
+            {
+                score.transportSampled(status.srttMs/1000.0,
+                        status.cwndBytes);
+            }
+
             /**
              * Resets the value of a peer.
              * @exceptionsafety Nothrow
@@ -436,6 +1366,7 @@ class PeerSet::Impl final : public PeerEntryServer
             void resetValue()
             {
                 value = 0;
+                score.reset();
             }
 
             size_t hash()
@@ -458,8 +1389,9 @@ class PeerSet::Impl final : public PeerEntryServer
         inline PeerEntry(
                 Peer&            peer,
                 PeerEntryServer& peerEntryServer,
-                const TimeUnit&  maxResideTime)
-            : pImpl{new Impl(peer, peerEntryServer, maxResideTime)}
+                const TimeUnit&  maxResideTime,
+                PeerMux*         peerMux = nullptr)
+            : pImpl{new Impl(peer, peerEntryServer, maxResideTime, peerMux)}
         {}
         inline InetSockAddr getRemoteAddr() const { return pImpl->getRemoteAddr(); }
         inline void operator()(const ChunkId& earliest)
@@ -468,9 +1400,28 @@ class PeerSet::Impl final : public PeerEntryServer
         inline void incValue()              const { pImpl->incValue(); }
         inline void decValue()              const { pImpl->decValue(); }
         inline PeerValue getValue()         const { return pImpl->getValue(); }
+        inline double getScore()            const { return pImpl->getScore(); }
+        inline void transportSampled(const SctpSock::Status& status) const {
+            pImpl->transportSampled(status);
+        }
+        inline bool heartbeatsNegotiated() const noexcept {
+            return pImpl->heartbeatsNegotiated();
+        }
+        inline bool mayHave(const ProdIndex& prodIndex) const noexcept {
+            return pImpl->mayHave(prodIndex);
+        }
+        inline std::chrono::milliseconds getRecvSilence() const noexcept {
+            return pImpl->getRecvSilence();
+        }
+        inline bool sendIdleFor(const Clock::duration& duration)
+                                            const noexcept {
+            return pImpl->sendIdleFor(duration);
+        }
         inline void resetValue()            const { pImpl->resetValue(); }
+        inline void saveSession()           const { pImpl->saveSession(); }
+        inline void recyclePeer()           const { pImpl->recyclePeer(); }
         inline void push(
-                std::shared_ptr<SendAction> action) const {
+                const std::shared_ptr<SendAction>& action) const {
             pImpl->push(action);
         }
         inline size_t hash()                const {return pImpl->hash(); }
@@ -490,18 +1441,100 @@ class PeerSet::Impl final : public PeerEntryServer
     typedef Future<void>                        PeerFuture;
     typedef std::pair<PeerFuture, PeerEntry>    ActivePeerEntry;
 
+    /// Snapshot of the active peers for the lock-free notify fan-out
+    typedef std::vector<std::pair<InetSockAddr, PeerEntry>>
+                                                PeerList;
+
     mutable std::mutex                          mutex;
     mutable std::condition_variable             cond;
     std::unordered_map<InetSockAddr, ActivePeerEntry>
                                                 activePeerEntries;
     std::unordered_map<PeerFuture, PeerEntry>   peerEntries;
+    /// Immutable snapshot of the active peers. Read without `mutex` by the
+    /// notify fan-out; replaced under `mutex` whenever a peer is added or
+    /// removed. Copy-on-write: a fan-out that holds the previous snapshot
+    /// keeps using it
+    std::shared_ptr<const PeerList>             peerList;
     const TimeUnit                              stasisDuration;
     const TimeUnit                              maxResideTime;
     unsigned                                    maxPeers;
     std::exception_ptr                          exception;
+    /// Whether `exception` is set. Allows checking without taking `mutex`
+    std::atomic<bool>                           haveException;
     TimePoint                                   timeLastInsert;
     PeerSetServer&                              peerSetServer;
     Completer<void>                             completer;
+    /// Event-loop multiplexer of peer input. Inactive in thread-per-peer mode
+    PeerMux                                     peerMux;
+    ChunkReqScheduler                           reqScheduler;
+    Thread                                      reqSchedThread;
+    /// Thread on which the heartbeat monitor executes
+    Thread                                      heartbeatThread;
+    /// Maximum number of saved sessions
+    static const size_t                         MAX_SESSIONS = 64;
+    /// Guards `savedSessions`
+    mutable std::mutex                          sessionMutex;
+    /// Backlog cursor of each ended association, keyed by the session token
+    /// its remote peer can present on a reconnection
+    std::unordered_map<uint64_t, ChunkId>       savedSessions;
+    /// Order in which this node asks remote peers to serve its backlog
+    std::atomic<BacklogOrder>                   backlogOrder;
+    /// Aggregate backlog bandwidth-budget shared by all the peers
+    BandwidthBudget                             backlogBudget;
+    /// Aggregate backlog service-rate in bytes per second. 0 => no limit
+    std::atomic<double>                         backlogRate;
+    /// Per-peer backlog service-rate in bytes per second. 0 => no limit
+    std::atomic<double>                         peerBacklogRate;
+    /// Bandwidth-budget for pushing rare chunks
+    BandwidthBudget                             pushBudget;
+    /// Chunk-push rate in bytes per second. 0 -- the default -- disables
+    /// proactive pushing
+    std::atomic<double>                         pushRate;
+    /// The peers recently known -- from their notices -- to have a chunk.
+    /// Consulted, while pushing is enabled, for how rare a chunk is and for
+    /// which peers lack it
+    ChunkId2PeerAddrsMap                        chunkHolders;
+    /// Exports the number of active peers. Deregistered on destruction, so
+    /// it must be declared after the state it samples.
+    Metrics::Gauge                              peerCountGauge;
+    /// Adjusts the maximum number of peers at runtime. Deregistered on
+    /// destruction, so it must be declared after the state it adjusts.
+    Tunables::Handle                            maxPeersTunable;
+    /// Adjusts the aggregate backlog service-rate at runtime
+    Tunables::Handle                            backlogRateTunable;
+    /// Adjusts the per-peer backlog service-rate at runtime
+    Tunables::Handle                            peerBacklogRateTunable;
+    /// Adjusts the chunk-push rate at runtime
+    Tunables::Handle                            pushRateTunable;
+
+    /// Greatest number of known holders at which a chunk is still considered
+    /// rare enough to push
+    static const size_t                         MAX_PUSH_HOLDERS = 2;
+    /// Greatest number of peers a rare chunk is pushed to at once. A modest
+    /// fan-out suffices: each push creates another holder that pushes in
+    /// turn, so dissemination is exponential anyway, and a large fan-out
+    /// from every holder would mostly send duplicates.
+    static const unsigned                       MAX_PUSH_FANOUT = 2;
+
+    /**
+     * Parses a non-negative service-rate.
+     * @param[in] value        Decimal representation of the rate
+     * @return                 Service rate in bytes per second
+     * @throw InvalidArgument  `value` isn't a non-negative number
+     */
+    static double parseRate(const std::string& value)
+    {
+        double rate;
+        try {
+            rate = std::stod(value);
+        }
+        catch (const std::exception& e) {
+            throw INVALID_ARGUMENT("Not a number: \"" + value + "\"");
+        }
+        if (rate < 0)
+            throw INVALID_ARGUMENT("Service rate is negative: " + value);
+        return rate;
+    }
 
     /**
      * Indicates if the set is full.
@@ -513,6 +1546,36 @@ class PeerSet::Impl final : public PeerEntryServer
         return activePeerEntries.size() >= maxPeers;
     }
 
+    /**
+     * Publishes a new snapshot of the active peers for the notify fan-out.
+     * Peer churn is rare (at most once per stasis-duration) relative to the
+     * tens of thousands of notices per second that read the snapshot.
+     * @pre              `mutex` is locked
+     * @exceptionsafety  Strong guarantee
+     */
+    void updatePeerList()
+    {
+        assert(isLocked(mutex));
+        auto newList = std::make_shared<PeerList>();
+        newList->reserve(activePeerEntries.size());
+        for (const auto& elt : activePeerEntries)
+            newList->emplace_back(elt.first, elt.second.second);
+        std::atomic_store(&peerList,
+                std::shared_ptr<const PeerList>{std::move(newList)});
+    }
+
+    /**
+     * Throws the exception set by one of this instance's internal threads if
+     * it exists.
+     */
+    inline void throwIfException()
+    {
+        if (haveException.load(std::memory_order_acquire)) {
+            LockGuard lock{mutex};
+            std::rethrow_exception(exception);
+        }
+    }
+
     /**
      * Unconditionally adds a peer. The peer immediately starts receiving
      * messages from its associated remote peer and is ready to send messages.
@@ -530,7 +1593,8 @@ class PeerSet::Impl final : public PeerEntryServer
             const ChunkId& earliest)
     {
         assert(isLocked(mutex));
-        PeerEntry  entry{peer, *this, maxResideTime};
+        PeerEntry  entry{peer, *this, maxResideTime,
+                peerMux ? &peerMux : nullptr};
         PeerFuture peerFuture{};
         {
             UnlockGuard unlock{mutex};
@@ -541,20 +1605,22 @@ class PeerSet::Impl final : public PeerEntryServer
             activePeerEntries.emplace(peer.getRemoteAddr(),
                     std::pair<PeerFuture, PeerEntry>{peerFuture, entry});
             peerEntries.emplace(peerFuture, entry);
-            timeLastInsert = Clock::now();
+            updatePeerList();
+            timeLastInsert = SimClock::now();
             if (full())
                 resetValues();
         }
         catch (const std::exception& ex) {
             peerEntries.erase(peerFuture);
             activePeerEntries.erase(peer.getRemoteAddr());
+            updatePeerList();
             peerFuture.cancel(true);
         }
     }
 
     /**
-     * Stops the peer with the lowest value in the set of active peers and
-     * removes it from the set.
+     * Stops the peer with the lowest composite performance score in the set
+     * of active peers and removes it from the set.
      * @pre              `activePeerEntries.size() > 0`
      * @exceptionsafety  Basic guarantee
      * @threadsafety     Compatible but not safe
@@ -563,16 +1629,20 @@ class PeerSet::Impl final : public PeerEntryServer
     InetSockAddr stopAndRemoveWorstPeer()
     {
         assert(isLocked(mutex));
-        auto                                     minValue = VALUE_MAX;
+        auto                                     minScore =
+                std::numeric_limits<double>::infinity();
         std::pair<InetSockAddr, ActivePeerEntry> pair;
         for (const auto& elt : activePeerEntries) {
-            auto value = elt.second.second.getValue();
-            if (value < minValue) {
-                minValue = value;
+            const auto score = elt.second.second.getScore();
+            if (score < minScore) {
+                minScore = score;
                 pair = elt;
             }
         }
         activePeerEntries.erase(pair.first);
+        updatePeerList();
+        // The remote peer may reconnect; let it resume its backlog cursor
+        pair.second.second.saveSession();
         auto future = pair.second.first;
         UnlockGuard unlock{mutex};
         future.cancel();
@@ -599,13 +1669,20 @@ class PeerSet::Impl final : public PeerEntryServer
     void peerStopped(Future<void>& future)
     {
         InetSockAddr peerAddr{};
+        double       score = 0;
+        PeerEntry    peerEntry{};
         {
             LockGuard lock{mutex};
             auto      iter = peerEntries.find(future);
             if (iter != peerEntries.end()) {
-                auto peerEntry = iter->second;
+                peerEntry = iter->second;
                 peerAddr = peerEntry.getRemoteAddr();
+                score = peerEntry.getScore();
                 activePeerEntries.erase(peerAddr);
+                updatePeerList();
+                // The remote peer may reconnect; let it resume its backlog
+                // cursor
+                peerEntry.saveSession();
             }
             peerEntries.erase(future);
         }
@@ -626,8 +1703,18 @@ class PeerSet::Impl final : public PeerEntryServer
                 log_warn(ex);
             }
         }
-        if (peerAddr)
-            peerSetServer.peerStopped(peerAddr);
+        if (peerAddr) {
+            HYCAST_PROBE(peer_removed);
+            reqScheduler.peerStopped(peerAddr);
+            peerSetServer.peerStopped(peerAddr, score);
+            /*
+             * The association is over: offer the torn-down peer
+             * implementation to the warm-peer pool for the reconnect that
+             * often follows. Done without `mutex` because the entry's
+             * remaining tasks are canceled and joined here.
+             */
+            peerEntry.recyclePeer();
+        }
     }
 
     /**
@@ -652,6 +1739,159 @@ class PeerSet::Impl final : public PeerEntryServer
     	catch (const std::exception& e) {
     	    LockGuard lock{mutex};
             exception = std::current_exception();
+            haveException.store(true, std::memory_order_release);
+    	}
+    }
+
+    /**
+     * Issues deferred and re-issued chunk-requests from the chunk-request
+     * scheduler to the relevant remote peers. Doesn't return unless an
+     * exception is thrown. Intended to run on its own thread.
+     */
+    void runReqScheduler()
+    {
+    	try {
+            for (;;) {
+                ChunkId      chunkId{};
+                InetSockAddr peerAddr{};
+                reqScheduler.getAssignment(chunkId, peerAddr); // Blocks
+                std::shared_ptr<SendAction> action{
+                        new SendChunkRequest(chunkId)};
+                LockGuard lock{mutex};
+                auto      iter = activePeerEntries.find(peerAddr);
+                if (iter != activePeerEntries.end())
+                    iter->second.second.push(action);
+            }
+    	}
+    	catch (const std::exception& e) {
+    	    LockGuard lock{mutex};
+            exception = std::current_exception();
+            haveException.store(true, std::memory_order_release);
+    	}
+    }
+
+    /**
+     * Stops a remote peer that has missed too many heartbeat deadlines and
+     * removes it from the set of active peers. The peer's future is
+     * canceled; `handleStoppedPeers()` then reaps it, and the ordinary
+     * stopped-peer path -- `reqScheduler.peerStopped()` -- immediately
+     * re-stripes the peer's in-flight chunk-requests across the surviving
+     * peers.
+     * @param[in] peerAddr  Address of the unresponsive remote peer
+     * @param[in] silence   How long nothing has been received from it
+     * @exceptionsafety     Basic guarantee
+     * @threadsafety        Safe
+     */
+    void evictUnresponsivePeer(
+            const InetSockAddr&              peerAddr,
+            const std::chrono::milliseconds& silence)
+    {
+        PeerFuture future{};
+        {
+            LockGuard lock{mutex};
+            auto      iter = activePeerEntries.find(peerAddr);
+            if (iter == activePeerEntries.end())
+                return; // The peer already stopped
+            future = iter->second.first;
+            // The remote peer may recover and reconnect; let it resume its
+            // backlog cursor
+            iter->second.second.saveSession();
+            activePeerEntries.erase(iter);
+            updatePeerList();
+        }
+        static auto& evictions = Metrics::getCounter(
+                "hycast_peers_heartbeat_evictions_total",
+                "Remote peers evicted because nothing was received from "
+                "them within the heartbeat deadline");
+        evictions.add();
+        LOG_NOTE("Evicting remote peer " + peerAddr.to_string() +
+                ": nothing received in " + std::to_string(silence.count()) +
+                " ms");
+        future.cancel();
+    }
+
+    /**
+     * Monitors the liveness of the active peers once per heartbeat
+     * interval: evicts a peer from which nothing has been received for
+     * `MAX_MISSED_HEARTBEATS` intervals and queues a heartbeat to a peer to
+     * which nothing has been sent for an interval -- so the interval is
+     * effectively adaptive: tight on an idle association, while flowing
+     * traffic carries the liveness signal for free. Peers that didn't
+     * negotiate heartbeats are governed by worst-peer replacement alone.
+     * Returns when canceled. Intended to run on its own thread.
+     */
+    void runHeartbeatMonitor()
+    {
+    	try {
+            const std::chrono::milliseconds interval{HEARTBEAT_INTERVAL_MS};
+            /*
+             * Cooperatively canceled: the destructor's `cancel()` notifies
+             * the sleep instead of delivering `pthread_cancel()`, so the
+             * scan needs no cancellation points.
+             */
+            Thread::enableCooperativeCancel();
+            Mutex                   sleepMutex;
+            std::condition_variable sleepCond;
+            Interrupter             interrupter{[&sleepMutex,&sleepCond] {
+                    LockGuard lock{sleepMutex};
+                    sleepCond.notify_one();
+            }};
+            /*
+             * The monitor doubles as the retention re-advertiser: it already
+             * wakes every interval, so eviction-driven movement of the
+             * store's floor is noticed here and re-advertised -- within an
+             * interval -- instead of threading an eviction callback from the
+             * store up through every layer. Only the monitor thread touches
+             * this state.
+             */
+            RetentionMsg lastRetention{};
+            bool         retentionAdvertised{false};
+            while (!Thread::cancelRequested()) {
+                {
+                    const auto deadline = SimClock::now() + interval;
+                    UniqueLock lock{sleepMutex};
+                    while (!Thread::cancelRequested() &&
+                            SimClock::waitUntil(sleepCond, lock, deadline) !=
+                                    std::cv_status::timeout)
+                        ;
+                }
+                if (Thread::cancelRequested())
+                    break;
+                // Lock-free: the same snapshot the notify fan-out uses
+                const auto peers = std::atomic_load(&peerList);
+                for (const auto& elt : *peers) {
+                    const auto& entry = elt.second;
+                    if (!entry.heartbeatsNegotiated())
+                        continue;
+                    const auto silence = entry.getRecvSilence();
+                    if (silence >= interval*MAX_MISSED_HEARTBEATS) {
+                        evictUnresponsivePeer(elt.first, silence);
+                    }
+                    else if (entry.sendIdleFor(interval)) {
+                        entry.push(std::shared_ptr<SendAction>{
+                                new SendHeartbeat{}});
+                    }
+                }
+                RetentionMsg retention{};
+                if (peerSetServer.getRetention(retention) &&
+                        (!retentionAdvertised ||
+                         retention.holdsAnything() !=
+                                 lastRetention.holdsAnything() ||
+                         retention.getOldestProd() !=
+                                 lastRetention.getOldestProd())) {
+                    std::shared_ptr<SendAction> action{
+                            new SendRetention{retention}};
+                    for (const auto& elt : *peers)
+                        elt.second.push(action);
+                    lastRetention = retention;
+                    retentionAdvertised = true;
+                }
+            }
+    	}
+    	catch (const std::exception& e) {
+    	    LockGuard lock{mutex};
+            exception = std::current_exception();
+            haveException.store(true, std::memory_order_release);
     	}
     }
 
@@ -659,20 +1899,23 @@ class PeerSet::Impl final : public PeerEntryServer
      * Notifies all remote peers, except one, about available information on a
      * product.
      * @param[in] prodIndex  Product index
+     * @param[in] prodName   Name of the product or the empty string if unknown
      * @param[in] except     Address of remote peer to exclude
      */
     void notify(
             const ProdIndex&    prodIndex,
+            const std::string&  prodName,
             const InetSockAddr& except)
     {
-        LockGuard lock{mutex};
-    	if (exception)
-            std::rethrow_exception(exception);
-        std::shared_ptr<SendProdNotice> action{new SendProdNotice(prodIndex)};
-        for (const auto& elt : activePeerEntries) {
+        throwIfException();
+        std::shared_ptr<SendAction> action{
+                new SendProdNotice(prodIndex, prodName)};
+        // Lock-free: each peer's send-queue is internally synchronized
+        const auto peers = std::atomic_load(&peerList);
+        for (const auto& elt : *peers) {
             if (elt.first == except)
                 continue;
-            elt.second.second.push(action);
+            elt.second.push(action);
         }
     }
 
@@ -685,14 +1928,63 @@ class PeerSet::Impl final : public PeerEntryServer
             const ChunkId&      id,
             const InetSockAddr& except)
     {
-        LockGuard lock{mutex};
-    	if (exception)
-            std::rethrow_exception(exception);
-        std::shared_ptr<SendChunkNotice> action{new SendChunkNotice(id)};
-        for (const auto& elt : activePeerEntries) {
+        throwIfException();
+        std::shared_ptr<SendAction> action{new SendChunkNotice(id)};
+        // Lock-free: each peer's send-queue is internally synchronized
+        const auto peers = std::atomic_load(&peerList);
+        for (const auto& elt : *peers) {
             if (elt.first == except)
                 continue;
-            elt.second.second.push(action);
+            elt.second.push(action);
+        }
+    }
+
+    /**
+     * Pushes a just-received chunk-of-data, unrequested, to a few remote
+     * peers that haven't announced it -- iff pushing is enabled and the
+     * chunk is rare (few peers are known to have it). A rare chunk is
+     * otherwise served serially from its few holders as requests trickle
+     * in, which is the last-chunk convoy every multicast outage produces.
+     * The receiving side needs no protocol support: an unrequested chunk
+     * arrives like any other and the product-store discards a duplicate.
+     * Pushed bytes are claimed from the push bandwidth-budget; a chunk
+     * that doesn't fit isn't pushed and remains obtainable by the ordinary
+     * notice-and-request exchange.
+     * @param[in] chunkId   Identifier of the just-received data-chunk
+     * @param[in] peerAddr  Address of the remote peer the chunk came from
+     * @exceptionsafety     Basic guarantee
+     * @threadsafety        Safe
+     */
+    void maybePush(
+            const ChunkId&      chunkId,
+            const InetSockAddr& peerAddr)
+    {
+        if (pushRate <= 0)
+            return;
+        if (chunkHolders.count(chunkId) > MAX_PUSH_HOLDERS)
+            return; // Chunk isn't rare
+        ActualChunk chunk{};
+        if (!peerSetServer.get(chunkId, chunk))
+            return;
+        static auto& pushCount = Metrics::getCounter(
+                "hycast_chunks_pushed_total",
+                "Rare data-chunks pushed, unrequested, to remote peers");
+        unsigned   numPushed = 0;
+        const auto peers = std::atomic_load(&peerList);
+        for (const auto& elt : *peers) {
+            if (elt.first == peerAddr ||
+                    chunkHolders.contains(chunkId, elt.first))
+                continue; // Peer has the chunk
+            if (!pushBudget.tryAcquire(pushRate, chunk.getSize()))
+                break; // Budget is exhausted
+            elt.second.push(std::shared_ptr<SendAction>{
+                    new SendChunk(chunk)});
+            // The peer is now a holder: don't re-push and count it toward
+            // the chunk's rarity
+            chunkHolders.add(chunkId, elt.first);
+            pushCount.add();
+            if (++numPushed >= MAX_PUSH_FANOUT)
+                break;
         }
     }
 
@@ -704,36 +1996,138 @@ public:
      * @param[in] stasisDuration  Minimum amount of time that the set must be
      *                            full and unchanged before the worst-performing
      *                            peer may be removed
+     * @param[in] numEventThreads  Number of threads that multiplex input from
+     *                            all the peers or 0, in which case each peer
+     *                            gets a dedicated receiving thread
      * @throws InvalidArgument    `maxPeers == 0 || stasisDuration <= 0`
      */
     Impl(   PeerSetServer& peerSetServer,
             const unsigned maxPeers,
-            const unsigned stasisDuration)
+            const unsigned stasisDuration,
+            const unsigned numEventThreads)
         : mutex{}
         , cond{}
         , activePeerEntries{}
         , peerEntries{}
+        , peerList{new PeerList{}}
         , stasisDuration{stasisDuration}
         , maxResideTime{stasisDuration*2}
         , maxPeers{maxPeers}
         , exception{}
-        , timeLastInsert{Clock::now()}
+        , haveException{false}
+        , timeLastInsert{SimClock::now()}
         /*
          * g++(1) 4.8.5 doesn't support "{}"-based initialization of references;
          * clang(1) does.
          */
         , peerSetServer(peerSetServer)
         , completer{}
+        , peerMux{}
+        , reqScheduler{MAX_OUTSTANDING_REQS, REQUEST_DEADLINE}
+        , reqSchedThread{}
+        , heartbeatThread{}
+        , sessionMutex{}
+        , savedSessions{}
+        , backlogOrder{BacklogOrder::OLDEST_FIRST}
+        , backlogBudget{}
+        , backlogRate{0}
+        , peerBacklogRate{0}
+        , pushBudget{}
+        , pushRate{0}
+        , chunkHolders{}
+        , peerCountGauge{}
+        , maxPeersTunable{}
+        , backlogRateTunable{}
+        , peerBacklogRateTunable{}
+        , pushRateTunable{}
     {
+        static std::atomic<unsigned> numPeerSets{0};
+        const auto setNum = numPeerSets++;
+        peerCountGauge = Metrics::registerGauge(
+                "hycast_active_peers{peerset=\"" +
+                        std::to_string(setNum) + "\"}",
+                "Number of active peers",
+                [this]{
+                    LockGuard lock{mutex};
+                    return static_cast<double>(activePeerEntries.size());
+                });
+        maxPeersTunable = Tunables::registerTunable(
+                "peerset." + std::to_string(setNum) + ".max_peers",
+                "Maximum number of active peers. Shrinking removes the "
+                "worst-performing peers immediately.",
+                [this](const std::string& value) {
+                    unsigned maxPeers;
+                    try {
+                        maxPeers = static_cast<unsigned>(std::stoul(value));
+                    }
+                    catch (const std::exception& e) {
+                        throw INVALID_ARGUMENT("Not an unsigned integer: \"" +
+                                value + "\"");
+                    }
+                    setMaxPeers(maxPeers);
+                    return std::to_string(maxPeers);
+                });
+        backlogRateTunable = Tunables::registerTunable(
+                "peerset." + std::to_string(setNum) + ".backlog_rate",
+                "Aggregate backlog service-rate in bytes per second. "
+                "Backlog chunk-requests beyond the rate aren't served, so "
+                "the requesters fetch history from other peers. 0 disables "
+                "the limit.",
+                [this](const std::string& value) {
+                    const auto rate = parseRate(value);
+                    backlogRate = rate;
+                    return std::to_string(rate);
+                });
+        peerBacklogRateTunable = Tunables::registerTunable(
+                "peerset." + std::to_string(setNum) + ".peer_backlog_rate",
+                "Per-peer backlog service-rate in bytes per second, so no "
+                "single peer's catch-up can consume the whole aggregate "
+                "budget. 0 disables the limit.",
+                [this](const std::string& value) {
+                    const auto rate = parseRate(value);
+                    peerBacklogRate = rate;
+                    return std::to_string(rate);
+                });
+        pushRateTunable = Tunables::registerTunable(
+                "peerset." + std::to_string(setNum) + ".push_rate",
+                "Rate, in bytes per second, at which rare data-chunks may "
+                "be pushed to remote peers that haven't announced them. 0 "
+                "-- the default -- disables proactive pushing.",
+                [this](const std::string& value) {
+                    const auto rate = parseRate(value);
+                    pushRate = rate;
+                    return std::to_string(rate);
+                });
         if (maxPeers == 0)
             throw INVALID_ARGUMENT("Maximum number of peers can't be zero");
+        if (numEventThreads)
+            peerMux = PeerMux{numEventThreads};
+        // Deferred requests of equal priority complete nearly-finished
+        // products first
+        reqScheduler.setCompletenessFn(
+                [this](const ProdIndex& prodIndex) {
+                    return this->peerSetServer.getCompleteness(prodIndex);
+                });
+        reqSchedThread = Thread{&Impl::runReqScheduler, this};
+        heartbeatThread = Thread{&Impl::runHeartbeatMonitor, this};
     }
 
     /**
      * Destroys. Cancels all threads and joins them. It is unspecified if peers
      * stopped as a result of this call still report.
      */
-    ~Impl() =default;
+    ~Impl()
+    {
+    	try {
+            heartbeatThread.cancel();
+            heartbeatThread.join();
+            reqSchedThread.cancel();
+            reqSchedThread.join();
+    	}
+    	catch (const std::exception& e) {
+            log_error(e); // Because a destructor shouldn't throw an exception
+    	}
+    }
 
     /// Prevents copy and move construction and assignment
     Impl(const Impl& that) =delete;
@@ -750,10 +2144,10 @@ public:
             if (exception)
                 std::rethrow_exception(exception);
             for (auto timeNextAttempt = timeLastInsert + stasisDuration;
-                    full() && Clock::now() < timeNextAttempt;
+                    full() && SimClock::now() < timeNextAttempt;
                     timeNextAttempt = timeLastInsert + stasisDuration) {
                 Canceler canceler{};
-                cond.wait_until(lock, timeNextAttempt);
+                SimClock::waitUntil(cond, lock, timeNextAttempt);
             }
             if (activePeerEntries.find(peer.getRemoteAddr()) !=
                     activePeerEntries.end()) {
@@ -764,6 +2158,7 @@ public:
                     peerAddr = stopAndRemoveWorstPeer();
                 auto earliest = peerSetServer.getEarliestMissingChunkId();
                 add(peer, earliest);
+                HYCAST_PROBE(peer_added);
                 inserted = true;
             }
         } // `mutex` locked
@@ -774,6 +2169,25 @@ public:
         return inserted;
     }
 
+    /**
+     * Sets the maximum number of active peers. If the set holds more peers
+     * than the new maximum, then the worst-performing peers are stopped and
+     * removed until it doesn't.
+     * @param[in] maxPeers     New maximum number of active peers
+     * @throw InvalidArgument  `maxPeers == 0`
+     * @exceptionsafety        Basic guarantee
+     * @threadsafety           Safe
+     */
+    void setMaxPeers(const unsigned maxPeers)
+    {
+        if (maxPeers == 0)
+            throw INVALID_ARGUMENT("Maximum number of peers can't be zero");
+        LockGuard lock{mutex};
+        this->maxPeers = maxPeers;
+        while (activePeerEntries.size() > maxPeers)
+            stopAndRemoveWorstPeer();
+    }
+
     bool contains(const InetSockAddr& peerAddr) const
     {
         LockGuard lock{mutex};
@@ -782,12 +2196,15 @@ public:
         return activePeerEntries.find(peerAddr) != activePeerEntries.end();
     }
 
-    void notify(const ProdIndex& prodIndex)
+    void notify(
+            const ProdIndex&   prodIndex,
+            const std::string& prodName = std::string{})
     {
         LockGuard lock{mutex};
     	if (exception)
             std::rethrow_exception(exception);
-        std::shared_ptr<SendProdNotice> action{new SendProdNotice(prodIndex)};
+        std::shared_ptr<SendAction> action{
+                new SendProdNotice(prodIndex, prodName)};
         for (const auto& elt : activePeerEntries)
             elt.second.second.push(action);
     }
@@ -797,7 +2214,126 @@ public:
         LockGuard lock{mutex};
     	if (exception)
             std::rethrow_exception(exception);
-        std::shared_ptr<SendChunkNotice> action{new SendChunkNotice(id)};
+        std::shared_ptr<SendAction> action{new SendChunkNotice(id)};
+        for (const auto& elt : activePeerEntries)
+            elt.second.second.push(action);
+    }
+
+    void notify(const ChunkRange& chunkRange)
+    {
+        LockGuard lock{mutex};
+    	if (exception)
+            std::rethrow_exception(exception);
+        std::shared_ptr<SendAction> action{
+                new SendChunkRangeNotice(chunkRange)};
+        for (const auto& elt : activePeerEntries)
+            elt.second.second.push(action);
+    }
+
+    void notify(const ChunkRangeSet& rangeSet)
+    {
+        LockGuard lock{mutex};
+    	if (exception)
+            std::rethrow_exception(exception);
+        std::shared_ptr<SendAction> action{
+                new SendChunkRangeSetNotice(rangeSet)};
+        for (const auto& elt : activePeerEntries)
+            elt.second.second.push(action);
+    }
+
+    /**
+     * Cancels any outstanding peer-to-peer request for a chunk -- e.g.,
+     * because the chunk arrived via multicast. The chunk's entry in the
+     * chunk-request scheduler is deleted and, if the request was assigned to
+     * a remote peer, a best-effort cancellation message is queued to that
+     * peer so it can drop its reply if the reply hasn't been transmitted.
+     * @param[in] chunkId  Identifier of the unwanted data-chunk
+     */
+    void cancel(const ChunkId& chunkId)
+    {
+        const auto assignee = reqScheduler.cancelled(chunkId);
+        if (!assignee)
+            return;
+        std::shared_ptr<SendAction> action{new SendChunkCancel(chunkId)};
+        LockGuard lock{mutex};
+    	if (exception)
+            std::rethrow_exception(exception);
+        auto iter = activePeerEntries.find(assignee);
+        if (iter != activePeerEntries.end())
+            iter->second.second.push(action);
+    }
+
+    /**
+     * Requests the repair of chunks-of-data that another transport lost --
+     * e.g., chunks that a gap in the multicast datagram sequence numbers
+     * shows will never arrive. Each chunk that's still needed is assigned to
+     * an active peer by the chunk-request scheduler -- the remaining peers
+     * are recorded as candidates -- and the request is queued to the
+     * assignee immediately. Unlike a notice-driven request, no peer has
+     * announced the chunk: a peer that doesn't have it simply doesn't reply
+     * and the scheduler re-issues the request to an alternative candidate at
+     * the deadline.
+     * @param[in] rangeSet  Identifiers of the missing chunks, as ranges
+     */
+    void repair(const ChunkRangeSet& rangeSet)
+    {
+        for (const auto& chunkRange : rangeSet) {
+            const auto prodIndex = chunkRange.getFirst().getProdIndex();
+            // The priority class arrives in the product-information, if it has
+            ProdInfo   prodInfo{};
+            const auto priority = peerSetServer.get(prodIndex, prodInfo)
+                    ? prodInfo.getPriority()
+                    : ProdInfo::defaultPriority;
+            if (prodInfo && prodInfo.isExpired())
+                continue; // Time-to-live elapsed: the product is worthless
+            const ChunkIndex::type numChunks = chunkRange.getNumChunks();
+            for (ChunkIndex::type i = 0; i < numChunks; ++i) {
+                const auto chunkId = chunkRange.getChunkId(i);
+                if (!peerSetServer.shouldRequest(chunkId))
+                    continue; // Chunk arrived or was already requested
+                LockGuard lock{mutex};
+                if (exception)
+                    std::rethrow_exception(exception);
+                for (auto& elt : activePeerEntries) {
+                    /*
+                     * A peer whose advertised retention range excludes the
+                     * product evicted it: a request would be a wasted round
+                     * trip. A chunk that no active peer retains is left to
+                     * the bandwidth-budgeted backlog service instead.
+                     */
+                    if (!elt.second.second.mayHave(chunkId.getProdIndex()))
+                        continue;
+                    if (reqScheduler.tryAssign(chunkId, elt.first, priority)) {
+                        std::shared_ptr<SendAction> action{
+                                new SendChunkRequest(chunkId)};
+                        elt.second.second.push(action);
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * Enables or disables backpressure on the chunk-request scheduler.
+     * @param[in] enable  Whether to withhold new chunk-requests
+     * @see `ChunkReqScheduler::setBackpressure()`
+     */
+    void setBackpressure(const bool enable)
+    {
+        reqScheduler.setBackpressure(enable);
+    }
+
+    /**
+     * Sends a product filter to all remote peers, which then stop sending
+     * notices for products whose names the filter excludes.
+     * @param[in] filter  Product filter
+     */
+    void sendFilter(const ProdFilter& filter)
+    {
+        LockGuard lock{mutex};
+    	if (exception)
+            std::rethrow_exception(exception);
+        std::shared_ptr<SendAction> action{new SendFilter(filter)};
         for (const auto& elt : activePeerEntries)
             elt.second.second.push(action);
     }
@@ -839,11 +2375,120 @@ public:
         return size() >= maxPeers;
     }
 
+    double getWorstScore() const
+    {
+        LockGuard lock{mutex};
+    	if (exception)
+            std::rethrow_exception(exception);
+        if (activePeerEntries.size() < maxPeers)
+            // There's room: any candidate beats no peer at all
+            return -std::numeric_limits<double>::infinity();
+        auto minScore = std::numeric_limits<double>::infinity();
+        for (const auto& elt : activePeerEntries) {
+            const auto score = elt.second.second.getScore();
+            if (score < minScore)
+                minScore = score;
+        }
+        return minScore;
+    }
+
     Backlogger getBacklogger(const ChunkId& chunkId, Peer& peer)
     {
         return peerSetServer.getBacklogger(chunkId, peer);
     }
 
+    void saveSession(
+            const uint64_t token,
+            const ChunkId& backlogCursor)
+    {
+        if (!token || !backlogCursor)
+            return;
+        LockGuard lock{sessionMutex};
+        /*
+         * NB: The cache is advisory, so it's cleared when it hits the cap.
+         * Losing an entry merely re-announces a backlog.
+         */
+        if (savedSessions.size() >= MAX_SESSIONS)
+            savedSessions.clear();
+        savedSessions[token] = backlogCursor;
+    }
+
+    ChunkId restoreSession(const uint64_t token)
+    {
+        LockGuard lock{sessionMutex};
+        auto      iter = savedSessions.find(token);
+        if (iter == savedSessions.end())
+            return ChunkId{};
+        auto cursor = iter->second;
+        savedSessions.erase(iter);
+        return cursor;
+    }
+
+    /**
+     * Sets the order in which remote peers will be asked to serve this
+     * node's backlog. Affects subsequently-added peers; backlogs already
+     * being received are unaffected.
+     * @param[in] order  Order in which the backlog should be served
+     */
+    void setBacklogOrder(const BacklogOrder order) noexcept
+    {
+        backlogOrder = order;
+    }
+
+    BacklogOrder getBacklogOrder() const noexcept
+    {
+        return backlogOrder;
+    }
+
+    /**
+     * Sets the backlog bandwidth-budget: caps on the aggregate and per-peer
+     * rates at which backlog data-chunks are served to remote peers.
+     * @param[in] aggRate      Aggregate backlog service-rate in bytes per
+     *                         second or 0 for no limit
+     * @param[in] perPeerRate  Per-peer backlog service-rate in bytes per
+     *                         second or 0 for no limit
+     * @throw InvalidArgument  A rate is negative
+     */
+    void setBacklogBudget(
+            const double aggRate,
+            const double perPeerRate)
+    {
+        if (aggRate < 0 || perPeerRate < 0)
+            throw INVALID_ARGUMENT("Backlog service-rate is negative");
+        backlogRate = aggRate;
+        peerBacklogRate = perPeerRate;
+    }
+
+    /**
+     * Sets the bandwidth-budget for pushing rare chunks: the rate at which
+     * a chunk that few peers have may be sent, unrequested, to peers that
+     * haven't announced it. A nonzero rate enables proactive pushing.
+     * @param[in] rate         Push rate in bytes per second or 0 -- the
+     *                         default -- to disable pushing
+     * @throw InvalidArgument  The rate is negative
+     */
+    void setPushBudget(const double rate)
+    {
+        if (rate < 0)
+            throw INVALID_ARGUMENT("Push rate is negative");
+        pushRate = rate;
+    }
+
+    double getPeerBacklogRate() const noexcept
+    {
+        return peerBacklogRate;
+    }
+
+    bool acquireBacklogBandwidth(const size_t nbytes)
+    {
+        return backlogBudget.tryAcquire(backlogRate, nbytes);
+    }
+
+    bool getRetention(RetentionMsg& retention)
+    {
+        return peerSetServer.getRetention(retention);
+    }
+
     bool shouldRequest(const ProdIndex& prodIndex)
     {
         return peerSetServer.shouldRequest(prodIndex);
@@ -854,6 +2499,30 @@ public:
         return peerSetServer.shouldRequest(chunkId);
     }
 
+    bool shouldRequest(
+            const ChunkId&      chunkId,
+            const InetSockAddr& peerAddr)
+    {
+        // The notice reveals a holder of the chunk; remember it for the
+        // rare-chunk pusher
+        if (pushRate > 0)
+            chunkHolders.add(chunkId, peerAddr);
+        // The priority class arrives in the product-information, if it has
+        ProdInfo   prodInfo{};
+        const auto priority = peerSetServer.get(chunkId.getProdIndex(),
+                prodInfo)
+                ? prodInfo.getPriority()
+                : ProdInfo::defaultPriority;
+        if (prodInfo && prodInfo.isExpired())
+            return false; // Time-to-live elapsed: the product is worthless
+        if (!reqScheduler.tryAssign(chunkId, peerAddr, priority))
+            return false; // Assigned to another peer or window is full
+        if (peerSetServer.shouldRequest(chunkId))
+            return true;
+        reqScheduler.received(chunkId); // Chunk isn't actually needed
+        return false;
+    }
+
     bool get(const ProdIndex& prodIndex, ProdInfo& prodInfo)
     {
         return peerSetServer.get(prodIndex, prodInfo);
@@ -868,24 +2537,103 @@ public:
     {
         auto status = peerSetServer.receive(info, peerAddr);
         if (status.isNew())
-            notify(info.getIndex(), peerAddr);
+            notify(info.getIndex(), info.getName(), peerAddr);
         return status;
     }
 
+    /**
+     * Samples the kernel's transport metrics for a remote peer's association
+     * and feeds them into the peer's performance score and the chunk-request
+     * scheduler's request-window for the peer: a collapsed congestion window
+     * reroutes chunk-requests seconds before the throughput metric would
+     * decay. Failure is ignored because the metrics are advisory -- scoring
+     * then falls back on application-level symptoms.
+     * @param[in] peerAddr  Address of remote peer
+     */
+    void sampleTransport(const InetSockAddr& peerAddr)
+    {
+        try {
+            SctpSock::Status status;
+            {
+                LockGuard lock{mutex};
+                auto      iter = activePeerEntries.find(peerAddr);
+                if (iter == activePeerEntries.end())
+                    return;
+                status = iter->second.second.getPeer().getTransportStatus();
+                iter->second.second.transportSampled(status);
+            }
+            reqScheduler.setWindow(peerAddr, status.cwndBytes /
+                    static_cast<unsigned>(ChunkSize::defaultSize) + 1);
+        }
+        catch (const std::exception& ex) {
+        }
+    }
+
     RecvStatus receive(LatentChunk& chunk, const InetSockAddr& peerAddr)
     {
         auto status = peerSetServer.receive(chunk, peerAddr);
-        if (status.isNew())
+        reqScheduler.received(chunk.getId());
+        sampleTransport(peerAddr);
+        if (status.isNew()) {
             notify(chunk.getId(), peerAddr);
+            // A chunk that had to come peer-to-peer is a candidate for
+            // rare-chunk pushing
+            maybePush(chunk.getId(), peerAddr);
+        }
+        return status;
+    }
+
+    RecvStatus receive(
+            LatentSmallProd&    smallProd,
+            const InetSockAddr& peerAddr)
+    {
+        const auto prodInfo = smallProd.getInfo();
+        const auto chunkId = ChunkInfo{prodInfo, 0}.getId();
+        auto       status = peerSetServer.receive(smallProd, peerAddr);
+        reqScheduler.received(chunkId);
+        sampleTransport(peerAddr);
+        if (status.isNew()) {
+            notify(prodInfo.getIndex(), prodInfo.getName(), peerAddr);
+            notify(chunkId, peerAddr);
+            // A chunk that had to come peer-to-peer is a candidate for
+            // rare-chunk pushing
+            maybePush(chunkId, peerAddr);
+        }
         return status;
     }
+
+    void receive(
+            LatentChunk* const  chunks,
+            const size_t        numChunks,
+            RecvStatus* const   statuses,
+            const InetSockAddr& peerAddr)
+    {
+        peerSetServer.receive(chunks, numChunks, statuses, peerAddr);
+        for (size_t i = 0; i < numChunks; ++i) {
+            reqScheduler.received(chunks[i].getId());
+            if (statuses[i].isNew()) {
+                notify(chunks[i].getId(), peerAddr);
+                maybePush(chunks[i].getId(), peerAddr);
+            }
+        }
+        sampleTransport(peerAddr); // Once per batch suffices
+    }
+
+    void receive(
+            const PeerGossip&   gossip,
+            const InetSockAddr& peerAddr)
+    {
+        peerSetServer.receive(gossip, peerAddr);
+    }
 }; // `PeerSet::Impl`
 
 PeerSet::PeerSet(
         PeerSetServer& peerSetServer,
         const unsigned maxPeers,
-        const unsigned stasisDuration)
-    : pImpl(new Impl(peerSetServer, maxPeers, stasisDuration))
+        const unsigned stasisDuration,
+        const unsigned numEventThreads)
+    : pImpl(new Impl(peerSetServer, maxPeers, stasisDuration,
+            numEventThreads))
 {}
 
 bool PeerSet::tryInsert(Peer& peer) const
@@ -903,11 +2651,70 @@ void PeerSet::notify(const ProdIndex& prodIndex) const
     pImpl->notify(prodIndex);
 }
 
+void PeerSet::notify(
+        const ProdIndex&   prodIndex,
+        const std::string& prodName) const
+{
+    pImpl->notify(prodIndex, prodName);
+}
+
 void PeerSet::notify(const ChunkId& chunkId) const
 {
     pImpl->notify(chunkId);
 }
 
+void PeerSet::notify(const ChunkRange& chunkRange) const
+{
+    pImpl->notify(chunkRange);
+}
+
+void PeerSet::notify(const ChunkRangeSet& rangeSet) const
+{
+    pImpl->notify(rangeSet);
+}
+
+void PeerSet::cancel(const ChunkId& chunkId) const
+{
+    pImpl->cancel(chunkId);
+}
+
+void PeerSet::repair(const ChunkRangeSet& rangeSet) const
+{
+    pImpl->repair(rangeSet);
+}
+
+void PeerSet::setBackpressure(const bool enable) const
+{
+    pImpl->setBackpressure(enable);
+}
+
+void PeerSet::sendFilter(const ProdFilter& filter) const
+{
+    pImpl->sendFilter(filter);
+}
+
+void PeerSet::setMaxPeers(const unsigned maxPeers) const
+{
+    pImpl->setMaxPeers(maxPeers);
+}
+
+void PeerSet::setBacklogBudget(
+        const double aggRate,
+        const double perPeerRate) const
+{
+    pImpl->setBacklogBudget(aggRate, perPeerRate);
+}
+
+void PeerSet::setPushBudget(const double rate) const
+{
+    pImpl->setPushBudget(rate);
+}
+
+void PeerSet::setBacklogOrder(const BacklogOrder order) const noexcept
+{
+    pImpl->setBacklogOrder(order);
+}
+
 void PeerSet::incValue(Peer& peer) const
 {
     pImpl->incValue(peer);
@@ -928,4 +2735,9 @@ bool PeerSet::isFull() const
     return pImpl->isFull();
 }
 
+double PeerSet::getWorstScore() const
+{
+    return pImpl->getWorstScore();
+}
+
 } // namespace
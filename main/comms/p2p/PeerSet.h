@@ -16,6 +16,7 @@
 #include "Notifier.h"
 #include "Peer.h"
 #include "PeerSetServer.h"
+#include "ProdFilter.h"
 
 #include <chrono>
 #include <functional>
@@ -57,11 +58,18 @@ public:
      *                            set must be full and unchanged before the
      *                            worst-performing peer may be removed. Default
      *                            is `PeerSet::defaultStasisDuration`.
+     * @param[in] numEventThreads  Number of threads that multiplex input from
+     *                            all the peers or 0 -- the default -- in which
+     *                            case each peer gets a dedicated receiving
+     *                            thread. A few event threads suffice for a
+     *                            large set of peers because a peer's socket
+     *                            rarely has input pending.
      * @throws InvalidArgument    `maxPeers == 0 || stasisDuration <= 0`
      */
     PeerSet(PeerSetServer& peerSetServer,
             unsigned       maxPeers = defaultMaxPeers,
-            const unsigned stasisDuration = defaultStasisDuration);
+            const unsigned stasisDuration = defaultStasisDuration,
+            const unsigned numEventThreads = 0);
 
     /**
      * Tries to insert a peer. The attempt will fail if the peer is already a
@@ -97,6 +105,22 @@ public:
      */
     void notify(const ProdIndex& prodIndex) const;
 
+    /**
+     * Notifies all remote peers about available information on a product,
+     * identifying the product by name. A peer whose remote side advertised a
+     * product filter that excludes the name suppresses the notice and the
+     * product's subsequent chunk notices.
+     * @param[in] prodIndex       Product index
+     * @param[in] prodName        Name of the product or the empty string if
+     *                            unknown, in which case every peer is notified
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void notify(
+            const ProdIndex&   prodIndex,
+            const std::string& prodName) const;
+
     /**
      * Notifies all remote peers about an available chunk-of-data.
      * @param[in] chunkId         Chunk-ID
@@ -106,6 +130,146 @@ public:
      */
     void notify(const ChunkId& chunkId) const;
 
+    /**
+     * Notifies all remote peers about a contiguous range of available
+     * chunks-of-data. Each peer is sent one coalesced notice instead of a
+     * notice per chunk.
+     * @param[in] chunkRange      Range of chunk identifiers
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void notify(const ChunkRange& chunkRange) const;
+
+    /**
+     * Notifies all remote peers about a set of available chunks-of-data
+     * encoded as contiguous ranges. Each peer is sent one coalesced notice
+     * instead of a notice per chunk or per range.
+     * @param[in] rangeSet        Set of chunk-ranges
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void notify(const ChunkRangeSet& rangeSet) const;
+
+    /**
+     * Cancels any outstanding peer-to-peer request for a chunk -- e.g.,
+     * because the chunk arrived via multicast. If the request was assigned to
+     * a remote peer, then a best-effort cancellation message is sent to that
+     * peer so it can drop its reply if the reply hasn't been transmitted.
+     * @param[in] chunkId         Identifier of the unwanted data-chunk
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Safe
+     */
+    void cancel(const ChunkId& chunkId) const;
+
+    /**
+     * Requests the repair of chunks-of-data that another transport lost --
+     * e.g., chunks that a gap in the multicast datagram sequence numbers
+     * shows will never arrive. Each chunk that's still needed is immediately
+     * assigned to an active peer without waiting for the chunk to be
+     * announced; a peer that doesn't have the chunk simply doesn't reply and
+     * the request is re-issued to an alternative peer at the deadline.
+     * @param[in] rangeSet        Identifiers of the missing chunks, as ranges
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Safe
+     */
+    void repair(const ChunkRangeSet& rangeSet) const;
+
+    /**
+     * Enables or disables backpressure on the chunk-request scheduler --
+     * e.g., because a shared memory-budget reached its ceiling. While
+     * enabled, no new chunk-request is assigned to a remote peer; overdue
+     * requests are still re-issued so in-flight chunks complete.
+     * @param[in] enable  Whether to withhold new chunk-requests
+     * @exceptionsafety   Strong guarantee
+     * @threadsafety      Safe
+     */
+    void setBackpressure(const bool enable) const;
+
+    /**
+     * Sets the order in which remote peers will be asked to serve this
+     * node's backlog. Under `BacklogOrder::RECENT_FIRST` a window of the
+     * most recent products arrives first and the historical fill-in
+     * follows, so a node recovering from a long outage sees current data
+     * within seconds instead of after the whole backlog. Affects
+     * subsequently-added peers; backlogs already being received are
+     * unaffected.
+     * @param[in] order   Order in which the backlog should be served
+     * @exceptionsafety   Nothrow
+     * @threadsafety      Safe
+     */
+    void setBacklogOrder(const BacklogOrder order) const noexcept;
+
+    /**
+     * Sends a product filter to all remote peers, which then stop sending
+     * notices -- including backlog notices -- for products whose names the
+     * filter excludes. An empty filter re-enables all notices.
+     * @param[in] filter          Product filter
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety           Basic
+     * @threadsafety              Compatible but not safe
+     */
+    void sendFilter(const ProdFilter& filter) const;
+
+    /**
+     * Sets the maximum number of active peers. If the set holds more peers
+     * than the new maximum, then the worst-performing peers are stopped and
+     * removed until it doesn't. Also adjustable at runtime via the tunable
+     * `peerset.<n>.max_peers`.
+     * @param[in] maxPeers     New maximum number of active peers
+     * @throw InvalidArgument  `maxPeers == 0`
+     * @exceptionsafety        Basic guarantee
+     * @threadsafety           Safe
+     */
+    void setMaxPeers(const unsigned maxPeers) const;
+
+    /**
+     * Sets the backlog bandwidth-budget: caps on the aggregate and per-peer
+     * rates at which backlog data-chunks are served to remote peers. This
+     * node may be the only one that has the entire history -- on the source
+     * node it always is -- so unbudgeted backlog service can saturate the
+     * uplink and degrade the live transmission path, which must come first.
+     * A backlog chunk-request beyond the budget isn't served: it times out
+     * at the requester, which retries another peer, so history spreads
+     * peer-to-peer instead. By default service is unbudgeted. Also
+     * adjustable at runtime via the tunables `peerset.<n>.backlog_rate` and
+     * `peerset.<n>.peer_backlog_rate`.
+     * @param[in] aggRate      Aggregate backlog service-rate in bytes per
+     *                         second or 0 for no limit
+     * @param[in] perPeerRate  Per-peer backlog service-rate in bytes per
+     *                         second or 0 for no limit
+     * @throw InvalidArgument  A rate is negative
+     * @exceptionsafety        Strong guarantee
+     * @threadsafety           Safe
+     */
+    void setBacklogBudget(
+            const double aggRate,
+            const double perPeerRate) const;
+
+    /**
+     * Sets the bandwidth-budget for proactively pushing rare chunks -- and
+     * thereby enables pushing, which is off by default. The P2P exchange is
+     * otherwise strictly pull (notice, request, deliver), so a chunk that
+     * most of the swarm is missing -- typical after a multicast outage --
+     * is served serially from its few holders as requests trickle in. With
+     * pushing enabled, a peer that receives a chunk announced by few others
+     * sends it, unrequested and within the budget, to a couple of peers
+     * that haven't announced it; each recipient becomes another holder that
+     * pushes in turn, so the chunk spreads exponentially instead. The
+     * receiving side needs no protocol support: an unrequested chunk
+     * arrives like any other and a duplicate is discarded. Also adjustable
+     * at runtime via the tunable `peerset.<n>.push_rate`.
+     * @param[in] rate         Push rate in bytes per second or 0 -- the
+     *                         default -- to disable pushing
+     * @throw InvalidArgument  The rate is negative
+     * @exceptionsafety        Strong guarantee
+     * @threadsafety           Safe
+     */
+    void setPushBudget(const double rate) const;
+
     /**
      * Increments the value of a peer.
      * @param[in] peer  Peer to have its value incremented
@@ -130,6 +294,17 @@ public:
      * @threadsafety    Safe
      */
     bool isFull() const;
+
+    /**
+     * Returns the composite performance score of the worst-performing peer in
+     * the set -- the score a candidate must beat in order for replacement to
+     * be an upgrade.
+     * @return           Lowest composite performance score among the active
+     *                   peers or negative infinity if the set isn't full
+     * @exceptionsafety  Strong guarantee
+     * @threadsafety     Safe
+     */
+    double getWorstScore() const;
 };
 
 } // namespace
@@ -14,6 +14,7 @@
 #define PEERSETSERVER_H_
 
 #include "P2pMgrServer.h"
+#include "PeerGossip.h"
 
 namespace hycast {
 
@@ -22,11 +23,39 @@ class PeerSetServer : public P2pMgrServer
 public:
     virtual ~PeerSetServer() =default;
 
+    using P2pContentRcvr::receive;
+
     /**
      * Handles a peer that stopped (for whatever reason).
      * @param[in] peerAddr  Address of the remote peer
      */
     virtual void peerStopped(const InetSockAddr& peerAddr) =0;
+
+    /**
+     * Handles a peer that stopped (for whatever reason). The default
+     * implementation discards the score and calls
+     * `peerStopped(const InetSockAddr&)`.
+     * @param[in] peerAddr  Address of the remote peer
+     * @param[in] score     Composite performance score of the peer at the time
+     *                      it stopped. Higher is better.
+     */
+    virtual void peerStopped(
+            const InetSockAddr& peerAddr,
+            const double        score)
+    {
+        peerStopped(peerAddr);
+    }
+
+    /**
+     * Accepts a gossip message from a remote peer. The default implementation
+     * ignores it.
+     * @param[in] gossip    Gossip message
+     * @param[in] peerAddr  Address of remote peer that sent the message
+     */
+    virtual void receive(
+            const PeerGossip&   gossip,
+            const InetSockAddr& peerAddr)
+    {}
 };
 
 } // namespace
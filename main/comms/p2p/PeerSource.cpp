@@ -72,4 +72,18 @@ bool PeerSource::empty() const noexcept
     return pImpl->empty();
 }
 
+void PeerSource::learn(
+        const InetSockAddr& peerAddr,
+        const double        score,
+        const unsigned      delay)
+{
+    push(peerAddr, delay);
+}
+
+std::vector<std::pair<InetSockAddr, double>> PeerSource::getBest(
+        const size_t n) const
+{
+    return std::vector<std::pair<InetSockAddr, double>>{};
+}
+
 } // namespace
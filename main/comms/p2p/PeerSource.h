@@ -16,6 +16,8 @@
 #include "InetSockAddr.h"
 
 #include <chrono>
+#include <utility>
+#include <vector>
 
 namespace hycast {
 
@@ -62,6 +64,34 @@ public:
      * @threadsafety    Safe
      */
     bool empty() const noexcept;
+
+    /**
+     * Accepts an observation of a potential peer's performance (e.g., from a
+     * gossip message or a stopped peer). The default implementation discards
+     * the score and adds the peer to the set of potential peers.
+     * @param[in] peerAddr  Internet socket address of the peer's server
+     * @param[in] score     Observed performance score. Higher is better.
+     * @param[in] delay     The delay, in seconds, for the potential peer before
+     *                      it becomes available
+     * @exceptionsafety     Strong guarantee
+     * @threadsafety        Safe
+     */
+    virtual void learn(
+            const InetSockAddr& peerAddr,
+            const double        score,
+            const unsigned      delay = 0);
+
+    /**
+     * Returns the highest-scored known peers. The default implementation
+     * returns an empty container because this source doesn't track
+     * performance.
+     * @param[in] n      Maximum number of peers to return
+     * @return           Peer addresses and their scores, best first
+     * @exceptionsafety  Strong guarantee
+     * @threadsafety     Safe
+     */
+    virtual std::vector<std::pair<InetSockAddr, double>> getBest(
+            const size_t n) const;
 };
 
 class NilPeerSource final : public PeerSource
@@ -0,0 +1,47 @@
+/**
+ * This file implements a retention-range advertisement exchanged between
+ * peers.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: RetentionMsg.cpp
+ * @author: Steven R. Emmerson
+ */
+
+#include "RetentionMsg.h"
+
+namespace hycast {
+
+size_t RetentionMsg::getSerialSize(unsigned version) const noexcept
+{
+    return getStaticSerialSize(version);
+}
+
+size_t RetentionMsg::serialize(
+        Encoder&       encoder,
+        const unsigned version) const
+{
+    size_t nbytes = encoder.encode(holdsData);
+    nbytes += encoder.encode(oldestProd);
+    nbytes += encoder.encode(oldestTime);
+    return nbytes;
+}
+
+RetentionMsg RetentionMsg::deserialize(
+        Decoder&        decoder,
+        const unsigned  version)
+{
+    uint32_t        holdsData;
+    ProdIndex::type oldestProd;
+    uint64_t        oldestTime;
+    decoder.decode(holdsData);
+    decoder.decode(oldestProd);
+    decoder.decode(oldestTime);
+    return holdsData
+            ? RetentionMsg{ProdIndex{oldestProd}, oldestTime}
+            : RetentionMsg{};
+}
+
+} // namespace
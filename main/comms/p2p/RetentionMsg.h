@@ -0,0 +1,139 @@
+/**
+ * This file declares a retention-range advertisement exchanged between peers.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: RetentionMsg.h
+ * @author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_COMMS_P2P_RETENTIONMSG_H_
+#define MAIN_COMMS_P2P_RETENTIONMSG_H_
+
+#include "Codec.h"
+#include "ProdIndex.h"
+#include "Serializable.h"
+
+namespace hycast {
+
+/**
+ * Retention range advertised by a peer: the oldest data-product its store
+ * still holds, so the remote peer doesn't waste request round trips asking
+ * for data this peer evicted long ago. The advertisement is absolute --
+ * each one replaces the previous one -- so the two sides can't drift
+ * apart. Sent at connection setup and whenever eviction moves the oldest
+ * resident product; exchanged only when both peers advertise
+ * `VersionMsg::RETENTION`.
+ */
+class RetentionMsg final : public Serializable<RetentionMsg>
+{
+    /// Index of the oldest resident product. Meaningless if `holdsData` is 0.
+    ProdIndex::type oldestProd;
+    /// Origin timestamp of the oldest resident product in microseconds since
+    /// the Unix epoch or 0 if unknown. Meaningless if `holdsData` is 0.
+    uint64_t        oldestTime;
+    /// Whether the sending peer's store holds anything at all. 0 iff the
+    /// store is empty.
+    uint32_t        holdsData;
+
+public:
+    /**
+     * Default constructs: the sending peer's store holds nothing.
+     */
+    RetentionMsg()
+        : oldestProd{0}
+        , oldestTime{0}
+        , holdsData{0}
+    {}
+
+    /**
+     * Constructs.
+     * @param[in] oldestProd  Index of the oldest product the sending peer's
+     *                        store still holds
+     * @param[in] oldestTime  Origin timestamp of that product in microseconds
+     *                        since the Unix epoch or 0 if unknown
+     */
+    RetentionMsg(
+            const ProdIndex& oldestProd,
+            const uint64_t   oldestTime)
+        : oldestProd{oldestProd}
+        , oldestTime{oldestTime}
+        , holdsData{1}
+    {}
+
+    /**
+     * Indicates if the sending peer's store holds anything at all.
+     * @retval `true`   The store holds at least one product
+     * @retval `false`  The store is empty
+     */
+    bool holdsAnything() const noexcept
+    {
+        return holdsData != 0;
+    }
+
+    /**
+     * Returns the index of the oldest product the sending peer's store still
+     * holds. Meaningless unless `holdsAnything()`.
+     * @return Index of the oldest resident product
+     */
+    ProdIndex getOldestProd() const noexcept
+    {
+        return ProdIndex{oldestProd};
+    }
+
+    /**
+     * Returns the origin timestamp of the oldest product the sending peer's
+     * store still holds. Meaningless unless `holdsAnything()`.
+     * @return Origin timestamp in microseconds since the Unix epoch or 0 if
+     *         unknown
+     */
+    uint64_t getOldestTime() const noexcept
+    {
+        return oldestTime;
+    }
+
+    /**
+     * Serializes this instance to an encoder.
+     * @param[in] encoder  Encoder
+     * @param[in] version  Protocol version
+     * @return Number of bytes written
+     * @exceptionsafety Basic guarantee
+     * @threadsafety    Safe
+     */
+    size_t serialize(
+            Encoder&       encoder,
+            const unsigned version) const;
+
+    size_t getSerialSize(unsigned version) const noexcept;
+
+    /**
+     * Returns the number of bytes in the serial representation of any
+     * instance.
+     * @param[in] version  Protocol version
+     * @return the number of bytes in the serial representation
+     */
+    static constexpr size_t getStaticSerialSize(const unsigned version)
+            noexcept {
+        return Codec::getSerialSize(sizeof(uint32_t)) +
+                Codec::getSerialSize(sizeof(ProdIndex::type)) +
+                Codec::getSerialSize(sizeof(uint64_t));
+    }
+
+    /**
+     * Returns an instance corresponding to the serialized representation in a
+     * decoder.
+     * @param[in] decoder  Decoder
+     * @param[in] version  Protocol version
+     * @exceptionsafety Basic
+     * @threadsafety    Compatible but not thread-safe
+     */
+    static RetentionMsg deserialize(
+            Decoder&        decoder,
+            const unsigned  version);
+};
+
+} // namespace
+
+#endif /* MAIN_COMMS_P2P_RETENTIONMSG_H_ */
@@ -15,20 +15,30 @@
 
 namespace hycast {
 
-VersionMsg::VersionMsg(unsigned version)
+VersionMsg::VersionMsg(
+        unsigned version,
+        unsigned capabilities,
+        uint64_t sessionToken,
+        uint64_t resumeToken)
     : version(version)
+    , capabilities(capabilities)
+    , sessionToken(sessionToken)
+    , resumeToken(resumeToken)
 {}
 
 size_t VersionMsg::getSerialSize(unsigned version) const noexcept
 {
-    return Codec::getSerialSize(&version);
+    return getStaticSerialSize(version);
 }
 
 size_t VersionMsg::serialize(
         Encoder&       encoder,
         const unsigned version) const
 {
-    return encoder.encode(this->version);
+    return encoder.encode(this->version) +
+            encoder.encode(this->capabilities) +
+            encoder.encode(this->sessionToken) +
+            encoder.encode(this->resumeToken);
 }
 
 VersionMsg VersionMsg::deserialize(
@@ -36,8 +46,14 @@ VersionMsg VersionMsg::deserialize(
         const unsigned  version)
 {
     unsigned vers;
+    unsigned caps;
+    uint64_t sessionToken;
+    uint64_t resumeToken;
     decoder.decode(vers);
-    return VersionMsg(vers);
+    decoder.decode(caps);
+    decoder.decode(sessionToken);
+    decoder.decode(resumeToken);
+    return VersionMsg(vers, caps, sessionToken, resumeToken);
 }
 
 unsigned VersionMsg::getVersion() const
@@ -45,4 +61,19 @@ unsigned VersionMsg::getVersion() const
     return version;
 }
 
+unsigned VersionMsg::getCapabilities() const
+{
+    return capabilities;
+}
+
+uint64_t VersionMsg::getSessionToken() const
+{
+    return sessionToken;
+}
+
+uint64_t VersionMsg::getResumeToken() const
+{
+    return resumeToken;
+}
+
 } // namespace
@@ -21,9 +21,56 @@ namespace hycast {
 class VersionMsg final : public Serializable<VersionMsg>
 {
     unsigned version;
+    unsigned capabilities;
+    uint64_t sessionToken;
+    uint64_t resumeToken;
 
 public:
-    explicit VersionMsg(unsigned version);
+    /**
+     * Optional capabilities advertised with the protocol version. A
+     * capability is used on an association only if both peers advertise it,
+     * and bits a receiver doesn't recognize are simply never negotiated --
+     * so a new wire-level feature rolls out node-by-node instead of
+     * requiring a protocol-version flag-day.
+     */
+    typedef enum {
+        LZ4_CHUNKS       = 0x1, /// Can receive LZ4-compressed data-chunks
+        /// Can receive the compact (varint, delta-coded) message encoding
+        COMPACT_ENCODING = 0x2,
+        /// Can receive batched chunk-run messages
+        CHUNK_RUNS       = 0x4,
+        /// Advertises and honors receive-window credit for chunk deliveries
+        FLOW_CONTROL     = 0x8,
+        /// Can receive a single-chunk product as one combined
+        /// ProdInfo+payload message
+        SMALL_PRODUCTS   = 0x10,
+        /// Sends liveness heartbeats when its association is idle and may be
+        /// evicted for missing a few heartbeat deadlines
+        HEARTBEATS       = 0x20,
+        /// Advertises the retention range of its product-store -- at
+        /// connection setup and when eviction moves it -- and honors the
+        /// remote peer's advertisement when assigning chunk-requests
+        RETENTION        = 0x40
+    } Capability;
+
+    /**
+     * Constructs.
+     * @param[in] version       Protocol version
+     * @param[in] capabilities  Advertised capabilities as a bitmask of
+     *                          `Capability` values
+     * @param[in] sessionToken  Token the sending peer issues for this
+     *                          association. Presenting it on a reconnection
+     *                          resumes the association's server-side session
+     *                          state. 0 means no token is issued.
+     * @param[in] resumeToken   Token issued to the sending peer on a prior
+     *                          association that it presents for resumption
+     *                          or 0 for none
+     */
+    explicit VersionMsg(
+            unsigned version,
+            unsigned capabilities = 0,
+            uint64_t sessionToken = 0,
+            uint64_t resumeToken = 0);
 
     /**
      * Serializes this instance to an encoder.
@@ -39,8 +86,43 @@ public:
 
     size_t getSerialSize(unsigned version) const noexcept;
 
+    /**
+     * Returns the number of bytes in the serial representation of any
+     * instance.
+     * @param[in] version  Protocol version
+     * @return the number of bytes in the serial representation
+     */
+    static constexpr size_t getStaticSerialSize(const unsigned version)
+            noexcept {
+        return Codec::getSerialSize(sizeof(uint32_t)) + // Version
+                Codec::getSerialSize(sizeof(uint32_t)) + // Capabilities
+                Codec::getSerialSize(sizeof(uint64_t)) + // Session token
+                Codec::getSerialSize(sizeof(uint64_t)); // Resumption token
+    }
+
     unsigned getVersion() const;
 
+    /**
+     * Returns the capabilities advertised by the sending peer as a bitmask of
+     * `Capability` values.
+     * @return Advertised capabilities
+     */
+    unsigned getCapabilities() const;
+
+    /**
+     * Returns the token the sending peer issued for this association or 0
+     * if none was issued.
+     * @return Issued session token
+     */
+    uint64_t getSessionToken() const;
+
+    /**
+     * Returns the token the sending peer presents to resume a prior
+     * association's server-side session state or 0 if none is presented.
+     * @return Presented resumption token
+     */
+    uint64_t getResumeToken() const;
+
     /**
      * Returns an instance corresponding to the serialized representation in a
      * decoder.
@@ -14,8 +14,33 @@
 #include "error.h"
 #include "YamlPeerSource.h"
 
+#include <thread>
+
 namespace hycast {
 
+/**
+ * Resolves a candidate's hostname on its own, detached thread and caches the
+ * result in the address, which is shared by all copies -- including the one
+ * just pushed to the source. The candidates thus resolve in parallel at
+ * load, so the code that later pops and connects to them finds resolutions
+ * already cached and a slow or dead resolver delays startup's time-to-peers
+ * by at most one candidate's network round-trips rather than by serialized,
+ * multi-second resolver timeouts.
+ * @param[in] peerAddr  Address of the candidate peer
+ */
+static void resolveInBackground(const InetSockAddr& peerAddr)
+{
+    std::thread{[peerAddr]{
+        try {
+            peerAddr.resolve();
+        }
+        catch (const std::exception& ex) {
+            LOG_WARN("Couldn't resolve peer candidate " +
+                    peerAddr.to_string() + ": " + ex.what());
+        }
+    }}.detach();
+}
+
 YamlPeerSource::YamlPeerSource(YAML::Node peerAddrs)
     : PeerSource{}
 {
@@ -27,7 +52,9 @@ YamlPeerSource::YamlPeerSource(YAML::Node peerAddrs)
                     " is not a map");
         auto inetAddr = peerAddrs[i]["inetAddr"].as<std::string>();
         auto port = peerAddrs[i]["port"].as<in_port_t>();
-        push(InetSockAddr(inetAddr, port));
+        InetSockAddr peerAddr{inetAddr, port};
+        push(peerAddr);
+        resolveInBackground(peerAddr);
     }
 }
 
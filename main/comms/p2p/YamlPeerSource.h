@@ -20,6 +20,11 @@
 
 namespace hycast {
 
+/**
+ * A source of potential remote peers specified by a YAML document. Candidate
+ * hostnames are resolved asynchronously and in parallel at load, so popping
+ * a candidate and connecting to it doesn't wait on the resolver.
+ */
 class YamlPeerSource : public PeerSource
 {
 public:
@@ -11,15 +11,17 @@
  */
 
 #include "Completer.h"
+#include "error.h"
 #include "Executor.h"
 #include "Future.h"
 #include "Thread.h"
 
 #include <assert.h>
-#include <condition_variable>
-#include <mutex>
-#include <queue>
+#include <atomic>
+#include <cstdint>
+#include <sys/eventfd.h>
 #include <type_traits>
+#include <unistd.h>
 #include <utility>
 
 namespace hycast {
@@ -27,71 +29,185 @@ namespace hycast {
 template<class Ret>
 class Completer<Ret>::Impl
 {
-    /// Types:
-    typedef std::mutex              Mutex;
-    typedef std::lock_guard<Mutex>  LockGuard;
-    typedef std::unique_lock<Mutex> UniqueLock;
-    typedef std::condition_variable Cond;
+    /// Number of priority lanes
+    static const unsigned numLanes =
+            static_cast<unsigned>(TaskPriority::NUM_PRIORITIES);
+    /**
+     * Maximum number of consecutive `take()`-s from a higher-priority lane
+     * while a lower-priority lane held a waiting future. Reached, the lowest
+     * waiting lane is served instead, so a stream of urgent completions
+     * delays the retrieval of backlog and maintenance results but can't
+     * starve it.
+     */
+    static const unsigned MAX_LANE_BYPASSES{16};
+
+    /**
+     * Lock-free, multiple-producer, single-consumer queue of completed
+     * futures. Completions arrive in bursts from many task threads: each
+     * enqueues without locking, so completing tasks never contend with one
+     * another or with `take()`. Waking the consumer is the caller's job: the
+     * `Impl` shares one eventfd among its per-priority lanes.
+     */
     class FutureQueue
     {
-        Mutex                    mutex;
-        Cond                     cond;
-        std::queue<Future<Ret>>  futures;
+        struct Node {
+            std::atomic<Node*> next;
+            Future<Ret>        future;
+
+            Node()
+                : next{nullptr}
+                , future{}
+            {}
+            explicit Node(Future<Ret> future)
+                : next{nullptr}
+                , future{future}
+            {}
+        };
+
+        std::atomic<Node*> head;    ///< Where producers enqueue
+        Node*              tail;    ///< Where the consumer dequeues
 
     public:
         FutureQueue()
-            : mutex{}
-            , cond{}
-            , futures{}
-        {}
+            : head{}
+            , tail{new Node{}} // Stub node: the queue is never truly empty
+        {
+            head.store(tail);
+        }
+
+        ~FutureQueue()
+        {
+            for (Node* node = tail; node; ) {
+                Node* next = node->next.load(std::memory_order_relaxed);
+                delete node;
+                node = next;
+            }
+        }
 
+        /**
+         * Adds a future. Lock-free: may be called concurrently by any number
+         * of threads.
+         * @param[in] future  Future to be added
+         */
         void push(Future<Ret> future)
         {
-            LockGuard lock{mutex};
-            futures.push(future);
-            cond.notify_all();
+            Node* const node = new Node{future};
+            // Serialization point among producers
+            Node* const prev = head.exchange(node, std::memory_order_acq_rel);
+            // The node is visible to the consumer only after this store
+            prev->next.store(node, std::memory_order_release);
         }
 
-        Future<Ret> pop()
+        /**
+         * Indicates if a future is available. Must only be called by a
+         * single thread.
+         * @retval `true`   A future is available
+         * @retval `false`  The queue is empty
+         */
+        bool peek() const
         {
-            UniqueLock lock{mutex};
-            while (futures.empty()) {
-                Canceler canceler{};
-                cond.wait(lock);
-            }
-            auto future = futures.front();
-            futures.pop();
-            return future;
+            return tail->next.load(std::memory_order_acquire) != nullptr;
         }
+
+        /**
+         * Tries to remove the next future in completion order. Doesn't
+         * block. Must only be called by a single thread.
+         * @param[out] future  Removed future. Set iff `true` is returned.
+         * @retval `true`      Future was removed
+         * @retval `false`     The queue is empty
+         */
+        bool tryPop(Future<Ret>& future)
+        {
+            Node* const next = tail->next.load(std::memory_order_acquire);
+            if (next == nullptr)
+                return false;
+            future = next->future;
+            next->future = Future<Ret>{}; // Don't retain references
+            delete tail;
+            tail = next;
+            return true;
+        }
+    };
+
+    /// Argument of the thread cleanup-routine that enqueues a task's future
+    struct CleanupArg {
+        Impl*        impl;
+        TaskPriority priority;
     };
 
     /// Executor
     Executor<Ret>            executor;
-    /// Queue of futures of completed tasks
-    FutureQueue              completedFutures;
+    /// Per-priority queues of futures of completed tasks
+    FutureQueue              completedLanes[numLanes];
+    /// Wakes the consumer in `take()`
+    int                      eventFd;
+    /// Consecutive `take()`-s that bypassed a waiting lower-priority lane.
+    /// Only accessed by the single consumer, so unguarded.
+    unsigned                 numBypassed;
 
-    void add() {
+    void add(const TaskPriority priority) {
         auto future = executor.getFuture();
-        completedFutures.push(future);
+        completedLanes[static_cast<unsigned>(priority)].push(future);
+        const uint64_t one = 1;
+        if (::write(eventFd, &one, sizeof(one)) != sizeof(one))
+            throw SYSTEM_ERROR("Couldn't signal eventfd");
     }
 
     static void addFutureToQueue(void* arg) {
-        auto impl = static_cast<Impl*>(arg);
-        impl->add();
+        auto cleanupArg = static_cast<CleanupArg*>(arg);
+        cleanupArg->impl->add(cleanupArg->priority);
+    }
+
+    /**
+     * Tries to remove the next completed future, serving the
+     * highest-priority non-empty lane -- except that after
+     * `MAX_LANE_BYPASSES` consecutive removals that bypassed a waiting
+     * lower-priority future the lowest non-empty lane is served instead.
+     * Doesn't block. Must only be called by the single consumer.
+     * @param[out] future  Removed future. Set iff `true` is returned.
+     * @retval `true`      Future was removed
+     * @retval `false`     All lanes are empty
+     */
+    bool tryTake(Future<Ret>& future)
+    {
+        int highest = -1;
+        int lowest = -1;
+        for (unsigned i = 0; i < numLanes; ++i) {
+            if (completedLanes[i].peek()) {
+                if (highest < 0)
+                    highest = i;
+                lowest = i;
+            }
+        }
+        if (highest < 0)
+            return false;
+        unsigned lane = highest;
+        if (lowest == highest) {
+            numBypassed = 0;
+        }
+        else if (++numBypassed >= MAX_LANE_BYPASSES) {
+            lane = lowest;
+            numBypassed = 0;
+        }
+        return completedLanes[lane].tryPop(future);
     }
 
 protected:
     /**
      * Wraps a callable in a callable that adds the associated future to the
-     * queue of completed futures when the task completes.
-     * @param[in] func  Callable to be wrapped
-     * @return          Wrapped callable
+     * task's priority lane of completed futures when the task completes.
+     * @param[in] func      Callable to be wrapped
+     * @param[in] priority  Priority lane of the task
+     * @return              Wrapped callable
      */
-    std::function<Ret()> getCallable(const std::function<Ret()>& func)
+    std::function<Ret()> getCallable(
+            const std::function<Ret()>& func,
+            const TaskPriority          priority)
     {
-        return [this,func] {
+        return [this,func,priority] {
             Ret result;
-            THREAD_CLEANUP_PUSH(addFutureToQueue, this);
+            CleanupArg cleanupArg{this, priority};
+            THREAD_CLEANUP_PUSH(addFutureToQueue, &cleanupArg);
             result = func();
             THREAD_CLEANUP_POP(true);
             return result;
@@ -104,8 +220,13 @@ public:
      */
     Impl()
         : executor{}
-        , completedFutures{}
-    {}
+        , completedLanes{}
+        , eventFd{::eventfd(0, 0)}
+        , numBypassed{0}
+    {
+        if (eventFd < 0)
+            throw SYSTEM_ERROR("Couldn't create eventfd");
+    }
 
     ~Impl()
     {
@@ -116,31 +237,50 @@ public:
         catch (const std::exception& ex) {
             LOG_ERROR(ex, "Couldn't destroy completer");
         }
+        ::close(eventFd);
     }
 
     /**
      * Submits a callable for execution. The callable's future will also be
      * returned by take(), eventually.
-     * @param[in,out] func  Callable to be executed
-     * @return              Callable's future
-     * @exceptionsafety     Basic guarantee
-     * @threadsafety        Safe
-     * @see                 take()
+     * @param[in,out] func      Callable to be executed
+     * @param[in]     priority  Priority lane of the task
+     * @return                  Callable's future
+     * @exceptionsafety         Basic guarantee
+     * @threadsafety            Safe
+     * @see                     take()
      */
-    Future<Ret> submit(const std::function<Ret()>& func) {
-        auto callable = getCallable(func);
+    Future<Ret> submit(
+            const std::function<Ret()>& func,
+            const TaskPriority          priority) {
+        auto callable = getCallable(func, priority);
         auto future = executor.submit(callable);
         return future;
     }
 
     /**
      * Returns the next completed future. Blocks until one is available.
+     * Higher-priority lanes are served first, subject to the bypass bound.
      * @return the next completed future
      * @exceptionsafety  Basic guarantee
      * @threadsafety     Safe
      */
     Future<Ret> take() {
-        return completedFutures.pop();
+        for (;;) {
+            Future<Ret> future{};
+            if (tryTake(future))
+                return future;
+            // Empty (or a producer hasn't linked its node yet): wait.
+            // The eventfd count accumulates, so no wakeup can be lost.
+            uint64_t count;
+            ssize_t  nbytes;
+            {
+                Canceler canceler{};
+                nbytes = ::read(eventFd, &count, sizeof(count));
+            }
+            if (nbytes != sizeof(count))
+                throw SYSTEM_ERROR("Couldn't read eventfd");
+        }
     }
 };
 
@@ -148,16 +288,19 @@ public:
 
 /**
  * Wraps a callable in a callable that adds the associated future to the
- * completed-task queue when the task completes. Complete specialization for
- * callables that return void.
- * @param[in] func  Void callable to be wrapped
- * @return          Wrapped callable
+ * task's priority lane of completed futures when the task completes. Complete
+ * specialization for callables that return void.
+ * @param[in] func      Void callable to be wrapped
+ * @param[in] priority  Priority lane of the task
+ * @return              Wrapped callable
  */
 template<>
 std::function<void()> Completer<void>::Impl::getCallable(
-        const std::function<void()>& func) {
-    return [this,func] {
-        THREAD_CLEANUP_PUSH(addFutureToQueue, this);
+        const std::function<void()>& func,
+        const TaskPriority           priority) {
+    return [this,func,priority] {
+        CleanupArg cleanupArg{this, priority};
+        THREAD_CLEANUP_PUSH(addFutureToQueue, &cleanupArg);
         func();
         THREAD_CLEANUP_POP(true);
     };
@@ -175,9 +318,11 @@ Completer<Ret>::~Completer()
 {}
 
 template<class Ret>
-Future<Ret> Completer<Ret>::submit(const std::function<Ret()>& func)
+Future<Ret> Completer<Ret>::submit(
+        const std::function<Ret()>& func,
+        const TaskPriority          priority)
 {
-    return pImpl->submit(func);
+    return pImpl->submit(func, priority);
 }
 
 template<class Ret>
@@ -14,6 +14,7 @@
 #define MAIN_MISC_COMPLETER_H_
 
 #include "Future.h"
+#include "Task.h"
 
 #include <functional>
 #include <memory>
@@ -42,16 +43,25 @@ public:
      * Submits a callable for execution. The callable's future will, eventually,
      * be returned by take().
      * @param[in,out] func       Task to be executed
+     * @param[in]     priority   Priority lane of the task. Determines the
+     *                           order in which take() returns completed
+     *                           futures.
      * @return                   Task's future
      * @throws std::logic_error  cancel() has been called
      * @exceptionsafety          Basic guarantee
      * @threadsafety             Safe
      * @throws std::logic_error  Instance is shut down
      */
-    Future<Ret> submit(const std::function<Ret()>& func);
+    Future<Ret> submit(
+            const std::function<Ret()>& func,
+            const TaskPriority          priority = TaskPriority::NORMAL);
 
     /**
      * Returns the next completed future. Blocks until one is available.
+     * Futures of higher-priority tasks are returned before those of
+     * lower-priority ones, except that the number of consecutive returns that
+     * bypass a waiting lower-priority future is bounded, so a stream of
+     * urgent completions can't starve the others.
      * @return the next completed future
      * @exceptionsafety  Basic guarantee
      * @threadsafety     Safe
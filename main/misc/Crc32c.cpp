@@ -0,0 +1,254 @@
+/**
+ * This file implements the CRC32C (Castagnoli) checksum.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All Rights
+ * reserved. See file "Copying" in the top-level source-directory for usage
+ * restrictions.
+ *
+ *        File: Crc32c.cpp
+ *  Created on: Jan 16, 2018
+ *      Author: Steven R. Emmerson
+ */
+
+#include "config.h"
+
+#include "Crc32c.h"
+
+#include <cstring>
+
+#ifdef __ARM_FEATURE_CRC32
+    #include <arm_acle.h>
+#endif
+
+namespace hycast {
+
+/// CRC32C generator polynomial, reflected
+static const uint32_t crc32cPoly = 0x82f63b78u;
+
+/**
+ * Lookup tables for the slicing-by-8 software implementation. `table[0]` is
+ * the classic byte-at-a-time table; `table[k]` advances a byte `k` positions
+ * further through the CRC register, so eight input bytes can be folded into
+ * the register with eight independent table lookups.
+ */
+static const struct SoftTables final
+{
+    uint32_t table[8][256];
+
+    SoftTables() noexcept
+    {
+        for (unsigned n = 0; n < 256; ++n) {
+            uint32_t crc = n;
+            for (unsigned k = 0; k < 8; ++k)
+                crc = (crc & 1) ? (crc >> 1) ^ crc32cPoly : crc >> 1;
+            table[0][n] = crc;
+        }
+        for (unsigned n = 0; n < 256; ++n) {
+            uint32_t crc = table[0][n];
+            for (unsigned k = 1; k < 8; ++k) {
+                crc = table[0][crc & 0xff] ^ (crc >> 8);
+                table[k][n] = crc;
+            }
+        }
+    }
+} tables{};
+
+/**
+ * Software implementation. Folds eight bytes per iteration.
+ * @param[in] crc     CRC register. Already inverted.
+ * @param[in] ptr     Bytes to be checksummed
+ * @param[in] nbytes  Number of bytes
+ * @return            Resulting CRC register, not yet inverted
+ */
+static uint32_t softCrc32c(
+        uint32_t       crc,
+        const uint8_t* ptr,
+        size_t         nbytes) noexcept
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    while (nbytes && (reinterpret_cast<uintptr_t>(ptr) & 7)) {
+        crc = tables.table[0][(crc ^ *ptr++) & 0xff] ^ (crc >> 8);
+        --nbytes;
+    }
+    while (nbytes >= 8) {
+        uint64_t word;
+        ::memcpy(&word, ptr, 8);
+        word ^= crc;
+        crc = tables.table[7][word & 0xff] ^
+                tables.table[6][(word >> 8) & 0xff] ^
+                tables.table[5][(word >> 16) & 0xff] ^
+                tables.table[4][(word >> 24) & 0xff] ^
+                tables.table[3][(word >> 32) & 0xff] ^
+                tables.table[2][(word >> 40) & 0xff] ^
+                tables.table[1][(word >> 48) & 0xff] ^
+                tables.table[0][word >> 56];
+        ptr += 8;
+        nbytes -= 8;
+    }
+#endif
+    while (nbytes) {
+        crc = tables.table[0][(crc ^ *ptr++) & 0xff] ^ (crc >> 8);
+        --nbytes;
+    }
+    return crc;
+}
+
+#ifdef __x86_64__
+/**
+ * Hardware implementation. The SSE4.2 CRC32 instruction folds eight bytes
+ * per cycle-or-so.
+ * @param[in] crc     CRC register. Already inverted.
+ * @param[in] ptr     Bytes to be checksummed
+ * @param[in] nbytes  Number of bytes
+ * @return            Resulting CRC register, not yet inverted
+ */
+__attribute__((target("sse4.2")))
+static uint32_t hardCrc32c(
+        uint32_t       crc,
+        const uint8_t* ptr,
+        size_t         nbytes) noexcept
+{
+    while (nbytes && (reinterpret_cast<uintptr_t>(ptr) & 7)) {
+        crc = __builtin_ia32_crc32qi(crc, *ptr++);
+        --nbytes;
+    }
+    uint64_t wide = crc;
+    while (nbytes >= 8) {
+        uint64_t word;
+        ::memcpy(&word, ptr, 8);
+        wide = __builtin_ia32_crc32di(wide, word);
+        ptr += 8;
+        nbytes -= 8;
+    }
+    crc = static_cast<uint32_t>(wide);
+    while (nbytes) {
+        crc = __builtin_ia32_crc32qi(crc, *ptr++);
+        --nbytes;
+    }
+    return crc;
+}
+#endif
+
+#ifdef __ARM_FEATURE_CRC32
+/**
+ * Hardware implementation using the ARMv8 CRC32 extension.
+ * @param[in] crc     CRC register. Already inverted.
+ * @param[in] ptr     Bytes to be checksummed
+ * @param[in] nbytes  Number of bytes
+ * @return            Resulting CRC register, not yet inverted
+ */
+static uint32_t hardCrc32c(
+        uint32_t       crc,
+        const uint8_t* ptr,
+        size_t         nbytes) noexcept
+{
+    while (nbytes && (reinterpret_cast<uintptr_t>(ptr) & 7)) {
+        crc = __crc32cb(crc, *ptr++);
+        --nbytes;
+    }
+    while (nbytes >= 8) {
+        uint64_t word;
+        ::memcpy(&word, ptr, 8);
+        crc = __crc32cd(crc, word);
+        ptr += 8;
+        nbytes -= 8;
+    }
+    while (nbytes) {
+        crc = __crc32cb(crc, *ptr++);
+        --nbytes;
+    }
+    return crc;
+}
+#endif
+
+/**
+ * Multiplies a GF(2) matrix by a GF(2) vector. The matrix is 32 columns of
+ * 32 bits each; multiplication is AND and addition is XOR.
+ * @param[in] mat  Matrix
+ * @param[in] vec  Vector
+ * @return         Product
+ */
+static uint32_t gf2MatrixTimes(
+        const uint32_t mat[32],
+        uint32_t       vec) noexcept
+{
+    uint32_t sum = 0;
+    for (unsigned i = 0; vec; vec >>= 1, ++i)
+        if (vec & 1)
+            sum ^= mat[i];
+    return sum;
+}
+
+/**
+ * Squares a GF(2) matrix.
+ * @param[out] square  Square of the matrix
+ * @param[in]  mat     Matrix
+ */
+static void gf2MatrixSquare(
+        uint32_t       square[32],
+        const uint32_t mat[32]) noexcept
+{
+    for (unsigned n = 0; n < 32; ++n)
+        square[n] = gf2MatrixTimes(mat, mat[n]);
+}
+
+uint32_t crc32cCombine(
+        const uint32_t crc1,
+        const uint32_t crc2,
+        size_t         nbytes2) noexcept
+{
+    if (nbytes2 == 0)
+        return crc1;
+    /*
+     * Appending `nbytes2` bytes to the first sequence advances its CRC
+     * register by a linear operator over GF(2). The operator for one zero
+     * bit is the polynomial's companion matrix; repeated squaring yields the
+     * operator for any power-of-two number of zero bits, and the bits of
+     * `nbytes2` select which squares to apply -- O(log nbytes2) matrix
+     * operations in all.
+     */
+    uint32_t even[32]; // Operator for 2^(2k) zero bits
+    uint32_t odd[32];  // Operator for 2^(2k+1) zero bits
+    odd[0] = crc32cPoly;
+    for (unsigned n = 1, row = 1; n < 32; ++n, row <<= 1)
+        odd[n] = row;
+    gf2MatrixSquare(even, odd); // Two zero bits
+    gf2MatrixSquare(odd, even); // Four zero bits
+    uint32_t crc = crc1;
+    size_t   len = nbytes2;
+    do {
+        gf2MatrixSquare(even, odd);
+        if (len & 1)
+            crc = gf2MatrixTimes(even, crc);
+        len >>= 1;
+        if (len == 0)
+            break;
+        gf2MatrixSquare(odd, even);
+        if (len & 1)
+            crc = gf2MatrixTimes(odd, crc);
+        len >>= 1;
+    } while (len);
+    return crc ^ crc2;
+}
+
+uint32_t crc32c(
+        uint32_t          crc,
+        const void* const data,
+        size_t            nbytes) noexcept
+{
+    auto ptr = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+#ifdef __x86_64__
+    static const bool haveHardware = __builtin_cpu_supports("sse4.2");
+    crc = haveHardware
+            ? hardCrc32c(crc, ptr, nbytes)
+            : softCrc32c(crc, ptr, nbytes);
+#elif defined(__ARM_FEATURE_CRC32)
+    crc = hardCrc32c(crc, ptr, nbytes);
+#else
+    crc = softCrc32c(crc, ptr, nbytes);
+#endif
+    return ~crc;
+}
+
+} // namespace
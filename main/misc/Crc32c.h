@@ -0,0 +1,65 @@
+/**
+ * This file declares a function for computing the CRC32C (Castagnoli)
+ * checksum of a sequence of bytes. The CPU's CRC32 instructions are used when
+ * they're available (SSE4.2 on x86-64, the optional CRC32 extension on
+ * ARMv8); otherwise, an 8-bytes-at-a-time table-driven ("slicing-by-8")
+ * software implementation is used. Either way, the cost is a small fraction
+ * of a byte-at-a-time CRC.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All Rights
+ * reserved. See file "Copying" in the top-level source-directory for usage
+ * restrictions.
+ *
+ *        File: Crc32c.h
+ *  Created on: Jan 16, 2018
+ *      Author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_MISC_CRC32C_H_
+#define MAIN_MISC_CRC32C_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace hycast {
+
+/**
+ * Computes the CRC32C checksum of a sequence of bytes. A checksum can be
+ * computed incrementally by passing the result of one call as the initial
+ * value of the next.
+ * @param[in] crc     Initial value. `0` for a new checksum or the result of
+ *                    a previous call to continue one.
+ * @param[in] data    Bytes to be checksummed
+ * @param[in] nbytes  Number of bytes
+ * @return            CRC32C checksum
+ * @exceptionsafety   Nothrow
+ * @threadsafety      Safe
+ */
+uint32_t crc32c(
+        uint32_t          crc,
+        const void* const data,
+        size_t            nbytes) noexcept;
+
+/**
+ * Combines the CRC32C checksums of two adjacent byte-sequences into the
+ * checksum of their concatenation without touching either sequence's bytes:
+ * the second checksum's register is advanced past the first sequence by
+ * GF(2) matrix exponentiation, so the cost is logarithmic in `nbytes2` and
+ * independent of the data. Checksums of consecutive pieces -- computed
+ * piecewise while each piece was hot in cache -- can thus be folded, in
+ * order, into the checksum of the whole.
+ * @param[in] crc1     Checksum of the first sequence
+ * @param[in] crc2     Checksum of the second sequence
+ * @param[in] nbytes2  Number of bytes in the second sequence
+ * @return             Checksum of the concatenated sequences
+ * @exceptionsafety    Nothrow
+ * @threadsafety       Safe
+ */
+uint32_t crc32cCombine(
+        const uint32_t crc1,
+        const uint32_t crc2,
+        size_t         nbytes2) noexcept;
+
+} // namespace
+
+#endif /* MAIN_MISC_CRC32C_H_ */
@@ -1,5 +1,8 @@
 /**
- * This file implements a thread-safe delay-queue.
+ * This file implements a thread-safe delay-queue. The queue is backed by a
+ * hashed timing-wheel, so adding an element and expiring a due element are
+ * both O(1) -- independent of the number of elements -- and due elements are
+ * harvested in batches of one wheel-slot at a time.
  *
  * Copyright 2017 University Corporation for Atmospheric Research. All rights
  * reserved. See the the file COPYING in the top-level source-directory for
@@ -12,14 +15,16 @@
 #include "config.h"
 
 #include "DelayQueue.h"
+#include "SimClock.h"
 #include "Thread.h"
 
 #include <chrono>
 #include <condition_variable>
 #include <cstddef>
+#include <cstdint>
 #include <deque>
 #include <mutex>
-#include <queue>
+#include <vector>
 
 namespace hycast {
 
@@ -38,6 +43,7 @@ class DelayQueue<Value,Dur>::Impl final
     typedef std::mutex                Mutex;
     typedef std::unique_lock<Mutex>   UniqueLock;
     typedef std::lock_guard<Mutex>    LockGuard;
+    typedef int64_t                   Tick;
 
     /**
      * An element in the queue.
@@ -57,7 +63,7 @@ class DelayQueue<Value,Dur>::Impl final
                 const Value&    value,
                 const Duration& delay)
             : value{value}
-            , when{Clock::now() + delay}
+            , when{SimClock::now() + delay}
         {}
 
         /**
@@ -83,31 +89,93 @@ class DelayQueue<Value,Dur>::Impl final
         }
     };
 
+    /// A slot of the timing-wheel. Holds the elements that hash to the slot.
+    typedef std::deque<Element> Slot;
+
+    /// Number of slots in the timing-wheel. Must be a power of two.
+    static const size_t NUM_SLOTS{256};
+
+    /// The mutex for concurrent access to the queue.
+    std::mutex mutable      mutex;
+    /// The condition variable for signaling when the queue has been modified
+    std::condition_variable cond;
+    /// The timing-wheel. One tick is one unit of the duration type.
+    std::vector<Slot>       wheel;
+    /// Elements that are due but not yet popped
+    std::deque<Element>     dueElts;
+    /// Number of elements in the timing-wheel (excludes due elements)
+    size_t                  numElts;
+    /// Earliest tick that the wheel-cursor hasn't yet processed
+    Tick                    currTick;
+
     /**
-     * Class for comparing elements.
+     * Returns the tick that contains a time-point.
+     * @param[in] when  Time-point
+     * @return          Containing tick
      */
-    struct Compare final
+    inline static Tick tickOf(const TimePoint& when)
     {
-        /**
-         * Compares two elements.
-         * @param[in] e1   First element
-         * @param[in] e2   Second element
-         * @return `true`  First element is less than second element
-         * @return `false` First element is not less than second element
-         */
-        bool operator()(const Element& e1, const Element& e2) const noexcept
-        {
-            // Later time => lower priority
-            return e1.getTime() > e2.getTime();
+        return std::chrono::duration_cast<Duration>(when.time_since_epoch())
+                .count();
+    }
+
+    /**
+     * Returns the time-point at which a tick begins.
+     * @param[in] tick  Tick
+     * @return          Time-point at which the tick begins
+     */
+    inline static TimePoint timeOf(const Tick tick)
+    {
+        return TimePoint{std::chrono::duration_cast<Clock::duration>(
+                Duration{static_cast<typename Duration::rep>(tick)})};
+    }
+
+    /**
+     * Advances the wheel-cursor, moving the elements of every processed slot
+     * that are due to the due-elements batch. Elements in a processed slot
+     * that belong to a later revolution of the wheel are left in place.
+     * @pre                 `mutex` is locked
+     * @param[in] nowTick   Tick that contains the current time
+     */
+    void advance(const Tick nowTick)
+    {
+        if (numElts == 0) {
+            currTick = nowTick + 1; // Nothing to process: skip the gap
+            return;
         }
-    };
+        while (currTick <= nowTick) {
+            auto& slot = wheel[currTick & (NUM_SLOTS - 1)];
+            for (auto iter = slot.begin(); iter != slot.end(); ) {
+                if (tickOf(iter->getTime()) <= currTick) {
+                    dueElts.push_back(*iter);
+                    iter = slot.erase(iter);
+                    --numElts;
+                }
+                else {
+                    ++iter; // Later revolution
+                }
+            }
+            ++currTick;
+        }
+    }
 
-    /// The mutex for concurrent access to the queue.
-    std::mutex mutable                                         mutex;
-    /// The condition variable for signaling when the queue has been modified
-    std::condition_variable                                    cond;
-    /// The queue.
-    std::priority_queue<Element, std::deque<Element>, Compare> queue;
+    /**
+     * Returns the reveal-time of the earliest pending element. The scan is
+     * linear in the number of pending elements but only performed when the
+     * queue has nothing due -- i.e., when the alternative is sleeping.
+     * @pre     `mutex` is locked
+     * @pre     `numElts > 0`
+     * @return  Reveal-time of the earliest pending element
+     */
+    TimePoint earliestTime() const
+    {
+        TimePoint earliest{TimePoint::max()};
+        for (const auto& slot : wheel)
+            for (const auto& elt : slot)
+                if (elt.getTime() < earliest)
+                    earliest = elt.getTime();
+        return earliest;
+    }
 
 public:
     /**
@@ -118,7 +186,10 @@ public:
     explicit Impl()
         : mutex{}
         , cond{}
-        , queue{}
+        , wheel(NUM_SLOTS)
+        , dueElts{}
+        , numElts{0}
+        , currTick{tickOf(SimClock::now())}
     {}
 
     /**
@@ -134,7 +205,15 @@ public:
             const Duration& delay)
     {
         UniqueLock lock{mutex};
-        queue.push(Element(value, delay));
+        Element    elt{value, delay};
+        const auto tick = tickOf(elt.getTime());
+        if (tick < currTick) {
+            dueElts.push_back(elt); // Already due
+        }
+        else {
+            wheel[tick & (NUM_SLOTS - 1)].push_back(elt);
+            ++numElts;
+        }
         cond.notify_one();
     }
 
@@ -150,31 +229,45 @@ public:
     Value pop()
     {
         UniqueLock lock{mutex};
-        while (queue.empty()) {
-            Canceler canceler{};
-            cond.wait(lock);
-        }
-        for (TimePoint time = queue.top().getTime(); time > Clock::now();
-                time = queue.top().getTime()) {
-            Canceler canceler{};
-            cond.wait_until(lock, time);
+        for (;;) {
+            if (!dueElts.empty()) {
+                auto value = dueElts.front().getValue();
+                dueElts.pop_front();
+                return value;
+            }
+            if (numElts == 0) {
+                Canceler canceler{};
+                cond.wait(lock);
+                continue;
+            }
+            advance(tickOf(SimClock::now()));
+            if (dueElts.empty()) {
+                /*
+                 * Nothing due: sleep until the earliest pending element's
+                 * reveal-time. Sleeping only until the cursor's tick begins
+                 * would wake this thread every tick until that element
+                 * matured. `push()` notifies the condition-variable, so an
+                 * element added during the sleep can't be overslept.
+                 */
+                Canceler canceler{};
+                SimClock::waitUntil(cond, lock, earliestTime());
+            }
         }
-        auto value = queue.top().getValue();
-        queue.pop();
-        return value;
     }
 
     bool empty() const noexcept
     {
         LockGuard lock{mutex};
-        return queue.empty();
+        return numElts == 0 && dueElts.empty();
     }
 
     void clear() noexcept
     {
         LockGuard lock{mutex};
-        while (!queue.empty())
-            queue.pop();
+        for (auto& slot : wheel)
+            slot.clear();
+        dueElts.clear();
+        numElts = 0;
     }
 };
 
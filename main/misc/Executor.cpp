@@ -123,6 +123,9 @@ class Executor<Ret>::Impl final
     /// Whether or not this instance has been shut down
     bool          closed;
 
+    /// CPU affinity for new task threads. Empty means unrestricted.
+    std::vector<unsigned> affinity;
+
     /**
      * Indicates whether or not the mutex is locked. Upon return, the state of
      * the mutex is the same as upon entry.
@@ -235,6 +238,8 @@ class Executor<Ret>::Impl final
         removeAndDestroyDoneThread();
         Barrier barrier{2};
         auto    thread = newThread(task, barrier); // RAII object
+        if (!affinity.empty())
+            thread.setAffinity(affinity);
         tasks.add(thread, task);
         cond.notify_all();
         barrier.wait(); // Synchronize `taskMap` changes with thread
@@ -252,6 +257,7 @@ public:
         , doneThreadId{}
         , emptyThreadId{}
         , closed{false}
+        , affinity{}
     {}
 
     /**
@@ -285,7 +291,7 @@ public:
     {
         Future<Ret> future{};
         try {
-            Task<Ret> task{func};
+            Task<Ret> task{std::move(func)};
             future = submitTask(task);
         }
         catch (const std::exception& e) {
@@ -294,6 +300,17 @@ public:
         return future;
     }
 
+    /**
+     * Sets the CPU affinity of subsequently-submitted jobs.
+     * @param[in] cpus  CPU indexes the task threads may run on. Empty means
+     *                  unrestricted.
+     */
+    void setAffinity(const std::vector<unsigned>& cpus)
+    {
+        LockGuard lock{mutex};
+        affinity = cpus;
+    }
+
     /**
      * Returns the future associated with the current thread.
      * @return                   The associated future
@@ -361,7 +378,13 @@ Future<Ret> Executor<Ret>::submit(std::function<Ret()>& func) const
 template<class Ret>
 Future<Ret> Executor<Ret>::submit(std::function<Ret()>&& func) const
 {
-    return pImpl->submit(func);
+    return pImpl->submit(std::move(func));
+}
+
+template<class Ret>
+void Executor<Ret>::setAffinity(const std::vector<unsigned>& cpus) const
+{
+    pImpl->setAffinity(cpus);
 }
 
 template<class Ret>
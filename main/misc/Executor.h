@@ -61,6 +61,19 @@ public:
      */
     Future<Ret> submit(std::function<Ret()>&& func) const;
 
+    /**
+     * Sets the CPU affinity of subsequently-submitted callables. Each new
+     * task thread is pinned to the given CPUs, so on NUMA systems the memory
+     * that a task first-touches is allocated on the corresponding node.
+     * Threads of already-executing callables are unaffected. An empty vector
+     * (the default) restores unrestricted placement for new callables.
+     * @param[in] cpus     CPU indexes the task threads may run on
+     * @throw SystemError  Affinity couldn't be set (thrown by `submit()`)
+     * @exceptionsafety    Strong guarantee
+     * @threadsafety       Safe
+     */
+    void setAffinity(const std::vector<unsigned>& cpus) const;
+
     /**
      * Returns the future associated with the current thread.
      * @return                 The associated future. Will be empty if no such
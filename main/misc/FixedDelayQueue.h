@@ -12,6 +12,7 @@
 #ifndef MISC_FIXEDDELAYQUEUE_H
 #define MISC_FIXEDDELAYQUEUE_H
 
+#include "SimClock.h"
 #include "Thread.h"
 
 #include <chrono>
@@ -60,7 +61,7 @@ private:
                     Value          value,
                     const Duration delay)
                 : value{value}
-                , when{Clock::now() + delay}
+                , when{SimClock::now() + delay}
             {}
 
             /**
@@ -118,11 +119,25 @@ private:
          */
         void push(Value value)
         {
-            std::unique_lock<std::mutex>(mutex);
+            std::unique_lock<std::mutex> lock(mutex);
             queue.push(Element(value, delay));
             cond.notify_one();
         }
 
+        /**
+         * Sets the delay for subsequently-added values. Values already in the
+         * queue keep their original reveal-times.
+         * @param[in] delay  The delay for each subsequent element in units of
+         *                   the template parameter
+         * @exceptionsafety Strong guarantee
+         * @threadsafety    Safe
+         */
+        void setDelay(const Duration delay)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            this->delay = delay;
+        }
+
         /**
          * Returns the value whose reveal-time is the earliest and not later than
          * the current time and removes it from the queue. Blocks until such a value
@@ -140,9 +155,9 @@ private:
                 cond.wait(lock);
             }
             for (const TimePoint time = queue.front().getTime();
-                    time > Clock::now(); ) {
+                    time > SimClock::now(); ) {
                 Canceler canceler{};
-                cond.wait_until(lock, time);
+                SimClock::waitUntil(cond, lock, time);
             }
             Value value = queue.front().getValue();
             queue.pop();
@@ -187,6 +202,19 @@ public:
         pImpl->push(value);
     }
 
+    /**
+     * Sets the delay for subsequently-added values. Values already in the
+     * queue keep their original reveal-times.
+     * @param[in] delay  The delay for each subsequent element in units of the
+     *                   template parameter
+     * @exceptionsafety Strong guarantee
+     * @threadsafety    Safe
+     */
+    void setDelay(const Duration delay)
+    {
+        pImpl->setDelay(delay);
+    }
+
     /**
      * Returns the value whose reveal-time is the earliest and not later than
      * the current time and removes it from the queue. Blocks until such a value
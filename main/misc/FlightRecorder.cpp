@@ -0,0 +1,232 @@
+/**
+ * This file implements the flight recorder: fixed-memory, per-thread binary
+ * event rings dumped on demand or on a fatal signal.
+ *
+ * The dump-file format, consumed by hycast_frdump(1), is native byte-order:
+ *
+ *     FileHeader                  { "HYFR", version, sizeof(Event) }
+ *     repeated:  RingHeader       { thread-ordinal, number of events }
+ *                Event[count]     oldest first
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: FlightRecorder.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "error.h"
+#include "FlightRecorder.h"
+
+#include <atomic>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+namespace hycast {
+
+namespace {
+    typedef FlightRecorder::Event Event;
+
+    /**
+     * A thread's event ring. `next` counts events ever recorded; the ring
+     * holds the last `capacity` of them. Rings are heap-allocated and never
+     * freed, so a dump includes the final events of threads that have since
+     * exited.
+     */
+    struct Ring final
+    {
+        std::atomic<uint64_t> next;
+        uint64_t              capacity; ///< Power of two
+        Event*                events;
+
+        explicit Ring(const uint64_t capacity)
+            : next{0}
+            , capacity{capacity}
+            , events{new Event[capacity]}
+        {}
+    };
+
+    /// All rings, in slot order. Written once per thread, under no lock:
+    /// a thread claims the slot `numRings++` and then publishes its ring.
+    Ring*                 rings[FlightRecorder::maxThreads];
+    std::atomic<unsigned> numRings{0};
+    /// Capacity of rings yet to be allocated
+    std::atomic<uint64_t> defaultCapacity{1ul << 18};
+
+    /// Calling thread's ring. `nullptr` until first use; `rings` slots were
+    /// exhausted if still `nullptr` after `getRing()`.
+    thread_local Ring* myRing = nullptr;
+    thread_local bool  triedRing = false;
+
+    Ring* getRing() noexcept
+    {
+        if (!triedRing) {
+            triedRing = true;
+            try {
+                const auto slot = numRings.fetch_add(1);
+                if (slot < FlightRecorder::maxThreads) {
+                    auto ring = new Ring{defaultCapacity.load()};
+                    rings[slot] = ring; // Publishes after construction
+                    myRing = ring;
+                }
+            }
+            catch (const std::exception& e) {
+            }
+        }
+        return myRing;
+    }
+
+    /// Pathname for the fault-time dump. Fixed storage: a signal-handler
+    /// can't touch a std::string.
+    char faultPathname[256];
+
+    /**
+     * Writes all of a buffer to a file. Async-signal-safe.
+     * @return `true` on success
+     */
+    bool writeAll(
+            const int         fd,
+            const void*       data,
+            size_t            nbytes) noexcept
+    {
+        auto bytes = static_cast<const char*>(data);
+        while (nbytes > 0) {
+            const auto status = ::write(fd, bytes, nbytes);
+            if (status < 0)
+                return false;
+            bytes += status;
+            nbytes -= status;
+        }
+        return true;
+    }
+
+    /**
+     * Dumps every ring to an open file. Async-signal-safe: used by both the
+     * on-demand dump and the fatal-signal handler.
+     * @param[in] fd  File descriptor. Not closed.
+     * @return        `true` on success
+     */
+    bool dumpToFd(const int fd) noexcept
+    {
+        struct {
+            char     magic[4];
+            uint32_t version;
+            uint32_t eventSize;
+            uint32_t pad;
+        } fileHeader = {{'H','Y','F','R'}, 1, sizeof(Event), 0};
+        if (!writeAll(fd, &fileHeader, sizeof(fileHeader)))
+            return false;
+        const auto count = numRings.load();
+        for (unsigned slot = 0; slot < count &&
+                slot < FlightRecorder::maxThreads; ++slot) {
+            const auto ring = rings[slot];
+            if (ring == nullptr)
+                continue; // Slot claimed but ring not yet published
+            const auto next = ring->next.load();
+            const auto numEvents =
+                    (next < ring->capacity) ? next : ring->capacity;
+            struct {
+                uint64_t thread;
+                uint64_t numEvents;
+            } ringHeader = {slot, numEvents};
+            if (!writeAll(fd, &ringHeader, sizeof(ringHeader)))
+                return false;
+            // Oldest first; two segments if the ring has wrapped
+            const auto start = (next - numEvents) & (ring->capacity - 1);
+            const auto firstSeg = (start + numEvents <= ring->capacity)
+                    ? numEvents
+                    : ring->capacity - start;
+            if (!writeAll(fd, ring->events + start,
+                        firstSeg*sizeof(Event)) ||
+                    !writeAll(fd, ring->events,
+                        (numEvents - firstSeg)*sizeof(Event)))
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * Handles a fatal signal: dumps the rings and re-raises the signal with
+     * its default disposition so the usual death (and core-file) follows.
+     */
+    extern "C" void handleFatalSignal(const int sig)
+    {
+        const auto fd = ::open(faultPathname, O_WRONLY|O_CREAT|O_TRUNC, 0666);
+        if (fd >= 0) {
+            dumpToFd(fd);
+            ::close(fd);
+        }
+        ::signal(sig, SIG_DFL);
+        ::raise(sig);
+    }
+}
+
+void FlightRecorder::record(
+        const Event::Type type,
+        const uint32_t    prod,
+        const uint32_t    chunk,
+        const uint32_t    size) noexcept
+{
+    const auto ring = getRing();
+    if (ring == nullptr)
+        return;
+    struct timespec now;
+    ::clock_gettime(CLOCK_MONOTONIC, &now);
+    const auto next = ring->next.load(std::memory_order_relaxed);
+    auto&      event = ring->events[next & (ring->capacity - 1)];
+    event.when = static_cast<uint64_t>(now.tv_sec)*1000000000 + now.tv_nsec;
+    event.prod = prod;
+    event.chunk = chunk;
+    event.size = size;
+    event.type = type;
+    event.pad = 0;
+    ring->next.store(next + 1, std::memory_order_release);
+}
+
+const unsigned FlightRecorder::maxThreads;
+
+void FlightRecorder::setCapacity(const size_t numEvents)
+{
+    if (numEvents == 0)
+        throw INVALID_ARGUMENT("Ring capacity can't be zero");
+    uint64_t capacity = 1;
+    while (capacity < numEvents)
+        capacity <<= 1;
+    defaultCapacity = capacity;
+}
+
+void FlightRecorder::dump(const std::string& pathname)
+{
+    const auto fd = ::open(pathname.data(), O_WRONLY|O_CREAT|O_TRUNC, 0666);
+    if (fd < 0)
+        throw SYSTEM_ERROR("Couldn't create flight-recorder dump-file \"" +
+                pathname + "\"");
+    const auto success = dumpToFd(fd);
+    ::close(fd);
+    if (!success)
+        throw SYSTEM_ERROR("Couldn't write flight-recorder dump-file \"" +
+                pathname + "\"");
+}
+
+void FlightRecorder::dumpOnFault(const std::string& pathname)
+{
+    if (pathname.size() >= sizeof(faultPathname))
+        throw INVALID_ARGUMENT("Dump-file pathname \"" + pathname +
+                "\" is too long");
+    ::strncpy(faultPathname, pathname.data(), sizeof(faultPathname)-1);
+    struct sigaction sigAction = {};
+    sigAction.sa_handler = handleFatalSignal;
+    ::sigemptyset(&sigAction.sa_mask);
+    for (const auto sig : {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT}) {
+        if (::sigaction(sig, &sigAction, nullptr))
+            throw SYSTEM_ERROR("Couldn't install flight-recorder handler "
+                    "for signal " + std::to_string(sig));
+    }
+}
+
+} // namespace
@@ -0,0 +1,117 @@
+/**
+ * This file declares an always-on, fixed-memory flight recorder: a binary
+ * ring of chunk-level pipeline events that each thread writes without
+ * locking. When a performance incident happens at 3 AM, the last few
+ * million events -- timestamps included -- are dumped to a file on demand
+ * or on a fatal signal and decoded offline with hycast_frdump(1), giving
+ * complete hindsight that logs can't.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: FlightRecorder.h
+ * @author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_MISC_FLIGHTRECORDER_H_
+#define MAIN_MISC_FLIGHTRECORDER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace hycast {
+
+class FlightRecorder final
+{
+public:
+    /// One recorded event. A compact, fixed-size struct written in native
+    /// byte-order: recording is a timestamp read and a 24-byte store.
+    struct Event final
+    {
+        /// What happened. Values are part of the dump-file format: only
+        /// append.
+        typedef enum : uint16_t {
+            CHUNK_RECV_MCAST = 1, ///< Chunk arrived via multicast
+            CHUNK_RECV_P2P,       ///< Chunk arrived from a peer
+            CHUNK_STORED,         ///< New chunk entered the product-store
+            PRODUCT_COMPLETE,     ///< Product became complete
+            REQUEST_SENT,         ///< Chunk-request sent to a peer
+            REQUEST_SERVED,       ///< Chunk sent to a peer
+            PRODUCT_PROCESSED,    ///< Product handed to local processing
+            EVICTION,             ///< Product left the product-store
+            TRACE_ID              ///< Product's trace identifier became
+                                  ///< known (chunk=low half, size=high half
+                                  ///< of the 64-bit identifier)
+        } Type;
+
+        uint64_t when;  ///< `CLOCK_MONOTONIC` nanoseconds
+        uint32_t prod;  ///< Product-index
+        uint32_t chunk; ///< Chunk-index or 0 if not applicable
+        uint32_t size;  ///< Number of bytes or 0 if not applicable
+        uint16_t type;  ///< `Event::Type`
+        uint16_t pad;   ///< Unused. Zero.
+    };
+
+    /**
+     * Records an event in the calling thread's ring, overwriting the oldest
+     * when the ring is full. No locking; cheap enough for the hot path. The
+     * first call on a thread allocates the thread's ring; if all ring-slots
+     * are taken (cf. `maxThreads`), the thread's events are silently
+     * dropped.
+     * @param[in] type   What happened
+     * @param[in] prod   Product-index
+     * @param[in] chunk  Chunk-index or 0
+     * @param[in] size   Number of bytes or 0
+     * @exceptionsafety  Nothrow
+     * @threadsafety     Safe
+     */
+    static void record(
+            const Event::Type type,
+            const uint32_t    prod,
+            const uint32_t    chunk = 0,
+            const uint32_t    size = 0) noexcept;
+
+    /// Maximum number of threads that may record
+    static const unsigned maxThreads = 256;
+
+    /**
+     * Sets the per-thread ring capacity. Affects only rings not yet
+     * allocated, so call before traffic flows. Rounded up to a power of two.
+     * The default is 2^18 events (6 MiB) per thread.
+     * @param[in] numEvents    Events retained per thread
+     * @throw InvalidArgument  `numEvents == 0`
+     * @threadsafety           Safe
+     */
+    static void setCapacity(const size_t numEvents);
+
+    /**
+     * Dumps every thread's ring to a file for offline decoding with
+     * hycast_frdump(1). Recording continues while the dump is written, so an
+     * event being overwritten mid-dump may decode as garbage; the decoder
+     * tolerates that.
+     * @param[in] pathname  Pathname of the dump-file. Overwritten.
+     * @throw SystemError   File couldn't be written
+     * @threadsafety        Safe
+     */
+    static void dump(const std::string& pathname);
+
+    /**
+     * Arranges for the rings to be dumped to the given file if the process
+     * takes a fatal signal (SIGSEGV, SIGBUS, SIGFPE, SIGILL, or SIGABRT).
+     * The handler uses only async-signal-safe calls and then re-raises the
+     * signal with its default disposition.
+     * @param[in] pathname  Pathname of the dump-file. Referenced at
+     *                      fault-time, so it's copied into static storage;
+     *                      at most 255 bytes.
+     * @throw InvalidArgument  Pathname is too long
+     * @throw SystemError      Signal-handler couldn't be installed
+     * @threadsafety           Compatible but not safe
+     */
+    static void dumpOnFault(const std::string& pathname);
+};
+
+} // namespace
+
+#endif /* MAIN_MISC_FLIGHTRECORDER_H_ */
@@ -231,6 +231,10 @@ BasicFuture::BasicFuture(Impl* ptr)
     : pImpl{ptr}
 {}
 
+BasicFuture::BasicFuture(std::shared_ptr<Impl> ptr)
+    : pImpl{std::move(ptr)}
+{}
+
 BasicFuture::~BasicFuture()
 {
     try {
@@ -374,12 +378,12 @@ Future<Ret>::Future()
 
 template<class Ret>
 Future<Ret>::Future(Stop& stop)
-    : BasicFuture{new Impl(stop)}
+    : BasicFuture{std::make_shared<Impl>(stop)}
 {}
 
 template<class Ret>
 Future<Ret>::Future(Stop&& stop)
-    : BasicFuture{new Impl(std::forward<Stop>(stop))}
+    : BasicFuture{std::make_shared<Impl>(std::forward<Stop>(stop))}
 {}
 
 template<class Ret>
@@ -451,11 +455,11 @@ Future<void>::Future()
 {}
 
 Future<void>::Future(Stop& stop)
-    : BasicFuture{new Impl(stop)}
+    : BasicFuture{std::make_shared<Impl>(stop)}
 {}
 
 Future<void>::Future(Stop&& stop)
-    : BasicFuture{new Impl(std::forward<Stop>(stop))}
+    : BasicFuture{std::make_shared<Impl>(std::forward<Stop>(stop))}
 {}
 
 void Future<void>::setResult() const
@@ -38,6 +38,14 @@ protected:
      */
     BasicFuture(Impl* ptr);
 
+    /**
+     * Constructs from a shared pointer to the template subclass
+     * implementation. Allows the implementation and its reference-count to
+     * occupy a single allocation (see `std::make_shared()`).
+     * @param[in] ptr   Shared pointer to template subclass implementation
+     */
+    BasicFuture(std::shared_ptr<Impl> ptr);
+
 public:
     /**
      * Default constructs.
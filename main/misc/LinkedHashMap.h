@@ -1,5 +1,9 @@
 /**
- * This file declares a thread-safe, combined doubly-linked list and hash table.
+ * This file declares a thread-safe map that remembers insertion order. The
+ * implementation is a flat, open-addressing hash table with robin-hood
+ * probing: entries live in a contiguous arena and insertion order is kept by
+ * indices into that arena, so lookups and age-ordered scans are sequential
+ * memory reads rather than pointer chases.
  *
  * Copyright 2017 University Corporation for Atmospheric Research. All Rights
  * reserved. See file "Copying" in the top-level source-directory for usage
@@ -13,46 +17,206 @@
 #ifndef MAIN_MISC_LINKEDHASHMAP_H_
 #define MAIN_MISC_LINKEDHASHMAP_H_
 
-#include <exception>
-#include <list>
-#include <memory>
+#include <cstddef>
+#include <functional>
 #include <mutex>
-#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace hycast {
 
 template<class Key, class Value>
 class LinkedHashMap
 {
-    typedef std::shared_ptr<Key> KeyPtr;
-    struct MapValue
+    typedef std::mutex             Mutex;
+    typedef std::lock_guard<Mutex> LockGuard;
+
+    /// Index value that denotes "no entry"
+    static const size_t npos = static_cast<size_t>(-1);
+
+    /// Entry in the contiguous arena
+    struct Entry
     {
-        KeyPtr prev;
-        KeyPtr next;
+        Key    key;
         Value  value;
+        size_t prev; ///< Arena-index of previously-inserted entry or `npos`
+        size_t next; ///< Arena-index of next-inserted entry or `npos`
 
-        inline MapValue(
-                const KeyPtr& prev,
-                const Value&  value)
-            : prev{prev}
-            , next{}
+        inline Entry(
+                const Key&   key,
+                const Value& value,
+                const size_t prev)
+            : key{key}
             , value{value}
+            , prev{prev}
+            , next{npos}
         {}
     };
-    typedef std::mutex             Mutex;
-    typedef std::lock_guard<Mutex> LockGuard;
 
-    std::unordered_map<Key, MapValue> map;
-    Mutex                          mutex;
-    KeyPtr                         front;
-    KeyPtr                         back;
+    /// Bucket of the open-addressing table
+    struct Bucket
+    {
+        size_t hash;  ///< Hash code of the key. Meaningful iff occupied.
+        size_t index; ///< Arena-index of the entry or `npos` if empty
+    };
+
+    Mutex               mutex;
+    std::vector<Entry>  entries;  ///< Contiguous arena of entries
+    std::vector<size_t> freeList; ///< Arena-indices of removed entries
+    std::vector<Bucket> buckets;  ///< Open-addressing table. Power-of-2 size.
+    size_t              numEntries;
+    size_t              head;     ///< Arena-index of oldest entry or `npos`
+    size_t              tail;     ///< Arena-index of newest entry or `npos`
+
+    /**
+     * Returns the distance of a bucket from the home bucket of the key it
+     * holds.
+     * @param[in] hash  Hash code of the held key
+     * @param[in] slot  Index of the bucket
+     */
+    inline size_t probeDist(
+            const size_t hash,
+            const size_t slot) const noexcept
+    {
+        const size_t mask = buckets.size() - 1;
+        return (slot + buckets.size() - (hash & mask)) & mask;
+    }
+
+    /**
+     * Returns the bucket that holds a key.
+     * @param[in] key   Key
+     * @param[in] hash  Hash code of `key`
+     * @return          Index of the bucket or `npos` if the key is absent
+     */
+    size_t findBucket(
+            const Key&   key,
+            const size_t hash) const noexcept
+    {
+        if (buckets.empty())
+            return npos;
+        const size_t mask = buckets.size() - 1;
+        size_t       slot = hash & mask;
+        size_t       dist = 0;
+        for (;;) {
+            const Bucket& bucket = buckets[slot];
+            if (bucket.index == npos)
+                return npos;
+            /*
+             * Robin-hood invariant: a resident that's closer to home than the
+             * probe is long would have been displaced by the sought key.
+             */
+            if (probeDist(bucket.hash, slot) < dist)
+                return npos;
+            if (bucket.hash == hash && entries[bucket.index].key == key)
+                return slot;
+            slot = (slot + 1) & mask;
+            ++dist;
+        }
+    }
+
+    /**
+     * Inserts an arena-index into the open-addressing table. Robin-hood
+     * probing: the displacement of residents that are closer to their home
+     * bucket bounds the variance of probe lengths.
+     * @param[in] hash   Hash code of the entry's key
+     * @param[in] index  Arena-index of the entry
+     * @pre              The table has a free bucket and doesn't hold the key
+     */
+    void insertBucket(
+            size_t hash,
+            size_t index) noexcept
+    {
+        const size_t mask = buckets.size() - 1;
+        size_t       slot = hash & mask;
+        size_t       dist = 0;
+        for (;;) {
+            Bucket& bucket = buckets[slot];
+            if (bucket.index == npos) {
+                bucket.hash = hash;
+                bucket.index = index;
+                return;
+            }
+            const size_t residentDist = probeDist(bucket.hash, slot);
+            if (residentDist < dist) {
+                std::swap(bucket.hash, hash);
+                std::swap(bucket.index, index);
+                dist = residentDist;
+            }
+            slot = (slot + 1) & mask;
+            ++dist;
+        }
+    }
+
+    /**
+     * Removes a bucket by shifting the following probe-sequence backward,
+     * which preserves the robin-hood invariant without tombstones.
+     * @param[in] slot  Index of the bucket to remove
+     */
+    void eraseBucket(size_t slot) noexcept
+    {
+        const size_t mask = buckets.size() - 1;
+        for (;;) {
+            const size_t  nextSlot = (slot + 1) & mask;
+            const Bucket& next = buckets[nextSlot];
+            if (next.index == npos || probeDist(next.hash, nextSlot) == 0) {
+                buckets[slot].index = npos;
+                return;
+            }
+            buckets[slot] = next;
+            slot = nextSlot;
+        }
+    }
+
+    /**
+     * Ensures the table can absorb one more entry at a load factor of at most
+     * 0.7. All-or-nothing: the new table is built aside and then swapped in.
+     * @throw std::bad_alloc  Required memory can't be allocated
+     */
+    void ensureCapacity()
+    {
+        if (10*(numEntries + 1) < 7*buckets.size())
+            return;
+        const size_t        newSize = buckets.empty() ? 16 : 2*buckets.size();
+        std::vector<Bucket> newBuckets(newSize, Bucket{0, npos});
+        newBuckets.swap(buckets);
+        for (size_t index = head; index != npos; index = entries[index].next)
+            insertBucket(std::hash<Key>()(entries[index].key), index);
+    }
+
+    /**
+     * Unlinks an entry from the insertion-order list and returns its arena
+     * slot to the free list.
+     * @param[in] index  Arena-index of the entry
+     */
+    void unlink(const size_t index) noexcept
+    {
+        Entry& entry = entries[index];
+        (entry.prev != npos)
+            ? (entries[entry.prev].next = entry.next)
+            : (head = entry.next);
+        (entry.next != npos)
+            ? (entries[entry.next].prev = entry.prev)
+            : (tail = entry.prev);
+        --numEntries;
+        if (numEntries == 0) {
+            // Cheap compaction: capacity is retained
+            entries.clear();
+            freeList.clear();
+        }
+        else {
+            freeList.push_back(index); // Can't throw: capacity was reserved
+        }
+    }
 
 public:
     LinkedHashMap()
-        : map{}
-        , mutex{}
-        , front{}
-        , back{}
+        : mutex{}
+        , entries{}
+        , freeList{}
+        , buckets{}
+        , numEntries{0}
+        , head{npos}
+        , tail{npos}
     {}
 
     /**
@@ -70,19 +234,29 @@ public:
             const Key&   key,
             const Value& value)
     {
-        LockGuard lock{mutex};
-        auto      pair = map.emplace(key, MapValue{back, value});
-        try {
-            if (!pair.second)
-                return false;
-            back = KeyPtr{new Key{key}};
-            if (!front)
-                front = back;
+        LockGuard    lock{mutex};
+        const size_t hash = std::hash<Key>()(key);
+        if (findBucket(key, hash) != npos)
+            return false;
+        ensureCapacity();
+        size_t index;
+        if (freeList.empty()) {
+            entries.push_back(Entry{key, value, tail});
+            index = entries.size() - 1;
+            freeList.reserve(entries.size()); // Keeps unlink() nothrow
         }
-        catch (const std::exception& ex) {
-            map.erase(key);
-            throw;
+        else {
+            index = freeList.back();
+            entries[index] = Entry{key, value, tail};
+            freeList.pop_back();
         }
+        // The remainder can't throw
+        insertBucket(hash, index);
+        (tail != npos)
+            ? (entries[tail].next = index)
+            : (head = index);
+        tail = index;
+        ++numEntries;
         return true;
     }
 
@@ -97,16 +271,13 @@ public:
     bool pop(Value& value) noexcept
     {
         LockGuard lock{mutex};
-        if (!front)
+        if (head == npos)
             return false;
-        KeyPtr    keyPtr = front;
-        MapValue& mapValue = map.at(*keyPtr);
-        value = mapValue.value;
-        front = mapValue.next;
-        front
-            ? map.at(*front).prev.reset()
-            : back.reset();
-        map.erase(*keyPtr);
+        const size_t index = head;
+        Entry&       entry = entries[index];
+        value = entry.value;
+        eraseBucket(findBucket(entry.key, std::hash<Key>()(entry.key)));
+        unlink(index);
         return true;
     }
 
@@ -120,20 +291,13 @@ public:
      */
     bool remove(Key& key) noexcept
     {
-        LockGuard lock{mutex};
-        auto iter = map.find(key);
-        if (iter == map.end())
+        LockGuard    lock{mutex};
+        const size_t slot = findBucket(key, std::hash<Key>()(key));
+        if (slot == npos)
             return false;
-        MapValue& mapValue = iter->second;
-        KeyPtr keyPtr = mapValue.prev;
-        keyPtr
-            ? (map.at(*keyPtr).next = mapValue.next)
-            : (front = mapValue.next);
-        keyPtr = mapValue.next;
-        keyPtr
-            ? (map.at(*keyPtr).prev = mapValue.prev)
-            : (back = mapValue.prev);
-        map.erase(iter);
+        const size_t index = buckets[slot].index;
+        eraseBucket(slot);
+        unlink(index);
         return true;
     }
 };
@@ -1,7 +1,12 @@
 /**
  * This file declares a mapping from a key to a list of values. It is similar to
  * `std::unordered_multimap` with the additional guarantee that the values in
- * each list are ordered by their time of addition (earliest to latest).
+ * each list are ordered by their time of addition (earliest to latest). The
+ * per-key lists are not `std::list`s: a key's first value is stored inline in
+ * its map entry -- so the common single-value key costs no list allocation at
+ * all -- and any further values live in a pooled arena of singly-linked nodes,
+ * so traversal follows indices into contiguous storage rather than chasing
+ * heap pointers.
  *
  * Copyright 2016 University Corporation for Atmospheric Research. All rights
  * reserved. See the file COPYING in the top-level source-directory for
@@ -14,11 +19,11 @@
 #ifndef MAP_OF_LISTS_H_
 #define MAP_OF_LISTS_H_
 
-#include <condition_variable>
-#include <list>
+#include <cstddef>
 #include <mutex>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 namespace hycast {
 
@@ -29,22 +34,151 @@ namespace hycast {
  */
 template<class K, class V>
 class MapOfLists final {
-    typedef std::unordered_map<K, std::list<V>> Map;
+    typedef std::mutex             Mutex;
+    typedef std::lock_guard<Mutex> LockGuard;
 
-    Map                             map;
-    mutable std::mutex              mutex;
-    mutable std::condition_variable cond;
+    /// Index value that denotes "no node"
+    static const size_t npos = static_cast<size_t>(-1);
+
+    /// Pool-allocated node that holds a value added after a key's first
+    struct Node
+    {
+        V      value; ///< The value
+        size_t next;  ///< Pool-index of the next-added node or `npos`
+
+        inline Node(
+                const V&     value,
+                const size_t next)
+            : value{value}
+            , next{next}
+        {}
+    };
+
+    /// Per-key entry. Holds the first-added value inline.
+    struct Entry
+    {
+        V      first; ///< First-added value
+        size_t head;  ///< Pool-index of the second-added value or `npos`
+        size_t tail;  ///< Pool-index of the last-added value or `npos`
+
+        inline explicit Entry(const V& first)
+            : first{first}
+            , head{npos}
+            , tail{npos}
+        {}
+    };
+
+    typedef std::unordered_map<K, Entry> Map;
+
+    Map                 map;
+    std::vector<Node>   pool;     ///< Pooled arena of chain nodes
+    std::vector<size_t> freeList; ///< Pool-indices of removed nodes
+    mutable Mutex       mutex;
 
     MapOfLists(const MapOfLists& map);
     MapOfLists& operator=(const MapOfLists& map);
+
+    /**
+     * Allocates a node from the pool.
+     * @param[in] value  Value the node is to hold
+     * @return           Pool-index of the node
+     */
+    size_t allocNode(const V& value)
+    {
+        if (freeList.empty()) {
+            pool.push_back(Node{value, npos});
+            return pool.size() - 1;
+        }
+        const size_t index = freeList.back();
+        pool[index] = Node{value, npos};
+        freeList.pop_back();
+        return index;
+    }
+
+    /**
+     * Returns a key's chain of nodes -- but not its inline first value -- to
+     * the free list.
+     * @param[in] entry  The key's entry
+     */
+    void freeChain(const Entry& entry)
+    {
+        for (size_t index = entry.head; index != npos;
+                index = pool[index].next)
+            freeList.push_back(index);
+    }
+
 public:
-    typedef typename Map::mapped_type::const_iterator ValueIterator;
-    typedef std::pair<ValueIterator, ValueIterator>   ValueBounds;
+    /**
+     * Const iterator over the values that have a particular key, in the order
+     * of their addition. Only valid while the containing map isn't modified.
+     */
+    class ValueIterator
+    {
+        friend class MapOfLists;
+
+        const MapOfLists* map;   ///< Containing map
+        const V*          first; ///< Inline first value or `nullptr` if past it
+        size_t            index; ///< Pool-index of the current node or `npos`
+
+        inline ValueIterator(
+                const MapOfLists* map,
+                const V*          first,
+                const size_t      index)
+            : map{map}
+            , first{first}
+            , index{index}
+        {}
+
+    public:
+        /**
+         * Default constructs an end-of-range iterator.
+         */
+        inline ValueIterator()
+            : map{nullptr}
+            , first{nullptr}
+            , index{npos}
+        {}
+
+        inline const V& operator *() const
+        {
+            return first ? *first : map->pool[index].value;
+        }
+
+        inline ValueIterator& operator ++()
+        {
+            if (first) {
+                first = nullptr;
+            }
+            else {
+                index = map->pool[index].next;
+            }
+            return *this;
+        }
+
+        inline bool operator ==(const ValueIterator& that) const
+        {
+            return first == that.first && index == that.index;
+        }
+
+        inline bool operator !=(const ValueIterator& that) const
+        {
+            return !(*this == that);
+        }
+    };
+
+    typedef std::pair<ValueIterator, ValueIterator> ValueBounds;
+
     /**
      * Constructs from the initial number of keys.
      * @param[in] numKeys  Initial number of keys
      */
-    explicit MapOfLists(unsigned numKeys = 0);
+    explicit MapOfLists(unsigned numKeys = 0)
+        : map{numKeys}
+        , pool{}
+        , freeList{}
+        , mutex{}
+    {}
+
     /**
      * Adds a value to the list of values that have a particular key-of-data.
      * The list is ordered by insertion with the first added value at the front.
@@ -55,7 +189,21 @@ public:
      */
     void add(
             const K& key,
-            V&       value);
+            V&       value)
+    {
+        LockGuard lock{mutex};
+        auto      pair = map.emplace(key, Entry{value});
+        if (!pair.second) {
+            // Not the key's first value: append a pooled node to its chain
+            const size_t index = allocNode(value);
+            Entry&       entry = pair.first->second;
+            (entry.tail != npos)
+                ? (pool[entry.tail].next = index)
+                : (entry.head = index);
+            entry.tail = index;
+        }
+    }
+
     /**
      * Returns the bounds of a range that includes all the values that have a
      * given key. The values are in the same order in which they were added.
@@ -66,14 +214,33 @@ public:
      * @exceptionsafety Basic guarantee
      * @threadsafety    Safe
      */
-    std::pair<ValueIterator, ValueIterator> getValues(const K& key) const;
+    ValueBounds getValues(const K& key) const
+    {
+        LockGuard lock{mutex};
+        const auto iter = map.find(key);
+        if (iter == map.end())
+            return ValueBounds{ValueIterator{}, ValueIterator{}};
+        const Entry& entry = iter->second;
+        return ValueBounds{ValueIterator{this, &entry.first, entry.head},
+                ValueIterator{}};
+    }
+
     /**
      * Removes a particular key and all the values associated with it.
      * @param[in] key   Key
      * @exceptionsafety Basic guarantee
      * @threadsafety    Safe
      */
-    void remove(const K& key);
+    void remove(const K& key)
+    {
+        LockGuard  lock{mutex};
+        const auto iter = map.find(key);
+        if (iter != map.end()) {
+            freeChain(iter->second);
+            map.erase(iter);
+        }
+    }
+
     /**
      * Removes a value from from the list of values associated with a particular
      * key.
@@ -85,7 +252,45 @@ public:
      */
     void remove(
             const K& key,
-            const V& value);
+            const V& value)
+    {
+        LockGuard  lock{mutex};
+        const auto iter = map.find(key);
+        if (iter == map.end())
+            return;
+        Entry& entry = iter->second;
+        // Remove every match in the chain
+        size_t prev = npos;
+        for (size_t index = entry.head; index != npos; ) {
+            const size_t next = pool[index].next;
+            if (pool[index].value == value) {
+                (prev != npos)
+                    ? (pool[prev].next = next)
+                    : (entry.head = next);
+                if (entry.tail == index)
+                    entry.tail = prev;
+                freeList.push_back(index);
+            }
+            else {
+                prev = index;
+            }
+            index = next;
+        }
+        // Then the inline first value; the chain's head can't match anymore
+        if (entry.first == value) {
+            const size_t head = entry.head;
+            if (head == npos) {
+                map.erase(iter); // The key's list is now empty
+            }
+            else {
+                entry.first = pool[head].value;
+                entry.head = pool[head].next;
+                if (entry.tail == head)
+                    entry.tail = npos;
+                freeList.push_back(head);
+            }
+        }
+    }
 };
 
 } // namespace
@@ -0,0 +1,212 @@
+/**
+ * This file implements a memory-budget manager.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All Rights
+ * reserved. See file "COPYING" in the top-level source-directory for usage
+ * restrictions.
+ *
+ *        File: MemBudget.cpp
+ *  Created on: Aug 29, 2017
+ *      Author: Steven R. Emmerson
+ */
+
+#include "config.h"
+
+#include "error.h"
+#include "MemBudget.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+namespace hycast {
+
+class MemBudget::Impl final
+{
+    typedef std::mutex              Mutex;
+    typedef std::lock_guard<Mutex>  LockGuard;
+    typedef std::unique_lock<Mutex> UniqueLock;
+
+    /// Fraction of the ceiling at which the oldest products are evicted early
+    static constexpr double         shrinkFraction = 0.80;
+    /// Fraction of the ceiling at which complete products are compressed
+    static constexpr double         compressFraction = 0.90;
+    /// Fraction of the ceiling at which backlog production is paused
+    static constexpr double         pauseFraction = 0.95;
+
+    mutable Mutex                   mutex;
+    mutable std::condition_variable cond;
+    const size_t                    ceiling;
+    size_t                          usage;
+    Level                           level;
+    std::vector<Observer>           observers;
+
+    /**
+     * Returns the pressure-level that corresponds to a usage.
+     * @param[in] usage  Number of claimed bytes
+     * @return           Corresponding pressure-level
+     */
+    Level levelOf(const size_t usage) const noexcept
+    {
+        if (usage >= ceiling)
+            return Level::BACKPRESSURE;
+        if (usage >= static_cast<size_t>(ceiling*pauseFraction))
+            return Level::PAUSE_BACKLOG;
+        if (usage >= static_cast<size_t>(ceiling*compressFraction))
+            return Level::COMPRESS_COLD;
+        if (usage >= static_cast<size_t>(ceiling*shrinkFraction))
+            return Level::SHRINK_RESIDENCE;
+        return Level::NONE;
+    }
+
+    /**
+     * Updates the pressure-level after a change in usage. If the level
+     * changed, then waiting threads are awoken and the observers are invoked
+     * without the lock so an observer may claim or release.
+     * @pre             `lock` references a locked `mutex`
+     * @param[in] lock  Lock on `mutex`
+     */
+    void updateLevel(UniqueLock& lock)
+    {
+        const auto newLevel = levelOf(usage);
+        if (newLevel == level)
+            return;
+        level = newLevel;
+        cond.notify_all();
+        auto copies = observers; // Observers may be added concurrently
+        lock.unlock();
+        for (auto& observer : copies) {
+            try {
+                observer(newLevel);
+            }
+            catch (const std::exception& e) {
+                log_error(e); // Observers are advisory
+            }
+        }
+    }
+
+public:
+    /**
+     * Constructs.
+     * @param[in] ceiling      Ceiling, in bytes, on the sum of claimed
+     *                         allocations
+     * @throw InvalidArgument  `ceiling == 0`
+     */
+    explicit Impl(const size_t ceiling)
+        : mutex{}
+        , cond{}
+        , ceiling{ceiling}
+        , usage{0}
+        , level{Level::NONE}
+        , observers{}
+    {
+        if (ceiling == 0)
+            throw INVALID_ARGUMENT("Memory-budget ceiling is zero");
+    }
+
+    /**
+     * Prevents copy and move construction and assignment.
+     */
+    Impl(const Impl& that) =delete;
+    Impl(const Impl&& that) =delete;
+    Impl& operator=(const Impl& rhs) =delete;
+    Impl& operator=(const Impl&& rhs) =delete;
+
+    void claim(const size_t nbytes)
+    {
+        UniqueLock lock{mutex};
+        usage += nbytes;
+        updateLevel(lock);
+    }
+
+    void release(const size_t nbytes)
+    {
+        UniqueLock lock{mutex};
+        usage -= (nbytes < usage) ? nbytes : usage;
+        updateLevel(lock);
+    }
+
+    size_t getUsage() const
+    {
+        LockGuard lock{mutex};
+        return usage;
+    }
+
+    size_t getCeiling() const noexcept
+    {
+        return ceiling;
+    }
+
+    Level getLevel() const
+    {
+        LockGuard lock{mutex};
+        return level;
+    }
+
+    void observe(const Observer& observer)
+    {
+        LockGuard lock{mutex};
+        observers.push_back(observer);
+    }
+
+    void awaitBelow(const Level level) const
+    {
+        UniqueLock lock{mutex};
+        while (this->level >= level)
+            cond.wait(lock); // Cancellation point
+    }
+};
+
+constexpr double MemBudget::Impl::shrinkFraction;
+constexpr double MemBudget::Impl::compressFraction;
+constexpr double MemBudget::Impl::pauseFraction;
+
+MemBudget::MemBudget(const size_t ceiling)
+    : pImpl{new Impl(ceiling)}
+{}
+
+MemBudget::operator bool() const noexcept
+{
+    return pImpl.operator bool();
+}
+
+void MemBudget::claim(const size_t nbytes) const
+{
+    if (pImpl)
+        pImpl->claim(nbytes);
+}
+
+void MemBudget::release(const size_t nbytes) const
+{
+    if (pImpl)
+        pImpl->release(nbytes);
+}
+
+size_t MemBudget::getUsage() const
+{
+    return pImpl ? pImpl->getUsage() : 0;
+}
+
+size_t MemBudget::getCeiling() const
+{
+    return pImpl ? pImpl->getCeiling() : 0;
+}
+
+MemBudget::Level MemBudget::getLevel() const
+{
+    return pImpl ? pImpl->getLevel() : Level::NONE;
+}
+
+void MemBudget::observe(const Observer& observer) const
+{
+    if (pImpl)
+        pImpl->observe(observer);
+}
+
+void MemBudget::awaitBelow(const Level level) const
+{
+    if (pImpl)
+        pImpl->awaitBelow(level);
+}
+
+} // namespace
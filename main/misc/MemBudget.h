@@ -0,0 +1,141 @@
+/**
+ * This file declares a memory-budget manager. Components whose memory use
+ * grows with traffic -- the product-store, chunk buffers, backlog queues --
+ * register their allocations with a shared budget, which enforces a
+ * configurable ceiling through graduated responses instead of letting the
+ * components' sum grow until the process is killed.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All Rights
+ * reserved. See file "Copying" in the top-level source-directory for usage
+ * restrictions.
+ *
+ *        File: MemBudget.h
+ *  Created on: Aug 29, 2017
+ *      Author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_MISC_MEMBUDGET_H_
+#define MAIN_MISC_MEMBUDGET_H_
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+namespace hycast {
+
+/**
+ * A memory budget shared by the components of a node. Each component claims
+ * the bytes it allocates and releases the bytes it frees; the budget derives
+ * a pressure-level from the running sum and notifies observers when the
+ * level changes, so degradation under a backlog storm is graduated and
+ * predictable rather than an out-of-memory kill.
+ */
+class MemBudget final
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Pressure-level of the budget. The levels are ordered: each response
+     * includes those of the lower levels.
+     */
+    enum class Level {
+        NONE,             ///< Usage is comfortably below the ceiling
+        SHRINK_RESIDENCE, ///< Evict the oldest products before their
+                          ///< minimum residence-time elapses
+        COMPRESS_COLD,    ///< Additionally compress complete products
+                          ///< without waiting for the cold-tier age
+        PAUSE_BACKLOG,    ///< Additionally pause backlog production
+        BACKPRESSURE      ///< Additionally stop scheduling new chunk-requests
+    };
+
+    /**
+     * Function invoked when the pressure-level changes. Level changes can be
+     * reported out of order under concurrent claims and releases, so an
+     * observer must act on the given level alone and be idempotent.
+     */
+    typedef std::function<void(Level)> Observer;
+
+    /**
+     * Default constructs. The resulting instance has no ceiling: claims and
+     * releases are ignored and the pressure-level is always `Level::NONE`.
+     * Components can therefore hold a budget unconditionally.
+     */
+    MemBudget() =default;
+
+    /**
+     * Constructs.
+     * @param[in] ceiling      Ceiling, in bytes, on the sum of claimed
+     *                         allocations
+     * @throw InvalidArgument  `ceiling == 0`
+     */
+    explicit MemBudget(const size_t ceiling);
+
+    /**
+     * Indicates if this instance has a ceiling.
+     * @retval `true`   This instance has a ceiling
+     * @retval `false`  This instance was default constructed
+     */
+    operator bool() const noexcept;
+
+    /**
+     * Claims bytes against the budget. A claim is never refused -- the
+     * graduated responses of the observers, not allocation failure, relieve
+     * the pressure. Observers are notified if the pressure-level changes.
+     * @param[in] nbytes  Number of bytes allocated
+     * @exceptionsafety   Basic guarantee
+     * @threadsafety      Safe
+     */
+    void claim(const size_t nbytes) const;
+
+    /**
+     * Releases previously-claimed bytes. Observers are notified if the
+     * pressure-level changes.
+     * @param[in] nbytes  Number of bytes freed
+     * @exceptionsafety   Basic guarantee
+     * @threadsafety      Safe
+     */
+    void release(const size_t nbytes) const;
+
+    /**
+     * Returns the number of currently-claimed bytes.
+     * @return Number of claimed bytes
+     */
+    size_t getUsage() const;
+
+    /**
+     * Returns the ceiling on the sum of claimed allocations.
+     * @return Ceiling in bytes. Will be 0 if this instance has no ceiling.
+     */
+    size_t getCeiling() const;
+
+    /**
+     * Returns the current pressure-level.
+     * @return Current pressure-level
+     */
+    Level getLevel() const;
+
+    /**
+     * Registers an observer of pressure-level changes. The observer is
+     * invoked -- on the thread of the claim or release that changed the
+     * level -- every time the level changes.
+     * @param[in] observer  Observer of pressure-level changes
+     * @exceptionsafety     Strong guarantee
+     * @threadsafety        Safe
+     */
+    void observe(const Observer& observer) const;
+
+    /**
+     * Blocks while the pressure-level is at or above the given level.
+     * Returns immediately if this instance has no ceiling. This is a
+     * cancellation point.
+     * @param[in] level  Pressure-level below which to wait
+     * @threadsafety     Safe
+     */
+    void awaitBelow(const Level level) const;
+};
+
+} // namespace
+
+#endif /* MAIN_MISC_MEMBUDGET_H_ */
@@ -0,0 +1,98 @@
+/**
+ * This file implements the page-fault-proofing mode. `mlockall()` with
+ * `MCL_FUTURE` is used rather than per-region `mlock()` calls: it covers
+ * every hot region -- including ones allocated later, such as pooled chunk
+ * buffers and thread stacks -- without each allocator having to know about
+ * the mode, and a locked page is faulted in by the kernel at allocation.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *        File: MemResidency.cpp
+ *  Created on: Aug 30, 2026
+ *      Author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "MemResidency.h"
+#include "error.h"
+#include "logging.h"
+#include "Metrics.h"
+
+#include <alloca.h>
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace hycast {
+
+/// Whether `mlockall()` has been successfully called
+static std::atomic<bool> enabled{false};
+
+void MemResidency::enable()
+{
+    static std::mutex     mutex;
+    static Metrics::Gauge lockedGauge{};
+
+    std::lock_guard<std::mutex> lock{mutex};
+    if (enabled.load(std::memory_order_acquire))
+        return; // Already enabled
+    if (::mlockall(MCL_CURRENT|MCL_FUTURE))
+        throw SYSTEM_ERROR("Couldn't lock process's pages into memory. "
+                "Check CAP_IPC_LOCK and RLIMIT_MEMLOCK.");
+    lockedGauge = Metrics::registerGauge("hycast_locked_memory_bytes",
+            "Amount of the process's memory that is locked",
+            []{return static_cast<double>(lockedBytes());});
+    enabled.store(true, std::memory_order_release);
+    LOG_NOTE("Locked process's pages into memory: " +
+            std::to_string(lockedBytes()) + " bytes currently locked");
+}
+
+bool MemResidency::isEnabled() noexcept
+{
+    return enabled.load(std::memory_order_acquire);
+}
+
+void MemResidency::prefaultStack(const size_t numBytes) noexcept
+{
+    if (numBytes == 0)
+        return;
+    const size_t pageSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    /*
+     * The region is part of this call's frame, so its pages are faulted in
+     * -- and, when the mode is enabled, locked -- before the call returns
+     * and stay allocated for the thread's deeper frames to reuse.
+     */
+    volatile char* const region =
+            static_cast<volatile char*>(::alloca(numBytes));
+    for (size_t offset = 0; offset < numBytes; offset += pageSize)
+        region[offset] = 0;
+    region[numBytes-1] = 0;
+}
+
+size_t MemResidency::lockedBytes() noexcept
+{
+    try {
+        std::ifstream status{"/proc/self/status"};
+        std::string   line;
+        while (std::getline(status, line)) {
+            if (line.compare(0, 6, "VmLck:") == 0) {
+                std::istringstream parser{line.substr(6)};
+                size_t             kibiBytes;
+                if (parser >> kibiBytes)
+                    return kibiBytes * 1024;
+                break;
+            }
+        }
+    }
+    catch (const std::exception& ex) {
+    }
+    return 0;
+}
+
+} // namespace
@@ -0,0 +1,78 @@
+/**
+ * This file declares a page-fault-proofing mode for latency-critical
+ * processes. Enabling it locks the process's pages into memory -- current
+ * and future, so the chunk arena, codec buffers, and thread stacks stay
+ * resident -- and helpers pre-fault lazily-allocated regions at startup so
+ * the first touch on the receive path never takes a major fault.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *        File: MemResidency.h
+ *  Created on: Aug 30, 2026
+ *      Author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_MISC_MEMRESIDENCY_H_
+#define MAIN_MISC_MEMRESIDENCY_H_
+
+#include <cstddef>
+
+namespace hycast {
+
+/**
+ * Process-wide memory-residency hardening. All members are static: page
+ * locking is a per-process property.
+ */
+class MemResidency final
+{
+public:
+    MemResidency() =delete;
+
+    /**
+     * Locks the process's current and future pages into memory and registers
+     * a gauge, `hycast_locked_memory_bytes`, that reports the locked amount.
+     * Should be called at startup, before the hot regions are allocated, so
+     * they are locked -- and thereby faulted in -- at allocation. Idempotent.
+     * @throw SystemError  `mlockall()` failed. Typically the process lacks
+     *                     `CAP_IPC_LOCK` or its `RLIMIT_MEMLOCK` is too low.
+     * @exceptionsafety    Strong guarantee
+     * @threadsafety       Safe
+     */
+    static void enable();
+
+    /**
+     * Indicates if page locking is enabled.
+     * @retval `true`    Pages are locked
+     * @retval `false`   Pages are not locked
+     * @exceptionsafety  Nothrow
+     * @threadsafety     Safe
+     */
+    static bool isEnabled() noexcept;
+
+    /**
+     * Pre-faults the calling thread's stack by touching the given number of
+     * bytes below the current frame. A thread's stack is allocated lazily,
+     * one page per fault, so a latency-critical thread should call this
+     * once, when it starts, with its expected peak stack depth.
+     * @param[in] numBytes  Number of bytes of stack to pre-fault
+     * @exceptionsafety     Nothrow
+     * @threadsafety        Safe
+     */
+    static void prefaultStack(const size_t numBytes) noexcept;
+
+    /**
+     * Returns the amount of the process's memory that is locked -- i.e.,
+     * `VmLck` from `/proc/self/status`.
+     * @return           Amount of locked memory in bytes or 0 if the amount
+     *                   can't be determined
+     * @exceptionsafety  Nothrow
+     * @threadsafety     Safe
+     */
+    static size_t lockedBytes() noexcept;
+};
+
+} // namespace
+
+#endif /* MAIN_MISC_MEMRESIDENCY_H_ */
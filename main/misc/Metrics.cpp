@@ -0,0 +1,246 @@
+/**
+ * This file implements a process-wide registry of operational metrics and a
+ * server that exports them in Prometheus text format.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: Metrics.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "error.h"
+#include "logging.h"
+#include "Metrics.h"
+#include "Thread.h"
+
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace hycast {
+
+namespace {
+    /**
+     * The registry proper. A Meyers singleton so instrumented static
+     * initializers may register metrics in any order.
+     */
+    struct Registry final
+    {
+        /// One registered series: a counter or a sampled gauge
+        struct Entry final
+        {
+            std::string                       help;
+            std::unique_ptr<Metrics::Counter> counter; ///< `nullptr` => gauge
+            Metrics::Sampler                  sampler;
+        };
+
+        std::mutex mutex;
+        /// Series by name. Ordered so a family's series report contiguously.
+        std::map<std::string, Entry> entries;
+
+        static Registry& instance()
+        {
+            static Registry registry{};
+            return registry;
+        }
+
+        /// Returns a series-name's family name (the part before a label-set)
+        static std::string familyOf(const std::string& name)
+        {
+            return name.substr(0, name.find('{'));
+        }
+    };
+}
+
+class Metrics::Gauge::Impl final
+{
+    std::string name;
+
+public:
+    explicit Impl(const std::string& name)
+        : name{name}
+    {}
+
+    ~Impl() noexcept
+    {
+        auto& registry = Registry::instance();
+        std::lock_guard<std::mutex> lock{registry.mutex};
+        registry.entries.erase(name);
+    }
+};
+
+Metrics::Gauge::Gauge(Impl* const impl)
+    : pImpl{impl}
+{}
+
+Metrics::Counter& Metrics::getCounter(
+        const std::string& name,
+        const std::string& help)
+{
+    auto&                       registry = Registry::instance();
+    std::lock_guard<std::mutex> lock{registry.mutex};
+    auto                        iter = registry.entries.find(name);
+    if (iter == registry.entries.end()) {
+        auto& entry = registry.entries[name];
+        entry.help = help;
+        entry.counter.reset(new Counter{});
+        return *entry.counter;
+    }
+    if (!iter->second.counter)
+        throw LOGIC_ERROR("Metric \"" + name + "\" is a gauge");
+    return *iter->second.counter;
+}
+
+Metrics::Gauge Metrics::registerGauge(
+        const std::string& name,
+        const std::string& help,
+        const Sampler&     sampler)
+{
+    auto&                       registry = Registry::instance();
+    std::lock_guard<std::mutex> lock{registry.mutex};
+    if (registry.entries.count(name))
+        throw INVALID_ARGUMENT("Metric \"" + name + "\" already registered");
+    auto& entry = registry.entries[name];
+    entry.help = help;
+    entry.sampler = sampler;
+    return Gauge{new Gauge::Impl(name)};
+}
+
+void Metrics::report(std::ostream& ostream)
+{
+    auto&                       registry = Registry::instance();
+    std::lock_guard<std::mutex> lock{registry.mutex};
+    std::string                 prevFamily;
+    for (const auto& elt : registry.entries) {
+        const auto& name = elt.first;
+        const auto& entry = elt.second;
+        const auto  family = Registry::familyOf(name);
+        if (family != prevFamily) {
+            ostream << "# HELP " << family << ' ' << entry.help << '\n';
+            ostream << "# TYPE " << family
+                    << (entry.counter ? " counter\n" : " gauge\n");
+            prevFamily = family;
+        }
+        if (entry.counter) {
+            ostream << name << ' ' << entry.counter->get() << '\n';
+        }
+        else {
+            ostream << name << ' ' << entry.sampler() << '\n';
+        }
+    }
+}
+
+class MetricsServer::Impl final
+{
+    std::string pathname;
+    int         sd;
+    Thread      serverThread;
+
+    /**
+     * Serves one scrape: renders the registry and writes it to the
+     * connection. A half-written scrape (e.g., the scraper hung up) is the
+     * scraper's problem, not ours.
+     * @param[in] sd  Connection socket descriptor. Closed on return.
+     */
+    static void serve(const int sd) noexcept
+    {
+        try {
+            std::ostringstream oss;
+            Metrics::report(oss);
+            const auto  text = oss.str();
+            const char* bytes = text.data();
+            size_t      left = text.size();
+            while (left > 0) {
+                const auto nbytes = ::write(sd, bytes, left);
+                if (nbytes < 0)
+                    break;
+                bytes += nbytes;
+                left -= nbytes;
+            }
+        }
+        catch (const std::exception& e) {
+            log_warn(e); // Because end of thread
+        }
+        ::close(sd);
+    }
+
+    /**
+     * Accepts scrape connections. Doesn't return unless an exception is
+     * thrown. Intended to be run on a separate thread.
+     * @exceptionsafety  Basic guarantee
+     * @threadsafety     Compatible but not safe
+     */
+    void runServer()
+    {
+        try {
+            for (;;) {
+                const auto connSd = ::accept(sd, nullptr, nullptr); // Blocks
+                if (connSd < 0)
+                    throw SYSTEM_ERROR(
+                            "accept() failure on metrics socket " + pathname);
+                serve(connSd);
+            }
+        }
+        catch (const std::exception& e) {
+            log_error(e); // Because end of thread
+        }
+    }
+
+public:
+    /**
+     * Constructs.
+     * @param[in] pathname  Pathname of the Unix-domain socket to serve on
+     * @throw SystemError   Socket couldn't be created or bound
+     */
+    explicit Impl(const std::string& pathname)
+        : pathname{pathname}
+        , sd{::socket(AF_UNIX, SOCK_STREAM, 0)}
+        , serverThread{}
+    {
+        if (sd < 0)
+            throw SYSTEM_ERROR("Couldn't create metrics socket " + pathname);
+        try {
+            struct sockaddr_un sockAddr = {};
+            sockAddr.sun_family = AF_UNIX;
+            if (pathname.size() >= sizeof(sockAddr.sun_path))
+                throw INVALID_ARGUMENT("Metrics socket pathname \"" +
+                        pathname + "\" is too long");
+            pathname.copy(sockAddr.sun_path, sizeof(sockAddr.sun_path)-1);
+            ::unlink(pathname.c_str()); // Remove stale socket-file
+            if (::bind(sd, reinterpret_cast<struct sockaddr*>(&sockAddr),
+                    sizeof(sockAddr)) ||
+                    ::listen(sd, 8))
+                throw SYSTEM_ERROR(
+                        "Couldn't serve on metrics socket " + pathname);
+            serverThread = Thread{[this]{runServer();}};
+        }
+        catch (const std::exception& e) {
+            ::close(sd);
+            throw;
+        }
+    }
+
+    ~Impl() noexcept
+    {
+        try {
+            serverThread.cancel(); // `accept()` is a cancellation point
+        }
+        catch (const std::exception& e) {
+            log_error(e); // Because destructors mustn't throw
+        }
+        ::close(sd);
+        ::unlink(pathname.c_str());
+    }
+};
+
+MetricsServer::MetricsServer(const std::string& pathname)
+    : pImpl{new Impl(pathname)}
+{}
+
+} // namespace
@@ -0,0 +1,161 @@
+/**
+ * This file declares a process-wide registry of operational metrics and a
+ * server that exports them, on demand, in Prometheus text format. Counters
+ * are single relaxed atomic adds and gauges are sampled only when scraped,
+ * so instrumented hot paths pay nothing when nobody is looking.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: Metrics.h
+ * @author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_MISC_METRICS_H_
+#define MAIN_MISC_METRICS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace hycast {
+
+/**
+ * Process-wide registry of metrics. A metric's name may carry a Prometheus
+ * label-set (e.g., `hycast_chunks_total{transport="mcast"}`); series whose
+ * names share the part before the label-set are reported as one metric
+ * family.
+ */
+class Metrics final
+{
+public:
+    /**
+     * A monotonic counter. Obtained once -- typically into a static reference
+     * -- and then incremented from the hot path.
+     */
+    class Counter final
+    {
+        friend class Metrics;
+
+        std::atomic<uint64_t> count;
+
+        Counter()
+            : count{0}
+        {}
+
+        Counter(const Counter&) = delete;
+        Counter& operator=(const Counter&) = delete;
+
+    public:
+        /**
+         * Adds to the counter. A single relaxed atomic add.
+         * @param[in] amount  Amount to add
+         * @exceptionsafety   Nothrow
+         * @threadsafety      Safe
+         */
+        inline void add(const uint64_t amount = 1) noexcept
+        {
+            count.fetch_add(amount, std::memory_order_relaxed);
+        }
+
+        /**
+         * Returns the current value.
+         * @exceptionsafety  Nothrow
+         * @threadsafety     Safe
+         */
+        inline uint64_t get() const noexcept
+        {
+            return count.load(std::memory_order_relaxed);
+        }
+    };
+
+    /// Function that samples a gauge's current value. Called at scrape-time
+    /// on the scraping thread, so it must be thread-safe.
+    typedef std::function<double()> Sampler;
+
+    /**
+     * Handle for a registered gauge. Destruction of the last copy
+     * deregisters the gauge, so an object that registers a gauge over its
+     * own state keeps the handle as a member and the gauge can't outlive
+     * the state it samples.
+     */
+    class Gauge final
+    {
+        friend class Metrics;
+
+        class                 Impl;
+        std::shared_ptr<Impl> pImpl;
+
+        explicit Gauge(Impl* impl);
+
+    public:
+        Gauge() =default;
+    };
+
+    /**
+     * Returns the counter with the given name, creating it if necessary. The
+     * returned reference remains valid for the life of the process.
+     * @param[in] name     Name of the counter. Should end in `_total` per
+     *                     Prometheus convention. May carry a label-set.
+     * @param[in] help     One-line description for the `# HELP` annotation
+     * @return             Corresponding counter
+     * @throw LogicError   Name is registered as a gauge
+     * @exceptionsafety    Strong guarantee
+     * @threadsafety       Safe
+     */
+    static Counter& getCounter(
+            const std::string& name,
+            const std::string& help);
+
+    /**
+     * Registers a gauge.
+     * @param[in] name         Name of the gauge. May carry a label-set.
+     * @param[in] help         One-line description for the `# HELP`
+     *                         annotation
+     * @param[in] sampler      Returns the gauge's current value
+     * @return                 Handle whose destruction deregisters the gauge
+     * @throw InvalidArgument  Name is already registered
+     * @exceptionsafety        Strong guarantee
+     * @threadsafety           Safe
+     */
+    static Gauge registerGauge(
+            const std::string& name,
+            const std::string& help,
+            const Sampler&     sampler);
+
+    /**
+     * Writes all registered metrics to a stream in Prometheus text format
+     * (version 0.0.4).
+     * @param[in] ostream  Output stream
+     * @threadsafety       Safe
+     */
+    static void report(std::ostream& ostream);
+};
+
+/**
+ * Server that dumps the metric registry to whoever connects to its
+ * Unix-domain socket -- e.g., a Prometheus node-exporter textfile hook or a
+ * curious operator with `nc -U`. Runs on its own thread; the instrumented
+ * paths are never involved in a scrape.
+ */
+class MetricsServer final
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Constructs. Any stale socket-file at the pathname is removed first.
+     * @param[in] pathname  Pathname of the Unix-domain socket to serve on
+     * @throw SystemError   Socket couldn't be created or bound
+     */
+    explicit MetricsServer(const std::string& pathname);
+};
+
+} // namespace
+
+#endif /* MAIN_MISC_METRICS_H_ */
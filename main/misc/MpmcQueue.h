@@ -0,0 +1,186 @@
+/**
+ * This file declares a bounded, lock-free, multiple-producer/multiple-consumer
+ * queue. Slots carry per-slot sequence numbers (Vyukov's design) so producers
+ * and consumers synchronize through a single compare-and-swap each, with no
+ * mutex on the hot path.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research
+ * See file "Copying" in the top-level source-directory for terms and
+ * conditions.
+ *
+ * MpmcQueue.h
+ *
+ *  Created on: Aug 29, 2017
+ *      Author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_MISC_MPMCQUEUE_H_
+#define MAIN_MISC_MPMCQUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+namespace hycast {
+
+template<class T>
+class MpmcQueue final
+{
+    struct Slot
+    {
+        std::atomic<size_t> seq;
+        T                   obj;
+    };
+
+    const size_t                  capacity; /// Number of slots. Power of two.
+    const size_t                  mask;     /// `capacity - 1`
+    std::unique_ptr<Slot[]>       slots;
+    /// Index of the next slot to fill. Monotonically increasing.
+    alignas(64) std::atomic<size_t> head;
+    /// Index of the next slot to drain. Monotonically increasing.
+    alignas(64) std::atomic<size_t> tail;
+
+    /**
+     * Rounds a value up to the next power of two.
+     * @param[in] n  Value to round up
+     * @return       Smallest power of two that's not less than `n`
+     */
+    static size_t ceilPow2(size_t n)
+    {
+        size_t result = 1;
+        while (result < n)
+            result <<= 1;
+        return result;
+    }
+
+public:
+    /**
+     * Constructs.
+     * @param[in] minCapacity  Minimum number of unconsumed objects the queue
+     *                         can hold. Rounded up to a power of two.
+     * @throws std::invalid_argument  `minCapacity == 0`
+     */
+    explicit MpmcQueue(const size_t minCapacity)
+        : capacity{ceilPow2(minCapacity)}
+        , mask{capacity - 1}
+        , slots{new Slot[capacity]}
+        , head{0}
+        , tail{0}
+    {
+        if (minCapacity == 0)
+            throw std::invalid_argument("Zero queue capacity");
+        for (size_t i = 0; i < capacity; ++i)
+            slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    MpmcQueue(const MpmcQueue& that) = delete;
+    MpmcQueue(const MpmcQueue&& that) = delete;
+    MpmcQueue& operator =(const MpmcQueue& rhs) = delete;
+    MpmcQueue& operator =(const MpmcQueue&& rhs) = delete;
+
+    /**
+     * Tries to add an object to the queue. Doesn't block.
+     * @param[in] obj   Object to add
+     * @retval `true`   Object was added
+     * @retval `false`  Queue is full
+     * @exceptionsafety Nothrow if `T`'s copy assignment is nothrow
+     * @threadsafety    Safe
+     */
+    bool tryPush(const T& obj)
+    {
+        size_t pos = head.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot&          slot = slots[pos & mask];
+            const size_t   seq = slot.seq.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(seq) -
+                    static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1,
+                        std::memory_order_relaxed)) {
+                    slot.obj = obj;
+                    slot.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false; // Queue is full
+            }
+            else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * Tries to remove the oldest object from the queue. Doesn't block.
+     * @param[out] obj  Removed object. Set iff `true` is returned.
+     * @retval `true`   Object was removed
+     * @retval `false`  Queue is empty
+     * @exceptionsafety Nothrow if `T`'s copy assignment is nothrow
+     * @threadsafety    Safe
+     */
+    bool tryPop(T& obj)
+    {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot&          slot = slots[pos & mask];
+            const size_t   seq = slot.seq.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(seq) -
+                    static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1,
+                        std::memory_order_relaxed)) {
+                    obj = slot.obj;
+                    slot.seq.store(pos + capacity, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false; // Queue is empty
+            }
+            else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * Adds an object to the queue. Blocks while the queue is full.
+     * @param[in] obj  Object to add
+     * @threadsafety   Safe
+     */
+    void push(const T& obj)
+    {
+        while (!tryPush(obj))
+            std::this_thread::yield();
+    }
+
+    /**
+     * Removes and returns the oldest object in the queue. Blocks while the
+     * queue is empty.
+     * @return        Removed object
+     * @threadsafety  Safe
+     */
+    T pop()
+    {
+        T obj;
+        while (!tryPop(obj))
+            std::this_thread::yield();
+        return obj;
+    }
+
+    /**
+     * Returns the number of slots in the queue.
+     * @return Number of slots
+     */
+    size_t getCapacity() const noexcept
+    {
+        return capacity;
+    }
+};
+
+} // namespace
+
+#endif /* MAIN_MISC_MPMCQUEUE_H_ */
@@ -1,6 +1,8 @@
 /**
- * This file implements a mutex like std::mutex but one that keeps track of the
- * lock state and the owning thread.
+ * This file implements the contention-profiling mode of `MyMutex`: a
+ * process-wide registry accumulates per-name wait tallies and reports the
+ * most contended names at shutdown. The checking and release modes are
+ * entirely inline in MyMutex.h.
  *
  * Copyright 2016 University Corporation for Atmospheric Research. All rights
  * reserved. See the file COPYING in the top-level source-directory for
@@ -9,45 +11,134 @@
  *   @file: MyMutex.cpp
  * @author: Steven R. Emmerson
  */
+#include "config.h"
 
 #include "MyMutex.h"
 
+#ifdef MUTEX_PROFILING
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
 namespace hycast {
 
-MyMutex::MyMutex()
-    : isLocked{false}
-    , threadId{}
-    , mutex{}
-{}
+/**
+ * Process-wide registry of mutex-contention tallies. Destroyed mutexes fold
+ * their tallies into the registry by name; the registry's destructor -- which
+ * runs at process shutdown -- reports the most contended names.
+ */
+class MutexProfiler final
+{
+    /// Accumulated tallies of the mutexes of one name
+    struct Tally
+    {
+        unsigned long numAcquires{0};
+        unsigned long numContended{0};
+        unsigned long waitNanos{0};
+    };
 
-void MyMutex::lock()
+    /// Maximum number of names in the shutdown report
+    static const size_t maxReported = 10;
+
+    std::mutex                   mutex;
+    std::map<std::string, Tally> tallies;
+
+public:
+    /**
+     * Returns the single instance. Constructed on first use so that it
+     * outlives every static-storage mutex that's constructed afterwards.
+     * @return Single instance
+     */
+    static MutexProfiler& instance()
+    {
+        static MutexProfiler profiler{};
+        return profiler;
+    }
+
+    /**
+     * Folds a mutex's tallies into the registry.
+     * @param[in] mutex  Mutex being destroyed
+     */
+    void add(const MyMutex& mutex)
+    {
+        std::lock_guard<std::mutex> lock{this->mutex};
+        auto& tally = tallies[mutex.name];
+        tally.numAcquires += mutex.numAcquires.load(
+                std::memory_order_relaxed);
+        tally.numContended += mutex.numContended.load(
+                std::memory_order_relaxed);
+        tally.waitNanos += mutex.waitNanos.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Reports the most contended names, by total wait-time. Written to the
+     * standard error stream directly because the logging module might already
+     * have been destroyed during static destruction.
+     */
+    ~MutexProfiler()
+    {
+        typedef std::pair<std::string, Tally> Elt;
+        std::vector<Elt> sorted(tallies.begin(), tallies.end());
+        std::sort(sorted.begin(), sorted.end(),
+                [](const Elt& e1, const Elt& e2) {
+                    return e1.second.waitNanos > e2.second.waitNanos;});
+        ::fprintf(stderr, "Mutex contention (top %zu by wait-time):\n",
+                std::min(maxReported, sorted.size()));
+        size_t numReported = 0;
+        for (const auto& elt : sorted) {
+            if (numReported++ >= maxReported)
+                break;
+            const auto& tally = elt.second;
+            ::fprintf(stderr,
+                    "    %-32s acquires=%lu contended=%lu waitSecs=%g\n",
+                    elt.first.c_str(), tally.numAcquires, tally.numContended,
+                    tally.waitNanos*1e-9);
+        }
+    }
+};
+
+MyMutex::MyMutex(const char* name)
+    : name{name}
+    , numAcquires{0}
+    , numContended{0}
+    , waitNanos{0}
 {
-    std::lock_guard<decltype(mutex)> lock{mutex};
-    std::mutex::lock();
-    isLocked = true;
-    threadId = std::this_thread::get_id();
+    MutexProfiler::instance(); // Ensure the registry outlives this instance
 }
 
-void MyMutex::try_lock()
+MyMutex::~MyMutex()
 {
-    std::lock_guard<decltype(mutex)> lock{mutex};
-    if (std::mutex::try_lock()) {
-        isLocked = true;
-        threadId = std::this_thread::get_id();
-    }
+    MutexProfiler::instance().add(*this);
 }
 
-void MyMutex::unlock()
+void MyMutex::lock()
 {
-    std::lock_guard<decltype(mutex)> lock{mutex};
-    std::mutex::unlock();
-    isLocked = false;
+    if (!std::mutex::try_lock()) {
+        const auto start = std::chrono::steady_clock::now();
+        std::mutex::lock();
+        const auto nanos = std::chrono::duration_cast<
+                std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+        numContended.fetch_add(1, std::memory_order_relaxed);
+        waitNanos.fetch_add(nanos, std::memory_order_relaxed);
+    }
+    numAcquires.fetch_add(1, std::memory_order_relaxed);
+    OpAccounting::countLock();
 }
 
-bool MyMutex::currentThreadHasLock() const
+bool MyMutex::try_lock()
 {
-    std::lock_guard<decltype(mutex)> lock{mutex};
-    return isLocked && threadId == std::this_thread::get_id();
+    if (!std::mutex::try_lock())
+        return false;
+    numAcquires.fetch_add(1, std::memory_order_relaxed);
+    OpAccounting::countLock();
+    return true;
 }
 
 } // namespace
+
+#endif // MUTEX_PROFILING
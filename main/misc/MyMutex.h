@@ -1,6 +1,13 @@
 /**
- * This file declares a mutex like std::mutex but one that keeps track of the
- * lock state and the owning thread.
+ * This file declares a mutex like std::mutex whose behavior depends on the
+ * build configuration:
+ *   - By default, it keeps track of the lock state and the owning thread so
+ *     that code can assert lock-ownership;
+ *   - In a release build (NDEBUG), it compiles down to a bare std::mutex with
+ *     no bookkeeping; and
+ *   - When configured with --enable-mutex-profiling, it records how often and
+ *     for how long threads wait for the lock and the most contended mutexes
+ *     are reported at shutdown.
  *
  * Copyright 2016 University Corporation for Atmospheric Research. All rights
  * reserved. See the file COPYING in the top-level source-directory for
@@ -13,45 +20,155 @@
 #ifndef MAIN_MISC_MYMUTEX_H_
 #define MAIN_MISC_MYMUTEX_H_
 
+#include "config.h"
+
+#include "OpAccounting.h"
+
+#include <atomic>
 #include <mutex>
+#include <thread>
 
 namespace hycast {
 
+#ifdef MUTEX_PROFILING
+
+/**
+ * Instrumented mutex. The uncontended path costs a single relaxed atomic
+ * increment over std::mutex; only contended acquisitions are timed. Each
+ * instance's tallies are folded -- by name -- into a process-wide registry
+ * when the instance is destroyed, and the registry reports the most contended
+ * names at shutdown.
+ */
+class MyMutex final : public std::mutex
+{
+    /// Name of the call site. Must be a string literal or otherwise outlive
+    /// this instance.
+    const char*                name;
+    /// Number of acquisitions
+    std::atomic<unsigned long> numAcquires;
+    /// Number of acquisitions that had to wait
+    std::atomic<unsigned long> numContended;
+    /// Total time, in nanoseconds, spent waiting for the lock
+    std::atomic<unsigned long> waitNanos;
+
+    friend class MutexProfiler;
+
+public:
+    /**
+     * Constructs.
+     * @param[in] name  Name of the call site under which this instance's
+     *                  contention is reported. Must outlive this instance.
+     */
+    explicit MyMutex(const char* name = "anonymous");
+
+    ~MyMutex();
+
+    MyMutex(const MyMutex& that) =delete;
+    MyMutex& operator =(const MyMutex& rhs) =delete;
+
+    void lock();
+    bool try_lock();
+    void unlock() {
+        std::mutex::unlock();
+    }
+    /**
+     * Ownership isn't tracked in this mode, so this is vacuously true: an
+     * assertion written against the checking mode won't fire.
+     * @retval `true`  Always
+     */
+    bool currentThreadHasLock() const noexcept {
+        return true;
+    }
+};
+
+#elif defined(NDEBUG)
+
+/**
+ * Release build: a bare std::mutex with no bookkeeping whatsoever. In an
+ * accounting build, acquisitions are still attributed to the current
+ * pipeline operation.
+ */
 class MyMutex final : public std::mutex
 {
-    bool            isLocked;
-    std::thread::id threadId;
-    std::mutex      mutex;
 public:
-    MyMutex()
+    explicit MyMutex(const char* name = "anonymous") {}
+#ifdef OP_ACCOUNTING
+    void lock() {
+        std::mutex::lock();
+        OpAccounting::countLock();
+    }
+    bool try_lock() {
+        if (!std::mutex::try_lock())
+            return false;
+        OpAccounting::countLock();
+        return true;
+    }
+#endif
+    /**
+     * Ownership isn't tracked in this mode, so this is vacuously true: an
+     * assertion written against the checking mode won't fire.
+     * @retval `true`  Always
+     */
+    bool currentThreadHasLock() const noexcept {
+        return true;
+    }
+};
+
+#else
+
+/**
+ * Checking mutex: keeps track of the lock state and the owning thread so that
+ * code can assert lock-ownership.
+ */
+class MyMutex final : public std::mutex
+{
+    bool               isLocked;
+    std::thread::id    threadId;
+    mutable std::mutex mutex;
+public:
+    explicit MyMutex(const char* name = "anonymous")
         : isLocked{false}
         , threadId{}
         , mutex{}
     {}
+    MyMutex(const MyMutex& that) =delete;
+    MyMutex& operator =(const MyMutex& rhs) =delete;
     void lock() {
-        std::lock_guard<decltype(mutex)> lock{mutex};
         std::mutex::lock();
+        OpAccounting::countLock();
+        std::lock_guard<decltype(mutex)> lock{mutex};
         isLocked = true;
         threadId = std::this_thread::get_id();
     }
-    void try_lock() {
+    bool try_lock() {
         std::lock_guard<decltype(mutex)> lock{mutex};
-        if (std::mutex::try_lock()) {
-            isLocked = true;
-            threadId = std::this_thread::get_id();
-        }
+        if (!std::mutex::try_lock())
+            return false;
+        OpAccounting::countLock();
+        isLocked = true;
+        threadId = std::this_thread::get_id();
+        return true;
     }
     void unlock() {
-        std::lock_guard<decltype(mutex)> lock{mutex};
+        {
+            std::lock_guard<decltype(mutex)> lock{mutex};
+            isLocked = false;
+        }
         std::mutex::unlock();
-        isLocked = false;
     }
+    /**
+     * Indicates if the current thread holds the lock.
+     * @retval `true`   The current thread holds the lock
+     * @retval `false`  The current thread doesn't hold the lock
+     */
     bool currentThreadHasLock() const {
         std::lock_guard<decltype(mutex)> lock{mutex};
         return isLocked && threadId == std::this_thread::get_id();
     }
 };
 
+#endif
+
 } // namespace
 
 #endif /* MAIN_MISC_MYMUTEX_H_ */
@@ -0,0 +1,207 @@
+/**
+ * This file implements per-operation cost accounting. The global allocation
+ * operators are interposed so that every heap allocation and deallocation is
+ * attributed -- via a thread-local operation marker -- to the pipeline
+ * operation the allocating thread is executing; `MyMutex` reports its
+ * acquisitions the same way. The per-operation tallies are fixed-size atomic
+ * counters, so the interposed operators never allocate themselves, and a
+ * report is written at process shutdown. Empty unless `configure
+ * --enable-op-accounting`.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: OpAccounting.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "OpAccounting.h"
+
+#ifdef OP_ACCOUNTING
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+/// Accumulated tallies of one operation
+struct Tally
+{
+    std::atomic<unsigned long> ops;
+    std::atomic<unsigned long> allocs;
+    std::atomic<unsigned long> allocBytes;
+    std::atomic<unsigned long> frees;
+    std::atomic<unsigned long> locks;
+};
+
+/// Per-operation tallies. Zero-initialized static storage: usable before any
+/// constructor runs, which matters because the interposed operators are
+/// called during static initialization.
+Tally tallies[hycast::OpAccounting::NUM_OPS];
+
+/// Operation the current thread is executing
+thread_local hycast::OpAccounting::Op currentOp{hycast::OpAccounting::NONE};
+
+/**
+ * Returns the name of an operation.
+ * @param[in] op  Operation
+ * @return        Name of the operation
+ */
+const char* opName(const unsigned op)
+{
+    switch (op) {
+        case hycast::OpAccounting::CHUNK_RECV: return "chunk_recv";
+        case hycast::OpAccounting::NOTIFY:     return "notify";
+        case hycast::OpAccounting::STORE_ADD:  return "store_add";
+        default:                               return "(unattributed)";
+    }
+}
+
+/**
+ * Reports the per-operation tallies at process shutdown. Written to the
+ * standard error stream directly because the logging module might already
+ * have been destroyed during static destruction.
+ */
+struct Reporter
+{
+    ~Reporter()
+    {
+        ::fprintf(stderr, "Per-operation accounting:\n");
+        for (unsigned op = 0; op < hycast::OpAccounting::NUM_OPS; ++op) {
+            const auto& tally = tallies[op];
+            const auto  ops = tally.ops.load(std::memory_order_relaxed);
+            const auto  allocs = tally.allocs.load(std::memory_order_relaxed);
+            ::fprintf(stderr,
+                    "    %-16s ops=%lu allocs=%lu allocBytes=%lu frees=%lu "
+                    "locks=%lu allocsPerOp=%g\n",
+                    opName(op), ops, allocs,
+                    tally.allocBytes.load(std::memory_order_relaxed),
+                    tally.frees.load(std::memory_order_relaxed),
+                    tally.locks.load(std::memory_order_relaxed),
+                    ops ? static_cast<double>(allocs)/ops : 0.0);
+        }
+    }
+} reporter;
+
+} // namespace
+
+namespace hycast {
+
+OpAccounting::Scope::Scope(const Op op) noexcept
+    : prev{currentOp}
+{
+    currentOp = op;
+    tallies[op].ops.fetch_add(1, std::memory_order_relaxed);
+}
+
+OpAccounting::Scope::~Scope() noexcept
+{
+    currentOp = prev;
+}
+
+void OpAccounting::countLock() noexcept
+{
+    tallies[currentOp].locks.fetch_add(1, std::memory_order_relaxed);
+}
+
+unsigned long OpAccounting::getOps(const Op op) noexcept
+{
+    return tallies[op].ops.load(std::memory_order_relaxed);
+}
+
+unsigned long OpAccounting::getAllocs(const Op op) noexcept
+{
+    return tallies[op].allocs.load(std::memory_order_relaxed);
+}
+
+unsigned long OpAccounting::getAllocBytes(const Op op) noexcept
+{
+    return tallies[op].allocBytes.load(std::memory_order_relaxed);
+}
+
+unsigned long OpAccounting::getFrees(const Op op) noexcept
+{
+    return tallies[op].frees.load(std::memory_order_relaxed);
+}
+
+unsigned long OpAccounting::getLocks(const Op op) noexcept
+{
+    return tallies[op].locks.load(std::memory_order_relaxed);
+}
+
+} // namespace
+
+/*
+ * Interposed global allocation operators. Only counting is added: the
+ * allocations themselves go straight to malloc(3)/free(3), and the counters
+ * are plain atomics, so the operators never recurse.
+ */
+
+void* operator new(const std::size_t size)
+{
+    void* const ptr = std::malloc(size ? size : 1);
+    if (ptr == nullptr)
+        throw std::bad_alloc{};
+    auto& tally = tallies[currentOp];
+    tally.allocs.fetch_add(1, std::memory_order_relaxed);
+    tally.allocBytes.fetch_add(size, std::memory_order_relaxed);
+    return ptr;
+}
+
+void* operator new(
+        const std::size_t     size,
+        const std::nothrow_t&) noexcept
+{
+    void* const ptr = std::malloc(size ? size : 1);
+    if (ptr) {
+        auto& tally = tallies[currentOp];
+        tally.allocs.fetch_add(1, std::memory_order_relaxed);
+        tally.allocBytes.fetch_add(size, std::memory_order_relaxed);
+    }
+    return ptr;
+}
+
+void* operator new[](const std::size_t size)
+{
+    return ::operator new(size);
+}
+
+void* operator new[](
+        const std::size_t     size,
+        const std::nothrow_t& nothrow) noexcept
+{
+    return ::operator new(size, nothrow);
+}
+
+void operator delete(void* const ptr) noexcept
+{
+    if (ptr) {
+        tallies[currentOp].frees.fetch_add(1, std::memory_order_relaxed);
+        std::free(ptr);
+    }
+}
+
+void operator delete(
+        void* const           ptr,
+        const std::nothrow_t&) noexcept
+{
+    ::operator delete(ptr);
+}
+
+void operator delete[](void* const ptr) noexcept
+{
+    ::operator delete(ptr);
+}
+
+void operator delete[](
+        void* const           ptr,
+        const std::nothrow_t&) noexcept
+{
+    ::operator delete(ptr);
+}
+
+#endif // OP_ACCOUNTING
@@ -0,0 +1,132 @@
+/**
+ * This file declares per-operation cost accounting: heap allocations and
+ * MyMutex acquisitions are attributed to the pipeline operation -- chunk
+ * reception, peer notification, product-store addition -- that the current
+ * thread is executing, and the per-operation tallies are reported at
+ * shutdown. The tallies are also queryable, so a test can assert a budget
+ * (e.g., "a chunk reception performs no allocations") and lock in
+ * allocation-elimination work permanently. Compiled out entirely unless
+ * `configure --enable-op-accounting`.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: OpAccounting.h
+ * @author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_MISC_OPACCOUNTING_H_
+#define MAIN_MISC_OPACCOUNTING_H_
+
+#include "config.h"
+
+#include <cstddef>
+
+namespace hycast {
+
+class OpAccounting final
+{
+public:
+    /// Pipeline operations to which costs are attributed
+    typedef enum {
+        NONE = 0,      ///< No operation in progress on the thread
+        CHUNK_RECV,    ///< Reception of a chunk-of-data
+        NOTIFY,        ///< Notification of a peer
+        STORE_ADD,     ///< Addition to the product-store
+        NUM_OPS        ///< Number of operations. Not an operation.
+    } Op;
+
+#ifdef OP_ACCOUNTING
+
+    /**
+     * RAII scope that marks the calling thread as executing an operation.
+     * Scopes nest: costs are attributed to the innermost operation, and the
+     * enclosing operation is restored when the scope is destroyed.
+     */
+    class Scope final
+    {
+        const Op prev;
+
+    public:
+        /**
+         * Constructs. Attributes the calling thread's subsequent costs to the
+         * given operation and counts one execution of it.
+         * @param[in] op  Operation the calling thread is executing
+         */
+        explicit Scope(const Op op) noexcept;
+
+        ~Scope() noexcept;
+
+        Scope(const Scope& that) =delete;
+        Scope& operator =(const Scope& rhs) =delete;
+    };
+
+    /**
+     * Counts one lock acquisition against the calling thread's current
+     * operation. Called by `MyMutex`.
+     */
+    static void countLock() noexcept;
+
+    /**
+     * Returns the number of executions of an operation.
+     * @param[in] op  Operation
+     * @return        Number of executions
+     */
+    static unsigned long getOps(const Op op) noexcept;
+
+    /**
+     * Returns the number of heap allocations attributed to an operation.
+     * @param[in] op  Operation
+     * @return        Number of allocations
+     */
+    static unsigned long getAllocs(const Op op) noexcept;
+
+    /**
+     * Returns the number of heap bytes allocated by an operation.
+     * @param[in] op  Operation
+     * @return        Number of allocated bytes
+     */
+    static unsigned long getAllocBytes(const Op op) noexcept;
+
+    /**
+     * Returns the number of heap deallocations attributed to an operation.
+     * @param[in] op  Operation
+     * @return        Number of deallocations
+     */
+    static unsigned long getFrees(const Op op) noexcept;
+
+    /**
+     * Returns the number of `MyMutex` acquisitions attributed to an
+     * operation.
+     * @param[in] op  Operation
+     * @return        Number of lock acquisitions
+     */
+    static unsigned long getLocks(const Op op) noexcept;
+
+#else
+
+    /**
+     * Accounting is disabled: a scope costs nothing.
+     */
+    class Scope final
+    {
+    public:
+        explicit Scope(const Op op) noexcept {}
+        Scope(const Scope& that) =delete;
+        Scope& operator =(const Scope& rhs) =delete;
+    };
+
+    static void countLock() noexcept {}
+    static unsigned long getOps(const Op op) noexcept { return 0; }
+    static unsigned long getAllocs(const Op op) noexcept { return 0; }
+    static unsigned long getAllocBytes(const Op op) noexcept { return 0; }
+    static unsigned long getFrees(const Op op) noexcept { return 0; }
+    static unsigned long getLocks(const Op op) noexcept { return 0; }
+
+#endif
+};
+
+} // namespace
+
+#endif /* MAIN_MISC_OPACCOUNTING_H_ */
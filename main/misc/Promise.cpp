@@ -121,6 +121,10 @@ BasicPromise::BasicPromise(Impl* ptr)
     : pImpl{ptr}
 {}
 
+BasicPromise::BasicPromise(std::shared_ptr<Impl> ptr)
+    : pImpl{std::move(ptr)}
+{}
+
 void BasicPromise::setException() const
 {
     pImpl->setException();
@@ -173,7 +177,7 @@ public:
 
 template<class Ret>
 Promise<Ret>::Promise()
-    : BasicPromise{new Impl()}
+    : BasicPromise{std::make_shared<Impl>()}
 {}
 
 template<class Ret>
@@ -210,7 +214,7 @@ public:
 };
 
 Promise<void>::Promise()
-    : BasicPromise{new Impl()}
+    : BasicPromise{std::make_shared<Impl>()}
 {}
 
 void Promise<void>::setResult() const
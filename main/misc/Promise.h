@@ -26,6 +26,14 @@ protected:
 
     BasicPromise(Impl* ptr);
 
+    /**
+     * Constructs from a shared pointer to the template subclass
+     * implementation. Allows the implementation and its reference-count to
+     * occupy a single allocation (see `std::make_shared()`).
+     * @param[in] ptr   Shared pointer to template subclass implementation
+     */
+    BasicPromise(std::shared_ptr<Impl> ptr);
+
 public:
     /**
      * Default constructs.
@@ -0,0 +1,84 @@
+/**
+ * This file implements the process-wide simulation clock. Virtual time is a
+ * steady-clock epoch captured at the switch to virtual mode plus an
+ * atomically-accumulated offset, so `now()` stays lock-free on the hot
+ * paths that read it. Waiters poll rather than register with the clock:
+ * `advance()` therefore needs no knowledge of who is waiting, and a blocked
+ * thread observes an advancement within one poll-interval.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *        File: SimClock.cpp
+ *  Created on: Aug 30, 2026
+ *      Author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "SimClock.h"
+#include "error.h"
+
+#include <atomic>
+
+namespace hycast {
+
+/// Whether the clock is virtual. Written once, by `enableVirtual()`.
+static std::atomic<bool>                     virtualMode{false};
+/// Offset of the virtual time from the virtual epoch in clock-ticks
+static std::atomic<SimClock::Duration::rep>  virtualTicks{0};
+/// Real time at which the clock became virtual
+static SimClock::TimePoint                   virtualEpoch{};
+/// How long a virtual-mode waiter sleeps between polls of the clock
+static const std::chrono::milliseconds       pollInterval{1};
+
+SimClock::TimePoint SimClock::now() noexcept
+{
+    if (!virtualMode.load(std::memory_order_acquire))
+        return Clock::now();
+    return virtualEpoch + Duration{virtualTicks.load(
+            std::memory_order_relaxed)};
+}
+
+bool SimClock::isVirtual() noexcept
+{
+    return virtualMode.load(std::memory_order_acquire);
+}
+
+void SimClock::enableVirtual() noexcept
+{
+    if (virtualMode.load(std::memory_order_acquire))
+        return; // Already virtual
+    virtualEpoch = Clock::now();
+    // Release so `now()` sees the epoch once it sees the mode
+    virtualMode.store(true, std::memory_order_release);
+}
+
+void SimClock::advance(const Duration& amount)
+{
+    if (!virtualMode.load(std::memory_order_acquire))
+        throw LOGIC_ERROR("Clock isn't virtual");
+    virtualTicks.fetch_add(amount.count(), std::memory_order_relaxed);
+}
+
+std::cv_status SimClock::waitUntil(
+        std::condition_variable&      cond,
+        std::unique_lock<std::mutex>& lock,
+        const TimePoint&              when)
+{
+    if (!virtualMode.load(std::memory_order_acquire))
+        return cond.wait_until(lock, when);
+    if (now() >= when)
+        return std::cv_status::timeout;
+    /*
+     * The real wait is bounded by the poll-interval so an `advance()` is
+     * observed promptly even though it doesn't notify the caller's
+     * condition-variable.
+     */
+    cond.wait_for(lock, pollInterval);
+    return (now() >= when)
+            ? std::cv_status::timeout
+            : std::cv_status::no_timeout;
+}
+
+} // namespace
@@ -0,0 +1,105 @@
+/**
+ * This file declares a process-wide simulation clock. In its default, real
+ * mode it is a thin veneer over `std::chrono::steady_clock`. In virtual mode
+ * -- enabled once, by tests and the swarm simulator -- time stands still
+ * until `advance()` is called, so an hour of residence-based eviction or a
+ * stasis cycle can be exercised in milliseconds of real time.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *        File: SimClock.h
+ *  Created on: Aug 30, 2026
+ *      Author: Steven R. Emmerson
+ */
+
+#ifndef MISC_SIMCLOCK_H
+#define MISC_SIMCLOCK_H
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace hycast {
+
+/**
+ * A process-wide clock for time-driven components. All members are static:
+ * every component in the process observes the same time so that, for
+ * example, a product's residence-time in the store and the stasis period of
+ * the peer-set advance together.
+ */
+class SimClock final
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+    typedef Clock::time_point         TimePoint;
+    typedef Clock::duration           Duration;
+
+    SimClock() =delete;
+
+    /**
+     * Returns the current time. In real mode this is the steady-clock time;
+     * in virtual mode it is the time of the switch to virtual mode plus all
+     * subsequent advancements.
+     * @return           Current time
+     * @exceptionsafety  Nothrow
+     * @threadsafety     Safe
+     */
+    static TimePoint now() noexcept;
+
+    /**
+     * Indicates if the clock is in virtual mode.
+     * @retval `true`    The clock is virtual
+     * @retval `false`   The clock is real
+     * @exceptionsafety  Nothrow
+     * @threadsafety     Safe
+     */
+    static bool isVirtual() noexcept;
+
+    /**
+     * Switches the clock to virtual mode. The virtual time starts at the
+     * real time of the switch and thereafter moves only via `advance()`.
+     * The switch is process-wide and irreversible; calling this a second
+     * time is a no-op. Must be called before any time-driven component
+     * records a time-point -- i.e., at the start of a test or simulation.
+     * @exceptionsafety  Nothrow
+     * @threadsafety     Safe
+     */
+    static void enableVirtual() noexcept;
+
+    /**
+     * Advances the virtual clock. Threads blocked in `waitUntil()` observe
+     * the new time within a poll-interval without being explicitly notified.
+     * @param[in] amount   Amount by which to advance the clock
+     * @throw LogicError   The clock isn't virtual
+     * @exceptionsafety    Strong guarantee
+     * @threadsafety       Safe
+     */
+    static void advance(const Duration& amount);
+
+    /**
+     * Waits on a condition-variable until it is notified or the clock
+     * reaches a time-point. In real mode this delegates to
+     * `std::condition_variable::wait_until()`. In virtual mode the thread
+     * briefly waits on the condition-variable in a loop so that it observes
+     * both notifications and advancements of the clock. Spurious wakeups
+     * occur in both modes: callers must re-check their predicate, as they
+     * would with a bare condition-variable.
+     * @param[in]     cond  Condition-variable to wait on
+     * @param[in,out] lock  Associated lock. Locked on entry and return.
+     * @param[in]     when  Time-point at which to stop waiting
+     * @return              `std::cv_status::timeout` iff the clock has
+     *                      reached the time-point
+     * @exceptionsafety     Basic guarantee
+     * @threadsafety        Safe
+     */
+    static std::cv_status waitUntil(
+            std::condition_variable&      cond,
+            std::unique_lock<std::mutex>& lock,
+            const TimePoint&              when);
+};
+
+} // namespace
+
+#endif /* MISC_SIMCLOCK_H */
@@ -0,0 +1,478 @@
+/**
+ * This file implements a fixed-size thread-pool executor whose worker threads
+ * steal queued tasks from each other.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: StealingExecutor.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "error.h"
+#include "StealingExecutor.h"
+#include "Task.h"
+#include "Thread.h"
+
+#include <deque>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hycast {
+
+template<class Ret>
+class StealingExecutor<Ret>::Impl final
+{
+    typedef std::mutex              Mutex;
+    typedef std::lock_guard<Mutex>  LockGuard;
+    typedef std::unique_lock<Mutex> UniqueLock;
+    typedef std::condition_variable Cond;
+
+    /// Number of priority lanes
+    static const unsigned numLanes =
+            static_cast<unsigned>(TaskPriority::NUM_PRIORITIES);
+    /**
+     * Maximum number of consecutive pops from a higher-priority lane while a
+     * lower-priority lane had a waiting task. Reached, the lowest waiting
+     * lane is served instead, so urgent load delays backlog and maintenance
+     * work but can't starve it.
+     */
+    static const unsigned MAX_LANE_BYPASSES{16};
+
+    /**
+     * A unit of queued work: either a submitted task, whose result is
+     * delivered through its future, or a detached callable posted by
+     * `post()`, which has no task, future, promise, or result storage.
+     */
+    struct Work
+    {
+        /// Submitted task. Invalid for a detached posting.
+        Task<Ret>             task;
+        /// Detached callable. Empty for a submitted task.
+        std::function<void()> detached;
+
+        Work()
+            : task{}
+            , detached{}
+        {}
+
+        explicit Work(const Task<Ret>& task)
+            : task{task}
+            , detached{}
+        {}
+
+        explicit Work(std::function<void()>&& func)
+            : task{}
+            , detached{std::move(func)}
+        {}
+    };
+
+    /// A worker thread's state, including its independently-locked task lanes
+    struct Worker
+    {
+        mutable Mutex     mutex;
+        /// Queued work by priority lane. The owner pops from the front;
+        /// thieves steal from the back.
+        std::deque<Work>  lanes[numLanes];
+        /// Currently-executing task. Invalid if the worker is idle or
+        /// executing a detached callable, which can't be canceled.
+        Task<Ret>         current;
+        /// Consecutive pops that bypassed a waiting lower-priority lane
+        unsigned          numBypassed;
+
+        Worker()
+            : mutex{}
+            , lanes{}
+            , current{}
+            , numBypassed{0}
+        {}
+    };
+
+    /// Guards `pending`, `closed`, and `nextWorker`
+    mutable Mutex                        mutex;
+    mutable Cond                         cond;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<Thread>                  threads;
+    /// Number of queued tasks not yet claimed by a worker
+    size_t                               pending;
+    /// Index of the worker to receive the next submission
+    unsigned                             nextWorker;
+    /// Whether or not this instance has been shut down
+    bool                                 closed;
+    /// Called with exceptions thrown by detached callables. Guarded by
+    /// `mutex`.
+    std::function<void(const std::exception&)> errorHandler;
+
+    /**
+     * Tries to remove a task from the front of a worker's own lanes. The
+     * highest-priority non-empty lane is served, except that after
+     * `MAX_LANE_BYPASSES` consecutive pops that bypassed a waiting
+     * lower-priority task the lowest non-empty lane is served instead.
+     * @param[in]  self  Index of the worker
+     * @param[out] work  Removed work. Set iff `true` is returned.
+     * @retval `true`    Work was removed
+     * @retval `false`   All lanes are empty
+     */
+    bool tryPopOwn(
+            const unsigned self,
+            Work&          work)
+    {
+        Worker&   worker = *workers[self];
+        LockGuard lock{worker.mutex};
+        int       highest = -1;
+        int       lowest = -1;
+        for (unsigned i = 0; i < numLanes; ++i) {
+            if (!worker.lanes[i].empty()) {
+                if (highest < 0)
+                    highest = i;
+                lowest = i;
+            }
+        }
+        if (highest < 0)
+            return false;
+        unsigned lane = highest;
+        if (lowest == highest) {
+            worker.numBypassed = 0;
+        }
+        else if (++worker.numBypassed >= MAX_LANE_BYPASSES) {
+            lane = lowest;
+            worker.numBypassed = 0;
+        }
+        work = worker.lanes[lane].front();
+        worker.lanes[lane].pop_front();
+        worker.current = work.task;
+        return true;
+    }
+
+    /**
+     * Tries to steal a task from the back of another worker's lanes. A thief
+     * takes the most urgent task available; the bypass bound isn't applied
+     * because a thief steals only when its own lanes are empty, so stealing
+     * never bypasses a task the thief could serve.
+     * @param[in]  self  Index of the stealing worker
+     * @param[out] work  Stolen work. Set iff `true` is returned.
+     * @retval `true`    Work was stolen
+     * @retval `false`   No task could be stolen
+     */
+    bool trySteal(
+            const unsigned self,
+            Work&          work)
+    {
+        for (unsigned i = 1; i < workers.size(); ++i) {
+            Worker&   victim = *workers[(self + i) % workers.size()];
+            LockGuard lock{victim.mutex};
+            for (unsigned lane = 0; lane < numLanes; ++lane) {
+                if (!victim.lanes[lane].empty()) {
+                    work = victim.lanes[lane].back();
+                    victim.lanes[lane].pop_back();
+                    LockGuard selfLock{workers[self]->mutex};
+                    workers[self]->current = work.task;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Returns the next task for a worker to execute. Blocks until a task is
+     * available or the executor is shut down and drained.
+     * @param[in]  self  Index of the worker
+     * @param[out] work  Work to execute. Set iff `true` is returned.
+     * @retval `true`    Work was obtained
+     * @retval `false`   Executor is shut down and no tasks remain
+     */
+    bool getWork(
+            const unsigned self,
+            Work&          work)
+    {
+        {
+            UniqueLock lock{mutex};
+            while (pending == 0) {
+                if (closed)
+                    return false;
+                cond.wait(lock);
+            }
+            --pending;
+        }
+        /*
+         * A claimed task exists in some deque: scan until it's found. A
+         * submitter pushes to a deque before incrementing `pending`, so the
+         * scan terminates.
+         */
+        for (;;) {
+            if (tryPopOwn(self, work) || trySteal(self, work))
+                return true;
+            std::this_thread::yield();
+        }
+    }
+
+    /**
+     * A worker thread's run loop. Executes tasks until the executor is shut
+     * down and no queued tasks remain.
+     * @param[in] self  Index of the worker
+     */
+    void runWorker(const unsigned self)
+    {
+        Work work{};
+        while (getWork(self, work)) {
+            if (work.task) {
+                work.task();
+            }
+            else {
+                std::function<void(const std::exception&)> handler;
+                {
+                    LockGuard lock{mutex};
+                    handler = errorHandler;
+                }
+                try {
+                    work.detached();
+                }
+                catch (const std::exception& e) {
+                    handler(e);
+                }
+            }
+            work = Work{};
+            Worker&   worker = *workers[self];
+            LockGuard lock{worker.mutex};
+            worker.current = Task<Ret>{};
+        }
+    }
+
+public:
+    /**
+     * Constructs.
+     * @param[in] numWorkers  Number of worker threads or 0, in which case the
+     *                        hardware concurrency is used
+     */
+    explicit Impl(unsigned numWorkers)
+        : mutex{}
+        , cond{}
+        , workers{}
+        , threads{}
+        , pending{0}
+        , nextWorker{0}
+        , closed{false}
+        , errorHandler{[](const std::exception& ex){log_error(ex);}}
+    {
+        if (numWorkers == 0) {
+            numWorkers = std::thread::hardware_concurrency();
+            if (numWorkers == 0)
+                numWorkers = 2;
+        }
+        for (unsigned i = 0; i < numWorkers; ++i)
+            workers.emplace_back(new Worker{});
+        for (unsigned i = 0; i < numWorkers; ++i)
+            threads.emplace_back(Thread{[this,i]{runWorker(i);}});
+    }
+
+    Impl(const Impl& impl) =delete;
+    Impl& operator=(const Impl& rhs) =delete;
+
+    /**
+     * Destroys. Cancels all queued and executing tasks and joins the worker
+     * threads.
+     */
+    ~Impl() noexcept
+    {
+        try {
+            shutdown(true);
+            awaitTermination();
+        }
+        catch (const std::exception& e) {
+            try {
+                std::throw_with_nested(RUNTIME_ERROR(
+                        "Couldn't destroy work-stealing executor"));
+            }
+            catch (const std::exception& ex) {
+                log_error(ex);
+            }
+        }
+    }
+
+    /**
+     * Submits a callable for execution by the pool.
+     * @param[in] func      Task to be executed
+     * @param[in] priority  Priority lane of the task
+     * @return              The task's future
+     * @throw LogicError    `shutdown()` has been called
+     */
+    Future<Ret> submit(
+            std::function<Ret()> func,
+            const TaskPriority   priority)
+    {
+        LockGuard lock{mutex};
+        if (closed)
+            throw LOGIC_ERROR("Executor is shut down");
+        Task<Ret>  task{std::move(func)};
+        const auto index = nextWorker;
+        nextWorker = (nextWorker + 1) % workers.size();
+        {
+            Worker&   worker = *workers[index];
+            LockGuard workerLock{worker.mutex};
+            worker.lanes[static_cast<unsigned>(priority)].push_back(
+                    Work{task});
+        }
+        ++pending;
+        cond.notify_one();
+        return task.getFuture();
+    }
+
+    /**
+     * Posts a detached callable for execution by the pool. No task, future,
+     * promise, or result storage is created: the callable alone is enqueued.
+     * @param[in] func      Callable to be executed
+     * @param[in] priority  Priority lane of the callable
+     * @throw LogicError    `shutdown()` has been called
+     */
+    void post(
+            std::function<void()> func,
+            const TaskPriority    priority)
+    {
+        LockGuard lock{mutex};
+        if (closed)
+            throw LOGIC_ERROR("Executor is shut down");
+        const auto index = nextWorker;
+        nextWorker = (nextWorker + 1) % workers.size();
+        {
+            Worker&   worker = *workers[index];
+            LockGuard workerLock{worker.mutex};
+            worker.lanes[static_cast<unsigned>(priority)].push_back(
+                    Work{std::move(func)});
+        }
+        ++pending;
+        cond.notify_one();
+    }
+
+    /**
+     * Sets the function that is called with exceptions thrown by detached
+     * callables.
+     * @param[in] handler      Error handler. Must not be empty.
+     * @throw InvalidArgument  `handler` is empty
+     */
+    void setErrorHandler(const std::function<void(const std::exception&)>&
+            handler)
+    {
+        if (!handler)
+            throw INVALID_ARGUMENT("Empty error handler");
+        LockGuard lock{mutex};
+        errorHandler = handler;
+    }
+
+    /**
+     * Shuts down this instance. Queued tasks are canceled.
+     * @param[in] mayInterrupt  Whether or not the threads-of-execution of
+     *                          executing tasks may be canceled
+     */
+    void shutdown(const bool mayInterrupt)
+    {
+        {
+            LockGuard lock{mutex};
+            if (closed)
+                return;
+            closed = true;
+            pending = 0;
+        }
+        for (auto& workerPtr : workers) {
+            Worker&   worker = *workerPtr;
+            LockGuard lock{worker.mutex};
+            for (unsigned lane = 0; lane < numLanes; ++lane) {
+                // Queued detached callables are simply dropped: they have no
+                // future through which to report cancellation
+                for (auto& work : worker.lanes[lane]) {
+                    if (work.task)
+                        work.task.cancel(false);
+                }
+                worker.lanes[lane].clear();
+            }
+            if (mayInterrupt && worker.current)
+                worker.current.cancel(true);
+        }
+        cond.notify_all();
+    }
+
+    /**
+     * Waits until all worker threads have completed.
+     * @throw LogicError  Iff `shutdown()` wasn't called first
+     */
+    void awaitTermination()
+    {
+        {
+            LockGuard lock{mutex};
+            if (!closed)
+                throw LOGIC_ERROR("Executor hasn't been shut down");
+        }
+        for (auto& thread : threads) {
+            if (thread.joinable())
+                thread.join();
+        }
+    }
+};
+
+template<class Ret>
+StealingExecutor<Ret>::StealingExecutor(const unsigned numWorkers)
+    : pImpl{new Impl(numWorkers)}
+{}
+
+template<class Ret>
+StealingExecutor<Ret> StealingExecutor<Ret>::getShared()
+{
+    static StealingExecutor<Ret> shared{};
+    return shared;
+}
+
+template<class Ret>
+StealingExecutor<Ret>::~StealingExecutor() noexcept
+{}
+
+template<class Ret>
+Future<Ret> StealingExecutor<Ret>::submit(
+        std::function<Ret()>& func,
+        const TaskPriority    priority) const
+{
+    return pImpl->submit(func, priority);
+}
+
+template<class Ret>
+Future<Ret> StealingExecutor<Ret>::submit(
+        std::function<Ret()>&& func,
+        const TaskPriority     priority) const
+{
+    return pImpl->submit(std::move(func), priority);
+}
+
+template<class Ret>
+void StealingExecutor<Ret>::post(
+        std::function<void()>&& func,
+        const TaskPriority      priority) const
+{
+    pImpl->post(std::move(func), priority);
+}
+
+template<class Ret>
+void StealingExecutor<Ret>::setErrorHandler(
+        const std::function<void(const std::exception&)>& handler) const
+{
+    pImpl->setErrorHandler(handler);
+}
+
+template<class Ret>
+void StealingExecutor<Ret>::shutdown(const bool mayInterrupt) const
+{
+    pImpl->shutdown(mayInterrupt);
+}
+
+template<class Ret>
+void StealingExecutor<Ret>::awaitTermination() const
+{
+    pImpl->awaitTermination();
+}
+
+template class StealingExecutor<int>;
+template class StealingExecutor<void>;
+
+} // namespace
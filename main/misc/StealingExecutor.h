@@ -0,0 +1,144 @@
+/**
+ * This file declares a fixed-size thread-pool executor whose worker threads
+ * steal queued tasks from each other. Unlike `Executor`, which creates a
+ * thread per task, this executor reuses its workers, so task submission
+ * doesn't pay thread creation and teardown costs.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: StealingExecutor.h
+ * @author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_MISC_STEALINGEXECUTOR_H_
+#define MAIN_MISC_STEALINGEXECUTOR_H_
+
+#include "Future.h"
+#include "Task.h"
+
+#include <exception>
+#include <functional>
+#include <memory>
+
+namespace hycast {
+
+/**
+ * Class template for a work-stealing thread-pool executor of type-returning
+ * callables.
+ */
+template<class Ret>
+class StealingExecutor final
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Constructs.
+     * @param[in] numWorkers  Number of worker threads or 0, in which case the
+     *                        hardware concurrency is used
+     */
+    explicit StealingExecutor(const unsigned numWorkers = 0);
+
+    /**
+     * Returns the process-wide shared executor, sized to the hardware
+     * concurrency and created on first use. Components that would otherwise
+     * each create a worker pool (e.g., one ingester per feed in a
+     * consolidated multi-feed process) should share this instance so the
+     * process runs one pool's worth of threads instead of one per component.
+     * @return           Process-wide shared executor
+     * @exceptionsafety  Strong guarantee
+     * @threadsafety     Safe
+     */
+    static StealingExecutor getShared();
+
+    /**
+     * Destroys. Cancels all queued and executing tasks and waits for the
+     * worker threads to complete.
+     */
+    ~StealingExecutor() noexcept;
+
+    /**
+     * Submits a callable for execution by the pool. The callable is queued
+     * with the least-recently-used worker; idle workers steal queued
+     * callables from busy ones. A worker executes queued callables in
+     * priority order but bounds how long a waiting lower-priority callable
+     * can be bypassed.
+     * @param[in,out] func      Task to be executed
+     * @param[in]     priority  Priority lane of the task
+     * @return                  The task's future
+     * @throw LogicError        `shutdown()` has been called
+     * @exceptionsafety         Basic guarantee
+     * @threadsafety            Safe
+     */
+    Future<Ret> submit(
+            std::function<Ret()>& func,
+            const TaskPriority    priority = TaskPriority::NORMAL) const;
+
+    /**
+     * Submits a callable for execution by the pool.
+     * @param[in,out] func      Task to be executed
+     * @param[in]     priority  Priority lane of the task
+     * @return                  The task's future
+     * @throw LogicError        `shutdown()` has been called
+     * @exceptionsafety         Basic guarantee
+     * @threadsafety            Safe
+     */
+    Future<Ret> submit(
+            std::function<Ret()>&& func,
+            const TaskPriority     priority = TaskPriority::NORMAL) const;
+
+    /**
+     * Posts a detached, fire-and-forget callable for execution by the pool.
+     * Unlike `submit()`, no task, future, promise, or result storage is
+     * created -- the callable alone is enqueued -- so this is the cheap path
+     * for work whose result is never inspected (e.g., notice fan-out,
+     * logging, cleanup). An exception thrown by the callable is passed to
+     * the handler set by `setErrorHandler()`, which logs it by default. A
+     * queued callable that the executor is shut down before executing is
+     * silently dropped; a callable that must observe cancellation should be
+     * submitted instead.
+     * @param[in] func      Callable to be executed
+     * @param[in] priority  Priority lane of the callable
+     * @throw LogicError    `shutdown()` has been called
+     * @exceptionsafety     Basic guarantee
+     * @threadsafety        Safe
+     * @see setErrorHandler()
+     */
+    void post(
+            std::function<void()>&& func,
+            const TaskPriority      priority = TaskPriority::NORMAL) const;
+
+    /**
+     * Sets the function that is called -- on the worker's thread -- with
+     * exceptions thrown by detached callables. The default handler logs the
+     * exception.
+     * @param[in] handler      Error handler. Must not be empty.
+     * @throw InvalidArgument  `handler` is empty
+     * @exceptionsafety        Strong guarantee
+     * @threadsafety           Safe
+     * @see post()
+     */
+    void setErrorHandler(
+            const std::function<void(const std::exception&)>& handler) const;
+
+    /**
+     * Shuts down this instance. Callables that have not started will be
+     * canceled. Upon return, `submit()` will always throw an exception.
+     * @param[in] mayInterrupt  Whether or not the threads-of-execution of
+     *                          executing callables may be canceled
+     */
+    void shutdown(const bool mayInterrupt = true) const;
+
+    /**
+     * Waits until all worker threads have completed.
+     * @throw LogicError  Iff `shutdown()` wasn't called first
+     */
+    void awaitTermination() const;
+};
+
+} // namespace
+
+#endif /* MAIN_MISC_STEALINGEXECUTOR_H_ */
@@ -66,7 +66,7 @@ public:
 
     Impl(std::function<Ret()>&& func)
         : mutex{}
-        , func{func}
+        , func{std::move(func)}
         , threadId{}
         , haveThreadId{false}
         , future{[this](bool mayIntr){cancel(mayIntr);}}
@@ -175,7 +175,7 @@ Task<Ret>::Task()
 
 template<class Ret>
 Task<Ret>::Task(std::function<Ret()> func)
-    : pImpl{new Impl(func)}
+    : pImpl{std::make_shared<Impl>(std::move(func))}
 {}
 
 template<class Ret>
@@ -20,6 +20,20 @@
 
 namespace hycast {
 
+/**
+ * Relative urgency of a task. These are lanes rather than absolute
+ * priorities: an executor serves a higher lane before a lower one but bounds
+ * how long a waiting lower lane can be bypassed, so a flood of urgent tasks
+ * can't starve the others. `HIGH` is for real-time data handling, `NORMAL`
+ * for control work, and `LOW` for backlog and maintenance work.
+ */
+enum class TaskPriority : unsigned {
+    HIGH = 0,
+    NORMAL,
+    LOW,
+    NUM_PRIORITIES ///< Number of priorities. Must be last.
+};
+
 template<class Ret>
 class Task final
 {
@@ -19,11 +19,15 @@
 #include <cassert>
 #include <functional>
 #include <iostream>
+#include <limits.h>
 #include <map>
 #include <mutex>
 #include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
 #include <system_error>
 #include <thread>
+#include <unistd.h>
 #include <utility>
 
 namespace hycast {
@@ -80,37 +84,53 @@ void hycast::Cue::wait() const
 /******************************************************************************/
 
 Thread::Impl::ThreadMap::ThreadMap()
-    : mutex{}
-    , threads{}
+    : shards{}
+    , indexMutex{}
     , threadIndexes(0, false)
+    , firstMaybeUnused{0}
 {}
 
+/**
+ * Returns the shard for a thread identifier.
+ * @param[in] threadId  Thread identifier
+ * @return              Corresponding shard
+ */
+Thread::Impl::ThreadMap::Shard& Thread::Impl::ThreadMap::getShard(
+        const ThreadId& threadId) noexcept
+{
+    return shards[std::hash<ThreadId>()(threadId) % numShards];
+}
+
 long Thread::Impl::ThreadMap::setAndGetLowestUnusedIndex() noexcept
 {
+    LockGuard lock{indexMutex};
     long size = threadIndexes.size();
     long num;
-    for (num = 0; num < size && threadIndexes[num]; ++num)
+    for (num = firstMaybeUnused; num < size && threadIndexes[num]; ++num)
         ;
     if (num + 1 > threadIndexes.size())
         threadIndexes.resize(num+1);
     threadIndexes[num] = true;
+    firstMaybeUnused = num + 1;
     return num;
 }
 
 void Thread::Impl::ThreadMap::add(Impl* const impl)
 {
-    LockGuard lock{mutex};
     assert(impl->joinable());
-    assert(threads.find(impl->id()) == threads.end());
     impl->threadIndex = setAndGetLowestUnusedIndex();
-    threads[impl->id()] = impl;
+    auto&     shard = getShard(impl->id());
+    LockGuard lock{shard.mutex};
+    assert(shard.threads.find(impl->id()) == shard.threads.end());
+    shard.threads[impl->id()] = impl;
     //std::clog << "Added thread " << impl->id() << std::endl;
 }
 
 bool Thread::Impl::ThreadMap::contains(const ThreadId& threadId)
 {
-    LockGuard lock{mutex};
-    return threads.find(threadId) != threads.end();
+    auto&     shard = getShard(threadId);
+    LockGuard lock{shard.mutex};
+    return shard.threads.find(threadId) != shard.threads.end();
 }
 
 /**
@@ -121,28 +141,41 @@ bool Thread::Impl::ThreadMap::contains(const ThreadId& threadId)
  */
 Thread::Impl* Thread::Impl::ThreadMap::get(const ThreadId& threadId)
 {
-    LockGuard lock{mutex};
-    auto iter = threads.find(threadId);
-    return (iter == threads.end()) ? nullptr : iter->second;
+    auto&     shard = getShard(threadId);
+    LockGuard lock{shard.mutex};
+    auto iter = shard.threads.find(threadId);
+    return (iter == shard.threads.end()) ? nullptr : iter->second;
 }
 
 Thread::Impl::ThreadMap::Map::size_type
 Thread::Impl::ThreadMap::erase(const ThreadId& threadId)
 {
     assert(threadId != ThreadId{});
-    LockGuard lock{mutex};
-    auto iter = threads.find(threadId);
-    if (iter == threads.end())
-        return 0;
-    threadIndexes[iter->second->threadIndex] = false;
-    threads.erase(iter);
+    long  threadIndex;
+    {
+        auto&     shard = getShard(threadId);
+        LockGuard lock{shard.mutex};
+        auto iter = shard.threads.find(threadId);
+        if (iter == shard.threads.end())
+            return 0;
+        threadIndex = iter->second->threadIndex;
+        shard.threads.erase(iter);
+    }
+    LockGuard lock{indexMutex};
+    threadIndexes[threadIndex] = false;
+    if (threadIndex < firstMaybeUnused)
+        firstMaybeUnused = threadIndex;
     return 1;
 }
 
 Thread::Impl::ThreadMap::Map::size_type Thread::Impl::ThreadMap::size()
 {
-    LockGuard lock{mutex};
-    return threads.size();
+    Map::size_type num = 0;
+    for (size_t i = 0; i < numShards; ++i) {
+        LockGuard lock{shards[i].mutex};
+        num += shards[i].threads.size();
+    }
+    return num;
 }
 
 /******************************************************************************/
@@ -175,6 +208,8 @@ Barrier::~Barrier() noexcept
 
 Thread::Impl::ThreadMap Thread::Impl::threads;
 
+thread_local Thread::Impl* Thread::Impl::currentImpl = nullptr;
+
 bool Thread::Impl::isLocked() const
 {
     if (!mutex.try_lock())
@@ -203,6 +238,26 @@ void Thread::Impl::privateCancel()
     assert(lockedJoinable());
     if (native_handle != stdThread.native_handle())
         ::abort();
+    // Set whichever mechanism is used so `cancelRequested()` polls observe
+    // the request even if this call raced with the cooperative opt-in
+    stopRequested.store(true);
+    if (cooperative.load()) {
+        /*
+         * The thread opted in to cooperative cancellation: it observes the
+         * request at its next loop boundary and returns normally -- no
+         * asynchronous unwinding -- so a blocking operation must be
+         * interrupted explicitly.
+         */
+        if (interrupter) {
+            try {
+                interrupter(); // Invoked with `mutex` locked
+            }
+            catch (const std::exception& e) {
+                log_error(e);
+            }
+        }
+        return;
+    }
     auto status = ::pthread_cancel(stdThread.native_handle());
     if (status)
         throw SYSTEM_ERROR("Couldn't cancel thread: "
@@ -340,6 +395,85 @@ long Thread::Impl::getThreadNumber() noexcept
     return impl ? impl->threadIndex : -1;
 }
 
+/**
+ * Sets the CPU affinity of a POSIX thread.
+ * @param[in] handle       POSIX thread handle
+ * @param[in] cpus         CPU indexes the thread may run on
+ * @throw InvalidArgument  `cpus` is empty
+ * @throw SystemError      Affinity couldn't be set
+ */
+static void setThreadAffinity(
+        const pthread_t              handle,
+        const std::vector<unsigned>& cpus)
+{
+    if (cpus.empty())
+        throw INVALID_ARGUMENT("Empty set of CPU indexes");
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (const auto cpu : cpus)
+        CPU_SET(cpu, &cpuSet);
+    const int status = ::pthread_setaffinity_np(handle, sizeof(cpuSet),
+            &cpuSet);
+    if (status)
+        throw SYSTEM_ERROR("pthread_setaffinity_np() failure", status);
+}
+
+void Thread::Impl::setAffinity(const std::vector<unsigned>& cpus)
+{
+    setThreadAffinity(native_handle, cpus);
+}
+
+/**
+ * Sets the scheduling policy and priority of a thread. Real-time policies
+ * need either `CAP_SYS_NICE` or an `RLIMIT_RTPRIO` soft limit at or above
+ * the requested priority; the limit is checked up front so the failure
+ * names the rlimit instead of surfacing as a bare `EPERM`.
+ * @param[in] handle       Native handle of the thread
+ * @param[in] policy       `SCHED_FIFO`, `SCHED_RR`, or `SCHED_OTHER`
+ * @param[in] priority     Priority within the policy's range. Must be 0 for
+ *                         `SCHED_OTHER`.
+ * @throw InvalidArgument  Unsupported policy or out-of-range priority
+ * @throw RuntimeError     `RLIMIT_RTPRIO` forbids the requested priority
+ * @throw SystemError      Scheduling couldn't be set
+ */
+static void setThreadScheduling(
+        const pthread_t handle,
+        const int       policy,
+        const int       priority)
+{
+    if (policy != SCHED_FIFO && policy != SCHED_RR && policy != SCHED_OTHER)
+        throw INVALID_ARGUMENT("Unsupported scheduling policy: " +
+                std::to_string(policy));
+    const int minPrio = ::sched_get_priority_min(policy);
+    const int maxPrio = ::sched_get_priority_max(policy);
+    if (priority < minPrio || priority > maxPrio)
+        throw INVALID_ARGUMENT("Priority " + std::to_string(priority) +
+                " is outside [" + std::to_string(minPrio) + ", " +
+                std::to_string(maxPrio) + "] of scheduling policy " +
+                std::to_string(policy));
+    if (policy != SCHED_OTHER && ::geteuid() != 0) {
+        struct rlimit rlimit;
+        if (::getrlimit(RLIMIT_RTPRIO, &rlimit) == 0 &&
+                static_cast<rlim_t>(priority) > rlimit.rlim_cur)
+            throw RUNTIME_ERROR("RLIMIT_RTPRIO soft limit (" +
+                    std::to_string(rlimit.rlim_cur) + ") is below requested "
+                    "real-time priority " + std::to_string(priority) +
+                    ": raise the limit or grant CAP_SYS_NICE");
+    }
+    struct sched_param param = {};
+    param.sched_priority = priority;
+    const int status = ::pthread_setschedparam(handle, policy, &param);
+    if (status)
+        throw SYSTEM_ERROR("pthread_setschedparam() failure", status);
+}
+
+void Thread::Impl::setScheduling(
+        const int policy,
+        const int priority)
+{
+    setThreadScheduling(native_handle, policy, priority);
+}
+
 void Thread::Impl::cancel()
 {
     ensureCompleted();
@@ -356,6 +490,27 @@ void Thread::Impl::cancel(const Id& threadId)
     }
 }
 
+void Thread::Impl::enableCooperativeCancel() noexcept
+{
+    if (currentImpl)
+        currentImpl->cooperative.store(true);
+}
+
+bool Thread::Impl::cancelRequested() noexcept
+{
+    return currentImpl &&
+            currentImpl->stopRequested.load(std::memory_order_relaxed);
+}
+
+void Thread::Impl::setInterrupter(const std::function<void()>& func)
+{
+    if (currentImpl == nullptr)
+        throw LOGIC_ERROR("Current thread isn't a `Thread`");
+    LockGuard lock{currentImpl->mutex};
+    currentImpl->interrupter = func;
+    currentImpl->cooperative.store(true);
+}
+
 bool Thread::Impl::joinable() const
 {
     LockGuard lock{mutex};
@@ -456,6 +611,91 @@ void Thread::testCancel()
     ::pthread_testcancel();
 }
 
+void Thread::enableCooperativeCancel() noexcept
+{
+    Impl::enableCooperativeCancel();
+}
+
+bool Thread::cancelRequested() noexcept
+{
+    return Impl::cancelRequested();
+}
+
+void Thread::setInterrupter(const std::function<void()>& func)
+{
+    Impl::setInterrupter(func);
+}
+
+void Thread::setAffinity(const std::vector<unsigned>& cpus) const
+{
+    if (!pImpl)
+        throw LOGIC_ERROR("Thread was default constructed");
+    pImpl->setAffinity(cpus);
+}
+
+void Thread::setCurrentAffinity(const std::vector<unsigned>& cpus)
+{
+    setThreadAffinity(::pthread_self(), cpus);
+}
+
+void Thread::setScheduling(
+        const int policy,
+        const int priority) const
+{
+    if (!pImpl)
+        throw LOGIC_ERROR("Thread was default constructed");
+    pImpl->setScheduling(policy, priority);
+}
+
+void Thread::setCurrentScheduling(
+        const int policy,
+        const int priority)
+{
+    setThreadScheduling(::pthread_self(), policy, priority);
+}
+
+void Thread::setDefaultStackSize(const size_t nbytes)
+{
+    if (nbytes == 0)
+        throw INVALID_ARGUMENT("Zero stack size");
+    size_t     size = nbytes;
+    const long pageSize = ::sysconf(_SC_PAGESIZE);
+    if (pageSize > 0) // Round up to a whole number of pages
+        size = ((size + pageSize - 1) / pageSize) * pageSize;
+    if (size < PTHREAD_STACK_MIN)
+        size = PTHREAD_STACK_MIN;
+    /*
+     * The default thread-attributes apply to every subsequently-created
+     * thread -- `std::thread` creates with a `nullptr` attribute -- so the
+     * one knob covers `Thread`, `Executor`, and everything built on them.
+     */
+    pthread_attr_t attr;
+    auto status = ::pthread_getattr_default_np(&attr);
+    if (status)
+        throw SYSTEM_ERROR("pthread_getattr_default_np() failure", status);
+    status = ::pthread_attr_setstacksize(&attr, size);
+    if (status == 0)
+        status = ::pthread_setattr_default_np(&attr);
+    ::pthread_attr_destroy(&attr);
+    if (status)
+        throw SYSTEM_ERROR("Couldn't set default thread stack-size to " +
+                std::to_string(size) + " bytes", status);
+}
+
+size_t Thread::getDefaultStackSize()
+{
+    pthread_attr_t attr;
+    auto status = ::pthread_getattr_default_np(&attr);
+    if (status)
+        throw SYSTEM_ERROR("pthread_getattr_default_np() failure", status);
+    size_t size;
+    status = ::pthread_attr_getstacksize(&attr, &size);
+    ::pthread_attr_destroy(&attr);
+    if (status)
+        throw SYSTEM_ERROR("pthread_attr_getstacksize() failure", status);
+    return size;
+}
+
 void Thread::cancel()
 {
     if (pImpl)
@@ -24,6 +24,7 @@
 #include <map>
 #include <memory>
 #include <pthread.h>
+#include <sched.h>
 #include <thread>
 #include <vector>
 
@@ -219,10 +220,25 @@ private:
             typedef std::lock_guard<Mutex>    LockGuard;
             typedef std::map<ThreadId, Impl*> Map;
 
-            mutable Mutex      mutex;
-            Map                threads;
+            /// Number of shards. A power of two for cheap modulo.
+            static const size_t numShards = 32;
+
+            /// A shard: the subset of the threads whose identifiers hash to it.
+            /// Sharding keeps thread creation and teardown -- which happen on
+            /// every peer connection -- from serializing on a single lock.
+            struct Shard {
+                mutable Mutex mutex;
+                Map           threads;
+            };
+
+            Shard              shards[numShards];
+            /// For the thread-index allocator:
+            mutable Mutex      indexMutex;
             std::vector<bool>  threadIndexes;
+            /// Lowest index that might be unused. Scanning starts here.
+            long               firstMaybeUnused;
 
+            Shard& getShard(const ThreadId& threadId) noexcept;
             long setAndGetLowestUnusedIndex() noexcept;
 
         public:
@@ -250,10 +266,19 @@ private:
         unsigned                        state;
         Barrier                         barrier;
         long                            threadIndex;
+        /// Whether the thread opted in to cooperative cancellation:
+        std::atomic<bool>               cooperative;
+        /// Whether cancellation of the thread has been requested:
+        std::atomic<bool>               stopRequested;
+        /// Called on cancellation to interrupt a blocking operation of a
+        /// cooperatively-canceled thread. Guarded by `mutex`:
+        std::function<void()>           interrupter;
         mutable std::thread             stdThread;
         std::thread::native_handle_type native_handle;
         /// Set of joinable threads:
         static ThreadMap                threads;
+        /// Implementation associated with the current thread:
+        static thread_local Impl*       currentImpl;
 
         /**
          * Indicates if the mutex is locked or not.
@@ -384,9 +409,13 @@ private:
             , state{State::unset}
             , barrier{2}
             , threadIndex{-1} // Unknown thread number
+            , cooperative{false}
+            , stopRequested{false}
+            , interrupter{}
             , stdThread{[this](decltype(
                     std::bind(callable, std::forward<Args>(args)...))&&
                             boundCallable) mutable {
+                currentImpl = this;
                 THREAD_CLEANUP_PUSH(setCompletedAndNotify, this);
                 try {
                     Thread::disableCancel();
@@ -454,6 +483,28 @@ private:
          */
         static long getThreadNumber() noexcept;
 
+        /**
+         * Sets the CPU affinity of the thread.
+         * @param[in] cpus         CPU indexes the thread may run on
+         * @throw InvalidArgument  `cpus` is empty
+         * @throw SystemError      Affinity couldn't be set
+         * @exceptionsafety        Strong guarantee
+         * @threadsafety           Safe
+         */
+        void setAffinity(const std::vector<unsigned>& cpus);
+
+        /**
+         * Sets the scheduling policy and priority of the thread.
+         * @param[in] policy       `SCHED_FIFO`, `SCHED_RR`, or `SCHED_OTHER`
+         * @param[in] priority     Priority within the policy's range
+         * @throw InvalidArgument  Unsupported policy or out-of-range priority
+         * @throw RuntimeError     `RLIMIT_RTPRIO` forbids the priority
+         * @throw SystemError      Scheduling couldn't be set
+         * @exceptionsafety        Strong guarantee
+         * @threadsafety           Safe
+         */
+        void setScheduling(const int policy, const int priority);
+
         /**
          * Cancels the thread. Idempotent. The completion of the
          * thread-of-execution is asynchronous with respect to this function.
@@ -473,6 +524,29 @@ private:
          */
         static void cancel(const ThreadId& threadId);
 
+        /**
+         * Opts the current thread in to cooperative cancellation. Does
+         * nothing if the current thread isn't a `Thread`.
+         */
+        static void enableCooperativeCancel() noexcept;
+
+        /**
+         * Indicates if cancellation of the current thread has been requested.
+         * Always `false` on a thread that isn't a `Thread`.
+         * @retval `true`   Cancellation has been requested
+         * @retval `false`  Cancellation hasn't been requested
+         */
+        static bool cancelRequested() noexcept;
+
+        /**
+         * Registers the cancellation-interrupter of the current thread. Also
+         * opts the thread in to cooperative cancellation. An empty function
+         * deregisters.
+         * @param[in] func    Interrupter or empty function
+         * @throw LogicError  Current thread isn't a `Thread`
+         */
+        static void setInterrupter(const std::function<void()>& func);
+
         /**
          * Indicates if this instance is joinable or not.
          * @return `true`   Instance is joinable
@@ -624,6 +698,148 @@ public:
      */
     static void testCancel();
 
+    /**
+     * Opts the current thread in to cooperative cancellation. Thereafter,
+     * `cancel()` sets a per-thread flag and invokes any interrupter
+     * registered via `setInterrupter()` instead of delivering
+     * `pthread_cancel()`: the thread observes the request by polling
+     * `cancelRequested()` at its natural loop boundaries and returns
+     * normally, so no asynchronous stack unwinding occurs and blocking calls
+     * need no `Canceler` scopes or cancellation points. Does nothing if the
+     * current thread isn't a `Thread`.
+     * @exceptionsafety  Nothrow
+     * @threadsafety     Safe
+     * @see cancelRequested()
+     * @see setInterrupter()
+     */
+    static void enableCooperativeCancel() noexcept;
+
+    /**
+     * Indicates if cancellation of the current thread has been requested.
+     * The cooperative analogue of `testCancel()`: a single relaxed atomic
+     * load, intended to be polled at loop boundaries. Set by `cancel()`
+     * whichever cancellation mechanism it uses, so a cooperatively-canceled
+     * loop observes the request even if `cancel()` raced with the opt-in.
+     * Always `false` on a thread that isn't a `Thread`.
+     * @retval `true`    Cancellation has been requested
+     * @retval `false`   Cancellation hasn't been requested
+     * @exceptionsafety  Nothrow
+     * @threadsafety     Safe
+     * @see enableCooperativeCancel()
+     */
+    static bool cancelRequested() noexcept;
+
+    /**
+     * Registers a function that `cancel()` will invoke -- on the canceling
+     * thread -- to interrupt a blocking operation of the current thread:
+     * e.g., notifying a condition-variable or shutting down a socket.
+     * Registering an interrupter also opts the thread in to cooperative
+     * cancellation. An empty function deregisters. Because cancellation
+     * might have been requested before registration, the thread should check
+     * `cancelRequested()` afterward. The RAII class `Interrupter` should be
+     * used instead of calling this directly.
+     * @param[in] func     Interrupter or empty function
+     * @throw LogicError   Current thread isn't a `Thread`
+     * @exceptionsafety    Strong guarantee
+     * @threadsafety       Safe
+     * @see `Interrupter`
+     */
+    static void setInterrupter(const std::function<void()>& func);
+
+    /**
+     * Sets the CPU affinity of this thread. On NUMA systems, pinning a thread
+     * near the relevant device (e.g., the NIC) and letting it first-touch its
+     * buffers keeps both the thread and its memory on the same node.
+     * @param[in] cpus         CPU indexes the thread may run on
+     * @throw InvalidArgument  `cpus` is empty
+     * @throw LogicError       This instance was default constructed
+     * @throw SystemError      Affinity couldn't be set
+     * @exceptionsafety        Strong guarantee
+     * @threadsafety           Safe
+     */
+    void setAffinity(const std::vector<unsigned>& cpus) const;
+
+    /**
+     * Sets the scheduling policy and priority of this thread. A `SCHED_FIFO`
+     * or `SCHED_RR` thread preempts every `SCHED_OTHER` thread on its CPU
+     * and runs until it blocks, so a receive thread made real-time no longer
+     * loses the CPU to housekeeping under load -- the remaining receive
+     * jitter is bounded by interrupts, not by the scheduler. Use sparingly:
+     * only the latency-critical receive threads should be real-time, with
+     * backlog and maintenance work left at `SCHED_OTHER`, and a real-time
+     * thread that spins without blocking can starve the rest of its CPU.
+     * Best combined with `setAffinity()` so the real-time thread owns a
+     * dedicated core. Requires `CAP_SYS_NICE` or an `RLIMIT_RTPRIO` soft
+     * limit at or above the priority; the limit is checked up front so the
+     * failure names the rlimit instead of surfacing as a bare `EPERM`.
+     * @param[in] policy       `SCHED_FIFO`, `SCHED_RR`, or `SCHED_OTHER`
+     * @param[in] priority     Priority within the policy's range (see
+     *                         `sched_get_priority_min()`/`_max()`). Must be
+     *                         0 for `SCHED_OTHER`.
+     * @throw InvalidArgument  Unsupported policy or out-of-range priority
+     * @throw LogicError       This instance was default constructed
+     * @throw RuntimeError     `RLIMIT_RTPRIO` forbids the priority
+     * @throw SystemError      Scheduling couldn't be set
+     * @exceptionsafety        Strong guarantee
+     * @threadsafety           Safe
+     */
+    void setScheduling(const int policy, const int priority) const;
+
+    /**
+     * Sets the default stack size of subsequently-created threads --
+     * including those of `Executor`, `Completer`, and `PeerSet`, which are
+     * all created through this class. Stack pages are committed lazily, on
+     * first touch, but every thread reserves the full size of virtual
+     * address space: the platform default (`RLIMIT_STACK`, typically 8 MiB)
+     * times a thread-per-peer population can exceed the overcommit or
+     * cgroup limit of a memory-constrained node, while protocol threads
+     * need only tens of KB. The given size is rounded up to the platform's
+     * minimum. Also adjustable at runtime via the tunable
+     * `thread.default_stack_size`.
+     * @param[in] nbytes       Default stack size in bytes
+     * @throw InvalidArgument  `nbytes == 0`
+     * @throw SystemError      Default couldn't be set
+     * @exceptionsafety        Strong guarantee
+     * @threadsafety           Safe
+     */
+    static void setDefaultStackSize(const size_t nbytes);
+
+    /**
+     * Returns the default stack size of subsequently-created threads.
+     * @return             Default stack size in bytes or 0 for the platform
+     *                     default (`RLIMIT_STACK`)
+     * @throw SystemError  Default couldn't be obtained
+     * @exceptionsafety    Strong guarantee
+     * @threadsafety       Safe
+     */
+    static size_t getDefaultStackSize();
+
+    /**
+     * Sets the CPU affinity of the current thread. May be called from threads
+     * that aren't `Thread`-s.
+     * @param[in] cpus         CPU indexes the thread may run on
+     * @throw InvalidArgument  `cpus` is empty
+     * @throw SystemError      Affinity couldn't be set
+     * @exceptionsafety        Strong guarantee
+     * @threadsafety           Safe
+     */
+    static void setCurrentAffinity(const std::vector<unsigned>& cpus);
+
+    /**
+     * Sets the scheduling policy and priority of the current thread. May be
+     * called from threads that aren't `Thread`-s.
+     * @param[in] policy       `SCHED_FIFO`, `SCHED_RR`, or `SCHED_OTHER`
+     * @param[in] priority     Priority within the policy's range. Must be 0
+     *                         for `SCHED_OTHER`.
+     * @throw InvalidArgument  Unsupported policy or out-of-range priority
+     * @throw RuntimeError     `RLIMIT_RTPRIO` forbids the priority
+     * @throw SystemError      Scheduling couldn't be set
+     * @exceptionsafety        Strong guarantee
+     * @threadsafety           Safe
+     * @see setScheduling()
+     */
+    static void setCurrentScheduling(const int policy, const int priority);
+
     /**
      * Cancels this thread. Idempotent. Does nothing if the thread isn't
      * joinable. The completion of the thread-of-execution is asynchronous with
@@ -694,6 +910,47 @@ public:
     }
 };
 
+/**
+ * RAII class that registers a cancellation-interrupter for the current thread
+ * on construction and deregisters it on destruction. The counterpart of
+ * `Canceler` for cooperatively-canceled threads: instead of enabling
+ * asynchronous cancellation around a blocking call, the blocking call is
+ * unblocked by the interrupter and the thread then observes
+ * `Thread::cancelRequested()` at its loop boundary.
+ */
+class Interrupter
+{
+public:
+    /**
+     * Registers the interrupter. Opts the current thread in to cooperative
+     * cancellation.
+     * @param[in] func    Function that unblocks the thread's blocking
+     *                    operation. Invoked on the canceling thread.
+     * @throw LogicError  Current thread isn't a `Thread`
+     * @see `Thread::setInterrupter()`
+     */
+    explicit Interrupter(const std::function<void()>& func)
+    {
+        Thread::setInterrupter(func);
+    }
+
+    Interrupter(const Interrupter& that) =delete;
+    Interrupter& operator=(const Interrupter& rhs) =delete;
+
+    /**
+     * Deregisters the interrupter.
+     */
+    ~Interrupter()
+    {
+        try {
+            Thread::setInterrupter(std::function<void()>{});
+        }
+        catch (const std::exception& e) {
+            log_error(e); // Because a destructor shouldn't throw an exception
+        }
+    }
+};
+
 } // namespace
 
 /******************************************************************************/
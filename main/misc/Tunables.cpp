@@ -0,0 +1,296 @@
+/**
+ * This file implements a process-wide registry of runtime-adjustable
+ * parameters and a server that adjusts them over a Unix-domain socket.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: Tunables.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "error.h"
+#include "logging.h"
+#include "Thread.h"
+#include "Tunables.h"
+
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace hycast {
+
+namespace {
+    /**
+     * The registry proper. A Meyers singleton so components may register
+     * tunables from static initializers in any order.
+     */
+    struct Registry final
+    {
+        /// One registered tunable
+        struct Entry final
+        {
+            std::string      help;
+            Tunables::Setter setter;
+        };
+
+        std::mutex mutex;
+        /// Tunables by name. Ordered so `list` reports alphabetically.
+        std::map<std::string, Entry> entries;
+
+        static Registry& instance()
+        {
+            static Registry registry{};
+            return registry;
+        }
+    };
+}
+
+class Tunables::Handle::Impl final
+{
+    std::string name;
+
+public:
+    explicit Impl(const std::string& name)
+        : name{name}
+    {}
+
+    ~Impl() noexcept
+    {
+        auto& registry = Registry::instance();
+        std::lock_guard<std::mutex> lock{registry.mutex};
+        registry.entries.erase(name);
+    }
+};
+
+Tunables::Handle::Handle(Impl* const impl)
+    : pImpl{impl}
+{}
+
+Tunables::Handle Tunables::registerTunable(
+        const std::string& name,
+        const std::string& help,
+        const Setter&      setter)
+{
+    auto&                       registry = Registry::instance();
+    std::lock_guard<std::mutex> lock{registry.mutex};
+    if (registry.entries.count(name))
+        throw INVALID_ARGUMENT("Tunable \"" + name + "\" already registered");
+    auto& entry = registry.entries[name];
+    entry.help = help;
+    entry.setter = setter;
+    return Handle{new Handle::Impl(name)};
+}
+
+std::string Tunables::set(
+        const std::string& name,
+        const std::string& value)
+{
+    auto&                       registry = Registry::instance();
+    std::lock_guard<std::mutex> lock{registry.mutex};
+    auto                        iter = registry.entries.find(name);
+    if (iter == registry.entries.end())
+        throw NOT_FOUND_ERROR("No such tunable: \"" + name + "\"");
+    // Applied under the lock, like `Metrics::report()` samples gauges, so a
+    // setter can't run against a component being destroyed: the component's
+    // handle blocks in deregistration until the setter returns
+    return iter->second.setter(value);
+}
+
+void Tunables::list(std::ostream& ostream)
+{
+    auto&                       registry = Registry::instance();
+    std::lock_guard<std::mutex> lock{registry.mutex};
+    for (const auto& elt : registry.entries)
+        ostream << elt.first << ' ' << elt.second.help << '\n';
+}
+
+class TunablesServer::Impl final
+{
+    std::string      pathname;
+    int              sd;
+    /// Built-in tunable for the logging threshold
+    Tunables::Handle logLevelTunable;
+    /// Built-in tunable for the default thread stack-size
+    Tunables::Handle stackSizeTunable;
+    Thread           serverThread;
+
+    /**
+     * Executes one command-line and returns the reply.
+     * @param[in] line  Command-line (without the terminating newline)
+     * @return          Reply text. Empty for an empty line.
+     */
+    static std::string execute(const std::string& line)
+    {
+        std::istringstream iss{line};
+        std::string        command;
+        iss >> command;
+        if (command.empty())
+            return "";
+        if (command == "list") {
+            std::ostringstream oss;
+            Tunables::list(oss);
+            return oss.str();
+        }
+        if (command == "set") {
+            std::string name;
+            std::string value;
+            iss >> name >> value;
+            if (name.empty() || value.empty())
+                return "error: usage: set <name> <value>\n";
+            try {
+                return "ok: " + name + " = " + Tunables::set(name, value) +
+                        "\n";
+            }
+            catch (const std::exception& e) {
+                return std::string{"error: "} + e.what() + "\n";
+            }
+        }
+        return "error: unknown command \"" + command + "\"\n";
+    }
+
+    /**
+     * Serves one connection: executes each received command-line and writes
+     * its reply until the client hangs up.
+     * @param[in] sd  Connection socket descriptor. Closed on return.
+     */
+    static void serve(const int sd) noexcept
+    {
+        try {
+            std::string line;
+            char        buf[512];
+            for (bool open = true; open; ) {
+                const auto nbytes = ::read(sd, buf, sizeof(buf));
+                if (nbytes <= 0)
+                    break;
+                for (ssize_t i = 0; i < nbytes && open; ++i) {
+                    if (buf[i] != '\n') {
+                        line.push_back(buf[i]);
+                        continue;
+                    }
+                    const auto  reply = execute(line);
+                    line.clear();
+                    const char* bytes = reply.data();
+                    size_t      left = reply.size();
+                    while (left > 0) {
+                        const auto n = ::write(sd, bytes, left);
+                        if (n < 0) {
+                            open = false;
+                            break;
+                        }
+                        bytes += n;
+                        left -= n;
+                    }
+                }
+            }
+        }
+        catch (const std::exception& e) {
+            log_warn(e); // Because end of thread
+        }
+        ::close(sd);
+    }
+
+    /**
+     * Accepts control connections. Doesn't return unless an exception is
+     * thrown. Intended to be run on a separate thread.
+     * @exceptionsafety  Basic guarantee
+     * @threadsafety     Compatible but not safe
+     */
+    void runServer()
+    {
+        try {
+            for (;;) {
+                const auto connSd = ::accept(sd, nullptr, nullptr); // Blocks
+                if (connSd < 0)
+                    throw SYSTEM_ERROR(
+                            "accept() failure on control socket " + pathname);
+                serve(connSd);
+            }
+        }
+        catch (const std::exception& e) {
+            log_error(e); // Because end of thread
+        }
+    }
+
+public:
+    /**
+     * Constructs.
+     * @param[in] pathname  Pathname of the Unix-domain socket to serve on
+     * @throw SystemError   Socket couldn't be created or bound
+     */
+    explicit Impl(const std::string& pathname)
+        : pathname{pathname}
+        , sd{::socket(AF_UNIX, SOCK_STREAM, 0)}
+        , logLevelTunable{}
+        , stackSizeTunable{}
+        , serverThread{}
+    {
+        if (sd < 0)
+            throw SYSTEM_ERROR("Couldn't create control socket " + pathname);
+        try {
+            logLevelTunable = Tunables::registerTunable("log_level",
+                    "Logging threshold: debug, info, note, warn, or error",
+                    [](const std::string& value) {
+                        if      (value == "debug") logLevel = LOG_DEBUG;
+                        else if (value == "info")  logLevel = LOG_INFO;
+                        else if (value == "note")  logLevel = LOG_NOTE;
+                        else if (value == "warn")  logLevel = LOG_WARN;
+                        else if (value == "error") logLevel = LOG_ERROR;
+                        else
+                            throw INVALID_ARGUMENT(
+                                    "Unknown logging level \"" + value +
+                                    "\"");
+                        return value;
+                    });
+            stackSizeTunable = Tunables::registerTunable(
+                    "thread.default_stack_size",
+                    "Default stack size, in bytes, of subsequently-created "
+                    "threads",
+                    [](const std::string& value) {
+                        Thread::setDefaultStackSize(
+                                static_cast<size_t>(std::stoul(value)));
+                        return std::to_string(Thread::getDefaultStackSize());
+                    });
+            struct sockaddr_un sockAddr = {};
+            sockAddr.sun_family = AF_UNIX;
+            if (pathname.size() >= sizeof(sockAddr.sun_path))
+                throw INVALID_ARGUMENT("Control socket pathname \"" +
+                        pathname + "\" is too long");
+            pathname.copy(sockAddr.sun_path, sizeof(sockAddr.sun_path)-1);
+            ::unlink(pathname.c_str()); // Remove stale socket-file
+            if (::bind(sd, reinterpret_cast<struct sockaddr*>(&sockAddr),
+                    sizeof(sockAddr)) ||
+                    ::listen(sd, 8))
+                throw SYSTEM_ERROR(
+                        "Couldn't serve on control socket " + pathname);
+            serverThread = Thread{[this]{runServer();}};
+        }
+        catch (const std::exception& e) {
+            ::close(sd);
+            throw;
+        }
+    }
+
+    ~Impl() noexcept
+    {
+        try {
+            serverThread.cancel(); // `accept()` is a cancellation point
+        }
+        catch (const std::exception& e) {
+            log_error(e); // Because destructors mustn't throw
+        }
+        ::close(sd);
+        ::unlink(pathname.c_str());
+    }
+};
+
+TunablesServer::TunablesServer(const std::string& pathname)
+    : pImpl{new Impl(pathname)}
+{}
+
+} // namespace
@@ -0,0 +1,125 @@
+/**
+ * This file declares a process-wide registry of runtime-adjustable parameters
+ * ("tunables") and a server that adjusts them, on command, over a Unix-domain
+ * socket. Parameters like the maximum number of peers, the multicast pacing
+ * rate, and the product residence-time can thus be tuned under load instead
+ * of by a restart -- which would cost a multicast gap and its backlog repair.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: Tunables.h
+ * @author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_MISC_TUNABLES_H_
+#define MAIN_MISC_TUNABLES_H_
+
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace hycast {
+
+/**
+ * Process-wide registry of tunables. A component registers a tunable over its
+ * own state; the constructor parameter that set that state becomes merely its
+ * initial value. An instance-number in the name (e.g., `peerset.0.max_peers`)
+ * distinguishes multiple instances of a component in one process.
+ */
+class Tunables final
+{
+public:
+    /// Function that applies a tunable's new value, given in textual form,
+    /// and returns the resulting value as text. Called on the control-server
+    /// thread, so it must be thread-safe; an unacceptable value is rejected
+    /// by throwing.
+    typedef std::function<std::string(const std::string&)> Setter;
+
+    /**
+     * Handle for a registered tunable. Destruction of the last copy
+     * deregisters the tunable, so an object that registers a tunable over
+     * its own state keeps the handle as a member and the tunable can't
+     * outlive the state it adjusts.
+     */
+    class Handle final
+    {
+        friend class Tunables;
+
+        class                 Impl;
+        std::shared_ptr<Impl> pImpl;
+
+        explicit Handle(Impl* impl);
+
+    public:
+        Handle() =default;
+    };
+
+    /**
+     * Registers a tunable.
+     * @param[in] name         Name of the tunable
+     * @param[in] help         One-line description, including the unit
+     * @param[in] setter       Applies a new value
+     * @return                 Handle whose destruction deregisters the
+     *                         tunable
+     * @throw InvalidArgument  Name is already registered
+     * @exceptionsafety        Strong guarantee
+     * @threadsafety           Safe
+     */
+    static Handle registerTunable(
+            const std::string& name,
+            const std::string& help,
+            const Setter&      setter);
+
+    /**
+     * Sets a tunable to a new value.
+     * @param[in] name      Name of the tunable
+     * @param[in] value     New value in textual form
+     * @return              Resulting value as text
+     * @throw NotFoundError No such tunable
+     * @throw               Whatever the tunable's setter throws for an
+     *                      unacceptable value
+     * @exceptionsafety     Strong guarantee
+     * @threadsafety        Safe
+     */
+    static std::string set(
+            const std::string& name,
+            const std::string& value);
+
+    /**
+     * Writes the name and description of every registered tunable to a
+     * stream, one per line.
+     * @param[in] ostream  Output stream
+     * @threadsafety       Safe
+     */
+    static void list(std::ostream& ostream);
+};
+
+/**
+ * Server that adjusts registered tunables on behalf of whoever connects to
+ * its Unix-domain socket -- e.g., an operator with `nc -U`. The protocol is
+ * one command per line: `list` writes the registered tunables and `set <name>
+ * <value>` applies a value, answering `ok: ...` or `error: ...`. Runs on its
+ * own thread. The logging level is served as the built-in tunable
+ * `log_level` and the default thread stack-size as
+ * `thread.default_stack_size`.
+ */
+class TunablesServer final
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Constructs. Any stale socket-file at the pathname is removed first.
+     * @param[in] pathname  Pathname of the Unix-domain socket to serve on
+     * @throw SystemError   Socket couldn't be created or bound
+     */
+    explicit TunablesServer(const std::string& pathname);
+};
+
+} // namespace
+
+#endif /* MAIN_MISC_TUNABLES_H_ */
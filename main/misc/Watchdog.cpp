@@ -0,0 +1,262 @@
+/**
+ * This file implements a stall watchdog for the hot-path threads.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: Watchdog.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "error.h"
+#include "FlightRecorder.h"
+#include "logging.h"
+#include "Thread.h"
+#include "Watchdog.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <execinfo.h>
+#include <mutex>
+#include <pthread.h>
+#include <set>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace hycast {
+
+/// Visible outside `Heartbeat` because the registry and the monitor, below,
+/// work directly on it
+class Watchdog::Heartbeat::Impl final
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+    typedef Clock::time_point         TimePoint;
+
+    const std::string     name;   ///< Thread name for log messages
+    const pthread_t       thread; ///< Thread the heartbeat reports on
+    std::atomic<uint64_t> count;  ///< Number of units of work completed
+    /// Whether the thread is blocked awaiting input, which isn't a stall
+    std::atomic<bool>     parked;
+
+    /*
+     * The monitor's notebook on this heartbeat. Accessed only by the monitor
+     * thread, under the registry lock.
+     */
+    uint64_t  lastCount;  ///< Count at the last observed progress
+    TimePoint lastChange; ///< Time of the last observed progress
+    bool      stalled;    ///< Whether a stall has been reported
+
+    explicit Impl(const std::string& name);
+
+    ~Impl() noexcept;
+
+    inline void beat() noexcept
+    {
+        parked.store(false, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    inline void park() noexcept
+    {
+        parked.store(true, std::memory_order_relaxed);
+    }
+};
+
+namespace {
+    /**
+     * The heartbeat registry. A Meyers singleton so hot-path threads may
+     * register in any order relative to the monitor's construction.
+     */
+    struct Registry final
+    {
+        std::mutex mutex;
+        std::set<Watchdog::Heartbeat::Impl*> entries;
+
+        static Registry& instance()
+        {
+            static Registry registry{};
+            return registry;
+        }
+    };
+
+    /**
+     * Writes the calling thread's stack to the standard error stream.
+     * Installed on `SIGUSR2` by the monitor and raised in the stalled
+     * thread. `backtrace()` isn't formally async-signal-safe, but this
+     * handler runs only when the thread is already known to be stuck and a
+     * best-effort stack beats no stack.
+     */
+    extern "C" void dumpStack(const int sig)
+    {
+        static const char heading[] = "Stack of stalled thread:\n";
+        const auto        ignored = ::write(STDERR_FILENO, heading,
+                sizeof(heading)-1);
+        static_cast<void>(ignored);
+        void* frames[64];
+        const int numFrames = ::backtrace(frames,
+                sizeof(frames)/sizeof(frames[0]));
+        ::backtrace_symbols_fd(frames, numFrames, STDERR_FILENO);
+    }
+}
+
+Watchdog::Heartbeat::Impl::Impl(const std::string& name)
+    : name{name}
+    , thread{::pthread_self()}
+    , count{0}
+    , parked{false}
+    , lastCount{0}
+    , lastChange{Clock::now()}
+    , stalled{false}
+{
+    auto& registry = Registry::instance();
+    std::lock_guard<std::mutex> lock{registry.mutex};
+    registry.entries.insert(this);
+}
+
+Watchdog::Heartbeat::Impl::~Impl() noexcept
+{
+    auto& registry = Registry::instance();
+    std::lock_guard<std::mutex> lock{registry.mutex};
+    registry.entries.erase(this);
+}
+
+Watchdog::Heartbeat::Heartbeat(Impl* const impl)
+    : pImpl{impl}
+{}
+
+void Watchdog::Heartbeat::beat() const noexcept
+{
+    pImpl->beat();
+}
+
+void Watchdog::Heartbeat::park() const noexcept
+{
+    pImpl->park();
+}
+
+Watchdog::Heartbeat Watchdog::registerThread(const std::string& name)
+{
+    return Heartbeat{new Heartbeat::Impl(name)};
+}
+
+class Watchdog::Impl final
+{
+    typedef Heartbeat::Impl::Clock Clock;
+
+    /// Seconds between successive scans of the heartbeat registry
+    static const unsigned scanPeriodSecs = 1;
+
+    const Clock::duration deadline;
+    const std::string     dumpPathname;
+    Thread                monitorThread;
+
+    /**
+     * Scans the heartbeat registry once, reporting stalls and recoveries.
+     */
+    void scan()
+    {
+        auto&                       registry = Registry::instance();
+        std::lock_guard<std::mutex> lock{registry.mutex};
+        const auto                  now = Clock::now();
+        for (const auto impl : registry.entries) {
+            const auto count = impl->count.load(std::memory_order_relaxed);
+            if (count != impl->lastCount ||
+                    impl->parked.load(std::memory_order_relaxed)) {
+                if (impl->stalled) {
+                    LOG_NOTE("Thread \"" + impl->name + "\" resumed after "
+                            "stalling for " + std::to_string(
+                            std::chrono::duration_cast<std::chrono::seconds>(
+                            now - impl->lastChange).count()) + " s");
+                    impl->stalled = false;
+                }
+                impl->lastCount = count;
+                impl->lastChange = now;
+            }
+            else if (!impl->stalled && now - impl->lastChange > deadline) {
+                impl->stalled = true;
+                LOG_ERROR("Thread \"" + impl->name + "\" has made no "
+                        "progress in " + std::to_string(
+                        std::chrono::duration_cast<std::chrono::seconds>(
+                        now - impl->lastChange).count()) + " s");
+                ::pthread_kill(impl->thread, SIGUSR2); // Logs its stack
+                if (dumpPathname.size()) {
+                    FlightRecorder::dump(dumpPathname);
+                    LOG_NOTE("Flight recorder dumped to \"" + dumpPathname +
+                            "\"");
+                }
+            }
+        }
+    }
+
+    /**
+     * Periodically scans the heartbeat registry. Doesn't return unless an
+     * exception is thrown. Intended to be run on a separate thread.
+     * @exceptionsafety  Basic guarantee
+     * @threadsafety     Compatible but not safe
+     */
+    void runMonitor()
+    {
+        try {
+            for (;;) {
+                {
+                    Canceler canceler{};
+                    ::sleep(scanPeriodSecs);
+                }
+                scan();
+            }
+        }
+        catch (const std::exception& e) {
+            log_error(e); // Because end of thread
+        }
+    }
+
+public:
+    /**
+     * Constructs and starts the monitor thread.
+     * @param[in] deadlineSecs  Seconds without progress before a thread is
+     *                          flagged as stalled
+     * @param[in] dumpPathname  Pathname of the flight-recorder dump-file or
+     *                          the empty string for no dump
+     * @throw InvalidArgument   `deadlineSecs == 0`
+     * @throw SystemError       Stack-dump signal-handler couldn't be
+     *                          installed
+     */
+    Impl(   const unsigned     deadlineSecs,
+            const std::string& dumpPathname)
+        : deadline{std::chrono::seconds{deadlineSecs}}
+        , dumpPathname{dumpPathname}
+        , monitorThread{}
+    {
+        if (deadlineSecs == 0)
+            throw INVALID_ARGUMENT("Zero stall-deadline");
+        struct sigaction sigAction = {};
+        sigAction.sa_handler = dumpStack;
+        ::sigemptyset(&sigAction.sa_mask);
+        if (::sigaction(SIGUSR2, &sigAction, nullptr))
+            throw SYSTEM_ERROR("Couldn't install stack-dump signal-handler");
+        monitorThread = Thread{[this]{runMonitor();}};
+    }
+
+    ~Impl() noexcept
+    {
+        try {
+            monitorThread.cancel(); // `sleep()` is a cancellation point
+        }
+        catch (const std::exception& e) {
+            log_error(e); // Because destructors mustn't throw
+        }
+    }
+};
+
+Watchdog::Watchdog(
+        const unsigned     deadlineSecs,
+        const std::string& dumpPathname)
+    : pImpl{new Impl(deadlineSecs, dumpPathname)}
+{}
+
+} // namespace
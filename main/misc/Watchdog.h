@@ -0,0 +1,110 @@
+/**
+ * This file declares a stall watchdog for the hot-path threads. Each such
+ * thread registers a heartbeat that it bumps once per unit of work and parks
+ * while blocked awaiting input; a monitor thread flags a heartbeat that is
+ * neither beating nor parked past a deadline, logging the stalled thread's
+ * stack and dumping the flight recorder. A stall (disk hiccup, lock convoy)
+ * is thus diagnosed in seconds instead of being inferred, hours later, from
+ * downstream data gaps.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: Watchdog.h
+ * @author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_MISC_WATCHDOG_H_
+#define MAIN_MISC_WATCHDOG_H_
+
+#include <memory>
+#include <string>
+
+namespace hycast {
+
+/**
+ * Stall watchdog. Heartbeats are registered process-wide; an instance of
+ * this class monitors them on its own thread. Without an instance the
+ * heartbeats cost a relaxed atomic operation apiece and nothing more.
+ */
+class Watchdog final
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Handle for a registered heartbeat. Destruction of the last copy
+     * deregisters the heartbeat, so a thread's loop keeps the handle in a
+     * local variable and the heartbeat can't outlive the loop it reports on.
+     */
+    class Heartbeat final
+    {
+    public:
+        class Impl;
+
+    private:
+        friend class Watchdog;
+
+        std::shared_ptr<Impl> pImpl;
+
+        explicit Heartbeat(Impl* impl);
+
+    public:
+        Heartbeat() =default;
+
+        /**
+         * Reports progress: one unit of work was completed or input arrived.
+         * Un-parks the heartbeat. A single relaxed atomic add.
+         * @exceptionsafety  Nothrow
+         * @threadsafety     Safe
+         */
+        void beat() const noexcept;
+
+        /**
+         * Marks the thread as blocked awaiting input, which isn't a stall:
+         * a parked heartbeat is never flagged. The next `beat()` un-parks.
+         * @exceptionsafety  Nothrow
+         * @threadsafety     Safe
+         */
+        void park() const noexcept;
+    };
+
+    /**
+     * Registers a heartbeat for the calling thread. Must be called on the
+     * thread whose loop the heartbeat reports on: the thread's identity is
+     * captured for the stack dump. Names needn't be unique; they only label
+     * log messages.
+     * @param[in] name   Name of the thread for log messages
+     * @return           Heartbeat for the calling thread
+     * @exceptionsafety  Strong guarantee
+     * @threadsafety     Safe
+     */
+    static Heartbeat registerThread(const std::string& name);
+
+    /**
+     * Constructs and starts the monitor thread. When a registered heartbeat
+     * neither beats nor parks for longer than the deadline, the monitor logs
+     * the stall, writes the stalled thread's stack to the standard error
+     * stream (via `SIGUSR2`, whose disposition this constructor takes over),
+     * and dumps the flight recorder for offline decoding with
+     * hycast_frdump(1). Recovery is also logged, so the log brackets the
+     * stall.
+     * @param[in] deadlineSecs  Seconds without progress before a thread is
+     *                          flagged as stalled
+     * @param[in] dumpPathname  Pathname of the flight-recorder dump-file or
+     *                          the empty string for no dump
+     * @throw InvalidArgument   `deadlineSecs == 0`
+     * @throw SystemError       Stack-dump signal-handler couldn't be
+     *                          installed
+     * @see FlightRecorder::dump()
+     */
+    explicit Watchdog(
+            const unsigned     deadlineSecs,
+            const std::string& dumpPathname = "");
+};
+
+} // namespace
+
+#endif /* MAIN_MISC_WATCHDOG_H_ */
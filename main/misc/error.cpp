@@ -10,51 +10,123 @@
  */
 
 #include "error.h"
+#include "Thread.h"
 
 namespace hycast {
 
+DeferredWhat::DeferredWhat(
+        const char* file,
+        const int   line,
+        std::string msg)
+    : file{file}
+    , line{line}
+    , threadNumber{Thread::getThreadNumber()}
+    , msg{std::move(msg)}
+    , formatted{}
+{}
+
+const char* DeferredWhat::get() const noexcept
+{
+    return get(msg.c_str());
+}
+
+const char* DeferredWhat::get(const char* raw) const noexcept
+{
+    if (formatted.empty()) {
+        try {
+            formatted = placeStamp(file, line, threadNumber) + " " + raw;
+        }
+        catch (const std::exception& e) {
+            return raw; // Formatting is best-effort
+        }
+    }
+    return formatted.c_str();
+}
+
+/*
+ * The standard base classes are constructed with the raw message: the
+ * place-stamped message is formatted only if and when `what()` is called,
+ * so catch sites that merely check the type don't pay for the formatting.
+ */
+
 InvalidArgument::InvalidArgument(
         const char*       file,
         const int         line,
         const std::string msg)
-    : std::invalid_argument{makeWhat(file, line, msg)}
+    : std::invalid_argument{msg}
+    , deferredWhat{file, line, msg}
 {}
 
+const char* InvalidArgument::what() const noexcept
+{
+    return deferredWhat.get();
+}
+
 LogicError::LogicError(
         const char*       file,
         const int         line,
         const std::string msg)
-    : std::logic_error{makeWhat(file, line, msg)}
+    : std::logic_error{msg}
+    , deferredWhat{file, line, msg}
 {}
 
+const char* LogicError::what() const noexcept
+{
+    return deferredWhat.get();
+}
+
 NotFoundError::NotFoundError(
         const char*       file,
         const int         line,
         const std::string msg)
-    : std::runtime_error{makeWhat(file, line, msg)}
+    : std::runtime_error{msg}
+    , deferredWhat{file, line, msg}
 {}
 
+const char* NotFoundError::what() const noexcept
+{
+    return deferredWhat.get();
+}
+
 OutOfRange::OutOfRange(
         const char*       file,
         const int         line,
         const std::string msg)
-    : std::out_of_range{makeWhat(file, line, msg)}
+    : std::out_of_range{msg}
+    , deferredWhat{file, line, msg}
 {}
 
+const char* OutOfRange::what() const noexcept
+{
+    return deferredWhat.get();
+}
+
 RuntimeError::RuntimeError(
         const char*       file,
         const int         line,
         const std::string msg)
-    : std::runtime_error{makeWhat(file, line, msg)}
+    : std::runtime_error{msg}
+    , deferredWhat{file, line, msg}
 {}
 
+const char* RuntimeError::what() const noexcept
+{
+    return deferredWhat.get();
+}
+
 SystemError::SystemError(
         const char*       file,
         const int         line,
         const std::string msg,
         const int         errnum)
-    : std::system_error{errnum, std::system_category(),
-            makeWhat(file, line, msg)}
+    : std::system_error{errnum, std::system_category(), msg}
+    , deferredWhat{file, line, msg}
 {}
 
+const char* SystemError::what() const noexcept
+{
+    // The base's `what()` appends the error description to the raw message
+    return deferredWhat.get(std::system_error::what());
+}
+
 } // namespace
@@ -20,63 +20,123 @@
 
 namespace hycast {
 
+/**
+ * Lazily-formatted `what()` message of the package's exceptions.
+ * Construction captures only the raw arguments -- file, line, message, and
+ * the throwing thread's number -- and the place-stamped message is formatted
+ * on the first call to `get()`. Catch sites that only check the type and
+ * continue -- common in connection-teardown paths during churn -- thus never
+ * pay for the formatting. Not thread-safe: an exception is expected to be
+ * examined by one thread at a time.
+ */
+class DeferredWhat final
+{
+    const char*         file;         ///< Pathname literal from `__FILE__`
+    int                 line;
+    long                threadNumber; ///< Thread number at construction
+    std::string         msg;
+    mutable std::string formatted;    ///< Empty until the first `get()`
+
+public:
+    DeferredWhat(
+            const char* file,
+            const int   line,
+            std::string msg);
+
+    /**
+     * Returns the place-stamped message, formatting it on the first call.
+     * @return  Place-stamped message. Raw message if formatting failed.
+     */
+    const char* get() const noexcept;
+
+    /**
+     * Same, but stamps `raw` instead of the stored message -- e.g., a
+     * `std::system_error`'s `what()`, which appends the error description.
+     * @param[in] raw  Message to be place-stamped
+     * @return         Place-stamped message. `raw` if formatting failed.
+     */
+    const char* get(const char* raw) const noexcept;
+};
+
 class InvalidArgument : public std::invalid_argument
 {
+    DeferredWhat deferredWhat;
+
 public:
     InvalidArgument(
             const char*       file,
             const int         line,
             const std::string msg);
 
+    const char* what() const noexcept;
+
 #define INVALID_ARGUMENT(msg) InvalidArgument(__FILE__, __LINE__, msg)
 };
 
 class LogicError : public std::logic_error
 {
+    DeferredWhat deferredWhat;
+
 public:
     LogicError(
             const char*       file,
             const int         line,
             const std::string msg);
 
+    const char* what() const noexcept;
+
 #define LOGIC_ERROR(msg) LogicError(__FILE__, __LINE__, msg)
 };
 
 class NotFoundError : public std::runtime_error
 {
+    DeferredWhat deferredWhat;
+
 public:
     NotFoundError(
             const char*       file,
             const int         line,
             const std::string msg);
 
+    const char* what() const noexcept;
+
 #define NOT_FOUND_ERROR(msg) NotFoundError(__FILE__, __LINE__, msg)
 };
 
 class OutOfRange : public std::out_of_range
 {
+    DeferredWhat deferredWhat;
+
 public:
     OutOfRange(
             const char*       file,
             const int         line,
             const std::string msg);
 
+    const char* what() const noexcept;
+
 #define OUT_OF_RANGE(msg) OutOfRange(__FILE__, __LINE__, msg)
 };
 
 class RuntimeError : public std::runtime_error
 {
+    DeferredWhat deferredWhat;
+
 public:
     RuntimeError(
             const char*       file,
             const int         line,
             const std::string msg);
 
+    const char* what() const noexcept;
+
 #define RUNTIME_ERROR(msg) RuntimeError(__FILE__, __LINE__, msg)
 };
 
 class SystemError : public std::system_error
 {
+    DeferredWhat deferredWhat;
+
 public:
     SystemError(
             const char*       file,
@@ -84,6 +144,8 @@ public:
             const std::string msg,
             const int         errnum = errno);
 
+    const char* what() const noexcept;
+
 #define SYSTEM_ERROR(msg, ...) SystemError(__FILE__, __LINE__, msg, ##__VA_ARGS__)
 };
 
@@ -91,6 +153,10 @@ void timeStamp();
 std::string placeStamp(
         const char* const file,
         const int         line);
+std::string placeStamp(
+        const char* const file,
+        const int         line,
+        const long        threadNumber);
 std::string placeStamp(
         const char* const file,
         const int         line,
@@ -118,6 +184,18 @@ inline bool log_enabled(const LogLevel level) {
     return level <= logLevel;
 }
 
+/**
+ * Sets whether or not logging is asynchronous. When asynchronous, messages
+ * are formatted into an in-memory queue on the calling thread and written by
+ * a dedicated writer thread, so a slow standard-error stream can't stall the
+ * caller; messages are dropped (and the drops counted) if the queue is full.
+ * Disabling blocks until the writer thread has drained the queue and reverts
+ * to synchronous logging. Idempotent.
+ * @param[in] enable  Whether or not logging should be asynchronous
+ * @threadsafety      Safe
+ */
+void log_setAsync(const bool enable);
+
 void log(
         const LogLevel        level,
         const std::exception& ex);
@@ -0,0 +1,129 @@
+/**
+ * This file implements hycast_frdump(1): the offline decoder for
+ * flight-recorder dump-files (cf. FlightRecorder.h). It merges every
+ * thread's ring into one timeline and prints one line per event, e.g.:
+ *
+ *         3.241058769    2  CHUNK_RECV_MCAST     prod=1052 chunk=17 size=40000
+ *
+ * Times are seconds relative to the earliest event in the dump. Events
+ * overwritten while the dump was being written may decode as garbage; an
+ * unknown event-type is printed numerically rather than rejected.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: frdump.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "FlightRecorder.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+typedef hycast::FlightRecorder::Event Event;
+
+/// A decoded event with its originating thread-ordinal
+struct ThreadEvent final
+{
+    Event    event;
+    uint64_t thread;
+};
+
+static const char* typeName(const uint16_t type)
+{
+    switch (type) {
+        case Event::CHUNK_RECV_MCAST:  return "CHUNK_RECV_MCAST";
+        case Event::CHUNK_RECV_P2P:    return "CHUNK_RECV_P2P";
+        case Event::CHUNK_STORED:      return "CHUNK_STORED";
+        case Event::PRODUCT_COMPLETE:  return "PRODUCT_COMPLETE";
+        case Event::REQUEST_SENT:      return "REQUEST_SENT";
+        case Event::REQUEST_SERVED:    return "REQUEST_SERVED";
+        case Event::PRODUCT_PROCESSED: return "PRODUCT_PROCESSED";
+        case Event::EVICTION:          return "EVICTION";
+        case Event::TRACE_ID:          return "TRACE_ID";
+        default:                       return nullptr;
+    }
+}
+
+int main(
+        const int   argc,
+        char* const argv[])
+{
+    if (argc != 2) {
+        ::fprintf(stderr, "Usage: %s <dump-file>\n", argv[0]);
+        return 1;
+    }
+    FILE* const file = ::fopen(argv[1], "rb");
+    if (file == nullptr) {
+        ::perror(argv[1]);
+        return 1;
+    }
+    struct {
+        char     magic[4];
+        uint32_t version;
+        uint32_t eventSize;
+        uint32_t pad;
+    } fileHeader;
+    if (::fread(&fileHeader, sizeof(fileHeader), 1, file) != 1 ||
+            ::memcmp(fileHeader.magic, "HYFR", 4)) {
+        ::fprintf(stderr, "%s isn't a flight-recorder dump-file\n", argv[1]);
+        return 1;
+    }
+    if (fileHeader.version != 1 || fileHeader.eventSize != sizeof(Event)) {
+        ::fprintf(stderr, "%s: unsupported format (version %u, "
+                "event-size %u)\n", argv[1], fileHeader.version,
+                fileHeader.eventSize);
+        return 1;
+    }
+    std::vector<ThreadEvent> events;
+    for (;;) {
+        struct {
+            uint64_t thread;
+            uint64_t numEvents;
+        } ringHeader;
+        if (::fread(&ringHeader, sizeof(ringHeader), 1, file) != 1)
+            break; // End of dump
+        for (uint64_t i = 0; i < ringHeader.numEvents; ++i) {
+            ThreadEvent threadEvent;
+            if (::fread(&threadEvent.event, sizeof(Event), 1, file) != 1) {
+                ::fprintf(stderr, "%s: truncated dump-file\n", argv[1]);
+                return 1;
+            }
+            threadEvent.thread = ringHeader.thread;
+            events.push_back(threadEvent);
+        }
+    }
+    ::fclose(file);
+    std::sort(events.begin(), events.end(),
+            [](const ThreadEvent& lhs, const ThreadEvent& rhs) {
+                return lhs.event.when < rhs.event.when;
+            });
+    const uint64_t epoch = events.empty() ? 0 : events.front().event.when;
+    for (const auto& threadEvent : events) {
+        const auto& event = threadEvent.event;
+        const auto  when = event.when - epoch;
+        const auto  name = typeName(event.type);
+        if (name) {
+            ::printf("%7llu.%09llu %4llu  %-17s prod=%u chunk=%u size=%u\n",
+                    static_cast<unsigned long long>(when/1000000000),
+                    static_cast<unsigned long long>(when%1000000000),
+                    static_cast<unsigned long long>(threadEvent.thread),
+                    name, event.prod, event.chunk, event.size);
+        }
+        else {
+            ::printf("%7llu.%09llu %4llu  type=%-12u prod=%u chunk=%u "
+                    "size=%u\n",
+                    static_cast<unsigned long long>(when/1000000000),
+                    static_cast<unsigned long long>(when%1000000000),
+                    static_cast<unsigned long long>(threadEvent.thread),
+                    event.type, event.prod, event.chunk, event.size);
+        }
+    }
+    return 0;
+}
@@ -10,15 +10,19 @@
  */
 
 #include "error.h"
+#include "MpmcQueue.h"
 #include "Thread.h"
 
+#include <atomic>
 #include <chrono>
 #include <cstdarg>
 #include <cstdio>
 #include <ctime>
 #include <iostream>
 #include <mutex>
+#include <string>
 #include <sys/time.h>
+#include <thread>
 
 namespace hycast {
 
@@ -37,11 +41,19 @@ void timeStamp()
 std::string placeStamp(
         const char* const file,
         const int         line)
+{
+    return placeStamp(file, line, Thread::getThreadNumber());
+}
+
+std::string placeStamp(
+        const char* const file,
+        const int         line,
+        const long        threadNumber)
 {
     char name[::strlen(file)+1];
     ::strcpy(name, file);
     return std::string(::basename(name)) + ":" + std::to_string(line) + "#" +
-            std::to_string(Thread::getThreadNumber());
+            std::to_string(threadNumber);
 }
 
 std::string placeStamp(
@@ -111,6 +123,128 @@ static const char*           logLevelNames[] = {"DEBUG", "INFO", "NOTE", "WARN",
         "ERROR"};
 static std::recursive_mutex  mutex;
 
+/**
+ * A log message captured on the logging thread. Timestamp formatting and the
+ * write to the standard error stream are deferred to the writer thread in
+ * asynchronous mode.
+ */
+struct LogEntry
+{
+    struct timeval when;
+    LogLevel       level;
+    std::string    msg;
+};
+
+/// Number of entries the asynchronous queue can hold
+static const size_t               asyncQueueSize = 1024;
+/// Queue drained by the writer thread. Non-null iff asynchronous mode is
+/// enabled. Once allocated, the queue is retained even when asynchronous mode
+/// is disabled because a logging thread might still hold a reference to it.
+static std::atomic<MpmcQueue<LogEntry>*> entryQueue{nullptr};
+static MpmcQueue<LogEntry>*       writerQueue = nullptr;
+/// Thread that drains `entryQueue`. A plain `std::thread` because the logging
+/// backend mustn't depend on the cancellation machinery, which itself logs.
+static std::thread                writerThread;
+/// Tells the writer thread to drain the queue and return
+static std::atomic<bool>          writerDone{false};
+/// Number of messages dropped because the queue was full
+static std::atomic<unsigned long> numDropped{0};
+
+/**
+ * Writes a single entry to the standard error stream. Doesn't flush.
+ * @param[in] entry  Entry to be written
+ */
+static void writeEntry(const LogEntry& entry)
+{
+    struct tm tm;
+    ::gmtime_r(&entry.when.tv_sec, &tm);
+    ::fprintf(stderr, "%04d%02d%02dT%02d%02d%02d.%06ldZ %s %s\n",
+            tm.tm_year+1900, tm.tm_mon+1, tm.tm_mday, tm.tm_hour, tm.tm_min,
+            tm.tm_sec, static_cast<long>(entry.when.tv_usec),
+            logLevelNames[entry.level], entry.msg.c_str());
+}
+
+/**
+ * Drains the queue of deferred entries. Flushes only when the queue goes
+ * idle, so a burst of messages is written with a single flush. Doesn't return
+ * until asynchronous mode is disabled. Intended to run on the writer thread.
+ * @param[in] queue  Queue of deferred entries
+ */
+static void runWriter(MpmcQueue<LogEntry>* const queue)
+{
+    LogEntry entry;
+    for (;;) {
+        if (queue->tryPop(entry)) {
+            writeEntry(entry);
+            continue;
+        }
+        ::fflush(stderr);
+        const auto dropped = numDropped.exchange(0);
+        if (dropped) {
+            ::fprintf(stderr, "%lu log message%s dropped\n", dropped,
+                    (dropped == 1) ? " was" : "s were");
+            ::fflush(stderr);
+        }
+        if (writerDone.load(std::memory_order_acquire))
+            break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    // Final drain: entries might have been pushed before the mode changed
+    while (queue->tryPop(entry))
+        writeEntry(entry);
+    ::fflush(stderr);
+}
+
+/**
+ * Submits a message for output. In asynchronous mode the message is queued
+ * for the writer thread -- or dropped if the queue is full, because loss is
+ * preferable to stalling the caller. Otherwise, the message is written and
+ * flushed on the calling thread.
+ * @param[in] level  Severity level of the message
+ * @param[in] msg    The message
+ */
+static void submit(
+        const LogLevel     level,
+        const std::string& msg)
+{
+    LogEntry entry;
+    ::gettimeofday(&entry.when, nullptr);
+    entry.level = level;
+    entry.msg = msg;
+    const auto queue = entryQueue.load(std::memory_order_acquire);
+    if (queue) {
+        if (!queue->tryPush(entry))
+            ++numDropped;
+    }
+    else {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+        writeEntry(entry);
+        ::fflush(stderr);
+    }
+}
+
+void log_setAsync(const bool enable)
+{
+    std::lock_guard<decltype(mutex)> lock{mutex};
+    const auto queue = entryQueue.load(std::memory_order_acquire);
+    if (enable) {
+        if (queue)
+            return;
+        if (writerQueue == nullptr)
+            writerQueue = new MpmcQueue<LogEntry>{asyncQueueSize};
+        writerDone.store(false, std::memory_order_release);
+        writerThread = std::thread{runWriter, writerQueue};
+        entryQueue.store(writerQueue, std::memory_order_release);
+    }
+    else {
+        if (queue == nullptr)
+            return;
+        entryQueue.store(nullptr, std::memory_order_release);
+        writerDone.store(true, std::memory_order_release);
+        writerThread.join();
+    }
+}
+
 void log(
         const LogLevel        level,
         const std::exception& ex)
@@ -121,10 +255,10 @@ void log(
     catch (const std::exception& inner) {
         log(level, inner);
     }
+    // The recursive mutex keeps a nested-exception chain contiguous in
+    // synchronous mode; the asynchronous queue preserves per-thread order
     std::lock_guard<decltype(mutex)> lock{mutex};
-    timeStamp();
-    ::fprintf(stderr, "%s %s\n", logLevelNames[level], ex.what());
-    ::fflush(stderr);
+    submit(level, ex.what());
 }
 
 void log(
@@ -134,13 +268,9 @@ void log(
         const char*    fmt,
         va_list        argList)
 {
-    std::lock_guard<decltype(mutex)> lock{mutex};
-    timeStamp();
-    ::fprintf(stderr, "%s %s ", logLevelNames[level],
-            placeStamp(file, line).c_str());
-    ::vfprintf(stderr, fmt, argList);
-    ::fputc('\n', stderr);
-    ::fflush(stderr);
+    char buf[512];
+    ::vsnprintf(buf, sizeof(buf), fmt, argList); // Truncates if necessary
+    submit(level, placeStamp(file, line) + " " + buf);
 }
 
 void log(
@@ -150,7 +280,6 @@ void log(
         const char*    fmt,
         ...)
 {
-    std::lock_guard<decltype(mutex)> lock{mutex};
     va_list argList;
     va_start(argList, fmt);
     log(level, file, line, fmt, argList);
@@ -179,11 +308,7 @@ void log(
         const int         line,
         const std::string msg)
 {
-    std::lock_guard<decltype(mutex)> lock{mutex};
-    timeStamp();
-    std::cerr << logLevelNames[level] << " " << placeStamp(file, line).c_str()
-            << " " << msg << std::endl;
-    std::cerr.flush();
+    submit(level, placeStamp(file, line) + " " + msg);
 }
 
 void log(
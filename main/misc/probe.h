@@ -0,0 +1,51 @@
+/**
+ * This file declares the USDT probe points of the product pipeline. The
+ * probes are dtrace-style static tracepoints: a tool such as bpftrace or
+ * perf attaches to them by provider and name -- stable across releases --
+ * instead of by mangled symbol, and an unattached probe costs one nop.
+ * Compiled out entirely unless `configure --enable-usdt`.
+ *
+ * The provider is "hycast". The probes at the pipeline's joints are:
+ *
+ *   chunk_recv_mcast(prodIndex, chunkIndex, size)  Chunk arrived via multicast
+ *   chunk_recv_p2p(prodIndex, chunkIndex, size)    Chunk arrived from a peer
+ *   chunk_stored(prodIndex, chunkIndex)            New chunk entered the store
+ *   product_complete(prodIndex, size)              Product became complete
+ *   notice_sent(prodIndex, chunkIndex)             Chunk-notice sent to a peer
+ *   request_sent(prodIndex, chunkIndex)            Chunk-request sent to a peer
+ *   request_served(prodIndex, chunkIndex, size)    Chunk sent to a peer
+ *   trace_id(prodIndex, traceId)                   Product's trace identifier
+ *                                                  became known at this node
+ *   peer_added()                                   Peer entered the active set
+ *   peer_removed()                                 Peer left the active set
+ *   eviction(prodIndex)                            Product left the store
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: probe.h
+ * @author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_MISC_PROBE_H_
+#define MAIN_MISC_PROBE_H_
+
+#include "config.h"
+
+#ifdef USE_USDT
+    #include <sys/sdt.h>
+    #define HYCAST_PROBE(name)                 DTRACE_PROBE(hycast, name)
+    #define HYCAST_PROBE1(name, a1)            DTRACE_PROBE1(hycast, name, a1)
+    #define HYCAST_PROBE2(name, a1, a2)        DTRACE_PROBE2(hycast, name, \
+                                                       a1, a2)
+    #define HYCAST_PROBE3(name, a1, a2, a3)    DTRACE_PROBE3(hycast, name, \
+                                                       a1, a2, a3)
+#else
+    #define HYCAST_PROBE(name)
+    #define HYCAST_PROBE1(name, a1)
+    #define HYCAST_PROBE2(name, a1, a2)
+    #define HYCAST_PROBE3(name, a1, a2, a3)
+#endif
+
+#endif /* MAIN_MISC_PROBE_H_ */
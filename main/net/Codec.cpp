@@ -14,55 +14,113 @@
 
 #include "Codec.h"
 #include "error.h"
+#include "Metrics.h"
 
 #include <climits>
 #include <cstring>
 #include <netinet/in.h>
 #include <stdexcept>
+#include <unordered_map>
+#include <vector>
 
 namespace hycast {
 
+/**
+ * Thread-local pool of serial buffers, bucketed by size. A codec's
+ * constructor draws a pre-touched buffer from the pool of its thread and its
+ * destructor returns it, so paths that create short-lived codecs -- peer
+ * connection setup, backlog message generation -- don't pay allocation and
+ * page-faulting for up to 64 KiB each time. Being thread-local, the pool
+ * needs no locking. A codec destroyed on a different thread than the one
+ * that constructed it merely returns its buffer to the destroying thread's
+ * pool.
+ */
+namespace {
+    struct BufPool final
+    {
+        /// Maximum number of pooled buffers per size
+        static const size_t                            maxBufs = 8;
+        std::unordered_map<size_t, std::vector<char*>> buckets;
+
+        ~BufPool() noexcept
+        {
+            for (auto& elt : buckets)
+                for (auto buf : elt.second)
+                    delete[] buf;
+        }
+
+        char* acquire(const size_t size)
+        {
+            static auto& hitCount = Metrics::getCounter(
+                    "hycast_codec_bufpool_acquires_total{result=\"hit\"}",
+                    "Serial-buffer acquisitions, by whether the thread's "
+                    "pool could satisfy them");
+            static auto& missCount = Metrics::getCounter(
+                    "hycast_codec_bufpool_acquires_total{result=\"miss\"}",
+                    "Serial-buffer acquisitions, by whether the thread's "
+                    "pool could satisfy them");
+            auto& bucket = buckets[size];
+            if (!bucket.empty()) {
+                const auto buf = bucket.back();
+                bucket.pop_back();
+                hitCount.add();
+                return buf;
+            }
+            missCount.add();
+            char* const buf = new char[size];
+            // Pre-touch so page-faults are paid here and not in the I/O path
+            for (size_t i = 0; i < size; i += 4096)
+                buf[i] = 0;
+            return buf;
+        }
+
+        void release(char* const buf, const size_t size) noexcept
+        {
+            try {
+                auto& bucket = buckets[size];
+                if (bucket.size() < maxBufs) {
+                    bucket.push_back(buf);
+                    return;
+                }
+            }
+            catch (const std::exception& e) {
+            }
+            delete[] buf;
+        }
+    };
+
+    thread_local BufPool bufPool{};
+}
+
+const size_t BufPool::maxBufs;
+
 Codec::Codec(const size_t maxSize)
     : serialBufSize{maxSize}
-    , serialBuf{new char[maxSize]}
+    , serialBuf{bufPool.acquire(maxSize)}
     , nextSerial{serialBuf}
     , serialBufBytes{0}
+    , numDma{0}
 {
-    dma.iov_len = 0;
-    dma.iov_base = nullptr;
+    for (int i = 0; i < maxDmaSegs; ++i) {
+        dma[i].iov_len = 0;
+        dma[i].iov_base = nullptr;
+    }
 }
 
 Codec::~Codec()
 {
-    delete[] serialBuf;
+    bufPool.release(serialBuf, serialBufSize);
 }
 
 void Codec::reset() noexcept
 {
     serialBufBytes = 0;
     nextSerial = serialBuf;
-    dma.iov_len = 0;
-    dma.iov_base = nullptr;
-}
-
-size_t Codec::getSerialSize(const size_t size) noexcept
-{
-    return size;
-}
-
-size_t Codec::getSerialSize(const bool* value)
-{
-    return sizeof(bool);
-}
-
-size_t Codec::getSerialSize(const uint16_t* value)
-{
-    return sizeof(uint16_t);
-}
-
-size_t Codec::getSerialSize(const uint32_t* value)
-{
-    return sizeof(uint32_t);
+    for (int i = 0; i < numDma; ++i) {
+        dma[i].iov_len = 0;
+        dma[i].iov_base = nullptr;
+    }
+    numDma = 0;
 }
 
 size_t Codec::getSerialSize(const std::string& string)
@@ -73,6 +131,13 @@ size_t Codec::getSerialSize(const std::string& string)
 Encoder::Encoder(
         const size_t maxSize)
     : Codec{maxSize}
+    , batching{false}
+    , batchBytes{0}
+    , byteThreshold{0}
+    , recThreshold{0}
+    , batchRecs{0}
+    , recSerial{serialBuf}
+    , batchIov{}
 {}
 
 Encoder::~Encoder()
@@ -113,7 +178,7 @@ size_t Encoder::encode(const uint16_t value)
     const size_t len = sizeof(uint16_t);
     if (serialBufBytes + len > serialBufSize)
         throw std::runtime_error("Buffer-write overflow");
-    *reinterpret_cast<uint16_t*>(nextSerial) = htons(value);
+    storeUnaligned(nextSerial, hton(value));
     serialBufBytes += len;
     nextSerial += len;
     return len;
@@ -124,7 +189,7 @@ size_t Encoder::encode(const uint32_t value)
     const size_t len = sizeof(uint32_t);
     if (serialBufBytes + len > serialBufSize)
         throw std::runtime_error("Buffer-write overflow");
-    *reinterpret_cast<uint32_t*>(nextSerial) = htonl(value);
+    storeUnaligned(nextSerial, hton(value));
     serialBufBytes += len;
     nextSerial += len;
     return len;
@@ -136,6 +201,24 @@ size_t Encoder::encode(const uint64_t value)
     return encode(ptr[0]) +  encode(ptr[1]);
 }
 
+size_t Encoder::encodeVarint(const uint64_t value)
+{
+    const size_t len = getVarintSize(value);
+    if (serialBufBytes + len > serialBufSize)
+        throw std::runtime_error("Buffer-write overflow");
+    uint64_t rest = value;
+    do {
+        uint8_t byte = rest & 0x7f;
+        rest >>= 7;
+        if (rest)
+            byte |= 0x80;
+        *reinterpret_cast<uint8_t*>(nextSerial) = byte;
+        nextSerial += sizeof(uint8_t);
+    } while (rest);
+    serialBufBytes += len;
+    return len;
+}
+
 void Decoder::decode(bool& value)
 {
     const size_t len = sizeof(bool);
@@ -161,7 +244,7 @@ void Decoder::decode(uint16_t& value)
     const size_t len = sizeof(uint16_t);
     if (serialBufBytes < len)
         throw std::runtime_error("Buffer-read overflow");
-    value = ntohs(*reinterpret_cast<uint16_t*>(nextSerial));
+    value = ntoh(loadUnaligned<uint16_t>(nextSerial));
     serialBufBytes -= len;
     nextSerial += len;
 }
@@ -171,7 +254,7 @@ void Decoder::decode(uint32_t& value)
     const size_t len = sizeof(uint32_t);
     if (serialBufBytes < len)
         throw std::runtime_error("Buffer-read overflow");
-    value = ntohl(*reinterpret_cast<uint32_t*>(nextSerial));
+    value = ntoh(loadUnaligned<uint32_t>(nextSerial));
     serialBufBytes -= len;
     nextSerial += len;
 }
@@ -183,6 +266,23 @@ void Decoder::decode(uint64_t& value)
     decode(ptr[1]);
 }
 
+uint64_t Decoder::decodeVarint()
+{
+    uint64_t value = 0;
+    for (unsigned shift = 0; ; shift += 7) {
+        if (shift > 63)
+            throw std::runtime_error("Malformed varint");
+        if (serialBufBytes < sizeof(uint8_t))
+            throw std::runtime_error("Buffer-read overflow");
+        const uint8_t byte = *reinterpret_cast<uint8_t*>(nextSerial);
+        nextSerial += sizeof(uint8_t);
+        serialBufBytes -= sizeof(uint8_t);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+            return value;
+    }
+}
+
 size_t Encoder::encode(const std::string& string)
 {
     const size_t strlen = string.size();
@@ -209,17 +309,46 @@ void Decoder::decode(std::string& string)
     nextSerial += strlen;
 }
 
+Decoder::StringRef Decoder::decodeStringRef()
+{
+    // Keep consistent with `decode(std::string&)`
+    StrLen strlen;
+    decode(strlen);
+    if (strlen > serialBufBytes)
+        throw std::runtime_error("Buffer-read overflow");
+    const StringRef view{nextSerial, strlen};
+    serialBufBytes -= strlen;
+    nextSerial += strlen;
+    return view;
+}
+
 size_t Encoder::encode(
         const void* const bytes,
         const size_t      len)
 {
-    if (dma.iov_len)
+    if (numDma >= maxDmaSegs)
         throw std::runtime_error("I/O vector overflow");
-    dma.iov_base = const_cast<void*>(bytes);
-    dma.iov_len = len;
+    dma[numDma].iov_base = const_cast<void*>(bytes);
+    dma[numDma].iov_len = len;
+    ++numDma;
     return len;
 }
 
+size_t Encoder::encode(
+        const struct iovec* iov,
+        const int           iovcnt)
+{
+    if (numDma + iovcnt > maxDmaSegs)
+        throw std::runtime_error("I/O vector overflow");
+    size_t nbytes = 0;
+    for (int i = 0; i < iovcnt; ++i) {
+        dma[numDma] = iov[i];
+        nbytes += iov[i].iov_len;
+        ++numDma;
+    }
+    return nbytes;
+}
+
 size_t Decoder::decode(
         void* const  bytes,
         const size_t len)
@@ -234,15 +363,78 @@ size_t Decoder::decode(
     return nbytes - iov[0].iov_len; // Minus bytes in serial buffer
 }
 
+void Encoder::setBatching(
+        const size_t maxBytes,
+        const int    maxRecords)
+{
+    if (nextSerial != serialBuf || numDma)
+        throw LOGIC_ERROR("Serial buffer is not empty");
+    batching = true;
+    byteThreshold = maxBytes;
+    recThreshold = maxRecords;
+}
+
+void Encoder::gatherRecord()
+{
+    struct iovec iov;
+    iov.iov_base = recSerial;
+    iov.iov_len = nextSerial - recSerial;
+    if (iov.iov_len) {
+        batchIov.push_back(iov);
+        batchBytes += iov.iov_len;
+    }
+    for (int i = 0; i < numDma; ++i) {
+        batchIov.push_back(dma[i]);
+        batchBytes += dma[i].iov_len;
+    }
+    numDma = 0;
+    recSerial = nextSerial;
+    ++batchRecs;
+}
+
+size_t Encoder::endRecord()
+{
+    if (!batching) {
+        size_t nbytes = nextSerial - serialBuf;
+        for (int i = 0; i < numDma; ++i)
+            nbytes += dma[i].iov_len;
+        flush();
+        return nbytes;
+    }
+    const size_t before = batchBytes;
+    gatherRecord();
+    const size_t nbytes = batchBytes - before;
+    if (batchBytes >= byteThreshold || batchRecs >= recThreshold)
+        flush();
+    return nbytes;
+}
+
 void Encoder::flush()
 {
     try {
-        struct iovec iov[2];
-        iov[0].iov_base = serialBuf;
-        iov[0].iov_len = nextSerial - serialBuf;
-        iov[1] = dma;
-        reset();
-        write(iov, 2);
+        if (batching) {
+            if (nextSerial != recSerial || numDma)
+                gatherRecord();
+            if (batchIov.empty())
+                return;
+            const int iovcnt = static_cast<int>(batchIov.size());
+            reset();
+            recSerial = serialBuf;
+            batchBytes = 0;
+            batchRecs = 0;
+            write(batchIov.data(), iovcnt);
+            batchIov.clear();
+        }
+        else {
+            struct iovec iov[1+maxDmaSegs];
+            iov[0].iov_base = serialBuf;
+            iov[0].iov_len = nextSerial - serialBuf;
+            const int iovcnt = 1 + numDma;
+            for (int i = 0; i < numDma; ++i)
+                iov[1+i] = dma[i];
+            reset();
+            write(iov, iovcnt);
+        }
     }
     catch (const std::exception& ex) {
         std::throw_with_nested(RUNTIME_ERROR("Couldn't flush I/O"));
@@ -287,8 +479,7 @@ bool Decoder::operator==(const Decoder& that) const noexcept
             (serialBuf == that.serialBuf) &&
             (nextSerial == that.nextSerial) &&
             (serialBufBytes == that.serialBufBytes) &&
-            (dma.iov_base == that.dma.iov_base) &&
-            (dma.iov_len == that.dma.iov_len)
+            (numDma == that.numDma)
         );
 }
 
@@ -359,8 +550,7 @@ bool MemDecoder::operator==(const MemDecoder& that) const noexcept
             (serialBuf == that.serialBuf) &&
             (nextSerial == that.nextSerial) &&
             (serialBufBytes == that.serialBufBytes) &&
-            (dma.iov_base == that.dma.iov_base) &&
-            (dma.iov_len == that.dma.iov_len) &&
+            (numDma == that.numDma) &&
             (memBuf == that.memBuf) &&
             (memRead == that.memRead)
         );
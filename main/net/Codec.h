@@ -16,8 +16,12 @@
 #include <climits>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <netinet/in.h>
+#include <stdexcept>
 #include <string>
 #include <sys/uio.h>
+#include <vector>
 
 namespace hycast {
 
@@ -29,19 +33,100 @@ class Codec
 protected:
     typedef uint16_t    StrLen;
     static const StrLen maxStrLen = UINT16_MAX;
+    /// Maximum number of byte-array segments per record
+    static const int    maxDmaSegs = 8;
 
     const size_t serialBufSize;  /// Serial buffer size in bytes
     char* const  serialBuf;      /// Serial buffer
     char*        nextSerial;     /// Next byte in buffer to access
     size_t       serialBufBytes; /// Number of bytes written to or remaining to
                                  /// be read from buffer
-    struct iovec dma;            /// Vector for byte-array direct-memory-access
+    struct iovec dma[maxDmaSegs]; /// Vectors for byte-array
+                                  /// direct-memory-access
+    int          numDma;         /// Number of byte-array segments
 
     void reset() noexcept;
 
+    /**
+     * Returns the serial size of a sequence of fixed-layout fields. Known at
+     * compile-time.
+     * @return Serial size of the fields in bytes
+     */
+    static constexpr size_t fieldsSize() noexcept
+    {
+        return 0;
+    }
+    template<typename First, typename... Rest>
+    static constexpr size_t fieldsSize(
+            const First&   first,
+            const Rest&... rest) noexcept
+    {
+        return sizeof(First) + fieldsSize(rest...);
+    }
+
+    /*
+     * Byte-order conversion and unaligned field access. The compiler
+     * builtins collapse to a single `bswap` instruction -- and to nothing on
+     * a big-endian target -- where the generic shifting behind
+     * `htons()`/`ntohl()` isn't always recognized, and a `::memcpy()` of a
+     * size known at compile-time compiles to a plain load or store, so
+     * accessing a serialized field costs one `mov` plus at most one `bswap`
+     * regardless of the field's alignment in the serial buffer. These are
+     * instantiated in every serialization of every message, so the
+     * difference is multiplied by the message rate.
+     */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    static constexpr uint16_t hton(const uint16_t value) noexcept {
+        return value; // Host order is network order
+    }
+    static constexpr uint32_t hton(const uint32_t value) noexcept {
+        return value;
+    }
+#else
+    static inline uint16_t hton(const uint16_t value) noexcept {
+        return __builtin_bswap16(value);
+    }
+    static inline uint32_t hton(const uint32_t value) noexcept {
+        return __builtin_bswap32(value);
+    }
+#endif
+    // Byte-swapping is an involution, so the conversions are identical
+    static inline uint16_t ntoh(const uint16_t value) noexcept {
+        return hton(value);
+    }
+    static inline uint32_t ntoh(const uint32_t value) noexcept {
+        return hton(value);
+    }
+
+    /**
+     * Loads a possibly-unaligned value from the serial buffer.
+     * @param[in] ptr  Where the value resides
+     * @return         The value
+     */
+    template<typename T>
+    static inline T loadUnaligned(const char* const ptr) noexcept {
+        T value;
+        ::memcpy(&value, ptr, sizeof(T));
+        return value;
+    }
+
+    /**
+     * Stores a value at a possibly-unaligned location in the serial buffer.
+     * @param[in] ptr    Where the value should reside
+     * @param[in] value  The value
+     */
+    template<typename T>
+    static inline void storeUnaligned(
+            char* const ptr,
+            const T     value) noexcept {
+        ::memcpy(ptr, &value, sizeof(T));
+    }
+
 public:
     /**
-     * Constructs.
+     * Constructs. The serial buffer is drawn from a thread-local pool of
+     * pre-touched buffers and returned to it on destruction, so construction
+     * is allocation-free in steady state.
      * @param[in] maxSize  Maximum size of serial buffer in bytes
      */
     explicit Codec(const size_t maxSize);
@@ -51,12 +136,46 @@ public:
      */
     virtual ~Codec() =0;
 
-    static size_t getSerialSize(const size_t size) noexcept;
-    static size_t getSerialSize(const bool* value);
-    static size_t getSerialSize(const uint8_t* value);
-    static size_t getSerialSize(const uint16_t* value);
-    static size_t getSerialSize(const uint32_t* value);
+    /*
+     * The scalar sizes are `constexpr` so message sizes that don't depend on
+     * the content -- which is all of them except strings -- fold to
+     * compile-time constants, enabling exact-size serial buffers.
+     */
+    static constexpr size_t getSerialSize(const size_t size) noexcept {
+        return size;
+    }
+    static constexpr size_t getSerialSize(const bool* value) noexcept {
+        return sizeof(bool);
+    }
+    static constexpr size_t getSerialSize(const uint8_t* value) noexcept {
+        return sizeof(uint8_t);
+    }
+    static constexpr size_t getSerialSize(const uint16_t* value) noexcept {
+        return sizeof(uint16_t);
+    }
+    static constexpr size_t getSerialSize(const uint32_t* value) noexcept {
+        return sizeof(uint32_t);
+    }
     static size_t getSerialSize(const std::string& string);
+
+    /// Maximum serial size, in bytes, of a varint-encoded integer. Intended
+    /// for sizing codec buffers.
+    static const size_t maxVarintSize = 10;
+
+    /**
+     * Returns the serial size of a varint-encoded integer. Unlike the
+     * fixed-width sizes, this depends on the value: one byte per 7 bits of
+     * magnitude.
+     * @param[in] value  Value to be encoded
+     * @return           Serial size of the value in bytes
+     */
+    static size_t getVarintSize(uint64_t value) noexcept
+    {
+        size_t nbytes = 1;
+        while (value >>= 7)
+            ++nbytes;
+        return nbytes;
+    }
 }; // `Codec`
 
 /**
@@ -64,6 +183,67 @@ public:
  */
 class Encoder : public Codec
 {
+    bool                      batching;      /// Whether records are batched
+    size_t                    batchBytes;    /// Bytes in accumulated records
+    size_t                    byteThreshold; /// Batch flush threshold in bytes
+    int                       recThreshold;  /// Batch flush threshold in
+                                             /// records
+    int                       batchRecs;     /// Number of complete records in
+                                             /// batch
+    char*                     recSerial;     /// Start of current record in
+                                             /// serial buffer
+    std::vector<struct iovec> batchIov;      /// Gather-vector of accumulated
+                                             /// records
+
+    /**
+     * Appends the serial bytes and byte-array segments of the current record
+     * to the batch gather-vector.
+     */
+    void gatherRecord();
+
+    /**
+     * Stores a field in the serial buffer in network byte-order. Doesn't check
+     * the bounds. Advances the location in the serial buffer.
+     * @param[in] value  Value to store
+     */
+    inline void put(const bool value) noexcept
+    {
+        *reinterpret_cast<uint8_t*>(nextSerial) = value;
+        nextSerial += sizeof(bool);
+    }
+    inline void put(const uint8_t value) noexcept
+    {
+        *reinterpret_cast<uint8_t*>(nextSerial) = value;
+        nextSerial += sizeof(uint8_t);
+    }
+    inline void put(const uint16_t value) noexcept
+    {
+        storeUnaligned(nextSerial, hton(value));
+        nextSerial += sizeof(uint16_t);
+    }
+    inline void put(const uint32_t value) noexcept
+    {
+        storeUnaligned(nextSerial, hton(value));
+        nextSerial += sizeof(uint32_t);
+    }
+    inline void put(const uint64_t value) noexcept
+    {
+        // Keep consistent with `encode(uint64_t)`
+        const uint32_t* ptr = reinterpret_cast<const uint32_t*>(&value);
+        put(ptr[0]);
+        put(ptr[1]);
+    }
+    inline void putFields() noexcept
+    {}
+    template<typename First, typename... Rest>
+    inline void putFields(
+            const First    first,
+            const Rest...  rest) noexcept
+    {
+        put(first);
+        putFields(rest...);
+    }
+
 protected:
     /**
      * Writes to the underlying I/O object.
@@ -121,6 +301,18 @@ public:
      */
     size_t encode(const uint64_t value);
 
+    /**
+     * Serializes an unsigned integer into the serial buffer as a varint: 7
+     * bits per byte, least-significant group first, the high bit of each
+     * byte indicating that another follows. A value below 128 serializes to
+     * a single byte, so the small indices and sizes of notice-class messages
+     * shrink substantially relative to their fixed-width encoding.
+     * @param[in] value  Value to serialize
+     * @return           Number of bytes written
+     * @throws std::runtime_error  Buffer-write overflow
+     */
+    size_t encodeVarint(const uint64_t value);
+
     /**
      * Serializes a string into the serial buffer.
      * @param[in] string  String to serialize
@@ -130,22 +322,79 @@ public:
     size_t encode(const std::string& string);
 
     /**
-     * Serializes a byte-array. May be called at most once between calls to
-     * write(). The array isn't serialized into the serial buffer. Instead, it's
-     * location and length are saved for a subsequent scatter-write. Therefore,
-     * the array must persist until the data is written.
+     * Serializes a byte-array. May be called at most `maxDmaSegs` times
+     * between calls to write(). The array isn't serialized into the serial
+     * buffer. Instead, it's location and length are saved for a subsequent
+     * scatter-write. Therefore, the array must persist until the data is
+     * written.
      * @param[in] bytes Array to serialize
      * @param[in] len   Size of array in bytes
      * @return Number of bytes written (same as `len`)
-     * @throws std::runtime_error  Already called
+     * @throws std::runtime_error  No segment available
      */
     size_t encode(
             const void*  bytes,
             const size_t len);
 
     /**
-     * Writes the serial buffer and any byte-array to the underlying I/O object.
-     * Clears the serial buffer.
+     * Serializes a sequence of fixed-layout fields into the serial buffer with
+     * a single bounds-check. Because the combined size is known at
+     * compile-time, the stores compile to straight-line code -- unlike the
+     * equivalent sequence of individual encode() calls. Intended for the
+     * fixed-layout headers of high-rate messages.
+     * @param[in] fields  Fields to serialize, in order
+     * @return            Number of bytes written
+     * @throws std::runtime_error  Buffer-write overflow
+     */
+    template<typename... Fields>
+    size_t encodeFields(const Fields... fields)
+    {
+        const size_t len = fieldsSize(fields...);
+        if (serialBufBytes + len > serialBufSize)
+            throw std::runtime_error("Buffer-write overflow");
+        putFields(fields...);
+        serialBufBytes += len;
+        return len;
+    }
+
+    /**
+     * Serializes a gather-vector of byte-arrays. The arrays aren't serialized
+     * into the serial buffer: their locations and lengths are saved for a
+     * subsequent scatter-write with no intermediate copy. Therefore, the
+     * arrays must persist until the data is written.
+     * @param[in] iov     Gather-vector of caller-owned arrays
+     * @param[in] iovcnt  Number of elements in gather-vector
+     * @return Number of bytes written (sum of the lengths)
+     * @throws std::runtime_error  Insufficient segments available
+     */
+    size_t encode(
+            const struct iovec* iov,
+            const int           iovcnt);
+
+    /**
+     * Enables batching mode. Complete records accumulate -- see `endRecord()`
+     * -- and are written to the underlying I/O object in a single vectored
+     * write when a threshold is met or `flush()` is called. Amortizes the
+     * per-write system call over many small records.
+     * @param[in] maxBytes    Flush when this many bytes have accumulated
+     * @param[in] maxRecords  Flush when this many records have accumulated
+     * @throws LogicError  Serial buffer is not empty
+     */
+    void setBatching(
+            const size_t maxBytes,
+            const int    maxRecords);
+
+    /**
+     * Marks the current record as complete. In batching mode, the record is
+     * added to the batch and the batch is automatically flushed if a
+     * threshold has been met; otherwise, this is equivalent to `flush()`.
+     * @return Number of bytes in the record
+     */
+    size_t endRecord();
+
+    /**
+     * Writes the serial buffer and any byte-array to the underlying I/O object
+     * -- including any batched records. Clears the serial buffer.
      */
     void flush();
 };
@@ -155,6 +404,49 @@ public:
  */
 class Decoder : public Codec
 {
+    /**
+     * Loads a field from the serial buffer in network byte-order. Doesn't
+     * check the bounds. Advances the location in the serial buffer.
+     * @param[out] value  Loaded value
+     */
+    inline void get(bool& value) noexcept
+    {
+        value = *reinterpret_cast<bool*>(nextSerial);
+        nextSerial += sizeof(bool);
+    }
+    inline void get(uint8_t& value) noexcept
+    {
+        value = *reinterpret_cast<uint8_t*>(nextSerial);
+        nextSerial += sizeof(uint8_t);
+    }
+    inline void get(uint16_t& value) noexcept
+    {
+        value = ntoh(loadUnaligned<uint16_t>(nextSerial));
+        nextSerial += sizeof(uint16_t);
+    }
+    inline void get(uint32_t& value) noexcept
+    {
+        value = ntoh(loadUnaligned<uint32_t>(nextSerial));
+        nextSerial += sizeof(uint32_t);
+    }
+    inline void get(uint64_t& value) noexcept
+    {
+        // Keep consistent with `decode(uint64_t&)`
+        uint32_t* ptr = reinterpret_cast<uint32_t*>(&value);
+        get(ptr[0]);
+        get(ptr[1]);
+    }
+    inline void getFields() noexcept
+    {}
+    template<typename First, typename... Rest>
+    inline void getFields(
+            First&    first,
+            Rest&...  rest) noexcept
+    {
+        get(first);
+        getFields(rest...);
+    }
+
 protected:
     /**
      * Reads from the underlying I/O object.
@@ -185,6 +477,23 @@ public:
      */
     virtual ~Decoder();
 
+    /**
+     * Returns a view of the pending record without consuming it. Available
+     * when the underlying I/O object holds the record in a user-space buffer
+     * (e.g., a batched UDP socket): the returned pointer then refers directly
+     * into that buffer and nothing is copied. The view is valid until the
+     * record is discarded and doesn't affect the serial buffer, so a caller
+     * that gets `nullptr` can proceed with `fill()` and `decode()` as usual.
+     * The default implementation returns `nullptr`.
+     * @param[in] nbytes  Minimum number of bytes the view must expose
+     * @retval nullptr    No view is available or the record is too small
+     * @return            Pointer to the first byte of the pending record
+     */
+    virtual const char* peek(const size_t nbytes)
+    {
+        return nullptr;
+    }
+
     /**
      * Reads additional bytes from the underlying I/O object into the serial
      * buffer. Calls are cumulative: each adds to the serial buffer.
@@ -225,11 +534,40 @@ public:
      */
     void decode(uint64_t& value);
 
+    /**
+     * Deserializes a varint-encoded unsigned integer from the serial buffer.
+     * Advances the location in the serial buffer. Inverse of
+     * `Encoder::encodeVarint()`.
+     * @return Deserialized value
+     * @throws std::runtime_error  Buffer-read overflow or malformed varint
+     */
+    uint64_t decodeVarint();
+
     /**
      * Deserializes a string from the serial buffer.
      */
     void decode(std::string& string);
 
+    /**
+     * Non-owning view of a string in the serial buffer. The characters are
+     * not NUL-terminated.
+     */
+    struct StringRef {
+        const char* data; ///< First character
+        size_t      len;  ///< Length in bytes
+    };
+
+    /**
+     * Deserializes a string from the serial buffer as a non-owning view --
+     * avoiding the temporary `std::string` of `decode(std::string&)`.
+     * Advances the location in the serial buffer. The view refers directly
+     * into the serial buffer and is valid only until the next `fill()`,
+     * `clear()`, or destruction of this instance.
+     * @return View of the string
+     * @throws std::runtime_error  Buffer-read overflow
+     */
+    StringRef decodeStringRef();
+
     /**
      * Deserializes a byte-array. May be called at most once between calls to
      * `read(const size_t nbytes)`. The array isn't read from the serial buffer.
@@ -243,6 +581,23 @@ public:
             void* const  bytes,
             const size_t len);
 
+    /**
+     * Deserializes a sequence of fixed-layout fields from the serial buffer
+     * with a single bounds-check and straight-line loads. Advances the
+     * location in the serial buffer. Inverse of `Encoder::encodeFields()`.
+     * @param[out] fields  Fields to deserialize, in order
+     * @throws std::runtime_error  Buffer-read overflow
+     */
+    template<typename... Fields>
+    void decodeFields(Fields&... fields)
+    {
+        const size_t len = fieldsSize(fields...);
+        if (serialBufBytes < len)
+            throw std::runtime_error("Buffer-read overflow");
+        getFields(fields...);
+        serialBufBytes -= len;
+    }
+
     /**
      * Returns the number of bytes yet to be read from the message.
      * @return Number of bytes yet to be read
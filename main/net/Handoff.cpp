@@ -0,0 +1,268 @@
+/**
+ * This file implements the mechanism for a warm process handoff. File
+ * descriptors are passed between processes over a Unix-domain socket via
+ * `SCM_RIGHTS` ancillary messages. `SOCK_SEQPACKET` is used so each labeled
+ * descriptor is one message: boundaries are preserved and a zero-byte read
+ * unambiguously means the sender closed the connection.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: Handoff.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "error.h"
+#include "Handoff.h"
+#include "Thread.h"
+
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace hycast {
+
+/// Maximum size of a descriptor's label in bytes
+static const size_t maxLabelLen = 255;
+
+/**
+ * Initializes a Unix-domain socket address.
+ * @param[out] sockAddr    Unix-domain socket address
+ * @param[in]  pathname    Pathname of the socket
+ * @throw InvalidArgument  Pathname is too long for a Unix-domain socket
+ */
+static void initSockAddr(
+        struct sockaddr_un& sockAddr,
+        const std::string&  pathname)
+{
+    if (pathname.size() >= sizeof(sockAddr.sun_path))
+        throw INVALID_ARGUMENT("Handoff-socket pathname \"" + pathname +
+                "\" is too long");
+    ::memset(&sockAddr, 0, sizeof(sockAddr));
+    sockAddr.sun_family = AF_UNIX;
+    ::strncpy(sockAddr.sun_path, pathname.data(),
+            sizeof(sockAddr.sun_path)-1);
+}
+
+/**
+ * Returns a Unix-domain `SOCK_SEQPACKET` socket.
+ * @return             Socket descriptor
+ * @throw SystemError  Socket couldn't be created
+ */
+static int createSocket()
+{
+    const int sd = ::socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (sd < 0)
+        throw SYSTEM_ERROR("Couldn't create Unix-domain socket");
+    return sd;
+}
+
+/******************************************************************************/
+
+class HandoffSender::Impl final
+{
+    const int sd;
+
+public:
+    /**
+     * Constructs. Connects to the handoff socket at the given pathname.
+     * @param[in] pathname     Pathname of the Unix-domain handoff socket
+     * @throw InvalidArgument  Pathname is too long for a Unix-domain socket
+     * @throw SystemError      Couldn't connect to receiver
+     */
+    explicit Impl(const std::string& pathname)
+        : sd{createSocket()}
+    {
+        try {
+            struct sockaddr_un sockAddr;
+            initSockAddr(sockAddr, pathname);
+            if (::connect(sd, reinterpret_cast<struct sockaddr*>(&sockAddr),
+                    sizeof(sockAddr)))
+                throw SYSTEM_ERROR("Couldn't connect to handoff socket \"" +
+                        pathname + "\"");
+        }
+        catch (const std::exception& e) {
+            (void)::close(sd);
+            throw;
+        }
+    }
+
+    /**
+     * Prevents copy and move construction and assignment.
+     */
+    Impl(const Impl& that) =delete;
+    Impl(const Impl&& that) =delete;
+    Impl& operator=(const Impl& rhs) =delete;
+    Impl& operator=(const Impl&& rhs) =delete;
+
+    ~Impl() noexcept
+    {
+        (void)::close(sd); // Tells the receiver the handoff is complete
+    }
+
+    /**
+     * Sends a labeled file descriptor. The label is the message payload; the
+     * descriptor rides in an `SCM_RIGHTS` ancillary message.
+     * @param[in] label        Identifies the descriptor to the receiver
+     * @param[in] fd           File descriptor to send
+     * @throw InvalidArgument  Label is empty or too long
+     * @throw SystemError      Couldn't send descriptor
+     */
+    void send(
+            const std::string& label,
+            const int          fd)
+    {
+        if (label.empty() || label.size() > maxLabelLen)
+            throw INVALID_ARGUMENT("Invalid handoff label \"" + label + "\"");
+        struct iovec iov;
+        iov.iov_base = const_cast<char*>(label.data());
+        iov.iov_len = label.size();
+        char cmsgBuf[CMSG_SPACE(sizeof(int))] = {};
+        struct msghdr msghdr = {};
+        msghdr.msg_iov = &iov;
+        msghdr.msg_iovlen = 1;
+        msghdr.msg_control = cmsgBuf;
+        msghdr.msg_controllen = sizeof(cmsgBuf);
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msghdr);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        ::memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+        if (::sendmsg(sd, &msghdr, 0) !=
+                static_cast<ssize_t>(label.size()))
+            throw SYSTEM_ERROR("Couldn't send descriptor " +
+                    std::to_string(fd) + " with label \"" + label + "\"");
+    }
+};
+
+HandoffSender::HandoffSender(const std::string& pathname)
+    : pImpl{new Impl(pathname)}
+{}
+
+void HandoffSender::send(
+        const std::string& label,
+        const int          fd) const
+{
+    pImpl->send(label, fd);
+}
+
+/******************************************************************************/
+
+class HandoffReceiver::Impl final
+{
+    const std::string pathname;
+    const int         sd;
+    /// Accepted connection from the sender or -1 if not yet accepted
+    int               peerSd;
+
+public:
+    /**
+     * Constructs. Creates the handoff socket at the given pathname and
+     * listens for the sender.
+     * @param[in] pathname     Pathname of the Unix-domain handoff socket
+     * @throw InvalidArgument  Pathname is too long for a Unix-domain socket
+     * @throw SystemError      Couldn't create handoff socket
+     */
+    explicit Impl(const std::string& pathname)
+        : pathname{pathname}
+        , sd{createSocket()}
+        , peerSd{-1}
+    {
+        try {
+            struct sockaddr_un sockAddr;
+            initSockAddr(sockAddr, pathname);
+            // Remove any stale socket-file from a previous handoff
+            (void)::unlink(pathname.data());
+            if (::bind(sd, reinterpret_cast<struct sockaddr*>(&sockAddr),
+                    sizeof(sockAddr)))
+                throw SYSTEM_ERROR("Couldn't bind handoff socket to \"" +
+                        pathname + "\"");
+            if (::listen(sd, 1))
+                throw SYSTEM_ERROR("Couldn't listen on handoff socket \"" +
+                        pathname + "\"");
+        }
+        catch (const std::exception& e) {
+            (void)::close(sd);
+            throw;
+        }
+    }
+
+    /**
+     * Prevents copy and move construction and assignment.
+     */
+    Impl(const Impl& that) =delete;
+    Impl(const Impl&& that) =delete;
+    Impl& operator=(const Impl& rhs) =delete;
+    Impl& operator=(const Impl&& rhs) =delete;
+
+    ~Impl() noexcept
+    {
+        if (peerSd >= 0)
+            (void)::close(peerSd);
+        (void)::close(sd);
+        (void)::unlink(pathname.data());
+    }
+
+    /**
+     * Receives the next labeled file descriptor. Accepts the sender's
+     * connection on the first call.
+     * @param[out] label    Label the sender attached to the descriptor
+     * @retval -1           Sender closed the connection; handoff is complete
+     * @return              Received file descriptor
+     * @throw SystemError   Couldn't receive descriptor
+     * @throw RuntimeError  Message arrived without a descriptor
+     */
+    int recv(std::string& label)
+    {
+        if (peerSd < 0) {
+            Canceler canceler{};
+            peerSd = ::accept(sd, nullptr, nullptr);
+            if (peerSd < 0)
+                throw SYSTEM_ERROR("Couldn't accept handoff connection on \""
+                        + pathname + "\"");
+        }
+        char          labelBuf[maxLabelLen];
+        struct iovec  iov;
+        iov.iov_base = labelBuf;
+        iov.iov_len = sizeof(labelBuf);
+        char          cmsgBuf[CMSG_SPACE(sizeof(int))];
+        struct msghdr msghdr = {};
+        msghdr.msg_iov = &iov;
+        msghdr.msg_iovlen = 1;
+        msghdr.msg_control = cmsgBuf;
+        msghdr.msg_controllen = sizeof(cmsgBuf);
+        ssize_t nbytes;
+        {
+            Canceler canceler{};
+            nbytes = ::recvmsg(peerSd, &msghdr, MSG_CMSG_CLOEXEC);
+        }
+        if (nbytes < 0)
+            throw SYSTEM_ERROR("Couldn't receive handoff message on \"" +
+                    pathname + "\"");
+        if (nbytes == 0)
+            return -1; // Sender closed the connection
+        const struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msghdr);
+        if (cmsg == nullptr || cmsg->cmsg_level != SOL_SOCKET ||
+                cmsg->cmsg_type != SCM_RIGHTS)
+            throw RUNTIME_ERROR("Handoff message on \"" + pathname +
+                    "\" arrived without a descriptor");
+        int fd;
+        ::memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+        label.assign(labelBuf, nbytes);
+        return fd;
+    }
+};
+
+HandoffReceiver::HandoffReceiver(const std::string& pathname)
+    : pImpl{new Impl(pathname)}
+{}
+
+int HandoffReceiver::recv(std::string& label) const
+{
+    return pImpl->recv(label);
+}
+
+} // namespace
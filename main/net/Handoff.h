@@ -0,0 +1,103 @@
+/**
+ * This file declares the mechanism for a warm process handoff. An old process
+ * passes its open file descriptors -- listening sockets, the multicast
+ * socket -- to a new process over a Unix-domain socket, so an upgrade keeps
+ * the kernel sockets (and the packets queued in them) instead of paying
+ * cold-start costs: no dropped multicast subscription, no peer reconnection,
+ * no backlog repair.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: Handoff.h
+ * @author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_NET_HANDOFF_H_
+#define MAIN_NET_HANDOFF_H_
+
+#include <memory>
+#include <string>
+
+namespace hycast {
+
+/**
+ * The sending side of a warm process handoff. The old process constructs one
+ * -- connecting to the new process's `HandoffReceiver` -- and sends each
+ * descriptor it wants to survive the upgrade together with a label that tells
+ * the new process what the descriptor is. Destruction closes the connection,
+ * which tells the new process that the handoff is complete.
+ */
+class HandoffSender final
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Constructs. Connects to the `HandoffReceiver` at the given pathname.
+     * @param[in] pathname     Pathname of the Unix-domain handoff socket
+     * @throw InvalidArgument  Pathname is too long for a Unix-domain socket
+     * @throw SystemError      Couldn't connect to receiver
+     */
+    explicit HandoffSender(const std::string& pathname);
+
+    /**
+     * Sends a file descriptor. The receiving process gets its own descriptor
+     * for the same open file description, so socket state -- bound addresses,
+     * multicast group memberships, queued packets, established associations --
+     * is preserved.
+     * @param[in] label        Identifies the descriptor to the receiver
+     *                         (e.g., "peerSrvr", "mcast.0"). Must not be
+     *                         empty. At most 255 bytes.
+     * @param[in] fd           File descriptor to send
+     * @throw InvalidArgument  Label is empty or too long
+     * @throw SystemError      Couldn't send descriptor
+     * @exceptionsafety        Strong guarantee
+     * @threadsafety           Compatible but not safe
+     */
+    void send(
+            const std::string& label,
+            const int          fd) const;
+};
+
+/**
+ * The receiving side of a warm process handoff. The new process constructs
+ * one before the old process exits, receives the labeled descriptors, and
+ * reconstructs its sockets from them.
+ */
+class HandoffReceiver final
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Constructs. Creates the Unix-domain handoff socket at the given
+     * pathname -- replacing any stale socket-file from a previous handoff --
+     * and listens for the `HandoffSender` of the old process.
+     * @param[in] pathname     Pathname of the Unix-domain handoff socket
+     * @throw InvalidArgument  Pathname is too long for a Unix-domain socket
+     * @throw SystemError      Couldn't create handoff socket
+     */
+    explicit HandoffReceiver(const std::string& pathname);
+
+    /**
+     * Receives the next file descriptor. Blocks until the old process sends
+     * one or completes the handoff by closing its `HandoffSender`. This is a
+     * cancellation point.
+     * @param[out] label    Label the sender attached to the descriptor
+     * @retval -1           Handoff is complete; `label` is unchanged
+     * @return              Received file descriptor. The caller owns it.
+     * @throw SystemError   Couldn't receive descriptor
+     * @throw RuntimeError  Message arrived without a descriptor
+     * @exceptionsafety     Strong guarantee
+     * @threadsafety        Compatible but not safe
+     */
+    int recv(std::string& label) const;
+};
+
+} // namespace
+
+#endif /* MAIN_NET_HANDOFF_H_ */
@@ -20,6 +20,9 @@
 #include "InetAddr.h"
 
 #include <arpa/inet.h>
+#include <chrono>
+#include <memory>
+#include <mutex>
 #include <net/if.h>
 #include <netdb.h>
 #include <set>
@@ -109,6 +112,29 @@ public:
      */
     virtual size_t hash() const noexcept =0;
 
+    /**
+     * Returns an identifier of this instance's subnet. Addresses with equal
+     * identifiers likely share a network path. The default implementation
+     * returns the hash code, so an unresolved hostname is its own group.
+     * @return          Identifier of this instance's subnet
+     * @exceptionsafety Nothrow
+     * @threadsafety    Safe
+     */
+    virtual size_t getSubnetId() const noexcept
+    {
+        return hash();
+    }
+
+    /**
+     * Resolves this instance so subsequent use doesn't hit the resolver. The
+     * default implementation does nothing: an IP-based address is its own
+     * resolution.
+     * @exceptionsafety Strong guarantee
+     * @threadsafety    Safe
+     */
+    virtual void resolve() const
+    {}
+
     /**
      * Indicates if this instance is considered equal to another.
      * @param[in] that  Other instance
@@ -179,6 +205,19 @@ public:
      */
     virtual std::string to_string() const =0;
 
+    /**
+     * Returns a new implementation holding this instance's address in the
+     * given family. An IP-based address is its own (and only) family member;
+     * a hostname may resolve in both families.
+     * @param[in] family  Address family: `AF_INET` or `AF_INET6`
+     * @retval nullptr    This instance has no address in the family
+     * @return            Corresponding new implementation. Caller assumes
+     *                    ownership.
+     * @exceptionsafety   Strong guarantee
+     * @threadsafety      Safe
+     */
+    virtual Impl* getImpl(const int family) const =0;
+
     /**
      * Returns a new socket.
      * @param[in] sockType  Type of socket as defined in <sys/socket.h>:
@@ -221,6 +260,21 @@ public:
             const int      sd,
             const unsigned limit) const =0;
 
+    /**
+     * Sets the Differentiated Services code-point on a socket for outgoing
+     * packets so the network can class the socket's traffic.
+     * @param[in] sd    Socket
+     * @param[in] dscp  Code-point in [0,63] (see RFC 2474). 0 is best-effort
+     *                  (the default).
+     * @throws std::invalid_argument  `dscp > 63`
+     * @throws std::system_error      `setsockopt()` failure
+     * @execptionsafety  Strong guarantee
+     * @threadsafety     Safe
+     */
+    virtual void setDscp(
+            const int      sd,
+            const unsigned dscp) const =0;
+
     /**
      * Sets whether or not a multicast packet written to a socket will be
      * read from the same socket. Such looping in enabled by default.
@@ -271,6 +325,16 @@ size_t InetAddr::hash() const noexcept
     return pImpl->hash();
 }
 
+void InetAddr::resolve() const
+{
+    pImpl->resolve();
+}
+
+size_t InetAddr::getSubnetId() const noexcept
+{
+    return pImpl->getSubnetId();
+}
+
 bool InetAddr::operator ==(const InetAddr& that) const noexcept
 {
     return *pImpl.get() == *that.pImpl.get();
@@ -306,6 +370,17 @@ std::string InetAddr::to_string() const
     return pImpl->to_string();
 }
 
+bool InetAddr::getInetAddr(
+        const int family,
+        InetAddr& inetAddr) const
+{
+    Impl* const impl = pImpl->getImpl(family);
+    if (impl == nullptr)
+        return false;
+    inetAddr = InetAddr{impl};
+    return true;
+}
+
 int InetAddr::getSocket(const int sockType) const
 {
     return pImpl->getSocket(sockType);
@@ -323,6 +398,13 @@ void InetAddr::setHopLimit(
     pImpl->setHopLimit(sd, limit);
 }
 
+void InetAddr::setDscp(
+        const int      sd,
+        const unsigned dscp) const
+{
+    pImpl->setDscp(sd, dscp);
+}
+
 void InetAddr::setMcastLoop(
         const int      sd,
         const bool     enable) const
@@ -344,7 +426,22 @@ IpAddr::~IpAddr() noexcept
 
 class Ipv4Addr final : public IpAddr
 {
-    in_addr_t ipAddr;
+    in_addr_t               ipAddr;
+    struct sockaddr_storage sockAddr; /// Preparsed socket address. Port is 0.
+
+    /**
+     * Initializes the preparsed socket address so that producing a complete
+     * socket address is a copy plus a port-number store.
+     * @exceptionsafety Nothrow
+     */
+    void initSockAddr() noexcept
+    {
+        ::memset(&sockAddr, 0, sizeof(sockAddr));
+        struct sockaddr_in* const addr =
+                reinterpret_cast<struct sockaddr_in*>(&sockAddr);
+        addr->sin_family = AF_INET;
+        addr->sin_addr.s_addr = ipAddr;
+    }
 
 public:
     /**
@@ -353,7 +450,9 @@ public:
      */
     explicit Ipv4Addr(const in_addr_t ipAddr) noexcept
         : ipAddr{ipAddr}
-    {};
+    {
+        initSockAddr();
+    };
 
     /**
      * Constructs from an IPv4 address.
@@ -362,7 +461,9 @@ public:
      */
     explicit Ipv4Addr(const struct in_addr& ipAddr) noexcept
         : ipAddr{ipAddr.s_addr}
-    {};
+    {
+        initSockAddr();
+    };
 
     ~Ipv4Addr() noexcept
     {}
@@ -383,12 +484,8 @@ public:
             const int         port,
             const int         sockType = 0) const noexcept
     {
-        ::memset(&storage, 0, sizeof(storage));
-        struct sockaddr_in* sockAddr =
-                reinterpret_cast<struct sockaddr_in*>(&storage);
-        sockAddr->sin_family = AF_INET;
-        sockAddr->sin_port = htons(port);
-        sockAddr->sin_addr.s_addr = ipAddr;
+        storage = sockAddr;
+        reinterpret_cast<struct sockaddr_in*>(&storage)->sin_port = htons(port);
     }
 
     /**
@@ -403,6 +500,17 @@ public:
         return h(ipAddr);
     }
 
+    /**
+     * Returns an identifier of this instance's subnet: the /24 prefix.
+     * @return          Identifier of this instance's subnet
+     * @exceptionsafety Nothrow
+     * @threadsafety    Safe
+     */
+    size_t getSubnetId() const noexcept
+    {
+        return ::ntohl(ipAddr) >> 8;
+    }
+
     bool operator==(const InetAddr::Impl& that) const noexcept
     {
         return that == *this;
@@ -489,6 +597,13 @@ public:
      * @exceptionsafety  Strong guarantee
      * @threadsafety     Safe
      */
+    InetAddr::Impl* getImpl(const int family) const
+    {
+        return (family == AF_INET)
+                ? new Ipv4Addr{ipAddr}
+                : nullptr;
+    }
+
     int getSocket(const int sockType) const
     {
         int sd = ::socket(AF_INET, sockType, 0);
@@ -546,6 +661,32 @@ public:
                     ", limit=" + std::to_string(value));
     }
 
+    /**
+     * Sets the Differentiated Services code-point on a socket for outgoing
+     * packets so the network can class the socket's traffic.
+     * @param[in] sd    Socket
+     * @param[in] dscp  Code-point in [0,63] (see RFC 2474). 0 is best-effort
+     *                  (the default).
+     * @throws std::invalid_argument  `dscp > 63`
+     * @throws std::system_error      `setsockopt()` failure
+     * @execptionsafety  Strong guarantee
+     * @threadsafety     Safe
+     */
+    void setDscp(
+            const int      sd,
+            const unsigned dscp) const
+    {
+        if (dscp > 63)
+            throw std::invalid_argument("Invalid DSCP: " +
+                    std::to_string(dscp));
+        const int value = dscp << 2; // Code-point occupies upper 6 bits
+        if (::setsockopt(sd, IPPROTO_IP, IP_TOS, &value, sizeof(value)))
+            throw std::system_error(errno, std::system_category(),
+                    std::string("Couldn't set DSCP for outgoing packets: "
+                    "sock=") + std::to_string(sd) + ", dscp=" +
+                    std::to_string(dscp));
+    }
+
     /**
      * Sets whether or not a multicast packet written to a socket will be
      * read from the same socket. Such looping in enabled by default.
@@ -573,7 +714,22 @@ public:
 
 class Ipv6Addr final : public IpAddr
 {
-    struct in6_addr ipAddr;
+    struct in6_addr         ipAddr;
+    struct sockaddr_storage sockAddr; /// Preparsed socket address. Port is 0.
+
+    /**
+     * Initializes the preparsed socket address so that producing a complete
+     * socket address is a copy plus a port-number store.
+     * @exceptionsafety Nothrow
+     */
+    void initSockAddr() noexcept
+    {
+        ::memset(&sockAddr, 0, sizeof(sockAddr));
+        struct sockaddr_in6* const addr =
+                reinterpret_cast<struct sockaddr_in6*>(&sockAddr);
+        addr->sin6_family = AF_INET6;
+        addr->sin6_addr = ipAddr;
+    }
 
     /**
      * Returns the index of the interface that corresponds to this Internet
@@ -645,6 +801,7 @@ public:
         : ipAddr{}
     {
         ::memcpy(&this->ipAddr, &ipAddr, sizeof(ipAddr));
+        initSockAddr();
     }
 
     /**
@@ -663,12 +820,9 @@ public:
             const int         port,
             const int         sockType = 0) const
     {
-        ::memset(&storage, 0, sizeof(storage));
-        struct sockaddr_in6* sockAddr =
-                reinterpret_cast<struct sockaddr_in6*>(&storage);
-        sockAddr->sin6_family = AF_INET6;
-        sockAddr->sin6_port = htons(port);
-        sockAddr->sin6_addr = ipAddr;
+        storage = sockAddr;
+        reinterpret_cast<struct sockaddr_in6*>(&storage)->sin6_port =
+                htons(port);
     }
 
     /**
@@ -688,6 +842,20 @@ public:
         return hash;
     }
 
+    /**
+     * Returns an identifier of this instance's subnet: a hash of the /64
+     * prefix.
+     * @return          Identifier of this instance's subnet
+     * @exceptionsafety Nothrow
+     * @threadsafety    Safe
+     */
+    size_t getSubnetId() const noexcept
+    {
+        uint64_t prefix;
+        ::memcpy(&prefix, ipAddr.s6_addr, sizeof(prefix));
+        return std::hash<uint64_t>()(prefix);
+    }
+
     bool operator==(const InetAddr::Impl& that) const noexcept
     {
         return that == *this;
@@ -778,6 +946,13 @@ public:
      * @exceptionsafety  Strong guarantee
      * @threadsafety     Safe
      */
+    InetAddr::Impl* getImpl(const int family) const
+    {
+        return (family == AF_INET6)
+                ? new Ipv6Addr{ipAddr}
+                : nullptr;
+    }
+
     int getSocket(const int sockType) const
     {
         int sd = ::socket(AF_INET6, sockType, 0);
@@ -835,6 +1010,33 @@ public:
                     ", limit=" + std::to_string(value));
     }
 
+    /**
+     * Sets the Differentiated Services code-point on a socket for outgoing
+     * packets so the network can class the socket's traffic.
+     * @param[in] sd    Socket
+     * @param[in] dscp  Code-point in [0,63] (see RFC 2474). 0 is best-effort
+     *                  (the default).
+     * @throws std::invalid_argument  `dscp > 63`
+     * @throws std::system_error      `setsockopt()` failure
+     * @execptionsafety  Strong guarantee
+     * @threadsafety     Safe
+     */
+    void setDscp(
+            const int      sd,
+            const unsigned dscp) const
+    {
+        if (dscp > 63)
+            throw std::invalid_argument("Invalid DSCP: " +
+                    std::to_string(dscp));
+        const int value = dscp << 2; // Code-point occupies upper 6 bits
+        if (::setsockopt(sd, IPPROTO_IPV6, IPV6_TCLASS, &value,
+                sizeof(value)))
+            throw std::system_error(errno, std::system_category(),
+                    std::string("Couldn't set DSCP for outgoing packets: "
+                    "sock=") + std::to_string(sd) + ", dscp=" +
+                    std::to_string(dscp));
+    }
+
     /**
      * Sets whether or not a multicast packet written to a socket will be
      * read from the same socket. Such looping in enabled by default.
@@ -862,7 +1064,21 @@ public:
 
 class InetNameAddr final : public InetAddr::Impl
 {
-    std::string name; /// Hostname
+    typedef std::mutex                Mutex;
+    typedef std::lock_guard<Mutex>    LockGuard;
+    typedef std::chrono::steady_clock Clock;
+
+    /// Lifetime of a cached resolution. After it expires, the next use
+    /// re-resolves -- so a peer whose address moved is found -- but a failed
+    /// re-resolution serves the stale address, so resolver trouble can't
+    /// break a name that resolved before.
+    static const unsigned resolutionTtlSecs = 3600;
+
+    std::string                     name;     /// Hostname
+    const size_t                    hashCode; /// Hash code of hostname
+    mutable Mutex                   mutex;    /// Guards the resolution cache
+    mutable std::shared_ptr<IpAddr> ipAddr;   /// Cached resolution of hostname
+    mutable Clock::time_point       resolvedTime; /// When `ipAddr` was cached
 
     /**
      * Adds Internet addresses to a set.
@@ -971,19 +1187,39 @@ class InetNameAddr final : public InetAddr::Impl
 
     /**
      * Returns the first IP-based Internet address associated with this
-     * instance's hostname.
-     * @retval NULL  No address found
-     * @return       First matching address
-     * @throws std::system_error `getaddrinfo()` failure
+     * instance's hostname. A successful resolution is cached for
+     * `resolutionTtlSecs` seconds, so steady use hits the resolver about
+     * once per lifetime rather than per connection; after the lifetime
+     * expires, a failed re-resolution serves the stale address.
+     * @retval empty pointer  No address found
+     * @return                First matching address
+     * @throws std::system_error `getaddrinfo()` failure and no resolution
+     *                           is cached
      * @exceptionsafety  Strong guarantee
      * @threadsafety     Safe
      */
-    IpAddr* getIpAddr() const
+    std::shared_ptr<IpAddr> getIpAddr() const
     {
-        IpAddr* ipAddr = getIpAddr(AF_INET);
-        return (ipAddr != nullptr)
-                ? ipAddr
-                : getIpAddr(AF_INET6);
+        LockGuard  lock{mutex};
+        const auto now = Clock::now();
+        if (ipAddr && now < resolvedTime +
+                std::chrono::seconds{resolutionTtlSecs})
+            return ipAddr;
+        try {
+            IpAddr* addr = getIpAddr(AF_INET);
+            if (addr == nullptr)
+                addr = getIpAddr(AF_INET6);
+            if (addr) {
+                ipAddr.reset(addr);
+                resolvedTime = now;
+            }
+        }
+        catch (const std::exception& e) {
+            if (!ipAddr)
+                throw;
+            // Serve the stale resolution
+        }
+        return ipAddr;
     }
 
 public:
@@ -993,8 +1229,27 @@ public:
      */
     explicit InetNameAddr(const std::string name = "")
         : name{name}
+        , hashCode{std::hash<std::string>()(name)}
+        , mutex{}
+        , ipAddr{}
+        , resolvedTime{}
     {}
 
+    /**
+     * Resolves the hostname and caches the result so subsequent use doesn't
+     * hit the resolver.
+     * @throws std::system_error  `getaddrinfo()` failure
+     * @throws RuntimeError       The hostname has no IP address
+     * @exceptionsafety  Strong guarantee
+     * @threadsafety     Safe
+     */
+    void resolve() const
+    {
+        if (!getIpAddr())
+            throw RUNTIME_ERROR("Hostname \"" + name +
+                    "\" has no IP address");
+    }
+
     /**
      * Returns the `struct sockaddr_storage` corresponding to this instance and
      * a port number.
@@ -1011,15 +1266,7 @@ public:
             const int         port,
             const int         sockType = 0) const
     {
-        IpAddr* const ipAddr = getIpAddr();
-        try {
-            ipAddr->setSockAddrStorage(storage, port, sockType);
-            delete ipAddr;
-        }
-        catch (...) {
-            delete ipAddr;
-            throw;
-        }
+        getIpAddr()->setSockAddrStorage(storage, port, sockType);
     }
 
     /**
@@ -1030,8 +1277,7 @@ public:
      */
     size_t hash() const noexcept
     {
-        std::hash<std::string> h;
-        return h(name);
+        return hashCode;
     }
 
     bool operator==(const InetAddr::Impl& that) const noexcept
@@ -1119,20 +1365,21 @@ public:
      * @exceptionsafety  Strong guarantee
      * @threadsafety     Safe
      */
-    int getSocket(const int sockType) const
+    InetAddr::Impl* getImpl(const int family) const
     {
-        IpAddr* const ipAddr = getIpAddr();
         try {
-            int sd = ipAddr->getSocket(sockType);
-            delete ipAddr;
-            return sd;
+            return getIpAddr(family);
         }
-        catch (...) {
-            delete ipAddr;
-            throw;
+        catch (const std::exception& e) {
+            return nullptr; // Resolution failure => no address in the family
         }
     }
 
+    int getSocket(const int sockType) const
+    {
+        return getIpAddr()->getSocket(sockType);
+    }
+
     /**
      * Sets the interface to use for outgoing datagrams.
      * @param[in] sd     Socket descriptor
@@ -1141,15 +1388,7 @@ public:
      */
     void setInterface(const int sd) const
     {
-        IpAddr* const ipAddr = getIpAddr();
-        try {
-            ipAddr->setInterface(sd);
-            delete ipAddr;
-        }
-        catch (...) {
-            delete ipAddr;
-            throw;
-        }
+        getIpAddr()->setInterface(sd);
     }
 
     /**
@@ -1173,15 +1412,25 @@ public:
             const int      sd,
             const unsigned limit) const
     {
-        IpAddr* const ipAddr = getIpAddr();
-        try {
-            ipAddr->setHopLimit(sd, limit);
-            delete ipAddr;
-        }
-        catch (...) {
-            delete ipAddr;
-            throw;
-        }
+        getIpAddr()->setHopLimit(sd, limit);
+    }
+
+    /**
+     * Sets the Differentiated Services code-point on a socket for outgoing
+     * packets so the network can class the socket's traffic.
+     * @param[in] sd    Socket
+     * @param[in] dscp  Code-point in [0,63] (see RFC 2474). 0 is best-effort
+     *                  (the default).
+     * @throws std::invalid_argument  `dscp > 63`
+     * @throws std::system_error      `setsockopt()` failure
+     * @execptionsafety  Strong guarantee
+     * @threadsafety     Safe
+     */
+    void setDscp(
+            const int      sd,
+            const unsigned dscp) const
+    {
+        getIpAddr()->setDscp(sd, dscp);
     }
 
     /**
@@ -1197,15 +1446,7 @@ public:
             const int  sd,
             const bool enable) const
     {
-        IpAddr* const ipAddr = getIpAddr();
-        try {
-            ipAddr->setMcastLoop(sd, enable);
-            delete ipAddr;
-        }
-        catch (...) {
-            delete ipAddr;
-            throw;
-        }
+        getIpAddr()->setMcastLoop(sd, enable);
     }
 };
 
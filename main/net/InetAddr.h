@@ -79,6 +79,31 @@ public:
      */
     size_t hash() const noexcept;
 
+    /**
+     * Returns an identifier of this instance's subnet: the /24 prefix of an
+     * IPv4 address or a hash of the /64 prefix of an IPv6 address. Addresses
+     * with equal identifiers likely share a network path, so spreading
+     * selections over distinct identifiers decorrelates path failures.
+     * @return          Identifier of this instance's subnet
+     * @exceptionsafety Nothrow
+     * @threadsafety    Safe
+     */
+    size_t getSubnetId() const noexcept;
+
+    /**
+     * Resolves this instance so subsequent use doesn't hit the resolver: a
+     * hostname is resolved and the result cached for the resolution's
+     * lifetime; an IP-based address is its own resolution, so this is a
+     * no-op. Intended for resolving candidates eagerly -- and on their own
+     * threads -- so a slow or dead resolver can't stall the code that later
+     * connects to them.
+     * @throws std::system_error  Resolution failure
+     * @throws RuntimeError       The hostname has no IP address
+     * @exceptionsafety  Strong guarantee
+     * @threadsafety     Safe
+     */
+    void resolve() const;
+
     /**
      * Indicates if this instance is considered equal to another.
      * @param[in] that  Other instance
@@ -128,6 +153,21 @@ public:
      */
     std::string to_string() const;
 
+    /**
+     * Returns this instance's address in the given family. An IP-based
+     * address is its own (and only) family member; a hostname may resolve in
+     * both families.
+     * @param[in]  family    Address family: `AF_INET` or `AF_INET6`
+     * @param[out] inetAddr  Corresponding address. Set iff `true` is returned.
+     * @retval `true`   This instance has an address in the family
+     * @retval `false`  It doesn't
+     * @exceptionsafety  Strong guarantee
+     * @threadsafety     Safe
+     */
+    bool getInetAddr(
+            const int family,
+            InetAddr& inetAddr) const;
+
     /**
      * Returns a new socket.
      * @param[in] sockType  Type of socket as defined in <sys/socket.h>:
@@ -171,6 +211,21 @@ public:
             const int      sd,
             const unsigned limit) const;
 
+    /**
+     * Sets the Differentiated Services code-point on a socket for outgoing
+     * packets so the network can class the socket's traffic.
+     * @param[in] sd    Socket
+     * @param[in] dscp  Code-point in [0,63] (see RFC 2474). 0 is best-effort
+     *                  (the default).
+     * @throws std::invalid_argument  `dscp > 63`
+     * @throws std::system_error      `setsockopt()` failure
+     * @execptionsafety  Strong guarantee
+     * @threadsafety     Safe
+     */
+    void setDscp(
+            const int      sd,
+            const unsigned dscp) const;
+
     /**
      * Sets whether or not a multicast packet written to a socket will be
      * read from the same socket. Such looping in enabled by default.
@@ -141,6 +141,15 @@ public:
         return inetAddr;
     }
 
+    /**
+     * Returns the associated port number.
+     * @return The associated port number
+     */
+    PortNumber getPort() const noexcept
+    {
+        return port;
+    }
+
     /**
      * Sets a socket address storage structure.
      * @param[in]     sd       Socket descriptor
@@ -150,8 +159,12 @@ public:
             const int                sd,
             struct sockaddr_storage& storage) const
     {
-        int sockType = getSockType(sd);
-        inetAddr.setSockAddrStorage(storage, port.get_host(), sockType);
+        /*
+         * The socket-type hint is ignored by every Internet address
+         * implementation, so the `getsockopt()` call is elided on this
+         * per-connection path.
+         */
+        inetAddr.setSockAddrStorage(storage, port.get_host());
     }
 
     operator bool()
@@ -241,8 +254,9 @@ public:
         int status;
         {
             Canceler canceler{};
+            // `sizeof(storage)` accommodates both families' socket addresses
             status = ::connect(sd, reinterpret_cast<struct sockaddr*>(&storage),
-                    sizeof(struct sockaddr));
+                    sizeof(storage));
         }
         if (status)
             throw SYSTEM_ERROR("connect() failure: sd=" +
@@ -297,6 +311,26 @@ public:
         return *this;
     }
 
+    /**
+     * Sets the Differentiated Services code-point on a socket for outgoing
+     * packets so the network can class the socket's traffic.
+     * @param[in] sd    Socket
+     * @param[in] dscp  Code-point in [0,63] (see RFC 2474). 0 is best-effort
+     *                  (the default).
+     * @returns  This instance
+     * @throws std::invalid_argument  `dscp > 63`
+     * @throws std::system_error      `setsockopt()` failure
+     * @execptionsafety  Strong guarantee
+     * @threadsafety     Safe
+     */
+    const Impl& setDscp(
+            const int      sd,
+            const unsigned dscp) const
+    {
+        inetAddr.setDscp(sd, dscp);
+        return *this;
+    }
+
     /**
      * Sets whether or not a multicast packet sent to a socket will also be
      * read from the same socket. Such looping in enabled by default.
@@ -411,6 +445,16 @@ InetAddr InetSockAddr::getInetAddr() const noexcept
     return pImpl->getInetAddr();
 }
 
+PortNumber InetSockAddr::getPort() const noexcept
+{
+    return pImpl->getPort();
+}
+
+void InetSockAddr::resolve() const
+{
+    pImpl->getInetAddr().resolve();
+}
+
 void InetSockAddr::setSockAddrStorage(
         const int                sd,
         struct sockaddr_storage& storage) const
@@ -464,6 +508,14 @@ const InetSockAddr& InetSockAddr::setHopLimit(
     return *this;
 }
 
+const InetSockAddr& InetSockAddr::setDscp(
+        const int      sd,
+        const unsigned dscp) const
+{
+    pImpl->setDscp(sd, dscp);
+    return *this;
+}
+
 const InetSockAddr& InetSockAddr::setMcastLoop(
         const int  sd,
         const bool enable) const
@@ -112,6 +112,23 @@ public:
      */
     InetAddr getInetAddr() const noexcept;
 
+    /**
+     * Returns the associated port number.
+     * @return The associated port number
+     */
+    PortNumber getPort() const noexcept;
+
+    /**
+     * Resolves the associated Internet address so subsequent use doesn't hit
+     * the resolver. A no-op for an IP-based address.
+     * @throws std::system_error  Resolution failure
+     * @throws RuntimeError       The hostname has no IP address
+     * @exceptionsafety  Strong guarantee
+     * @threadsafety     Safe
+     * @see InetAddr::resolve()
+     */
+    void resolve() const;
+
     /**
      * Sets a socket address storage structure.
      * @param[in]     sd       Socket descriptor
@@ -212,6 +229,22 @@ public:
             const int      sd,
             const unsigned limit) const;
 
+    /**
+     * Sets the Differentiated Services code-point on a socket for outgoing
+     * packets so the network can class the socket's traffic.
+     * @param[in] sd    Socket
+     * @param[in] dscp  Code-point in [0,63] (see RFC 2474). 0 is best-effort
+     *                  (the default).
+     * @returns  This instance
+     * @throws std::invalid_argument  `dscp > 63`
+     * @throws std::system_error      `setsockopt()` failure
+     * @execptionsafety  Strong guarantee
+     * @threadsafety     Safe
+     */
+    const InetSockAddr& setDscp(
+            const int      sd,
+            const unsigned dscp) const;
+
     /**
      * Sets whether or not a multicast packet sent to a socket will also be
      * read from the same socket. Such looping in enabled by default.
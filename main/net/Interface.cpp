@@ -15,6 +15,8 @@
 #include "error.h"
 #include "Interface.h"
 
+#include <map>
+#include <mutex>
 #include <sys/types.h>
 #include <ifaddrs.h>
 
@@ -66,6 +68,15 @@ public:
      * @exceptionsafety        Strong guarantee
      * @threadsafety           Probably compatible but not safe
      */
+    /**
+     * Returns the name of the interface.
+     * @return Name of the interface (e.g., "eth0")
+     */
+    const std::string& getName() const noexcept
+    {
+        return name;
+    }
+
     InetAddr getInetAddr(const int family) const
     {
         /*
@@ -112,6 +123,11 @@ Interface::Interface(const std::string& name)
     : pImpl{new Impl(name)}
 {}
 
+const std::string& Interface::getName() const
+{
+    return pImpl->getName();
+}
+
 Interface::Interface(const int number)
     : pImpl{new Impl(number)}
 {
@@ -123,4 +139,133 @@ InetAddr hycast::Interface::getInetAddr(const int family) const
     return pImpl->getInetAddr(family);
 }
 
+/******************************************************************************/
+
+class InterfaceSet::Impl final
+{
+    /// An interface and its number of active acquisitions
+    struct Entry
+    {
+        Interface iface;
+        unsigned  numActive;
+
+        explicit Entry(const Interface& iface)
+            : iface{iface}
+            , numActive{0}
+        {}
+    };
+
+    std::mutex                 mutex;
+    std::vector<Entry>         entries;
+    /// Acquired addresses and the index of their entry
+    std::map<InetAddr, size_t> addrToEntry;
+    /// Index of next entry for the round-robin policy
+    size_t                     nextIndex;
+    const Policy               policy;
+
+public:
+    /**
+     * Constructs.
+     * @param[in] ifaces       Interfaces over which to stripe
+     * @param[in] policy       Policy by which a source interface is picked
+     * @throw InvalidArgument  `ifaces` is empty
+     */
+    Impl(   const std::vector<Interface>& ifaces,
+            const Policy                  policy)
+        : mutex{}
+        , entries{}
+        , addrToEntry{}
+        , nextIndex{0}
+        , policy{policy}
+    {
+        if (ifaces.empty())
+            throw INVALID_ARGUMENT("Empty set of interfaces");
+        entries.reserve(ifaces.size());
+        for (auto& iface : ifaces)
+            entries.emplace_back(iface);
+    }
+
+    /**
+     * Prevents copy and move construction and assignment.
+     */
+    Impl(const Impl& that) =delete;
+    Impl(const Impl&& that) =delete;
+    Impl& operator=(const Impl& rhs) =delete;
+    Impl& operator=(const Impl&& rhs) =delete;
+
+    size_t size()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return entries.size();
+    }
+
+    /**
+     * Picks a source interface by policy and returns its Internet address.
+     * @param[in] family       Address family. One of `AF_INET` or `AF_INET6`.
+     * @return                 Internet address of picked interface
+     * @throw InvalidArgument  `family` is invalid
+     * @throw LogicError       An interface has no address in the family
+     * @exceptionsafety        Strong guarantee
+     * @threadsafety           Safe
+     */
+    InetAddr acquire(const int family)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        size_t index = nextIndex % entries.size();
+        if (policy == Policy::LEAST_USED) {
+            // Earlier entries win ties so the scan is deterministic
+            for (size_t i = 0; i < entries.size(); ++i)
+                if (entries[i].numActive < entries[index].numActive)
+                    index = i;
+        }
+        auto addr = entries[index].iface.getInetAddr(family);
+        ++entries[index].numActive;
+        addrToEntry[addr] = index;
+        nextIndex = index + 1;
+        return addr;
+    }
+
+    /**
+     * Releases a previously-acquired source address. Does nothing if the
+     * address wasn't acquired from this instance.
+     * @param[in] srcAddr  Address returned by `acquire()`
+     */
+    void release(const InetAddr& srcAddr)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto iter = addrToEntry.find(srcAddr);
+        if (iter != addrToEntry.end()) {
+            auto& entry = entries[iter->second];
+            if (entry.numActive > 0)
+                --entry.numActive;
+        }
+    }
+};
+
+InterfaceSet::InterfaceSet(
+        const std::vector<Interface>& ifaces,
+        const Policy                  policy)
+    : pImpl{new Impl(ifaces, policy)}
+{}
+
+InterfaceSet::operator bool() const noexcept
+{
+    return pImpl.operator bool();
+}
+
+size_t InterfaceSet::size() const
+{
+    return pImpl->size();
+}
+
+InetAddr InterfaceSet::acquire(const int family)
+{
+    return pImpl->acquire(family);
+}
+
+void InterfaceSet::release(const InetAddr& srcAddr)
+{
+    pImpl->release(srcAddr);
+}
+
 } // namespace
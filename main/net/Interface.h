@@ -19,6 +19,7 @@
 #include <memory>
 #include <string>
 #include <sys/socket.h>
+#include <vector>
 
 namespace hycast {
 
@@ -45,6 +46,12 @@ public:
      */
     Interface(const int index);
 
+    /**
+     * Returns the name of the interface.
+     * @return Name of the interface (e.g., "eth0")
+     */
+    const std::string& getName() const;
+
     /**
      * Returns an Internet address of the interface.
      * @param[in] family       Address family. One of `AF_INET` or `AF_INET6`.
@@ -59,6 +66,84 @@ public:
     InetAddr getInetAddr(const int family) const;
 };
 
+/******************************************************************************/
+
+/**
+ * A set of network interfaces over which outgoing connections are striped.
+ * Each acquisition picks a source interface by policy so that, e.g., peer
+ * associations spread across several NICs instead of all riding the one the
+ * routing table prefers. Thread-safe.
+ */
+class InterfaceSet final
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Policy by which a source interface is picked.
+     */
+    enum class Policy {
+        ROUND_ROBIN, ///< Interfaces are used in rotation
+        LEAST_USED   ///< The interface with the fewest active acquisitions
+    };
+
+    /**
+     * Default constructs. The resulting instance is empty: `operator bool()`
+     * will return `false`.
+     */
+    InterfaceSet() =default;
+
+    /**
+     * Constructs.
+     * @param[in] ifaces       Interfaces over which to stripe
+     * @param[in] policy       Policy by which a source interface is picked.
+     *                         The default is `Policy::LEAST_USED` so a
+     *                         long-lived association (e.g., one serving
+     *                         backlog) doesn't pin new connections to its
+     *                         saturated port.
+     * @throw InvalidArgument  `ifaces` is empty
+     */
+    explicit InterfaceSet(
+            const std::vector<Interface>& ifaces,
+            const Policy                  policy = Policy::LEAST_USED);
+
+    /**
+     * Indicates if this instance is non-empty.
+     * @retval `true`   This instance has interfaces
+     * @retval `false`  This instance was default constructed
+     */
+    operator bool() const noexcept;
+
+    /**
+     * Returns the number of interfaces.
+     * @return Number of interfaces
+     */
+    size_t size() const;
+
+    /**
+     * Picks a source interface by policy and returns its Internet address.
+     * The interface is counted as in-use until the address is released.
+     * @param[in] family       Address family. One of `AF_INET` or `AF_INET6`.
+     * @return                 Internet address of picked interface
+     * @throw InvalidArgument  `family` is invalid
+     * @throw LogicError       An interface has no address in the family
+     * @exceptionsafety        Strong guarantee
+     * @threadsafety           Safe
+     * @see `release()`
+     */
+    InetAddr acquire(const int family);
+
+    /**
+     * Releases a previously-acquired source address. Does nothing if the
+     * address wasn't acquired from this instance.
+     * @param[in] srcAddr  Address returned by `acquire()`
+     * @exceptionsafety    Strong guarantee
+     * @threadsafety       Safe
+     */
+    void release(const InetAddr& srcAddr);
+};
+
 } // namespace
 
 #endif /* MAIN_NET_INTERFACE_H_ */
@@ -0,0 +1,441 @@
+/**
+ * This file implements a handle class for an established message-oriented
+ * socket whose underlying transport is either an SCTP association or a TCP
+ * connection with record framing.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: MsgSock.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "error.h"
+#include "MsgSock.h"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+namespace hycast {
+
+class MsgSock::Impl
+{
+public:
+    virtual ~Impl() noexcept
+    {}
+
+    virtual InetSockAddr getRemoteAddr() const =0;
+
+    virtual int getSock() const noexcept =0;
+
+    virtual void enableZeroCopy() const =0;
+
+    virtual void enableAdaptiveSndBuf(const int max) const =0;
+
+    virtual SctpSock::Status getStatus() const =0;
+
+    virtual void send(
+            const unsigned streamId,
+            const void*    msg,
+            const size_t   len,
+            const unsigned timetolive) const =0;
+
+    virtual void sendv(
+            const unsigned streamId,
+            struct iovec*  iovec,
+            const int      iovcnt,
+            const unsigned timetolive) const =0;
+
+    virtual unsigned getStreamId() const =0;
+
+    virtual uint32_t getSize() const =0;
+
+    virtual void recv(
+            void*        msg,
+            const size_t len,
+            const int    flags) const =0;
+
+    virtual size_t recvv(
+            const struct iovec* iovec,
+            const int           iovcnt,
+            const int           flags) const =0;
+
+    /**
+     * Returns the underlying TCP socket or the null pointer if the transport
+     * isn't TCP.
+     * @return Underlying TCP socket or the null pointer
+     */
+    virtual const TcpSock* getTcpSock() const noexcept
+    {
+        return nullptr;
+    }
+
+    /**
+     * Forwards the payload of the current message to another socket
+     * implementation if the kernel can move the bytes directly between the
+     * two transports. The default implementation indicates that it can't.
+     * @param[in] egress    Implementation to forward the payload to
+     * @param[in] streamId  Logical stream number on the egress socket
+     * @retval true   Payload was forwarded and the message consumed
+     * @retval false  The transports have no kernel path; the message is
+     *                untouched
+     */
+    virtual bool forward(
+            const Impl&    egress,
+            const unsigned streamId) const
+    {
+        return false;
+    }
+
+    virtual bool hasMessage() const =0;
+
+    virtual void discard() const =0;
+
+    virtual std::string to_string() const =0;
+};
+
+/**
+ * Message-oriented socket whose transport is an SCTP association.
+ */
+class SctpMsgSock final : public MsgSock::Impl
+{
+    SctpSock sock;
+
+public:
+    explicit SctpMsgSock(const SctpSock& sock)
+        : sock{sock}
+    {}
+
+    InetSockAddr getRemoteAddr() const
+    {
+        return sock.getRemoteAddr();
+    }
+
+    int getSock() const noexcept
+    {
+        return sock.getSock();
+    }
+
+    void enableZeroCopy() const
+    {
+        sock.enableZeroCopy();
+    }
+
+    void enableAdaptiveSndBuf(const int max) const
+    {
+        sock.enableAdaptiveSndBuf(max);
+    }
+
+    SctpSock::Status getStatus() const
+    {
+        return sock.getStatus();
+    }
+
+    void send(
+            const unsigned streamId,
+            const void*    msg,
+            const size_t   len,
+            const unsigned timetolive) const
+    {
+        sock.send(streamId, msg, len, timetolive);
+    }
+
+    void sendv(
+            const unsigned streamId,
+            struct iovec*  iovec,
+            const int      iovcnt,
+            const unsigned timetolive) const
+    {
+        sock.sendv(streamId, iovec, iovcnt, timetolive);
+    }
+
+    unsigned getStreamId() const
+    {
+        return sock.getStreamId();
+    }
+
+    uint32_t getSize() const
+    {
+        return sock.getSize();
+    }
+
+    void recv(
+            void*        msg,
+            const size_t len,
+            const int    flags) const
+    {
+        sock.recv(msg, len, flags);
+    }
+
+    size_t recvv(
+            const struct iovec* iovec,
+            const int           iovcnt,
+            const int           flags) const
+    {
+        return sock.recvv(iovec, iovcnt, flags);
+    }
+
+    bool hasMessage() const
+    {
+        return sock.hasMessage();
+    }
+
+    void discard() const
+    {
+        sock.discard();
+    }
+
+    std::string to_string() const
+    {
+        return sock.to_string();
+    }
+};
+
+/**
+ * Message-oriented socket whose transport is a TCP connection with record
+ * framing.
+ */
+class TcpMsgSock final : public MsgSock::Impl
+{
+    TcpSock sock;
+
+public:
+    explicit TcpMsgSock(const TcpSock& sock)
+        : sock{sock}
+    {}
+
+    InetSockAddr getRemoteAddr() const
+    {
+        return sock.getRemoteAddr();
+    }
+
+    int getSock() const noexcept
+    {
+        return sock.getSock();
+    }
+
+    void enableZeroCopy() const
+    {
+        LOG_WARN("Zero-copy transmission isn't supported on a TCP "
+                "message-socket; sends will copy as usual");
+    }
+
+    void enableAdaptiveSndBuf(const int max) const
+    {
+        LOG_NOTE("A TCP message-socket's send buffer is autotuned by the "
+                "kernel; adaptive sizing isn't needed");
+    }
+
+    /**
+     * Returns a snapshot of the kernel's transport metrics for the TCP
+     * connection -- the `TCP_INFO` fields that correspond to what
+     * `SCTP_STATUS` reports for an association.
+     * @return             Transport metrics of the connection
+     * @throw SystemError  Metrics couldn't be obtained
+     */
+    SctpSock::Status getStatus() const
+    {
+        struct tcp_info info;
+        socklen_t       len = sizeof(info);
+        if (::getsockopt(sock.getSock(), IPPROTO_TCP, TCP_INFO, &info, &len))
+            throw SYSTEM_ERROR("getsockopt() failure: Couldn't get TCP "
+                    "status: sock=" + std::to_string(sock.getSock()));
+        SctpSock::Status status;
+        status.srttMs = info.tcpi_rtt / 1000; // `tcpi_rtt` is in microseconds
+        status.cwndBytes = info.tcpi_snd_cwnd * info.tcpi_snd_mss;
+        status.unackedData = info.tcpi_unacked;
+        status.pendingData = 0; // TCP doesn't report expected data
+        return status;
+    }
+
+    // TCP is fully reliable, so the partial-reliability lifetime is ignored
+    void send(
+            const unsigned streamId,
+            const void*    msg,
+            const size_t   len,
+            const unsigned timetolive) const
+    {
+        sock.send(streamId, msg, len);
+    }
+
+    void sendv(
+            const unsigned streamId,
+            struct iovec*  iovec,
+            const int      iovcnt,
+            const unsigned timetolive) const
+    {
+        sock.sendv(streamId, iovec, iovcnt);
+    }
+
+    unsigned getStreamId() const
+    {
+        return sock.getStreamId();
+    }
+
+    uint32_t getSize() const
+    {
+        return sock.getSize();
+    }
+
+    void recv(
+            void*        msg,
+            const size_t len,
+            const int    flags) const
+    {
+        sock.recv(msg, len, flags);
+    }
+
+    size_t recvv(
+            const struct iovec* iovec,
+            const int           iovcnt,
+            const int           flags) const
+    {
+        return sock.recvv(iovec, iovcnt, flags);
+    }
+
+    const TcpSock* getTcpSock() const noexcept
+    {
+        return &sock;
+    }
+
+    bool forward(
+            const Impl&    egress,
+            const unsigned streamId) const
+    {
+        const TcpSock* const egressSock = egress.getTcpSock();
+        if (egressSock == nullptr)
+            return false; // No kernel path to a non-TCP egress
+        sock.forward(*egressSock, streamId);
+        return true;
+    }
+
+    bool hasMessage() const
+    {
+        return sock.hasMessage();
+    }
+
+    void discard() const
+    {
+        sock.discard();
+    }
+
+    std::string to_string() const
+    {
+        return sock.to_string();
+    }
+};
+
+/******************************************************************************/
+
+MsgSock::MsgSock()
+    : pImpl{}
+{}
+
+MsgSock::MsgSock(const SctpSock& sock)
+    : pImpl{new SctpMsgSock(sock)}
+{}
+
+MsgSock::MsgSock(const TcpSock& sock)
+    : pImpl{new TcpMsgSock(sock)}
+{}
+
+InetSockAddr MsgSock::getRemoteAddr() const
+{
+    return pImpl ? pImpl->getRemoteAddr() : InetSockAddr{};
+}
+
+int MsgSock::getSock() const noexcept
+{
+    return pImpl ? pImpl->getSock() : -1;
+}
+
+void MsgSock::enableZeroCopy() const
+{
+    pImpl->enableZeroCopy();
+}
+
+void MsgSock::enableAdaptiveSndBuf(const int max) const
+{
+    pImpl->enableAdaptiveSndBuf(max);
+}
+
+SctpSock::Status MsgSock::getStatus() const
+{
+    return pImpl->getStatus();
+}
+
+void MsgSock::send(
+        const unsigned streamId,
+        const void*    msg,
+        const size_t   len,
+        const unsigned timetolive) const
+{
+    pImpl->send(streamId, msg, len, timetolive);
+}
+
+void MsgSock::sendv(
+        const unsigned streamId,
+        struct iovec*  iovec,
+        const int      iovcnt,
+        const unsigned timetolive) const
+{
+    pImpl->sendv(streamId, iovec, iovcnt, timetolive);
+}
+
+unsigned MsgSock::getStreamId() const
+{
+    return pImpl->getStreamId();
+}
+
+uint32_t MsgSock::getSize() const
+{
+    return pImpl->getSize();
+}
+
+void MsgSock::recv(
+        void*        msg,
+        const size_t len,
+        const int    flags) const
+{
+    pImpl->recv(msg, len, flags);
+}
+
+size_t MsgSock::recvv(
+        const struct iovec* iovec,
+        const int           iovcnt,
+        const int           flags) const
+{
+    return pImpl->recvv(iovec, iovcnt, flags);
+}
+
+bool MsgSock::forward(
+        const MsgSock& egress,
+        const unsigned streamId) const
+{
+    return pImpl->forward(*egress.pImpl, streamId);
+}
+
+bool MsgSock::hasMessage() const
+{
+    return pImpl->hasMessage();
+}
+
+void MsgSock::discard() const
+{
+    pImpl->discard();
+}
+
+bool MsgSock::operator==(const MsgSock& that) const noexcept
+{
+    return pImpl.get() == that.pImpl.get();
+}
+
+std::string MsgSock::to_string() const
+{
+    return pImpl ? pImpl->to_string() : "SocketImpl{sd=-1}";
+}
+
+} // namespace
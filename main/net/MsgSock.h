@@ -0,0 +1,259 @@
+/**
+ * This file declares a handle class for an established message-oriented
+ * socket. The underlying transport is either an SCTP association or a TCP
+ * connection with record framing; higher-level components (e.g., `Channel`
+ * and `Peer`) use this class so the transport can be selected per-peer at
+ * connect time.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: MsgSock.h
+ * @author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_NET_MSGSOCK_H_
+#define MAIN_NET_MSGSOCK_H_
+
+#include "InetSockAddr.h"
+#include "SctpSock.h"
+#include "TcpSock.h"
+
+#include <memory>
+
+namespace hycast {
+
+/**
+ * An established socket that preserves message boundaries and carries
+ * multiple logical streams. Wraps either an `SctpSock` or a `TcpSock`: the
+ * constructors are implicit so either concrete socket may be passed wherever
+ * a `MsgSock` is expected.
+ */
+class MsgSock final
+{
+public:
+    class                 Impl; // Implemented per underlying transport
+
+private:
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Default constructs.
+     */
+    MsgSock();
+
+    /**
+     * Constructs from an established SCTP socket. Intentionally not `explicit`.
+     * @param[in] sock  Established SCTP socket
+     */
+    MsgSock(const SctpSock& sock);
+
+    /**
+     * Constructs from an established TCP socket. Intentionally not `explicit`.
+     * @param[in] sock  Established TCP socket
+     */
+    MsgSock(const TcpSock& sock);
+
+    /**
+     * Returns the Internet socket address of the remote end.
+     * @return Internet socket address of the remote end
+     */
+    InetSockAddr getRemoteAddr() const;
+
+    /**
+     * Returns the socket descriptor.
+     * @return socket descriptor
+     * @exceptionsafety Strong guarantee
+     * @threadsafety    Safe
+     */
+    int getSock() const noexcept;
+
+    /**
+     * Enables zero-copy transmission if the underlying transport supports it;
+     * otherwise, logs a warning and does nothing.
+     * @exceptionsafety  Strong guarantee
+     * @threadsafety     Safe
+     */
+    void enableZeroCopy() const;
+
+    /**
+     * Enables adaptive send-buffer sizing if the underlying transport
+     * supports it; otherwise, logs a note and does nothing. An SCTP
+     * transport then doubles its send buffer -- up to `max` bytes --
+     * whenever a send blocks long enough to indicate that the buffer was
+     * full. A TCP transport's send buffer is already autotuned by the
+     * kernel (the `net.ipv4.tcp_wmem` sysctl).
+     * @param[in] max          Ceiling on adaptive growth in bytes
+     * @throw InvalidArgument  `max <= 0`
+     * @throw SystemError      Current size couldn't be obtained
+     * @exceptionsafety        Strong guarantee
+     * @threadsafety           Safe
+     * @see `SctpSock::enableAdaptiveSndBuf()`
+     */
+    void enableAdaptiveSndBuf(const int max) const;
+
+    /**
+     * Returns a snapshot of the kernel's transport metrics for the
+     * connection. For an SCTP socket, this is what `SCTP_STATUS` reports;
+     * for a TCP socket, the equivalent fields of `TCP_INFO`.
+     * @return             Transport metrics of the connection
+     * @throw SystemError  Metrics couldn't be obtained
+     * @exceptionsafety    Strong guarantee
+     * @threadsafety       Safe
+     */
+    SctpSock::Status getStatus() const;
+
+    /**
+     * Sends a message.
+     * @param[in] streamId    Logical stream number
+     * @param[in] msg         Message to be sent
+     * @param[in] len         Size of message in bytes
+     * @param[in] timetolive  Partial-reliability lifetime in milliseconds
+     *                        (see RFC 3758): under congestion, an SCTP
+     *                        transport abandons an unsent or unacknowledged
+     *                        message this old instead of retransmitting it.
+     *                        0 (the default) means fully-reliable delivery.
+     *                        Ignored by a TCP transport, which is always
+     *                        fully reliable.
+     * @throws std::system_error if an I/O error occurred
+     * @exceptionsafety Basic
+     * @threadsafety    Safe
+     */
+    void send(
+            const unsigned streamId,
+            const void*    msg,
+            const size_t   len,
+            const unsigned timetolive = 0) const;
+
+    /**
+     * Sends a message. This is a cancellation point.
+     * @param[in] streamId    Logical stream number
+     * @param[in] iovec       Vector comprising message to send
+     * @param[in] iovcnt      Number of elements in `iovec`
+     * @param[in] timetolive  Partial-reliability lifetime in milliseconds or
+     *                        0 (the default) for fully-reliable delivery
+     * @see `send()`
+     */
+    void sendv(
+            const unsigned streamId,
+            struct iovec*  iovec,
+            const int      iovcnt,
+            const unsigned timetolive = 0) const;
+
+    /**
+     * Returns the logical stream number of the current message. Waits for the
+     * message if necessary. The message is left in the socket's input buffer.
+     * @returns Logical stream number
+     * @throws std::system_error if an I/O error occurs
+     * @exceptionsafety Basic
+     */
+    unsigned getStreamId() const;
+
+    /**
+     * Returns the size, in bytes, of the current message. Waits for the
+     * message if necessary. The message is left in the socket's input buffer.
+     * @returns Size of message in bytes. Will equal 0 when socket is closed by
+     *          remote peer.
+     * @throws std::system_error if an I/O error occurs
+     * @exceptionsafety Basic
+     */
+    uint32_t getSize() const;
+
+    /**
+     * Receives a message.
+     * @param[out] msg     Receive buffer
+     * @param[in]  len     Size of receive buffer in bytes
+     * @param[in]  flags   Type of message reception. Logical OR of zero or
+     *                     more of
+     *                       - `MSG_PEEK` Peeks at the incoming message
+     * @throws std::system_error on I/O failure
+     */
+    void recv(
+            void*        msg,
+            const size_t len,
+            const int    flags = 0) const;
+
+    /**
+     * Receives a message.
+     * @param[in] iovec     Vector comprising message to receive
+     * @param[in] iovcnt    Number of elements in `iovec`
+     * @param[in] flags     Type of message reception. Logical OR of zero or
+     *                      more of
+     *                      - `MSG_PEEK` Peeks at the incoming message
+     * @return              Number of bytes actually read
+     * @throws std::system_error if an I/O error occurs
+     * @exceptionsafety Basic
+     * @threadsafety Safe
+     */
+    size_t recvv(
+            const struct iovec* iovec,
+            const int           iovcnt,
+            const int           flags = 0) const;
+
+    /**
+     * Forwards the payload of the current message to another message-socket
+     * if the kernel can move the bytes directly between the two transports;
+     * otherwise, does nothing. Only a TCP-to-TCP forward has such a path: a
+     * relay whose peer connections are TCP then moves a relayed chunk's
+     * payload from its upstream to its downstream connection without the
+     * bytes ever entering userspace. A caller that gets `false` receives and
+     * re-sends the message ordinarily.
+     * @param[in] egress    Socket to forward the payload to
+     * @param[in] streamId  Logical stream number on the egress socket
+     * @retval true   Payload was forwarded and the message consumed
+     * @retval false  The transports have no kernel path; the message is
+     *                untouched
+     * @throws InvalidArgument   Invalid egress stream number
+     * @throws std::system_error I/O failure on either socket
+     * @exceptionsafety Basic
+     * @threadsafety    Safe
+     * @see `TcpSock::forward()`
+     */
+    bool forward(
+            const MsgSock& egress,
+            const unsigned streamId) const;
+
+    /**
+     * Indicates if this instance has a current message.
+     * @retval true   Yes
+     * @retval false  No
+     */
+    bool hasMessage() const;
+
+    /**
+     * Discards the current message.
+     * @exceptionsafety Basic guarantee
+     * @threadsafety    Thread-compatible but not thread-safe
+     */
+    void discard() const;
+
+    /**
+     * Indicates if this instance equals another.
+     * @param[in] that  Other instance
+     * @retval `true`   This instance equals the other
+     * @retval `false`  This instance doesn't equal the other
+     * @exceptionsafety Nothrow
+     */
+    bool operator==(const MsgSock& that) const noexcept;
+
+    /**
+     * Returns a string representation of this instance's socket.
+     * @return String representation of this instance's socket
+     * @throws std::bad_alloc if required memory can't be allocated
+     * @exceptionsafety Strong
+     * @threadsafety    Safe
+     */
+    std::string to_string() const;
+};
+
+} // namespace
+
+namespace std {
+    inline string to_string(const hycast::MsgSock& sock) {
+        return sock.to_string();
+    }
+}
+
+#endif /* MAIN_NET_MSGSOCK_H_ */
@@ -0,0 +1,194 @@
+/**
+ * This file implements the network-condition emulator for the test harness.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: NetEmulator.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "error.h"
+#include "NetEmulator.h"
+
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <thread>
+
+namespace hycast {
+
+class NetEmulator::Impl final
+{
+    typedef std::mutex                     Mutex;
+    typedef std::lock_guard<Mutex>         LockGuard;
+    typedef std::chrono::steady_clock      Clock;
+    typedef std::chrono::time_point<Clock> TimePoint;
+    typedef std::chrono::duration<double>  Seconds;
+
+    Mutex                                  mutex;
+    std::default_random_engine             generator;
+    std::uniform_real_distribution<double> uniform;
+    // Gilbert-Elliott burst-loss. Disabled while both loss terms are zero.
+    double                                 pGoodToBad;
+    double                                 pBadToGood;
+    double                                 lossGood;
+    double                                 lossBad;
+    bool                                   inBadState;
+    // Added latency. Disabled while `latencyMean` and `jitter` are zero.
+    double                                 latencyMean;
+    double                                 jitter;
+    // Bandwidth cap. Disabled while `secsPerByte` is zero.
+    double                                 secsPerByte;
+    /// Earliest time the next delivery may complete under the cap
+    TimePoint                              nextDelivery;
+
+    static void checkProbability(
+            const char* const name,
+            const double      probability)
+    {
+        if (probability < 0 || probability > 1)
+            throw INVALID_ARGUMENT(std::string{name} + " (" +
+                    std::to_string(probability) + ") isn't a probability");
+    }
+
+public:
+    explicit Impl(const unsigned seed)
+        : mutex{}
+        , generator{seed}
+        , uniform{0, 1}
+        , pGoodToBad{0}
+        , pBadToGood{0}
+        , lossGood{0}
+        , lossBad{0}
+        , inBadState{false}
+        , latencyMean{0}
+        , jitter{0}
+        , secsPerByte{0}
+        , nextDelivery{}
+    {}
+
+    void setBurstLoss(
+            const double pGoodToBad,
+            const double pBadToGood,
+            const double lossGood,
+            const double lossBad)
+    {
+        checkProbability("Good-to-bad transition-probability", pGoodToBad);
+        checkProbability("Bad-to-good transition-probability", pBadToGood);
+        checkProbability("Good-state loss-probability", lossGood);
+        checkProbability("Bad-state loss-probability", lossBad);
+        LockGuard lock{mutex};
+        this->pGoodToBad = pGoodToBad;
+        this->pBadToGood = pBadToGood;
+        this->lossGood = lossGood;
+        this->lossBad = lossBad;
+    }
+
+    void setLatency(
+            const double mean,
+            const double jitter)
+    {
+        if (mean < 0)
+            throw INVALID_ARGUMENT("Mean latency is negative: " +
+                    std::to_string(mean));
+        if (jitter < 0)
+            throw INVALID_ARGUMENT("Jitter is negative: " +
+                    std::to_string(jitter));
+        LockGuard lock{mutex};
+        this->latencyMean = mean;
+        this->jitter = jitter;
+    }
+
+    void setBandwidth(const double bytesPerSec)
+    {
+        if (bytesPerSec <= 0)
+            throw INVALID_ARGUMENT("Bandwidth cap isn't positive: " +
+                    std::to_string(bytesPerSec));
+        LockGuard lock{mutex};
+        secsPerByte = 1/bytesPerSec;
+    }
+
+    bool shouldDrop()
+    {
+        LockGuard lock{mutex};
+        if (lossGood == 0 && lossBad == 0)
+            return false;
+        inBadState = inBadState
+                ? uniform(generator) >= pBadToGood
+                : uniform(generator) < pGoodToBad;
+        return uniform(generator) < (inBadState ? lossBad : lossGood);
+    }
+
+    void delay(const size_t nbytes)
+    {
+        Seconds latency{0};
+        auto    until = TimePoint{};
+        {
+            LockGuard  lock{mutex};
+            const auto now = Clock::now();
+            if (latencyMean > 0 || jitter > 0)
+                latency = Seconds{latencyMean +
+                        jitter*(2*uniform(generator) - 1)};
+            if (latency < Seconds{0})
+                latency = Seconds{0};
+            if (secsPerByte > 0) {
+                // Token-bucket pacing of the emulated traffic as a whole
+                if (nextDelivery < now)
+                    nextDelivery = now;
+                nextDelivery += std::chrono::duration_cast<Clock::duration>(
+                        Seconds{nbytes*secsPerByte});
+                until = nextDelivery;
+            }
+        }
+        // Sleeps happen outside the lock so deliveries pipeline
+        if (until != TimePoint{})
+            std::this_thread::sleep_until(until);
+        if (latency > Seconds{0})
+            std::this_thread::sleep_for(latency);
+    }
+};
+
+NetEmulator::NetEmulator(const unsigned seed)
+    : pImpl{new Impl(seed)}
+{}
+
+NetEmulator::operator bool() const noexcept
+{
+    return static_cast<bool>(pImpl);
+}
+
+void NetEmulator::setBurstLoss(
+        const double pGoodToBad,
+        const double pBadToGood,
+        const double lossGood,
+        const double lossBad) const
+{
+    pImpl->setBurstLoss(pGoodToBad, pBadToGood, lossGood, lossBad);
+}
+
+void NetEmulator::setLatency(
+        const double mean,
+        const double jitter) const
+{
+    pImpl->setLatency(mean, jitter);
+}
+
+void NetEmulator::setBandwidth(const double bytesPerSec) const
+{
+    pImpl->setBandwidth(bytesPerSec);
+}
+
+bool NetEmulator::shouldDrop() const
+{
+    return pImpl->shouldDrop();
+}
+
+void NetEmulator::delay(const size_t nbytes) const
+{
+    pImpl->delay(nbytes);
+}
+
+} // namespace
@@ -0,0 +1,114 @@
+/**
+ * This file declares an emulator of adverse network conditions for the test
+ * harness. Attached to a socket, it subjects that socket's traffic to bursty
+ * loss (a Gilbert-Elliott two-state chain), added latency with jitter, and a
+ * bandwidth cap -- the conditions that uniform random loss (cf. Receiving's
+ * `drop` parameter) can't reproduce. Not intended for production use.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: NetEmulator.h
+ * @author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_NET_NETEMULATOR_H_
+#define MAIN_NET_NETEMULATOR_H_
+
+#include <cstddef>
+#include <memory>
+
+namespace hycast {
+
+class NetEmulator final
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Default constructs. Will test false: sockets treat such an instance as
+     * no emulation at all.
+     */
+    NetEmulator() =default;
+
+    /**
+     * Constructs an enabled emulator that initially passes all traffic
+     * through unmolested. Copies share state, so one emulator attached to
+     * several sockets subjects their combined traffic to, e.g., a single
+     * bandwidth cap.
+     * @param[in] seed  Seed for the pseudo-random number generator, so a
+     *                  test's loss pattern is reproducible
+     */
+    explicit NetEmulator(const unsigned seed);
+
+    /**
+     * Indicates if this instance is enabled.
+     * @retval `true`  Iff this instance was constructed with a seed
+     */
+    operator bool() const noexcept;
+
+    /**
+     * Configures Gilbert-Elliott burst-loss. The chain is advanced and a
+     * loss decision drawn once per datagram by `shouldDrop()`.
+     * @param[in] pGoodToBad   Probability of entering the bad (burst) state
+     *                         after a datagram in the good state
+     * @param[in] pBadToGood   Probability of leaving the bad state after a
+     *                         datagram in it
+     * @param[in] lossGood     Probability of losing a datagram in the good
+     *                         state
+     * @param[in] lossBad      Probability of losing a datagram in the bad
+     *                         state
+     * @throw InvalidArgument  A probability is outside the interval [0, 1]
+     * @threadsafety           Safe
+     */
+    void setBurstLoss(
+            const double pGoodToBad,
+            const double pBadToGood,
+            const double lossGood,
+            const double lossBad) const;
+
+    /**
+     * Configures added latency. Each delivery is delayed by a value drawn
+     * uniformly from [mean-jitter, mean+jitter], clamped at zero.
+     * @param[in] mean         Mean added latency in seconds
+     * @param[in] jitter       Half-width of the latency distribution in
+     *                         seconds
+     * @throw InvalidArgument  `mean < 0 || jitter < 0`
+     * @threadsafety           Safe
+     */
+    void setLatency(
+            const double mean,
+            const double jitter = 0) const;
+
+    /**
+     * Configures a bandwidth cap. Deliveries are paced so the emulated
+     * traffic doesn't exceed the given rate.
+     * @param[in] bytesPerSec  Bandwidth cap in bytes per second
+     * @throw InvalidArgument  `bytesPerSec <= 0`
+     * @threadsafety           Safe
+     */
+    void setBandwidth(const double bytesPerSec) const;
+
+    /**
+     * Decides the fate of a datagram: advances the Gilbert-Elliott chain and
+     * draws a loss decision from its current state.
+     * @retval `true`  Iff the datagram should be dropped
+     * @threadsafety   Safe
+     */
+    bool shouldDrop() const;
+
+    /**
+     * Imposes the configured latency and pacing on a delivery: blocks the
+     * calling thread for the drawn latency plus however long the bandwidth
+     * cap requires for `nbytes` more bytes.
+     * @param[in] nbytes  Number of bytes being delivered
+     * @threadsafety      Safe
+     */
+    void delay(const size_t nbytes) const;
+};
+
+} // namespace
+
+#endif /* MAIN_NET_NETEMULATOR_H_ */
@@ -62,6 +62,21 @@ public:
             const size_t nbytes,
             const bool   peek = false);
 
+    /**
+     * Returns a view of the pending record without consuming it. Only
+     * available when the stream holds the record in a user-space buffer: the
+     * returned pointer then refers directly into that buffer and nothing is
+     * copied. The view is valid until the record is consumed or discarded.
+     * The default implementation returns `nullptr`.
+     * @param[in] nbytes  Minimum number of bytes the view must expose
+     * @retval nullptr    No view is available or the record is too small
+     * @return            Pointer to the first byte of the pending record
+     */
+    virtual const void* peek(const size_t nbytes)
+    {
+        return nullptr;
+    }
+
     /**
      * Returns the size, in bytes, of the current record. Waits for a record if
      * necessary.
@@ -13,6 +13,7 @@
 #define SCTPSOCK_H_
 
 #include "InetSockAddr.h"
+#include "NetEmulator.h"
 
 #include <memory>
 
@@ -41,6 +42,14 @@ public:
      */
     static int createSocket();
 
+    /**
+     * Creates an SCTP-compatible BSD socket in the given address family.
+     * @param[in] family   Address family: `AF_INET` or `AF_INET6`
+     * @return             SCTP-compatible socket descriptor
+     * @throw SystemError  Socket couldn't be created
+     */
+    static int createSocket(const int family);
+
     /**
      * Default constructs.
      */
@@ -93,6 +102,18 @@ public:
      */
     BaseSctpSock& setRecvBufSize(const int size);
 
+    /**
+     * Sets the Differentiated Services code-point on the socket so the
+     * network can class the association's traffic (e.g., prioritize chunk
+     * repair over backlog transfers on a different association).
+     * @param[in] dscp         Code-point in [0,63] (see RFC 2474). 0 is
+     *                         best-effort (the default).
+     * @return                 Reference to this instance
+     * @throw InvalidArgument  `dscp > 63`
+     * @throw SystemError      Code-point couldn't be set
+     */
+    BaseSctpSock& setDscp(const unsigned dscp);
+
     /**
      * Returns the socket descriptor.
      * @return socket descriptor
@@ -130,6 +151,17 @@ class SctpSock final : public BaseSctpSock
     class Impl;
 
 public:
+    /**
+     * Snapshot of the kernel's transport metrics for the SCTP association.
+     * The per-path values refer to the primary path.
+     */
+    struct Status {
+        unsigned srttMs;      ///< Smoothed round-trip time in milliseconds
+        unsigned cwndBytes;   ///< Congestion window in bytes
+        unsigned unackedData; ///< Number of unacknowledged DATA chunks
+        unsigned pendingData; ///< Number of DATA chunks awaiting receipt
+    };
+
     /**
      * Default constructs.
      */
@@ -151,6 +183,19 @@ public:
      */
     explicit SctpSock(const int numStreams);
 
+    /**
+     * Constructs an SCTP socket from the client side in the given address
+     * family. As for `SctpSock(int)`, which creates an IPv4 socket.
+     * @param[in] family       Address family: `AF_INET` or `AF_INET6`
+     * @param[in] numStreams   Number of SCTP streams
+     * @throw InvalidArgument  `numStreams <= 0`
+     * @throw SystemError      Socket couldn't be created
+     * @see `connect(InetSockAddr& addr)`
+     */
+    SctpSock(
+            const int family,
+            const int numStreams);
+
     /**
      * Constructs an SCTP socket from the server side.
      * @param[in] sd         SCTP socket descriptor from `accept()`
@@ -191,17 +236,75 @@ public:
      */
     SctpSock& connect(const InetSockAddr& addr);
 
+    /**
+     * Sets the local source address. Binds the socket to the address with an
+     * ephemeral port so the connection uses a particular interface (e.g., one
+     * picked from an `InterfaceSet`) instead of the one the routing table
+     * prefers. Must be called before `connect()`.
+     * @param[in] srcAddr   Internet address of source interface
+     * @return              This instance
+     * @throws SystemError  Couldn't bind socket to address
+     * @exceptionsafety     Strong
+     * @threadsafety        Safe
+     * @see `connect(const InetSockAddr& addr)`
+     */
+    SctpSock& setSrcAddr(const InetAddr& srcAddr);
+
     /**
      * Returns the Internet socket address of the remote end.
      * @return Internet socket address of the remote end
      */
     InetSockAddr getRemoteAddr() const;
 
+    /**
+     * Enables zero-copy transmission. Messages over a size threshold are
+     * transmitted directly from the caller's pages instead of being copied
+     * into the kernel's send-buffer; smaller messages are copied as usual.
+     * Such a message must persist, unmodified, until the kernel signals
+     * completion, which `sendv()` tracks. Does nothing -- except log a warning
+     * -- if the kernel or protocol doesn't support zero-copy transmission:
+     * every send then copies as usual.
+     * @exceptionsafety  Strong guarantee
+     * @threadsafety     Safe
+     */
+    void enableZeroCopy() const;
+
+    /**
+     * Enables adaptive send-buffer sizing. Whenever a send blocks long
+     * enough to indicate that the send buffer was full, the buffer is
+     * doubled -- up to `max` bytes -- so a transient stall doesn't keep
+     * throttling every stream of the association. The current size is
+     * exported via the metric `hycast_sctp_sndbuf_bytes`.
+     * @param[in] max          Ceiling on adaptive growth in bytes
+     * @throw InvalidArgument  `max <= 0`
+     * @throw SystemError      Current size couldn't be obtained
+     * @exceptionsafety        Strong guarantee
+     * @threadsafety           Safe
+     */
+    void enableAdaptiveSndBuf(const int max) const;
+
+    /**
+     * Returns a snapshot of the kernel's transport metrics for the
+     * association -- what `SCTP_STATUS` reports. Lets a higher-level
+     * component react to transport congestion (e.g., a collapsed congestion
+     * window) well before application-level symptoms appear.
+     * @return             Transport metrics of the association
+     * @throw SystemError  Metrics couldn't be obtained
+     * @exceptionsafety    Strong guarantee
+     * @threadsafety       Safe
+     */
+    Status getStatus() const;
+
     /**
      * Sends a message.
-     * @param[in] streamId  SCTP stream number
-     * @param[in] msg       Message to be sent
-     * @param[in] len       Size of message in bytes
+     * @param[in] streamId    SCTP stream number
+     * @param[in] msg         Message to be sent
+     * @param[in] len         Size of message in bytes
+     * @param[in] timetolive  Partial-reliability lifetime in milliseconds
+     *                        (see RFC 3758): under congestion, the kernel
+     *                        abandons an unsent or unacknowledged message
+     *                        this old instead of retransmitting it. 0 (the
+     *                        default) means fully-reliable delivery.
      * @throws std::system_error if an I/O error occurred
      * @exceptionsafety Basic
      * @threadsafety    Compatible but not safe
@@ -209,18 +312,23 @@ public:
     void send(
             const unsigned streamId,
             const void*    msg,
-            const size_t   len) const;
+            const size_t   len,
+            const unsigned timetolive = 0) const;
 
     /**
      * Sends a message. This is a cancellation point.
-     * @param[in] streamId  SCTP stream number
-     * @param[in] iovec     Vector comprising message to send
-     * @param[in] iovcnt    Number of elements in `iovec`
+     * @param[in] streamId    SCTP stream number
+     * @param[in] iovec       Vector comprising message to send
+     * @param[in] iovcnt      Number of elements in `iovec`
+     * @param[in] timetolive  Partial-reliability lifetime in milliseconds or
+     *                        0 (the default) for fully-reliable delivery
+     * @see `send()`
      */
     void sendv(
             const unsigned streamId,
             struct iovec*  iovec,
-            const int      iovcnt) const;
+            const int      iovcnt,
+            const unsigned timetolive = 0) const;
 
     /**
      * Returns the SCTP stream number of the current message. Waits for the
@@ -275,6 +383,16 @@ public:
             const int           iovcnt,
             const int           flags = 0) const;
 
+    /**
+     * Attaches a network-condition emulator for the test harness: received
+     * messages are delayed by the emulator's latency and bandwidth cap
+     * before delivery. SCTP is reliable, so -- unlike on a UDP socket --
+     * the emulator's loss model isn't applied.
+     * @param[in] emulator  Emulator of adverse network conditions
+     * @see NetEmulator
+     */
+    void setEmulator(const NetEmulator& emulator) const;
+
     /**
      * Indicates if this instance has a current message.
      * @retval true   Yes
@@ -321,6 +439,22 @@ public:
             const InetSockAddr& addr,
             const int           numStreams = 1);
 
+    /**
+     * Constructs from an existing socket descriptor -- e.g., one inherited
+     * from the previous process during a warm handoff. The socket's bound
+     * address and listen-queue are preserved, so no association attempt is
+     * refused during an upgrade.
+     * @param[in] sd              Bound, SCTP-compatible socket descriptor.
+     *                            This instance assumes ownership.
+     * @param[in] numStreams      Number of SCTP streams
+     * @throw InvalidArgument     `sd < 0 || numStreams < 0`
+     * @throw SystemError         Socket couldn't be configured
+     * @see `HandoffReceiver::recv()`
+     */
+    SrvrSctpSock(
+            const int sd,
+            const int numStreams);
+
     /**
      * Copy assigns.
      * @param[in] rhs  Other instance
@@ -0,0 +1,856 @@
+/**
+ * This file implements TCP sockets that carry the same multi-stream message
+ * protocol as the SCTP sockets. Reads on a socket are stateful; writes are
+ * stateless.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: TcpSock.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "error.h"
+#include "InetSockAddr.h"
+#include "TcpSock.h"
+
+#include <arpa/inet.h>
+#include <cstdint>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <mutex>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include <sys/socket.h>
+#include <system_error>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace hycast {
+
+class TcpSock::Impl final
+{
+    /**
+     * Record header that precedes every message on the byte-stream. All
+     * fields are in network byte order.
+     * Keep consistent between `sendv()` and `ensureMsg()`.
+     */
+    struct RecHeader
+    {
+        uint32_t size;     ///< Payload length in bytes
+        uint16_t streamId; ///< Logical stream number
+        uint16_t unused;   ///< Reserved. Must be zero.
+    };
+
+    mutable std::mutex readMutex;
+    mutable std::mutex writeMutex;
+    InetSockAddr       remoteAddr;
+    InetAddr           srcAddr;
+    bool               haveSrcAddr;
+    int                sd;
+    const int          numStreams;
+    /// Whether the current message's header has been read
+    bool               haveCurrMsg;
+    /// Payload length of the current message in bytes
+    uint32_t           size;
+    /// Logical stream number of the current message
+    unsigned           streamId;
+
+    /**
+     * Configures an established socket: disables Nagle's algorithm so the
+     * small control messages of the peer protocol aren't delayed behind
+     * unacknowledged bulk data. The encoders already batch serial output
+     * into maximally-sized records.
+     * @throw SystemError  Socket couldn't be configured
+     */
+    void configure()
+    {
+        const int enable = 1;
+        if (::setsockopt(sd, IPPROTO_TCP, TCP_NODELAY, &enable,
+                sizeof(enable)))
+            throw SYSTEM_ERROR("setsockopt() failure: Couldn't disable "
+                    "Nagle's algorithm: sock=" + std::to_string(sd));
+    }
+
+    /**
+     * Receives bytes. Doesn't return until the requested number of bytes has
+     * been received, the remote end has closed the connection, or an error
+     * occurs. This is a cancellation point.
+     * @param[out] buf     Receive buffer
+     * @param[in]  nbytes  Number of bytes to receive
+     * @retval     0       Connection was closed before any byte arrived
+     * @return             `nbytes`
+     * @throw SystemError  I/O failure or connection closed mid-record
+     */
+    size_t recvFully(
+            void* const  buf,
+            const size_t nbytes) const
+    {
+        size_t got = 0;
+        while (got < nbytes) {
+            const ssize_t n = ::read(sd, static_cast<char*>(buf) + got,
+                    nbytes - got);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                throw SYSTEM_ERROR("read() failure: sock=" +
+                        std::to_string(sd));
+            }
+            if (n == 0) {
+                if (got == 0)
+                    return 0;
+                throw SYSTEM_ERROR("Connection closed mid-record: sock=" +
+                        std::to_string(sd) + ", got=" + std::to_string(got) +
+                        ", expected=" + std::to_string(nbytes));
+            }
+            got += n;
+        }
+        return nbytes;
+    }
+
+    /**
+     * Reads the record header of the next message if one hasn't been read.
+     * Waits for the header if necessary. On return, the payload is at the
+     * head of the byte-stream. If the remote end has closed the connection,
+     * then the current message's size will be 0.
+     * @pre `readMutex` is locked
+     * @throw SystemError  I/O failure
+     */
+    void ensureMsg()
+    {
+        if (!haveCurrMsg) {
+            RecHeader header;
+            if (recvFully(&header, sizeof(header)) == 0) {
+                size = 0; // Connection closed by remote end
+                streamId = 0;
+            }
+            else {
+                size = ntohl(header.size);
+                streamId = ntohs(header.streamId);
+            }
+            haveCurrMsg = true;
+        }
+    }
+
+    /**
+     * Sends bytes. Doesn't return until every byte has been submitted to the
+     * transport or an error occurs. This is a cancellation point.
+     * @pre `writeMutex` is locked
+     * @param[in] buf      Bytes to send
+     * @param[in] nbytes   Number of bytes to send
+     * @throw SystemError  I/O failure
+     */
+    void writeFully(
+            const void* const buf,
+            const size_t      nbytes) const
+    {
+        size_t sent = 0;
+        while (sent < nbytes) {
+            const ssize_t n = ::write(sd, static_cast<const char*>(buf) + sent,
+                    nbytes - sent);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                throw SYSTEM_ERROR("write() failure: sock=" +
+                        std::to_string(sd));
+            }
+            sent += n;
+        }
+    }
+
+    /**
+     * Forwards payload bytes to another TCP socket through a userspace
+     * bounce-buffer: the fallback for `forward()` when the kernel can't
+     * splice the descriptors.
+     * @pre `readMutex` and `egress.writeMutex` are locked and the record
+     *      header has been read
+     * @param[in] egress   Socket to forward the bytes to
+     * @param[in] nbytes   Number of payload bytes to forward
+     * @throw SystemError  I/O failure on either socket
+     */
+    void bounce(
+            Impl&        egress,
+            const size_t nbytes)
+    {
+        char   buf[8192];
+        size_t left = nbytes;
+        while (left > 0) {
+            const size_t chunk = left > sizeof(buf) ? sizeof(buf) : left;
+            if (recvFully(buf, chunk) == 0)
+                throw SYSTEM_ERROR("Connection closed mid-record: sock=" +
+                        std::to_string(sd) + ", left=" + std::to_string(left));
+            egress.writeFully(buf, chunk);
+            left -= chunk;
+        }
+    }
+
+    /**
+     * Discards the payload of the current message.
+     * @pre `readMutex` is locked and the record header has been read
+     * @throw SystemError  I/O failure
+     */
+    void drain()
+    {
+        char   trash[4096];
+        size_t left = size;
+        while (left > 0) {
+            const size_t nbytes = left > sizeof(trash) ? sizeof(trash) : left;
+            if (recvFully(trash, nbytes) == 0)
+                break;
+            left -= nbytes;
+        }
+        haveCurrMsg = false;
+    }
+
+    /**
+     * Vets a logical stream number.
+     * @param[in] streamId     Logical stream number
+     * @throw InvalidArgument  Stream number is invalid
+     */
+    void vet(const unsigned streamId) const
+    {
+        if (streamId >= static_cast<unsigned>(numStreams))
+            throw INVALID_ARGUMENT("Invalid stream number: streamId=" +
+                    std::to_string(streamId) + ", numStreams=" +
+                    std::to_string(numStreams));
+    }
+
+public:
+    /**
+     * Constructs from the client side. The socket isn't created until
+     * `connect()` is called because its address family depends on the
+     * server's address.
+     * @param[in] numStreams   Number of logical streams
+     * @throw InvalidArgument  `numStreams <= 0`
+     */
+    explicit Impl(const int numStreams)
+        : readMutex{}
+        , writeMutex{}
+        , remoteAddr{}
+        , srcAddr{}
+        , haveSrcAddr{false}
+        , sd{-1}
+        , numStreams{numStreams}
+        , haveCurrMsg{false}
+        , size{0}
+        , streamId{0}
+    {
+        if (numStreams <= 0)
+            throw INVALID_ARGUMENT("Invalid number of streams: " +
+                    std::to_string(numStreams));
+    }
+
+    /**
+     * Constructs from the server side.
+     * @param[in] sd          TCP socket descriptor from `accept()`
+     * @param[in] addr        Address of remote TCP socket
+     * @param[in] numStreams  Number of logical streams
+     * @throw InvalidArgument  `sd < 0 || numStreams <= 0`
+     * @throw SystemError      Socket couldn't be configured
+     */
+    Impl(   const int              sd,
+            const struct sockaddr& addr,
+            const int              numStreams)
+        : readMutex{}
+        , writeMutex{}
+        , remoteAddr{addr}
+        , srcAddr{}
+        , haveSrcAddr{false}
+        , sd{sd}
+        , numStreams{numStreams}
+        , haveCurrMsg{false}
+        , size{0}
+        , streamId{0}
+    {
+        if (sd < 0)
+            throw INVALID_ARGUMENT("Invalid socket descriptor: " +
+                    std::to_string(sd));
+        if (numStreams <= 0)
+            throw INVALID_ARGUMENT("Invalid number of streams: " +
+                    std::to_string(numStreams));
+        configure();
+    }
+
+    /// Prevents copy and move construction and assignment
+    Impl(const Impl& impl) =delete;
+    Impl(const Impl&& impl) =delete;
+    Impl& operator=(const Impl& rhs) =delete;
+    Impl& operator=(const Impl&& rhs) =delete;
+
+    /**
+     * Destroys. Closes the underlying BSD socket if it's open.
+     * @exceptionsafety Nothrow
+     */
+    ~Impl() noexcept
+    {
+        if (sd >= 0)
+            ::close(sd);
+    }
+
+    /**
+     * Connects to a server. Blocks until the connection is established.
+     * @param[in] addr      Internet socket address of the server
+     * @throws LogicError   Socket is already connected
+     * @throws SystemError  Connection failure
+     */
+    void connect(const InetSockAddr& addr)
+    {
+        if (sd >= 0)
+            throw LOGIC_ERROR("Socket is already connected: sock=" +
+                    std::to_string(sd));
+        sd = addr.getSocket(SOCK_STREAM);
+        try {
+            if (haveSrcAddr)
+                InetSockAddr{srcAddr, 0}.bind(sd);
+            addr.connect(sd);
+            configure();
+            remoteAddr = addr;
+        }
+        catch (const std::exception& ex) {
+            ::close(sd);
+            sd = -1;
+            std::throw_with_nested(SYSTEM_ERROR(
+                    "Couldn't connect TCP socket to " + addr.to_string()));
+        }
+    }
+
+    /**
+     * Sets the local source address. Must be called before `connect()`.
+     * @param[in] srcAddr  Internet address of source interface
+     * @throws LogicError  Socket is already connected
+     */
+    void setSrcAddr(const InetAddr& srcAddr)
+    {
+        if (sd >= 0)
+            throw LOGIC_ERROR("Socket is already connected: sock=" +
+                    std::to_string(sd));
+        this->srcAddr = srcAddr;
+        haveSrcAddr = true;
+    }
+
+    InetSockAddr getRemoteAddr() const
+    {
+        return remoteAddr;
+    }
+
+    uint16_t getNumStreams() const
+    {
+        return numStreams;
+    }
+
+    int getSock() const noexcept
+    {
+        return sd;
+    }
+
+    /**
+     * Sends a message. The record header and payload are gather-written so
+     * the record is submitted to the transport in one system call. This is a
+     * cancellation point.
+     * @param[in] streamId  Logical stream number
+     * @param[in] iovec     Vector comprising message to send
+     * @param[in] iovcnt    Number of elements in `iovec`
+     * @throws InvalidArgument   Invalid stream number
+     * @throws std::system_error I/O failure
+     */
+    void sendv(
+            const unsigned streamId,
+            struct iovec*  iovec,
+            const int      iovcnt)
+    {
+        vet(streamId);
+        size_t payload = 0;
+        for (int i = 0; i < iovcnt; ++i)
+            payload += iovec[i].iov_len;
+        RecHeader header;
+        header.size = htonl(static_cast<uint32_t>(payload));
+        header.streamId = htons(static_cast<uint16_t>(streamId));
+        header.unused = 0;
+        struct iovec iov[1+iovcnt];
+        iov[0].iov_base = &header;
+        iov[0].iov_len = sizeof(header);
+        for (int i = 0; i < iovcnt; ++i)
+            iov[1+i] = iovec[i];
+        std::lock_guard<std::mutex> lock{writeMutex};
+        size_t sent = 0;
+        const size_t total = sizeof(header) + payload;
+        int          first = 0;
+        int          cnt = 1 + iovcnt;
+        while (sent < total) {
+            const ssize_t n = ::writev(sd, iov + first, cnt);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                throw SYSTEM_ERROR("writev() failure: sock=" +
+                        std::to_string(sd) + ", sent=" + std::to_string(sent) +
+                        ", total=" + std::to_string(total));
+            }
+            sent += n;
+            // Advance the vector past the bytes that were written
+            size_t skip = n;
+            while (cnt > 0 && skip >= iov[first].iov_len) {
+                skip -= iov[first].iov_len;
+                ++first;
+                --cnt;
+            }
+            if (cnt > 0 && skip > 0) {
+                iov[first].iov_base =
+                        static_cast<char*>(iov[first].iov_base) + skip;
+                iov[first].iov_len -= skip;
+            }
+        }
+    }
+
+    void send(
+            const unsigned streamId,
+            const void*    msg,
+            const size_t   len)
+    {
+        struct iovec iov;
+        iov.iov_base = const_cast<void*>(msg);
+        iov.iov_len = len;
+        sendv(streamId, &iov, 1);
+    }
+
+    unsigned getStreamId()
+    {
+        std::lock_guard<std::mutex> lock{readMutex};
+        ensureMsg();
+        return streamId;
+    }
+
+    uint32_t getSize()
+    {
+        std::lock_guard<std::mutex> lock{readMutex};
+        ensureMsg();
+        return size;
+    }
+
+    /**
+     * Receives a message. When peeking, the payload is left at the head of
+     * the byte-stream; otherwise, the entire message is consumed and payload
+     * bytes beyond the requested number are discarded so the byte-stream
+     * stays aligned on record boundaries. This is a cancellation point.
+     * @param[in] iovec     Vector comprising message to receive
+     * @param[in] iovcnt    Number of elements in `iovec`
+     * @param[in] flags     `MSG_PEEK` or 0
+     * @return              Number of bytes actually read
+     * @throws std::system_error I/O failure
+     */
+    size_t recvv(
+            const struct iovec* iovec,
+            const int           iovcnt,
+            const int           flags)
+    {
+        std::lock_guard<std::mutex> lock{readMutex};
+        ensureMsg();
+        size_t want = 0;
+        for (int i = 0; i < iovcnt; ++i)
+            want += iovec[i].iov_len;
+        if (want > size)
+            want = size;
+        size_t got;
+        if (flags & MSG_PEEK) {
+            /*
+             * The peek must be clamped to the current record's payload --
+             * the caller's buffer can be larger -- lest it run into the
+             * header of the next record. `MSG_WAITALL` keeps the peek from
+             * returning a partial payload when the record hasn't completely
+             * arrived.
+             */
+            struct iovec iov[iovcnt];
+            int          cnt = 0;
+            for (size_t left = want; cnt < iovcnt && left > 0; ++cnt) {
+                iov[cnt] = iovec[cnt];
+                if (iov[cnt].iov_len > left)
+                    iov[cnt].iov_len = left;
+                left -= iov[cnt].iov_len;
+            }
+            struct msghdr msghdr = {};
+            msghdr.msg_iov = iov;
+            msghdr.msg_iovlen = cnt;
+            ssize_t n;
+            for (;;) {
+                n = ::recvmsg(sd, &msghdr, MSG_PEEK | MSG_WAITALL);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                break;
+            }
+            if (n < 0)
+                throw SYSTEM_ERROR("recvmsg() failure: sock=" +
+                        std::to_string(sd));
+            got = n;
+        }
+        else {
+            got = 0;
+            for (int i = 0; i < iovcnt && got < want; ++i) {
+                const size_t nbytes = (want - got < iovec[i].iov_len)
+                        ? want - got
+                        : iovec[i].iov_len;
+                if (recvFully(iovec[i].iov_base, nbytes) == 0)
+                    break;
+                got += nbytes;
+            }
+            const size_t excess = size - got;
+            size = excess;
+            drain(); // Discards `size` bytes; clears `haveCurrMsg`
+        }
+        return got;
+    }
+
+    void recv(
+            void*        msg,
+            const size_t len,
+            const int    flags)
+    {
+        struct iovec iov;
+        iov.iov_base = msg;
+        iov.iov_len = len;
+        recvv(&iov, 1, flags);
+    }
+
+    /**
+     * Forwards the payload of the current message to another TCP socket.
+     * Once the record header has been read, the payload bytes are moved from
+     * this socket to the egress socket by the kernel -- `splice(2)` through
+     * a pipe -- so they never enter userspace. Falls back to a bounce-buffer
+     * copy if the kernel can't splice the descriptors. The message is
+     * consumed.
+     * @param[in] egress    Socket to forward the payload to
+     * @param[in] streamId  Logical stream number on the egress socket
+     * @retval 0            Connection was closed by the remote end
+     * @return              Number of payload bytes forwarded
+     * @throw InvalidArgument  Invalid egress stream number
+     * @throw SystemError      I/O failure on either socket
+     */
+    size_t forward(
+            Impl&          egress,
+            const unsigned streamId)
+    {
+        egress.vet(streamId);
+        std::lock_guard<std::mutex> readLock{readMutex};
+        ensureMsg();
+        if (size == 0) {
+            haveCurrMsg = false;
+            return 0; // Connection was closed by the remote end
+        }
+        const size_t payload = size;
+        RecHeader    header;
+        header.size = htonl(size);
+        header.streamId = htons(static_cast<uint16_t>(streamId));
+        header.unused = 0;
+        // The header and payload must be contiguous on the egress byte-stream
+        std::lock_guard<std::mutex> writeLock{egress.writeMutex};
+        egress.writeFully(&header, sizeof(header));
+        size_t left = payload;
+        int    pipeFds[2];
+        if (::pipe(pipeFds)) {
+            bounce(egress, left);
+        }
+        else {
+            try {
+                while (left > 0) {
+                    ssize_t n;
+                    for (;;) {
+                        n = ::splice(sd, nullptr, pipeFds[1], nullptr, left,
+                                SPLICE_F_MOVE | SPLICE_F_MORE);
+                        if (n < 0 && errno == EINTR)
+                            continue;
+                        break;
+                    }
+                    if (n < 0) {
+                        if (errno == EINVAL && left == payload) {
+                            // The kernel can't splice these descriptors
+                            bounce(egress, left);
+                            break;
+                        }
+                        throw SYSTEM_ERROR("splice() failure: sock=" +
+                                std::to_string(sd));
+                    }
+                    if (n == 0)
+                        throw SYSTEM_ERROR("Connection closed mid-record: "
+                                "sock=" + std::to_string(sd) + ", left=" +
+                                std::to_string(left));
+                    left -= n;
+                    size_t inPipe = n;
+                    while (inPipe > 0) {
+                        const ssize_t sent = ::splice(pipeFds[0], nullptr,
+                                egress.sd, nullptr, inPipe,
+                                SPLICE_F_MOVE | (left ? SPLICE_F_MORE : 0));
+                        if (sent < 0) {
+                            if (errno == EINTR)
+                                continue;
+                            throw SYSTEM_ERROR("splice() failure: sock=" +
+                                    std::to_string(egress.sd));
+                        }
+                        inPipe -= sent;
+                    }
+                }
+            }
+            catch (const std::exception& ex) {
+                ::close(pipeFds[0]);
+                ::close(pipeFds[1]);
+                throw;
+            }
+            ::close(pipeFds[0]);
+            ::close(pipeFds[1]);
+        }
+        haveCurrMsg = false;
+        return payload;
+    }
+
+    bool hasMessage()
+    {
+        std::lock_guard<std::mutex> lock{readMutex};
+        return haveCurrMsg;
+    }
+
+    void discard()
+    {
+        std::lock_guard<std::mutex> lock{readMutex};
+        if (haveCurrMsg)
+            drain();
+    }
+
+    std::string to_string() const
+    {
+        return std::string("SocketImpl{sd=") + std::to_string(sd) +
+                ", numStreams=" + std::to_string(numStreams) + "}";
+    }
+};
+
+/******************************************************************************/
+
+TcpSock::TcpSock()
+    : pImpl{}
+{}
+
+TcpSock::TcpSock(const int numStreams)
+    : pImpl{new Impl(numStreams)}
+{}
+
+TcpSock::TcpSock(
+        const int              sd,
+        const struct sockaddr& addr,
+        const int              numStreams)
+    : pImpl{new Impl(sd, addr, numStreams)}
+{}
+
+TcpSock& TcpSock::connect(const InetSockAddr& addr)
+{
+    pImpl->connect(addr);
+    return *this;
+}
+
+TcpSock& TcpSock::setSrcAddr(const InetAddr& srcAddr)
+{
+    pImpl->setSrcAddr(srcAddr);
+    return *this;
+}
+
+InetSockAddr TcpSock::getRemoteAddr() const
+{
+    return pImpl->getRemoteAddr();
+}
+
+uint16_t TcpSock::getNumStreams() const
+{
+    return pImpl->getNumStreams();
+}
+
+int TcpSock::getSock() const noexcept
+{
+    return pImpl ? pImpl->getSock() : -1;
+}
+
+void TcpSock::send(
+        const unsigned streamId,
+        const void*    msg,
+        const size_t   len) const
+{
+    pImpl->send(streamId, msg, len);
+}
+
+void TcpSock::sendv(
+        const unsigned streamId,
+        struct iovec*  iovec,
+        const int      iovcnt) const
+{
+    pImpl->sendv(streamId, iovec, iovcnt);
+}
+
+unsigned TcpSock::getStreamId() const
+{
+    return pImpl->getStreamId();
+}
+
+uint32_t TcpSock::getSize() const
+{
+    return pImpl->getSize();
+}
+
+void TcpSock::recv(
+        void*        msg,
+        const size_t len,
+        const int    flags) const
+{
+    pImpl->recv(msg, len, flags);
+}
+
+size_t TcpSock::recvv(
+        const struct iovec* iovec,
+        const int           iovcnt,
+        const int           flags) const
+{
+    return pImpl->recvv(iovec, iovcnt, flags);
+}
+
+size_t TcpSock::forward(
+        const TcpSock& egress,
+        const unsigned streamId) const
+{
+    return pImpl->forward(*egress.pImpl, streamId);
+}
+
+bool TcpSock::hasMessage() const
+{
+    return pImpl->hasMessage();
+}
+
+void TcpSock::discard() const
+{
+    pImpl->discard();
+}
+
+bool TcpSock::operator==(const TcpSock& that) const noexcept
+{
+    return pImpl.get() == that.pImpl.get();
+}
+
+std::string TcpSock::to_string() const
+{
+    return pImpl ? pImpl->to_string() : "SocketImpl{sd=-1}";
+}
+
+/******************************************************************************/
+
+class SrvrTcpSock::Impl final
+{
+    InetSockAddr srvrAddr;
+    int          sd;
+    const int    numStreams;
+    bool         isListening;
+
+public:
+    /**
+     * Constructs. The socket is bound to the Internet socket address.
+     * @param[in] addr        Internet socket address on which to listen
+     * @param[in] numStreams  Number of logical streams
+     * @throw InvalidArgument  `numStreams <= 0`
+     * @throw SystemError      Socket couldn't be created or bound
+     */
+    Impl(   const InetSockAddr& addr,
+            const int           numStreams)
+        : srvrAddr{addr}
+        , sd{-1}
+        , numStreams{numStreams}
+        , isListening{false}
+    {
+        if (numStreams <= 0)
+            throw INVALID_ARGUMENT("Invalid number of streams: " +
+                    std::to_string(numStreams));
+        sd = addr.getSocket(SOCK_STREAM);
+        try {
+            const int enable = 1;
+            if (::setsockopt(sd, SOL_SOCKET, SO_REUSEADDR, &enable,
+                    sizeof(enable)))
+                throw SYSTEM_ERROR("setsockopt() failure: Couldn't reuse "
+                        "address: sock=" + std::to_string(sd));
+            addr.bind(sd);
+        }
+        catch (const std::exception& ex) {
+            ::close(sd);
+            std::throw_with_nested(RUNTIME_ERROR("Couldn't construct "
+                    "server-side TCP socket on " + addr.to_string()));
+        }
+    }
+
+    /// Prevents copy and move construction and assignment
+    Impl(const Impl& impl) =delete;
+    Impl& operator=(const Impl& rhs) =delete;
+
+    ~Impl() noexcept
+    {
+        if (sd >= 0)
+            ::close(sd);
+    }
+
+    int getSock() const noexcept
+    {
+        return sd;
+    }
+
+    void listen(const int queueSize)
+    {
+        if (isListening)
+            throw LOGIC_ERROR("Socket is already listening: sock=" +
+                    std::to_string(sd));
+        if (::listen(sd, queueSize))
+            throw SYSTEM_ERROR("listen() failure: sock=" + std::to_string(sd));
+        isListening = true;
+    }
+
+    /**
+     * Accepts an incoming connection. This is a cancellation point.
+     * @return             The accepted connection
+     * @throw SystemError  `accept()` failure
+     */
+    TcpSock accept()
+    {
+        if (!isListening)
+            listen(5);
+        struct sockaddr addr = {};
+        socklen_t       len = sizeof(addr);
+        const int       newSd = ::accept(sd, &addr, &len);
+        if (newSd < 0)
+            throw SYSTEM_ERROR("accept() failure: sd=" + std::to_string(sd));
+        try {
+            return TcpSock{newSd, addr, numStreams};
+        }
+        catch (const std::exception& ex) {
+            ::close(newSd);
+            throw;
+        }
+    }
+};
+
+SrvrTcpSock::SrvrTcpSock()
+    : pImpl{}
+{}
+
+SrvrTcpSock::SrvrTcpSock(
+        const InetSockAddr& addr,
+        const int           numStreams)
+    : pImpl{new Impl(addr, numStreams)}
+{}
+
+int SrvrTcpSock::getSock() const noexcept
+{
+    return pImpl ? pImpl->getSock() : -1;
+}
+
+void SrvrTcpSock::listen(const int queueSize) const
+{
+    pImpl->listen(queueSize);
+}
+
+TcpSock SrvrTcpSock::accept() const
+{
+    return pImpl->accept();
+}
+
+} // namespace
@@ -0,0 +1,308 @@
+/**
+ * This file declares handle classes for TCP sockets that carry the same
+ * multi-stream message protocol as the SCTP sockets.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: TcpSock.h
+ * @author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_NET_TCPSOCK_H_
+#define MAIN_NET_TCPSOCK_H_
+
+#include "InetSockAddr.h"
+
+#include <memory>
+
+namespace hycast {
+
+/**
+ * An established TCP socket that preserves message boundaries. Each message
+ * is preceded by an 8-byte record header -- payload length and logical
+ * stream number in network byte order -- so the multi-stream message
+ * protocol of an SCTP socket survives TCP's byte-stream semantics. Because
+ * the transport is plain TCP, bulk payloads ride the NIC's segmentation-
+ * offload paths (TSO/GRO) and traverse middleboxes that block SCTP. Unlike
+ * SCTP streams, however, the logical streams share one ordered byte-stream:
+ * a large message delays the messages behind it.
+ */
+class TcpSock final
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Default constructs.
+     */
+    TcpSock();
+
+    /**
+     * Constructs a TCP socket from the client side. The caller must
+     * eventually call `connect()` to establish a connection.
+     * @param[in] numStreams   Number of logical streams
+     * @throw InvalidArgument  `numStreams <= 0`
+     * @see `connect(const InetSockAddr& addr)`
+     */
+    explicit TcpSock(const int numStreams);
+
+    /**
+     * Constructs a TCP socket from the server side.
+     * @param[in] sd          TCP socket descriptor from `accept()`
+     * @param[in] addr        Address of remote TCP socket
+     * @param[in] numStreams  Number of logical streams
+     * @throws SystemError    Socket couldn't be configured
+     */
+    TcpSock(
+            const int              sd,
+            const struct sockaddr& addr,
+            const int              numStreams);
+
+    /**
+     * Connects to a server. Blocks until the connection is established.
+     * @param[in] addr      Internet socket address of the server
+     * @return              This instance
+     * @throws SystemError  Connection failure
+     * @exceptionsafety     Strong
+     * @threadsafety        Safe
+     */
+    TcpSock& connect(const InetSockAddr& addr);
+
+    /**
+     * Sets the local source address. The connection will be bound to the
+     * address with an ephemeral port so it uses a particular interface (e.g.,
+     * one picked from an `InterfaceSet`) instead of the one the routing table
+     * prefers. Must be called before `connect()`.
+     * @param[in] srcAddr  Internet address of source interface
+     * @return             This instance
+     * @throws LogicError  Socket is already connected
+     * @exceptionsafety    Strong
+     * @threadsafety       Safe
+     * @see `connect(const InetSockAddr& addr)`
+     */
+    TcpSock& setSrcAddr(const InetAddr& srcAddr);
+
+    /**
+     * Returns the Internet socket address of the remote end.
+     * @return Internet socket address of the remote end
+     */
+    InetSockAddr getRemoteAddr() const;
+
+    /**
+     * Returns the number of logical streams.
+     * @return the number of logical streams
+     */
+    uint16_t getNumStreams() const;
+
+    /**
+     * Returns the socket descriptor.
+     * @return socket descriptor
+     * @exceptionsafety Strong guarantee
+     * @threadsafety    Safe
+     */
+    int getSock() const noexcept;
+
+    /**
+     * Sends a message.
+     * @param[in] streamId  Logical stream number
+     * @param[in] msg       Message to be sent
+     * @param[in] len       Size of message in bytes
+     * @throws std::system_error if an I/O error occurred
+     * @exceptionsafety Basic
+     * @threadsafety    Safe
+     */
+    void send(
+            const unsigned streamId,
+            const void*    msg,
+            const size_t   len) const;
+
+    /**
+     * Sends a message. This is a cancellation point.
+     * @param[in] streamId  Logical stream number
+     * @param[in] iovec     Vector comprising message to send
+     * @param[in] iovcnt    Number of elements in `iovec`
+     */
+    void sendv(
+            const unsigned streamId,
+            struct iovec*  iovec,
+            const int      iovcnt) const;
+
+    /**
+     * Returns the logical stream number of the current message. Waits for the
+     * message if necessary. The message's payload is left in the socket's
+     * input buffer.
+     * @returns Logical stream number
+     * @throws std::system_error if an I/O error occurs
+     * @exceptionsafety Basic
+     */
+    unsigned getStreamId() const;
+
+    /**
+     * Returns the size, in bytes, of the current message. Waits for the
+     * message if necessary. The message's payload is left in the socket's
+     * input buffer.
+     * @returns Size of message in bytes. Will equal 0 when socket is closed by
+     *          remote peer.
+     * @throws std::system_error if an I/O error occurs
+     * @exceptionsafety Basic
+     */
+    uint32_t getSize() const;
+
+    /**
+     * Receives a message. Unless peeking, the entire message is consumed:
+     * payload bytes beyond the requested number are discarded so the
+     * byte-stream stays aligned on record boundaries.
+     * @param[out] msg     Receive buffer
+     * @param[in]  len     Size of receive buffer in bytes
+     * @param[in]  flags   Type of message reception. Logical OR of zero or
+     *                     more of
+     *                       - `MSG_PEEK` Peeks at the incoming message
+     * @throws std::system_error on I/O failure
+     */
+    void recv(
+            void*        msg,
+            const size_t len,
+            const int    flags = 0) const;
+
+    /**
+     * Receives a message. Unless peeking, the entire message is consumed:
+     * payload bytes beyond the requested number are discarded so the
+     * byte-stream stays aligned on record boundaries.
+     * @param[in] iovec     Vector comprising message to receive
+     * @param[in] iovcnt    Number of elements in `iovec`
+     * @param[in] flags     Type of message reception. Logical OR of zero or
+     *                      more of
+     *                      - `MSG_PEEK` Peeks at the incoming message
+     * @return              Number of bytes actually read
+     * @throws std::system_error if an I/O error occurs
+     * @exceptionsafety Basic
+     * @threadsafety Safe
+     */
+    size_t recvv(
+            const struct iovec* iovec,
+            const int           iovcnt,
+            const int           flags = 0) const;
+
+    /**
+     * Forwards the payload of the current message to another TCP socket
+     * without copying it through userspace: once the record header has been
+     * read, the payload bytes are moved from this socket to the egress
+     * socket by the kernel (`splice(2)` through a pipe). Intended for relay
+     * nodes, whose chunk payloads depart byte-for-byte as they arrived:
+     * forwarding then costs no payload memory-bandwidth at all. Falls back
+     * to a bounce-buffer copy if the kernel can't splice the descriptors.
+     * The message is consumed.
+     * @param[in] egress    Socket to forward the payload to
+     * @param[in] streamId  Logical stream number on the egress socket
+     * @retval 0            Connection was closed by the remote end
+     * @return              Number of payload bytes forwarded
+     * @throws InvalidArgument   Invalid egress stream number
+     * @throws std::system_error I/O failure on either socket
+     * @exceptionsafety Basic
+     * @threadsafety    Safe
+     */
+    size_t forward(
+            const TcpSock& egress,
+            const unsigned streamId) const;
+
+    /**
+     * Indicates if this instance has a current message.
+     * @retval true   Yes
+     * @retval false  No
+     */
+    bool hasMessage() const;
+
+    /**
+     * Discards the current message.
+     * @exceptionsafety Basic guarantee
+     * @threadsafety    Thread-compatible but not thread-safe
+     */
+    void discard() const;
+
+    /**
+     * Indicates if this instance equals another.
+     * @param[in] that  Other instance
+     * @retval `true`   This instance equals the other
+     * @retval `false`  This instance doesn't equal the other
+     * @exceptionsafety Nothrow
+     */
+    bool operator==(const TcpSock& that) const noexcept;
+
+    /**
+     * Returns a string representation of this instance's socket.
+     * @return String representation of this instance's socket
+     * @throws std::bad_alloc if required memory can't be allocated
+     * @exceptionsafety Strong
+     * @threadsafety    Safe
+     */
+    std::string to_string() const;
+};
+
+/******************************************************************************/
+
+/**
+ * Server-side TCP socket. One that listens for incoming connection attempts.
+ */
+class SrvrTcpSock final
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Default constructs. On return
+     * - `getSock()` will return `-1`
+     * - `accept()` will throw an exception
+     */
+    SrvrTcpSock();
+
+    /**
+     * Constructs. The socket is bound to the Internet socket address but
+     * `listen()` is not called to allow certain options to be set (e.g.,
+     * buffer sizes).
+     * @param[in] addr        Internet socket address on which to listen
+     * @param[in] numStreams  Number of logical streams
+     * @throw RuntimeError    Couldn't construct server-side TCP socket
+     * @see   `listen()`
+     */
+    SrvrTcpSock(
+            const InetSockAddr& addr,
+            const int           numStreams = 1);
+
+    /**
+     * Returns the socket descriptor.
+     * @return socket descriptor
+     * @exceptionsafety Strong guarantee
+     * @threadsafety    Safe
+     */
+    int getSock() const noexcept;
+
+    /**
+     * Configures the socket for accepting incoming connection attempts.
+     * @param[in] queueSize  Size of the backlog queue
+     * @throw LogicError     Socket already configured for listening
+     * @throw SystemError    `::listen()` failure
+     */
+    void listen(const int queueSize = 5) const;
+
+    /**
+     * Accepts an incoming connection on the socket.
+     * @return          The accepted connection
+     * @exceptionsafety Basic guarantee
+     * @threadsafety    Thread-compatible but not thread-safe
+     */
+    TcpSock accept() const;
+};
+
+} // namespace
+
+namespace std {
+    inline string to_string(const hycast::TcpSock& sock) {
+        return sock.to_string();
+    }
+}
+
+#endif /* MAIN_NET_TCPSOCK_H_ */
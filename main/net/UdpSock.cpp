@@ -11,16 +11,36 @@
 #include "config.h"
 
 #include "error.h"
+#include "Metrics.h"
+#include "NetEmulator.h"
 #include "Thread.h"
 #include "UdpSock.h"
 
+#include <atomic>
 #include <cerrno>
+#include <chrono>
+#include <cstring>
 #include <iostream>
+#ifdef USE_IO_URING
+#include <liburing.h>
+#endif
+#ifdef USE_AF_XDP
+#include <cstdlib>
+#include <linux/if_ether.h>
+#include <net/if.h>
+#include <netinet/ip.h>
+#include <poll.h>
+#include <xdp/xsk.h>
+#endif
+#include <memory>
 #include <netinet/in.h>
+#include <netinet/udp.h>
+#include <queue>
 #include <sys/socket.h>
 #include <sys/uio.h>
 #include <system_error>
 #include <unistd.h>
+#include <vector>
 
 namespace hycast {
 
@@ -41,6 +61,21 @@ protected:
         : sd{inetSockAddr.getSocket(SOCK_DGRAM)}
     {}
 
+    /**
+     * Constructs from an existing socket descriptor -- e.g., one inherited
+     * from the previous process during a warm handoff.
+     * @param[in] sd           Socket descriptor. This instance assumes
+     *                         ownership.
+     * @throw InvalidArgument  `sd < 0`
+     */
+    explicit Impl(const int sd)
+        : sd{sd}
+    {
+        if (sd < 0)
+            throw INVALID_ARGUMENT("Invalid socket descriptor: " +
+                    std::to_string(sd));
+    }
+
 public:
     /**
      * Default constructs.
@@ -64,6 +99,17 @@ public:
     Impl& operator=(const Impl& impl) =delete;
     Impl& operator=(const Impl&& impl) =delete;
 
+    /**
+     * Returns the socket descriptor.
+     * @return          Socket descriptor
+     * @exceptionsafety Nothrow
+     * @threadsafety    Safe
+     */
+    int getSock() const noexcept
+    {
+        return sd;
+    }
+
     /**
      * Returns a string representation of this instance's socket.
      * @return String representation of this instance's socket
@@ -81,11 +127,601 @@ class InUdpSock::Impl : public UdpSock::Impl
 {
     UdpPayloadSize currRecSize;
 
+    unsigned                              batchSize;  /// Max datagrams per
+                                                      /// recvmmsg()
+    unsigned                              batchHead;  /// Index of current
+                                                      /// batched datagram
+    unsigned                              batchCount; /// Number of unread
+                                                      /// batched datagrams
+    std::vector<std::unique_ptr<char[]>>  batchBufs;  /// Batched datagrams
+    std::vector<UdpPayloadSize>           batchLens;  /// Batched datagram
+                                                      /// sizes
+    bool                                  gro;        /// Whether UDP generic
+                                                      /// receive offload is
+                                                      /// enabled
+    std::vector<UdpPayloadSize>           batchSegs;  /// GRO segment size of
+                                                      /// each batched receive.
+                                                      /// 0 => not coalesced
+    size_t                                segOffset;  /// Offset of the current
+                                                      /// segment in the
+                                                      /// current batched
+                                                      /// receive
+
+    /// Size of an ancillary-data buffer for the telemetry control messages
+    static const size_t                   ctrlBufSize = 128;
+
+    bool                                  telemetry;  /// Whether kernel
+                                                      /// telemetry is enabled
+    struct timespec                       lastRxTime; /// Kernel receive time
+                                                      /// of current datagram
+    unsigned long                         numDropped; /// Kernel count of
+                                                      /// dropped datagrams
+    std::unique_ptr<char[]>               ctrlBuf;    /// Ancillary data of
+                                                      /// unbatched receives
+    std::vector<std::unique_ptr<char[]>>  batchCtrls; /// Ancillary data of
+                                                      /// batched datagrams
+    std::vector<struct timespec>          batchTimes; /// Kernel receive times
+                                                      /// of batched datagrams
+    std::vector<char>                     peekBuf;    /// Staging buffer for
+                                                      /// header peeks of
+                                                      /// unbatched receives
+    NetEmulator                           emulator;   /// Emulated network
+                                                      /// conditions. Empty --
+                                                      /// a pass-through -- in
+                                                      /// production.
+    bool                                  emulDecided;/// Whether the pending
+                                                      /// peeked datagram's
+                                                      /// fate is decided
+    bool                                  emulDrop;   /// That fate
+    unsigned                              spinMicros; /// Busy-poll spin budget
+                                                      /// in microseconds. 0 =>
+                                                      /// disabled
+    std::atomic<int>                      rcvBufSize; /// Receive-buffer size
+                                                      /// last requested. 0 =>
+                                                      /// adaptive sizing is
+                                                      /// disabled
+    int                                   rcvBufCap;  /// Ceiling on adaptive
+                                                      /// growth in bytes
+    /// Exports the receive-buffer size. Deregistered on destruction, so it
+    /// must be declared after the state it samples.
+    Metrics::Gauge                        rcvBufGauge;
+#ifdef USE_IO_URING
+    struct io_uring             ring;      /// io_uring(7) instance
+    bool                        haveRing;  /// Whether `ring` is initialized
+    std::vector<struct msghdr>  ringHdrs;  /// One per in-flight receive
+    std::vector<struct iovec>   ringIovs;  /// One per in-flight receive
+    std::queue<unsigned>        readyBufs; /// Indexes of completed datagrams
+                                           /// in completion order
+#endif
+#ifdef USE_AF_XDP
+    /// A received AF_XDP frame whose UDP payload is pending delivery
+    struct XdpFrame {
+        uint64_t       addr;   /// UMEM address of the frame
+        uint32_t       payOff; /// Offset of the UDP payload in the frame
+        UdpPayloadSize payLen; /// Length of the UDP payload
+    };
+    /// Number of frames in the UMEM. Matches the default fill-ring size so
+    /// every frame can be offered to the kernel at once.
+    static const unsigned umemNumFrames = 2048;
+    bool                  xdp;       /// Whether the AF_XDP backend is active
+    struct xsk_umem*      umem;      /// Shared packet-buffer region
+    struct xsk_socket*    xsk;       /// AF_XDP socket
+    void*                 umemArea;  /// Memory backing the UMEM
+    struct xsk_ring_prod  fillRing;  /// Frames offered to the kernel
+    struct xsk_ring_cons  compRing;  /// Transmit completions (unused)
+    struct xsk_ring_cons  rxRing;    /// Received frames
+    struct xsk_ring_prod  txRing;    /// Transmit ring (unused)
+    std::queue<XdpFrame>  xdpFrames; /// Payloads awaiting delivery
+#endif
+
     void init()
     {
         currRecSize = 0;
+        batchSize = 0;
+        batchHead = 0;
+        batchCount = 0;
+        gro = false;
+        segOffset = 0;
+        telemetry = false;
+        lastRxTime = timespec{};
+        numDropped = 0;
+        emulDecided = false;
+        emulDrop = false;
+        spinMicros = 0;
+        rcvBufSize = 0;
+        rcvBufCap = 0;
+#ifdef USE_IO_URING
+        haveRing = false;
+#endif
+#ifdef USE_AF_XDP
+        xdp = false;
+        umem = nullptr;
+        xsk = nullptr;
+        umemArea = nullptr;
+#endif
+    }
+
+    /**
+     * Sets the size of the receive buffer. `SO_RCVBUF` is silently limited
+     * by the `net.core.rmem_max` sysctl, so `SO_RCVBUFFORCE` -- which isn't
+     * -- is tried first; it needs `CAP_NET_ADMIN`, however, so failure falls
+     * back to the limited option.
+     * @param[in] size      Receive-buffer size in bytes
+     * @throws SystemError  `setsockopt()` failure
+     */
+    void setRcvBufSize(const int size)
+    {
+#ifdef SO_RCVBUFFORCE
+        if (::setsockopt(sd, SOL_SOCKET, SO_RCVBUFFORCE, &size,
+                sizeof(size)) == 0) {
+            rcvBufSize = size;
+            return;
+        }
+#endif
+        if (::setsockopt(sd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size)))
+            throw SYSTEM_ERROR("Couldn't set receive-buffer size: sock=" +
+                    std::to_string(sd) + ", size=" + std::to_string(size));
+        rcvBufSize = size;
+    }
+
+    /**
+     * Doubles the receive buffer -- up to the configured ceiling -- because
+     * the kernel dropped datagrams it couldn't buffer. Called from the
+     * receive path, so a failure is logged rather than thrown.
+     */
+    void growRcvBuf() noexcept
+    {
+        const int oldSize = rcvBufSize;
+        if (oldSize >= rcvBufCap)
+            return; // Already at the ceiling
+        const int newSize = (oldSize > rcvBufCap/2)
+                ? rcvBufCap
+                : 2*oldSize;
+        try {
+            setRcvBufSize(newSize);
+            LOG_NOTE("Kernel dropped datagrams: grew receive buffer from " +
+                    std::to_string(oldSize) + " to " + std::to_string(newSize) +
+                    " bytes: sock=" + std::to_string(sd));
+        }
+        catch (const std::exception& e) {
+            log_warn(e);
+        }
+    }
+
+    /**
+     * Extracts the kernel receive timestamp and the kernel drop-count from
+     * the ancillary data of a received datagram. Does nothing if telemetry
+     * isn't enabled.
+     * @param[in]  msghdr  Message header of the received datagram
+     * @param[out] when    Kernel receive timestamp. Unmodified if absent.
+     */
+    void parseTelemetry(
+            const struct msghdr& msghdr,
+            struct timespec&     when) noexcept
+    {
+        auto hdr = const_cast<struct msghdr*>(&msghdr);
+        for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(hdr); cmsg != nullptr;
+                cmsg = CMSG_NXTHDR(hdr, cmsg)) {
+            if (cmsg->cmsg_level != SOL_SOCKET)
+                continue;
+            if (cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+                ::memcpy(&when, CMSG_DATA(cmsg), sizeof(when));
+            }
+            else if (cmsg->cmsg_type == SO_RXQ_OVFL) {
+                // Cumulative count of datagrams this socket couldn't buffer
+                uint32_t ovfl;
+                ::memcpy(&ovfl, CMSG_DATA(cmsg), sizeof(ovfl));
+                if (ovfl != numDropped && rcvBufSize)
+                    growRcvBuf();
+                numDropped = ovfl;
+            }
+        }
+    }
+
+    /**
+     * Extracts the generic-receive-offload segment size from the ancillary
+     * data of a received datagram.
+     * @param[in] msghdr  Message header of the received datagram
+     * @return            Size of the segments the kernel coalesced into the
+     *                    datagram or 0 if the datagram wasn't coalesced
+     */
+    static UdpPayloadSize parseGroSegSize(const struct msghdr& msghdr) noexcept
+    {
+#ifdef UDP_GRO
+        auto hdr = const_cast<struct msghdr*>(&msghdr);
+        for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(hdr); cmsg != nullptr;
+                cmsg = CMSG_NXTHDR(hdr, cmsg)) {
+            if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+                uint16_t segSize;
+                ::memcpy(&segSize, CMSG_DATA(cmsg), sizeof(segSize));
+                return segSize;
+            }
+        }
+#endif
+        return 0;
+    }
+
+    /**
+     * Returns the length of the current segment of a batched receive: the
+     * whole remaining datagram unless the kernel coalesced a train of
+     * datagrams into it, in which case the aggregate is served one original
+     * datagram at a time.
+     * @param[in] buf  Index of the batch buffer
+     * @return         Length of the current segment
+     */
+    inline UdpPayloadSize currSegLen(const unsigned buf) const noexcept
+    {
+        const size_t         remaining = batchLens[buf] - segOffset;
+        const UdpPayloadSize segSize = batchSegs[buf];
+        return (segSize != 0 && segSize < remaining)
+                ? segSize
+                : static_cast<UdpPayloadSize>(remaining);
+    }
+
+    /**
+     * Consumes the current segment of a batched receive.
+     * @param[in] buf     Index of the batch buffer
+     * @param[in] seglen  Length of the segment
+     * @retval `true`     The buffer is exhausted and should be recycled
+     * @retval `false`    The buffer holds further segments
+     */
+    inline bool consumeSeg(
+            const unsigned       buf,
+            const UdpPayloadSize seglen) noexcept
+    {
+        segOffset += seglen;
+        if (segOffset < batchLens[buf])
+            return false;
+        segOffset = 0;
+        return true;
+    }
+
+    /**
+     * Spins until a datagram is pending or the spin budget expires. Called
+     * before a blocking receive when busy-polling is enabled: a datagram that
+     * arrives during the spin is noticed without a scheduler wakeup, whose
+     * latency would otherwise dominate. Does nothing if busy-polling is
+     * disabled.
+     * @retval true   A datagram is pending -- or the socket has failed, in
+     *                which case the consuming receive reports the error
+     * @retval false  Busy-polling is disabled or the budget expired
+     */
+    bool spinForInput() noexcept
+    {
+        if (spinMicros == 0)
+            return false;
+        const auto deadline = std::chrono::steady_clock::now() +
+                std::chrono::microseconds{spinMicros};
+        char byte;
+        do {
+            if (::recv(sd, &byte, sizeof(byte), MSG_PEEK | MSG_DONTWAIT) >= 0)
+                return true;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                return true;
+        } while (std::chrono::steady_clock::now() < deadline);
+        return false;
+    }
+
+    /**
+     * Refills the user-space batch with one recvmmsg() system call. Waits for
+     * a datagram if necessary.
+     * @pre                 `batchCount == 0`
+     * @throws SystemError  I/O error reading from socket
+     */
+    void refillBatch()
+    {
+        spinForInput(); // If it succeeds, the following read won't block
+        std::vector<struct mmsghdr> msgs(batchSize);
+        std::vector<struct iovec>   iovs(batchSize);
+        for (unsigned i = 0; i < batchSize; ++i) {
+            iovs[i].iov_base = batchBufs[i].get();
+            iovs[i].iov_len = maxPayload;
+            msgs[i] = mmsghdr{};
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            if (telemetry || gro) {
+                msgs[i].msg_hdr.msg_control = batchCtrls[i].get();
+                msgs[i].msg_hdr.msg_controllen = ctrlBufSize;
+            }
+        }
+        int nmsgs;
+        {
+            Canceler canceler{};
+            nmsgs = ::recvmmsg(sd, msgs.data(), batchSize,
+                    MSG_WAITFORONE, nullptr);
+        }
+        if (nmsgs < 0)
+            throw SYSTEM_ERROR(std::string{"recvmmsg() failure: sock="} +
+                    std::to_string(sd));
+        batchHead = 0;
+        batchCount = nmsgs;
+        for (int i = 0; i < nmsgs; ++i) {
+            batchLens[i] = msgs[i].msg_len;
+            batchSegs[i] = gro ? parseGroSegSize(msgs[i].msg_hdr) : 0;
+            if (telemetry) {
+                batchTimes[i] = timespec{};
+                parseTelemetry(msgs[i].msg_hdr, batchTimes[i]);
+            }
+        }
+    }
+
+    /**
+     * Scatter-receives a datagram from the user-space batch, refilling the
+     * batch with one recvmmsg() system call if it's empty.
+     * @param[in] iovec     Scatter-read vector
+     * @param[in] iovcnt    Number of elements in scatter-read vector
+     * @param[in] peek      Whether or not to peek at the datagram
+     * @return              Actual number of bytes read into the buffers
+     * @throws SystemError  I/O error reading from socket
+     */
+    UdpPayloadSize batchRecv(
+           const struct iovec* iovec,
+           const int           iovcnt,
+           const bool          peek)
+    {
+        if (batchCount == 0)
+            refillBatch();
+        if (telemetry)
+            lastRxTime = batchTimes[batchHead];
+        const char*          src = batchBufs[batchHead].get() + segOffset;
+        const UdpPayloadSize len = currSegLen(batchHead);
+        size_t               left = len;
+        for (int i = 0; left > 0 && i < iovcnt; ++i) {
+            const size_t nbytes = iovec[i].iov_len > left
+                    ? left : iovec[i].iov_len;
+            ::memcpy(iovec[i].iov_base, src, nbytes);
+            src += nbytes;
+            left -= nbytes;
+        }
+        const UdpPayloadSize nbytes = len - left;
+        if (peek) {
+            currRecSize = nbytes;
+        }
+        else {
+            if (consumeSeg(batchHead, len)) {
+                ++batchHead;
+                --batchCount;
+            }
+            currRecSize = 0;
+        }
+        return nbytes;
+    }
+
+#ifdef USE_IO_URING
+    /**
+     * Stages an asynchronous receive into a batch buffer. The submission-queue
+     * entry isn't submitted to the kernel until the next
+     * `io_uring_submit_and_wait()` -- so consuming a batch of datagrams costs
+     * one system call rather than one per datagram.
+     * @param[in] i  Index of batch buffer
+     * @throws RuntimeError  Submission queue is full
+     */
+    void submitRecv(const unsigned i)
+    {
+        ringIovs[i].iov_base = batchBufs[i].get();
+        ringIovs[i].iov_len = maxPayload;
+        ringHdrs[i] = msghdr{};
+        ringHdrs[i].msg_iov = &ringIovs[i];
+        ringHdrs[i].msg_iovlen = 1;
+        if (telemetry || gro) {
+            ringHdrs[i].msg_control = batchCtrls[i].get();
+            ringHdrs[i].msg_controllen = ctrlBufSize;
+        }
+        struct io_uring_sqe* sqe = ::io_uring_get_sqe(&ring);
+        if (sqe == nullptr)
+            throw RUNTIME_ERROR(std::string{"io_uring submission-queue is "
+                    "full: sock="} + std::to_string(sd));
+        ::io_uring_prep_recvmsg(sqe, sd, &ringHdrs[i], 0);
+        ::io_uring_sqe_set_data(sqe,
+                reinterpret_cast<void*>(static_cast<uintptr_t>(i)));
+    }
+
+    /**
+     * Submits any staged receives, waits for at least one to complete, and
+     * moves every completed datagram onto the ready queue.
+     * @throws SystemError  Submission or asynchronous `recvmsg()` failure
+     */
+    void reapCompletions()
+    {
+        spinForInput(); // If it succeeds, the following wait will be brief
+        int status;
+        {
+            Canceler canceler{};
+            status = ::io_uring_submit_and_wait(&ring, 1);
+        }
+        if (status < 0)
+            throw SYSTEM_ERROR(std::string{"io_uring_submit_and_wait() "
+                    "failure: sock="} + std::to_string(sd), -status);
+        struct io_uring_cqe* cqe;
+        while (::io_uring_peek_cqe(&ring, &cqe) == 0) {
+            const unsigned i = static_cast<unsigned>(
+                    reinterpret_cast<uintptr_t>(::io_uring_cqe_get_data(cqe)));
+            const int      res = cqe->res;
+            ::io_uring_cqe_seen(&ring, cqe);
+            if (res < 0)
+                throw SYSTEM_ERROR(std::string{"Asynchronous recvmsg() "
+                        "failure: sock="} + std::to_string(sd), -res);
+            batchLens[i] = res;
+            batchSegs[i] = gro ? parseGroSegSize(ringHdrs[i]) : 0;
+            if (telemetry) {
+                batchTimes[i] = timespec{};
+                parseTelemetry(ringHdrs[i], batchTimes[i]);
+            }
+            readyBufs.push(i);
+        }
     }
 
+    /**
+     * Scatter-receives a datagram from the completion queue. Every batch
+     * buffer has an asynchronous receive outstanding; this blocks only if none
+     * has yet completed.
+     * @param[in] iovec     Scatter-read vector
+     * @param[in] iovcnt    Number of elements in scatter-read vector
+     * @param[in] peek      Whether or not to peek at the datagram
+     * @return              Actual number of bytes read into the buffers
+     * @throws SystemError  I/O error reading from socket
+     */
+    UdpPayloadSize ringRecv(
+           const struct iovec* iovec,
+           const int           iovcnt,
+           const bool          peek)
+    {
+        while (readyBufs.empty())
+            reapCompletions();
+        const unsigned       buf = readyBufs.front();
+        if (telemetry)
+            lastRxTime = batchTimes[buf];
+        const char*          src = batchBufs[buf].get() + segOffset;
+        const UdpPayloadSize len = currSegLen(buf);
+        size_t               left = len;
+        for (int i = 0; left > 0 && i < iovcnt; ++i) {
+            const size_t nbytes = iovec[i].iov_len > left
+                    ? left : iovec[i].iov_len;
+            ::memcpy(iovec[i].iov_base, src, nbytes);
+            src += nbytes;
+            left -= nbytes;
+        }
+        const UdpPayloadSize nbytes = len - left;
+        if (peek) {
+            currRecSize = nbytes;
+        }
+        else {
+            if (consumeSeg(buf, len)) {
+                readyBufs.pop();
+                submitRecv(buf); // Re-arms the buffer
+            }
+            currRecSize = 0;
+        }
+        return nbytes;
+    }
+#endif
+
+#ifdef USE_AF_XDP
+    /**
+     * Returns a consumed frame to the fill ring so the kernel can receive
+     * into it again.
+     * @param[in] addr  UMEM address of the frame
+     */
+    void recycleFrame(const uint64_t addr) noexcept
+    {
+        uint32_t idx;
+        /*
+         * Can't fail: the fill ring holds as many slots as the UMEM holds
+         * frames, so a slot is always free for a frame being returned
+         */
+        ::xsk_ring_prod__reserve(&fillRing, 1, &idx);
+        *::xsk_ring_prod__fill_addr(&fillRing, idx) = addr;
+        ::xsk_ring_prod__submit(&fillRing, 1);
+    }
+
+    /**
+     * Waits for received frames, validates each one as a UDP datagram for
+     * this socket's port, and queues the payloads for delivery. The XDP
+     * program redirects whole Ethernet frames, so the protocol headers are
+     * parsed here; frames that aren't for this socket -- other protocols or
+     * other ports sharing the NIC queue -- are returned to the kernel
+     * immediately.
+     * @throws SystemError  `poll()` failure
+     */
+    void fillXdpQueue()
+    {
+        while (xdpFrames.empty()) {
+            uint32_t idx;
+            uint32_t avail = ::xsk_ring_cons__peek(&rxRing, umemNumFrames,
+                    &idx);
+            if (avail == 0) {
+                struct pollfd pollfd;
+                pollfd.fd = ::xsk_socket__fd(xsk);
+                pollfd.events = POLLIN;
+                int status;
+                {
+                    Canceler canceler{};
+                    status = ::poll(&pollfd, 1, -1);
+                }
+                if (status < 0)
+                    throw SYSTEM_ERROR(std::string{"poll() failure on AF_XDP "
+                            "socket: sock="} + std::to_string(sd));
+                continue;
+            }
+            const in_port_t localPort = localSockAddr.getPort().get_network();
+            for (uint32_t i = 0; i < avail; ++i, ++idx) {
+                const struct xdp_desc* desc =
+                        ::xsk_ring_cons__rx_desc(&rxRing, idx);
+                const char* frame = static_cast<const char*>(
+                        ::xsk_umem__get_data(umemArea, desc->addr));
+                const struct ethhdr* eth =
+                        reinterpret_cast<const struct ethhdr*>(frame);
+                if (desc->len < sizeof(*eth) ||
+                        eth->h_proto != htons(ETH_P_IP)) {
+                    recycleFrame(desc->addr);
+                    continue;
+                }
+                const struct iphdr* ip = reinterpret_cast<const struct iphdr*>(
+                        frame + sizeof(*eth));
+                const uint32_t ipHdrLen = ip->ihl*4u;
+                if (ip->protocol != IPPROTO_UDP ||
+                        desc->len < sizeof(*eth) + ipHdrLen + sizeof(udphdr)) {
+                    recycleFrame(desc->addr);
+                    continue;
+                }
+                const struct udphdr* udp =
+                        reinterpret_cast<const struct udphdr*>(
+                                frame + sizeof(*eth) + ipHdrLen);
+                if (udp->dest != localPort) {
+                    recycleFrame(desc->addr);
+                    continue;
+                }
+                XdpFrame xdpFrame;
+                xdpFrame.addr = desc->addr;
+                xdpFrame.payOff = sizeof(*eth) + ipHdrLen + sizeof(*udp);
+                xdpFrame.payLen = ntohs(udp->len) - sizeof(*udp);
+                xdpFrames.push(xdpFrame);
+            }
+            ::xsk_ring_cons__release(&rxRing, avail);
+        }
+    }
+
+    /**
+     * Scatter-receives a datagram from the AF_XDP receive ring. The payload
+     * is copied straight from the UMEM frame the NIC wrote; the kernel UDP
+     * stack never touches the packet.
+     * @param[in] iovec     Scatter-read vector
+     * @param[in] iovcnt    Number of elements in scatter-read vector
+     * @param[in] peek      Whether or not to peek at the datagram
+     * @return              Actual number of bytes read into the buffers
+     * @throws SystemError  I/O error reading from socket
+     */
+    UdpPayloadSize xdpRecv(
+           const struct iovec* iovec,
+           const int           iovcnt,
+           const bool          peek)
+    {
+        fillXdpQueue();
+        const XdpFrame&      frame = xdpFrames.front();
+        const char*          src = static_cast<const char*>(
+                ::xsk_umem__get_data(umemArea, frame.addr)) + frame.payOff;
+        const UdpPayloadSize len = frame.payLen;
+        size_t               left = len;
+        for (int i = 0; left > 0 && i < iovcnt; ++i) {
+            const size_t nbytes = iovec[i].iov_len > left
+                    ? left : iovec[i].iov_len;
+            ::memcpy(iovec[i].iov_base, src, nbytes);
+            src += nbytes;
+            left -= nbytes;
+        }
+        const UdpPayloadSize nbytes = len - left;
+        if (peek) {
+            currRecSize = nbytes;
+        }
+        else {
+            recycleFrame(frame.addr);
+            xdpFrames.pop();
+            currRecSize = 0;
+        }
+        return nbytes;
+    }
+#endif
+
     /**
      * Allows multiple sockets to use the same port number for incoming packets
      * @throws std::system_error  setsockopt() failure
@@ -150,9 +786,47 @@ public:
     }
 
     /**
-     * Destroys.
+     * Constructs from an existing socket descriptor -- e.g., one inherited
+     * from the previous process during a warm handoff. The socket keeps its
+     * bound address and queued datagrams; the local socket address is
+     * recovered from the kernel.
+     * @param[in] sd           Bound socket descriptor. This instance assumes
+     *                         ownership.
+     * @throw InvalidArgument  `sd < 0`
+     * @throw SystemError      Couldn't get local socket address
+     */
+    explicit Impl(const int sd)
+        : UdpSock::Impl{sd}
+        , localSockAddr{}
+    {
+        init();
+        struct sockaddr_storage storage = {};
+        socklen_t               len = sizeof(storage);
+        if (::getsockname(sd, reinterpret_cast<struct sockaddr*>(&storage),
+                &len))
+            throw SYSTEM_ERROR("Couldn't get local address of socket " +
+                    std::to_string(sd));
+        localSockAddr = InetSockAddr{
+                *reinterpret_cast<struct sockaddr*>(&storage)};
+    }
+
+    /**
+     * Destroys. Cancels any outstanding asynchronous receives.
      */
-    virtual ~Impl() noexcept =default;
+    virtual ~Impl() noexcept
+    {
+#ifdef USE_IO_URING
+        if (haveRing)
+            ::io_uring_queue_exit(&ring);
+#endif
+#ifdef USE_AF_XDP
+        if (xsk)
+            ::xsk_socket__delete(xsk);
+        if (umem)
+            ::xsk_umem__delete(umem);
+        ::free(umemArea);
+#endif
+    }
 
     virtual std::string to_string() const
     {
@@ -189,22 +863,65 @@ public:
            const int           iovcnt,
            const bool          peek = false)
     {
-        struct msghdr msghdr = {};
-        msghdr.msg_iov = const_cast<struct iovec*>(iovec);
-        msghdr.msg_iovlen = iovcnt;
-        ssize_t nbytes;
-        {
-            Canceler canceler{};
-            nbytes = ::recvmsg(sd, &msghdr, peek ? MSG_PEEK : 0);
+#ifdef USE_AF_XDP
+        if (xdp)
+            return xdpRecv(iovec, iovcnt, peek);
+#endif
+        if (batchSize) {
+#ifdef USE_IO_URING
+            return ringRecv(iovec, iovcnt, peek);
+#else
+            return batchRecv(iovec, iovcnt, peek);
+#endif
         }
+        for (;;) {
+            struct msghdr msghdr = {};
+            msghdr.msg_iov = const_cast<struct iovec*>(iovec);
+            msghdr.msg_iovlen = iovcnt;
+            if (telemetry) {
+                msghdr.msg_control = ctrlBuf.get();
+                msghdr.msg_controllen = ctrlBufSize;
+            }
+            ssize_t nbytes;
+            {
+                spinForInput(); // If it succeeds, the read won't block
+                Canceler canceler{};
+                nbytes = ::recvmsg(sd, &msghdr, peek ? MSG_PEEK : 0);
+            }
+            if (telemetry && nbytes >= 0)
+                parseTelemetry(msghdr, lastRxTime);
 #if 0
-        ::printf("UdpSock::recv(): iovcnt=%d, iovec[0].iov_len=%zu, "
-                "peek=%d, nbytes=%zd\n", iovcnt, iovec[0].iov_len, peek,
-                nbytes);
+            ::printf("UdpSock::recv(): iovcnt=%d, iovec[0].iov_len=%zu, "
+                    "peek=%d, nbytes=%zd\n", iovcnt, iovec[0].iov_len, peek,
+                    nbytes);
 #endif
-        checkReadStatus(nbytes);
-        currRecSize = peek ? nbytes : 0;
-        return nbytes;
+            checkReadStatus(nbytes);
+            if (emulator && nbytes > 0) {
+                /*
+                 * A datagram's fate is decided when it's first seen, so a
+                 * peek and the consuming read that follows agree on it
+                 */
+                if (!emulDecided) {
+                    emulDrop = emulator.shouldDrop();
+                    if (!emulDrop)
+                        emulator.delay(nbytes);
+                    emulDecided = true;
+                }
+                if (!peek)
+                    emulDecided = false; // Consumed: the next datagram is new
+                if (emulDrop) {
+                    if (peek) {
+                        // Consume the doomed datagram the caller peeked at
+                        char byte;
+                        ::recv(sd, &byte, sizeof(byte), 0);
+                        emulDecided = false;
+                    }
+                    continue;
+                }
+            }
+            currRecSize = peek ? nbytes : 0;
+            return nbytes;
+        }
     }
 
     /**
@@ -231,8 +948,332 @@ public:
     }
 
     /**
-     * Discards the current datagram. Does nothing if there is no current
-     * datagram. Idempotent.
+     * Returns a view of the leading bytes of the pending datagram without
+     * consuming it. When batching is enabled, the datagram resides in a
+     * user-space buffer and the returned pointer refers directly into it --
+     * no copy and no system call. When batching is disabled, the leading
+     * bytes are peeked into a small staging buffer with one MSG_PEEK
+     * receive, which copies only those bytes out of the kernel: the payload
+     * stays in the kernel, whence a subsequent `discard()` drops it without
+     * it ever crossing into user space. Waits for a datagram if necessary.
+     * The view is valid until the datagram is consumed or discarded.
+     * @param[in] nbytes    Minimum number of bytes the view must expose
+     * @retval nullptr      The datagram is too small
+     * @return              Pointer to the first byte of the pending datagram
+     * @throws SystemError  I/O error reading from socket
+     */
+    const void* peek(const size_t nbytes)
+    {
+#ifdef USE_AF_XDP
+        if (xdp) {
+            fillXdpQueue();
+            const XdpFrame& frame = xdpFrames.front();
+            if (frame.payLen < nbytes)
+                return nullptr;
+            currRecSize = frame.payLen; // The datagram remains pending
+            return static_cast<const char*>(
+                    ::xsk_umem__get_data(umemArea, frame.addr)) + frame.payOff;
+        }
+#endif
+        if (batchSize == 0) {
+            if (peekBuf.size() < nbytes)
+                peekBuf.resize(nbytes);
+            struct iovec iov;
+            iov.iov_base = peekBuf.data();
+            iov.iov_len = nbytes;
+            // Sets `currRecSize`; handles telemetry and the emulator
+            if (recv(&iov, 1, true) < nbytes)
+                return nullptr;
+            return peekBuf.data();
+        }
+#ifdef USE_IO_URING
+        while (readyBufs.empty())
+            reapCompletions();
+        const unsigned head = readyBufs.front();
+#else
+        if (batchCount == 0)
+            refillBatch();
+        const unsigned head = batchHead;
+#endif
+        if (telemetry)
+            lastRxTime = batchTimes[head];
+        const UdpPayloadSize len = currSegLen(head);
+        if (len < nbytes)
+            return nullptr;
+        currRecSize = len; // The datagram remains pending
+        return batchBufs[head].get() + segOffset;
+    }
+
+    /**
+     * Attaches a network-condition emulator.
+     * @param[in] emulator  Emulator of adverse network conditions
+     * @throws LogicError   Batched reception is enabled
+     */
+    void setEmulator(const NetEmulator& emulator)
+    {
+        if (batchSize)
+            throw LOGIC_ERROR(
+                    "Emulation is incompatible with batched reception");
+        this->emulator = emulator;
+    }
+
+    /**
+     * Enables batched reception.
+     * @param[in] count  Maximum number of datagrams to read per system call
+     * @throws InvalidArgument  `count == 0`
+     */
+    void setBatching(const unsigned count)
+    {
+        if (count == 0)
+            throw INVALID_ARGUMENT("Zero batch-size");
+#ifdef USE_IO_URING
+        // In-flight receives reference the batch buffers; cancel them before
+        // the buffers can be reallocated
+        if (haveRing) {
+            ::io_uring_queue_exit(&ring);
+            haveRing = false;
+            readyBufs = decltype(readyBufs){};
+        }
+#endif
+        batchBufs.resize(count);
+        for (unsigned i = batchSize; i < count; ++i)
+            batchBufs[i].reset(new char[maxPayload]);
+        batchLens.resize(count);
+        batchSegs.resize(count);
+        if (telemetry || gro) {
+            batchCtrls.resize(count);
+            for (unsigned i = batchSize; i < count; ++i)
+                batchCtrls[i].reset(new char[ctrlBufSize]);
+        }
+        if (telemetry)
+            batchTimes.resize(count);
+        batchSize = count;
+#ifdef USE_IO_URING
+        const int status = ::io_uring_queue_init(count, &ring, 0);
+        if (status < 0)
+            throw SYSTEM_ERROR(std::string{"io_uring_queue_init() failure: "
+                    "sock="} + std::to_string(sd), -status);
+        haveRing = true;
+        ringHdrs.resize(count);
+        ringIovs.resize(count);
+        for (unsigned i = 0; i < count; ++i)
+            submitRecv(i);
+#endif
+    }
+
+    /**
+     * Enables receive telemetry. The kernel will attach its receive timestamp
+     * and its cumulative count of dropped datagrams to every received
+     * datagram.
+     * @throws SystemError  `setsockopt()` failure
+     */
+    void enableTelemetry()
+    {
+        if (telemetry)
+            return;
+        const int yes = 1;
+        if (::setsockopt(sd, SOL_SOCKET, SO_TIMESTAMPNS, &yes, sizeof(yes)))
+            throw SYSTEM_ERROR("Couldn't enable kernel receive timestamps: "
+                    "sock=" + std::to_string(sd));
+        if (::setsockopt(sd, SOL_SOCKET, SO_RXQ_OVFL, &yes, sizeof(yes)))
+            throw SYSTEM_ERROR("Couldn't enable kernel drop-counting: sock=" +
+                    std::to_string(sd));
+        ctrlBuf.reset(new char[ctrlBufSize]);
+        if (batchSize) {
+            batchCtrls.resize(batchSize);
+            for (unsigned i = 0; i < batchSize; ++i)
+                batchCtrls[i].reset(new char[ctrlBufSize]);
+            batchTimes.resize(batchSize);
+        }
+        /*
+         * Receives that are already in flight were posted without an
+         * ancillary-data buffer; their telemetry is silently absent.
+         */
+        telemetry = true;
+    }
+
+    /**
+     * Enables UDP generic receive offload. The kernel then coalesces trains
+     * of equal-size datagrams -- such as the MTU-sized canonical chunks that
+     * application-layer fragmentation generates -- into one aggregate per
+     * `recvmmsg()` slot, with the segment size attached as ancillary data.
+     * The aggregate is served one segment at a time, so callers continue to
+     * see individual datagrams. A no-op if the kernel doesn't support the
+     * socket option.
+     * @throws LogicError  Batched reception isn't enabled
+     */
+    void enableGro()
+    {
+#ifdef UDP_GRO
+        if (batchSize == 0)
+            throw LOGIC_ERROR("GRO requires batched reception");
+        if (gro)
+            return;
+        const int yes = 1;
+        if (::setsockopt(sd, SOL_UDP, UDP_GRO, &yes, sizeof(yes))) {
+            LOG_NOTE("Kernel doesn't support UDP generic receive offload: "
+                    "sock=" + std::to_string(sd));
+            return;
+        }
+        // The segment-size control message needs an ancillary-data buffer
+        batchCtrls.resize(batchSize);
+        for (unsigned i = 0; i < batchSize; ++i)
+            if (!batchCtrls[i])
+                batchCtrls[i].reset(new char[ctrlBufSize]);
+        gro = true;
+#else
+        LOG_NOTE("Not built with UDP generic receive offload support");
+#endif
+    }
+
+    /**
+     * Enables the experimental AF_XDP receive backend. Ethernet frames from
+     * the given NIC receive-queue are redirected by the kernel's XDP hook
+     * straight into user-space UMEM buffers, bypassing the kernel UDP stack
+     * entirely; `recv()` and `peek()` then serve the UDP payloads from those
+     * buffers. The regular socket stays open -- it carries the multicast
+     * group membership -- but stops seeing the data, which the XDP program
+     * claims first. The queue should be dedicated to this feed (e.g., via an
+     * ethtool flow-steering rule): datagrams for other ports that land on it
+     * are dropped rather than passed up the stack, and kernel telemetry,
+     * GRO, and the network-condition emulator don't apply to the bypassed
+     * path. Falls back to standard reception -- with a log message -- if the
+     * AF_XDP socket can't be created, which requires `CAP_NET_ADMIN` and
+     * driver support.
+     * @param[in] ifaceName  Name of the network interface (e.g., "eth0")
+     * @param[in] queueId    NIC receive-queue to attach to
+     * @throws SystemError   The UMEM couldn't be created
+     */
+    void enableXdp(
+            const std::string& ifaceName,
+            const unsigned     queueId)
+    {
+#ifdef USE_AF_XDP
+        if (xdp)
+            return;
+        const size_t frameSize = XSK_UMEM__DEFAULT_FRAME_SIZE;
+        const size_t umemSize = umemNumFrames*frameSize;
+        if (::posix_memalign(&umemArea, ::getpagesize(), umemSize))
+            throw SYSTEM_ERROR("Couldn't allocate AF_XDP UMEM: size=" +
+                    std::to_string(umemSize));
+        int status = ::xsk_umem__create(&umem, umemArea, umemSize, &fillRing,
+                &compRing, nullptr);
+        if (status) {
+            ::free(umemArea);
+            umemArea = nullptr;
+            throw SYSTEM_ERROR(std::string{"xsk_umem__create() failure: "
+                    "sock="} + std::to_string(sd), -status);
+        }
+        status = ::xsk_socket__create(&xsk, ifaceName.c_str(), queueId, umem,
+                &rxRing, &txRing, nullptr);
+        if (status) {
+            LOG_NOTE("Couldn't create AF_XDP socket (needs CAP_NET_ADMIN and "
+                    "driver support): iface=" + ifaceName + ", queue=" +
+                    std::to_string(queueId) + "; using standard reception");
+            ::xsk_umem__delete(umem);
+            umem = nullptr;
+            ::free(umemArea);
+            umemArea = nullptr;
+            return;
+        }
+        // Offer every frame to the kernel
+        uint32_t idx;
+        ::xsk_ring_prod__reserve(&fillRing, umemNumFrames, &idx);
+        for (unsigned i = 0; i < umemNumFrames; ++i, ++idx)
+            *::xsk_ring_prod__fill_addr(&fillRing, idx) = i*frameSize;
+        ::xsk_ring_prod__submit(&fillRing, umemNumFrames);
+        xdp = true;
+#else
+        LOG_NOTE("Not built with AF_XDP support (see \"./configure "
+                "--enable-af-xdp\"); using standard reception");
+#endif
+    }
+
+    /**
+     * Enables adaptive receive-buffer sizing. The receive buffer starts at
+     * `initial` bytes and is doubled -- up to `max` bytes -- whenever the
+     * kernel's drop counter shows that datagrams were lost because the
+     * buffer was full. Enables telemetry, which carries the drop counter.
+     * @param[in] initial       Initial receive-buffer size in bytes
+     * @param[in] max           Ceiling on adaptive growth in bytes
+     * @throws InvalidArgument  `initial <= 0 || max < initial`
+     * @throws SystemError      `setsockopt()` failure
+     */
+    void enableAdaptiveRcvBuf(
+            const int initial,
+            const int max)
+    {
+        if (initial <= 0 || max < initial)
+            throw INVALID_ARGUMENT("Invalid receive-buffer sizes: initial=" +
+                    std::to_string(initial) + ", max=" + std::to_string(max));
+        enableTelemetry(); // Carries the kernel's drop counter
+        setRcvBufSize(initial);
+        rcvBufCap = max;
+        static std::atomic<unsigned> numAdaptive{0};
+        rcvBufGauge = Metrics::registerGauge(
+                "hycast_udp_rcvbuf_bytes{sock=\"" +
+                        std::to_string(numAdaptive++) + "\"}",
+                "Size of the adaptively-managed UDP receive buffer",
+                [this]{return static_cast<double>(rcvBufSize.load());});
+    }
+
+    /**
+     * Enables busy-polling reception. This instance spins for the given
+     * budget before every blocking receive, and the kernel is asked to
+     * busy-poll the network device for the same period, so a datagram that
+     * arrives within the budget is received without a scheduler wakeup.
+     * Burns a core while spinning: intended for latency-critical receivers
+     * whose receive thread is pinned to a dedicated CPU (see
+     * `Thread::setAffinity()`).
+     * @param[in] spinMicros    Spin budget in microseconds
+     * @throws InvalidArgument  `spinMicros == 0`
+     */
+    void enableBusyPoll(const unsigned spinMicros)
+    {
+        if (spinMicros == 0)
+            throw INVALID_ARGUMENT("Zero spin-budget");
+#ifdef SO_BUSY_POLL
+        /*
+         * Large values need CAP_NET_ADMIN on older kernels; the user-space
+         * spin still delivers most of the benefit, so failure isn't fatal
+         */
+        const int micros = spinMicros;
+        if (::setsockopt(sd, SOL_SOCKET, SO_BUSY_POLL, &micros, sizeof(micros)))
+            LOG_WARN("Couldn't enable kernel busy-polling: sock=" +
+                    std::to_string(sd));
+#endif
+        this->spinMicros = spinMicros;
+    }
+
+    /**
+     * Returns the kernel receive timestamp of the most recently received
+     * datagram.
+     * @return Kernel receive timestamp. All zeros if no datagram has been
+     *         received since telemetry was enabled.
+     */
+    struct timespec getRecvTimestamp() const noexcept
+    {
+        return lastRxTime;
+    }
+
+    /**
+     * Returns the kernel's cumulative count of datagrams dropped because this
+     * socket's receive buffer was full.
+     * @return Number of datagrams dropped by the kernel
+     */
+    unsigned long getDropCount() const noexcept
+    {
+        return numDropped;
+    }
+
+    /**
+     * Discards the current datagram without draining its payload: the
+     * consuming one-byte receive makes the kernel drop the excess --
+     * MSG_TRUNC semantics are how a datagram socket treats a short read --
+     * so a receiver that peeked at the header and doesn't want the datagram
+     * never pays memory bandwidth for the payload. On a batched socket the
+     * equivalent: the ring cursor advances past the buffered datagram. Does
+     * nothing if there is no current datagram. Idempotent.
      * @exceptionsafety Basic guarantee
      * @threadsafety    Thread-compatible but not thread-safe
      */
@@ -266,6 +1307,44 @@ class OutUdpSock::Impl final : public UdpSock::Impl
 {
     struct sockaddr_storage sockAddrStorage;
 
+    unsigned                             batchSize;  /// Max datagrams per
+                                                     /// sendmmsg()
+    unsigned                             batchCount; /// Number of staged
+                                                     /// datagrams
+    std::vector<std::unique_ptr<char[]>> batchBufs;  /// Staged datagrams
+    std::vector<size_t>                  batchLens;  /// Staged datagram sizes
+#ifdef USE_IO_URING
+    struct io_uring                      ring;       /// io_uring(7) instance
+    bool                                 haveRing;   /// Whether `ring` is
+                                                     /// initialized
+#endif
+
+    /**
+     * Stages a message for a later sendmmsg() system call. The message is
+     * gathered into a staging buffer so the caller's buffers needn't persist.
+     * @param[in] iovec   Vector comprising message to send
+     * @param[in] iovcnt  Number of elements in `iovec`
+     * @throws InvalidArgument    Message is larger than the maximum payload
+     * @throws std::system_error  I/O error writing to socket
+     */
+    void batchSend(
+            const struct iovec* const iovec,
+            const int                 iovcnt)
+    {
+        char*  buf = batchBufs[batchCount].get();
+        size_t len = 0;
+        for (int i = 0; i < iovcnt; ++i) {
+            if (len + iovec[i].iov_len > maxPayload)
+                throw INVALID_ARGUMENT("Datagram too large: nbytes=" +
+                        std::to_string(len + iovec[i].iov_len));
+            ::memcpy(buf + len, iovec[i].iov_base, iovec[i].iov_len);
+            len += iovec[i].iov_len;
+        }
+        batchLens[batchCount] = len;
+        if (++batchCount >= batchSize)
+            flush();
+    }
+
 protected:
     InetSockAddr remoteSockAddr;
 
@@ -278,6 +1357,13 @@ public:
     explicit Impl(
             const InetSockAddr& remoteSockAddr)
         : UdpSock::Impl{remoteSockAddr}
+        , batchSize{0}
+        , batchCount{0}
+        , batchBufs{}
+        , batchLens{}
+#ifdef USE_IO_URING
+        , haveRing{false}
+#endif
         , remoteSockAddr{remoteSockAddr}
     {
     	try {
@@ -297,7 +1383,13 @@ public:
     /**
      * Destroys.
      */
-    virtual ~Impl() noexcept =default;
+    virtual ~Impl() noexcept
+    {
+#ifdef USE_IO_URING
+        if (haveRing)
+            ::io_uring_queue_exit(&ring);
+#endif
+    }
 
     virtual std::string to_string() const
     {
@@ -354,6 +1446,139 @@ public:
         remoteSockAddr.setHopLimit(sd, limit);
     }
 
+    /**
+     * Sets the Differentiated Services code-point on the socket so the
+     * network can class its traffic.
+     * @param[in] dscp  Code-point in [0,63] (see RFC 2474). 0 is best-effort
+     *                  (the default).
+     * @throws std::invalid_argument  `dscp > 63`
+     * @throws std::system_error      `setsockopt()` failure
+     * @execptionsafety  Strong guarantee
+     * @threadsafety     Safe
+     */
+    void setDscp(
+            const unsigned dscp) const
+    {
+        remoteSockAddr.setDscp(sd, dscp);
+    }
+
+    /**
+     * Enables batched transmission.
+     * @param[in] count  Maximum number of datagrams per system call
+     * @throws InvalidArgument  `count == 0`
+     */
+    void setBatching(const unsigned count)
+    {
+        if (count == 0)
+            throw INVALID_ARGUMENT("Zero batch-size");
+        flush();
+        batchBufs.resize(count);
+        for (unsigned i = batchSize; i < count; ++i)
+            batchBufs[i].reset(new char[maxPayload]);
+        batchLens.resize(count);
+        batchSize = count;
+#ifdef USE_IO_URING
+        if (haveRing) {
+            ::io_uring_queue_exit(&ring);
+            haveRing = false;
+        }
+        const int status = ::io_uring_queue_init(count, &ring, 0);
+        if (status < 0)
+            throw SYSTEM_ERROR(std::string{"io_uring_queue_init() failure: "
+                    "sock="} + std::to_string(sd), -status);
+        haveRing = true;
+#endif
+    }
+
+#ifdef USE_IO_URING
+    /**
+     * Transmits the staged datagrams by submitting one asynchronous sendmsg()
+     * per datagram with a single io_uring_submit_and_wait() system call and
+     * reaping every completion. The kernel may transmit the datagrams out of
+     * order; UDP makes no ordering guarantee anyway.
+     * @throws RuntimeError       Submission queue is full
+     * @throws std::system_error  I/O error writing to socket
+     */
+    void ringFlush()
+    {
+        std::vector<struct msghdr> hdrs(batchCount);
+        std::vector<struct iovec>  iovs(batchCount);
+        for (unsigned i = 0; i < batchCount; ++i) {
+            iovs[i].iov_base = batchBufs[i].get();
+            iovs[i].iov_len = batchLens[i];
+            hdrs[i] = msghdr{};
+            hdrs[i].msg_name = &sockAddrStorage;
+            hdrs[i].msg_namelen = sizeof(sockAddrStorage);
+            hdrs[i].msg_iov = &iovs[i];
+            hdrs[i].msg_iovlen = 1;
+            struct io_uring_sqe* sqe = ::io_uring_get_sqe(&ring);
+            if (sqe == nullptr) {
+                batchCount = 0;
+                throw RUNTIME_ERROR(std::string{"io_uring submission-queue is "
+                        "full: sock="} + std::to_string(sd));
+            }
+            ::io_uring_prep_sendmsg(sqe, sd, &hdrs[i], 0);
+        }
+        const unsigned count = batchCount;
+        batchCount = 0; // Like the sendmmsg() path: staging empties on error
+        int status = ::io_uring_submit_and_wait(&ring, count);
+        if (status < 0)
+            throw SYSTEM_ERROR(std::string{"io_uring_submit_and_wait() "
+                    "failure: sock="} + std::to_string(sd), -status);
+        int firstErr = 0; // All completions are reaped before throwing
+        for (unsigned i = 0; i < count; ++i) {
+            struct io_uring_cqe* cqe;
+            status = ::io_uring_wait_cqe(&ring, &cqe);
+            if (status < 0)
+                throw SYSTEM_ERROR(std::string{"io_uring_wait_cqe() failure: "
+                        "sock="} + std::to_string(sd), -status);
+            if (cqe->res < 0 && firstErr == 0)
+                firstErr = -cqe->res;
+            ::io_uring_cqe_seen(&ring, cqe);
+        }
+        if (firstErr)
+            throw SYSTEM_ERROR(std::string{"Asynchronous sendmsg() failure: "
+                    "sock="} + std::to_string(sd), firstErr);
+    }
+#endif
+
+    /**
+     * Transmits any staged datagrams with a single sendmmsg() system call.
+     * @throws std::system_error  I/O error writing to socket
+     */
+    void flush()
+    {
+        if (batchCount == 0)
+            return;
+#ifdef USE_IO_URING
+        ringFlush();
+#else
+        std::vector<struct mmsghdr> msgs(batchCount);
+        std::vector<struct iovec>   iovs(batchCount);
+        for (unsigned i = 0; i < batchCount; ++i) {
+            iovs[i].iov_base = batchBufs[i].get();
+            iovs[i].iov_len = batchLens[i];
+            msgs[i] = mmsghdr{};
+            msgs[i].msg_hdr.msg_name = &sockAddrStorage;
+            msgs[i].msg_hdr.msg_namelen = sizeof(sockAddrStorage);
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        unsigned sent = 0;
+        while (sent < batchCount) {
+            const int nmsgs = ::sendmmsg(sd, msgs.data() + sent,
+                    batchCount - sent, 0);
+            if (nmsgs < 0) {
+                batchCount = 0;
+                throw SYSTEM_ERROR(std::string{"sendmmsg() failure: sock="} +
+                        std::to_string(sd));
+            }
+            sent += nmsgs;
+        }
+        batchCount = 0;
+#endif
+    }
+
     /**
      * Scatter-sends a message.
      * @param[in] iovec     Vector comprising message to send
@@ -364,6 +1589,10 @@ public:
             const struct iovec* iovec,
             const int           iovcnt)
     {
+        if (batchSize) {
+            batchSend(iovec, iovcnt);
+            return;
+        }
         struct msghdr msghdr = {};
         msghdr.msg_name = &sockAddrStorage;
         msghdr.msg_namelen = sizeof(sockAddrStorage);
@@ -445,6 +1674,23 @@ public:
         mcastAddr.joinSourceGroup(sd, sourceAddr);
     }
 
+    /**
+     * Constructs from an existing socket descriptor -- e.g., one inherited
+     * from the previous process during a warm handoff. The socket keeps its
+     * multicast group memberships and the datagrams queued in its receive
+     * buffer, so an upgrade loses no packets.
+     * @param[in] sd           Bound socket descriptor with the group
+     *                         membership already established. This instance
+     *                         assumes ownership.
+     * @throw InvalidArgument  `sd < 0`
+     * @throw SystemError      Couldn't get local socket address
+     */
+    explicit Impl(const int sd)
+        : InUdpSock::Impl{sd}
+        , sourceAddr{}
+        , isSourceSpecific{false}
+    {}
+
     /**
      * Returns a string representation of this instance's socket.
      * @return String representation of this instance's socket
@@ -482,6 +1728,11 @@ UdpSock::UdpSock(Impl* const pImpl)
 UdpSock::~UdpSock()
 {}
 
+int UdpSock::getSock() const noexcept
+{
+    return pImpl->getSock();
+}
+
 InUdpSock::InUdpSock(Impl* const pImpl)
     : UdpSock{pImpl}
 {}
@@ -531,6 +1782,60 @@ size_t InUdpSock::recv(
     return getPimpl()->recv(buf, len, peek);
 }
 
+const void* InUdpSock::peek(const size_t nbytes)
+{
+    return getPimpl()->peek(nbytes);
+}
+
+void InUdpSock::setBatching(const unsigned count)
+{
+    getPimpl()->setBatching(count);
+}
+
+void InUdpSock::setEmulator(const NetEmulator& emulator)
+{
+    getPimpl()->setEmulator(emulator);
+}
+
+void InUdpSock::enableTelemetry()
+{
+    getPimpl()->enableTelemetry();
+}
+
+void InUdpSock::enableGro()
+{
+    getPimpl()->enableGro();
+}
+
+void InUdpSock::enableXdp(
+        const std::string& ifaceName,
+        const unsigned     queueId)
+{
+    getPimpl()->enableXdp(ifaceName, queueId);
+}
+
+void InUdpSock::enableAdaptiveRcvBuf(
+        const int initial,
+        const int max)
+{
+    getPimpl()->enableAdaptiveRcvBuf(initial, max);
+}
+
+void InUdpSock::enableBusyPoll(const unsigned spinMicros)
+{
+    getPimpl()->enableBusyPoll(spinMicros);
+}
+
+struct timespec InUdpSock::getRecvTimestamp() const noexcept
+{
+    return getPimpl()->getRecvTimestamp();
+}
+
+unsigned long InUdpSock::getDropCount() const noexcept
+{
+    return getPimpl()->getDropCount();
+}
+
 void InUdpSock::discard()
 {
     return getPimpl()->discard();
@@ -585,6 +1890,23 @@ const OutUdpSock& OutUdpSock::setHopLimit(
     return *this;
 }
 
+const OutUdpSock& OutUdpSock::setDscp(
+        const unsigned dscp) const
+{
+    getPimpl()->setDscp(dscp);
+    return *this;
+}
+
+void OutUdpSock::setBatching(const unsigned count)
+{
+    getPimpl()->setBatching(count);
+}
+
+void OutUdpSock::flush()
+{
+    getPimpl()->flush();
+}
+
 void OutUdpSock::send(
         const struct iovec* const iovec,
         const int                 iovcnt)
@@ -622,6 +1944,10 @@ McastUdpSock::McastUdpSock(
     : InUdpSock(new Impl(mcastAddr, sourceAddr, sharePort))
 {}
 
+McastUdpSock::McastUdpSock(const int sd)
+    : InUdpSock(new Impl(sd))
+{}
+
 McastUdpSock::~McastUdpSock()
 {
     /*
@@ -14,8 +14,10 @@
 
 #include "InetAddr.h"
 #include "InetSockAddr.h"
+#include "NetEmulator.h"
 
 #include <sys/types.h>
+#include <time.h>
 
 namespace hycast {
 
@@ -56,6 +58,16 @@ public:
      */
     virtual const InetSockAddr getLocalAddr() const =0;
 
+    /**
+     * Returns the socket descriptor -- e.g., so it can be passed to the next
+     * process during a warm handoff.
+     * @return          Socket descriptor
+     * @exceptionsafety Nothrow
+     * @threadsafety    Safe
+     * @see `HandoffSender::send()`
+     */
+    int getSock() const noexcept;
+
     /**
      * Returns a string representation of this instance's socket.
      * @return String representation of this instance's socket
@@ -134,6 +146,36 @@ public:
     virtual const OutUdpSock& setHopLimit(
             const unsigned limit) const;
 
+    /**
+     * Sets the Differentiated Services code-point on the socket so the
+     * network can class its traffic (e.g., prioritize real-time product
+     * datagrams over bulk transfers).
+     * @param[in] dscp  Code-point in [0,63] (see RFC 2474). 0 is best-effort
+     *                  (the default).
+     * @throws std::invalid_argument  `dscp > 63`
+     * @throws std::system_error      `setsockopt()` failure
+     * @execptionsafety  Strong guarantee
+     * @threadsafety     Safe
+     */
+    virtual const OutUdpSock& setDscp(
+            const unsigned dscp) const;
+
+    /**
+     * Enables batched transmission. Datagrams passed to send() are staged in
+     * user-space and transmitted with a single sendmmsg() system call when
+     * `count` datagrams have accumulated or flush() is called, which
+     * amortizes the per-datagram system call at high message rates.
+     * @param[in] count  Maximum number of datagrams per system call
+     * @throws InvalidArgument  `count == 0`
+     */
+    void setBatching(const unsigned count);
+
+    /**
+     * Transmits any staged datagrams. A no-op unless batching is enabled.
+     * @throws std::system_error  I/O error writing to socket
+     */
+    void flush();
+
     /**
      * Scatter-sends a message.
      * @param[in] iovec     Vector comprising message to send
@@ -243,7 +285,148 @@ public:
            const bool   peek = false);
 
     /**
-     * Discards the current datagram.
+     * Returns a view of the leading bytes of the pending datagram without
+     * consuming it. When batching is enabled, the datagram resides in a
+     * user-space buffer and the returned pointer refers directly into it --
+     * no copy and no system call. When batching is disabled, the leading
+     * bytes are peeked into a small staging buffer with one MSG_PEEK
+     * receive, which copies only those bytes out of the kernel: a receiver
+     * that then doesn't want the datagram calls `discard()` and the payload
+     * never crosses into user space. Waits for a datagram if necessary. The
+     * view is valid until the datagram is consumed or discarded.
+     * @param[in] nbytes  Minimum number of bytes the view must expose
+     * @retval nullptr    The datagram is too small
+     * @return            Pointer to the first byte of the pending datagram
+     * @throws std::system_error  I/O error reading from socket
+     */
+    const void* peek(const size_t nbytes);
+
+    /**
+     * Enables batched reception. Up to `count` datagrams are read from the
+     * socket in a single recvmmsg() system call and served to subsequent
+     * calls to recv() from user-space buffers, which amortizes the
+     * per-datagram system call at high packet rates.
+     * @param[in] count  Maximum number of datagrams to read per system call
+     * @throws InvalidArgument  `count == 0`
+     */
+    void setBatching(const unsigned count);
+
+    /**
+     * Attaches a network-condition emulator for the test harness: received
+     * datagrams are subjected to the emulator's burst-loss, latency, and
+     * bandwidth cap before delivery. A datagram's fate is decided when it's
+     * first seen, so a peek and the consuming read that follows agree on it.
+     * @param[in] emulator  Emulator of adverse network conditions
+     * @throws LogicError   Batched reception is enabled
+     * @see NetEmulator
+     */
+    void setEmulator(const NetEmulator& emulator);
+
+    /**
+     * Enables receive telemetry. The kernel attaches its receive timestamp
+     * and its cumulative count of datagrams dropped because the socket's
+     * receive buffer was full to every received datagram, which distinguishes
+     * loss in this host from loss in the network.
+     * @throws std::system_error  `setsockopt()` failure
+     * @exceptionsafety           Strong guarantee
+     * @threadsafety              Safe
+     */
+    void enableTelemetry();
+
+    /**
+     * Enables UDP generic receive offload. The kernel coalesces trains of
+     * equal-size datagrams into one aggregate per receive slot, cutting the
+     * per-datagram protocol-stack overhead; the socket serves the aggregate
+     * one segment at a time, so `recv()` and `peek()` continue to return
+     * individual datagrams. A no-op if the kernel doesn't support the
+     * socket option.
+     * @throws std::logic_error  Batched reception isn't enabled
+     * @exceptionsafety          Strong guarantee
+     * @threadsafety             Compatible but not safe
+     */
+    void enableGro();
+
+    /**
+     * Enables the experimental AF_XDP receive backend. Datagrams from the
+     * given NIC receive-queue are delivered as raw Ethernet frames into
+     * user-space UMEM buffers, bypassing the kernel UDP stack; `recv()` and
+     * `peek()` serve the UDP payloads from those buffers. The queue should
+     * be dedicated to this feed via a flow-steering rule. Falls back to
+     * standard reception -- with a log message -- if the AF_XDP socket can't
+     * be created or the build lacks support (see `./configure
+     * --enable-af-xdp`).
+     * @param[in] ifaceName  Name of the network interface (e.g., "eth0")
+     * @param[in] queueId    NIC receive-queue to attach to
+     * @throws std::system_error  The UMEM couldn't be created
+     * @exceptionsafety           Strong guarantee
+     * @threadsafety              Compatible but not safe
+     */
+    void enableXdp(
+            const std::string& ifaceName,
+            const unsigned     queueId);
+
+    /**
+     * Enables adaptive receive-buffer sizing. The receive buffer is set to
+     * `initial` bytes and doubled -- up to `max` bytes -- whenever the
+     * kernel's drop counter shows that datagrams were lost because the
+     * buffer was full, so the buffer tunes itself to the observed burst size
+     * instead of relying on a hand-tuned `net.core.rmem_default`. Implies
+     * `enableTelemetry()`, which carries the drop counter. The current size
+     * is exported via the metric `hycast_udp_rcvbuf_bytes`.
+     * @param[in] initial  Initial receive-buffer size in bytes
+     * @param[in] max      Ceiling on adaptive growth in bytes
+     * @throws InvalidArgument    `initial <= 0 || max < initial`
+     * @throws std::system_error  `setsockopt()` failure
+     * @exceptionsafety           Basic guarantee
+     * @threadsafety              Compatible but not safe
+     */
+    void enableAdaptiveRcvBuf(
+            const int initial,
+            const int max);
+
+    /**
+     * Enables busy-polling reception for latency-critical receivers. Before
+     * every blocking receive, this socket spins for the given budget -- and
+     * the kernel busy-polls the network device via `SO_BUSY_POLL` -- so a
+     * datagram that arrives within the budget is received without a scheduler
+     * wakeup, whose latency (several microseconds, worse under load)
+     * otherwise dominates once batching has removed the system-call
+     * overhead. Burns a core while spinning: the receive thread should be
+     * pinned to a dedicated CPU via `Thread::setAffinity()`.
+     * @param[in] spinMicros  Spin budget in microseconds
+     * @throws InvalidArgument  `spinMicros == 0`
+     * @exceptionsafety         Strong guarantee
+     * @threadsafety            Compatible but not safe
+     */
+    void enableBusyPoll(const unsigned spinMicros);
+
+    /**
+     * Returns the kernel receive timestamp of the most recently received
+     * datagram. Meaningful only after telemetry is enabled.
+     * @return  Kernel receive timestamp. All zeros if no datagram has been
+     *          received since telemetry was enabled.
+     * @exceptionsafety  No throw
+     * @threadsafety     Compatible but not safe
+     */
+    struct timespec getRecvTimestamp() const noexcept;
+
+    /**
+     * Returns the kernel's count of datagrams that were dropped because this
+     * socket's receive buffer was full. Meaningful only after telemetry is
+     * enabled. The count is cumulative since the socket was created.
+     * @return  Number of datagrams dropped by the kernel
+     * @exceptionsafety  No throw
+     * @threadsafety     Compatible but not safe
+     */
+    unsigned long getDropCount() const noexcept;
+
+    /**
+     * Discards the current datagram without draining its payload: on an
+     * unbatched socket the kernel drops the unread excess -- the MSG_TRUNC
+     * semantics of a short read on a datagram socket -- and on a batched
+     * socket the ring cursor advances past the buffered datagram. Paired
+     * with `peek()`, a filtered receiver thus pays for an unwanted
+     * datagram's header only, never its payload.
      */
     void discard();
 
@@ -302,6 +485,20 @@ public:
             const InetAddr&     sourceAddr,
             const bool          sharePort = false);
 
+    /**
+     * Constructs from an existing socket descriptor -- e.g., one inherited
+     * from the previous process during a warm handoff. The socket keeps its
+     * multicast group memberships and the datagrams queued in its receive
+     * buffer, so an upgrade loses no packets.
+     * @param[in] sd           Bound socket descriptor with the group
+     *                         membership already established. This instance
+     *                         assumes ownership.
+     * @throw InvalidArgument  `sd < 0`
+     * @throw SystemError      Couldn't get local socket address
+     * @see `HandoffReceiver::recv()`
+     */
+    explicit McastUdpSock(const int sd);
+
     /**
      * Destroys.
      */
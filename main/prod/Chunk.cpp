@@ -12,15 +12,27 @@
  * @author: Steven R. Emmerson
  */
 
+#include "config.h"
+
 #include "Chunk.h"
 #include "Codec.h"
+#include "Crc32c.h"
 #include "error.h"
 #include "ProdInfo.h"
 
+#include <atomic>
 #include <cstring>
+#include <vector>
+
+#ifdef USE_LZ4
+    #include <lz4.h>
+#endif
 
 namespace hycast {
 
+/// Whether or not chunk data is checksummed end-to-end
+static std::atomic<bool> checksumChunkData{false};
+
 /******************************************************************************/
 
 // Following initialized where declared; hence, no value specified here
@@ -39,10 +51,6 @@ class ChunkId::Impl
      * Index of the chunk of data in the product's data.
      */
     ChunkIndex                  chunkIndex;
-    /**
-     * Hash-code of this instance.
-     */
-    mutable std::atomic<size_t> hashCode;
     /**
      * Whether or not this instance is valid.
      */
@@ -52,7 +60,6 @@ public:
     Impl() noexcept
         : prodIndex{0}
         , chunkIndex{0}
-        , hashCode{0}
         , isValid{false}
     {}
 
@@ -63,29 +70,59 @@ public:
          * - `serialize(Encoder&, unsigned)`
          * - `getStaticSerialSize(unsigned)`
          */
-        : prodIndex{ProdIndex::deserialize(decoder, version)}
-        , chunkIndex{ChunkIndex::deserialize(decoder, version)}
-        , hashCode{0}
+        : prodIndex{}
+        , chunkIndex{}
         , isValid{false}
     {
-        decoder.decode(isValid);
+        if (version == 0) {
+            // One bounds-check and straight-line loads for the whole message
+            ProdIndex::type  prodIndexVal;
+            ChunkIndex::type chunkIndexVal;
+            decoder.decodeFields(prodIndexVal, chunkIndexVal, isValid);
+            prodIndex = ProdIndex{prodIndexVal};
+            chunkIndex = ChunkIndex{chunkIndexVal};
+        }
+        else {
+            // Compact encoding: both indices are varints
+            prodIndex = ProdIndex{decoder.decodeVarint()};
+            chunkIndex = ChunkIndex{
+                    static_cast<ChunkIndex::type>(decoder.decodeVarint())};
+            decoder.decode(isValid);
+        }
     }
 
+    /**
+     * Constructs from explicit field values. Intended for the delta-coded
+     * deserialization, which reconstructs the validity flag from the wire.
+     */
+    Impl(   const ProdIndex  prodIndex,
+            const ChunkIndex chunkIndex,
+            const bool       isValid)
+        : prodIndex{prodIndex}
+        , chunkIndex{chunkIndex}
+        , isValid{isValid}
+    {}
+
     Impl(   const ProdInfo&  prodInfo,
             const ChunkIndex chunkIndex)
         : prodIndex{prodInfo.getIndex()}
         , chunkIndex{chunkIndex}
-        , hashCode{0}
         , isValid{prodInfo && chunkIndex}
     {}
 
     Impl(const ChunkInfo& info)
         : prodIndex{info.getProdIndex()}
         , chunkIndex{info.getIndex()}
-        , hashCode{0}
         , isValid{info}
     {}
 
+    Impl(   const ProdIndex& prodIndex,
+            const ChunkIndex chunkIndex)
+        : prodIndex{prodIndex}
+        , chunkIndex{chunkIndex}
+        , isValid{0 != chunkIndex}
+    {}
+
     operator bool() const noexcept
     {
         return isValid;
@@ -109,15 +146,31 @@ public:
 
     bool operator==(const Impl& that) const noexcept
     {
-        return prodIndex == that.prodIndex && chunkIndex == that.chunkIndex;
+        return pack() == that.pack();
+    }
+
+    uint64_t pack() const noexcept
+    {
+        return (static_cast<uint64_t>(
+                        static_cast<ProdIndex::type>(prodIndex)) << 32) |
+                static_cast<ChunkIndex::type>(chunkIndex);
     }
 
     size_t hash() const noexcept
     {
-        if (hashCode.load() == 0)
-            hashCode = prodIndex.hash() |
-                    std::hash<ChunkIndex::type>()(chunkIndex);
-        return hashCode.load();
+        /*
+         * Finalizer-style mix of the packed identifier (after splitmix64). A
+         * few register operations -- cheaper than combining per-field
+         * hash-codes -- and, unlike the previous combination, it spreads both
+         * indices over every bit of the result.
+         */
+        uint64_t key = pack();
+        key ^= key >> 30;
+        key *= UINT64_C(0xbf58476d1ce4e5b9);
+        key ^= key >> 27;
+        key *= UINT64_C(0x94d049bb133111eb);
+        key ^= key >> 31;
+        return static_cast<size_t>(key);
     }
 
     bool operator<(const Impl& that) const noexcept
@@ -151,11 +204,71 @@ public:
          * - `ChunkId::ChunkId(Decoder, unsigned)`
          * - `ChunkId::getStaticSerialSize(const unsigned)`
          */
-        return prodIndex.serialize(encoder, version) +
-                chunkIndex.serialize(encoder, version) +
+        if (version == 0) {
+            // One bounds-check and straight-line stores for the whole message
+            return encoder.encodeFields(
+                    static_cast<ProdIndex::type>(prodIndex),
+                    static_cast<ChunkIndex::type>(chunkIndex),
+                    isValid);
+        }
+        // Compact encoding: both indices are varints
+        return encoder.encodeVarint(prodIndex) +
+                encoder.encodeVarint(chunkIndex) +
+                encoder.encode(isValid);
+    }
+
+    size_t getSerialSize(const unsigned version) const noexcept
+    {
+        return version == 0
+                ? getStaticSerialSize(version)
+                : prodIndex.getSerialSize(version) +
+                        chunkIndex.getSerialSize(version) +
+                        sizeof(bool);
+    }
+
+    /**
+     * Serializes this instance with its product-index delta-coded against a
+     * predecessor in the same message. Compact encoding only: successive
+     * identifiers in a range-set mostly share or increment the
+     * product-index, so the delta is almost always a one-byte varint.
+     * @param[out] encoder  Encoder
+     * @param[in]  prev     Predecessor in the same message
+     * @param[in]  version  Protocol version. Must not be 0.
+     * @return              Number of bytes written
+     */
+    size_t serializeDelta(
+            Encoder&       encoder,
+            const Impl&    prev,
+            const unsigned version) const
+    {
+        return encoder.encodeVarint(static_cast<ProdIndex::type>(prodIndex) -
+                        static_cast<ProdIndex::type>(prev.prodIndex)) +
+                encoder.encodeVarint(chunkIndex) +
                 encoder.encode(isValid);
     }
 
+    /**
+     * Returns a new instance whose product-index is delta-coded against a
+     * predecessor in the same message. Inverse of `serializeDelta()`.
+     * @param[in] decoder  Decoder
+     * @param[in] prev     Predecessor in the same message
+     * @param[in] version  Protocol version. Must not be 0.
+     */
+    static Impl* deserializeDelta(
+            Decoder&       decoder,
+            const Impl&    prev,
+            const unsigned version)
+    {
+        const ProdIndex prodIndex{
+                static_cast<ProdIndex::type>(prev.prodIndex) +
+                decoder.decodeVarint()};
+        const ChunkIndex chunkIndex{
+                static_cast<ChunkIndex::type>(decoder.decodeVarint())};
+        bool isValid;
+        decoder.decode(isValid);
+        return new Impl{prodIndex, chunkIndex, isValid};
+    }
+
     std::string to_string() const
     {
         return "{prodIndex=" + std::to_string(prodIndex) + ", chunkIndex=" +
@@ -168,6 +281,10 @@ ChunkId::ChunkId() noexcept
     : pImpl{new Impl()}
 {}
 
+ChunkId::ChunkId(Impl* const impl)
+    : pImpl{impl}
+{}
+
 ChunkId::ChunkId(
         Decoder& decoder,
         unsigned version)
@@ -185,6 +302,12 @@ ChunkId::ChunkId(
     : pImpl{new Impl(info)}
 {}
 
+ChunkId::ChunkId(
+        const ProdIndex& prodIndex,
+        const ChunkIndex chunkIndex)
+    : pImpl{new Impl(prodIndex, chunkIndex)}
+{}
+
 ChunkId::operator bool() const noexcept
 {
     return pImpl->operator bool();
@@ -215,19 +338,19 @@ size_t ChunkId::hash() const noexcept
     return pImpl->hash();
 }
 
-bool ChunkId::operator<(const ChunkId& that) const noexcept
+uint64_t ChunkId::pack() const noexcept
 {
-    return pImpl->operator<(*that.pImpl.get());
+    return pImpl->pack();
 }
 
-size_t ChunkId::getStaticSerialSize(const unsigned version) noexcept
+bool ChunkId::operator<(const ChunkId& that) const noexcept
 {
-    return Impl::getStaticSerialSize(version);
+    return pImpl->operator<(*that.pImpl.get());
 }
 
 size_t ChunkId::getSerialSize(const unsigned version) const noexcept
 {
-    return Impl::getStaticSerialSize(version);
+    return pImpl->getSerialSize(version);
 }
 
 size_t ChunkId::serialize(
@@ -237,6 +360,14 @@ size_t ChunkId::serialize(
     return pImpl->serialize(encoder, version);
 }
 
+size_t ChunkId::serializeDelta(
+        Encoder&       encoder,
+        const ChunkId& prev,
+        const unsigned version) const
+{
+    return pImpl->serializeDelta(encoder, *prev.pImpl.get(), version);
+}
+
 ChunkId ChunkId::deserialize(
             Decoder&          decoder,
             const unsigned    version)
@@ -244,6 +375,15 @@ ChunkId ChunkId::deserialize(
     return ChunkId{decoder, version};
 }
 
+ChunkId ChunkId::deserializeDelta(
+        Decoder&       decoder,
+        const ChunkId& prev,
+        const unsigned version)
+{
+    return ChunkId{Impl::deserializeDelta(decoder, *prev.pImpl.get(),
+            version)};
+}
+
 std::string ChunkId::to_string() const
 {
     return pImpl->to_string();
@@ -251,6 +391,17 @@ std::string ChunkId::to_string() const
 
 /******************************************************************************/
 
+ChunkRange::ChunkRange(const ProdInfo& prodInfo)
+    : first{prodInfo, 0}
+    , numChunks{prodInfo.getNumChunks()}
+{}
+
+/******************************************************************************/
+
+const size_t ChunkRangeSet::maxRanges;
+
+/******************************************************************************/
+
 class ChunkInfo::Impl
 {
     ProdInfo   prodInfo;
@@ -494,7 +645,10 @@ public:
          */
         return ChunkId::getStaticSerialSize(version) +
                 ProdSize::getStaticSerialSize(version) +
-                ChunkSize::getStaticSerialSize(version);
+                ChunkSize::getStaticSerialSize(version) +
+                (checksumChunkData
+                        ? Codec::getSerialSize(sizeof(uint32_t))
+                        : 0);
     }
 
     size_t getSerialSize(const unsigned version) const noexcept
@@ -523,6 +677,16 @@ BaseChunk::BaseChunk(Impl* impl)
 
 BaseChunk::~BaseChunk() =default;
 
+void BaseChunk::enableChecksums(const bool enable) noexcept
+{
+    checksumChunkData = enable;
+}
+
+bool BaseChunk::checksumsEnabled() noexcept
+{
+    return checksumChunkData;
+}
+
 ChunkInfo BaseChunk::getInfo() const noexcept
 {
     return pImpl->getInfo();
@@ -577,7 +741,10 @@ size_t BaseChunk::getSerialSize(const unsigned version) const noexcept
 
 class ActualChunk::Impl final : public BaseChunk::Impl
 {
-    const void* data;
+    const void*                              data;
+    /// Optional reference-counted owners of the data. Keep the data alive
+    /// while this instance references it.
+    std::vector<std::shared_ptr<const void>> keepers;
 
 public:
     /**
@@ -586,6 +753,7 @@ public:
     Impl()
         : BaseChunk::Impl{}
         , data(nullptr)
+        , keepers{}
     {}
 
     Impl(   const ProdInfo&    prodInfo,
@@ -593,12 +761,14 @@ public:
             const void*        data)
         : BaseChunk::Impl{prodInfo, chunkIndex}
         , data{data}
+        , keepers{}
     {}
 
     Impl(   const ChunkInfo&   chunkInfo,
             const void*        data)
         : BaseChunk::Impl{chunkInfo}
         , data{data}
+        , keepers{}
     {}
 
     Impl(const Impl& impl) =delete;
@@ -606,6 +776,15 @@ public:
     Impl& operator=(const Impl& rhs) =delete;
     Impl& operator=(const Impl&& rhs) =delete;
 
+    /**
+     * Retains a reference to an owner of the data.
+     * @param[in] keeper  Reference-counted owner of the data
+     */
+    void keepData(std::shared_ptr<const void> keeper)
+    {
+        keepers.push_back(std::move(keeper));
+    }
+
     /**
      * Returns a pointer to the data.
      * @returns a pointer to the data
@@ -633,11 +812,16 @@ public:
          * Keep consistent with
          * - `LatentChunk::Impl::Impl(Decoder&, unsigned)`
          * - `BaseChunk:Impl::getMetadataSize(unsigned)`
+         *
+         * The checksum precedes the data because draining a latent chunk
+         * consumes the rest of the record: a trailer would be unreachable.
          */
-        return info.getId().serialize(encoder, version) +
+        size_t nbytes = info.getId().serialize(encoder, version) +
                 info.getProdSize().serialize(encoder, version) +
-                info.getCanonSize().serialize(encoder, version) +
-                encoder.encode(data, info.getSize());
+                info.getCanonSize().serialize(encoder, version);
+        if (checksumChunkData)
+            nbytes += encoder.encode(crc32c(0, data, info.getSize()));
+        return nbytes + encoder.encode(data, info.getSize());
     }
 
     /**
@@ -672,6 +856,11 @@ ActualChunk::ActualChunk(
     : BaseChunk{new Impl(chunkInfo, data)}
 {}
 
+void ActualChunk::keepData(std::shared_ptr<const void> keeper)
+{
+    static_cast<Impl*>(pImpl.get())->keepData(std::move(keeper));
+}
+
 const void* ActualChunk::getData() const noexcept
 {
     return static_cast<Impl*>(pImpl.get())->getData();
@@ -697,7 +886,9 @@ class LatentChunk::Impl final : public BaseChunk::Impl
     typedef std::shared_ptr<Impl> SharedPimpl;
 
     Decoder*     decoder;
+    const void*  srcData;
     unsigned     version;
+    uint32_t     expectedCrc;
     bool         drained;
 
 public:
@@ -707,10 +898,28 @@ public:
     Impl()
         : BaseChunk::Impl()
         , decoder(nullptr)
+        , srcData{nullptr}
         , version(0)
+        , expectedCrc{0}
         , drained{true}
     {}
 
+    /**
+     * Constructs from a chunk of data that resides in memory.
+     * @param[in] info  Information on the chunk
+     * @param[in] data  Chunk data. *Must* exist until this instance is drained
+     *                  or discarded.
+     */
+    Impl(   const ChunkInfo& info,
+            const void*      data)
+        : BaseChunk::Impl{info}
+        , decoder(nullptr)
+        , srcData{data}
+        , version(0)
+        , expectedCrc{0}
+        , drained{false}
+    {}
+
     /**
      * Constructs from a serialized representation in a decoder.
      * @param[in] decoder      Decoder. *Must* exist for the duration of this
@@ -722,7 +931,9 @@ public:
             const unsigned version)
         : BaseChunk::Impl{}
         , decoder(&decoder)
+        , srcData{nullptr}
         , version(version)
+        , expectedCrc{0}
         , drained{false}
     {
         /*
@@ -733,6 +944,8 @@ public:
         auto chunkId = ChunkId::deserialize(decoder, version);
         auto prodSize = ProdSize::deserialize(decoder, version);
         auto canonChunkSize = ChunkSize::deserialize(decoder, version);
+        if (checksumChunkData)
+            decoder.decode(expectedCrc);
         // Can't get size of UDP message
         // Name is empty
         ProdInfo prodInfo{chunkId.getProdIndex(), prodSize, canonChunkSize};
@@ -754,9 +967,16 @@ public:
 
     /**
      * Drains the chunk of data into a buffer. The latent data will no longer
-     * be available.
+     * be available. A checksum mismatch is a routine consequence of network
+     * corruption, so it's indicated by the return value -- the chunk will be
+     * re-requested -- rather than by an exception, which would cost the
+     * connection that delivered the chunk.
      * @param[in] data            Buffer to drain the chunk of data into
      * @param[in] size            Size of the buffer in bytes
+     * @retval 0                  Checksums are enabled and the data doesn't
+     *                            match the sender's checksum. The buffer's
+     *                            content is unspecified and must be ignored.
+     *                            A warning is logged.
      * @return                    Number of bytes actually transferred
      * @throws std::system_error  I/O error occurred
      * @exceptionsafety           Basic
@@ -768,8 +988,25 @@ public:
     {
         if (drained)
             throw LOGIC_ERROR("Latent chunk-of-data already drained");
+        if (srcData) {
+            // Chunk resides in memory: a single copy and no checksum
+            const size_t chunkSize = info.getSize();
+            const size_t nbytes = size < chunkSize ? size : chunkSize;
+            ::memcpy(data, srcData, nbytes);
+            drained = true;
+            return nbytes;
+        }
         const size_t nbytes = decoder->decode(data, size);
         drained = true;
+        if (checksumChunkData) {
+            const auto actual = crc32c(0, data, nbytes);
+            if (actual != expectedCrc) {
+                LOG_WARN("Corrupt data-chunk " + info.getId().to_string() +
+                        ": CRC32C is " + std::to_string(actual) +
+                        "; should be " + std::to_string(expectedCrc));
+                return 0;
+            }
+        }
         return nbytes;
     }
 
@@ -783,7 +1020,8 @@ public:
     void discard()
     {
         if (!drained) {
-            decoder->clear();
+            if (decoder)
+                decoder->clear();
             drained = true;
         }
     }
@@ -805,7 +1043,8 @@ public:
                 (drained == that.drained) &&
                 (version == that.version) &&
                 (info == that.info) &&
-                (decoder == that.decoder));
+                (decoder == that.decoder) &&
+                (srcData == that.srcData));
     }
 };
 
@@ -819,6 +1058,12 @@ LatentChunk::LatentChunk(
     : BaseChunk{new Impl(decoder, version)}
 {}
 
+LatentChunk::LatentChunk(
+        const ChunkInfo& info,
+        const void*      data)
+    : BaseChunk{new Impl(info, data)}
+{}
+
 LatentChunk LatentChunk::deserialize(
         Decoder&       decoder,
         const unsigned version)
@@ -848,4 +1093,744 @@ bool LatentChunk::operator==(const LatentChunk& that) const noexcept
     return pImpl->operator==(*that.pImpl.get());
 }
 
+/******************************************************************************/
+
+// Definition needed because the member is odr-used (e.g., in comparisons)
+const unsigned ActualChunkRun::maxChunks;
+
+class ActualChunkRun::Impl final
+{
+    std::vector<ActualChunk> chunks;
+
+public:
+    explicit Impl(const std::vector<ActualChunk>& chunks)
+        : chunks{chunks}
+    {
+        if (chunks.empty())
+            throw INVALID_ARGUMENT("Chunk-run is empty");
+        if (chunks.size() > maxChunks)
+            throw INVALID_ARGUMENT("Chunk-run has " +
+                    std::to_string(chunks.size()) + " chunks; maximum is " +
+                    std::to_string(maxChunks));
+        const auto& first = chunks.front();
+        for (size_t i = 1; i < chunks.size(); ++i) {
+            const auto& chunk = chunks[i];
+            if (chunk.getProdIndex() != first.getProdIndex() ||
+                    static_cast<ChunkIndex::type>(chunk.getIndex()) !=
+                    static_cast<ChunkIndex::type>(first.getIndex()) + i)
+                throw INVALID_ARGUMENT("Chunk " + chunk.getId().to_string() +
+                        " doesn't extend run starting at chunk " +
+                        first.getId().to_string());
+        }
+    }
+
+    Impl(const Impl& impl) =delete;
+    Impl(const Impl&& impl) =delete;
+    Impl& operator=(const Impl& rhs) =delete;
+    Impl& operator=(const Impl&& rhs) =delete;
+
+    unsigned getNumChunks() const noexcept
+    {
+        return chunks.size();
+    }
+
+    /**
+     * Serializes this instance to an encoder. The chunks' data is gathered
+     * directly from where it resides -- one segment per chunk -- so it isn't
+     * copied through the serial buffer.
+     * @param[in] encoder  Encoder
+     * @param[in] version  Protocol version
+     * @return             Number of bytes written
+     */
+    size_t serialize(
+            Encoder&       encoder,
+            const unsigned version)
+    {
+        /*
+         * Keep consistent with
+         * - `LatentChunkRun::Impl::Impl(Decoder&, unsigned)`
+         * - `ActualChunkRun::getMaxMetadataSize(unsigned)`
+         *
+         * As with a single chunk, the checksum precedes the data because
+         * draining consumes the rest of the record.
+         */
+        const auto& first = chunks.front();
+        size_t nbytes = first.getId().serialize(encoder, version) +
+                first.getProdSize().serialize(encoder, version) +
+                first.getCanonSize().serialize(encoder, version);
+        nbytes += encoder.encode(
+                static_cast<uint16_t>(chunks.size()));
+        if (BaseChunk::checksumsEnabled()) {
+            uint32_t crc = 0;
+            for (const auto& chunk : chunks)
+                crc = crc32c(crc, chunk.getData(), chunk.getInfo().getSize());
+            nbytes += encoder.encode(crc);
+        }
+        for (const auto& chunk : chunks)
+            nbytes += encoder.encode(chunk.getData(),
+                    chunk.getInfo().getSize());
+        return nbytes;
+    }
+};
+
+ActualChunkRun::ActualChunkRun()
+    : pImpl{}
+{}
+
+ActualChunkRun::ActualChunkRun(const std::vector<ActualChunk>& chunks)
+    : pImpl{new Impl(chunks)}
+{}
+
+unsigned ActualChunkRun::getNumChunks() const noexcept
+{
+    return pImpl->getNumChunks();
+}
+
+size_t ActualChunkRun::serialize(
+        Encoder&       encoder,
+        const unsigned version) const
+{
+    return pImpl->serialize(encoder, version);
+}
+
+/******************************************************************************/
+
+class LatentChunkRun::Impl final
+{
+    Decoder*    decoder;
+    ProdInfo    prodInfo;
+    ChunkIndex  firstIndex;
+    unsigned    numChunks;
+    size_t      totalSize;
+    uint32_t    expectedCrc;
+    bool        drained;
+
+public:
+    /**
+     * Constructs from nothing.
+     */
+    Impl()
+        : decoder{nullptr}
+        , prodInfo{}
+        , firstIndex{0}
+        , numChunks{0}
+        , totalSize{0}
+        , expectedCrc{0}
+        , drained{true}
+    {}
+
+    /**
+     * Constructs from a serialized representation in a decoder.
+     * @param[in] decoder  Decoder. *Must* exist for the duration of this
+     *                     instance
+     * @param[in] version  Protocol version
+     */
+    Impl(   Decoder&       decoder,
+            const unsigned version)
+        : decoder{&decoder}
+        , prodInfo{}
+        , firstIndex{0}
+        , numChunks{0}
+        , totalSize{0}
+        , expectedCrc{0}
+        , drained{false}
+    {
+        /*
+         * Keep consistent with
+         * - `ActualChunkRun::Impl::serialize(Encoder&, unsigned)`
+         * - `ActualChunkRun::getMaxMetadataSize(unsigned)`
+         */
+        auto     chunkId = ChunkId::deserialize(decoder, version);
+        auto     prodSize = ProdSize::deserialize(decoder, version);
+        auto     canonChunkSize = ChunkSize::deserialize(decoder, version);
+        uint16_t num;
+        decoder.decode(num);
+        if (BaseChunk::checksumsEnabled())
+            decoder.decode(expectedCrc);
+        // Name is empty
+        prodInfo = ProdInfo{chunkId.getProdIndex(), prodSize, canonChunkSize};
+        firstIndex = chunkId.getChunkIndex();
+        numChunks = num;
+        for (unsigned i = 0; i < numChunks; ++i)
+            totalSize += getChunkInfo(i).getSize();
+    }
+
+    Impl(const Impl& impl) =delete;
+    Impl(const Impl&& impl) =delete;
+    Impl& operator=(const Impl& rhs) =delete;
+    Impl& operator=(const Impl&& rhs) =delete;
+
+    /**
+     * Destroys. Ensures that any and all data no longer exists.
+     */
+    ~Impl()
+    {
+        discard();
+    }
+
+    unsigned getNumChunks() const noexcept
+    {
+        return numChunks;
+    }
+
+    ChunkInfo getChunkInfo(const unsigned index) const
+    {
+        if (index >= numChunks)
+            throw INVALID_ARGUMENT("Chunk-run index is " +
+                    std::to_string(index) + "; size is " +
+                    std::to_string(numChunks));
+        return ChunkInfo{prodInfo, ChunkIndex{
+                static_cast<ChunkIndex::type>(firstIndex) + index}};
+    }
+
+    size_t getTotalSize() const noexcept
+    {
+        return totalSize;
+    }
+
+    size_t drainData(
+            void* const  data,
+            const size_t size)
+    {
+        if (drained)
+            throw LOGIC_ERROR("Latent chunk-run already drained");
+        const size_t nbytes = decoder->decode(data, size);
+        drained = true;
+        if (BaseChunk::checksumsEnabled()) {
+            const auto actual = crc32c(0, data, nbytes);
+            if (actual != expectedCrc) {
+                LOG_WARN("Corrupt chunk-run of product " +
+                        std::to_string(prodInfo.getIndex()) +
+                        ": CRC32C is " + std::to_string(actual) +
+                        "; should be " + std::to_string(expectedCrc));
+                return 0;
+            }
+        }
+        return nbytes;
+    }
+
+    void discard()
+    {
+        if (!drained) {
+            if (decoder)
+                decoder->clear();
+            drained = true;
+        }
+    }
+
+    bool hasData()
+    {
+        return !drained;
+    }
+};
+
+LatentChunkRun::LatentChunkRun()
+    : pImpl{new Impl()}
+{}
+
+LatentChunkRun::LatentChunkRun(
+        Decoder&       decoder,
+        const unsigned version)
+    : pImpl{new Impl(decoder, version)}
+{}
+
+LatentChunkRun LatentChunkRun::deserialize(
+        Decoder&       decoder,
+        const unsigned version)
+{
+    return LatentChunkRun(decoder, version);
+}
+
+unsigned LatentChunkRun::getNumChunks() const noexcept
+{
+    return pImpl->getNumChunks();
+}
+
+ChunkInfo LatentChunkRun::getChunkInfo(const unsigned index) const
+{
+    return pImpl->getChunkInfo(index);
+}
+
+size_t LatentChunkRun::getTotalSize() const noexcept
+{
+    return pImpl->getTotalSize();
+}
+
+size_t LatentChunkRun::drainData(
+        void* const  data,
+        const size_t size)
+{
+    return pImpl->drainData(data, size);
+}
+
+void LatentChunkRun::discard() const
+{
+    pImpl->discard();
+}
+
+bool LatentChunkRun::hasData()
+{
+    return pImpl->hasData();
+}
+
+/******************************************************************************/
+
+// Definition needed because the member is odr-used (e.g., in comparisons)
+const ChunkSize::type ActualCompressedChunk::minSize;
+
+class ActualCompressedChunk::Impl final
+{
+    ChunkInfo         info;
+    std::vector<char> compressed;
+    uint32_t          crc;
+
+public:
+    /**
+     * Constructs by compressing a data-chunk's data. If the data is
+     * incompressible, `operator bool()` will return false.
+     * @param[in] chunk   Data-chunk to compress
+     * @throw LogicError  Not built with LZ4 support
+     */
+    explicit Impl(const ActualChunk& chunk)
+        : info{chunk.getInfo()}
+        , compressed{}
+        , crc{0}
+    {
+#ifdef USE_LZ4
+        const auto srcSize = info.getSize();
+        /*
+         * The destination capacity is one byte less than the source size, so
+         * LZ4 abandons compression -- cheaply -- as soon as the data proves
+         * incompressible.
+         */
+        compressed.resize(srcSize - 1);
+        const int nbytes = LZ4_compress_default(
+                static_cast<const char*>(chunk.getData()), compressed.data(),
+                srcSize, compressed.size());
+        if (nbytes <= 0) {
+            compressed.clear(); // Incompressible
+        }
+        else {
+            compressed.resize(nbytes);
+            if (BaseChunk::checksumsEnabled())
+                crc = crc32c(0, chunk.getData(), srcSize);
+        }
+#else
+        throw LOGIC_ERROR("Not built with LZ4 support (--enable-lz4)");
+#endif
+    }
+
+    Impl(const Impl& impl) =delete;
+    Impl(const Impl&& impl) =delete;
+    Impl& operator=(const Impl& rhs) =delete;
+    Impl& operator=(const Impl&& rhs) =delete;
+
+    operator bool() const noexcept
+    {
+        return !compressed.empty();
+    }
+
+    const ChunkId getId() const noexcept
+    {
+        return info.getId();
+    }
+
+    size_t serialize(
+            Encoder&       encoder,
+            const unsigned version)
+    {
+        /*
+         * Keep consistent with
+         * - `LatentCompressedChunk::Impl::Impl(Decoder&, unsigned)`
+         * - `ActualCompressedChunk::getMaxMetadataSize(unsigned)`
+         *
+         * The checksum is of the uncompressed data, so a mismatch catches
+         * corruption on either side of the codec as well as on the wire.
+         */
+        size_t nbytes = info.getId().serialize(encoder, version) +
+                info.getProdSize().serialize(encoder, version) +
+                info.getCanonSize().serialize(encoder, version);
+        nbytes += encoder.encode(static_cast<uint32_t>(compressed.size()));
+        if (BaseChunk::checksumsEnabled())
+            nbytes += encoder.encode(crc);
+        return nbytes + encoder.encode(compressed.data(), compressed.size());
+    }
+};
+
+ActualCompressedChunk::ActualCompressedChunk()
+    : pImpl{}
+{}
+
+ActualCompressedChunk::ActualCompressedChunk(const ActualChunk& chunk)
+    : pImpl{new Impl(chunk)}
+{}
+
+ActualCompressedChunk::operator bool() const noexcept
+{
+    return pImpl && pImpl->operator bool();
+}
+
+const ChunkId ActualCompressedChunk::getId() const noexcept
+{
+    return pImpl->getId();
+}
+
+size_t ActualCompressedChunk::serialize(
+        Encoder&       encoder,
+        const unsigned version) const
+{
+    return pImpl->serialize(encoder, version);
+}
+
+/******************************************************************************/
+
+class LatentCompressedChunk::Impl final
+{
+    Decoder*   decoder;
+    ChunkInfo  info;
+    uint32_t   compressedSize;
+    uint32_t   expectedCrc;
+    bool       drained;
+
+public:
+    /**
+     * Constructs from nothing.
+     */
+    Impl()
+        : decoder{nullptr}
+        , info{}
+        , compressedSize{0}
+        , expectedCrc{0}
+        , drained{true}
+    {}
+
+    /**
+     * Constructs from a serialized representation in a decoder.
+     * @param[in] decoder  Decoder. *Must* exist for the duration of this
+     *                     instance
+     * @param[in] version  Protocol version
+     */
+    Impl(   Decoder&       decoder,
+            const unsigned version)
+        : decoder{&decoder}
+        , info{}
+        , compressedSize{0}
+        , expectedCrc{0}
+        , drained{false}
+    {
+        /*
+         * Keep consistent with
+         * - `ActualCompressedChunk::Impl::serialize(Encoder&, unsigned)`
+         * - `ActualCompressedChunk::getMaxMetadataSize(unsigned)`
+         */
+        auto chunkId = ChunkId::deserialize(decoder, version);
+        auto prodSize = ProdSize::deserialize(decoder, version);
+        auto canonChunkSize = ChunkSize::deserialize(decoder, version);
+        decoder.decode(compressedSize);
+        if (BaseChunk::checksumsEnabled())
+            decoder.decode(expectedCrc);
+        // Name is empty
+        ProdInfo prodInfo{chunkId.getProdIndex(), prodSize, canonChunkSize};
+        info = ChunkInfo{prodInfo, chunkId.getChunkIndex()};
+    }
+
+    Impl(const Impl& impl) =delete;
+    Impl(const Impl&& impl) =delete;
+    Impl& operator=(const Impl& rhs) =delete;
+    Impl& operator=(const Impl&& rhs) =delete;
+
+    /**
+     * Destroys. Ensures that any and all data no longer exists.
+     */
+    ~Impl()
+    {
+        discard();
+    }
+
+    ChunkInfo getInfo() const
+    {
+        return info;
+    }
+
+    size_t drainData(
+            void* const  data,
+            const size_t size)
+    {
+        if (drained)
+            throw LOGIC_ERROR("Latent compressed chunk already drained");
+#ifdef USE_LZ4
+        std::vector<char> compressed(compressedSize);
+        const size_t nread = decoder->decode(compressed.data(),
+                compressedSize);
+        drained = true;
+        if (nread != compressedSize)
+            return 0;
+        // A corrupt chunk is dropped; it will be re-requested
+        const int nbytes = LZ4_decompress_safe(compressed.data(),
+                static_cast<char*>(data), compressedSize, size);
+        if (nbytes < 0 ||
+                static_cast<ChunkSize::type>(nbytes) != info.getSize()) {
+            LOG_WARN("Corrupt compressed chunk " + info.getId().to_string() +
+                    ": LZ4 decompression failed");
+            return 0;
+        }
+        if (BaseChunk::checksumsEnabled()) {
+            const auto actual = crc32c(0, data, nbytes);
+            if (actual != expectedCrc) {
+                LOG_WARN("Corrupt compressed chunk " +
+                        info.getId().to_string() + ": CRC32C is " +
+                        std::to_string(actual) + "; should be " +
+                        std::to_string(expectedCrc));
+                return 0;
+            }
+        }
+        return nbytes;
+#else
+        throw LOGIC_ERROR("Not built with LZ4 support (--enable-lz4)");
+#endif
+    }
+
+    void discard()
+    {
+        if (!drained) {
+            if (decoder)
+                decoder->clear();
+            drained = true;
+        }
+    }
+
+    bool hasData()
+    {
+        return !drained;
+    }
+};
+
+LatentCompressedChunk::LatentCompressedChunk()
+    : pImpl{new Impl()}
+{}
+
+LatentCompressedChunk::LatentCompressedChunk(
+        Decoder&       decoder,
+        const unsigned version)
+    : pImpl{new Impl(decoder, version)}
+{}
+
+LatentCompressedChunk LatentCompressedChunk::deserialize(
+        Decoder&       decoder,
+        const unsigned version)
+{
+    return LatentCompressedChunk(decoder, version);
+}
+
+ChunkInfo LatentCompressedChunk::getInfo() const
+{
+    return pImpl->getInfo();
+}
+
+size_t LatentCompressedChunk::drainData(
+        void* const  data,
+        const size_t size)
+{
+    return pImpl->drainData(data, size);
+}
+
+void LatentCompressedChunk::discard() const
+{
+    pImpl->discard();
+}
+
+bool LatentCompressedChunk::hasData()
+{
+    return pImpl->hasData();
+}
+
+/******************************************************************************/
+
+class ActualSmallProd::Impl final
+{
+    ProdInfo    prodInfo;
+    ActualChunk chunk; // Keeps the product's data alive
+
+public:
+    /**
+     * Constructs from a product's information and its single data-chunk.
+     * @param[in] prodInfo     Product information
+     * @param[in] chunk        The product's only data-chunk
+     * @throw InvalidArgument  The product has more than one chunk or the
+     *                         chunk isn't the product's chunk 0
+     */
+    Impl(   const ProdInfo&    prodInfo,
+            const ActualChunk& chunk)
+        : prodInfo{prodInfo}
+        , chunk{chunk}
+    {
+        if (prodInfo.getNumChunks() != 1)
+            throw INVALID_ARGUMENT("Product " +
+                    std::to_string(prodInfo.getIndex()) + " has " +
+                    std::to_string(prodInfo.getNumChunks()) +
+                    " chunks; not 1");
+        if (chunk.getProdIndex() != prodInfo.getIndex() ||
+                static_cast<ChunkIndex::type>(chunk.getIndex()) != 0)
+            throw INVALID_ARGUMENT("Chunk " + chunk.getId().to_string() +
+                    " isn't chunk 0 of product " +
+                    std::to_string(prodInfo.getIndex()));
+    }
+
+    Impl(const Impl& impl) =delete;
+    Impl(const Impl&& impl) =delete;
+    Impl& operator=(const Impl& rhs) =delete;
+    Impl& operator=(const Impl&& rhs) =delete;
+
+    const ProdInfo& getInfo() const noexcept
+    {
+        return prodInfo;
+    }
+
+    size_t serialize(
+            Encoder&       encoder,
+            const unsigned version)
+    {
+        // Keep consistent with `LatentSmallProd::Impl::Impl(Decoder&,
+        // unsigned)`
+        const size_t nbytes = prodInfo.serialize(encoder, version);
+        return nbytes + encoder.encode(chunk.getData(), chunk.getSize());
+    }
+};
+
+ActualSmallProd::ActualSmallProd()
+    : pImpl{}
+{}
+
+ActualSmallProd::ActualSmallProd(
+        const ProdInfo&    prodInfo,
+        const ActualChunk& chunk)
+    : pImpl{new Impl(prodInfo, chunk)}
+{}
+
+const ProdInfo& ActualSmallProd::getInfo() const noexcept
+{
+    return pImpl->getInfo();
+}
+
+size_t ActualSmallProd::serialize(
+        Encoder&       encoder,
+        const unsigned version) const
+{
+    return pImpl->serialize(encoder, version);
+}
+
+/******************************************************************************/
+
+class LatentSmallProd::Impl final
+{
+    Decoder*  decoder;
+    ProdInfo  prodInfo;
+    bool      drained;
+
+public:
+    /**
+     * Constructs from nothing.
+     */
+    Impl()
+        : decoder{nullptr}
+        , prodInfo{}
+        , drained{true}
+    {}
+
+    /**
+     * Constructs from a serialized representation in a decoder.
+     * @param[in] decoder  Decoder. *Must* exist for the duration of this
+     *                     instance
+     * @param[in] version  Protocol version
+     */
+    Impl(   Decoder&       decoder,
+            const unsigned version)
+        : decoder{&decoder}
+        , prodInfo{ProdInfo::deserialize(decoder, version)}
+        , drained{false}
+    {}
+
+    Impl(const Impl& impl) =delete;
+    Impl(const Impl&& impl) =delete;
+    Impl& operator=(const Impl& rhs) =delete;
+    Impl& operator=(const Impl&& rhs) =delete;
+
+    /**
+     * Destroys. Ensures that any and all data no longer exists.
+     */
+    ~Impl()
+    {
+        discard();
+    }
+
+    ProdInfo getInfo() const
+    {
+        return prodInfo;
+    }
+
+    size_t drainData(
+            void* const  data,
+            const size_t size)
+    {
+        if (drained)
+            throw LOGIC_ERROR("Latent small product already drained");
+        const size_t nbytes = decoder->decode(data, size);
+        drained = true;
+        return nbytes;
+    }
+
+    void discard()
+    {
+        if (!drained) {
+            if (decoder)
+                decoder->clear();
+            drained = true;
+        }
+    }
+
+    bool hasData()
+    {
+        return !drained;
+    }
+};
+
+LatentSmallProd::LatentSmallProd()
+    : pImpl{new Impl()}
+{}
+
+LatentSmallProd::LatentSmallProd(
+        Decoder&       decoder,
+        const unsigned version)
+    : pImpl{new Impl(decoder, version)}
+{}
+
+LatentSmallProd LatentSmallProd::deserialize(
+        Decoder&       decoder,
+        const unsigned version)
+{
+    return LatentSmallProd(decoder, version);
+}
+
+ProdInfo LatentSmallProd::getInfo() const
+{
+    return pImpl->getInfo();
+}
+
+size_t LatentSmallProd::drainData(
+        void* const  data,
+        const size_t size)
+{
+    return pImpl->drainData(data, size);
+}
+
+void LatentSmallProd::discard() const
+{
+    pImpl->discard();
+}
+
+bool LatentSmallProd::hasData()
+{
+    return pImpl->hasData();
+}
+
 } // namespace
@@ -29,6 +29,7 @@
 #include <functional>
 #include <functional>
 #include <memory>
+#include <vector>
 
 namespace hycast {
 
@@ -92,7 +93,8 @@ public:
      * @param[in] version  Protocol version
      * @return the number of bytes in the serial representation
      */
-    static size_t getStaticSerialSize(const unsigned version) noexcept {
+    static constexpr size_t getStaticSerialSize(const unsigned version)
+            noexcept {
         return Codec::getSerialSize(sizeof(type));
     }
 
@@ -194,7 +196,8 @@ public:
      * @param[in] version  Protocol version
      * @return the number of bytes in the serial representation
      */
-    static size_t getStaticSerialSize(const unsigned version) noexcept {
+    static constexpr size_t getStaticSerialSize(const unsigned version)
+            noexcept {
         return Codec::getSerialSize(sizeof(type));
     }
 
@@ -259,13 +262,17 @@ public:
     }
 
     /**
-     * Returns the number of bytes in the serial representation of any
-     * instance.
+     * Returns the maximum number of bytes in the serial representation of
+     * any instance. Under the compact encoding (version >= 1) the index is a
+     * varint, so this is a worst case for sizing buffers.
      * @param[in] version  Protocol version
      * @return the number of bytes in the serial representation
      */
-    static size_t getStaticSerialSize(const unsigned version) noexcept {
-        return Codec::getSerialSize(sizeof(type));
+    static constexpr size_t getStaticSerialSize(const unsigned version)
+            noexcept {
+        return version == 0
+                ? Codec::getSerialSize(sizeof(type))
+                : Codec::maxVarintSize;
     }
 
     /**
@@ -275,21 +282,27 @@ public:
      * @return the number of bytes in the serial representation
      */
     inline size_t getSerialSize(unsigned version) const noexcept {
-        return getStaticSerialSize(version);
+        return version == 0
+                ? getStaticSerialSize(version)
+                : Codec::getVarintSize(index);
     }
 
     inline size_t serialize(
             Encoder&       encoder,
             const unsigned version) const
     {
-        return encoder.encode(index);
+        return version == 0
+                ? encoder.encode(index)
+                : encoder.encodeVarint(index);
     }
 
     inline static ChunkIndex deserialize(
             Decoder&       decoder,
             const unsigned version)
     {
-        return SerialInt<type>::deserialize(decoder, version);
+        return version == 0
+                ? ChunkIndex{SerialInt<type>::deserialize(decoder, version)}
+                : ChunkIndex{static_cast<type>(decoder.decodeVarint())};
     }
 
     inline std::string to_string() const
@@ -307,6 +320,12 @@ class ChunkId final : public Serializable<ChunkId>
     class                 Impl;
     std::shared_ptr<Impl> pImpl;
 
+    /**
+     * Constructs from an implementation.
+     * @param[in] impl  Implementation. Ownership is taken.
+     */
+    explicit ChunkId(Impl* impl);
+
 public:
     /**
      * Default constructs.
@@ -337,6 +356,15 @@ public:
      */
     explicit ChunkId(const ChunkInfo& info);
 
+    /**
+     * Constructs. The chunk-index isn't checked against the associated
+     * product's information (cf. `ChunkId(const ProdInfo&, const ChunkIndex)`).
+     * @param[in] prodIndex   Product index
+     * @param[in] chunkIndex  Chunk index
+     */
+    ChunkId(const ProdIndex& prodIndex,
+            const ChunkIndex chunkIndex);
+
     /**
      * Indicates if this instance is valid (i.e., wasn't default constructed).
      * @retval `true`   Instance is valid
@@ -382,6 +410,17 @@ public:
      */
     size_t hash() const noexcept;
 
+    /**
+     * Returns this instance packed into a single word: the product-index in
+     * the upper 32 bits and the chunk-index in the lower 32. Intended for
+     * keying maps: the packed word compares and hashes in one operation
+     * instead of per-field work on every probe.
+     * @return           Packed product-index/chunk-index
+     * @exceptionsafety  Nothrow
+     * @threadsafety     Safe
+     */
+    uint64_t pack() const noexcept;
+
     /**
      * Indicates if this instance is considered less than another.
      * @param[in] that  Other instance
@@ -393,10 +432,16 @@ public:
 
     /**
      * Returns the size of a serialized instance in bytes.
+     * Keep consistent with `ChunkId::Impl`.
      * @param[in] version  Protocol version
      * @return the size of a serialized instance in bytes
      */
-    static size_t getStaticSerialSize(const unsigned version) noexcept;
+    static constexpr size_t getStaticSerialSize(const unsigned version)
+            noexcept {
+        return ProdIndex::getStaticSerialSize(version) +
+                ChunkIndex::getStaticSerialSize(version) +
+                Codec::getSerialSize(sizeof(bool));
+    }
 
     /**
      * Returns the size, in bytes, of the serialized representation of this
@@ -416,6 +461,21 @@ public:
             Encoder&       encoder,
             const unsigned version) const;
 
+    /**
+     * Serializes this instance with its product-index delta-coded against a
+     * predecessor in the same message. Compact encoding only: successive
+     * identifiers in a range-set mostly share or increment the
+     * product-index, so the delta is almost always a one-byte varint.
+     * @param[out] encoder  Encoder
+     * @param[in]  prev     Predecessor in the same message
+     * @param[in]  version  Protocol version. Must not be 0.
+     * @return              Number of bytes written
+     */
+    size_t serializeDelta(
+            Encoder&       encoder,
+            const ChunkId& prev,
+            const unsigned version) const;
+
     /**
      * Returns a new instance corresponding to a serialized representation in a
      * decoder.
@@ -428,6 +488,18 @@ public:
             Decoder&          decoder,
             const unsigned    version);
 
+    /**
+     * Returns a new instance whose product-index is delta-coded against a
+     * predecessor in the same message. Inverse of `serializeDelta()`.
+     * @param[in] decoder  Decoder
+     * @param[in] prev     Predecessor in the same message
+     * @param[in] version  Protocol version. Must not be 0.
+     */
+    static ChunkId deserializeDelta(
+            Decoder&       decoder,
+            const ChunkId& prev,
+            const unsigned version);
+
     /**
      * Returns a string representation of this instance.
      * @return String representation
@@ -437,6 +509,387 @@ public:
 
 /******************************************************************************/
 
+/**
+ * A contiguous range of chunk identifiers within a single data-product. One
+ * instance stands for what would otherwise be a run of individual `ChunkId`
+ * messages, so notifying about every chunk of a product costs one serialized
+ * record instead of one per chunk.
+ */
+class ChunkRange final : public Serializable<ChunkRange>
+{
+    ChunkId    first;     ///< Identifier of first chunk in range
+    ChunkIndex numChunks; ///< Number of chunks in range
+
+public:
+    /**
+     * Default constructs. The range will be empty.
+     */
+    ChunkRange()
+        : first{}
+        , numChunks{0}
+    {}
+
+    /**
+     * Constructs.
+     * @param[in] first      Identifier of the first chunk in the range
+     * @param[in] numChunks  Number of chunks in the range
+     */
+    ChunkRange(
+            const ChunkId&   first,
+            const ChunkIndex numChunks)
+        : first{first}
+        , numChunks{numChunks}
+    {}
+
+    /**
+     * Constructs a range that covers every chunk of a data-product.
+     * @param[in] prodInfo  Product information
+     */
+    explicit ChunkRange(const ProdInfo& prodInfo);
+
+    /**
+     * Indicates if this instance is non-empty.
+     * @retval `true`   Range contains at least one chunk
+     * @retval `false`  Range is empty
+     */
+    inline operator bool() const noexcept
+    {
+        return 0 != static_cast<ChunkIndex::type>(numChunks);
+    }
+
+    /**
+     * Returns the identifier of the first chunk in the range.
+     * @return Identifier of first chunk
+     */
+    inline const ChunkId& getFirst() const noexcept
+    {
+        return first;
+    }
+
+    /**
+     * Returns the number of chunks in the range.
+     * @return Number of chunks in the range
+     */
+    inline ChunkIndex getNumChunks() const noexcept
+    {
+        return numChunks;
+    }
+
+    /**
+     * Returns the identifier of the chunk at an offset into the range.
+     * @param[in] offset  Offset from the first chunk. Must be less than the
+     *                    number of chunks in the range.
+     * @return            Identifier of corresponding chunk
+     */
+    inline ChunkId getChunkId(const ChunkIndex::type offset) const
+    {
+        return ChunkId{first.getProdIndex(),
+                ChunkIndex{first.getChunkIndex() + offset}};
+    }
+
+    /**
+     * Returns the number of bytes in the serial representation of any
+     * instance.
+     * @param[in] version  Protocol version
+     * @return the number of bytes in the serial representation
+     */
+    static constexpr size_t getStaticSerialSize(const unsigned version)
+            noexcept
+    {
+        return ChunkId::getStaticSerialSize(version) +
+                ChunkIndex::getStaticSerialSize(version);
+    }
+
+    /**
+     * Returns the number of bytes in the serial representation of this
+     * instance.
+     * @param[in] version  Protocol version
+     * @return the number of bytes in the serial representation
+     */
+    inline size_t getSerialSize(unsigned version) const noexcept
+    {
+        return getStaticSerialSize(version);
+    }
+
+    inline size_t serialize(
+            Encoder&       encoder,
+            const unsigned version) const
+    {
+        return first.serialize(encoder, version) +
+                numChunks.serialize(encoder, version);
+    }
+
+    inline static ChunkRange deserialize(
+            Decoder&       decoder,
+            const unsigned version)
+    {
+        auto first = ChunkId::deserialize(decoder, version);
+        auto numChunks = ChunkIndex::deserialize(decoder, version);
+        return ChunkRange{first, numChunks};
+    }
+
+    /**
+     * Serializes this instance with its product-index delta-coded against
+     * the preceding range in the same message.
+     * @param[out] encoder  Encoder
+     * @param[in]  prev     Preceding range in the same message
+     * @param[in]  version  Protocol version. Must not be 0.
+     * @return              Number of bytes written
+     */
+    inline size_t serializeDelta(
+            Encoder&          encoder,
+            const ChunkRange& prev,
+            const unsigned    version) const
+    {
+        return first.serializeDelta(encoder, prev.first, version) +
+                numChunks.serialize(encoder, version);
+    }
+
+    /**
+     * Returns a new instance whose product-index is delta-coded against the
+     * preceding range in the same message. Inverse of `serializeDelta()`.
+     * @param[in] decoder  Decoder
+     * @param[in] prev     Preceding range in the same message
+     * @param[in] version  Protocol version. Must not be 0.
+     */
+    inline static ChunkRange deserializeDelta(
+            Decoder&          decoder,
+            const ChunkRange& prev,
+            const unsigned    version)
+    {
+        auto first = ChunkId::deserializeDelta(decoder, prev.first, version);
+        auto numChunks = ChunkIndex::deserialize(decoder, version);
+        return ChunkRange{first, numChunks};
+    }
+
+    inline std::string to_string() const
+    {
+        return "{first=" + first.to_string() + ", numChunks=" +
+                numChunks.to_string() + "}";
+    }
+}; // `ChunkRange`
+
+/******************************************************************************/
+
+/**
+ * A set of chunk identifiers encoded as contiguous ranges. Successively added
+ * identifiers are coalesced into `ChunkRange`s, so a dense sequence (e.g., a
+ * backlog announcement) serializes as a few (product-index, first-index,
+ * count) tuples while a sparse sequence degenerates to an explicit list of
+ * single-chunk ranges. One instance stands for what would otherwise be many
+ * individual notice messages.
+ */
+class ChunkRangeSet final : public Serializable<ChunkRangeSet>
+{
+    /// Type of the serialized range-count. Keep consistent with `serialize()`.
+    typedef uint16_t NumRangesType;
+
+    std::vector<ChunkRange> ranges; ///< Coalesced ranges, in insertion order
+
+public:
+    /// Maximum number of ranges in an instance
+    static const size_t maxRanges = 64;
+
+    /**
+     * Default constructs. The set will be empty.
+     */
+    ChunkRangeSet()
+        : ranges{}
+    {}
+
+    /**
+     * Adds a chunk identifier to the set. The identifier is coalesced into
+     * the last range if it immediately follows it; otherwise, a new
+     * single-chunk range is started.
+     * @param[in] chunkId  Chunk identifier to add
+     * @retval `true`      Identifier was added
+     * @retval `false`     Set is full. The caller should send this instance,
+     *                     clear it, and add the identifier again.
+     */
+    inline bool add(const ChunkId& chunkId)
+    {
+        if (!ranges.empty()) {
+            auto&      last = ranges.back();
+            const auto first = last.getFirst();
+            if (first.getProdIndex() == chunkId.getProdIndex() &&
+                    static_cast<ChunkIndex::type>(first.getChunkIndex()) +
+                    static_cast<ChunkIndex::type>(last.getNumChunks()) ==
+                    static_cast<ChunkIndex::type>(chunkId.getChunkIndex())) {
+                last = ChunkRange{first, ChunkIndex{
+                        static_cast<ChunkIndex::type>(last.getNumChunks())
+                        + 1}};
+                return true;
+            }
+        }
+        if (ranges.size() >= maxRanges)
+            return false;
+        ranges.push_back(ChunkRange{chunkId, ChunkIndex{1}});
+        return true;
+    }
+
+    /**
+     * Adds a whole range to the set. The range isn't coalesced with its
+     * neighbors.
+     * @param[in] range  Range to add
+     * @retval `true`    Range was added
+     * @retval `false`   Set is full. The caller should send this instance,
+     *                   clear it, and add the range again.
+     */
+    inline bool add(const ChunkRange& range)
+    {
+        if (ranges.size() >= maxRanges)
+            return false;
+        ranges.push_back(range);
+        return true;
+    }
+
+    /**
+     * Indicates if this instance is non-empty.
+     * @retval `true`   Set contains at least one chunk identifier
+     * @retval `false`  Set is empty
+     */
+    inline operator bool() const noexcept
+    {
+        return !ranges.empty();
+    }
+
+    /**
+     * Returns the number of ranges in the set.
+     * @return Number of ranges
+     */
+    inline size_t size() const noexcept
+    {
+        return ranges.size();
+    }
+
+    /**
+     * Returns the total number of chunk identifiers in the set.
+     * @return Total number of chunk identifiers
+     */
+    inline ChunkIndex::type getNumChunks() const noexcept
+    {
+        ChunkIndex::type numChunks{0};
+        for (const auto& range : ranges)
+            numChunks += static_cast<ChunkIndex::type>(range.getNumChunks());
+        return numChunks;
+    }
+
+    /**
+     * Removes all ranges from the set.
+     */
+    inline void clear() noexcept
+    {
+        ranges.clear();
+    }
+
+    /**
+     * Returns an iterator over the start of the ranges.
+     * @return Iterator over start of ranges
+     */
+    inline std::vector<ChunkRange>::const_iterator begin() const noexcept
+    {
+        return ranges.begin();
+    }
+
+    /**
+     * Returns an iterator over the end of the ranges.
+     * @return Iterator over end of ranges
+     */
+    inline std::vector<ChunkRange>::const_iterator end() const noexcept
+    {
+        return ranges.end();
+    }
+
+    /**
+     * Returns the number of bytes in the serial representation of the largest
+     * possible instance. Intended for sizing codec buffers.
+     * @param[in] version  Protocol version
+     * @return the number of bytes in the largest serial representation
+     */
+    static constexpr size_t getMaxSerialSize(const unsigned version) noexcept
+    {
+        return (version == 0
+                    ? Codec::getSerialSize(sizeof(NumRangesType))
+                    : Codec::maxVarintSize) +
+                maxRanges * ChunkRange::getStaticSerialSize(version);
+    }
+
+    /**
+     * Returns the number of bytes in the serial representation of this
+     * instance. Under the compact encoding (version >= 1) the sizes are
+     * value-dependent, so this is a worst case for sizing buffers.
+     * @param[in] version  Protocol version
+     * @return the number of bytes in the serial representation
+     */
+    inline size_t getSerialSize(unsigned version) const noexcept
+    {
+        return (version == 0
+                    ? Codec::getSerialSize(sizeof(NumRangesType))
+                    : Codec::getVarintSize(ranges.size())) +
+                ranges.size() * ChunkRange::getStaticSerialSize(version);
+    }
+
+    inline size_t serialize(
+            Encoder&       encoder,
+            const unsigned version) const
+    {
+        if (version == 0) {
+            size_t nbytes = encoder.encode(
+                    static_cast<NumRangesType>(ranges.size()));
+            for (const auto& range : ranges)
+                nbytes += range.serialize(encoder, version);
+            return nbytes;
+        }
+        /*
+         * Compact encoding: varint count, first range in full, then each
+         * further range with its product-index delta-coded against its
+         * predecessor -- successive ranges mostly share or increment the
+         * product-index, so a delta is almost always a one-byte varint.
+         */
+        size_t nbytes = encoder.encodeVarint(ranges.size());
+        for (size_t i = 0; i < ranges.size(); ++i)
+            nbytes += (i == 0)
+                    ? ranges[i].serialize(encoder, version)
+                    : ranges[i].serializeDelta(encoder, ranges[i-1],
+                            version);
+        return nbytes;
+    }
+
+    static ChunkRangeSet deserialize(
+            Decoder&       decoder,
+            const unsigned version)
+    {
+        uint64_t numRanges;
+        if (version == 0) {
+            NumRangesType count;
+            decoder.decode(count);
+            numRanges = count;
+        }
+        else {
+            numRanges = decoder.decodeVarint();
+        }
+        if (numRanges > maxRanges)
+            throw RUNTIME_ERROR("Too many chunk-ranges: " +
+                    std::to_string(numRanges));
+        ChunkRangeSet set{};
+        set.ranges.reserve(numRanges);
+        for (uint64_t i = 0; i < numRanges; ++i)
+            set.ranges.push_back((version == 0 || i == 0)
+                    ? ChunkRange::deserialize(decoder, version)
+                    : ChunkRange::deserializeDelta(decoder,
+                            set.ranges.back(), version));
+        return set;
+    }
+
+    inline std::string to_string() const
+    {
+        return "{numRanges=" + std::to_string(ranges.size()) +
+                ", numChunks=" + std::to_string(getNumChunks()) + "}";
+    }
+}; // `ChunkRangeSet`
+
+/******************************************************************************/
+
 class ChunkInfo
 {
     class                 Impl;
@@ -585,6 +1038,43 @@ public:
      */
     virtual ~BaseChunk() =0;
 
+    /**
+     * Enables or disables end-to-end checksums on chunk data. When enabled,
+     * `ActualChunk::serialize()` appends a CRC32C checksum of the data to the
+     * serialized representation and `LatentChunk::drainData()` verifies it,
+     * which catches corruption that the transport checksums miss. Both ends
+     * of a connection must agree on this setting. Disabled by default.
+     * @param[in] enable  Whether or not to checksum chunk data
+     * @exceptionsafety   Nothrow
+     * @threadsafety      Safe
+     */
+    static void enableChecksums(const bool enable) noexcept;
+
+    /**
+     * Indicates if end-to-end checksums on chunk data are enabled.
+     * @retval `true`    Checksums are enabled
+     * @retval `false`   Checksums are not enabled
+     * @exceptionsafety  Nothrow
+     * @threadsafety     Safe
+     */
+    static bool checksumsEnabled() noexcept;
+
+    /**
+     * Returns an upper bound, known at compile time, on the number of bytes
+     * in the metadata of a serialized data-chunk -- whether or not checksums
+     * are enabled. Keep consistent with `BaseChunk::Impl::getMetadataSize()`.
+     * @param[in] version  Protocol version
+     * @return             Maximum number of bytes in serialized metadata
+     */
+    static constexpr size_t getMaxMetadataSize(const unsigned version)
+            noexcept
+    {
+        return ChunkId::getStaticSerialSize(version) +
+                ProdSize::getStaticSerialSize(version) +
+                ChunkSize::getStaticSerialSize(version) +
+                Codec::getSerialSize(sizeof(uint32_t)); // CRC32C
+    }
+
     /**
      * Indicates if this instance is valid (i.e., wasn't default constructed).
      * @retval `true`   Instance is valid
@@ -703,6 +1193,21 @@ public:
             const ChunkInfo& chunkInfo,
             const void*      data);
 
+    /**
+     * Retains a reference to the owner of this instance's data so that the
+     * data exists for at least the lifetime of this instance -- even if all
+     * other references to the owner are dropped (e.g., because the associated
+     * data-product was deleted while this instance sat in a peer's
+     * send-queue). The data is still not copied: this instance continues to
+     * reference the owner's data region directly.
+     * May be called more than once; every owner is retained (e.g., both a
+     *  file-product's implementation and its memory-mapping).
+     * @param[in] keeper  Reference-counted owner of the data
+     * @exceptionsafety   Strong guarantee
+     * @threadsafety      Compatible but not safe
+     */
+    void keepData(std::shared_ptr<const void> keeper);
+
     /**
      * Returns a pointer to the data.
      * @returns a pointer to the data
@@ -757,6 +1262,17 @@ public:
             Decoder&       decoder,
             const unsigned version);
 
+    /**
+     * Constructs from a chunk of data that resides in memory. Draining such a
+     * chunk is a single copy from the given data into the destination buffer.
+     * @param[in] info  Information on the chunk
+     * @param[in] data  Chunk data. *Must* exist until this instance is drained
+     *                  or discarded.
+     */
+    LatentChunk(
+            const ChunkInfo& info,
+            const void*      data);
+
     static LatentChunk deserialize(
             Decoder&       decoder,
             const unsigned version);
@@ -800,6 +1316,461 @@ public:
     bool operator ==(const LatentChunk& that) const noexcept;
 };
 
+/******************************************************************************/
+
+/**
+ * A contiguous run of memory-based data-chunks of one data-product that is
+ * transmitted as a single message. Coalescing a run amortizes the per-chunk
+ * message overhead (header, system call, bookkeeping) over the run, which is
+ * what bounds peer-to-peer backlog throughput for large products.
+ */
+class ActualChunkRun final
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Maximum number of data-chunks per run. Bounded by the number of gather
+     * segments an encoder supports (`Codec::maxDmaSegs`), so the chunks'
+     * data is transmitted zero-copy from the product-store.
+     */
+    static const unsigned maxChunks = 8;
+
+    /**
+     * Default constructs. Any attempt to use the resulting instance will
+     * throw an exception.
+     */
+    ActualChunkRun();
+
+    /**
+     * Constructs.
+     * @param[in] chunks       Data-chunks of the run. Must be non-empty,
+     *                         belong to the same data-product, have
+     *                         consecutive chunk-indexes, and number at most
+     *                         `maxChunks`.
+     * @throw InvalidArgument  The chunks don't form a valid run
+     */
+    explicit ActualChunkRun(const std::vector<ActualChunk>& chunks);
+
+    /**
+     * Returns the number of data-chunks in the run.
+     * @return Number of data-chunks
+     */
+    unsigned getNumChunks() const noexcept;
+
+    /**
+     * Serializes this instance to an encoder.
+     * @param[in] encoder  Encoder
+     * @param[in] version  Protocol version
+     * @return             Number of bytes written
+     * @exceptionsafety    Basic
+     * @threadsafety       Compatible but not safe
+     */
+    size_t serialize(
+            Encoder&       encoder,
+            const unsigned version) const;
+
+    /**
+     * Returns an upper bound, known at compile time, on the number of bytes
+     * in the metadata of a serialized chunk-run -- whether or not checksums
+     * are enabled.
+     * @param[in] version  Protocol version
+     * @return             Maximum number of bytes in serialized metadata
+     */
+    static constexpr size_t getMaxMetadataSize(const unsigned version)
+            noexcept
+    {
+        return BaseChunk::getMaxMetadataSize(version) +
+                Codec::getSerialSize(sizeof(uint16_t)); // Number of chunks
+    }
+};
+
+/******************************************************************************/
+
+/**
+ * A contiguous run of data-chunks whose data must be drained from a decoder.
+ */
+class LatentChunkRun final
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Default constructs. Any attempt to use the resulting instance will
+     * throw an exception.
+     */
+    LatentChunkRun();
+
+    /**
+     * Constructs from a serialized representation in a decoder. Reads the
+     * run's metadata; the chunks' data remains in the decoder until
+     * `drainData()` or `discard()` is called.
+     * @param[in] decoder  Decoder. *Must* exist for the duration of this
+     *                     instance
+     * @param[in] version  Protocol version
+     */
+    LatentChunkRun(
+            Decoder&       decoder,
+            const unsigned version);
+
+    /**
+     * Returns an instance corresponding to a serialized representation in a
+     * decoder.
+     * @param[in] decoder  Decoder
+     * @param[in] version  Protocol version
+     */
+    static LatentChunkRun deserialize(
+            Decoder&       decoder,
+            const unsigned version);
+
+    /**
+     * Returns the number of data-chunks in the run.
+     * @return Number of data-chunks
+     */
+    unsigned getNumChunks() const noexcept;
+
+    /**
+     * Returns information on a data-chunk of the run. The product name will
+     * be empty.
+     * @param[in] index  Origin-0 index of the chunk within the run
+     * @return           Information on the chunk
+     */
+    ChunkInfo getChunkInfo(const unsigned index) const;
+
+    /**
+     * Returns the total number of bytes of chunk data in the run.
+     * @return Total number of bytes of chunk data
+     */
+    size_t getTotalSize() const noexcept;
+
+    /**
+     * Drains the data of all the run's chunks, concatenated in chunk-index
+     * order, into a buffer. The latent data will no longer be available.
+     * @param[in] data   Buffer to drain the data into. Should be at least
+     *                   `getTotalSize()` bytes.
+     * @param[in] size   Size of the buffer in bytes
+     * @retval 0         Checksums are enabled and the data doesn't match the
+     *                   sender's checksum. The buffer's content must be
+     *                   ignored. A warning is logged.
+     * @return           Number of bytes actually transferred
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety  Basic
+     * @threadsafety     Safe
+     */
+    size_t drainData(
+            void* const  data,
+            const size_t size);
+
+    /**
+     * Discards the data of the run. The latent data will no longer be
+     * available. Idempotent.
+     * @throws std::system_error  I/O error occurred
+     */
+    void discard() const;
+
+    /**
+     * Indicates if this instance has data (i.e., whether or not `drainData()`
+     * has been called).
+     * @retval true   This instance has data
+     * @retval false  This instance doesn't have data
+     */
+    bool hasData();
+};
+
+/******************************************************************************/
+
+/**
+ * A memory-based data-chunk whose data is sent LZ4-compressed. Intended for
+ * bandwidth-constrained peer links: model-output products typically compress
+ * 2.5-4x, so compressing chunk payloads multiplies effective link bandwidth at
+ * a small CPU cost. Only used on an association if both peers advertised the
+ * capability (`VersionMsg::LZ4_CHUNKS`). Requires building with
+ * `--enable-lz4`; otherwise, construction throws.
+ */
+class ActualCompressedChunk final
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Minimum size, in bytes, of a data-chunk worth compressing. Below this,
+     * the per-chunk metadata dominates and compression doesn't pay.
+     */
+    static const ChunkSize::type minSize = 512;
+
+    /**
+     * Default constructs. Any attempt to use the resulting instance will
+     * throw an exception.
+     */
+    ActualCompressedChunk();
+
+    /**
+     * Constructs by compressing a data-chunk's data. If the data is
+     * incompressible (the compressed form wouldn't be smaller), the resulting
+     * instance is invalid and the chunk should be sent uncompressed; LZ4
+     * detects this cheaply, so probing costs little on incompressible data.
+     * @param[in] chunk       Data-chunk to compress
+     * @throw LogicError      Not built with LZ4 support
+     * @throw InvalidArgument The chunk is invalid
+     */
+    explicit ActualCompressedChunk(const ActualChunk& chunk);
+
+    /**
+     * Indicates if this instance is valid (i.e., the data compressed).
+     * @retval `true`   Instance is valid
+     * @retval `false`  Instance is not valid
+     */
+    operator bool() const noexcept;
+
+    /**
+     * Returns the chunk identifier.
+     * @return Chunk identifier
+     */
+    const ChunkId getId() const noexcept;
+
+    /**
+     * Serializes this instance to an encoder. The payload is the LZ4
+     * block-compressed chunk data.
+     * @param[in] encoder  Encoder
+     * @param[in] version  Protocol version
+     * @return             Number of bytes written
+     * @exceptionsafety    Basic
+     * @threadsafety       Compatible but not safe
+     */
+    size_t serialize(
+            Encoder&       encoder,
+            const unsigned version) const;
+
+    /**
+     * Returns an upper bound, known at compile time, on the number of bytes
+     * in the metadata of a serialized compressed chunk.
+     * @param[in] version  Protocol version
+     * @return             Maximum number of bytes in serialized metadata
+     */
+    static constexpr size_t getMaxMetadataSize(const unsigned version)
+            noexcept
+    {
+        return BaseChunk::getMaxMetadataSize(version) +
+                Codec::getSerialSize(sizeof(uint32_t)); // Compressed size
+    }
+};
+
+/******************************************************************************/
+
+/**
+ * An LZ4-compressed data-chunk whose data must be drained from a decoder.
+ */
+class LatentCompressedChunk final
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Default constructs. Any attempt to use the resulting instance will
+     * throw an exception.
+     */
+    LatentCompressedChunk();
+
+    /**
+     * Constructs from a serialized representation in a decoder. Reads the
+     * chunk's metadata; the compressed data remains in the decoder until
+     * `drainData()` or `discard()` is called.
+     * @param[in] decoder  Decoder. *Must* exist for the duration of this
+     *                     instance
+     * @param[in] version  Protocol version
+     */
+    LatentCompressedChunk(
+            Decoder&       decoder,
+            const unsigned version);
+
+    /**
+     * Returns an instance corresponding to a serialized representation in a
+     * decoder.
+     * @param[in] decoder  Decoder
+     * @param[in] version  Protocol version
+     */
+    static LatentCompressedChunk deserialize(
+            Decoder&       decoder,
+            const unsigned version);
+
+    /**
+     * Returns information on the data-chunk. The product name will be empty.
+     * @return Information on the chunk
+     */
+    ChunkInfo getInfo() const;
+
+    /**
+     * Drains the chunk's data, decompressed, into a buffer. The latent data
+     * will no longer be available.
+     * @param[in] data   Buffer to drain the decompressed data into. Should be
+     *                   at least `getInfo().getSize()` bytes.
+     * @param[in] size   Size of the buffer in bytes
+     * @retval 0         The data is corrupt (failed decompression or, if
+     *                   checksums are enabled, a checksum mismatch). The
+     *                   buffer's content must be ignored. A warning is
+     *                   logged.
+     * @return           Number of decompressed bytes transferred
+     * @throw LogicError          Not built with LZ4 support
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety  Basic
+     * @threadsafety     Safe
+     */
+    size_t drainData(
+            void* const  data,
+            const size_t size);
+
+    /**
+     * Discards the data of the chunk. The latent data will no longer be
+     * available. Idempotent.
+     * @throws std::system_error  I/O error occurred
+     */
+    void discard() const;
+
+    /**
+     * Indicates if this instance has data (i.e., whether or not `drainData()`
+     * has been called).
+     * @retval true   This instance has data
+     * @retval false  This instance doesn't have data
+     */
+    bool hasData();
+};
+
+/******************************************************************************/
+
+/**
+ * A small, complete data-product in a single message: the product-information
+ * followed by the product's entire data. Most products by count fit one
+ * chunk, and for them the per-product overhead -- a product-information
+ * message, a separate chunk message, and store assembly -- dominates the
+ * bandwidth, so the combined message halves it for the common case. Used on
+ * a peer association only if both peers advertised the capability
+ * (`VersionMsg::SMALL_PRODUCTS`).
+ */
+class ActualSmallProd final
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Default constructs. Any attempt to use the resulting instance will
+     * throw an exception.
+     */
+    ActualSmallProd();
+
+    /**
+     * Constructs from a product's information and its single data-chunk.
+     * @param[in] prodInfo         Product information. Must describe a
+     *                             single-chunk product.
+     * @param[in] chunk            The product's only data-chunk. Keeps the
+     *                             data alive for the life of this instance.
+     * @throw InvalidArgument      The product has more than one chunk or the
+     *                             chunk isn't the product's chunk 0
+     */
+    ActualSmallProd(
+            const ProdInfo&    prodInfo,
+            const ActualChunk& chunk);
+
+    /**
+     * Returns information on the product.
+     * @return Information on the product
+     */
+    const ProdInfo& getInfo() const noexcept;
+
+    /**
+     * Serializes this instance to an encoder. The payload is the product's
+     * entire data.
+     * @param[in] encoder  Encoder
+     * @param[in] version  Protocol version
+     * @return             Number of bytes written
+     * @exceptionsafety    Basic
+     * @threadsafety       Compatible but not safe
+     */
+    size_t serialize(
+            Encoder&       encoder,
+            const unsigned version) const;
+};
+
+/******************************************************************************/
+
+/**
+ * A small, complete data-product whose data must be drained from a decoder.
+ */
+class LatentSmallProd final
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Default constructs. Any attempt to use the resulting instance will
+     * throw an exception.
+     */
+    LatentSmallProd();
+
+    /**
+     * Constructs from a serialized representation in a decoder. Reads the
+     * product-information; the product's data remains in the decoder until
+     * `drainData()` or `discard()` is called.
+     * @param[in] decoder  Decoder. *Must* exist for the duration of this
+     *                     instance
+     * @param[in] version  Protocol version
+     */
+    LatentSmallProd(
+            Decoder&       decoder,
+            const unsigned version);
+
+    /**
+     * Returns an instance corresponding to a serialized representation in a
+     * decoder.
+     * @param[in] decoder  Decoder
+     * @param[in] version  Protocol version
+     */
+    static LatentSmallProd deserialize(
+            Decoder&       decoder,
+            const unsigned version);
+
+    /**
+     * Returns information on the product.
+     * @return Information on the product
+     */
+    ProdInfo getInfo() const;
+
+    /**
+     * Drains the product's data into a buffer. The latent data will no
+     * longer be available.
+     * @param[in] data   Buffer to drain the data into. Should be at least
+     *                   `getInfo().getSize()` bytes.
+     * @param[in] size   Size of the buffer in bytes
+     * @return           Number of bytes transferred
+     * @throws std::system_error  I/O error occurred
+     * @exceptionsafety  Basic
+     * @threadsafety     Safe
+     */
+    size_t drainData(
+            void* const  data,
+            const size_t size);
+
+    /**
+     * Discards the data of the product. The latent data will no longer be
+     * available. Idempotent.
+     * @throws std::system_error  I/O error occurred
+     */
+    void discard() const;
+
+    /**
+     * Indicates if this instance has data (i.e., whether or not `drainData()`
+     * has been called).
+     * @retval true   This instance has data
+     * @retval false  This instance doesn't have data
+     */
+    bool hasData();
+};
+
 } // namespace
 
 /******************************************************************************/
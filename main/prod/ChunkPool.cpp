@@ -0,0 +1,242 @@
+/**
+ * This file implements a thread-safe pool of fixed-size buffers for the
+ * payloads of data-chunks.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: ChunkPool.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "ChunkPool.h"
+#include "error.h"
+
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace hycast {
+
+class ChunkPool::Impl final : public std::enable_shared_from_this<ChunkPool::Impl>
+{
+    typedef std::mutex             Mutex;
+    typedef std::lock_guard<Mutex> LockGuard;
+
+    mutable Mutex      mutex;
+    std::vector<char*> freeBufs;
+    const size_t       bufSize;
+    const size_t       maxFree;
+
+public:
+    /**
+     * Constructs.
+     * @param[in] bufSize  Size of each buffer in bytes
+     * @param[in] maxFree  Maximum number of unused buffers to retain
+     * @throws InvalidArgument  `bufSize == 0`
+     */
+    Impl(   const size_t bufSize,
+            const size_t maxFree)
+        : mutex{}
+        , freeBufs{}
+        , bufSize{bufSize}
+        , maxFree{maxFree}
+    {
+        if (bufSize == 0)
+            throw INVALID_ARGUMENT("Zero buffer-size");
+    }
+
+    Impl(const Impl& impl) =delete;
+    Impl& operator=(const Impl& rhs) =delete;
+
+    ~Impl()
+    {
+        for (auto buf : freeBufs)
+            delete[] buf;
+    }
+
+    /**
+     * Returns a buffer. An unused buffer is recycled if one exists;
+     * otherwise, a new buffer is allocated.
+     * @return Pointer to buffer of `bufSize` bytes
+     */
+    char* get()
+    {
+        {
+            LockGuard lock{mutex};
+            if (!freeBufs.empty()) {
+                char* const buf = freeBufs.back();
+                freeBufs.pop_back();
+                return buf;
+            }
+        }
+        return new char[bufSize];
+    }
+
+    /**
+     * Returns a buffer to the pool. The buffer is freed if the pool already
+     * retains `maxFree` unused buffers.
+     * @param[in] buf  Buffer previously returned by `get()`
+     */
+    void put(char* const buf) noexcept
+    {
+        {
+            LockGuard lock{mutex};
+            if (freeBufs.size() < maxFree) {
+                try {
+                    freeBufs.push_back(buf);
+                    return;
+                }
+                catch (const std::exception& ex) {
+                }
+            }
+        }
+        delete[] buf;
+    }
+
+    /**
+     * Pre-allocates unused buffers, touching every page of each so the
+     * pages are faulted in now rather than on the receive path.
+     * @param[in] numBufs  Number of unused buffers the pool should retain.
+     *                     Capped at the pool's retention limit.
+     */
+    void prewarm(const size_t numBufs)
+    {
+        LockGuard  lock{mutex};
+        const auto limit = (numBufs < maxFree) ? numBufs : maxFree;
+        while (freeBufs.size() < limit) {
+            char* const buf = new char[bufSize];
+            ::memset(buf, 0, bufSize);
+            try {
+                freeBufs.push_back(buf);
+            }
+            catch (const std::exception& ex) {
+                delete[] buf;
+                throw;
+            }
+        }
+    }
+
+    size_t getBufSize() const noexcept
+    {
+        return bufSize;
+    }
+
+    size_t numFree() const noexcept
+    {
+        LockGuard lock{mutex};
+        return freeBufs.size();
+    }
+};
+
+/******************************************************************************/
+
+class ChunkPool::Buffer::Impl final
+{
+    std::shared_ptr<ChunkPool::Impl> pool;
+    char* const                      buf;
+
+public:
+    /**
+     * Constructs.
+     * @param[in] pool  Pool that the buffer belongs to
+     * @param[in] buf   Buffer drawn from the pool
+     */
+    Impl(   const std::shared_ptr<ChunkPool::Impl>& pool,
+            char* const                             buf)
+        : pool{pool}
+        , buf{buf}
+    {}
+
+    Impl(const Impl& impl) =delete;
+    Impl& operator=(const Impl& rhs) =delete;
+
+    /**
+     * Destroys. Returns the buffer to its pool.
+     */
+    ~Impl()
+    {
+        pool->put(buf);
+    }
+
+    char* data() const noexcept
+    {
+        return buf;
+    }
+
+    size_t size() const noexcept
+    {
+        return pool->getBufSize();
+    }
+};
+
+ChunkPool::Buffer::Buffer()
+    : pImpl{}
+{}
+
+ChunkPool::Buffer::Buffer(Impl* impl)
+    : pImpl{impl}
+{}
+
+ChunkPool::Buffer::operator bool() const noexcept
+{
+    return pImpl.operator bool();
+}
+
+char* ChunkPool::Buffer::data() const noexcept
+{
+    return pImpl->data();
+}
+
+size_t ChunkPool::Buffer::size() const noexcept
+{
+    return pImpl->size();
+}
+
+/******************************************************************************/
+
+ChunkPool::ChunkPool()
+    : pImpl{}
+{}
+
+ChunkPool::ChunkPool(
+        const size_t bufSize,
+        const size_t maxFree)
+    : pImpl{new Impl(bufSize, maxFree)}
+{}
+
+ChunkPool ChunkPool::getShared(const size_t bufSize)
+{
+    static std::mutex                 mutex;
+    static std::map<size_t, ChunkPool> pools;
+    std::lock_guard<std::mutex> lock{mutex};
+    auto iter = pools.find(bufSize);
+    if (iter == pools.end())
+        iter = pools.emplace(bufSize, ChunkPool{bufSize}).first;
+    return iter->second;
+}
+
+ChunkPool::Buffer ChunkPool::get()
+{
+    return Buffer{new Buffer::Impl(pImpl, pImpl->get())};
+}
+
+void ChunkPool::prewarm(const size_t numBufs)
+{
+    pImpl->prewarm(numBufs);
+}
+
+size_t ChunkPool::getBufSize() const noexcept
+{
+    return pImpl->getBufSize();
+}
+
+size_t ChunkPool::numFree() const noexcept
+{
+    return pImpl->numFree();
+}
+
+} // namespace
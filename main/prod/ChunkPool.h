@@ -0,0 +1,139 @@
+/**
+ * This file declares a thread-safe pool of fixed-size buffers for the payloads
+ * of data-chunks. Buffers are recycled when their handles are destroyed, which
+ * keeps the per-chunk hot path free of heap allocation.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: ChunkPool.h
+ * @author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_PROD_CHUNKPOOL_H_
+#define MAIN_PROD_CHUNKPOOL_H_
+
+#include "Chunk.h"
+
+#include <cstddef>
+#include <memory>
+
+namespace hycast {
+
+class ChunkPool final
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Handle for a buffer drawn from a pool. The buffer is returned to the
+     * pool when the last copy of its handle is destroyed.
+     */
+    class Buffer final
+    {
+        friend class ChunkPool;
+
+        class                 Impl;
+        std::shared_ptr<Impl> pImpl;
+
+        Buffer(Impl* impl);
+
+    public:
+        /**
+         * Default constructs. The instance will be invalid.
+         */
+        Buffer();
+
+        /**
+         * Indicates if this instance is valid (i.e., wasn't default
+         * constructed).
+         * @retval `true`   Instance is valid
+         * @retval `false`  Instance is not valid
+         */
+        operator bool() const noexcept;
+
+        /**
+         * Returns a pointer to the buffer's data.
+         * @return Pointer to data
+         * @exceptionsafety Nothrow
+         * @threadsafety    Safe
+         */
+        char* data() const noexcept;
+
+        /**
+         * Returns the size of the buffer in bytes.
+         * @return Size of buffer in bytes
+         * @exceptionsafety Nothrow
+         * @threadsafety    Safe
+         */
+        size_t size() const noexcept;
+    }; // `Buffer`
+
+    /**
+     * Default constructs. The instance will be invalid.
+     */
+    ChunkPool();
+
+    /**
+     * Constructs.
+     * @param[in] bufSize  Size of each buffer in bytes
+     * @param[in] maxFree  Maximum number of unused buffers to retain.
+     *                     Additional buffers are freed when returned.
+     * @throws InvalidArgument  `bufSize == 0`
+     */
+    explicit ChunkPool(
+            const size_t bufSize,
+            const size_t maxFree = 128);
+
+    /**
+     * Returns the process-wide shared pool for a given buffer size, created
+     * on first use. Components in one process that buffer same-sized chunk
+     * payloads (e.g., several feeds in a consolidated relay process) then
+     * recycle from one arena instead of each retaining its own free buffers.
+     * @param[in] bufSize  Size of each buffer in bytes
+     * @return             Process-wide shared pool for `bufSize`-byte buffers
+     * @throws InvalidArgument  `bufSize == 0`
+     * @exceptionsafety    Strong guarantee
+     * @threadsafety       Safe
+     */
+    static ChunkPool getShared(const size_t bufSize);
+
+    /**
+     * Returns a buffer from the pool. An unused buffer is recycled if one
+     * exists; otherwise, a new buffer is allocated.
+     * @return               Buffer of `bufSize` bytes
+     * @exceptionsafety      Strong guarantee
+     * @threadsafety         Safe
+     */
+    Buffer get();
+
+    /**
+     * Pre-allocates unused buffers, touching every page of each so the
+     * pages are faulted in -- and, under `MemResidency::enable()`, locked
+     * -- at startup rather than on the receive path.
+     * @param[in] numBufs  Number of unused buffers the pool should retain.
+     *                     Capped at the pool's retention limit.
+     * @throws std::bad_alloc  Necessary memory can't be allocated
+     * @exceptionsafety    Basic guarantee
+     * @threadsafety       Safe
+     */
+    void prewarm(const size_t numBufs);
+
+    /**
+     * Returns the size of each buffer in bytes.
+     * @return Size of each buffer in bytes
+     */
+    size_t getBufSize() const noexcept;
+
+    /**
+     * Returns the number of unused buffers currently retained by the pool.
+     * @return Number of unused buffers
+     */
+    size_t numFree() const noexcept;
+}; // `ChunkPool`
+
+} // namespace
+
+#endif /* MAIN_PROD_CHUNKPOOL_H_ */
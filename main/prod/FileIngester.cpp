@@ -19,14 +19,26 @@
 
 #include "error.h"
 #include "FileIngester.h"
+#include "StealingExecutor.h"
+#include "Thread.h"
 
 #include <chrono>
+#include <condition_variable>
+#include <cstring>
 #include <dirent.h>
+#include <exception>
 #include <fcntl.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <poll.h>
+#include <queue>
 #include <stack>
 #include <sys/inotify.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <unordered_map>
 
 namespace hycast {
 
@@ -51,9 +63,18 @@ class FileIngester::Impl : public Ingester::Impl
                 throw SYSTEM_ERROR(std::string{"opendir() failure on \""} +
                         pathname + "\"");
         }
+        DirEntry(DirEntry&& that) noexcept
+            : dir{that.dir}
+            , pathname{std::move(that.pathname)}
+        {
+            that.dir = nullptr; // Lest the directory be closed twice
+        }
+        DirEntry(const DirEntry&) =delete;
+        DirEntry& operator=(const DirEntry&) =delete;
         ~DirEntry() noexcept
         {
-            ::closedir(dir);
+            if (dir)
+                ::closedir(dir);
         }
         const std::string makePathname(const std::string& filename)
         {
@@ -62,13 +83,18 @@ class FileIngester::Impl : public Ingester::Impl
         bool next(std::string& filename)
         {
             struct dirent  entry, *result;
-            auto           status = ::readdir_r(dir, &entry, &result);
-            if (status)
-                throw SYSTEM_ERROR("readdir() failure on directory \"" +
-                        pathname + "\"", status);
-            if (result == nullptr) {
-                // Nothing more in current directory
-                return false;
+            for (;;) {
+                auto status = ::readdir_r(dir, &entry, &result);
+                if (status)
+                    throw SYSTEM_ERROR("readdir() failure on directory \"" +
+                            pathname + "\"", status);
+                if (result == nullptr) {
+                    // Nothing more in current directory
+                    return false;
+                }
+                if (::strcmp(entry.d_name, ".") &&
+                        ::strcmp(entry.d_name, ".."))
+                    break;
             }
             filename = makePathname(entry.d_name);
             return true;
@@ -99,12 +125,66 @@ class FileIngester::Impl : public Ingester::Impl
 
     typedef std::chrono::system_clock      Clock;
     typedef std::chrono::time_point<Clock> TimePoint;
+    typedef std::mutex                     Mutex;
+    typedef std::lock_guard<Mutex>         LockGuard;
+    typedef std::unique_lock<Mutex>        UniqueLock;
+    typedef std::condition_variable        Cond;
+
+    /**
+     * Outcome of one file-to-product conversion.
+     */
+    struct Conversion
+    {
+        Product            prod;
+        std::exception_ptr ex;
+    };
 
-    const std::string dirPathname;
-    const int         fd;
-    TimePoint         start;
-    bool              scanDir;
-    DirStack          dirStack;
+    /// Size of the inotify(7) event buffer in bytes. Large enough that a
+    /// burst of arrivals is drained with few read() system calls
+    static const size_t   eventBufSize = 64*1024;
+    /// Maximum number of pre-existing files converted per batch
+    static const unsigned scanBatchSize = 512;
+
+    const std::string                    dirPathname;
+    const int                            fd;
+    TimePoint                            start;
+    bool                                 scanDir;
+    DirStack                             dirStack;
+    /// Index for the next data-product
+    ProdIndex                            prodIndex;
+    /// Pathnames of completed files in event order
+    std::queue<std::string>              arrivals;
+    /// Pathname of the directory that a watch-descriptor watches
+    std::unordered_map<int, std::string> watchDirs;
+    /// Guards `conversions`
+    Mutex                                mutex;
+    /// Signaled when a conversion completes
+    Cond                                 cond;
+    /// Sequence number of the next conversion to be submitted
+    unsigned long                        nextSubmitSeq;
+    /// Sequence number of the next conversion to be delivered
+    unsigned long                        nextDeliverSeq;
+    /// Completed conversions by sequence number
+    std::map<unsigned long, Conversion>  conversions;
+    /// Worker pool for file-to-product conversions. Empty in serial mode.
+    /// Declared last so that the workers complete before the other members
+    /// are destroyed
+    std::unique_ptr<StealingExecutor<void>> executor;
+
+    /**
+     * Adds an inotify(7) watch on a directory.
+     * @param[in] pathname  Pathname of the directory
+     * @throws SystemError  `inotify_add_watch()` failure
+     */
+    void addWatch(const std::string& pathname)
+    {
+        const auto wd = ::inotify_add_watch(fd, pathname.data(),
+                IN_CLOSE_WRITE | IN_CREATE | IN_DELETE_SELF | IN_MOVED_TO);
+        if (wd == -1)
+            throw SYSTEM_ERROR(std::string{"inotify_add_watch() failure on \""}
+                    + pathname + "\"");
+        watchDirs[wd] = pathname;
+    }
 
     bool isDirectory(const std::string& pathname)
     {
@@ -126,63 +206,203 @@ class FileIngester::Impl : public Ingester::Impl
             std::chrono::nanoseconds{statBuf.st_mtim.tv_nsec};
     }
 
-    bool getScanDirProd(Product& prod)
+    /**
+     * Returns the pathname of the next pre-existing file in the directory
+     * hierarchy. Newly-found subdirectories are watched so that files that
+     * arrive in them during the scan aren't missed.
+     * @param[out] pathname  Pathname of the file
+     * @retval `true`        A file was found
+     * @retval `false`       The scan is complete
+     */
+    bool nextScanFile(std::string& pathname)
     {
         while (!dirStack.empty()) {
-            std::string pathname;
             if (!dirStack.next(pathname)) {
                 dirStack.pop();
                 continue;
             }
             if (isDirectory(pathname)) {
                 dirStack.push(pathname);
+                addWatch(pathname);
                 continue;
             }
-            if (getTime(pathname) < start) {
-#if 0
-                prod = Product{pathname}; // TODO
-#endif
+            if (getTime(pathname) < start)
                 return true;
-            }
         }
         return false;
     }
 
+    bool getScanDirProd(Product& prod)
+    {
+        std::string pathname;
+        if (!nextScanFile(pathname))
+            return false;
+        prod = FileProduct{prodIndex, pathname};
+        ++prodIndex;
+        return true;
+    }
+
+    /**
+     * Handles a single inotify(7) event. A completed file is appended to the
+     * arrival queue; a new subdirectory is watched.
+     * @param[in] event     The event
+     * @throws SystemError  `inotify_add_watch()` failure
+     */
+    void handleEvent(const struct inotify_event& event)
+    {
+        if (event.mask & (IN_DELETE_SELF | IN_IGNORED)) {
+            watchDirs.erase(event.wd);
+            return;
+        }
+        const auto iter = watchDirs.find(event.wd);
+        if (iter == watchDirs.end())
+            return;
+        const std::string pathname = iter->second + "/" + event.name;
+        if (event.mask & IN_ISDIR) {
+            if (event.mask & (IN_CREATE | IN_MOVED_TO))
+                addWatch(pathname);
+        }
+        else if (event.mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+            arrivals.push(pathname);
+        }
+    }
+
+    /**
+     * Drains the inotify(7) file-descriptor with a single read() -- many
+     * events per system call during a burst of arrivals -- and handles every
+     * drained event. Blocks until at least one event arrives.
+     * @throws SystemError  `read()` failure
+     */
+    void drainInotify()
+    {
+        alignas(struct inotify_event) char buf[eventBufSize];
+        ssize_t nbytes;
+        {
+            Canceler canceler{};
+            nbytes = ::read(fd, buf, sizeof(buf));
+        }
+        if (nbytes == -1)
+            throw SYSTEM_ERROR("read() failure on inotify file-descriptor");
+        for (const char* ptr = buf; ptr < buf + nbytes; ) {
+            auto event = reinterpret_cast<const struct inotify_event*>(ptr);
+            ptr += sizeof(struct inotify_event) + event->len;
+            handleEvent(*event);
+        }
+    }
+
     Product getInotifyProd()
     {
-        union {
-            char                 buf[sizeof(struct inotify_event) + NAME_MAX + 1];
-            struct inotify_event event;
+        while (arrivals.empty())
+            drainInotify();
+        const std::string pathname = arrivals.front();
+        arrivals.pop();
+        Product prod = FileProduct{prodIndex, pathname};
+        ++prodIndex;
+        return prod;
+    }
+
+    /**
+     * Submits the conversion of a file into a data-product to the worker
+     * pool. The sequence number assigned here preserves arrival order on
+     * delivery even though conversions complete in any order.
+     * @param[in] pathname  Pathname of the file
+     */
+    void submitConversion(const std::string pathname)
+    {
+        const ProdIndex     index = prodIndex;
+        ++prodIndex;
+        const unsigned long seq = nextSubmitSeq++;
+        std::function<void()> task = [this,seq,index,pathname] {
+            Conversion conversion{};
+            try {
+                conversion.prod = FileProduct{index, pathname};
+            }
+            catch (...) {
+                conversion.ex = std::current_exception();
+            }
+            LockGuard lock{mutex};
+            conversions[seq] = std::move(conversion);
+            cond.notify_all();
         };
+        executor->submit(task);
+    }
+
+    /**
+     * Returns the next data-product in arrival order. Files are gathered in
+     * batches -- from the initial scan or by draining the inotify(7)
+     * file-descriptor -- and converted concurrently by the worker pool.
+     * @return                Next data-product
+     * @throws SystemError    Couldn't read a file or an event
+     * @throws std::exception Exception thrown by a conversion
+     */
+    Product getParallelProd()
+    {
         for (;;) {
-            auto nbytes = ::read(fd, buf, sizeof(buf));
-            if (nbytes == -1)
-                throw SYSTEM_ERROR("read() failure");
-            switch (event.mask) {
-            // TODO
+            if (nextDeliverSeq < nextSubmitSeq) {
+                // Conversions are outstanding; await the next one in order
+                UniqueLock lock{mutex};
+                while (conversions.count(nextDeliverSeq) == 0) {
+                    Canceler canceler{};
+                    cond.wait(lock);
+                }
+                auto conversion = std::move(conversions[nextDeliverSeq]);
+                conversions.erase(nextDeliverSeq);
+                ++nextDeliverSeq;
+                if (conversion.ex)
+                    std::rethrow_exception(conversion.ex);
+                return conversion.prod;
+            }
+            if (scanDir) {
+                std::string pathname;
+                unsigned    i;
+                for (i = 0; i < scanBatchSize && nextScanFile(pathname); ++i)
+                    submitConversion(pathname);
+                if (i == 0)
+                    scanDir = false;
+                continue;
+            }
+            drainInotify();
+            while (!arrivals.empty()) {
+                submitConversion(arrivals.front());
+                arrivals.pop();
             }
         }
-        return Product{};
     }
 
-    explicit Impl(const std::string& rootDirPathname)
+    Impl(   const std::string& rootDirPathname,
+            const unsigned     numWorkers,
+            const bool         parallel)
         : dirPathname{rootDirPathname}
         , fd{::inotify_init1(IN_CLOEXEC)}
         , start{}
         , scanDir{true}
         , dirStack{}
+        , prodIndex{0}
+        , arrivals{}
+        , watchDirs{}
+        , mutex{}
+        , cond{}
+        , nextSubmitSeq{0}
+        , nextDeliverSeq{0}
+        , conversions{}
+        , executor{}
     {
         if (fd == -1)
             throw SYSTEM_ERROR("inotify_init1() failure");
         try {
             dirStack.push(rootDirPathname);
-
-            auto wd = ::inotify_add_watch(fd, rootDirPathname.data(),
-                    IN_CLOSE_WRITE | IN_CREATE | IN_DELETE_SELF | IN_MOVED_TO);
-            if (wd == -1)
-                throw SYSTEM_ERROR("inotify_add_watch() failure");
-
+            addWatch(rootDirPathname);
             start = Clock::now();
+            /*
+             * No explicit worker-count means the process-wide shared pool:
+             * several ingesters in one process (one per feed) then run one
+             * pool's worth of conversion threads instead of one pool each
+             */
+            if (parallel)
+                executor.reset(numWorkers
+                        ? new StealingExecutor<void>{numWorkers}
+                        : new StealingExecutor<void>{
+                                StealingExecutor<void>::getShared()});
         }
         catch (const std::exception& ex) {
             ::close(fd);
@@ -198,6 +418,8 @@ class FileIngester::Impl : public Ingester::Impl
 
     Product getProduct()
     {
+        if (executor)
+            return getParallelProd();
         if (scanDir) {
             Product prod{};
             if (getScanDirProd(prod))
@@ -206,6 +428,51 @@ class FileIngester::Impl : public Ingester::Impl
         }
         return getInotifyProd();
     }
+
+    /**
+     * Returns the inotify(7) file-descriptor, which becomes readable when
+     * filesystem events await draining.
+     * @return  The file-descriptor
+     * @see IngesterMux
+     */
+    int getPollFd()
+    {
+        return fd;
+    }
+
+    /**
+     * Returns the next data-product without blocking. A multiplexer calls
+     * this on a pooled worker-thread, so the file-to-product conversion
+     * itself runs off the event-thread and this ingester needs no worker
+     * pool of its own. During the initial scan of the directory hierarchy,
+     * products are delivered without the file-descriptor being readable.
+     * @param[out] prod     Next data-product
+     * @retval `true`       A product was delivered
+     * @retval `false`      No completed file awaits conversion
+     * @throws SystemError  Couldn't read a file or an event
+     * @see IngesterMux
+     */
+    bool tryGetProduct(Product& prod)
+    {
+        if (scanDir) {
+            if (getScanDirProd(prod))
+                return true;
+            scanDir = false;
+        }
+        while (arrivals.empty()) {
+            struct pollfd pollFd;
+            pollFd.fd = fd;
+            pollFd.events = POLLIN;
+            if (::poll(&pollFd, 1, 0) <= 0)
+                return false;
+            drainInotify();
+        }
+        const std::string pathname = arrivals.front();
+        arrivals.pop();
+        prod = FileProduct{prodIndex, pathname};
+        ++prodIndex;
+        return true;
+    }
 }; // FileIngester::Impl
 
 FileIngester::FileIngester()
@@ -213,7 +480,13 @@ FileIngester::FileIngester()
 {}
 
 FileIngester::FileIngester(const std::string& dirPathname)
-    : Ingester{new Impl{dirPathname}}
+    : Ingester{new Impl{dirPathname, 0, false}}
+{}
+
+FileIngester::FileIngester(
+        const std::string& dirPathname,
+        const unsigned     numWorkers)
+    : Ingester{new Impl{dirPathname, numWorkers, true}}
 {}
 
 } // namespace
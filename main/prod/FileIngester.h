@@ -36,6 +36,24 @@ public:
      * @throw SystemError      `::inotify_add_watch()` failure
      */
     explicit FileIngester(const std::string& dirPathname);
+
+    /**
+     * Constructs an ingester that drains inotify(7) events in large batches
+     * and converts files into data-products on a pool of worker threads.
+     * Products are still delivered in arrival order, so a burst of small
+     * files doesn't serialize behind single-threaded stat/open/read.
+     * @param[in] dirPathname  Pathname of directory to monitor
+     * @param[in] numWorkers   Number of dedicated conversion threads or 0,
+     *                         in which case the process-wide shared executor
+     *                         is used -- so several ingesters in one process
+     *                         share one pool's worth of threads
+     * @throw SystemError      `::opendir()` failure on `dirPathName`
+     * @throw SystemError      `::inotify_init1()` failure
+     * @throw SystemError      `::inotify_add_watch()` failure
+     */
+    FileIngester(
+            const std::string& dirPathname,
+            const unsigned     numWorkers);
 };
 
 } // namespace
@@ -30,6 +30,35 @@ protected:
         {}
 
         virtual Product getProduct() =0;
+
+        /**
+         * Returns a file-descriptor that becomes readable when
+         * `tryGetProduct()` has -- or may have -- a product to deliver, so
+         * an ingester-multiplexer can watch many mostly-idle ingesters from
+         * one event-thread. The default implementation returns -1: the
+         * ingester can't be multiplexed.
+         * @return  The file-descriptor or -1
+         * @see IngesterMux
+         */
+        virtual int getPollFd()
+        {
+            return -1;
+        }
+
+        /**
+         * Returns the next data-product without blocking. The default
+         * implementation delivers nothing. A multiplexer calls this on one
+         * thread at a time, so an implementation needn't be thread-safe with
+         * respect to itself.
+         * @param[out] prod  Next data-product
+         * @retval `true`    A product was delivered
+         * @retval `false`   No product is currently available
+         * @see IngesterMux
+         */
+        virtual bool tryGetProduct(Product& prod)
+        {
+            return false;
+        }
     };
 
     Ingester(Impl* impl)
@@ -55,6 +84,30 @@ public:
     {
         return pImpl->getProduct();
     }
+
+    /**
+     * Returns a file-descriptor that becomes readable when
+     * `tryGetProduct()` has -- or may have -- a product to deliver.
+     * @return  The file-descriptor or -1 if this ingester can't be
+     *          multiplexed
+     * @see IngesterMux
+     */
+    inline int getPollFd()
+    {
+        return pImpl->getPollFd();
+    }
+
+    /**
+     * Returns the next data-product without blocking.
+     * @param[out] prod  Next data-product
+     * @retval `true`    A product was delivered
+     * @retval `false`   No product is currently available
+     * @see IngesterMux
+     */
+    inline bool tryGetProduct(Product& prod)
+    {
+        return pImpl->tryGetProduct(prod);
+    }
 };
 
 } // namespace
@@ -0,0 +1,343 @@
+/**
+ * This file implements a multiplexer of ingesters. An ingest host that
+ * watches a dozen directory hierarchies plus a shared-memory channel would
+ * otherwise burn a dedicated blocking thread per mostly-idle source. This
+ * multiplexer instead polls every ingester's file-descriptor -- the inotify
+ * descriptor of a file-ingester, the eventfd of a shared-memory ingester --
+ * from one event-thread. When a descriptor becomes readable, the draining of
+ * its ingester is dispatched to a pool of worker-threads; at most one
+ * drain-task per ingester is in flight, and a descriptor isn't polled again
+ * until its task completes. The workers drain a ready ingester to empty --
+ * batching a burst of arrivals into one dispatch -- and append the products
+ * to a single, ordered queue that `getProduct()` delivers from.
+ *
+ * Copyright 2018 University Corporation for Atmospheric Research. All Rights
+ * reserved. See file "Copying" in the top-level source-directory for usage
+ * restrictions.
+ *
+ *        File: IngesterMux.cpp
+ *  Created on: Aug 30, 2018
+ *      Author: Steven R. Emmerson
+ */
+
+#include "config.h"
+
+#include "error.h"
+#include "IngesterMux.h"
+#include "StealingExecutor.h"
+#include "Thread.h"
+
+#include <cerrno>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <poll.h>
+#include <queue>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace hycast {
+
+class IngesterMux::Impl final : public Ingester::Impl
+{
+    typedef std::mutex              Mutex;
+    typedef std::lock_guard<Mutex>  LockGuard;
+    typedef std::unique_lock<Mutex> UniqueLock;
+    typedef std::condition_variable Cond;
+
+    /// Default maximum number of undelivered products
+    static const size_t defaultMaxQueued = 512;
+
+    /// State of one multiplexed ingester
+    struct Source
+    {
+        Ingester* ingester; ///< The ingester. Not owned.
+        int       fd;       ///< Its pollable file-descriptor
+        bool      inFlight; ///< A drain-task is dispatched? Guarded by `mutex`
+    };
+
+    std::vector<Source> sources;
+    /// Signaled to re-arm the poller after a drain-task completes
+    int                 wakeFd;
+    /// Guards `Source::inFlight`, `products`, `exception` and `done`
+    Mutex               mutex;
+    /// Signaled when `products` changes, a drain-task completes, or an
+    /// exception is set
+    Cond                cond;
+    /// The single ordered product-queue
+    std::queue<Product> products;
+    const size_t        maxQueued;
+    /// First exception thrown by the event-thread or a drain-task
+    std::exception_ptr  exception;
+    /// Set by the destructor to unblock the drain-tasks
+    bool                done;
+    /// Worker pool that drains ready ingesters. Empty means construction
+    /// failed.
+    std::unique_ptr<StealingExecutor<void>> executor;
+    /// The event-thread. Declared last so that it terminates first.
+    Thread              pollThread;
+
+    /**
+     * Wakes the event-thread so that it re-polls with the current set of
+     * idle file-descriptors.
+     */
+    void wake() noexcept
+    {
+        const uint64_t one = 1;
+        if (::write(wakeFd, &one, sizeof(one)) == -1 && errno != EAGAIN)
+            LOG_WARN("write() failure on multiplexer eventfd");
+    }
+
+    /**
+     * Appends a data-product to the delivery queue. Blocks while the queue
+     * is full. This is a cancellation point.
+     * @param[in] prod  Data-product
+     * @retval `true`   The product was queued
+     * @retval `false`  This instance is being destroyed
+     */
+    bool enqueue(Product& prod)
+    {
+        UniqueLock lock{mutex};
+        while (products.size() >= maxQueued && !done) {
+            Canceler canceler{};
+            cond.wait(lock);
+        }
+        if (done)
+            return false;
+        products.push(prod);
+        cond.notify_all();
+        return true;
+    }
+
+    /**
+     * Drains an ingester to empty and queues its products in order.
+     * Executes on a worker-thread of the pool -- so conversions (e.g.,
+     * file-to-product) never run on the event-thread. An exception is saved
+     * for `getProduct()` to rethrow.
+     * @param[in] source  State of the ingester
+     */
+    void drain(Source& source)
+    {
+        try {
+            Product prod{};
+            while (source.ingester->tryGetProduct(prod) && enqueue(prod))
+                ;
+        }
+        catch (...) {
+            LockGuard lock{mutex};
+            if (!exception)
+                exception = std::current_exception();
+            cond.notify_all();
+        }
+        /*
+         * The wake must precede the in-flight clearing: the destructor
+         * closes the eventfd as soon as no task is in flight, so a wake
+         * after the clearing could write to a closed -- possibly reused --
+         * descriptor.
+         */
+        wake();
+        {
+            LockGuard lock{mutex};
+            source.inFlight = false;
+            cond.notify_all();
+        }
+    }
+
+    /**
+     * Dispatches the draining of a ready ingester to the worker pool. The
+     * ingester's file-descriptor isn't polled again until the drain-task
+     * completes, so at most one task per ingester is ever in flight.
+     * @param[in] source  State of the ingester
+     */
+    void dispatch(Source& source)
+    {
+        {
+            LockGuard lock{mutex};
+            source.inFlight = true;
+        }
+        std::function<void()> task = [this,&source]{drain(source);};
+        executor->submit(task);
+    }
+
+    /**
+     * The event-loop: polls the file-descriptors of every ingester without
+     * an in-flight drain-task and dispatches the ready ones. Executes on
+     * `pollThread`.
+     */
+    void runPoller()
+    {
+        try {
+            /*
+             * Initial drain of every ingester: one may hold products before
+             * its descriptor is readable -- e.g., a file-ingester's scan of
+             * pre-existing files or an already-filled shared-memory ring
+             */
+            for (auto& source : sources)
+                dispatch(source);
+            for (;;) {
+                std::vector<struct pollfd> pollFds;
+                std::vector<Source*>       polled;
+                pollFds.push_back({wakeFd, POLLIN, 0});
+                {
+                    LockGuard lock{mutex};
+                    for (auto& source : sources) {
+                        if (!source.inFlight) {
+                            pollFds.push_back({source.fd, POLLIN, 0});
+                            polled.push_back(&source);
+                        }
+                    }
+                }
+                int numReady;
+                {
+                    Canceler canceler{};
+                    numReady = ::poll(pollFds.data(), pollFds.size(), -1);
+                }
+                if (numReady == -1) {
+                    if (errno == EINTR)
+                        continue;
+                    throw SYSTEM_ERROR("poll() failure");
+                }
+                if (pollFds[0].revents & POLLIN) {
+                    uint64_t count;
+                    while (::read(wakeFd, &count, sizeof(count)) > 0)
+                        ;
+                }
+                for (size_t i = 1; i < pollFds.size(); ++i)
+                    if (pollFds[i].revents & (POLLIN|POLLERR|POLLHUP))
+                        dispatch(*polled[i-1]);
+            }
+        }
+        catch (const std::exception& ex) {
+            LockGuard lock{mutex};
+            if (!exception)
+                exception = std::current_exception();
+            cond.notify_all();
+        }
+    }
+
+    /**
+     * Indicates if any drain-task is in flight. The mutex must be locked.
+     * @retval `true`   At least one drain-task is in flight
+     * @retval `false`  No drain-task is in flight
+     */
+    bool anyInFlight() const
+    {
+        for (auto& source : sources)
+            if (source.inFlight)
+                return true;
+        return false;
+    }
+
+public:
+    /**
+     * Constructs.
+     * @param[in] ingesters    Ingesters to multiplex. Must exist for the
+     *                         duration of this instance.
+     * @param[in] numWorkers   Number of dedicated worker-threads or 0 for
+     *                         the process-wide shared executor
+     * @param[in] maxQueued    Maximum number of undelivered products or 0
+     *                         for the default
+     * @throw InvalidArgument  `ingesters` is empty or contains an ingester
+     *                         that can't be multiplexed
+     * @throw SystemError      `eventfd()` failure
+     */
+    Impl(   const std::vector<Ingester*>& ingesters,
+            const unsigned                numWorkers,
+            const size_t                  maxQueued)
+        : sources{}
+        , wakeFd{-1}
+        , mutex{}
+        , cond{}
+        , products{}
+        , maxQueued{maxQueued ? maxQueued : defaultMaxQueued}
+        , exception{}
+        , done{false}
+        , executor{}
+        , pollThread{}
+    {
+        if (ingesters.empty())
+            throw INVALID_ARGUMENT("No ingesters to multiplex");
+        sources.reserve(ingesters.size()); // So drain-tasks may hold references
+        for (auto ingester : ingesters) {
+            const auto fd = ingester->getPollFd();
+            if (fd < 0)
+                throw INVALID_ARGUMENT("Ingester can't be multiplexed");
+            sources.push_back(Source{ingester, fd, false});
+        }
+        wakeFd = ::eventfd(0, EFD_CLOEXEC|EFD_NONBLOCK);
+        if (wakeFd == -1)
+            throw SYSTEM_ERROR("eventfd() failure");
+        try {
+            /*
+             * No explicit worker-count means the process-wide shared pool --
+             * see FileIngester
+             */
+            executor.reset(numWorkers
+                    ? new StealingExecutor<void>{numWorkers}
+                    : new StealingExecutor<void>{
+                            StealingExecutor<void>::getShared()});
+            pollThread = Thread{[this]{runPoller();}};
+        }
+        catch (const std::exception& ex) {
+            ::close(wakeFd);
+            throw;
+        }
+    }
+
+    ~Impl() noexcept
+    {
+        try {
+            pollThread = Thread{}; // Cancels and joins the event-thread
+            {
+                // Await outstanding drain-tasks lest one outlive this instance
+                UniqueLock lock{mutex};
+                done = true;
+                cond.notify_all();
+                while (anyInFlight())
+                    cond.wait(lock);
+            }
+            ::close(wakeFd);
+        }
+        catch (const std::exception& ex) {
+            log_error(ex);
+        }
+    }
+
+    /**
+     * Returns the next data-product from the single ordered queue. Products
+     * of one ingester are delivered in that ingester's order. Blocks until a
+     * product is available. This is a cancellation point.
+     * @return                Next data-product
+     * @throws std::exception Exception thrown by the event-thread or by the
+     *                        draining of an ingester
+     */
+    Product getProduct()
+    {
+        UniqueLock lock{mutex};
+        while (products.empty()) {
+            if (exception)
+                std::rethrow_exception(exception);
+            Canceler canceler{};
+            cond.wait(lock);
+        }
+        auto prod = products.front();
+        products.pop();
+        cond.notify_all();
+        return prod;
+    }
+}; // IngesterMux::Impl
+
+IngesterMux::IngesterMux()
+    : Ingester{}
+{}
+
+IngesterMux::IngesterMux(
+        const std::vector<Ingester*>& ingesters,
+        const unsigned                numWorkers,
+        const size_t                  maxQueued)
+    : Ingester{new Impl{ingesters, numWorkers, maxQueued}}
+{}
+
+} // namespace
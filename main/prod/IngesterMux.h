@@ -0,0 +1,60 @@
+/**
+ * This file declares a multiplexer of ingesters. One event-thread polls the
+ * file-descriptors of all the ingesters -- instead of each ingester occupying
+ * a dedicated, mostly-idle blocking thread -- and dispatches ready ingesters
+ * to a pool of worker-threads, which drain them into a single, ordered
+ * product-queue.
+ *
+ * Copyright 2018 University Corporation for Atmospheric Research. All Rights
+ * reserved. See file "Copying" in the top-level source-directory for usage
+ * restrictions.
+ *
+ *        File: IngesterMux.h
+ *  Created on: Aug 30, 2018
+ *      Author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_PROD_INGESTERMUX_H_
+#define MAIN_PROD_INGESTERMUX_H_
+
+#include "Ingester.h"
+
+#include <vector>
+
+namespace hycast {
+
+class IngesterMux final : public Ingester
+{
+    class Impl;
+
+public:
+    IngesterMux();
+
+    /**
+     * Constructs.
+     * @param[in] ingesters   Ingesters to multiplex. Every ingester must be
+     *                        multiplexable -- i.e., its `getPollFd()` must
+     *                        not return -1 -- and must exist for the
+     *                        duration of this instance. At most one
+     *                        worker-thread drains an ingester at a time, so
+     *                        per-ingester delivery order is preserved.
+     * @param[in] numWorkers  Number of dedicated worker-threads or 0, in
+     *                        which case the process-wide shared executor is
+     *                        used
+     * @param[in] maxQueued   Maximum number of undelivered products or 0 for
+     *                        a reasonable default. A full queue blocks the
+     *                        workers -- backpressure to the sources --
+     *                        instead of growing without bound.
+     * @throw InvalidArgument  `ingesters` is empty or contains an ingester
+     *                         that can't be multiplexed
+     * @throw SystemError      `eventfd()` failure
+     */
+    explicit IngesterMux(
+            const std::vector<Ingester*>& ingesters,
+            const unsigned                numWorkers = 0,
+            const size_t                  maxQueued = 0);
+};
+
+} // namespace
+
+#endif /* MAIN_PROD_INGESTERMUX_H_ */
@@ -0,0 +1,99 @@
+/**
+ * This file implements a product filter: a small set of glob patterns against
+ * product names.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: ProdFilter.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "error.h"
+#include "ProdFilter.h"
+
+#include <fnmatch.h>
+
+namespace hycast {
+
+const size_t ProdFilter::maxPatterns;
+const size_t ProdFilter::maxPatternLen;
+
+ProdFilter::ProdFilter()
+    : patterns{}
+{}
+
+void ProdFilter::add(const std::string& pattern)
+{
+    if (patterns.size() >= maxPatterns)
+        throw INVALID_ARGUMENT("Filter already has " +
+                std::to_string(maxPatterns) + " patterns");
+    if (pattern.size() > maxPatternLen)
+        throw INVALID_ARGUMENT("Pattern \"" + pattern + "\" is longer than " +
+                std::to_string(maxPatternLen) + " bytes");
+    patterns.push_back(pattern);
+}
+
+size_t ProdFilter::size() const noexcept
+{
+    return patterns.size();
+}
+
+ProdFilter::operator bool() const noexcept
+{
+    return !patterns.empty();
+}
+
+bool ProdFilter::matches(const std::string& prodName) const noexcept
+{
+    if (patterns.empty())
+        return true;
+    for (const auto& pattern : patterns)
+        if (::fnmatch(pattern.c_str(), prodName.c_str(), 0) == 0)
+            return true;
+    return false;
+}
+
+size_t ProdFilter::serialize(
+        Encoder&       encoder,
+        const unsigned version) const
+{
+    size_t nbytes = encoder.encode(static_cast<uint16_t>(patterns.size()));
+    for (const auto& pattern : patterns)
+        nbytes += encoder.encode(pattern);
+    return nbytes;
+}
+
+size_t ProdFilter::getSerialSize(unsigned version) const noexcept
+{
+    size_t nbytes = Codec::getSerialSize(sizeof(uint16_t));
+    for (const auto& pattern : patterns)
+        nbytes += Codec::getSerialSize(pattern);
+    return nbytes;
+}
+
+ProdFilter ProdFilter::deserialize(
+        Decoder&        decoder,
+        const unsigned  version)
+{
+    ProdFilter filter{};
+    uint16_t   numPatterns;
+    decoder.decode(numPatterns);
+    if (numPatterns > maxPatterns)
+        throw RUNTIME_ERROR("Filter message has " +
+                std::to_string(numPatterns) + " patterns; maximum is " +
+                std::to_string(maxPatterns));
+    for (uint16_t i = 0; i < numPatterns; ++i) {
+        std::string pattern;
+        decoder.decode(pattern);
+        if (pattern.size() > maxPatternLen)
+            throw RUNTIME_ERROR("Pattern is longer than " +
+                    std::to_string(maxPatternLen) + " bytes");
+        filter.patterns.push_back(pattern);
+    }
+    return filter;
+}
+
+} // namespace
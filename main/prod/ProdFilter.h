@@ -0,0 +1,122 @@
+/**
+ * This file declares a product filter: a small set of glob patterns against
+ * product names. A receiver that needs only a subset of the feed registers a
+ * filter so non-matching products are discarded early, and sends the filter
+ * to its peers so notices for excluded products are never transmitted.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: ProdFilter.h
+ * @author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_PROD_PRODFILTER_H_
+#define MAIN_PROD_PRODFILTER_H_
+
+#include "Serializable.h"
+
+#include <string>
+#include <vector>
+
+namespace hycast {
+
+class ProdFilter final : public Serializable<ProdFilter>
+{
+    std::vector<std::string> patterns;
+
+public:
+    /// Maximum number of patterns in a filter
+    static const size_t maxPatterns = 32;
+    /// Maximum length of a pattern in bytes
+    static const size_t maxPatternLen = 128;
+
+    /**
+     * Constructs an empty filter, which matches every product.
+     */
+    ProdFilter();
+
+    /**
+     * Adds a glob pattern in fnmatch(3) syntax.
+     * @param[in] pattern          Glob pattern
+     * @throw     InvalidArgument  Pattern is too long or the filter is full
+     * @exceptionsafety            Strong guarantee
+     * @threadsafety               Compatible but not safe
+     */
+    void add(const std::string& pattern);
+
+    /**
+     * Returns the number of patterns in this filter.
+     * @return Number of patterns
+     */
+    size_t size() const noexcept;
+
+    /**
+     * Indicates if this filter has any patterns.
+     * @return `true` iff this filter has at least one pattern
+     */
+    operator bool() const noexcept;
+
+    /**
+     * Indicates if a product name passes this filter. An empty filter passes
+     * every name.
+     * @param[in] prodName  Name of the product
+     * @return `true`       Name matches a pattern or the filter is empty
+     * @return `false`      Otherwise
+     * @exceptionsafety     Nothrow
+     * @threadsafety        Safe
+     */
+    bool matches(const std::string& prodName) const noexcept;
+
+    /**
+     * Serializes this instance to an encoder.
+     * @param[in] encoder  Encoder
+     * @param[in] version  Protocol version
+     * @return Number of bytes written
+     * @exceptionsafety Basic guarantee
+     * @threadsafety    Safe
+     */
+    size_t serialize(
+            Encoder&       encoder,
+            const unsigned version) const;
+
+    /**
+     * Returns the number of bytes in the serial representation of this
+     * instance.
+     * @param[in] version  Protocol version
+     * @return the number of bytes in the serial representation
+     */
+    size_t getSerialSize(unsigned version) const noexcept;
+
+    /**
+     * Returns an upper bound, known at compile time, on the number of bytes
+     * in the serial representation of any instance.
+     * Keep consistent with `getSerialSize()`.
+     * @param[in] version  Protocol version
+     * @return the maximum number of bytes in a serial representation
+     */
+    static constexpr size_t getMaxSerialSize(const unsigned version)
+            noexcept {
+        return Codec::getSerialSize(sizeof(uint16_t)) + // Number of patterns
+                maxPatterns*(
+                    Codec::getSerialSize(sizeof(uint16_t)) + // Pattern length
+                    maxPatternLen);                          // Pattern
+    }
+
+    /**
+     * Returns an instance corresponding to the serialized representation in a
+     * decoder.
+     * @param[in] decoder  Decoder
+     * @param[in] version  Protocol version
+     * @exceptionsafety Basic
+     * @threadsafety    Compatible but not thread-safe
+     */
+    static ProdFilter deserialize(
+            Decoder&        decoder,
+            const unsigned  version);
+};
+
+} // namespace
+
+#endif /* MAIN_PROD_PRODFILTER_H_ */
@@ -111,13 +111,17 @@ public:
     }
 
     /**
-     * Returns the number of bytes in the serial representation of an
-     * instance.
+     * Returns the maximum number of bytes in the serial representation of an
+     * instance. Under the compact encoding (version >= 1) the index is a
+     * varint, so this is a worst case for sizing buffers.
      * @param[in] version  Protocol version
      * @return the number of bytes in the serial representation
      */
-    static size_t getStaticSerialSize(const unsigned version) noexcept {
-        return Codec::getSerialSize(sizeof(type));
+    static constexpr size_t getStaticSerialSize(const unsigned version)
+            noexcept {
+        return version == 0
+                ? Codec::getSerialSize(sizeof(type))
+                : Codec::maxVarintSize;
     }
 
     /**
@@ -127,21 +131,27 @@ public:
      * @return the number of bytes in the serial representation
      */
     inline size_t getSerialSize(unsigned version) const noexcept {
-        return index.getSerialSize(version);
+        return version == 0
+                ? index.getSerialSize(version)
+                : Codec::getVarintSize(index);
     }
 
     inline size_t serialize(
             Encoder&       encoder,
             const unsigned version) const
     {
-        return index.serialize(encoder, version);
+        return version == 0
+                ? index.serialize(encoder, version)
+                : encoder.encodeVarint(index);
     }
 
     inline static ProdIndex deserialize(
             Decoder&       decoder,
             const unsigned version)
     {
-        return SerialInt<type>::deserialize(decoder, version);
+        return version == 0
+                ? ProdIndex{SerialInt<type>::deserialize(decoder, version)}
+                : ProdIndex{decoder.decodeVarint()};
     }
 };
 
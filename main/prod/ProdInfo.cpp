@@ -17,6 +17,8 @@
 #include "Serializable.h"
 
 #include <arpa/inet.h>
+#include <chrono>
+#include <random>
 #include <stdexcept>
 #include <cstdint>
 #include <cstring>
@@ -27,11 +29,19 @@
 
 namespace hycast {
 
+const ProdInfo::Priority ProdInfo::defaultPriority;
+const ProdInfo::TtlSecs  ProdInfo::defaultTtl;
+
 class ProdInfo::Impl final
 {
     ProdIndex   index;
     ProdSize    size;
     ChunkSize   canonChunkSize;
+    Priority    priority;
+    OriginTime  originTime;
+    TtlSecs     ttl;
+    PayloadCrc  payloadCrc;
+    TraceId     traceId;
     ProdName    name;
 
 public:
@@ -42,16 +52,31 @@ public:
         : index{0}
         , size{0}
         , canonChunkSize{0}
+        , priority{defaultPriority}
+        , originTime{0}
+        , ttl{defaultTtl}
+        , payloadCrc{0}
+        , traceId{0}
         , name{}
     {}
 
-    Impl(   const ProdIndex index,
-            const ProdName& name,
-            const ProdSize  size,
-            const ChunkSize canonChunkSize)
+    Impl(   const ProdIndex  index,
+            const ProdName&  name,
+            const ProdSize   size,
+            const ChunkSize  canonChunkSize,
+            const Priority   priority,
+            const OriginTime originTime,
+            const TtlSecs    ttl,
+            const PayloadCrc payloadCrc,
+            const TraceId    traceId)
         : index{index}
         , size{size}
         , canonChunkSize{canonChunkSize}
+        , priority{priority}
+        , originTime{originTime}
+        , ttl{ttl}
+        , payloadCrc{payloadCrc}
+        , traceId{traceId}
         , name{name}
     {}
 
@@ -60,9 +85,25 @@ public:
         : Impl{}
     {
         // Keep consonant with ProdInfo::serialize()
-        size = ProdSize::deserialize(decoder, version);
-        index = ProdIndex::deserialize(decoder, version);
-        canonChunkSize = ChunkSize::deserialize(decoder, version);
+        // One bounds-check and straight-line loads for the fixed-layout prefix
+        ProdSize::type  sizeVal;
+        ProdIndex::type indexVal;
+        ChunkSize::type chunkSizeVal;
+        Priority        priorityVal;
+        OriginTime      originTimeVal;
+        TtlSecs         ttlVal;
+        PayloadCrc      payloadCrcVal;
+        TraceId         traceIdVal;
+        decoder.decodeFields(sizeVal, indexVal, chunkSizeVal, priorityVal,
+                originTimeVal, ttlVal, payloadCrcVal, traceIdVal);
+        size = ProdSize{sizeVal};
+        index = ProdIndex{indexVal};
+        canonChunkSize = ChunkSize{chunkSizeVal};
+        priority = priorityVal;
+        originTime = originTimeVal;
+        ttl = ttlVal;
+        payloadCrc = payloadCrcVal;
+        traceId = traceIdVal;
         name = ProdName::deserialize(decoder, version);
     }
 
@@ -79,7 +120,12 @@ public:
     {
         return "{index=" + index.to_string() + ", name=\"" + name.to_string() +
                 "\", size=" + std::to_string(size) + ", canonicalChunkSize=" +
-                canonChunkSize.to_string() + "}";
+                canonChunkSize.to_string() + ", priority=" +
+                std::to_string(priority) + ", originTime=" +
+                std::to_string(originTime) + ", ttl=" +
+                std::to_string(ttl) + ", payloadCrc=" +
+                std::to_string(payloadCrc) + ", traceId=" +
+                std::to_string(traceId) + "}";
     }
 
     /**
@@ -115,6 +161,112 @@ public:
         return size;
     }
 
+    /**
+     * Returns the priority class of the product.
+     * @return          Priority class of the product
+     * @exceptionsafety Nothrow
+     * @threadsafety    Safe
+     */
+    inline Priority getPriority() const noexcept
+    {
+        return priority;
+    }
+
+    /**
+     * Returns the origin timestamp of the product.
+     * @return          Origin timestamp or 0 for not-yet-transmitted
+     * @exceptionsafety Nothrow
+     * @threadsafety    Safe
+     */
+    inline OriginTime getOriginTime() const noexcept
+    {
+        return originTime;
+    }
+
+    /**
+     * Returns the time-to-live of the product.
+     * @return          Time-to-live in seconds or 0 for no expiration
+     * @exceptionsafety Nothrow
+     * @threadsafety    Safe
+     */
+    inline TtlSecs getTtl() const noexcept
+    {
+        return ttl;
+    }
+
+    /**
+     * Indicates if the product has expired. An untransmitted product --
+     * whose origin timestamp is 0 -- can't expire.
+     * @retval `true`   The product has expired
+     * @retval `false`  The product hasn't expired
+     * @exceptionsafety Nothrow
+     * @threadsafety    Safe
+     */
+    inline bool isExpired() const noexcept
+    {
+        return ttl != 0 && originTime != 0 &&
+                ProdInfo::now() > originTime +
+                        static_cast<OriginTime>(ttl)*1000000;
+    }
+
+    /**
+     * Sets the origin timestamp if it isn't already set.
+     * @param[in] originTime  Origin timestamp
+     * @exceptionsafety       Nothrow
+     * @threadsafety          Compatible but not safe
+     */
+    inline void setOriginTime(const OriginTime originTime) noexcept
+    {
+        if (this->originTime == 0)
+            this->originTime = originTime;
+    }
+
+    /**
+     * Returns the payload checksum of the product.
+     * @return          Payload checksum or 0 for not-computed
+     * @exceptionsafety Nothrow
+     * @threadsafety    Safe
+     */
+    inline PayloadCrc getPayloadCrc() const noexcept
+    {
+        return payloadCrc;
+    }
+
+    /**
+     * Sets the payload checksum if it isn't already set.
+     * @param[in] payloadCrc  Payload checksum
+     * @exceptionsafety       Nothrow
+     * @threadsafety          Compatible but not safe
+     */
+    inline void setPayloadCrc(const PayloadCrc payloadCrc) noexcept
+    {
+        if (this->payloadCrc == 0)
+            this->payloadCrc = payloadCrc;
+    }
+
+    /**
+     * Returns the trace identifier of the product.
+     * @return          Trace identifier or 0 for not-minted
+     * @exceptionsafety Nothrow
+     * @threadsafety    Safe
+     */
+    inline TraceId getTraceId() const noexcept
+    {
+        return traceId;
+    }
+
+    /**
+     * Sets the trace identifier if it isn't already set.
+     * @param[in] traceId  Trace identifier
+     * @exceptionsafety    Nothrow
+     * @threadsafety       Compatible but not safe
+     */
+    inline void setTraceId(const TraceId traceId) noexcept
+    {
+        if (this->traceId == 0)
+            this->traceId = traceId;
+    }
+
     /**
      * Indicates if this instance is earlier than another.
      * @param[in] that   Other instance
@@ -184,7 +336,9 @@ public:
     {
         const bool result = ((index == that.index) &&
                 (size == that.size) &&
-                (canonChunkSize == that.canonChunkSize));
+                (canonChunkSize == that.canonChunkSize) &&
+                (priority == that.priority) &&
+                (ttl == that.ttl));
         return result;
     }
 
@@ -214,6 +368,11 @@ public:
         return  size.getSerialSize(version) +
                 index.getSerialSize(version) +
                 canonChunkSize.getSerialSize(version) +
+                Codec::getSerialSize(sizeof(Priority)) +
+                Codec::getSerialSize(sizeof(OriginTime)) +
+                Codec::getSerialSize(sizeof(TtlSecs)) +
+                Codec::getSerialSize(sizeof(PayloadCrc)) +
+                Codec::getSerialSize(sizeof(TraceId)) +
                 name.getSerialSize(version);
     }
 
@@ -229,9 +388,17 @@ public:
             const unsigned version) const
     {
         // Keep consonant with ProdInfo::deserialize()
-        return  size.serialize(encoder, version) +
-                index.serialize(encoder, version) +
-                canonChunkSize.serialize(encoder, version) +
+        // One bounds-check and straight-line stores for the fixed-layout
+        // prefix
+        return  encoder.encodeFields(
+                        static_cast<ProdSize::type>(size),
+                        static_cast<ProdIndex::type>(index),
+                        static_cast<ChunkSize::type>(canonChunkSize),
+                        priority,
+                        originTime,
+                        ttl,
+                        payloadCrc,
+                        traceId) +
                 name.serialize(encoder, version);
     }
 };
@@ -241,11 +408,17 @@ ProdInfo::ProdInfo()
 {}
 
 ProdInfo::ProdInfo(
-        const ProdIndex index,
-        const ProdName& name,
-        const ProdSize  size,
-        const ChunkSize canonChunkSize)
-    : pImpl(new Impl(index, name, size, canonChunkSize))
+        const ProdIndex  index,
+        const ProdName&  name,
+        const ProdSize   size,
+        const ChunkSize  canonChunkSize,
+        const Priority   priority,
+        const OriginTime originTime,
+        const TtlSecs    ttl,
+        const PayloadCrc payloadCrc,
+        const TraceId    traceId)
+    : pImpl(new Impl(index, name, size, canonChunkSize, priority, originTime,
+            ttl, payloadCrc, traceId))
 {}
 
 ProdInfo::ProdInfo(
@@ -308,6 +481,72 @@ ProdSize ProdInfo::getSize() const noexcept
     return pImpl->getSize();
 }
 
+ProdInfo::Priority ProdInfo::getPriority() const noexcept
+{
+    return pImpl->getPriority();
+}
+
+ProdInfo::OriginTime ProdInfo::getOriginTime() const noexcept
+{
+    return pImpl->getOriginTime();
+}
+
+void ProdInfo::setOriginTime(const OriginTime originTime) const noexcept
+{
+    pImpl->setOriginTime(originTime);
+}
+
+ProdInfo::TtlSecs ProdInfo::getTtl() const noexcept
+{
+    return pImpl->getTtl();
+}
+
+bool ProdInfo::isExpired() const noexcept
+{
+    return pImpl->isExpired();
+}
+
+ProdInfo::PayloadCrc ProdInfo::getPayloadCrc() const noexcept
+{
+    return pImpl->getPayloadCrc();
+}
+
+void ProdInfo::setPayloadCrc(const PayloadCrc payloadCrc) const noexcept
+{
+    pImpl->setPayloadCrc(payloadCrc);
+}
+
+ProdInfo::TraceId ProdInfo::getTraceId() const noexcept
+{
+    return pImpl->getTraceId();
+}
+
+void ProdInfo::setTraceId(const TraceId traceId) const noexcept
+{
+    pImpl->setTraceId(traceId);
+}
+
+bool ProdInfo::isSampled() const noexcept
+{
+    return (pImpl->getTraceId() & 1) != 0;
+}
+
+ProdInfo::TraceId ProdInfo::mintTraceId(const bool sampled) noexcept
+{
+    static thread_local std::mt19937_64 generator{std::random_device{}()};
+    TraceId traceId;
+    do {
+        traceId = (generator() << 1) | (sampled ? 1 : 0);
+    } while ((traceId >> 1) == 0); // A zero identifier means not-minted
+    return traceId;
+}
+
+ProdInfo::OriginTime ProdInfo::now() noexcept
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
 bool ProdInfo::isEarlierThan(const ProdInfo& that) const noexcept
 {
     return pImpl->isEarlierThan(*that.pImpl.get());
@@ -374,7 +613,8 @@ ProdInfo ProdInfo::deserialize(
 {
     Impl impl{decoder, version};
     return ProdInfo{impl.getIndex(), impl.getName(), impl.getSize(),
-            impl.getChunkSize()};
+            impl.getChunkSize(), impl.getPriority(), impl.getOriginTime(),
+            impl.getTtl(), impl.getPayloadCrc(), impl.getTraceId()};
 }
 
 } // namespace
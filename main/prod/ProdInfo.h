@@ -30,6 +30,67 @@ class ProdInfo final : public Serializable<ProdInfo>
     std::shared_ptr<Impl> pImpl;
 
 public:
+    /**
+     * Type of a product's priority class. Higher values are more urgent.
+     * Carried in the serial representation so the class is honored by every
+     * node -- in the multicast scheduler, the peer send-queues, the
+     * chunk-request scheduler, and the local-processing worker pool -- and
+     * a severe-weather warning, for example, needn't share a FIFO with bulk
+     * model output.
+     */
+    typedef uint16_t Priority;
+
+    /// Default priority class (the least urgent)
+    static const Priority defaultPriority = 0;
+
+    /**
+     * Type of a product's origin timestamp: microseconds since the Unix
+     * epoch per the sending node's (presumably NTP-disciplined) system
+     * clock, or 0 if the product hasn't been transmitted. Carried in the
+     * serial representation so a receiver can compute the one-way,
+     * origin-to-completion latency without correlating logs across
+     * machines. Telemetry only: it doesn't participate in equality.
+     */
+    typedef uint64_t OriginTime;
+
+    /**
+     * Type of a product's time-to-live: seconds after the origin timestamp
+     * beyond which the product is worthless (e.g., a 10-minute nowcast), or
+     * 0 for no expiration. Carried in the serial representation so every
+     * node honors it: the backlog skips expired products, the chunk-request
+     * scheduler never requests them, and the product-store evicts them
+     * before the minimum residence-time -- after an outage, bandwidth
+     * concentrates on data that's still actionable.
+     */
+    typedef uint32_t TtlSecs;
+
+    /// Default time-to-live (no expiration)
+    static const TtlSecs defaultTtl = 0;
+
+    /**
+     * Type of a product's trace identifier: a random, nonzero value minted
+     * at the source, or 0 if no identifier was minted. Carried in the
+     * serial representation and stamped into the USDT probes and
+     * flight-recorder events of every node the product crosses, so the
+     * product's path through source, relays, and receivers can be
+     * correlated by one value instead of by product-index and guessed
+     * clocks. The low-order bit is the sampling flag: set iff the product
+     * was chosen for full-detail tracing. Like the origin timestamp, it's
+     * telemetry only and doesn't participate in equality.
+     */
+    typedef uint64_t TraceId;
+
+    /**
+     * Type of a product's payload checksum: the CRC32C of the product's
+     * entire data, or 0 if the source didn't compute one. Carried in the
+     * serial representation so a receiver can verify end-to-end integrity --
+     * catching reassembly bugs and source-side corruption that per-datagram
+     * checksums can't -- by comparing against a checksum it accumulates
+     * chunk-by-chunk as the product assembles. Like the origin timestamp,
+     * it's set only at the source and doesn't participate in equality.
+     */
+    typedef uint32_t PayloadCrc;
+
     /**
      * Default constructs.
      */
@@ -41,13 +102,25 @@ public:
      * @param[in] name         Product name
      * @param[in] size         Size of product in bytes
      * @param[in] chunkSize    Size of canonical data-chunk in bytes
+     * @param[in] priority     Priority class. Higher values are more urgent.
+     * @param[in] originTime   Origin timestamp or 0 for not-yet-transmitted
+     * @param[in] ttl          Time-to-live in seconds after the origin
+     *                         timestamp or 0 for no expiration
+     * @param[in] payloadCrc   CRC32C of the product's data or 0 for not
+     *                         computed
+     * @param[in] traceId      Trace identifier or 0 for not minted
      * @throws InvalidArgument `name.size() > prodNameSizeMax`
      */
     ProdInfo(
-            const ProdIndex index,
-            const ProdName& name,
-            const ProdSize  size,
-            const ChunkSize chunkSize = ChunkSize::defaultSize);
+            const ProdIndex  index,
+            const ProdName&  name,
+            const ProdSize   size,
+            const ChunkSize  chunkSize = ChunkSize::defaultSize,
+            const Priority   priority = defaultPriority,
+            const OriginTime originTime = 0,
+            const TtlSecs    ttl = defaultTtl,
+            const PayloadCrc payloadCrc = 0,
+            const TraceId    traceId = 0);
 
     /**
      * Constructs a partial instance. The name will be the empty string.
@@ -104,6 +177,125 @@ public:
      */
     ProdSize getSize() const noexcept;
 
+    /**
+     * Returns the priority class of the product. Higher values are more
+     * urgent.
+     * @return Priority class of the product
+     * @exceptionsafety Nothrow
+     * @threadsafety    Safe
+     */
+    Priority getPriority() const noexcept;
+
+    /**
+     * Returns the origin timestamp: the time of the product's first
+     * transmission in microseconds since the Unix epoch, or 0 if the product
+     * hasn't been transmitted.
+     * @return Origin timestamp
+     * @exceptionsafety Nothrow
+     * @threadsafety    Safe
+     */
+    OriginTime getOriginTime() const noexcept;
+
+    /**
+     * Sets the origin timestamp. Does nothing if the timestamp is already
+     * set, so retransmissions -- e.g., the backlog -- keep the
+     * first-transmission stamp. The timestamp is shared by all copies of
+     * this instance.
+     * @param[in] originTime  Origin timestamp
+     * @exceptionsafety Nothrow
+     * @threadsafety    Compatible but not safe
+     */
+    void setOriginTime(const OriginTime originTime) const noexcept;
+
+    /**
+     * Returns the current time as an origin timestamp: microseconds since
+     * the Unix epoch per the system clock, which NTP is assumed to
+     * discipline.
+     * @return Current time
+     * @exceptionsafety Nothrow
+     * @threadsafety    Safe
+     */
+    static OriginTime now() noexcept;
+
+    /**
+     * Returns the time-to-live: seconds after the origin timestamp beyond
+     * which the product is worthless, or 0 for no expiration.
+     * @return Time-to-live in seconds
+     * @exceptionsafety Nothrow
+     * @threadsafety    Safe
+     */
+    TtlSecs getTtl() const noexcept;
+
+    /**
+     * Returns the payload checksum: the CRC32C of the product's entire data,
+     * or 0 if the source didn't compute one.
+     * @return Payload checksum
+     * @exceptionsafety Nothrow
+     * @threadsafety    Safe
+     */
+    PayloadCrc getPayloadCrc() const noexcept;
+
+    /**
+     * Sets the payload checksum. Does nothing if the checksum is already
+     * set, so retransmissions keep the checksum computed at first shipment.
+     * The checksum is shared by all copies of this instance.
+     * @param[in] payloadCrc  Payload checksum
+     * @exceptionsafety Nothrow
+     * @threadsafety    Compatible but not safe
+     */
+    void setPayloadCrc(const PayloadCrc payloadCrc) const noexcept;
+
+    /**
+     * Returns the trace identifier: a random value minted at the source, or
+     * 0 if none was minted.
+     * @return Trace identifier
+     * @exceptionsafety Nothrow
+     * @threadsafety    Safe
+     */
+    TraceId getTraceId() const noexcept;
+
+    /**
+     * Sets the trace identifier. Does nothing if the identifier is already
+     * set, so retransmissions keep the identifier minted at first shipment.
+     * The identifier is shared by all copies of this instance.
+     * @param[in] traceId  Trace identifier
+     * @exceptionsafety Nothrow
+     * @threadsafety    Compatible but not safe
+     */
+    void setTraceId(const TraceId traceId) const noexcept;
+
+    /**
+     * Indicates if the product was chosen for full-detail tracing -- i.e.,
+     * the trace identifier is set and its sampling flag is on.
+     * @retval `true`   The product is sampled
+     * @retval `false`  The product is not sampled
+     * @exceptionsafety Nothrow
+     * @threadsafety    Safe
+     */
+    bool isSampled() const noexcept;
+
+    /**
+     * Mints a trace identifier: random, nonzero, with the low-order bit set
+     * iff the product should get full-detail tracing.
+     * @param[in] sampled  Whether the product is chosen for full-detail
+     *                     tracing
+     * @return             New trace identifier
+     * @exceptionsafety    Nothrow
+     * @threadsafety       Safe
+     */
+    static TraceId mintTraceId(const bool sampled) noexcept;
+
+    /**
+     * Indicates if the product has expired: its time-to-live is set, its
+     * origin timestamp is set, and more than the time-to-live has elapsed
+     * since the origin timestamp. An untransmitted product can't expire.
+     * @retval `true`   The product has expired
+     * @retval `false`  The product hasn't expired
+     * @exceptionsafety Nothrow
+     * @threadsafety    Safe
+     */
+    bool isExpired() const noexcept;
+
     /**
      * Indicates if this instance is earlier than another.
      * @param[in] that   Other instance
@@ -232,6 +424,29 @@ public:
      */
     size_t getSerialSize(unsigned version) const noexcept;
 
+    /**
+     * Returns an upper bound, known at compile time, on the number of bytes
+     * in the serial representation of any instance. The bound is tight: the
+     * product name is the only variable-length field and its length is
+     * limited to `ProdName::prodNameMax`.
+     * Keep consistent with `ProdInfo::Impl::getSerialSize()`.
+     * @param[in] version  Protocol version
+     * @return the maximum number of bytes in a serial representation
+     */
+    static constexpr size_t getMaxSerialSize(const unsigned version)
+            noexcept {
+        return ProdSize::getStaticSerialSize(version) +
+                ProdIndex::getStaticSerialSize(version) +
+                ChunkSize::getStaticSerialSize(version) +
+                Codec::getSerialSize(sizeof(Priority)) + // Priority class
+                Codec::getSerialSize(sizeof(OriginTime)) + // Origin timestamp
+                Codec::getSerialSize(sizeof(TtlSecs)) +  // Time-to-live
+                Codec::getSerialSize(sizeof(PayloadCrc)) + // Payload checksum
+                Codec::getSerialSize(sizeof(TraceId)) +  // Trace identifier
+                Codec::getSerialSize(sizeof(uint16_t)) + // Name length
+                ProdName::prodNameMax;                   // Name characters
+    }
+
     /**
      * Serializes this instance to an encoder.
      * @param[in] encoder   Encoder
@@ -1,5 +1,7 @@
 /**
- * This file declares the name of a data-product.
+ * This file declares the name of a data-product. The name resides in a
+ * fixed-capacity buffer within the instance, so copying a name -- which
+ * happens on every product-information copy -- never allocates.
  *
  * Copyright 2017 University Corporation for Atmospheric Research. All Rights
  * reserved. See file "Copying" in the top-level source-directory for usage
@@ -15,39 +17,59 @@
 
 #include "error.h"
 
+#include <cstdint>
+#include <cstring>
 #include <string>
 
 namespace hycast {
 
 class ProdName final : public Serializable<ProdName>
 {
-    std::string name;
+public:
+    /// Maximum length of a product name in bytes
+    static const uint16_t prodNameMax = 48;
+
+private:
+    char     name[prodNameMax+1]; ///< NUL-terminated product name
+    uint16_t len;                 ///< Length of product name in bytes
+
+    /**
+     * Vets a product-name length.
+     * @param[in] length           Length of product name in bytes
+     * @throw     InvalidArgument  Name is too long
+     */
+    static void vetLength(const size_t length)
+    {
+        if (length > prodNameMax)
+            throw INVALID_ARGUMENT("Name too long: length=" +
+                    std::to_string(length) + ", max=" +
+                    std::to_string(prodNameMax));
+    }
 
     ProdName(
             Decoder&       decoder,
             const unsigned version)
     {
-        decoder.decode(name);
-        if (name.length() > prodNameMax)
-            throw INVALID_ARGUMENT("Name too long: length=" +
-                    std::to_string(name.length()) + ", max=" +
-                    std::to_string(prodNameMax));
+        // The view avoids a temporary heap `std::string` per decoded name
+        const auto view = decoder.decodeStringRef();
+        vetLength(view.len);
+        len = static_cast<uint16_t>(view.len);
+        ::memcpy(name, view.data, len);
+        name[len] = 0;
     }
 
 public:
-    static const uint16_t prodNameMax = UINT16_MAX;
-
     inline ProdName()
         : name{}
+        , len{0}
     {}
 
     inline ProdName(const std::string& name)
-        : name{name}
     {
-        if (name.length() > prodNameMax)
-            throw INVALID_ARGUMENT("Name too long: length=" +
-                    std::to_string(name.length()) + ", max=" +
-                    std::to_string(prodNameMax));
+        vetLength(name.length());
+        len = static_cast<uint16_t>(name.length());
+        ::memcpy(this->name, name.data(), len);
+        this->name[len] = 0;
     }
 
     inline ProdName(const char* name)
@@ -56,22 +78,22 @@ public:
 
     inline size_t length() const noexcept
     {
-        return name.length();
+        return len;
     }
 
     inline operator std::string() const
     {
-        return name;
+        return std::string{name, len};
     }
 
     inline const std::string to_string() const
     {
-        return name;
+        return std::string{name, len};
     }
 
     inline const char* c_str() const noexcept
     {
-        return name.c_str();
+        return name;
     }
 
     /**
@@ -87,7 +109,11 @@ public:
      */
     inline int compare(const ProdName& that) const
     {
-        return name.compare(that.name);
+        const auto minLen = (len < that.len) ? len : that.len;
+        const int  cmp = ::memcmp(name, that.name, minLen);
+        return cmp
+                ? cmp
+                : static_cast<int>(len) - static_cast<int>(that.len);
     }
 
     /**
@@ -97,14 +123,14 @@ public:
      * @return the number of bytes in the serial representation
      */
     inline size_t getSerialSize(unsigned version) const noexcept {
-        return Codec::getSerialSize(name);
+        return Codec::getSerialSize(&len) + len;
     }
 
     inline size_t serialize(
             Encoder&       encoder,
             const unsigned version) const
     {
-        return encoder.encode(name);
+        return encoder.encode(std::string{name, len});
     }
 
     inline static ProdName deserialize(
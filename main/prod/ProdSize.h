@@ -84,7 +84,8 @@ public:
      * @param[in] version  Protocol version
      * @return the number of bytes in the serial representation
      */
-    static size_t getStaticSerialSize(const unsigned version) noexcept {
+    static constexpr size_t getStaticSerialSize(const unsigned version)
+            noexcept {
         return Codec::getSerialSize(sizeof(type));
     }
 
@@ -11,120 +11,637 @@
 
 #include "config.h"
 
+#include "Crc32c.h"
+#include "DelayQueue.h"
 #include "error.h"
 #include "FixedDelayQueue.h"
+#include "FlightRecorder.h"
+#include "MemBudget.h"
+#include "Metrics.h"
+#include "OpAccounting.h"
+#include "probe.h"
 #include "ProdStore.h"
 #include "Product.h"
+#include "Tunables.h"
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
 #include <exception>
 #include <fstream>
+#include <malloc.h>
 #include <map>
+#include <memory>
+#include <set>
 #include <mutex>
 #include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
 #include <thread>
+#include <unistd.h>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <zlib.h>
 
 namespace hycast {
 
-/// Product entry
+/// Product entry. A "hot" entry holds its product uncompressed in memory. A
+/// complete entry whose age exceeds the cold-tier threshold is frozen: its
+/// data is zlib-compressed and the product is released. A frozen entry is
+/// transparently thawed when its product or a chunk of its data is requested
+/// (e.g., by a `Backlogger` or a peer).
 class ProdEntry
 {
-    Product prod;
+    Product           prod;
+    /// Information on the product. Valid only while the entry is cold.
+    ProdInfo          info;
+    /// zlib-compressed product data. Empty <=> entry is hot.
+    std::vector<char> coldData;
+    /// Uncompressed product data of a thawed entry. `prod` references it.
+    /// Reference-counted so chunks served to peers can keep it alive.
+    std::shared_ptr<std::vector<char>> hotBuf;
+    /// CRC32C of each received chunk's data, indexed by chunk. Computed as
+    /// the chunk is stored -- while its bytes are hot in cache -- and folded
+    /// into the whole-payload checksum at completion, so end-to-end
+    /// verification costs no re-read of the product. Released after
+    /// verification.
+    std::vector<uint32_t>              chunkCrcs;
+    /// Number of chunk checksums computed
+    ChunkIndex::type                   numChunkCrcs{0};
+    /// Whether the payload checksum has been verified (or can't be)
+    bool                               crcVerified{false};
+
+    inline bool isCold() const noexcept
+    {
+        return !coldData.empty();
+    }
+
+    /**
+     * Computes the CRC32C of a just-stored chunk's data while its bytes are
+     * hot in cache. Verifies the whole-payload checksum if the chunk was the
+     * product's last.
+     * @param[in] chunk  Chunk that was just added to the product
+     */
+    void crcChunk(const LatentChunk& chunk)
+    {
+        if (chunkCrcs.empty())
+            chunkCrcs.resize(prod.getInfo().getNumChunks());
+        chunkCrcs[chunk.getIndex()] = crc32c(0,
+                prod.getData() + chunk.getOffset(), chunk.getSize());
+        ++numChunkCrcs;
+        verifyPayload();
+    }
+
+    /**
+     * Verifies the product's payload against the checksum carried in its
+     * product-information: folds the per-chunk checksums, in chunk order,
+     * into the whole-payload CRC32C and compares. Runs once, when both every
+     * chunk has been checksummed and the product-information has arrived --
+     * either may come last. A mismatch -- a reassembly bug or source-side
+     * corruption that per-datagram checksums can't catch -- is logged and
+     * counted; an absent checksum (the source didn't compute one, e.g., a
+     * streamed shipment) verifies vacuously.
+     * @exceptionsafety Basic guarantee
+     * @threadsafety    Compatible but not safe
+     */
+    void verifyPayload()
+    {
+        const auto& prodInfo = prod.getInfo();
+        if (crcVerified || !prodInfo.isComplete() ||
+                numChunkCrcs != prodInfo.getNumChunks())
+            return;
+        crcVerified = true;
+        const auto expected = prodInfo.getPayloadCrc();
+        if (expected != 0) {
+            uint32_t   crc = 0;
+            const auto numChunks = prodInfo.getNumChunks();
+            for (ChunkIndex index{0}; index < numChunks; ++index)
+                crc = crc32cCombine(crc, chunkCrcs[index],
+                        prodInfo.getChunkSize(index));
+            if (crc != expected) {
+                LOG_WARN("Payload of completed product " +
+                        prodInfo.to_string() + " doesn't match the checksum "
+                        "carried from its source: computed=" +
+                        std::to_string(crc));
+                static auto& mismatches = Metrics::getCounter(
+                        "hycast_prodstore_payload_crc_mismatches_total",
+                        "Completed products whose reassembled payload didn't "
+                        "match the CRC32C carried from the source");
+                mismatches.add(1);
+            }
+        }
+        chunkCrcs = std::vector<uint32_t>{};
+    }
 
 public:
-    ProdEntry(const ProdInfo& prodInfo)
-        : prod{PartialProduct{prodInfo}}
+    /**
+     * Default constructs. The resulting instance holds no product.
+     */
+    ProdEntry()
+        : prod{}
     {}
 
-    ProdEntry(ProdInfo&& prodInfo)
-        : prod{PartialProduct{prodInfo}}
+    ProdEntry(
+            const ProdInfo& prodInfo,
+            const bool      hugePages = false)
+        : prod{PartialProduct{prodInfo, hugePages}}
     {}
 
-    ProdEntry(LatentChunk& chunk)
+    /**
+     * Constructs from a chunk that arrived before its product-information.
+     * The chunk's metadata carries the product's size and canonical
+     * chunk-size, so the product's entire data-region is speculatively
+     * allocated and the chunk is added to it; the product's name is backfilled
+     * when the product-information arrives.
+     * @param[in] chunk      First-arriving chunk of the product
+     * @param[in] hugePages  Whether the data-region should be backed by huge
+     *                       pages
+     */
+    ProdEntry(
+            LatentChunk& chunk,
+            const bool   hugePages = false)
         : ProdEntry{ProdInfo{chunk.getProdIndex(), chunk.getProdSize(),
-                chunk.getCanonSize()}}
+                chunk.getCanonSize()}, hugePages}
     {
-        prod.add(chunk);
+        if (prod.add(chunk))
+            crcChunk(chunk);
     }
 
     ProdEntry(Product& prod)
         : prod{prod}
     {}
 
+    /**
+     * Freezes this entry. Compresses the product's data, saves the product's
+     * information, and releases the product. Does nothing if the entry is
+     * already cold or the product is incomplete.
+     * @throw RuntimeError  Couldn't compress product data
+     * @exceptionsafety     Strong guarantee
+     * @threadsafety        Compatible but not safe
+     */
+    void freeze()
+    {
+        if (isCold() || !prod.isComplete())
+            return;
+        const uLong       size = prod.getInfo().getSize();
+        uLongf            destLen = ::compressBound(size);
+        std::vector<char> buf(destLen);
+        const int         status = ::compress2(
+                reinterpret_cast<Bytef*>(buf.data()), &destLen,
+                reinterpret_cast<const Bytef*>(prod.getData()), size,
+                Z_DEFAULT_COMPRESSION);
+        if (status != Z_OK)
+            throw RUNTIME_ERROR("Couldn't compress product " +
+                    prod.getInfo().to_string() + ": zlib status=" +
+                    std::to_string(status));
+        buf.resize(destLen);
+        buf.shrink_to_fit();
+        info = prod.getInfo();
+        coldData = std::move(buf);
+        prod = Product{};
+        hotBuf.reset(); // Any served chunk still references the data
+    }
+
+    /**
+     * Thaws this entry. Decompresses the product's data and reconstitutes the
+     * product. Does nothing if the entry is hot.
+     * @throw RuntimeError  Couldn't decompress product data
+     * @exceptionsafety     Strong guarantee
+     * @threadsafety        Compatible but not safe
+     */
+    void thaw()
+    {
+        if (!isCold())
+            return;
+        const uLong       size = info.getSize();
+        uLongf            destLen = size;
+        std::vector<char> buf(size);
+        const int         status = ::uncompress(
+                reinterpret_cast<Bytef*>(buf.data()), &destLen,
+                reinterpret_cast<const Bytef*>(coldData.data()),
+                coldData.size());
+        if (status != Z_OK || destLen != size)
+            throw RUNTIME_ERROR("Couldn't decompress product " +
+                    info.to_string() + ": zlib status=" +
+                    std::to_string(status));
+        hotBuf = std::make_shared<std::vector<char>>(std::move(buf));
+        prod = MemoryProduct{info.getIndex(), info.getName(), info.getSize(),
+                hotBuf->data(), info.getChunkSize()};
+        coldData = std::vector<char>{};
+    }
+
+    /**
+     * Relocates this entry's compressed data into a fresh, exactly-sized
+     * allocation and frees the old one. A cold entry's data may live for
+     * weeks in whatever heap region it happened to land in, pinning the
+     * region's pages among freed neighbors of other sizes; periodically
+     * re-allocating the long-lived bytes lets the allocator coalesce the
+     * vacated space. Does nothing if the entry is hot.
+     * @return           Number of bytes copied
+     * @exceptionsafety  Strong guarantee
+     * @threadsafety     Compatible but not safe
+     */
+    size_t relocate()
+    {
+        if (!isCold())
+            return 0;
+        std::vector<char> fresh{coldData};
+        coldData.swap(fresh);
+        return coldData.size();
+    }
+
     inline bool isEarlierThan(ProdEntry& that)
     {
-        return prod.isEarlierThan(that.prod);
+        return getInfo().getIndex().isEarlierThan(that.getInfo().getIndex());
     }
 
     inline ChunkId identifyEarliestMissingChunk() const
     {
-        return prod.identifyEarliestMissingChunk();
+        // A cold entry is complete and, consequently, has no missing chunk
+        return isCold()
+                ? ChunkId{}
+                : prod.identifyEarliestMissingChunk();
     }
 
     inline bool set(const ProdInfo& prodInfo)
     {
-        return prod.set(prodInfo);
+        if (isCold())
+            return false; // A cold entry already has its product-information
+        const bool result = prod.set(prodInfo);
+        // The product-information -- and the checksum it carries -- may
+        // arrive after the final chunk
+        verifyPayload();
+        return result;
     }
 
     inline bool add(LatentChunk& chunk)
     {
-        return prod.add(chunk);
+        if (isCold()) {
+            chunk.discard(); // A cold entry already has all its chunks
+            return false;
+        }
+        if (!prod.add(chunk))
+            return false;
+        crcChunk(chunk);
+        return true;
     }
 
     inline const ProdInfo& getInfo() const
     {
-        return prod.getInfo();
+        return isCold()
+                ? info
+                : prod.getInfo();
     }
 
     inline bool isComplete() const
     {
-        return prod.isComplete();
+        return isCold() || prod.isComplete();
     }
 
-    const inline Product& getProduct() const
+    const inline Product& getProduct()
     {
+        thaw();
         return prod;
     }
 
     inline bool haveChunk(const ChunkIndex index) const
     {
-        return prod.haveChunk(index);
+        return isCold()
+                ? index < info.getNumChunks()
+                : prod.haveChunk(index);
     }
 
     inline ActualChunk getChunk(const ChunkIndex index)
     {
-        return prod.getChunk(index);
+        thaw();
+        auto chunk = prod.getChunk(index);
+        // A thawed entry's data lives in `hotBuf` rather than in the product
+        if (chunk && hotBuf)
+            chunk.keepData(hotBuf);
+        return chunk;
+    }
+
+    /**
+     * Indicates if this entry holds a product.
+     * @retval `true`  Iff this entry holds a product
+     */
+    inline explicit operator bool() const noexcept
+    {
+        return prod || isCold();
+    }
+};
+
+/******************************************************************************/
+
+/// Structure-of-arrays sidecar of per-product metadata. The hot per-product
+/// bookkeeping -- index, arrival time, size, chunk counts, state flags -- is
+/// held in contiguous parallel arrays keyed by slot, so maintenance scans
+/// (memory-pressure relief, completeness checks) stream through cache lines
+/// instead of chasing shard-map nodes, `shared_ptr` control blocks, and
+/// `ProdInfo` strings; cold details -- the name, the data -- stay in the
+/// product entries. A removed product's slot is recycled, so the arrays'
+/// length tracks the store's occupancy rather than its history.
+class ProdMetaTable
+{
+public:
+    /// State flags of a product
+    enum : uint8_t {
+        RESIDENT = 1, ///< The slot holds a product
+        COMPLETE = 2, ///< The product has all its data-chunks
+        COLD     = 4, ///< The entry was frozen into the compressed cold tier
+    };
+
+private:
+    typedef std::mutex             Mutex;
+    typedef std::lock_guard<Mutex> LockGuard;
+
+    mutable Mutex                 mutex;
+    /// Parallel arrays keyed by slot:
+    std::vector<ProdIndex::type>  indexes;   ///< Product indexes
+    std::vector<uint64_t>         arrivals;  ///< Arrival times: microseconds
+                                             ///< on the steady clock
+    std::vector<ProdSize::type>   sizes;     ///< Product sizes in bytes
+    std::vector<ChunkIndex::type> numChunks; ///< Total data-chunks
+    std::vector<ChunkIndex::type> received;  ///< Received data-chunks
+    std::vector<uint8_t>          flags;     ///< State flags
+    /// Recyclable slots of removed products
+    std::vector<size_t>           freeSlots;
+    /// Slot of each resident product
+    std::unordered_map<ProdIndex::type, size_t> slots;
+
+    /**
+     * Returns the current time as an arrival timestamp.
+     * @return Microseconds on the steady clock
+     */
+    static uint64_t nowMicros()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+public:
+    ProdMetaTable()
+        : mutex{}
+        , indexes{}
+        , arrivals{}
+        , sizes{}
+        , numChunks{}
+        , received{}
+        , flags{}
+        , freeSlots{}
+        , slots{}
+    {}
+
+    /**
+     * Adds a product. Does nothing if the product is already present.
+     * @param[in] index      Index of the product
+     * @param[in] size       Size of the product in bytes
+     * @param[in] nChunks    Total number of the product's data-chunks
+     * @param[in] nReceived  Number of data-chunks received so far
+     * @param[in] complete   Whether the product is complete
+     */
+    void add(
+            const ProdIndex&       index,
+            const ProdSize         size,
+            const ChunkIndex::type nChunks,
+            const ChunkIndex::type nReceived,
+            const bool             complete)
+    {
+        const auto    key = static_cast<ProdIndex::type>(index);
+        const uint8_t state = complete ? (RESIDENT | COMPLETE) : RESIDENT;
+        LockGuard     lock{mutex};
+        if (slots.find(key) != slots.end())
+            return;
+        size_t slot;
+        if (freeSlots.empty()) {
+            slot = indexes.size();
+            indexes.push_back(key);
+            arrivals.push_back(nowMicros());
+            sizes.push_back(static_cast<ProdSize::type>(size));
+            numChunks.push_back(nChunks);
+            received.push_back(nReceived);
+            flags.push_back(state);
+        }
+        else {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+            indexes[slot] = key;
+            arrivals[slot] = nowMicros();
+            sizes[slot] = static_cast<ProdSize::type>(size);
+            numChunks[slot] = nChunks;
+            received[slot] = nReceived;
+            flags[slot] = state;
+        }
+        slots[key] = slot;
+    }
+
+    /**
+     * Accepts the reception of data-chunks of a product. Does nothing if the
+     * product isn't present.
+     * @param[in] index  Index of the product
+     * @param[in] n      Number of newly-received data-chunks
+     */
+    void addReceived(
+            const ProdIndex&       index,
+            const ChunkIndex::type n)
+    {
+        LockGuard lock{mutex};
+        auto      iter = slots.find(static_cast<ProdIndex::type>(index));
+        if (iter == slots.end())
+            return;
+        const auto slot = iter->second;
+        received[slot] += n;
+        if (received[slot] >= numChunks[slot])
+            flags[slot] |= COMPLETE;
+    }
+
+    /**
+     * Marks a product as complete. Does nothing if the product isn't present.
+     * @param[in] index  Index of the product
+     */
+    void setComplete(const ProdIndex& index)
+    {
+        LockGuard lock{mutex};
+        auto      iter = slots.find(static_cast<ProdIndex::type>(index));
+        if (iter == slots.end())
+            return;
+        const auto slot = iter->second;
+        received[slot] = numChunks[slot];
+        flags[slot] |= COMPLETE;
+    }
+
+    /**
+     * Marks a product as frozen into the cold tier. Does nothing if the
+     * product isn't present.
+     * @param[in] index  Index of the product
+     */
+    void setCold(const ProdIndex& index)
+    {
+        LockGuard lock{mutex};
+        auto      iter = slots.find(static_cast<ProdIndex::type>(index));
+        if (iter != slots.end())
+            flags[iter->second] |= COLD;
+    }
+
+    /**
+     * Removes a product. Its slot is recycled. Does nothing if the product
+     * isn't present.
+     * @param[in] index  Index of the product
+     */
+    void remove(const ProdIndex& index)
+    {
+        LockGuard lock{mutex};
+        auto      iter = slots.find(static_cast<ProdIndex::type>(index));
+        if (iter == slots.end())
+            return;
+        flags[iter->second] = 0;
+        freeSlots.push_back(iter->second);
+        slots.erase(iter);
+    }
+
+    /**
+     * Returns the fraction of a product's data-chunks that have been
+     * received. Costs one hash probe and two array reads -- no shard lock
+     * and no pointer-chase into the product.
+     * @param[in] index  Index of the product
+     * @return           Completeness fraction in `[0,1]`. 0 if the product
+     *                   isn't present.
+     */
+    double getCompleteness(const ProdIndex& index) const
+    {
+        LockGuard lock{mutex};
+        auto      iter = slots.find(static_cast<ProdIndex::type>(index));
+        if (iter == slots.end())
+            return 0;
+        const auto slot = iter->second;
+        if (flags[slot] & COMPLETE)
+            return 1;
+        return numChunks[slot]
+                ? static_cast<double>(received[slot])/numChunks[slot]
+                : 1;
+    }
+
+    /**
+     * Pre-sizes this instance for an expected number of resident products.
+     * @param[in] numProds  Expected number of resident products
+     */
+    void reserve(const size_t numProds)
+    {
+        LockGuard lock{mutex};
+        indexes.reserve(numProds);
+        arrivals.reserve(numProds);
+        sizes.reserve(numProds);
+        numChunks.reserve(numProds);
+        received.reserve(numProds);
+        flags.reserve(numProds);
+        slots.reserve(numProds);
+    }
+
+    /**
+     * Grows the slot-table ahead of need when its occupancy nears the rehash
+     * threshold, so the rehash is paid here -- on a maintenance thread --
+     * rather than by an ingest thread's insert.
+     */
+    void growIfNeeded()
+    {
+        LockGuard    lock{mutex};
+        const size_t limit = slots.bucket_count()*slots.max_load_factor();
+        if (slots.bucket_count() == 0 || 8*slots.size() >= 7*limit)
+            slots.reserve(2*slots.size() + 16);
+    }
+
+    /**
+     * Returns a snapshot of the resident products' indexes, earliest arrival
+     * first -- e.g., so the memory-pressure reliever can evict oldest-first
+     * without probing every possible index in the store's range. Streams
+     * once through the parallel arrays.
+     * @param[out] result  Resident product-indexes, earliest arrival first
+     */
+    void getResident(std::vector<ProdIndex::type>& result) const
+    {
+        std::vector<std::pair<uint64_t, ProdIndex::type>> byArrival{};
+        {
+            LockGuard  lock{mutex};
+            const auto numSlots = indexes.size();
+            byArrival.reserve(slots.size());
+            for (size_t slot = 0; slot < numSlots; ++slot)
+                if (flags[slot] & RESIDENT)
+                    byArrival.emplace_back(arrivals[slot], indexes[slot]);
+        }
+        std::sort(byArrival.begin(), byArrival.end());
+        result.clear();
+        result.reserve(byArrival.size());
+        for (const auto& elt : byArrival)
+            result.push_back(elt.second);
     }
 };
 
 /******************************************************************************/
 
-/// Map of products
+/// Map of products. The map is sharded across independently-locked
+/// sub-maps so that concurrent ingest threads contend for a lock only when
+/// they touch products in the same shard.
 class ProdMap
 {
     typedef std::mutex             Mutex;
     typedef std::lock_guard<Mutex> LockGuard;
 
-    mutable Mutex                            mutex;
-    /// Map of products
-    std::unordered_map<ProdIndex, ProdEntry> prods;
-    /// Map of incomplete products
-    std::map<ProdIndex, ProdEntry*>          incomplete;
-    ProdIndex                                earliest;
-    ProdIndex                                latest;
-    static const ChunkId                     emptyChunkId;
+    /// Number of independently-locked shards
+    static const size_t numShards = 16;
+
+    /// Independently-locked portion of the map of products
+    struct Shard
+    {
+        mutable Mutex                            mutex;
+        /// Map of products
+        std::unordered_map<ProdIndex, ProdEntry> prods;
+    };
+
+    mutable Shard            shards[numShards];
+    /// Guards the bookkeeping that spans shards
+    mutable Mutex            bookMutex;
+    /// Indexes of incomplete products
+    std::set<ProdIndex>      incomplete;
+    /// Ordered index of every stored product. Lets a `ChunkInfoIterator`
+    /// seek to a starting product -- and skip runs of expired products --
+    /// in O(log n) instead of probing every possible index
+    std::set<ProdIndex>      ordered;
+    ProdIndex                earliest;
+    ProdIndex                latest;
+    size_t                   numProds;
+    /// Whether product data buffers should be backed by huge pages
+    const bool               hugePages;
+    /// Structure-of-arrays sidecar of per-product metadata for maintenance
+    /// scans and completeness checks
+    ProdMetaTable            meta;
+    static const ChunkId     emptyChunkId;
+
+    /**
+     * Returns the shard for a given product.
+     * @param[in] index  Product index
+     * @return           Shard that contains the product
+     */
+    inline Shard& getShard(const ProdIndex& index) const noexcept
+    {
+        return shards[index.hash() % numShards];
+    }
 
     /**
      * Updates the indexes of the earliest and latest products that this
-     * instance contains.
-     * @pre `mutex` is locked
+     * instance contains and the number of products.
+     * @pre `bookMutex` is locked
      * @param[in] index  Product index
      */
-    void updateEndIndexes(const ProdIndex& index)
+    void countNewProd(const ProdIndex& index)
     {
-        if (prods.size() == 0) {
+        if (numProds == 0) {
             latest = earliest = index;
         }
         else {
@@ -133,15 +650,26 @@ class ProdMap
             if (latest.isEarlierThan(index))
                 latest = index;
         }
+        ++numProds;
+        ordered.insert(index);
     }
 
 public:
-    ProdMap()
-        : mutex{}
-        , prods{}
+    /**
+     * Constructs.
+     * @param[in] hugePages  Whether product data buffers should be backed by
+     *                       huge pages
+     */
+    explicit ProdMap(const bool hugePages = false)
+        : shards{}
+        , bookMutex{}
         , incomplete{}
+        , ordered{}
         , earliest{}
         , latest{}
+        , numProds{0}
+        , hugePages{hugePages}
+        , meta{}
     {}
 
     /**
@@ -155,12 +683,21 @@ public:
      */
     bool add(Product& prod)
     {
-        LockGuard  lock{mutex};
         auto       prodIndex = prod.getIndex();
-        auto       pair = prods.emplace(prodIndex, ProdEntry{prod});
+        auto&      shard = getShard(prodIndex);
+        LockGuard  lock{shard.mutex};
+        auto       pair = shard.prods.emplace(prodIndex, ProdEntry{prod});
         const bool isNew = pair.second;
+        if (isNew) {
+            const auto& info = prod.getInfo();
+            meta.add(prodIndex, info.getSize(), info.getNumChunks(),
+                    static_cast<ChunkIndex::type>(
+                            prod.getNumReceivedChunks()),
+                    prod.isComplete());
+        }
+        LockGuard  bookLock{bookMutex};
         if (isNew)
-            updateEndIndexes(prodIndex);
+            countNewProd(prodIndex);
         incomplete.erase(prodIndex); // Just to make sure
         return isNew;
     }
@@ -169,24 +706,34 @@ public:
      * Adds information on a product.
      * @param[in]  prodInfo  Product information
      * @param[out] prod      Associated product
+     * @param[out] created   Whether the product's entry was created by this
+     *                       addition. `false` if the entry already existed
+     *                       (e.g., it was speculatively created by a chunk
+     *                       that arrived first).
      * @return               Status of addition
      * @see                  `ProdStore::AddStatus`
      */
     RecvStatus add(
             const ProdInfo&   prodInfo,
-            ProdEntry** const prodEntry)
+            ProdEntry** const prodEntry,
+            bool* const       created)
     {
-        LockGuard   lock{mutex};
         ProdEntry*  entry;
         RecvStatus  status{};
         const auto  prodIndex = prodInfo.getIndex();
-        auto        iter = prods.find(prodIndex);
-        if (iter == prods.end()) {
+        auto&       shard = getShard(prodIndex);
+        LockGuard   lock{shard.mutex};
+        auto        iter = shard.prods.find(prodIndex);
+        *created = iter == shard.prods.end();
+        if (*created) {
             status.setNew();
-            entry = &prods.emplace(prodIndex,
-                    ProdEntry{prodInfo}).first->second;
-            incomplete[prodIndex] = entry;
-            updateEndIndexes(prodIndex);
+            entry = &shard.prods.emplace(prodIndex,
+                    ProdEntry{prodInfo, hugePages}).first->second;
+            meta.add(prodIndex, prodInfo.getSize(), prodInfo.getNumChunks(),
+                    0, false);
+            LockGuard bookLock{bookMutex};
+            incomplete.insert(prodIndex);
+            countNewProd(prodIndex);
         }
         else {
             entry = &iter->second;
@@ -194,6 +741,8 @@ public:
                 status.setNew();
             if (entry->isComplete()) {
                 status.setComplete();
+                meta.setComplete(prodIndex);
+                LockGuard bookLock{bookMutex};
                 incomplete.erase(prodIndex);
             }
         }
@@ -202,33 +751,48 @@ public:
     }
 
     /**
-     * Adds a chunk of data.
-     * @param[in]  chunk  Chunk of data
-     * @param[out] prod   Associated product
-     * @return            Status of addition
-     * @see               `ProdStore::AddStatus`
+     * Adds a chunk of data. If the chunk arrives before its product's
+     * information, then the product's entry is speculatively created from the
+     * chunk's metadata.
+     * @param[in]  chunk    Chunk of data
+     * @param[out] prod     Associated product
+     * @param[out] created  Whether the product's entry was created by this
+     *                      addition
+     * @return              Status of addition
+     * @see                 `ProdStore::AddStatus`
      */
     RecvStatus add(
             LatentChunk&      chunk,
-            ProdEntry** const prodEntry)
+            ProdEntry** const prodEntry,
+            bool* const       created)
     {
-        LockGuard  lock{mutex};
         ProdEntry* entry;
         RecvStatus status{};
         const auto prodIndex = chunk.getProdIndex();
-        auto       iter = prods.find(prodIndex);
-        if (iter == prods.end()) {
+        auto&      shard = getShard(prodIndex);
+        LockGuard  lock{shard.mutex};
+        auto       iter = shard.prods.find(prodIndex);
+        *created = iter == shard.prods.end();
+        if (*created) {
             status.setNew();
-            entry = &prods.emplace(prodIndex, ProdEntry{chunk}).first->second;
-            incomplete[prodIndex] = entry;
-            updateEndIndexes(prodIndex);
+            entry = &shard.prods.emplace(prodIndex,
+                    ProdEntry{chunk, hugePages}).first->second;
+            meta.add(prodIndex, entry->getInfo().getSize(),
+                    entry->getInfo().getNumChunks(), 1, entry->isComplete());
+            LockGuard bookLock{bookMutex};
+            incomplete.insert(prodIndex);
+            countNewProd(prodIndex);
         }
         else {
             entry = &iter->second;
-            if (entry->add(chunk))
+            if (entry->add(chunk)) {
                 status.setNew();
+                meta.addReceived(prodIndex, 1);
+            }
             if (entry->isComplete()) {
                 status.setComplete();
+                meta.setComplete(prodIndex);
+                LockGuard bookLock{bookMutex};
                 incomplete.erase(prodIndex);
             }
         }
@@ -236,6 +800,112 @@ public:
         return status;
     }
 
+    /// Result of adding one product's group of a batch of chunks
+    struct GroupAdd
+    {
+        ProdEntry* entry;     ///< Entry of the group's product
+        ProdIndex  prodIndex; ///< Index of the group's product
+        RecvStatus status;    ///< Combined status of the group's additions
+        bool       created;   ///< Whether the group created the entry
+    };
+
+    /**
+     * Adds a batch of chunks of data. The batch is sorted by shard, then
+     * product, so each product's group of chunks is added under a single
+     * acquisition of its shard's lock and the group's completeness check
+     * runs once -- after the group's last chunk -- rather than per chunk.
+     * Equivalent to adding the chunks one at a time.
+     * @param[in]     chunks    Chunks of data
+     * @param[in,out] order     Positions in `chunks` of the chunks to be
+     *                          added. Sorted by shard, then product, on
+     *                          return.
+     * @param[out]    statuses  Status of each addition, parallel to `chunks`
+     * @param[out]    products  Associated product of each added chunk,
+     *                          parallel to `chunks`
+     * @param[out]    groups    Result of each product's group of additions
+     */
+    void add(
+            LatentChunk* const     chunks,
+            std::vector<size_t>&   order,
+            RecvStatus* const      statuses,
+            Product* const         products,
+            std::vector<GroupAdd>& groups)
+    {
+        std::sort(order.begin(), order.end(),
+                [this,chunks](const size_t a, const size_t b) {
+            const auto indexA = chunks[a].getProdIndex();
+            const auto indexB = chunks[b].getProdIndex();
+            const auto shardA = indexA.hash() % numShards;
+            const auto shardB = indexB.hash() % numShards;
+            if (shardA != shardB)
+                return shardA < shardB;
+            if (!(indexA == indexB))
+                return static_cast<ProdIndex::type>(indexA) <
+                        static_cast<ProdIndex::type>(indexB);
+            return a < b; // Preserves arrival order within a product
+        });
+        size_t i = 0;
+        while (i < order.size()) {
+            const auto prodIndex = chunks[order[i]].getProdIndex();
+            size_t     end = i + 1;
+            while (end < order.size() &&
+                    chunks[order[end]].getProdIndex() == prodIndex)
+                ++end;
+            GroupAdd group{};
+            group.prodIndex = prodIndex;
+            {
+                auto&     shard = getShard(prodIndex);
+                LockGuard lock{shard.mutex};
+                auto      iter = shard.prods.find(prodIndex);
+                size_t    first = i;
+                group.created = iter == shard.prods.end();
+                if (group.created) {
+                    statuses[order[i]].setNew();
+                    group.status.setNew();
+                    group.entry = &shard.prods.emplace(prodIndex,
+                            ProdEntry{chunks[order[i]], hugePages})
+                            .first->second;
+                    meta.add(prodIndex, group.entry->getInfo().getSize(),
+                            group.entry->getInfo().getNumChunks(), 1,
+                            group.entry->isComplete());
+                    LockGuard bookLock{bookMutex};
+                    incomplete.insert(prodIndex);
+                    countNewProd(prodIndex);
+                    first = i + 1;
+                }
+                else {
+                    group.entry = &iter->second;
+                }
+                ChunkIndex::type numAdded = 0;
+                for (size_t j = first; j < end; ++j) {
+                    if (group.entry->add(chunks[order[j]])) {
+                        statuses[order[j]].setNew();
+                        group.status.setNew();
+                        ++numAdded;
+                    }
+                }
+                // Per-group metadata update, like the completeness check
+                if (numAdded)
+                    meta.addReceived(prodIndex, numAdded);
+                // Grouped completeness check: once per product, after the
+                // group's last chunk
+                if (group.entry->isComplete()) {
+                    group.status.setComplete();
+                    meta.setComplete(prodIndex);
+                    for (size_t j = i; j < end; ++j)
+                        statuses[order[j]].setComplete();
+                    LockGuard bookLock{bookMutex};
+                    incomplete.erase(prodIndex);
+                }
+            }
+            const auto& prod = group.entry->getProduct();
+            for (size_t j = i; j < end; ++j)
+                products[order[j]] = prod;
+            groups.push_back(group);
+            i = end;
+        }
+    }
+
     /**
      * Returns the number of products in the store -- both complete and
      * incomplete.
@@ -243,22 +913,40 @@ public:
      */
     size_t size() const noexcept
     {
-        LockGuard lock{mutex};
-        return prods.size();
+        LockGuard lock{bookMutex};
+        return numProds;
     }
 
     ProdIndex getEarliest()
     {
-        LockGuard lock{mutex};
+        LockGuard lock{bookMutex};
         return earliest;
     }
 
     ProdIndex getLatest()
     {
-        LockGuard lock{mutex};
+        LockGuard lock{bookMutex};
         return latest;
     }
 
+    /**
+     * Returns the index of the oldest product this instance still holds.
+     * Unlike `getEarliest()`, which is a high-water cursor, the answer
+     * tracks eviction: a removed product no longer bounds it.
+     * @param[out] index  Index of the oldest resident product. Set iff a
+     *                    product is resident.
+     * @retval `true`     A product is resident
+     * @retval `false`    The instance is empty
+     */
+    bool getOldestResident(ProdIndex& index) const
+    {
+        LockGuard lock{bookMutex};
+        if (ordered.empty())
+            return false;
+        index = *ordered.begin();
+        return true;
+    }
+
     /**
      * Returns product-information on a given data-product.
      * @param[in]  index  Index of the data-product
@@ -269,13 +957,40 @@ public:
     ProdInfo getProdInfo(
             const ProdIndex index) const
     {
-        LockGuard lock{mutex};
-        auto iter = prods.find(index);
-        return (iter == prods.end())
+        auto&     shard = getShard(index);
+        LockGuard lock{shard.mutex};
+        auto iter = shard.prods.find(index);
+        return (iter == shard.prods.end())
             ? ProdInfo{}
             : iter->second.getInfo();
     }
 
+    /**
+     * Returns the fraction of a product's data-chunks that have been
+     * received. Answered from the metadata sidecar, so the check costs two
+     * array reads rather than a shard probe and a pointer-chase into the
+     * product.
+     * @param[in] index  Index of the product
+     * @return           Completeness fraction in `[0,1]`. 0 if the product
+     *                   doesn't exist.
+     */
+    double getCompleteness(const ProdIndex index) const
+    {
+        return meta.getCompleteness(index);
+    }
+
+    /**
+     * Returns a snapshot of the resident products' indexes, earliest arrival
+     * first. Streams through the metadata sidecar's contiguous arrays, so
+     * the cost scales with the products scanned rather than with cache
+     * misses or with the width of the store's index range.
+     * @param[out] result  Resident product-indexes, earliest arrival first
+     */
+    void getResident(std::vector<ProdIndex::type>& result) const
+    {
+        meta.getResident(result);
+    }
+
     /**
      * Indicates if this instance contains a given chunk of data.
      * @param[in] id    Chunk Id
@@ -284,9 +999,10 @@ public:
      */
     bool haveChunk(const ChunkId& id) const
     {
-        LockGuard lock{mutex};
-        auto      iter = prods.find(id.getProdIndex());
-        if (iter == prods.end())
+        auto&     shard = getShard(id.getProdIndex());
+        LockGuard lock{shard.mutex};
+        auto      iter = shard.prods.find(id.getProdIndex());
+        if (iter == shard.prods.end())
             return false;
         return iter->second.haveChunk(id.getChunkIndex());
     }
@@ -299,32 +1015,209 @@ public:
      */
     ActualChunk getChunk(const ChunkId& id)
     {
-        LockGuard lock{mutex};
-        auto      iter = prods.find(id.getProdIndex());
-        return (iter == prods.end())
+        auto&     shard = getShard(id.getProdIndex());
+        LockGuard lock{shard.mutex};
+        auto      iter = shard.prods.find(id.getProdIndex());
+        return (iter == shard.prods.end())
                 ? ActualChunk{}
                 : iter->second.getChunk(id.getChunkIndex());
     }
 
+    /**
+     * Freezes a product. Compresses the product's data and releases the
+     * product. Does nothing if the product doesn't exist, is incomplete, or
+     * is already frozen.
+     * @param[in] index     Index of the product
+     * @throw RuntimeError  Couldn't compress product data
+     * @exceptionsafety     Strong guarantee
+     * @threadsafety        Safe
+     */
+    void freeze(const ProdIndex& index)
+    {
+        auto&     shard = getShard(index);
+        LockGuard lock{shard.mutex};
+        auto      iter = shard.prods.find(index);
+        if (iter != shard.prods.end()) {
+            iter->second.freeze();
+            // Only a complete product freezes
+            if (iter->second.isComplete())
+                meta.setCold(index);
+        }
+    }
+
+    /**
+     * Relocates a cold product's compressed data into a fresh, exactly-sized
+     * allocation. Does nothing if the product doesn't exist or is hot.
+     * @param[in] index  Index of the product
+     * @return           Number of bytes copied
+     * @exceptionsafety  Strong guarantee
+     * @threadsafety     Safe
+     * @see `ProdEntry::relocate()`
+     */
+    size_t relocateCold(const ProdIndex& index)
+    {
+        auto&     shard = getShard(index);
+        LockGuard lock{shard.mutex};
+        auto      iter = shard.prods.find(index);
+        return (iter == shard.prods.end()) ? 0 : iter->second.relocate();
+    }
+
+    /**
+     * Pre-sizes this instance for an expected number of resident products.
+     * Each shard's hash table and the metadata sidecar are reserved so the
+     * expected population never triggers a rehash at all.
+     * @param[in] numProds  Expected number of resident products
+     */
+    void reserve(const size_t numProds)
+    {
+        const size_t perShard = (numProds + numShards - 1)/numShards;
+        for (size_t i = 0; i < numShards; ++i) {
+            LockGuard lock{shards[i].mutex};
+            shards[i].prods.reserve(perShard);
+        }
+        meta.reserve(numProds);
+    }
+
+    /**
+     * Grows any shard whose hash table is near its rehash threshold.
+     * Intended to run periodically on a maintenance thread: the rehash-all
+     * is then paid here, under the shard's lock but off the ingest threads,
+     * so no chunk insert ever pays it.
+     */
+    void growIfNeeded()
+    {
+        for (size_t i = 0; i < numShards; ++i) {
+            LockGuard    lock{shards[i].mutex};
+            auto&        map = shards[i].prods;
+            const size_t limit = map.bucket_count()*map.max_load_factor();
+            if (map.bucket_count() == 0 || 8*map.size() >= 7*limit)
+                map.reserve(2*map.size() + 16);
+        }
+        meta.growIfNeeded();
+    }
+
+    /**
+     * Sets a product index to the index of the earliest stored product that
+     * isn't earlier than it. Seeks in O(log n) on the ordered product-index,
+     * so starting a backlog -- or skipping a run of expired products -- never
+     * scans the store; a reconnect storm consequently can't stall ingest
+     * behind iterator scans. Holds only the bookkeeping lock and only for the
+     * duration of the seek.
+     * @param[in,out] index  Product index. Set iff such a product exists.
+     * @retval `true`        Such a product exists and `index` was set
+     * @retval `false`       No such product exists
+     * @threadsafety         Safe
+     */
+    bool seekNotEarlier(ProdIndex& index) const
+    {
+        LockGuard lock{bookMutex};
+        auto      iter = ordered.lower_bound(index);
+        if (iter == ordered.end())
+            return false;
+        index = *iter;
+        return true;
+    }
+
+    /**
+     * Returns the identity of the first chunk of the stored product that's
+     * `numProds` products back from the latest one (or of the earliest
+     * stored product if fewer are stored). Walks backwards over the ordered
+     * product-index under the bookkeeping lock, so the cost is bounded by
+     * `numProds` rather than by the size of the store.
+     * @param[in] numProds  Size of the recent window in products
+     * @return              Identity of the window's first chunk or an empty
+     *                      identifier if the store is empty
+     * @threadsafety        Safe
+     * @see `ChunkId::operator bool()`
+     */
+    ChunkId getRecentStart(const size_t numProds) const
+    {
+        ProdIndex prodIndex;
+        {
+            LockGuard lock{bookMutex};
+            auto      iter = ordered.rbegin();
+            if (iter == ordered.rend())
+                return emptyChunkId;
+            for (size_t i = 1; i < numProds; ++i) {
+                if (++iter == ordered.rend()) {
+                    --iter;
+                    break;
+                }
+            }
+            prodIndex = *iter;
+        }
+        const auto prodInfo = getProdInfo(prodIndex);
+        return prodInfo
+                ? ChunkId{prodInfo, ChunkIndex{0}}
+                : emptyChunkId; // Product aged out between the locks
+    }
+
     ChunkId identifyEarliestMissingChunk() const
     {
-        LockGuard lock{mutex};
-        auto iter = incomplete.begin();
-        return (iter == incomplete.end())
+        ProdIndex prodIndex;
+        {
+            LockGuard lock{bookMutex};
+            auto iter = incomplete.begin();
+            if (iter == incomplete.end())
+                return emptyChunkId;
+            prodIndex = *iter;
+        }
+        auto&     shard = getShard(prodIndex);
+        LockGuard lock{shard.mutex};
+        auto      iter = shard.prods.find(prodIndex);
+        return (iter == shard.prods.end())
                 ? emptyChunkId
-                : iter->second->identifyEarliestMissingChunk();
+                : iter->second.identifyEarliestMissingChunk();
+    }
+
+    /**
+     * Executes a function on every product entry. Each shard is locked while
+     * its entries are processed.
+     * @param[in] func  Function to execute
+     */
+    void forEach(const std::function<void(ProdEntry&)>& func)
+    {
+        for (size_t i = 0; i < numShards; ++i) {
+            LockGuard lock{shards[i].mutex};
+            for (auto& pair : shards[i].prods)
+                func(pair.second);
+        }
     }
 
-    void erase(const ProdIndex& index)
+    /**
+     * Removes a product entry and returns it rather than destroying it, so
+     * the caller can free the product's memory -- which can be large --
+     * without holding the shard's lock. Ingest threads targeting the same
+     * shard consequently never wait behind a deallocation.
+     * @param[in] index  Index of the product
+     * @return           Removed entry. Will be empty if the product didn't
+     *                   exist.
+     * @exceptionsafety  Basic guarantee
+     * @threadsafety     Safe
+     */
+    ProdEntry remove(const ProdIndex& index)
     {
-        LockGuard lock{mutex};
-        prods.erase(index);
-        auto iter = incomplete.find(index);
-        if (iter != incomplete.end()) {
-            LOG_WARN("Deleting incomplete product " +
-                    iter->second->getInfo().to_string());
-            incomplete.erase(iter);
+        ProdEntry removed{};
+        auto&     shard = getShard(index);
+        LockGuard lock{shard.mutex};
+        auto      iter = shard.prods.find(index);
+        if (iter == shard.prods.end())
+            return removed;
+        {
+            LockGuard bookLock{bookMutex};
+            auto inc = incomplete.find(index);
+            if (inc != incomplete.end()) {
+                LOG_WARN("Deleting incomplete product " +
+                        iter->second.getInfo().to_string());
+                incomplete.erase(inc);
+            }
+            ordered.erase(index);
+            --numProds;
         }
+        removed = std::move(iter->second);
+        shard.prods.erase(iter);
+        meta.remove(index);
+        return removed;
     }
 };
 
@@ -357,35 +1250,39 @@ public:
     {
         if (!startWith)
             throw INVALID_ARGUMENT("Empty data-chunk information");
+        /*
+         * Locating `startWith` is an O(log n) seek on the store's ordered
+         * product-index (performed by `operator *()`) rather than a scan, so
+         * a storm of reconnecting peers starting backloggers doesn't stall
+         * ingest.
+         */
         prodIndex = startWith.getProdIndex();
         const auto prodInfo = prods.getProdInfo(prodIndex);
-        const auto earliest = prods.getEarliest();
-        if (!prodInfo) {
-            // `startWith` product not found
-            prodIndex = earliest;
-            chunkIndex = 0;
-        }
-        else {
-            // `startWith` product found
-            if (!prodIndex.isEarlierThan(earliest)) {
-                chunkIndex = prodInfo.getChunkIndex(startWith);
-            }
-            else {
-                prodIndex = earliest;
-                chunkIndex = 0;
-            }
-        }
+        chunkIndex = prodInfo
+                ? prodInfo.getChunkIndex(startWith)
+                : ChunkIndex{0};
     }
 
     /**
      * Identifies the chunk of data that the product-store contains and that is
-     * closest to but not earlier than the current chunk.
+     * closest to but not earlier than the current chunk. Each gap of expired
+     * or missing products is skipped with a single O(log n) seek, and no
+     * store lock is held across yields to the caller.
      * @return  Chunk identifier. Will be invalid if such a chunk doesn't exist.
      * @see `ChunkId::operator bool()`
      */
     const ChunkId operator *()
     {
-        for (; prodIndex <= prods.getLatest(); ++prodIndex) {
+        for (;;) {
+            auto stored = prodIndex;
+            if (!prods.seekNotEarlier(stored))
+                return invalidChunkId;
+            if (stored != prodIndex) {
+                // Jumped a gap; the chunk position applied to the old product
+                prodIndex = stored;
+                chunkIndex = 0;
+            }
+            // The product can expire between the seek and this lookup
             auto prodInfo = prods.getProdInfo(prodIndex);
             if (prodInfo) {
                 auto numChunks = prodInfo.getNumChunks();
@@ -395,9 +1292,9 @@ public:
                         return chunkId;
                 }
             }
+            ++prodIndex;
             chunkIndex = 0;
         }
-        return invalidChunkId;
     }
 
     /**
@@ -433,35 +1330,328 @@ class ProdStore::Impl final
 {
     typedef std::mutex                 Mutex;
     typedef std::lock_guard<Mutex>     LockGuard;
+    typedef std::unique_lock<Mutex>    UniqueLock;
 
     typedef std::chrono::milliseconds  Duration; /// Unit of residence-time
 
-    /// Pathname of persistence file
-    std::string                                pathname;
-    /// Pathname of temporary persistence file
-    std::string                                tempPathname;
-    /// Persistence file
-    std::ofstream                              file;
-    /// Map of products
-    ProdMap                                    prods;
-    /// Concurrent-access mutex
-    mutable Mutex                              mutex;
-    /// Product-deletion delay-queue
-    FixedDelayQueue<ProdIndex, Duration>       delayQ;
-    /// Thread for deleting products whose residence-time exceeds the minimum
-    std::thread                                deletionThread;
-    mutable std::exception_ptr                 exception;
-    ProdIndex                                  earliest;
-    ProdIndex                                  latest;
-    static const ChunkId                     emptyChunkId;
-
-    void setAndThrowException() const
+    /**
+     * Deferred freeing of evicted products. Removing a product from the map
+     * and freeing its memory -- which can be large -- are decoupled: the
+     * deletion thread extracts entries with bounded work per shard-lock
+     * acquisition and hands them to this reclaimer, whose thread destroys
+     * them. A burst of expirations consequently backs up here rather than in
+     * front of `ProdStore::add()`.
+     */
+    class Reclaimer final
     {
-        LockGuard lock{mutex};
-        exception = std::current_exception();
-        throw;
-    }
-
+        typedef std::unique_lock<Mutex> UniqueLock;
+
+        mutable Mutex           mutex;
+        std::condition_variable cond;
+        std::vector<ProdEntry>  entries;
+        std::thread             thread;
+
+        /**
+         * Destroys deferred product entries. Doesn't return. Intended to run
+         * on its own thread.
+         */
+        void run()
+        {
+            for (;;) {
+                std::vector<ProdEntry> condemned{};
+                {
+                    UniqueLock lock{mutex};
+                    while (entries.empty())
+                        cond.wait(lock); // Cancellation point
+                    condemned.swap(entries);
+                } // `condemned` destroyed -- and product memory freed -- here
+            }
+        }
+
+    public:
+        Reclaimer()
+            : mutex{}
+            , cond{}
+            , entries{}
+            , thread{[this]{run();}}
+        {}
+
+        /**
+         * Destroys. Any entries whose destruction is still deferred are
+         * destroyed with this instance.
+         */
+        ~Reclaimer() noexcept
+        {
+            try {
+                ::pthread_cancel(thread.native_handle());
+                thread.join();
+            }
+            catch (const std::exception& e) {
+                log_error(e);
+            }
+        }
+
+        /**
+         * Defers destruction of a product entry to the reclamation thread.
+         * @param[in] entry  Entry to be destroyed
+         */
+        void defer(ProdEntry&& entry)
+        {
+            LockGuard lock{mutex};
+            entries.push_back(std::move(entry));
+            cond.notify_one();
+        }
+    };
+
+    /**
+     * Front-guard of recently-evicted product-indexes. Late arrivals for an
+     * evicted product -- stragglers from slow peers or requeued multicast --
+     * die here with a single hash probe instead of costing a store lookup
+     * and entry-creation before being discarded. During recovery from a long
+     * outage, a large fraction of arriving chunks can be for products that
+     * were already completed and evicted.
+     *
+     * The guard is two exact hash-set generations that rotate when the
+     * current one fills, rather than a Bloom filter: a Bloom false positive
+     * would silently and *permanently* drop every chunk of a live product
+     * (the same index always hashes the same), which is a correctness
+     * hazard. The exact set has the same O(1) probe and bounded memory.
+     */
+    class EvictedGuard final
+    {
+        /// Maximum number of indexes per generation
+        static const size_t genCapacity = 4096;
+
+        mutable Mutex                       mutex;
+        std::unordered_set<ProdIndex::type> curr;
+        std::unordered_set<ProdIndex::type> prev;
+
+    public:
+        EvictedGuard()
+            : mutex{}
+            , curr{}
+            , prev{}
+        {
+            curr.reserve(genCapacity);
+        }
+
+        /**
+         * Adds the index of an evicted product. When the current generation
+         * is full, it becomes the previous generation -- whose contents are
+         * forgotten -- and a fresh one starts.
+         * @param[in] prodIndex  Index of the evicted product
+         */
+        void add(const ProdIndex prodIndex)
+        {
+            LockGuard lock{mutex};
+            if (curr.size() >= genCapacity) {
+                prev = std::move(curr);
+                curr = std::unordered_set<ProdIndex::type>{};
+                curr.reserve(genCapacity);
+            }
+            curr.insert(static_cast<ProdIndex::type>(prodIndex));
+        }
+
+        /**
+         * Indicates if a product was recently evicted.
+         * @param[in] prodIndex  Index of the product
+         * @retval `true`        The product was recently evicted
+         * @retval `false`       The product wasn't recently evicted
+         */
+        bool contains(const ProdIndex prodIndex) const
+        {
+            const auto index = static_cast<ProdIndex::type>(prodIndex);
+            LockGuard  lock{mutex};
+            return curr.count(index) || prev.count(index);
+        }
+    };
+
+    /**
+     * Secondary index from product-name to product-index. Maintained
+     * incrementally on addition and eviction so that by-name operations --
+     * dedup, operator queries, selective reprocessing -- cost a single hash
+     * probe under a dedicated, briefly-held mutex instead of a scan of the
+     * whole store under its locks. If several resident products share a
+     * name, the most recently added one wins.
+     */
+    class NameIndex final
+    {
+        mutable Mutex                                    mutex;
+        std::unordered_map<std::string, ProdIndex::type> indexes;
+
+    public:
+        NameIndex()
+            : mutex{}
+            , indexes{}
+        {}
+
+        /**
+         * Adds or replaces the entry for a name.
+         * @param[in] name       Name of the product
+         * @param[in] prodIndex  Index of the product
+         */
+        void put(
+                const std::string& name,
+                const ProdIndex    prodIndex)
+        {
+            LockGuard lock{mutex};
+            indexes[name] = static_cast<ProdIndex::type>(prodIndex);
+        }
+
+        /**
+         * Removes the entry for a name -- but only if it still refers to the
+         * given product: a newer product that took over the name keeps its
+         * mapping.
+         * @param[in] name       Name of the evicted product
+         * @param[in] prodIndex  Index of the evicted product
+         */
+        void erase(
+                const std::string& name,
+                const ProdIndex    prodIndex)
+        {
+            LockGuard  lock{mutex};
+            const auto iter = indexes.find(name);
+            if (iter != indexes.end() &&
+                    iter->second == static_cast<ProdIndex::type>(prodIndex))
+                indexes.erase(iter);
+        }
+
+        /**
+         * Returns the index of the product with a given name.
+         * @param[in]  name       Name of the product
+         * @param[out] prodIndex  Index of the product. Set iff found.
+         * @retval `true`         A product with the name is in the store
+         * @retval `false`        No product with the name is in the store
+         */
+        bool get(
+                const std::string& name,
+                ProdIndex&         prodIndex) const
+        {
+            LockGuard  lock{mutex};
+            const auto iter = indexes.find(name);
+            if (iter == indexes.end())
+                return false;
+            prodIndex = ProdIndex{iter->second};
+            return true;
+        }
+    };
+
+    /// Magic number of the persistence-file format ("HYPS")
+    static const uint32_t                      persistMagic = 0x48595053;
+    /// Version of the persistence-file format
+    static const uint32_t                      persistVersion = 1;
+    /// Interval, in microseconds, between flushes of the journal to disk
+    static const unsigned                      journalFlushMicros = 1000000;
+    /// Journal size, in bytes, that triggers a full checkpoint. Bounds both
+    /// the journal and the time replay takes at startup
+    static const size_t                        maxJournalBytes =
+            256*1024*1024;
+
+    /// Pathname of persistence file
+    std::string                                pathname;
+    /// Memory-mapped previous persistence-file. Product data references the
+    /// mapping, so it lives as long as this instance.
+    void*                                      mapAddr;
+    /// Size of the memory-mapping in bytes
+    size_t                                     mapSize;
+    /// Pathname of temporary persistence file
+    std::string                                tempPathname;
+    /// Persistence file
+    std::ofstream                              file;
+    /// Pathname of the append-only journal of completed products
+    std::string                                journalPathname;
+    /// Pathname the journal is rotated to while a checkpoint is written
+    std::string                                oldJournalPathname;
+    /// File descriptor of the journal or -1 for no journal
+    int                                        journalFd;
+    /// Serializes journal appends and rotation
+    mutable Mutex                              journalMutex;
+    /// Number of bytes in the journal
+    size_t                                     journalSize;
+    /// Whether appended journal records haven't been flushed to disk
+    bool                                       journalDirty;
+    /// Heap copies of journals made during replay. Replayed products
+    /// reference them, so they live as long as this instance.
+    std::vector<std::unique_ptr<char[]>>       journalBufs;
+    /// Thread for flushing the journal and writing checkpoints
+    std::thread                                journalThread;
+    /// Thread for loading historical products at startup
+    mutable std::thread                        loadThread;
+    /// Serializes joining of the load thread
+    mutable Mutex                              loadMutex;
+    /// Map of products
+    ProdMap                                    prods;
+    /// Concurrent-access mutex
+    mutable Mutex                              mutex;
+    /// Product-deletion delay-queue
+    FixedDelayQueue<ProdIndex, Duration>       delayQ;
+    /// Whether or not complete products are migrated to the cold tier
+    const bool                                 tierCold;
+    /// Cold-tier migration delay-queue
+    FixedDelayQueue<ProdIndex, Duration>       coldQ;
+    /// Early-eviction delay-queue for products with a time-to-live. The
+    /// delay varies per product, so this isn't a `FixedDelayQueue`.
+    DelayQueue<ProdIndex, Duration>            ttlQ;
+    /// Deferred freeing of evicted products
+    Reclaimer                                  reclaimer;
+    /// Front-guard of recently-evicted product-indexes
+    EvictedGuard                               evictedGuard;
+    /// Secondary index from product-name to product-index
+    NameIndex                                  nameIndex;
+    /// Thread for deleting products whose residence-time exceeds the minimum
+    std::thread                                deletionThread;
+    /// Thread for deleting products whose time-to-live has elapsed
+    std::thread                                ttlThread;
+    /// Seconds between sweeps that grow the hash tables ahead of need
+    static const unsigned                      growthPeriodSecs = 1;
+    /// Thread for growing the hash tables ahead of need
+    std::thread                                growthThread;
+    /// Thread for migrating products to the cold tier
+    std::thread                                migrationThread;
+    /// Shared memory-budget. May be empty, in which case no accounting is done
+    MemBudget                                  memBudget;
+    /// Concurrent-access variables for the memory-pressure level:
+    mutable Mutex                              pressureMutex;
+    std::condition_variable                    pressureCond;
+    MemBudget::Level                           pressureLevel;
+    /// Thread for relieving memory-pressure
+    std::thread                                pressureThread;
+    /// Default rate, in bytes per second, of background compaction copy-work
+    static constexpr double                    defaultCompactRate = 4*1024*1024;
+    /// Seconds between background compaction sweeps
+    static const unsigned                      compactPeriodSecs = 600;
+    /// Bytes relocated per compaction step before the copy-rate is re-imposed
+    static const size_t                        compactSliceBytes = 256*1024;
+    /// Rate, in bytes per second, of background compaction copy-work or 0 to
+    /// disable compaction. Adjustable at runtime via the tunable
+    /// `store.<n>.compact_rate`.
+    std::atomic<double>                        compactRate;
+    /// Thread for background compaction of long-lived allocations
+    std::thread                                compactThread;
+    mutable std::exception_ptr                 exception;
+    ProdIndex                                  earliest;
+    ProdIndex                                  latest;
+    /// Exports the store's occupancy. Deregistered on destruction, so it must
+    /// be declared after the state it samples.
+    Metrics::Gauge                             occupancyGauge;
+    /// Adjusts the minimum residence-time at runtime. Deregistered on
+    /// destruction, so it must be declared after the state it adjusts.
+    Tunables::Handle                           residenceTunable;
+    /// Adjusts the compaction copy-rate at runtime. Deregistered on
+    /// destruction, so it must be declared after the state it adjusts.
+    Tunables::Handle                           compactRateTunable;
+    /// Pre-sizes the hash tables at runtime. Deregistered on destruction,
+    /// so it must be declared after the state it adjusts.
+    Tunables::Handle                           expectedProdsTunable;
+    static const ChunkId                     emptyChunkId;
+
+    void setAndThrowException() const
+    {
+        LockGuard lock{mutex};
+        exception = std::current_exception();
+        throw;
+    }
+
     void throwIfException() const
     {
         LockGuard lock{mutex};
@@ -470,11 +1660,170 @@ class ProdStore::Impl final
     }
 
     /**
-     * Writes to the temporary persistence-file.
+     * Writes to the temporary persistence-file. Only complete products are
+     * persisted.
      */
     void writeTempFile()
     {
-        throw LOGIC_ERROR("Not implemented yet");
+        file.write(reinterpret_cast<const char*>(&persistMagic),
+                sizeof(persistMagic));
+        file.write(reinterpret_cast<const char*>(&persistVersion),
+                sizeof(persistVersion));
+        uint64_t numProds = 0;
+        const auto countPos = file.tellp();
+        file.write(reinterpret_cast<const char*>(&numProds),
+                sizeof(numProds));
+        prods.forEach([this,&numProds](ProdEntry& entry) {
+            if (!entry.isComplete())
+                return;
+            const auto&       info = entry.getInfo();
+            const uint32_t    index = info.getIndex();
+            const uint32_t    size = info.getSize();
+            const uint16_t    canonSize = info.getChunkSize();
+            const std::string name = info.getName().to_string();
+            const uint16_t    nameLen = static_cast<uint16_t>(name.size());
+            file.write(reinterpret_cast<const char*>(&index), sizeof(index));
+            file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+            file.write(reinterpret_cast<const char*>(&canonSize),
+                    sizeof(canonSize));
+            file.write(reinterpret_cast<const char*>(&nameLen),
+                    sizeof(nameLen));
+            file.write(name.data(), nameLen);
+            Product prod = entry.getProduct();
+            file.write(prod.getData(), size);
+            ++numProds;
+        });
+        file.seekp(countPos);
+        file.write(reinterpret_cast<const char*>(&numProds),
+                sizeof(numProds));
+        if (file.fail())
+            throw SYSTEM_ERROR(
+                    "Couldn't write temporary output product-store \"" +
+                    tempPathname + "\"");
+    }
+
+    /// Record of a persisted product parsed from the memory-mapping
+    struct PersistRecord
+    {
+        uint32_t    index;     ///< Product index
+        uint32_t    size;      ///< Size of the product's data in bytes
+        uint16_t    canonSize; ///< Canonical chunk-size
+        uint16_t    nameLen;   ///< Length of the product's name in bytes
+        const char* name;      ///< Product's name. References the mapping.
+        const char* data;      ///< Product's data. References the mapping.
+    };
+
+    /**
+     * Restores the state of this instance from the previous persistence-file,
+     * if it exists. The file is memory-mapped and restored products reference
+     * the mapping directly, so startup doesn't copy product data. The kernel
+     * is advised to read the mapping ahead of use, and the index-building is
+     * spread across worker threads -- which contend only when two products
+     * hash to the same shard of the product-map.
+     */
+    void restore()
+    {
+        int fd = ::open(pathname.data(), O_RDONLY);
+        if (fd < 0)
+            return; // No previous persistence-file
+        try {
+            struct stat statBuf;
+            if (::fstat(fd, &statBuf))
+                throw SYSTEM_ERROR("Couldn't stat() product-store \"" +
+                        pathname + "\"");
+            mapSize = statBuf.st_size;
+            if (mapSize < sizeof(persistMagic) + sizeof(persistVersion) +
+                    sizeof(uint64_t)) {
+                LOG_WARN("Ignoring truncated product-store \"" + pathname +
+                        "\"");
+                ::close(fd);
+                mapSize = 0;
+                return;
+            }
+            mapAddr = ::mmap(nullptr, mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapAddr == MAP_FAILED) {
+                mapAddr = nullptr;
+                throw SYSTEM_ERROR("Couldn't memory-map product-store \"" +
+                        pathname + "\"");
+            }
+            ::close(fd); // Mapping persists
+            fd = -1;     // So a later parse failure doesn't close it again
+            // Start the disk reads now; the parse below then rarely faults
+            if (::madvise(mapAddr, mapSize, MADV_WILLNEED))
+                LOG_DEBUG("Couldn't advise readahead of product-store \"" +
+                        pathname + "\"");
+            const char*       next = static_cast<const char*>(mapAddr);
+            const char* const end = next + mapSize;
+            uint32_t          magic, fmtVersion;
+            uint64_t          numProds;
+            ::memcpy(&magic, next, sizeof(magic));
+            next += sizeof(magic);
+            ::memcpy(&fmtVersion, next, sizeof(fmtVersion));
+            next += sizeof(fmtVersion);
+            if (magic != persistMagic || fmtVersion != persistVersion)
+                throw RUNTIME_ERROR("Invalid product-store \"" + pathname +
+                        "\"");
+            ::memcpy(&numProds, next, sizeof(numProds));
+            next += sizeof(numProds);
+            // The records are variable-length, so the walk itself is serial --
+            // but it only reads headers; the insertions are parallelized below
+            std::vector<PersistRecord> records;
+            records.reserve(numProds);
+            for (uint64_t i = 0; i < numProds; ++i) {
+                PersistRecord rec;
+                if (next + sizeof(rec.index) + sizeof(rec.size) +
+                        sizeof(rec.canonSize) + sizeof(rec.nameLen) > end)
+                    throw RUNTIME_ERROR("Corrupt product-store \"" +
+                            pathname + "\"");
+                ::memcpy(&rec.index, next, sizeof(rec.index));
+                next += sizeof(rec.index);
+                ::memcpy(&rec.size, next, sizeof(rec.size));
+                next += sizeof(rec.size);
+                ::memcpy(&rec.canonSize, next, sizeof(rec.canonSize));
+                next += sizeof(rec.canonSize);
+                ::memcpy(&rec.nameLen, next, sizeof(rec.nameLen));
+                next += sizeof(rec.nameLen);
+                if (next + rec.nameLen + rec.size > end)
+                    throw RUNTIME_ERROR("Corrupt product-store \"" +
+                            pathname + "\"");
+                rec.name = next;
+                next += rec.nameLen;
+                rec.data = next;
+                next += rec.size;
+                records.push_back(rec);
+            }
+            auto numWorkers = std::thread::hardware_concurrency();
+            if (numWorkers == 0)
+                numWorkers = 1;
+            if (numWorkers > records.size())
+                numWorkers = records.size();
+            std::vector<std::thread> workers;
+            for (unsigned worker = 0; worker < numWorkers; ++worker) {
+                workers.emplace_back([this,&records,worker,numWorkers] {
+                    try {
+                        for (auto i = worker; i < records.size();
+                                i += numWorkers) {
+                            const auto&       rec = records[i];
+                            const std::string name{rec.name, rec.nameLen};
+                            Product           prod = MemoryProduct{rec.index,
+                                    name, rec.size, rec.data, rec.canonSize};
+                            add(prod);
+                        }
+                    }
+                    catch (const std::exception& e) {
+                        // `add()` saved the exception; lookups will rethrow it
+                        log_error(e);
+                    }
+                });
+            }
+            for (auto& worker : workers)
+                worker.join();
+        }
+        catch (const std::exception& ex) {
+            if (fd >= 0)
+                ::close(fd);
+            throw;
+        }
     }
 
     /**
@@ -519,6 +1868,15 @@ class ProdStore::Impl final
      */
     void persist()
     {
+        if (!file.is_open()) {
+            // Re-opened for every checkpoint after the first
+            file.open(tempPathname, std::ofstream::binary |
+                    std::ofstream::trunc);
+            if (file.fail())
+                throw SYSTEM_ERROR(
+                        "Couldn't open temporary output product-store \"" +
+                        tempPathname + "\"");
+        }
         try {
             writeTempFile();
             closeTempFile();
@@ -536,21 +1894,507 @@ class ProdStore::Impl final
         renameTempFile();
     }
 
+    /**
+     * Appends a completed data-product to the journal. The record is
+     * length-prefixed and checksummed so that a record torn by a crash is
+     * detected -- and replay stopped -- at the next startup. A failure is
+     * logged rather than thrown because the journal is an optimization:
+     * without it recovery merely falls back to refetching from peers. Does
+     * nothing if there's no journal.
+     * Keep consistent with `replayJournal()`.
+     * @param[in] prod   Completed data-product
+     * @threadsafety     Safe
+     */
+    void appendToJournal(Product& prod)
+    {
+        if (journalFd < 0)
+            return;
+        const auto&       info = prod.getInfo();
+        const uint32_t    index = info.getIndex();
+        const uint32_t    size = info.getSize();
+        const uint16_t    canonSize = info.getChunkSize();
+        const std::string name = info.getName().to_string();
+        const uint16_t    nameLen = static_cast<uint16_t>(name.size());
+        const uint32_t    payloadLen = sizeof(index) + sizeof(size) +
+                sizeof(canonSize) + sizeof(nameLen) + nameLen + size;
+        char              header[sizeof(payloadLen) + sizeof(index) +
+                sizeof(size) + sizeof(canonSize) + sizeof(nameLen)];
+        char*             next = header;
+        ::memcpy(next, &payloadLen, sizeof(payloadLen));
+        next += sizeof(payloadLen);
+        ::memcpy(next, &index, sizeof(index));
+        next += sizeof(index);
+        ::memcpy(next, &size, sizeof(size));
+        next += sizeof(size);
+        ::memcpy(next, &canonSize, sizeof(canonSize));
+        next += sizeof(canonSize);
+        ::memcpy(next, &nameLen, sizeof(nameLen));
+        uint32_t crc = crc32c(0, header + sizeof(payloadLen),
+                sizeof(header) - sizeof(payloadLen));
+        crc = crc32c(crc, name.data(), nameLen);
+        crc = crc32c(crc, prod.getData(), size);
+        struct iovec iov[4];
+        iov[0].iov_base = header;
+        iov[0].iov_len = sizeof(header);
+        iov[1].iov_base = const_cast<char*>(name.data());
+        iov[1].iov_len = nameLen;
+        iov[2].iov_base = const_cast<char*>(prod.getData());
+        iov[2].iov_len = size;
+        iov[3].iov_base = &crc;
+        iov[3].iov_len = sizeof(crc);
+        LockGuard lock{journalMutex};
+        if (journalFd < 0)
+            return;
+        if (::writev(journalFd, iov, 4) < 0) {
+            LOG_WARN("Couldn't append product " + info.to_string() +
+                    " to product-store journal \"" + journalPathname + "\"");
+        }
+        else {
+            journalSize += sizeof(payloadLen) + payloadLen + sizeof(crc);
+            journalDirty = true;
+        }
+    }
+
+    /**
+     * Replays a journal into the store. Replay stops at the first torn or
+     * corrupt record, which a crash can leave at the end of the file.
+     * Products already restored from the persistence-file are ignored.
+     * Replayed products reference a heap copy of the journal that lives as
+     * long as this instance, so replay copies product data only once.
+     * Keep consistent with `appendToJournal()`.
+     * @param[in] path  Pathname of journal. Needn't exist.
+     * @return          Number of products replayed
+     */
+    size_t replayJournal(const std::string& path)
+    {
+        const int fd = ::open(path.data(), O_RDONLY);
+        if (fd < 0)
+            return 0; // No journal
+        struct stat statBuf;
+        if (::fstat(fd, &statBuf) || statBuf.st_size == 0) {
+            ::close(fd);
+            return 0;
+        }
+        const size_t            fileSize = statBuf.st_size;
+        std::unique_ptr<char[]> buf{new char[fileSize]};
+        size_t                  nread = 0;
+        while (nread < fileSize) {
+            const auto n = ::read(fd, buf.get() + nread, fileSize - nread);
+            if (n <= 0)
+                break;
+            nread += n;
+        }
+        ::close(fd);
+        size_t            numProds = 0;
+        const char*       next = buf.get();
+        const char* const end = buf.get() + nread;
+        for (;;) {
+            uint32_t payloadLen, crc;
+            if (next + sizeof(payloadLen) > end)
+                break;
+            ::memcpy(&payloadLen, next, sizeof(payloadLen));
+            const char* payload = next + sizeof(payloadLen);
+            if (payload + payloadLen + sizeof(crc) > end)
+                break; // Torn record
+            ::memcpy(&crc, payload + payloadLen, sizeof(crc));
+            if (crc32c(0, payload, payloadLen) != crc)
+                break; // Torn or corrupt record
+            uint32_t index, size;
+            uint16_t canonSize, nameLen;
+            ::memcpy(&index, payload, sizeof(index));
+            payload += sizeof(index);
+            ::memcpy(&size, payload, sizeof(size));
+            payload += sizeof(size);
+            ::memcpy(&canonSize, payload, sizeof(canonSize));
+            payload += sizeof(canonSize);
+            ::memcpy(&nameLen, payload, sizeof(nameLen));
+            payload += sizeof(nameLen);
+            if (payloadLen != sizeof(index) + sizeof(size) +
+                    sizeof(canonSize) + sizeof(nameLen) + nameLen + size)
+                break; // Corrupt record
+            const std::string name{payload, nameLen};
+            payload += nameLen;
+            Product prod = MemoryProduct{index, name, size, payload,
+                    canonSize};
+            add(prod);
+            ++numProds;
+            next = payload + size + sizeof(crc);
+        }
+        if (numProds)
+            journalBufs.push_back(std::move(buf)); // Products reference it
+        return numProds;
+    }
+
+    /**
+     * Loads historical products: restores the previous persistence-file,
+     * replays the journals, and then opens the journal for appending. Runs on
+     * its own thread so that the store accepts traffic immediately after
+     * construction -- lookups conservatively answer "don't have it" until the
+     * history fills in behind. A failure is logged rather than propagated
+     * because persistence is an optimization: missing history is merely
+     * refetched from peers.
+     */
+    void loadHistory()
+    {
+        try {
+            const auto start = std::chrono::steady_clock::now();
+            restore();
+            // Recover products that completed after the persistence-file was
+            // last written. The rotated journal, if it exists, is older.
+            auto numReplayed = replayJournal(oldJournalPathname);
+            numReplayed += replayJournal(journalPathname);
+            if (numReplayed)
+                LOG_NOTE("Replayed " + std::to_string(numReplayed) +
+                        " data-products from journal \"" + journalPathname +
+                        "\"");
+            const int fd = ::open(journalPathname.data(),
+                    O_WRONLY|O_CREAT|O_APPEND, 0666);
+            if (fd < 0) {
+                LOG_WARN("Couldn't open product-store journal \"" +
+                        journalPathname + "\"");
+            }
+            else {
+                const auto offset = ::lseek(fd, 0, SEEK_END);
+                {
+                    LockGuard lock{journalMutex};
+                    journalFd = fd;
+                    journalSize = (offset > 0) ? offset : 0;
+                }
+                journalThread = std::thread([this]{flushJournal();});
+            }
+            const auto millis = std::chrono::duration_cast<
+                    std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+            LOG_NOTE("Loaded " + std::to_string(prods.size()) +
+                    " historical data-products from \"" + pathname + "\" in " +
+                    std::to_string(millis) + " ms");
+        }
+        catch (const std::exception& e) {
+            log_error(e);
+            LOG_WARN("Couldn't load historical data-products from \"" +
+                    pathname + "\"");
+        }
+    }
+
+    /**
+     * Writes a full checkpoint: rotates the journal aside, saves the entire
+     * store in the persistence-file, and then deletes the rotated journal.
+     * Products that complete while the checkpoint is being written land in
+     * the fresh journal -- and the rotated journal is replayed at the next
+     * startup if it still exists -- so no completed product is lost however
+     * the sequence is interrupted.
+     */
+    void checkpoint()
+    {
+        {
+            LockGuard lock{journalMutex};
+            if (journalFd >= 0) {
+                ::close(journalFd);
+                if (::rename(journalPathname.data(),
+                        oldJournalPathname.data()))
+                    LOG_WARN("Couldn't rotate product-store journal \"" +
+                            journalPathname + "\"");
+                journalFd = ::open(journalPathname.data(),
+                        O_WRONLY|O_CREAT|O_APPEND|O_TRUNC, 0666);
+                if (journalFd < 0)
+                    LOG_WARN("Couldn't re-open product-store journal \"" +
+                            journalPathname + "\"");
+                journalSize = 0;
+            }
+        }
+        persist();
+        ::remove(oldJournalPathname.data()); // Subsumed by the checkpoint
+    }
+
+    /**
+     * Flushes appended journal records to disk on a short interval and
+     * writes a full checkpoint whenever the journal exceeds its maximum
+     * size. Doesn't return. Intended to run on its own thread.
+     */
+    void flushJournal()
+    {
+    	try {
+            for (;;) {
+                ::usleep(journalFlushMicros);
+                bool tooBig;
+                {
+                    LockGuard lock{journalMutex};
+                    if (journalDirty) {
+                        journalDirty = false;
+                        if (journalFd >= 0 && ::fdatasync(journalFd))
+                            LOG_WARN("Couldn't flush product-store journal "
+                                    "\"" + journalPathname + "\"");
+                    }
+                    tooBig = journalSize >= maxJournalBytes;
+                }
+                if (tooBig)
+                    checkpoint();
+            }
+    	}
+    	catch (const std::exception& e) {
+    	    setAndThrowException();
+    	}
+    }
+
     /**
      * Deletes products whose residence-time is greater than the minimum.
      * Doesn't return. Intended to run on its own thread.
      */
     void deleteOldProds()
+    {
+    	try {
+            for (;;) {
+                // The entry's memory is freed on the reclamation thread so
+                // ingest never waits behind a mass expiry
+                auto entry = prods.remove(delayQ.pop());
+                if (entry) {
+                    HYCAST_PROBE1(eviction, static_cast<ProdIndex::type>(
+                            entry.getInfo().getIndex()));
+                    FlightRecorder::record(FlightRecorder::Event::EVICTION,
+                            static_cast<ProdIndex::type>(
+                                    entry.getInfo().getIndex()));
+                    static auto& evictionCount = Metrics::getCounter(
+                            "hycast_store_evictions_total{reason="
+                            "\"expired\"}",
+                            "Data-products evicted from the product-store, "
+                            "by reason");
+                    evictionCount.add();
+                    evictedGuard.add(entry.getInfo().getIndex());
+                    nameIndex.erase(entry.getInfo().getName().to_string(),
+                            entry.getInfo().getIndex());
+                    memBudget.release(entry.getInfo().getSize());
+                    reclaimer.defer(std::move(entry));
+                }
+            }
+    	}
+    	catch (const std::exception& e) {
+    	    setAndThrowException();
+    	}
+    }
+
+    /**
+     * Deletes products whose time-to-live has elapsed -- typically before
+     * their minimum residence-time. Most products have no time-to-live and
+     * never pass through here. Doesn't return. Intended to run on its own
+     * thread.
+     */
+    void deleteTtlProds()
+    {
+    	try {
+            for (;;) {
+                // Empty if the product was already evicted
+                auto entry = prods.remove(ttlQ.pop());
+                if (entry) {
+                    HYCAST_PROBE1(eviction, static_cast<ProdIndex::type>(
+                            entry.getInfo().getIndex()));
+                    FlightRecorder::record(FlightRecorder::Event::EVICTION,
+                            static_cast<ProdIndex::type>(
+                                    entry.getInfo().getIndex()));
+                    static auto& evictionCount = Metrics::getCounter(
+                            "hycast_store_evictions_total{reason=\"ttl\"}",
+                            "Data-products evicted from the product-store, "
+                            "by reason");
+                    evictionCount.add();
+                    evictedGuard.add(entry.getInfo().getIndex());
+                    nameIndex.erase(entry.getInfo().getName().to_string(),
+                            entry.getInfo().getIndex());
+                    memBudget.release(entry.getInfo().getSize());
+                    reclaimer.defer(std::move(entry));
+                }
+            }
+    	}
+    	catch (const std::exception& e) {
+    	    setAndThrowException();
+    	}
+    }
+
+    /**
+     * Schedules the early eviction of a product whose time-to-live is set.
+     * The delay is the remainder of the time-to-live relative to the origin
+     * timestamp -- the full time-to-live if the timestamp isn't set. Does
+     * nothing if the product-information is invalid or has no time-to-live.
+     * @param[in] prodInfo  Information on the product
+     */
+    void scheduleTtl(const ProdInfo& prodInfo)
+    {
+        if (!prodInfo || prodInfo.getTtl() == 0)
+            return;
+        const auto ttl = prodInfo.getTtl();
+        auto       millis = static_cast<Duration::rep>(ttl)*1000;
+        const auto origin = prodInfo.getOriginTime();
+        if (origin) {
+            const auto expiry = origin +
+                    static_cast<ProdInfo::OriginTime>(ttl)*1000000;
+            const auto now = ProdInfo::now();
+            millis = (expiry > now)
+                    ? static_cast<Duration::rep>((expiry - now)/1000)
+                    : 0;
+        }
+        ttlQ.push(prodInfo.getIndex(), Duration{millis});
+    }
+
+    /**
+     * Migrates products whose age is greater than the cold-tier threshold to
+     * the cold tier. Doesn't return. Intended to run on its own thread.
+     */
+    void migrateColdProds()
     {
     	try {
             for (;;)
-                prods.erase(delayQ.pop());
+                prods.freeze(coldQ.pop());
+    	}
+    	catch (const std::exception& e) {
+    	    setAndThrowException();
+    	}
+    }
+
+    /**
+     * Grows the product-map's hash tables ahead of need, so a table's
+     * periodic rehash-all happens on this thread instead of stalling an
+     * ingest thread's insert at a store-size milestone. Doesn't return.
+     * Intended to run on its own thread.
+     */
+    void growTables()
+    {
+    	try {
+            for (;;) {
+                std::this_thread::sleep_for( // Cancellation point
+                        std::chrono::seconds{growthPeriodSecs});
+                prods.growIfNeeded();
+            }
     	}
     	catch (const std::exception& e) {
     	    setAndThrowException();
     	}
     }
 
+    /**
+     * Relieves memory-pressure. Waits until the memory-budget reports
+     * pressure; then, oldest-first, evicts products before their minimum
+     * residence-time elapses and -- at the compression level or above --
+     * compresses complete products without waiting for the cold-tier age.
+     * Eviction releases the products' claims on the budget, so the scan is
+     * self-limiting: it stops as soon as the pressure-level drops below the
+     * eviction level. Doesn't return. Intended to run on its own thread.
+     */
+    void relievePressure()
+    {
+        try {
+            for (;;) {
+                {
+                    UniqueLock lock{pressureMutex};
+                    while (pressureLevel < MemBudget::Level::SHRINK_RESIDENCE)
+                        pressureCond.wait(lock); // Cancellation point
+                }
+                /*
+                 * The resident snapshot comes from the metadata sidecar's
+                 * contiguous arrays, so the scan's cost scales with the
+                 * products evicted rather than with the width of the store's
+                 * index range.
+                 */
+                std::vector<ProdIndex::type> resident{};
+                prods.getResident(resident);
+                for (const auto indexVal : resident) {
+                    const ProdIndex index{indexVal};
+                    const auto level = memBudget.getLevel();
+                    if (level < MemBudget::Level::SHRINK_RESIDENCE)
+                        break;
+                    auto entry = prods.remove(index);
+                    if (entry) {
+                        HYCAST_PROBE1(eviction, static_cast<ProdIndex::type>(
+                                entry.getInfo().getIndex()));
+                        FlightRecorder::record(
+                                FlightRecorder::Event::EVICTION,
+                                static_cast<ProdIndex::type>(
+                                        entry.getInfo().getIndex()));
+                        static auto& evictionCount = Metrics::getCounter(
+                                "hycast_store_evictions_total{reason="
+                                "\"pressure\"}",
+                                "Data-products evicted from the product-"
+                                "store, by reason");
+                        evictionCount.add();
+                        evictedGuard.add(entry.getInfo().getIndex());
+                        nameIndex.erase(entry.getInfo().getName().to_string(),
+                                entry.getInfo().getIndex());
+                        memBudget.release(entry.getInfo().getSize());
+                        reclaimer.defer(std::move(entry));
+                    }
+                    else if (level >= MemBudget::Level::COMPRESS_COLD) {
+                        prods.freeze(index);
+                    }
+                }
+                /*
+                 * Compression doesn't release budget-claims (claims track the
+                 * uncompressed payload), so avoid spinning when eviction
+                 * can't lower the level any further.
+                 */
+                UniqueLock lock{pressureMutex};
+                if (pressureLevel >= MemBudget::Level::SHRINK_RESIDENCE)
+                    pressureCond.wait_for(lock, std::chrono::seconds{1});
+            }
+        }
+        catch (const std::exception& e) {
+            setAndThrowException();
+        }
+    }
+
+    /**
+     * Compacts the store's long-lived allocations. Each sweep relocates the
+     * cold entries' compressed data into fresh, exactly-sized allocations --
+     * products of varied sizes that live for weeks otherwise pin pages
+     * throughout the heap, so resident memory grows well beyond the live
+     * bytes -- and then returns the vacated pages to the operating system.
+     * The copy-work is bounded to `compactRate` bytes per second and yields
+     * while the memory-budget reports pressure, when the pressure-relief
+     * scan is already copying and compressing. Doesn't return. Intended to
+     * run on its own thread.
+     */
+    void compact()
+    {
+        try {
+            for (;;) {
+                std::this_thread::sleep_for( // Cancellation point
+                        std::chrono::seconds{compactPeriodSecs});
+                const double rate = compactRate;
+                if (rate <= 0)
+                    continue;
+                std::vector<ProdIndex::type> resident{};
+                prods.getResident(resident);
+                size_t slice = 0;
+                size_t total = 0;
+                for (const auto indexVal : resident) {
+                    {
+                        // Compaction yields to the pressure-relief scan
+                        UniqueLock lock{pressureMutex};
+                        while (pressureLevel != MemBudget::Level::NONE)
+                            pressureCond.wait(lock); // Cancellation point
+                    }
+                    const auto copied = prods.relocateCold(ProdIndex{indexVal});
+                    slice += copied;
+                    total += copied;
+                    if (slice >= compactSliceBytes) {
+                        // Bound the copy-rate
+                        std::this_thread::sleep_for(
+                                std::chrono::duration<double>{slice/rate});
+                        slice = 0;
+                    }
+                }
+                if (total) {
+                    static auto& compactedBytes = Metrics::getCounter(
+                            "hycast_store_compacted_bytes_total",
+                            "Bytes of cold product data relocated by the "
+                            "background compactor");
+                    compactedBytes.add(total);
+                }
+                // Return the vacated pages to the operating system
+                ::malloc_trim(0);
+            }
+        }
+        catch (const std::exception& e) {
+            setAndThrowException();
+        }
+    }
+
 public:
     /**
      * Constructs.
@@ -558,20 +2402,126 @@ public:
      *                       string to indicate no persistence.
      * @param[in] residence  Minimum residence-time for a product in the store
      *                       in seconds
+     * @param[in] coldAge    Age, in seconds, at which a complete product is
+     *                       migrated to the compressed cold tier or 0 to
+     *                       disable cold-tier migration
+     * @param[in] hugePages  Whether product data buffers should be backed by
+     *                       huge pages
      */
     Impl(   const std::string& pathname,
-            const double       residence)
+            const double       residence,
+            const double       coldAge,
+            const bool         hugePages)
         : pathname{pathname}
+        , mapAddr{nullptr}
+        , mapSize{0}
         , tempPathname{pathname + ".tmp"}
         , file{}
-        , prods{}
+        , journalPathname{pathname + ".journal"}
+        , oldJournalPathname{pathname + ".journal.old"}
+        , journalFd{-1}
+        , journalMutex{}
+        , journalSize{0}
+        , journalDirty{false}
+        , journalBufs{}
+        , journalThread{}
+        , loadThread{}
+        , loadMutex{}
+        , prods{hugePages}
         , mutex{}
         , delayQ{Duration(static_cast<Duration::rep>(residence*1000))}
-        , deletionThread{std::thread([this]{deleteOldProds();})}
+        , tierCold{coldAge > 0}
+        , coldQ{Duration(static_cast<Duration::rep>(coldAge*1000))}
+        , ttlQ{}
+        , reclaimer{}
+        , evictedGuard{}
+        , nameIndex{}
+        , deletionThread{}
+        , ttlThread{}
+        , growthThread{}
+        , migrationThread{}
+        , memBudget{}
+        , pressureMutex{}
+        , pressureCond{}
+        , pressureLevel{MemBudget::Level::NONE}
+        , pressureThread{}
+        , compactRate{defaultCompactRate}
+        , compactThread{}
         , exception{}
         , earliest{}
         , latest{}
+        , occupancyGauge{}
+        , residenceTunable{}
+        , compactRateTunable{}
+        , expectedProdsTunable{}
     {
+        static std::atomic<unsigned> numStores{0};
+        const auto storeNum = numStores++;
+        occupancyGauge = Metrics::registerGauge(
+                "hycast_store_products{store=\"" +
+                        std::to_string(storeNum) + "\"}",
+                "Number of data-products resident in the product-store",
+                [this]{return static_cast<double>(prods.size());});
+        residenceTunable = Tunables::registerTunable(
+                "store." + std::to_string(storeNum) + ".residence",
+                "Minimum residence-time of subsequently-added data-products "
+                "in seconds",
+                [this](const std::string& value) {
+                    double residence;
+                    try {
+                        residence = std::stod(value);
+                    }
+                    catch (const std::exception& e) {
+                        throw INVALID_ARGUMENT("Not a number: \"" + value +
+                                "\"");
+                    }
+                    setResidence(residence);
+                    return std::to_string(residence);
+                });
+        compactRateTunable = Tunables::registerTunable(
+                "store." + std::to_string(storeNum) + ".compact_rate",
+                "Rate, in bytes per second, of background compaction "
+                "copy-work. 0 disables compaction.",
+                [this](const std::string& value) {
+                    double rate;
+                    try {
+                        rate = std::stod(value);
+                    }
+                    catch (const std::exception& e) {
+                        throw INVALID_ARGUMENT("Not a number: \"" + value +
+                                "\"");
+                    }
+                    if (rate < 0)
+                        throw INVALID_ARGUMENT("Compaction-rate is negative: "
+                                + std::to_string(rate));
+                    compactRate = rate;
+                    return std::to_string(rate);
+                });
+        expectedProdsTunable = Tunables::registerTunable(
+                "store." + std::to_string(storeNum) + ".expected_products",
+                "Expected number of resident data-products -- e.g., the "
+                "product rate times the residence-time. The store's hash "
+                "tables are pre-sized for it, so reaching the expected "
+                "population never rehashes at all.",
+                [this](const std::string& value) {
+                    unsigned long num;
+                    try {
+                        num = std::stoul(value);
+                    }
+                    catch (const std::exception& e) {
+                        throw INVALID_ARGUMENT("Invalid product-count: \"" +
+                                value + "\"");
+                    }
+                    prods.reserve(num);
+                    return std::to_string(num);
+                });
+        // Validate before starting threads lest their destruction terminate
+        if (residence < 0)
+            throw INVALID_ARGUMENT("Residence-time is negative: " +
+                    std::to_string(residence));
+        if (coldAge < 0)
+            throw INVALID_ARGUMENT("Cold-tier age is negative: " +
+                    std::to_string(coldAge));
         if (pathname.length()) {
             file.open(tempPathname, std::ofstream::binary |
                     std::ofstream::trunc);
@@ -580,9 +2530,21 @@ public:
                         "Couldn't open temporary output product-store \"" +
                         tempPathname + "\"");
         }
-        if (residence < 0)
-            throw INVALID_ARGUMENT("Residence-time is negative: " +
-                    std::to_string(residence));
+        deletionThread = std::thread([this]{deleteOldProds();});
+        ttlThread = std::thread([this]{deleteTtlProds();});
+        growthThread = std::thread([this]{growTables();});
+        if (tierCold) {
+            migrationThread = std::thread([this]{migrateColdProds();});
+            // Only the cold tier has long-lived allocations to compact
+            compactThread = std::thread([this]{compact();});
+        }
+        /*
+         * Historical products are loaded in the background so that the first
+         * multicast chunk can be stored milliseconds after construction
+         * rather than after a multi-gigabyte load.
+         */
+        if (pathname.length())
+            loadThread = std::thread([this]{loadHistory();});
     }
 
     /**
@@ -591,6 +2553,17 @@ public:
      */
     ~Impl() noexcept
     {
+        try {
+            /*
+             * The load must finish -- not be cancelled -- because `persist()`
+             * below overwrites the persistence-file: cancelling would discard
+             * the historical products that weren't yet loaded.
+             */
+            awaitHistory();
+        }
+        catch (const std::exception& e) {
+            log_error(e);
+        }
         try {
             ::pthread_cancel(deletionThread.native_handle());
             deletionThread.join();
@@ -599,12 +2572,128 @@ public:
             log_error(e);
         }
         try {
-            if (file.is_open())
+            ::pthread_cancel(ttlThread.native_handle());
+            ttlThread.join();
+        }
+        catch (const std::exception& e) {
+            log_error(e);
+        }
+        try {
+            ::pthread_cancel(growthThread.native_handle());
+            growthThread.join();
+        }
+        catch (const std::exception& e) {
+            log_error(e);
+        }
+        try {
+            if (migrationThread.joinable()) {
+                ::pthread_cancel(migrationThread.native_handle());
+                migrationThread.join();
+            }
+        }
+        catch (const std::exception& e) {
+            log_error(e);
+        }
+        try {
+            if (compactThread.joinable()) {
+                ::pthread_cancel(compactThread.native_handle());
+                compactThread.join();
+            }
+        }
+        catch (const std::exception& e) {
+            log_error(e);
+        }
+        try {
+            if (pressureThread.joinable()) {
+                ::pthread_cancel(pressureThread.native_handle());
+                pressureThread.join();
+            }
+        }
+        catch (const std::exception& e) {
+            log_error(e);
+        }
+        try {
+            if (journalThread.joinable()) {
+                ::pthread_cancel(journalThread.native_handle());
+                journalThread.join();
+            }
+        }
+        catch (const std::exception& e) {
+            log_error(e);
+        }
+        try {
+            if (pathname.length()) {
                 persist();
+                // The persistence-file now subsumes the journal
+                if (journalFd >= 0 && ::ftruncate(journalFd, 0))
+                    LOG_WARN("Couldn't truncate product-store journal \"" +
+                            journalPathname + "\"");
+                ::remove(oldJournalPathname.data());
+            }
         }
         catch (const std::exception& e) {
             log_error(e);
         }
+        if (journalFd >= 0)
+            ::close(journalFd);
+        if (mapAddr)
+            ::munmap(mapAddr, mapSize);
+    }
+
+    /**
+     * Sets the shared memory-budget. Subsequently-added products claim their
+     * size against the budget and release it when evicted. Under pressure,
+     * the oldest products are evicted before their minimum residence-time
+     * elapses and complete products are compressed without waiting for the
+     * cold-tier age.
+     * @param[in] memBudget  Shared memory-budget
+     * @throw LogicError     A memory-budget was already set
+     * @exceptionsafety      Strong guarantee
+     * @threadsafety         Compatible but not safe
+     */
+    void setMemBudget(const MemBudget& memBudget)
+    {
+        if (this->memBudget)
+            throw LOGIC_ERROR("Memory-budget is already set");
+        this->memBudget = memBudget;
+        memBudget.observe([this](const MemBudget::Level level) {
+            LockGuard lock{pressureMutex};
+            pressureLevel = level;
+            pressureCond.notify_one();
+        });
+        pressureThread = std::thread([this]{relievePressure();});
+    }
+
+    /**
+     * Sets the minimum residence-time of subsequently-added data-products.
+     * Products already in the store keep the residence-time that was in
+     * effect when they were added.
+     * @param[in] residence    Desired minimum residence-time in seconds
+     * @throw InvalidArgument  Residence-time is negative
+     * @exceptionsafety        Strong guarantee
+     * @threadsafety           Safe
+     */
+    void setResidence(const double residence)
+    {
+        if (residence < 0)
+            throw INVALID_ARGUMENT("Residence-time is negative: " +
+                    std::to_string(residence));
+        delayQ.setDelay(Duration(static_cast<Duration::rep>(residence*1000)));
+    }
+
+    /**
+     * Waits until the historical products have been loaded. Returns
+     * immediately if the load has completed or no persistence-file was
+     * specified.
+     * @exceptionsafety  Basic guarantee
+     * @threadsafety     Safe
+     */
+    void awaitHistory() const
+    {
+        // `std::thread::join()` isn't safe to call concurrently
+        LockGuard lock{loadMutex};
+        if (loadThread.joinable())
+            loadThread.join();
     }
 
     /**
@@ -615,17 +2704,82 @@ public:
      * @exceptionsafety  Basic guarantee
      * @threadsafety     Safe
      */
-    void add(Product& prod)
+    bool add(Product& prod)
     {
         throwIfException();
         try {
             const bool isNew = prods.add(prod);
-            if (isNew)
+            if (isNew) {
+                nameIndex.put(prod.getInfo().getName().to_string(),
+                        prod.getIndex());
+                memBudget.claim(prod.getInfo().getSize());
                 delayQ.push(prod.getIndex());
+                scheduleTtl(prod.getInfo());
+                if (tierCold)
+                    coldQ.push(prod.getIndex());
+                appendToJournal(prod);
+            }
+            return isNew;
         }
         catch (const std::exception& ex) {
             setAndThrowException();
         }
+        return false; // To accommodate Eclipse
+    }
+
+    /**
+     * Discards a late arrival of product-information for a recently-evicted
+     * product. Product-information carries no latent data, so there's
+     * nothing to do.
+     */
+    static void discardLate(const ProdInfo& prodInfo)
+    {}
+
+    /**
+     * Returns the product-name carried by product-information.
+     * @param[in] prodInfo  Product information
+     * @return              Name of the product
+     */
+    static std::string nameOf(const ProdInfo& prodInfo)
+    {
+        return prodInfo.getName().to_string();
+    }
+
+    /**
+     * Returns the empty string: a chunk carries no product-name.
+     */
+    static std::string nameOf(const LatentChunk& chunk)
+    {
+        return std::string{};
+    }
+
+    /**
+     * Returns the product-information itself.
+     * @param[in] prodInfo  Product information
+     * @return              The product-information
+     */
+    static ProdInfo infoOf(const ProdInfo& prodInfo)
+    {
+        return prodInfo;
+    }
+
+    /**
+     * Returns invalid product-information: a chunk carries none.
+     */
+    static ProdInfo infoOf(const LatentChunk& chunk)
+    {
+        return ProdInfo{};
+    }
+
+    /**
+     * Discards a late-arriving chunk of a recently-evicted product. The
+     * chunk's latent data must be drained from its source.
+     * @param[in] chunk  Late-arriving chunk
+     */
+    static void discardLate(LatentChunk& chunk)
+    {
+        if (chunk.hasData())
+            chunk.discard();
     }
 
     /**
@@ -649,13 +2803,50 @@ public:
             Product&        prod)
     {
         throwIfException();
+        if (evictedGuard.contains(prodIndex)) {
+            // A straggler for an evicted product dies here, before any store
+            // lookup or entry-creation
+            static auto& lateDropCount = Metrics::getCounter(
+                    "hycast_store_late_drops_total",
+                    "Late arrivals for recently-evicted products dropped at "
+                    "the product-store's front-guard");
+            lateDropCount.add();
+            discardLate(thing);
+            return RecvStatus{};
+        }
         ProdEntry*  entry;
         RecvStatus  status{};
+        bool        created = false;
         try {
-            status = prods.add(thing, &entry);
-            if (status.isNew())
+            status = prods.add(thing, &entry, &created);
+            if (status.isNew()) {
+                // Only product-information carries a name
+                const auto name = nameOf(thing);
+                if (name.length())
+                    nameIndex.put(name, prodIndex);
+                // A time-to-live likewise arrives only with the
+                // product-information, which may backfill an entry that a
+                // chunk created
+                scheduleTtl(infoOf(thing));
+                // The completing addition schedules the cold-tier migration
+                if (tierCold && entry->isComplete())
+                    coldQ.push(prodIndex);
+            }
+            /*
+             * The data-region is allocated when the entry is created --
+             * speculatively, if the creating addition is a chunk -- so that's
+             * when the product claims its memory and its residence-clock
+             * starts. Subsequent additions (further chunks, the backfilling
+             * product-information) neither re-claim nor re-schedule.
+             */
+            if (created) {
+                memBudget.claim(entry->getInfo().getSize());
                 delayQ.push(prodIndex);
+            }
             prod = entry->getProduct();
+            // Only the completing addition journals the product
+            if (status.isNew() && entry->isComplete())
+                appendToJournal(prod);
         }
         catch (const std::exception& ex) {
             setAndThrowException();
@@ -665,6 +2856,77 @@ public:
         return status;
     }
 
+    /**
+     * Adds a batch of latent chunks of data. Equivalent to -- but cheaper
+     * than -- adding the chunks one at a time: the batch is sorted by shard,
+     * then product, so each product's group of chunks costs one acquisition
+     * of its shard's lock and one completeness check rather than one per
+     * chunk. Per-product bookkeeping -- the memory-budget claim, the
+     * residence clock, the journal append -- likewise runs once per group.
+     * @param[in]  chunks     Latent chunks of data to be added
+     * @param[in]  numChunks  Number of chunks in the batch
+     * @param[out] statuses   Status of each addition, parallel to `chunks`
+     * @param[out] products   Associated product of each chunk, parallel to
+     *                        `chunks`
+     * @exceptionsafety       Basic guarantee
+     * @threadsafety          Safe
+     */
+    void add(
+            LatentChunk* const chunks,
+            const size_t       numChunks,
+            RecvStatus* const  statuses,
+            Product* const     products)
+    {
+        throwIfException();
+        std::vector<size_t> order{};
+        order.reserve(numChunks);
+        for (size_t i = 0; i < numChunks; ++i) {
+            statuses[i] = RecvStatus{};
+            products[i] = Product{};
+            if (evictedGuard.contains(chunks[i].getProdIndex())) {
+                // A straggler for an evicted product dies here, before any
+                // store lookup or entry-creation
+                static auto& lateDropCount = Metrics::getCounter(
+                        "hycast_store_late_drops_total",
+                        "Late arrivals for recently-evicted products dropped "
+                        "at the product-store's front-guard");
+                lateDropCount.add();
+                discardLate(chunks[i]);
+            }
+            else {
+                order.push_back(i);
+            }
+        }
+        if (order.empty())
+            return;
+        try {
+            std::vector<ProdMap::GroupAdd> groups{};
+            prods.add(chunks, order, statuses, products, groups);
+            for (auto& group : groups) {
+                /*
+                 * The same per-group bookkeeping as the single-chunk path's
+                 * per-chunk bookkeeping: the data-region is allocated when
+                 * the entry is created, so that's when the product claims
+                 * its memory and its residence-clock starts; the completing
+                 * group journals the product.
+                 */
+                if (group.created) {
+                    memBudget.claim(group.entry->getInfo().getSize());
+                    delayQ.push(group.prodIndex);
+                }
+                if (group.status.isNew() && group.entry->isComplete()) {
+                    if (tierCold)
+                        coldQ.push(group.prodIndex);
+                    auto prod = group.entry->getProduct();
+                    appendToJournal(prod);
+                }
+            }
+        }
+        catch (const std::exception& ex) {
+            setAndThrowException();
+        }
+    }
+
     /**
      * Returns the number of products in the store -- both complete and
      * incomplete.
@@ -675,6 +2937,22 @@ public:
         return prods.size();
     }
 
+    /**
+     * Returns the index of the product with a given name via the secondary
+     * name-index: one hash probe, no store scan, no store lock.
+     * @param[in]  name       Name of the product
+     * @param[out] prodIndex  Index of the product. Set iff found.
+     * @retval `true`         A product with the name is in the store
+     * @retval `false`        No product with the name is in the store
+     */
+    bool getProdIndex(
+            const std::string& name,
+            ProdIndex&         prodIndex) const
+    {
+        throwIfException();
+        return nameIndex.get(name, prodIndex);
+    }
+
     bool haveProdInfo(const ProdIndex index) const
     {
         throwIfException();
@@ -706,6 +2984,48 @@ public:
         return ProdInfo{}; // To accommodate Eclipse
     }
 
+    /**
+     * Returns information on the oldest data-product this instance still
+     * holds: the lower bound of its retention range. Tracks eviction, so
+     * it's the honest floor to advertise to remote peers.
+     * @return  Information on the oldest resident product. Will be invalid
+     *          if the store is empty.
+     * @see `ProdInfo::operator bool()`
+     */
+    ProdInfo getOldestResident() const
+    {
+        throwIfException();
+        try {
+            ProdIndex index{};
+            return prods.getOldestResident(index)
+                    ? prods.getProdInfo(index)
+                    : ProdInfo{};
+        }
+        catch (const std::exception& ex) {
+            setAndThrowException();
+        }
+        return ProdInfo{}; // To accommodate Eclipse
+    }
+
+    /**
+     * Returns the fraction of a product's data-chunks that have been
+     * received.
+     * @param[in] index  Index of the product
+     * @return           Completeness fraction in `[0,1]`. 0 if the product
+     *                   doesn't exist.
+     */
+    double getCompleteness(const ProdIndex index) const
+    {
+        throwIfException();
+        try {
+            return prods.getCompleteness(index);
+        }
+        catch (const std::exception& ex) {
+            setAndThrowException();
+        }
+        return 0; // To accommodate Eclipse
+    }
+
     /**
      * Indicates if this instance contains a given chunk of data.
      * @param[in] info  Information on the chunk
@@ -756,6 +3076,25 @@ public:
         return emptyChunkId; // To accommodate Eclipse
     }
 
+    /**
+     * Returns the identity of the first chunk of the recent window: the
+     * stored product `numProds` products back from the latest one.
+     * @param[in] numProds  Size of the recent window in products
+     * @return              Identity of the window's first chunk or an empty
+     *                      identifier if the store is empty
+     */
+    ChunkId getRecentStart(const size_t numProds) const
+    {
+        throwIfException();
+        try {
+            return prods.getRecentStart(numProds);
+        }
+        catch (const std::exception& ex) {
+            setAndThrowException();
+        }
+        return emptyChunkId; // To accommodate Eclipse
+    }
+
     ProdStore::ChunkInfoIterator getChunkInfoIterator(
             const ChunkId& startWith)
     {
@@ -764,17 +3103,36 @@ public:
     }
 };
 
-const ChunkId ProdStore::Impl::emptyChunkId{};
+const ChunkId  ProdStore::Impl::emptyChunkId{};
+const uint32_t ProdStore::Impl::persistMagic;
+const uint32_t ProdStore::Impl::persistVersion;
 
 ProdStore::ProdStore(
         const std::string& pathname,
-        const double       residence)
-    : pImpl{new Impl(pathname, residence)}
+        const double       residence,
+        const double       coldAge,
+        const bool         hugePages)
+    : pImpl{new Impl(pathname, residence, coldAge, hugePages)}
 {}
 
-void ProdStore::add(Product& prod)
+void ProdStore::setMemBudget(const MemBudget& memBudget) const
 {
-    pImpl->add(prod);
+    pImpl->setMemBudget(memBudget);
+}
+
+void ProdStore::setResidence(const double residence) const
+{
+    pImpl->setResidence(residence);
+}
+
+void ProdStore::awaitHistory() const
+{
+    pImpl->awaitHistory();
+}
+
+bool ProdStore::add(Product& prod)
+{
+    return pImpl->add(prod);
 }
 
 RecvStatus ProdStore::add(
@@ -788,14 +3146,32 @@ RecvStatus ProdStore::add(
         LatentChunk& chunk,
         Product&     prod)
 {
+    OpAccounting::Scope opScope{OpAccounting::STORE_ADD};
     return pImpl->add(chunk, chunk.getProdIndex(), prod);
 }
 
+void ProdStore::add(
+        LatentChunk* const chunks,
+        const size_t       numChunks,
+        RecvStatus* const  statuses,
+        Product* const     prods)
+{
+    OpAccounting::Scope opScope{OpAccounting::STORE_ADD};
+    pImpl->add(chunks, numChunks, statuses, prods);
+}
+
 size_t ProdStore::size() const noexcept
 {
     return pImpl->size();
 }
 
+bool ProdStore::getProdIndex(
+        const std::string& name,
+        ProdIndex&         prodIndex) const
+{
+    return pImpl->getProdIndex(name, prodIndex);
+}
+
 bool ProdStore::haveProdInfo(const ProdIndex index) const
 {
     return pImpl->haveProdInfo(index);
@@ -806,6 +3182,11 @@ ProdInfo ProdStore::getProdInfo(const ProdIndex index) const
     return pImpl->getProdInfo(index);
 }
 
+double ProdStore::getCompleteness(const ProdIndex index) const
+{
+    return pImpl->getCompleteness(index);
+}
+
 bool ProdStore::haveChunk(const ChunkId& id) const
 {
     return pImpl->haveChunk(id);
@@ -816,11 +3197,21 @@ ActualChunk ProdStore::getChunk(const ChunkId& id) const
     return pImpl->getChunk(id);
 }
 
+ProdInfo ProdStore::getOldestResident() const
+{
+    return pImpl->getOldestResident();
+}
+
 ChunkId ProdStore::getOldestMissingChunk() const
 {
     return pImpl->identifyEarliestMissingChunk();
 }
 
+ChunkId ProdStore::getRecentStart(const size_t numProds) const
+{
+    return pImpl->getRecentStart(numProds);
+}
+
 ProdStore::ChunkInfoIterator ProdStore::getChunkInfoIterator(
         const ChunkId& startWith) const
 {
@@ -14,6 +14,7 @@
 #define MAIN_PROD_PRODSTORE_H_
 
 #include "Chunk.h"
+#include "MemBudget.h"
 #include "Product.h"
 #include "ProdRcvr.h"
 #include <memory>
@@ -49,18 +50,38 @@ public:
     /**
      * Constructs. If the given file isn't the empty string, then the
      * product-store will be written to it upon destruction in order to persist
-     * the store between sessions.
+     * the store between sessions. Additionally, completed data-products are
+     * appended to a bounded journal -- the given pathname with ".journal"
+     * appended -- that's flushed to disk on a short interval and replayed at
+     * startup, so recovery after a crash costs seconds of replay rather than
+     * refetching everything over the network. Historical products are loaded
+     * on a separate thread, so the store accepts new products immediately;
+     * until the load completes, lookups simply don't see the history.
      * @param[in] path        Pathname of file for persisting the product-store
      *                        between sessions or the empty string to indicate
      *                        no persistence
      * @param[in] residence   Desired minimum residence-time, in seconds, of
      *                        data-products
+     * @param[in] coldAge     Age, in seconds, at which a complete data-product
+     *                        is migrated to a compressed cold tier or 0 to
+     *                        keep every data-product uncompressed. A cold
+     *                        data-product is transparently decompressed when
+     *                        it or a chunk of its data is requested.
+     * @param[in] hugePages   Whether the data buffers of incoming
+     *                        data-products should be backed by 2 MiB huge
+     *                        pages, which reduces TLB pressure when many
+     *                        large data-products are resident. Silently falls
+     *                        back to regular pages if huge pages aren't
+     *                        available.
      * @throw SystemError     Couldn't open temporary persistence-file
      * @throw InvalidArgument Residence-time is negative
+     * @throw InvalidArgument Cold-tier age is negative
      */
     explicit ProdStore(
             const std::string& pathname,
-            const double       residence = DEFAULT_MIN_RESIDENCE);
+            const double       residence = DEFAULT_MIN_RESIDENCE,
+            const double       coldAge = 0,
+            const bool         hugePages = false);
 
     /**
      * Constructs. The product-store will not be written to a persistence-file
@@ -74,15 +95,51 @@ public:
         : ProdStore("", residence)
     {}
 
+    /**
+     * Sets the shared memory-budget. Subsequently-added products claim their
+     * size against the budget and release it when evicted. Under pressure,
+     * the oldest products are evicted before their minimum residence-time
+     * elapses and complete products are compressed without waiting for the
+     * cold-tier age.
+     * @param[in] memBudget  Shared memory-budget
+     * @throw LogicError     A memory-budget was already set
+     * @exceptionsafety      Strong guarantee
+     * @threadsafety         Compatible but not safe
+     */
+    void setMemBudget(const MemBudget& memBudget) const;
+
+    /**
+     * Waits until the historical products -- those in the persistence-file
+     * and its journal -- have been loaded. Returns immediately if the load
+     * has completed or no persistence-file was specified.
+     * @exceptionsafety  Basic guarantee
+     * @threadsafety     Safe
+     */
+    void awaitHistory() const;
+
+    /**
+     * Sets the minimum residence-time of subsequently-added data-products.
+     * Products already in the store keep the residence-time that was in
+     * effect when they were added. Also adjustable at runtime via the
+     * tunable `store.<n>.residence`.
+     * @param[in] residence    Desired minimum residence-time, in seconds
+     * @throw InvalidArgument  Residence-time is negative
+     * @exceptionsafety        Strong guarantee
+     * @threadsafety           Safe
+     */
+    void setResidence(const double residence) const;
+
     /**
      * Adds an entire product. Does nothing if the product has already been
      * added. If added, the product will be removed when the minimum residence
      * time has elapsed.
      * @param[in] prod   Product to be added
+     * @retval `true`    Product was added
+     * @retval `false`   Product had already been added
      * @exceptionsafety  Basic guarantee
      * @threadsafety     Safe
      */
-    void add(Product& prod);
+    bool add(Product& prod);
 
     /**
      * Adds product-information to an entry. Creates the entry if it doesn't
@@ -111,6 +168,32 @@ public:
      */
     RecvStatus add(LatentChunk& chunk, Product& prod);
 
+    /**
+     * Adds a batch of latent chunks of data. Equivalent to -- but cheaper
+     * than -- adding the chunks one at a time: the batch is sorted by shard,
+     * then product, so each product's group of chunks costs one acquisition
+     * of its shard's lock and one completeness check rather than one per
+     * chunk. With batched socket reception delivering many chunks per system
+     * call, per-chunk lock acquisition would squander the batching gains
+     * upstream of the store.
+     * @param[in]  chunks     Latent chunks of data to be added
+     * @param[in]  numChunks  Number of chunks in the batch
+     * @param[out] statuses   Status of each addition, parallel to `chunks`.
+     *                        Must have at least `numChunks` elements; every
+     *                        element is overwritten.
+     * @param[out] prods      Associated product of each chunk, parallel to
+     *                        `chunks`. Must have at least `numChunks`
+     *                        elements; every element is overwritten.
+     * @exceptionsafety       Basic guarantee
+     * @threadsafety          Safe
+     * @see                   `ProdStore::add(LatentChunk&, Product&)`
+     */
+    void add(
+            LatentChunk* chunks,
+            size_t       numChunks,
+            RecvStatus*  statuses,
+            Product*     prods);
+
     /**
      * Returns the number of products in the store -- both complete and
      * incomplete.
@@ -136,6 +219,33 @@ public:
      */
     ProdInfo getProdInfo(const ProdIndex index) const;
 
+    /**
+     * Returns the fraction of a given data-product's data-chunks that have
+     * been received -- e.g., so the chunk-request scheduler can prefer chunks
+     * that finish nearly-complete products.
+     * @param[in] index  Index of the data-product
+     * @return           Completeness fraction in `[0,1]`. 0 if no such
+     *                   data-product exists.
+     * @threadsafety     Safe
+     */
+    double getCompleteness(const ProdIndex index) const;
+
+    /**
+     * Returns the index of the product with a given name. The lookup probes
+     * a secondary index that's maintained incrementally on addition and
+     * eviction, so it costs one hash probe rather than a scan of the store
+     * under its locks. If several resident products share the name, the most
+     * recently added one is returned.
+     * @param[in]  name       Name of the product
+     * @param[out] prodIndex  Index of the product. Set iff found.
+     * @retval `true`         A product with the name is in the store
+     * @retval `false`        No product with the name is in the store
+     * @threadsafety          Safe
+     */
+    bool getProdIndex(
+            const std::string& name,
+            ProdIndex&         prodIndex) const;
+
     /**
      * Indicates if this instance contains a given chunk of data.
      * @param[in] id    Identifier of chunk
@@ -153,12 +263,36 @@ public:
      */
     ActualChunk getChunk(const ChunkId& id) const;
 
+    /**
+     * Returns information on the oldest data-product this instance still
+     * holds: the lower bound of its retention range. Tracks eviction, so
+     * it's the honest floor to advertise to remote peers.
+     * @return        Information on the oldest resident product. Will be
+     *                invalid if the store is empty.
+     * @threadsafety  Safe
+     * @see `ProdInfo::operator bool()`
+     */
+    ProdInfo getOldestResident() const;
+
     /**
      * Returns information on the oldest missing data-chunk.
      * @return  Information on the oldest missing data-chunk
      */
     ChunkId getOldestMissingChunk() const;
 
+    /**
+     * Returns the identity of the first chunk of the recent window: the
+     * stored product `numProds` products back from the latest one (or the
+     * earliest stored product if fewer are stored). Intended for serving a
+     * backlog recent-window first.
+     * @param[in] numProds  Size of the recent window in products
+     * @return              Identity of the window's first chunk or an empty
+     *                      identifier if the store is empty
+     * @threadsafety        Safe
+     * @see `ChunkId::operator bool()`
+     */
+    ChunkId getRecentStart(const size_t numProds) const;
+
     ChunkInfoIterator getChunkInfoIterator(const ChunkId& startWith) const;
 };
 
@@ -113,7 +113,39 @@ public:
 
     virtual bool isComplete() const noexcept =0;
 
+    /**
+     * Returns the size of the contiguous leading extent of the data. A
+     * complete product's extent is its entire data, so that's the default.
+     * @return Size, in bytes, of the contiguous leading extent
+     */
+    virtual ProdSize getContiguousSize() const noexcept
+    {
+        return prodInfo.getSize();
+    }
+
+    /**
+     * Returns the number of received data-chunks. A complete product has all
+     * of them, so that's the default.
+     * @return Number of received data-chunks
+     */
+    virtual ChunkIndex getNumReceivedChunks() const noexcept
+    {
+        return prodInfo.getNumChunks();
+    }
+
     virtual const char* getData() =0;
+
+    /**
+     * Returns a non-copying view of the contiguous leading extent of the
+     * data. The default view keeps this implementation alive, which suffices
+     * when the implementation owns the data's storage.
+     * @param[in] self  This implementation as referenced by the handle
+     * @return          View of the data
+     */
+    virtual Product::DataSpan getDataSpan(const std::shared_ptr<Impl>& self)
+    {
+        return Product::DataSpan{getData(), getContiguousSize(), self};
+    }
 };
 
 Product::Product(Impl* ptr)
@@ -163,11 +195,26 @@ bool Product::isComplete() const noexcept
     return pImpl->isComplete();
 }
 
+ProdSize Product::getContiguousSize() const noexcept
+{
+    return pImpl->getContiguousSize();
+}
+
+ChunkIndex Product::getNumReceivedChunks() const noexcept
+{
+    return pImpl->getNumReceivedChunks();
+}
+
 const char* Product::getData()
 {
     return pImpl->getData();
 }
 
+Product::DataSpan Product::getDataSpan()
+{
+    return pImpl->getDataSpan(pImpl);
+}
+
 bool Product::haveChunk(const ChunkOffset offset) const
 {
     return pImpl->haveChunk(offset);
@@ -180,7 +227,16 @@ bool Product::haveChunk(const ChunkIndex index) const
 
 ActualChunk Product::getChunk(const ChunkIndex index)
 {
-    return pImpl->getChunk(index);
+    auto chunk = pImpl->getChunk(index);
+    /*
+     * The chunk references this product's data directly. Retaining the
+     * implementation keeps the data alive -- without copying it -- even if
+     * this product is deleted while the chunk is in use (e.g., queued for
+     * transmission to a peer).
+     */
+    if (chunk)
+        chunk.keepData(pImpl);
+    return chunk;
 }
 
 /******************************************************************************/
@@ -217,28 +273,41 @@ public:
     }
 
     /**
-     * Sets the associated product-information providing it is consistent with
-     * the information provided during construction (basically, only the name
-     * can be changed).
-     * @param[in] info       New product-information
-     * @retval `false`       Duplicate information
-     * @retval `true`        New information consistent with existing
-     * @throw LogicError     Product information can't be changed
+     * Does nothing because a complete product's information can't change.
+     * Product-information arriving for a complete product is a routine
+     * duplicate (e.g., the multicast and P2P transports race), so it's
+     * rejected with a status code rather than an exception.
+     * @param[in] info  New product-information
+     * @retval `false`  Always. Duplicate information.
      */
     inline bool set(const ProdInfo& info)
     {
-        throw LOGIC_ERROR(
-                "Can't set product-information of complete product");
+        return false;
     }
 
+    /**
+     * Does nothing because a complete product already has all its data. A
+     * chunk arriving for a complete product is a routine duplicate, so it's
+     * rejected with a status code rather than an exception.
+     * @param[in] chunk  Chunk of data
+     * @retval `false`   Always. Duplicate chunk.
+     */
     inline bool add(const ActualChunk& chunk)
     {
-        throw LOGIC_ERROR("Can't add data to complete product");
+        return false;
     }
 
+    /**
+     * Discards the chunk because a complete product already has all its
+     * data. A chunk arriving for a complete product is a routine duplicate,
+     * so it's rejected with a status code rather than an exception.
+     * @param[in] chunk  Latent chunk of data
+     * @retval `false`   Always. Duplicate chunk.
+     */
     inline bool add(LatentChunk& chunk)
     {
-        throw LOGIC_ERROR("Can't add data to complete product");
+        chunk.discard();
+        return false;
     }
 
     /**
@@ -271,7 +340,9 @@ CompleteProduct::~CompleteProduct()
 
 class MemoryProduct::Impl : public CompleteProduct::Impl
 {
-    const char* data;
+    const char*           data;
+    /// Releases the caller-managed storage. May be empty.
+    std::function<void()> release;
 
 public:
     Impl(   const ProdIndex    index,
@@ -281,8 +352,47 @@ public:
             const ChunkSize    chunkSize)
         : CompleteProduct::Impl{ProdInfo{index, name, size, chunkSize}}
         , data{data}
+        , release{}
+    {}
+
+    Impl(   const ProdIndex              index,
+            const std::string&           name,
+            const ProdSize               size,
+            const char*                  data,
+            const std::function<void()>& release,
+            const ChunkSize              chunkSize)
+        : CompleteProduct::Impl{ProdInfo{index, name, size, chunkSize}}
+        , data{data}
+        , release{release}
+    {}
+
+    Impl(   const ProdInfo& prodInfo,
+            const char*     data)
+        : CompleteProduct::Impl{prodInfo}
+        , data{data}
+        , release{}
     {}
 
+    Impl(   const ProdInfo&              prodInfo,
+            const char*                  data,
+            const std::function<void()>& release)
+        : CompleteProduct::Impl{prodInfo}
+        , data{data}
+        , release{release}
+    {}
+
+    ~Impl() noexcept
+    {
+        if (release) {
+            try {
+                release();
+            }
+            catch (const std::exception& ex) {
+                log_error(ex);
+            }
+        }
+    }
+
     ActualChunk getChunk(const ChunkIndex index)
     {
         auto offset = prodInfo.getChunkOffset(index);
@@ -309,16 +419,67 @@ MemoryProduct::MemoryProduct(
     : CompleteProduct{new Impl{index, name, size, data, chunkSize}}
 {}
 
+MemoryProduct::MemoryProduct(
+        const ProdIndex              index,
+        const ProdName&              name,
+        const ProdSize               size,
+        const char*                  data,
+        const std::function<void()>& release,
+        const ChunkSize              chunkSize)
+    : CompleteProduct{new Impl{index, name, size, data, release, chunkSize}}
+{}
+
+MemoryProduct::MemoryProduct(
+        const ProdInfo& prodInfo,
+        const char*     data)
+    : CompleteProduct{new Impl{prodInfo, data}}
+{}
+
+MemoryProduct::MemoryProduct(
+        const ProdInfo&              prodInfo,
+        const char*                  data,
+        const std::function<void()>& release)
+    : CompleteProduct{new Impl{prodInfo, data, release}}
+{}
+
 /******************************************************************************/
 
 class FileProduct::Impl : public CompleteProduct::Impl
 {
     typedef std::mutex Mutex;
 
+    /**
+     * A memory-mapped region of a product-file. Reference-counted so that a
+     * chunk that's being shipped keeps the pages mapped after the
+     * least-recently-used mechanism or the destructor releases them.
+     */
+    class Mapping final
+    {
+        void* const  addr;
+        const size_t size;
+
+    public:
+        Mapping(void* const  addr,
+                const size_t size) noexcept
+            : addr{addr}
+            , size{size}
+        {}
+        Mapping(const Mapping&) =delete;
+        Mapping& operator=(const Mapping&) =delete;
+        ~Mapping() noexcept
+        {
+            ::munmap(addr, size);
+        }
+        char* data() const noexcept
+        {
+            return static_cast<char*>(addr);
+        }
+    };
+
     /// Pathname of file
     std::string                              pathname;
-    /// Product data
-    void*                                    data;
+    /// Memory-mapping of the file or empty
+    std::shared_ptr<Mapping>                 mapping;
     /// Collection of active instances
     static LinkedHashMap<std::string, Impl*> activeImpls;
     /// Mutex for concurrent access to collection of active instances
@@ -378,10 +539,14 @@ class FileProduct::Impl : public CompleteProduct::Impl
      */
     int memoryMap(const int fd)
     {
-        auto ptr = ::mmap(0, prodInfo.getSize(), PROT_READ, MAP_PRIVATE, fd, 0);
+        const size_t size = prodInfo.getSize();
+        auto         ptr = ::mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
         if (ptr == MAP_FAILED)
             return errno;
-        data = ptr;
+        // Shipping reads a product sequentially; the page cache -- not the
+        // heap -- holds the product's bytes
+        ::madvise(ptr, size, MADV_SEQUENTIAL);
+        mapping.reset(new Mapping{ptr, size});
         return 0;
     }
 
@@ -394,13 +559,14 @@ class FileProduct::Impl : public CompleteProduct::Impl
      */
     void unMemoryMap()
     {
-        ::munmap(data, prodInfo.getSize());
-        data = nullptr;
+        // The pages persist until the last in-flight chunk drops its
+        // reference
+        mapping.reset();
     }
 
     /**
      * Makes this instance the most-recently accessed one.
-     * @pre                  `data != nullptr`
+     * @pre                  The file is memory-mapped
      * @exceptionsafety      Strong guarantee for this instance; Basic guarantee
      *                       for `activeImpls`.
      * @threadsafety         Safe
@@ -416,7 +582,7 @@ class FileProduct::Impl : public CompleteProduct::Impl
      * Activates this instance. Memory-maps the file and adds this instance
      * to the collection of active instances.
      * @pre                  `prodInfo` is valid
-     * @pre                  `data == nullptr`
+     * @pre                  The file isn't memory-mapped
      * @throw RuntimeError   Couldn't free-up sufficient resources
      * @throw SystemError    Couldn't open file
      * @throw SystemError    Couldn't memory-map file
@@ -481,7 +647,7 @@ class FileProduct::Impl : public CompleteProduct::Impl
      */
     inline void ensureActive()
     {
-        data
+        mapping
             ? makeMostRecentlyAccessed()
             : activate();
     }
@@ -502,7 +668,7 @@ public:
             const ChunkSize    chunkSize)
         : CompleteProduct::Impl() // Eclipse misunderstands `{}`
         , pathname{pathname}
-        , data{nullptr}
+        , mapping{}
     {
         int fd = openFile();
         try {
@@ -521,7 +687,7 @@ public:
      */
     ~Impl() noexcept
     {
-        if (data)
+        if (mapping)
             deactivate();
     }
 
@@ -533,7 +699,14 @@ public:
     {
         auto offset = prodInfo.getChunkOffset(index);
         ensureActive();
-        return ActualChunk{prodInfo, index, static_cast<char*>(data) + offset};
+        ActualChunk chunk{prodInfo, index, mapping->data() + offset};
+        /*
+         * The mapping must outlive the chunk: the least-recently-used
+         * mechanism may unmap this product while the chunk awaits
+         * transmission.
+         */
+        chunk.keepData(mapping);
+        return chunk;
     }
 
     /**
@@ -543,7 +716,21 @@ public:
     const char* getData()
     {
         ensureActive();
-        return static_cast<char*>(data);
+        return mapping->data();
+    }
+
+    /**
+     * @exceptionsafety     Strong guarantee
+     * @threadsafety        Compatible but not safe
+     */
+    Product::DataSpan getDataSpan(const std::shared_ptr<Product::Impl>& self)
+    {
+        ensureActive();
+        /*
+         * The mapping must outlive the view: the least-recently-used
+         * mechanism may unmap this product while the view is in use
+         */
+        return Product::DataSpan{mapping->data(), prodInfo.getSize(), mapping};
     }
 };
 
@@ -565,20 +752,74 @@ FileProduct::FileProduct(
 
 class PartialProduct::Impl : public Product::Impl
 {
+    /// Size of a huge page in bytes. Linux's default huge-page size is 2 MiB.
+    static const size_t hugePageSize = 2*1024*1024;
+
     std::vector<bool> chunkVec;
     char*             data;
+    size_t            mapSize; /// Size of mapping; 0 <=> `data` is on the heap
     ChunkIndex::type  numChunks; /// Current number of contained chunks
+    /// Number of leading chunks present without a gap
+    ChunkIndex::type  prefixChunks;
     bool              complete;
 
+    /**
+     * Allocates the data buffer. If huge pages are requested and the product
+     * is at least a huge page in size, then the buffer is memory-mapped --
+     * first with explicit huge pages and, failing that (e.g., because none
+     * are reserved), with regular pages advised to be transparently promoted.
+     * Otherwise, the buffer is allocated on the heap.
+     * @param[in] size       Size of the data buffer in bytes
+     * @param[in] hugePages  Whether huge-page backing should be requested
+     * @throw SystemError    Out of memory
+     * @exceptionsafety      Strong guarantee
+     */
+    void allocData(
+            const size_t size,
+            const bool   hugePages)
+    {
+#ifdef MAP_HUGETLB
+        if (hugePages && size >= hugePageSize) {
+            // Round up to a whole number of huge pages
+            const size_t roundedSize =
+                    (size + hugePageSize - 1) / hugePageSize * hugePageSize;
+            auto ptr = ::mmap(nullptr, roundedSize, PROT_READ|PROT_WRITE,
+                    MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0);
+            if (ptr == MAP_FAILED) {
+                // No reserved huge pages. Use regular pages and ask the
+                // kernel to transparently promote them.
+                ptr = ::mmap(nullptr, roundedSize, PROT_READ|PROT_WRITE,
+                        MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+                if (ptr != MAP_FAILED)
+                    ::madvise(ptr, roundedSize, MADV_HUGEPAGE);
+#endif
+            }
+            if (ptr != MAP_FAILED) {
+                data = static_cast<char*>(ptr);
+                mapSize = roundedSize;
+                return;
+            }
+        }
+#endif
+        data = new char[size];
+    }
+
 public:
-    explicit Impl(const ProdInfo& prodInfo)
+    explicit Impl(
+            const ProdInfo& prodInfo,
+            const bool      hugePages = false)
         : Product::Impl{prodInfo}
         // Parentheses are necessary in the following initialization
         , chunkVec(prodInfo.getNumChunks(), false)
-        , data{new char[prodInfo.getSize()]}
+        , data{nullptr}
+        , mapSize{0}
         , numChunks{0}
+        , prefixChunks{0}
         , complete{false}
-    {}
+    {
+        allocData(prodInfo.getSize(), hugePages);
+    }
 
     Impl(const Impl& that) =delete;
     Impl& operator=(const Impl& rhs) =delete;
@@ -588,7 +829,12 @@ public:
      */
     ~Impl()
     {
-        delete[] data;
+        if (mapSize) {
+            ::munmap(data, mapSize);
+        }
+        else {
+            delete[] data;
+        }
     }
 
     ChunkId identifyEarliestMissingChunk() const noexcept
@@ -615,11 +861,28 @@ public:
         ::memcpy(data + chunk.getOffset(), chunk.getData(), chunk.getSize());
         chunkVec[chunkIndex] = true;
         complete = ++numChunks == prodInfo.getNumChunks();
-        if (complete)
+        if (complete) {
             std::vector<bool>().swap(chunkVec); // clear by reallocating
+        }
+        else {
+            while (prefixChunks < chunkVec.size() && chunkVec[prefixChunks])
+                ++prefixChunks;
+        }
         return true;
     }
 
+    /**
+     * Adds a latent chunk of data. Routine rejections -- duplicates and
+     * chunks that don't belong to this product (e.g., the sender reused the
+     * product-index after this receiver fell behind) -- are indicated by the
+     * return value rather than an exception because they're common under
+     * load and an exception here would cost the connection that delivered
+     * the chunk.
+     * @param[in] chunk  Latent chunk
+     * @retval `true`    Chunk was added
+     * @retval `false`   Chunk was rejected. A warning is logged unless the
+     *                   chunk was merely a duplicate.
+     */
     bool add(LatentChunk& chunk)
     {
         if (complete) {
@@ -627,10 +890,12 @@ public:
             return false;
         }
         if (chunk.getInfo() != prodInfo.getChunkInfo(chunk.getIndex())) {
-            throw INVALID_ARGUMENT("Inconsistent latent-chunk information: "
+            LOG_WARN("Rejecting inconsistent latent-chunk information: "
                     "chunkInfo=" + std::to_string(chunk.getInfo()) +
                     ", expected=" +
                     std::to_string(prodInfo.getChunkInfo(chunk.getIndex())));
+            chunk.discard();
+            return false;
         }
         const auto chunkIndex = chunk.getIndex();
         if (chunkVec.at(chunkIndex)) {
@@ -640,37 +905,57 @@ public:
         const auto expectedChunkSize = prodInfo.getChunkSize(chunkIndex);
         const auto chunkOffset = chunk.getOffset();
         if (chunkOffset + expectedChunkSize > prodInfo.getSize()) {
+            LOG_WARN("Rejecting data-chunk: chunkOffset{" +
+                    std::to_string(chunkOffset) + "} + chunkSize{" +
+                    std::to_string(expectedChunkSize) + "} > productSize{" +
+                    std::to_string(prodInfo.getSize()) + "}");
             chunk.discard();
-            throw RUNTIME_ERROR("chunkOffset{" + std::to_string(chunkOffset) +
-                    "} + chunkSize{" + std::to_string(expectedChunkSize) +
-                    "} > productSize{" + std::to_string(prodInfo.getSize()) +
-                    "}");
+            return false;
         }
         const auto actualChunkSize = chunk.drainData(data+chunkOffset,
                 expectedChunkSize);
-        if (actualChunkSize != expectedChunkSize)
-            throw RUNTIME_ERROR(
-                    "Unexpected chunk size: expected=" +
-                    std::to_string(expectedChunkSize) +
-                    ", actual=" + std::to_string(actualChunkSize));
+        if (actualChunkSize != expectedChunkSize) {
+            // Corrupt or short chunk. The buffer region wasn't marked
+            // received, so the chunk will be re-requested.
+            LOG_WARN("Rejecting data-chunk " +
+                    chunk.getInfo().getId().to_string() +
+                    ": expected " + std::to_string(expectedChunkSize) +
+                    " bytes; got " + std::to_string(actualChunkSize));
+            return false;
+        }
         complete = ++numChunks == prodInfo.getNumChunks();
         if (complete) {
             std::vector<bool>().swap(chunkVec); // clear by reallocating
         }
         else {
             chunkVec[chunkIndex] = true;
+            while (prefixChunks < chunkVec.size() && chunkVec[prefixChunks])
+                ++prefixChunks;
         }
         return true;
     }
 
+    /**
+     * Sets the associated product-information providing it is consistent
+     * with the information provided during construction (basically, only the
+     * name can be changed). Inconsistent information is a routine rejection
+     * (e.g., the sender reused the product-index), so it's indicated by the
+     * return value rather than an exception.
+     * @param[in] info  New product-information
+     * @retval `true`   New information consistent with existing
+     * @retval `false`  Duplicate or inconsistent information. A warning is
+     *                  logged if the information is inconsistent.
+     */
     bool set(const ProdInfo& info)
     {
         if (info.getIndex() != prodInfo.getIndex() ||
                 info.getSize() != prodInfo.getSize() ||
-                info.getChunkSize() != prodInfo.getChunkSize())
-            throw RUNTIME_ERROR(
-                    "Replacement product-information is inconsistent: curr=" +
+                info.getChunkSize() != prodInfo.getChunkSize()) {
+            LOG_WARN(
+                    "Rejecting inconsistent product-information: curr=" +
                     prodInfo.to_string() + ", new=" + info.to_string());
+            return false;
+        }
         const bool isNew = prodInfo.getName().to_string().length() == 0 &&
                 info.getName().to_string().length() > 0;
         prodInfo = info;
@@ -682,6 +967,29 @@ public:
         return complete && prodInfo.getName().to_string().length() > 0;
     }
 
+    /**
+     * Returns the size of the contiguous leading extent of the data.
+     * `prefixChunks` is less than the number of chunks while the product is
+     * incomplete, so the offset-computation can't throw.
+     * @return Size, in bytes, of the contiguous leading extent
+     */
+    ProdSize getContiguousSize() const noexcept
+    {
+        if (complete)
+            return prodInfo.getSize();
+        return prefixChunks
+                ? ProdSize{prodInfo.getChunkOffset(
+                        static_cast<ChunkIndex>(prefixChunks))}
+                : ProdSize{0};
+    }
+
+    ChunkIndex getNumReceivedChunks() const noexcept
+    {
+        return complete
+                ? prodInfo.getNumChunks()
+                : ChunkIndex{numChunks};
+    }
+
     bool haveChunk(const ChunkIndex index) const
     {
         return index < prodInfo.getNumChunks() && (complete || chunkVec[index]);
@@ -716,8 +1024,10 @@ PartialProduct::PartialProduct()
     : Product{}
 {}
 
-PartialProduct::PartialProduct(const ProdInfo& prodInfo)
-    : Product{new Impl{prodInfo}}
+PartialProduct::PartialProduct(
+        const ProdInfo& prodInfo,
+        const bool      hugePages)
+    : Product{new Impl{prodInfo, hugePages}}
 {}
 
 } // namespace
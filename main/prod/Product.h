@@ -15,6 +15,7 @@
 #include "ProdInfo.h"
 #include "Chunk.h"
 
+#include <functional>
 #include <memory>
 
 namespace hycast {
@@ -36,6 +37,79 @@ protected:
     Product(Impl* ptr);
 
 public:
+    /**
+     * Non-copying view of the contiguous leading extent of a product's data.
+     * References the product's storage directly and holds whatever keeps that
+     * storage alive (e.g., a file-product's memory-mapping), so the view
+     * remains valid for its own lifetime -- even after the product handle is
+     * destroyed or the least-recently-used mechanism would have released the
+     * storage.
+     * @see `Product::getDataSpan()`
+     */
+    class DataSpan final
+    {
+        std::shared_ptr<const void> keeper; ///< Keeps the data's storage alive
+        const char*                 data;   ///< First byte of the data
+        ProdSize                    size;   ///< Size of the data in bytes
+
+    public:
+        /**
+         * Default constructs an invalid instance.
+         */
+        DataSpan()
+            : keeper{}
+            , data{nullptr}
+            , size{0}
+        {}
+
+        /**
+         * Constructs.
+         * @param[in] data    First byte of the data. Not copied.
+         * @param[in] size    Size of the data in bytes
+         * @param[in] keeper  Reference-counted owner of the data's storage
+         */
+        DataSpan(
+                const char*                        data,
+                const ProdSize                     size,
+                const std::shared_ptr<const void>& keeper)
+            : keeper{keeper}
+            , data{data}
+            , size{size}
+        {}
+
+        /**
+         * Indicates if this instance is valid (i.e., references data).
+         * @retval `true`   Instance is valid
+         * @retval `false`  Instance is not valid
+         */
+        inline operator bool() const noexcept
+        {
+            return data != nullptr;
+        }
+
+        /**
+         * Returns a pointer to the data.
+         * @return          Pointer to the data
+         * @exceptionsafety Nothrow
+         * @threadsafety    Safe
+         */
+        inline const char* getData() const noexcept
+        {
+            return data;
+        }
+
+        /**
+         * Returns the size of the data.
+         * @return          Size of the data in bytes
+         * @exceptionsafety Nothrow
+         * @threadsafety    Safe
+         */
+        inline ProdSize getSize() const noexcept
+        {
+            return size;
+        }
+    };
+
     /**
      * Default constructs.
      */
@@ -166,12 +240,46 @@ public:
      */
     bool isComplete() const noexcept;
 
+    /**
+     * Returns the size of the contiguous leading extent of the data: the
+     * number of bytes, starting at offset 0, that have been received. Equals
+     * the product's size iff the product is complete.
+     * @return          Size, in bytes, of the contiguous leading extent
+     * @exceptionsafety Nothrow
+     * @threadsafety    Compatible but not safe
+     */
+    ProdSize getContiguousSize() const noexcept;
+
+    /**
+     * Returns the number of data-chunks that have been received -- anywhere
+     * in the product, not just the contiguous leading extent. Equals
+     * `getInfo().getNumChunks()` iff the product is complete.
+     * @return          Number of received data-chunks
+     * @exceptionsafety Nothrow
+     * @threadsafety    Compatible but not safe
+     */
+    ChunkIndex getNumReceivedChunks() const noexcept;
+
     /**
      * Returns a pointer to the data, which might contain garbage if
      * `isComplete()` is false.
      * @return  Pointer to data
      */
     const char* getData();
+
+    /**
+     * Returns a view of the contiguous leading extent of the data -- the
+     * entire data iff the product is complete -- without copying it. Unlike
+     * `getData()`, the view keeps the underlying storage alive, so it remains
+     * valid even after a file-product's memory-mapping would otherwise be
+     * released. A Processing implementation that only hashes or forwards the
+     * bytes can consequently work directly from the product's storage.
+     * @return           View of the data
+     * @exceptionsafety  Strong guarantee
+     * @threadsafety     Compatible but not safe
+     * @see `getContiguousSize()`
+     */
+    DataSpan getDataSpan();
 };
 
 /******************************************************************************/
@@ -212,6 +320,53 @@ public:
             const ProdSize  size,
             const char*     data,
             const ChunkSize chunkSize = ChunkSize::defaultSize);
+
+    /**
+     * Constructs from complete data in caller-managed storage -- e.g., a slot
+     * in a shared-memory ring -- that must be released when the product is no
+     * longer referenced.
+     * @param[in] index      Data-product index
+     * @param[in] name       Name of data-product
+     * @param[in] size       Size of data-product
+     * @param[in] data       Product data. Not copied. *Must* exist until
+     *                       `release` is called.
+     * @param[in] release    Called when the last copy of the constructed
+     *                       instance is destroyed
+     * @param[in] chunkSize  Canonical size of a data-chunk
+     */
+    MemoryProduct(
+            const ProdIndex              index,
+            const ProdName&              name,
+            const ProdSize               size,
+            const char*                  data,
+            const std::function<void()>& release,
+            const ChunkSize              chunkSize = ChunkSize::defaultSize);
+
+    /**
+     * Constructs from complete product-information and data -- e.g., so an
+     * ingester can set the priority class or time-to-live.
+     * @param[in] prodInfo  Complete information on the data-product
+     * @param[in] data      Product data. Not copied. *Must* exist for the
+     *                      lifetime of the constructed instance.
+     */
+    MemoryProduct(
+            const ProdInfo& prodInfo,
+            const char*     data);
+
+    /**
+     * Constructs from complete product-information and data in
+     * caller-managed storage that must be released when the product is no
+     * longer referenced.
+     * @param[in] prodInfo  Complete information on the data-product
+     * @param[in] data      Product data. Not copied. *Must* exist until
+     *                      `release` is called.
+     * @param[in] release   Called when the last copy of the constructed
+     *                      instance is destroyed
+     */
+    MemoryProduct(
+            const ProdInfo&              prodInfo,
+            const char*                  data,
+            const std::function<void()>& release);
 };
 
 /******************************************************************************/
@@ -244,7 +399,19 @@ class PartialProduct final : public Product
 public:
     PartialProduct();
 
-    PartialProduct(const ProdInfo& prodInfo);
+    /**
+     * Constructs.
+     * @param[in] prodInfo   Information on the data-product
+     * @param[in] hugePages  Whether the data buffer should be backed by 2 MiB
+     *                       huge pages, which reduces TLB pressure when many
+     *                       large data-products are resident. Has no effect
+     *                       on data-products smaller than a huge page.
+     *                       Silently falls back to regular pages if huge
+     *                       pages aren't available.
+     */
+    PartialProduct(
+            const ProdInfo& prodInfo,
+            const bool      hugePages = false);
 };
 
 } // namespace
@@ -0,0 +1,527 @@
+/**
+ * This file implements a shared-memory ingester of data-products. One that
+ * returns to a source-node of hycast products a sequence of products to be
+ * transmitted.
+ *
+ * This particular implementation accepts products through a ring of slots in
+ * a POSIX shared-memory segment that a co-located producer process fills.
+ * Delivered products are `MemoryProduct` views into the mapped segment, so
+ * ingestion costs no disk round trip and no consumer-side copy: a slot is
+ * marked free -- and may be reused by the producer -- only when the last copy
+ * of its product is destroyed.
+ *
+ * Copyright 2018 University Corporation for Atmospheric Research. All Rights
+ * reserved. See file "Copying" in the top-level source-directory for usage
+ * restrictions.
+ *
+ *        File: ShmIngester.cpp
+ *  Created on: Aug 29, 2018
+ *      Author: Steven R. Emmerson
+ */
+
+#include "config.h"
+
+#include "error.h"
+#include "ShmIngester.h"
+#include "Thread.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace hycast {
+
+/// Identifies a compatible segment. Incremented when the layout changes.
+static const uint64_t RING_MAGIC = 0x68796361737431; // "hycast1"
+
+/// States of a ring-slot
+enum SlotState : uint32_t {
+    SLOT_FREE = 0,  ///< May be claimed by the producer
+    SLOT_CLAIMED,   ///< Being filled by the producer
+    SLOT_FILLED     ///< Holds a product awaiting -- or held by -- the consumer
+};
+
+/**
+ * Header of a ring-slot. The product payload immediately follows, so the
+ * slot-stride is the cache-line-aligned sum of this header and the maximum
+ * product-size.
+ */
+struct SlotHeader
+{
+    uint32_t state;                        ///< `SlotState` guarded by the
+                                           ///< ring-header mutex
+    uint32_t size;                         ///< Product size in bytes
+    char     name[ProdName::prodNameMax + 1]; ///< NUL-terminated product name
+};
+
+/**
+ * Header of the shared-memory ring. Resides at the start of the segment; the
+ * slots follow at the first cache-line boundary. The mutex and
+ * condition-variable are process-shared: the producer signals when a slot is
+ * filled and the consumer signals when one is freed.
+ */
+struct RingHeader
+{
+    uint64_t        magic;       ///< `RING_MAGIC`
+    uint32_t        numSlots;    ///< Number of slots in the ring
+    uint32_t        maxProdSize; ///< Maximum product-size in bytes
+    uint64_t        slotStride;  ///< Distance between slots in bytes
+    pthread_mutex_t mutex;       ///< Guards the cursors and slot-states
+    pthread_cond_t  cond;        ///< Signaled on fill and on free
+    uint64_t        head;        ///< Index of next slot to claim (producer)
+    uint64_t        tail;        ///< Index of next slot to deliver (consumer)
+};
+
+/// Cache-line alignment of the slots and their payloads
+static const size_t ringAlign = 64;
+
+static inline size_t roundUp(const size_t nbytes)
+{
+    return (nbytes + ringAlign - 1) & ~(ringAlign - 1);
+}
+
+/**
+ * RAII lock on the process-shared mutex of a ring. Unlocks on destruction,
+ * including during the stack-unwinding of a thread-cancellation.
+ */
+class RingLock final
+{
+    pthread_mutex_t* mutex;
+public:
+    explicit RingLock(pthread_mutex_t& mutex)
+        : mutex{&mutex}
+    {
+        const auto status = ::pthread_mutex_lock(this->mutex);
+        if (status)
+            throw SYSTEM_ERROR("Couldn't lock shared-memory ring", status);
+    }
+    RingLock(const RingLock&) =delete;
+    RingLock& operator=(const RingLock&) =delete;
+    ~RingLock() noexcept
+    {
+        ::pthread_mutex_unlock(mutex);
+    }
+};
+
+/**
+ * A mapped shared-memory ring. Common to the producer and consumer endpoints.
+ */
+class Ring
+{
+protected:
+    const std::string name;    ///< Name of the shared-memory segment
+    size_t            mapSize; ///< Size of the mapping in bytes
+    RingHeader*       header;  ///< Ring header at the start of the mapping
+
+    Ring(const std::string& name)
+        : name{name}
+        , mapSize{0}
+        , header{nullptr}
+    {}
+
+    ~Ring() noexcept
+    {
+        if (header)
+            ::munmap(header, mapSize);
+    }
+
+    /**
+     * Returns the header of a slot.
+     * @param[in] cursor  Value of a ring-cursor (`head` or `tail`)
+     * @return            Header of the corresponding slot
+     */
+    inline SlotHeader* getSlot(const uint64_t cursor) const
+    {
+        return reinterpret_cast<SlotHeader*>(
+                reinterpret_cast<char*>(header) + roundUp(sizeof(RingHeader)) +
+                (cursor % header->numSlots)*header->slotStride);
+    }
+
+    /**
+     * Returns the payload of a slot.
+     * @param[in] slot  Header of the slot
+     * @return          Start of the slot's product payload
+     */
+    static inline char* getPayload(SlotHeader* const slot)
+    {
+        return reinterpret_cast<char*>(slot) + roundUp(sizeof(SlotHeader));
+    }
+};
+
+/******************************************************************************/
+
+class ShmProducer::Impl final : public Ring
+{
+    /**
+     * Initializes the ring header and slots.
+     * @param[in] numSlots     Number of slots
+     * @param[in] maxProdSize  Maximum product-size in bytes
+     * @throw SystemError      Couldn't initialize process-shared mutex or
+     *                         condition-variable
+     */
+    void init(
+            const unsigned numSlots,
+            const size_t   maxProdSize)
+    {
+        header->magic = RING_MAGIC;
+        header->numSlots = numSlots;
+        header->maxProdSize = maxProdSize;
+        header->slotStride = roundUp(sizeof(SlotHeader)) +
+                roundUp(maxProdSize);
+        header->head = 0;
+        header->tail = 0;
+        pthread_mutexattr_t mutexAttr;
+        ::pthread_mutexattr_init(&mutexAttr);
+        ::pthread_mutexattr_setpshared(&mutexAttr, PTHREAD_PROCESS_SHARED);
+        auto status = ::pthread_mutex_init(&header->mutex, &mutexAttr);
+        ::pthread_mutexattr_destroy(&mutexAttr);
+        if (status)
+            throw SYSTEM_ERROR("Couldn't initialize process-shared mutex",
+                    status);
+        pthread_condattr_t condAttr;
+        ::pthread_condattr_init(&condAttr);
+        ::pthread_condattr_setpshared(&condAttr, PTHREAD_PROCESS_SHARED);
+        status = ::pthread_cond_init(&header->cond, &condAttr);
+        ::pthread_condattr_destroy(&condAttr);
+        if (status)
+            throw SYSTEM_ERROR("Couldn't initialize process-shared "
+                    "condition-variable", status);
+        for (uint64_t i = 0; i < numSlots; ++i)
+            getSlot(i)->state = SLOT_FREE;
+    }
+
+public:
+    /**
+     * Constructs. Creates and initializes the shared-memory ring.
+     * @param[in] name         Name of the shared-memory segment
+     * @param[in] numSlots     Number of slots in the ring
+     * @param[in] maxProdSize  Maximum size of a data-product in bytes
+     * @throw InvalidArgument  `numSlots == 0 || maxProdSize == 0`
+     * @throw SystemError      `shm_open()`, `ftruncate()` or `mmap()` failure
+     */
+    Impl(   const std::string& name,
+            const unsigned     numSlots,
+            const size_t       maxProdSize)
+        : Ring{name}
+    {
+        if (numSlots == 0)
+            throw INVALID_ARGUMENT("Number of ring-slots can't be zero");
+        if (maxProdSize == 0)
+            throw INVALID_ARGUMENT("Maximum product-size can't be zero");
+        const auto fd = ::shm_open(name.data(), O_CREAT|O_EXCL|O_RDWR,
+                S_IRUSR|S_IWUSR);
+        if (fd == -1)
+            throw SYSTEM_ERROR(std::string{"shm_open() failure on \""} + name +
+                    "\"");
+        try {
+            mapSize = roundUp(sizeof(RingHeader)) +
+                    numSlots*(roundUp(sizeof(SlotHeader)) +
+                            roundUp(maxProdSize));
+            if (::ftruncate(fd, mapSize))
+                throw SYSTEM_ERROR(std::string{"ftruncate() failure on \""} +
+                        name + "\"");
+            auto ptr = ::mmap(nullptr, mapSize, PROT_READ|PROT_WRITE,
+                    MAP_SHARED, fd, 0);
+            if (ptr == MAP_FAILED)
+                throw SYSTEM_ERROR(std::string{"mmap() failure on \""} + name +
+                        "\"");
+            header = static_cast<RingHeader*>(ptr);
+            init(numSlots, maxProdSize);
+            ::close(fd);
+        }
+        catch (const std::exception& ex) {
+            ::close(fd);
+            ::shm_unlink(name.data());
+            throw;
+        }
+    }
+
+    ~Impl() noexcept
+    {
+        ::shm_unlink(name.data());
+    }
+
+    /**
+     * Publishes a data-product. Blocks until a slot is free. The payload is
+     * copied outside the lock, so a slow copy of a large product doesn't
+     * stall the consumer.
+     * @param[in] prodName     Name of the data-product
+     * @param[in] data         Product data
+     * @param[in] size         Size of the data in bytes
+     * @throw InvalidArgument  `size > maxProdSize` or `prodName` is too long
+     * @exceptionsafety        Basic guarantee
+     * @threadsafety           Safe
+     */
+    void send(
+            const std::string& prodName,
+            const char*        data,
+            const size_t       size)
+    {
+        if (size > header->maxProdSize)
+            throw INVALID_ARGUMENT("Product-size " + std::to_string(size) +
+                    " is greater than maximum " +
+                    std::to_string(header->maxProdSize));
+        if (prodName.length() > ProdName::prodNameMax)
+            throw INVALID_ARGUMENT("Product-name \"" + prodName +
+                    "\" is too long");
+        SlotHeader* slot;
+        {
+            RingLock lock{header->mutex};
+            while (getSlot(header->head)->state != SLOT_FREE) {
+                Canceler    canceler{};
+                const auto status = ::pthread_cond_wait(&header->cond,
+                        &header->mutex);
+                if (status)
+                    throw SYSTEM_ERROR("Couldn't wait on shared-memory ring",
+                            status);
+            }
+            slot = getSlot(header->head);
+            slot->state = SLOT_CLAIMED;
+            ++header->head;
+        }
+        slot->size = size;
+        ::strcpy(slot->name, prodName.data());
+        ::memcpy(getPayload(slot), data, size);
+        RingLock lock{header->mutex};
+        slot->state = SLOT_FILLED;
+        ::pthread_cond_broadcast(&header->cond);
+    }
+};
+
+ShmProducer::ShmProducer()
+    : pImpl{}
+{}
+
+ShmProducer::ShmProducer(
+        const std::string& name,
+        const unsigned     numSlots,
+        const size_t       maxProdSize)
+    : pImpl{new Impl{name, numSlots, maxProdSize}}
+{}
+
+void ShmProducer::send(
+        const std::string& prodName,
+        const char*        data,
+        const size_t       size)
+{
+    pImpl->send(prodName, data, size);
+}
+
+/******************************************************************************/
+
+class ShmIngester::Impl final : public Ring, public Ingester::Impl
+{
+    /// Index for the next data-product
+    ProdIndex prodIndex;
+    /// Becomes readable when the producer fills a slot. -1 until
+    /// `getPollFd()` is first called.
+    int       eventFd;
+    /// Waits on the ring's condition-variable and signals `eventFd`
+    Thread    waiter;
+
+    /**
+     * Marks a slot free and signals the producer. Called when the last copy
+     * of the slot's product is destroyed.
+     * @param[in] slot  Header of the slot
+     */
+    void releaseSlot(SlotHeader* const slot)
+    {
+        RingLock lock{header->mutex};
+        slot->state = SLOT_FREE;
+        ::pthread_cond_broadcast(&header->cond);
+    }
+
+    /**
+     * Waits on the ring's process-shared condition-variable and writes to
+     * the eventfd(2) whenever the slot at the tail is newly filled -- once
+     * per batch of fills, not once per slot. Executes on `waiter`.
+     */
+    void runWaiter()
+    {
+        try {
+            // No tail-cursor can equal this, so a pre-filled ring signals
+            uint64_t signaledTail = ~0ul;
+            for (;;) {
+                {
+                    RingLock lock{header->mutex};
+                    /*
+                     * A delivered slot stays `SLOT_FILLED` until its last
+                     * product-view is destroyed, so the state alone can't
+                     * distinguish a new fill from a stale slot after the
+                     * tail wraps a lap: only a slot the producer has claimed
+                     * (`tail != head`) and finished filling is a product.
+                     */
+                    while (header->tail == header->head ||
+                            getSlot(header->tail)->state != SLOT_FILLED ||
+                            header->tail == signaledTail) {
+                        Canceler   canceler{};
+                        const auto status = ::pthread_cond_wait(&header->cond,
+                                &header->mutex);
+                        if (status)
+                            throw SYSTEM_ERROR("Couldn't wait on shared-memory "
+                                    "ring", status);
+                    }
+                    signaledTail = header->tail;
+                }
+                const uint64_t one = 1;
+                if (::write(eventFd, &one, sizeof(one)) == -1 &&
+                        errno != EAGAIN)
+                    throw SYSTEM_ERROR("write() failure on ring eventfd");
+            }
+        }
+        catch (const std::exception& ex) {
+            log_error(ex);
+        }
+    }
+
+public:
+    /**
+     * Constructs. Attaches to an existing shared-memory ring.
+     * @param[in] name      Name of the shared-memory segment
+     * @throw SystemError   `shm_open()`, `fstat()` or `mmap()` failure
+     * @throw RuntimeError  The segment isn't a compatible ring
+     */
+    Impl(const std::string& name)
+        : Ring{name}
+        , prodIndex{0}
+        , eventFd{-1}
+        , waiter{}
+    {
+        const auto fd = ::shm_open(name.data(), O_RDWR, 0);
+        if (fd == -1)
+            throw SYSTEM_ERROR(std::string{"shm_open() failure on \""} + name +
+                    "\"");
+        try {
+            struct stat statBuf;
+            if (::fstat(fd, &statBuf))
+                throw SYSTEM_ERROR(std::string{"fstat() failure on \""} + name
+                        + "\"");
+            mapSize = statBuf.st_size;
+            if (mapSize < sizeof(RingHeader))
+                throw RUNTIME_ERROR("Shared-memory segment \"" + name +
+                        "\" is too small to be a ring");
+            auto ptr = ::mmap(nullptr, mapSize, PROT_READ|PROT_WRITE,
+                    MAP_SHARED, fd, 0);
+            if (ptr == MAP_FAILED)
+                throw SYSTEM_ERROR(std::string{"mmap() failure on \""} + name +
+                        "\"");
+            header = static_cast<RingHeader*>(ptr);
+            if (header->magic != RING_MAGIC)
+                throw RUNTIME_ERROR("Shared-memory segment \"" + name +
+                        "\" isn't a compatible ring");
+            ::close(fd);
+        }
+        catch (const std::exception& ex) {
+            ::close(fd);
+            throw;
+        }
+    }
+
+    ~Impl() noexcept
+    {
+        if (eventFd >= 0) {
+            waiter = Thread{}; // Cancels and joins the waiter-thread
+            ::close(eventFd);
+        }
+    }
+
+    /**
+     * Returns a file-descriptor that becomes readable when the producer
+     * fills a slot. The ring synchronizes with a process-shared
+     * condition-variable, which isn't pollable, so the first call creates an
+     * eventfd(2) plus an internal thread that waits on the
+     * condition-variable and signals the eventfd on each fill.
+     * @return             The file-descriptor
+     * @throw SystemError  `eventfd()` failure
+     * @see IngesterMux
+     */
+    int getPollFd()
+    {
+        if (eventFd < 0) {
+            eventFd = ::eventfd(0, EFD_CLOEXEC|EFD_NONBLOCK);
+            if (eventFd == -1)
+                throw SYSTEM_ERROR("eventfd() failure");
+            waiter = Thread{[this]{runWaiter();}};
+        }
+        return eventFd;
+    }
+
+    /**
+     * Returns the next data-product if a slot is filled, without blocking.
+     * @param[out] prod  Next data-product
+     * @retval `true`    A product was delivered
+     * @retval `false`   No slot is filled
+     * @see IngesterMux
+     */
+    bool tryGetProduct(Product& prod)
+    {
+        if (eventFd >= 0) {
+            uint64_t count;
+            while (::read(eventFd, &count, sizeof(count)) > 0)
+                ;
+        }
+        SlotHeader* slot;
+        {
+            RingLock lock{header->mutex};
+            // See `runWaiter()`: the cursors distinguish a new fill from a
+            // stale still-FILLED slot after the tail wraps a lap
+            if (header->tail == header->head ||
+                    getSlot(header->tail)->state != SLOT_FILLED)
+                return false;
+            slot = getSlot(header->tail);
+            ++header->tail;
+        }
+        prod = MemoryProduct{prodIndex, ProdName{slot->name}, slot->size,
+                getPayload(slot), [this,slot]{releaseSlot(slot);}};
+        ++prodIndex;
+        return true;
+    }
+
+    /**
+     * Returns the next data-product: a zero-copy view into the slot that the
+     * producer filled. Blocks until a slot is filled. This is a cancellation
+     * point.
+     * @return            Next data-product
+     * @throw SystemError Couldn't wait on the ring
+     */
+    Product getProduct()
+    {
+        SlotHeader* slot;
+        {
+            RingLock lock{header->mutex};
+            // See `runWaiter()`: the cursors distinguish a new fill from a
+            // stale still-FILLED slot after the tail wraps a lap
+            while (header->tail == header->head ||
+                    getSlot(header->tail)->state != SLOT_FILLED) {
+                Canceler   canceler{};
+                const auto status = ::pthread_cond_wait(&header->cond,
+                        &header->mutex);
+                if (status)
+                    throw SYSTEM_ERROR("Couldn't wait on shared-memory ring",
+                            status);
+            }
+            slot = getSlot(header->tail);
+            ++header->tail;
+        }
+        Product prod = MemoryProduct{prodIndex, ProdName{slot->name},
+                slot->size, getPayload(slot),
+                [this,slot]{releaseSlot(slot);}};
+        ++prodIndex;
+        return prod;
+    }
+}; // ShmIngester::Impl
+
+ShmIngester::ShmIngester()
+    : Ingester{}
+{}
+
+ShmIngester::ShmIngester(const std::string& name)
+    : Ingester{new Impl{name}}
+{}
+
+} // namespace
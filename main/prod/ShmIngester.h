@@ -0,0 +1,94 @@
+/**
+ * This file declares a shared-memory ingester of data-products. One that
+ * accepts products through a shared-memory ring from a co-located producer
+ * process and delivers them as zero-copy views into the ring -- no disk
+ * round trip.
+ *
+ * Copyright 2018 University Corporation for Atmospheric Research. All Rights
+ * reserved. See file "Copying" in the top-level source-directory for usage
+ * restrictions.
+ *
+ *        File: ShmIngester.h
+ *  Created on: Aug 29, 2018
+ *      Author: Steven R. Emmerson
+ */
+
+#ifndef MAIN_PROD_SHMINGESTER_H_
+#define MAIN_PROD_SHMINGESTER_H_
+
+#include "Ingester.h"
+
+#include <string>
+
+namespace hycast {
+
+/**
+ * Producer-side endpoint of the shared-memory ring. A co-located producer
+ * process constructs one -- which creates and initializes the ring -- and
+ * publishes its products into it. The segment is unlinked on destruction.
+ */
+class ShmProducer final
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    ShmProducer();
+
+    /**
+     * Constructs. Creates and initializes the shared-memory ring.
+     * @param[in] name         Name of the shared-memory segment (see
+     *                         shm_open(3))
+     * @param[in] numSlots     Number of slots in the ring
+     * @param[in] maxProdSize  Maximum size of a data-product in bytes
+     * @throw InvalidArgument  `numSlots == 0 || maxProdSize == 0`
+     * @throw SystemError      `shm_open()`, `ftruncate()` or `mmap()` failure
+     */
+    ShmProducer(
+            const std::string& name,
+            const unsigned     numSlots,
+            const size_t       maxProdSize);
+
+    /**
+     * Publishes a data-product. Blocks until a slot is free. This is a
+     * cancellation point.
+     * @param[in] prodName     Name of the data-product
+     * @param[in] data         Product data. Copied into the ring.
+     * @param[in] size         Size of the data in bytes
+     * @throw InvalidArgument  `size` is greater than the maximum product-size
+     *                         or `prodName` is too long
+     * @exceptionsafety        Basic guarantee
+     * @threadsafety           Safe
+     */
+    void send(
+            const std::string& prodName,
+            const char*        data,
+            const size_t       size);
+};
+
+/**
+ * Consumer-side endpoint of the shared-memory ring. Delivered products are
+ * zero-copy views into the ring: a product's slot is reused only after the
+ * last copy of the product is destroyed, and every product must be destroyed
+ * before this instance is.
+ */
+class ShmIngester final : public Ingester
+{
+    class Impl;
+
+public:
+    ShmIngester();
+
+    /**
+     * Constructs. Attaches to an existing shared-memory ring.
+     * @param[in] name      Name of the shared-memory segment (see
+     *                      shm_open(3))
+     * @throw SystemError   `shm_open()`, `fstat()` or `mmap()` failure
+     * @throw RuntimeError  The segment isn't a compatible ring
+     */
+    explicit ShmIngester(const std::string& name);
+};
+
+} // namespace
+
+#endif /* MAIN_PROD_SHMINGESTER_H_ */
@@ -0,0 +1,164 @@
+/**
+ * This file tests class `DurableTxQueue`.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See file "COPYING" in the top-level source-directory for usage
+ * restrictions.
+ *
+ *       File: DurableTxQueue_test.cpp
+ *     Author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "DurableTxQueue.h"
+#include "Product.h"
+
+#include <cstring>
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+/// The fixture for testing class `DurableTxQueue`
+class DurableTxQueueTest : public ::testing::Test
+{
+protected:
+    const std::string pathname;
+    const size_t      capacity;
+    char              data[10000];
+
+    DurableTxQueueTest()
+        : pathname{"/tmp/DurableTxQueue_test.ring"}
+        , capacity{65536}
+    {
+        ::unlink(pathname.c_str());
+        for (size_t i = 0; i < sizeof(data); ++i)
+            data[i] = static_cast<char>(i);
+    }
+
+    ~DurableTxQueueTest()
+    {
+        ::unlink(pathname.c_str());
+    }
+
+    hycast::Product makeProduct(
+            const hycast::ProdIndex::type index,
+            const hycast::ProdSize::type  size)
+    {
+        return hycast::MemoryProduct{hycast::ProdIndex{index},
+                "product" + std::to_string(index), size, data};
+    }
+};
+
+// Tests default construction
+TEST_F(DurableTxQueueTest, DefaultConstruction)
+{
+    hycast::DurableTxQueue queue{};
+    EXPECT_FALSE(queue);
+}
+
+// Tests invalid construction
+TEST_F(DurableTxQueueTest, InvalidConstruction)
+{
+    EXPECT_THROW(hycast::DurableTxQueue(pathname, 1),
+            std::invalid_argument);
+}
+
+// Tests recording and acknowledging a product
+TEST_F(DurableTxQueueTest, PutAndDone)
+{
+    hycast::DurableTxQueue queue{pathname, capacity};
+    EXPECT_TRUE(queue);
+    EXPECT_EQ(0, queue.size());
+
+    auto     prod = makeProduct(1, 1000);
+    uint64_t id;
+    EXPECT_TRUE(queue.put(prod, id));
+    EXPECT_EQ(1, queue.size());
+
+    queue.done(id);
+    EXPECT_EQ(0, queue.size());
+}
+
+// Tests that a full ring rejects a product
+TEST_F(DurableTxQueueTest, FullRing)
+{
+    hycast::DurableTxQueue queue{pathname, capacity};
+
+    uint64_t id;
+    unsigned count = 0;
+    for (;;) {
+        auto prod = makeProduct(count, sizeof(data));
+        if (!queue.put(prod, id))
+            break;
+        ++count;
+    }
+    EXPECT_GT(count, 0);
+    EXPECT_EQ(count, queue.size());
+}
+
+// Tests that unacknowledged products survive reopening and replay in order
+TEST_F(DurableTxQueueTest, Replay)
+{
+    uint64_t id1, id2, id3;
+    {
+        hycast::DurableTxQueue queue{pathname, capacity};
+        auto prod1 = makeProduct(1, 1000);
+        auto prod2 = makeProduct(2, 2000);
+        auto prod3 = makeProduct(3, 3000);
+        EXPECT_TRUE(queue.put(prod1, id1));
+        EXPECT_TRUE(queue.put(prod2, id2));
+        EXPECT_TRUE(queue.put(prod3, id3));
+        queue.done(id2); // Out-of-order acknowledgment
+    } // "Crash" with products 1 and 3 untransmitted
+
+    hycast::DurableTxQueue queue{pathname, capacity};
+    EXPECT_EQ(2, queue.size());
+
+    std::vector<hycast::Product> replayed{};
+    queue.replay([&queue,&replayed](const uint64_t id,
+            hycast::Product& prod) {
+        replayed.push_back(prod);
+        queue.done(id);
+    });
+    ASSERT_EQ(2, replayed.size());
+    EXPECT_EQ(0, queue.size());
+
+    auto info = replayed[0].getInfo();
+    EXPECT_EQ(hycast::ProdIndex{1}, info.getIndex());
+    EXPECT_STREQ("product1", info.getName().c_str());
+    EXPECT_EQ(1000, info.getSize());
+    EXPECT_EQ(0, ::memcmp(data, replayed[0].getDataSpan().getData(), 1000));
+
+    info = replayed[1].getInfo();
+    EXPECT_EQ(hycast::ProdIndex{3}, info.getIndex());
+    EXPECT_EQ(3000, info.getSize());
+
+    // New products can be recorded after the replay
+    auto prod = makeProduct(4, 1000);
+    uint64_t id;
+    EXPECT_TRUE(queue.put(prod, id));
+    queue.done(id);
+}
+
+// Tests that the ring wraps: more bytes pass through than the ring holds
+TEST_F(DurableTxQueueTest, Wrap)
+{
+    hycast::DurableTxQueue queue{pathname, capacity};
+
+    for (unsigned i = 0; i < 100; ++i) {
+        auto     prod = makeProduct(i, sizeof(data));
+        uint64_t id;
+        ASSERT_TRUE(queue.put(prod, id));
+        queue.done(id);
+    }
+    EXPECT_EQ(0, queue.size());
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,120 @@
+/**
+ * This file tests class `FileWriting`.
+ *
+ * Copyright 2018 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: FileWriting_test.cpp
+ * @author: Steven R. Emmerson
+ */
+
+#include "error.h"
+#include "FileWriting.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// The fixture for testing class FileWriting.
+class FileWritingTest : public ::testing::Test {
+protected:
+    FileWritingTest()
+    {
+        ::system(("rm -rf " + rootDirPathname).data());
+        ::mkdir(rootDirPathname.data(), S_IRWXU);
+        for (size_t i = 0; i < sizeof(data); ++i)
+            data[i] = static_cast<char>(i);
+    }
+
+    virtual void TearDown()
+    {
+        ::system(("rm -rf " + rootDirPathname).data());
+    }
+
+    hycast::Product makeProd(
+            const hycast::ProdIndex prodIndex,
+            const std::string&      name,
+            const size_t            size)
+    {
+        return hycast::MemoryProduct{prodIndex, name,
+                hycast::ProdSize{static_cast<hycast::ProdSize::type>(size)},
+                data};
+    }
+
+    void expectFile(
+            const std::string& name,
+            const size_t       size)
+    {
+        const auto  pathname = rootDirPathname + "/" + name;
+        struct stat statBuf;
+        ASSERT_EQ(0, ::stat(pathname.data(), &statBuf));
+        EXPECT_EQ(size, statBuf.st_size);
+        char buf[8192];
+        const auto fd = ::open(pathname.data(), O_RDONLY);
+        ASSERT_NE(-1, fd);
+        EXPECT_EQ(size, ::read(fd, buf, sizeof(buf)));
+        EXPECT_EQ(0, ::memcmp(data, buf, size));
+        ::close(fd);
+    }
+
+    const std::string rootDirPathname{"/tmp/FileWriting_test"};
+    char              data[8192];
+};
+
+// Tests invalid construction
+TEST_F(FileWritingTest, InvalidConstruction) {
+    EXPECT_THROW(hycast::FileWriting(rootDirPathname, 0),
+            hycast::InvalidArgument);
+}
+
+// Tests that queued products -- including ones in nested directories -- are
+// completely written by destruction and that the completion observer is
+// called for each
+TEST_F(FileWritingTest, WriteBehind) {
+    const size_t             numProds = 20;
+    std::atomic<size_t>      numCompleted{0};
+    {
+        hycast::FileWriting writing{rootDirPathname, 2};
+        writing.setCompletionObserver(
+                [&numCompleted](const hycast::ProdInfo& prodInfo,
+                        const std::string& pathname) {
+            ++numCompleted;
+        });
+        for (size_t i = 0; i < numProds; ++i) {
+            auto prod = makeProd(i, "subdir/prod" + std::to_string(i),
+                    1000 + i);
+            writing.process(prod);
+        }
+    } // Destruction drains the queue
+    EXPECT_EQ(numProds, numCompleted);
+    for (size_t i = 0; i < numProds; ++i)
+        expectFile("subdir/prod" + std::to_string(i), 1000 + i);
+}
+
+// Tests that the dirty backlog is bounded
+TEST_F(FileWritingTest, BoundedBacklog) {
+    const size_t        maxBacklog = 4000;
+    hycast::FileWriting writing{rootDirPathname, 1, maxBacklog};
+    for (size_t i = 0; i < 20; ++i) {
+        auto prod = makeProd(i, "prod" + std::to_string(i), 1000);
+        writing.process(prod); // Blocks while the backlog is full
+        EXPECT_GE(maxBacklog, writing.getBacklog());
+    }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,128 @@
+/**
+ * This file tests class `ParallelProcessing`.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: ParallelProcessing_test.cpp
+ * @author: Steven R. Emmerson
+ */
+
+#include "ParallelProcessing.h"
+
+#include <atomic>
+#include <gtest/gtest.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+/**
+ * Downstream processor that records, per product-name, the sizes of the
+ * data-products in the order in which they were processed. The size of a
+ * data-product serves as its sequence number.
+ */
+class OrderRecorder final : public hycast::Processing
+{
+    std::mutex mutex;
+
+public:
+    std::map<std::string, std::vector<size_t>> order;
+    std::atomic<size_t>                        count;
+
+    OrderRecorder()
+        : mutex{}
+        , order{}
+        , count{0}
+    {}
+
+    void process(hycast::Product prod)
+    {
+        ::usleep(1000);
+        std::lock_guard<std::mutex> lock{mutex};
+        order[prod.getInfo().getName().to_string()].push_back(
+                prod.getInfo().getSize());
+        ++count;
+    }
+};
+
+// The fixture for testing class ParallelProcessing.
+class ParallelProcessingTest : public ::testing::Test {
+protected:
+    hycast::Product makeProd(
+            const hycast::ProdIndex prodIndex,
+            const std::string&      name,
+            const size_t            size)
+    {
+        return hycast::MemoryProduct{prodIndex, name,
+                hycast::ProdSize{static_cast<hycast::ProdSize::type>(size)},
+                data};
+    }
+
+    char data[8192];
+};
+
+// Tests construction
+TEST_F(ParallelProcessingTest, Construction) {
+    OrderRecorder              recorder{};
+    hycast::ParallelProcessing processing{recorder};
+    EXPECT_EQ(0, processing.getOutstanding());
+}
+
+// Tests invalid queue capacity
+TEST_F(ParallelProcessingTest, ZeroQueueCapacity) {
+    OrderRecorder recorder{};
+    EXPECT_THROW(hycast::ParallelProcessing(recorder, 2, 0),
+            hycast::InvalidArgument);
+}
+
+// Tests that every submitted product is processed and that same-named
+// products are processed in submission order
+TEST_F(ParallelProcessingTest, OrderedProcessing) {
+    const size_t  numNames = 4;
+    const size_t  numPerName = 25;
+    OrderRecorder recorder{};
+    {
+        hycast::ParallelProcessing processing{recorder, 4, 8};
+        hycast::ProdIndex          prodIndex{0};
+        for (size_t i = 0; i < numPerName; ++i) {
+            for (size_t j = 0; j < numNames; ++j) {
+                processing.process(makeProd(prodIndex,
+                        "product" + std::to_string(j), i + 1));
+                ++prodIndex;
+            }
+        }
+    } // Destruction drains the queues
+    EXPECT_EQ(numNames*numPerName, recorder.count.load());
+    for (size_t j = 0; j < numNames; ++j) {
+        auto& sizes = recorder.order["product" + std::to_string(j)];
+        ASSERT_EQ(numPerName, sizes.size());
+        for (size_t i = 0; i < numPerName; ++i)
+            EXPECT_EQ(i + 1, sizes[i]);
+    }
+}
+
+// Tests unordered processing
+TEST_F(ParallelProcessingTest, UnorderedProcessing) {
+    const size_t  numProds = 50;
+    OrderRecorder recorder{};
+    {
+        hycast::ParallelProcessing processing{recorder, 4, 8, false};
+        for (size_t i = 0; i < numProds; ++i)
+            processing.process(makeProd(hycast::ProdIndex{
+                    static_cast<hycast::ProdIndex::type>(i)},
+                    "product" + std::to_string(i), i + 1));
+    }
+    EXPECT_EQ(numProds, recorder.count.load());
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,83 @@
+/**
+ * This file tests class `PerfMeter`.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All Rights
+ * reserved. See file "Copying" in the top-level source-directory for usage
+ * restrictions.
+ *
+ *        File: PerfMeter_test.cpp
+ *  Created on: Aug 29, 2017
+ *      Author: Steven R. Emmerson
+ */
+
+#include "PerfMeter.h"
+
+#include <chrono>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <thread>
+
+namespace {
+
+// The fixture for testing class PerfMeter.
+class PerfMeterTest : public ::testing::Test {
+protected:
+    const hycast::ProdInfo prodInfo{1, "product", 2000, 1000};
+    hycast::PerfMeter      perfMeter{};
+};
+
+// Tests counting products
+TEST_F(PerfMeterTest, ProductCounting) {
+    EXPECT_EQ(0, perfMeter.getProdCount());
+    perfMeter.product(prodInfo);
+    EXPECT_EQ(1, perfMeter.getProdCount());
+}
+
+// Tests per-transport chunk and byte counters
+TEST_F(PerfMeterTest, TransportCounters) {
+    const hycast::ChunkId chunkId{prodInfo, 0};
+    perfMeter.chunk(chunkId, 1000, hycast::PerfMeter::MCAST);
+    perfMeter.chunk(chunkId, 1000, hycast::PerfMeter::MCAST);
+    perfMeter.chunk(chunkId, 1000, hycast::PerfMeter::P2P);
+    EXPECT_EQ(2, perfMeter.getChunkCount(hycast::PerfMeter::MCAST));
+    EXPECT_EQ(2000, perfMeter.getByteCount(hycast::PerfMeter::MCAST));
+    EXPECT_EQ(1, perfMeter.getChunkCount(hycast::PerfMeter::P2P));
+    EXPECT_EQ(1000, perfMeter.getByteCount(hycast::PerfMeter::P2P));
+}
+
+// Tests the product completion-latency histogram
+TEST_F(PerfMeterTest, CompletionLatency) {
+    EXPECT_TRUE(std::isnan(perfMeter.getLatencyQuantile(0.99)));
+    const hycast::ChunkId chunkId{prodInfo, 0};
+    perfMeter.chunk(chunkId, 1000, hycast::PerfMeter::MCAST);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    perfMeter.product(prodInfo);
+    const auto median = perfMeter.getLatencyQuantile(0.5);
+    EXPECT_GE(median, 0.09);
+    EXPECT_LE(median, 1.0);
+    // One sample => every quantile is that sample's bucket
+    EXPECT_EQ(median, perfMeter.getLatencyQuantile(0.99));
+    EXPECT_THROW(perfMeter.getLatencyQuantile(1.5),
+            hycast::InvalidArgument);
+}
+
+// Tests the one-way, origin-to-completion latency histogram
+TEST_F(PerfMeterTest, OriginLatency) {
+    EXPECT_TRUE(std::isnan(perfMeter.getOriginLatencyQuantile(0.99)));
+    perfMeter.product(prodInfo); // No origin timestamp => nothing recorded
+    EXPECT_TRUE(std::isnan(perfMeter.getOriginLatencyQuantile(0.99)));
+    prodInfo.setOriginTime(hycast::ProdInfo::now() - 100000); // 100 ms ago
+    perfMeter.product(prodInfo);
+    const auto median = perfMeter.getOriginLatencyQuantile(0.5);
+    EXPECT_GE(median, 0.09);
+    EXPECT_LE(median, 1.0);
+    EXPECT_THROW(perfMeter.getOriginLatencyQuantile(-0.5),
+            hycast::InvalidArgument);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
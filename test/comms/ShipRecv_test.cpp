@@ -21,21 +21,61 @@
 #include "YamlPeerSource.h"
 
 #include <gtest/gtest.h>
+#include <chrono>
+#include <cstdlib>
 #include <mutex>
+#include <sys/resource.h>
 
 namespace {
 
+/**
+ * Returns the value of an environment variable as an unsigned integer or a
+ * default if the variable isn't set.
+ * @param[in] name  Name of environment variable
+ * @param[in] dflt  Default value
+ * @return          Value of environment variable or default
+ */
+unsigned long envULong(
+        const char*         name,
+        const unsigned long dflt)
+{
+    const char* value = ::getenv(name);
+    return value ? ::strtoul(value, nullptr, 10) : dflt;
+}
+
+/**
+ * Returns the value of an environment variable as a double or a default if
+ * the variable isn't set.
+ * @param[in] name  Name of environment variable
+ * @param[in] dflt  Default value
+ * @return          Value of environment variable or default
+ */
+double envDouble(
+        const char*  name,
+        const double dflt)
+{
+    const char* value = ::getenv(name);
+    return value ? ::strtod(value, nullptr) : dflt;
+}
+
+/**
+ * Returns the CPU time (user plus system) this process has consumed.
+ * @return CPU time in seconds
+ */
+double cpuSeconds()
+{
+    struct rusage usage;
+    ::getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec*1e-6 +
+            usage.ru_stime.tv_sec + usage.ru_stime.tv_usec*1e-6;
+}
+
 // The fixture for testing classes Shipping and Receiving.
 class ShipRecvTest : public ::testing::Test, public hycast::Processing
 {
 protected:
     void process(hycast::Product prod)
     {
-        // Parentheses must be used in the following statement
-        static std::vector<bool>    rcvdProdIndexes(NUM_PRODUCTS, false);
-        static std::mutex           mutex;
-        static unsigned long        rcvdUniqueProds = 0;
-        static int                  seqIndex{0};
         std::lock_guard<std::mutex> lock{mutex};
         auto                        info = prod.getInfo();
         size_t                      prodIndex =
@@ -46,12 +86,23 @@ protected:
             throw hycast::LOGIC_ERROR("Duplicate product: index=" +
                     std::to_string(prodIndex));
         rcvdProdIndexes[prodIndex] = true;
-        if (++rcvdUniqueProds == NUM_PRODUCTS)
+        if (++rcvdUniqueProds == rcvdProdIndexes.size())
             cue.cue();
     }
 
+    /**
+     * Sets the number of products whose reception cues the main thread.
+     * Must be called before products flow.
+     * @param[in] numProds  Number of expected products
+     */
+    void expectProducts(const size_t numProds)
+    {
+        rcvdProdIndexes = std::vector<bool>(numProds, false);
+    }
+
     ShipRecvTest()
     {
+        expectProducts(NUM_PRODUCTS);
         // gcc 4.8 doesn't support non-trivial designated initializers
         srcMcastInfo.mcastAddr = mcastAddr;
         srcMcastInfo.srcAddr = localInetAddr;
@@ -87,6 +138,67 @@ protected:
     hycast::SrcMcastInfo       srcMcastInfo;
     hycast::PerfMeter          perfMeter{};
     hycast::Cue                cue{};
+    std::mutex                 mutex{};
+    std::vector<bool>          rcvdProdIndexes{};
+    unsigned long              rcvdUniqueProds{0};
+    int                        seqIndex{0};
+};
+
+/**
+ * Streaming consumer: records the contiguous-prefix extents it's handed and
+ * verifies the prefix bytes against the expected product data.
+ */
+class PrefixConsumer final : public hycast::Processing
+{
+    std::mutex  mutex;
+    const char* expect;
+
+public:
+    unsigned long numPrefixCalls;
+    size_t        maxExtent;
+    unsigned long prefixErrors;
+    bool          gotWhole;
+    hycast::Cue   done;
+
+    explicit PrefixConsumer(const char* expect)
+        : mutex{}
+        , expect{expect}
+        , numPrefixCalls{0}
+        , maxExtent{0}
+        , prefixErrors{0}
+        , gotWhole{false}
+        , done{}
+    {}
+
+    bool processesPrefixes() const noexcept override
+    {
+        return true;
+    }
+
+    void processPrefix(
+            const hycast::ProdInfo& prodInfo,
+            const char*             data,
+            const hycast::ProdSize  extent) override
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        ++numPrefixCalls;
+        const size_t size = static_cast<hycast::ProdSize::type>(extent);
+        if (size > maxExtent) {
+            if (::memcmp(data, expect, size))
+                ++prefixErrors;
+            maxExtent = size;
+        }
+    }
+
+    void process(hycast::Product prod) override
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            gotWhole = prod.isComplete() && 0 == ::memcmp(prod.getData(),
+                    expect, prod.getInfo().getSize());
+        }
+        done.cue();
+    }
 };
 
 // Tests shipping construction
@@ -94,6 +206,74 @@ TEST_F(ShipRecvTest, ShippingConstruction) {
     hycast::Shipping(prodStore, mcastAddr, protoVers, srcSrvrAddr);
 }
 
+// Tests that content-hash dedup suppresses a recently-shipped identical
+// payload but not a distinct one
+TEST_F(ShipRecvTest, DedupSuppression) {
+    hycast::Shipping shipping{prodStore, mcastAddr, protoVers, srcSrvrAddr};
+    shipping.enableDedup();
+    hycast::MemoryProduct prod1{hycast::ProdIndex{0}, "product 0",
+            sizeof(data), data};
+    shipping.ship(prod1);
+    EXPECT_EQ(1, prodStore.size());
+    // Identical payload under a new name: suppressed
+    hycast::MemoryProduct prod2{hycast::ProdIndex{1}, "renamed product",
+            sizeof(data), data};
+    shipping.ship(prod2);
+    EXPECT_EQ(1, prodStore.size());
+    // Distinct payload: shipped
+    char other[1000];
+    for (size_t i = 0; i < sizeof(other); ++i)
+        other[i] = ~data[i];
+    hycast::MemoryProduct prod3{hycast::ProdIndex{2}, "distinct product",
+            sizeof(other), other};
+    shipping.ship(prod3);
+    EXPECT_EQ(2, prodStore.size());
+}
+
+// Tests the layered essential feed: shipping proceeds with the layer
+// enabled, large products are announced-only while small ones are carried
+// in full, and a second enable is rejected
+TEST_F(ShipRecvTest, EssentialLayer) {
+    const hycast::InetSockAddr essAddr{"232.0.0.1", srcPort};
+    hycast::Shipping shipping{prodStore, mcastAddr, protoVers, srcSrvrAddr};
+    shipping.enableEssentialLayer(essAddr, 1000, 1);
+    // Above the size cap and at default priority: announcement only
+    hycast::MemoryProduct big{hycast::ProdIndex{0}, "big product",
+            sizeof(data), data};
+    shipping.ship(big);
+    // Within the size cap: carried in full
+    hycast::MemoryProduct small{hycast::ProdIndex{1}, "small product", 1000,
+            data};
+    shipping.ship(small);
+    // Above the size cap but at an essential priority: carried in full
+    hycast::MemoryProduct urgent{hycast::ProdInfo{2, "urgent product",
+            sizeof(data), hycast::ChunkSize::defaultSize, 1}, data};
+    shipping.ship(urgent);
+    EXPECT_EQ(3, prodStore.size());
+    EXPECT_THROW(shipping.enableEssentialLayer(essAddr, 1000, 1),
+            hycast::LogicError);
+}
+
+// Tests incremental delivery of contiguous prefixes to a streaming consumer
+TEST_F(ShipRecvTest, StreamingPrefixDelivery) {
+    PrefixConsumer    consumer{data};
+    hycast::Shipping  shipping{prodStore, mcastAddr, protoVers, srcSrvrAddr,
+            maxPeers, stasisDuration};
+    hycast::Receiving receiving{srcMcastInfo, p2pInfo, consumer, protoVers};
+
+    ::sleep(1);
+
+    hycast::MemoryProduct prod{prodIndex, "streamed product", sizeof(data),
+            data};
+    shipping.ship(prod);
+    consumer.done.wait();
+    EXPECT_TRUE(consumer.gotWhole);
+    // Leading extents were delivered before the product completed
+    EXPECT_GE(consumer.numPrefixCalls, 1);
+    EXPECT_EQ(0, consumer.prefixErrors);
+    EXPECT_LE(consumer.maxExtent, sizeof(data));
+}
+
 // Tests receiving construction
 TEST_F(ShipRecvTest, ReceivingConstruction) {
     hycast::Receiving{srcMcastInfo, p2pInfo, *this, protoVers};
@@ -126,6 +306,84 @@ TEST_F(ShipRecvTest, ShippingAndReceiving) {
     hycast::logLevel = logLevelOnEntry;
 }
 
+/*
+ * End-to-end loopback performance harness. Intended to be run by itself,
+ * e.g.,
+ *     ShipRecv_test --gtest_filter='*Performance'
+ * The workload is configurable via environment variables:
+ *     HYCAST_PERF_PROD_COUNT  Number of products (default 100)
+ *     HYCAST_PERF_PROD_SIZE   Size of each product in bytes (default 100000)
+ *     HYCAST_PERF_CHUNK_SIZE  Canonical chunk size in bytes (default
+ *                             ChunkSize::defaultSize)
+ *     HYCAST_PERF_DROP        Proportion of multicast traffic synthetically
+ *                             dropped, which forces recovery over the P2P
+ *                             path (default 0.2)
+ * Results are written to standard output as a single machine-readable line
+ * of key=value pairs: throughput, per-transport chunk and byte counts,
+ * product completion-latency percentiles, and CPU time per byte.
+ */
+TEST_F(ShipRecvTest, Performance) {
+    const unsigned long numProds =
+            envULong("HYCAST_PERF_PROD_COUNT", NUM_PRODUCTS);
+    const unsigned long prodSize =
+            envULong("HYCAST_PERF_PROD_SIZE", sizeof(data));
+    const hycast::ChunkSize chunkSize{static_cast<hycast::ChunkSize::type>(
+            envULong("HYCAST_PERF_CHUNK_SIZE",
+                    hycast::ChunkSize::defaultSize))};
+    const double dropRate = envDouble("HYCAST_PERF_DROP", drop);
+
+    auto logLevelOnEntry = hycast::logLevel;
+    hycast::logLevel = hycast::LOG_NOTE;
+    expectProducts(numProds);
+    std::vector<char> prodData(prodSize);
+    for (size_t i = 0; i < prodSize; ++i)
+        prodData[i] = i % UCHAR_MAX;
+
+    hycast::Shipping  shipping{prodStore, mcastAddr, protoVers, srcSrvrAddr,
+            maxPeers, stasisDuration};
+    hycast::Receiving receiving{srcMcastInfo, p2pInfo, *this, protoVers, "",
+            dropRate};
+    receiving.setPerfMeter(perfMeter);
+
+    ::sleep(1);
+
+    const double cpuStart = cpuSeconds();
+    const auto   clockStart = std::chrono::steady_clock::now();
+    for (hycast::ProdIndex i = 0; numProds > static_cast<uint64_t>(i); ++i) {
+        std::string name = std::string{"product " } + std::to_string(i);
+        hycast::MemoryProduct prod{i,  name,
+                static_cast<hycast::ProdSize::type>(prodSize),
+                prodData.data(), chunkSize};
+        shipping.ship(prod);
+    }
+    cue.wait();
+    const double seconds = std::chrono::duration_cast<
+            std::chrono::duration<double>>(
+            std::chrono::steady_clock::now() - clockStart).count();
+    const double cpu = cpuSeconds() - cpuStart;
+    perfMeter.stop();
+
+    const double totalBytes = static_cast<double>(numProds)*prodSize;
+    std::cout << "perf:"
+            << " prodCount=" << numProds
+            << " prodSize=" << prodSize
+            << " chunkSize=" << static_cast<unsigned>(chunkSize)
+            << " drop=" << dropRate
+            << " seconds=" << seconds
+            << " bytesPerSec=" << (seconds > 0 ? totalBytes/seconds : 0)
+            << " mcastChunks=" << perfMeter.getChunkCount(hycast::PerfMeter::MCAST)
+            << " mcastBytes=" << perfMeter.getByteCount(hycast::PerfMeter::MCAST)
+            << " p2pChunks=" << perfMeter.getChunkCount(hycast::PerfMeter::P2P)
+            << " p2pBytes=" << perfMeter.getByteCount(hycast::PerfMeter::P2P)
+            << " latP50=" << perfMeter.getLatencyQuantile(0.5)
+            << " latP90=" << perfMeter.getLatencyQuantile(0.9)
+            << " latP99=" << perfMeter.getLatencyQuantile(0.99)
+            << " cpuSecs=" << cpu
+            << " cpuNsPerByte=" << (totalBytes > 0 ? cpu*1e9/totalBytes : 0)
+            << '\n';
+    hycast::logLevel = logLevelOnEntry;
+}
+
 }  // namespace
 
 int main(int argc, char **argv) {
@@ -0,0 +1,98 @@
+/**
+ * This file tests class `ShmProcessing`.
+ *
+ * Copyright 2018 University Corporation for Atmospheric Research. All rights
+ * reserved. See file "COPYING" in the top-level source-directory for usage
+ * restrictions.
+ *
+ *       File: ShmProcessing_test.cpp
+ * Created On: Aug 29, 2018
+ *     Author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "error.h"
+#include "ShmIngester.h"
+#include "ShmProcessing.h"
+
+#include <cstring>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+
+namespace {
+
+/// The fixture for testing class `ShmProcessing`
+class ShmProcessingTest : public ::testing::Test
+{
+protected:
+    const std::string segName{"/ShmProcessing_test"};
+    const std::string prodData{"This is a data-product"};
+};
+
+// Tests default construction
+TEST_F(ShmProcessingTest, DefaultConstruction)
+{
+    hycast::ShmProcessing processing{};
+}
+
+// Tests invalid construction
+TEST_F(ShmProcessingTest, InvalidConstruction)
+{
+    EXPECT_THROW(hycast::ShmProcessing(segName, 0, 1000),
+            std::invalid_argument);
+    EXPECT_THROW(hycast::ShmProcessing(segName, 4, 0), std::invalid_argument);
+}
+
+// Tests delivery of completed products to a consumer process's endpoint
+TEST_F(ShmProcessingTest, Delivery)
+{
+    hycast::ShmProcessing processing{segName, 4, 1000};
+    hycast::ShmIngester   consumer{segName};
+    const int             numProds = 10;
+    std::thread thread{[this,&processing]{
+        for (int i = 0; i < numProds; ++i) {
+            hycast::MemoryProduct prod{
+                    hycast::ProdIndex{static_cast<hycast::ProdIndex::type>(i)},
+                    "product" + std::to_string(i),
+                    static_cast<hycast::ProdSize::type>(prodData.length()),
+                    prodData.data()};
+            processing.process(prod);
+        }
+    }};
+    for (int i = 0; i < numProds; ++i) {
+        auto prod = consumer.getProduct();
+        EXPECT_EQ("product" + std::to_string(i),
+                prod.getInfo().getName().to_string());
+        EXPECT_EQ(prodData.length(), prod.getInfo().getSize());
+        EXPECT_EQ(0, ::memcmp(prodData.data(), prod.getData(),
+                prodData.length()));
+        EXPECT_TRUE(prod.isComplete());
+    }
+    thread.join();
+}
+
+// Tests that an oversize product is dropped rather than wedging the ring
+TEST_F(ShmProcessingTest, OversizeDrop)
+{
+    hycast::ShmProcessing processing{segName, 4,  prodData.length()};
+    hycast::ShmIngester   consumer{segName};
+    const std::string     bigData(2*prodData.length(), 'x');
+    hycast::MemoryProduct bigProd{hycast::ProdIndex{0}, "too big",
+            static_cast<hycast::ProdSize::type>(bigData.length()),
+            bigData.data()};
+    processing.process(bigProd); // Returns without publishing
+    hycast::MemoryProduct prod{hycast::ProdIndex{1}, "fits",
+            static_cast<hycast::ProdSize::type>(prodData.length()),
+            prodData.data()};
+    processing.process(prod);
+    auto rcvdProd = consumer.getProduct();
+    EXPECT_EQ("fits", rcvdProd.getInfo().getName().to_string());
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
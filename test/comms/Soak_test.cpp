@@ -0,0 +1,356 @@
+/**
+ * Long-run soak harness for the loopback shipping/receiving pipeline.
+ *
+ * Drives products through the pipeline at a configurable byte-rate with a
+ * realistic (log-normal) product-size distribution while periodically
+ * sampling the process's resident set, the allocator's arena occupancy
+ * versus its live bytes, and the product throughput. The test fails if,
+ * after a warm-up period, the resident set still trends upward faster than
+ * a threshold or the heap-fragmentation ratio (arena bytes per live byte)
+ * exceeds a ceiling -- the signatures of the slow growth that otherwise
+ * only appears after weeks of operation.
+ *
+ * The default duration keeps `make check` reasonable; a real soak is run by
+ * itself, e.g.,
+ *     HYCAST_SOAK_SECONDS=14400 Soak_test --gtest_filter='*Soak'
+ * The workload and thresholds are configurable via environment variables:
+ *     HYCAST_SOAK_SECONDS        Duration in seconds (default 30)
+ *     HYCAST_SOAK_RATE_BPS       Shipped bytes per second (default 5000000)
+ *     HYCAST_SOAK_MEAN_SIZE      Mean product-size in bytes (default 100000)
+ *     HYCAST_SOAK_SIGMA          Log-normal shape parameter (default 1.0)
+ *     HYCAST_SOAK_DROP           Proportion of multicast traffic
+ *                                synthetically dropped, which exercises the
+ *                                P2P repair path (default 0.1)
+ *     HYCAST_SOAK_RESIDENCE      Product-store residence-time in seconds
+ *                                (default 10)
+ *     HYCAST_SOAK_SAMPLE_SECS    Seconds between samples (default 2)
+ *     HYCAST_SOAK_WARMUP_FRAC    Leading fraction of samples excluded from
+ *                                the trend fit (default 0.25)
+ *     HYCAST_SOAK_MAX_RSS_SLOPE  Maximum post-warm-up RSS growth in bytes
+ *                                per second (default 1048576; tighten for
+ *                                long runs)
+ *     HYCAST_SOAK_MAX_FRAG       Maximum final arena-bytes per live-byte
+ *                                (default 3.0)
+ * Each sample and a final summary are written to standard output as
+ * machine-readable lines of key=value pairs.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: Soak_test.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "error.h"
+#include "Interface.h"
+#include "P2pMgr.h"
+#include "Processing.h"
+#include "ProdStore.h"
+#include "Receiving.h"
+#include "Shipping.h"
+#include "YamlPeerSource.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <malloc.h>
+#include <random>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+/**
+ * Returns the value of an environment variable as an unsigned integer or a
+ * default if the variable isn't set.
+ * @param[in] name  Name of environment variable
+ * @param[in] dflt  Default value
+ * @return          Value of environment variable or default
+ */
+unsigned long envULong(
+        const char*         name,
+        const unsigned long dflt)
+{
+    const char* value = ::getenv(name);
+    return value ? ::strtoul(value, nullptr, 10) : dflt;
+}
+
+/**
+ * Returns the value of an environment variable as a double or a default if
+ * the variable isn't set.
+ * @param[in] name  Name of environment variable
+ * @param[in] dflt  Default value
+ * @return          Value of environment variable or default
+ */
+double envDouble(
+        const char*  name,
+        const double dflt)
+{
+    const char* value = ::getenv(name);
+    return value ? ::strtod(value, nullptr) : dflt;
+}
+
+/**
+ * Returns the size of this process's resident set.
+ * @return Resident set size in bytes
+ */
+double rssBytes()
+{
+    unsigned long totalPages, residentPages;
+    FILE* const   file = ::fopen("/proc/self/statm", "r");
+    if (file == nullptr)
+        return 0;
+    const int n = ::fscanf(file, "%lu %lu", &totalPages, &residentPages);
+    ::fclose(file);
+    return n == 2
+            ? static_cast<double>(residentPages)*::sysconf(_SC_PAGESIZE)
+            : 0;
+}
+
+/// One periodic sample of the process's memory state
+struct MemSample
+{
+    double seconds;   ///< Seconds since the run started
+    double rss;       ///< Resident set size in bytes
+    double arena;     ///< Heap bytes held from the OS (sbrk plus mmap)
+    double live;      ///< Heap bytes in allocated blocks
+    double shipped;   ///< Bytes shipped so far
+    double received;  ///< Bytes received so far
+};
+
+/**
+ * Samples the allocator: the bytes it holds from the operating system and
+ * the bytes that are actually in allocated blocks. The difference is the
+ * fragmentation this harness exists to expose. `mallinfo()`'s fields are
+ * `int`, so the sample is only meaningful below 2 GiB of heap -- ample for
+ * this workload.
+ * @param[out] arena  Heap bytes held from the OS
+ * @param[out] live   Heap bytes in allocated blocks
+ */
+void heapStats(
+        double& arena,
+        double& live)
+{
+    const struct mallinfo info = ::mallinfo();
+    arena = static_cast<double>(info.arena) + info.hblkhd;
+    live = static_cast<double>(info.uordblks) + info.hblkhd;
+}
+
+/**
+ * Returns the least-squares slope of `y` versus `seconds` over the samples
+ * at and beyond `first`.
+ * @param[in] samples  Periodic samples
+ * @param[in] first    Index of the first sample to fit
+ * @param[in] y        Sample field to fit
+ * @return             Slope in field-units per second
+ */
+double slope(
+        const std::vector<MemSample>& samples,
+        const size_t                  first,
+        double MemSample::*const      y)
+{
+    const size_t n = samples.size() - first;
+    if (n < 2)
+        return 0;
+    double sumX = 0, sumY = 0, sumXX = 0, sumXY = 0;
+    for (size_t i = first; i < samples.size(); ++i) {
+        const double x = samples[i].seconds;
+        const double v = samples[i].*y;
+        sumX += x;
+        sumY += v;
+        sumXX += x*x;
+        sumXY += x*v;
+    }
+    const double denom = n*sumXX - sumX*sumX;
+    return denom ? (n*sumXY - sumX*sumY)/denom : 0;
+}
+
+// The fixture for soaking the loopback shipping/receiving pipeline
+class SoakTest : public ::testing::Test, public hycast::Processing
+{
+protected:
+    void process(hycast::Product prod)
+    {
+        ++rcvdProds;
+        rcvdBytes += prod.getInfo().getSize();
+    }
+
+    SoakTest()
+    {
+        // gcc 4.8 doesn't support non-trivial designated initializers
+        srcMcastInfo.mcastAddr = mcastAddr;
+        srcMcastInfo.srcAddr = localInetAddr;
+    }
+
+    const double               residence{
+            envDouble("HYCAST_SOAK_RESIDENCE", 10)};
+    hycast::ProdStore          prodStore{residence};
+    const in_port_t            srcPort{38810};
+    const in_port_t            snkPort{38811};
+    const hycast::InetSockAddr mcastAddr{"232.0.0.2", srcPort};
+    const hycast::InetAddr     localInetAddr{
+            hycast::Interface{ETHNET_IFACE_NAME}.getInetAddr(AF_INET)};
+    hycast::InetSockAddr       srcSrvrAddr{localInetAddr, srcPort};
+    hycast::InetSockAddr       snkSrvrAddr{localInetAddr, snkPort};
+    const unsigned             protoVers{0};
+    hycast::YamlPeerSource     peerSource{"[{inetAddr: " +
+            localInetAddr.to_string() + ", port: " + std::to_string(srcPort) +
+            "}]"};
+    const unsigned             maxPeers = 1;
+    const unsigned             stasisDuration =
+            hycast::PeerSet::defaultStasisDuration;
+    // gcc 4.8 doesn't support non-trivial designated initializers
+    hycast::P2pInfo            p2pInfo{snkSrvrAddr, maxPeers, peerSource,
+            stasisDuration};
+    // gcc 4.8 doesn't support non-trivial designated initializers
+    hycast::SrcMcastInfo       srcMcastInfo;
+    std::atomic<unsigned long> rcvdProds{0};
+    std::atomic<unsigned long> rcvdBytes{0};
+};
+
+// Soaks the pipeline and fails on an RSS trend or a fragmentation ceiling
+TEST_F(SoakTest, Soak) {
+    const double duration = envDouble("HYCAST_SOAK_SECONDS", 30);
+    const double rate = envDouble("HYCAST_SOAK_RATE_BPS", 5e6);
+    const double meanSize = envDouble("HYCAST_SOAK_MEAN_SIZE", 100000);
+    const double sigma = envDouble("HYCAST_SOAK_SIGMA", 1.0);
+    const double dropRate = envDouble("HYCAST_SOAK_DROP", 0.1);
+    const double sampleSecs = envDouble("HYCAST_SOAK_SAMPLE_SECS", 2);
+    const double warmupFrac = envDouble("HYCAST_SOAK_WARMUP_FRAC", 0.25);
+    const double maxRssSlope =
+            envDouble("HYCAST_SOAK_MAX_RSS_SLOPE", 1024*1024);
+    const double maxFrag = envDouble("HYCAST_SOAK_MAX_FRAG", 3.0);
+    const size_t maxProdSize = 1000000;
+
+    auto logLevelOnEntry = hycast::logLevel;
+    hycast::logLevel = hycast::LOG_NOTE;
+    std::vector<char> prodData(maxProdSize);
+    for (size_t i = 0; i < maxProdSize; ++i)
+        prodData[i] = i % UCHAR_MAX;
+
+    hycast::Shipping  shipping{prodStore, mcastAddr, protoVers, srcSrvrAddr,
+            maxPeers, stasisDuration};
+    hycast::Receiving receiving{srcMcastInfo, p2pInfo, *this, protoVers, "",
+            dropRate};
+
+    ::sleep(1);
+
+    /*
+     * Log-normal product-sizes: most products are small while a heavy tail
+     * of large ones churns differently-sized allocations through the
+     * chunk/store lifecycle -- the mix that provokes fragmentation.
+     */
+    std::default_random_engine        generator{1}; // Reproducible
+    std::lognormal_distribution<>     sizeDist{
+            std::log(meanSize) - sigma*sigma/2, sigma};
+
+    std::vector<MemSample> samples{};
+    const auto             start = Clock::now();
+    double                 shippedBytes = 0;
+    unsigned long          shippedProds = 0;
+    double                 nextSample = sampleSecs;
+    hycast::ProdIndex      prodIndex{0};
+
+    for (;;) {
+        const double elapsed = std::chrono::duration_cast<
+                std::chrono::duration<double>>(Clock::now() - start).count();
+        if (elapsed >= duration)
+            break;
+        if (elapsed >= nextSample) {
+            MemSample sample{};
+            sample.seconds = elapsed;
+            sample.rss = rssBytes();
+            heapStats(sample.arena, sample.live);
+            sample.shipped = shippedBytes;
+            sample.received = static_cast<double>(rcvdBytes);
+            samples.push_back(sample);
+            std::cout << "soak-sample:"
+                    << " seconds=" << sample.seconds
+                    << " rss=" << sample.rss
+                    << " heapArena=" << sample.arena
+                    << " heapLive=" << sample.live
+                    << " frag=" << (sample.live > 0
+                            ? sample.arena/sample.live : 0)
+                    << " shippedBytes=" << sample.shipped
+                    << " rcvdBytes=" << sample.received
+                    << '\n';
+            nextSample += sampleSecs;
+        }
+        // Pace shipment to the configured byte-rate
+        if (shippedBytes > rate*elapsed) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+            continue;
+        }
+        auto size = static_cast<size_t>(sizeDist(generator));
+        if (size < 1000)
+            size = 1000;
+        if (size > maxProdSize)
+            size = maxProdSize;
+        std::string name = std::string{"product "} +
+                std::to_string(prodIndex);
+        hycast::MemoryProduct prod{prodIndex, name,
+                static_cast<hycast::ProdSize::type>(size), prodData.data()};
+        shipping.ship(prod);
+        shippedBytes += size;
+        ++shippedProds;
+        ++prodIndex;
+    }
+
+    ASSERT_GE(samples.size(), 4);
+    // Trim the allocator's caches so the final sample reflects what the
+    // heap actually retains
+    ::malloc_trim(0);
+    {
+        MemSample sample{};
+        sample.seconds = std::chrono::duration_cast<
+                std::chrono::duration<double>>(Clock::now() - start).count();
+        sample.rss = rssBytes();
+        heapStats(sample.arena, sample.live);
+        sample.shipped = shippedBytes;
+        sample.received = static_cast<double>(rcvdBytes);
+        samples.push_back(sample);
+    }
+
+    const size_t first = static_cast<size_t>(warmupFrac*samples.size());
+    const double rssSlope = slope(samples, first, &MemSample::rss);
+    const double fragRatio = samples.back().live > 0
+            ? samples.back().arena/samples.back().live
+            : 0;
+    std::cout << "soak:"
+            << " seconds=" << samples.back().seconds
+            << " shippedProds=" << shippedProds
+            << " shippedBytes=" << shippedBytes
+            << " rcvdProds=" << rcvdProds
+            << " rcvdBytes=" << rcvdBytes
+            << " rssStart=" << samples[first].rss
+            << " rssEnd=" << samples.back().rss
+            << " rssSlopeBps=" << rssSlope
+            << " heapArena=" << samples.back().arena
+            << " heapLive=" << samples.back().live
+            << " frag=" << fragRatio
+            << '\n';
+
+    // Some products must actually have flowed for the run to mean anything
+    EXPECT_GT(rcvdProds, 0);
+    // The resident set mustn't still be growing after warm-up...
+    EXPECT_LE(rssSlope, maxRssSlope);
+    // ...and the heap mustn't be mostly holes
+    EXPECT_LE(fragRatio, maxFrag);
+
+    hycast::logLevel = logLevelOnEntry;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
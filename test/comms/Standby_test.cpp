@@ -0,0 +1,125 @@
+/**
+ * This file tests class `Standby`.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: Standby_test.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "Interface.h"
+#include "Shipping.h"
+#include "Standby.h"
+#include "Thread.h"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+namespace {
+
+// The fixture for testing class `Standby`
+class StandbyTest : public ::testing::Test
+{
+protected:
+    StandbyTest()
+    {
+        for (size_t i = 0; i < sizeof(data); ++i)
+            data[i] = i % UCHAR_MAX;
+    }
+
+    char                            data[10000];
+    hycast::ProdStore               prodStore{};
+    const hycast::InetAddr          localInetAddr{
+            hycast::Interface{ETHNET_IFACE_NAME}.getInetAddr(AF_INET)};
+    const hycast::InetSockAddr      mcastAddr{"232.0.0.3", 38820};
+    const hycast::InetSockAddr      hbAddr{"232.0.0.4", 38821};
+    const std::vector<hycast::InetSockAddr> mcastAddrs{mcastAddr};
+    // Distinct peer-server ports: the active and the standby coexist on
+    // this host
+    hycast::InetSockAddr            activeSrvrAddr{localInetAddr, 38822};
+    hycast::InetSockAddr            standbySrvrAddr{localInetAddr, 38823};
+    const unsigned                  protoVers{0};
+    hycast::Cue                     tookOver{};
+    hycast::ProdIndex               resumeIndex{0};
+
+    hycast::Standby::TakeoverObserver observer()
+    {
+        return [this](hycast::Shipping& shipping,
+                const hycast::ProdIndex resume) {
+            resumeIndex = resume;
+            tookOver.cue();
+        };
+    }
+};
+
+// Tests invalid construction
+TEST_F(StandbyTest, InvalidConstruction)
+{
+    EXPECT_THROW(hycast::Standby(prodStore,
+            std::vector<hycast::InetSockAddr>{}, protoVers, standbySrvrAddr,
+            hbAddr, 1, observer()), std::invalid_argument);
+    EXPECT_THROW(hycast::Standby(prodStore, mcastAddrs, protoVers,
+            standbySrvrAddr, hbAddr, 0, observer()), std::invalid_argument);
+}
+
+// Tests that heartbeats keep the standby passive
+TEST_F(StandbyTest, HeartbeatsKeepStandbyPassive)
+{
+    hycast::Standby standby{prodStore, mcastAddrs, protoVers,
+            standbySrvrAddr, hbAddr, 1, observer()};
+    hycast::ProdStore activeStore{};
+    hycast::Shipping  shipping{activeStore, mcastAddrs, protoVers,
+            activeSrvrAddr};
+    shipping.startHeartbeat(hbAddr, 0.2);
+
+    ::sleep(3);
+    EXPECT_FALSE(standby.isActive());
+}
+
+// Tests takeover after heartbeat silence with the advertised resume-index
+TEST_F(StandbyTest, TakeoverAfterSilence)
+{
+    hycast::Standby standby{prodStore, mcastAddrs, protoVers,
+            standbySrvrAddr, hbAddr, 1, observer()};
+    {
+        hycast::ProdStore activeStore{};
+        hycast::Shipping  shipping{activeStore, mcastAddrs, protoVers,
+                activeSrvrAddr};
+        shipping.startHeartbeat(hbAddr, 0.2);
+        hycast::MemoryProduct prod{hycast::ProdIndex{7}, "product 7",
+                sizeof(data), data};
+        shipping.ship(prod);
+        ::sleep(1); // A post-shipment heartbeat advertises index 8
+    } // The active source "crashes"
+
+    tookOver.wait();
+    EXPECT_TRUE(standby.isActive());
+    EXPECT_EQ(hycast::ProdIndex{8}, resumeIndex);
+}
+
+// Tests an operator-commanded switchover with a locally-observed index
+TEST_F(StandbyTest, ManualTakeover)
+{
+    hycast::Standby standby{prodStore, mcastAddrs, protoVers,
+            standbySrvrAddr, hbAddr, 60, observer()};
+    EXPECT_FALSE(standby.isActive());
+
+    standby.noteProduct(hycast::ProdInfo{3, "product 3", sizeof(data)});
+    standby.takeover();
+    tookOver.wait();
+    EXPECT_TRUE(standby.isActive());
+    EXPECT_EQ(hycast::ProdIndex{4}, resumeIndex);
+
+    standby.takeover(); // Idempotent
+    EXPECT_TRUE(standby.isActive());
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
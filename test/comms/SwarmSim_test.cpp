@@ -0,0 +1,401 @@
+/**
+ * This file is an in-process P2P swarm-simulation benchmark. It instantiates
+ * one shipping node and many receiving nodes over loopback in a single
+ * process, drives a synthetic product feed, and reports swarm-wide metrics.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: SwarmSim_test.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "error.h"
+#include "Interface.h"
+#include "P2pMgr.h"
+#include "PerfMeter.h"
+#include "Processing.h"
+#include "Receiving.h"
+#include "Shipping.h"
+#include "Thread.h"
+#include "YamlPeerSource.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <sys/resource.h>
+
+namespace {
+
+typedef std::chrono::steady_clock     Clock;
+typedef std::chrono::duration<double> Seconds;
+
+/**
+ * Returns the value of an environment variable as an unsigned integer or a
+ * default if the variable isn't set.
+ * @param[in] name  Name of environment variable
+ * @param[in] dflt  Default value
+ * @return          Value of environment variable or default
+ */
+unsigned long envULong(
+        const char*         name,
+        const unsigned long dflt)
+{
+    const char* value = ::getenv(name);
+    return value ? ::strtoul(value, nullptr, 10) : dflt;
+}
+
+/**
+ * Returns the value of an environment variable as a double or a default if
+ * the variable isn't set.
+ * @param[in] name  Name of environment variable
+ * @param[in] dflt  Default value
+ * @return          Value of environment variable or default
+ */
+double envDouble(
+        const char*  name,
+        const double dflt)
+{
+    const char* value = ::getenv(name);
+    return value ? ::strtod(value, nullptr) : dflt;
+}
+
+/**
+ * Returns the CPU time (user plus system) this process has consumed.
+ * @return CPU time in seconds
+ */
+double cpuSeconds()
+{
+    struct rusage usage;
+    ::getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec*1e-6 +
+            usage.ru_stime.tv_sec + usage.ru_stime.tv_usec*1e-6;
+}
+
+/**
+ * Returns a quantile of a sorted sample.
+ * @param[in] sorted    Sample values in ascending order
+ * @param[in] quantile  Desired quantile in [0,1]
+ * @return              Value of the quantile or 0 if the sample is empty
+ */
+double quantile(
+        const std::vector<double>& sorted,
+        const double               quantile)
+{
+    if (sorted.empty())
+        return 0;
+    const size_t index = static_cast<size_t>(quantile*(sorted.size() - 1)
+            + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+/**
+ * One simulated receiving node of the swarm: its own `Receiving` instance,
+ * performance meter, and completion bookkeeping. Nodes also serve one another
+ * over the P2P protocol, so peer-selection and scheduler behavior at scale is
+ * exercised in a single process.
+ */
+class SwarmNode final : public hycast::Processing
+{
+    std::mutex             mutex;
+    std::vector<bool>      rcvdProdIndexes;
+    unsigned long          rcvdUniqueProds;
+    Clock::time_point      doneTime;
+    std::atomic<unsigned>& numDoneNodes;
+    const unsigned         numNodes;
+    hycast::Cue            allDone;
+
+public:
+    const unsigned                     index;
+    hycast::PerfMeter                  perfMeter;
+    hycast::YamlPeerSource             peerSource;
+    hycast::P2pInfo                    p2pInfo;
+    std::unique_ptr<hycast::Receiving> receiving;
+
+    /**
+     * Constructs. The node's `Receiving` instance isn't created until
+     * `start()` is called.
+     * @param[in] index           Origin-0 index of this node
+     * @param[in] numProds        Number of products the node will receive
+     * @param[in] peerYaml        YAML specification of the node's potential
+     *                            peers
+     * @param[in] srvrAddr        Socket address of the node's P2P server
+     * @param[in] maxPeers        Maximum number of active peers
+     * @param[in] stasisDuration  Minimum amount of time, in seconds, that the
+     *                            set of active peers must be unchanged before
+     *                            the worst-performing peer may be replaced
+     * @param[in] numDoneNodes    Count of nodes that have received every
+     *                            product. Shared among the nodes.
+     * @param[in] numNodes        Number of nodes in the swarm
+     * @param[in] allDone         Cued when every node has received every
+     *                            product
+     */
+    SwarmNode(
+            const unsigned              index,
+            const unsigned long         numProds,
+            const std::string&          peerYaml,
+            const hycast::InetSockAddr& srvrAddr,
+            const unsigned              maxPeers,
+            const unsigned              stasisDuration,
+            std::atomic<unsigned>&      numDoneNodes,
+            const unsigned              numNodes,
+            hycast::Cue&                allDone)
+        : mutex{}
+        , rcvdProdIndexes(numProds, false)
+        , rcvdUniqueProds{0}
+        , doneTime{}
+        , numDoneNodes(numDoneNodes)
+        , numNodes{numNodes}
+        , allDone{allDone}
+        , index{index}
+        , perfMeter{}
+        , peerSource{peerYaml}
+        , p2pInfo{srvrAddr, maxPeers, peerSource, stasisDuration}
+        , receiving{}
+    {}
+
+    /**
+     * Starts the node by creating its `Receiving` instance.
+     * @param[in] srcMcastInfo  Information on the source-specific multicast
+     * @param[in] version       Protocol version
+     * @param[in] drop          Proportion of multicast traffic to
+     *                          synthetically drop
+     */
+    void start(
+            const hycast::SrcMcastInfo& srcMcastInfo,
+            const unsigned              version,
+            const double                drop)
+    {
+        receiving.reset(new hycast::Receiving{srcMcastInfo, p2pInfo, *this,
+                version, "", drop});
+        receiving->setPerfMeter(perfMeter);
+    }
+
+    /**
+     * Processes a complete data-product. Duplicate deliveries are counted by
+     * the performance meter but are otherwise ignored so that a large swarm
+     * keeps running.
+     * @param[in] prod  Complete data-product
+     */
+    void process(hycast::Product prod)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto                        info = prod.getInfo();
+        const size_t                prodIndex =
+                static_cast<uint64_t>(info.getIndex());
+        perfMeter.product(info);
+        if (!rcvdProdIndexes.at(prodIndex)) {
+            rcvdProdIndexes[prodIndex] = true;
+            if (++rcvdUniqueProds == rcvdProdIndexes.size()) {
+                doneTime = Clock::now();
+                if (++numDoneNodes == numNodes)
+                    allDone.cue();
+            }
+        }
+    }
+
+    /**
+     * Returns the node's time-to-complete: the wall-clock seconds from the
+     * given start until the node had received every product.
+     * @param[in] start  Time shipping started
+     * @return           Seconds until this node was complete
+     */
+    double doneSeconds(const Clock::time_point start) const
+    {
+        return Seconds{doneTime - start}.count();
+    }
+};
+
+// The fixture for the swarm-simulation benchmark
+class SwarmSimTest : public ::testing::Test
+{
+protected:
+    SwarmSimTest()
+    {
+        // gcc 4.8 doesn't support non-trivial designated initializers
+        srcMcastInfo.mcastAddr = mcastAddr;
+        srcMcastInfo.srcAddr = localInetAddr;
+    }
+
+    /**
+     * Returns the YAML specification of a node's potential peers: the source
+     * plus up to `fanout` predecessor nodes, which makes the swarm a sparse
+     * mesh rather than a star around the source.
+     * @param[in] index   Origin-0 index of the node
+     * @param[in] fanout  Maximum number of predecessor nodes to include
+     * @return            YAML peer specification
+     */
+    std::string peerYaml(
+            const unsigned index,
+            const unsigned fanout)
+    {
+        std::string yaml = "[{inetAddr: " + localInetAddr.to_string() +
+                ", port: " + std::to_string(srcPort) + "}";
+        for (unsigned back = 1; back <= fanout && back <= index; ++back)
+            yaml += ", {inetAddr: " + localInetAddr.to_string() + ", port: " +
+                    std::to_string(nodeBasePort + index - back) + "}";
+        return yaml + "]";
+    }
+
+    const in_port_t            srcPort{38810};
+    const in_port_t            nodeBasePort{38811};
+    const hycast::InetSockAddr mcastAddr{"232.0.0.2", srcPort};
+    const hycast::InetAddr     localInetAddr{
+            hycast::Interface{ETHNET_IFACE_NAME}.getInetAddr(AF_INET)};
+    hycast::InetSockAddr       srcSrvrAddr{localInetAddr, srcPort};
+    const unsigned             protoVers{0};
+    const unsigned             stasisDuration =
+            hycast::PeerSet::defaultStasisDuration;
+    hycast::ProdStore          prodStore{};
+    // gcc 4.8 doesn't support non-trivial designated initializers
+    hycast::SrcMcastInfo       srcMcastInfo;
+    std::atomic<unsigned>      numDoneNodes{0};
+    hycast::Cue                allDone{};
+};
+
+/*
+ * In-process swarm simulation. Dozens of receiving nodes -- each with its own
+ * `Receiving` instance, P2P server, and independent synthetic multicast loss
+ * -- share one source over loopback, so peer-selection and chunk-scheduler
+ * changes are measurable at swarm scale without deployment. Intended to be
+ * run by itself, e.g.,
+ *     SwarmSim_test --gtest_filter='*Swarm'
+ * The workload is configurable via environment variables:
+ *     HYCAST_SWARM_NODE_COUNT  Number of receiving nodes (default 8)
+ *     HYCAST_SWARM_PROD_COUNT  Number of products (default 50)
+ *     HYCAST_SWARM_PROD_SIZE   Size of each product in bytes (default 100000)
+ *     HYCAST_SWARM_CHUNK_SIZE  Canonical chunk size in bytes (default
+ *                              ChunkSize::defaultSize)
+ *     HYCAST_SWARM_DROP        Proportion of multicast traffic each node
+ *                              synthetically drops, which forces recovery
+ *                              over the P2P mesh (default 0.2)
+ *     HYCAST_SWARM_MAX_PEERS   Maximum number of active peers per node
+ *                              (default 3)
+ *     HYCAST_SWARM_FANOUT      Number of predecessor nodes in each node's
+ *                              potential-peer list (default 2). 0 makes the
+ *                              swarm a star around the source, in which case
+ *                              the aggregate P2P traffic equals the source's
+ *                              P2P uplink load.
+ * Results are written to standard output: one "swarmNode:" line of key=value
+ * pairs per node (per-transport chunk counts, redundant-delivery ratio, and
+ * product completion-latency percentiles) followed by one "swarm:" summary
+ * line (time-to-complete distribution across nodes, aggregate P2P traffic --
+ * the source's uplink upper bound -- and CPU time).
+ */
+TEST_F(SwarmSimTest, Swarm) {
+    const unsigned numNodes = static_cast<unsigned>(
+            envULong("HYCAST_SWARM_NODE_COUNT", 8));
+    const unsigned long numProds = envULong("HYCAST_SWARM_PROD_COUNT", 50);
+    const unsigned long prodSize = envULong("HYCAST_SWARM_PROD_SIZE", 100000);
+    const hycast::ChunkSize chunkSize{static_cast<hycast::ChunkSize::type>(
+            envULong("HYCAST_SWARM_CHUNK_SIZE",
+                    hycast::ChunkSize::defaultSize))};
+    const double dropRate = envDouble("HYCAST_SWARM_DROP", 0.2);
+    const unsigned maxPeers = static_cast<unsigned>(
+            envULong("HYCAST_SWARM_MAX_PEERS", 3));
+    const unsigned fanout = static_cast<unsigned>(
+            envULong("HYCAST_SWARM_FANOUT", 2));
+
+    auto logLevelOnEntry = hycast::logLevel;
+    hycast::logLevel = hycast::LOG_NOTE;
+    std::vector<char> prodData(prodSize);
+    for (size_t i = 0; i < prodSize; ++i)
+        prodData[i] = i % UCHAR_MAX;
+
+    // The source must be able to serve every node that chooses it as a peer
+    hycast::Shipping shipping{prodStore, mcastAddr, protoVers, srcSrvrAddr,
+            numNodes, stasisDuration};
+
+    std::vector<std::unique_ptr<SwarmNode>> nodes;
+    nodes.reserve(numNodes);
+    for (unsigned i = 0; i < numNodes; ++i) {
+        hycast::InetSockAddr srvrAddr{localInetAddr,
+                static_cast<in_port_t>(nodeBasePort + i)};
+        nodes.emplace_back(new SwarmNode{i, numProds, peerYaml(i, fanout),
+                srvrAddr, maxPeers, stasisDuration, numDoneNodes, numNodes,
+                allDone});
+    }
+    for (auto& node : nodes)
+        node->start(srcMcastInfo, protoVers, dropRate);
+
+    ::sleep(2); // Let the P2P mesh form
+
+    const double cpuStart = cpuSeconds();
+    const auto   clockStart = Clock::now();
+    for (hycast::ProdIndex i = 0; numProds > static_cast<uint64_t>(i); ++i) {
+        std::string name = std::string{"product " } + std::to_string(i);
+        hycast::MemoryProduct prod{i, name,
+                static_cast<hycast::ProdSize::type>(prodSize),
+                prodData.data(), chunkSize};
+        shipping.ship(prod);
+    }
+    allDone.wait();
+    const double seconds = Seconds{Clock::now() - clockStart}.count();
+    const double cpu = cpuSeconds() - cpuStart;
+
+    const unsigned long chunksPerProd = (prodSize + chunkSize - 1)/chunkSize;
+    const double        neededChunks =
+            static_cast<double>(numProds)*chunksPerProd;
+    unsigned long       p2pChunksTotal{0};
+    unsigned long       p2pBytesTotal{0};
+    unsigned long       mcastChunksTotal{0};
+    std::vector<double> doneSecs;
+    doneSecs.reserve(numNodes);
+    for (auto& node : nodes) {
+        node->perfMeter.stop();
+        const auto mcastChunks =
+                node->perfMeter.getChunkCount(hycast::PerfMeter::MCAST);
+        const auto p2pChunks =
+                node->perfMeter.getChunkCount(hycast::PerfMeter::P2P);
+        p2pChunksTotal += p2pChunks;
+        p2pBytesTotal += node->perfMeter.getByteCount(hycast::PerfMeter::P2P);
+        mcastChunksTotal += mcastChunks;
+        doneSecs.push_back(node->doneSeconds(clockStart));
+        std::cout << "swarmNode:"
+                << " node=" << node->index
+                << " mcastChunks=" << mcastChunks
+                << " p2pChunks=" << p2pChunks
+                << " redundancy=" << (neededChunks > 0
+                        ? (mcastChunks + p2pChunks)/neededChunks : 0)
+                << " latP50=" << node->perfMeter.getLatencyQuantile(0.5)
+                << " latP99=" << node->perfMeter.getLatencyQuantile(0.99)
+                << " doneSecs=" << doneSecs.back()
+                << '\n';
+    }
+    std::sort(doneSecs.begin(), doneSecs.end());
+
+    const double totalBytes = static_cast<double>(numProds)*prodSize;
+    std::cout << "swarm:"
+            << " nodeCount=" << numNodes
+            << " prodCount=" << numProds
+            << " prodSize=" << prodSize
+            << " chunkSize=" << static_cast<unsigned>(chunkSize)
+            << " drop=" << dropRate
+            << " maxPeers=" << maxPeers
+            << " fanout=" << fanout
+            << " seconds=" << seconds
+            << " doneP50=" << quantile(doneSecs, 0.5)
+            << " doneP90=" << quantile(doneSecs, 0.9)
+            << " doneMax=" << doneSecs.back()
+            << " mcastChunksTotal=" << mcastChunksTotal
+            << " p2pChunksTotal=" << p2pChunksTotal
+            << " p2pBytesTotal=" << p2pBytesTotal
+            << " cpuSecs=" << cpu
+            << " cpuNsPerByte=" << (totalBytes > 0 ? cpu*1e9/totalBytes : 0)
+            << '\n';
+    hycast::logLevel = logLevelOnEntry;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -150,6 +150,36 @@ TEST_F(McastReceiverTest, SourceSpecificReception) {
     EXPECT_EQ(prod.getInfo().getNumChunks(), chunkIndex);
 }
 
+// Tests reception with per-datagram sequence numbers (protocol version 1).
+// Nothing is lost on the loopback, so the sequence must stay gapless.
+TEST_F(McastReceiverTest, SequencedReception) {
+    version = 1;
+    hycast::McastReceiver mcastRcvr(ssmGroupAddr, srcAddr, *this, version);
+    std::thread           rcvrThread =
+            std::thread([this,mcastRcvr]() mutable {runReceiver(mcastRcvr);});
+    sendProduct(ssmGroupAddr);
+    ::usleep(100000);
+    ::pthread_cancel(rcvrThread.native_handle());
+    rcvrThread.join();
+    EXPECT_EQ(prod.getInfo().getNumChunks(), chunkIndex);
+}
+
+// Tests reception with message-processing workers. All of a product's
+// messages go to the same worker, so in-order delivery is preserved.
+TEST_F(McastReceiverTest, PartitionedWorkerReception) {
+    const unsigned        fecBlockSize = 0;
+    const unsigned        numWorkers = 2;
+    hycast::McastReceiver mcastRcvr(ssmGroupAddr, srcAddr, *this, version,
+            fecBlockSize, numWorkers);
+    std::thread           rcvrThread =
+            std::thread([this,mcastRcvr]() mutable {runReceiver(mcastRcvr);});
+    sendProduct(ssmGroupAddr);
+    ::usleep(100000);
+    ::pthread_cancel(rcvrThread.native_handle());
+    rcvrThread.join();
+    EXPECT_EQ(prod.getInfo().getNumChunks(), chunkIndex);
+}
+
 }  // namespace
 
 int main(int argc, char **argv) {
@@ -9,6 +9,7 @@
  * @author: Steven R. Emmerson
  */
 
+#include <chrono>
 #include <cstring>
 #include <gtest/gtest.h>
 #include <mcast/McastSender.h>
@@ -73,6 +74,30 @@ TEST_F(McastSenderTest, SendDataProduct) {
     sender.send(prod);
 }
 
+// Tests paced sending of a data-product
+TEST_F(McastSenderTest, PacedSend) {
+    hycast::InetSockAddr    mcastAddr("234.128.117.0", 38800);
+    // 100 kB/s with a 4 kB burst => sending 38 kB takes at least 300 ms
+    hycast::McastSender     sender(mcastAddr, 0, 0, 100000, 4000);
+    const hycast::ProdInfo  prodInfo{0, "product", 38000, 1000};
+    hycast::PartialProduct  prod(prodInfo);
+    for (hycast::ChunkIndex chunkIndex = 0;
+            chunkIndex < prodInfo.getNumChunks(); ++chunkIndex) {
+        auto dataSize = prodInfo.getChunkSize(chunkIndex);
+        char data[static_cast<size_t>(dataSize)];
+        ::memset(data, 0xbd, dataSize);
+        hycast::ChunkInfo   chunkInfo(prodInfo, chunkIndex);
+        hycast::ActualChunk chunk(chunkInfo, data);
+        prod.add(chunk);
+    }
+    const auto start = std::chrono::steady_clock::now();
+    sender.send(prod);
+    const auto elapsed = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+    EXPECT_GE(elapsed, 0.3);
+    EXPECT_THROW(sender.setRate(-1), hycast::InvalidArgument);
+}
+
 }  // namespace
 
 int main(int argc, char **argv) {
@@ -11,7 +11,9 @@
 
 #include <Chunk.h>
 #include "error.h"
+#include "MsgSock.h"
 #include "ProdInfo.h"
+#include "RetentionMsg.h"
 #include "SctpSock.h"
 
 #include <cstddef>
@@ -43,22 +45,32 @@ void runClient()
     try {
         hycast::SctpSock sock(numStreams);
         sock.connect(serverSockAddr);
+        hycast::MsgSock msgSock{sock};
 
-        hycast::Channel<hycast::ProdInfo> prodInfoChannel(sock, 0, 0);
-        EXPECT_EQ(sock, prodInfoChannel.getSocket());
+        hycast::Channel<hycast::ProdInfo> prodInfoChannel(msgSock, 0, 0);
+        EXPECT_EQ(msgSock, prodInfoChannel.getSocket());
         hycast::ProdInfo prodInfo1(1, "product", 5);
         prodInfoChannel.send(prodInfo1);
         EXPECT_EQ(0, sock.getStreamId());
         hycast::ProdInfo prodInfo2(prodInfoChannel.recv());
         EXPECT_TRUE(prodInfo1 == prodInfo2);
 
-        hycast::Channel<hycast::ChunkId> chunkInfoChannel(sock, 1, 0);
-        EXPECT_EQ(sock, chunkInfoChannel.getSocket());
+        hycast::Channel<hycast::ChunkId> chunkInfoChannel(msgSock, 1, 0);
+        EXPECT_EQ(msgSock, chunkInfoChannel.getSocket());
         hycast::ChunkId chunkInfo1(prodInfo1, 0);
         chunkInfoChannel.send(chunkInfo1);
         EXPECT_EQ(1, sock.getStreamId());
         hycast::ChunkId chunkInfo2(chunkInfoChannel.recv());
         EXPECT_TRUE(chunkInfo1 == chunkInfo2);
+
+        hycast::Channel<hycast::RetentionMsg> retentionChannel(msgSock, 2, 0);
+        hycast::RetentionMsg retention1{hycast::ProdIndex{1}, 7};
+        retentionChannel.send(retention1);
+        EXPECT_EQ(2, sock.getStreamId());
+        hycast::RetentionMsg retention2(retentionChannel.recv());
+        EXPECT_TRUE(retention2.holdsAnything());
+        EXPECT_EQ(retention1.getOldestProd(), retention2.getOldestProd());
+        EXPECT_EQ(retention1.getOldestTime(), retention2.getOldestTime());
     }
     catch (const std::exception& e) {
         hycast::log_error(e);
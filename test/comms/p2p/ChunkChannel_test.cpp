@@ -11,6 +11,7 @@
 
 #include "Chunk.h"
 #include "InetSockAddr.h"
+#include "MsgSock.h"
 #include "ProdInfo.h"
 #include "SctpSock.h"
 
@@ -42,8 +43,9 @@ void runClient()
 {
     hycast::SctpSock sock(numStreams);
     sock.connect(serverSockAddr);
+    hycast::MsgSock msgSock{sock};
 
-    hycast::Channel<hycast::ActualChunk,hycast::LatentChunk> chunkChannel(sock, 0, 0);
+    hycast::Channel<hycast::ActualChunk,hycast::LatentChunk> chunkChannel(msgSock, 0, 0);
     uint8_t data1[hycast::ChunkSize::defaultSize];
     (void)memset(data1, 0xbd, sizeof(data1));
     hycast::ProdInfo  prodInfo(0, "product", sizeof(data1));
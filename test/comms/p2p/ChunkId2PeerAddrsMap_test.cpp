@@ -17,6 +17,7 @@
 #include <chrono>
 #include <gtest/gtest.h>
 #include <random>
+#include <thread>
 
 namespace {
 
@@ -105,6 +106,38 @@ TEST_F(ChunkId2PeerAddrsMapTest, GetRandom)
     EXPECT_EQ(peerAddr2, peerAddr);
 }
 
+// Tests that entries survive incremental table growth
+TEST_F(ChunkId2PeerAddrsMapTest, IncrementalGrowth)
+{
+    // A small hint forces repeated growths and retired-table migrations
+    hycast::ChunkId2PeerAddrsMap peerAddrs{DEFAULT_MAX_NOTICE_AGE, 16};
+    const int numChunks = 2000;
+    for (int i = 0; i < numChunks; ++i) {
+        hycast::ProdInfo info(i, "product", 100000);
+        peerAddrs.add(hycast::ChunkId{info, 0}, peerAddr1);
+    }
+    EXPECT_EQ(numChunks, peerAddrs.size());
+    for (int i = 0; i < numChunks; ++i) {
+        hycast::ProdInfo info(i, "product", 100000);
+        EXPECT_TRUE(peerAddrs.contains(hycast::ChunkId{info, 0}, peerAddr1));
+    }
+}
+
+// Tests expiry of stale entries
+TEST_F(ChunkId2PeerAddrsMapTest, Expiry)
+{
+    hycast::InetSockAddr         peerAddr{};
+    hycast::ChunkId2PeerAddrsMap peerAddrs{0.1};
+    std::default_random_engine   generator{};
+
+    peerAddrs.add(chunkId1, peerAddr1);
+    ASSERT_TRUE(peerAddrs.getRandom(chunkId1, peerAddr, generator));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds{200});
+    EXPECT_FALSE(peerAddrs.getRandom(chunkId1, peerAddr, generator));
+    EXPECT_EQ(0, peerAddrs.size());
+}
+
 }  // namespace
 
 int main(int argc, char **argv) {
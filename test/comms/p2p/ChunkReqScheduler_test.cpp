@@ -0,0 +1,222 @@
+/**
+ * This file tests class `ChunkReqScheduler`.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See file "COPYING" in the top-level source-directory for usage
+ * restrictions.
+ *
+ *       File: ChunkReqScheduler_test.cpp
+ * Created On: Dec 14, 2017
+ *     Author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "ChunkReqScheduler.h"
+#include "ProdInfo.h"
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+
+namespace {
+
+/// The fixture for testing class `ChunkReqScheduler`
+class ChunkReqSchedulerTest : public ::testing::Test
+{
+protected:
+    hycast::ProdInfo     prodInfo;
+    hycast::ChunkId      chunkId1;
+    hycast::ChunkId      chunkId2;
+    hycast::ChunkId      chunkId3;
+    hycast::InetAddr     ipv4Addr;
+    hycast::InetAddr     ipv6Addr;
+    hycast::InetSockAddr peerAddr1;
+    hycast::InetSockAddr peerAddr2;
+
+    ChunkReqSchedulerTest()
+        : prodInfo(1, "product", 100000)
+        , chunkId1(prodInfo, 0)
+        , chunkId2(prodInfo, 1)
+        , chunkId3(prodInfo, 2)
+        , ipv4Addr{"128.117.140.56"}
+        , ipv6Addr{"2001:db8::ff00:42:8329"}
+        , peerAddr1{ipv4Addr, 38800}
+        , peerAddr2{ipv6Addr, 38800}
+    {}
+};
+
+// Tests invalid construction
+TEST_F(ChunkReqSchedulerTest, InvalidConstruction)
+{
+    EXPECT_THROW(hycast::ChunkReqScheduler(0, 1), std::invalid_argument);
+    EXPECT_THROW(hycast::ChunkReqScheduler(1, 0), std::invalid_argument);
+}
+
+// Tests that a chunk is assigned to only one peer
+TEST_F(ChunkReqSchedulerTest, SingleAssignment)
+{
+    hycast::ChunkReqScheduler scheduler{8, 10};
+    EXPECT_EQ(0, scheduler.size());
+
+    EXPECT_TRUE(scheduler.tryAssign(chunkId1, peerAddr1));
+    EXPECT_EQ(1, scheduler.size());
+
+    EXPECT_FALSE(scheduler.tryAssign(chunkId1, peerAddr2));
+    EXPECT_EQ(1, scheduler.size());
+
+    scheduler.received(chunkId1);
+    EXPECT_EQ(0, scheduler.size());
+}
+
+// Tests that assignments are striped across peers by the request-window
+TEST_F(ChunkReqSchedulerTest, WindowLimit)
+{
+    hycast::ChunkReqScheduler scheduler{1, 10};
+
+    EXPECT_TRUE(scheduler.tryAssign(chunkId1, peerAddr1));
+    EXPECT_FALSE(scheduler.tryAssign(chunkId2, peerAddr1)); // Window is full
+    EXPECT_TRUE(scheduler.tryAssign(chunkId2, peerAddr2));
+
+    scheduler.received(chunkId1);
+    EXPECT_TRUE(scheduler.tryAssign(chunkId3, peerAddr1));
+}
+
+// Tests dispatch of a deferred request when a window-slot is freed
+TEST_F(ChunkReqSchedulerTest, DeferredDispatch)
+{
+    hycast::ChunkReqScheduler scheduler{1, 10};
+
+    EXPECT_TRUE(scheduler.tryAssign(chunkId1, peerAddr1));
+    EXPECT_FALSE(scheduler.tryAssign(chunkId2, peerAddr1)); // Deferred
+
+    std::thread thread{[this,&scheduler]{scheduler.received(chunkId1);}};
+    hycast::ChunkId      chunkId{};
+    hycast::InetSockAddr peerAddr{};
+    scheduler.getAssignment(chunkId, peerAddr); // Blocks until slot is freed
+    EXPECT_EQ(chunkId2, chunkId);
+    EXPECT_EQ(peerAddr1, peerAddr);
+    thread.join();
+}
+
+// Tests that the highest-priority deferred chunk-request is dispatched first
+TEST_F(ChunkReqSchedulerTest, PriorityDispatch)
+{
+    hycast::ChunkReqScheduler scheduler{1, 10};
+
+    EXPECT_TRUE(scheduler.tryAssign(chunkId1, peerAddr1));
+    EXPECT_FALSE(scheduler.tryAssign(chunkId2, peerAddr1));    // Deferred
+    EXPECT_FALSE(scheduler.tryAssign(chunkId3, peerAddr1, 5)); // Urgent
+
+    std::thread thread{[this,&scheduler]{scheduler.received(chunkId1);}};
+    hycast::ChunkId      chunkId{};
+    hycast::InetSockAddr peerAddr{};
+    scheduler.getAssignment(chunkId, peerAddr); // Blocks until slot is freed
+    EXPECT_EQ(chunkId3, chunkId); // Urgent chunk preempts earlier bulk one
+    EXPECT_EQ(peerAddr1, peerAddr);
+    thread.join();
+}
+
+// Tests that, within a priority class, deferred requests complete the most
+// nearly-finished product first
+TEST_F(ChunkReqSchedulerTest, CompletenessDispatch)
+{
+    hycast::ChunkReqScheduler scheduler{1, 10};
+    hycast::ProdInfo          prodInfo2{2, "product 2", 100000};
+    hycast::ChunkId           otherProdChunk{prodInfo2, 0};
+
+    // The other product is 90% complete; `prodInfo`'s is 10%
+    scheduler.setCompletenessFn(
+            [&prodInfo2](const hycast::ProdIndex& prodIndex) {
+                return (prodIndex == prodInfo2.getIndex()) ? 0.9 : 0.1;
+            });
+
+    EXPECT_TRUE(scheduler.tryAssign(chunkId1, peerAddr1));
+    EXPECT_FALSE(scheduler.tryAssign(chunkId2, peerAddr1));       // Deferred
+    EXPECT_FALSE(scheduler.tryAssign(otherProdChunk, peerAddr1)); // Deferred
+
+    std::thread thread{[this,&scheduler]{scheduler.received(chunkId1);}};
+    hycast::ChunkId      chunkId{};
+    hycast::InetSockAddr peerAddr{};
+    scheduler.getAssignment(chunkId, peerAddr); // Blocks until slot is freed
+    EXPECT_EQ(otherProdChunk, chunkId); // Nearly-complete product goes first
+    EXPECT_EQ(peerAddr1, peerAddr);
+    thread.join();
+}
+
+// Tests cancellation of an assigned chunk-request
+TEST_F(ChunkReqSchedulerTest, Cancellation)
+{
+    hycast::ChunkReqScheduler scheduler{1, 10};
+
+    EXPECT_TRUE(scheduler.tryAssign(chunkId1, peerAddr1));
+
+    EXPECT_EQ(peerAddr1, scheduler.cancelled(chunkId1));
+    EXPECT_EQ(0, scheduler.size());
+    // The window-slot was freed
+    EXPECT_TRUE(scheduler.tryAssign(chunkId2, peerAddr1));
+
+    // An unknown chunk has no assignee
+    EXPECT_FALSE(scheduler.cancelled(chunkId3));
+}
+
+// Tests re-issuing an overdue request to an alternative peer
+TEST_F(ChunkReqSchedulerTest, DeadlineReissue)
+{
+    hycast::ChunkReqScheduler scheduler{8, 1};
+
+    EXPECT_TRUE(scheduler.tryAssign(chunkId1, peerAddr1));
+    EXPECT_FALSE(scheduler.tryAssign(chunkId1, peerAddr2)); // Candidate
+
+    hycast::ChunkId      chunkId{};
+    hycast::InetSockAddr peerAddr{};
+    scheduler.getAssignment(chunkId, peerAddr); // Blocks until deadline
+    EXPECT_EQ(chunkId1, chunkId);
+    EXPECT_EQ(peerAddr2, peerAddr);
+}
+
+// Tests hold-down of repair requests after multicast beats one
+TEST_F(ChunkReqSchedulerTest, RepairHoldDown)
+{
+    hycast::ChunkReqScheduler scheduler{8, 10};
+
+    // Multicast beats the tracked chunk by ~50 ms: a hold-down sample
+    EXPECT_TRUE(scheduler.tryAssign(chunkId1, peerAddr1));
+    std::this_thread::sleep_for(std::chrono::milliseconds{50});
+    scheduler.cancelled(chunkId1);
+
+    // A new chunk is held down rather than assigned immediately...
+    EXPECT_FALSE(scheduler.tryAssign(chunkId2, peerAddr1));
+    // ...but an urgent chunk bypasses the hold-down
+    EXPECT_TRUE(scheduler.tryAssign(chunkId3, peerAddr1, 5));
+
+    // The held chunk is dispatched once its window elapses
+    hycast::ChunkId      chunkId{};
+    hycast::InetSockAddr peerAddr{};
+    scheduler.getAssignment(chunkId, peerAddr);
+    EXPECT_EQ(chunkId2, chunkId);
+    EXPECT_EQ(peerAddr1, peerAddr);
+}
+
+// Tests reassignment of the requests of a stopped peer
+TEST_F(ChunkReqSchedulerTest, PeerStopped)
+{
+    hycast::ChunkReqScheduler scheduler{8, 10};
+
+    EXPECT_TRUE(scheduler.tryAssign(chunkId1, peerAddr1));
+    EXPECT_FALSE(scheduler.tryAssign(chunkId1, peerAddr2)); // Candidate
+
+    scheduler.peerStopped(peerAddr1);
+
+    hycast::ChunkId      chunkId{};
+    hycast::InetSockAddr peerAddr{};
+    scheduler.getAssignment(chunkId, peerAddr);
+    EXPECT_EQ(chunkId1, chunkId);
+    EXPECT_EQ(peerAddr2, peerAddr);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
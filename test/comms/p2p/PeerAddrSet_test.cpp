@@ -84,6 +84,56 @@ TEST_F(PeerAddrSetTest, GetRandom)
     EXPECT_EQ(peerAddr2, peerAddr);
 }
 
+// Tests that selection favors subnet diversity
+TEST_F(PeerAddrSetTest, SubnetDiversity)
+{
+    hycast::InetSockAddr       peerAddr{};
+    hycast::PeerAddrSet        peerAddrSet{};
+    std::default_random_engine generator{1};
+
+    // Two peers in one /24 subnet; a third on a different subnet
+    hycast::InetSockAddr sameSubnet1{hycast::InetAddr{"128.117.140.56"}, 38800};
+    hycast::InetSockAddr sameSubnet2{hycast::InetAddr{"128.117.140.57"}, 38800};
+    hycast::InetSockAddr otherSubnet{hycast::InetAddr{"192.168.1.1"}, 38800};
+    peerAddrSet.add(sameSubnet1);
+    peerAddrSet.add(sameSubnet2);
+    peerAddrSet.add(otherSubnet);
+
+    /*
+     * The subnet-level draw should pick the lone subnet about half the time
+     * (3000 of 6000); a flat per-peer draw would pick it about a third of
+     * the time (2000 of 6000)
+     */
+    unsigned numOther = 0;
+    for (int i = 0; i < 6000; ++i) {
+        ASSERT_TRUE(peerAddrSet.getRandom(peerAddr, generator));
+        if (peerAddr == otherSubnet)
+            ++numOther;
+    }
+    EXPECT_GT(numOther, 2500);
+}
+
+// Tests that selection favors quality-weight within a subnet
+TEST_F(PeerAddrSetTest, QualityWeight)
+{
+    hycast::InetSockAddr       peerAddr{};
+    hycast::PeerAddrSet        peerAddrSet{};
+    std::default_random_engine generator{1};
+
+    hycast::InetSockAddr goodPeer{hycast::InetAddr{"128.117.140.56"}, 38800};
+    hycast::InetSockAddr poorPeer{hycast::InetAddr{"128.117.140.57"}, 38800};
+    peerAddrSet.add(goodPeer, 9);
+    peerAddrSet.add(poorPeer, 1);
+
+    unsigned numGood = 0;
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(peerAddrSet.getRandom(peerAddr, generator));
+        if (peerAddr == goodPeer)
+            ++numGood;
+    }
+    EXPECT_GT(numGood, 800);
+}
+
 }  // namespace
 
 int main(int argc, char **argv) {
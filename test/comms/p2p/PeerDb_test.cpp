@@ -0,0 +1,106 @@
+/**
+ * This file tests the class `PeerDb`.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: PeerDb_test.cpp
+ * @author: Steven R. Emmerson
+ */
+
+#include "PeerDb.h"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+namespace {
+
+// The fixture for testing class PeerDb.
+class PeerDbTest : public ::testing::Test {
+protected:
+    const std::string          pathname{"/tmp/PeerDb_test.db"};
+    const hycast::InetSockAddr peerAddr1{"192.168.0.1", 38800};
+    const hycast::InetSockAddr peerAddr2{"192.168.0.2", 38800};
+    const hycast::InetSockAddr peerAddr3{"192.168.0.3", 38800};
+
+    PeerDbTest() {
+        ::unlink(pathname.c_str());
+    }
+
+    virtual ~PeerDbTest() {
+        ::unlink(pathname.c_str());
+    }
+};
+
+// Tests construction without a database file
+TEST_F(PeerDbTest, Construction) {
+    hycast::PeerDb peerDb{pathname};
+    EXPECT_EQ(0, peerDb.size());
+    EXPECT_EQ(0, peerDb.getRanked(10).size());
+}
+
+// Tests ranking by score
+TEST_F(PeerDbTest, Ranking) {
+    hycast::PeerDb peerDb{pathname};
+    peerDb.observe(peerAddr1, 1);
+    peerDb.observe(peerAddr2, 3);
+    peerDb.observe(peerAddr3, 2);
+    auto ranked = peerDb.getRanked(2);
+    ASSERT_EQ(2, ranked.size());
+    EXPECT_EQ(peerAddr2, ranked[0].first);
+    EXPECT_EQ(3, ranked[0].second);
+    EXPECT_EQ(peerAddr3, ranked[1].first);
+}
+
+// Tests that repeated observations form a moving average
+TEST_F(PeerDbTest, MovingAverage) {
+    hycast::PeerDb peerDb{pathname};
+    peerDb.observe(peerAddr1, 4);
+    peerDb.observe(peerAddr1, 0);
+    EXPECT_EQ(1, peerDb.size());
+    auto ranked = peerDb.getRanked(1);
+    ASSERT_EQ(1, ranked.size());
+    EXPECT_GT(4, ranked[0].second);
+    EXPECT_LT(0, ranked[0].second);
+}
+
+// Tests persistence across instances
+TEST_F(PeerDbTest, Persistence) {
+    {
+        hycast::PeerDb peerDb{pathname};
+        peerDb.observe(peerAddr1, 1);
+        peerDb.observe(peerAddr2, 2);
+        peerDb.save();
+    }
+    hycast::PeerDb peerDb{pathname};
+    EXPECT_EQ(2, peerDb.size());
+    auto ranked = peerDb.getRanked(10);
+    ASSERT_EQ(2, ranked.size());
+    EXPECT_EQ(peerAddr2, ranked[0].first);
+    EXPECT_EQ(peerAddr1, ranked[1].first);
+}
+
+// Tests the database-backed source of potential peers
+TEST_F(PeerDbTest, PeerDbSource) {
+    {
+        hycast::PeerDb peerDb{pathname};
+        peerDb.observe(peerAddr1, 2);
+    }
+    hycast::PeerDbSource peerSource{pathname};
+    EXPECT_FALSE(peerSource.empty());
+    EXPECT_EQ(peerAddr1, peerSource.pop());
+    peerSource.learn(peerAddr2, 3);
+    EXPECT_EQ(peerAddr2, peerSource.pop());
+    auto best = peerSource.getBest(10);
+    ASSERT_EQ(2, best.size());
+    EXPECT_EQ(peerAddr2, best[0].first);
+    EXPECT_EQ(peerAddr1, best[1].first);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,77 @@
+/**
+ * This file tests the class `PeerGossip`.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: PeerGossip_test.cpp
+ * @author: Steven R. Emmerson
+ */
+
+#include "PeerGossip.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+// The fixture for testing class PeerGossip.
+class PeerGossipTest : public ::testing::Test {
+protected:
+    const hycast::InetSockAddr peerAddr1{"192.168.0.1", 38800};
+    const hycast::InetSockAddr peerAddr2{"192.168.0.2", 38801};
+};
+
+// Tests default construction
+TEST_F(PeerGossipTest, DefaultConstruction) {
+    hycast::PeerGossip gossip{};
+    EXPECT_EQ(0, gossip.size());
+}
+
+// Tests adding peers
+TEST_F(PeerGossipTest, Addition) {
+    hycast::PeerGossip gossip{};
+    gossip.add(peerAddr1, 1.5);
+    gossip.add(peerAddr2, 0);
+    EXPECT_EQ(2, gossip.size());
+    EXPECT_EQ(peerAddr1, gossip.getPeerAddr(0));
+    EXPECT_EQ(1.5, gossip.getScore(0));
+    EXPECT_EQ(peerAddr2, gossip.getPeerAddr(1));
+    EXPECT_EQ(0, gossip.getScore(1));
+}
+
+// Tests that a full message ignores additions
+TEST_F(PeerGossipTest, FullMessage) {
+    hycast::PeerGossip gossip{};
+    for (size_t i = 0; i <= hycast::PeerGossip::maxEntries; ++i)
+        gossip.add(peerAddr1, 1);
+    EXPECT_EQ(hycast::PeerGossip::maxEntries, gossip.size());
+}
+
+// Tests serialization/de-serialization
+TEST_F(PeerGossipTest, Serialization) {
+    hycast::PeerGossip gossip1{};
+    gossip1.add(peerAddr1, 1.5);
+    gossip1.add(peerAddr2, 0.25);
+    const size_t nbytes = gossip1.getSerialSize(0);
+    EXPECT_TRUE(nbytes <= hycast::PeerGossip::getMaxSerialSize(0));
+    alignas(alignof(size_t)) char bytes[nbytes];
+    hycast::MemEncoder encoder(bytes, nbytes);
+    gossip1.serialize(encoder, 0);
+    encoder.flush();
+    hycast::MemDecoder decoder(bytes, nbytes);
+    decoder.fill(0);
+    auto gossip2 = hycast::PeerGossip::deserialize(decoder, 0);
+    ASSERT_EQ(2, gossip2.size());
+    EXPECT_EQ(peerAddr1, gossip2.getPeerAddr(0));
+    EXPECT_EQ(1.5, gossip2.getScore(0));
+    EXPECT_EQ(peerAddr2, gossip2.getPeerAddr(1));
+    EXPECT_EQ(0.25, gossip2.getScore(1));
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,93 @@
+/**
+ * This file tests the class `PeerScore`.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: PeerScore_test.cpp
+ * @author: Steven R. Emmerson
+ */
+
+#include "PeerScore.h"
+#include "ProdInfo.h"
+
+#include <gtest/gtest.h>
+#include <limits>
+
+namespace {
+
+// The fixture for testing class PeerScore
+class PeerScoreTest : public ::testing::Test {
+protected:
+    const hycast::ProdInfo prodInfo{0, "product",
+            2*hycast::ChunkSize::defaultSize};
+};
+
+// Tests that a new instance has a neutral score
+TEST_F(PeerScoreTest, DefaultConstruction) {
+    hycast::PeerScore score{};
+    EXPECT_EQ(0, score.getScore());
+}
+
+// Tests that deliveries raise the score
+TEST_F(PeerScoreTest, DeliveryRaisesScore) {
+    hycast::PeerScore score{};
+    hycast::ChunkId   chunkId{prodInfo, 0};
+    score.noticeReceived();
+    score.requestSent(chunkId);
+    score.chunkReceived(chunkId, hycast::ChunkSize::defaultSize);
+    EXPECT_LT(0, score.getScore());
+}
+
+// Tests that a delivering peer outranks an all-notice peer
+TEST_F(PeerScoreTest, ConversionMatters) {
+    hycast::PeerScore deliverer{};
+    hycast::PeerScore talker{};
+    for (unsigned chunkIndex = 0; chunkIndex < 2; ++chunkIndex) {
+        hycast::ChunkId chunkId{prodInfo, hycast::ChunkIndex{chunkIndex}};
+        deliverer.noticeReceived();
+        deliverer.requestSent(chunkId);
+        deliverer.chunkReceived(chunkId, hycast::ChunkSize::defaultSize);
+        for (int i = 0; i < 10; ++i)
+            talker.noticeReceived();
+    }
+    EXPECT_LT(talker.getScore(), deliverer.getScore());
+}
+
+// Tests that a collapsed congestion window lowers the score
+TEST_F(PeerScoreTest, CongestionLowersScore) {
+    hycast::PeerScore healthy{};
+    hycast::PeerScore congested{};
+    healthy.transportSampled(0.01, 10.0*hycast::ChunkSize::defaultSize);
+    congested.transportSampled(0.01, hycast::ChunkSize::defaultSize/16.0);
+    EXPECT_LT(congested.getScore(), healthy.getScore());
+}
+
+// Tests the estimated score of a probed peer
+TEST_F(PeerScoreTest, ProbeScore) {
+    // A mute candidate can never win
+    EXPECT_EQ(-std::numeric_limits<double>::infinity(),
+            hycast::PeerScore::probeScore(0, -1));
+    // A faster, lower-latency candidate outranks a slower one
+    EXPECT_LT(hycast::PeerScore::probeScore(1, 2),
+            hycast::PeerScore::probeScore(10, 0.1));
+}
+
+// Tests resetting
+TEST_F(PeerScoreTest, Reset) {
+    hycast::PeerScore score{};
+    hycast::ChunkId   chunkId{prodInfo, 0};
+    score.noticeReceived();
+    score.requestSent(chunkId);
+    score.chunkReceived(chunkId, hycast::ChunkSize::defaultSize);
+    score.reset();
+    EXPECT_EQ(0, score.getScore());
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
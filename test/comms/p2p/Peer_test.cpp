@@ -73,8 +73,11 @@ public:
         delete[] chunkData;
     }
 
-    void startBacklog(const hycast::ChunkId& chunkId) {
+    void startBacklog(
+            const hycast::ChunkId&      chunkId,
+            const hycast::BacklogOrder  order) {
         EXPECT_EQ(backlogChunkId, chunkId);
+        EXPECT_EQ(hycast::BacklogOrder::OLDEST_FIRST, order);
     }
     bool shouldRequest(const hycast::ProdIndex& index) {
         EXPECT_EQ(prodIndex, index);
@@ -198,6 +201,14 @@ TEST_F(PeerTest, DefaultConstruction) {
     hycast::Peer peer{};
 }
 
+// Tests that recycling leaves the instance in the default-constructed state
+TEST_F(PeerTest, Recycle) {
+    hycast::Peer peer{};
+    peer.recycle();
+    EXPECT_STREQ("{addr=:0, version=0, sock={sd=-1, numStreams=0}}",
+            peer.to_string().data());
+}
+
 // Tests to_string
 TEST_F(PeerTest, ToString) {
     EXPECT_STREQ("{addr=:0, version=0, sock={sd=-1, numStreams=0}}",
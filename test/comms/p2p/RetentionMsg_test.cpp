@@ -0,0 +1,72 @@
+/**
+ * This file tests the class `RetentionMsg`.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: RetentionMsg_test.cpp
+ * @author: Steven R. Emmerson
+ */
+
+#include "RetentionMsg.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+// The fixture for testing class RetentionMsg.
+class RetentionMsgTest : public ::testing::Test {
+};
+
+// Tests default construction: an empty store
+TEST_F(RetentionMsgTest, DefaultConstruction) {
+    hycast::RetentionMsg retention{};
+    EXPECT_FALSE(retention.holdsAnything());
+}
+
+// Tests construction from an oldest resident product
+TEST_F(RetentionMsgTest, Construction) {
+    hycast::RetentionMsg retention{hycast::ProdIndex{2}, 3};
+    EXPECT_TRUE(retention.holdsAnything());
+    EXPECT_EQ(hycast::ProdIndex{2}, retention.getOldestProd());
+    EXPECT_EQ(3u, retention.getOldestTime());
+}
+
+// Tests serialization/de-serialization
+TEST_F(RetentionMsgTest, Serialization) {
+    hycast::RetentionMsg retention1{hycast::ProdIndex{5}, 1500000007000000u};
+    const size_t nbytes = retention1.getSerialSize(0);
+    EXPECT_EQ(hycast::RetentionMsg::getStaticSerialSize(0), nbytes);
+    alignas(alignof(size_t)) char bytes[nbytes];
+    hycast::MemEncoder encoder(bytes, nbytes);
+    retention1.serialize(encoder, 0);
+    encoder.flush();
+    hycast::MemDecoder decoder(bytes, nbytes);
+    decoder.fill(0);
+    auto retention2 = hycast::RetentionMsg::deserialize(decoder, 0);
+    EXPECT_TRUE(retention2.holdsAnything());
+    EXPECT_EQ(hycast::ProdIndex{5}, retention2.getOldestProd());
+    EXPECT_EQ(1500000007000000u, retention2.getOldestTime());
+}
+
+// Tests serialization/de-serialization of an empty advertisement
+TEST_F(RetentionMsgTest, EmptySerialization) {
+    hycast::RetentionMsg retention1{};
+    const size_t nbytes = retention1.getSerialSize(0);
+    alignas(alignof(size_t)) char bytes[nbytes];
+    hycast::MemEncoder encoder(bytes, nbytes);
+    retention1.serialize(encoder, 0);
+    encoder.flush();
+    hycast::MemDecoder decoder(bytes, nbytes);
+    decoder.fill(0);
+    auto retention2 = hycast::RetentionMsg::deserialize(decoder, 0);
+    EXPECT_FALSE(retention2.holdsAnything());
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
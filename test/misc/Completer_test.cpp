@@ -90,6 +90,18 @@ TEST_F(CompleterTest, MultipleIntExecution) {
     }
 }
 
+// Tests that take() returns higher-priority completions first
+TEST_F(CompleterTest, PriorityTake) {
+    hycast::Completer<int> completer{};
+    auto low = completer.submit([]{return 0;}, hycast::TaskPriority::LOW);
+    auto high = completer.submit([]{return 1;}, hycast::TaskPriority::HIGH);
+    // A future is enqueued for take() before its result is set
+    low.getResult();
+    high.getResult();
+    EXPECT_TRUE(completer.take() == high);
+    EXPECT_TRUE(completer.take() == low);
+}
+
 // Tests cancellation of void task
 TEST_F(CompleterTest, VoidCancellation) {
     hycast::Completer<void> completer{};
@@ -0,0 +1,105 @@
+/**
+ * This file tests the function `crc32c()`
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: Crc32c_test.cpp
+ * @author: Steven R. Emmerson
+ */
+
+#include "Crc32c.h"
+
+#include <cstring>
+#include <gtest/gtest.h>
+
+namespace {
+
+// The fixture for testing function crc32c()
+class Crc32cTest : public ::testing::Test {
+ protected:
+};
+
+// Tests the standard check-value (RFC 3720)
+TEST_F(Crc32cTest, CheckValue) {
+    EXPECT_EQ(0xe3069283u, hycast::crc32c(0, "123456789", 9));
+}
+
+// Tests the empty input
+TEST_F(Crc32cTest, EmptyInput) {
+    EXPECT_EQ(0u, hycast::crc32c(0, "", 0));
+}
+
+// Tests that an incremental computation equals a one-shot computation
+TEST_F(Crc32cTest, Incremental) {
+    const char data[] = "The quick brown fox jumps over the lazy dog";
+    const auto nbytes = sizeof(data) - 1;
+    const auto oneShot = hycast::crc32c(0, data, nbytes);
+    for (size_t split = 0; split <= nbytes; ++split) {
+        auto crc = hycast::crc32c(0, data, split);
+        crc = hycast::crc32c(crc, data + split, nbytes - split);
+        EXPECT_EQ(oneShot, crc);
+    }
+}
+
+// Tests a long buffer at every alignment
+TEST_F(Crc32cTest, Alignment) {
+    char buf[4096+8];
+    for (size_t i = 0; i < sizeof(buf); ++i)
+        buf[i] = static_cast<char>(i);
+    const auto expect = hycast::crc32c(0, buf, 4096);
+    for (size_t offset = 1; offset < 8; ++offset) {
+        ::memmove(buf + offset, buf, 4096);
+        EXPECT_EQ(expect, hycast::crc32c(0, buf + offset, 4096));
+        ::memmove(buf, buf + offset, 4096);
+    }
+}
+
+// Tests that combining the checksums of two adjacent pieces equals the
+// checksum of the whole, at every split
+TEST_F(Crc32cTest, Combine) {
+    const char data[] = "The quick brown fox jumps over the lazy dog";
+    const auto nbytes = sizeof(data) - 1;
+    const auto oneShot = hycast::crc32c(0, data, nbytes);
+    for (size_t split = 0; split <= nbytes; ++split) {
+        const auto crc1 = hycast::crc32c(0, data, split);
+        const auto crc2 = hycast::crc32c(0, data + split, nbytes - split);
+        EXPECT_EQ(oneShot, hycast::crc32cCombine(crc1, crc2,
+                nbytes - split));
+    }
+}
+
+// Tests that combining many piecewise checksums equals a one-shot computation
+TEST_F(Crc32cTest, CombineMany) {
+    char buf[4096];
+    for (size_t i = 0; i < sizeof(buf); ++i)
+        buf[i] = static_cast<char>(i * 31);
+    const auto   oneShot = hycast::crc32c(0, buf, sizeof(buf));
+    const size_t pieceSize = 100;
+    uint32_t     crc = 0;
+    for (size_t offset = 0; offset < sizeof(buf); offset += pieceSize) {
+        const auto len = (offset + pieceSize <= sizeof(buf))
+                ? pieceSize
+                : sizeof(buf) - offset;
+        crc = hycast::crc32cCombine(crc, hycast::crc32c(0, buf + offset, len),
+                len);
+    }
+    EXPECT_EQ(oneShot, crc);
+}
+
+// Tests that different inputs yield different checksums
+TEST_F(Crc32cTest, Sensitivity) {
+    char data[64];
+    ::memset(data, 0xbd, sizeof(data));
+    const auto crc = hycast::crc32c(0, data, sizeof(data));
+    data[sizeof(data)-1] ^= 0x01;
+    EXPECT_NE(crc, hycast::crc32c(0, data, sizeof(data)));
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -18,6 +18,7 @@
 #include <gtest/gtest.h>
 #include <iostream>
 #include <random>
+#include <sched.h>
 #include <stdexcept>
 #include <unistd.h>
 
@@ -61,6 +62,17 @@ TEST_F(ExecutorTest, IntExecution) {
     EXPECT_EQ(0, hycast::Thread::size());
 }
 
+// Tests CPU affinity of submitted tasks
+TEST_F(ExecutorTest, TaskAffinity) {
+    {
+        hycast::Executor<int> executor{};
+        executor.setAffinity(std::vector<unsigned>{0});
+        auto future = executor.submit([]{return ::sched_getcpu();});
+        EXPECT_EQ(0, future.getResult());
+    }
+    EXPECT_EQ(0, hycast::Thread::size());
+}
+
 // Tests canceling void task
 TEST_F(ExecutorTest, CancelVoid) {
     {
@@ -0,0 +1,146 @@
+/**
+ * This file tests class `FlightRecorder`.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: FlightRecorder_test.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "FlightRecorder.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+namespace {
+
+typedef hycast::FlightRecorder          FlightRecorder;
+typedef hycast::FlightRecorder::Event   Event;
+
+/// The fixture for testing class `FlightRecorder`
+class FlightRecorderTest : public ::testing::Test
+{
+protected:
+    const std::string pathname{"FlightRecorder_test.dump"};
+
+    ~FlightRecorderTest()
+    {
+        ::remove(pathname.data());
+    }
+
+    /// Reads back a dump-file: header is validated, events are returned
+    std::vector<Event> decode()
+    {
+        std::ifstream file{pathname, std::ifstream::binary};
+        EXPECT_TRUE(file.is_open());
+        struct {
+            char     magic[4];
+            uint32_t version;
+            uint32_t eventSize;
+            uint32_t pad;
+        } fileHeader;
+        file.read(reinterpret_cast<char*>(&fileHeader), sizeof(fileHeader));
+        EXPECT_EQ(0, ::memcmp(fileHeader.magic, "HYFR", 4));
+        EXPECT_EQ(1, fileHeader.version);
+        EXPECT_EQ(sizeof(Event), fileHeader.eventSize);
+        std::vector<Event> events;
+        for (;;) {
+            struct {
+                uint64_t thread;
+                uint64_t numEvents;
+            } ringHeader;
+            file.read(reinterpret_cast<char*>(&ringHeader),
+                    sizeof(ringHeader));
+            if (file.eof())
+                break;
+            for (uint64_t i = 0; i < ringHeader.numEvents; ++i) {
+                Event event;
+                file.read(reinterpret_cast<char*>(&event), sizeof(event));
+                events.push_back(event);
+            }
+        }
+        return events;
+    }
+};
+
+// Tests that recorded events round-trip through a dump-file
+TEST_F(FlightRecorderTest, RecordAndDump)
+{
+    FlightRecorder::record(Event::CHUNK_RECV_MCAST, 1, 2, 3);
+    FlightRecorder::record(Event::PRODUCT_COMPLETE, 1, 0, 40000);
+    FlightRecorder::dump(pathname);
+    const auto events = decode();
+    ASSERT_LE(2, events.size());
+    // This thread's events are in recording order with monotonic timestamps
+    unsigned found = 0;
+    uint64_t prevWhen = 0;
+    for (const auto& event : events) {
+        if (event.type == Event::CHUNK_RECV_MCAST && event.prod == 1) {
+            EXPECT_EQ(2, event.chunk);
+            EXPECT_EQ(3, event.size);
+            EXPECT_LE(prevWhen, event.when);
+            prevWhen = event.when;
+            ++found;
+        }
+        else if (event.type == Event::PRODUCT_COMPLETE && event.prod == 1) {
+            EXPECT_EQ(40000, event.size);
+            EXPECT_LE(prevWhen, event.when);
+            ++found;
+        }
+    }
+    EXPECT_EQ(2, found);
+}
+
+// Tests that the ring keeps only the most-recent events
+TEST_F(FlightRecorderTest, Wraparound)
+{
+    // Rings already exist at their default capacity, so wrap one explicitly
+    const uint64_t numRecorded = (1ul << 18) + 100;
+    for (uint64_t i = 0; i < numRecorded; ++i)
+        FlightRecorder::record(Event::CHUNK_STORED, 2,
+                static_cast<uint32_t>(i));
+    FlightRecorder::dump(pathname);
+    const auto events = decode();
+    EXPECT_GT(numRecorded, events.size());
+    // The oldest surviving chunk-index of this run is the wrapped-to one
+    uint64_t prevWhen = 0;
+    for (const auto& event : events) {
+        if (event.type == Event::CHUNK_STORED && event.prod == 2) {
+            EXPECT_LE(100, event.chunk);
+            EXPECT_LE(prevWhen, event.when);
+            prevWhen = event.when;
+        }
+    }
+}
+
+// Tests recording from multiple threads: each gets its own ring
+TEST_F(FlightRecorderTest, MultipleThreads)
+{
+    std::thread thread{[]{
+        for (unsigned i = 0; i < 10; ++i)
+            FlightRecorder::record(Event::CHUNK_RECV_P2P, 3, i, 1000);
+    }};
+    thread.join();
+    FlightRecorder::dump(pathname); // After the thread exited
+    const auto events = decode();
+    unsigned   found = 0;
+    for (const auto& event : events)
+        if (event.type == Event::CHUNK_RECV_P2P && event.prod == 3)
+            ++found;
+    EXPECT_EQ(10, found);
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
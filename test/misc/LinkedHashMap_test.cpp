@@ -0,0 +1,121 @@
+/**
+ * This file tests the class `LinkedHashMap`
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: LinkedHashMap_test.cpp
+ * @author: Steven R. Emmerson
+ */
+
+#include "LinkedHashMap.h"
+
+#include <gtest/gtest.h>
+#include <string>
+
+namespace {
+
+// The fixture for testing class LinkedHashMap.
+class LinkedHashMapTest : public ::testing::Test {
+ protected:
+};
+
+// Tests default construction
+TEST_F(LinkedHashMapTest, DefaultConstruction) {
+    hycast::LinkedHashMap<int, int> map{};
+    int                             value;
+    EXPECT_FALSE(map.pop(value));
+}
+
+// Tests insertion
+TEST_F(LinkedHashMapTest, Insertion) {
+    hycast::LinkedHashMap<int, int> map{};
+    EXPECT_TRUE(map.insert(1, 10));
+    EXPECT_FALSE(map.insert(1, 20));
+    int value;
+    EXPECT_TRUE(map.pop(value));
+    EXPECT_EQ(10, value);
+    EXPECT_FALSE(map.pop(value));
+}
+
+// Tests that popping returns values in insertion order
+TEST_F(LinkedHashMapTest, InsertionOrder) {
+    hycast::LinkedHashMap<int, int> map{};
+    for (int key = 0; key < 100; ++key)
+        EXPECT_TRUE(map.insert(key, 2*key));
+    for (int key = 0; key < 100; ++key) {
+        int value;
+        EXPECT_TRUE(map.pop(value));
+        EXPECT_EQ(2*key, value);
+    }
+    int value;
+    EXPECT_FALSE(map.pop(value));
+}
+
+// Tests removal by key
+TEST_F(LinkedHashMapTest, Removal) {
+    hycast::LinkedHashMap<int, int> map{};
+    for (int key = 0; key < 10; ++key)
+        EXPECT_TRUE(map.insert(key, 2*key));
+    int key = 0;
+    EXPECT_TRUE(map.remove(key)); // Oldest
+    key = 9;
+    EXPECT_TRUE(map.remove(key)); // Newest
+    key = 5;
+    EXPECT_TRUE(map.remove(key)); // Interior
+    EXPECT_FALSE(map.remove(key));
+    for (int expect : {1, 2, 3, 4, 6, 7, 8}) {
+        int value;
+        EXPECT_TRUE(map.pop(value));
+        EXPECT_EQ(2*expect, value);
+    }
+    int value;
+    EXPECT_FALSE(map.pop(value));
+}
+
+// Tests reuse of removed slots
+TEST_F(LinkedHashMapTest, SlotReuse) {
+    hycast::LinkedHashMap<std::string, int> map{};
+    for (int i = 0; i < 1000; ++i) {
+        const auto key = std::to_string(i);
+        EXPECT_TRUE(map.insert(key, i));
+        if (i >= 8) {
+            int value;
+            EXPECT_TRUE(map.pop(value));
+            EXPECT_EQ(i - 8, value);
+        }
+    }
+    for (int i = 992; i < 1000; ++i) {
+        int value;
+        EXPECT_TRUE(map.pop(value));
+        EXPECT_EQ(i, value);
+    }
+}
+
+// Tests growth past the initial table size
+TEST_F(LinkedHashMapTest, Growth) {
+    hycast::LinkedHashMap<std::string, std::string> map{};
+    for (int i = 0; i < 10000; ++i)
+        EXPECT_TRUE(map.insert(std::to_string(i), std::to_string(2*i)));
+    for (int i = 0; i < 10000; ++i)
+        EXPECT_FALSE(map.insert(std::to_string(i), ""));
+    for (int i = 0; i < 10000; i += 2) {
+        auto key = std::to_string(i);
+        EXPECT_TRUE(map.remove(key));
+    }
+    for (int i = 1; i < 10000; i += 2) {
+        std::string value;
+        EXPECT_TRUE(map.pop(value));
+        EXPECT_EQ(std::to_string(2*i), value);
+    }
+    std::string value;
+    EXPECT_FALSE(map.pop(value));
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
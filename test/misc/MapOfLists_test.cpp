@@ -0,0 +1,110 @@
+/**
+ * This file tests the class `MapOfLists`
+ *
+ * Copyright 2016 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: MapOfLists_test.cpp
+ * @author: Steven R. Emmerson
+ */
+
+#include "MapOfLists.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef hycast::MapOfLists<int, std::string> Map;
+
+std::vector<std::string> valuesOf(
+        const Map& map,
+        const int  key)
+{
+    std::vector<std::string> values;
+    auto                     bounds = map.getValues(key);
+    for (auto iter = bounds.first; iter != bounds.second; ++iter)
+        values.push_back(*iter);
+    return values;
+}
+
+// The fixture for testing class MapOfLists.
+class MapOfListsTest : public ::testing::Test {
+ protected:
+};
+
+// Tests default construction
+TEST_F(MapOfListsTest, DefaultConstruction) {
+    Map  map{};
+    auto bounds = map.getValues(0);
+    EXPECT_TRUE(bounds.first == bounds.second);
+}
+
+// Tests that a key's values iterate in addition order
+TEST_F(MapOfListsTest, AdditionOrder) {
+    Map map{};
+    for (int i = 0; i < 4; ++i) {
+        auto value = std::to_string(i);
+        map.add(1, value);
+    }
+    const auto values = valuesOf(map, 1);
+    ASSERT_EQ(4, values.size());
+    for (int i = 0; i < 4; ++i)
+        EXPECT_EQ(std::to_string(i), values[i]);
+    EXPECT_EQ(0, valuesOf(map, 2).size());
+}
+
+// Tests removing a key
+TEST_F(MapOfListsTest, KeyRemoval) {
+    Map         map{};
+    std::string value{"value"};
+    map.add(1, value);
+    map.add(1, value);
+    map.add(2, value);
+    map.remove(1);
+    EXPECT_EQ(0, valuesOf(map, 1).size());
+    EXPECT_EQ(1, valuesOf(map, 2).size());
+}
+
+// Tests removing a value -- every occurrence, wherever it sits in the list
+TEST_F(MapOfListsTest, ValueRemoval) {
+    Map map{};
+    for (auto name : {"dup", "a", "dup", "b", "dup"}) {
+        std::string value{name};
+        map.add(1, value);
+    }
+    map.remove(1, "dup");
+    auto values = valuesOf(map, 1);
+    ASSERT_EQ(2, values.size());
+    EXPECT_EQ("a", values[0]);
+    EXPECT_EQ("b", values[1]);
+    // Removing the remainder empties the key
+    map.remove(1, "a");
+    map.remove(1, "b");
+    EXPECT_EQ(0, valuesOf(map, 1).size());
+}
+
+// Tests reuse of pooled nodes
+TEST_F(MapOfListsTest, NodeReuse) {
+    Map map{};
+    for (int round = 0; round < 100; ++round) {
+        for (int i = 0; i < 8; ++i) {
+            auto value = std::to_string(i);
+            map.add(round, value);
+        }
+        const auto values = valuesOf(map, round);
+        ASSERT_EQ(8, values.size());
+        for (int i = 0; i < 8; ++i)
+            EXPECT_EQ(std::to_string(i), values[i]);
+        map.remove(round);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,112 @@
+/**
+ * This file tests class `MemBudget`.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: MemBudget_test.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "MemBudget.h"
+
+#include <gtest/gtest.h>
+#include <thread>
+
+namespace {
+
+/// The fixture for testing class `MemBudget`
+class MemBudgetTest : public ::testing::Test
+{
+protected:
+    const size_t ceiling{1000};
+};
+
+// Tests default construction
+TEST_F(MemBudgetTest, DefaultConstruction)
+{
+    hycast::MemBudget budget{};
+    EXPECT_FALSE(budget);
+    EXPECT_EQ(0, budget.getCeiling());
+    // Claims against an unbudgeted instance are ignored
+    budget.claim(1ul << 40);
+    EXPECT_EQ(0, budget.getUsage());
+    EXPECT_EQ(hycast::MemBudget::Level::NONE, budget.getLevel());
+    // Must not block
+    budget.awaitBelow(hycast::MemBudget::Level::SHRINK_RESIDENCE);
+}
+
+// Tests construction
+TEST_F(MemBudgetTest, Construction)
+{
+    hycast::MemBudget budget{ceiling};
+    EXPECT_TRUE(budget);
+    EXPECT_EQ(ceiling, budget.getCeiling());
+    EXPECT_EQ(0, budget.getUsage());
+    EXPECT_THROW(hycast::MemBudget{0}, std::invalid_argument);
+}
+
+// Tests the graduated pressure-levels
+TEST_F(MemBudgetTest, Levels)
+{
+    typedef hycast::MemBudget::Level Level;
+    hycast::MemBudget budget{ceiling};
+    EXPECT_EQ(Level::NONE, budget.getLevel());
+    budget.claim(800);
+    EXPECT_EQ(Level::SHRINK_RESIDENCE, budget.getLevel());
+    budget.claim(100);
+    EXPECT_EQ(Level::COMPRESS_COLD, budget.getLevel());
+    budget.claim(50);
+    EXPECT_EQ(Level::PAUSE_BACKLOG, budget.getLevel());
+    budget.claim(50);
+    EXPECT_EQ(Level::BACKPRESSURE, budget.getLevel());
+    budget.release(1000);
+    EXPECT_EQ(Level::NONE, budget.getLevel());
+    EXPECT_EQ(0, budget.getUsage());
+    // An excess release doesn't underflow
+    budget.release(1);
+    EXPECT_EQ(0, budget.getUsage());
+}
+
+// Tests observation of pressure-level changes
+TEST_F(MemBudgetTest, Observer)
+{
+    typedef hycast::MemBudget::Level Level;
+    hycast::MemBudget budget{ceiling};
+    Level             observed{Level::NONE};
+    unsigned          numChanges{0};
+    budget.observe([&](const Level level) {
+        observed = level;
+        ++numChanges;
+    });
+    budget.claim(100); // Level unchanged
+    EXPECT_EQ(0, numChanges);
+    budget.claim(900);
+    EXPECT_EQ(Level::BACKPRESSURE, observed);
+    budget.release(1000);
+    EXPECT_EQ(Level::NONE, observed);
+    EXPECT_EQ(2, numChanges);
+}
+
+// Tests waiting for pressure to abate
+TEST_F(MemBudgetTest, AwaitBelow)
+{
+    typedef hycast::MemBudget::Level Level;
+    hycast::MemBudget budget{ceiling};
+    budget.claim(ceiling);
+    std::thread thread{[&] {
+        budget.awaitBelow(Level::PAUSE_BACKLOG);
+        EXPECT_LT(budget.getLevel(), Level::PAUSE_BACKLOG);
+    }};
+    budget.release(ceiling/2);
+    thread.join();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
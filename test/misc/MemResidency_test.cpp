@@ -0,0 +1,55 @@
+/**
+ * This file tests the class `MemResidency`.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: MemResidency_test.cpp
+ * @author: Steven R. Emmerson
+ */
+
+#include "error.h"
+#include "MemResidency.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+// The fixture for testing class MemResidency.
+class MemResidencyTest : public ::testing::Test {
+};
+
+// Tests that the locked-memory accounting is readable
+TEST_F(MemResidencyTest, LockedBytes) {
+    // Nothing is locked yet
+    EXPECT_EQ(0u, hycast::MemResidency::lockedBytes());
+}
+
+// Tests pre-faulting the calling thread's stack
+TEST_F(MemResidencyTest, PrefaultStack) {
+    hycast::MemResidency::prefaultStack(0);
+    hycast::MemResidency::prefaultStack(64*1024);
+}
+
+// Tests enabling page locking. The environment might not allow it.
+TEST_F(MemResidencyTest, Enable) {
+    EXPECT_FALSE(hycast::MemResidency::isEnabled());
+    try {
+        hycast::MemResidency::enable();
+        EXPECT_TRUE(hycast::MemResidency::isEnabled());
+        hycast::MemResidency::enable(); // Idempotent
+        EXPECT_LT(0u, hycast::MemResidency::lockedBytes());
+    }
+    catch (const hycast::SystemError& ex) {
+        // Unprivileged or memlock-limited environment
+        EXPECT_FALSE(hycast::MemResidency::isEnabled());
+    }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
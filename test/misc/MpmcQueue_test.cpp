@@ -0,0 +1,95 @@
+/**
+ * This file tests the class `MpmcQueue`
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: MpmcQueue_test.cpp
+ * @author: Steven R. Emmerson
+ */
+
+#include "MpmcQueue.h"
+
+#include <gtest/gtest.h>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// The fixture for testing class MpmcQueue.
+class MpmcQueueTest : public ::testing::Test {
+ protected:
+};
+
+// Tests invalid construction
+TEST_F(MpmcQueueTest, InvalidConstruction) {
+    EXPECT_THROW(hycast::MpmcQueue<int>{0}, std::invalid_argument);
+}
+
+// Tests capacity rounding
+TEST_F(MpmcQueueTest, Capacity) {
+    hycast::MpmcQueue<int> queue{3};
+    EXPECT_EQ(4, queue.getCapacity());
+}
+
+// Tests serial push and pop
+TEST_F(MpmcQueueTest, SerialPushPop) {
+    hycast::MpmcQueue<int> queue{4};
+    EXPECT_TRUE(queue.tryPush(1));
+    EXPECT_TRUE(queue.tryPush(2));
+    int value;
+    EXPECT_TRUE(queue.tryPop(value));
+    EXPECT_EQ(1, value);
+    EXPECT_TRUE(queue.tryPop(value));
+    EXPECT_EQ(2, value);
+    EXPECT_FALSE(queue.tryPop(value));
+}
+
+// Tests the queue becoming full
+TEST_F(MpmcQueueTest, Full) {
+    hycast::MpmcQueue<int> queue{2};
+    EXPECT_TRUE(queue.tryPush(1));
+    EXPECT_TRUE(queue.tryPush(2));
+    EXPECT_FALSE(queue.tryPush(3));
+}
+
+// Tests concurrent producers and consumers
+TEST_F(MpmcQueueTest, Concurrent) {
+    hycast::MpmcQueue<int>   queue{64};
+    const int                numThreads = 4;
+    const int                perThread = 10000;
+    std::vector<std::thread> producers;
+    std::vector<std::thread> consumers;
+    std::mutex               mutex;
+    std::multiset<int>       values;
+    for (int i = 0; i < numThreads; ++i) {
+        producers.emplace_back([&queue, i, perThread] {
+            for (int j = 0; j < perThread; ++j)
+                queue.push(i*perThread + j);
+        });
+        consumers.emplace_back([&queue, &mutex, &values, perThread] {
+            for (int j = 0; j < perThread; ++j) {
+                const int value = queue.pop();
+                std::lock_guard<std::mutex> lock{mutex};
+                values.insert(value);
+            }
+        });
+    }
+    for (auto& thread : producers)
+        thread.join();
+    for (auto& thread : consumers)
+        thread.join();
+    EXPECT_EQ(numThreads*perThread, values.size());
+    for (int i = 0; i < numThreads*perThread; ++i)
+        EXPECT_EQ(1, values.count(i));
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
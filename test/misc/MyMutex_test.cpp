@@ -0,0 +1,68 @@
+/**
+ * This file tests class `MyMutex`.
+ *
+ * Copyright 2016 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: MyMutex_test.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "MyMutex.h"
+
+#include <gtest/gtest.h>
+#include <thread>
+
+namespace {
+
+// The fixture for testing class MyMutex.
+class MyMutexTest : public ::testing::Test
+{
+protected:
+    hycast::MyMutex mutex{"MyMutex_test"};
+};
+
+// Tests default construction
+TEST_F(MyMutexTest, DefaultConstruction) {
+    hycast::MyMutex mutex{};
+}
+
+// Tests lock ownership
+TEST_F(MyMutexTest, LockOwnership) {
+#if !defined(NDEBUG) && !defined(MUTEX_PROFILING)
+    EXPECT_FALSE(mutex.currentThreadHasLock());
+#endif
+    mutex.lock();
+    EXPECT_TRUE(mutex.currentThreadHasLock());
+    mutex.unlock();
+}
+
+// Tests that another thread doesn't own the lock
+TEST_F(MyMutexTest, OtherThreadOwnership) {
+    mutex.lock();
+    bool otherHasLock = true;
+    std::thread thread{[this,&otherHasLock]{
+            otherHasLock = mutex.currentThreadHasLock();}};
+    thread.join();
+    mutex.unlock();
+#if !defined(NDEBUG) && !defined(MUTEX_PROFILING)
+    EXPECT_FALSE(otherHasLock);
+#endif
+}
+
+// Tests try_lock
+TEST_F(MyMutexTest, TryLock) {
+    EXPECT_TRUE(mutex.try_lock());
+    std::thread thread{[this]{EXPECT_FALSE(mutex.try_lock());}};
+    thread.join();
+    mutex.unlock();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
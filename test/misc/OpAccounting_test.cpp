@@ -0,0 +1,132 @@
+/**
+ * This file tests class `OpAccounting`. The accounting tests only run in an
+ * accounting build (`configure --enable-op-accounting`); otherwise the class
+ * is a no-op and that's what's verified. The budget test is the pattern CI
+ * uses to lock in allocation-elimination work: assert the per-operation
+ * allocation count of a workload against a fixed number.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: OpAccounting_test.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "MyMutex.h"
+#include "OpAccounting.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+/// The fixture for testing class `OpAccounting`
+class OpAccountingTest : public ::testing::Test
+{};
+
+#ifdef OP_ACCOUNTING
+
+// Tests that allocations inside a scope are attributed to its operation
+TEST_F(OpAccountingTest, AllocAttribution)
+{
+    const auto opsBefore =
+            hycast::OpAccounting::getOps(hycast::OpAccounting::CHUNK_RECV);
+    const auto allocsBefore =
+            hycast::OpAccounting::getAllocs(hycast::OpAccounting::CHUNK_RECV);
+    const auto bytesBefore = hycast::OpAccounting::getAllocBytes(
+            hycast::OpAccounting::CHUNK_RECV);
+    {
+        hycast::OpAccounting::Scope scope{hycast::OpAccounting::CHUNK_RECV};
+        delete[] new char[1000];
+    }
+    EXPECT_EQ(opsBefore + 1,
+            hycast::OpAccounting::getOps(hycast::OpAccounting::CHUNK_RECV));
+    EXPECT_EQ(allocsBefore + 1,
+            hycast::OpAccounting::getAllocs(hycast::OpAccounting::CHUNK_RECV));
+    EXPECT_LE(bytesBefore + 1000, hycast::OpAccounting::getAllocBytes(
+            hycast::OpAccounting::CHUNK_RECV));
+}
+
+// Tests that scopes nest: inner costs go to the inner operation and the
+// outer operation is restored
+TEST_F(OpAccountingTest, Nesting)
+{
+    const auto outerBefore =
+            hycast::OpAccounting::getAllocs(hycast::OpAccounting::CHUNK_RECV);
+    const auto innerBefore =
+            hycast::OpAccounting::getAllocs(hycast::OpAccounting::STORE_ADD);
+    {
+        hycast::OpAccounting::Scope outer{hycast::OpAccounting::CHUNK_RECV};
+        {
+            hycast::OpAccounting::Scope inner{
+                    hycast::OpAccounting::STORE_ADD};
+            delete new char;
+        }
+        delete new char;
+    }
+    EXPECT_EQ(outerBefore + 1,
+            hycast::OpAccounting::getAllocs(hycast::OpAccounting::CHUNK_RECV));
+    EXPECT_EQ(innerBefore + 1,
+            hycast::OpAccounting::getAllocs(hycast::OpAccounting::STORE_ADD));
+}
+
+// Tests that MyMutex acquisitions are attributed to the current operation
+TEST_F(OpAccountingTest, LockAttribution)
+{
+    const auto locksBefore =
+            hycast::OpAccounting::getLocks(hycast::OpAccounting::NOTIFY);
+    hycast::MyMutex mutex{"OpAccounting_test"};
+    {
+        hycast::OpAccounting::Scope scope{hycast::OpAccounting::NOTIFY};
+        mutex.lock();
+        mutex.unlock();
+    }
+    EXPECT_EQ(locksBefore + 1,
+            hycast::OpAccounting::getLocks(hycast::OpAccounting::NOTIFY));
+}
+
+// The CI budget pattern: run a workload under a scope and assert its
+// per-execution allocation count against a fixed budget
+TEST_F(OpAccountingTest, Budget)
+{
+    const auto opsBefore =
+            hycast::OpAccounting::getOps(hycast::OpAccounting::NOTIFY);
+    const auto allocsBefore =
+            hycast::OpAccounting::getAllocs(hycast::OpAccounting::NOTIFY);
+    const unsigned numOps = 100;
+    for (unsigned i = 0; i < numOps; ++i) {
+        hycast::OpAccounting::Scope scope{hycast::OpAccounting::NOTIFY};
+        // An allocation-free workload
+    }
+    EXPECT_EQ(opsBefore + numOps,
+            hycast::OpAccounting::getOps(hycast::OpAccounting::NOTIFY));
+    const unsigned long budget = 0; // Allocations per operation
+    EXPECT_LE(hycast::OpAccounting::getAllocs(hycast::OpAccounting::NOTIFY)
+            - allocsBefore, budget*numOps);
+}
+
+#else
+
+// Tests that a non-accounting build costs nothing and reports nothing
+TEST_F(OpAccountingTest, Disabled)
+{
+    {
+        hycast::OpAccounting::Scope scope{hycast::OpAccounting::CHUNK_RECV};
+        delete new char;
+    }
+    EXPECT_EQ(0,
+            hycast::OpAccounting::getOps(hycast::OpAccounting::CHUNK_RECV));
+    EXPECT_EQ(0,
+            hycast::OpAccounting::getAllocs(hycast::OpAccounting::CHUNK_RECV));
+}
+
+#endif // OP_ACCOUNTING
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,75 @@
+/**
+ * This file tests the class `SimClock`. The switch to virtual mode is
+ * process-wide and irreversible, so this test lives in its own program and
+ * enables virtual mode before exercising any time-driven component.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: SimClock_test.cpp
+ * @author: Steven R. Emmerson
+ */
+
+#include "DelayQueue.h"
+#include "FixedDelayQueue.h"
+#include "SimClock.h"
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+// The fixture for testing class SimClock.
+class SimClockTest : public ::testing::Test {
+protected:
+    SimClockTest()
+    {
+        hycast::SimClock::enableVirtual(); // Idempotent
+    }
+};
+
+// Tests that virtual time stands still until advanced
+TEST_F(SimClockTest, VirtualTimeStandsStill) {
+    EXPECT_TRUE(hycast::SimClock::isVirtual());
+    const auto before = hycast::SimClock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    EXPECT_EQ(before, hycast::SimClock::now());
+    hycast::SimClock::advance(std::chrono::seconds{1});
+    EXPECT_EQ(before + std::chrono::seconds{1}, hycast::SimClock::now());
+}
+
+// Tests that an hour-long delay-queue residence elapses in virtual time
+TEST_F(SimClockTest, DelayQueuePopsOnVirtualTime) {
+    hycast::DelayQueue<int, std::chrono::seconds> delayQ{};
+    delayQ.push(1, std::chrono::seconds{3600});
+    int        value{0};
+    std::thread popper{[&delayQ,&value]{value = delayQ.pop();}};
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    EXPECT_EQ(0, value);
+    hycast::SimClock::advance(std::chrono::hours{1});
+    popper.join();
+    EXPECT_EQ(1, value);
+}
+
+// Tests that a fixed-delay queue's residence elapses in virtual time
+TEST_F(SimClockTest, FixedDelayQueuePopsOnVirtualTime) {
+    hycast::FixedDelayQueue<int, std::chrono::seconds> delayQ{
+            std::chrono::seconds{3600}};
+    delayQ.push(1);
+    std::thread advancer{[]{
+            std::this_thread::sleep_for(std::chrono::milliseconds{20});
+            hycast::SimClock::advance(std::chrono::hours{1});
+    }};
+    EXPECT_EQ(1, delayQ.pop());
+    advancer.join();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,136 @@
+/**
+ * This file tests the class `StealingExecutor`.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: StealingExecutor_test.cpp
+ * @author: Steven R. Emmerson
+ */
+
+#include "error.h"
+#include "StealingExecutor.h"
+#include "Thread.h"
+
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// The fixture for testing class StealingExecutor.
+class StealingExecutorTest : public ::testing::Test {
+};
+
+// Tests construction of void executor
+TEST_F(StealingExecutorTest, VoidConstruction) {
+    hycast::StealingExecutor<void> executor{2};
+}
+
+// Tests construction of int executor
+TEST_F(StealingExecutorTest, IntConstruction) {
+    hycast::StealingExecutor<int> executor{2};
+}
+
+// Tests executing void task
+TEST_F(StealingExecutorTest, VoidExecution) {
+    hycast::StealingExecutor<void> executor{2};
+    auto future = executor.submit([]{});
+    EXPECT_FALSE(future.wasCanceled());
+    future.getResult();
+}
+
+// Tests executing int task
+TEST_F(StealingExecutorTest, IntExecution) {
+    hycast::StealingExecutor<int> executor{2};
+    auto future = executor.submit([]{return 1;});
+    EXPECT_FALSE(future.wasCanceled());
+    EXPECT_EQ(1, future.getResult());
+}
+
+// Tests that workers are reused across many tasks
+TEST_F(StealingExecutorTest, ManyTasks) {
+    hycast::StealingExecutor<int>    executor{4};
+    std::vector<hycast::Future<int>> futures;
+    const int                        numTasks = 200;
+    for (int i = 0; i < numTasks; ++i)
+        futures.push_back(executor.submit([i]{return i;}));
+    for (int i = 0; i < numTasks; ++i)
+        EXPECT_EQ(i, futures[i].getResult());
+}
+
+// Tests that an idle worker steals from a busy one
+TEST_F(StealingExecutorTest, Stealing) {
+    hycast::StealingExecutor<void> executor{2};
+    std::atomic_int                numDone{0};
+    std::vector<hycast::Future<void>> futures;
+    for (int i = 0; i < 8; ++i) {
+        futures.push_back(executor.submit([&numDone]{
+                std::this_thread::sleep_for(std::chrono::milliseconds{10});
+                ++numDone;
+        }));
+    }
+    for (auto& future : futures)
+        future.getResult();
+    EXPECT_EQ(8, numDone.load());
+}
+
+// Tests that a worker serves a higher-priority queued task first
+TEST_F(StealingExecutorTest, PriorityLanes) {
+    hycast::StealingExecutor<void> executor{1};
+    hycast::Barrier                barrier{2};
+    std::vector<int>               order;
+    auto blocker = executor.submit([&barrier]{barrier.wait();});
+    auto low = executor.submit([&order]{order.push_back(0);},
+            hycast::TaskPriority::LOW);
+    auto high = executor.submit([&order]{order.push_back(1);},
+            hycast::TaskPriority::HIGH);
+    barrier.wait();
+    low.getResult();
+    high.getResult();
+    ASSERT_EQ(2u, order.size());
+    EXPECT_EQ(1, order[0]);
+    EXPECT_EQ(0, order[1]);
+}
+
+// Tests detached fire-and-forget posting
+TEST_F(StealingExecutorTest, DetachedPosting) {
+    hycast::StealingExecutor<void> executor{2};
+    std::atomic_int                numDone{0};
+    std::atomic_int                numErrors{0};
+    executor.setErrorHandler([&numErrors](const std::exception& ex) {
+            ++numErrors;});
+    for (int i = 0; i < 8; ++i)
+        executor.post([&numDone]{++numDone;});
+    executor.post([]{throw std::runtime_error("Faux error");});
+    while (numDone.load() < 8 || numErrors.load() < 1)
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    EXPECT_EQ(8, numDone.load());
+    EXPECT_EQ(1, numErrors.load());
+}
+
+// Tests that shutdown cancels queued tasks
+TEST_F(StealingExecutorTest, ShutdownCancelsQueued) {
+    hycast::StealingExecutor<void> executor{1};
+    auto blocker = executor.submit([]{
+            std::this_thread::sleep_for(std::chrono::milliseconds{100});
+    });
+    auto queued = executor.submit([]{});
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    executor.shutdown(false);
+    EXPECT_THROW(executor.submit([]{}), std::logic_error);
+    blocker.getResult();
+    EXPECT_TRUE(queued.wasCanceled());
+    executor.awaitTermination();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
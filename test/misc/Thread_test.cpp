@@ -22,6 +22,7 @@
 #include <iostream>
 #include <mutex>
 #include <random>
+#include <sched.h>
 #include <unistd.h>
 
 namespace {
@@ -209,6 +210,55 @@ TEST_F(ThreadTest, DefaultConstruction)
     EXPECT_NO_THROW(thread.cancel());
 }
 
+// Tests CPU affinity
+TEST_F(ThreadTest, Affinity)
+{
+    // Current thread
+    hycast::Thread::setCurrentAffinity(std::vector<unsigned>{0});
+    EXPECT_EQ(0, ::sched_getcpu());
+    // Instance
+    hycast::Thread thread{[]{
+        hycast::Canceler canceler{};
+        ::pause();
+    }};
+    EXPECT_NO_THROW(thread.setAffinity(std::vector<unsigned>{0}));
+    EXPECT_THROW(thread.setAffinity(std::vector<unsigned>{}),
+            hycast::InvalidArgument);
+    thread.cancel();
+    thread.join();
+    // Default-constructed instance
+    hycast::Thread defaultThread{};
+    EXPECT_THROW(defaultThread.setAffinity(std::vector<unsigned>{0}),
+            hycast::LogicError);
+}
+
+// Tests scheduling-policy control
+TEST_F(ThreadTest, Scheduling)
+{
+    hycast::Thread thread{[]{
+        hycast::Canceler canceler{};
+        ::pause();
+    }};
+    // SCHED_OTHER at priority 0 is the status quo and always permitted
+    EXPECT_NO_THROW(thread.setScheduling(SCHED_OTHER, 0));
+    // Unsupported policy
+    EXPECT_THROW(thread.setScheduling(-1, 0), hycast::InvalidArgument);
+    // Out-of-range priority (SCHED_FIFO priorities start at 1)
+    EXPECT_THROW(thread.setScheduling(SCHED_FIFO, 0),
+            hycast::InvalidArgument);
+    thread.cancel();
+    thread.join();
+    // Default-constructed instance
+    hycast::Thread defaultThread{};
+    EXPECT_THROW(defaultThread.setScheduling(SCHED_OTHER, 0),
+            hycast::LogicError);
+    // Real-time promotion needs privilege, so only try it when we have it
+    if (::geteuid() == 0) {
+        EXPECT_NO_THROW(hycast::Thread::setCurrentScheduling(SCHED_FIFO, 1));
+        hycast::Thread::setCurrentScheduling(SCHED_OTHER, 0);
+    }
+}
+
 static void staticFunc(const int i)
 {
     arg = i;
@@ -392,6 +442,28 @@ TEST_F(ThreadTest, MoveAssignmentAndNonMemberCancellation)
     EXPECT_EQ(id, threadId);
 }
 
+// Tests cooperative cancellation
+TEST_F(ThreadTest, CooperativeCancellation)
+{
+    ASSERT_EQ(0, hycast::Thread::size());
+    EXPECT_FALSE(hycast::Thread::cancelRequested()); // Not a `Thread`
+    hycast::Thread thread{[this]{
+        hycast::Thread::enableCooperativeCancel();
+        hycast::Interrupter interrupter{[this]{
+                LockGuard lock{mutex};
+                cond.notify_all();
+        }};
+        markAndNotify();
+        UniqueLock lock{mutex};
+        while (!hycast::Thread::cancelRequested())
+            cond.wait(lock);
+    }};
+    waitOnCallable();
+    thread.cancel(); // Sets the flag and invokes the interrupter
+    thread.join();   // The thread returned normally; no unwinding
+    EXPECT_EQ(0, hycast::Thread::size());
+}
+
 // Tests setting cancelability
 TEST_F(ThreadTest, SettingCancelability)
 {
@@ -473,6 +545,20 @@ TEST_F(ThreadTest, Receiving) {
     Receiving{};
 }
 
+// Tests setting the default stack size of subsequently-created threads
+TEST_F(ThreadTest, DefaultStackSize) {
+    const auto previous = hycast::Thread::getDefaultStackSize();
+    EXPECT_THROW(hycast::Thread::setDefaultStackSize(0),
+            hycast::InvalidArgument);
+    const size_t small{256*1024};
+    hycast::Thread::setDefaultStackSize(small);
+    EXPECT_GE(hycast::Thread::getDefaultStackSize(), small);
+    hycast::Thread thread{[]{}}; // Thread creation still works
+    thread.join();
+    if (previous) // Restore; 0 means the platform default
+        hycast::Thread::setDefaultStackSize(previous);
+}
+
 }  // namespace
 
 int main(int argc, char **argv) {
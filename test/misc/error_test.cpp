@@ -83,6 +83,21 @@ TEST_F(ErrorTest, SystemError) {
 }
 
 
+// Tests that the lazily-formatted what() message is place-stamped
+TEST_F(ErrorTest, DeferredWhat) {
+    const auto        ex = hycast::RUNTIME_ERROR("Deferred message");
+    const std::string what{ex.what()};
+    EXPECT_NE(std::string::npos, what.find("error_test.cpp:"));
+    EXPECT_NE(std::string::npos, what.find("Deferred message"));
+    EXPECT_STREQ(what.c_str(), ex.what()); // Formatted once, then cached
+    const auto        sysEx = hycast::SystemError(__FILE__, __LINE__,
+            "System error", 2);
+    const std::string sysWhat{sysEx.what()};
+    EXPECT_NE(std::string::npos, sysWhat.find("error_test.cpp:"));
+    // The error description survives the deferral
+    EXPECT_NE(std::string::npos, sysWhat.find("System error"));
+}
+
 static void throwNestedException() {
     try {
         try {
@@ -0,0 +1,75 @@
+/**
+ * This file tests the classes `HandoffSender` and `HandoffReceiver`.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: Handoff_test.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "Handoff.h"
+
+#include <cstring>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+namespace {
+
+/// The fixture for testing classes `HandoffSender` and `HandoffReceiver`
+class HandoffTest : public ::testing::Test
+{
+protected:
+    const std::string pathname{"/tmp/Handoff_test.sock"};
+};
+
+// Tests invalid construction
+TEST_F(HandoffTest, InvalidConstruction)
+{
+    const std::string tooLong(200, 'x');
+    EXPECT_THROW(hycast::HandoffReceiver{"/tmp/" + tooLong},
+            std::invalid_argument);
+    // No receiver is listening
+    EXPECT_THROW(hycast::HandoffSender{pathname}, std::system_error);
+}
+
+// Tests passing descriptors between a sender and a receiver
+TEST_F(HandoffTest, RoundTrip)
+{
+    hycast::HandoffReceiver receiver{pathname};
+    int                     fds[2];
+    ASSERT_EQ(0, ::pipe(fds));
+    {
+        hycast::HandoffSender sender{pathname};
+        EXPECT_THROW(sender.send("", fds[0]), std::invalid_argument);
+        sender.send("pipe.rd", fds[0]);
+        sender.send("pipe.wr", fds[1]);
+    } // Destruction completes the handoff
+    std::string label{};
+    const int   rdFd = receiver.recv(label);
+    EXPECT_EQ("pipe.rd", label);
+    ASSERT_LE(0, rdFd);
+    const int   wrFd = receiver.recv(label);
+    EXPECT_EQ("pipe.wr", label);
+    ASSERT_LE(0, wrFd);
+    // The handoff is complete
+    EXPECT_EQ(-1, receiver.recv(label));
+    // The received descriptors reference the same open file descriptions
+    EXPECT_EQ(5, ::write(wrFd, "hello", 5));
+    char buf[8] = {};
+    EXPECT_EQ(5, ::read(rdFd, buf, sizeof(buf)));
+    EXPECT_STREQ("hello", buf);
+    ::close(fds[0]);
+    ::close(fds[1]);
+    ::close(rdFd);
+    ::close(wrFd);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
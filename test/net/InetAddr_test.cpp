@@ -99,6 +99,17 @@ TEST_F(InetAddrTest, ConstructionFromHostname) {
     EXPECT_STREQ(HOSTNAME1, addr1.to_string().data());
 }
 
+// Tests eager resolution
+TEST_F(InetAddrTest, Resolution) {
+    hycast::InetAddr addr1{IPV4_ADDR1};
+    addr1.resolve(); // No-op for an IP-based address
+    hycast::InetAddr addr2{"localhost"};
+    addr2.resolve(); // Resolves and caches
+    // The cached resolution is shared by all copies
+    hycast::InetAddr addr3{addr2};
+    addr3.resolve();
+}
+
 // Tests copy construction
 TEST_F(InetAddrTest, CopyConstruction) {
     hycast::InetAddr addr1{IPV4_ADDR1};
@@ -137,6 +148,24 @@ TEST_F(InetAddrTest, HostnameToSocketAddress) {
     EXPECT_EQ(inet_addr("127.0.0.1"), sockAddrIn->sin_addr.s_addr);
 }
 
+// Tests extracting the address of a given family
+TEST_F(InetAddrTest, FamilyExtraction) {
+    hycast::InetAddr ipv4Addr{IPV4_ADDR1};
+    hycast::InetAddr famAddr;
+    EXPECT_TRUE(ipv4Addr.getInetAddr(AF_INET, famAddr));
+    EXPECT_STREQ(IPV4_ADDR1, famAddr.to_string().data());
+    EXPECT_FALSE(ipv4Addr.getInetAddr(AF_INET6, famAddr));
+
+    hycast::InetAddr ipv6Addr{IPV6_ADDR1};
+    EXPECT_TRUE(ipv6Addr.getInetAddr(AF_INET6, famAddr));
+    EXPECT_STREQ(IPV6_ADDR1, famAddr.to_string().data());
+    EXPECT_FALSE(ipv6Addr.getInetAddr(AF_INET, famAddr));
+
+    hycast::InetAddr nameAddr{"localhost"};
+    EXPECT_TRUE(nameAddr.getInetAddr(AF_INET, famAddr));
+    EXPECT_STREQ("127.0.0.1", famAddr.to_string().data());
+}
+
 // Tests comparisons
 TEST_F(InetAddrTest, Comparisons) {
     EXPECT_EQ(ipv4Addr1, ipv4Addr1);
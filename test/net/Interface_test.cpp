@@ -45,6 +45,38 @@ TEST_F(InterfaceTest, GetIPv4Addr)
     std::cout << "IPv4 addr = " << inetAddr.to_string() << '\n';
 }
 
+// Tests getting the name
+TEST_F(InterfaceTest, GetName)
+{
+    hycast::Interface iface{ethernetIfaceName};
+    EXPECT_EQ(ethernetIfaceName, iface.getName());
+}
+
+// Tests construction of an interface-set
+TEST_F(InterfaceTest, InterfaceSetConstruction)
+{
+    hycast::InterfaceSet emptySet{};
+    EXPECT_FALSE(emptySet);
+    EXPECT_THROW(hycast::InterfaceSet{std::vector<hycast::Interface>{}},
+            std::invalid_argument);
+
+    hycast::InterfaceSet ifaceSet{{hycast::Interface{ethernetIfaceName}}};
+    EXPECT_TRUE(ifaceSet);
+    EXPECT_EQ(1, ifaceSet.size());
+}
+
+// Tests acquiring and releasing a source address
+TEST_F(InterfaceTest, InterfaceSetAcquireRelease)
+{
+    hycast::Interface    iface{ethernetIfaceName};
+    hycast::InterfaceSet ifaceSet{{iface}};
+    auto srcAddr = ifaceSet.acquire(AF_INET);
+    EXPECT_EQ(iface.getInetAddr(AF_INET), srcAddr);
+    ifaceSet.release(srcAddr);
+    // Releasing an unacquired address is benign
+    ifaceSet.release(hycast::InetAddr{"128.117.140.56"});
+}
+
 #if SUPPORTS_IPV6
 // Tests getting IPv6 address
 TEST_F(InterfaceTest, GetIPv6Addr)
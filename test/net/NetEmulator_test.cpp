@@ -0,0 +1,122 @@
+/**
+ * This file tests class `NetEmulator`.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: NetEmulator_test.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "NetEmulator.h"
+
+#include <chrono>
+#include <gtest/gtest.h>
+
+namespace {
+
+typedef std::chrono::steady_clock             Clock;
+typedef std::chrono::duration<double>         Seconds;
+
+/// The fixture for testing class `NetEmulator`
+class NetEmulatorTest : public ::testing::Test
+{
+protected:
+    const unsigned seed{1};
+
+    /// Returns the wall-clock seconds a delivery of `nbytes` was delayed
+    double timeDelay(
+            const hycast::NetEmulator& emulator,
+            const size_t               nbytes)
+    {
+        const auto start = Clock::now();
+        emulator.delay(nbytes);
+        return Seconds{Clock::now() - start}.count();
+    }
+};
+
+// Tests default construction: disabled, a pass-through
+TEST_F(NetEmulatorTest, DefaultConstruction)
+{
+    hycast::NetEmulator emulator{};
+    EXPECT_FALSE(emulator);
+}
+
+// Tests construction: enabled but initially unmolesting
+TEST_F(NetEmulatorTest, Construction)
+{
+    hycast::NetEmulator emulator{seed};
+    EXPECT_TRUE(emulator);
+    for (unsigned i = 0; i < 100; ++i)
+        EXPECT_FALSE(emulator.shouldDrop());
+    EXPECT_GT(0.01, timeDelay(emulator, 1000000));
+}
+
+// Tests parameter validation
+TEST_F(NetEmulatorTest, Validation)
+{
+    hycast::NetEmulator emulator{seed};
+    EXPECT_THROW(emulator.setBurstLoss(1.5, 0, 0, 0),
+            std::invalid_argument);
+    EXPECT_THROW(emulator.setBurstLoss(0, -0.1, 0, 0),
+            std::invalid_argument);
+    EXPECT_THROW(emulator.setLatency(-1), std::invalid_argument);
+    EXPECT_THROW(emulator.setBandwidth(0), std::invalid_argument);
+}
+
+// Tests Gilbert-Elliott burst-loss at its extremes
+TEST_F(NetEmulatorTest, BurstLoss)
+{
+    hycast::NetEmulator emulator{seed};
+    // Always in the bad state and the bad state always loses
+    emulator.setBurstLoss(1, 0, 0, 1);
+    for (unsigned i = 0; i < 100; ++i)
+        EXPECT_TRUE(emulator.shouldDrop());
+    // Never leaves the good state and the good state never loses
+    emulator.setBurstLoss(0, 1, 0, 1);
+    emulator.setBurstLoss(0, 1, 0, 0); // Chain may still be in bad state
+    for (unsigned i = 0; i < 100; ++i)
+        EXPECT_FALSE(emulator.shouldDrop());
+}
+
+// Tests that a seed makes the loss pattern reproducible
+TEST_F(NetEmulatorTest, Reproducibility)
+{
+    hycast::NetEmulator emulator1{seed};
+    hycast::NetEmulator emulator2{seed};
+    emulator1.setBurstLoss(0.1, 0.3, 0.01, 0.5);
+    emulator2.setBurstLoss(0.1, 0.3, 0.01, 0.5);
+    for (unsigned i = 0; i < 1000; ++i)
+        EXPECT_EQ(emulator1.shouldDrop(), emulator2.shouldDrop());
+}
+
+// Tests added latency
+TEST_F(NetEmulatorTest, Latency)
+{
+    hycast::NetEmulator emulator{seed};
+    emulator.setLatency(0.05, 0.02);
+    for (unsigned i = 0; i < 5; ++i)
+        EXPECT_LE(0.03, timeDelay(emulator, 1000));
+}
+
+// Tests the bandwidth cap
+TEST_F(NetEmulatorTest, Bandwidth)
+{
+    hycast::NetEmulator emulator{seed};
+    emulator.setBandwidth(1000000); // 1 MB/s
+    // 300 kB at 1 MB/s is 0.3 s, however it's divided among deliveries
+    const auto start = Clock::now();
+    for (unsigned i = 0; i < 3; ++i)
+        emulator.delay(100000);
+    EXPECT_LE(0.25, Seconds{Clock::now() - start}.count());
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -82,6 +82,18 @@ void runClient(hycast::SctpSock sock)
     sock.recvv(iov, sizeof(iov)/sizeof(iov[0]), 0);
     for (unsigned i = 0; i < sizeof(outBuf); ++i)
         EXPECT_EQ(outBuf[i], inBuf[i]);
+
+    // Test a partially-reliable (timed) send: on an uncongested association
+    // the message must still arrive
+    uint8_t prBuf[10];
+    (void)memset(prBuf, 0x5a, sizeof(prBuf));
+    sock.send(1, prBuf, sizeof(prBuf), 5000);
+    size = sock.getSize();
+    EXPECT_EQ(sizeof(prBuf), size);
+    EXPECT_EQ(1, sock.getStreamId());
+    char prInBuf[sizeof(prBuf)];
+    sock.recv(prInBuf, size);
+    EXPECT_TRUE(memcmp(prInBuf, prBuf, size) == 0);
 }
 
 // The fixture for testing class Socket.
@@ -223,6 +235,17 @@ TEST_F(SctpTest, ReceiveBufferSize) {
     EXPECT_TRUE(size < s.getRecvBufSize());
 }
 
+// Tests setting the Differentiated Services code-point
+TEST_F(SctpTest, Dscp) {
+    hycast::SrvrSctpSock s{srvrAddr};
+    s.setDscp(46); // Expedited forwarding
+    int       tos;
+    socklen_t len = sizeof(tos);
+    EXPECT_EQ(0, ::getsockopt(s.getSock(), IPPROTO_IP, IP_TOS, &tos, &len));
+    EXPECT_EQ(46 << 2, tos);
+    EXPECT_THROW(s.setDscp(64), std::invalid_argument);
+}
+
 // Tests equality operator
 TEST_F(SctpTest, EqualityOperator) {
     hycast::SrvrSctpSock s1{srvrAddr};
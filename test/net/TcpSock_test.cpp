@@ -0,0 +1,194 @@
+/**
+ * This file tests the class `TcpSock`.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYRIGHT in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: TcpSock_test.cpp
+ * @author: Steven R. Emmerson
+ */
+
+#include "error.h"
+#include "InetSockAddr.h"
+#include "Interface.h"
+#include "MsgSock.h"
+#include "TcpSock.h"
+
+#include <cstring>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+void runServer(hycast::SrvrTcpSock serverSock)
+{
+    hycast::TcpSock connSock(serverSock.accept());
+    for (;;) {
+        uint32_t size = connSock.getSize();
+        if (size == 0)
+            break;
+        unsigned streamId = connSock.getStreamId();
+        char buf[size];
+        connSock.recv(buf, size);
+        connSock.send(streamId, buf, size);
+    }
+}
+
+void runClient(hycast::TcpSock sock)
+{
+    // Test TcpSock::send() and TcpSock::recv()
+    for (int i = 0; i < 100; ++i) {
+        unsigned outStream = i % sock.getNumStreams();
+        uint8_t outBuf[1+i];
+        (void)memset(outBuf, 0xbd, sizeof(outBuf));
+        sock.send(outStream, outBuf, sizeof(outBuf));
+        uint32_t size = sock.getSize();
+        EXPECT_EQ(sizeof(outBuf), size);
+        unsigned inStream = sock.getStreamId();
+        EXPECT_EQ(inStream, outStream);
+        char inBuf[size];
+        sock.recv(inBuf, size);
+        EXPECT_TRUE(memcmp(inBuf, outBuf, size) == 0);
+    }
+
+    // Test TcpSock::sendv() and TcpSock::recvv()
+    uint8_t outBuf[100];
+    for (unsigned i = 0; i < sizeof(outBuf); ++i)
+        outBuf[i] = i;
+    struct iovec iov[5];
+    for (int i = 0; i < 5; ++i) {
+        iov[i].iov_base = outBuf + i*20;
+        iov[i].iov_len = 20;
+    }
+    sock.sendv(0, iov, sizeof(iov)/sizeof(iov[0]));
+    uint32_t size = sock.getSize();
+    EXPECT_EQ(sizeof(outBuf), size);
+    unsigned inStream = sock.getStreamId();
+    EXPECT_EQ(0, inStream);
+    char inBuf[size];
+
+    // Peek at the message; it must remain the current one
+    sock.recv(inBuf, size, MSG_PEEK);
+    EXPECT_TRUE(memcmp(inBuf, outBuf, size) == 0);
+    EXPECT_EQ(sizeof(outBuf), sock.getSize());
+
+    (void)memset(inBuf, 0, sizeof(inBuf));
+    for (int i = 0; i < 5; ++i) {
+        iov[i].iov_base = inBuf + i*20;
+        iov[i].iov_len = 20;
+    }
+    sock.recvv(iov, sizeof(iov)/sizeof(iov[0]), 0);
+    for (unsigned i = 0; i < sizeof(outBuf); ++i)
+        EXPECT_EQ(outBuf[i], inBuf[i]);
+
+    // Test record-boundary preservation with a short read
+    sock.send(1, outBuf, sizeof(outBuf));
+    sock.send(2, outBuf, 10);
+    char shortBuf[10];
+    sock.recv(shortBuf, sizeof(shortBuf)); // Excess payload is discarded
+    EXPECT_EQ(10, sock.getSize());
+    EXPECT_EQ(2, sock.getStreamId());
+    sock.discard();
+}
+
+// The fixture for testing class `TcpSock`
+class TcpSockTest : public ::testing::Test
+{
+protected:
+    const in_port_t         MY_PORT_NUM = 38801;
+    const int               numStreams = 5;
+    const hycast::Interface nic{"lo"};
+    hycast::InetSockAddr    srvrAddr{nic.getInetAddr(AF_INET), MY_PORT_NUM};
+};
+
+// Tests invalid construction
+TEST_F(TcpSockTest, InvalidConstruction)
+{
+    EXPECT_THROW(hycast::TcpSock{0}, std::invalid_argument);
+}
+
+// Tests a round-trip over the loopback interface
+TEST_F(TcpSockTest, RoundTrip)
+{
+    hycast::SrvrTcpSock srvrSock{srvrAddr, numStreams};
+    srvrSock.listen();
+    std::thread srvrThread{[srvrSock]{runServer(srvrSock);}};
+
+    hycast::TcpSock clntSock{numStreams};
+    clntSock.connect(srvrAddr);
+    EXPECT_EQ(srvrAddr, clntSock.getRemoteAddr());
+    runClient(clntSock);
+
+    clntSock = hycast::TcpSock{}; // Closes connection; server returns
+    srvrThread.join();
+}
+
+// Tests kernel forwarding of a message's payload between two connections
+TEST_F(TcpSockTest, ForwardsPayload)
+{
+    const hycast::InetSockAddr relayAddr{nic.getInetAddr(AF_INET),
+            static_cast<in_port_t>(MY_PORT_NUM + 1)};
+
+    hycast::SrvrTcpSock ingressSrvr{relayAddr, numStreams};
+    ingressSrvr.listen();
+    hycast::SrvrTcpSock egressSrvr{srvrAddr, numStreams};
+    egressSrvr.listen();
+
+    hycast::TcpSock upstream{numStreams};
+    upstream.connect(relayAddr);
+    hycast::TcpSock ingress{ingressSrvr.accept()};
+    hycast::TcpSock egress{numStreams};
+    egress.connect(srvrAddr);
+    hycast::TcpSock downstream{egressSrvr.accept()};
+
+    // Payload larger than a default pipe so forwarding must iterate
+    std::vector<uint8_t> outBuf(200000);
+    for (size_t i = 0; i < outBuf.size(); ++i)
+        outBuf[i] = static_cast<uint8_t>(i);
+    std::thread sendThread{[&upstream,&outBuf]{
+            upstream.send(3, outBuf.data(), outBuf.size());}};
+    std::thread fwdThread{[&ingress,&egress,&outBuf]{
+            EXPECT_EQ(outBuf.size(), ingress.forward(egress, 2));}};
+
+    EXPECT_EQ(outBuf.size(), downstream.getSize());
+    EXPECT_EQ(2, downstream.getStreamId());
+    std::vector<uint8_t> inBuf(outBuf.size());
+    downstream.recv(inBuf.data(), inBuf.size());
+    EXPECT_TRUE(memcmp(inBuf.data(), outBuf.data(), inBuf.size()) == 0);
+    sendThread.join();
+    fwdThread.join();
+
+    // A TCP-to-TCP `MsgSock` forward uses the same kernel path
+    upstream.send(1, outBuf.data(), 10);
+    hycast::MsgSock msgIngress{ingress};
+    EXPECT_TRUE(msgIngress.forward(hycast::MsgSock{egress}, 1));
+    EXPECT_EQ(10, downstream.getSize());
+    EXPECT_EQ(1, downstream.getStreamId());
+    downstream.discard();
+}
+
+// Tests that an invalid stream number is rejected
+TEST_F(TcpSockTest, InvalidStreamId)
+{
+    hycast::SrvrTcpSock srvrSock{srvrAddr, numStreams};
+    srvrSock.listen();
+
+    hycast::TcpSock clntSock{numStreams};
+    clntSock.connect(srvrAddr);
+    char buf[1] = {};
+    EXPECT_THROW(clntSock.send(numStreams, buf, sizeof(buf)),
+            std::invalid_argument);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
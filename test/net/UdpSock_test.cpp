@@ -12,6 +12,7 @@
 #include "error.h"
 #include "UdpSock.h"
 
+#include <climits>
 #include <cstdint>
 #include <cstring>
 #include <gtest/gtest.h>
@@ -132,6 +133,15 @@ TEST_F(UdpSockTest, LocalhostOutputConstruction) {
     sock.send(buf, sizeof(buf));
 }
 
+// Tests setting the Differentiated Services code-point
+TEST_F(UdpSockTest, Dscp) {
+    hycast::OutUdpSock sock(localSockAddr);
+    sock.setDscp(46); // Expedited forwarding
+    EXPECT_THROW(sock.setDscp(64), std::invalid_argument);
+    char buf[1];
+    sock.send(buf, sizeof(buf));
+}
+
 // Tests source-independent multicast socket construction
 TEST_F(UdpSockTest, AnySourceConstruction) {
     hycast::McastUdpSock sock(mcastSockAddr);
@@ -152,6 +162,76 @@ TEST_F(UdpSockTest, SourceSpecificConstruction) {
     }
 }
 
+// Tests kernel receive telemetry
+TEST_F(UdpSockTest, Telemetry) {
+    hycast::InUdpSock recvSock(localSockAddr);
+    recvSock.enableTelemetry();
+    EXPECT_EQ(0, recvSock.getDropCount());
+    hycast::OutUdpSock sendSock(localSockAddr);
+    char buf[1000];
+    ::memset(buf, 0, sizeof(buf));
+    sendSock.send(buf, sizeof(buf));
+    EXPECT_EQ(sizeof(buf), recvSock.recv(buf, sizeof(buf)));
+    auto when = recvSock.getRecvTimestamp();
+    EXPECT_TRUE(when.tv_sec != 0 || when.tv_nsec != 0);
+    EXPECT_EQ(0, recvSock.getDropCount());
+}
+
+// Tests zero-copy peeking at a batched datagram
+TEST_F(UdpSockTest, BatchedPeek) {
+    hycast::InUdpSock recvSock(localSockAddr);
+    EXPECT_EQ(nullptr, recvSock.peek(1)); // Unbatched: no view available
+    recvSock.setBatching(4);
+    hycast::OutUdpSock sendSock(localSockAddr);
+    char buf[1000];
+    for (size_t i = 0; i < sizeof(buf); ++i)
+        buf[i] = i % UCHAR_MAX;
+    sendSock.send(buf, sizeof(buf));
+    auto view = static_cast<const char*>(recvSock.peek(sizeof(buf)));
+    ASSERT_NE(nullptr, view);
+    EXPECT_EQ(0, ::memcmp(buf, view, sizeof(buf)));
+    EXPECT_TRUE(recvSock.hasRecord());
+    EXPECT_EQ(nullptr, recvSock.peek(sizeof(buf) + 1)); // Datagram too small
+    // The datagram wasn't consumed
+    char buf2[1000];
+    EXPECT_EQ(sizeof(buf2), recvSock.recv(buf2, sizeof(buf2)));
+    EXPECT_EQ(0, ::memcmp(buf, buf2, sizeof(buf2)));
+}
+
+// Tests busy-polling reception
+TEST_F(UdpSockTest, BusyPoll) {
+    hycast::InUdpSock recvSock(localSockAddr);
+    EXPECT_THROW(recvSock.enableBusyPoll(0), std::invalid_argument);
+    recvSock.enableBusyPoll(50);
+    hycast::OutUdpSock sendSock(localSockAddr);
+    char buf[1000];
+    ::memset(buf, 0, sizeof(buf));
+    sendSock.send(buf, sizeof(buf));
+    EXPECT_EQ(sizeof(buf), recvSock.recv(buf, sizeof(buf)));
+    // Busy-polling also applies to batched reception
+    recvSock.setBatching(4);
+    sendSock.send(buf, sizeof(buf));
+    EXPECT_EQ(sizeof(buf), recvSock.recv(buf, sizeof(buf)));
+}
+
+// Tests adaptive receive-buffer sizing
+TEST_F(UdpSockTest, AdaptiveRcvBuf) {
+    hycast::InUdpSock recvSock(localSockAddr);
+    EXPECT_THROW(recvSock.enableAdaptiveRcvBuf(0, 1 << 20),
+            std::invalid_argument);
+    EXPECT_THROW(recvSock.enableAdaptiveRcvBuf(1 << 20, 1 << 10),
+            std::invalid_argument);
+    recvSock.enableAdaptiveRcvBuf(1 << 20, 8 << 20);
+    // Reception is unaffected and telemetry is implied
+    hycast::OutUdpSock sendSock(localSockAddr);
+    char buf[1000];
+    ::memset(buf, 0, sizeof(buf));
+    sendSock.send(buf, sizeof(buf));
+    EXPECT_EQ(sizeof(buf), recvSock.recv(buf, sizeof(buf)));
+    auto when = recvSock.getRecvTimestamp();
+    EXPECT_TRUE(when.tv_sec != 0 || when.tv_nsec != 0);
+}
+
 // Tests source-independent multicasting
 TEST_F(UdpSockTest, AnySourceMulticasting) {
     hycast::McastUdpSock recvSock(mcastSockAddr);
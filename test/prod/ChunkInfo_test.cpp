@@ -60,6 +60,17 @@ TEST_F(ChunkInfoTest, Equals) {
     EXPECT_FALSE(info1 == info4);
 }
 
+// Tests ChunkId::pack()
+TEST_F(ChunkInfoTest, ChunkIdPack) {
+    hycast::ChunkId id{hycast::ProdIndex{2}, hycast::ChunkIndex{3}};
+    EXPECT_EQ((uint64_t{2} << 32) | 3, id.pack());
+    hycast::ChunkId same{hycast::ProdIndex{2}, hycast::ChunkIndex{3}};
+    EXPECT_TRUE(id == same);
+    hycast::ChunkId swapped{hycast::ProdIndex{3}, hycast::ChunkIndex{2}};
+    EXPECT_NE(id.pack(), swapped.pack());
+    EXPECT_NE(id.hash(), swapped.hash());
+}
+
 }  // namespace
 
 int main(int argc, char **argv) {
@@ -0,0 +1,88 @@
+/**
+ * This file tests the class `ChunkPool`
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: ChunkPool_test.cpp
+ * @author: Steven R. Emmerson
+ */
+
+#include "ChunkPool.h"
+
+#include <cstring>
+#include <gtest/gtest.h>
+
+namespace {
+
+// The fixture for testing class ChunkPool.
+class ChunkPoolTest : public ::testing::Test {
+ protected:
+};
+
+// Tests invalid construction
+TEST_F(ChunkPoolTest, InvalidConstruction) {
+    EXPECT_THROW(hycast::ChunkPool(0), std::invalid_argument);
+}
+
+// Tests getting a buffer
+TEST_F(ChunkPoolTest, GetBuffer) {
+    hycast::ChunkPool pool{hycast::ChunkSize::maxSize};
+    auto buffer = pool.get();
+    EXPECT_TRUE(buffer);
+    EXPECT_EQ(hycast::ChunkSize::maxSize, buffer.size());
+    ::memset(buffer.data(), 0, buffer.size());
+}
+
+// Tests buffer recycling
+TEST_F(ChunkPoolTest, Recycling) {
+    hycast::ChunkPool pool{1000};
+    EXPECT_EQ(0, pool.numFree());
+    char* data;
+    {
+        auto buffer = pool.get();
+        data = buffer.data();
+    }
+    EXPECT_EQ(1, pool.numFree());
+    auto buffer = pool.get();
+    EXPECT_EQ(data, buffer.data());
+    EXPECT_EQ(0, pool.numFree());
+}
+
+// Tests the process-wide shared pool
+TEST_F(ChunkPoolTest, SharedPool) {
+    auto pool1 = hycast::ChunkPool::getShared(2000);
+    auto pool2 = hycast::ChunkPool::getShared(2000);
+    // Same size => same arena: a buffer freed via one handle is recycled by
+    // the other
+    char* data;
+    {
+        auto buffer = pool1.get();
+        data = buffer.data();
+    }
+    EXPECT_EQ(1, pool2.numFree());
+    auto buffer = pool2.get();
+    EXPECT_EQ(data, buffer.data());
+    // A different size is a different arena
+    auto pool3 = hycast::ChunkPool::getShared(3000);
+    EXPECT_EQ(3000, pool3.getBufSize());
+    EXPECT_EQ(0, pool3.numFree());
+}
+
+// Tests the retention limit
+TEST_F(ChunkPoolTest, RetentionLimit) {
+    hycast::ChunkPool pool{1000, 1};
+    {
+        auto buffer1 = pool.get();
+        auto buffer2 = pool.get();
+    }
+    EXPECT_EQ(1, pool.numFree());
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
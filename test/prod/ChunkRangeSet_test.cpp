@@ -0,0 +1,139 @@
+/**
+ * This file tests the class `ChunkRangeSet`.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: ChunkRangeSet_test.cpp
+ * @author: Steven R. Emmerson
+ */
+
+#include "Chunk.h"
+#include "Codec.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+// The fixture for testing class ChunkRangeSet.
+class ChunkRangeSetTest : public ::testing::Test {
+protected:
+    hycast::ChunkId chunkId(
+            const hycast::ProdIndex::type  prodIndex,
+            const hycast::ChunkIndex::type chunkIndex)
+    {
+        return hycast::ChunkId{hycast::ProdIndex{prodIndex},
+                hycast::ChunkIndex{chunkIndex}};
+    }
+};
+
+// Tests default construction
+TEST_F(ChunkRangeSetTest, DefaultConstruction) {
+    hycast::ChunkRangeSet set{};
+    EXPECT_FALSE(set);
+    EXPECT_EQ(0, set.size());
+    EXPECT_EQ(0, set.getNumChunks());
+}
+
+// Tests that contiguous chunk identifiers coalesce into one range
+TEST_F(ChunkRangeSetTest, Coalescing) {
+    hycast::ChunkRangeSet set{};
+    for (hycast::ChunkIndex::type i = 0; i < 100; ++i)
+        EXPECT_TRUE(set.add(chunkId(1, i)));
+    EXPECT_EQ(1, set.size());
+    EXPECT_EQ(100, set.getNumChunks());
+    auto range = *set.begin();
+    EXPECT_TRUE(chunkId(1, 0) == range.getFirst());
+    EXPECT_EQ(100, range.getNumChunks());
+}
+
+// Tests that a gap or a product boundary starts a new range
+TEST_F(ChunkRangeSetTest, NewRanges) {
+    hycast::ChunkRangeSet set{};
+    EXPECT_TRUE(set.add(chunkId(1, 0)));
+    EXPECT_TRUE(set.add(chunkId(1, 1)));
+    EXPECT_TRUE(set.add(chunkId(1, 3))); // Gap
+    EXPECT_TRUE(set.add(chunkId(2, 4))); // New product
+    EXPECT_EQ(3, set.size());
+    EXPECT_EQ(4, set.getNumChunks());
+}
+
+// Tests that a full set rejects a non-coalescible identifier
+TEST_F(ChunkRangeSetTest, FullSet) {
+    hycast::ChunkRangeSet set{};
+    // Every other chunk so nothing coalesces
+    for (size_t i = 0; i < hycast::ChunkRangeSet::maxRanges; ++i)
+        EXPECT_TRUE(set.add(chunkId(1, 2*i)));
+    EXPECT_EQ(hycast::ChunkRangeSet::maxRanges, set.size());
+    EXPECT_FALSE(set.add(chunkId(1, 2*hycast::ChunkRangeSet::maxRanges)));
+    // A coalescible identifier is still accepted
+    EXPECT_TRUE(set.add(chunkId(1, 2*hycast::ChunkRangeSet::maxRanges - 1)));
+    set.clear();
+    EXPECT_FALSE(set);
+    EXPECT_TRUE(set.add(chunkId(1, 0)));
+}
+
+// Tests serialization/de-serialization
+TEST_F(ChunkRangeSetTest, Serialization) {
+    hycast::ChunkRangeSet set1{};
+    for (hycast::ChunkIndex::type i = 0; i < 10; ++i)
+        set1.add(chunkId(1, i));
+    set1.add(chunkId(2, 0)); // Sparse fallback: single-chunk range
+    const size_t nbytes = set1.getSerialSize(0);
+    EXPECT_GE(hycast::ChunkRangeSet::getMaxSerialSize(0), nbytes);
+    alignas(alignof(size_t)) char bytes[nbytes];
+    hycast::MemEncoder encoder(bytes, nbytes);
+    set1.serialize(encoder, 0);
+    encoder.flush();
+    hycast::MemDecoder decoder(bytes, nbytes);
+    decoder.fill(0);
+    auto set2 = hycast::ChunkRangeSet::deserialize(decoder, 0);
+    EXPECT_EQ(set1.size(), set2.size());
+    EXPECT_EQ(set1.getNumChunks(), set2.getNumChunks());
+    auto iter1 = set1.begin();
+    auto iter2 = set2.begin();
+    for (; iter1 != set1.end(); ++iter1, ++iter2) {
+        EXPECT_TRUE(iter1->getFirst() == iter2->getFirst());
+        EXPECT_EQ(static_cast<hycast::ChunkIndex::type>(
+                iter1->getNumChunks()),
+                static_cast<hycast::ChunkIndex::type>(iter2->getNumChunks()));
+    }
+}
+
+// Tests the compact (varint, delta-coded) encoding round-trip
+TEST_F(ChunkRangeSetTest, CompactSerialization) {
+    const unsigned version = 1;
+    hycast::ChunkRangeSet set1{};
+    for (hycast::ChunkIndex::type i = 0; i < 10; ++i)
+        set1.add(chunkId(1, i));
+    set1.add(chunkId(2, 0)); // Sparse fallback: single-chunk range
+    const size_t maxBytes = set1.getSerialSize(version);
+    EXPECT_GE(hycast::ChunkRangeSet::getMaxSerialSize(version), maxBytes);
+    alignas(alignof(size_t)) char bytes[maxBytes];
+    hycast::MemEncoder encoder(bytes, maxBytes);
+    const size_t nbytes = set1.serialize(encoder, version);
+    // The point of the exercise: smaller than the fixed-width encoding
+    EXPECT_GT(set1.getSerialSize(0), nbytes);
+    encoder.flush();
+    hycast::MemDecoder decoder(bytes, nbytes);
+    decoder.fill(0);
+    auto set2 = hycast::ChunkRangeSet::deserialize(decoder, version);
+    EXPECT_EQ(set1.size(), set2.size());
+    EXPECT_EQ(set1.getNumChunks(), set2.getNumChunks());
+    auto iter1 = set1.begin();
+    auto iter2 = set2.begin();
+    for (; iter1 != set1.end(); ++iter1, ++iter2) {
+        EXPECT_TRUE(iter1->getFirst() == iter2->getFirst());
+        EXPECT_EQ(static_cast<hycast::ChunkIndex::type>(
+                iter1->getNumChunks()),
+                static_cast<hycast::ChunkIndex::type>(iter2->getNumChunks()));
+    }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,62 @@
+/**
+ * This file tests the class `ChunkRange`.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: ChunkRange_test.cpp
+ * @author: Steven R. Emmerson
+ */
+
+#include "Chunk.h"
+#include "ProdInfo.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+// The fixture for testing class ChunkRange.
+class ChunkRangeTest : public ::testing::Test {
+protected:
+    ChunkRangeTest()
+        : prodSize{4u*hycast::ChunkSize::defaultSize}
+    {}
+
+    hycast::ProdSize prodSize;
+};
+
+// Tests construction
+TEST_F(ChunkRangeTest, Construction) {
+    hycast::ProdInfo   prodInfo{0, "product", prodSize};
+    hycast::ChunkRange range{prodInfo};
+    EXPECT_EQ(prodInfo.getNumChunks(), range.getNumChunks());
+    EXPECT_EQ(0, range.getFirst().getChunkIndex());
+    EXPECT_EQ(prodInfo.getIndex(), range.getFirst().getProdIndex());
+}
+
+// Tests operator bool
+TEST_F(ChunkRangeTest, OperatorBool) {
+    EXPECT_FALSE(hycast::ChunkRange{});
+    hycast::ProdInfo   prodInfo{0, "product", prodSize};
+    hycast::ChunkRange range{prodInfo};
+    EXPECT_TRUE(range);
+}
+
+// Tests that the range yields the chunk identifiers it stands for
+TEST_F(ChunkRangeTest, GetChunkId) {
+    hycast::ProdInfo                prodInfo{0, "product", prodSize};
+    hycast::ChunkRange              range{prodInfo};
+    const hycast::ChunkIndex::type  numChunks = range.getNumChunks();
+    for (hycast::ChunkIndex::type i = 0; i < numChunks; ++i) {
+        hycast::ChunkId expect{prodInfo, i};
+        EXPECT_TRUE(expect == range.getChunkId(i));
+    }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,108 @@
+/**
+ * This file tests the classes `ActualChunkRun` and `LatentChunkRun`.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: ChunkRun_test.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "Chunk.h"
+#include "Codec.h"
+#include "ProdInfo.h"
+
+#include <cstring>
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace {
+
+// The fixture for testing classes ActualChunkRun and LatentChunkRun.
+class ChunkRunTest : public ::testing::Test {
+protected:
+    ChunkRunTest()
+        : version{0}
+        , chunkSize{1000}
+        , prodInfo{0, "product", hycast::ProdSize{3500},
+                hycast::ChunkSize{chunkSize}}
+        , data{}
+    {
+        data.resize(3500);
+        for (size_t i = 0; i < data.size(); ++i)
+            data[i] = static_cast<char>(i);
+    }
+
+    /**
+     * Returns a run of contiguous chunks of the data-product.
+     * @param[in] firstIndex  Index of the first chunk
+     * @param[in] numChunks   Number of chunks
+     */
+    std::vector<hycast::ActualChunk> makeRun(
+            const hycast::ChunkIndex::type firstIndex,
+            const unsigned                 numChunks)
+    {
+        std::vector<hycast::ActualChunk> chunks{};
+        for (unsigned i = 0; i < numChunks; ++i) {
+            const hycast::ChunkIndex index{firstIndex + i};
+            hycast::ChunkInfo chunkInfo{prodInfo, index};
+            chunks.push_back(hycast::ActualChunk{chunkInfo,
+                    data.data() + chunkInfo.getOffset()});
+        }
+        return chunks;
+    }
+
+    unsigned            version;
+    hycast::ChunkSize::type chunkSize;
+    hycast::ProdInfo    prodInfo;
+    std::vector<char>   data;
+};
+
+// Tests construction of an invalid run
+TEST_F(ChunkRunTest, InvalidConstruction) {
+    EXPECT_THROW(hycast::ActualChunkRun{std::vector<hycast::ActualChunk>{}},
+            hycast::InvalidArgument);
+    // Non-contiguous chunks
+    auto chunks = makeRun(0, 1);
+    auto tail = makeRun(2, 1);
+    chunks.push_back(tail.front());
+    EXPECT_THROW(hycast::ActualChunkRun{chunks}, hycast::InvalidArgument);
+}
+
+// Tests a serialization round-trip
+TEST_F(ChunkRunTest, RoundTrip) {
+    const unsigned numChunks = 4; // Last chunk is partial: 500 bytes
+    hycast::ActualChunkRun run{makeRun(0, numChunks)};
+    EXPECT_EQ(numChunks, run.getNumChunks());
+
+    char               msg[5000];
+    hycast::MemEncoder encoder(msg, sizeof(msg));
+    const size_t msgLen = run.serialize(encoder, version);
+    encoder.flush();
+
+    hycast::MemDecoder decoder(msg, msgLen);
+    decoder.fill(hycast::ActualChunkRun::getMaxMetadataSize(version));
+    auto latentRun = hycast::LatentChunkRun::deserialize(decoder, version);
+    EXPECT_EQ(numChunks, latentRun.getNumChunks());
+    EXPECT_EQ(data.size(), latentRun.getTotalSize());
+    for (unsigned i = 0; i < numChunks; ++i) {
+        auto chunkInfo = latentRun.getChunkInfo(i);
+        EXPECT_EQ(i, chunkInfo.getIndex());
+        EXPECT_EQ(prodInfo.getIndex(), chunkInfo.getProdIndex());
+    }
+
+    std::vector<char> drained(latentRun.getTotalSize());
+    EXPECT_EQ(drained.size(),
+            latentRun.drainData(drained.data(), drained.size()));
+    EXPECT_FALSE(latentRun.hasData());
+    EXPECT_EQ(0, ::memcmp(data.data(), drained.data(), data.size()));
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
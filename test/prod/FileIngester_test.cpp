@@ -71,6 +71,32 @@ TEST_F(FileIngesterTest, InvalidDirectoryConstruction)
     EXPECT_THROW(hycast::FileIngester{"/dev/null"}, hycast::SystemError);
 }
 
+// Tests parallel ingestion of a burst of pre-existing files
+TEST_F(FileIngesterTest, ParallelIngestion)
+{
+    const int numFiles = 20;
+    for (int i = 0; i < numFiles; ++i) {
+        const auto pathname = rootDirPathname + "/file" + std::to_string(i);
+        auto fd = ::open(pathname.data(), O_WRONLY|O_CREAT, S_IRWXU);
+        ASSERT_NE(-1, fd);
+        ASSERT_EQ(4, ::write(fd, "data", 4));
+        ::close(fd);
+    }
+    {
+        hycast::FileIngester ingester{rootDirPathname, 4};
+        for (int i = 0; i < numFiles; ++i) {
+            // Delivery must preserve arrival order despite concurrent
+            // conversion
+            auto prod = ingester.getProduct();
+            EXPECT_EQ(hycast::ProdIndex{static_cast<hycast::ProdIndex::type>(
+                    i)}, prod.getInfo().getIndex());
+            EXPECT_EQ(4, prod.getInfo().getSize());
+        }
+    }
+    for (int i = 0; i < numFiles; ++i)
+        std::remove((rootDirPathname + "/file" + std::to_string(i)).data());
+}
+
 #if 0
 // Tests empty directory construction
 TEST_F(FileIngesterTest, EmptyDirectoryConstruction)
@@ -0,0 +1,130 @@
+/**
+ * This file tests class `IngesterMux`.
+ *
+ * Copyright 2018 University Corporation for Atmospheric Research. All rights
+ * reserved. See file "COPYING" in the top-level source-directory for usage
+ * restrictions.
+ *
+ *       File: IngesterMux_test.cpp
+ * Created On: Aug 30, 2018
+ *     Author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "error.h"
+#include "FileIngester.h"
+#include "IngesterMux.h"
+#include "ShmIngester.h"
+
+#include <cstdio>
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <map>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+
+namespace {
+
+/// The fixture for testing class `IngesterMux`
+class IngesterMuxTest : public ::testing::Test
+{
+protected:
+    IngesterMuxTest()
+    {
+        for (auto& dirPathname : dirPathnames) {
+            std::remove(dirPathname.data());
+            ::mkdir(dirPathname.data(), S_IRWXU);
+        }
+        ::shm_unlink(segName.data());
+    }
+
+    virtual void TearDown()
+    {
+        for (auto& dirPathname : dirPathnames)
+            std::remove(dirPathname.data());
+    }
+
+    void createFile(
+            const std::string& dirPathname,
+            const int          num)
+    {
+        const auto pathname = dirPathname + "/file" + std::to_string(num);
+        auto       fd = ::open(pathname.data(), O_WRONLY|O_CREAT, S_IRWXU);
+        ASSERT_NE(-1, fd);
+        ASSERT_EQ(4, ::write(fd, "data", 4));
+        ::close(fd);
+    }
+
+    const std::string dirPathnames[2]{"/tmp/IngesterMux0", "/tmp/IngesterMux1"};
+    const std::string segName{"/IngesterMux_test"};
+};
+
+// Tests default construction
+TEST_F(IngesterMuxTest, DefaultConstruction)
+{
+    hycast::IngesterMux mux{};
+    EXPECT_FALSE(mux);
+}
+
+// Tests invalid construction
+TEST_F(IngesterMuxTest, InvalidConstruction)
+{
+    EXPECT_THROW(hycast::IngesterMux{std::vector<hycast::Ingester*>{}},
+            std::invalid_argument);
+}
+
+// Tests multiplexing two directory hierarchies from one event-thread
+TEST_F(IngesterMuxTest, FileMultiplexing)
+{
+    const int            numFiles = 10;
+    hycast::FileIngester ingesters[2]{
+            hycast::FileIngester{dirPathnames[0]},
+            hycast::FileIngester{dirPathnames[1]}};
+    hycast::IngesterMux  mux{{&ingesters[0], &ingesters[1]}};
+    for (int i = 0; i < numFiles; ++i)
+        createFile(dirPathnames[i%2], i);
+    // Each ingester's products arrive in that ingester's order
+    std::map<std::string, int> numDelivered;
+    for (int i = 0; i < numFiles; ++i) {
+        auto       prod = mux.getProduct();
+        const auto name = prod.getInfo().getName().to_string();
+        const auto dirPathname = name.substr(0, name.rfind('/'));
+        EXPECT_EQ(4, prod.getInfo().getSize());
+        ++numDelivered[dirPathname];
+    }
+    EXPECT_EQ(numFiles/2, numDelivered[dirPathnames[0]]);
+    EXPECT_EQ(numFiles/2, numDelivered[dirPathnames[1]]);
+    for (int i = 0; i < numFiles; ++i)
+        std::remove((dirPathnames[i%2] + "/file" + std::to_string(i)).data());
+}
+
+// Tests multiplexing a shared-memory ring via its eventfd bridge
+TEST_F(IngesterMuxTest, ShmMultiplexing)
+{
+    const std::string   prodData{"This is a data-product"};
+    const int           numProds = 10;
+    hycast::ShmProducer producer{segName, 4, 1000};
+    hycast::ShmIngester ingester{segName};
+    hycast::IngesterMux mux{{&ingester}};
+    std::thread thread{[&]{
+        for (int i = 0; i < numProds; ++i)
+            producer.send("product" + std::to_string(i), prodData.data(),
+                    prodData.length());
+    }};
+    for (int i = 0; i < numProds; ++i) {
+        auto prod = mux.getProduct();
+        EXPECT_EQ("product" + std::to_string(i),
+                prod.getInfo().getName().to_string());
+        EXPECT_EQ(prodData.length(), prod.getInfo().getSize());
+    }
+    thread.join();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
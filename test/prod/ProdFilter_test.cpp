@@ -0,0 +1,81 @@
+/**
+ * This file tests the class `ProdFilter`.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: ProdFilter_test.cpp
+ * @author: Steven R. Emmerson
+ */
+
+#include "Codec.h"
+#include "error.h"
+#include "ProdFilter.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+// The fixture for testing class ProdFilter.
+class ProdFilterTest : public ::testing::Test {
+};
+
+// Tests that an empty filter matches every name
+TEST_F(ProdFilterTest, DefaultConstruction) {
+    hycast::ProdFilter filter{};
+    EXPECT_FALSE(filter);
+    EXPECT_EQ(0, filter.size());
+    EXPECT_TRUE(filter.matches("anything"));
+    EXPECT_TRUE(filter.matches(""));
+}
+
+// Tests glob-pattern matching
+TEST_F(ProdFilterTest, Matching) {
+    hycast::ProdFilter filter{};
+    filter.add("data/grib2/*");
+    filter.add("*.nc");
+    EXPECT_TRUE(filter);
+    EXPECT_EQ(2, filter.size());
+    EXPECT_TRUE(filter.matches("data/grib2/gfs.t00z"));
+    EXPECT_TRUE(filter.matches("obs/metar.nc"));
+    EXPECT_FALSE(filter.matches("data/bufr/ship"));
+}
+
+// Tests the limits on patterns
+TEST_F(ProdFilterTest, Limits) {
+    hycast::ProdFilter filter{};
+    EXPECT_THROW(filter.add(std::string(
+            hycast::ProdFilter::maxPatternLen + 1, 'x')),
+            hycast::InvalidArgument);
+    for (size_t i = 0; i < hycast::ProdFilter::maxPatterns; ++i)
+        filter.add("pattern" + std::to_string(i));
+    EXPECT_THROW(filter.add("one-too-many"), hycast::InvalidArgument);
+}
+
+// Tests serialization/de-serialization
+TEST_F(ProdFilterTest, Serialization) {
+    hycast::ProdFilter filter1{};
+    filter1.add("data/grib2/*");
+    filter1.add("*.nc");
+    const size_t nbytes = filter1.getSerialSize(0);
+    EXPECT_GE(hycast::ProdFilter::getMaxSerialSize(0), nbytes);
+    alignas(alignof(size_t)) char bytes[nbytes];
+    hycast::MemEncoder encoder(bytes, nbytes);
+    filter1.serialize(encoder, 0);
+    encoder.flush();
+    hycast::MemDecoder decoder(bytes, nbytes);
+    decoder.fill(0);
+    auto filter2 = hycast::ProdFilter::deserialize(decoder, 0);
+    EXPECT_EQ(filter1.size(), filter2.size());
+    EXPECT_TRUE(filter2.matches("data/grib2/gfs.t00z"));
+    EXPECT_TRUE(filter2.matches("obs/metar.nc"));
+    EXPECT_FALSE(filter2.matches("data/bufr/ship"));
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -101,6 +101,26 @@ TEST_F(ProdIndexTest, Serialization) {
     EXPECT_TRUE(index1 == index2);
 }
 
+// Tests the compact (varint) encoding round-trip
+TEST_F(ProdIndexTest, CompactSerialization) {
+    for (const hycast::ProdIndex::type value :
+            {hycast::ProdIndex::type(1), hycast::ProdIndex::type(300),
+             hycast::ProdIndex::prodIndexMax}) {
+        hycast::ProdIndex index1(value);
+        const size_t nbytes = index1.getSerialSize(1);
+        alignas(alignof(size_t)) char bytes[nbytes];
+        hycast::MemEncoder encoder(bytes, nbytes);
+        index1.serialize(encoder, 1);
+        encoder.flush();
+        hycast::MemDecoder decoder(bytes, nbytes);
+        decoder.fill(0);
+        auto index2 = hycast::ProdIndex::deserialize(decoder, 1);
+        EXPECT_TRUE(index1 == index2);
+    }
+    // A small index serializes to a single byte
+    EXPECT_EQ(1, hycast::ProdIndex{1}.getSerialSize(1));
+}
+
 }  // namespace
 
 int main(int argc, char **argv) {
@@ -56,6 +56,38 @@ TEST_F(ProdInfoTest, Construction) {
     EXPECT_STREQ("name", info.getName().c_str());
     EXPECT_EQ(1, info.getIndex());
     EXPECT_EQ(2, info.getSize());
+    EXPECT_EQ(hycast::ProdInfo::defaultPriority, info.getPriority());
+    hycast::ProdInfo urgent(1, "name", 2, hycast::ChunkSize::defaultSize, 3);
+    EXPECT_EQ(3, urgent.getPriority());
+}
+
+// Tests the origin timestamp
+TEST_F(ProdInfoTest, OriginTime) {
+    hycast::ProdInfo info(1, "name", 2);
+    EXPECT_EQ(0, info.getOriginTime());
+    const auto originTime = hycast::ProdInfo::now();
+    info.setOriginTime(originTime);
+    EXPECT_EQ(originTime, info.getOriginTime());
+    // A second stamp doesn't overwrite the first
+    info.setOriginTime(originTime + 1);
+    EXPECT_EQ(originTime, info.getOriginTime());
+}
+
+// Tests the time-to-live
+TEST_F(ProdInfoTest, TimeToLive) {
+    hycast::ProdInfo info(1, "name", 2);
+    EXPECT_EQ(hycast::ProdInfo::defaultTtl, info.getTtl());
+    EXPECT_FALSE(info.isExpired()); // No time-to-live
+    hycast::ProdInfo nowcast(1, "name", 2, hycast::ChunkSize::defaultSize,
+            hycast::ProdInfo::defaultPriority, 0, 600);
+    EXPECT_EQ(600, nowcast.getTtl());
+    EXPECT_FALSE(nowcast.isExpired()); // Not yet transmitted
+    nowcast.setOriginTime(hycast::ProdInfo::now());
+    EXPECT_FALSE(nowcast.isExpired());
+    hycast::ProdInfo stale(2, "name", 2, hycast::ChunkSize::defaultSize,
+            hycast::ProdInfo::defaultPriority, 0, 1);
+    stale.setOriginTime(hycast::ProdInfo::now() - 2000000);
+    EXPECT_TRUE(stale.isExpired());
 }
 
 // Tests equals()
@@ -68,17 +100,51 @@ TEST_F(ProdInfoTest, Equals) {
     EXPECT_FALSE(info1 == info4);
     hycast::ProdInfo info5(1, "names", 2);
     EXPECT_FALSE(info1 == info5);
+    hycast::ProdInfo info6(1, "name", 2, hycast::ChunkSize::defaultSize, 1);
+    EXPECT_FALSE(info1 == info6);
+}
+
+// Tests the payload checksum
+TEST_F(ProdInfoTest, PayloadCrc) {
+    hycast::ProdInfo info(1, "name", 2);
+    EXPECT_EQ(0, info.getPayloadCrc()); // Not computed
+    info.setPayloadCrc(0xe3069283u);
+    EXPECT_EQ(0xe3069283u, info.getPayloadCrc());
+    // A second stamp doesn't overwrite the first
+    info.setPayloadCrc(1);
+    EXPECT_EQ(0xe3069283u, info.getPayloadCrc());
+}
+
+// Tests the trace identifier
+TEST_F(ProdInfoTest, TraceId) {
+    hycast::ProdInfo info(1, "name", 2);
+    EXPECT_EQ(0, info.getTraceId()); // Not minted
+    EXPECT_FALSE(info.isSampled());
+    const auto traceId = hycast::ProdInfo::mintTraceId(true);
+    EXPECT_NE(0, traceId);
+    EXPECT_EQ(1, traceId & 1); // Sampling flag
+    EXPECT_EQ(0, hycast::ProdInfo::mintTraceId(false) & 1);
+    info.setTraceId(traceId);
+    EXPECT_EQ(traceId, info.getTraceId());
+    EXPECT_TRUE(info.isSampled());
+    // A second stamp doesn't overwrite the first
+    info.setTraceId(hycast::ProdInfo::mintTraceId(false));
+    EXPECT_EQ(traceId, info.getTraceId());
 }
 
 // Tests getSerialSize()
 TEST_F(ProdInfoTest, GetSerialSize) {
     hycast::ProdInfo info1(1, "name", 2);
-    EXPECT_EQ(20, info1.getSerialSize(0));
+    EXPECT_EQ(46, info1.getSerialSize(0));
 }
 
 // Tests serialization/de-serialization
 TEST_F(ProdInfoTest, Serialization) {
-    hycast::ProdInfo info1(1, "name", 2);
+    hycast::ProdInfo info1(1, "name", 2, hycast::ChunkSize::defaultSize, 2, 0,
+            600);
+    info1.setOriginTime(hycast::ProdInfo::now());
+    info1.setPayloadCrc(0xe3069283u);
+    info1.setTraceId(hycast::ProdInfo::mintTraceId(true));
     const size_t nbytes = info1.getSerialSize(0);
     alignas(alignof(size_t)) char bytes[nbytes];
     hycast::MemEncoder encoder(bytes, nbytes);
@@ -88,6 +154,11 @@ TEST_F(ProdInfoTest, Serialization) {
     decoder.fill(0);
     auto info2 = hycast::ProdInfo::deserialize(decoder, 0);
     EXPECT_TRUE(info1 == info2);
+    EXPECT_EQ(info1.getOriginTime(), info2.getOriginTime());
+    EXPECT_EQ(info1.getTtl(), info2.getTtl());
+    EXPECT_EQ(info1.getPayloadCrc(), info2.getPayloadCrc());
+    EXPECT_EQ(info1.getTraceId(), info2.getTraceId());
+    EXPECT_TRUE(info2.isSampled());
 }
 
 }  // namespace
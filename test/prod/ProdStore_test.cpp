@@ -94,6 +94,42 @@ protected:
         }
     }
 
+    /**
+     * Adds every chunk of a product WITHOUT first adding the
+     * product-information, so the first chunk speculatively creates the
+     * product.
+     * @param[in]  prodInfo  Product information (used only for serialization)
+     * @param[in]  data      Product data
+     * @param[in]  ps        Product-store
+     * @param[out] prod      Associated product
+     * @return               Status of the last addition
+     */
+    hycast::RecvStatus addChunksOnly(
+            const hycast::ProdInfo prodInfo,
+            const char*            data,
+            hycast::ProdStore&     ps,
+            hycast::Product&       prod)
+    {
+        char               buf[hycast::UdpSock::maxPayload];
+        hycast::RecvStatus status{};
+        for (hycast::ChunkIndex chunkIndex = 0;
+                chunkIndex < prodInfo.getNumChunks(); ++chunkIndex) {
+            const hycast::ChunkInfo   chunkInfo{prodInfo, chunkIndex};
+            const hycast::ActualChunk actualChunk{chunkInfo,
+                    data+prodInfo.getChunkOffset(chunkIndex)};
+            hycast::MemEncoder        encoder(buf, sizeof(buf));
+            const auto                nbytes =
+                    actualChunk.serialize(encoder, version);
+            encoder.flush();
+
+            hycast::MemDecoder  decoder(buf, nbytes);
+            decoder.fill(hycast::LatentChunk::getMetadataSize(version));
+            hycast::LatentChunk latentChunk(decoder, version);
+            status = ps.add(latentChunk, prod);
+        }
+        return status;
+    }
+
     // Objects declared here can be used by all tests in the test case for ProdStore.
     const unsigned          version{0};
     const std::string       pathname{"hycast.ps"};
@@ -147,6 +183,33 @@ TEST_F(ProdStoreTest, AddingLatentChunks) {
     EXPECT_EQ(2, ps.size());
 }
 
+// Tests speculative product allocation from a first-arriving chunk
+TEST_F(ProdStoreTest, ChunkBeforeProdInfo) {
+    hycast::ProdStore ps{};
+    hycast::Product   prod2{};
+    // Every chunk arrives before the product-information
+    auto status = addChunksOnly(prodInfo, prod.getData(), ps, prod2);
+    EXPECT_EQ(1, ps.size());
+    // The data is complete but the product isn't: the name is still missing
+    EXPECT_FALSE(status.isComplete());
+    auto speculative = ps.getProdInfo(prodIndex);
+    EXPECT_EQ(prodSize, speculative.getSize());
+    EXPECT_EQ(0, speculative.getName().length());
+    // The product-information lands: the name is backfilled and the product
+    // completes
+    status = ps.add(prodInfo, prod2);
+    EXPECT_TRUE(status.isNew());
+    EXPECT_TRUE(status.isComplete());
+    EXPECT_TRUE(prod2.isComplete());
+    EXPECT_EQ(prodInfo, prod2.getInfo());
+    EXPECT_EQ(0, ::memcmp(prod.getData(), prod2.getData(), prodSize));
+    // The backfilled name is resolvable
+    hycast::ProdIndex foundIndex{};
+    EXPECT_TRUE(ps.getProdIndex("product", foundIndex));
+    EXPECT_EQ(prodIndex, foundIndex);
+    EXPECT_EQ(1, ps.size());
+}
+
 // Tests adding complete product
 TEST_F(ProdStoreTest, AddingCompleteProduct) {
     hycast::ProdStore ps{};
@@ -157,6 +220,20 @@ TEST_F(ProdStoreTest, AddingCompleteProduct) {
     EXPECT_EQ(prodInfo, prodInfo2);
 }
 
+// Tests the per-product completeness fraction
+TEST_F(ProdStoreTest, Completeness) {
+    hycast::ProdStore ps{};
+    hycast::Product   prod2{};
+    EXPECT_EQ(0, ps.getCompleteness(prodIndex)); // Unknown product
+    ps.add(prodInfo, prod2);
+    EXPECT_EQ(0, ps.getCompleteness(prodIndex)); // No chunks yet
+    addChunk(ps, prodInfo, 0);
+    EXPECT_DOUBLE_EQ(1.0/prodInfo.getNumChunks(),
+            ps.getCompleteness(prodIndex));
+    addChunks(prodInfo, prod.getData(), ps);     // Remaining chunks
+    EXPECT_DOUBLE_EQ(1, ps.getCompleteness(prodIndex));
+}
+
 // Tests product deletion
 TEST_F(ProdStoreTest, ProductDeletion) {
     hycast::ProdInfo  prodInfo(0, "product", 38000);
@@ -168,6 +245,118 @@ TEST_F(ProdStoreTest, ProductDeletion) {
     EXPECT_EQ(0, ps.size());
 }
 
+// Tests by-name lookup through the secondary name-index
+TEST_F(ProdStoreTest, NameIndex) {
+    hycast::ProdStore ps{};
+    hycast::Product   prod2;
+    hycast::ProdIndex foundIndex;
+    EXPECT_FALSE(ps.getProdIndex("product", foundIndex));
+    ps.add(prodInfo, prod2);
+    EXPECT_TRUE(ps.getProdIndex("product", foundIndex));
+    EXPECT_EQ(prodIndex, foundIndex);
+    EXPECT_FALSE(ps.getProdIndex("no such product", foundIndex));
+}
+
+// Tests that eviction removes a product's name-index entry
+TEST_F(ProdStoreTest, NameIndexEviction) {
+    hycast::ProdInfo  prodInfo(0, "product", 38000);
+    hycast::ProdStore ps{"", 0.1};
+    hycast::Product   prod;
+    hycast::ProdIndex foundIndex;
+    ps.add(prodInfo, prod);
+    EXPECT_TRUE(ps.getProdIndex("product", foundIndex));
+    ::usleep(200000); // Product is now evicted
+    EXPECT_FALSE(ps.getProdIndex("product", foundIndex));
+}
+
+// Tests that late arrivals for an evicted product die at the front-guard
+// instead of re-creating a store entry
+TEST_F(ProdStoreTest, EvictedProductGuard) {
+    hycast::ProdInfo  prodInfo(0, "product", 38000);
+    hycast::ProdStore ps{"", 0.1};
+    hycast::Product   prod;
+    EXPECT_FALSE(ps.add(prodInfo, prod).isComplete());
+    EXPECT_EQ(1, ps.size());
+    ::usleep(200000); // Product is now evicted
+    EXPECT_EQ(0, ps.size());
+    const auto status = ps.add(prodInfo, prod); // Straggler
+    EXPECT_FALSE(status.isNew());
+    EXPECT_FALSE(status.isComplete());
+    EXPECT_EQ(0, ps.size());
+}
+
+// Tests cold-tier migration and transparent rehydration
+TEST_F(ProdStoreTest, ColdTierMigration) {
+    hycast::ProdStore ps{"", 3600, 0.1};
+    ps.add(prod);
+    EXPECT_EQ(1, ps.size());
+    ::usleep(200000); // Product should now be frozen
+    EXPECT_EQ(1, ps.size());
+    auto prodInfo2 = ps.getProdInfo(prodIndex);
+    EXPECT_TRUE(prodInfo2);
+    EXPECT_EQ(prodInfo, prodInfo2);
+    const hycast::ChunkInfo chunkInfo{prodInfo, 0};
+    EXPECT_TRUE(ps.haveChunk(chunkInfo.getId()));
+    auto chunk = ps.getChunk(chunkInfo.getId());
+    EXPECT_TRUE(chunk);
+    EXPECT_EQ(0, ::memcmp(data, chunk.getData(),
+            static_cast<size_t>(chunk.getSize())));
+}
+
+// Tests huge-page backing of product data buffers
+TEST_F(ProdStoreTest, HugePageBacking) {
+    hycast::ProdStore ps{"", 3600, 0, true};
+    // Larger than a 2 MiB huge page so the huge-page path is exercised
+    hycast::ProdInfo  bigInfo{prodIndex, "big product", 4*1024*1024};
+    hycast::Product   prod2{};
+    EXPECT_FALSE(ps.add(bigInfo, prod2).isComplete());
+    EXPECT_EQ(1, ps.size());
+    addChunk(ps, bigInfo, 0);
+    const hycast::ChunkInfo chunkInfo{bigInfo, 0};
+    EXPECT_TRUE(ps.haveChunk(chunkInfo.getId()));
+    auto chunk = ps.getChunk(chunkInfo.getId());
+    EXPECT_TRUE(chunk);
+}
+
+// Tests invalid cold-tier age
+TEST_F(ProdStoreTest, NegativeColdAge) {
+    EXPECT_THROW(hycast::ProdStore("", 3600, -1), hycast::InvalidArgument);
+}
+
+// Tests replaying the journal after a simulated crash
+TEST_F(ProdStoreTest, JournalReplay) {
+    const std::string journal{pathname + ".journal"};
+    const std::string crashCopy{journal + ".crash"};
+    ::remove(pathname.c_str());
+    ::remove(journal.c_str());
+    {
+        hycast::ProdStore ps{pathname};
+        // The journal is opened by the background historical load
+        ps.awaitHistory();
+        ps.add(prod);
+        // The journal is appended-to synchronously; snapshot it before the
+        // clean shutdown below subsumes it into the persistence-file
+        std::ifstream in{journal, std::ifstream::binary};
+        std::ofstream out{crashCopy, std::ofstream::binary};
+        out << in.rdbuf();
+    }
+    // Simulate a crash: no persistence-file, only the journal
+    ::remove(pathname.c_str());
+    ::rename(crashCopy.c_str(), journal.c_str());
+    hycast::ProdStore ps{pathname};
+    ps.awaitHistory();
+    EXPECT_EQ(1, ps.size());
+    auto prodInfo2 = ps.getProdInfo(prodIndex);
+    EXPECT_TRUE(prodInfo2);
+    EXPECT_EQ(prodInfo, prodInfo2);
+    const hycast::ChunkInfo chunkInfo{prodInfo, 0};
+    EXPECT_TRUE(ps.haveChunk(chunkInfo.getId()));
+    auto chunk = ps.getChunk(chunkInfo.getId());
+    EXPECT_TRUE(chunk);
+    EXPECT_EQ(0, ::memcmp(data, chunk.getData(),
+            static_cast<size_t>(chunk.getSize())));
+}
+
 // Tests getting information on oldest missing chunk
 TEST_F(ProdStoreTest, OldestMissingChunk) {
     hycast::ProdStore ps{""};
@@ -180,6 +369,25 @@ TEST_F(ProdStoreTest, OldestMissingChunk) {
     EXPECT_EQ(chunkId, ps.getOldestMissingChunk());
 }
 
+// Tests identifying the start of the recent window
+TEST_F(ProdStoreTest, RecentStart) {
+    hycast::ProdStore ps{""};
+    EXPECT_FALSE(ps.getRecentStart(1));
+    hycast::ProdInfo infos[3] = {
+            hycast::ProdInfo{0, "Product 0", hycast::ChunkSize::defaultSize},
+            hycast::ProdInfo{1, "Product 1", hycast::ChunkSize::defaultSize},
+            hycast::ProdInfo{2, "Product 2", hycast::ChunkSize::defaultSize}};
+    for (auto& info : infos) {
+        hycast::Product product;
+        ps.add(info, product);
+    }
+    EXPECT_EQ((hycast::ChunkId{infos[2], 0}), ps.getRecentStart(1));
+    EXPECT_EQ((hycast::ChunkId{infos[1], 0}), ps.getRecentStart(2));
+    EXPECT_EQ((hycast::ChunkId{infos[0], 0}), ps.getRecentStart(3));
+    // A window larger than the store starts at the earliest stored product
+    EXPECT_EQ((hycast::ChunkId{infos[0], 0}), ps.getRecentStart(99));
+}
+
 }  // namespace
 
 int main(int argc, char **argv) {
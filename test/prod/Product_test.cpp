@@ -13,6 +13,9 @@
 #include <Chunk.h>
 #include "Product.h"
 
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <gtest/gtest.h>
 
 namespace {
@@ -88,6 +91,87 @@ TEST_F(ProductTest, IdentifyEarliestMissingChunk) {
     EXPECT_FALSE(chunkId);
 }
 
+// Tests that a gotten chunk keeps the product's data alive
+TEST_F(ProductTest, ChunkOutlivesProduct) {
+    char                   data[2][hycast::ChunkSize::defaultSize];
+    ::memset(data[0], 0xbd, sizeof(data[0]));
+    ::memset(data[1], 0xad, sizeof(data[1]));
+    hycast::ProdInfo       prodInfo{0, "product", sizeof(data)};
+    hycast::ActualChunk    chunk{};
+    {
+        hycast::PartialProduct prod{prodInfo};
+        prod.add(hycast::ActualChunk{prodInfo, 0, data[0]});
+        prod.add(hycast::ActualChunk{prodInfo, 1, data[1]});
+        chunk = prod.getChunk(1);
+        EXPECT_TRUE(chunk);
+    } // Product destroyed; chunk references its data without a copy
+    EXPECT_EQ(0, ::memcmp(data[1], chunk.getData(),
+            static_cast<size_t>(chunk.getSize())));
+}
+
+// Tests that a chunk of a file-product keeps the memory-mapping alive
+TEST_F(ProductTest, FileChunkOutlivesMapping) {
+    const std::string   pathname{"/tmp/Product_test.file"};
+    char                data[hycast::ChunkSize::defaultSize];
+    ::memset(data, 0xbd, sizeof(data));
+    auto                fd = ::open(pathname.data(), O_WRONLY|O_CREAT|O_TRUNC,
+            0600);
+    ASSERT_NE(-1, fd);
+    ASSERT_EQ(sizeof(data), ::write(fd, data, sizeof(data)));
+    ::close(fd);
+    hycast::ActualChunk chunk{};
+    {
+        hycast::FileProduct prod{0, pathname};
+        chunk = prod.getChunk(0);
+        EXPECT_TRUE(chunk);
+    } // Product destroyed and file unmapped; chunk retains the mapping
+    EXPECT_EQ(0, ::memcmp(data, chunk.getData(),
+            static_cast<size_t>(chunk.getSize())));
+    ::unlink(pathname.data());
+}
+
+// Tests the zero-copy view of a product's data
+TEST_F(ProductTest, DataSpan) {
+    char                   data[2][hycast::ChunkSize::defaultSize];
+    ::memset(data[0], 0xbd, sizeof(data[0]));
+    ::memset(data[1], 0xad, sizeof(data[1]));
+    hycast::ProdInfo       prodInfo{0, "product", sizeof(data)};
+    hycast::PartialProduct prod{prodInfo};
+    EXPECT_EQ(0, prod.getDataSpan().getSize()); // No contiguous extent yet
+    prod.add(hycast::ActualChunk{prodInfo, 0, data[0]});
+    auto span = prod.getDataSpan();
+    // The view covers the contiguous leading extent
+    ASSERT_TRUE(span);
+    EXPECT_EQ(sizeof(data[0]), span.getSize());
+    EXPECT_EQ(0, ::memcmp(data[0], span.getData(), sizeof(data[0])));
+    prod.add(hycast::ActualChunk{prodInfo, 1, data[1]});
+    span = prod.getDataSpan();
+    EXPECT_EQ(sizeof(data), span.getSize());
+    EXPECT_EQ(0, ::memcmp(data, span.getData(), sizeof(data)));
+}
+
+// Tests that a view of a file-product keeps the memory-mapping alive
+TEST_F(ProductTest, FileDataSpanOutlivesMapping) {
+    const std::string pathname{"/tmp/Product_test.file"};
+    char              data[hycast::ChunkSize::defaultSize];
+    ::memset(data, 0xbd, sizeof(data));
+    auto              fd = ::open(pathname.data(), O_WRONLY|O_CREAT|O_TRUNC,
+            0600);
+    ASSERT_NE(-1, fd);
+    ASSERT_EQ(sizeof(data), ::write(fd, data, sizeof(data)));
+    ::close(fd);
+    hycast::Product::DataSpan span{};
+    EXPECT_FALSE(span);
+    {
+        hycast::FileProduct prod{0, pathname};
+        span = prod.getDataSpan();
+        ASSERT_TRUE(span);
+    } // Product destroyed and file unmapped; view retains the mapping
+    EXPECT_EQ(sizeof(data), span.getSize());
+    EXPECT_EQ(0, ::memcmp(data, span.getData(), sizeof(data)));
+    ::unlink(pathname.data());
+}
+
 // Tests construction from complete data
 TEST_F(ProductTest, DataConstruction) {
     char                    data[128000];
@@ -129,6 +213,19 @@ TEST_F(ProductTest, Serialization) {
     }
 }
 
+// Tests rejection of routine duplicates without an exception
+TEST_F(ProductTest, DuplicateRejection) {
+    char                  data[128000];
+    ::memset(data, 0xbd, sizeof(data));
+    hycast::MemoryProduct prod{1, "product", sizeof(data), data};
+    const auto            prodInfo = prod.getInfo();
+    // A chunk arriving for a complete product is a duplicate, not a fault
+    hycast::ActualChunk   chunk{prodInfo, 0, data};
+    EXPECT_FALSE(prod.add(chunk));
+    // Likewise duplicate product-information
+    EXPECT_FALSE(prod.set(prodInfo));
+}
+
 }  // namespace
 
 int main(int argc, char **argv) {
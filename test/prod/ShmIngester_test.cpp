@@ -0,0 +1,100 @@
+/**
+ * This file tests class `ShmIngester`.
+ *
+ * Copyright 2018 University Corporation for Atmospheric Research. All rights
+ * reserved. See file "COPYING" in the top-level source-directory for usage
+ * restrictions.
+ *
+ *       File: ShmIngester_test.cpp
+ * Created On: Aug 29, 2018
+ *     Author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "error.h"
+#include "ShmIngester.h"
+
+#include <cstring>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+
+namespace {
+
+/// The fixture for testing class `ShmIngester`
+class ShmIngesterTest : public ::testing::Test
+{
+protected:
+    const std::string segName{"/ShmIngester_test"};
+    const std::string prodData{"This is a data-product"};
+};
+
+// Tests default construction
+TEST_F(ShmIngesterTest, DefaultConstruction)
+{
+    hycast::ShmIngester ingester{};
+    EXPECT_FALSE(ingester);
+}
+
+// Tests invalid construction
+TEST_F(ShmIngesterTest, InvalidConstruction)
+{
+    EXPECT_THROW(hycast::ShmProducer(segName, 0, 1000),
+            std::invalid_argument);
+    EXPECT_THROW(hycast::ShmProducer(segName, 4, 0), std::invalid_argument);
+    EXPECT_THROW(hycast::ShmIngester{"/NoSuchSegment"}, std::system_error);
+}
+
+// Tests zero-copy ingestion of published products
+TEST_F(ShmIngesterTest, Ingestion)
+{
+    hycast::ShmProducer producer{segName, 4, 1000};
+    hycast::ShmIngester ingester{segName};
+    const int           numProds = 10;
+    std::thread thread{[this,&producer]{
+        for (int i = 0; i < numProds; ++i)
+            producer.send("product" + std::to_string(i), prodData.data(),
+                    prodData.length());
+    }};
+    for (int i = 0; i < numProds; ++i) {
+        auto prod = ingester.getProduct();
+        EXPECT_EQ(hycast::ProdIndex{static_cast<hycast::ProdIndex::type>(i)},
+                prod.getInfo().getIndex());
+        EXPECT_EQ("product" + std::to_string(i),
+                prod.getInfo().getName().to_string());
+        EXPECT_EQ(prodData.length(), prod.getInfo().getSize());
+        EXPECT_EQ(0, ::memcmp(prodData.data(), prod.getData(),
+                prodData.length()));
+        EXPECT_TRUE(prod.isComplete());
+    }
+    thread.join();
+}
+
+// Tests that the ring blocks the producer until slots are released
+TEST_F(ShmIngesterTest, SlotReuse)
+{
+    const unsigned      numSlots = 2;
+    hycast::ShmProducer producer{segName, numSlots, 1000};
+    hycast::ShmIngester ingester{segName};
+    const int           numProds = 3*numSlots;
+    std::thread thread{[this,&producer]{
+        for (int i = 0; i < numProds; ++i)
+            producer.send("product" + std::to_string(i), prodData.data(),
+                    prodData.length());
+    }};
+    for (int i = 0; i < numProds; ++i) {
+        // Each product is destroyed -- releasing its slot -- before the next
+        // is delivered
+        auto prod = ingester.getProduct();
+        EXPECT_EQ("product" + std::to_string(i),
+                prod.getInfo().getName().to_string());
+    }
+    thread.join();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,85 @@
+/**
+ * This file tests the classes `ActualSmallProd` and `LatentSmallProd`.
+ *
+ * Copyright 2017 University Corporation for Atmospheric Research. All rights
+ * reserved. See the file COPYING in the top-level source-directory for
+ * licensing conditions.
+ *
+ *   @file: SmallProd_test.cpp
+ * @author: Steven R. Emmerson
+ */
+#include "config.h"
+
+#include "Chunk.h"
+#include "Codec.h"
+#include "ProdInfo.h"
+
+#include <cstring>
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace {
+
+// The fixture for testing classes ActualSmallProd and LatentSmallProd.
+class SmallProdTest : public ::testing::Test {
+protected:
+    SmallProdTest()
+        : version{0}
+        , chunkSize{1000}
+        , prodInfo{0, "product", hycast::ProdSize{800},
+                hycast::ChunkSize{chunkSize}}
+        , data{}
+    {
+        data.resize(800);
+        for (size_t i = 0; i < data.size(); ++i)
+            data[i] = static_cast<char>(i);
+    }
+
+    unsigned                version;
+    hycast::ChunkSize::type chunkSize;
+    hycast::ProdInfo        prodInfo;
+    std::vector<char>       data;
+};
+
+// Tests construction from a multi-chunk product
+TEST_F(SmallProdTest, InvalidConstruction) {
+    hycast::ProdInfo bigInfo{1, "big", hycast::ProdSize{3500},
+            hycast::ChunkSize{chunkSize}};
+    std::vector<char>  bigData(3500);
+    hycast::ChunkInfo  chunkInfo{bigInfo, 0};
+    hycast::ActualChunk chunk{chunkInfo, bigData.data()};
+    EXPECT_THROW(hycast::ActualSmallProd(bigInfo, chunk),
+            hycast::InvalidArgument);
+}
+
+// Tests a serialization round-trip
+TEST_F(SmallProdTest, RoundTrip) {
+    hycast::ChunkInfo   chunkInfo{prodInfo, 0};
+    hycast::ActualChunk chunk{chunkInfo, data.data()};
+    hycast::ActualSmallProd smallProd{prodInfo, chunk};
+    EXPECT_EQ(prodInfo, smallProd.getInfo());
+
+    char               msg[2000];
+    hycast::MemEncoder encoder(msg, sizeof(msg));
+    const size_t msgLen = smallProd.serialize(encoder, version);
+    encoder.flush();
+
+    hycast::MemDecoder decoder(msg, msgLen);
+    decoder.fill(hycast::ProdInfo::getMaxSerialSize(version));
+    auto latent = hycast::LatentSmallProd::deserialize(decoder, version);
+    EXPECT_EQ(prodInfo, latent.getInfo());
+    EXPECT_TRUE(latent.hasData());
+
+    std::vector<char> drained(prodInfo.getSize());
+    EXPECT_EQ(drained.size(),
+            latent.drainData(drained.data(), drained.size()));
+    EXPECT_FALSE(latent.hasData());
+    EXPECT_EQ(0, ::memcmp(data.data(), drained.data(), data.size()));
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}